@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <mpi.h>
+#include <cuML_comms.hpp>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../sg/benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace mg {
+
+/** The ranks of MPI_COMM_WORLD, which run all the benchmarks in lockstep */
+inline int worldRank() {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  return rank;
+}
+
+inline int worldSize() {
+  int size;
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  return size;
+}
+
+/** How the dataset of a benchmark grows with the number of GPUs */
+struct Scaling {
+  /** number of GPUs, the first ranks of MPI_COMM_WORLD, of the run */
+  int nGpus;
+  /**
+   * strong scaling when false: `DatasetParams::nrows` are the rows of all the
+   * GPUs, split among them; weak scaling when true: they are the rows of
+   * each GPU
+   */
+  bool weak;
+  /** the name of the case, without the number of GPUs */
+  std::string caseName;
+};
+
+/**
+ * The fixture of the multi-GPU benchmarks. Every rank of MPI_COMM_WORLD runs
+ * every benchmark, on a GPU of its own, but only the first `nGpus` ranks run
+ * the algorithm, on a communicator of their own: the other ranks only take
+ * part in the timing, so that all the ranks stay in the same benchmark. The
+ * time of an iteration is the largest of the ranks, and the rows are sharded
+ * as `Dataset::blobsShard`, one shard per rank, about the same centers.
+ *
+ * Besides the counters of `ML::Bench::Fixture` (of rank 0), reports:
+ * - gpus, the number of GPUs
+ * - rows/s, the rows of all the GPUs processed per second
+ * - speedup and efficiency, relative to the same case on a single GPU, if
+ *   it ran before: the speedup over the single GPU time, of the same total
+ *   rows for strong scaling (an efficiency of speedup / gpus), or of the rows
+ *   of one GPU for weak scaling (an efficiency of 1 / slowdown)
+ */
+template <typename D, typename L = int>
+class BlobsFixture : public ML::Bench::BlobsFixture<D, L> {
+ public:
+  BlobsFixture(const DatasetParams p, const BlobsParams b, const Scaling& s)
+    : ML::Bench::BlobsFixture<D, L>(localParams(p, s), b),
+      scaling(s),
+      comm(MPI_COMM_NULL) {}
+  BlobsFixture() = delete;
+
+  void SetUp(const ::benchmark::State& state) override {
+    bool active = worldRank() < scaling.nGpus;
+    MPI_Comm_split(MPI_COMM_WORLD, active ? 0 : MPI_UNDEFINED, worldRank(),
+                   &comm);
+    if (!active) return;
+    ML::Bench::BlobsFixture<D, L>::SetUp(state);
+    initialize_mpi_comms(*this->handle, comm);
+  }
+
+  void TearDown(const ::benchmark::State& state) override {
+    if (comm == MPI_COMM_NULL) return;
+    ML::Bench::BlobsFixture<D, L>::TearDown(state);
+    MPI_Comm_free(&comm);
+  }
+
+  // to keep compiler happy
+  void SetUp(::benchmark::State& st) override {
+    SetUp(const_cast<const ::benchmark::State&>(st));
+  }
+
+  // to keep compiler happy
+  void TearDown(::benchmark::State& st) override {
+    TearDown(const_cast<const ::benchmark::State&>(st));
+  }
+
+ protected:
+  /** one fit of the algorithm, on the ranks of the run only */
+  virtual void runIteration() = 0;
+
+  void allocateData(const ::benchmark::State& state) override {
+    this->data.allocate(*this->handle, this->params);
+    this->data.blobsShard(*this->handle, this->params, this->bParams,
+                          worldRank());
+  }
+
+  void BenchmarkCase(::benchmark::State& state) override {
+    totalSeconds = 0.0;
+    if (comm != MPI_COMM_NULL) {
+      ML::Bench::BlobsFixture<D, L>::BenchmarkCase(state);
+    } else {
+      runBenchmark(state);
+    }
+    setScalingCounters(state);
+  }
+
+  void runBenchmark(::benchmark::State& state) final {
+    bool active = comm != MPI_COMM_NULL;
+    cudaStream_t s = active ? this->stream : 0;
+    for (auto _ : state) {
+      if (active) this->flushL2();
+      // all the ranks start together, and the time is that of the slowest
+      MPI_Barrier(MPI_COMM_WORLD);
+      cudaEvent_t start, stop;
+      CUDA_CHECK(cudaEventCreate(&start));
+      CUDA_CHECK(cudaEventCreate(&stop));
+      CUDA_CHECK(cudaEventRecord(start, s));
+      if (active) runIteration();
+      CUDA_CHECK(cudaEventRecord(stop, s));
+      CUDA_CHECK(cudaEventSynchronize(stop));
+      float ms = 0.f;
+      CUDA_CHECK(cudaEventElapsedTime(&ms, start, stop));
+      CUDA_CHECK(cudaEventDestroy(start));
+      CUDA_CHECK(cudaEventDestroy(stop));
+      double seconds = ms / 1000.0;
+      MPI_Allreduce(MPI_IN_PLACE, &seconds, 1, MPI_DOUBLE, MPI_MAX,
+                    MPI_COMM_WORLD);
+      state.SetIterationTime(seconds);
+      totalSeconds += seconds;
+    }
+  }
+
+  /** the rows of all the GPUs of the run */
+  double totalRows() const {
+    return double(this->params.nrows) * scaling.nGpus;
+  }
+
+  Scaling scaling;
+  MPI_Comm comm;
+
+ private:
+  static DatasetParams localParams(DatasetParams p, const Scaling& s) {
+    ASSERT(s.nGpus > 0, "mg benchmark: number of GPUs must be positive");
+    if (!s.weak) p.nrows /= s.nGpus;
+    return p;
+  }
+
+  // as CudaEventTimer, whose time would only be that of this rank
+  void flushL2() {
+    int devId = 0;
+    CUDA_CHECK(cudaGetDevice(&devId));
+    int l2CacheSize = 0;
+    CUDA_CHECK(
+      cudaDeviceGetAttribute(&l2CacheSize, cudaDevAttrL2CacheSize, devId));
+    if (l2CacheSize > 0) {
+      auto allocator = this->handle->getDeviceAllocator();
+      auto* buffer = (int*)allocator->allocate(l2CacheSize, this->stream);
+      CUDA_CHECK(cudaMemsetAsync(buffer, 0, l2CacheSize, this->stream));
+      allocator->deallocate(buffer, l2CacheSize, this->stream);
+    }
+    CUDA_CHECK(cudaStreamSynchronize(this->stream));
+  }
+
+  void setScalingCounters(::benchmark::State& state) {
+    typedef ::benchmark::Counter Counter;
+    if (state.error_occurred() || state.iterations() == 0) return;
+    state.counters["gpus"] = scaling.nGpus;
+    state.counters["rows/s"] =
+      Counter(totalRows(), Counter::kIsIterationInvariantRate);
+    double seconds = totalSeconds / state.iterations();
+    auto& single = singleGpuSeconds();
+    if (scaling.nGpus == 1) single[scaling.caseName] = seconds;
+    auto it = single.find(scaling.caseName);
+    if (it == single.end() || seconds <= 0.0) return;
+    double speedup = it->second / seconds;
+    state.counters["speedup"] = speedup;
+    state.counters["efficiency"] =
+      scaling.weak ? speedup : speedup / scaling.nGpus;
+  }
+
+  /** the time per iteration of the cases on a single GPU, by case name */
+  static std::map<std::string, double>& singleGpuSeconds() {
+    static std::map<std::string, double> seconds;
+    return seconds;
+  }
+
+  double totalSeconds;
+};  // end class BlobsFixture
+
+namespace internal {
+
+/**
+ * The registration of the multi-GPU benchmarks waits for MPI_Init, since the
+ * cases depend on the number of ranks: see `registerBenchmarks`
+ */
+inline std::vector<std::function<void(int, int)>>& registry() {
+  static std::vector<std::function<void(int, int)>> r;
+  return r;
+}
+
+/** the numbers of GPUs of the runs: the powers of two, then all the ranks */
+inline std::vector<int> gpuCounts(int nRanks) {
+  std::vector<int> out;
+  for (int g = 1; g < nRanks; g *= 2) out.push_back(g);
+  out.push_back(nRanks);
+  return out;
+}
+
+template <typename Params, typename Class>
+struct Registrar {
+  Registrar(const std::vector<Params>& paramsList, const std::string& name) {
+    registry().push_back([=](int nRanks, int iterations) {
+      int counter = 0;
+      for (const auto& param : paramsList) {
+        for (bool weak : {false, true}) {
+          std::stringstream oss;
+          oss << name << "/" << counter << "/" << (weak ? "weak" : "strong");
+          for (int g : gpuCounts(nRanks)) {
+            Scaling s = {g, weak, oss.str()};
+            std::stringstream name;
+            name << s.caseName << "/gpus:" << g;
+            auto* b = ::benchmark::internal::RegisterBenchmarkInternal(
+              new Class(name.str(), param, s));
+            // all the ranks must run the same number of iterations
+            b->Iterations(iterations);
+            b->UseManualTime();
+            b->Unit(benchmark::kMillisecond);
+          }
+        }
+        ++counter;
+      }
+    });
+  }
+};  // end struct Registrar
+
+}  // end namespace internal
+
+/**
+ * Registers the multi-GPU benchmarks of `CUML_MG_BENCH_REGISTER` for nRanks
+ * ranks, each case running the given number of iterations. To be called by
+ * all the ranks, after MPI_Init.
+ */
+inline void registerBenchmarks(int nRanks, int iterations) {
+  for (auto& r : internal::registry()) r(nRanks, iterations);
+}
+
+/**
+ * The multi-GPU counterpart of `CUML_BENCH_REGISTER`: every set of params is
+ * benchmarked in strong and weak scaling, on 1, 2, 4, ... GPUs up to the
+ * number of ranks. BaseClass is a child class of
+ * `ML::Bench::mg::BlobsFixture`, constructed from the name, the params and
+ * the `Scaling` of the case.
+ * @note See at the end of kmeans.cu for a real use-case example.
+ */
+#define CUML_MG_BENCH_REGISTER(ParamsClass, BaseClass, BaseName, params)     \
+  static internal::Registrar<ParamsClass, BaseClass> BENCHMARK_PRIVATE_NAME( \
+    registrar)(params, #BaseClass "/" BaseName)
+
+}  // end namespace mg
+}  // end namespace Bench
+}  // end namespace ML
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/cluster/kmeans.hpp>
+#include <cuml/cuml.hpp>
+#include <utility>
+#include "benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace mg {
+namespace kmeans {
+
+struct Params {
+  DatasetParams data;
+  BlobsParams blobs;
+  ML::kmeans::KMeansParams kmeans;
+};
+
+template <typename D>
+class KMeans : public BlobsFixture<D> {
+ public:
+  KMeans(const std::string& name, const Params& p, const Scaling& s)
+    : BlobsFixture<D>(p.data, p.blobs, s), kParams(p.kmeans) {
+    this->SetName(name.c_str());
+  }
+
+ protected:
+  void runIteration() override {
+    ML::kmeans::fit_mg(*this->handle, kParams, this->data.X,
+                       this->params.nrows, this->params.ncols, centroids,
+                       inertia, nIter);
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    centroids = (D*)allocator->allocate(centroidsLen() * sizeof(D), stream);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    allocator->deallocate(centroids, centroidsLen() * sizeof(D), stream);
+  }
+
+ private:
+  size_t centroidsLen() const {
+    return size_t(kParams.n_clusters) * this->params.ncols;
+  }
+
+  ML::kmeans::KMeansParams kParams;
+  D* centroids;
+  D inertia;
+  int nIter;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  p.data.rowMajor = true;
+  p.blobs.cluster_std = 1.0;
+  p.blobs.shuffle = false;
+  p.blobs.center_box_min = -10.0;
+  p.blobs.center_box_max = 10.0;
+  p.blobs.seed = 12345ULL;
+  p.kmeans.init = ML::kmeans::KMeansParams::KMeansPlusPlus;
+  // a fixed number of iterations, for all the runs to do the same work
+  p.kmeans.max_iter = 20;
+  p.kmeans.tol = 0.0;
+  p.kmeans.verbose = false;
+  p.kmeans.seed = int(p.blobs.seed);
+  p.kmeans.metric = 0;  // L2
+  p.kmeans.inertia_check = false;
+  std::vector<std::pair<int, int>> rowcols = {{1000000, 64}, {4000000, 64}};
+  for (auto& rc : rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    for (auto nclass : std::vector<int>({8, 64})) {
+      p.data.nclasses = nclass;
+      p.kmeans.n_clusters = p.data.nclasses;
+      out.push_back(p);
+    }
+  }
+  return out;
+}
+
+CUML_MG_BENCH_REGISTER(Params, KMeans<float>, "blobs", getInputs());
+CUML_MG_BENCH_REGISTER(Params, KMeans<double>, "blobs", getInputs());
+
+}  // end namespace kmeans
+}  // end namespace mg
+}  // end namespace Bench
+}  // end namespace ML
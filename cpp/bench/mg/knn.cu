@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/cuml.hpp>
+#include <cuml/neighbors/knn.hpp>
+#include <random/rng.h>
+#include <utility>
+#include "benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace mg {
+namespace knn {
+
+struct AlgoParams {
+  int k;
+  /** number of queries, the same on all the ranks */
+  int nQueries;
+};
+
+struct Params {
+  DatasetParams data;
+  BlobsParams blobs;
+  AlgoParams knn;
+};
+
+// The neighbors of a batch of queries among the index rows of all the ranks
+class BruteForceKNN : public BlobsFixture<float> {
+ public:
+  BruteForceKNN(const std::string& name, const Params& p, const Scaling& s)
+    : BlobsFixture<float>(p.data, p.blobs, s), kParams(p.knn) {
+    this->SetName(name.c_str());
+  }
+
+ protected:
+  void runIteration() override {
+    std::vector<float*> input = {this->data.X};
+    std::vector<int> sizes = {this->params.nrows};
+    ML::brute_force_knn_mg(*this->handle, input, sizes, this->params.ncols,
+                           queries, kParams.nQueries, indices, distances,
+                           kParams.k, this->params.rowMajor,
+                           this->params.rowMajor);
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    queries = (float*)allocator->allocate(queriesLen() * sizeof(float), stream);
+    indices =
+      (int64_t*)allocator->allocate(resultsLen() * sizeof(int64_t), stream);
+    distances =
+      (float*)allocator->allocate(resultsLen() * sizeof(float), stream);
+    // the same seed on all the ranks
+    MLCommon::Random::Rng r(this->bParams.seed);
+    r.uniform(queries, queriesLen(), float(this->bParams.center_box_min),
+              float(this->bParams.center_box_max), stream);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    allocator->deallocate(queries, queriesLen() * sizeof(float), stream);
+    allocator->deallocate(indices, resultsLen() * sizeof(int64_t), stream);
+    allocator->deallocate(distances, resultsLen() * sizeof(float), stream);
+  }
+
+ private:
+  size_t queriesLen() const {
+    return size_t(kParams.nQueries) * this->params.ncols;
+  }
+  size_t resultsLen() const { return size_t(kParams.nQueries) * kParams.k; }
+
+  AlgoParams kParams;
+  float *queries, *distances;
+  int64_t* indices;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  p.data.nclasses = 8;
+  p.blobs.cluster_std = 1.0;
+  p.blobs.shuffle = false;
+  p.blobs.center_box_min = -10.0;
+  p.blobs.center_box_max = 10.0;
+  p.blobs.seed = 12345ULL;
+  p.knn.nQueries = 10000;
+  std::vector<std::pair<int, int>> rowcols = {{1000000, 32}, {1000000, 256}};
+  for (auto& rc : rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    for (auto rowMajor : std::vector<bool>({true, false})) {
+      p.data.rowMajor = rowMajor;
+      for (auto k : std::vector<int>({10, 64})) {
+        p.knn.k = k;
+        out.push_back(p);
+      }
+    }
+  }
+  return out;
+}
+
+CUML_MG_BENCH_REGISTER(Params, BruteForceKNN, "blobs", getInputs());
+
+}  // end namespace knn
+}  // end namespace mg
+}  // end namespace Bench
+}  // end namespace ML
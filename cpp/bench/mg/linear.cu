@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/cuml.hpp>
+#include <cuml/linear_model/glm.hpp>
+#include <utility>
+#include "benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace mg {
+namespace linear {
+
+struct AlgoParams {
+  /** the parameter of the l2 regularizer, an ordinary least squares if 0 */
+  double alpha;
+  bool fit_intercept;
+};
+
+struct Params {
+  DatasetParams data;
+  BlobsParams blobs;
+  AlgoParams linear;
+};
+
+/**
+ * Ordinary least squares and ridge regressions of the blobs labels, the
+ * cost of which only depends on the shapes
+ */
+template <typename D>
+class OLS : public BlobsFixture<D> {
+ public:
+  OLS(const std::string& name, const Params& p, const Scaling& s)
+    : BlobsFixture<D>(p.data, p.blobs, s), lParams(p.linear) {
+    this->SetName(name.c_str());
+  }
+
+ protected:
+  void runIteration() override {
+    if (lParams.alpha > 0.0) {
+      ML::ridgeFitMG(*this->handle, this->data.X, this->params.nrows,
+                     this->params.ncols, labels, D(lParams.alpha), coef,
+                     &intercept, lParams.fit_intercept);
+    } else {
+      ML::olsFitMG(*this->handle, this->data.X, this->params.nrows,
+                   this->params.ncols, labels, coef, &intercept,
+                   lParams.fit_intercept);
+    }
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    coef = (D*)allocator->allocate(this->params.ncols * sizeof(D), stream);
+    labels = (D*)allocator->allocate(this->params.nrows * sizeof(D), stream);
+    this->data.labelsAs(labels, *this->handle, this->params);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    allocator->deallocate(coef, this->params.ncols * sizeof(D), stream);
+    allocator->deallocate(labels, this->params.nrows * sizeof(D), stream);
+  }
+
+ private:
+  AlgoParams lParams;
+  D *coef, *labels;
+  D intercept;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  p.data.rowMajor = false;
+  p.data.nclasses = 8;
+  p.blobs.cluster_std = 1.0;
+  p.blobs.shuffle = false;
+  p.blobs.center_box_min = -10.0;
+  p.blobs.center_box_max = 10.0;
+  p.blobs.seed = 12345ULL;
+  p.linear.fit_intercept = true;
+  std::vector<std::pair<int, int>> rowcols = {{4000000, 64}, {1000000, 512}};
+  for (auto& rc : rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    for (auto alpha : std::vector<double>({0.0, 1.0})) {
+      p.linear.alpha = alpha;
+      out.push_back(p);
+    }
+  }
+  return out;
+}
+
+CUML_MG_BENCH_REGISTER(Params, OLS<float>, "blobs", getInputs());
+CUML_MG_BENCH_REGISTER(Params, OLS<double>, "blobs", getInputs());
+
+}  // end namespace linear
+}  // end namespace mg
+}  // end namespace Bench
+}  // end namespace ML
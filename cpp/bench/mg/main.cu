@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <cuda_runtime.h>
+#include <mpi.h>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "benchmark.cuh"
+
+namespace {
+
+/** the reporter of the ranks other than 0, whose results are those of 0 */
+class NullReporter : public ::benchmark::BenchmarkReporter {
+ public:
+  bool ReportContext(const Context&) override { return true; }
+  void ReportRuns(const std::vector<Run>&) override {}
+};
+
+}  // namespace
+
+/**
+ * To be run with one rank per GPU, eg: `mpirun -np 8 ./mg_benchmark`. Besides
+ * the flags of google benchmark, takes `--mg_iterations=<n>`, the number of
+ * iterations of every case (5 by default), which all the ranks must run.
+ */
+int main(int argc, char** argv) {
+  MPI_Init(&argc, &argv);
+  int rank = ML::Bench::mg::worldRank();
+  int nDevices = 0;
+  CUDA_CHECK(cudaGetDeviceCount(&nDevices));
+  ASSERT(nDevices > 0, "mg_benchmark: no GPU");
+  CUDA_CHECK(cudaSetDevice(rank % nDevices));
+
+  int iterations = 5;
+  const char* flag = "--mg_iterations=";
+  std::vector<char*> args;
+  for (int i = 0; i < argc; ++i) {
+    if (strncmp(argv[i], flag, strlen(flag)) == 0) {
+      iterations = atoi(argv[i] + strlen(flag));
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+  ASSERT(iterations > 0, "mg_benchmark: mg_iterations must be positive");
+  int nArgs = int(args.size());
+
+  ML::Bench::mg::registerBenchmarks(ML::Bench::mg::worldSize(), iterations);
+  ::benchmark::Initialize(&nArgs, args.data());
+  if (::benchmark::ReportUnrecognizedArguments(nArgs, args.data())) {
+    MPI_Finalize();
+    return 1;
+  }
+  if (rank == 0) {
+    ::benchmark::RunSpecifiedBenchmarks();
+  } else {
+    NullReporter reporter;
+    ::benchmark::RunSpecifiedBenchmarks(&reporter);
+  }
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/cuml.hpp>
+#include <cuml/decomposition/pca.hpp>
+#include <cuml/decomposition/tsvd.hpp>
+#include <utility>
+#include "benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace mg {
+namespace pca {
+
+struct Params {
+  DatasetParams data;
+  BlobsParams blobs;
+  int n_components;
+  ML::solver algorithm;
+};
+
+template <typename D>
+class PCA : public BlobsFixture<D> {
+ public:
+  PCA(const std::string& name, const Params& p, const Scaling& s)
+    : BlobsFixture<D>(p.data, p.blobs, s) {
+    this->SetName(name.c_str());
+    // the rows of this rank
+    prms.n_rows = this->params.nrows;
+    prms.n_cols = p.data.ncols;
+    prms.n_components = p.n_components;
+    prms.algorithm = p.algorithm;
+  }
+
+ protected:
+  void runIteration() override {
+    ML::pcaFitMG(*this->handle, this->data.X, components, explained_var,
+                 explained_var_ratio, singular_vals, mu, noise_vars, prms);
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    buffers = (D*)allocator->allocate(buffersLen() * sizeof(D), stream);
+    components = buffers;
+    explained_var = components + prms.n_components * prms.n_cols;
+    explained_var_ratio = explained_var + prms.n_components;
+    singular_vals = explained_var_ratio + prms.n_components;
+    mu = singular_vals + prms.n_components;
+    noise_vars = mu + prms.n_cols;
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    allocator->deallocate(buffers, buffersLen() * sizeof(D), stream);
+  }
+
+ private:
+  size_t buffersLen() const {
+    return size_t(prms.n_components) * prms.n_cols + 3 * prms.n_components +
+           prms.n_cols + 1;
+  }
+
+  ML::paramsPCA prms;
+  D *buffers, *components, *explained_var, *explained_var_ratio;
+  D *singular_vals, *mu, *noise_vars;
+};
+
+template <typename D>
+class TSVD : public BlobsFixture<D> {
+ public:
+  TSVD(const std::string& name, const Params& p, const Scaling& s)
+    : BlobsFixture<D>(p.data, p.blobs, s) {
+    this->SetName(name.c_str());
+    // the rows of this rank
+    prms.n_rows = this->params.nrows;
+    prms.n_cols = p.data.ncols;
+    prms.n_components = p.n_components;
+    prms.algorithm = p.algorithm;
+  }
+
+ protected:
+  void runIteration() override {
+    ML::tsvdFitMG(*this->handle, this->data.X, components, singular_vals,
+                  prms);
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    components = (D*)allocator->allocate(componentsLen() * sizeof(D), stream);
+    singular_vals =
+      (D*)allocator->allocate(prms.n_components * sizeof(D), stream);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    allocator->deallocate(components, componentsLen() * sizeof(D), stream);
+    allocator->deallocate(singular_vals, prms.n_components * sizeof(D),
+                          stream);
+  }
+
+ private:
+  size_t componentsLen() const {
+    return size_t(prms.n_components) * prms.n_cols;
+  }
+
+  ML::paramsTSVD prms;
+  D *components, *singular_vals;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  p.data.rowMajor = false;
+  p.data.nclasses = 8;
+  p.blobs.cluster_std = 1.0;
+  p.blobs.shuffle = false;
+  p.blobs.center_box_min = -10.0;
+  p.blobs.center_box_max = 10.0;
+  p.blobs.seed = 12345ULL;
+  std::vector<std::pair<int, int>> rowcols = {{4000000, 64}, {1000000, 512}};
+  for (auto& rc : rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    for (auto n_components : std::vector<int>({8, 32})) {
+      p.n_components = n_components;
+      for (auto algo : {ML::COV_EIG_DQ, ML::COV_EIG_JACOBI}) {
+        p.algorithm = algo;
+        out.push_back(p);
+      }
+    }
+  }
+  return out;
+}
+
+CUML_MG_BENCH_REGISTER(Params, PCA<float>, "blobs", getInputs());
+CUML_MG_BENCH_REGISTER(Params, PCA<double>, "blobs", getInputs());
+CUML_MG_BENCH_REGISTER(Params, TSVD<float>, "blobs", getInputs());
+CUML_MG_BENCH_REGISTER(Params, TSVD<double>, "blobs", getInputs());
+
+}  // end namespace pca
+}  // end namespace mg
+}  // end namespace Bench
+}  // end namespace ML
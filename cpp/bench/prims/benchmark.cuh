@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cuda_runtime.h>
+#include <cuml/common/cuml_allocator.hpp>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "cuda_utils.h"
+
+namespace MLCommon {
+namespace Bench {
+
+/**
+ * Main fixture to be inherited and used by all the prims benchmarks. Unlike
+ * the one of sg_benchmark, it has no cumlHandle, but only the stream and the
+ * device allocator the prims take.
+ */
+class Fixture : public ::benchmark::Fixture {
+ public:
+  Fixture(const std::string& name) : ::benchmark::Fixture() {
+    SetName(name.c_str());
+  }
+  Fixture() = delete;
+
+  void SetUp(const ::benchmark::State& state) override {
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    allocator.reset(new defaultDeviceAllocator);
+    allocateBuffers(state);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown(const ::benchmark::State& state) override {
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    deallocateBuffers(state);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+    allocator.reset();
+  }
+
+  // to keep compiler happy
+  void SetUp(::benchmark::State& st) override {
+    SetUp(const_cast<const ::benchmark::State&>(st));
+  }
+
+  // to keep compiler happy
+  void TearDown(::benchmark::State& st) override {
+    TearDown(const_cast<const ::benchmark::State&>(st));
+  }
+
+ protected:
+  // every benchmark should be overriding this
+  virtual void runBenchmark(::benchmark::State& state) = 0;
+  virtual void allocateBuffers(const ::benchmark::State& state) {}
+  virtual void deallocateBuffers(const ::benchmark::State& state) {}
+
+  void BenchmarkCase(::benchmark::State& state) { runBenchmark(state); }
+
+  /**
+   * Reports the throughput of the prim, given the bytes it reads and writes
+   * and the floating point operations it performs per iteration. The rates
+   * are relative to the manual time of the iterations.
+   */
+  static void setThroughput(::benchmark::State& state, double bytes,
+                            double flops = 0.0) {
+    state.counters["GB/s"] = ::benchmark::Counter(
+      bytes / 1e9, ::benchmark::Counter::kIsIterationInvariantRate);
+    if (flops > 0.0) {
+      state.counters["GFLOP/s"] = ::benchmark::Counter(
+        flops / 1e9, ::benchmark::Counter::kIsIterationInvariantRate);
+    }
+  }
+
+  /** allocates len elements of T on the stream of the fixture */
+  template <typename T>
+  T* allocate(size_t len) {
+    return (T*)allocator->allocate(len * sizeof(T), stream);
+  }
+
+  template <typename T>
+  void deallocate(T* ptr, size_t len) {
+    allocator->deallocate(ptr, len * sizeof(T), stream);
+  }
+
+  cudaStream_t stream;
+  std::shared_ptr<deviceAllocator> allocator;
+};  // end class Fixture
+
+/**
+ * RAII way of timing cuda calls, as in sg_benchmark: the L2 cache is
+ * flushed, when asked to, before the timer starts.
+ */
+struct CudaEventTimer {
+ public:
+  CudaEventTimer(std::shared_ptr<deviceAllocator> alloc,
+                 ::benchmark::State& st, bool flushL2, cudaStream_t s)
+    : state(&st), stream(s) {
+    CUDA_CHECK(cudaEventCreate(&start));
+    CUDA_CHECK(cudaEventCreate(&stop));
+    if (flushL2) {
+      int devId = 0;
+      CUDA_CHECK(cudaGetDevice(&devId));
+      int l2CacheSize = 0;
+      CUDA_CHECK(
+        cudaDeviceGetAttribute(&l2CacheSize, cudaDevAttrL2CacheSize, devId));
+      if (l2CacheSize > 0) {
+        auto* buffer = (int*)alloc->allocate(l2CacheSize, stream);
+        CUDA_CHECK(cudaMemsetAsync(buffer, 0, l2CacheSize, stream));
+        alloc->deallocate(buffer, l2CacheSize, stream);
+        CUDA_CHECK(cudaStreamSynchronize(stream));
+      }
+    }
+    CUDA_CHECK(cudaEventRecord(start, stream));
+  }
+  CudaEventTimer() = delete;
+
+  ~CudaEventTimer() {
+    CUDA_CHECK(cudaEventRecord(stop, stream));
+    CUDA_CHECK(cudaEventSynchronize(stop));
+    float milliseconds = 0.0f;
+    CUDA_CHECK(cudaEventElapsedTime(&milliseconds, start, stop));
+    state->SetIterationTime(milliseconds / 1000.f);
+    CUDA_CHECK(cudaEventDestroy(start));
+    CUDA_CHECK(cudaEventDestroy(stop));
+  }
+
+ private:
+  cudaEvent_t start;
+  cudaEvent_t stop;
+  ::benchmark::State* state;
+  cudaStream_t stream;
+};  // end namespace CudaEventTimer
+
+namespace internal {
+template <typename Params, typename Class>
+struct Registrar {
+  Registrar(const std::vector<Params>& paramsList, const std::string& name) {
+    int counter = 0;
+    for (const auto& param : paramsList) {
+      std::stringstream oss;
+      oss << counter;
+      auto testName = name + "/" + oss.str();
+      auto* b = ::benchmark::internal::RegisterBenchmarkInternal(
+        new Class(testName, param));
+      b->UseManualTime();
+      b->Unit(benchmark::kMicrosecond);
+      ++counter;
+    }
+  }
+};  // end struct Registrar
+};  // end namespace internal
+
+/**
+ * The entry point macro of the prims benchmarks, as CUML_BENCH_REGISTER is
+ * for sg_benchmark.
+ * @param ParamsClass a struct which contains all the parameters of one case
+ * @param BaseClass the child class of `MLCommon::Bench::Fixture` to run
+ * @param BaseName a unique string to identify these cases at the end of run
+ * @param params list of params upon which to benchmark the prim
+ */
+#define PRIMS_BENCH_REGISTER(ParamsClass, BaseClass, BaseName, params)       \
+  static internal::Registrar<ParamsClass, BaseClass> BENCHMARK_PRIVATE_NAME( \
+    registrar)(params, #BaseClass "/" BaseName)
+
+}  // end namespace Bench
+}  // end namespace MLCommon
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <linalg/unary_op.h>
+#include <random/rng.h>
+#include <sparse/coo.h>
+#include <memory>
+#include "benchmark.cuh"
+
+namespace MLCommon {
+namespace Bench {
+namespace coo {
+
+enum OpType { SORT, REMOVE_ZEROS, ROW_COUNT, SORTED_TO_CSR };
+
+struct Params {
+  int rows, cols, nnz;
+  OpType op;
+};
+
+/** zeroes the negative values, ie: about half of the uniform ones */
+template <typename T>
+struct ZeroNegativeOp {
+  HDI T operator()(T in) const { return in < T(0) ? T(0) : in; }
+};
+
+/**
+ * The ops of a random rows x cols COO matrix of nnz entries, half of which
+ * are zeros: sorting it, removing its zeros, counting the entries of its
+ * rows and, once sorted, computing the CSR row offsets.
+ */
+template <typename T>
+class COO : public Fixture {
+ public:
+  COO(const std::string& name, const Params& p) : Fixture(name), params(p) {}
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    for (auto _ : state) {
+      // the sort is in place, so that every iteration starts unsorted
+      if (params.op == SORT) copyToSorted();
+      Sparse::COO<T> out(allocator, stream);
+      CudaEventTimer timer(allocator, state, true, stream);
+      switch (params.op) {
+        case SORT:
+          Sparse::coo_sort(sorted.get(), allocator, stream);
+          break;
+        case REMOVE_ZEROS:
+          Sparse::coo_remove_zeros<32, T>(in.get(), &out, allocator, stream);
+          break;
+        case ROW_COUNT:
+          CUDA_CHECK(cudaMemsetAsync(counts, 0, params.rows * sizeof(int),
+                                     stream));
+          Sparse::coo_row_count<32, T>(in.get(), counts, stream);
+          break;
+        case SORTED_TO_CSR:
+          Sparse::sorted_coo_to_csr(sorted.get(), counts, allocator, stream);
+          break;
+      }
+    }
+    // the indices and values of the entries, read once
+    setThroughput(state, double(params.nnz) * (2 * sizeof(int) + sizeof(T)));
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    in.reset(new Sparse::COO<T>(allocator, stream, params.nnz, params.rows,
+                                params.cols, false));
+    sorted.reset(new Sparse::COO<T>(allocator, stream, params.nnz,
+                                    params.rows, params.cols, false));
+    counts = allocate<int>(params.rows);
+    Random::Rng r(12345ULL);
+    r.uniformInt(in->rows(), params.nnz, 0, params.rows, stream);
+    r.uniformInt(in->cols(), params.nnz, 0, params.cols, stream);
+    r.uniform(in->vals(), params.nnz, T(-1), T(1), stream);
+    LinAlg::unaryOp(in->vals(), in->vals(), params.nnz, ZeroNegativeOp<T>(),
+                    stream);
+    copyToSorted();
+    Sparse::coo_sort(sorted.get(), allocator, stream);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    in.reset();
+    sorted.reset();
+    deallocate(counts, params.rows);
+  }
+
+ private:
+  void copyToSorted() {
+    copy(sorted->rows(), in->rows(), params.nnz, stream);
+    copy(sorted->cols(), in->cols(), params.nnz, stream);
+    copy(sorted->vals(), in->vals(), params.nnz, stream);
+  }
+
+  Params params;
+  std::unique_ptr<Sparse::COO<T>> in, sorted;
+  int* counts;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  std::vector<std::vector<int>> shapes = {{100000, 100000, 1000000},
+                                          {1000000, 1000000, 15000000},
+                                          {10000, 1000000, 10000000}};
+  for (auto& shape : shapes) {
+    p.rows = shape[0];
+    p.cols = shape[1];
+    p.nnz = shape[2];
+    for (auto op : {SORT, REMOVE_ZEROS, ROW_COUNT, SORTED_TO_CSR}) {
+      p.op = op;
+      out.push_back(p);
+    }
+  }
+  return out;
+}
+
+PRIMS_BENCH_REGISTER(Params, COO<float>, "uniform", getInputs());
+PRIMS_BENCH_REGISTER(Params, COO<double>, "uniform", getInputs());
+
+}  // end namespace coo
+}  // end namespace Bench
+}  // end namespace MLCommon
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <common/device_buffer.hpp>
+#include <distance/distance.h>
+#include <random/rng.h>
+#include <memory>
+#include "benchmark.cuh"
+
+namespace MLCommon {
+namespace Bench {
+namespace distance {
+
+struct Params {
+  int m, n, k;
+  MLCommon::Distance::DistanceType metric;
+};
+
+/**
+ * The m x n distance matrix of row-major inputs. The flops are counted as
+ * 2 * m * n * k, whatever the metric.
+ */
+template <typename T>
+class PairwiseDistance : public Fixture {
+ public:
+  PairwiseDistance(const std::string& name, const Params& p)
+    : Fixture(name), params(p) {}
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    for (auto _ : state) {
+      CudaEventTimer timer(allocator, state, true, stream);
+      MLCommon::Distance::pairwiseDistance(x, y, dist, params.m, params.n,
+                                           params.k, *workspace, params.metric,
+                                           stream, true, T(3));
+    }
+    double m = params.m, n = params.n, k = params.k;
+    setThroughput(state, (m * k + n * k + m * n) * sizeof(T), 2 * m * n * k);
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    x = allocate<T>(size_t(params.m) * params.k);
+    y = allocate<T>(size_t(params.n) * params.k);
+    dist = allocate<T>(size_t(params.m) * params.n);
+    workspace.reset(new device_buffer<char>(allocator, stream));
+    Random::Rng r(12345ULL);
+    r.uniform(x, params.m * params.k, T(-1), T(1), stream);
+    r.uniform(y, params.n * params.k, T(-1), T(1), stream);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    deallocate(x, size_t(params.m) * params.k);
+    deallocate(y, size_t(params.n) * params.k);
+    deallocate(dist, size_t(params.m) * params.n);
+    workspace.reset();
+  }
+
+ private:
+  Params params;
+  T *x, *y, *dist;
+  std::unique_ptr<device_buffer<char>> workspace;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  std::vector<std::vector<int>> shapes = {
+    {1024, 1024, 64}, {4096, 4096, 128}, {16384, 1024, 32}, {4096, 4096, 512}};
+  for (auto& shape : shapes) {
+    p.m = shape[0];
+    p.n = shape[1];
+    p.k = shape[2];
+    for (int metric = MLCommon::Distance::EucExpandedL2;
+         metric < MLCommon::Distance::EucUnexpandedHaversine; ++metric) {
+      p.metric = MLCommon::Distance::DistanceType(metric);
+      out.push_back(p);
+    }
+  }
+  // the haversine distance is between (lat, lon) points
+  p.metric = MLCommon::Distance::EucUnexpandedHaversine;
+  p.k = 2;
+  for (int mn : {1024, 4096, 16384}) {
+    p.m = p.n = mn;
+    out.push_back(p);
+  }
+  return out;
+}
+
+PRIMS_BENCH_REGISTER(Params, PairwiseDistance<float>, "distance", getInputs());
+PRIMS_BENCH_REGISTER(Params, PairwiseDistance<double>, "distance", getInputs());
+
+}  // end namespace distance
+}  // end namespace Bench
+}  // end namespace MLCommon
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random/rng.h>
+#include <stats/histogram.h>
+#include "benchmark.cuh"
+
+namespace MLCommon {
+namespace Bench {
+namespace histogram {
+
+struct Params {
+  int nrows, ncols, nbins;
+  Stats::HistType type;
+};
+
+/** ncols histograms of nrows uniform integers in [0, nbins) each */
+class Histogram : public Fixture {
+ public:
+  Histogram(const std::string& name, const Params& p)
+    : Fixture(name), params(p) {}
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    for (auto _ : state) {
+      CudaEventTimer timer(allocator, state, true, stream);
+      Stats::histogram<int>(params.type, bins, params.nbins, data,
+                            params.nrows, params.ncols, stream);
+    }
+    setThroughput(state, (double(dataLen()) + binsLen()) * sizeof(int));
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    data = allocate<int>(dataLen());
+    bins = allocate<int>(binsLen());
+    Random::Rng r(12345ULL);
+    r.uniformInt(data, dataLen(), 0, params.nbins, stream);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    deallocate(data, dataLen());
+    deallocate(bins, binsLen());
+  }
+
+ private:
+  size_t dataLen() const { return size_t(params.nrows) * params.ncols; }
+  size_t binsLen() const { return size_t(params.nbins) * params.ncols; }
+
+  Params params;
+  int *data, *bins;
+};
+
+// the shared memory needed by the bins of a block, or 0 when they are global
+size_t smemBytes(Stats::HistType type, int nbins) {
+  switch (type) {
+    case Stats::HistTypeSmem:
+    case Stats::HistTypeSmemMatchAny:
+      return nbins * sizeof(int);
+    case Stats::HistTypeSmemBits1:
+    case Stats::HistTypeSmemBits2:
+    case Stats::HistTypeSmemBits4:
+    case Stats::HistTypeSmemBits8:
+    case Stats::HistTypeSmemBits16:
+      return ceildiv<size_t>(size_t(nbins) * type, 8);
+    default:
+      return 0;
+  }
+}
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  std::vector<Stats::HistType> types = {
+    Stats::HistTypeSmemBits1, Stats::HistTypeSmemBits2,
+    Stats::HistTypeSmemBits4, Stats::HistTypeSmemBits8,
+    Stats::HistTypeSmemBits16, Stats::HistTypeGmem,
+    Stats::HistTypeSmem, Stats::HistTypeSmemMatchAny,
+    Stats::HistTypeSmemHash, Stats::HistTypeAuto};
+  std::vector<std::pair<int, int>> rowcols = {
+    {1000000, 1}, {100000, 100}, {10000000, 4}};
+  for (auto& rc : rowcols) {
+    p.nrows = rc.first;
+    p.ncols = rc.second;
+    for (int nbins : {32, 1000, 20000}) {
+      p.nbins = nbins;
+      for (auto type : types) {
+        // beyond the 48KiB of shared memory every device has
+        if (smemBytes(type, nbins) > 48 * 1024) continue;
+        p.type = type;
+        out.push_back(p);
+      }
+    }
+  }
+  return out;
+}
+
+PRIMS_BENCH_REGISTER(Params, Histogram, "histogram", getInputs());
+
+}  // end namespace histogram
+}  // end namespace Bench
+}  // end namespace MLCommon
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <linalg/coalesced_reduction.h>
+#include <linalg/reduce.h>
+#include <random/rng.h>
+#include "benchmark.cuh"
+
+namespace MLCommon {
+namespace Bench {
+namespace reduce {
+
+struct Params {
+  int rows, cols;
+  bool rowMajor, alongRows;
+};
+
+/**
+ * Sums of a rows x cols matrix, per row when alongRows and per column
+ * otherwise, by LinAlg::reduce, which dispatches to coalescedReduction when
+ * the reduced dimension is contiguous and to stridedReduction otherwise.
+ */
+template <typename T>
+class Reduce : public Fixture {
+ public:
+  Reduce(const std::string& name, const Params& p) : Fixture(name), params(p) {}
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    for (auto _ : state) {
+      CudaEventTimer timer(allocator, state, true, stream);
+      LinAlg::reduce(out, data, params.cols, params.rows, T(0),
+                     params.rowMajor, params.alongRows, stream);
+    }
+    setThroughput(state, double(dataLen() + outLen()) * sizeof(T), dataLen());
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    data = allocate<T>(dataLen());
+    out = allocate<T>(outLen());
+    Random::Rng r(12345ULL);
+    r.uniform(data, dataLen(), T(-1), T(1), stream);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    deallocate(data, dataLen());
+    deallocate(out, outLen());
+  }
+
+  size_t dataLen() const { return size_t(params.rows) * params.cols; }
+  size_t outLen() const { return params.alongRows ? params.rows : params.cols; }
+
+  Params params;
+  T *data, *out;
+};
+
+/**
+ * The per row sums of a row-major matrix by coalescedReduction directly, ie:
+ * without the dispatch of reduce.
+ */
+template <typename T>
+class CoalescedReduction : public Reduce<T> {
+ public:
+  CoalescedReduction(const std::string& name, const Params& p)
+    : Reduce<T>(name, p) {}
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    for (auto _ : state) {
+      CudaEventTimer timer(this->allocator, state, true, this->stream);
+      LinAlg::coalescedReduction(this->out, this->data, this->params.cols,
+                                 this->params.rows, T(0), this->stream);
+    }
+    this->setThroughput(
+      state, double(this->dataLen() + this->outLen()) * sizeof(T),
+      this->dataLen());
+  }
+};
+
+std::vector<Params> getInputs(bool coalescedOnly) {
+  std::vector<Params> out;
+  Params p;
+  std::vector<std::pair<int, int>> rowcols = {
+    {1024, 1024}, {32, 1048576}, {1048576, 32}, {8192, 8192}, {1000000, 3}};
+  for (auto& rc : rowcols) {
+    p.rows = rc.first;
+    p.cols = rc.second;
+    for (bool rowMajor : {true, false}) {
+      for (bool alongRows : {true, false}) {
+        if (coalescedOnly && !(rowMajor && alongRows)) continue;
+        p.rowMajor = rowMajor;
+        p.alongRows = alongRows;
+        out.push_back(p);
+      }
+    }
+  }
+  return out;
+}
+
+PRIMS_BENCH_REGISTER(Params, Reduce<float>, "reduce", getInputs(false));
+PRIMS_BENCH_REGISTER(Params, Reduce<double>, "reduce", getInputs(false));
+PRIMS_BENCH_REGISTER(Params, CoalescedReduction<float>, "reduce",
+                     getInputs(true));
+PRIMS_BENCH_REGISTER(Params, CoalescedReduction<double>, "reduce",
+                     getInputs(true));
+
+}  // end namespace reduce
+}  // end namespace Bench
+}  // end namespace MLCommon
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random/rng.h>
+#include "benchmark.cuh"
+
+namespace MLCommon {
+namespace Bench {
+namespace rng {
+
+enum DistType { UNIFORM, NORMAL, LOGNORMAL, EXPONENTIAL, BERNOULLI };
+
+struct Params {
+  int len;
+  Random::GeneratorType gtype;
+  DistType dist;
+};
+
+template <typename T>
+class Rng : public Fixture {
+ public:
+  Rng(const std::string& name, const Params& p) : Fixture(name), params(p) {}
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    Random::Rng r(12345ULL, params.gtype);
+    for (auto _ : state) {
+      CudaEventTimer timer(allocator, state, true, stream);
+      switch (params.dist) {
+        case UNIFORM:
+          r.uniform(ptr, params.len, T(-1), T(1), stream);
+          break;
+        case NORMAL:
+          r.normal(ptr, params.len, T(0), T(1), stream);
+          break;
+        case LOGNORMAL:
+          r.lognormal(ptr, params.len, T(0), T(1), stream);
+          break;
+        case EXPONENTIAL:
+          r.exponential(ptr, params.len, T(1), stream);
+          break;
+        case BERNOULLI:
+          r.bernoulli(flags, params.len, T(0.5), stream);
+          break;
+      }
+    }
+    size_t size = params.dist == BERNOULLI ? sizeof(bool) : sizeof(T);
+    setThroughput(state, double(params.len) * size);
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    ptr = allocate<T>(params.len);
+    flags = allocate<bool>(params.len);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    deallocate(ptr, params.len);
+    deallocate(flags, params.len);
+  }
+
+ private:
+  Params params;
+  T* ptr;
+  bool* flags;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  for (int len : {1024 * 1024, 32 * 1024 * 1024}) {
+    p.len = len;
+    for (auto gtype :
+         {Random::GenPhilox, Random::GenTaps, Random::GenKiss99}) {
+      p.gtype = gtype;
+      for (auto dist : {UNIFORM, NORMAL, LOGNORMAL, EXPONENTIAL, BERNOULLI}) {
+        p.dist = dist;
+        out.push_back(p);
+      }
+    }
+  }
+  return out;
+}
+
+PRIMS_BENCH_REGISTER(Params, Rng<float>, "rng", getInputs());
+PRIMS_BENCH_REGISTER(Params, Rng<double>, "rng", getInputs());
+
+}  // end namespace rng
+}  // end namespace Bench
+}  // end namespace MLCommon
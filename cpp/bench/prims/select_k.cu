@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random/rng.h>
+#include <selection/columnWiseSort.h>
+#include <selection/kselection.h>
+#include "benchmark.cuh"
+
+namespace MLCommon {
+namespace Bench {
+namespace select_k {
+
+struct Params {
+  int rows, cols, k;
+  bool sort;
+};
+
+/** the k smallest values of each row of a row-major matrix by warpTopK */
+class WarpTopK : public Fixture {
+ public:
+  WarpTopK(const std::string& name, const Params& p)
+    : Fixture(name), params(p) {}
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    for (auto _ : state) {
+      CudaEventTimer timer(allocator, state, true, stream);
+      if (params.sort) {
+        Selection::warpTopK<float, int, true, true>(
+          outv, outk, arr, params.k, params.rows, params.cols, stream);
+      } else {
+        Selection::warpTopK<float, int, true, false>(
+          outv, outk, arr, params.k, params.rows, params.cols, stream);
+      }
+    }
+    setThroughput(state, double(arrLen()) * sizeof(float) +
+                           double(outLen()) * (sizeof(float) + sizeof(int)));
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    arr = allocate<float>(arrLen());
+    outv = allocate<float>(outLen());
+    outk = allocate<int>(outLen());
+    Random::Rng r(12345ULL);
+    r.uniform(arr, arrLen(), -1.f, 1.f, stream);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    deallocate(arr, arrLen());
+    deallocate(outv, outLen());
+    deallocate(outk, outLen());
+  }
+
+ private:
+  size_t arrLen() const { return size_t(params.rows) * params.cols; }
+  size_t outLen() const { return size_t(params.rows) * params.k; }
+
+  Params params;
+  float *arr, *outv;
+  int* outk;
+};
+
+/**
+ * The indices of each row of a row-major matrix sorted by value, by
+ * sortColumnsPerRow, which sorts the rows in shared memory up to a few
+ * thousand columns and by a segmented radix sort beyond.
+ */
+class SortColumnsPerRow : public Fixture {
+ public:
+  SortColumnsPerRow(const std::string& name, const Params& p)
+    : Fixture(name), params(p) {}
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    for (auto _ : state) {
+      CudaEventTimer timer(allocator, state, true, stream);
+      Selection::sortColumnsPerRow(in, out, params.rows, params.cols,
+                                   needWorkspace, workspace, workspaceSize,
+                                   stream);
+    }
+    setThroughput(state, double(len()) * (sizeof(float) + sizeof(int)));
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    in = allocate<float>(len());
+    out = allocate<int>(len());
+    Random::Rng r(12345ULL);
+    r.uniform(in, len(), -1.f, 1.f, stream);
+    needWorkspace = false;
+    workspace = nullptr;
+    workspaceSize = 0;
+    Selection::sortColumnsPerRow(in, out, params.rows, params.cols,
+                                 needWorkspace, workspace, workspaceSize,
+                                 stream);
+    if (needWorkspace) workspace = allocate<char>(workspaceSize);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    deallocate(in, len());
+    deallocate(out, len());
+    if (needWorkspace) deallocate((char*)workspace, workspaceSize);
+  }
+
+ private:
+  size_t len() const { return size_t(params.rows) * params.cols; }
+
+  Params params;
+  float* in;
+  int* out;
+  bool needWorkspace;
+  void* workspace;
+  size_t workspaceSize;
+};
+
+std::vector<Params> getTopKInputs() {
+  std::vector<Params> out;
+  Params p;
+  std::vector<std::pair<int, int>> rowcols = {
+    {10000, 1024}, {1000, 16384}, {100, 262144}};
+  for (auto& rc : rowcols) {
+    p.rows = rc.first;
+    p.cols = rc.second;
+    for (int k : {1, 32, 256}) {
+      p.k = k;
+      for (bool sort : {false, true}) {
+        p.sort = sort;
+        out.push_back(p);
+      }
+    }
+  }
+  return out;
+}
+
+std::vector<Params> getSortInputs() {
+  std::vector<Params> out;
+  Params p;
+  p.k = 0;
+  p.sort = true;
+  std::vector<std::pair<int, int>> rowcols = {
+    {10000, 64}, {10000, 512}, {1000, 4096}, {1000, 16384}, {100, 262144}};
+  for (auto& rc : rowcols) {
+    p.rows = rc.first;
+    p.cols = rc.second;
+    out.push_back(p);
+  }
+  return out;
+}
+
+PRIMS_BENCH_REGISTER(Params, WarpTopK, "uniform", getTopKInputs());
+PRIMS_BENCH_REGISTER(Params, SortColumnsPerRow, "uniform", getSortInputs());
+
+}  // end namespace select_k
+}  // end namespace Bench
+}  // end namespace MLCommon
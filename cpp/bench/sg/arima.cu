@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <arima/batched_arima.hpp>
+#include <cuml/cuml.hpp>
+#include <cuml/datasets/make_arima.hpp>
+#include <cuml/tsa/arima_common.h>
+#include <utility>
+#include <vector>
+#include "benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace arima {
+
+struct AlgoParams {
+  ARIMAOrder order;
+  uint64_t seed;
+  // whether to time the fit from zero parameters rather than the
+  // log-likelihood of the parameters the series are simulated with
+  bool fit;
+};
+
+/** nrows is the length of the series, and ncols the number of series */
+struct Params {
+  DatasetParams data;
+  AlgoParams arima;
+};
+
+/**
+ * Batched log-likelihood or fit of series simulated by make_arima from
+ * random models of the given order, stored one after the other
+ */
+class Arima : public Fixture {
+ public:
+  Arima(const std::string& name, const Params& p)
+    : Fixture(p.data), aParams(p.arima) {
+    this->SetName(name.c_str());
+  }
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    auto& handle = *this->handle;
+    auto stream = handle.getStream();
+    const ARIMAOrder& order = aParams.order;
+    for (auto _ : state) {
+      if (aParams.fit) {
+        // the fit overwrites its starting point
+        CUDA_CHECK(cudaMemsetAsync(fit_params, 0, paramsLen() * sizeof(double),
+                                   stream));
+        CudaEventTimer timer(handle, state, true, stream);
+        ML::batched_fit(handle, data, params.ncols, params.nrows, order,
+                        fit_params, niter.data(), status.data());
+      } else {
+        CudaEventTimer timer(handle, state, true, stream);
+        ML::batched_loglike(handle, data, params.ncols, params.nrows, order,
+                            true_params, loglike, vs, false, false);
+      }
+    }
+  }
+
+  void allocateData(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    data = (double*)allocator->allocate(dataLen() * sizeof(double), stream);
+    true_params =
+      (double*)allocator->allocate(paramsLen() * sizeof(double), stream);
+    ML::Datasets::make_arima(*this->handle, data, params.ncols, params.nrows,
+                             aParams.order, 1.0, 1.0, aParams.seed,
+                             true_params);
+  }
+
+  void deallocateData(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    allocator->deallocate(data, dataLen() * sizeof(double), stream);
+    allocator->deallocate(true_params, paramsLen() * sizeof(double), stream);
+  }
+
+  double bytesPerIteration() const override {
+    return double(dataLen()) * sizeof(double);
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    fit_params =
+      (double*)allocator->allocate(paramsLen() * sizeof(double), stream);
+    loglike =
+      (double*)allocator->allocate(params.ncols * sizeof(double), stream);
+    vs = (double*)allocator->allocate(vsLen() * sizeof(double), stream);
+    niter.resize(params.ncols);
+    status.resize(params.ncols);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    allocator->deallocate(fit_params, paramsLen() * sizeof(double), stream);
+    allocator->deallocate(loglike, params.ncols * sizeof(double), stream);
+    allocator->deallocate(vs, vsLen() * sizeof(double), stream);
+  }
+
+ private:
+  size_t dataLen() const { return size_t(params.nrows) * params.ncols; }
+  size_t paramsLen() const {
+    return size_t(aParams.order.complexity()) * params.ncols;
+  }
+  size_t vsLen() const {
+    return size_t(params.nrows - aParams.order.n_diff()) * params.ncols;
+  }
+
+  AlgoParams aParams;
+  double *data, *true_params, *fit_params, *loglike, *vs;
+  std::vector<int> niter, status;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  p.data.rowMajor = false;
+  p.data.nclasses = 0;
+  p.arima.seed = 12345ULL;
+  // length, number of series
+  std::vector<std::pair<int, int>> shapes = {
+    {100, 1000}, {100, 10000}, {500, 1000}};
+  // (p, d, q)(P, D, Q)_s, without exogenous regressors
+  std::vector<ARIMAOrder> orders = {{1, 1, 1, 0, 0, 0, 0, 0},
+                                    {2, 0, 2, 0, 0, 0, 0, 0},
+                                    {1, 1, 1, 1, 1, 1, 12, 0}};
+  for (auto& shape : shapes) {
+    p.data.nrows = shape.first;
+    p.data.ncols = shape.second;
+    for (auto& order : orders) {
+      p.arima.order = order;
+      for (bool fit : {false, true}) {
+        p.arima.fit = fit;
+        out.push_back(p);
+      }
+    }
+  }
+  return out;
+}
+
+CUML_BENCH_REGISTER(Params, Arima, "arima", getInputs());
+
+}  // end namespace arima
+}  // end namespace Bench
+}  // end namespace ML
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cuda_runtime.h>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ML {
+namespace Bench {
+
+/**
+ * The params of the cases, by the name they are registered with, eg: the
+ * shape of their dataset, for the results of a case to be compared only with
+ * the results of the same params
+ */
+inline std::map<std::string, std::map<std::string, std::string>>&
+caseParams() {
+  static std::map<std::string, std::map<std::string, std::string>> params;
+  return params;
+}
+
+/**
+ * A reporter of the results in the stable JSON schema of the baselines of
+ * `scripts/compare_bench_baseline.py`, besides the display of its wrapped
+ * reporter. The file, written once all the benchmarks ran, is:
+ *
+ *   {"schema": "cuml-bench-baseline", "version": 1,
+ *    "context": {"date": ..., "gpu": ..., "compute_capability": ...,
+ *                "driver_version": ..., "runtime_version": ...},
+ *    "results": {"<gpu>/<name>": {"algorithm": ..., "dataset": ...,
+ *                                 "case": ..., "params": {...},
+ *                                 "gpu": ..., "time_unit": ...,
+ *                                 "iterations": ..., "samples": [...],
+ *                                 "mean": ..., "stddev": ...,
+ *                                 "counters": {...}}}}
+ *
+ * where name is the name the case is registered with, `<Class>/<dataset>/
+ * <case>`, and samples are the times per iteration of the repetitions of the
+ * case (see --benchmark_repetitions), on which the comparison is based.
+ */
+class BaselineReporter : public ::benchmark::BenchmarkReporter {
+ public:
+  BaselineReporter(::benchmark::BenchmarkReporter* display,
+                   const std::string& file)
+    : display(display), file(file) {}
+
+  bool ReportContext(const Context& context) override {
+    display->SetOutputStream(&GetOutputStream());
+    display->SetErrorStream(&GetErrorStream());
+    int dev = 0, driver = 0, runtime = 0;
+    cudaDeviceProp prop;
+    if (cudaGetDevice(&dev) == cudaSuccess &&
+        cudaGetDeviceProperties(&prop, dev) == cudaSuccess) {
+      gpu = prop.name;
+      std::stringstream cc;
+      cc << prop.major << "." << prop.minor;
+      computeCapability = cc.str();
+    } else {
+      gpu = "unknown";
+    }
+    cudaDriverGetVersion(&driver);
+    cudaRuntimeGetVersion(&runtime);
+    driverVersion = driver;
+    runtimeVersion = runtime;
+    return display->ReportContext(context);
+  }
+
+  void ReportRuns(const std::vector<Run>& runs) override {
+    for (const auto& run : runs) {
+      if (run.error_occurred || run.run_type != Run::RT_Iteration) continue;
+      Result& r = results[caseName(run.benchmark_name())];
+      r.timeUnit = ::benchmark::GetTimeUnitString(run.time_unit);
+      r.iterations = int64_t(run.iterations);
+      r.samples.push_back(run.GetAdjustedRealTime());
+      r.counters.clear();
+      for (const auto& c : run.counters) r.counters[c.first] = c.second.value;
+    }
+    display->ReportRuns(runs);
+  }
+
+  void Finalize() override {
+    display->Finalize();
+    std::ofstream out(file);
+    if (!out) {
+      GetErrorStream() << "cannot write the baseline to " << file << "\n";
+      return;
+    }
+    out << "{\n  \"schema\": \"cuml-bench-baseline\",\n  \"version\": 1,\n";
+    out << "  \"context\": {\"date\": " << quote(date())
+        << ", \"gpu\": " << quote(gpu)
+        << ", \"compute_capability\": " << quote(computeCapability)
+        << ", \"driver_version\": " << driverVersion
+        << ", \"runtime_version\": " << runtimeVersion << "},\n";
+    out << "  \"results\": {";
+    const char* sep = "\n";
+    for (const auto& it : results) {
+      out << sep << "    " << quote(gpu + "/" + it.first) << ": ";
+      writeResult(out, it.first, it.second);
+      sep = ",\n";
+    }
+    out << "\n  }\n}\n";
+  }
+
+ private:
+  struct Result {
+    std::string timeUnit;
+    int64_t iterations;
+    std::vector<double> samples;
+    std::map<std::string, double> counters;
+  };
+
+  // the registered name, without the suffixes of google benchmark
+  static std::string caseName(const std::string& name) {
+    size_t pos = name.find("/manual_time");
+    return pos == std::string::npos ? name : name.substr(0, pos);
+  }
+
+  void writeResult(std::ostream& out, const std::string& name,
+                   const Result& r) const {
+    // <Class>/<dataset>/<case>
+    size_t last = name.rfind('/');
+    size_t first = name.rfind('/', last == 0 ? 0 : last - 1);
+    double mean = 0.0, var = 0.0;
+    for (double s : r.samples) mean += s;
+    mean /= r.samples.size();
+    for (double s : r.samples) var += (s - mean) * (s - mean);
+    if (r.samples.size() > 1) var /= r.samples.size() - 1;
+    out << "{\"algorithm\": " << quote(name.substr(0, first))
+        << ", \"dataset\": "
+        << quote(name.substr(first + 1, last - first - 1))
+        << ", \"case\": " << name.substr(last + 1) << ", \"params\": {";
+    const char* sep = "";
+    auto p = caseParams().find(name);
+    if (p != caseParams().end()) {
+      for (const auto& kv : p->second) {
+        out << sep << quote(kv.first) << ": " << quote(kv.second);
+        sep = ", ";
+      }
+    }
+    out << "}, \"gpu\": " << quote(gpu)
+        << ", \"time_unit\": " << quote(r.timeUnit)
+        << ", \"iterations\": " << r.iterations << ", \"samples\": [";
+    sep = "";
+    for (double s : r.samples) {
+      out << sep << number(s);
+      sep = ", ";
+    }
+    out << "], \"mean\": " << number(mean)
+        << ", \"stddev\": " << number(std::sqrt(var)) << ", \"counters\": {";
+    sep = "";
+    for (const auto& c : r.counters) {
+      out << sep << quote(c.first) << ": " << number(c.second);
+      sep = ", ";
+    }
+    out << "}}";
+  }
+
+  static std::string quote(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+      if (c == '"' || c == '\\') {
+        out += '\\';
+        out += c;
+      } else if ((unsigned char)c < 0x20) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\u%04x", c);
+        out += buf;
+      } else {
+        out += c;
+      }
+    }
+    return out + "\"";
+  }
+
+  // JSON has no inf nor nan
+  static std::string number(double v) {
+    if (!std::isfinite(v)) return "null";
+    std::stringstream ss;
+    ss.precision(17);
+    ss << v;
+    return ss.str();
+  }
+
+  static std::string date() {
+    char buf[32];
+    time_t now = time(nullptr);
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    return buf;
+  }
+
+  ::benchmark::BenchmarkReporter* display;
+  std::string file;
+  std::string gpu, computeCapability;
+  int driverVersion, runtimeVersion;
+  std::map<std::string, Result> results;
+};  // end class BaselineReporter
+
+}  // end namespace Bench
+}  // end namespace ML
@@ -19,8 +19,11 @@
 #include <benchmark/benchmark.h>
 #include <cuda_runtime.h>
 #include <cuml/cuml.hpp>
+#include <algorithm>
 #include <sstream>
+#include <string>
 #include <vector>
+#include "baseline.h"
 #include "dataset.cuh"
 #include "utils.h"
 
@@ -71,11 +74,72 @@ class Fixture : public ::benchmark::Fixture {
   virtual void allocateBuffers(const ::benchmark::State& state) {}
   virtual void deallocateBuffers(const ::benchmark::State& state) {}
 
+  /**
+   * the bytes an iteration reads and writes, to report the achieved
+   * bandwidth, or 0 when unknown. The dataset fixtures count one pass over
+   * the dataset, which the algorithms may override with a closer figure.
+   */
+  virtual double bytesPerIteration() const { return 0.0; }
+
   void BenchmarkCase(::benchmark::State& state) {
+    handle->resetDeviceMemoryUsage();
+    size_t baseline = handle->getDeviceMemoryUsage().bytesInUse;
+    handle->resetProfile();
+    handle->setProfiling(true);
     runBenchmark(state);
+    handle->setProfiling(false);
+    setCounters(state, baseline);
     generateMetrics(state);
   }
 
+  /**
+   * Reports, besides the time of the iterations:
+   * - rows/s, the rows of the dataset processed per second
+   * - bytes, GB/s and bw/peak, the bytes of an iteration (see
+   *   bytesPerIteration), and the bandwidth they make, in GB/s and as a
+   *   fraction of the peak bandwidth of the device
+   * - peak_MiB and workspace_MiB, the peak of the device memory allocated
+   *   through the handle during the iterations, in all and on top of what
+   *   was allocated before them (which includes the buffer CudaEventTimer
+   *   uses to flush the L2 cache)
+   * - <phase>_ms, the average GPU time per iteration of each phase of the
+   *   calls (see ML::detail::phaseScope)
+   * The rates are relative to the manual time of the iterations.
+   */
+  void setCounters(::benchmark::State& state, size_t baseline) {
+    typedef ::benchmark::Counter Counter;
+    if (state.error_occurred() || state.iterations() == 0) return;
+    state.counters["rows/s"] =
+      Counter(params.nrows, Counter::kIsIterationInvariantRate);
+    double bytes = bytesPerIteration();
+    if (bytes > 0.0) {
+      state.counters["bytes"] = bytes;
+      state.counters["GB/s"] =
+        Counter(bytes / 1e9, Counter::kIsIterationInvariantRate);
+      double peak = peakBandwidth();
+      if (peak > 0.0) {
+        state.counters["bw/peak"] =
+          Counter(bytes / peak, Counter::kIsIterationInvariantRate);
+      }
+    }
+    memoryUsage usage = handle->getDeviceMemoryUsage();
+    state.counters["peak_MiB"] = usage.peakBytesInUse / 1048576.0;
+    state.counters["workspace_MiB"] =
+      (usage.peakBytesInUse - std::min(baseline, usage.peakBytesInUse)) /
+      1048576.0;
+    double iters = double(state.iterations());
+    for (const auto& p : handle->getImpl().getProfileTimings()) {
+      state.counters[p.name + "_ms"] = p.gpuMs / iters;
+    }
+  }
+
+  /** the peak memory bandwidth of the device in bytes/s, 0 if unknown */
+  double peakBandwidth() const {
+    const cudaDeviceProp& prop = handle->getDeviceProperties();
+    // the memory clock rate is in kHz, and the memory is double data rate
+    return 2.0 * prop.memoryClockRate * 1e3 * (prop.memoryBusWidth / 8.0);
+  }
+
   DatasetParams params;
   std::unique_ptr<cumlHandle> handle;
   cudaStream_t stream;
@@ -107,6 +171,10 @@ class BlobsFixture : public Fixture {
     data.deallocate(*handle, params);
   }
 
+  double bytesPerIteration() const override {
+    return double(params.nrows) * (params.ncols * sizeof(D) + sizeof(L));
+  }
+
   /** parameters passed to `make_blobs` */
   BlobsParams bParams;
   Dataset<D, L> data;
@@ -133,11 +201,47 @@ class RegressionFixture : public Fixture {
     data.deallocate(*handle, params);
   }
 
+  double bytesPerIteration() const override {
+    return double(params.nrows) * (params.ncols + 1) * sizeof(D);
+  }
+
   /** parameters passed to `make_regression` */
   RegressionParams rParams;
   Dataset<D, D> data;
 };  // end class RegressionFixture
 
+/**
+ * Fixture to be used for benchmarking on a dataset read from a binary dataset
+ * file, eg: one converted by `csv_to_binary`, so that datasets of hundreds of
+ * millions of rows load at the bandwidth of the disk. The shape of the
+ * dataset is that of the file, see `binaryDatasetParams`.
+ */
+template <typename D, typename L = int>
+class BinaryFixture : public Fixture {
+ public:
+  BinaryFixture(const DatasetParams p, const std::string& f)
+    : Fixture(p), file(f) {}
+  BinaryFixture() = delete;
+
+ protected:
+  void allocateData(const ::benchmark::State& state) override {
+    data.allocate(*handle, params);
+    data.read_binary(*handle, file, params);
+  }
+
+  void deallocateData(const ::benchmark::State& state) override {
+    data.deallocate(*handle, params);
+  }
+
+  double bytesPerIteration() const override {
+    return double(params.nrows) * (params.ncols * sizeof(D) + sizeof(L));
+  }
+
+  /** path to the binary dataset file */
+  std::string file;
+  Dataset<D, L> data;
+};  // end class BinaryFixture
+
 /**
  * RAII way of timing cuda calls. This has been shamelessly copied from the
  * cudf codebase. So, credits for this class goes to cudf developers.
@@ -200,6 +304,16 @@ struct CudaEventTimer {
 };  // end namespace CudaEventTimer
 
 namespace internal {
+
+/** the dataset of a case, which keys its results in the baselines */
+inline void recordParams(const std::string& name, const DatasetParams& p) {
+  auto& params = caseParams()[name];
+  params["nrows"] = std::to_string(p.nrows);
+  params["ncols"] = std::to_string(p.ncols);
+  params["nclasses"] = std::to_string(p.nclasses);
+  params["rowMajor"] = p.rowMajor ? "true" : "false";
+}
+
 template <typename Params, typename Class>
 struct Registrar {
   Registrar(const std::vector<Params>& paramsList, const std::string& name) {
@@ -208,6 +322,7 @@ struct Registrar {
       std::stringstream oss;
       oss << counter;
       auto testName = name + "/" + oss.str();
+      recordParams(testName, param.data);
       auto* b = ::benchmark::internal::RegisterBenchmarkInternal(
         new Class(testName, param));
       ///@todo: expose a currying-like interface to the final macro
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_runtime.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cuml/common/utils.hpp>
+#include <string>
+
+namespace ML {
+namespace Bench {
+
+/** the element types of a binary dataset */
+enum binaryType : uint32_t { BIN_INT32 = 0, BIN_FLOAT32 = 1, BIN_FLOAT64 = 2 };
+
+template <typename T>
+struct binaryTypeOf;
+template <>
+struct binaryTypeOf<int> {
+  static const binaryType value = BIN_INT32;
+};
+template <>
+struct binaryTypeOf<float> {
+  static const binaryType value = BIN_FLOAT32;
+};
+template <>
+struct binaryTypeOf<double> {
+  static const binaryType value = BIN_FLOAT64;
+};
+
+inline size_t binaryTypeSize(uint32_t type) {
+  return type == BIN_FLOAT64 ? 8 : 4;
+}
+
+/**
+ * The header of a binary dataset file. It is followed by the nrows x ncols
+ * features in row-major order, then by the nrows labels, both in the native
+ * byte order, so that the file is read without any parsing.
+ */
+struct binaryDatasetHeader {
+  static const uint64_t MAGIC = 0x48434e45424c4d43ULL;  // "CMLBENCH"
+  static const uint32_t VERSION = 1;
+  uint64_t magic;
+  uint32_t version;
+  uint32_t dataType;
+  uint32_t labelType;
+  uint32_t reserved;
+  uint64_t nrows;
+  uint64_t ncols;
+
+  size_t dataBytes() const {
+    return size_t(nrows) * ncols * binaryTypeSize(dataType);
+  }
+  size_t labelBytes() const {
+    return size_t(nrows) * binaryTypeSize(labelType);
+  }
+};
+
+/** A binary dataset file mapped in memory, see binaryDatasetHeader */
+class binaryDatasetFile {
+ public:
+  explicit binaryDatasetFile(const std::string& path)
+    : _base(nullptr), _size(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    ASSERT(fd >= 0, "binary dataset: cannot open %s", path.c_str());
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(_header);
+    if (ok) {
+      _size = size_t(st.st_size);
+      _base = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+      ok = _base != MAP_FAILED;
+      if (!ok) _base = nullptr;
+    }
+    close(fd);
+    ASSERT(ok, "binary dataset: cannot map %s", path.c_str());
+    // the pages are read once, in order
+    madvise(_base, _size, MADV_SEQUENTIAL);
+    memcpy(&_header, _base, sizeof(_header));
+    ASSERT(_header.magic == binaryDatasetHeader::MAGIC &&
+             _header.version == binaryDatasetHeader::VERSION,
+           "binary dataset: %s is not a dataset of this version",
+           path.c_str());
+    ASSERT(sizeof(_header) + _header.dataBytes() + _header.labelBytes() <=
+             _size,
+           "binary dataset: %s is truncated", path.c_str());
+  }
+
+  ~binaryDatasetFile() {
+    if (_base != nullptr) munmap(_base, _size);
+  }
+
+  binaryDatasetFile(const binaryDatasetFile&) = delete;
+  binaryDatasetFile& operator=(const binaryDatasetFile&) = delete;
+
+  const binaryDatasetHeader& header() const { return _header; }
+  const void* data() const { return (const char*)_base + sizeof(_header); }
+  const void* labels() const {
+    return (const char*)data() + _header.dataBytes();
+  }
+
+ private:
+  binaryDatasetHeader _header;
+  void* _base;
+  size_t _size;
+};
+
+/**
+ * Copies bytes from the pageable host memory src, eg: a mapped file, to the
+ * device memory dst, in chunks staged through two pinned buffers, so that
+ * reading a chunk from src overlaps the transfer of the previous one, at the
+ * full bandwidth of pinned transfers. Returns once the copy is done.
+ */
+inline void stagedCopyToDevice(void* dst, const void* src, size_t bytes,
+                               cudaStream_t stream,
+                               size_t chunk = size_t(64) << 20) {
+  if (bytes == 0) return;
+  chunk = std::min(chunk, bytes);
+  char* staging[2];
+  cudaEvent_t copied[2];
+  for (int b = 0; b < 2; ++b) {
+    CUDA_CHECK(cudaMallocHost(&staging[b], chunk));
+    CUDA_CHECK(cudaEventCreateWithFlags(&copied[b], cudaEventDisableTiming));
+  }
+  for (size_t off = 0, i = 0; off < bytes; off += chunk, ++i) {
+    int b = int(i % 2);
+    size_t len = std::min(chunk, bytes - off);
+    // the transfer from this buffer two chunks ago must be done
+    CUDA_CHECK(cudaEventSynchronize(copied[b]));
+    memcpy(staging[b], (const char*)src + off, len);
+    CUDA_CHECK(cudaMemcpyAsync((char*)dst + off, staging[b], len,
+                               cudaMemcpyHostToDevice, stream));
+    CUDA_CHECK(cudaEventRecord(copied[b], stream));
+  }
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  for (int b = 0; b < 2; ++b) {
+    CUDA_CHECK(cudaEventDestroy(copied[b]));
+    CUDA_CHECK(cudaFreeHost(staging[b]));
+  }
+}
+
+}  // end namespace Bench
+}  // end namespace ML
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Converts a csv file, one row per line, to a binary dataset file of the
+ * benchmarks (see binaryDatasetHeader), in a single pass over the csv file.
+ *
+ *   csv_to_binary <in.csv> <out.bin> [options]
+ *     --label-col <c>   column of the labels, -1 for the last (default)
+ *     --double          features stored as double rather than float
+ *     --float-labels    labels stored as the features rather than int
+ *     --skip-header     ignore the first line of the csv file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "binary_dataset.h"
+
+namespace ML {
+namespace Bench {
+namespace {
+
+template <typename D>
+void appendFeature(std::vector<char>& row, const char* field) {
+  D v = D(strtod(field, nullptr));
+  row.insert(row.end(), (const char*)&v, (const char*)&v + sizeof(D));
+}
+
+template <typename D, typename L>
+void convert(std::istream& in, FILE* out, const std::string& outfile,
+             int label_col, bool skip_header) {
+  binaryDatasetHeader h;
+  memset(&h, 0, sizeof(h));
+  h.magic = binaryDatasetHeader::MAGIC;
+  h.version = binaryDatasetHeader::VERSION;
+  h.dataType = binaryTypeOf<D>::value;
+  h.labelType = binaryTypeOf<L>::value;
+  // the counts are only known at the end, when the header is rewritten
+  ASSERT(fwrite(&h, sizeof(h), 1, out) == 1, "csv_to_binary: cannot write %s",
+         outfile.c_str());
+  // the labels follow all the features, and are kept until then
+  std::vector<L> labels;
+  std::vector<char> row;
+  std::vector<char*> fields;
+  std::string line;
+  if (skip_header) std::getline(in, line);
+  while (std::getline(in, line)) {
+    if (line.empty() || line == "\r") continue;
+    fields.clear();
+    for (char* f = &line[0];; ++f) {
+      fields.push_back(f);
+      f = strchr(f, ',');
+      if (f == nullptr) break;
+      *f = '\0';
+    }
+    int ncols = int(fields.size());
+    int lc = label_col < 0 ? ncols - 1 : label_col;
+    ASSERT(lc < ncols, "csv_to_binary: row %zu has no column %d",
+           size_t(h.nrows), lc);
+    if (h.nrows == 0) h.ncols = uint64_t(ncols - 1);
+    ASSERT(uint64_t(ncols - 1) == h.ncols,
+           "csv_to_binary: row %zu has %d columns rather than %zu",
+           size_t(h.nrows), ncols, size_t(h.ncols + 1));
+    row.clear();
+    for (int c = 0; c < ncols; ++c) {
+      if (c == lc) {
+        labels.push_back(L(strtod(fields[c], nullptr)));
+      } else {
+        appendFeature<D>(row, fields[c]);
+      }
+    }
+    ASSERT(fwrite(row.data(), 1, row.size(), out) == row.size(),
+           "csv_to_binary: cannot write %s", outfile.c_str());
+    ++h.nrows;
+  }
+  size_t n = labels.size();
+  ASSERT(fwrite(labels.data(), sizeof(L), n, out) == n,
+         "csv_to_binary: cannot write %s", outfile.c_str());
+  ASSERT(fseek(out, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, out) == 1,
+         "csv_to_binary: cannot write %s", outfile.c_str());
+  std::cout << outfile << ": " << h.nrows << " rows x " << h.ncols
+            << " columns" << std::endl;
+}
+
+}  // namespace
+}  // end namespace Bench
+}  // end namespace ML
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " <in.csv> <out.bin> [--label-col c]"
+              << " [--double] [--float-labels] [--skip-header]" << std::endl;
+    return 1;
+  }
+  std::string infile(argv[1]), outfile(argv[2]);
+  int label_col = -1;
+  bool use_double = false, float_labels = false, skip_header = false;
+  for (int i = 3; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg == "--label-col" && i + 1 < argc) {
+      label_col = atoi(argv[++i]);
+    } else if (arg == "--double") {
+      use_double = true;
+    } else if (arg == "--float-labels") {
+      float_labels = true;
+    } else if (arg == "--skip-header") {
+      skip_header = true;
+    } else {
+      std::cerr << "unknown option " << arg << std::endl;
+      return 1;
+    }
+  }
+  try {
+    std::ifstream in(infile);
+    ASSERT(in.good(), "csv_to_binary: cannot open %s", infile.c_str());
+    FILE* out = fopen(outfile.c_str(), "wb");
+    ASSERT(out != nullptr, "csv_to_binary: cannot open %s", outfile.c_str());
+    if (use_double && float_labels) {
+      ML::Bench::convert<double, double>(in, out, outfile, label_col,
+                                         skip_header);
+    } else if (use_double) {
+      ML::Bench::convert<double, int>(in, out, outfile, label_col,
+                                      skip_header);
+    } else if (float_labels) {
+      ML::Bench::convert<float, float>(in, out, outfile, label_col,
+                                       skip_header);
+    } else {
+      ML::Bench::convert<float, int>(in, out, outfile, label_col,
+                                     skip_header);
+    }
+    ASSERT(fclose(out) == 0, "csv_to_binary: cannot write %s",
+           outfile.c_str());
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -18,15 +18,21 @@
 
 #include <cuda_utils.h>
 #include <linalg/transpose.h>
+#include <linalg/unary_op.h>
 #include <random/make_blobs.h>
 #include <random/make_regression.h>
+#include <random/rng.h>
 #include <common/cumlHandle.hpp>
+#include <common/device_buffer.hpp>
 #include <cuml/cuml.hpp>
+#include <algorithm>
+#include <climits>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <vector>
+#include "binary_dataset.h"
 
 namespace ML {
 namespace Bench {
@@ -65,6 +71,12 @@ struct RegressionParams {
   uint64_t seed;
 };
 
+/** Casts the labels of a dataset to the type expected by an algorithm */
+template <typename OutT, typename InT>
+struct LabelCastOp {
+  HDI OutT operator()(InT in) const { return OutT(in); }
+};
+
 /**
  * @brief A simple object to hold the loaded dataset for benchmarking
  * @tparam D type of the dataset (type of X)
@@ -81,16 +93,27 @@ struct Dataset {
   void allocate(const cumlHandle& handle, const DatasetParams& p) {
     auto allocator = handle.getDeviceAllocator();
     auto stream = handle.getStream();
-    X = (D*)allocator->allocate(p.nrows * p.ncols * sizeof(D), stream);
-    y = (L*)allocator->allocate(p.nrows * sizeof(L), stream);
+    X = (D*)allocator->allocate(size_t(p.nrows) * p.ncols * sizeof(D), stream);
+    y = (L*)allocator->allocate(size_t(p.nrows) * sizeof(L), stream);
   }
 
   /** free-up the buffers */
   void deallocate(const cumlHandle& handle, const DatasetParams& p) {
     auto allocator = handle.getDeviceAllocator();
     auto stream = handle.getStream();
-    allocator->deallocate(X, p.nrows * p.ncols * sizeof(D), stream);
-    allocator->deallocate(y, p.nrows * sizeof(L), stream);
+    allocator->deallocate(X, size_t(p.nrows) * p.ncols * sizeof(D), stream);
+    allocator->deallocate(y, size_t(p.nrows) * sizeof(L), stream);
+  }
+
+  /**
+   * Writes the labels cast to T to out, of p.nrows elements, for the
+   * classifiers which take labels of the type of the input, eg: SVC
+   */
+  template <typename T>
+  void labelsAs(T* out, const cumlHandle& handle,
+                const DatasetParams& p) const {
+    MLCommon::LinAlg::unaryOp(out, y, p.nrows, LabelCastOp<T, L>(),
+                              handle.getStream());
   }
 
   /** whether the current dataset is for classification or regression */
@@ -102,27 +125,19 @@ struct Dataset {
    */
   void blobs(const cumlHandle& handle, const DatasetParams& p,
              const BlobsParams& b) {
-    ASSERT(isClassification(),
-           "make_blobs: is only for classification/clustering problems!");
-    const auto& handle_impl = handle.getImpl();
-    auto stream = handle_impl.getStream();
-    auto cublas_handle = handle_impl.getCublasHandle();
-    auto allocator = handle_impl.getDeviceAllocator();
-
-    D* tmpX = X;
+    generateBlobs(handle, p, b, -1);
+  }
 
-    if (!p.rowMajor) {
-      tmpX = (D*)allocator->allocate(p.nrows * p.ncols * sizeof(D), stream);
-    }
-    MLCommon::Random::make_blobs<D, L>(
-      tmpX, y, p.nrows, p.ncols, p.nclasses, allocator, stream, nullptr,
-      nullptr, D(b.cluster_std), b.shuffle, D(b.center_box_min),
-      D(b.center_box_max), b.seed);
-    if (!p.rowMajor) {
-      MLCommon::LinAlg::transpose(tmpX, X, p.nrows, p.ncols, cublas_handle,
-                                  stream);
-      allocator->deallocate(tmpX, p.nrows * p.ncols * sizeof(D), stream);
-    }
+  /**
+   * Generate the rows of the shard `shard` of a blobs dataset sharded across
+   * ranks, eg: for the multi-GPU benchmarks. All the shards draw their p.nrows
+   * rows about the same centers, each with its own seed.
+   * Assumes that the user has already called `allocate`
+   */
+  void blobsShard(const cumlHandle& handle, const DatasetParams& p,
+                  const BlobsParams& b, int shard) {
+    ASSERT(shard >= 0, "make_blobs: shard cannot be negative");
+    generateBlobs(handle, p, b, shard);
   }
 
   /**
@@ -142,7 +157,8 @@ struct Dataset {
     D* tmpX = X;
 
     if (!p.rowMajor) {
-      tmpX = (D*)allocator->allocate(p.nrows * p.ncols * sizeof(D), stream);
+      tmpX = (D*)allocator->allocate(
+        size_t(p.nrows) * p.ncols * sizeof(D), stream);
     }
     MLCommon::Random::make_regression(
       tmpX, y, p.nrows, p.ncols, r.n_informative, cublas_handle,
@@ -151,7 +167,44 @@ struct Dataset {
     if (!p.rowMajor) {
       MLCommon::LinAlg::transpose(tmpX, X, p.nrows, p.ncols, cublas_handle,
                                   stream);
-      allocator->deallocate(tmpX, p.nrows * p.ncols * sizeof(D), stream);
+      allocator->deallocate(tmpX, size_t(p.nrows) * p.ncols * sizeof(D),
+                            stream);
+    }
+  }
+
+  /**
+   * @brief Read a binary dataset file (see binaryDatasetHeader) and construct
+   *        the dataset. The file is mapped in memory, and copied to the
+   *        device through pinned buffers. Assumes that the user has already
+   *        called `allocate`, with the params of binaryDatasetParams.
+   * @param handle cuml handle
+   * @param file the binary dataset file
+   * @param p dataset parameters
+   */
+  void read_binary(const cumlHandle& handle, const std::string& file,
+                   const DatasetParams& p) {
+    const auto& handle_impl = handle.getImpl();
+    auto stream = handle_impl.getStream();
+    auto allocator = handle_impl.getDeviceAllocator();
+    binaryDatasetFile in(file);
+    const binaryDatasetHeader& h = in.header();
+    ASSERT(h.dataType == binaryTypeOf<D>::value &&
+             h.labelType == binaryTypeOf<L>::value,
+           "read_binary: %s does not hold the types of this dataset",
+           file.c_str());
+    ASSERT(h.nrows == uint64_t(p.nrows) && h.ncols == uint64_t(p.ncols),
+           "read_binary: %s is not of %d x %d", file.c_str(), p.nrows,
+           p.ncols);
+    D* tmpX = X;
+    if (!p.rowMajor) {
+      tmpX = (D*)allocator->allocate(h.dataBytes(), stream);
+    }
+    stagedCopyToDevice(tmpX, in.data(), h.dataBytes(), stream);
+    stagedCopyToDevice(y, in.labels(), h.labelBytes(), stream);
+    if (!p.rowMajor) {
+      MLCommon::LinAlg::transpose(tmpX, X, p.nrows, p.ncols,
+                                  handle_impl.getCublasHandle(), stream);
+      allocator->deallocate(tmpX, h.dataBytes(), stream);
     }
   }
 
@@ -174,7 +227,7 @@ struct Dataset {
       ASSERT(false,
              "read_csv: for classification data 'nclasses' is mandatory!");
     }
-    std::vector<D> _X(p.nrows * p.ncols);
+    std::vector<D> _X(size_t(p.nrows) * p.ncols);
     std::vector<L> _y(p.nrows);
     std::ifstream myfile;
     myfile.open(csvfile);
@@ -188,11 +241,70 @@ struct Dataset {
     }
     myfile.close();
     auto stream = handle.getStream();
-    MLCommon::copy(X, &(_X[0]), p.nrows * p.ncols, stream);
+    MLCommon::copy(X, &(_X[0]), size_t(p.nrows) * p.ncols, stream);
     MLCommon::copy(y, &(_y[0]), p.nrows, stream);
   }
 
  private:
+  // the whole dataset when shard is negative
+  void generateBlobs(const cumlHandle& handle, const DatasetParams& p,
+                     const BlobsParams& b, int shard) {
+    ASSERT(isClassification(),
+           "make_blobs: is only for classification/clustering problems!");
+    const auto& handle_impl = handle.getImpl();
+    auto stream = handle_impl.getStream();
+    auto cublas_handle = handle_impl.getCublasHandle();
+    auto allocator = handle_impl.getDeviceAllocator();
+
+    D* tmpX = X;
+
+    if (!p.rowMajor) {
+      tmpX = (D*)allocator->allocate(
+        size_t(p.nrows) * p.ncols * sizeof(D), stream);
+    }
+    if (shard < 0 && size_t(p.nrows) * p.ncols <= size_t(INT_MAX)) {
+      MLCommon::Random::make_blobs<D, L>(
+        tmpX, y, p.nrows, p.ncols, p.nclasses, allocator, stream, nullptr,
+        nullptr, D(b.cluster_std), b.shuffle, D(b.center_box_min),
+        D(b.center_box_max), b.seed);
+    } else {
+      blobsInChunks(tmpX, handle_impl, p, b, std::max(shard, 0));
+    }
+    if (!p.rowMajor) {
+      MLCommon::LinAlg::transpose(tmpX, X, p.nrows, p.ncols, cublas_handle,
+                                  stream);
+      allocator->deallocate(tmpX, size_t(p.nrows) * p.ncols * sizeof(D),
+                            stream);
+    }
+  }
+
+  /**
+   * make_blobs of int indices is limited to INT_MAX elements: the rows are
+   * drawn in chunks of the same centers, each chunk of each shard with its
+   * own seed
+   */
+  void blobsInChunks(D* out, const cumlHandle_impl& handle_impl,
+                     const DatasetParams& p, const BlobsParams& b, int shard) {
+    auto stream = handle_impl.getStream();
+    auto allocator = handle_impl.getDeviceAllocator();
+    MLCommon::device_buffer<D> centers(allocator, stream,
+                                       size_t(p.nclasses) * p.ncols);
+    MLCommon::Random::Rng r(b.seed);
+    r.uniform(centers.data(), centers.size(), D(b.center_box_min),
+              D(b.center_box_max), stream);
+    // a chunk of 2^28 elements at most, which bounds the temporaries of the
+    // shuffle
+    const int chunk_rows = std::max(1, (1 << 28) / p.ncols);
+    for (int row = 0, c = 0; row < p.nrows; row += chunk_rows, ++c) {
+      int rows = std::min(chunk_rows, p.nrows - row);
+      MLCommon::Random::make_blobs<D, L>(
+        out + size_t(row) * p.ncols, y + row, rows, p.ncols, p.nclasses,
+        allocator, stream, centers.data(), nullptr, D(b.cluster_std),
+        b.shuffle, D(b.center_box_min), D(b.center_box_max),
+        b.seed + (uint64_t(shard) << 32) + c + 1);
+    }
+  }
+
   std::vector<std::string> split(const std::string& str, char delimiter) {
     std::vector<std::string> tokens;
     std::string token;
@@ -204,5 +316,24 @@ struct Dataset {
   }
 };
 
+/**
+ * The params of the dataset of a binary dataset file, to allocate it before
+ * Dataset::read_binary
+ */
+inline DatasetParams binaryDatasetParams(const std::string& file,
+                                         bool rowMajor, int nclasses = 0) {
+  binaryDatasetFile in(file);
+  const binaryDatasetHeader& h = in.header();
+  ASSERT(h.nrows <= uint64_t(INT_MAX) && h.ncols <= uint64_t(INT_MAX),
+         "binaryDatasetParams: %s has more rows or columns than an int holds",
+         file.c_str());
+  DatasetParams p;
+  p.nrows = int(h.nrows);
+  p.ncols = int(h.ncols);
+  p.nclasses = nclasses;
+  p.rowMajor = rowMajor;
+  return p;
+}
+
 }  // end namespace Bench
 }  // end namespace ML
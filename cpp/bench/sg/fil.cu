@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/cuml.hpp>
+#include <cuml/fil/fil.h>
+#include <random>
+#include <utility>
+#include "benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace fil {
+
+struct AlgoParams {
+  int depth;
+  int num_trees;
+  ML::fil::storage_type_t storage;
+  ML::fil::algo_t algo;
+  uint64_t seed;
+};
+
+struct Params {
+  DatasetParams data;
+  BlobsParams blobs;
+  AlgoParams fil;
+};
+
+/**
+ * Inference of a forest of random complete trees of the given depth, whose
+ * thresholds are drawn in the range of the samples so that the rows spread
+ * over the leaves, stored as dense, sparse or sparse 8-byte nodes.
+ */
+class FIL : public BlobsFixture<float> {
+ public:
+  FIL(const std::string& name, const Params& p)
+    : BlobsFixture<float>(p.data, p.blobs), fParams(p.fil) {
+    this->SetName(name.c_str());
+  }
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    if (!this->params.rowMajor) {
+      state.SkipWithError("FIL only supports row-major inputs");
+    }
+    auto& handle = *this->handle;
+    auto stream = handle.getStream();
+    for (auto _ : state) {
+      CudaEventTimer timer(handle, state, true, stream);
+      ML::fil::predict(handle, forest, preds, this->data.X,
+                       this->params.nrows);
+    }
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    preds = (float*)allocator->allocate(this->params.nrows * sizeof(float),
+                                        stream);
+    randomTrees();
+    ML::fil::forest_params_t fp;
+    fp.depth = fParams.depth;
+    fp.num_trees = fParams.num_trees;
+    fp.num_cols = this->params.ncols;
+    fp.algo = fParams.algo;
+    fp.output = ML::fil::AVG;
+    fp.threshold = 0.f;
+    fp.global_bias = 0.f;
+    fp.num_classes = 1;
+    if (fParams.storage == ML::fil::DENSE) {
+      fp.num_nodes = int(dense.size());
+      ML::fil::init_dense(*this->handle, &forest, dense.data(), &fp);
+    } else if (fParams.storage == ML::fil::SPARSE) {
+      std::vector<ML::fil::sparse_node_t> nodes(dense.size());
+      toSparse(nodes);
+      fp.num_nodes = int(nodes.size());
+      ML::fil::init_sparse(*this->handle, &forest, roots.data(), nodes.data(),
+                           &fp);
+    } else {
+      std::vector<ML::fil::sparse_node8_t> nodes(dense.size());
+      toSparse(nodes);
+      fp.num_nodes = int(nodes.size());
+      ML::fil::init_sparse(*this->handle, &forest, roots.data(), nodes.data(),
+                           &fp);
+    }
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    ML::fil::free(*this->handle, forest);
+    allocator->deallocate(preds, this->params.nrows * sizeof(float), stream);
+  }
+
+ private:
+  int treeNodes() const { return (1 << (fParams.depth + 1)) - 1; }
+
+  // the complete trees, breadth first, one after the other
+  void randomTrees() {
+    std::mt19937 gen(fParams.seed);
+    std::uniform_int_distribution<int> fid(0, this->params.ncols - 1);
+    std::uniform_real_distribution<float> thresh(this->bParams.center_box_min,
+                                                 this->bParams.center_box_max);
+    std::uniform_real_distribution<float> output(-1.f, 1.f);
+    int n_inner = (1 << fParams.depth) - 1;
+    dense.resize(size_t(treeNodes()) * fParams.num_trees);
+    for (int t = 0; t < fParams.num_trees; ++t) {
+      for (int i = 0; i < treeNodes(); ++i) {
+        bool is_leaf = i >= n_inner;
+        ML::fil::dense_node_init(&dense[size_t(t) * treeNodes() + i],
+                                 output(gen), thresh(gen), fid(gen),
+                                 gen() % 2 == 0, is_leaf);
+      }
+    }
+  }
+
+  // the same trees in sparse nodes, in the same order: the children of node
+  // i of a tree are at 2 * i + 1 and 2 * i + 2 from its root
+  template <typename Node>
+  void toSparse(std::vector<Node>& nodes) {
+    roots.resize(fParams.num_trees);
+    for (int t = 0; t < fParams.num_trees; ++t) {
+      roots[t] = t * treeNodes();
+      for (int i = 0; i < treeNodes(); ++i) {
+        size_t n = size_t(t) * treeNodes() + i;
+        float output, thresh;
+        int fid;
+        bool def_left, is_leaf;
+        ML::fil::dense_node_decode(&dense[n], &output, &thresh, &fid,
+                                   &def_left, &is_leaf);
+        sparseInit(&nodes[n], output, thresh, fid, def_left, is_leaf,
+                   is_leaf ? 0 : 2 * i + 1);
+      }
+    }
+  }
+
+  static void sparseInit(ML::fil::sparse_node_t* node, float output,
+                         float thresh, int fid, bool def_left, bool is_leaf,
+                         int left_index) {
+    ML::fil::sparse_node_init(node, output, thresh, fid, def_left, is_leaf,
+                              left_index);
+  }
+
+  static void sparseInit(ML::fil::sparse_node8_t* node, float output,
+                         float thresh, int fid, bool def_left, bool is_leaf,
+                         int left_index) {
+    ML::fil::sparse_node8_init(node, output, thresh, fid, def_left, is_leaf,
+                               left_index);
+  }
+
+  AlgoParams fParams;
+  std::vector<ML::fil::dense_node_t> dense;
+  std::vector<int> roots;
+  ML::fil::forest_t forest;
+  float* preds;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  p.data.rowMajor = true;
+  p.data.nclasses = 2;
+  p.blobs.cluster_std = 1.0;
+  p.blobs.shuffle = false;
+  p.blobs.center_box_min = -10.0;
+  p.blobs.center_box_max = 10.0;
+  p.blobs.seed = 12345ULL;
+  p.fil.seed = 12345ULL;
+  std::vector<std::pair<int, int>> rowcols = {
+    {100000, 32}, {1000000, 32}, {100000, 256}};
+  // the sparse forests only distinguish NAIVE from the other algorithms
+  std::vector<std::pair<ML::fil::storage_type_t, ML::fil::algo_t>> layouts = {
+    {ML::fil::DENSE, ML::fil::NAIVE},
+    {ML::fil::DENSE, ML::fil::TREE_REORG},
+    {ML::fil::DENSE, ML::fil::BATCH_TREE_REORG},
+    {ML::fil::SPARSE, ML::fil::NAIVE},
+    {ML::fil::SPARSE8, ML::fil::NAIVE}};
+  for (auto& rc : rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    for (auto& dt : std::vector<std::pair<int, int>>({{8, 100}, {12, 500}})) {
+      p.fil.depth = dt.first;
+      p.fil.num_trees = dt.second;
+      for (auto& layout : layouts) {
+        p.fil.storage = layout.first;
+        p.fil.algo = layout.second;
+        out.push_back(p);
+      }
+    }
+  }
+  return out;
+}
+
+CUML_BENCH_REGISTER(Params, FIL, "blobs", getInputs());
+
+}  // end namespace fil
+}  // end namespace Bench
+}  // end namespace ML
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/cuml.hpp>
+#include <cuml/tsa/holtwinters.h>
+#include <cmath>
+#include <random>
+#include <utility>
+#include "benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace holtwinters {
+
+struct AlgoParams {
+  int frequency;
+  int start_periods;
+  ML::SeasonalType seasonal;
+  double epsilon;
+  uint64_t seed;
+};
+
+/** nrows is the length of the series, and ncols the number of series */
+struct Params {
+  DatasetParams data;
+  AlgoParams hw;
+};
+
+/**
+ * Batched fit of the series of a trend plus a sine of period frequency plus
+ * a gaussian noise, stored one after the other
+ */
+template <typename D>
+class HoltWinters : public Fixture {
+ public:
+  HoltWinters(const std::string& name, const Params& p)
+    : Fixture(p.data), hParams(p.hw) {
+    this->SetName(name.c_str());
+  }
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    auto& handle = *this->handle;
+    auto stream = handle.getStream();
+    for (auto _ : state) {
+      CudaEventTimer timer(handle, state, true, stream);
+      ML::HoltWinters::fit(handle, params.nrows, params.ncols,
+                           hParams.frequency, hParams.start_periods,
+                           hParams.seasonal, D(hParams.epsilon), data, level,
+                           trend, season, error);
+    }
+  }
+
+  void allocateData(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    std::mt19937 gen(hParams.seed);
+    std::normal_distribution<D> noise(D(0), D(1));
+    std::vector<D> series(dataLen());
+    const D two_pi = D(2 * M_PI);
+    for (int b = 0; b < params.ncols; ++b) {
+      for (int t = 0; t < params.nrows; ++t) {
+        // positive for the multiplicative seasons
+        series[size_t(b) * params.nrows + t] =
+          D(50) + D(0.1) * t +
+          D(10) * std::sin(two_pi * t / hParams.frequency + b) + noise(gen);
+      }
+    }
+    data = (D*)allocator->allocate(dataLen() * sizeof(D), stream);
+    MLCommon::updateDevice(data, series.data(), dataLen(), stream);
+    // series is pageable and freed on return
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void deallocateData(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    allocator->deallocate(data, dataLen() * sizeof(D), stream);
+  }
+
+  double bytesPerIteration() const override {
+    return double(dataLen()) * sizeof(D);
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    int leveltrend_seed_len, season_seed_len, error_len;
+    int leveltrend_coef_offset, season_coef_offset;
+    ML::HoltWinters::buffer_size(params.nrows, params.ncols, hParams.frequency,
+                                 &leveltrend_seed_len, &season_seed_len,
+                                 &components_len, &error_len,
+                                 &leveltrend_coef_offset, &season_coef_offset);
+    level = (D*)allocator->allocate(components_len * sizeof(D), stream);
+    trend = (D*)allocator->allocate(components_len * sizeof(D), stream);
+    season = (D*)allocator->allocate(components_len * sizeof(D), stream);
+    error = (D*)allocator->allocate(params.ncols * sizeof(D), stream);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    allocator->deallocate(level, components_len * sizeof(D), stream);
+    allocator->deallocate(trend, components_len * sizeof(D), stream);
+    allocator->deallocate(season, components_len * sizeof(D), stream);
+    allocator->deallocate(error, params.ncols * sizeof(D), stream);
+  }
+
+ private:
+  size_t dataLen() const { return size_t(params.nrows) * params.ncols; }
+
+  AlgoParams hParams;
+  int components_len;
+  D *data, *level, *trend, *season, *error;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  p.data.rowMajor = false;
+  p.data.nclasses = 0;
+  p.hw.start_periods = 2;
+  p.hw.epsilon = 2.24e-3;
+  p.hw.seed = 12345ULL;
+  // length, number of series
+  std::vector<std::pair<int, int>> shapes = {
+    {120, 1000}, {120, 100000}, {1000, 10000}};
+  for (auto& shape : shapes) {
+    p.data.nrows = shape.first;
+    p.data.ncols = shape.second;
+    for (auto frequency : std::vector<int>({12, 24})) {
+      p.hw.frequency = frequency;
+      for (auto seasonal : {ML::ADDITIVE, ML::MULTIPLICATIVE}) {
+        p.hw.seasonal = seasonal;
+        out.push_back(p);
+      }
+    }
+  }
+  return out;
+}
+
+CUML_BENCH_REGISTER(Params, HoltWinters<float>, "seasonal", getInputs());
+CUML_BENCH_REGISTER(Params, HoltWinters<double>, "seasonal", getInputs());
+
+}  // end namespace holtwinters
+}  // end namespace Bench
+}  // end namespace ML
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/cuml.hpp>
+#include <cuml/neighbors/knn.hpp>
+#include <utility>
+#include "benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace knn {
+
+struct AlgoParams {
+  int k;
+};
+
+struct Params {
+  DatasetParams data;
+  BlobsParams blobs;
+  AlgoParams knn;
+};
+
+// The neighbors of all the rows of the index, as when building a kNN graph
+class BruteForceKNN : public BlobsFixture<float> {
+ public:
+  BruteForceKNN(const std::string& name, const Params& p)
+    : BlobsFixture<float>(p.data, p.blobs), kParams(p.knn) {
+    this->SetName(name.c_str());
+  }
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    auto& handle = *this->handle;
+    auto stream = handle.getStream();
+    std::vector<float*> input = {this->data.X};
+    std::vector<int> sizes = {this->params.nrows};
+    for (auto _ : state) {
+      CudaEventTimer timer(handle, state, true, stream);
+      ML::brute_force_knn(handle, input, sizes, this->params.ncols,
+                          this->data.X, this->params.nrows, indices, distances,
+                          kParams.k, this->params.rowMajor,
+                          this->params.rowMajor);
+    }
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    size_t len = size_t(this->params.nrows) * kParams.k;
+    indices = (int64_t*)allocator->allocate(len * sizeof(int64_t), stream);
+    distances = (float*)allocator->allocate(len * sizeof(float), stream);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    size_t len = size_t(this->params.nrows) * kParams.k;
+    allocator->deallocate(indices, len * sizeof(int64_t), stream);
+    allocator->deallocate(distances, len * sizeof(float), stream);
+  }
+
+ private:
+  AlgoParams kParams;
+  int64_t* indices;
+  float* distances;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  p.data.nclasses = 8;
+  p.blobs.cluster_std = 1.0;
+  p.blobs.shuffle = false;
+  p.blobs.center_box_min = -10.0;
+  p.blobs.center_box_max = 10.0;
+  p.blobs.seed = 12345ULL;
+  std::vector<std::pair<int, int>> rowcols = {
+    {50000, 32}, {50000, 256}, {200000, 32}};
+  for (auto& rc : rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    for (auto rowMajor : std::vector<bool>({true, false})) {
+      p.data.rowMajor = rowMajor;
+      for (auto k : std::vector<int>({10, 64})) {
+        p.knn.k = k;
+        out.push_back(p);
+      }
+    }
+  }
+  return out;
+}
+
+CUML_BENCH_REGISTER(Params, BruteForceKNN, "blobs", getInputs());
+
+}  // end namespace knn
+}  // end namespace Bench
+}  // end namespace ML
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019, NVIDIA CORPORATION.
+ * Copyright (c) 2019-2020, NVIDIA CORPORATION.
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -15,5 +15,37 @@
  */
 
 #include <benchmark/benchmark.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "baseline.h"
 
-BENCHMARK_MAIN();
+/**
+ * Besides the flags of google benchmark, takes `--cuml_baseline_out=<file>`,
+ * to also write the results to file in the schema of the baselines, see
+ * ML::Bench::BaselineReporter. Run with `--benchmark_repetitions=<n>` for
+ * the comparison to have n samples per case.
+ */
+int main(int argc, char** argv) {
+  std::string baseline;
+  const char* flag = "--cuml_baseline_out=";
+  std::vector<char*> args;
+  for (int i = 0; i < argc; ++i) {
+    if (strncmp(argv[i], flag, strlen(flag)) == 0) {
+      baseline = argv[i] + strlen(flag);
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+  int nArgs = int(args.size());
+  ::benchmark::Initialize(&nArgs, args.data());
+  if (::benchmark::ReportUnrecognizedArguments(nArgs, args.data())) return 1;
+  if (baseline.empty()) {
+    ::benchmark::RunSpecifiedBenchmarks();
+  } else {
+    ::benchmark::ConsoleReporter display;
+    ML::Bench::BaselineReporter reporter(&display, baseline);
+    ::benchmark::RunSpecifiedBenchmarks(&reporter);
+  }
+  return 0;
+}
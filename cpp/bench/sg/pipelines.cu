@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <linalg/transpose.h>
+#include <treelite/c_api.h>
+#include <chrono>
+#include <cmath>
+#include <cuml/cluster/dbscan.hpp>
+#include <cuml/cluster/kmeans.hpp>
+#include <cuml/cuml.hpp>
+#include <cuml/decomposition/pca.hpp>
+#include <cuml/ensemble/randomforest.hpp>
+#include <cuml/fil/fil.h>
+#include <cuml/manifold/umap.hpp>
+#include <map>
+#include <utility>
+#include "benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace pipelines {
+
+/**
+ * The wall-clock times of the stages of a pipeline. A stage ends with the
+ * synchronization of the stream, since the handoffs between the stages
+ * include host work, eg: the treelite export of a random forest, which the
+ * events of the stream would not see.
+ */
+class Stages {
+ public:
+  template <typename Lambda>
+  void run(const std::string& name, cudaStream_t stream, Lambda stage) {
+    auto start = std::chrono::high_resolution_clock::now();
+    stage();
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    std::chrono::duration<double> d =
+      std::chrono::high_resolution_clock::now() - start;
+    if (seconds.find(name) == seconds.end()) order.push_back(name);
+    seconds[name] += d.count();
+  }
+
+  /** reports the average time per iteration of each stage as stage_<name>_ms */
+  void report(::benchmark::State& state) const {
+    if (state.error_occurred() || state.iterations() == 0) return;
+    for (const auto& name : order) {
+      state.counters["stage_" + name + "_ms"] =
+        seconds.at(name) * 1e3 / state.iterations();
+    }
+  }
+
+ private:
+  std::vector<std::string> order;
+  std::map<std::string, double> seconds;
+};
+
+struct UmapDbscanParams {
+  DatasetParams data;
+  BlobsParams blobs;
+  UMAPParams umap;
+  double eps;
+  int min_pts;
+};
+
+/**
+ * DBSCAN of the UMAP embeddings of the rows, the intermediate buffers
+ * allocated in the pipeline
+ */
+class UmapDbscan : public BlobsFixture<float> {
+ public:
+  UmapDbscan(const std::string& name, const UmapDbscanParams& p)
+    : BlobsFixture<float>(p.data, p.blobs),
+      uParams(p.umap),
+      eps(p.eps),
+      minPts(p.min_pts) {
+    this->SetName(name.c_str());
+  }
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    if (!this->params.rowMajor) {
+      state.SkipWithError("UmapDbscan only supports row-major inputs");
+    }
+    auto& handle = *this->handle;
+    auto stream = handle.getStream();
+    auto allocator = handle.getDeviceAllocator();
+    int n = this->params.nrows, d = this->params.ncols;
+    size_t embLen = size_t(n) * uParams.n_components;
+    Stages stages;
+    for (auto _ : state) {
+      CudaEventTimer timer(handle, state, true, stream);
+      float* embeddings;
+      int* labels;
+      stages.run("umap_fit", stream, [&]() {
+        embeddings =
+          (float*)allocator->allocate(embLen * sizeof(float), stream);
+        ML::fit(handle, this->data.X, n, d, &uParams, embeddings);
+      });
+      stages.run("dbscan_fit", stream, [&]() {
+        labels = (int*)allocator->allocate(n * sizeof(int), stream);
+        ML::dbscanFit(handle, embeddings, n, uParams.n_components,
+                      float(eps), minPts, labels);
+      });
+      allocator->deallocate(labels, n * sizeof(int), stream);
+      allocator->deallocate(embeddings, embLen * sizeof(float), stream);
+    }
+    stages.report(state);
+  }
+
+ private:
+  UMAPParams uParams;
+  double eps;
+  int minPts;
+};
+
+struct PcaKMeansParams {
+  DatasetParams data;
+  BlobsParams blobs;
+  int n_components;
+  ML::kmeans::KMeansParams kmeans;
+};
+
+/**
+ * k-means of the PCA projections of the rows. PCA takes and returns
+ * col-major matrices, while k-means takes row-major ones, for a transpose
+ * between the two.
+ */
+template <typename D>
+class PcaKMeans : public BlobsFixture<D> {
+ public:
+  PcaKMeans(const std::string& name, const PcaKMeansParams& p)
+    : BlobsFixture<D>(p.data, p.blobs), kParams(p.kmeans) {
+    this->SetName(name.c_str());
+    prms.n_rows = p.data.nrows;
+    prms.n_cols = p.data.ncols;
+    prms.n_components = p.n_components;
+    prms.algorithm = ML::COV_EIG_DQ;
+  }
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    if (this->params.rowMajor) {
+      state.SkipWithError("PcaKMeans only supports col-major inputs");
+    }
+    auto& handle = *this->handle;
+    auto stream = handle.getStream();
+    auto allocator = handle.getDeviceAllocator();
+    size_t transLen = size_t(prms.n_rows) * prms.n_components;
+    size_t modelLen = modelBufferLen();
+    size_t centroidsLen = size_t(kParams.n_clusters) * prms.n_components;
+    Stages stages;
+    for (auto _ : state) {
+      CudaEventTimer timer(handle, state, true, stream);
+      D *trans, *rowMajor, *model, *centroids;
+      stages.run("pca_fit_transform", stream, [&]() {
+        trans = (D*)allocator->allocate(transLen * sizeof(D), stream);
+        model = (D*)allocator->allocate(modelLen * sizeof(D), stream);
+        D* components = model;
+        D* explained_var = components + prms.n_components * prms.n_cols;
+        D* explained_var_ratio = explained_var + prms.n_components;
+        D* singular_vals = explained_var_ratio + prms.n_components;
+        D* mu = singular_vals + prms.n_components;
+        D* noise_vars = mu + prms.n_cols;
+        ML::pcaFitTransform(handle, this->data.X, trans, components,
+                            explained_var, explained_var_ratio,
+                            singular_vals, mu, noise_vars, prms);
+      });
+      stages.run("transpose", stream, [&]() {
+        rowMajor = (D*)allocator->allocate(transLen * sizeof(D), stream);
+        MLCommon::LinAlg::transpose(trans, rowMajor, prms.n_rows,
+                                    prms.n_components,
+                                    handle.getImpl().getCublasHandle(),
+                                    stream);
+      });
+      stages.run("kmeans_fit", stream, [&]() {
+        centroids = (D*)allocator->allocate(centroidsLen * sizeof(D), stream);
+        ML::kmeans::fit(handle, kParams, rowMajor, prms.n_rows,
+                        prms.n_components, centroids, inertia, nIter);
+      });
+      allocator->deallocate(centroids, centroidsLen * sizeof(D), stream);
+      allocator->deallocate(rowMajor, transLen * sizeof(D), stream);
+      allocator->deallocate(model, modelLen * sizeof(D), stream);
+      allocator->deallocate(trans, transLen * sizeof(D), stream);
+    }
+    stages.report(state);
+  }
+
+ private:
+  // components, explained_var(_ratio), singular_vals, mu and noise_vars
+  size_t modelBufferLen() const {
+    return size_t(prms.n_components) * prms.n_cols + 3 * prms.n_components +
+           prms.n_cols + 1;
+  }
+
+  ML::paramsPCA prms;
+  ML::kmeans::KMeansParams kParams;
+  D inertia;
+  int nIter;
+};
+
+struct RfFilParams {
+  DatasetParams data;
+  BlobsParams blobs;
+  RF_params rf;
+  ML::fil::storage_type_t storage;
+};
+
+/**
+ * Inference with FIL of a random forest fitted on the rows: the forest goes
+ * through its treelite export and import into FIL, and the col-major rows of
+ * the fit are transposed to the row-major ones of FIL
+ */
+class RfFil : public BlobsFixture<float> {
+ public:
+  RfFil(const std::string& name, const RfFilParams& p)
+    : BlobsFixture<float>(p.data, p.blobs),
+      rfParams(p.rf),
+      storage(p.storage) {
+    this->SetName(name.c_str());
+  }
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    if (this->params.rowMajor) {
+      state.SkipWithError("RfFil only supports col-major inputs");
+    }
+    auto& handle = *this->handle;
+    auto stream = handle.getStream();
+    auto allocator = handle.getDeviceAllocator();
+    int n = this->params.nrows, d = this->params.ncols;
+    size_t len = size_t(n) * d;
+    Stages stages;
+    for (auto _ : state) {
+      CudaEventTimer timer(handle, state, true, stream);
+      ML::RandomForestClassifierF rf;
+      ML::RandomForestClassifierF* pRf = &rf;
+      ModelHandle model;
+      ML::fil::forest_t forest;
+      float *rowMajor, *preds;
+      stages.run("rf_fit", stream, [&]() {
+        rf.trees = nullptr;
+        ML::fit(handle, pRf, this->data.X, n, d, this->data.y,
+                this->params.nclasses, rfParams);
+      });
+      stages.run("treelite_export", stream, [&]() {
+        std::vector<unsigned char> bytes;
+        ML::build_treelite_forest(&model, pRf, d, this->params.nclasses,
+                                  bytes);
+      });
+      stages.run("fil_import", stream, [&]() {
+        ML::fil::treelite_params_t tl;
+        tl.algo = ML::fil::ALGO_AUTO;
+        tl.output_class = true;
+        tl.threshold = 0.5f;
+        tl.storage_type = storage;
+        ML::fil::from_treelite(handle, &forest, model, &tl);
+      });
+      stages.run("transpose", stream, [&]() {
+        rowMajor = (float*)allocator->allocate(len * sizeof(float), stream);
+        MLCommon::LinAlg::transpose(this->data.X, rowMajor, n, d,
+                                    handle.getImpl().getCublasHandle(),
+                                    stream);
+      });
+      stages.run("fil_predict", stream, [&]() {
+        preds = (float*)allocator->allocate(n * sizeof(float), stream);
+        ML::fil::predict(handle, forest, preds, rowMajor, n);
+      });
+      allocator->deallocate(preds, n * sizeof(float), stream);
+      allocator->deallocate(rowMajor, len * sizeof(float), stream);
+      ML::fil::free(handle, forest);
+      ASSERT(TreeliteFreeModel(model) == 0, "RfFil: %s",
+             TreeliteGetLastError());
+      delete[] rf.trees;
+    }
+    stages.report(state);
+  }
+
+ private:
+  RF_params rfParams;
+  ML::fil::storage_type_t storage;
+};
+
+std::vector<UmapDbscanParams> getUmapDbscanInputs() {
+  std::vector<UmapDbscanParams> out;
+  UmapDbscanParams p;
+  p.data.rowMajor = true;
+  p.data.nclasses = 10;
+  p.blobs.cluster_std = 1.0;
+  p.blobs.shuffle = false;
+  p.blobs.center_box_min = -10.0;
+  p.blobs.center_box_max = 10.0;
+  p.blobs.seed = 12345ULL;
+  p.umap.n_components = 2;
+  p.umap.n_epochs = 500;
+  p.umap.random_state = 12345;
+  p.eps = 0.5;
+  p.min_pts = 10;
+  std::vector<std::pair<int, int>> rowcols = {{10000, 64}, {100000, 64}};
+  for (auto& rc : rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    out.push_back(p);
+  }
+  return out;
+}
+
+std::vector<PcaKMeansParams> getPcaKMeansInputs() {
+  std::vector<PcaKMeansParams> out;
+  PcaKMeansParams p;
+  p.data.rowMajor = false;
+  p.data.nclasses = 16;
+  p.blobs.cluster_std = 1.0;
+  p.blobs.shuffle = false;
+  p.blobs.center_box_min = -10.0;
+  p.blobs.center_box_max = 10.0;
+  p.blobs.seed = 12345ULL;
+  p.kmeans.n_clusters = p.data.nclasses;
+  p.kmeans.init = ML::kmeans::KMeansParams::InitMethod(0);
+  p.kmeans.max_iter = 300;
+  p.kmeans.tol = 1e-4;
+  p.kmeans.verbose = false;
+  p.kmeans.seed = int(p.blobs.seed);
+  p.kmeans.metric = 0;  // L2
+  p.kmeans.inertia_check = true;
+  std::vector<std::pair<int, int>> rowcols = {{100000, 256}, {1000000, 256}};
+  for (auto& rc : rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    for (auto n_components : std::vector<int>({8, 32})) {
+      p.n_components = n_components;
+      out.push_back(p);
+    }
+  }
+  return out;
+}
+
+std::vector<RfFilParams> getRfFilInputs() {
+  std::vector<RfFilParams> out;
+  RfFilParams p;
+  p.data.rowMajor = false;
+  p.data.nclasses = 2;
+  p.blobs.cluster_std = 10.0;
+  p.blobs.shuffle = false;
+  p.blobs.center_box_min = -10.0;
+  p.blobs.center_box_max = 10.0;
+  p.blobs.seed = 12345ULL;
+  p.rf.bootstrap = true;
+  p.rf.rows_sample = 1.f;
+  p.rf.tree_params.max_leaves = 1 << 20;
+  p.rf.tree_params.min_rows_per_node = 3;
+  p.rf.tree_params.n_bins = 32;
+  p.rf.tree_params.bootstrap_features = true;
+  p.rf.tree_params.quantile_per_tree = false;
+  p.rf.tree_params.split_algo = 1;
+  p.rf.tree_params.split_criterion = (ML::CRITERION)0;
+  p.rf.tree_params.max_depth = 10;
+  p.rf.n_trees = 100;
+  p.rf.n_streams = 8;
+  std::vector<std::pair<int, int>> rowcols = {{160000, 64}, {640000, 64}};
+  for (auto& rc : rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    p.rf.tree_params.max_features = 1.f / std::sqrt(float(rc.second));
+    for (auto storage : {ML::fil::DENSE, ML::fil::SPARSE}) {
+      p.storage = storage;
+      out.push_back(p);
+    }
+  }
+  return out;
+}
+
+CUML_BENCH_REGISTER(UmapDbscanParams, UmapDbscan, "blobs",
+                    getUmapDbscanInputs());
+CUML_BENCH_REGISTER(PcaKMeansParams, PcaKMeans<float>, "blobs",
+                    getPcaKMeansInputs());
+CUML_BENCH_REGISTER(PcaKMeansParams, PcaKMeans<double>, "blobs",
+                    getPcaKMeansInputs());
+CUML_BENCH_REGISTER(RfFilParams, RfFil, "blobs", getRfFilInputs());
+
+}  // end namespace pipelines
+}  // end namespace Bench
+}  // end namespace ML
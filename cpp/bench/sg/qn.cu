@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/cuml.hpp>
+#include <cuml/linear_model/glm.hpp>
+#include <utility>
+#include "benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace qn {
+
+struct AlgoParams {
+  bool fit_intercept;
+  double l1, l2;
+  int max_iter;
+  double grad_tol;
+  int linesearch_max_iter;
+  int lbfgs_memory;
+};
+
+struct Params {
+  DatasetParams data;
+  BlobsParams blobs;
+  AlgoParams qn;
+};
+
+/**
+ * Logistic regression of two classes, or softmax regression of more, by
+ * L-BFGS, or by OWL-QN when l1 is non-zero.
+ */
+template <typename D>
+class QN : public BlobsFixture<D> {
+ public:
+  QN(const std::string& name, const Params& p)
+    : BlobsFixture<D>(p.data, p.blobs), qParams(p.qn) {
+    this->SetName(name.c_str());
+  }
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    auto& handle = *this->handle;
+    auto stream = handle.getStream();
+    int C = nClasses();
+    int loss_type = C == 1 ? 0 : 2;
+    for (auto _ : state) {
+      // every fit starts from zero
+      CUDA_CHECK(cudaMemsetAsync(w0, 0, wLen() * sizeof(D), stream));
+      CudaEventTimer timer(handle, state, true, stream);
+      ML::GLM::qnFit(handle, this->data.X, labels, this->params.nrows,
+                     this->params.ncols, C, qParams.fit_intercept,
+                     D(qParams.l1), D(qParams.l2), qParams.max_iter,
+                     D(qParams.grad_tol), qParams.linesearch_max_iter,
+                     qParams.lbfgs_memory, 0, w0, &f, &nIter,
+                     !this->params.rowMajor, loss_type);
+    }
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    w0 = (D*)allocator->allocate(wLen() * sizeof(D), stream);
+    labels = (D*)allocator->allocate(this->params.nrows * sizeof(D), stream);
+    this->data.labelsAs(labels, *this->handle, this->params);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    allocator->deallocate(w0, wLen() * sizeof(D), stream);
+    allocator->deallocate(labels, this->params.nrows * sizeof(D), stream);
+  }
+
+ private:
+  // the logistic loss has a single set of coefficients
+  int nClasses() const {
+    return this->params.nclasses == 2 ? 1 : this->params.nclasses;
+  }
+
+  size_t wLen() const {
+    return size_t(this->params.ncols + (qParams.fit_intercept ? 1 : 0)) *
+           nClasses();
+  }
+
+  AlgoParams qParams;
+  D* labels;
+  D* w0;
+  D f;
+  int nIter;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  p.blobs.cluster_std = 3.0;
+  p.blobs.shuffle = false;
+  p.blobs.center_box_min = -10.0;
+  p.blobs.center_box_max = 10.0;
+  p.blobs.seed = 12345ULL;
+  p.qn.fit_intercept = true;
+  p.qn.l2 = 1e-2;
+  p.qn.max_iter = 200;
+  p.qn.grad_tol = 1e-6;
+  p.qn.linesearch_max_iter = 50;
+  p.qn.lbfgs_memory = 5;
+  std::vector<std::pair<int, int>> rowcols = {
+    {100000, 32}, {1000000, 32}, {100000, 512}};
+  for (auto& rc : rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    for (auto nclass : std::vector<int>({2, 8})) {
+      p.data.nclasses = nclass;
+      for (auto l1 : std::vector<double>({0.0, 1e-2})) {
+        p.qn.l1 = l1;
+        for (bool rowMajor : {true, false}) {
+          p.data.rowMajor = rowMajor;
+          out.push_back(p);
+        }
+      }
+    }
+  }
+  return out;
+}
+
+CUML_BENCH_REGISTER(Params, QN<float>, "blobs", getInputs());
+CUML_BENCH_REGISTER(Params, QN<double>, "blobs", getInputs());
+
+}  // end namespace qn
+}  // end namespace Bench
+}  // end namespace ML
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/cuml.hpp>
+#include <svm/svc.hpp>
+#include <utility>
+#include "benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace svc {
+
+struct Params {
+  DatasetParams data;
+  BlobsParams blobs;
+  ML::SVM::svmParameter svm;
+  MLCommon::Matrix::KernelParams kernel;
+  // whether to time the prediction of the samples by a model fitted on them
+  // rather than the fit
+  bool predict;
+};
+
+template <typename D>
+class SVC : public BlobsFixture<D> {
+ public:
+  SVC(const std::string& name, const Params& p)
+    : BlobsFixture<D>(p.data, p.blobs),
+      sParams(p.svm),
+      kParams(p.kernel),
+      predict(p.predict) {
+    this->SetName(name.c_str());
+  }
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    if (this->params.rowMajor) {
+      state.SkipWithError("SVC only supports col-major inputs");
+    }
+    auto& handle = *this->handle;
+    auto stream = handle.getStream();
+    int n = this->params.nrows, d = this->params.ncols;
+    for (auto _ : state) {
+      if (predict) {
+        CudaEventTimer timer(handle, state, true, stream);
+        ML::SVM::svcPredict(handle, this->data.X, n, d, kParams, model, preds,
+                            D(200), true);
+      } else {
+        {
+          CudaEventTimer timer(handle, state, true, stream);
+          ML::SVM::svcFit(handle, this->data.X, n, d, labels, sParams,
+                          kParams, model);
+        }
+        // the fit allocates the buffers of the model
+        ML::SVM::svmFreeBuffers(handle, model);
+      }
+    }
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    model = emptyModel();
+    preds = (D*)allocator->allocate(this->params.nrows * sizeof(D), stream);
+    labels = (D*)allocator->allocate(this->params.nrows * sizeof(D), stream);
+    this->data.labelsAs(labels, *this->handle, this->params);
+    if (predict) {
+      ML::SVM::svcFit(*this->handle, this->data.X, this->params.nrows,
+                      this->params.ncols, labels, sParams, kParams, model);
+    }
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    if (predict) ML::SVM::svmFreeBuffers(*this->handle, model);
+    allocator->deallocate(preds, this->params.nrows * sizeof(D), stream);
+    allocator->deallocate(labels, this->params.nrows * sizeof(D), stream);
+  }
+
+ private:
+  ML::SVM::svmModel<D> emptyModel() const {
+    return ML::SVM::svmModel<D>{0,       this->params.ncols, 0, nullptr,
+                                nullptr, nullptr,            0, nullptr};
+  }
+
+  ML::SVM::svmParameter sParams;
+  MLCommon::Matrix::KernelParams kParams;
+  bool predict;
+  ML::SVM::svmModel<D> model;
+  D* labels;
+  D* preds;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  p.data.rowMajor = false;
+  p.data.nclasses = 2;
+  p.blobs.cluster_std = 3.0;
+  p.blobs.shuffle = false;
+  p.blobs.center_box_min = -10.0;
+  p.blobs.center_box_max = 10.0;
+  p.blobs.seed = 12345ULL;
+  // C, cache_size, max_iter, nochange_steps, tol, verbose, epsilon, nu
+  p.svm = ML::SVM::svmParameter{1, 200, -1, 1000, 1e-3, false, 0.1, 0.5};
+  std::vector<std::pair<int, int>> rowcols = {
+    {10000, 32}, {50000, 32}, {50000, 256}};
+  std::vector<MLCommon::Matrix::KernelParams> kernels = {
+    {MLCommon::Matrix::LINEAR, 3, 1, 0}, {MLCommon::Matrix::RBF, 0, 0.01, 0}};
+  for (auto& rc : rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    for (auto& kernel : kernels) {
+      p.kernel = kernel;
+      for (bool predict : {false, true}) {
+        p.predict = predict;
+        out.push_back(p);
+      }
+    }
+  }
+  return out;
+}
+
+CUML_BENCH_REGISTER(Params, SVC<float>, "blobs", getInputs());
+CUML_BENCH_REGISTER(Params, SVC<double>, "blobs", getInputs());
+
+}  // end namespace svc
+}  // end namespace Bench
+}  // end namespace ML
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/cuml.hpp>
+#include <cuml/manifold/tsne.h>
+#include <utility>
+#include "benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace tsne {
+
+struct AlgoParams {
+  int dim;
+  int n_neighbors;
+  int max_iter;
+  bool barnes_hut;
+};
+
+struct Params {
+  DatasetParams data;
+  BlobsParams blobs;
+  AlgoParams tsne;
+};
+
+class TSNE : public BlobsFixture<float> {
+ public:
+  TSNE(const std::string& name, const Params& p)
+    : BlobsFixture<float>(p.data, p.blobs), tParams(p.tsne) {
+    this->SetName(name.c_str());
+  }
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    if (!this->params.rowMajor) {
+      state.SkipWithError("TSNE only supports row-major inputs");
+    }
+    auto& handle = *this->handle;
+    auto stream = handle.getStream();
+    for (auto _ : state) {
+      CudaEventTimer timer(handle, state, true, stream);
+      ML::TSNE_fit(handle, this->data.X, Y, this->params.nrows,
+                   this->params.ncols, tParams.dim, tParams.n_neighbors, 0.5f,
+                   0.0025f, 50.0f, 100, 1e-5f, 12.0f, 250, 0.01f, 200.0f,
+                   500.0f, tParams.max_iter, 1e-7f, 0.5f, 0.8f, 12345, false,
+                   true, tParams.barnes_hut);
+    }
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    Y = (float*)allocator->allocate(
+      size_t(this->params.nrows) * tParams.dim * sizeof(float), stream);
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    allocator->deallocate(
+      Y, size_t(this->params.nrows) * tParams.dim * sizeof(float), stream);
+  }
+
+ private:
+  AlgoParams tParams;
+  float* Y;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  p.data.rowMajor = true;
+  p.data.nclasses = 10;
+  p.blobs.cluster_std = 1.0;
+  p.blobs.shuffle = false;
+  p.blobs.center_box_min = -10.0;
+  p.blobs.center_box_max = 10.0;
+  p.blobs.seed = 12345ULL;
+  p.tsne.dim = 2;
+  p.tsne.n_neighbors = 90;
+  p.tsne.max_iter = 1000;
+  // the exact gradients are O(nrows^2)
+  std::vector<std::pair<int, int>> bh_rowcols = {
+    {10000, 64}, {100000, 64}, {100000, 256}};
+  std::vector<std::pair<int, int>> exact_rowcols = {{5000, 64}, {10000, 64}};
+  p.tsne.barnes_hut = true;
+  for (auto& rc : bh_rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    out.push_back(p);
+  }
+  p.tsne.barnes_hut = false;
+  for (auto& rc : exact_rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    out.push_back(p);
+  }
+  return out;
+}
+
+CUML_BENCH_REGISTER(Params, TSNE, "blobs", getInputs());
+
+}  // end namespace tsne
+}  // end namespace Bench
+}  // end namespace ML
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/cuml.hpp>
+#include <cuml/manifold/umap.hpp>
+#include <utility>
+#include "benchmark.cuh"
+
+namespace ML {
+namespace Bench {
+namespace umap {
+
+struct Params {
+  DatasetParams data;
+  BlobsParams blobs;
+  UMAPParams umap;
+  // whether to time the transform of the samples by a model fitted on them
+  // rather than the fit
+  bool transform;
+};
+
+class UMAP : public BlobsFixture<float> {
+ public:
+  UMAP(const std::string& name, const Params& p)
+    : BlobsFixture<float>(p.data, p.blobs),
+      uParams(p.umap),
+      transform(p.transform) {
+    this->SetName(name.c_str());
+  }
+
+ protected:
+  void runBenchmark(::benchmark::State& state) override {
+    if (!this->params.rowMajor) {
+      state.SkipWithError("UMAP only supports row-major inputs");
+    }
+    auto& handle = *this->handle;
+    auto stream = handle.getStream();
+    int n = this->params.nrows, d = this->params.ncols;
+    for (auto _ : state) {
+      CudaEventTimer timer(handle, state, true, stream);
+      if (transform) {
+        ML::transform(handle, this->data.X, n, d, this->data.X, n, embeddings,
+                      n, &uParams, transformed);
+      } else {
+        ML::fit(handle, this->data.X, n, d, &uParams, embeddings);
+      }
+    }
+  }
+
+  void allocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    size_t len = size_t(this->params.nrows) * uParams.n_components;
+    embeddings = (float*)allocator->allocate(len * sizeof(float), stream);
+    transformed = nullptr;
+    if (transform) {
+      transformed = (float*)allocator->allocate(len * sizeof(float), stream);
+      ML::fit(*this->handle, this->data.X, this->params.nrows,
+              this->params.ncols, &uParams, embeddings);
+    }
+  }
+
+  void deallocateBuffers(const ::benchmark::State& state) override {
+    auto allocator = this->handle->getDeviceAllocator();
+    auto stream = this->handle->getStream();
+    size_t len = size_t(this->params.nrows) * uParams.n_components;
+    allocator->deallocate(embeddings, len * sizeof(float), stream);
+    if (transformed != nullptr) {
+      allocator->deallocate(transformed, len * sizeof(float), stream);
+    }
+  }
+
+ private:
+  UMAPParams uParams;
+  bool transform;
+  float* embeddings;
+  float* transformed;
+};
+
+std::vector<Params> getInputs() {
+  std::vector<Params> out;
+  Params p;
+  p.data.rowMajor = true;
+  p.data.nclasses = 10;
+  p.blobs.cluster_std = 1.0;
+  p.blobs.shuffle = false;
+  p.blobs.center_box_min = -10.0;
+  p.blobs.center_box_max = 10.0;
+  p.blobs.seed = 12345ULL;
+  p.umap.n_components = 2;
+  p.umap.n_epochs = 500;
+  p.umap.random_state = 12345;
+  std::vector<std::pair<int, int>> rowcols = {
+    {10000, 64}, {100000, 64}, {100000, 256}};
+  for (auto& rc : rowcols) {
+    p.data.nrows = rc.first;
+    p.data.ncols = rc.second;
+    for (auto n_neighbors : std::vector<int>({15, 50})) {
+      p.umap.n_neighbors = n_neighbors;
+      for (auto transform : std::vector<bool>({false, true})) {
+        p.transform = transform;
+        out.push_back(p);
+      }
+    }
+  }
+  return out;
+}
+
+CUML_BENCH_REGISTER(Params, UMAP, "blobs", getInputs());
+
+}  // end namespace umap
+}  // end namespace Bench
+}  // end namespace ML
@@ -93,6 +93,8 @@ namespace {
                 return sizeof(float);
             case MLCommon::cumlCommunicator::DOUBLE:
                 return sizeof(double);
+            case MLCommon::cumlCommunicator::HALF:
+                return 2;
         }
     }
 
@@ -116,6 +118,8 @@ namespace {
                 return MPI_FLOAT;
             case MLCommon::cumlCommunicator::DOUBLE:
                 return MPI_DOUBLE;
+            case MLCommon::cumlCommunicator::HALF:
+                ASSERT(false, "ERROR: HALF is only supported by the NCCL collectives");
         }
     }
 
@@ -155,6 +159,8 @@ namespace {
                 return ncclFloat;
             case MLCommon::cumlCommunicator::DOUBLE:
                 return ncclDouble;
+            case MLCommon::cumlCommunicator::HALF:
+                return ncclHalf;
         }
     }
 
@@ -292,6 +298,28 @@ void cumlMPICommunicator_impl::waitall(int count, request_t array_of_requests[])
     MPI_CHECK( MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE) );
 }
 
+//Without NCCL point-to-point the stream-ordered send and receive go through blocking MPI calls,
+//so that an exchange between two ranks must send on one side first.
+void cumlMPICommunicator_impl::device_send(const void *buf, int size, int dest, cudaStream_t stream) const
+{
+#if defined(HAVE_NCCL) && defined(NCCL_VERSION_CODE) && NCCL_VERSION_CODE >= 2700
+    NCCL_CHECK( ncclSend(buf, size, ncclUint8, dest, _nccl_comm, stream) );
+#else
+    CUDA_CHECK( cudaStreamSynchronize( stream ) );
+    MPI_CHECK( MPI_Send(buf, size, MPI_BYTE, dest, 0, _mpi_comm) );
+#endif
+}
+
+void cumlMPICommunicator_impl::device_recv(void *buf, int size, int source, cudaStream_t stream) const
+{
+#if defined(HAVE_NCCL) && defined(NCCL_VERSION_CODE) && NCCL_VERSION_CODE >= 2700
+    NCCL_CHECK( ncclRecv(buf, size, ncclUint8, source, _nccl_comm, stream) );
+#else
+    CUDA_CHECK( cudaStreamSynchronize( stream ) );
+    MPI_CHECK( MPI_Recv(buf, size, MPI_BYTE, source, 0, _mpi_comm, MPI_STATUS_IGNORE) );
+#endif
+}
+
 void cumlMPICommunicator_impl::allreduce(const void* sendbuff, void* recvbuff, int count, datatype_t datatype, op_t op, cudaStream_t stream) const
 {
 #ifdef HAVE_NCCL
@@ -336,10 +364,12 @@ void cumlMPICommunicator_impl::allgatherv(const void *sendbuf, void *recvbuf, co
 {
 #ifdef HAVE_NCCL
     //From: "An Empirical Evaluation of Allgatherv on Multi-GPU Systems" - https://arxiv.org/pdf/1812.05964.pdf
-    //Listing 1 on page 4.
+    //Listing 1 on page 4. Grouped, the broadcasts are launched together.
+    NCCL_CHECK( ncclGroupStart() );
     for (int root = 0; root < _size; ++root) {
         NCCL_CHECK( ncclBroadcast(sendbuf, static_cast<char*>(recvbuf)+displs[root]*getDatatypeSize( datatype ), recvcounts[root], getNCCLDatatype( datatype ), root, _nccl_comm, stream) );
     }
+    NCCL_CHECK( ncclGroupEnd() );
 #else
     CUDA_CHECK( cudaStreamSynchronize( stream ) );
     MPI_CHECK( MPI_Allgatherv(sendbuf, recvcounts[_rank], getMPIDatatype( datatype ), recvbuf, recvcounts, displs, getMPIDatatype( datatype ), _mpi_comm) );
@@ -357,6 +387,62 @@ void cumlMPICommunicator_impl::reducescatter(const void* sendbuff, void* recvbuf
 #endif
 }
 
+void cumlMPICommunicator_impl::alltoall(const void* sendbuff, void* recvbuff, int count, datatype_t datatype, cudaStream_t stream) const
+{
+#ifdef HAVE_NCCL
+    std::vector<int> counts(_size,count), displs(_size);
+    for (int r = 0; r < _size; ++r) {
+        displs[r] = r*count;
+    }
+    alltoallv(sendbuff, counts.data(), displs.data(), recvbuff, counts.data(), displs.data(), datatype, stream);
+#else
+    CUDA_CHECK( cudaStreamSynchronize( stream ) );
+    MPI_CHECK( MPI_Alltoall(sendbuff, count, getMPIDatatype( datatype ), recvbuff, count, getMPIDatatype( datatype ), _mpi_comm) );
+#endif
+}
+
+void cumlMPICommunicator_impl::alltoallv(const void* sendbuf, const int sendcounts[], const int sdispls[], void* recvbuf, const int recvcounts[], const int rdispls[], datatype_t datatype, cudaStream_t stream) const
+{
+#ifdef HAVE_NCCL
+#if defined(NCCL_VERSION_CODE) && NCCL_VERSION_CODE >= 2700
+    //Point-to-point sends and receives, grouped so that they all progress together.
+    NCCL_CHECK( ncclGroupStart() );
+    for (int r = 0; r < _size; ++r) {
+        NCCL_CHECK( ncclSend(static_cast<const char*>(sendbuf)+sdispls[r]*getDatatypeSize( datatype ), sendcounts[r], getNCCLDatatype( datatype ), r, _nccl_comm, stream) );
+        NCCL_CHECK( ncclRecv(static_cast<char*>(recvbuf)+rdispls[r]*getDatatypeSize( datatype ), recvcounts[r], getNCCLDatatype( datatype ), r, _nccl_comm, stream) );
+    }
+    NCCL_CHECK( ncclGroupEnd() );
+#else
+    //NCCL without point-to-point: through MPI, which is blocking.
+    CUDA_CHECK( cudaStreamSynchronize( stream ) );
+    MPI_CHECK( MPI_Alltoallv(sendbuf, sendcounts, sdispls, getMPIDatatype( datatype ), recvbuf, recvcounts, rdispls, getMPIDatatype( datatype ), _mpi_comm) );
+#endif
+#else
+    CUDA_CHECK( cudaStreamSynchronize( stream ) );
+    MPI_CHECK( MPI_Alltoallv(sendbuf, sendcounts, sdispls, getMPIDatatype( datatype ), recvbuf, recvcounts, rdispls, getMPIDatatype( datatype ), _mpi_comm) );
+#endif
+}
+
+void cumlMPICommunicator_impl::groupStart() const
+{
+#ifdef HAVE_NCCL
+    NCCL_CHECK( ncclGroupStart() );
+#endif
+}
+
+void cumlMPICommunicator_impl::groupEnd() const
+{
+#ifdef HAVE_NCCL
+    NCCL_CHECK( ncclGroupEnd() );
+#endif
+}
+
+MLCommon::cumlCommunicator::status_t cumlMPICommunicator_impl::syncEvent(cudaEvent_t event) const
+{
+    CUDA_CHECK( cudaEventSynchronize( event ) );
+    return status_t::commStatusSuccess;
+}
+
 MLCommon::cumlCommunicator::status_t cumlMPICommunicator_impl::syncStream(
   cudaStream_t stream) const {
 
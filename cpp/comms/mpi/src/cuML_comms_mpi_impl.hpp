@@ -51,6 +51,10 @@ public:
 
     virtual void waitall(int count, request_t array_of_requests[]) const;
 
+    virtual void device_send(const void *buf, int size, int dest, cudaStream_t stream) const;
+
+    virtual void device_recv(void *buf, int size, int source, cudaStream_t stream) const;
+
     virtual void allreduce(const void* sendbuff, void* recvbuff, int count, datatype_t datatype, op_t op, cudaStream_t stream) const;
 
     virtual void bcast(void* buff, int count, datatype_t datatype, int root, cudaStream_t stream) const;
@@ -63,8 +67,18 @@ public:
 
     virtual void reducescatter(const void* sendbuff, void* recvbuff, int recvcount, datatype_t datatype, op_t op, cudaStream_t stream) const;
 
+    virtual void alltoall(const void* sendbuff, void* recvbuff, int count, datatype_t datatype, cudaStream_t stream) const;
+
+    virtual void alltoallv(const void* sendbuf, const int sendcounts[], const int sdispls[], void* recvbuf, const int recvcounts[], const int rdispls[], datatype_t datatype, cudaStream_t stream) const;
+
+    virtual void groupStart() const;
+
+    virtual void groupEnd() const;
+
     virtual status_t syncStream(cudaStream_t stream) const;
 
+    virtual status_t syncEvent(cudaEvent_t event) const;
+
 private:
     bool                                                _owns_mpi_comm;
     MPI_Comm                                            _mpi_comm;
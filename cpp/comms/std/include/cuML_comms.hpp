@@ -22,6 +22,7 @@
 #include <ucp/api/ucp.h>
 #endif
 
+#include <cuml/common/deviceGroup.hpp>
 #include <cuml/cuml.hpp>
 
 namespace ML {
@@ -53,4 +54,13 @@ void inject_comms(cumlHandle &handle, ncclComm_t comm, ucp_worker_h ucp_worker,
  */
 void inject_comms(cumlHandle &handle, ncclComm_t comm, int size, int rank);
 
+/**
+ * @brief Builds the NCCL communicators of the ranks of a single-process
+ * device group and injects them into the handles of the group, for the
+ * collective communications functions. The NCCL communicators are owned by
+ * the handles and destroyed with their last cumlCommunicator.
+ * @param group the devices of the process, whose handles get communicators
+ */
+void inject_comms_local(cumlDeviceGroup &group);
+
 }  // end namespace ML
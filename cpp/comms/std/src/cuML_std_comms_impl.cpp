@@ -34,6 +34,7 @@ constexpr bool UCX_ENABLED = false;
 #include <cstdio>
 #include <exception>
 #include <memory>
+#include <vector>
 
 #include <common/cumlHandle.hpp>
 #include <cuML_comms.hpp>
@@ -83,6 +84,8 @@ size_t getDatatypeSize(const cumlStdCommunicator_impl::datatype_t datatype) {
       return sizeof(float);
     case MLCommon::cumlCommunicator::DOUBLE:
       return sizeof(double);
+    case MLCommon::cumlCommunicator::HALF:
+      return 2;
   }
 }
 
@@ -105,6 +108,8 @@ ncclDataType_t getNCCLDatatype(
       return ncclFloat;
     case MLCommon::cumlCommunicator::DOUBLE:
       return ncclDouble;
+    case MLCommon::cumlCommunicator::HALF:
+      return ncclHalf;
   }
 }
 
@@ -150,6 +155,31 @@ void inject_comms(cumlHandle &handle, ncclComm_t comm, int size, int rank) {
   handle.getImpl().setCommunicator(communicator);
 }
 
+void inject_comms_local(cumlDeviceGroup &group) {
+  int size = group.size();
+  std::vector<int> devices(size);
+  for (int rank = 0; rank < size; rank++) devices[rank] = group.getDevice(rank);
+  std::vector<ncclComm_t> comms(size);
+  NCCL_CHECK(ncclCommInitAll(comms.data(), size, devices.data()));
+  int previous;
+  CUDA_CHECK(cudaGetDevice(&previous));
+  for (int rank = 0; rank < size; rank++) {
+    ncclComm_t comm = comms[rank];
+    // the communicator creates its stream and buffers on the current device
+    CUDA_CHECK(cudaSetDevice(devices[rank]));
+    std::shared_ptr<MLCommon::cumlCommunicator> communicator(
+      new MLCommon::cumlCommunicator(
+        std::unique_ptr<MLCommon::cumlCommunicator_iface>(
+          new cumlStdCommunicator_impl(comm, size, rank))),
+      [comm](MLCommon::cumlCommunicator *c) {
+        delete c;
+        NCCL_CHECK_NO_THROW(ncclCommDestroy(comm));
+      });
+    group.getHandle(rank).getImpl().setCommunicator(communicator);
+  }
+  CUDA_CHECK(cudaSetDevice(previous));
+}
+
 void inject_comms_py_coll(cumlHandle *handle, ncclComm_t comm, int size,
                           int rank) {
   inject_comms(*handle, comm, size, rank);
@@ -212,6 +242,7 @@ cumlStdCommunicator_impl::cumlStdCommunicator_impl(
   ncclComm_t comm, ucp_worker_h ucp_worker, std::shared_ptr<ucp_ep_h *> eps,
   int size, int rank)
   : _nccl_comm(comm),
+    _owns_nccl_comm(false),
     _ucp_worker(ucp_worker),
     _ucp_eps(eps),
     _size(size),
@@ -222,8 +253,12 @@ cumlStdCommunicator_impl::cumlStdCommunicator_impl(
 #endif
 
 cumlStdCommunicator_impl::cumlStdCommunicator_impl(ncclComm_t comm, int size,
-                                                   int rank)
-  : _nccl_comm(comm), _size(size), _rank(rank) {
+                                                   int rank,
+                                                   bool owns_nccl_comm)
+  : _nccl_comm(comm),
+    _owns_nccl_comm(owns_nccl_comm),
+    _size(size),
+    _rank(rank) {
   initialize();
 }
 
@@ -239,6 +274,8 @@ cumlStdCommunicator_impl::~cumlStdCommunicator_impl() {
 
   CUDA_CHECK_NO_THROW(cudaFree(_sendbuff));
   CUDA_CHECK_NO_THROW(cudaFree(_recvbuff));
+
+  if (_owns_nccl_comm) NCCL_CHECK_NO_THROW(ncclCommDestroy(_nccl_comm));
 }
 
 int cumlStdCommunicator_impl::getSize() const { return _size; }
@@ -247,10 +284,50 @@ int cumlStdCommunicator_impl::getRank() const { return _rank; }
 
 std::unique_ptr<MLCommon::cumlCommunicator_iface>
 cumlStdCommunicator_impl::commSplit(int color, int key) const {
-  // Not supported by NCCL
-  ASSERT(false,
-         "ERROR: commSplit called but not yet supported in this comms "
-         "implementation.");
+  // NCCL has no split: the ranks exchange their colors and keys, then the
+  // first rank of each color creates the clique of its color. The new
+  // communicator is collective-only.
+  std::vector<int> colorKeys(2 * _size);
+  colorKeys[2 * _rank] = color;
+  colorKeys[2 * _rank + 1] = key;
+  hostAllgather(colorKeys.data(), 2 * sizeof(int));
+
+  // the ranks of the color, ordered by key then by rank
+  std::vector<std::pair<int, int>> members;
+  for (int r = 0; r < _size; ++r) {
+    if (colorKeys[2 * r] == color)
+      members.emplace_back(colorKeys[2 * r + 1], r);
+  }
+  std::sort(members.begin(), members.end());
+  int subRank = 0;
+  while (members[subRank].second != _rank) ++subRank;
+  int subSize = members.size();
+
+  std::vector<ncclUniqueId> ids(_size);
+  if (subRank == 0) NCCL_CHECK(ncclGetUniqueId(&ids[_rank]));
+  hostAllgather(ids.data(), sizeof(ncclUniqueId));
+
+  ncclComm_t comm;
+  NCCL_CHECK(
+    ncclCommInitRank(&comm, subSize, ids[members[0].second], subRank));
+  return std::unique_ptr<MLCommon::cumlCommunicator_iface>(
+    new cumlStdCommunicator_impl(comm, subSize, subRank, true));
+}
+
+void cumlStdCommunicator_impl::hostAllgather(void *buf, int bytes) const {
+  char *buf_h = static_cast<char *>(buf);
+  char *buf_d;
+  CUDA_CHECK(cudaMalloc(&buf_d, _size * bytes));
+  CUDA_CHECK(cudaMemcpyAsync(buf_d + _rank * bytes, buf_h + _rank * bytes,
+                             bytes, cudaMemcpyHostToDevice, _stream));
+  allgather(buf_d + _rank * bytes, buf_d, bytes,
+            MLCommon::cumlCommunicator::CHAR, _stream);
+  CUDA_CHECK(cudaMemcpyAsync(buf_h, buf_d, _size * bytes,
+                             cudaMemcpyDeviceToHost, _stream));
+  status_t status = syncStream(_stream);
+  CUDA_CHECK(cudaFree(buf_d));
+  ASSERT(status == status_t::commStatusSuccess,
+         "ERROR: syncStream failed. This can be caused by a failed rank.");
 }
 
 void cumlStdCommunicator_impl::barrier() const {
@@ -361,6 +438,24 @@ void cumlStdCommunicator_impl::waitall(int count,
 #endif
 }
 
+void cumlStdCommunicator_impl::device_send(const void *buf, int size, int dest,
+                                           cudaStream_t stream) const {
+#if defined(NCCL_VERSION_CODE) && NCCL_VERSION_CODE >= 2700
+  NCCL_CHECK(ncclSend(buf, size, ncclUint8, dest, _nccl_comm, stream));
+#else
+  ASSERT(false, "ERROR: device_send requires NCCL 2.7 or later");
+#endif
+}
+
+void cumlStdCommunicator_impl::device_recv(void *buf, int size, int source,
+                                           cudaStream_t stream) const {
+#if defined(NCCL_VERSION_CODE) && NCCL_VERSION_CODE >= 2700
+  NCCL_CHECK(ncclRecv(buf, size, ncclUint8, source, _nccl_comm, stream));
+#else
+  ASSERT(false, "ERROR: device_recv requires NCCL 2.7 or later");
+#endif
+}
+
 void cumlStdCommunicator_impl::allreduce(const void *sendbuff, void *recvbuff,
                                          int count, datatype_t datatype,
                                          op_t op, cudaStream_t stream) const {
@@ -394,12 +489,14 @@ void cumlStdCommunicator_impl::allgatherv(const void *sendbuf, void *recvbuf,
                                           datatype_t datatype,
                                           cudaStream_t stream) const {
   //From: "An Empirical Evaluation of Allgatherv on Multi-GPU Systems" - https://arxiv.org/pdf/1812.05964.pdf
-  //Listing 1 on page 4.
+  //Listing 1 on page 4. Grouped, the broadcasts are launched together.
+  NCCL_CHECK(ncclGroupStart());
   for (int root = 0; root < _size; ++root)
     NCCL_CHECK(ncclBroadcast(
       sendbuf,
       static_cast<char *>(recvbuf) + displs[root] * getDatatypeSize(datatype),
       recvcounts[root], getNCCLDatatype(datatype), root, _nccl_comm, stream));
+  NCCL_CHECK(ncclGroupEnd());
 }
 
 void cumlStdCommunicator_impl::reducescatter(const void *sendbuff,
@@ -411,16 +508,55 @@ void cumlStdCommunicator_impl::reducescatter(const void *sendbuff,
                                _nccl_comm, stream));
 }
 
-MLCommon::cumlCommunicator::status_t cumlStdCommunicator_impl::syncStream(
-  cudaStream_t stream) const {
+void cumlStdCommunicator_impl::alltoall(const void *sendbuff, void *recvbuff,
+                                        int count, datatype_t datatype,
+                                        cudaStream_t stream) const {
+  std::vector<int> counts(_size, count), displs(_size);
+  for (int r = 0; r < _size; ++r) displs[r] = r * count;
+  alltoallv(sendbuff, counts.data(), displs.data(), recvbuff, counts.data(),
+            displs.data(), datatype, stream);
+}
+
+void cumlStdCommunicator_impl::alltoallv(
+  const void *sendbuf, const int sendcounts[], const int sdispls[],
+  void *recvbuf, const int recvcounts[], const int rdispls[],
+  datatype_t datatype, cudaStream_t stream) const {
+#if defined(NCCL_VERSION_CODE) && NCCL_VERSION_CODE >= 2700
+  // Point-to-point sends and receives, grouped so that they all progress
+  // together without deadlocking on the order of the ranks
+  size_t dtsize = getDatatypeSize(datatype);
+  ncclDataType_t ncclType = getNCCLDatatype(datatype);
+  NCCL_CHECK(ncclGroupStart());
+  for (int r = 0; r < _size; ++r) {
+    NCCL_CHECK(
+      ncclSend(static_cast<const char *>(sendbuf) + sdispls[r] * dtsize,
+               sendcounts[r], ncclType, r, _nccl_comm, stream));
+    NCCL_CHECK(ncclRecv(static_cast<char *>(recvbuf) + rdispls[r] * dtsize,
+                        recvcounts[r], ncclType, r, _nccl_comm, stream));
+  }
+  NCCL_CHECK(ncclGroupEnd());
+#else
+  ASSERT(false, "ERROR: alltoallv requires NCCL 2.7 or later");
+#endif
+}
+
+void cumlStdCommunicator_impl::groupStart() const {
+  NCCL_CHECK(ncclGroupStart());
+}
+
+void cumlStdCommunicator_impl::groupEnd() const { NCCL_CHECK(ncclGroupEnd()); }
+
+template <typename Query>
+MLCommon::cumlCommunicator::status_t cumlStdCommunicator_impl::waitUntilDone(
+  Query query) const {
   cudaError_t cudaErr;
   ncclResult_t ncclErr, ncclAsyncErr;
   while (1) {
-    cudaErr = cudaStreamQuery(stream);
+    cudaErr = query();
     if (cudaErr == cudaSuccess) return status_t::commStatusSuccess;
 
     if (cudaErr != cudaErrorNotReady) {
-      // An error occurred querying the status of the stream
+      // An error occurred querying the status of the stream or event
       return status_t::commStatusError;
     }
 
@@ -444,4 +580,14 @@ MLCommon::cumlCommunicator::status_t cumlStdCommunicator_impl::syncStream(
   }
 }
 
+MLCommon::cumlCommunicator::status_t cumlStdCommunicator_impl::syncStream(
+  cudaStream_t stream) const {
+  return waitUntilDone([stream]() { return cudaStreamQuery(stream); });
+}
+
+MLCommon::cumlCommunicator::status_t cumlStdCommunicator_impl::syncEvent(
+  cudaEvent_t event) const {
+  return waitUntilDone([event]() { return cudaEventQuery(event); });
+}
+
 }  // end namespace ML
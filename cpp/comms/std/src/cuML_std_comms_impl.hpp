@@ -69,8 +69,10 @@ class cumlStdCommunicator_impl : public MLCommon::cumlCommunicator_iface {
    * @param comm initilized nccl communicator
    * @param size size of the cluster
    * @param rank rank of the current worker
+   * @param owns_nccl_comm whether to destroy comm with the instance
    */
-  cumlStdCommunicator_impl(ncclComm_t comm, int size, int rank);
+  cumlStdCommunicator_impl(ncclComm_t comm, int size, int rank,
+                           bool owns_nccl_comm = false);
 
   virtual ~cumlStdCommunicator_impl();
 
@@ -91,6 +93,12 @@ class cumlStdCommunicator_impl : public MLCommon::cumlCommunicator_iface {
 
   virtual void waitall(int count, request_t array_of_requests[]) const;
 
+  virtual void device_send(const void* buf, int size, int dest,
+                           cudaStream_t stream) const;
+
+  virtual void device_recv(void* buf, int size, int source,
+                           cudaStream_t stream) const;
+
   virtual void allreduce(const void* sendbuff, void* recvbuff, int count,
                          datatype_t datatype, op_t op,
                          cudaStream_t stream) const;
@@ -113,10 +121,25 @@ class cumlStdCommunicator_impl : public MLCommon::cumlCommunicator_iface {
                              int recvcount, datatype_t datatype, op_t op,
                              cudaStream_t stream) const;
 
+  virtual void alltoall(const void* sendbuff, void* recvbuff, int count,
+                        datatype_t datatype, cudaStream_t stream) const;
+
+  virtual void alltoallv(const void* sendbuf, const int sendcounts[],
+                         const int sdispls[], void* recvbuf,
+                         const int recvcounts[], const int rdispls[],
+                         datatype_t datatype, cudaStream_t stream) const;
+
+  virtual void groupStart() const;
+
+  virtual void groupEnd() const;
+
   virtual status_t syncStream(cudaStream_t stream) const;
 
+  virtual status_t syncEvent(cudaEvent_t event) const;
+
  private:
   ncclComm_t _nccl_comm;
+  bool _owns_nccl_comm;
   cudaStream_t _stream;
 
   int *_sendbuff, *_recvbuff;
@@ -126,6 +149,11 @@ class cumlStdCommunicator_impl : public MLCommon::cumlCommunicator_iface {
 
   void initialize();
   void get_request_id(request_t* req) const;
+  /** allgathers the bytes of buf, on the host, at buf + rank * bytes */
+  void hostAllgather(void* buf, int bytes) const;
+  /** polls query until done, aborting the comm on asynchronous errors */
+  template <typename Query>
+  status_t waitUntilDone(Query query) const;
 
 #ifdef WITH_UCX
   ucp_worker_h _ucp_worker;
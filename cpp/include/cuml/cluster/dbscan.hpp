@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cuml/cuml.hpp>
+#include <cuml/neighbors/knn.hpp>
 
 namespace ML {
 
@@ -30,9 +31,12 @@ namespace ML {
  * @param[in] eps the epsilon value to use for epsilon-neighborhood determination
  * @param[in] min_pts minimum number of points to determine a cluster
  * @param[out] labels (size n_rows) output labels array
- * @param[in] max_mem_mbytes: the maximum number of megabytes to be used for each batch of
- *            the pairwise distance calculation. This enables the trade off between
+ * @param[in] max_mem_mbytes: the maximum number of megabytes of the epsilon
+ *            neighborhood graph of each batch, whose memory is proportional
+ *            to its number of edges. This enables the trade off between
  *            memory usage and algorithm execution time.
+ *            When 0, it is sized from the free device memory, as returned
+ *            by dbscanMaxMbytesPerBatch.
  * @param[in] verbose: print useful information as algorithm executes
  * @{
  */
@@ -52,4 +56,184 @@ void dbscanFit(const cumlHandle &handle, double *input, int64_t n_rows,
 
 /** @} */
 
+/**
+ * @brief Fits a DBSCAN model with the given metric on an input feature matrix
+ * and outputs the labels. The parameters are those of dbscanFit, and:
+ * @param[in] metric METRIC_L2, or METRIC_COSINE for the cosine distance,
+ *            1 - cosine similarity, with eps in [0, 2]. The rows of zero norm
+ *            are at distance 0 of each other and 1/2 of the other rows.
+ * @{
+ */
+void dbscanFit(const cumlHandle &handle, float *input, int n_rows, int n_cols,
+               float eps, int min_pts, MetricType metric, int *labels,
+               size_t max_bytes_per_batch = 0, bool verbose = false);
+void dbscanFit(const cumlHandle &handle, double *input, int n_rows, int n_cols,
+               double eps, int min_pts, MetricType metric, int *labels,
+               size_t max_bytes_per_batch = 0, bool verbose = false);
+
+void dbscanFit(const cumlHandle &handle, float *input, int64_t n_rows,
+               int64_t n_cols, float eps, int min_pts, MetricType metric,
+               int64_t *labels, size_t max_bytes_per_batch = 0,
+               bool verbose = false);
+void dbscanFit(const cumlHandle &handle, double *input, int64_t n_rows,
+               int64_t n_cols, double eps, int min_pts, MetricType metric,
+               int64_t *labels, size_t max_bytes_per_batch = 0,
+               bool verbose = false);
+/** @} */
+
+/**
+ * @brief Fits a DBSCAN model on a precomputed neighborhood graph, such as a
+ * knn graph, and outputs the labels. The neighbors of each sample are a row
+ * of the CSR graph; the graph does not have to be symmetric. A sample is a
+ * core point when it has at least min_pts neighbors, so each row should
+ * include the sample itself, as with the epsilon neighborhoods of dbscanFit.
+ * @param[in] handle cuml handle to use across the algorithm
+ * @param[in] indptr (size n_rows + 1) CSR row offsets of the graph
+ * @param[in] indices CSR column indices of the graph, the neighbors
+ * @param[in] distances null to keep all the neighbors, or the distances of
+ *            the neighbors, of which only those within eps are kept
+ * @param[in] n_rows number of samples
+ * @param[in] eps the epsilon value, unused without distances
+ * @param[in] min_pts minimum number of points to determine a cluster
+ * @param[out] labels (size n_rows) output labels array
+ * @param[in] verbose: print useful information as algorithm executes
+ * @{
+ */
+void dbscanFit(const cumlHandle &handle, const int *indptr, const int *indices,
+               const float *distances, int n_rows, float eps, int min_pts,
+               int *labels, bool verbose = false);
+void dbscanFit(const cumlHandle &handle, const int *indptr, const int *indices,
+               const double *distances, int n_rows, double eps, int min_pts,
+               int *labels, bool verbose = false);
+
+void dbscanFit(const cumlHandle &handle, const int64_t *indptr,
+               const int64_t *indices, const float *distances, int64_t n_rows,
+               float eps, int min_pts, int64_t *labels, bool verbose = false);
+void dbscanFit(const cumlHandle &handle, const int64_t *indptr,
+               const int64_t *indices, const double *distances, int64_t n_rows,
+               double eps, int min_pts, int64_t *labels, bool verbose = false);
+/** @} */
+
+/**
+ * @defgroup DbscanHierarchyCpp Density-based hierarchy of the DBSCAN* clusters
+ * @brief Computes the hierarchy of the DBSCAN* clusters of all the eps up to
+ * max_eps at once, as in HDBSCAN*: the core distance of each sample, the
+ * distance to its min_pts-th nearest neighbor, itself included, and the
+ * minimum spanning forest of the mutual reachability graph, whose edges join
+ * the samples within max_eps of each other and weigh the max of their
+ * distance and of their core distances. The epsilon neighborhood graph at
+ * max_eps is built whole, so max_eps bounds the memory.
+ * @param[in] handle cuml handle to use across the algorithm
+ * @param[in] input row-major input feature matrix
+ * @param[in] n_rows number of samples in the input feature matrix
+ * @param[in] n_cols number of features in the input feature matrix
+ * @param[in] min_pts minimum number of points to determine a cluster
+ * @param[in] max_eps the largest eps of the hierarchy, > 0
+ * @param[out] core_dists (size n_rows) core distance of each sample, or the
+ *             max float when it is above max_eps
+ * @param[out] mst_src (size n_rows - 1) source of each edge of the forest
+ * @param[out] mst_dst (size n_rows - 1) destination of each edge
+ * @param[out] mst_weights (size n_rows - 1) weight of each edge, ascending
+ * @param[in] verbose: print useful information as algorithm executes
+ * @return the number of edges of the forest
+ */
+int dbscanHierarchy(const cumlHandle &handle, const float *input, int n_rows,
+                    int n_cols, int min_pts, float max_eps, float *core_dists,
+                    int *mst_src, int *mst_dst, float *mst_weights,
+                    bool verbose = false);
+
+/**
+ * @brief Labels of the DBSCAN* clusters at eps from the hierarchy of
+ * dbscanHierarchy, at the cost of a pass over the forest, so that a sweep
+ * over eps needs a single hierarchy. As in DBSCAN*, the border points of
+ * dbscanFit are noise.
+ * @param[in] handle cuml handle to use across the algorithm
+ * @param[in] core_dists (size n_rows) core distances of the samples
+ * @param[in] mst_src source of each edge of the forest
+ * @param[in] mst_dst destination of each edge of the forest
+ * @param[in] mst_weights weight of each edge of the forest
+ * @param[in] n_edges number of edges of the forest
+ * @param[in] n_rows number of samples
+ * @param[in] eps the epsilon value, at most the max_eps of the hierarchy
+ * @param[out] labels (size n_rows) output labels array
+ */
+void dbscanCutHierarchy(const cumlHandle &handle, const float *core_dists,
+                        const int *mst_src, const int *mst_dst,
+                        const float *mst_weights, int n_edges, int n_rows,
+                        float eps, int *labels);
+
+/**
+ * @brief Fits an HDBSCAN* model: the labels of the most stable clusters of
+ * the hierarchy of dbscanHierarchy, by the excess of mass. The single linkage
+ * tree of the forest is condensed to the clusters of at least
+ * min_cluster_size samples, and a cluster is selected over the clusters it
+ * splits into when its stability is at least the sum of theirs.
+ * @param[in] handle cuml handle to use across the algorithm
+ * @param[in] input row-major input feature matrix
+ * @param[in] n_rows number of samples in the input feature matrix
+ * @param[in] n_cols number of features in the input feature matrix
+ * @param[in] min_pts minimum number of points to determine a core point
+ * @param[in] min_cluster_size the minimum number of samples of a cluster, >= 2
+ * @param[in] max_eps the largest eps of the hierarchy, > 0
+ * @param[out] labels (size n_rows) output labels array, -1 for the noise
+ * @param[in] verbose: print useful information as algorithm executes
+ */
+void hdbscanFit(const cumlHandle &handle, const float *input, int n_rows,
+                int n_cols, int min_pts, int min_cluster_size, float max_eps,
+                int *labels, bool verbose = false);
+/** @} */
+
+/**
+ * @brief Megabytes of the epsilon neighborhood graph of each batch that
+ * dbscanFit uses when max_bytes_per_batch is 0: what the free device memory
+ * leaves after the other allocations of the fit, with some headroom. The
+ * value depends on the free memory at the time of the call.
+ * @param[in] handle cuml handle to use across the algorithm
+ * @param[in] n_rows number of samples in the input feature matrix
+ * @param[in] n_cols number of features in the input feature matrix
+ * @return the megabytes of the graph of each batch, at least 1
+ * @{
+ */
+size_t dbscanMaxMbytesPerBatch(const cumlHandle &handle, int n_rows,
+                               int n_cols);
+size_t dbscanMaxMbytesPerBatch(const cumlHandle &handle, int64_t n_rows,
+                               int64_t n_cols);
+/** @} */
+
+/**
+ * @defgroup DbscanMGCpp C++ implementation of distributed Dbscan algo
+ * @brief Fits a DBSCAN model over the ranks of the communicator of handle,
+ * each holding a shard of the input feature matrix, and outputs the labels of
+ * the samples of this rank. The samples are numbered in rank order, and the
+ * labels are the same as those of dbscanFit on the concatenation of the
+ * shards. Every rank holds a copy of all the samples and of their labels.
+ * @param[in] handle cuml handle to use across the algorithm; it must have a
+ *            communicator.
+ * @param[in] input row-major input feature matrix of this rank
+ * @param[in] n_rows number of samples of this rank
+ * @param[in] n_cols number of features in the input feature matrix
+ * @param[in] eps the epsilon value to use for epsilon-neighborhood determination
+ * @param[in] min_pts minimum number of points to determine a cluster
+ * @param[out] labels (size n_rows) output labels of the samples of this rank
+ * @param[in] max_mem_mbytes: the maximum number of megabytes of the epsilon
+ *            neighborhood graph of each batch of the samples of this rank.
+ * @param[in] verbose: print useful information as algorithm executes
+ * @{
+ */
+void dbscanFitMG(const cumlHandle &handle, const float *input, int n_rows,
+                 int n_cols, float eps, int min_pts, int *labels,
+                 size_t max_bytes_per_batch = 0, bool verbose = false);
+void dbscanFitMG(const cumlHandle &handle, const double *input, int n_rows,
+                 int n_cols, double eps, int min_pts, int *labels,
+                 size_t max_bytes_per_batch = 0, bool verbose = false);
+
+void dbscanFitMG(const cumlHandle &handle, const float *input, int64_t n_rows,
+                 int64_t n_cols, float eps, int min_pts, int64_t *labels,
+                 size_t max_bytes_per_batch = 0, bool verbose = false);
+void dbscanFitMG(const cumlHandle &handle, const double *input, int64_t n_rows,
+                 int64_t n_cols, double eps, int min_pts, int64_t *labels,
+                 size_t max_bytes_per_batch = 0, bool verbose = false);
+
+/** @} */
+
 }  // namespace ML
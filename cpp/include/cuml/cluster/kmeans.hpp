@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cuml/cuml.hpp>
+#include <string>
 
 namespace ML {
 
@@ -25,6 +26,10 @@ namespace kmeans {
 struct KMeansParams {
   enum InitMethod { KMeansPlusPlus, Random, Array };
 
+  enum Algorithm { Lloyd, MiniBatch, Hamerly };
+
+  enum Precision { Full, Mixed };
+
   // The number of clusters to form as well as the number of centroids to
   // generate (default:8).
   int n_clusters = 8;
@@ -35,7 +40,8 @@ struct KMeansParams {
    * to select the initial cluster centers.
    *  - InitMethod::Random (random): Choose 'n_clusters' observations (rows) at
    * random from the input data for the initial centroids.
-   *  - InitMethod::Array (ndarray): Use 'centroids' as initial cluster centers.
+   *  - InitMethod::Array (ndarray): Use 'centroids' as initial cluster centers,
+   * e.g. to warm start a refit from the centroids of a previous fit.
    */
   InitMethod init = KMeansPlusPlus;
 
@@ -61,6 +67,59 @@ struct KMeansParams {
   int batch_size = 1 << 15;
 
   bool inertia_check = false;
+
+  /*
+   * Algorithm of the fit, defaults to Lloyd:
+   *  - Algorithm::Lloyd: every iteration assigns all the samples to their
+   * nearest centers and moves the centers to the means of their samples.
+   *  - Algorithm::MiniBatch: every iteration samples 'batch_size' samples at
+   * random and moves their nearest centers towards them, with a per-center
+   * learning rate of 1 / (# samples assigned to the center so far). The
+   * k-means++ initialization then runs on a random sample of
+   * 3 * 'batch_size' samples.
+   *  - Algorithm::Hamerly: Lloyd's iterations, keeping for every sample an
+   * upper bound of the distance to its center and a lower bound of the
+   * distance to the other centers, so that only the samples whose bounds
+   * overlap are assigned again. Requires a Euclidean metric and ignores
+   * 'inertia_check'.
+   */
+  Algorithm algorithm = Lloyd;
+
+  // MiniBatch only: stop when the smoothed mini-batch inertia did not
+  // improve by a relative 'tol' for this many consecutive iterations.
+  int max_no_improvement = 10;
+
+  /*
+   * Precision of the distances to the centers, defaults to full:
+   *  - Precision::Full: distances in the precision of the input.
+   *  - Precision::Mixed: single precision input with a Euclidean metric only;
+   * the samples-by-centers product runs on half precision copies of the
+   * samples and centers with single precision accumulation (on the tensor
+   * cores where the device has them). The distance to the nearest center is
+   * then recomputed in single precision, and the samples whose two nearest
+   * centers are within 'refine_margin' * (|x|^2 + |c|^2) of each other are
+   * assigned again in single precision. Falls back to Precision::Full for
+   * other inputs; Hamerly's algorithm ignores it.
+   */
+  Precision precision = Full;
+
+  // Mixed precision only: relative margin of the single precision
+  // refinement. The half precision error of a squared distance is around
+  // 1e-3 * (|x|^2 + |c|^2); 0 disables the refinement.
+  double refine_margin = 1e-2;
+
+  /*
+   * Distributed fits only (fit_mg): every 'checkpoint_interval' iterations,
+   * rank 0 writes the centroids and the number of iterations to
+   * 'checkpoint_path' in the background, 0 disabling the checkpoints. With
+   * 'resume', a fit finding a checkpoint of the same shape at
+   * 'checkpoint_path' continues from it, ignoring 'init', and otherwise
+   * starts as usual, so that a fit killed by a preemption is resumed by
+   * running it again.
+   */
+  std::string checkpoint_path;
+  int checkpoint_interval = 0;
+  bool resume = false;
 };
 
 /**
@@ -123,6 +182,144 @@ void fit(const ML::cumlHandle &handle, const KMeansParams &params,
          const double *X, int n_samples, int n_features, double *centroids,
          double &inertia, int &n_iter);
 
+/**
+ * @brief Compute k-means clustering of weighted samples with Lloyd's
+ * algorithm: the centroids are the weighted means of their samples. The
+ * initialization ignores the weights.
+ *
+ * @param[in]     handle        The handle to the cuML library context that
+ manages the CUDA resources.
+ * @param[in]     params        Parameters for KMeans model; params.algorithm
+ * must be Algorithm::Lloyd.
+ * @param[in]     X             Training instances to cluster. It must be noted
+ that the data must be in row-major format and stored in device accessible
+ * location.
+ * @param[in]     n_samples     Number of samples in the input X.
+ * @param[in]     n_features    Number of features or the dimensions of each
+ * sample.
+ * @param[in]     sample_weight Weight of each sample of X, in device
+ * accessible location.
+ * @param[in|out] centroids     [in] When init is InitMethod::Array, use
+ centroids as the initial cluster centers
+ *                              [out] Otherwise, generated centroids from the
+ kmeans algorithm is stored at the address pointed by 'centroids'.
+ * @param[out]    inertia       Weighted sum of squared distances of samples to
+ their closest cluster center.
+ * @param[out]    n_iter        Number of iterations run.
+ */
+void fit(const ML::cumlHandle &handle, const KMeansParams &params,
+         const float *X, int n_samples, int n_features,
+         const float *sample_weight, float *centroids, float &inertia,
+         int &n_iter);
+
+void fit(const ML::cumlHandle &handle, const KMeansParams &params,
+         const double *X, int n_samples, int n_features,
+         const double *sample_weight, double *centroids, double &inertia,
+         int &n_iter);
+
+/**
+ * @brief Compute k-means clustering of the rows of a CSR matrix with Lloyd's
+ * algorithm, without densifying it. The distances to the centroids are
+ * computed from sparse-dense products, so params.metric must be a Euclidean
+ * metric.
+ *
+ * @param[in]     handle        The handle to the cuML library context that
+ manages the CUDA resources.
+ * @param[in]     params        Parameters for KMeans model; params.algorithm
+ * must be Algorithm::Lloyd.
+ * @param[in]     vals          Nonzero values of the CSR matrix (nnz).
+ * @param[in]     row_ind       Offsets of the rows in vals (n_samples + 1).
+ * @param[in]     row_ind_ptr   Column index of each nonzero value (nnz).
+ * @param[in]     nnz           Number of nonzero values.
+ * @param[in]     n_samples     Number of rows of the CSR matrix.
+ * @param[in]     n_features    Number of columns of the CSR matrix.
+ * @param[in]     sample_weight Weight of each sample, or nullptr for unit
+ * weights, in device accessible location.
+ * @param[in|out] centroids     [in] When init is InitMethod::Array, use
+ centroids as the initial cluster centers
+ *                              [out] Otherwise, generated dense centroids
+ [n_clusters x n_features] from the kmeans algorithm are stored at the address
+ pointed by 'centroids'.
+ * @param[out]    inertia       Sum of squared distances of samples to their
+ closest cluster center, weighted by sample_weight.
+ * @param[out]    n_iter        Number of iterations run.
+ */
+void fit_sparse(const ML::cumlHandle &handle, const KMeansParams &params,
+                const float *vals, const int *row_ind, const int *row_ind_ptr,
+                int nnz, int n_samples, int n_features,
+                const float *sample_weight, float *centroids, float &inertia,
+                int &n_iter);
+
+void fit_sparse(const ML::cumlHandle &handle, const KMeansParams &params,
+                const double *vals, const int *row_ind, const int *row_ind_ptr,
+                int nnz, int n_samples, int n_features,
+                const double *sample_weight, double *centroids,
+                double &inertia, int &n_iter);
+
+/**
+ * @brief Compute k-means clustering over the ranks of the communicator of
+ * handle, each holding a shard of the training instances. Only
+ * Algorithm::Lloyd is supported.
+ *
+ * @param[in]     handle        The handle to the cuML library context that
+ manages the CUDA resources; it must have a communicator.
+ * @param[in]     params        Parameters for KMeans model, the same on all
+ * the ranks.
+ * @param[in]     X             Training instances of this rank. It must be
+ noted that the data must be in row-major format and stored in device
+ accessible location.
+ * @param[in]     n_samples     Number of samples in the input X of this rank.
+ * @param[in]     n_features    Number of features or the dimensions of each
+ * sample.
+ * @param[in|out] centroids     [in] When init is InitMethod::Array, use
+ centroids of rank 0 as the initial cluster centers
+ *                              [out] Otherwise, generated centroids from the
+ kmeans algorithm, the same on all the ranks, is stored at the address pointed
+ by 'centroids'.
+ * @param[out]    inertia       Sum of squared distances of the samples of all
+ the ranks to their closest cluster center.
+ * @param[out]    n_iter        Number of iterations run, including those
+ before the checkpoint the fit resumed from, if any.
+ */
+void fit_mg(const ML::cumlHandle &handle, const KMeansParams &params,
+            const float *X, int n_samples, int n_features, float *centroids,
+            float &inertia, int &n_iter);
+
+void fit_mg(const ML::cumlHandle &handle, const KMeansParams &params,
+            const double *X, int n_samples, int n_features, double *centroids,
+            double &inertia, int &n_iter);
+
+/**
+ * @brief Update a fitted model with new samples only, at the cost of a
+ single pass over them: the new samples are assigned to their closest
+ centroids, and each centroid moves to the mean of the samples assigned to it
+ by all the calls so far.
+ *
+ * @param[in]     handle         The handle to the cuML library context that
+ manages the CUDA resources.
+ * @param[in]     params         Parameters for KMeans model.
+ * @param[in]     X              New samples, in row-major format and stored
+ in device accessible location.
+ * @param[in]     n_samples      Number of samples in the input X.
+ * @param[in]     n_features     Number of features or the dimensions of each
+ * sample.
+ * @param[in|out] centroids      Cluster centroids [n_clusters x n_features] in
+ row-major format and stored in device accessible location.
+ * @param[in|out] cluster_counts Number of samples assigned to each centroid so
+ far [n_clusters], in device accessible location. Zeros for the first call on
+ a model from fit, which then makes one more Lloyd iteration over X and
+ counts its samples.
+ * @param[out]    inertia        Sum of squared distances of the new samples to
+ the centroids they were assigned to, before the update.
+ */
+void partial_fit(const ML::cumlHandle &handle, const KMeansParams &params,
+                 const float *X, int n_samples, int n_features,
+                 float *centroids, float *cluster_counts, float &inertia);
+
+void partial_fit(const ML::cumlHandle &handle, const KMeansParams &params,
+                 const double *X, int n_samples, int n_features,
+                 double *centroids, double *cluster_counts, double &inertia);
+
 /**
  * @brief Predict the closest cluster each sample in X belongs to.
  *
@@ -150,6 +347,61 @@ void predict(const ML::cumlHandle &handle, const KMeansParams &params,
              const double *centroids, const double *X, int n_samples,
              int n_features, int *labels, double &inertia);
 
+/**
+ * @brief Predict the closest cluster each sample in X belongs to, without
+ * synchronizing the host.
+ *
+ * All the work is enqueued on the stream of the handle, so that it may be
+ * pipelined with the stages before and after it; see predict for the other
+ * parameters.
+ *
+ * @param[out]    inertia       Sum of squared distances of samples to their
+ * closest cluster center. Device or pinned host pointer.
+ * @param[in]     done          Event recorded on the stream of the handle once
+ * labels and inertia are written, or nullptr.
+ */
+void predict_async(const ML::cumlHandle &handle, const KMeansParams &params,
+                   const float *centroids, const float *X, int n_samples,
+                   int n_features, int *labels, float *inertia,
+                   cudaEvent_t done = nullptr);
+
+void predict_async(const ML::cumlHandle &handle, const KMeansParams &params,
+                   const double *centroids, const double *X, int n_samples,
+                   int n_features, int *labels, double *inertia,
+                   cudaEvent_t done = nullptr);
+
+/**
+ * @brief Predict the closest cluster each row of a CSR matrix belongs to; see
+ * fit_sparse for the layout of the matrix.
+ *
+ * @param[in]     handle        The handle to the cuML library context that
+ * manages the CUDA resources.
+ * @param[in]     params        Parameters for KMeans model.
+ * @param[in]     centroids     Dense cluster centroids. It must be noted that
+ * the data must be in row-major format and stored in device accessible
+ * location.
+ * @param[in]     vals          Nonzero values of the CSR matrix (nnz).
+ * @param[in]     row_ind       Offsets of the rows in vals (n_samples + 1).
+ * @param[in]     row_ind_ptr   Column index of each nonzero value (nnz).
+ * @param[in]     nnz           Number of nonzero values.
+ * @param[in]     n_samples     Number of rows of the CSR matrix.
+ * @param[in]     n_features    Number of columns of the CSR matrix.
+ * @param[out]    labels        Index of the cluster each sample belongs to.
+ * @param[out]    inertia       Sum of squared distances of samples to their
+ * closest cluster center.
+ */
+void predict_sparse(const ML::cumlHandle &handle, const KMeansParams &params,
+                    const float *centroids, const float *vals,
+                    const int *row_ind, const int *row_ind_ptr, int nnz,
+                    int n_samples, int n_features, int *labels,
+                    float &inertia);
+
+void predict_sparse(const ML::cumlHandle &handle, const KMeansParams &params,
+                    const double *centroids, const double *vals,
+                    const int *row_ind, const int *row_ind_ptr, int nnz,
+                    int n_samples, int n_features, int *labels,
+                    double &inertia);
+
 /**
  * @brief Transform X to a cluster-distance space.
  *
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_runtime.h>
+#include <cuml/cuml.hpp>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace ML {
+
+/**
+ * @brief The GPUs of a single process, one cumlHandle per device.
+ *
+ * Each rank of the group is a device with its own handle: a non-blocking
+ * stream, allocators and cuBLAS, cuSOLVER and cuSPARSE handles created on
+ * that device. Peer access is enabled between the devices that support it,
+ * so that the kernels of a rank may read the buffers of another. For the
+ * algorithms that communicate through the handle, a communicator for the
+ * ranks of the group can be injected into their handles without Dask or MPI
+ * (see inject_comms_local in the std comms).
+ *
+ * @code{.cpp}
+ * ML::cumlDeviceGroup group;  // all the visible devices
+ * group.forEach([&](int rank, ML::cumlHandle& handle) {
+ *   // the device of the rank is current
+ *   ML::sgdPredict(handle, chunks[rank], ...);
+ * });
+ * group.synchronize();
+ * @endcode
+ */
+class cumlDeviceGroup {
+ public:
+  /**
+   * @param[in] devices   ids of the devices of the ranks, in order, all the
+   *                      visible devices if empty
+   * @param[in] n_streams number of internal streams of each handle
+   * @param[in] enable_peer_access  whether to enable peer access between
+   *                                the devices that support it
+   */
+  cumlDeviceGroup(const std::vector<int>& devices = std::vector<int>(),
+                  int n_streams = cumlHandle::getDefaultNumInternalStreams(),
+                  bool enable_peer_access = true);
+  /** @brief waits for all the work of the handles and destroys them */
+  ~cumlDeviceGroup();
+
+  cumlDeviceGroup(const cumlDeviceGroup& other) = delete;
+  cumlDeviceGroup& operator=(const cumlDeviceGroup& other) = delete;
+
+  /** @brief number of devices in the group */
+  int size() const { return int(_devices.size()); }
+  /** @brief device id of a rank */
+  int getDevice(int rank) const;
+  /** @brief handle of a rank, whose resources live on its device */
+  cumlHandle& getHandle(int rank) const;
+  /** @brief stream of the handle of a rank */
+  cudaStream_t getStream(int rank) const;
+  /** @brief whether the kernels of rank can access the memory of peer */
+  bool canAccessPeer(int rank, int peer) const;
+
+  /**
+   * @brief Run f(rank, handle) for all the ranks concurrently, each from its
+   *        own host thread with the device of the rank current.
+   *
+   * Returns once all the calls have returned, rethrowing the exception of
+   * the lowest rank that threw, if any. The work that f enqueues is not
+   * waited for (see synchronize).
+   */
+  void forEach(const std::function<void(int, cumlHandle&)>& f) const;
+
+  /** @brief wait for the work issued through the handles */
+  void synchronize() const;
+
+ private:
+  std::vector<int> _devices;
+  std::vector<std::unique_ptr<cumlHandle>> _handles;
+  std::vector<cudaStream_t> _streams;
+  /** _peerAccess[rank * size() + peer] */
+  std::vector<char> _peerAccess;
+};
+
+}  // end namespace ML
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cuda_runtime.h>
+#include <cuml/cuml.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ML {
+
+/**
+ * @brief Pool of ready cumlHandles for concurrent requests on one GPU.
+ *
+ * Each handle of the pool owns a stream and its cuBLAS, cuSOLVER and cuSPARSE
+ * handles, which are bound to a stream and thus not shared, while all of them
+ * share the same (thread-safe) device and host allocators, so that a memory
+ * pool serves all the requests. A request acquires a handle for as long as
+ * it runs, which makes the creation of the handles a one-time cost and lets
+ * up to size() requests run concurrently, the next ones waiting for a handle
+ * to be returned.
+ *
+ * @code{.cpp}
+ * ML::cumlHandlePool pool(8);
+ * // in each request thread
+ * ML::cumlHandlePool::lease h = pool.acquire();
+ * ML::sgdPredict(*h, ...);
+ * h.synchronize(); // before reading the results
+ * @endcode
+ */
+class cumlHandlePool {
+ public:
+  /** @brief A handle of the pool, returned to it on destruction */
+  class lease {
+   public:
+    lease(lease&& other);
+    lease& operator=(lease&& other);
+    lease(const lease& other) = delete;
+    lease& operator=(const lease& other) = delete;
+    ~lease();
+
+    cumlHandle& operator*() const { return *_handle; }
+    cumlHandle* operator->() const { return _handle; }
+    /** the stream of the handle, to order the work of the request with */
+    cudaStream_t getStream() const { return _handle->getStream(); }
+    /** wait for the work issued through the handle */
+    void synchronize() const;
+
+   private:
+    friend class cumlHandlePool;
+    lease(cumlHandlePool* pool, cumlHandle* handle);
+
+    cumlHandlePool* _pool;
+    cumlHandle* _handle;
+  };
+
+  /**
+   * @param[in] n_handles   number of handles, the maximum of concurrent
+   *                        requests
+   * @param[in] n_streams   number of internal streams of each handle
+   * @param[in] device_allocator  allocator shared by the handles, nullptr for
+   *                              the default of cumlHandle
+   * @param[in] host_allocator    allocator shared by the handles, nullptr for
+   *                              the default of cumlHandle
+   */
+  cumlHandlePool(int n_handles,
+                 int n_streams = cumlHandle::getDefaultNumInternalStreams(),
+                 std::shared_ptr<deviceAllocator> device_allocator = nullptr,
+                 std::shared_ptr<hostAllocator> host_allocator = nullptr);
+  /** @brief waits for all the work of the handles and destroys them */
+  ~cumlHandlePool();
+
+  cumlHandlePool(const cumlHandlePool& other) = delete;
+  cumlHandlePool& operator=(const cumlHandlePool& other) = delete;
+
+  /** @brief a free handle, waiting for one if they are all acquired */
+  lease acquire();
+  /** @brief number of handles in the pool */
+  int size() const { return int(_handles.size()); }
+  /** @brief number of handles currently free */
+  int available() const;
+
+  std::shared_ptr<deviceAllocator> getDeviceAllocator() const {
+    return _deviceAllocator;
+  }
+  std::shared_ptr<hostAllocator> getHostAllocator() const {
+    return _hostAllocator;
+  }
+
+ private:
+  void release(cumlHandle* handle);
+
+  std::vector<std::unique_ptr<cumlHandle>> _handles;
+  std::vector<cudaStream_t> _streams;
+  std::shared_ptr<deviceAllocator> _deviceAllocator;
+  std::shared_ptr<hostAllocator> _hostAllocator;
+  /** the handles not acquired */
+  std::vector<cumlHandle*> _free;
+  mutable std::mutex _mutex;
+  std::condition_variable _freed;
+};
+
+}  // end namespace ML
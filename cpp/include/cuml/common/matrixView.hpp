@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace ML {
+
+/**
+ * @brief A non-owning view of a matrix in device memory with arbitrary
+ *        strides, as described by __cuda_array_interface__ or DLPack.
+ *
+ * Element (i, j) is at data[i * rowStride + j * colStride], the strides
+ * being in elements. The entry points taking a view consume it in place
+ * whenever its layout is the one they work on, so that the arrays of cuDF,
+ * CuPy or PyTorch, whatever their order, padding or slicing, are only copied
+ * when their layout differs.
+ *
+ * @code{.cpp}
+ * // a C-ordered CuPy array, or its transpose, in place
+ * auto X = ML::matrixView<const float>::fromArrayInterface(ptr, shape,
+ *                                                          strides);
+ * ML::predict(handle, forest, X, preds);
+ * @endcode
+ */
+template <typename T>
+struct matrixView {
+  T* data;
+  int rows, cols;
+  int64_t rowStride, colStride;
+
+  matrixView(T* data, int rows, int cols, int64_t rowStride,
+             int64_t colStride)
+    : data(data),
+      rows(rows),
+      cols(cols),
+      rowStride(rowStride),
+      colStride(colStride) {}
+
+  /** a contiguous row-major (C-ordered) matrix */
+  static matrixView rowMajor(T* data, int rows, int cols) {
+    return matrixView(data, rows, cols, cols, 1);
+  }
+
+  /** a contiguous column-major (Fortran-ordered) matrix */
+  static matrixView colMajor(T* data, int rows, int cols) {
+    return matrixView(data, rows, cols, 1, rows);
+  }
+
+  /**
+   * a matrix described as by __cuda_array_interface__: its shape, and its
+   * strides in bytes or nullptr when C-ordered
+   */
+  static matrixView fromArrayInterface(T* data, const int64_t shape[2],
+                                       const int64_t* stridesBytes) {
+    if (stridesBytes == nullptr) {
+      return rowMajor(data, int(shape[0]), int(shape[1]));
+    }
+    return matrixView(data, int(shape[0]), int(shape[1]),
+                      stridesBytes[0] / int64_t(sizeof(T)),
+                      stridesBytes[1] / int64_t(sizeof(T)));
+  }
+
+  /**
+   * a matrix described as by DLPack: its shape, and its strides in elements
+   * or nullptr when compact and row-major
+   */
+  static matrixView fromDLPack(T* data, const int64_t shape[2],
+                               const int64_t* strides) {
+    if (strides == nullptr) return rowMajor(data, int(shape[0]), int(shape[1]));
+    return matrixView(data, int(shape[0]), int(shape[1]), strides[0],
+                      strides[1]);
+  }
+
+  /** whether the rows are contiguous and follow each other */
+  bool isRowMajor() const {
+    return (colStride == 1 || cols <= 1) && (rowStride == cols || rows <= 1);
+  }
+
+  /** whether the columns are contiguous and follow each other */
+  bool isColMajor() const {
+    return (rowStride == 1 || rows <= 1) && (colStride == rows || cols <= 1);
+  }
+};
+
+}  // end namespace ML
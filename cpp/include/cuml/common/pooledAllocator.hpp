@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_runtime.h>
+#include <algorithm>
+#include <cuml/common/cuml_allocator.hpp>
+#include <cuml/common/utils.hpp>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace MLCommon {
+
+/** Statistics of a pooled allocator, in bytes unless stated otherwise */
+struct pooledAllocatorStats {
+  /** size of the blocks currently handed out */
+  std::size_t bytesInUse;
+  /** high-water mark of bytesInUse */
+  std::size_t peakBytesInUse;
+  /** size of the free blocks kept for reuse */
+  std::size_t bytesCached;
+  /** high-water mark of bytesInUse + bytesCached, the memory footprint */
+  std::size_t peakBytesReserved;
+  /** number of calls to allocate */
+  std::size_t nAllocations;
+  /** number of those served from the cache */
+  std::size_t nCacheHits;
+  /** number of calls to the underlying allocation function */
+  std::size_t nCudaMallocs;
+};
+
+/**
+ * Device memory for pooledAllocator: a cached block is usable by any stream
+ * once that stream waits on the event of its deallocation, the blocks freed
+ * on the same stream being preferred as stream order already covers them.
+ */
+struct pooledDeviceMemory {
+  static cudaError_t malloc(void** ptr, std::size_t n) {
+    return cudaMalloc(ptr, n);
+  }
+  static cudaError_t free(void* ptr) { return cudaFree(ptr); }
+  static bool preferred(cudaStream_t freedOn, cudaEvent_t, cudaStream_t s) {
+    return freedOn == s;
+  }
+  static void waitFor(cudaEvent_t event, cudaStream_t stream) {
+    CUDA_CHECK(cudaStreamWaitEvent(stream, event, 0));
+  }
+};
+
+/**
+ * Pinned host memory for pooledAllocator: the host may touch a block as soon
+ * as it is handed out, so reusing one still read or written by an async copy
+ * means synchronizing with its event, the blocks whose copies are already
+ * done being preferred.
+ */
+struct pooledPinnedHostMemory {
+  static cudaError_t malloc(void** ptr, std::size_t n) {
+    return cudaMallocHost(ptr, n);
+  }
+  static cudaError_t free(void* ptr) { return cudaFreeHost(ptr); }
+  static bool preferred(cudaStream_t, cudaEvent_t event, cudaStream_t) {
+    return cudaEventQuery(event) == cudaSuccess;
+  }
+  static void waitFor(cudaEvent_t event, cudaStream_t) {
+    CUDA_CHECK(cudaEventSynchronize(event));
+  }
+};
+
+/**
+ * @brief Stream-ordered caching allocator.
+ *
+ * Requests are rounded up to power-of-two size classes, from minBlockBytes
+ * up to maxBlockBytes; larger ones go straight to Memory::malloc/free.
+ * A deallocated block goes to the free list of its size class, tagged with
+ * its stream and with an event recorded on that stream, and is handed out
+ * again once the work of that stream on it is ordered before the new use
+ * (see pooledDeviceMemory and pooledPinnedHostMemory).
+ * When the cached bytes would exceed maxCachedBytes, or an allocation fails,
+ * the cached blocks are returned to the system.
+ *
+ * The allocator is thread-safe and must be used on the device current at
+ * its construction.
+ *
+ * @tparam Interface deviceAllocator or hostAllocator
+ * @tparam Memory    where and how the blocks are allocated
+ */
+template <typename Interface, typename Memory>
+class pooledAllocator : public Interface {
+ public:
+  /**
+   * @param[in] maxCachedBytes  limit on the size of the cached free blocks
+   * @param[in] minBlockBytes   smallest size class
+   * @param[in] maxBlockBytes   largest size class: above it, the allocations
+   *                            are not pooled
+   */
+  pooledAllocator(std::size_t maxCachedBytes = std::size_t(1) << 30,
+                  std::size_t minBlockBytes = 512,
+                  std::size_t maxBlockBytes = std::size_t(1) << 28)
+    : _maxCachedBytes(maxCachedBytes),
+      _minBlockBytes(minBlockBytes),
+      _maxBlockBytes(maxBlockBytes),
+      _stats() {
+    ASSERT(minBlockBytes > 0 && (minBlockBytes & (minBlockBytes - 1)) == 0,
+           "pooledAllocator: minBlockBytes must be a power of two");
+    ASSERT(maxBlockBytes >= minBlockBytes,
+           "pooledAllocator: maxBlockBytes must be >= minBlockBytes");
+    std::size_t nBins = 1;
+    for (std::size_t b = minBlockBytes; b < maxBlockBytes; b *= 2) nBins++;
+    _freeBlocks.resize(nBins);
+  }
+
+  virtual void* allocate(std::size_t n, cudaStream_t stream) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.nAllocations++;
+    int bin = binOf(n);
+    std::size_t bytes = bin < 0 ? n : binBytes(bin);
+    void* ptr = bin < 0 ? nullptr : takeCached(bin, stream);
+    if (ptr != nullptr) {
+      _stats.nCacheHits++;
+      _stats.bytesCached -= bytes;
+    } else {
+      ptr = memoryMalloc(bytes);
+    }
+    _inUse[ptr] = bytes;
+    _stats.bytesInUse += bytes;
+    updatePeaks();
+    return ptr;
+  }
+
+  virtual void deallocate(void* p, std::size_t, cudaStream_t stream) {
+    if (p == nullptr) return;
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _inUse.find(p);
+    if (it == _inUse.end()) return;
+    std::size_t bytes = it->second;
+    _inUse.erase(it);
+    _stats.bytesInUse -= bytes;
+    int bin = binOf(bytes);
+    if (bin < 0) {
+      // deallocate should not throw execeptions which is why CUDA_CHECK is
+      // not used.
+      Memory::free(p);
+      return;
+    }
+    cudaEvent_t event = takeEvent();
+    if (event == nullptr || cudaEventRecord(event, stream) != cudaSuccess) {
+      if (event != nullptr) _events.push_back(event);
+      Memory::free(p);
+      return;
+    }
+    _freeBlocks[bin].push_back(block{p, stream, event});
+    _stats.bytesCached += bytes;
+    if (_stats.bytesCached > _maxCachedBytes) releaseCachedLocked();
+  }
+
+  /** @brief Return all the cached free blocks to the system */
+  void releaseCached() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    releaseCachedLocked();
+  }
+
+  /** @brief Statistics of the allocator since its construction */
+  pooledAllocatorStats getStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+  }
+
+  /** @brief Restart the high-water marks from the current usage */
+  void resetPeaks() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.peakBytesInUse = _stats.bytesInUse;
+    _stats.peakBytesReserved = _stats.bytesInUse + _stats.bytesCached;
+  }
+
+  virtual ~pooledAllocator() {
+    releaseCachedLocked();
+    for (auto& e : _events) cudaEventDestroy(e);
+  }
+
+ private:
+  struct block {
+    void* ptr;
+    cudaStream_t stream;
+    cudaEvent_t event;
+  };
+
+  /** size class of n bytes, -1 if too large to be pooled */
+  int binOf(std::size_t n) const {
+    if (n > _maxBlockBytes) return -1;
+    int bin = 0;
+    for (std::size_t b = _minBlockBytes; b < n; b *= 2) bin++;
+    return bin;
+  }
+
+  std::size_t binBytes(int bin) const { return _minBlockBytes << bin; }
+
+  /**
+   * a cached block of the bin usable on stream, preferring those that need
+   * no waiting, nullptr if there is none
+   */
+  void* takeCached(int bin, cudaStream_t stream) {
+    auto& blocks = _freeBlocks[bin];
+    if (blocks.empty()) return nullptr;
+    auto it = std::find_if(blocks.begin(), blocks.end(),
+                           [stream](const block& b) {
+                             return Memory::preferred(b.stream, b.event,
+                                                      stream);
+                           });
+    if (it == blocks.end()) it = blocks.begin();
+    // waiting even on a preferred block, which is then free, in case its
+    // stream was destroyed and the handle reused
+    Memory::waitFor(it->event, stream);
+    void* ptr = it->ptr;
+    _events.push_back(it->event);
+    blocks.erase(it);
+    return ptr;
+  }
+
+  void* memoryMalloc(std::size_t bytes) {
+    void* ptr = nullptr;
+    cudaError_t status = Memory::malloc(&ptr, bytes);
+    if (status != cudaSuccess) {
+      // clear the error, then retry with the cache handed back
+      cudaGetLastError();
+      releaseCachedLocked();
+      CUDA_CHECK(Memory::malloc(&ptr, bytes));
+    }
+    _stats.nCudaMallocs++;
+    return ptr;
+  }
+
+  cudaEvent_t takeEvent() {
+    cudaEvent_t event = nullptr;
+    if (!_events.empty()) {
+      event = _events.back();
+      _events.pop_back();
+    } else if (cudaEventCreateWithFlags(&event, cudaEventDisableTiming) !=
+               cudaSuccess) {
+      event = nullptr;
+    }
+    return event;
+  }
+
+  void releaseCachedLocked() {
+    for (auto& blocks : _freeBlocks) {
+      for (auto& b : blocks) {
+        // a block may still be in use by the work of its stream
+        cudaEventSynchronize(b.event);
+        Memory::free(b.ptr);
+        _events.push_back(b.event);
+      }
+      blocks.clear();
+    }
+    _stats.bytesCached = 0;
+  }
+
+  void updatePeaks() {
+    _stats.peakBytesInUse = std::max(_stats.peakBytesInUse, _stats.bytesInUse);
+    _stats.peakBytesReserved = std::max(_stats.peakBytesReserved,
+                                        _stats.bytesInUse + _stats.bytesCached);
+  }
+
+  std::size_t _maxCachedBytes, _minBlockBytes, _maxBlockBytes;
+  /** free blocks by size class, in the order of their deallocation */
+  std::vector<std::list<block>> _freeBlocks;
+  /** size of the blocks handed out */
+  std::unordered_map<void*, std::size_t> _inUse;
+  /** events not attached to a free block, for reuse */
+  std::vector<cudaEvent_t> _events;
+  pooledAllocatorStats _stats;
+  mutable std::mutex _mutex;
+};
+
+/** caching allocator of device memory, the default of cumlHandle */
+typedef pooledAllocator<deviceAllocator, pooledDeviceMemory>
+  pooledDeviceAllocator;
+
+/** caching allocator of pinned host memory, the default of cumlHandle */
+typedef pooledAllocator<hostAllocator, pooledPinnedHostMemory>
+  pooledHostAllocator;
+
+};  // end namespace MLCommon
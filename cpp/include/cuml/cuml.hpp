@@ -19,6 +19,7 @@
 #include <cuda_runtime.h>
 #include <cuml/common/cuml_allocator.hpp>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace ML {
@@ -31,6 +32,16 @@ using MLCommon::hostAllocator;
 using MLCommon::defaultDeviceAllocator;
 using MLCommon::defaultHostAllocator;
 
+/** Device memory accounted to a cumlHandle, or to one of its tags */
+struct memoryUsage {
+  /** bytes currently allocated */
+  std::size_t bytesInUse;
+  /** high-water mark of bytesInUse since the last reset */
+  std::size_t peakBytesInUse;
+  /** number of allocations since the last reset */
+  std::size_t nAllocations;
+};
+
 /**
  * @brief Handle to manage resources needed by cuML algorithms.
  */
@@ -42,8 +53,10 @@ class cumlHandle {
      *
      * The default paramters are 
      *   - stream: default or NULL stream
-     *   - DeviceAllocator: cudaMalloc
-     *   - HostAllocator: cudaMallocHost
+     *   - DeviceAllocator: pooledDeviceAllocator, a stream-ordered cache
+     *     over cudaMalloc (defaultDeviceAllocator for plain cudaMalloc)
+     *   - HostAllocator: pooledHostAllocator, the same cache over
+     *     cudaMallocHost (defaultHostAllocator for plain cudaMallocHost)
      * @{
      */
   cumlHandle(int n_streams);
@@ -91,6 +104,67 @@ class cumlHandle {
      * @returns the hostAllocator to use for host allocations.
      */
   std::shared_ptr<hostAllocator> getHostAllocator() const;
+  /**
+   * @brief gets the device memory allocated through this handle, whatever its
+   *        device allocator.
+   *
+   * @param[in] tag    an algorithm call or NVTX range tag, or "" for the total
+   *                   of the handle
+   * @returns the usage charged to the tag, all zeros for an unknown tag
+   */
+  memoryUsage getDeviceMemoryUsage(const std::string& tag = "") const;
+  /**
+   * @brief gets the tags to which device memory has been charged so far.
+   */
+  std::vector<std::string> getDeviceMemoryTags() const;
+  /**
+   * @brief restarts the peaks of the device memory usage from the current
+   *        usage, and the counts of allocations from zero.
+   */
+  void resetDeviceMemoryUsage();
+  /**
+   * @brief enables or disables the replay of predict calls from CUDA graphs.
+   *
+   * When enabled, the calls that support it (sgdPredict, qnPredict,
+   * fil::predict...) are captured into a CUDA graph on their first run
+   * with given shapes, buffers and scalars, and replayed from it on the
+   * next runs with the same, which removes most of their launch overhead. The stream of the
+   * handle must not be the default stream. Each graph keeps the workspace
+   * of its call allocated, until clearGraphs.
+   *
+   * @param[in] enable    whether to capture and replay
+   */
+  void setGraphCapture(bool enable);
+  /** @brief whether predict calls are captured and replayed */
+  bool getGraphCapture() const;
+  /** @brief destroys the captured graphs and releases their workspaces */
+  void clearGraphs();
+  /**
+   * @brief enables or disables the timing of the phases of the calls made
+   *        with this handle.
+   *
+   * When enabled, the entry points and main phases of the algorithms are
+   * timed on the host and, with CUDA events, on the stream of the handle,
+   * without synchronizing it. Disabled, the default, it costs a flag test
+   * per phase.
+   *
+   * @param[in] enable    whether to time the phases
+   */
+  void setProfiling(bool enable);
+  /** @brief whether the phases of the calls are timed */
+  bool getProfiling() const;
+  /**
+   * @brief gets the timings of the phases since profiling was enabled or
+   *        last reset, waiting for the work of the phases that have ended.
+   *
+   * @returns a JSON document, {"phases": [{"name", "calls", "gpu_ms",
+   *          "max_gpu_ms", "cpu_ms"}...]}, with the phases in the order
+   *          they first ran and their times in milliseconds summed over
+   *          their calls
+   */
+  std::string getProfileReport() const;
+  /** @brief forgets the timings so far */
+  void resetProfile();
   /**
   * @brief API to query Num of work streams set during handle creation.
   * @returns num of streams in the handle.
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuml/cuml.hpp>
+#include <cuml/tsa/arima_common.h>
+
+namespace ML {
+namespace Datasets {
+
+/**
+ * @brief Generate a batch of series simulated from random seasonal ARIMA
+ * models of the given order, for the tests and the benchmarks of the time
+ * series algorithms.
+ *
+ * The parameters of each series are random, the AR and MA polynomials being
+ * the Jones transforms of uniform draws in [-1, 1), so stationary and
+ * invertible. The
+ * reduced form ARMA(p + s P, q + s Q) is simulated with a burn-in, shifted by
+ * mu, then integrated D times with the period s and d times.
+ *
+ * @param[in]   handle          cuML handle
+ * @param[out]  out             The series, shape = (n_obs, batch_size),
+ *                              column major as the input of the ARIMA
+ *                              functions (device)
+ * @param[in]   batch_size      Number of series
+ * @param[in]   n_obs           Number of observations per series
+ * @param[in]   order           ARIMA order, without exogenous regressors
+ * @param[in]   noise_scale     Standard deviation of the innovations
+ * @param[in]   intercept_scale mu, when the order has one, is uniform in
+ *                              [-intercept_scale, intercept_scale)
+ * @param[in]   seed            Seed for the random number generator
+ * @param[out]  params          If not nullptr, the parameters of the
+ *                              series, grouped by series as described in
+ *                              ARIMAOrder, shape = (order.complexity(),
+ *                              batch_size) (device)
+ */
+void make_arima(cumlHandle& handle, double* out, int batch_size, int n_obs,
+                const ARIMAOrder& order, double noise_scale = 1.0,
+                double intercept_scale = 1.0, uint64_t seed = 0ULL,
+                double* params = nullptr);
+
+}  // namespace Datasets
+}  // namespace ML
@@ -17,6 +17,8 @@
 #pragma once
 
 #include <cuml/cuml.hpp>
+#include <cuml/datasets/shards.hpp>
+#include <functional>
 
 namespace ML {
 namespace Datasets {
@@ -73,5 +75,77 @@ void make_blobs(const cumlHandle& handle, double* out, int* labels, int n_rows,
                 bool shuffle, double center_box_min, double center_box_max,
                 uint64_t seed);
 
+/**
+ * @defgroup ShardedMakeBlobs
+ * @{
+ * @brief The blobs of make_blobs, by shards of a dataset which, from the seed
+ * alone, is the same whichever way it is cut and whichever rank generates the
+ * shards: the label of each row is drawn uniformly among the clusters, which
+ * also makes the dataset shuffled, and the centers, if not given, are the
+ * same on all the ranks. The values are counter-based, so the generation of
+ * a shard costs the same wherever it is in the dataset.
+ *
+ * make_blobs_shard generates the rows [row_offset, row_offset + n_rows),
+ * make_blobs_mg the rows of the rank of the communicator of the handle, see
+ * shard_rows, out of the n_rows of the whole dataset, and make_blobs_chunked
+ * the rows [row_offset, row_offset + n_rows) in chunks of at most chunk_rows
+ * rows, handed over to consume(out, labels, chunk_offset, chunk_rows) as soon
+ * as generated on the stream of the handle. The chunks reuse the same
+ * buffers, with which the consumer has to be done when the generation of the
+ * next chunk starts on the stream.
+ *
+ * For the params, see make_blobs.
+ */
+void make_blobs_shard(const cumlHandle& handle, float* out, int64_t* labels,
+                      int64_t row_offset, int64_t n_rows, int64_t n_cols,
+                      int64_t n_clusters, const float* centers = nullptr,
+                      const float* cluster_std = nullptr,
+                      const float cluster_std_scalar = 1.f,
+                      float center_box_min = -10.f,
+                      float center_box_max = 10.f, uint64_t seed = 0ULL);
+
+void make_blobs_shard(const cumlHandle& handle, double* out, int64_t* labels,
+                      int64_t row_offset, int64_t n_rows, int64_t n_cols,
+                      int64_t n_clusters, const double* centers = nullptr,
+                      const double* cluster_std = nullptr,
+                      const double cluster_std_scalar = 1.0,
+                      double center_box_min = -10.0,
+                      double center_box_max = 10.0, uint64_t seed = 0ULL);
+
+void make_blobs_mg(const cumlHandle& handle, float* out, int64_t* labels,
+                   int64_t n_rows, int64_t n_cols, int64_t n_clusters,
+                   const float* centers = nullptr,
+                   const float* cluster_std = nullptr,
+                   const float cluster_std_scalar = 1.f,
+                   float center_box_min = -10.f, float center_box_max = 10.f,
+                   uint64_t seed = 0ULL);
+
+void make_blobs_mg(const cumlHandle& handle, double* out, int64_t* labels,
+                   int64_t n_rows, int64_t n_cols, int64_t n_clusters,
+                   const double* centers = nullptr,
+                   const double* cluster_std = nullptr,
+                   const double cluster_std_scalar = 1.0,
+                   double center_box_min = -10.0,
+                   double center_box_max = 10.0, uint64_t seed = 0ULL);
+
+void make_blobs_chunked(
+  const cumlHandle& handle, int64_t row_offset, int64_t n_rows,
+  int64_t n_cols, int64_t n_clusters, int64_t chunk_rows,
+  const std::function<void(const float*, const int64_t*, int64_t, int64_t)>&
+    consume,
+  const float* centers = nullptr, const float* cluster_std = nullptr,
+  const float cluster_std_scalar = 1.f, float center_box_min = -10.f,
+  float center_box_max = 10.f, uint64_t seed = 0ULL);
+
+void make_blobs_chunked(
+  const cumlHandle& handle, int64_t row_offset, int64_t n_rows,
+  int64_t n_cols, int64_t n_clusters, int64_t chunk_rows,
+  const std::function<void(const double*, const int64_t*, int64_t, int64_t)>&
+    consume,
+  const double* centers = nullptr, const double* cluster_std = nullptr,
+  const double cluster_std_scalar = 1.0, double center_box_min = -10.0,
+  double center_box_max = 10.0, uint64_t seed = 0ULL);
+/** @} */
+
 }  // namespace Datasets
 }  // namespace ML
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuml/cuml.hpp>
+
+namespace ML {
+namespace Datasets {
+
+/**
+ * @brief GPU-equivalent of sklearn.datasets.make_classification as documented
+ * at:
+ * https://scikit-learn.org/stable/modules/generated/sklearn.datasets.make_classification.html
+ *
+ * @param[in]   handle              cuML handle
+ * @param[out]  out                 Row-major (samples, features) matrix of
+ *                                  the generated samples
+ * @param[out]  labels              The class of each sample (dim = n_rows)
+ * @param[in]   n_rows              Number of samples
+ * @param[in]   n_cols              Number of features
+ * @param[in]   n_classes           Number of classes
+ * @param[in]   n_clusters_per_class Number of clusters of each class
+ * @param[in]   n_informative       Number of informative features
+ * @param[in]   n_redundant         Number of redundant features, random
+ *                                  linear combinations of the informative
+ *                                  ones
+ * @param[in]   n_repeated          Number of features copied from random
+ *                                  informative or redundant ones
+ * @param[in]   flip_y              Ratio of the labels drawn at random, to
+ *                                  make the problem harder
+ * @param[in]   class_sep           Half the side of the hypercube around the
+ *                                  vertices of which are the clusters; larger
+ *                                  values make the problem easier
+ * @param[in]   hypercube           Whether the centroids are the vertices of
+ *                                  the hypercube, or are scaled at random
+ *                                  from them
+ * @param[in]   shift               A scalar added to all the features
+ * @param[in]   scale               A scalar by which all the features are
+ *                                  multiplied, after the shift
+ * @param[in]   shuffle             Shuffle the samples and the features
+ * @param[in]   seed                Seed for the random number generator
+ */
+void make_classification(
+  const cumlHandle& handle, float* out, int64_t* labels, int64_t n_rows,
+  int64_t n_cols, int64_t n_classes = 2, int64_t n_clusters_per_class = 2,
+  int64_t n_informative = 2, int64_t n_redundant = 2, int64_t n_repeated = 0,
+  float flip_y = 0.01f, float class_sep = 1.0f, bool hypercube = true,
+  float shift = 0.0f, float scale = 1.0f, bool shuffle = true,
+  uint64_t seed = 0ULL);
+
+void make_classification(
+  const cumlHandle& handle, double* out, int64_t* labels, int64_t n_rows,
+  int64_t n_cols, int64_t n_classes = 2, int64_t n_clusters_per_class = 2,
+  int64_t n_informative = 2, int64_t n_redundant = 2, int64_t n_repeated = 0,
+  double flip_y = 0.01, double class_sep = 1.0, bool hypercube = true,
+  double shift = 0.0, double scale = 1.0, bool shuffle = true,
+  uint64_t seed = 0ULL);
+
+void make_classification(
+  const cumlHandle& handle, float* out, int* labels, int n_rows, int n_cols,
+  int n_classes = 2, int n_clusters_per_class = 2, int n_informative = 2,
+  int n_redundant = 2, int n_repeated = 0, float flip_y = 0.01f,
+  float class_sep = 1.0f, bool hypercube = true, float shift = 0.0f,
+  float scale = 1.0f, bool shuffle = true, uint64_t seed = 0ULL);
+
+void make_classification(
+  const cumlHandle& handle, double* out, int* labels, int n_rows, int n_cols,
+  int n_classes = 2, int n_clusters_per_class = 2, int n_informative = 2,
+  int n_redundant = 2, int n_repeated = 0, double flip_y = 0.01,
+  double class_sep = 1.0, bool hypercube = true, double shift = 0.0,
+  double scale = 1.0, bool shuffle = true, uint64_t seed = 0ULL);
+
+}  // namespace Datasets
+}  // namespace ML
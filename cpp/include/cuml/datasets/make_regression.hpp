@@ -17,6 +17,8 @@
 #pragma once
 
 #include <cuml/cuml.hpp>
+#include <cuml/datasets/shards.hpp>
+#include <functional>
 
 namespace ML {
 namespace Datasets {
@@ -79,5 +81,69 @@ void make_regression(const cumlHandle& handle, double* out, double* values,
                      double tail_strength = 0.5, double noise = 0.0,
                      bool shuffle = true, uint64_t seed = 0ULL);
 
+/**
+ * @defgroup ShardedMakeRegression
+ * @{
+ * @brief The well conditioned problems of make_regression, by shards of a
+ * problem which, from the seed alone, is the same whichever way it is cut and
+ * whichever rank generates the shards. The informative features are the
+ * first n_informative, and the rows, being independent, are not shuffled. The
+ * values are counter-based, so the generation of a shard costs the same
+ * wherever it is in the problem.
+ *
+ * make_regression_shard generates the rows [row_offset, row_offset + n_rows),
+ * less than 2^31 of them, make_regression_mg the rows of the rank of the
+ * communicator of the handle, see shard_rows, out of the n_rows of the whole
+ * problem, and make_regression_chunked the rows [row_offset, row_offset +
+ * n_rows) in chunks of at most chunk_rows rows, handed over to
+ * consume(out, values, chunk_offset, chunk_rows) as soon as generated on the
+ * stream of the handle. The chunks reuse the same buffers, with which the
+ * consumer has to be done when the generation of the next chunk starts on the
+ * stream.
+ *
+ * For the params, see make_regression.
+ */
+void make_regression_shard(const cumlHandle& handle, float* out, float* values,
+                           int64_t row_offset, int64_t n_rows, int64_t n_cols,
+                           int64_t n_informative, float* coef = nullptr,
+                           int64_t n_targets = 1LL, float bias = 0.0f,
+                           float noise = 0.0f, uint64_t seed = 0ULL);
+
+void make_regression_shard(const cumlHandle& handle, double* out,
+                           double* values, int64_t row_offset, int64_t n_rows,
+                           int64_t n_cols, int64_t n_informative,
+                           double* coef = nullptr, int64_t n_targets = 1LL,
+                           double bias = 0.0, double noise = 0.0,
+                           uint64_t seed = 0ULL);
+
+void make_regression_mg(const cumlHandle& handle, float* out, float* values,
+                        int64_t n_rows, int64_t n_cols, int64_t n_informative,
+                        float* coef = nullptr, int64_t n_targets = 1LL,
+                        float bias = 0.0f, float noise = 0.0f,
+                        uint64_t seed = 0ULL);
+
+void make_regression_mg(const cumlHandle& handle, double* out, double* values,
+                        int64_t n_rows, int64_t n_cols, int64_t n_informative,
+                        double* coef = nullptr, int64_t n_targets = 1LL,
+                        double bias = 0.0, double noise = 0.0,
+                        uint64_t seed = 0ULL);
+
+void make_regression_chunked(
+  const cumlHandle& handle, int64_t row_offset, int64_t n_rows,
+  int64_t n_cols, int64_t n_informative, int64_t chunk_rows,
+  const std::function<void(const float*, const float*, int64_t, int64_t)>&
+    consume,
+  float* coef = nullptr, int64_t n_targets = 1LL, float bias = 0.0f,
+  float noise = 0.0f, uint64_t seed = 0ULL);
+
+void make_regression_chunked(
+  const cumlHandle& handle, int64_t row_offset, int64_t n_rows,
+  int64_t n_cols, int64_t n_informative, int64_t chunk_rows,
+  const std::function<void(const double*, const double*, int64_t, int64_t)>&
+    consume,
+  double* coef = nullptr, int64_t n_targets = 1LL, double bias = 0.0,
+  double noise = 0.0, uint64_t seed = 0ULL);
+/** @} */
+
 }  // namespace Datasets
 }  // namespace ML
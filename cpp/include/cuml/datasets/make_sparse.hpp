@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuml/cuml.hpp>
+
+namespace ML {
+namespace Datasets {
+
+/**
+ * @defgroup MakeSparse
+ * @{
+ * @brief Random CSR matrices, the GPU-equivalent of scipy.sparse.random as
+ * documented at:
+ * https://docs.scipy.org/doc/scipy/reference/generated/scipy.sparse.random.html
+ * with each element non-zero with probability density, rather than exactly
+ * density * n_rows * n_cols of them, and the column indices sorted in each
+ * row. The nnz being random, the matrix is generated in two passes:
+ *
+ *   make_sparse_rows(handle, indptr, n_rows, n_cols, density, seed);
+ *   // copy indptr[n_rows], the nnz, to the host and allocate with it
+ *   make_sparse(handle, indices, values, indptr, n_rows, n_cols, density,
+ *               value_min, value_max, seed);
+ *
+ * @param[in]   handle      cuML handle
+ * @param[out]  indptr      The row pointers (dim = n_rows + 1), input of
+ *                          make_sparse
+ * @param[out]  indices     The column indices of the non-zeros (dim = nnz)
+ * @param[out]  values      The values of the non-zeros (dim = nnz), uniform
+ *                          in [value_min, value_max)
+ * @param[in]   n_rows      Number of rows
+ * @param[in]   n_cols      Number of columns
+ * @param[in]   density     The probability of an element being non-zero
+ * @param[in]   value_min   Min value of the non-zeros
+ * @param[in]   value_max   Max value of the non-zeros, excluded
+ * @param[in]   seed        Seed for the random number generator, the same in
+ *                          both passes
+ */
+void make_sparse_rows(const cumlHandle& handle, int64_t* indptr,
+                      int64_t n_rows, int64_t n_cols, double density,
+                      uint64_t seed = 0ULL);
+
+void make_sparse_rows(const cumlHandle& handle, int* indptr, int n_rows,
+                      int n_cols, double density, uint64_t seed = 0ULL);
+
+void make_sparse(const cumlHandle& handle, int64_t* indices, float* values,
+                 const int64_t* indptr, int64_t n_rows, int64_t n_cols,
+                 double density, float value_min = 0.f,
+                 float value_max = 1.f, uint64_t seed = 0ULL);
+
+void make_sparse(const cumlHandle& handle, int64_t* indices, double* values,
+                 const int64_t* indptr, int64_t n_rows, int64_t n_cols,
+                 double density, double value_min = 0.0,
+                 double value_max = 1.0, uint64_t seed = 0ULL);
+
+void make_sparse(const cumlHandle& handle, int* indices, float* values,
+                 const int* indptr, int n_rows, int n_cols, double density,
+                 float value_min = 0.f, float value_max = 1.f,
+                 uint64_t seed = 0ULL);
+
+void make_sparse(const cumlHandle& handle, int* indices, double* values,
+                 const int* indptr, int n_rows, int n_cols, double density,
+                 double value_min = 0.0, double value_max = 1.0,
+                 uint64_t seed = 0ULL);
+/** @} */
+
+}  // namespace Datasets
+}  // namespace ML
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace ML {
+namespace Datasets {
+
+/**
+ * @brief The rows of a rank in the sharded generators of the datasets, the
+ * `*_mg` ones: the n_rows rows are cut in n_ranks contiguous shards, the
+ * first n_rows % n_ranks of which have one more row
+ * @param[in]   n_rows      Number of rows of the whole dataset
+ * @param[in]   n_ranks     Number of ranks sharing it
+ * @param[in]   rank        The rank
+ * @param[out]  row_offset  The global index of the first row of the rank
+ * @param[out]  rank_rows   Number of rows of the rank
+ */
+inline void shard_rows(int64_t n_rows, int n_ranks, int rank,
+                       int64_t* row_offset, int64_t* rank_rows) {
+  int64_t base = n_rows / n_ranks, extra = n_rows % n_ranks;
+  *rank_rows = base + (rank < extra ? 1 : 0);
+  *row_offset = base * rank + (rank < extra ? rank : extra);
+}
+
+}  // namespace Datasets
+}  // namespace ML
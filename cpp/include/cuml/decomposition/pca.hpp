@@ -28,6 +28,35 @@ void pcaFit(cumlHandle &handle, double *input, double *components,
             double *explained_var, double *explained_var_ratio,
             double *singular_vals, double *mu, double *noise_vars,
             paramsPCA prms);
+/**
+ * @defgroup functions to fit a PCA on the rows of all the ranks of the
+ * communicator of the handle. input holds the prms.n_rows rows of this rank,
+ * and the other parameters are as in pcaFit. The fit is the same on all the
+ * ranks.
+ * @{
+ */
+void pcaFitMG(cumlHandle &handle, float *input, float *components,
+              float *explained_var, float *explained_var_ratio,
+              float *singular_vals, float *mu, float *noise_vars,
+              paramsPCA prms);
+void pcaFitMG(cumlHandle &handle, double *input, double *components,
+              double *explained_var, double *explained_var_ratio,
+              double *singular_vals, double *mu, double *noise_vars,
+              paramsPCA prms);
+/** @} */
+
+void pcaPartialFit(cumlHandle &handle, float *input, float *mu,
+                   float *scatter, size_t *n_samples_seen, paramsPCA prms);
+void pcaPartialFit(cumlHandle &handle, double *input, double *mu,
+                   double *scatter, size_t *n_samples_seen, paramsPCA prms);
+void pcaFitScatter(cumlHandle &handle, const float *scatter,
+                   size_t n_samples_seen, float *components,
+                   float *explained_var, float *explained_var_ratio,
+                   float *singular_vals, paramsPCA prms);
+void pcaFitScatter(cumlHandle &handle, const double *scatter,
+                   size_t n_samples_seen, double *components,
+                   double *explained_var, double *explained_var_ratio,
+                   double *singular_vals, paramsPCA prms);
 void pcaFitTransform(cumlHandle &handle, float *input, float *trans_input,
                      float *components, float *explained_var,
                      float *explained_var_ratio, float *singular_vals,
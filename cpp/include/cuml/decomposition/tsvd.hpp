@@ -25,6 +25,25 @@ void tsvdFit(cumlHandle &handle, float *input, float *components,
              float *singular_vals, paramsTSVD prms);
 void tsvdFit(cumlHandle &handle, double *input, double *components,
              double *singular_vals, paramsTSVD prms);
+/**
+ * @defgroup functions to fit a TSVD on the rows of all the ranks of the
+ * communicator of the handle. input holds the prms.n_rows rows of this rank,
+ * and the other parameters are as in tsvdFit. The fit is the same on all the
+ * ranks.
+ * @{
+ */
+void tsvdFitMG(cumlHandle &handle, float *input, float *components,
+               float *singular_vals, paramsTSVD prms);
+void tsvdFitMG(cumlHandle &handle, double *input, double *components,
+               double *singular_vals, paramsTSVD prms);
+/** @} */
+
+void tsvdFitSparse(cumlHandle &handle, const float *values, const int *cols,
+                   const int *row_ids, int nnz, float *components,
+                   float *singular_vals, paramsTSVD prms);
+void tsvdFitSparse(cumlHandle &handle, const double *values, const int *cols,
+                   const int *row_ids, int nnz, double *components,
+                   double *singular_vals, paramsTSVD prms);
 void tsvdInverseTransform(cumlHandle &handle, float *trans_input,
                           float *components, float *input, paramsTSVD prms);
 void tsvdInverseTransform(cumlHandle &handle, double *trans_input,
@@ -33,6 +52,14 @@ void tsvdTransform(cumlHandle &handle, float *input, float *components,
                    float *trans_input, paramsTSVD prms);
 void tsvdTransform(cumlHandle &handle, double *input, double *components,
                    double *trans_input, paramsTSVD prms);
+void tsvdTransformSparse(cumlHandle &handle, const float *values,
+                         const int *cols, const int *row_ids, int nnz,
+                         float *components, float *trans_input,
+                         paramsTSVD prms);
+void tsvdTransformSparse(cumlHandle &handle, const double *values,
+                         const int *cols, const int *row_ids, int nnz,
+                         double *components, double *trans_input,
+                         paramsTSVD prms);
 void tsvdFitTransform(cumlHandle &handle, float *input, float *trans_input,
                       float *components, float *explained_var,
                       float *explained_var_ratio, float *singular_vals,
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cuml/ensemble/treelite_defs.hpp>
+#include <cuml/tree/decisiontree.hpp>
+#include <vector>
+
+namespace ML {
+
+enum GBDT_loss {
+  /** Regression: 0.5 * (prediction - label)^2 */
+  SQUARED_ERROR,
+  /** Binary classification on 0/1 labels: log loss of sigmoid(margin) */
+  LOGISTIC,
+};
+
+struct GBDT_params {
+  /**
+   * Number of boosting iterations, i.e. of trees.
+   */
+  int n_estimators;
+  /**
+   * Shrinkage of the leaf values of each tree.
+   */
+  float learning_rate;
+  /**
+   * Loss minimized by the boosting.
+   */
+  GBDT_loss loss;
+  /**
+   * L2 regularization of the leaf values.
+   */
+  float lambda;
+  /**
+   * Minimum hessian sum of each child of a split.
+   */
+  float min_child_weight;
+  /**
+   * Decision tree training hyper parameter struct. split_criterion is
+   * ignored (the split gain is the second order one of the loss) and
+   * min_impurity_decrease is the minimum gain of a split.
+   */
+  DecisionTree::DecisionTreeParams tree_params;
+};
+
+void set_gbdt_params(GBDT_params& params, int cfg_n_estimators = 100,
+                     float cfg_learning_rate = 0.1f,
+                     GBDT_loss cfg_loss = GBDT_loss::SQUARED_ERROR,
+                     float cfg_lambda = 1.0f,
+                     float cfg_min_child_weight = 1.0f);
+void validity_check(const GBDT_params params);
+void print(const GBDT_params params);
+
+/**
+ * A gradient boosted model: the prediction of a row is the sum of base_score
+ * and of the leaf values of the trees, through a sigmoid for LOGISTIC.
+ */
+template <class T>
+struct GBDTModel {
+  std::vector<DecisionTree::TreeMetaDataNode<T, T>> trees;
+  GBDT_params params;
+  T base_score;
+};
+
+typedef GBDTModel<float> GBDTModelF;
+typedef GBDTModel<double> GBDTModelD;
+
+template <class T>
+void build_treelite_gbdt(ModelHandle* model, const GBDTModel<T>* gbdt,
+                         int num_features);
+
+void fit(const cumlHandle& user_handle, GBDTModelF& model, const float* input,
+         int n_rows, int n_cols, const float* labels, GBDT_params params);
+void fit(const cumlHandle& user_handle, GBDTModelD& model, const double* input,
+         int n_rows, int n_cols, const double* labels, GBDT_params params);
+
+void predict(const cumlHandle& user_handle, const GBDTModelF& model,
+             const float* input, int n_rows, int n_cols, float* predictions);
+void predict(const cumlHandle& user_handle, const GBDTModelD& model,
+             const double* input, int n_rows, int n_cols, double* predictions);
+
+};  // namespace ML
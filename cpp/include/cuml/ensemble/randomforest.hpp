@@ -15,9 +15,12 @@
  */
 
 #pragma once
+#include <cuml/common/matrixView.hpp>
 #include <cuml/ensemble/treelite_defs.hpp>
+#include <cuml/fil/fil.h>
 #include <cuml/tree/decisiontree.hpp>
 #include <map>
+#include <vector>
 
 namespace ML {
 
@@ -75,6 +78,20 @@ struct RF_params {
    * N streams need N times RF workspace.
    */
   int n_streams;
+  /**
+   * Number of trees a classifier grows together in lock-step on a single
+   * stream, with one histogram kernel launch per level for all of them.
+   * Replaces n_streams when greater than 1; a batch needs batch size times
+   * the workspace of a tree. Ignored by regressors.
+   */
+  int tree_batch_size;
+  /**
+   * Whether fit computes the out-of-bag metrics and the impurity-based
+   * feature importances of the forest (see RandomForestMetaData), in one
+   * pass of the training rows through each tree. Default false.
+   * Not supported with stream_cols or by the distributed fit.
+   */
+  bool oob_score;
   DecisionTree::DecisionTreeParams tree_params;
 };
 
@@ -102,6 +119,17 @@ struct RandomForestMetaData {
   DecisionTree::TreeMetaDataNode<T, L>* trees;
   RF_params rf_params;
   //TODO can add prepare, train time, if needed
+  /**
+   * Set by fit if rf_params.oob_score: metrics of the mean (regression) or
+   * majority vote (classification) of the trees which do not have a row in
+   * their bootstrap sample, over the rows with at least one such tree.
+   */
+  RF_metrics oob_metrics;
+  /**
+   * Set by fit if rf_params.oob_score: impurity decrease of the splits on
+   * each feature, weighted by the node sizes, normalized to sum to 1.
+   */
+  std::vector<T> feature_importances;
 };
 
 template <class T, class L>
@@ -121,6 +149,36 @@ void build_treelite_forest(ModelHandle* model,
 
 std::vector<unsigned char> save_model(ModelHandle model);
 
+/**
+ * Write forest into *pbytes (previous contents replaced) in a compact flat
+ * binary format: the parameters, metrics and feature importances, followed
+ * by the nodes of all the trees with only the fields used for prediction.
+ * The blob uses the byte order and type sizes of the host which saved it.
+ */
+template <class T, class L>
+void save_forest(const RandomForestMetaData<T, L>* forest,
+                 std::vector<char>* pbytes);
+
+/**
+ * Load into forest, which must have no trees, the size bytes of a forest
+ * written by save_forest for the same T and L.
+ */
+template <class T, class L>
+void load_forest(RandomForestMetaData<T, L>* forest, const void* bytes,
+                 size_t size);
+
+/**
+ * Create a FIL forest directly from the trees of a regressor or binary
+ * classifier, without going through treelite; the tree outputs are
+ * averaged, and tl_params has the same meaning as for fil::from_treelite.
+ * Multi-class classifiers are not supported, as FIL has no vector leaves.
+ */
+template <class T, class L>
+void build_fil_forest(const cumlHandle& handle, fil::forest_t* pforest,
+                      const RandomForestMetaData<T, L>* forest,
+                      int num_features,
+                      const fil::treelite_params_t* tl_params);
+
 // ----------------------------- Classification ----------------------------------- //
 
 typedef RandomForestMetaData<float, int> RandomForestClassifierF;
@@ -133,6 +191,16 @@ void fit(const cumlHandle& user_handle, RandomForestClassifierD*& forest,
          double* input, int n_rows, int n_cols, int* labels,
          int n_unique_labels, RF_params rf_params);
 
+// Trains the trees over the ranks of the communicator of user_handle
+void fit_mg(const cumlHandle& user_handle, RandomForestClassifierF*& forest,
+            float* input, int n_rows, int n_cols, int* labels,
+            int n_unique_labels, RF_params rf_params);
+void fit_mg(const cumlHandle& user_handle, RandomForestClassifierD*& forest,
+            double* input, int n_rows, int n_cols, int* labels,
+            int n_unique_labels, RF_params rf_params);
+
+// Asynchronous unless verbose: the predictions are written by the work
+// enqueued on the stream of user_handle
 void predict(const cumlHandle& user_handle,
              const RandomForestClassifierF* forest, const float* input,
              int n_rows, int n_cols, int* predictions, bool verbose = false);
@@ -140,6 +208,24 @@ void predict(const cumlHandle& user_handle,
              const RandomForestClassifierD* forest, const double* input,
              int n_rows, int n_cols, int* predictions, bool verbose = false);
 
+// The same, from matrices of any layout: the fit works on column-major data
+// and the predictions on row-major data, which are only copied if their
+// layout differs
+void fit(const cumlHandle& user_handle, RandomForestClassifierF*& forest,
+         const matrixView<const float>& input, int* labels,
+         int n_unique_labels, RF_params rf_params);
+void fit(const cumlHandle& user_handle, RandomForestClassifierD*& forest,
+         const matrixView<const double>& input, int* labels,
+         int n_unique_labels, RF_params rf_params);
+void predict(const cumlHandle& user_handle,
+             const RandomForestClassifierF* forest,
+             const matrixView<const float>& input, int* predictions,
+             bool verbose = false);
+void predict(const cumlHandle& user_handle,
+             const RandomForestClassifierD* forest,
+             const matrixView<const double>& input, int* predictions,
+             bool verbose = false);
+
 void predictGetAll(const cumlHandle& user_handle,
                    const RandomForestClassifierF* forest, const float* input,
                    int n_rows, int n_cols, int* predictions,
@@ -175,6 +261,15 @@ void fit(const cumlHandle& user_handle, RandomForestRegressorD*& forest,
          double* input, int n_rows, int n_cols, double* labels,
          RF_params rf_params);
 
+// Trains the trees over the ranks of the communicator of user_handle
+void fit_mg(const cumlHandle& user_handle, RandomForestRegressorF*& forest,
+            float* input, int n_rows, int n_cols, float* labels,
+            RF_params rf_params);
+void fit_mg(const cumlHandle& user_handle, RandomForestRegressorD*& forest,
+            double* input, int n_rows, int n_cols, double* labels,
+            RF_params rf_params);
+
+// Asynchronous unless verbose, as for the classifier
 void predict(const cumlHandle& user_handle,
              const RandomForestRegressorF* forest, const float* input,
              int n_rows, int n_cols, float* predictions, bool verbose = false);
@@ -182,6 +277,22 @@ void predict(const cumlHandle& user_handle,
              const RandomForestRegressorD* forest, const double* input,
              int n_rows, int n_cols, double* predictions, bool verbose = false);
 
+// The same, from matrices of any layout, as for the classifier
+void fit(const cumlHandle& user_handle, RandomForestRegressorF*& forest,
+         const matrixView<const float>& input, float* labels,
+         RF_params rf_params);
+void fit(const cumlHandle& user_handle, RandomForestRegressorD*& forest,
+         const matrixView<const double>& input, double* labels,
+         RF_params rf_params);
+void predict(const cumlHandle& user_handle,
+             const RandomForestRegressorF* forest,
+             const matrixView<const float>& input, float* predictions,
+             bool verbose = false);
+void predict(const cumlHandle& user_handle,
+             const RandomForestRegressorD* forest,
+             const matrixView<const double>& input, double* predictions,
+             bool verbose = false);
+
 RF_metrics score(const cumlHandle& user_handle,
                  const RandomForestRegressorF* forest, const float* ref_labels,
                  int n_rows, float* predictions, bool verbose = false);
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <vector>
 #include <cuml/cuml.hpp>
 #include <cuml/ensemble/treelite_defs.hpp>
 
@@ -29,18 +30,26 @@ namespace fil {
  *  and the threshold/weight type.
  */
 
-/** Inference algorithm to use. */
+/** Inference algorithm to use. The values are explicit since they are
+    passed as integers and stored in saved forests. */
 enum algo_t {
   /** naive algorithm: 1 thread block predicts 1 row; the row is cached in
       shared memory, and the trees are distributed cyclically between threads */
-  NAIVE,
+  NAIVE = 0,
   /** tree reorg algorithm: same as naive, but the tree nodes are rearranged
       into a more coalescing-friendly layout: for every node position,
       nodes of all trees at that position are stored next to each other */
-  TREE_REORG,
+  TREE_REORG = 1,
   /** batch tree reorg algorithm: same as tree reorg, but predictions multiple rows (up to 4)
       in a single thread block */
-  BATCH_TREE_REORG
+  BATCH_TREE_REORG = 2,
+  /** choose the algorithm from the shape of the forest: sparse forests use
+      NAIVE; dense forests use BATCH_TREE_REORG when two rows fit into the
+      shared memory of a block and the trees are shallow enough (depth <= 15)
+      for several rows to be walked together, and TREE_REORG otherwise;
+      the rows and threads per block then follow the depth and the number
+      of trees */
+  ALGO_AUTO = 3
 };
 
 /**
@@ -50,7 +59,10 @@ enum algo_t {
  * output of the previous stage:
  * - one of RAW or AVG, indicating how to combine individual tree outputs into the forest output
  * - optional SIGMOID for applying the sigmoid transform
+ * - optional SOFTMAX, for applying softmax over the class scores of a row
+ *   (only for multi-class forests, and not together with SIGMOID)
  * - optional THRESHOLD, for thresholding for classification
+ *   (only for forests with a single output)
  */
 enum output_t {
   /** raw output: the sum of the tree outputs; use for GBM models for
@@ -68,6 +80,10 @@ enum output_t {
   /** threshold: apply threshold to the output of the previous stage to get the
       class (0 or 1) */
   THRESHOLD = 0x100,
+  /** softmax transformation: apply exp(x_i)/sum_j(exp(x_j)) over the
+      num_classes outputs of each row; use for GBM multi-class classification
+      models for class probabilities */
+  SOFTMAX = 0x1000,
 };
 
 /** storage_type_t defines whether to import the forests as dense or sparse */
@@ -77,7 +93,20 @@ enum storage_type_t {
   /** import the forest as dense */
   DENSE,
   /** import the forest as sparse */
-  SPARSE
+  SPARSE,
+  /** import the forest as sparse with 8-byte nodes; the number of features
+      must be at most 2**14 and each tree must have at most 2**16 nodes */
+  SPARSE8
+};
+
+/** mg_mode_t defines how a forest is split across multiple GPUs, each used
+    by a separate rank of the communicator of the cuML handle */
+enum mg_mode_t {
+  /** each rank holds the whole forest and predicts on its own rows */
+  DATA_PARALLEL,
+  /** each rank holds a subset of the trees; all ranks predict on the same
+      rows, and the partial sums of the ranks are summed with an allreduce */
+  MODEL_PARALLEL
 };
 
 /** dense_node_t is a node in a densely-stored forest */
@@ -93,6 +122,14 @@ struct sparse_node_t {
   int left_idx;
 };
 
+/** sparse_node8_t is a node of reduced size (8 bytes) in a sparsely-stored
+    forest; the feature index, the flags and the index of the left child
+    relative to the tree root are packed into bits */
+struct sparse_node8_t {
+  float val;
+  int bits;
+};
+
 /** dense_node_init initializes node from paramters */
 void dense_node_init(dense_node_t* n, float output, float thresh, int fid,
                      bool def_left, bool is_leaf);
@@ -110,6 +147,16 @@ void sparse_node_decode(const sparse_node_t* node, float* output, float* thresh,
                         int* fid, bool* def_left, bool* is_leaf,
                         int* left_index);
 
+/** sparse_node8_init initializes node from parameters; fid must be less
+    than 2**14, and left_index less than 2**16 */
+void sparse_node8_init(sparse_node8_t* node, float output, float thresh,
+                       int fid, bool def_left, bool is_leaf, int left_index);
+
+/** sparse_node8_decode extracts individual members from node */
+void sparse_node8_decode(const sparse_node8_t* node, float* output,
+                         float* thresh, int* fid, bool* def_left,
+                         bool* is_leaf, int* left_index);
+
 struct forest;
 
 /** forest_t is the predictor handle */
@@ -126,7 +173,8 @@ struct forest_params_t {
   // num_cols is the number of columns in the data
   int num_cols;
   // algo is the inference algorithm;
-  // sparse forests do not distinguish between NAIVE and TREE_REORG
+  // sparse forests do not distinguish between NAIVE and TREE_REORG,
+  // and only NAIVE and ALGO_AUTO are allowed for them
   algo_t algo;
   // output is the desired output type
   output_t output;
@@ -136,6 +184,11 @@ struct forest_params_t {
   // global_bias is added to the sum of tree predictions
   // (after averaging, if it is used, but before any further transformations)
   float global_bias;
+  // num_classes is the number of outputs per row; must be at least 1;
+  // if greater than 1, the trees are grouped by class: tree i contributes
+  // to the output for class i % num_classes, and num_trees must be
+  // divisible by num_classes
+  int num_classes;
 };
 
 /** treelite_params_t are parameters for importing treelite models */
@@ -172,7 +225,16 @@ void init_dense(const cumlHandle& h, forest_t* pf, const dense_node_t* nodes,
 void init_sparse(const cumlHandle& h, forest_t* pf, const int* trees,
                  const sparse_node_t* nodes, const forest_params_t* params);
 
-/** from_treelite uses a treelite model to initialize the forest
+/** init_sparse uses params, trees and 8-byte nodes to initialize
+ *  the sparse forest stored in pf; the parameters are the same as for
+ *  init_sparse() with sparse_node_t nodes
+ */
+void init_sparse(const cumlHandle& h, forest_t* pf, const int* trees,
+                 const sparse_node8_t* nodes, const forest_params_t* params);
+
+/** from_treelite uses a treelite model to initialize the forest;
+ * categorical splits are imported natively for the DENSE and SPARSE storage
+ * types, with the sets of categories going left stored alongside the forest
  * @param handle cuML handle used by this function
  * @param pforest pointer to where to store the newly created forest
  * @param model treelite model used to initialize the forest
@@ -181,6 +243,46 @@ void init_sparse(const cumlHandle& h, forest_t* pf, const int* trees,
 void from_treelite(const cumlHandle& handle, forest_t* pforest,
                    ModelHandle model, const treelite_params_t* tl_params);
 
+/** save writes forest f into *pbytes as a flat binary blob, which contains
+ *  the nodes as they are laid out on the device for inference, together with
+ *  the forest parameters; load() then copies the nodes back to the device
+ *  without any further processing
+ *  @param h cuML handle used by this function
+ *  @param f the forest to save
+ *  @param pbytes vector into which to write the saved forest; its previous
+ *      contents are replaced
+ */
+void save(const cumlHandle& h, forest_t f, std::vector<char>* pbytes);
+
+/** load creates a forest from a blob written by save(); the arrays
+ *  in the blob are 8-byte aligned, so that it can be memory-mapped from
+ *  a file; the blob uses the byte order of the host which saved it
+ *  @param h cuML handle used by this function
+ *  @param pf pointer to where to store the loaded forest
+ *  @param bytes the saved forest, in host memory; may be freed or unmapped
+ *      after the call
+ *  @param size size of bytes, in bytes
+ */
+void load(const cumlHandle& h, forest_t* pf, const void* bytes, size_t size);
+
+/** from_treelite_mg creates the part of a multi-GPU forest held by the rank
+ *  of the handle's communicator (see mg_mode_t); with MODEL_PARALLEL, rank r
+ *  of N ranks imports each N-th group of num_output_group consecutive trees,
+ *  starting from group r; predict() and predict_contributions() must then be
+ *  called on all ranks with the same data, and return the outputs of the whole
+ *  forest on each rank; predict_host() and predict_per_tree() are not
+ *  supported for model-parallel forests
+ *  @param handle cuML handle used by this function; for MODEL_PARALLEL,
+ *      its communicator must be initialized
+ *  @param pforest pointer to where to store the newly created forest
+ *  @param model treelite model used to initialize the forest
+ *  @param tl_params additional parameters for the forest
+ *  @param mode how to split the forest across the GPUs
+ */
+void from_treelite_mg(const cumlHandle& handle, forest_t* pforest,
+                      ModelHandle model, const treelite_params_t* tl_params,
+                      mg_mode_t mode);
+
 /** free deletes forest and all resources held by it; after this, forest is no longer usable
  *  @param h cuML handle used by this function
  *  @param f the forest to free; not usable after the call to this function
@@ -191,7 +293,9 @@ void free(const cumlHandle& h, forest_t f);
  *  the number of columns is stored in forest, and both preds and data point to GPU memory
  *  @param h cuML handle used by this function
  *  @param f forest used for predictions
- *  @param preds array of size n in GPU memory to store predictions into
+ *  @param preds array of size n * num_classes in GPU memory to store
+ *      predictions into; for multi-class forests, the outputs for row i
+ *      are stored at preds[i * num_classes .. (i + 1) * num_classes - 1]
  *  @param data array of size n * cols (cols is the number of columns
  *      for the forest f) from which to predict
  *  @param num_rows number of data rows
@@ -199,5 +303,66 @@ void free(const cumlHandle& h, forest_t f);
 void predict(const cumlHandle& h, forest_t f, float* preds, const float* data,
              size_t num_rows);
 
+/** predict_host is the same as predict(), but both preds and data point to
+ *  host memory; the rows are split into chunks that are distributed
+ *  cyclically over the internal streams of h (or its stream, if it has none),
+ *  so that copying the data to the device, inference and copying the
+ *  predictions back overlap; for the copies to be asynchronous, preds
+ *  and data must be in pinned host memory
+ *  @note the function is asynchronous with respect to the host: preds is only
+ *      valid after the stream of h is synchronized
+ *  @param h cuML handle used by this function
+ *  @param f forest used for predictions
+ *  @param preds array of size n * num_classes in host memory to store
+ *      predictions into
+ *  @param data array of size n * cols in host memory from which to predict
+ *  @param num_rows number of data rows
+ *  @param chunk_rows number of rows in a chunk; 0 means the default (65536)
+ */
+void predict_host(const cumlHandle& h, forest_t f, float* preds,
+                  const float* data, size_t num_rows, size_t chunk_rows = 0);
+
+/** predict_contributions computes the approximate contributions of the
+ *  features to the predictions on data (with n rows), in GPU memory;
+ *  the contribution of the split on the path of a row through a tree is the
+ *  change in the expected value of the tree from the node to its child and is
+ *  attributed to the feature of the split (Saabas' method); the expected value
+ *  of an inner node is the average of those of its children, weighted by
+ *  their covers if they were imported from treelite
+ *  @param h cuML handle used by this function
+ *  @param f forest used for predictions
+ *  @param preds array of size n * num_classes * (cols + 1) in GPU memory;
+ *      the contribution of feature j to output c of row i is stored at
+ *      preds[(i * num_classes + c) * (cols + 1) + j], and the bias term
+ *      (the expected value of the forest, plus global_bias) at j == cols;
+ *      the contributions are to the raw margin (but averaged if the output
+ *      is averaged), i.e. before sigmoid, softmax or threshold are applied,
+ *      and for each output they sum to it
+ *  @param data array of size n * cols (cols is the number of columns
+ *      for the forest f) for which to compute the contributions
+ *  @param num_rows number of data rows
+ */
+void predict_contributions(const cumlHandle& h, forest_t f, float* preds,
+                           const float* data, size_t num_rows);
+
+/** predict_per_tree writes, for each row of data (with n rows) and each tree
+ *  of the forest, the raw output of the tree (with no averaging, global_bias
+ *  or output transformations) or the index of the leaf the row reaches
+ *  in the tree, in one traversal on the GPU
+ *  @param h cuML handle used by this function
+ *  @param f forest used for predictions
+ *  @param preds array of size n * num_trees in GPU memory; the output for
+ *      row i and tree j is stored at preds[i * num_trees + j]
+ *  @param data array of size n * cols (cols is the number of columns
+ *      for the forest f) from which to predict
+ *  @param num_rows number of data rows
+ *  @param leaf_ids if true, the index of the leaf node within the tree is
+ *      written instead of its output; for dense forests, the index is that
+ *      of the node in breadth-first order within the full tree, and for
+ *      sparse forests, it is relative to the root index passed in trees
+ */
+void predict_per_tree(const cumlHandle& h, forest_t f, float* preds,
+                      const float* data, size_t num_rows, bool leaf_ids);
+
 }  // namespace fil
 }  // namespace ML
@@ -40,6 +40,27 @@ void olsFit(const cumlHandle &handle, double *input, int n_rows, int n_cols,
             bool normalize, int algo = 0);
 /** @} */
 
+/**
+ * @defgroup Functions fit an ordinary least squares model on host data, which
+ * is streamed to the device by blocks of rows
+ * @param input         host pointer to feature matrix n_rows x n_cols
+ * @param n_rows        number of rows of the feature matrix
+ * @param n_cols        number of columns of the feature matrix
+ * @param labels        host pointer to label vector of length n_rows
+ * @param coef          device pointer to hold the solution for weights of size n_cols
+ * @param intercept     host pointer to hold the solution for bias term of size 1
+ * @param fit_intercept if true, fit intercept
+ * @param batch_size    number of rows of a block
+ * @{
+ */
+void olsFitHost(const cumlHandle &handle, const float *input, size_t n_rows,
+                int n_cols, const float *labels, float *coef, float *intercept,
+                bool fit_intercept, int batch_size);
+void olsFitHost(const cumlHandle &handle, const double *input, size_t n_rows,
+                int n_cols, const double *labels, double *coef,
+                double *intercept, bool fit_intercept, int batch_size);
+/** @} */
+
 /**
  * @defgroup Functions fit a ridge regression model (l2 regularized least squares)
  * @param input         device pointer to feature matrix n_rows x n_cols
@@ -66,6 +87,59 @@ void ridgeFit(const cumlHandle &handle, double *input, int n_rows, int n_cols,
               int algo = 0);
 /** @} */
 
+/**
+ * @defgroup Functions fit the ridge regression models of a sequence of alphas,
+ * decomposing the data once
+ * @param alphas        host pointer to the parameters of the l2 regularizer
+ * @param n_alphas      number of regularization parameters
+ * @param coefs         device pointer to hold the weights of each alpha,
+ *                      n_cols x n_alphas
+ * @param intercepts    host pointer to hold the bias terms of each alpha
+ * The other parameters are those of ridgeFit.
+ * @{
+ */
+void ridgeFitPath(const cumlHandle &handle, float *input, int n_rows,
+                  int n_cols, float *labels, const float *alphas, int n_alphas,
+                  float *coefs, float *intercepts, bool fit_intercept,
+                  bool normalize, int algo = 0);
+
+void ridgeFitPath(const cumlHandle &handle, double *input, int n_rows,
+                  int n_cols, double *labels, const double *alphas,
+                  int n_alphas, double *coefs, double *intercepts,
+                  bool fit_intercept, bool normalize, int algo = 0);
+/** @} */
+
+/**
+ * @defgroup Functions fit an ordinary least squares or a ridge regression model
+ * on the rows of all the ranks of the communicator of the handle, by
+ * allreducing the Gram matrices and X^T y of the ranks
+ * @param input         device pointer to the rows of this rank, n_rows x n_cols
+ * @param n_rows        number of rows of this rank, which may be zero
+ * @param n_cols        number of columns of the feature matrix
+ * @param labels        device pointer to the labels of the rows of this rank
+ * @param alpha         the parameter of the l2 regularizer
+ * @param coef          device pointer to hold the solution for weights of size n_cols
+ * @param intercept     host pointer to hold the solution for bias term of size 1
+ * @param fit_intercept if true, fit intercept
+ * The input and the labels are restored on return, and the fit is the same
+ * on all the ranks.
+ * @{
+ */
+void olsFitMG(const cumlHandle &handle, float *input, int n_rows, int n_cols,
+              float *labels, float *coef, float *intercept,
+              bool fit_intercept);
+void olsFitMG(const cumlHandle &handle, double *input, int n_rows, int n_cols,
+              double *labels, double *coef, double *intercept,
+              bool fit_intercept);
+
+void ridgeFitMG(const cumlHandle &handle, float *input, int n_rows,
+                int n_cols, float *labels, float alpha, float *coef,
+                float *intercept, bool fit_intercept);
+void ridgeFitMG(const cumlHandle &handle, double *input, int n_rows,
+                int n_cols, double *labels, double alpha, double *coef,
+                double *intercept, bool fit_intercept);
+/** @} */
+
 /**
  * @defgroup Functions to make predictions with a fitted ordinary least squares and ridge regression model
  * @param input         device pointer to feature matrix n_rows x n_cols
@@ -90,6 +164,52 @@ void ridgePredict(const cumlHandle &handle, const double *input, int n_rows,
                   double *preds);
 /** @} */
 
+/**
+ * @defgroup Functions fit a batch of ordinary least squares and ridge
+ * regression models, all solved together
+ * @param input         device pointer to the n_batches feature matrices, each
+ *                      n_rows x n_cols (col major), stored one after the other
+ * @param n_rows        number of rows of each feature matrix
+ * @param n_cols        number of columns of each feature matrix
+ * @param n_batches     number of models
+ * @param labels        device pointer to the labels, n_rows x n_batches
+ * @param alpha         ridge regularization strength, shared by the models
+ * @param coef          device pointer to hold the weights, n_cols x n_batches
+ * @param intercept     device pointer to hold the bias terms, n_batches
+ * @param fit_intercept if true, fit intercept
+ * @param algo          specifies which solver the OLS fit uses
+ *                      (0: QR-decomposition, 1: Cholesky decomposition of the
+ *                      normal equations)
+ * @{
+ */
+void olsFitBatched(const cumlHandle &handle, float *input, int n_rows,
+                   int n_cols, int n_batches, float *labels, float *coef,
+                   float *intercept, bool fit_intercept, int algo = 0);
+void olsFitBatched(const cumlHandle &handle, double *input, int n_rows,
+                   int n_cols, int n_batches, double *labels, double *coef,
+                   double *intercept, bool fit_intercept, int algo = 0);
+
+void ridgeFitBatched(const cumlHandle &handle, float *input, int n_rows,
+                     int n_cols, int n_batches, float *labels, float alpha,
+                     float *coef, float *intercept, bool fit_intercept);
+void ridgeFitBatched(const cumlHandle &handle, double *input, int n_rows,
+                     int n_cols, int n_batches, double *labels, double alpha,
+                     double *coef, double *intercept, bool fit_intercept);
+
+/**
+ * Predictions of a batch of fitted linear models, preds (n_rows x n_batches)
+ * holding the predictions of each model on its own feature matrix.
+ */
+void linearPredictBatched(const cumlHandle &handle, const float *input,
+                          int n_rows, int n_cols, int n_batches,
+                          const float *coef, const float *intercept,
+                          float *preds);
+void linearPredictBatched(const cumlHandle &handle, const double *input,
+                          int n_rows, int n_cols, int n_batches,
+                          const double *coef, const double *intercept,
+                          double *preds);
+/** @} */
+
 /**
  * @defgroup functions to fit a GLM using quasi newton methods.
  * @param cuml_handle           reference to cumlHandle object
@@ -140,6 +260,65 @@ void qnFit(const cumlHandle &cuml_handle, double *X, double *y, int N, int D,
            bool X_col_major, int loss_type);
 /** @} */
 
+/**
+ * @defgroup functions to fit a GLM on sparse input using quasi newton methods.
+ * The parameters are as in qnFit, with the NxD feature matrix in CSR format:
+ * @param X_values              device pointer to the X_nnz values of X
+ * @param X_cols                device pointer to the X_nnz column indices of X
+ * @param X_row_ids             device pointer to the N + 1 row offsets of X
+ * @param X_nnz                 number of stored values in X
+ * @{
+ */
+void qnFitSparse(const cumlHandle &cuml_handle, float *X_values, int *X_cols,
+                 int *X_row_ids, int X_nnz, float *y, int N, int D, int C,
+                 bool fit_intercept, float l1, float l2, int max_iter,
+                 float grad_tol, int linesearch_max_iter, int lbfgs_memory,
+                 int verbosity, float *w0, float *f, int *num_iters,
+                 int loss_type);
+
+void qnFitSparse(const cumlHandle &cuml_handle, double *X_values, int *X_cols,
+                 int *X_row_ids, int X_nnz, double *y, int N, int D, int C,
+                 bool fit_intercept, double l1, double l2, int max_iter,
+                 double grad_tol, int linesearch_max_iter, int lbfgs_memory,
+                 int verbosity, double *w0, double *f, int *num_iters,
+                 int loss_type);
+/** @} */
+
+/**
+ * @defgroup functions to fit a GLM using quasi newton methods on the rows of
+ * all the ranks of the communicator of the handle. X and y hold the N rows of
+ * this rank, in dense or CSR format, and the other parameters are as in qnFit
+ * and qnFitSparse. The initial point of rank 0 is used, and the fitted
+ * parameters are the same on all the ranks.
+ * @{
+ */
+void qnFitMG(const cumlHandle &cuml_handle, float *X, float *y, int N, int D,
+             int C, bool fit_intercept, float l1, float l2, int max_iter,
+             float grad_tol, int linesearch_max_iter, int lbfgs_memory,
+             int verbosity, float *w0, float *f, int *num_iters,
+             bool X_col_major, int loss_type);
+
+void qnFitMG(const cumlHandle &cuml_handle, double *X, double *y, int N, int D,
+             int C, bool fit_intercept, double l1, double l2, int max_iter,
+             double grad_tol, int linesearch_max_iter, int lbfgs_memory,
+             int verbosity, double *w0, double *f, int *num_iters,
+             bool X_col_major, int loss_type);
+
+void qnFitSparseMG(const cumlHandle &cuml_handle, float *X_values,
+                   int *X_cols, int *X_row_ids, int X_nnz, float *y, int N,
+                   int D, int C, bool fit_intercept, float l1, float l2,
+                   int max_iter, float grad_tol, int linesearch_max_iter,
+                   int lbfgs_memory, int verbosity, float *w0, float *f,
+                   int *num_iters, int loss_type);
+
+void qnFitSparseMG(const cumlHandle &cuml_handle, double *X_values,
+                   int *X_cols, int *X_row_ids, int X_nnz, double *y, int N,
+                   int D, int C, bool fit_intercept, double l1, double l2,
+                   int max_iter, double grad_tol, int linesearch_max_iter,
+                   int lbfgs_memory, int verbosity, double *w0, double *f,
+                   int *num_iters, int loss_type);
+/** @} */
+
 /**
  * @defgroup functions to fit a GLM using quasi newton methods.
  * @param cuml_handle           reference to cumlHandle object
@@ -162,5 +341,21 @@ void qnPredict(const cumlHandle &cuml_handle, double *X, int N, int D, int C,
                int loss_type, double *preds);
 /** @} */
 
+/**
+ * @defgroup functions to predict with a GLM on input in CSR format, see
+ * qnPredict and qnFitSparse for the parameters.
+ * @{
+ */
+void qnPredictSparse(const cumlHandle &cuml_handle, float *X_values,
+                     int *X_cols, int *X_row_ids, int X_nnz, int N, int D,
+                     int C, bool fit_intercept, float *params, int loss_type,
+                     float *preds);
+
+void qnPredictSparse(const cumlHandle &cuml_handle, double *X_values,
+                     int *X_cols, int *X_row_ids, int X_nnz, int N, int D,
+                     int C, bool fit_intercept, double *params, int loss_type,
+                     double *preds);
+/** @} */
+
 }  // namespace GLM
 }  // namespace ML
@@ -20,8 +20,10 @@
 
 namespace ML {
 
+class knnIndex;
+
 /**
- * @brief Dimensionality reduction via TSNE using either Barnes Hut O(NlogN) or brute force O(N^2).
+ * @brief Dimensionality reduction via TSNE using either Barnes Hut O(NlogN), FFT-accelerated interpolation O(N) or brute force O(N^2).
  * @input param handle: The GPU handle.
  * @input param X: The dataset you want to apply TSNE on.
  * @output param Y: The final embedding. Will overwrite this internally.
@@ -46,7 +48,9 @@ namespace ML {
  * @input param random_state: Set this to -1 for pure random intializations or >= 0 for reproducible outputs.
  * @input param verbose: Whether to print error messages or not.
  * @input param intialize_embeddings: Whether to overwrite the current Y vector with random noise.
- * @input param barnes_hut: Whether to use the fast Barnes Hut or use the slower exact version.
+ * @input param barnes_hut: Whether to use the fast Barnes Hut, on a quadtree for dim == 2 and an octree for dim == 3, or use the slower exact version.
+ * @input param knn_index: Optional approximate nearest neighbors index holding the rows of X in order, created with handle, searched instead of a brute force kNN.
+ * @input param fft: Whether to compute the repulsive forces by FFT-accelerated interpolation (FIt-SNE), for dim == 2 only; overrides barnes_hut.
 
 The CUDA implementation is derived from the excellent CannyLabs open source implementation here:
 https://github.com/CannyLab/tsne-cuda/. The CannyLabs code is licensed according to the conditions in
@@ -66,6 +70,86 @@ void TSNE_fit(const cumlHandle &handle, const float *X, float *Y, const int n,
               const int max_iter = 1000, const float min_grad_norm = 1e-7,
               const float pre_momentum = 0.5, const float post_momentum = 0.8,
               const long long random_state = -1, const bool verbose = true,
-              const bool intialize_embeddings = true, bool barnes_hut = true);
+              const bool intialize_embeddings = true, bool barnes_hut = true,
+              const knnIndex *knn_index = nullptr, bool fft = false);
+
+/**
+ * @brief Dimensionality reduction via TSNE of the rows of a CSR matrix, whose kNN graph is found without densifying it.
+ * @input param handle: The GPU handle.
+ * @input param vals: The nonzero values of the CSR matrix X (nnz).
+ * @input param row_ind: The offsets of the rows of X in vals (n + 1).
+ * @input param row_ind_ptr: The column of each nonzero of X (nnz).
+ * @input param nnz: The number of nonzeros of X.
+ * @output param Y: The final embedding. Will overwrite this internally.
+ * @input param n: Number of rows in data X.
+ * @input param p: Number of columns in data X.
+ * See TSNE_fit for the other parameters; n_neighbors is at most 1024.
+ */
+void TSNE_fit_sparse(
+  const cumlHandle &handle, const float *vals, const int *row_ind,
+  const int *row_ind_ptr, const int nnz, float *Y, const int n, const int p,
+  const int dim = 2, int n_neighbors = 1023, const float theta = 0.5f,
+  const float epssq = 0.0025, float perplexity = 50.0f,
+  const int perplexity_max_iter = 100, const float perplexity_tol = 1e-5,
+  const float early_exaggeration = 12.0f, const int exaggeration_iter = 250,
+  const float min_gain = 0.01f, const float pre_learning_rate = 200.0f,
+  const float post_learning_rate = 500.0f, const int max_iter = 1000,
+  const float min_grad_norm = 1e-7, const float pre_momentum = 0.5,
+  const float post_momentum = 0.8, const long long random_state = -1,
+  const bool verbose = true, const bool intialize_embeddings = true,
+  bool barnes_hut = true, bool fft = false);
+
+/**
+ * @brief Dimensionality reduction via TSNE from a precomputed kNN graph, skipping the nearest neighbors search of TSNE_fit. Repeated runs on the same graph, as in perplexity sweeps, then only pay for the optimization.
+ * @input param handle: The GPU handle.
+ * @input param knn_indices: The indices of the n_neighbors nearest neighbors of every row (n, n_neighbors), each row included as its own nearest neighbor.
+ * @input param knn_dists: The distances to the n_neighbors nearest neighbors of every row (n, n_neighbors), sorted. Left unchanged.
+ * @output param Y: The final embedding. Will overwrite this internally.
+ * @input param n: Number of rows in the kNN graph.
+ * @input param dim: Number of output dimensions for embeddings Y.
+ * @input param n_neighbors: Number of nearest neighbors in the kNN graph, at most n.
+ * See TSNE_fit for the other parameters.
+ */
+void TSNE_fit_knn(const cumlHandle &handle, const long *knn_indices,
+                  const float *knn_dists, float *Y, const int n, const int dim,
+                  const int n_neighbors, const float theta = 0.5f,
+                  const float epssq = 0.0025, float perplexity = 50.0f,
+                  const int perplexity_max_iter = 100,
+                  const float perplexity_tol = 1e-5,
+                  const float early_exaggeration = 12.0f,
+                  const int exaggeration_iter = 250,
+                  const float min_gain = 0.01f,
+                  const float pre_learning_rate = 200.0f,
+                  const float post_learning_rate = 500.0f,
+                  const int max_iter = 1000, const float min_grad_norm = 1e-7,
+                  const float pre_momentum = 0.5,
+                  const float post_momentum = 0.8,
+                  const long long random_state = -1, const bool verbose = true,
+                  const bool intialize_embeddings = true,
+                  bool barnes_hut = true, bool fft = false);
+
+/**
+ * @brief Dimensionality reduction via Barnes Hut TSNE over the ranks of the communicator of the handle, for datasets beyond the memory of one GPU. Each rank holds a shard of the rows of X, the rows being numbered in rank order, and gets the 2D embeddings of its own rows. The kNN graph and the rows of P are split across the ranks; every rank builds the quadtree of the whole embedding, and the forces are summed over the ranks with an allreduce each iteration.
+ * @input param handle: The GPU handle, with a communicator.
+ * @input param X: The rows of X of this rank (n_local, p) in row-major.
+ * @output param Y: The final embedding of the rows of this rank (n_local, 2) in column-major.
+ * @input param n_local: Number of rows of X on this rank, at least 1.
+ * @input param p: Number of columns in data X.
+ * See TSNE_fit for the other parameters.
+ */
+void TSNE_fit_mg(const cumlHandle &handle, float *X, float *Y,
+                 const int n_local, const int p, int n_neighbors = 1023,
+                 const float theta = 0.5f, const float epssq = 0.0025,
+                 float perplexity = 50.0f, const int perplexity_max_iter = 100,
+                 const float perplexity_tol = 1e-5,
+                 const float early_exaggeration = 12.0f,
+                 const int exaggeration_iter = 250,
+                 const float min_gain = 0.01f,
+                 const float pre_learning_rate = 200.0f,
+                 const float post_learning_rate = 500.0f,
+                 const int max_iter = 1000, const float min_grad_norm = 1e-7,
+                 const float pre_momentum = 0.5,
+                 const float post_momentum = 0.8,
+                 const long long random_state = -1, const bool verbose = true);
 
 }  // namespace ML
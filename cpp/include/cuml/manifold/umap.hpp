@@ -20,6 +20,8 @@
 #include <cuml/neighbors/knn.hpp>
 #include "umapparams.h"
 
+#include <memory>
+
 namespace ML {
 
 void transform(const cumlHandle &handle, float *X, int n, int d, float *orig_X,
@@ -37,12 +39,83 @@ void fit(const cumlHandle &handle,
          int d,     // cols
          UMAPParams *params, float *embeddings);
 
+/**
+ * Fits an unsupervised UMAP model on a precomputed kNN graph of X, skipping
+ * the neighbor search. Row i of knn_indices / knn_dists (row-major, size
+ * n * params->n_neighbors) holds the params->n_neighbors nearest neighbors
+ * of row i of X, nearest first and including i itself, with their (not
+ * squared) distances. X is only read by the neighbor search, so it may be
+ * nullptr here.
+ */
+void fit(const cumlHandle &handle, float *X, int n, int d,
+         int64_t *knn_indices, float *knn_dists, UMAPParams *params,
+         float *embeddings);
+
+/**
+ * Fits a supervised UMAP model on a precomputed kNN graph of X; see the
+ * unsupervised overload for the layout of knn_indices / knn_dists.
+ */
+void fit(const cumlHandle &handle, float *X, float *y, int n, int d,
+         int64_t *knn_indices, float *knn_dists, UMAPParams *params,
+         float *embeddings);
+
+/**
+ * Fits an unsupervised UMAP model on a CSR matrix, whose kNN graph is
+ * searched without densifying it.
+ * @param vals        nonzero values of the CSR matrix (nnz)
+ * @param row_ind     offsets of the rows in vals (n + 1)
+ * @param row_ind_ptr col of each nonzero value (nnz)
+ * @param nnz         number of nonzero values
+ * @param n           n_samples of the CSR matrix
+ * @param d           d_features of the CSR matrix
+ * @param params      UMAP settings; params->knn_index must be nullptr
+ * @param embeddings  output embeddings of size (n_samples, n_components)
+ */
+void fit_sparse(const cumlHandle &handle, const float *vals,
+                const int *row_ind, const int *row_ind_ptr, int nnz, int n,
+                int d, UMAPParams *params, float *embeddings);
+
+/**
+ * Fits a supervised UMAP model on a CSR matrix; y holds the labels, of
+ * shape=n_samples. See the unsupervised fit_sparse for the other params.
+ */
+void fit_sparse(const cumlHandle &handle, const float *vals,
+                const int *row_ind, const int *row_ind_ptr, int nnz, float *y,
+                int n, int d, UMAPParams *params, float *embeddings);
+
+/**
+ * Projects the rows of the CSR matrix (vals, row_ind, row_ind_ptr) into the
+ * embedding of the CSR matrix (orig_vals, orig_row_ind, orig_row_ind_ptr)
+ * fitted with fit_sparse. n and orig_n are their rows, d their common cols,
+ * and transformed is of size (n, n_components).
+ */
+void transform_sparse(const cumlHandle &handle, const float *vals,
+                      const int *row_ind, const int *row_ind_ptr, int n, int d,
+                      const float *orig_vals, const int *orig_row_ind,
+                      const int *orig_row_ind_ptr, int orig_nnz, int orig_n,
+                      float *embedding, int embedding_n, UMAPParams *params,
+                      float *transformed);
+
+/**
+ * Fits an unsupervised UMAP model over the ranks of the communicator of
+ * handle. Each rank holds n > 0 rows of X, the rows being numbered in rank
+ * order, and gets the embeddings of its own rows (n, n_components). The kNN
+ * graph, the fuzzy simplicial set and the optimization of the embeddings
+ * are split by rows across the ranks; the embedding is initialized at
+ * random whatever params->init.
+ */
+void fit_mg(const cumlHandle &handle, float *X, int n, int d,
+            UMAPParams *params, float *embeddings);
+
 class UMAP_API {
   float *orig_X;
   int orig_n;
   cumlHandle *handle;
   UMAPParams *params;
 
+  struct FuzzyGraph;
+  std::unique_ptr<FuzzyGraph> graph;
+
  public:
   UMAP_API(const cumlHandle &handle, UMAPParams *params);
   ~UMAP_API();
@@ -75,6 +148,65 @@ class UMAP_API {
    */
   void fit(float *X, float *y, int n, int d, float *embeddings);
 
+  /**
+   * Fits an unsupervised UMAP model on a precomputed kNN graph of X
+   * @param X
+   *        pointer to an array in row-major format (note: this will be col-major soon)
+   * @param n
+   *        n_samples in X
+   * @param d
+   *        d_features in X
+   * @param knn_indices
+   *        the n_neighbors nearest neighbors of each row of X, including
+   *        itself and nearest first, shape=(n_samples, n_neighbors)
+   * @param knn_dists
+   *        the distances to knn_indices, shape=(n_samples, n_neighbors)
+   * @param embeddings
+   *        an array to return the output embeddings of size (n_samples, n_components)
+   */
+  void fit(float *X, int n, int d, int64_t *knn_indices, float *knn_dists,
+           float *embeddings);
+
+  /**
+   * Fits a supervised UMAP model on a precomputed kNN graph of X; see the
+   * unsupervised overload for knn_indices and knn_dists.
+   */
+  void fit(float *X, float *y, int n, int d, int64_t *knn_indices,
+           float *knn_dists, float *embeddings);
+
+  /**
+   * Builds the fuzzy simplicial set of X and keeps it, for fit_embedding to
+   * embed it with different embedding settings. Only the kNN and graph
+   * settings of the UMAPParams instance (n_neighbors, local_connectivity,
+   * set_op_mix_ratio, ...) are read here.
+   * @param X
+   *        pointer to an array in row-major format (note: this will be col-major soon)
+   * @param n
+   *        n_samples in X
+   * @param d
+   *        d_features in X
+   */
+  void fit_graph(float *X, int n, int d);
+
+  /**
+   * Builds and keeps the fuzzy simplicial set of X intersected with the
+   * simplicial set of the labels y, of shape=n_samples; see the unsupervised
+   * overload.
+   */
+  void fit_graph(float *X, float *y, int n, int d);
+
+  /**
+   * Embeds the fuzzy simplicial set kept by the last fit_graph, skipping the
+   * kNN graph and the fuzzy simplicial set. May be called any number of
+   * times, each with its own embedding settings.
+   * @param embed_params
+   *        the embedding settings (min_dist, spread, n_components, n_epochs,
+   *        init, ...); its kNN and graph settings are ignored
+   * @param embeddings
+   *        an array to return the output embeddings of size (n_samples, n_components)
+   */
+  void fit_embedding(UMAPParams *embed_params, float *embeddings);
+
   /**
    * Project a set of X vectors into the embedding space.
    * @param X
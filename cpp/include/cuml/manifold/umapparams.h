@@ -23,6 +23,8 @@ namespace ML {
 
 using namespace ML::Internals;
 
+class knnIndex;
+
 class UMAPParams {
  public:
   enum MetricType { EUCLIDEAN, CATEGORICAL };
@@ -109,6 +111,15 @@ class UMAPParams {
    */
   float transform_queue_size = 4.0;
 
+  /**
+   *  Number of rows transformed at a time, each batch going through the
+   *  kNN search, the fuzzy simplicial set and the optimization on its own
+   *  so that the memory used does not grow with the rows to transform. The
+   *  batches are spread over the internal streams of the handle. Set this
+   *  to 0 to transform all the rows at once.
+   */
+  int transform_batch_size = 0;
+
   /**
    * Print debug logging information as algorithm executes
    */
@@ -151,6 +162,29 @@ class UMAPParams {
   float target_weights = 0.5;
 
   GraphBasedDimRedCallback* callback = nullptr;
+
+  /**
+   *  Run the epochs of the embedding optimization without atomics: the edges
+   *  are grouped by vertex, each vertex gathers its gradients of an epoch
+   *  and they are all applied at the end of the epoch. This avoids the
+   *  contention on the hub vertices and, with a random_state >= 0, gives
+   *  reproducible embeddings.
+   */
+  bool deterministic = false;
+
+  /**
+   *  Seed of the random initialization and of the negative sampling. Set
+   *  this to -1 for seeds from the clock, or >= 0 for reproducible draws.
+   */
+  long long random_state = -1;
+
+  /**
+   *  Approximate nearest neighbors index searched for the k nearest
+   *  neighbors instead of a brute force search; not owned. It must hold the
+   *  rows of X (fit) or orig_X (transform), in order, and use the handle of
+   *  the UMAP calls.
+   */
+  knnIndex* knn_index = nullptr;
 };
 
 }  // namespace ML
@@ -58,6 +58,23 @@ float r2_score_py(const cumlHandle &handle, float *y, float *y_hat, int n);
 */
 double r2_score_py(const cumlHandle &handle, double *y, double *y_hat, int n);
 
+/**
+* Calculates the R-Squared scores of many models predicting the same
+* ground truth, in a single segmented reduction
+*
+* @param handle: cumlHandle
+* @param scores: Device array of the n_models R-squared values
+* @param y: Array of ground-truth response variables
+* @param y_hat: Row major array of the n_models x n predictions
+* @param n_models: Number of models
+* @param n: Number of elements in y and in each row of y_hat
+*/
+void batched_r2_score(const cumlHandle &handle, float *scores, const float *y,
+                      const float *y_hat, int n_models, int n);
+void batched_r2_score(const cumlHandle &handle, double *scores,
+                      const double *y, const double *y_hat, int n_models,
+                      int n);
+
 /**
 * Calculates the "rand index"
 *
@@ -237,6 +254,37 @@ double vMeasure(const cumlHandle &handle, const int *y, const int *y_hat,
                 const int n, const int lower_class_range,
                 const int upper_class_range);
 
+/**
+* The scores of a clustering against the truth labels, see clusteringScores
+*/
+struct ClusteringScores {
+  double adjustedRandIndex;
+  double mutualInfo;
+  double homogeneity;
+  double completeness;
+  double vMeasure;
+};
+
+/**
+* Calculates the "adjusted rand index", the "Mutual Information score", the
+* "homogeneity score", the "completeness score" and the "v-measure" at once
+*
+* The contingency matrix and its marginals, which all of these metrics derive
+* from, are only computed once.
+*
+* @param handle: cumlHandle
+* @param y: truth labels
+* @param y_hat: predicted labels
+* @param n: Number of elements in y and y_hat
+* @param lower_class_range: the lowest value in the range of classes
+* @param upper_class_range: the highest value in the range of classes
+* @return: The scores
+*/
+ClusteringScores clusteringScores(const cumlHandle &handle, const int *y,
+                                  const int *y_hat, const int n,
+                                  const int lower_class_range,
+                                  const int upper_class_range);
+
 /**
 * Calculates the "accuracy" between two input numpy arrays/ cudf series
 *
@@ -251,5 +299,70 @@ double vMeasure(const cumlHandle &handle, const int *y, const int *y_hat,
 */
 float accuracy_score_py(const cumlHandle &handle, const int *predictions,
                         const int *ref_predictions, int n);
+
+/**
+* Calculates the accuracies of many models predicting the same labels, in a
+* single segmented reduction
+*
+* @param handle: cumlHandle
+* @param scores: Device array of the n_models accuracies
+* @param predictions: Row major array of the n_models x n predicted labels
+* @param ref_predictions: truth labels
+* @param n_models: Number of models
+* @param n: Number of elements in ref_predictions and in each row of
+* predictions
+*/
+void batched_accuracy_score(const cumlHandle &handle, float *scores,
+                            const int *predictions, const int *ref_predictions,
+                            int n_models, int n);
+
+/**
+* Calculates the confusion matrix of predicted labels against the truth
+*
+* @param handle: cumlHandle
+* @param out: Device array of the row major confusion matrix, of n_classes x
+* n_classes with n_classes = upper_class_range - lower_class_range + 1; its
+* entry (i, j) counts the samples of true class i predicted as class j
+* @param y: truth labels
+* @param y_hat: predicted labels
+* @param n: Number of elements in y and y_hat
+* @param lower_class_range: the lowest value in the range of classes
+* @param upper_class_range: the highest value in the range of classes
+*/
+void confusion_matrix(const cumlHandle &handle, int *out, const int *y,
+                      const int *y_hat, int n, int lower_class_range,
+                      int upper_class_range);
+
+/**
+* Calculates the area under the ROC curve of the scores of a binary
+* classifier, with ties between scores linearly interpolated
+*
+* @param handle: cumlHandle
+* @param y: binary truth labels, nonzero for the positive class
+* @param y_score: scores of the samples, higher for the positive class
+* @param n: Number of elements in y and y_score
+* @return: The ROC AUC score
+*/
+double roc_auc_score(const cumlHandle &handle, const int *y,
+                     const float *y_score, int n);
+double roc_auc_score(const cumlHandle &handle, const int *y,
+                     const double *y_score, int n);
+
+/**
+* Calculates the log loss, the mean negative log-likelihood of the truth
+* labels under the predicted probabilities clipped to [eps, 1 - eps]
+*
+* @param handle: cumlHandle
+* @param y: truth labels, in [0, n_classes)
+* @param probs: row major predicted probabilities, of n x n_classes
+* @param n: Number of elements in y
+* @param n_classes: Number of classes
+* @param eps: clipping bound of the probabilities
+* @return: The log loss
+*/
+double log_loss(const cumlHandle &handle, const int *y, const float *probs,
+                int n, int n_classes, double eps = 1e-15);
+double log_loss(const cumlHandle &handle, const int *y, const double *probs,
+                int n, int n_classes, double eps = 1e-15);
 }  // namespace Metrics
 }  // namespace ML
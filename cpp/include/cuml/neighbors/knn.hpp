@@ -17,9 +17,25 @@
 #pragma once
 
 #include <common/cumlHandle.hpp>
+#include <cstdint>
+#include <vector>
 
 namespace ML {
 
+/** Metrics of brute_force_knn */
+enum MetricType {
+  /** L2 distance */
+  METRIC_L2,
+  /** inner product; a similarity, the neighbors have the largest ones */
+  METRIC_INNER_PRODUCT,
+  /** cosine distance, 1 - cosine similarity */
+  METRIC_COSINE,
+  /** L1 distance */
+  METRIC_L1,
+  /** Minkowski distance, (sum |x_i - y_i|^p)^(1/p) */
+  METRIC_MINKOWSKI
+};
+
 /**
    * @brief Flat C++ API function to perform a brute force knn on
    * a series of input arrays and combine the results into a single
@@ -36,11 +52,94 @@ namespace ML {
    * @param k the number of nearest neighbors to return
    * @param rowMajorIndex are the index arrays in row-major order?
    * @param rowMajorQuery are the query arrays in row-major order?
+   * @param metric distance metric; res_D holds the inner products, largest
+   *        first, for METRIC_INNER_PRODUCT
+   * @param p exponent of METRIC_MINKOWSKI
    */
 void brute_force_knn(cumlHandle &handle, std::vector<float *> &input,
                      std::vector<int> &sizes, int D, float *search_items, int n,
                      int64_t *res_I, float *res_D, int k,
-                     bool rowMajorIndex = false, bool rowMajorQuery = false);
+                     bool rowMajorIndex = false, bool rowMajorQuery = false,
+                     MetricType metric = METRIC_L2, float p = 2.0f);
+
+/**
+ * @brief Brute force knn over an index sharded across the ranks of the
+ * communicator of handle.
+ *
+ * Each rank holds its own partitions of the index and the same queries,
+ * and ends up with the neighbors among all the ranks. The index rows are
+ * numbered in rank order, then in the order of the partitions of each
+ * rank. The per rank neighbors are gathered on all the ranks and merged, a
+ * tile of queries at a time to bound the memory.
+ *
+ * @param handle the cuml handle to use, with a communicator
+ * @param input vector of pointers to the input arrays of this rank
+ * @param sizes vector of sizes of input arrays
+ * @param D the dimensionality of the arrays
+ * @param search_items array of items to search of dimensionality D
+ * @param n number of rows in search_items
+ * @param res_I the resulting index array of size n * k
+ * @param res_D the resulting distance array of size n * k
+ * @param k the number of nearest neighbors to return
+ * @param rowMajorIndex are the index arrays in row-major order?
+ * @param rowMajorQuery are the query arrays in row-major order?
+ * @param metric distance metric; res_D holds the inner products, largest
+ *        first, for METRIC_INNER_PRODUCT
+ * @param p exponent of METRIC_MINKOWSKI
+ */
+void brute_force_knn_mg(cumlHandle &handle, std::vector<float *> &input,
+                        std::vector<int> &sizes, int D, float *search_items,
+                        int n, int64_t *res_I, float *res_D, int k,
+                        bool rowMajorIndex = false, bool rowMajorQuery = false,
+                        MetricType metric = METRIC_L2, float p = 2.0f);
+
+/**
+ * @brief First pass of the radius neighbors graph of search_items: the CSR
+ * row offsets of the index rows within L2 distance eps of each item. The
+ * caller sizes the second pass with row_ind[n], the number of edges.
+ *
+ * @param handle the cuml handle to use
+ * @param input array of the n_index index rows of dimensionality D
+ * @param n_index number of rows in input
+ * @param D the dimensionality of the arrays
+ * @param search_items array of items to search of dimensionality D
+ * @param n number of rows in search_items
+ * @param eps radius of the neighborhoods
+ * @param row_ind the resulting n + 1 row offsets
+ * @param rowMajorIndex is input in row-major order?
+ * @param rowMajorQuery is search_items in row-major order?
+ */
+void radius_neighbors_row_ind(const cumlHandle &handle, const float *input,
+                              int n_index, int D, const float *search_items,
+                              int n, float eps, int *row_ind,
+                              bool rowMajorIndex = false,
+                              bool rowMajorQuery = false);
+
+/**
+ * @brief Second pass of the radius neighbors graph of search_items: the
+ * index rows within L2 distance eps of each item, in ascending order, and
+ * their distances. The distances are computed in tiles on the fly, so the
+ * graph takes memory proportional to its number of edges only.
+ *
+ * @param handle the cuml handle to use
+ * @param input array of the n_index index rows of dimensionality D
+ * @param n_index number of rows in input
+ * @param D the dimensionality of the arrays
+ * @param search_items array of items to search of dimensionality D
+ * @param n number of rows in search_items
+ * @param eps radius of the neighborhoods
+ * @param row_ind the row offsets from radius_neighbors_row_ind
+ * @param col_ind the resulting index rows, of row_ind[n] elements
+ * @param vals the resulting distances, of row_ind[n] elements
+ * @param rowMajorIndex is input in row-major order?
+ * @param rowMajorQuery is search_items in row-major order?
+ */
+void radius_neighbors_graph(const cumlHandle &handle, const float *input,
+                            int n_index, int D, const float *search_items,
+                            int n, float eps, const int *row_ind,
+                            int *col_ind, float *vals,
+                            bool rowMajorIndex = false,
+                            bool rowMajorQuery = false);
 
 /**
  * @brief Flat C++ API function to perform a knn classification using a
@@ -90,6 +189,244 @@ void knn_class_proba(cumlHandle &handle, std::vector<float *> &out,
                      int64_t *knn_indices, std::vector<int *> &y,
                      size_t n_samples, int k);
 
+/**
+ * @brief Search and classify in one pass: brute_force_knn followed by
+ * knn_classify, with the labels of the neighbors voted while merging the
+ * partitions, so the neighbors of the queries are never written out.
+ *
+ * @param handle the cuml handle to use
+ * @param out output array on device (size n * size of y vector)
+ * @param input vector of pointers to the input arrays
+ * @param sizes vector of sizes of input arrays
+ * @param D the dimensionality of the arrays
+ * @param search_items array of items to search of dimensionality D
+ * @param n number of rows in search_items
+ * @param k number of nearest neighbors
+ * @param y vector of label arrays on device of the rows of input, in the
+ *        order of the partitions
+ * @param rowMajorIndex are the index arrays in row-major order?
+ * @param rowMajorQuery are the query arrays in row-major order?
+ */
+void brute_force_knn_classify(cumlHandle &handle, int *out,
+                              std::vector<float *> &input,
+                              std::vector<int> &sizes, int D,
+                              float *search_items, int n, int k,
+                              std::vector<int *> &y, bool rowMajorIndex = false,
+                              bool rowMajorQuery = false);
+
+/**
+ * @brief Search and regress in one pass: brute_force_knn followed by
+ * knn_regress, with the labels of the neighbors averaged while merging the
+ * partitions.
+ *
+ * @param handle the cuml handle to use
+ * @param out output array on device (size n * size of y vector)
+ * @param input vector of pointers to the input arrays
+ * @param sizes vector of sizes of input arrays
+ * @param D the dimensionality of the arrays
+ * @param search_items array of items to search of dimensionality D
+ * @param n number of rows in search_items
+ * @param k number of nearest neighbors
+ * @param y vector of label arrays on device of the rows of input, in the
+ *        order of the partitions
+ * @param rowMajorIndex are the index arrays in row-major order?
+ * @param rowMajorQuery are the query arrays in row-major order?
+ */
+void brute_force_knn_regress(cumlHandle &handle, float *out,
+                             std::vector<float *> &input,
+                             std::vector<int> &sizes, int D,
+                             float *search_items, int n, int k,
+                             std::vector<float *> &y,
+                             bool rowMajorIndex = false,
+                             bool rowMajorQuery = false);
+
+/**
+ * @brief Search and compute class probabilities in one pass:
+ * brute_force_knn followed by knn_class_proba, with the labels of the
+ * neighbors counted while merging the partitions.
+ *
+ * @param handle the cuml handle to use
+ * @param out vector of output arrays on device. vector size = n_outputs.
+ * Each array should have size(n, n_classes)
+ * @param input vector of pointers to the input arrays
+ * @param sizes vector of sizes of input arrays
+ * @param D the dimensionality of the arrays
+ * @param search_items array of items to search of dimensionality D
+ * @param n number of rows in search_items
+ * @param k number of nearest neighbors
+ * @param y vector of label arrays on device of the rows of input, in the
+ *        order of the partitions
+ * @param rowMajorIndex are the index arrays in row-major order?
+ * @param rowMajorQuery are the query arrays in row-major order?
+ */
+void brute_force_knn_class_proba(cumlHandle &handle, std::vector<float *> &out,
+                                 std::vector<float *> &input,
+                                 std::vector<int> &sizes, int D,
+                                 float *search_items, int n, int k,
+                                 std::vector<int *> &y,
+                                 bool rowMajorIndex = false,
+                                 bool rowMajorQuery = false);
+
+/**
+ * @brief Distributed brute_force_knn_classify: the index and its labels are
+ * sharded across the ranks of the communicator of handle, each rank holding
+ * the labels of its own rows, and all the ranks have the same queries.
+ *
+ * Each rank searches its partitions, then the ranks exchange the distances
+ * and the labels of their local neighbors of a tile of queries at a time,
+ * never the index rows nor the whole label arrays, and vote over the merged
+ * neighbors. All the ranks end up with the same predictions.
+ *
+ * @param handle the cuml handle to use, with a communicator
+ * @param out output array on device (size n * size of y vector)
+ * @param input vector of pointers to the input arrays of this rank
+ * @param sizes vector of sizes of input arrays
+ * @param D the dimensionality of the arrays
+ * @param search_items array of items to search of dimensionality D
+ * @param n number of rows in search_items
+ * @param k number of nearest neighbors
+ * @param y vector of label arrays on device of the rows of input of this
+ *        rank, in the order of the partitions
+ * @param rowMajorIndex are the index arrays in row-major order?
+ * @param rowMajorQuery are the query arrays in row-major order?
+ */
+void brute_force_knn_classify_mg(cumlHandle &handle, int *out,
+                                 std::vector<float *> &input,
+                                 std::vector<int> &sizes, int D,
+                                 float *search_items, int n, int k,
+                                 std::vector<int *> &y,
+                                 bool rowMajorIndex = false,
+                                 bool rowMajorQuery = false);
+
+/**
+ * @brief Distributed brute_force_knn_regress, see
+ * brute_force_knn_classify_mg: the labels of the neighbors among all the
+ * ranks are averaged.
+ *
+ * @param handle the cuml handle to use, with a communicator
+ * @param out output array on device (size n * size of y vector)
+ * @param input vector of pointers to the input arrays of this rank
+ * @param sizes vector of sizes of input arrays
+ * @param D the dimensionality of the arrays
+ * @param search_items array of items to search of dimensionality D
+ * @param n number of rows in search_items
+ * @param k number of nearest neighbors
+ * @param y vector of label arrays on device of the rows of input of this
+ *        rank, in the order of the partitions
+ * @param rowMajorIndex are the index arrays in row-major order?
+ * @param rowMajorQuery are the query arrays in row-major order?
+ */
+void brute_force_knn_regress_mg(cumlHandle &handle, float *out,
+                                std::vector<float *> &input,
+                                std::vector<int> &sizes, int D,
+                                float *search_items, int n, int k,
+                                std::vector<float *> &y,
+                                bool rowMajorIndex = false,
+                                bool rowMajorQuery = false);
+
+enum knnIndexType {
+  /** inverted file index: the vectors are assigned to the nearest of
+      n_lists k-means centroids, and a query only scans the vectors of its
+      n_probes nearest centroids */
+  IVF_FLAT,
+  /** same as IVF_FLAT, but the vectors are stored as pq_m codes of pq_bits
+      bits each (product quantization), and the distances are approximate */
+  IVF_PQ
+};
+
+struct knnIndexParams {
+  knnIndexType type = IVF_FLAT;
+  /** number of inverted lists, i.e. of k-means centroids */
+  int n_lists = 1024;
+  /** number of inverted lists scanned per query; n_lists gives exact
+      results for IVF_FLAT */
+  int n_probes = 32;
+  /** IVF_PQ: number of sub-quantizers; must divide D */
+  int pq_m = 8;
+  /** IVF_PQ: number of bits of each code; 8 is supported on the GPU */
+  int pq_bits = 8;
+};
+
+struct knnIndexImpl;
+
+/**
+ * Approximate nearest neighbors index over row-major float vectors, built
+ * once and queried many times; wraps the FAISS GPU IVF indexes. The results
+ * of search() are in the format of brute_force_knn(), so they can be passed
+ * to knn_classify() and friends, and an index over the fitted rows can be
+ * used by UMAP (UMAPParams::knn_index) and TSNE_fit().
+ */
+class knnIndex {
+  cumlHandle *handle;
+  int D;
+  knnIndexParams params;
+  knnIndexImpl *impl;
+
+ public:
+  /**
+   * Create an empty index.
+   * @param handle the cuml handle to use; its stream is used by all the
+   *        calls on the index
+   * @param D      number of features in each vector
+   * @param params parameters of the index
+   */
+  knnIndex(const cumlHandle &handle, int D, const knnIndexParams &params);
+  knnIndex(const knnIndex &) = delete;
+  knnIndex &operator=(const knnIndex &) = delete;
+  ~knnIndex();
+
+  /**
+   * Train the index on input (a sample of it is used for k-means) and add
+   * the vectors of input, with ids 0 to n - 1; previous vectors are removed.
+   * @param input row-major array of n vectors on device
+   * @param n     number of vectors in input
+   */
+  void build(const float *input, int n);
+
+  /**
+   * Add the vectors of input to a built index, with ids following those of
+   * the vectors already in it.
+   * @param input row-major array of n vectors on device
+   * @param n     number of vectors in input
+   */
+  void add(const float *input, int n);
+
+  /**
+   * Search the index for the k (approximately) nearest neighbors of a set
+   * of query vectors.
+   * @param search_items row-major array of n query vectors on device
+   * @param n            number of items in search_items
+   * @param res_I        device array of size n * k for the neighbor ids
+   * @param res_D        device array of size n * k for the L2 distances
+   * @param k            number of neighbors to query
+   */
+  void search(const float *search_items, int n, int64_t *res_I, float *res_D,
+              int k) const;
+
+  /** Set the number of inverted lists scanned per query. */
+  void set_n_probes(int n_probes);
+
+  /** Number of vectors in the index. */
+  int64_t size() const;
+
+  /** Number of features of the vectors of the index. */
+  int dim() const { return D; }
+
+  /**
+   * Write the index into *pbytes (previous contents replaced), in the FAISS
+   * serialization format of the equivalent CPU index.
+   */
+  void save(std::vector<char> *pbytes) const;
+
+  /**
+   * Replace the index by one written by save(), which must have D features;
+   * the parameters of the index are updated from it.
+   * @param bytes the saved index, in host memory
+   * @param size  size of bytes, in bytes
+   */
+  void load(const void *bytes, size_t size);
+};
+
 class kNN {
   float **ptrs;
   int *sizes;
@@ -45,6 +45,42 @@ cumlError_t knn_search(const cumlHandle_t handle, float **input, int *size,
                        int64_t *res_I, float *res_D, int k, bool rowMajorIndex,
                        bool rowMajorQuery);
 
+/**
+   * @brief knn_search which returns once the search is enqueued on the
+   * stream of the handle. The partitions of the index are searched in turn
+   * on that stream, as the internal streams of the handle would synchronize
+   * the host.
+   *
+   * @param event if not NULL, recorded on the stream of the handle after the
+   * search, for the caller to query or synchronize with
+   * See knn_search for the other params
+   */
+cumlError_t knn_search_async(const cumlHandle_t handle, float **input,
+                             int *sizes, int n_params, int D,
+                             float *search_items, int n, int64_t *res_I,
+                             float *res_D, int k, bool rowMajorIndex,
+                             bool rowMajorQuery, cudaEvent_t event);
+
+/**
+   * @brief knn_search_async of n_queries query arrays in the same index, the
+   * results of search_items[q] of n[q] rows going to res_I[q] and res_D[q],
+   * so that a service pays for one call and one event per group of requests
+   *
+   * @param n_queries number of query arrays
+   * @param search_items host array of the query arrays (dim = n_queries)
+   * @param n host array of the numbers of rows of the queries
+   * @param res_I host array of the index arrays, each of size n[q] * k
+   * @param res_D host array of the distance arrays, each of size n[q] * k
+   * @param event if not NULL, recorded after the last query
+   * See knn_search for the other params
+   */
+cumlError_t knn_search_batch_async(const cumlHandle_t handle, float **input,
+                                   int *sizes, int n_params, int D,
+                                   int n_queries, float **search_items,
+                                   const int *n, int64_t **res_I,
+                                   float **res_D, int k, bool rowMajorIndex,
+                                   bool rowMajorQuery, cudaEvent_t event);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1 +1,50 @@
-int sweet_knn(int arg1, int arg2, int arg3, int arg4, int arg5, int arg6, float *arg7, float *arg8, int64_t *res_I, float *res_D);
\ No newline at end of file
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <common/cumlHandle.hpp>
+#include <cstdint>
+
+namespace ML {
+
+/**
+ * @brief Exact L2 kNN search with triangle inequality pruning (Sweet KNN).
+ *
+ * The index rows are clustered around representatives, and the distances
+ * to the representatives bound those to the queries, so most of the index
+ * rows are never compared to a query. This pays off for data with few
+ * dimensions; brute_force_knn() selects it automatically when it does.
+ *
+ * @param handle the cuml handle to use
+ * @param index the index rows, of n_index rows and D cols
+ * @param n_index number of rows in index, at most INT_MAX
+ * @param search_items the rows to query, of n rows and D cols
+ * @param n number of rows in search_items
+ * @param D the dimensionality of the rows
+ * @param res_I the resulting index array of size n * k
+ * @param res_D the resulting distance array of size n * k
+ * @param k the number of nearest neighbors to return, at most 1024
+ * @param rowMajorIndex is index in row-major order?
+ * @param rowMajorQuery is search_items in row-major order?
+ * @param n_reps number of representatives; when this is <= 0, sqrt(n_index)
+ */
+void sweet_knn(const cumlHandle &handle, const float *index, int64_t n_index,
+               const float *search_items, int64_t n, int D, int64_t *res_I,
+               float *res_D, int k, bool rowMajorIndex = false,
+               bool rowMajorQuery = false, int n_reps = 0);
+
+};  // namespace ML
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuml/cuml.hpp>
+#include <vector>
+
+namespace ML {
+namespace Preprocessing {
+
+/**
+ * @defgroup Preprocessing
+ * @{
+ * @brief Scalers, encoders and binning of features on the GPU, the
+ * equivalents of sklearn.preprocessing's StandardScaler, MinMaxScaler,
+ * OrdinalEncoder, OneHotEncoder and KBinsDiscretizer.
+ *
+ * The input is a column-major matrix of n_rows samples and n_cols features.
+ * The transforms write their output in a single pass, column-major or, with
+ * out_row_major, row-major, so that it is directly in the layout of the
+ * algorithm that consumes it. The fitted state lives on the device, except the
+ * categories of the encoders, whose number is only known after the fit.
+ */
+
+/** Strategies of the bin edges of kBinsDiscretizerFit */
+enum KBinsStrategy {
+  /** bins of equal width between the min and the max of the feature */
+  KBINS_UNIFORM = 0,
+  /** bins of (about) equal population, the edges being the quantiles of the
+   * feature, interpolated linearly as numpy.percentile does */
+  KBINS_QUANTILE = 1
+};
+
+/**
+ * @brief Fit a standard scaler: the mean and the standard deviation of each
+ * feature
+ * @param[in]  handle    cuML handle
+ * @param[in]  X         input matrix (col-major, n_rows x n_cols)
+ * @param[in]  n_rows    number of samples
+ * @param[in]  n_cols    number of features
+ * @param[out] mean      device array of the means (dim = n_cols)
+ * @param[out] scale     device array of the population standard deviations
+ *                       (dim = n_cols), 1 for the constant features or
+ *                       without with_std
+ * @param[in]  with_std  whether to scale to unit variance
+ */
+void standardScalerFit(const cumlHandle& handle, const float* X, int n_rows,
+                       int n_cols, float* mean, float* scale,
+                       bool with_std = true);
+void standardScalerFit(const cumlHandle& handle, const double* X, int n_rows,
+                       int n_cols, double* mean, double* scale,
+                       bool with_std = true);
+
+/**
+ * @brief Standardize the features: out = (X - mean) / scale
+ * @param[in]  handle         cuML handle
+ * @param[in]  X              input matrix (col-major, n_rows x n_cols)
+ * @param[in]  n_rows         number of samples
+ * @param[in]  n_cols         number of features
+ * @param[in]  mean           device array of the means (dim = n_cols)
+ * @param[in]  scale          device array of the scales (dim = n_cols)
+ * @param[in]  with_mean      whether to center the features
+ * @param[in]  with_std       whether to scale the features
+ * @param[out] out            output matrix (n_rows x n_cols), which can be X
+ *                            unless out_row_major
+ * @param[in]  out_row_major  whether out is row-major
+ */
+void standardScalerTransform(const cumlHandle& handle, const float* X,
+                             int n_rows, int n_cols, const float* mean,
+                             const float* scale, bool with_mean, bool with_std,
+                             float* out, bool out_row_major = false);
+void standardScalerTransform(const cumlHandle& handle, const double* X,
+                             int n_rows, int n_cols, const double* mean,
+                             const double* scale, bool with_mean,
+                             bool with_std, double* out,
+                             bool out_row_major = false);
+
+/**
+ * @brief standardScalerFit then standardScalerTransform, see them for the
+ * params
+ */
+void standardScalerFitTransform(const cumlHandle& handle, const float* X,
+                                int n_rows, int n_cols, float* mean,
+                                float* scale, bool with_mean, bool with_std,
+                                float* out, bool out_row_major = false);
+void standardScalerFitTransform(const cumlHandle& handle, const double* X,
+                                int n_rows, int n_cols, double* mean,
+                                double* scale, bool with_mean, bool with_std,
+                                double* out, bool out_row_major = false);
+
+/**
+ * @brief Fit a min-max scaler: the min and the max of each feature, ignoring
+ * the NaNs
+ * @param[in]  handle    cuML handle
+ * @param[in]  X         input matrix (col-major, n_rows x n_cols)
+ * @param[in]  n_rows    number of samples
+ * @param[in]  n_cols    number of features
+ * @param[out] data_min  device array of the mins (dim = n_cols)
+ * @param[out] data_max  device array of the maxs (dim = n_cols)
+ */
+void minMaxScalerFit(const cumlHandle& handle, const float* X, int n_rows,
+                     int n_cols, float* data_min, float* data_max);
+void minMaxScalerFit(const cumlHandle& handle, const double* X, int n_rows,
+                     int n_cols, double* data_min, double* data_max);
+
+/**
+ * @brief Scale the features to [feature_min, feature_max]:
+ * out = (X - data_min) / (data_max - data_min) * (feature_max - feature_min)
+ *       + feature_min, the constant features being mapped to feature_min
+ * @param[in]  handle         cuML handle
+ * @param[in]  X              input matrix (col-major, n_rows x n_cols)
+ * @param[in]  n_rows         number of samples
+ * @param[in]  n_cols         number of features
+ * @param[in]  data_min       device array of the mins (dim = n_cols)
+ * @param[in]  data_max       device array of the maxs (dim = n_cols)
+ * @param[in]  feature_min    min of the scaled features
+ * @param[in]  feature_max    max of the scaled features
+ * @param[out] out            output matrix (n_rows x n_cols), which can be X
+ *                            unless out_row_major
+ * @param[in]  out_row_major  whether out is row-major
+ */
+void minMaxScalerTransform(const cumlHandle& handle, const float* X,
+                           int n_rows, int n_cols, const float* data_min,
+                           const float* data_max, float feature_min,
+                           float feature_max, float* out,
+                           bool out_row_major = false);
+void minMaxScalerTransform(const cumlHandle& handle, const double* X,
+                           int n_rows, int n_cols, const double* data_min,
+                           const double* data_max, double feature_min,
+                           double feature_max, double* out,
+                           bool out_row_major = false);
+
+/**
+ * @brief minMaxScalerFit then minMaxScalerTransform, see them for the params
+ */
+void minMaxScalerFitTransform(const cumlHandle& handle, const float* X,
+                              int n_rows, int n_cols, float* data_min,
+                              float* data_max, float feature_min,
+                              float feature_max, float* out,
+                              bool out_row_major = false);
+void minMaxScalerFitTransform(const cumlHandle& handle, const double* X,
+                              int n_rows, int n_cols, double* data_min,
+                              double* data_max, double feature_min,
+                              double feature_max, double* out,
+                              bool out_row_major = false);
+
+/**
+ * @brief Fit an ordinal or one-hot encoder: the sorted unique values of each
+ * feature, which shall not contain NaNs
+ * @param[in]  handle      cuML handle
+ * @param[in]  X           input matrix (col-major, n_rows x n_cols)
+ * @param[in]  n_rows      number of samples
+ * @param[in]  n_cols      number of features
+ * @param[out] categories  the categories of each feature, on the host
+ */
+void encoderFit(const cumlHandle& handle, const float* X, int n_rows,
+                int n_cols, std::vector<std::vector<float>>& categories);
+void encoderFit(const cumlHandle& handle, const double* X, int n_rows,
+                int n_cols, std::vector<std::vector<double>>& categories);
+
+/**
+ * @brief Encode the features as the index of their value in the categories,
+ * -1 for the values that are not in them
+ * @param[in]  handle         cuML handle
+ * @param[in]  X              input matrix (col-major, n_rows x n_cols)
+ * @param[in]  n_rows         number of samples
+ * @param[in]  n_cols         number of features
+ * @param[in]  categories     the categories of encoderFit
+ * @param[out] out            output matrix (n_rows x n_cols), which can be X
+ *                            unless out_row_major
+ * @param[in]  out_row_major  whether out is row-major
+ */
+void ordinalEncoderTransform(
+  const cumlHandle& handle, const float* X, int n_rows, int n_cols,
+  const std::vector<std::vector<float>>& categories, float* out,
+  bool out_row_major = false);
+void ordinalEncoderTransform(
+  const cumlHandle& handle, const double* X, int n_rows, int n_cols,
+  const std::vector<std::vector<double>>& categories, double* out,
+  bool out_row_major = false);
+
+/**
+ * @brief Encode the features as one-hot vectors over their categories, the
+ * column of category k of feature j being the sum of the numbers of
+ * categories of the features before j, plus k. The values that are not in the
+ * categories are all zeros, as sklearn's handle_unknown='ignore'.
+ * @param[in]  handle         cuML handle
+ * @param[in]  X              input matrix (col-major, n_rows x n_cols)
+ * @param[in]  n_rows         number of samples
+ * @param[in]  n_cols         number of features
+ * @param[in]  categories     the categories of encoderFit
+ * @param[out] out            dense output matrix (n_rows x the total number
+ *                            of categories)
+ * @param[in]  out_row_major  whether out is row-major
+ */
+void oneHotEncoderTransform(const cumlHandle& handle, const float* X,
+                            int n_rows, int n_cols,
+                            const std::vector<std::vector<float>>& categories,
+                            float* out, bool out_row_major = false);
+void oneHotEncoderTransform(
+  const cumlHandle& handle, const double* X, int n_rows, int n_cols,
+  const std::vector<std::vector<double>>& categories, double* out,
+  bool out_row_major = false);
+
+/**
+ * @brief Fit a bins discretizer: the n_bins + 1 edges of the bins of each
+ * feature. Unlike sklearn, the repeated edges of the quantile strategy are
+ * kept, so that every feature has n_bins bins, some of them empty.
+ * @param[in]  handle     cuML handle
+ * @param[in]  X          input matrix (col-major, n_rows x n_cols)
+ * @param[in]  n_rows     number of samples
+ * @param[in]  n_cols     number of features
+ * @param[in]  n_bins     number of bins, at least 2
+ * @param[in]  strategy   a KBinsStrategy
+ * @param[out] bin_edges  device array of the edges, those of feature j being
+ *                        at j * (n_bins + 1) (dim = (n_bins + 1) x n_cols)
+ */
+void kBinsDiscretizerFit(const cumlHandle& handle, const float* X, int n_rows,
+                         int n_cols, int n_bins, KBinsStrategy strategy,
+                         float* bin_edges);
+void kBinsDiscretizerFit(const cumlHandle& handle, const double* X,
+                         int n_rows, int n_cols, int n_bins,
+                         KBinsStrategy strategy, double* bin_edges);
+
+/**
+ * @brief Discretize the features into their bins, the values beyond the
+ * edges going to the first or the last bin
+ * @param[in]  handle         cuML handle
+ * @param[in]  X              input matrix (col-major, n_rows x n_cols)
+ * @param[in]  n_rows         number of samples
+ * @param[in]  n_cols         number of features
+ * @param[in]  n_bins         number of bins
+ * @param[in]  bin_edges      device array of the edges of kBinsDiscretizerFit
+ * @param[in]  one_hot        whether to encode the bins as one-hot vectors,
+ *                            the column of bin b of feature j being
+ *                            j * n_bins + b, rather than as their index
+ * @param[out] out            output matrix (n_rows x n_cols, or
+ *                            n_rows x (n_cols * n_bins) with one_hot), which
+ *                            can be X without one_hot nor out_row_major
+ * @param[in]  out_row_major  whether out is row-major
+ */
+void kBinsDiscretizerTransform(const cumlHandle& handle, const float* X,
+                               int n_rows, int n_cols, int n_bins,
+                               const float* bin_edges, bool one_hot,
+                               float* out, bool out_row_major = false);
+void kBinsDiscretizerTransform(const cumlHandle& handle, const double* X,
+                               int n_rows, int n_cols, int n_bins,
+                               const double* bin_edges, bool one_hot,
+                               double* out, bool out_row_major = false);
+
+/**
+ * @brief kBinsDiscretizerFit then kBinsDiscretizerTransform, see them for the
+ * params
+ */
+void kBinsDiscretizerFitTransform(const cumlHandle& handle, const float* X,
+                                  int n_rows, int n_cols, int n_bins,
+                                  KBinsStrategy strategy, float* bin_edges,
+                                  bool one_hot, float* out,
+                                  bool out_row_major = false);
+void kBinsDiscretizerFitTransform(const cumlHandle& handle, const double* X,
+                                  int n_rows, int n_cols, int n_bins,
+                                  KBinsStrategy strategy, double* bin_edges,
+                                  bool one_hot, double* out,
+                                  bool out_row_major = false);
+/** @} */
+
+}  // namespace Preprocessing
+}  // namespace ML
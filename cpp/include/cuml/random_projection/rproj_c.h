@@ -74,6 +74,12 @@ void RPROJtransform(const cumlHandle &handle, math_t *input,
                     rand_mat<math_t> *random_matrix, math_t *output,
                     paramsRPROJ *params);
 
+template <typename math_t>
+void RPROJtransformSparse(const cumlHandle &handle, const math_t *values,
+                          const int *cols, const int *row_ids, int nnz,
+                          rand_mat<math_t> *random_matrix, math_t *output,
+                          paramsRPROJ *params);
+
 size_t johnson_lindenstrauss_min_dim(size_t n_samples, double eps);
 
 }  // namespace ML
\ No newline at end of file
@@ -34,6 +34,23 @@ void sgdFit(cumlHandle &handle, double *input, int n_rows, int n_cols,
             double power_t, int loss, int penalty, double alpha,
             double l1_ratio, bool shuffle, double tol, int n_iter_no_change);
 
+/**
+ * SGD fit, as sgdFit, with the column-major input and the labels in host
+ * memory; they are streamed to the device by mini-batches.
+ */
+void sgdFitHost(cumlHandle &handle, const float *input, int n_rows,
+                int n_cols, const float *labels, float *coef, float *intercept,
+                bool fit_intercept, int batch_size, int epochs, int lr_type,
+                float eta0, float power_t, int loss, int penalty, float alpha,
+                float l1_ratio, bool shuffle, float tol, int n_iter_no_change);
+
+void sgdFitHost(cumlHandle &handle, const double *input, int n_rows,
+                int n_cols, const double *labels, double *coef,
+                double *intercept, bool fit_intercept, int batch_size,
+                int epochs, int lr_type, double eta0, double power_t, int loss,
+                int penalty, double alpha, double l1_ratio, bool shuffle,
+                double tol, int n_iter_no_change);
+
 void sgdPredict(cumlHandle &handle, const float *input, int n_rows, int n_cols,
                 const float *coef, float intercept, float *preds, int loss);
 
@@ -51,12 +68,23 @@ void sgdPredictBinaryClass(cumlHandle &handle, const double *input, int n_rows,
 void cdFit(cumlHandle &handle, float *input, int n_rows, int n_cols,
            float *labels, float *coef, float *intercept, bool fit_intercept,
            bool normalize, int epochs, int loss, float alpha, float l1_ratio,
-           bool shuffle, float tol);
+           bool shuffle, float tol, bool precompute_gram = false);
 
 void cdFit(cumlHandle &handle, double *input, int n_rows, int n_cols,
            double *labels, double *coef, double *intercept, bool fit_intercept,
            bool normalize, int epochs, int loss, double alpha, double l1_ratio,
-           bool shuffle, double tol);
+           bool shuffle, double tol, bool precompute_gram = false);
+
+void cdFitPath(cumlHandle &handle, float *input, int n_rows, int n_cols,
+               float *labels, const float *alphas, int n_alphas, float *coefs,
+               float *intercepts, bool fit_intercept, bool normalize,
+               int epochs, int loss, float l1_ratio, bool shuffle, float tol);
+
+void cdFitPath(cumlHandle &handle, double *input, int n_rows, int n_cols,
+               double *labels, const double *alphas, int n_alphas,
+               double *coefs, double *intercepts, bool fit_intercept,
+               bool normalize, int epochs, int loss, double l1_ratio,
+               bool shuffle, double tol);
 
 void cdPredict(cumlHandle &handle, const float *input, int n_rows, int n_cols,
                const float *coef, float intercept, float *preds, int loss);
@@ -69,6 +69,16 @@ struct DecisionTreeParams {
    * Minimum impurity decrease required for spliting a node. If the impurity decrease is below this value, node is leafed out. Default is 0.0
    */
   float min_impurity_decrease;
+  /**
+   * Whether to convert the training data once into 8 or 16 bit per column bin indices, shared by the trees of a RF and used by the level kernels instead of the data.
+   * Only affects GLOBAL_QUANTILE split_algo with quantiles computed once per RF.
+   */
+  bool quantize;
+  /**
+   * If > 0, the training data of a RF classifier is a host pointer: it is pre-binned into host pinned memory, which the level kernels stream through the device in blocks of stream_cols columns.
+   * Requires GLOBAL_QUANTILE split_algo with quantiles computed once per RF, max_features 1.0 and no bootstrapped or shuffled features. Default 0 (data on the device).
+   */
+  int stream_cols;
 };
 
 void set_tree_params(DecisionTreeParams &params, int cfg_max_depth = -1,
@@ -79,7 +89,8 @@ void set_tree_params(DecisionTreeParams &params, int cfg_max_depth = -1,
                      bool cfg_bootstrap_features = false,
                      CRITERION cfg_split_criterion = CRITERION_END,
                      bool cfg_quantile_per_tree = false,
-                     bool cfg_shuffle_features = false);
+                     bool cfg_shuffle_features = false,
+                     bool cfg_quantize = false, int cfg_stream_cols = 0);
 void validity_check(const DecisionTreeParams params);
 void print(const DecisionTreeParams params);
 
@@ -118,6 +129,34 @@ void decisionTreeClassifierFit(const ML::cumlHandle &handle,
                                int unique_labels,
                                DecisionTree::DecisionTreeParams tree_params);
 
+void decisionTreeClassifierFitCSC(
+  const ML::cumlHandle &handle, TreeClassifierF *&tree, const int *csc_ind,
+  const int *csc_rows, const float *csc_vals, const int nnz, const int ncols,
+  const int nrows, int *labels, unsigned int *rowids,
+  const int n_sampled_rows, int unique_labels,
+  DecisionTree::DecisionTreeParams tree_params);
+
+void decisionTreeClassifierFitCSC(
+  const ML::cumlHandle &handle, TreeClassifierD *&tree, const int *csc_ind,
+  const int *csc_rows, const double *csc_vals, const int nnz,
+  const int ncols, const int nrows, int *labels, unsigned int *rowids,
+  const int n_sampled_rows, int unique_labels,
+  DecisionTree::DecisionTreeParams tree_params);
+
+void decisionTreeClassifierFitCSR(
+  const ML::cumlHandle &handle, TreeClassifierF *&tree, const int *csr_ind,
+  const int *csr_cols, const float *csr_vals, const int nnz, const int ncols,
+  const int nrows, int *labels, unsigned int *rowids,
+  const int n_sampled_rows, int unique_labels,
+  DecisionTree::DecisionTreeParams tree_params);
+
+void decisionTreeClassifierFitCSR(
+  const ML::cumlHandle &handle, TreeClassifierD *&tree, const int *csr_ind,
+  const int *csr_cols, const double *csr_vals, const int nnz,
+  const int ncols, const int nrows, int *labels, unsigned int *rowids,
+  const int n_sampled_rows, int unique_labels,
+  DecisionTree::DecisionTreeParams tree_params);
+
 void decisionTreeClassifierPredict(const ML::cumlHandle &handle,
                                    const TreeClassifierF *tree,
                                    const float *rows, const int n_rows,
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+namespace ML {
+
+/**
+ * Order of a seasonal ARIMA model with exogenous regressors,
+ * (p, d, q)(P, D, Q)_s. The parameters of a series are grouped as
+ * [mu, ar.., ma.., sar.., sma.., beta..], mu being present if d + D > 0.
+ */
+struct ARIMAOrder {
+  int p;       // Basic order
+  int d;
+  int q;
+  int P;       // Seasonal order
+  int D;
+  int Q;
+  int s;       // Seasonal period
+  int n_exog;  // Number of exogenous regressors
+
+  /** Number of AR and MA parameters of the expanded (reduced form) model */
+  int p_expanded() const { return p + s * P; }
+  int q_expanded() const { return q + s * Q; }
+  /** Number of observations lost by differencing */
+  int n_diff() const { return d + s * D; }
+  /** Whether the differenced series has a trend parameter mu */
+  int k() const { return d + D > 0 ? 1 : 0; }
+  /** Number of parameters per series */
+  int complexity() const { return k() + p + q + P + Q + n_exog; }
+};
+
+}  // namespace ML
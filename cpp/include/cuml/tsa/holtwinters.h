@@ -84,6 +84,27 @@ void fit(const ML::cumlHandle &handle, int n, int batch_size, int frequency,
          double *data, double *level_d, double *trend_d, double *season_d,
          double *error_d);
 
+/**
+             * Fits a HoltWinters model and also returns its smoothing
+             * coefficients, for forecast intervals and update
+             * @param[out] alpha_d
+             *             device pointer to array which will hold alpha,
+             *             one per series
+             * @param[out] beta_d
+             *             device pointer to array which will hold beta
+             * @param[out] gamma_d
+             *             device pointer to array which will hold gamma
+             * The other parameters are those of fit above
+             */
+void fit(const ML::cumlHandle &handle, int n, int batch_size, int frequency,
+         int start_periods, ML::SeasonalType seasonal, float epsilon,
+         float *data, float *level_d, float *trend_d, float *season_d,
+         float *error_d, float *alpha_d, float *beta_d, float *gamma_d);
+void fit(const ML::cumlHandle &handle, int n, int batch_size, int frequency,
+         int start_periods, ML::SeasonalType seasonal, double epsilon,
+         double *data, double *level_d, double *trend_d, double *season_d,
+         double *error_d, double *alpha_d, double *beta_d, double *gamma_d);
+
 /**
              * Forecasts future points from fitted HoltWinters model
              * @param[in] handle
@@ -114,5 +135,85 @@ void forecast(const ML::cumlHandle &handle, int n, int batch_size,
               int frequency, int h, ML::SeasonalType seasonal, double *level_d,
               double *trend_d, double *season_d, double *forecast_d);
 
+/**
+             * Forecasts future points from fitted HoltWinters model, with
+             * their prediction intervals. The intervals are those of the
+             * additive error model, the error variance being estimated from
+             * the training SSE
+             * @param[in] alpha_d
+             *            device pointer to array which holds alpha
+             * @param[in] beta_d
+             *            device pointer to array which holds beta
+             * @param[in] gamma_d
+             *            device pointer to array which holds gamma
+             * @param[in] error_d
+             *            device pointer to array which holds training SSE error
+             * @param[in] confidence
+             *            confidence level of the intervals, in (0, 1)
+             * @param[out] lower_d
+             *             device pointer to array which will hold the lower
+             *             bounds, laid out as forecast_d
+             * @param[out] upper_d
+             *             device pointer to array which will hold the upper
+             *             bounds, laid out as forecast_d
+             * The other parameters are those of forecast above
+             */
+void forecast(const ML::cumlHandle &handle, int n, int batch_size,
+              int frequency, int h, ML::SeasonalType seasonal, float *level_d,
+              float *trend_d, float *season_d, const float *alpha_d,
+              const float *beta_d, const float *gamma_d, const float *error_d,
+              float confidence, float *forecast_d, float *lower_d,
+              float *upper_d);
+void forecast(const ML::cumlHandle &handle, int n, int batch_size,
+              int frequency, int h, ML::SeasonalType seasonal, double *level_d,
+              double *trend_d, double *season_d, const double *alpha_d,
+              const double *beta_d, const double *gamma_d,
+              const double *error_d, double confidence, double *forecast_d,
+              double *lower_d, double *upper_d);
+
+/**
+             * Appends new observations to a fitted HoltWinters model: the
+             * last level, trend and season components are updated with the
+             * fitted alpha, beta and gamma, without optimization. forecast
+             * then predicts the points following the new observations.
+             * The components of the earlier points and the SSE are not
+             * updated
+             * @param[in] handle
+             *            cuml handle to use across the algorithm
+             * @param[in] n
+             *            n_samples in the time-series of the fit
+             * @param[in] batch_size
+             *            number of time-series in X
+             * @param[in] frequency
+             *            number of periods in a season of the time-series
+             * @param[in] n_new
+             *            number of new observations per time-series
+             * @param[in] seasonal
+             *            type of seasonal component (ADDITIVE or MULTIPLICATIVE)
+             * @param[in] data
+             *            device pointer to the new observations, laid out as
+             *            the data of fit
+             * @param[in] alpha_d
+             *            device pointer to array which holds alpha
+             * @param[in] beta_d
+             *            device pointer to array which holds beta
+             * @param[in] gamma_d
+             *            device pointer to array which holds gamma
+             * @param[inout] level_d
+             *             device pointer to array which holds level components
+             * @param[inout] trend_d
+             *             device pointer to array which holds trend components
+             * @param[inout] season_d
+             *             device pointer to array which holds season components
+             */
+void update(const ML::cumlHandle &handle, int n, int batch_size, int frequency,
+            int n_new, ML::SeasonalType seasonal, const float *data,
+            const float *alpha_d, const float *beta_d, const float *gamma_d,
+            float *level_d, float *trend_d, float *season_d);
+void update(const ML::cumlHandle &handle, int n, int batch_size, int frequency,
+            int n_new, ML::SeasonalType seasonal, const double *data,
+            const double *alpha_d, const double *beta_d, const double *gamma_d,
+            double *level_d, double *trend_d, double *season_d);
+
 }  // namespace HoltWinters
 }  // namespace ML
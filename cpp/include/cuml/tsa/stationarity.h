@@ -49,5 +49,32 @@ int stationarity(const cumlHandle& handle, const float* y_d, int* d,
 int stationarity(const cumlHandle& handle, const double* y_d, int* d,
                  int n_batches, int n_samples, double pval_threshold);
 
+/**
+ * @brief Compute recommended trend parameter (d=0 to max_d) for a batched
+ *        series, with the KPSS or the ADF test
+ * @details The smallest order of differencing that passes the test is
+ *          selected for each series. All the orders are tested in one pass.
+ * @note The data is a column-major matrix where the series are columns.
+ *       The output is an array of size n_batches.
+ * @param[in]   handle          cuML handle
+ * @param[in]   y_d             Input data
+ * @param[out]  d               Integer array to store the trends
+ * @param[in]   n_batches       Number of batches
+ * @param[in]   n_samples       Number of samples
+ * @param[in]   pval_threshold  P-value threshold. With KPSS, a series is
+ *                              stationary above it; with ADF, below it
+ * @param[in]   test            0: KPSS, 1: ADF
+ * @param[in]   max_d           Maximum order of differencing
+ * @return      An integer to track if some series failed the test
+ * @retval  -1  Some series failed the test
+ * @retval   k  All the series passed, some for d=k and the others for d<k
+ */
+int stationarity(const cumlHandle& handle, const float* y_d, int* d,
+                 int n_batches, int n_samples, float pval_threshold, int test,
+                 int max_d);
+int stationarity(const cumlHandle& handle, const double* y_d, int* d,
+                 int n_batches, int n_samples, double pval_threshold, int test,
+                 int max_d);
+
 }  // namespace Stationarity
 }  // namespace ML
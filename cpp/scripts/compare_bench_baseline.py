@@ -0,0 +1,165 @@
+# Copyright (c) 2020, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+"""Compares the results of sg_benchmark against a stored baseline, both
+written with --cuml_baseline_out, and flags the cases which got
+significantly slower: those whose mean time grew by more than --threshold,
+with a one-sided Welch's t-test of the samples (see --benchmark_repetitions)
+rejecting equal means at --alpha. Exits with 1 when a case is flagged, so
+that it can gate an upgrade."""
+
+from __future__ import print_function
+import argparse
+import json
+import math
+import sys
+
+
+SCHEMA = "cuml-bench-baseline"
+VERSION = 1
+
+
+def parse_args():
+    argparser = argparse.ArgumentParser(
+        "Flags the significant slowdowns of sg_benchmark against a baseline")
+    argparser.add_argument("baseline", type=str,
+                           help="The results to compare against")
+    argparser.add_argument("contender", type=str,
+                           help="The results to compare")
+    argparser.add_argument("--alpha", type=float, default=0.05,
+                           help="Significance level of the t-test")
+    argparser.add_argument("--threshold", type=float, default=0.05,
+                           help="Relative slowdown below which a case is "
+                           "never flagged")
+    argparser.add_argument("--all", action="store_true",
+                           help="Print all the compared cases, not only "
+                           "the flagged ones")
+    return argparser.parse_args()
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    if data.get("schema") != SCHEMA or data.get("version") != VERSION:
+        raise ValueError("%s is not a baseline of version %d" %
+                         (path, VERSION))
+    return data["results"]
+
+
+def betacf(a, b, x):
+    """The continued fraction of the incomplete beta function"""
+    tiny = 1e-300
+    qab, qap, qam = a + b, a + 1.0, a - 1.0
+    c, d = 1.0, 1.0 - qab * x / qap
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 201):
+        m2 = 2 * m
+        aa = m * (b - m) * x / ((qam + m2) * (a + m2))
+        d = 1.0 + aa * d
+        d = 1.0 / (d if abs(d) > tiny else tiny)
+        c = 1.0 + aa / c
+        c = c if abs(c) > tiny else tiny
+        h *= d * c
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2))
+        d = 1.0 + aa * d
+        d = 1.0 / (d if abs(d) > tiny else tiny)
+        c = 1.0 + aa / c
+        c = c if abs(c) > tiny else tiny
+        delta = d * c
+        h *= delta
+        if abs(delta - 1.0) < 1e-12:
+            break
+    return h
+
+
+def betainc(a, b, x):
+    """The regularized incomplete beta function I_x(a, b)"""
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    lbeta = math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+    front = math.exp(lbeta + a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return front * betacf(a, b, x) / a
+    return 1.0 - front * betacf(b, a, 1.0 - x) / b
+
+
+def t_sf(t, df):
+    """P(T > t) of a Student's t distribution of df degrees of freedom"""
+    x = df / (df + t * t)
+    tail = 0.5 * betainc(df / 2.0, 0.5, x)
+    return tail if t > 0 else 1.0 - tail
+
+
+def mean_var(samples):
+    n = len(samples)
+    mean = sum(samples) / n
+    var = sum((s - mean) ** 2 for s in samples) / (n - 1) if n > 1 else 0.0
+    return mean, var
+
+
+def slower_pvalue(base, cont):
+    """The p-value of the contender being slower than the baseline, None if
+    there are too few samples"""
+    if len(base) < 2 or len(cont) < 2:
+        return None
+    mb, vb = mean_var(base)
+    mc, vc = mean_var(cont)
+    sb, sc = vb / len(base), vc / len(cont)
+    if sb + sc == 0.0:
+        return 0.0 if mc > mb else 1.0
+    t = (mc - mb) / math.sqrt(sb + sc)
+    # the Welch-Satterthwaite degrees of freedom
+    df = (sb + sc) ** 2 / (sb ** 2 / (len(base) - 1) +
+                          sc ** 2 / (len(cont) - 1))
+    return t_sf(t, df)
+
+
+def main():
+    args = parse_args()
+    base = load(args.baseline)
+    cont = load(args.contender)
+    flagged = 0
+    rows = []
+    for key in sorted(set(base) & set(cont)):
+        b, c = base[key], cont[key]
+        if b.get("params") != c.get("params"):
+            print("%s: the params changed, skipped" % key, file=sys.stderr)
+            continue
+        if b["time_unit"] != c["time_unit"] or b["mean"] is None or \
+                c["mean"] is None or b["mean"] <= 0.0:
+            continue
+        change = c["mean"] / b["mean"] - 1.0
+        p = slower_pvalue(b["samples"], c["samples"])
+        slow = change > args.threshold and p is not None and p < args.alpha
+        flagged += slow
+        if slow or args.all:
+            rows.append((key, b["mean"], c["mean"], b["time_unit"], change,
+                         p, slow))
+    for key, mb, mc, unit, change, p, slow in rows:
+        print("%-8s %s: %.4g -> %.4g %s (%+.1f%%, p=%s)" %
+              ("SLOWER" if slow else "", key, mb, mc, unit, 100.0 * change,
+               "n/a" if p is None else "%.3g" % p))
+    for key in sorted(set(base) - set(cont)):
+        print("%s: missing from %s" % (key, args.contender), file=sys.stderr)
+    print("%d of %d cases significantly slower" %
+          (flagged, len(set(base) & set(cont))))
+    return 1 if flagged > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -16,11 +16,13 @@
 
 #include <cmath>
 #include <cstdio>
+#include <limits>
 #include <tuple>
 #include <vector>
 
 #include "batched_arima.hpp"
 #include "batched_kalman.hpp"
+#include "batched_lbfgs.h"
 #include "cuda_utils.h"
 #include "utils.h"
 
@@ -39,6 +41,7 @@
 #include <linalg/matrix_vector_op.h>
 #include <metrics/batched/information_criterion.h>
 #include <stats/mean.h>
+#include <timeSeries/stationarity.h>
 #include <matrix/batched_matrix.hpp>
 
 namespace ML {
@@ -226,7 +229,7 @@ void batched_loglike(cumlHandle& handle, double* d_y, int num_batches, int nobs,
   if (d == 0) {
     // no diff
     batched_kalman_filter(handle, d_y, nobs, d_Tar, d_Tma, p, q, num_batches,
-                          loglike, d_vs);
+                          loglike, d_vs, host_loglike);
   } else if (d == 1) {
     ////////////////////////////////////////////////////////////
     // diff and center (with `mu`):
@@ -253,7 +256,7 @@ void batched_loglike(cumlHandle& handle, double* d_y, int num_batches, int nobs,
     }
 
     batched_kalman_filter(handle, y_diff, nobs - d, d_Tar, d_Tma, p, q,
-                          num_batches, loglike, d_vs);
+                          num_batches, loglike, d_vs, host_loglike);
 
     allocator->deallocate(y_diff, sizeof(double) * num_batches * (nobs - 1),
                           stream);
@@ -472,4 +475,538 @@ void estimate_x0(cumlHandle& handle, double* d_mu, double* d_ar, double* d_ma,
   ML::POP_RANGE();
 }
 
+
+/**
+ * Splits the parameters grouped by series into arrays of the parameters of
+ * each kind, grouped by series.
+ */
+void unpack(const ARIMAOrder& order, const double* d_params, double* d_mu,
+            double* d_ar, double* d_ma, double* d_sar, double* d_sma,
+            double* d_beta, int num_batches, cudaStream_t stream) {
+  const int N = order.complexity();
+  const int k = order.k(), p = order.p, q = order.q, P = order.P,
+            Q = order.Q, n_exog = order.n_exog;
+  auto counting = thrust::make_counting_iterator(0);
+  thrust::for_each(thrust::cuda::par.on(stream), counting,
+                   counting + num_batches, [=] __device__(int bid) {
+                     const double* param = d_params + bid * N;
+                     if (k) d_mu[bid] = *param++;
+                     for (int i = 0; i < p; i++) d_ar[bid * p + i] = *param++;
+                     for (int i = 0; i < q; i++) d_ma[bid * q + i] = *param++;
+                     for (int i = 0; i < P; i++) d_sar[bid * P + i] = *param++;
+                     for (int i = 0; i < Q; i++) d_sma[bid * Q + i] = *param++;
+                     for (int i = 0; i < n_exog; i++)
+                       d_beta[bid * n_exog + i] = *param++;
+                   });
+}
+
+/** The inverse of the seasonal unpack */
+void pack(const ARIMAOrder& order, const double* d_mu, const double* d_ar,
+          const double* d_ma, const double* d_sar, const double* d_sma,
+          const double* d_beta, double* d_params, int num_batches,
+          cudaStream_t stream) {
+  const int N = order.complexity();
+  const int k = order.k(), p = order.p, q = order.q, P = order.P,
+            Q = order.Q, n_exog = order.n_exog;
+  auto counting = thrust::make_counting_iterator(0);
+  thrust::for_each(thrust::cuda::par.on(stream), counting,
+                   counting + num_batches, [=] __device__(int bid) {
+                     double* param = d_params + bid * N;
+                     if (k) *param++ = d_mu[bid];
+                     for (int i = 0; i < p; i++) *param++ = d_ar[bid * p + i];
+                     for (int i = 0; i < q; i++) *param++ = d_ma[bid * q + i];
+                     for (int i = 0; i < P; i++) *param++ = d_sar[bid * P + i];
+                     for (int i = 0; i < Q; i++) *param++ = d_sma[bid * Q + i];
+                     for (int i = 0; i < n_exog; i++)
+                       *param++ = d_beta[bid * n_exog + i];
+                   });
+}
+
+/**
+ * The parameters of a seasonal ARIMA and their buffers, unpacked by kind
+ */
+struct ARIMAParamsBuffers {
+  MLCommon::device_buffer<double> mu, ar, ma, sar, sma, beta;
+
+  ARIMAParamsBuffers(const ARIMAOrder& order, int num_batches,
+                     std::shared_ptr<MLCommon::deviceAllocator> allocator,
+                     cudaStream_t stream)
+    : mu(allocator, stream, num_batches),
+      ar(allocator, stream, order.p * num_batches),
+      ma(allocator, stream, order.q * num_batches),
+      sar(allocator, stream, order.P * num_batches),
+      sma(allocator, stream, order.Q * num_batches),
+      beta(allocator, stream, order.n_exog * num_batches) {}
+};
+
+/**
+ * Jones transform (or its inverse) of the seasonal ARIMA parameters grouped
+ * by series. The basic and the seasonal polynomials are transformed
+ * separately, their product then being stationary and invertible.
+ */
+void batched_jones_transform(cumlHandle& handle, const ARIMAOrder& order,
+                             int num_batches, bool isInv,
+                             const double* d_params, double* d_Tparams) {
+  auto allocator = handle.getDeviceAllocator();
+  auto stream = handle.getStream();
+  ARIMAParamsBuffers params(order, num_batches, allocator, stream);
+  ARIMAParamsBuffers Tparams(order, num_batches, allocator, stream);
+  unpack(order, d_params, params.mu.data(), params.ar.data(),
+         params.ma.data(), params.sar.data(), params.sma.data(),
+         params.beta.data(), num_batches, stream);
+  batched_jones_transform(handle, order.p, order.q, num_batches, isInv,
+                          params.ar.data(), params.ma.data(), Tparams.ar.data(),
+                          Tparams.ma.data());
+  batched_jones_transform(handle, order.P, order.Q, num_batches, isInv,
+                          params.sar.data(), params.sma.data(),
+                          Tparams.sar.data(), Tparams.sma.data());
+  pack(order, params.mu.data(), Tparams.ar.data(), Tparams.ma.data(),
+       Tparams.sar.data(), Tparams.sma.data(), params.beta.data(), d_Tparams,
+       num_batches, stream);
+}
+
+void batched_loglike(cumlHandle& handle, double* d_y, int num_batches, int nobs,
+                     const ARIMAOrder& order, double* d_params,
+                     double* loglike, double* d_vs, bool trans,
+                     bool host_loglike, const double* d_exog, bool fp32) {
+  ML::PUSH_RANGE(__func__);
+  auto allocator = handle.getDeviceAllocator();
+  auto stream = handle.getStream();
+  ASSERT(order.s > 0 || (order.P == 0 && order.D == 0 && order.Q == 0),
+         "A seasonal model needs a seasonal period s > 0");
+  ASSERT(order.n_exog == 0 || d_exog != nullptr,
+         "The exogenous regressors are missing");
+  const int N = order.complexity();
+  const int p = order.p, q = order.q, P = order.P, Q = order.Q,
+            s = order.s, d = order.d, D = order.D, n_exog = order.n_exog;
+  const int p_exp = order.p_expanded(), q_exp = order.q_expanded();
+  const int k = order.k();
+  const int n_obs_diff = nobs - order.n_diff();
+  ASSERT(n_obs_diff > 0, "The series are too short for the differencing");
+
+  MLCommon::device_buffer<double> Tparams(allocator, stream, N * num_batches);
+  if (trans) {
+    batched_jones_transform(handle, order, num_batches, false, d_params,
+                            Tparams.data());
+  } else {
+    MLCommon::copy(Tparams.data(), d_params, N * num_batches, stream);
+  }
+  ARIMAParamsBuffers params(order, num_batches, allocator, stream);
+  unpack(order, Tparams.data(), params.mu.data(), params.ar.data(),
+         params.ma.data(), params.sar.data(), params.sma.data(),
+         params.beta.data(), num_batches, stream);
+
+  // reduced form: (1 - ar(B))(1 - sar(B^s)) and (1 + ma(B))(1 + sma(B^s))
+  MLCommon::device_buffer<double> ar_exp(allocator, stream,
+                                         p_exp * num_batches);
+  MLCommon::device_buffer<double> ma_exp(allocator, stream,
+                                         q_exp * num_batches);
+  // the series, with the regression removed, differenced and centered
+  MLCommon::device_buffer<double> y_prep(allocator, stream, nobs * num_batches);
+  double* ar_exp_ = ar_exp.data();
+  double* ma_exp_ = ma_exp.data();
+  double* y_prep_ = y_prep.data();
+  const double* mu_ = params.mu.data();
+  const double* ar_ = params.ar.data();
+  const double* ma_ = params.ma.data();
+  const double* sar_ = params.sar.data();
+  const double* sma_ = params.sma.data();
+  const double* beta_ = params.beta.data();
+  auto counting = thrust::make_counting_iterator(0);
+  thrust::for_each(
+    thrust::cuda::par.on(stream), counting, counting + num_batches,
+    [=] __device__(int bid) {
+      for (int i = 0; i < p_exp; i++) ar_exp_[bid * p_exp + i] = 0.0;
+      for (int i = 0; i < p; i++) ar_exp_[bid * p_exp + i] = ar_[bid * p + i];
+      for (int j = 0; j < P; j++) {
+        double sar_j = sar_[bid * P + j];
+        ar_exp_[bid * p_exp + (j + 1) * s - 1] += sar_j;
+        for (int i = 0; i < p; i++) {
+          ar_exp_[bid * p_exp + (j + 1) * s + i] -= ar_[bid * p + i] * sar_j;
+        }
+      }
+      for (int i = 0; i < q_exp; i++) ma_exp_[bid * q_exp + i] = 0.0;
+      for (int i = 0; i < q; i++) ma_exp_[bid * q_exp + i] = ma_[bid * q + i];
+      for (int j = 0; j < Q; j++) {
+        double sma_j = sma_[bid * Q + j];
+        ma_exp_[bid * q_exp + (j + 1) * s - 1] += sma_j;
+        for (int i = 0; i < q; i++) {
+          ma_exp_[bid * q_exp + (j + 1) * s + i] += ma_[bid * q + i] * sma_j;
+        }
+      }
+
+      double* y_b = y_prep_ + bid * nobs;
+      for (int t = 0; t < nobs; t++) {
+        double y_t = d_y[bid * nobs + t];
+        for (int i = 0; i < n_exog; i++) {
+          y_t -= d_exog[(bid * n_exog + i) * nobs + t] *
+                 beta_[bid * n_exog + i];
+        }
+        y_b[t] = y_t;
+      }
+      // each difference shortens the series, kept aligned on its start
+      int len = nobs;
+      for (int i = 0; i < D; i++) {
+        for (int t = 0; t < len - s; t++) y_b[t] = y_b[t + s] - y_b[t];
+        len -= s;
+      }
+      for (int i = 0; i < d; i++) {
+        for (int t = 0; t < len - 1; t++) y_b[t] = y_b[t + 1] - y_b[t];
+        len -= 1;
+      }
+      if (k) {
+        for (int t = 0; t < len; t++) y_b[t] -= mu_[bid];
+      }
+    });
+  // compact the series to the layout (n_obs_diff, num_batches)
+  MLCommon::device_buffer<double> y_diff(allocator, stream,
+                                         n_obs_diff * num_batches);
+  CUDA_CHECK(cudaMemcpy2DAsync(y_diff.data(), sizeof(double) * n_obs_diff,
+                               y_prep.data(), sizeof(double) * nobs,
+                               sizeof(double) * n_obs_diff, num_batches,
+                               cudaMemcpyDeviceToDevice, stream));
+
+  batched_kalman_filter(handle, y_diff.data(), n_obs_diff, ar_exp.data(),
+                        ma_exp.data(), p_exp, q_exp, num_batches, loglike, d_vs,
+                        host_loglike, false, fp32);
+  ML::POP_RANGE();
+}
+
+void batched_loglike_grad(cumlHandle& handle, double* d_y, int num_batches,
+                          int nobs, int p, int d, int q, double* d_params,
+                          double* d_loglike, double* d_grad, double* d_vs,
+                          bool trans) {
+  ML::PUSH_RANGE(__func__);
+  auto allocator = handle.getDeviceAllocator();
+  auto stream = handle.getStream();
+  ARIMAOrder order = {p, d, q, 0, 0, 0, 0, 0};
+  const int N = p + d + q;
+  const int n_k = 1 + p + q;
+  ASSERT(d == 0 || d == 1, "Not supported difference parameter: d=0, 1");
+
+  MLCommon::device_buffer<double> Tparams(allocator, stream, N * num_batches);
+  if (trans) {
+    batched_jones_transform(handle, order, num_batches, false, d_params,
+                            Tparams.data());
+  } else {
+    MLCommon::copy(Tparams.data(), d_params, N * num_batches, stream);
+  }
+  MLCommon::device_buffer<double> mu(allocator, stream, num_batches);
+  MLCommon::device_buffer<double> ar(allocator, stream, p * num_batches);
+  MLCommon::device_buffer<double> ma(allocator, stream, q * num_batches);
+  unpack(Tparams.data(), mu.data(), ar.data(), ma.data(), num_batches, p, d, q,
+         stream);
+
+  // diff and center (with `mu`)
+  MLCommon::device_buffer<double> y_diff(allocator, stream,
+                                         (nobs - d) * num_batches);
+  double* y_diff_ = y_diff.data();
+  const double* mu_ = mu.data();
+  auto counting = thrust::make_counting_iterator(0);
+  thrust::for_each(thrust::cuda::par.on(stream), counting,
+                   counting + num_batches, [=] __device__(int bid) {
+                     for (int i = 0; i < nobs - d; i++) {
+                       y_diff_[bid * (nobs - d) + i] =
+                         d == 0 ? d_y[bid * nobs + i]
+                                : d_y[bid * nobs + i + 1] -
+                                    d_y[bid * nobs + i] - mu_[bid];
+                     }
+                   });
+
+  MLCommon::device_buffer<double> kalman_grad(allocator, stream,
+                                              n_k * num_batches);
+  batched_kalman_loglike_grad(handle, y_diff.data(), nobs - d, ar.data(),
+                              ma.data(), p, q, num_batches, d_loglike,
+                              kalman_grad.data(), d_vs);
+
+  // the gradient for the transformed parameters: the shift of the series
+  // is mu, the other parameters are the same
+  MLCommon::device_buffer<double> Tgrad(allocator, stream, N * num_batches);
+  double* Tgrad_ = trans ? Tgrad.data() : d_grad;
+  const double* kalman_grad_ = kalman_grad.data();
+  thrust::for_each(thrust::cuda::par.on(stream), counting,
+                   counting + num_batches, [=] __device__(int bid) {
+                     if (d) Tgrad_[bid * N] = kalman_grad_[bid * n_k];
+                     for (int i = 0; i < p + q; i++) {
+                       Tgrad_[bid * N + d + i] =
+                         kalman_grad_[bid * n_k + 1 + i];
+                     }
+                   });
+  if (!trans) {
+    ML::POP_RANGE();
+    return;
+  }
+
+  // chain rule through the Jones transform, whose Jacobian is cheap to
+  // evaluate by central differences
+  const double h = 1e-7;
+  MLCommon::device_buffer<double> x_pert(allocator, stream, N * num_batches);
+  MLCommon::device_buffer<double> T_ph(allocator, stream, N * num_batches);
+  MLCommon::device_buffer<double> T_mh(allocator, stream, N * num_batches);
+  double* x_pert_ = x_pert.data();
+  double* T_ph_ = T_ph.data();
+  double* T_mh_ = T_mh.data();
+  CUDA_CHECK(
+    cudaMemsetAsync(d_grad, 0, sizeof(double) * N * num_batches, stream));
+  MLCommon::copy(x_pert.data(), d_params, N * num_batches, stream);
+  for (int i = 0; i < N; i++) {
+    thrust::for_each(thrust::cuda::par.on(stream), counting,
+                     counting + num_batches, [=] __device__(int bid) {
+                       x_pert_[bid * N + i] = d_params[bid * N + i] + h;
+                     });
+    batched_jones_transform(handle, order, num_batches, false, x_pert_, T_ph_);
+    thrust::for_each(thrust::cuda::par.on(stream), counting,
+                     counting + num_batches, [=] __device__(int bid) {
+                       x_pert_[bid * N + i] = d_params[bid * N + i] - h;
+                     });
+    batched_jones_transform(handle, order, num_batches, false, x_pert_, T_mh_);
+    thrust::for_each(thrust::cuda::par.on(stream), counting,
+                     counting + num_batches, [=] __device__(int bid) {
+                       x_pert_[bid * N + i] = d_params[bid * N + i];
+                       double sum = 0.0;
+                       for (int j = 0; j < N; j++) {
+                         sum += Tgrad_[bid * N + j] *
+                                (T_ph_[bid * N + j] - T_mh_[bid * N + j]) /
+                                (2 * h);
+                       }
+                       d_grad[bid * N + i] = sum;
+                     });
+  }
+  ML::POP_RANGE();
+}
+
+/**
+ * The objective of batched_fit: the negative log-likelihood of each series
+ * per observation, as a function of the parameters before the Jones
+ * transform, and its gradient by central finite differences.
+ */
+struct ArimaFitObjective {
+  cumlHandle& handle;
+  double* d_y;
+  int num_batches, nobs;
+  ARIMAOrder order;
+  const double* d_exog;
+  double h;
+  double* d_vs;
+  double* x_pert;
+  double* f_ph;
+  double* f_mh;
+
+  void loglike(double* x, double* fx) {
+    batched_loglike(handle, d_y, num_batches, nobs, order, x, fx, d_vs, true,
+                    false, d_exog);
+  }
+
+  void operator()(const double* x, double* fx, double* grad) {
+    auto stream = handle.getStream();
+    auto counting = thrust::make_counting_iterator(0);
+    int N = order.complexity();
+    double scale = -1.0 / (nobs - 1);
+    MLCommon::copy(x_pert, x, N * num_batches, stream);
+    loglike(x_pert, fx);
+    thrust::for_each(thrust::cuda::par.on(stream), counting,
+                     counting + num_batches,
+                     [=] __device__(int bid) { fx[bid] *= scale; });
+    if (grad == nullptr) return;
+
+    if (order.P + order.D + order.Q + order.n_exog == 0) {
+      // analytic gradient of the non-seasonal models
+      batched_loglike_grad(handle, d_y, num_batches, nobs, order.p, order.d,
+                           order.q, x_pert, f_ph, grad, d_vs, true);
+      thrust::for_each(thrust::cuda::par.on(stream), counting,
+                       counting + N * num_batches,
+                       [=] __device__(int idx) { grad[idx] *= scale; });
+      return;
+    }
+
+    // the series are independent: all of them are perturbed at once
+    double* x_pert_ = x_pert;
+    double* f_ph_ = f_ph;
+    double* f_mh_ = f_mh;
+    double h_ = h;
+    for (int i = 0; i < N; i++) {
+      thrust::for_each(thrust::cuda::par.on(stream), counting,
+                       counting + num_batches, [=] __device__(int bid) {
+                         x_pert_[bid * N + i] = x[bid * N + i] + h_;
+                       });
+      loglike(x_pert_, f_ph_);
+      thrust::for_each(thrust::cuda::par.on(stream), counting,
+                       counting + num_batches, [=] __device__(int bid) {
+                         x_pert_[bid * N + i] = x[bid * N + i] - h_;
+                       });
+      loglike(x_pert_, f_mh_);
+      thrust::for_each(thrust::cuda::par.on(stream), counting,
+                       counting + num_batches, [=] __device__(int bid) {
+                         x_pert_[bid * N + i] = x[bid * N + i];
+                         grad[bid * N + i] =
+                           scale * (f_ph_[bid] - f_mh_[bid]) / (2 * h_);
+                       });
+    }
+  }
+};
+
+void batched_fit(cumlHandle& handle, double* d_y, int num_batches, int nobs,
+                 const ARIMAOrder& order, double* d_params, int* niter,
+                 int* status, int max_iter, double tol, double h,
+                 const double* d_exog) {
+  ML::PUSH_RANGE(__func__);
+  auto allocator = handle.getDeviceAllocator();
+  auto stream = handle.getStream();
+  int N = order.complexity();
+
+  MLCommon::device_buffer<double> x(allocator, stream, N * num_batches);
+  MLCommon::device_buffer<double> x_pert(allocator, stream, N * num_batches);
+  MLCommon::device_buffer<double> fx(allocator, stream, num_batches);
+  MLCommon::device_buffer<double> f_ph(allocator, stream, num_batches);
+  MLCommon::device_buffer<double> f_mh(allocator, stream, num_batches);
+  MLCommon::device_buffer<double> vs(allocator, stream,
+                                     (nobs - order.n_diff()) * num_batches);
+  MLCommon::device_buffer<int> d_niter(allocator, stream, num_batches);
+  MLCommon::device_buffer<int> d_status(allocator, stream, num_batches);
+
+  // the optimization runs on the parameters before the Jones transform
+  batched_jones_transform(handle, order, num_batches, true, d_params,
+                          x.data());
+
+  ArimaFitObjective objective{
+    handle, d_y, num_batches, nobs, order, d_exog, h, vs.data(), x_pert.data(),
+    f_ph.data(), f_mh.data()};
+  GLM::LBFGSParam<double> param;
+  param.epsilon = tol;
+  param.max_iterations = max_iter;
+  batched_min_lbfgs(param, objective, x.data(), fx.data(), d_niter.data(),
+                    d_status.data(), N, num_batches, allocator, stream);
+
+  batched_jones_transform(handle, order, num_batches, false, x.data(),
+                          d_params);
+
+  MLCommon::updateHost(niter, d_niter.data(), num_batches, stream);
+  MLCommon::updateHost(status, d_status.data(), num_batches, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  ML::POP_RANGE();
+}
+
+void batched_fit(cumlHandle& handle, double* d_y, int num_batches, int nobs,
+                 int p, int d, int q, double* d_params, int* niter, int* status,
+                 int max_iter, double tol, double h) {
+  ARIMAOrder order = {p, d, q, 0, 0, 0, 0, 0};
+  batched_fit(handle, d_y, num_batches, nobs, order, d_params, niter, status,
+              max_iter, tol, h);
+}
+
+void auto_arima(cumlHandle& handle, double* d_y, int num_batches, int nobs,
+                int max_p, int max_q, int ic_type, int* p, int* d, int* q,
+                double* d_params, double* ic, int max_iter, double tol) {
+  ML::PUSH_RANGE(__func__);
+  auto allocator = handle.getDeviceAllocator();
+  auto stream = handle.getStream();
+  const int N_max = 1 + max_p + max_q;
+  auto counting = thrust::make_counting_iterator(0);
+
+  // the difference order of each series by the KPSS test. Only d <= 1 is
+  // supported, so the series that fail for d = 1 too are also differenced
+  MLCommon::TimeSeries::stationarity(d_y, d, num_batches, nobs, allocator,
+                                     stream);
+  for (int bid = 0; bid < num_batches; bid++) {
+    if (d[bid] < 0) d[bid] = 1;
+  }
+
+  for (int dd = 0; dd <= 1; dd++) {
+    std::vector<int> map_h;
+    for (int bid = 0; bid < num_batches; bid++) {
+      if (d[bid] == dd) map_h.push_back(bid);
+    }
+    const int nb = map_h.size();
+    if (nb == 0) continue;
+
+    // the series of this difference order, contiguous
+    MLCommon::device_buffer<int> map(allocator, stream, nb);
+    MLCommon::updateDevice(map.data(), map_h.data(), nb, stream);
+    MLCommon::device_buffer<double> y_sub(allocator, stream, nobs * nb);
+    const int* map_ = map.data();
+    double* y_sub_ = y_sub.data();
+    thrust::for_each(thrust::cuda::par.on(stream), counting,
+                     counting + nobs * nb, [=] __device__(int idx) {
+                       int j = idx / nobs, i = idx % nobs;
+                       y_sub_[idx] = d_y[map_[j] * nobs + i];
+                     });
+
+    MLCommon::device_buffer<double> best_ic(allocator, stream, nb);
+    MLCommon::device_buffer<int> best_pq(allocator, stream, 2 * nb);
+    MLCommon::device_buffer<double> best_params(allocator, stream, N_max * nb);
+    MLCommon::device_buffer<double> cand_ic(allocator, stream, nb);
+    MLCommon::device_buffer<double> vs(allocator, stream, (nobs - dd) * nb);
+    thrust::fill(thrust::cuda::par.on(stream), best_ic.data(),
+                 best_ic.data() + nb, std::numeric_limits<double>::infinity());
+    CUDA_CHECK(cudaMemsetAsync(best_pq.data(), 0, sizeof(int) * 2 * nb,
+                               stream));
+    CUDA_CHECK(cudaMemsetAsync(best_params.data(), 0,
+                               sizeof(double) * N_max * nb, stream));
+    std::vector<int> niter(nb), status(nb);
+
+    // all the series are fitted at once for each candidate order
+    for (int pp = 0; pp <= max_p; pp++) {
+      for (int qq = 0; qq <= max_q; qq++) {
+        const int N = dd + pp + qq;
+        if (N == 0) continue;
+        MLCommon::device_buffer<double> mu(allocator, stream, nb);
+        MLCommon::device_buffer<double> ar(allocator, stream, pp * nb);
+        MLCommon::device_buffer<double> ma(allocator, stream, qq * nb);
+        MLCommon::device_buffer<double> params(allocator, stream, N * nb);
+        estimate_x0(handle, mu.data(), ar.data(), ma.data(), y_sub.data(), nb,
+                    nobs, pp, dd, qq);
+        pack(nb, pp, dd, qq, mu.data(), ar.data(), ma.data(), params.data(),
+             stream);
+        batched_fit(handle, y_sub.data(), nb, nobs, pp, dd, qq, params.data(),
+                    niter.data(), status.data(), max_iter, tol);
+
+        ARIMAOrder order = {pp, dd, qq, 0, 0, 0, 0, 0};
+        batched_loglike(handle, y_sub.data(), nb, nobs, order, params.data(),
+                        cand_ic.data(), vs.data(), false, false);
+        MLCommon::Metrics::Batched::information_criterion(
+          cand_ic.data(), cand_ic.data(),
+          static_cast<MLCommon::Metrics::IC_Type>(ic_type), N, nb, nobs - dd,
+          stream);
+
+        // keep the best model of each series; a failed fit yields NaN
+        double* best_ic_ = best_ic.data();
+        int* best_pq_ = best_pq.data();
+        double* best_params_ = best_params.data();
+        const double* cand_ic_ = cand_ic.data();
+        const double* params_ = params.data();
+        thrust::for_each(thrust::cuda::par.on(stream), counting,
+                         counting + nb, [=] __device__(int j) {
+                           if (!(cand_ic_[j] < best_ic_[j])) return;
+                           best_ic_[j] = cand_ic_[j];
+                           best_pq_[2 * j] = pp;
+                           best_pq_[2 * j + 1] = qq;
+                           for (int i = 0; i < N_max; i++) {
+                             best_params_[j * N_max + i] =
+                               i < N ? params_[j * N + i] : 0.0;
+                           }
+                         });
+      }
+    }
+
+    // scatter the best models back to their series
+    const double* best_params_ = best_params.data();
+    thrust::for_each(thrust::cuda::par.on(stream), counting,
+                     counting + N_max * nb, [=] __device__(int idx) {
+                       int j = idx / N_max, i = idx % N_max;
+                       d_params[map_[j] * N_max + i] = best_params_[idx];
+                     });
+    std::vector<int> best_pq_h(2 * nb);
+    std::vector<double> best_ic_h(nb);
+    MLCommon::updateHost(best_pq_h.data(), best_pq.data(), 2 * nb, stream);
+    MLCommon::updateHost(best_ic_h.data(), best_ic.data(), nb, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    for (int j = 0; j < nb; j++) {
+      p[map_h[j]] = best_pq_h[2 * j];
+      q[map_h[j]] = best_pq_h[2 * j + 1];
+      ic[map_h[j]] = best_ic_h[j];
+    }
+  }
+  ML::POP_RANGE();
+}
+
 }  // namespace ML
@@ -16,6 +16,7 @@
 
 #pragma once
 #include <cuml/cuml.hpp>
+#include <cuml/tsa/arima_common.h>
 #include <vector>
 
 namespace ML {
@@ -73,6 +74,102 @@ void batched_loglike(cumlHandle& handle, double* d_y, int num_batches, int nobs,
                      double* d_ma, double* loglike, double* d_vs,
                      bool trans = true, bool host_loglike = true);
 
+/**
+ * Compute the loglikelihood of the given parameter on the given time series
+ * in a batched context, for seasonal models with exogenous regressors:
+ * the regression on the exogenous variables is removed, then the series is
+ * differenced, centered by mu, and the Kalman filter runs on the reduced
+ * form ARMA(p + s P, q + s Q) of the seasonal polynomials.
+ *
+ * @param[in]  handle       cuML handle
+ * @param[in]  d_y          Series to fit: shape = (nobs, num_batches) and
+ *                          expects column major data layout. (device)
+ * @param[in]  num_batches  Number of time series
+ * @param[in]  nobs         Number of observations in a time series
+ * @param[in]  order        ARIMA order
+ * @param[in]  d_params     Parameters to evaluate, grouped by series, see
+ *                          ARIMAOrder (device)
+ * @param[out] loglike      Log-Likelihood of the model per series
+ * @param[out] d_vs         The residual between model and original signal.
+ *                          shape = (nobs - order.n_diff(), num_batches)
+ *                          (device)
+ * @param[in]  trans        Run `jones_transform` on params.
+ * @param[in]  host_loglike Whether loglike is a host pointer
+ * @param[in]  d_exog       Exogenous regressors, shape = (nobs, n_exog) per
+ *                          series, series after series (device)
+ * @param[in]  fp32         Run the Kalman filter in single precision, for
+ *                          well-conditioned models
+ */
+void batched_loglike(cumlHandle& handle, double* d_y, int num_batches, int nobs,
+                     const ARIMAOrder& order, double* d_params,
+                     double* loglike, double* d_vs, bool trans = true,
+                     bool host_loglike = true, const double* d_exog = nullptr,
+                     bool fp32 = false);
+
+/**
+ * Compute the loglikelihood and its analytic gradient with respect to the
+ * parameters, for non-seasonal models. See batched_kalman_loglike_grad.
+ *
+ * @param[in]  handle       cuML handle
+ * @param[in]  d_y          Series to fit: shape = (nobs, num_batches) and
+ *                          expects column major data layout. (device)
+ * @param[in]  num_batches  Number of time series
+ * @param[in]  nobs         Number of observations in a time series
+ * @param[in]  p            Number of AR parameters
+ * @param[in]  d            Difference parameter
+ * @param[in]  q            Number of MA parameters
+ * @param[in]  d_params     Parameters to evaluate group by series:
+ *                          [mu0, ar.., ma.., mu1, ..] (device)
+ * @param[out] d_loglike    Log-Likelihood of the model per series (device)
+ * @param[out] d_grad       Gradient of the log-likelihood with respect to
+ *                          d_params, grouped by series (device)
+ * @param[out] d_vs         The residual between model and original signal.
+ *                          shape = (nobs - d, num_batches) (device)
+ * @param[in]  trans        Run `jones_transform` on params.
+ */
+void batched_loglike_grad(cumlHandle& handle, double* d_y, int num_batches,
+                          int nobs, int p, int d, int q, double* d_params,
+                          double* d_loglike, double* d_grad, double* d_vs,
+                          bool trans = true);
+
+/**
+ * Fit ARIMA models to a batch of series by maximum likelihood, with a batched
+ * L-BFGS that stays on the device (see batched_min_lbfgs). The gradient of the
+ * log-likelihood is analytic for non-seasonal models without exogenous
+ * regressors, and computed by central finite differences otherwise.
+ *
+ * @param[in]    handle      cuML handle
+ * @param[in]    d_y         Series to fit: shape = (nobs, num_batches) and
+ *                           expects column major data layout. (device)
+ * @param[in]    num_batches Number of time series
+ * @param[in]    nobs        Number of observations in a time series
+ * @param[in]    p           Number of AR parameters
+ * @param[in]    d           Difference parameter
+ * @param[in]    q           Number of MA parameters
+ * @param[inout] d_params    Initial parameters, then the fitted ones, grouped
+ *                           by series: [mu0, ar.., ma.., mu1, ..] (device)
+ * @param[out]   niter       Number of iterations per series (host)
+ * @param[out]   status      Optimizer status per series, 0 on convergence,
+ *                           see GLM::OPT_RETCODE (host)
+ * @param[in]    max_iter    Maximum number of iterations
+ * @param[in]    tol         Tolerance on the norm of the gradient, relative
+ *                           to that of the parameters
+ * @param[in]    h           Finite-differencing step size
+ */
+void batched_fit(cumlHandle& handle, double* d_y, int num_batches, int nobs,
+                 int p, int d, int q, double* d_params, int* niter, int* status,
+                 int max_iter = 100, double tol = 1e-5, double h = 1e-9);
+
+/**
+ * Fit seasonal ARIMA models with exogenous regressors, see batched_fit above.
+ * The parameters are grouped as described in ARIMAOrder and d_exog is laid
+ * out as in the seasonal batched_loglike.
+ */
+void batched_fit(cumlHandle& handle, double* d_y, int num_batches, int nobs,
+                 const ARIMAOrder& order, double* d_params, int* niter,
+                 int* status, int max_iter = 100, double tol = 1e-5,
+                 double h = 1e-9, const double* d_exog = nullptr);
+
 /**
  * Batched in-sample prediction of a time-series given trend, AR, and MA
  * parameters.
@@ -183,4 +280,53 @@ void estimate_x0(cumlHandle& handle, double* d_mu, double* d_ar, double* d_ma,
                  const double* d_y, int num_batches, int nobs, int p, int d,
                  int q);
 
+/**
+ * Batched automatic order selection: the difference order of each series is
+ * chosen with the KPSS stationarity test, then all the orders
+ * (p, q) <= (max_p, max_q) are fitted to all the series of a difference
+ * order at once, and each series keeps the model of lowest information
+ * criterion.
+ *
+ * @param[in]  handle      cuML handle
+ * @param[in]  d_y         Series to fit: shape = (nobs, num_batches) and
+ *                         expects column major data layout. (device)
+ * @param[in]  num_batches Number of time series
+ * @param[in]  nobs        Number of observations in a time series
+ * @param[in]  max_p       Largest number of AR parameters tried
+ * @param[in]  max_q       Largest number of MA parameters tried
+ * @param[in]  ic_type     Information criterion: 0: AIC, 1: AICc, 2: BIC
+ * @param[out] p           Selected number of AR parameters per series (host)
+ * @param[out] d           Selected difference order per series, 0 or 1. The
+ *                         series that fail the test with d = 1 get d = 1
+ *                         (host)
+ * @param[out] q           Selected number of MA parameters per series (host)
+ * @param[out] d_params    Fitted parameters, [mu, ar.., ma..] of the selected
+ *                         order padded with zeros to 1 + max_p + max_q values
+ *                         per series (device)
+ * @param[out] ic          Information criterion of the selected models (host)
+ * @param[in]  max_iter    Maximum number of iterations of each fit
+ * @param[in]  tol         Tolerance of each fit, see batched_fit
+ */
+void auto_arima(cumlHandle& handle, double* d_y, int num_batches, int nobs,
+                int max_p, int max_q, int ic_type, int* p, int* d, int* q,
+                double* d_params, double* ic, int max_iter = 100,
+                double tol = 1e-5);
+
+/**
+ * Jones transform (or its inverse) of the seasonal ARIMA parameters grouped
+ * by series, see ARIMAOrder. The basic and the seasonal polynomials are
+ * transformed separately, their product then being stationary and
+ * invertible.
+ *
+ * @param[in]  handle      cuML handle
+ * @param[in]  order       ARIMA order
+ * @param[in]  num_batches Number of time series
+ * @param[in]  isInv       Do the inverse transform?
+ * @param[in]  d_params    Parameters grouped by series (device)
+ * @param[out] d_Tparams   Transformed parameters grouped by series (device)
+ */
+void batched_jones_transform(cumlHandle& handle, const ARIMAOrder& order,
+                             int num_batches, bool isInv,
+                             const double* d_params, double* d_Tparams);
+
 }  // namespace ML
@@ -33,6 +33,7 @@
 
 #include <cub/cub.cuh>
 
+#include <algorithm>
 #include <chrono>
 #include <ratio>
 
@@ -202,12 +203,159 @@ __global__ void batched_kalman_loop_kernel(double* ys, int nobs,
   }
 }
 
+//! Kalman loop for larger state dimensions. The threads of a block cooperate
+//! on a single series, whose matrices are kept in shared memory rather than in
+//! thread-local arrays that spill to local memory. The filter runs in DataT,
+//! float being enough for well-conditioned models.
+template <typename DataT>
+__global__ void batched_kalman_loop_shared_kernel(
+  double* ys, int nobs, double* T, double* Z, double* RRT, double* P,
+  double* alpha, int r, double* vs, double* Fs, double* sum_logFs) {
+  extern __shared__ char shared_buf[];
+  DataT* shared_mem = reinterpret_cast<DataT*>(shared_buf);
+  const int r2 = r * r;
+  DataT* s_RRT = shared_mem;
+  DataT* s_T = s_RRT + r2;
+  DataT* s_P = s_T + r2;
+  DataT* s_tmpA = s_P + r2;
+  DataT* s_tmpB = s_tmpA + r2;
+  DataT* s_Z = s_tmpB + r2;
+  DataT* s_alpha = s_Z + r;
+  DataT* s_K = s_alpha + r;
+  // the innovation and its variance of the current step
+  DataT* s_vF = s_K + r;
+
+  int bid = blockIdx.x;
+  int tid = threadIdx.x;
+  int nt = blockDim.x;
+
+  for (int i = tid; i < r2; i += nt) {
+    s_RRT[i] = RRT[bid * r2 + i];
+    s_T[i] = T[bid * r2 + i];
+    s_P[i] = P[bid * r2 + i];
+  }
+  for (int i = tid; i < r; i += nt) {
+    s_Z[i] = Z[bid * r + i];
+    s_alpha[i] = alpha[bid * r + i];
+  }
+  __syncthreads();
+
+  double bid_sum_logFs = 0.0;
+
+  for (int it = 0; it < nobs; it++) {
+    // 1. & 2.
+    if (tid == 0) {
+      DataT vs_it = DataT(ys[it + bid * nobs]) - s_alpha[0];
+      vs[it + bid * nobs] = vs_it;
+      Fs[it + bid * nobs] = s_P[0];
+      bid_sum_logFs += log(s_P[0]);
+      s_vF[0] = vs_it;
+      s_vF[1] = s_P[0];
+    }
+
+    // 3. tmpA = P*Z.T
+    for (int i = tid; i < r; i += nt) {
+      DataT sum = 0;
+      for (int j = 0; j < r; j++) sum += s_P[i + j * r] * s_Z[j];
+      s_tmpA[i] = sum;
+    }
+    __syncthreads();
+
+    // K = 1/Fs[it] * T*tmpA
+    // 4. alpha = T*alpha + K*vs[it], staged in tmpB
+    DataT vs_it = s_vF[0];
+    DataT _1_Fs = DataT(1) / s_vF[1];
+    for (int i = tid; i < r; i += nt) {
+      DataT sum_K = 0, sum_alpha = 0;
+      for (int j = 0; j < r; j++) {
+        sum_K += s_T[i + j * r] * s_tmpA[j];
+        sum_alpha += s_T[i + j * r] * s_alpha[j];
+      }
+      s_K[i] = _1_Fs * sum_K;
+      s_tmpB[i] = sum_alpha + s_K[i] * vs_it;
+    }
+    __syncthreads();
+
+    // 5. L = T - K*Z, stored in tmpA
+    for (int i = tid; i < r; i += nt) s_alpha[i] = s_tmpB[i];
+    for (int i = tid; i < r2; i += nt) {
+      s_tmpA[i] = s_T[i] - s_K[i % r] * s_Z[i / r];
+    }
+    __syncthreads();
+
+    // 6. P = T * P * L.transpose() + R * R.transpose();
+    // tmpB = P*L.T
+    for (int idx = tid; idx < r2; idx += nt) {
+      int i = idx % r, j = idx / r;
+      DataT sum = 0;
+      for (int k = 0; k < r; k++) sum += s_P[i + k * r] * s_tmpA[j + k * r];
+      s_tmpB[idx] = sum;
+    }
+    __syncthreads();
+
+    // P = T*tmpB + RRT
+    for (int idx = tid; idx < r2; idx += nt) {
+      int i = idx % r, j = idx / r;
+      DataT sum = 0;
+      for (int k = 0; k < r; k++) sum += s_T[i + k * r] * s_tmpB[k + j * r];
+      s_P[idx] = sum + s_RRT[idx];
+    }
+    __syncthreads();
+  }
+  if (tid == 0) sum_logFs[bid] = bid_sum_logFs;
+}
+
+//! State dimension from which a block cooperates on each series
+constexpr int KALMAN_SHARED_MIN_R = 4;
+
+template <typename DataT>
+void batched_kalman_loop_shared(double* ys, int nobs, const BatchedMatrix& T,
+                                const BatchedMatrix& Z,
+                                const BatchedMatrix& RRT,
+                                const BatchedMatrix& P0,
+                                const BatchedMatrix& alpha, int r, double* vs,
+                                double* Fs, double* sum_logFs) {
+  const int num_batches = T.batches();
+  auto stream = T.stream();
+  // one warp per series for the smaller states, up to 256 threads
+  int n_threads = std::min(256, MLCommon::alignTo(r * r, 32));
+  size_t shared_size = sizeof(DataT) * (5 * r * r + 3 * r + 2);
+  if (shared_size > 48 * 1024) {
+    // long seasonal periods: opt in to the larger shared memory
+    int device, max_shared;
+    CUDA_CHECK(cudaGetDevice(&device));
+    CUDA_CHECK(cudaDeviceGetAttribute(
+      &max_shared, cudaDevAttrMaxSharedMemoryPerBlockOptin, device));
+    ASSERT(shared_size <= max_shared,
+           "ERROR: Currently unsupported number of parameters (r).");
+    CUDA_CHECK(cudaFuncSetAttribute(
+      batched_kalman_loop_shared_kernel<DataT>,
+      cudaFuncAttributeMaxDynamicSharedMemorySize, shared_size));
+  }
+  batched_kalman_loop_shared_kernel<DataT>
+    <<<num_batches, n_threads, shared_size, stream>>>(
+      ys, nobs, T.raw_data(), Z.raw_data(), RRT.raw_data(), P0.raw_data(),
+      alpha.raw_data(), r, vs, Fs, sum_logFs);
+  CUDA_CHECK(cudaGetLastError());
+}
+
 void batched_kalman_loop(double* ys, int nobs, const BatchedMatrix& T,
                          const BatchedMatrix& Z, const BatchedMatrix& RRT,
                          const BatchedMatrix& P0, const BatchedMatrix& alpha,
-                         int r, double* vs, double* Fs, double* sum_logFs) {
+                         int r, double* vs, double* Fs, double* sum_logFs,
+                         bool fp32 = false) {
   const int num_batches = T.batches();
   auto stream = T.stream();
+  if (fp32) {
+    batched_kalman_loop_shared<float>(ys, nobs, T, Z, RRT, P0, alpha, r, vs,
+                                      Fs, sum_logFs);
+    return;
+  }
+  if (r >= KALMAN_SHARED_MIN_R) {
+    batched_kalman_loop_shared<double>(ys, nobs, T, Z, RRT, P0, alpha, r, vs,
+                                       Fs, sum_logFs);
+    return;
+  }
   dim3 numThreadsPerBlock(32, 1);
   dim3 numBlocks(MLCommon::ceildiv<int>(num_batches, numThreadsPerBlock.x), 1);
   if (r == 1) {
@@ -222,26 +370,6 @@ void batched_kalman_loop(double* ys, int nobs, const BatchedMatrix& T,
     batched_kalman_loop_kernel<3><<<numBlocks, numThreadsPerBlock, 0, stream>>>(
       ys, nobs, T.raw_data(), Z.raw_data(), RRT.raw_data(), P0.raw_data(),
       alpha.raw_data(), num_batches, vs, Fs, sum_logFs);
-  } else if (r == 4) {
-    batched_kalman_loop_kernel<4><<<numBlocks, numThreadsPerBlock, 0, stream>>>(
-      ys, nobs, T.raw_data(), Z.raw_data(), RRT.raw_data(), P0.raw_data(),
-      alpha.raw_data(), num_batches, vs, Fs, sum_logFs);
-  } else if (r == 5) {
-    batched_kalman_loop_kernel<5><<<numBlocks, numThreadsPerBlock, 0, stream>>>(
-      ys, nobs, T.raw_data(), Z.raw_data(), RRT.raw_data(), P0.raw_data(),
-      alpha.raw_data(), num_batches, vs, Fs, sum_logFs);
-  } else if (r == 6) {
-    batched_kalman_loop_kernel<6><<<numBlocks, numThreadsPerBlock, 0, stream>>>(
-      ys, nobs, T.raw_data(), Z.raw_data(), RRT.raw_data(), P0.raw_data(),
-      alpha.raw_data(), num_batches, vs, Fs, sum_logFs);
-  } else if (r == 7) {
-    batched_kalman_loop_kernel<7><<<numBlocks, numThreadsPerBlock, 0, stream>>>(
-      ys, nobs, T.raw_data(), Z.raw_data(), RRT.raw_data(), P0.raw_data(),
-      alpha.raw_data(), num_batches, vs, Fs, sum_logFs);
-  } else if (r == 8) {
-    batched_kalman_loop_kernel<8><<<numBlocks, numThreadsPerBlock, 0, stream>>>(
-      ys, nobs, T.raw_data(), Z.raw_data(), RRT.raw_data(), P0.raw_data(),
-      alpha.raw_data(), num_batches, vs, Fs, sum_logFs);
   } else {
     throw std::runtime_error(
       "ERROR: Currently unsupported number of parameters (r).");
@@ -295,7 +423,8 @@ void _batched_kalman_filter(cumlHandle& handle, double* d_ys, int nobs,
                             const BatchedMatrix& Zb, const BatchedMatrix& Tb,
                             const BatchedMatrix& Rb, int r, double* d_vs,
                             double* d_Fs, double* d_loglike, double* d_sigma2,
-                            bool initP_with_kalman_iterations = false) {
+                            bool initP_with_kalman_iterations = false,
+                            bool fp32 = false) {
   const size_t num_batches = Zb.batches();
   auto stream = handle.getStream();
 
@@ -360,7 +489,7 @@ void _batched_kalman_filter(cumlHandle& handle, double* d_ys, int nobs,
   // }
 
   batched_kalman_loop(d_ys, nobs, Tb, Zb, RRT, P, alpha, r, d_vs, d_Fs,
-                      d_sumlogFs);
+                      d_sumlogFs, fp32);
 
   // Finalize loglikelihood
   // 7. & 8.
@@ -437,7 +566,7 @@ void batched_kalman_filter(cumlHandle& handle, double* d_ys, int nobs,
                            const double* d_b_ma_params, int p, int q,
                            int num_batches, double* loglike, double* d_vs,
                            bool host_loglike,
-                           bool initP_with_kalman_iterations) {
+                           bool initP_with_kalman_iterations, bool fp32) {
   ML::PUSH_RANGE("batched_kalman_filter");
 
   const size_t ys_len = nobs;
@@ -475,7 +604,8 @@ void batched_kalman_filter(cumlHandle& handle, double* d_ys, int nobs,
   }
 
   _batched_kalman_filter(handle, d_ys, nobs, Zb, Tb, Rb, r, d_vs, d_Fs,
-                         d_loglike, d_sigma2, initP_with_kalman_iterations);
+                         d_loglike, d_sigma2, initP_with_kalman_iterations,
+                         fp32);
 
   if (host_loglike) {
     /* Tranfer log-likelihood device -> host */
@@ -490,6 +620,254 @@ void batched_kalman_filter(cumlHandle& handle, double* d_ys, int nobs,
   ML::POP_RANGE();
 }
 
+//! Kalman loop with the forward sensitivities of the log-likelihood to its
+//! parameters: a shift of the series (ys - c), the AR and the MA parameters,
+//! in this order. The threads of a block cooperate on a single series.
+//! dP0 holds the sensitivities of the initial covariance to the AR and MA
+//! parameters, r^2 x (p + q) per series.
+__global__ void batched_kalman_loop_grad_kernel(
+  const double* ys, int nobs, const double* T, const double* R,
+  const double* RRT, const double* P0, const double* dP0, int r, int p, int q,
+  double* vs, double* loglike, double* grad) {
+  extern __shared__ double shared_mem[];
+  const int r2 = r * r;
+  const int n_k = 1 + p + q;
+  double* s_T = shared_mem;
+  double* s_RRT = s_T + r2;
+  double* s_P = s_RRT + r2;
+  double* s_M = s_P + r2;
+  double* s_Pn = s_M + r2;
+  double* s_R = s_Pn + r2;
+  double* s_alpha = s_R + r;
+  double* s_an = s_alpha + r;
+  double* s_Tpz = s_an + r;
+  double* s_dP = s_Tpz + r;
+  double* s_W = s_dP + n_k * r2;
+  double* s_da = s_W + n_k * r2;
+  double* s_dan = s_da + n_k * r;
+  double* s_dK = s_dan + n_k * r;
+  double* s_dv = s_dK + n_k * r;
+  double* s_dF = s_dv + n_k;
+  // the innovation, its variance and the sum of v^2 / F
+  double* s_scal = s_dF + n_k;
+
+  int bid = blockIdx.x;
+  int tid = threadIdx.x;
+  int nt = blockDim.x;
+  const int n_dP0 = p + q;
+
+  for (int i = tid; i < r2; i += nt) {
+    s_T[i] = T[bid * r2 + i];
+    s_RRT[i] = RRT[bid * r2 + i];
+    s_P[i] = P0[bid * r2 + i];
+  }
+  for (int i = tid; i < r; i += nt) {
+    s_R[i] = R[bid * r + i];
+    s_alpha[i] = 0.0;
+  }
+  for (int idx = tid; idx < n_k * r2; idx += nt) {
+    int k = idx / r2;
+    s_dP[idx] = k == 0 ? 0.0 : dP0[(bid * n_dP0 + k - 1) * r2 + idx % r2];
+  }
+  for (int idx = tid; idx < n_k * r; idx += nt) s_da[idx] = 0.0;
+  __syncthreads();
+
+  double sum_logFs = 0.0, sum_v2_F = 0.0;
+  // the derivatives of these sums, accumulated by thread k
+  double dsum_logFs = 0.0, dsum_v2_F = 0.0;
+
+  for (int it = 0; it < nobs; it++) {
+    if (tid == 0) {
+      double v = ys[it + bid * nobs] - s_alpha[0];
+      vs[it + bid * nobs] = v;
+      s_scal[0] = v;
+      s_scal[1] = s_P[0];
+    }
+    for (int k = tid; k < n_k; k += nt) {
+      s_dv[k] = -s_da[k * r] - (k == 0 ? 1.0 : 0.0);
+      s_dF[k] = s_dP[k * r2];
+    }
+    // Tpz = T*P*Z.T
+    for (int i = tid; i < r; i += nt) {
+      double sum = 0.0;
+      for (int j = 0; j < r; j++) sum += s_T[i + j * r] * s_P[j];
+      s_Tpz[i] = sum;
+    }
+    __syncthreads();
+
+    double v = s_scal[0];
+    double F = s_scal[1];
+    if (tid == 0) {
+      sum_logFs += log(F);
+      sum_v2_F += v * v / F;
+    }
+    if (tid < n_k) {
+      dsum_logFs += s_dF[tid] / F;
+      dsum_v2_F += 2 * v * s_dv[tid] / F - v * v * s_dF[tid] / (F * F);
+    }
+    // alpha = T*alpha + K*v, K = Tpz / F
+    for (int i = tid; i < r; i += nt) {
+      double sum = 0.0;
+      for (int j = 0; j < r; j++) sum += s_T[i + j * r] * s_alpha[j];
+      s_an[i] = sum + s_Tpz[i] / F * v;
+    }
+    // the sensitivities of K and alpha
+    for (int idx = tid; idx < n_k * r; idx += nt) {
+      int k = idx / r, i = idx % r;
+      bool ar_k = k >= 1 && k <= p && i == k - 1;
+      double dTpz = ar_k ? F : 0.0;
+      double dTa = ar_k ? s_alpha[0] : 0.0;
+      for (int j = 0; j < r; j++) {
+        dTpz += s_T[i + j * r] * s_dP[k * r2 + j];
+        dTa += s_T[i + j * r] * s_da[k * r + j];
+      }
+      double dK = (dTpz - s_Tpz[i] / F * s_dF[k]) / F;
+      s_dK[idx] = dK;
+      s_dan[idx] = dTa + dK * v + s_Tpz[i] / F * s_dv[k];
+    }
+    // M = P*L.T, L = T - K*Z
+    for (int idx = tid; idx < r2; idx += nt) {
+      int a = idx % r, b = idx / r;
+      double sum = 0.0;
+      for (int c = 0; c < r; c++) sum += s_P[a + c * r] * s_T[b + c * r];
+      s_M[idx] = sum - s_P[a] * s_Tpz[b] / F;
+    }
+    __syncthreads();
+
+    // W = dP*L.T
+    for (int idx = tid; idx < n_k * r2; idx += nt) {
+      int k = idx / r2, a = idx % r, b = (idx % r2) / r;
+      const double* dP = s_dP + k * r2;
+      double sum = 0.0;
+      for (int c = 0; c < r; c++) sum += dP[a + c * r] * s_T[b + c * r];
+      s_W[idx] = sum - dP[a] * s_Tpz[b] / F;
+    }
+    // P = T*M + RRT
+    for (int idx = tid; idx < r2; idx += nt) {
+      int a = idx % r, b = idx / r;
+      double sum = 0.0;
+      for (int c = 0; c < r; c++) sum += s_T[a + c * r] * s_M[c + b * r];
+      s_Pn[idx] = sum + s_RRT[idx];
+    }
+    for (int i = tid; i < r; i += nt) s_alpha[i] = s_an[i];
+    for (int idx = tid; idx < n_k * r; idx += nt) s_da[idx] = s_dan[idx];
+    __syncthreads();
+
+    // dP = dT*M + T*W + T*P*dT.T - Tpz*dK.T + dRRT
+    for (int idx = tid; idx < n_k * r2; idx += nt) {
+      int k = idx / r2, a = idx % r, b = (idx % r2) / r;
+      const double* W = s_W + k * r2;
+      double sum = 0.0;
+      for (int c = 0; c < r; c++) sum += s_T[a + c * r] * W[c + b * r];
+      sum -= s_Tpz[a] * s_dK[k * r + b];
+      if (k >= 1 && k <= p) {
+        int i = k - 1;
+        if (a == i) sum += s_M[b * r];
+        if (b == i) sum += s_Tpz[a];
+      } else if (k > p) {
+        int j = k - p;
+        if (a == j) sum += s_R[b];
+        if (b == j) sum += s_R[a];
+      }
+      s_dP[idx] = sum;
+    }
+    for (int idx = tid; idx < r2; idx += nt) s_P[idx] = s_Pn[idx];
+    __syncthreads();
+  }
+
+  if (tid == 0) {
+    s_scal[2] = sum_v2_F;
+    loglike[bid] = -.5 * (sum_logFs + nobs * log(sum_v2_F / nobs)) -
+                   nobs / 2. * (log(2 * M_PI) + 1);
+  }
+  __syncthreads();
+  if (tid < n_k) {
+    grad[bid * n_k + tid] = -.5 * (dsum_logFs + nobs * dsum_v2_F / s_scal[2]);
+  }
+}
+
+void batched_kalman_loglike_grad(cumlHandle& handle, const double* d_ys,
+                                 int nobs, const double* d_b_ar_params,
+                                 const double* d_b_ma_params, int p, int q,
+                                 int num_batches, double* d_loglike,
+                                 double* d_grad, double* d_vs) {
+  ML::PUSH_RANGE(__func__);
+  auto cublasHandle = handle.getImpl().getCublasHandle();
+  auto stream = handle.getStream();
+  auto allocator = handle.getDeviceAllocator();
+  int r = std::max(p, q + 1);
+  int r2 = r * r;
+  int n_k = 1 + p + q;
+
+  BatchedMatrix Zb(1, r, num_batches, cublasHandle, allocator, stream, false);
+  BatchedMatrix Tb(r, r, num_batches, cublasHandle, allocator, stream, false);
+  BatchedMatrix Rb(r, 1, num_batches, cublasHandle, allocator, stream, false);
+  init_batched_kalman_matrices(handle, d_b_ar_params, d_b_ma_params,
+                               num_batches, p, q, r, Zb.raw_data(),
+                               Rb.raw_data(), Tb.raw_data());
+  BatchedMatrix RRT = b_gemm(Rb, Rb, false, true);
+
+  // P0 solves P0 = T P0 T' + RRT, and its sensitivity dP0 to a parameter
+  // dP0 = T dP0 T' + dT P0 T' + T P0 dT' + dRRT, with the same system
+  BatchedMatrix I_m_TxT =
+    BatchedMatrix::Identity(r2, num_batches, cublasHandle, allocator, stream) -
+    b_kron(Tb, Tb);
+  BatchedMatrix P0 = b_solve(I_m_TxT, RRT.vec()).mat(r, r);
+  MLCommon::device_buffer<double> dP0(allocator, stream,
+                                      r2 * (p + q) * num_batches);
+  if (p + q > 0) {
+    BatchedMatrix rhs(r2, p + q, num_batches, cublasHandle, allocator, stream,
+                      false);
+    double* d_rhs = rhs.raw_data();
+    const double* d_P0 = P0.raw_data();
+    const double* d_T = Tb.raw_data();
+    const double* d_R = Rb.raw_data();
+    auto counting = thrust::make_counting_iterator(0);
+    thrust::for_each(
+      thrust::cuda::par.on(stream), counting, counting + num_batches,
+      [=] __device__(int bid) {
+        const double* P0_b = d_P0 + bid * r2;
+        const double* T_b = d_T + bid * r2;
+        const double* R_b = d_R + bid * r;
+        for (int k = 0; k < p + q; k++) {
+          double* rhs_k = d_rhs + (bid * (p + q) + k) * r2;
+          for (int idx = 0; idx < r2; idx++) {
+            int a = idx % r, b = idx / r;
+            double val = 0.0;
+            if (k < p) {
+              // dT = e_k e_0'
+              for (int c = 0; c < r; c++) {
+                if (a == k) val += P0_b[c * r] * T_b[b + c * r];
+                if (b == k) val += T_b[a + c * r] * P0_b[c];
+              }
+            } else {
+              int j = k - p + 1;
+              if (a == j) val += R_b[b];
+              if (b == j) val += R_b[a];
+            }
+            rhs_k[idx] = val;
+          }
+        }
+      });
+    BatchedMatrix sol = b_solve(I_m_TxT, rhs);
+    MLCommon::copy(dP0.data(), sol.raw_data(), r2 * (p + q) * num_batches,
+                   stream);
+  }
+
+  // thread k accumulates the sensitivities to the parameter k
+  int n_threads = std::min(256, MLCommon::alignTo(n_k * r2, 32));
+  size_t shared_size = sizeof(double) * (5 * r2 + 4 * r + 2 * n_k * r2 +
+                                         3 * n_k * r + 2 * n_k + 3);
+  ASSERT(n_k <= n_threads && shared_size <= 48 * 1024,
+         "ERROR: Currently unsupported number of parameters for the gradient");
+  batched_kalman_loop_grad_kernel<<<num_batches, n_threads, shared_size,
+                                    stream>>>(
+    d_ys, nobs, Tb.raw_data(), Rb.raw_data(), RRT.raw_data(), P0.raw_data(),
+    dP0.data(), r, p, q, d_vs, d_loglike, d_grad);
+  CUDA_CHECK(cudaGetLastError());
+  ML::POP_RANGE();
+}
+
 template <typename T>
 std::ostream& operator<<(std::ostream& out, const std::vector<T>& v) {
   if (!v.empty()) {
@@ -46,13 +46,46 @@ namespace ML {
  * @param[in]  initP_with_kalman_it Initialize the Kalman filter covariance `P`
  *                                  with 1 or more kalman iterations instead of
  *                                  an analytical heuristic.
+ * @param[in]  fp32                 Run the filter loop in single precision,
+ *                                  for well-conditioned models
  */
 void batched_kalman_filter(cumlHandle& handle, double* d_ys_b, int nobs,
                            const double* d_b_ar_params,
                            const double* d_b_ma_params, int p, int q,
                            int num_batches, double* loglike, double* d_vs,
                            bool host_loglike = true,
-                           bool initP_with_kalman_iterations = false);
+                           bool initP_with_kalman_iterations = false,
+                           bool fp32 = false);
+
+/**
+ * The loglikelihood of the batched kalman filter and its analytic gradient,
+ * by forward sensitivities propagated along the filter, including those of
+ * the initial covariance.
+ *
+ * @param[in]  handle         cuml handle
+ * @param[in]  d_ys           The (batched) time series with shape
+ *                            (nobs, num_batches) in column major layout
+ *                            (device)
+ * @param[in]  nobs           The number of samples per time series
+ * @param[in]  d_b_ar_params  The AR parameters, in groups of size `p` (device)
+ * @param[in]  d_b_ma_params  The MA parameters, in groups of size `q` (device)
+ * @param[in]  p              The number of AR parameters
+ * @param[in]  q              The number of MA parameters
+ * @param[in]  num_batches    The number of series making up the batch
+ * @param[out] d_loglike      The loglikelihood of each series (device)
+ * @param[out] d_grad         The gradient of the loglikelihood of each series,
+ *                            in groups of size 1 + p + q: the derivative for
+ *                            a shift c of the series (ys - c), then those for
+ *                            the AR and MA parameters (device)
+ * @param[out] d_vs           The residual between the prediction and the
+ *                            original series, shape=(nobs, num_batches)
+ *                            (device)
+ */
+void batched_kalman_loglike_grad(cumlHandle& handle, const double* d_ys,
+                                 int nobs, const double* d_b_ar_params,
+                                 const double* d_b_ma_params, int p, int q,
+                                 int num_batches, double* d_loglike,
+                                 double* d_grad, double* d_vs);
 
 /**
  * Turns linear array of parameters into arrays of mu, ar, and ma parameters.
@@ -72,6 +105,25 @@ void batched_kalman_filter(cumlHandle& handle, double* d_ys_b, int nobs,
 void unpack(const double* d_params, double* d_mu, double* d_ar, double* d_ma,
             int batchSize, int p, int d, int q, cudaStream_t stream);
 
+/**
+ * Turns arrays of mu, ar, and ma parameters into a linear array of parameters
+ * grouped by batch. (using device arrays)
+ *
+ * @param[in]  batchSize Number of time series analyzed.
+ * @param[in]  p         Number of AR parameters
+ * @param[in]  d         Trend parameter
+ * @param[in]  q         Number of MA parameters
+ * @param[in]  d_mu      Trend parameter (device)
+ * @param[in]  d_ar      AR parameters (device)
+ * @param[in]  d_ma      MA parameters (device)
+ * @param[out] d_params  Linear array of all parameters grouped by batch
+ *                       [mu, ar, ma] (device)
+ * @param[in]  stream    CUDA stream
+ */
+void pack(int batchSize, int p, int d, int q, const double* d_mu,
+          const double* d_ar, const double* d_ma, double* d_params,
+          cudaStream_t stream);
+
 /**
  * Public interface to batched "jones transform" used in ARIMA to ensure
  * certain properties of the AR and MA parameters.
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <thrust/count.h>
+#include <thrust/execution_policy.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <common/device_buffer.hpp>
+#include <cuml/common/cuml_allocator.hpp>
+#include "cuda_utils.h"
+
+#include <glm/qn/qn_util.h>
+#include <glm/qn/simple_mat.h>
+
+namespace ML {
+
+//! Status of the series whose minimization is still running
+constexpr int BATCHED_LBFGS_RUNNING = -1;
+
+/**
+ * Minimizes independently the objectives of a batch of problems with L-BFGS,
+ * all the state staying on the device: each problem has its own history,
+ * its own backtracking (Armijo) line search and its own convergence test,
+ * and a problem that has converged or failed is frozen by a mask while the
+ * others go on. The only transfers to the host are the numbers of the
+ * problems still running, one per line search step.
+ *
+ * The function f evaluates all the problems at once:
+ *   f(x, fx, grad) with x of size n * batch_size, fx of size batch_size and
+ *   grad of size n * batch_size, or nullptr when only the values are needed.
+ *
+ * @param[in]    param      The solver settings: m, epsilon, max_iterations,
+ *                          max_linesearch, min_step, ftol and ls_dec are used
+ * @param[in]    f          The batched objective
+ * @param[inout] x          The initial points, then the minimizers, n per
+ *                          problem (device)
+ * @param[out]   fx         The objectives at x (device)
+ * @param[out]   niter      The number of iterations per problem (device)
+ * @param[out]   status     The GLM::OPT_RETCODE of each problem (device)
+ * @param[in]    n          The number of variables of a problem
+ * @param[in]    batch_size The number of problems
+ * @param[in]    allocator  Device allocator
+ * @param[in]    stream     CUDA stream
+ */
+template <typename Function>
+void batched_min_lbfgs(const GLM::LBFGSParam<double>& param, Function& f,
+                       double* x, double* fx, int* niter, int* status, int n,
+                       int batch_size,
+                       std::shared_ptr<MLCommon::deviceAllocator> allocator,
+                       cudaStream_t stream) {
+  ASSERT(param.check_param() == 0, "batched_min_lbfgs: invalid parameters");
+  using MLCommon::device_buffer;
+  const int m = param.m;
+  const int B = batch_size;
+  const double epsilon = param.epsilon;
+  const double ftol = param.ftol;
+  const double ls_dec = param.ls_dec;
+  const double min_step = param.min_step;
+
+  device_buffer<double> grad(allocator, stream, n * B);
+  device_buffer<double> x_new(allocator, stream, n * B);
+  device_buffer<double> grad_new(allocator, stream, n * B);
+  device_buffer<double> f_new(allocator, stream, B);
+  device_buffer<double> drt(allocator, stream, n * B);
+  device_buffer<double> step(allocator, stream, B);
+  device_buffer<double> dg(allocator, stream, B);
+  // the history of each problem, a ring of m pairs (s, y)
+  device_buffer<double> S(allocator, stream, m * n * B);
+  device_buffer<double> Y(allocator, stream, m * n * B);
+  device_buffer<double> rho(allocator, stream, m * B);
+  device_buffer<double> alpha(allocator, stream, m * B);
+  device_buffer<int> n_pairs(allocator, stream, B);
+  device_buffer<int> in_ls(allocator, stream, B);
+
+  double* grad_ = grad.data();
+  double* x_new_ = x_new.data();
+  double* grad_new_ = grad_new.data();
+  double* f_new_ = f_new.data();
+  double* drt_ = drt.data();
+  double* step_ = step.data();
+  double* dg_ = dg.data();
+  double* S_ = S.data();
+  double* Y_ = Y.data();
+  double* rho_ = rho.data();
+  double* alpha_ = alpha.data();
+  int* n_pairs_ = n_pairs.data();
+  int* in_ls_ = in_ls.data();
+
+  auto counting = thrust::make_counting_iterator(0);
+  auto running = [=] __device__(int s) { return s == BATCHED_LBFGS_RUNNING; };
+
+  f(x, fx, grad_);
+  thrust::for_each(
+    thrust::cuda::par.on(stream), counting, counting + B,
+    [=] __device__(int b) {
+      double xnorm = 0.0, gnorm = 0.0;
+      for (int i = 0; i < n; i++) {
+        xnorm += x[b * n + i] * x[b * n + i];
+        gnorm += grad_[b * n + i] * grad_[b * n + i];
+      }
+      niter[b] = 0;
+      n_pairs_[b] = 0;
+      status[b] = sqrt(gnorm) <= epsilon * max(1.0, sqrt(xnorm))
+                    ? GLM::OPT_SUCCESS
+                    : BATCHED_LBFGS_RUNNING;
+    });
+
+  for (int k = 1; k <= param.max_iterations || param.max_iterations == 0;
+       k++) {
+    // direction by the two-loop recursion, and the initial step
+    thrust::for_each(
+      thrust::cuda::par.on(stream), counting, counting + B,
+      [=] __device__(int b) {
+        int pairs = n_pairs_[b];
+        in_ls_[b] = status[b] == BATCHED_LBFGS_RUNNING;
+        for (int i = 0; i < n; i++) {
+          x_new_[b * n + i] = x[b * n + i];
+          drt_[b * n + i] = -grad_[b * n + i];
+        }
+        if (!in_ls_[b]) return;
+        int first = niter[b] - pairs;
+        for (int j = pairs - 1; j >= 0; j--) {
+          int pos = (first + j) % m;
+          const double* s = S_ + (b * m + pos) * n;
+          const double* y = Y_ + (b * m + pos) * n;
+          double a = 0.0;
+          for (int i = 0; i < n; i++) a += s[i] * drt_[b * n + i];
+          a *= rho_[b * m + pos];
+          alpha_[b * m + pos] = a;
+          for (int i = 0; i < n; i++) drt_[b * n + i] -= a * y[i];
+        }
+        if (pairs > 0) {
+          // scale by s'y / y'y of the latest pair
+          int pos = (first + pairs - 1) % m;
+          const double* y = Y_ + (b * m + pos) * n;
+          double yy = 0.0;
+          for (int i = 0; i < n; i++) yy += y[i] * y[i];
+          double gamma = 1.0 / (rho_[b * m + pos] * yy);
+          for (int i = 0; i < n; i++) drt_[b * n + i] *= gamma;
+        }
+        for (int j = 0; j < pairs; j++) {
+          int pos = (first + j) % m;
+          const double* s = S_ + (b * m + pos) * n;
+          const double* y = Y_ + (b * m + pos) * n;
+          double beta = 0.0;
+          for (int i = 0; i < n; i++) beta += y[i] * drt_[b * n + i];
+          beta *= rho_[b * m + pos];
+          for (int i = 0; i < n; i++)
+            drt_[b * n + i] += s[i] * (alpha_[b * m + pos] - beta);
+        }
+        double d_g = 0.0, dnorm = 0.0;
+        for (int i = 0; i < n; i++) {
+          d_g += drt_[b * n + i] * grad_[b * n + i];
+          dnorm += drt_[b * n + i] * drt_[b * n + i];
+        }
+        if (d_g >= 0) {
+          // not a descent direction: restart from steepest descent
+          n_pairs_[b] = pairs = 0;
+          d_g = 0.0;
+          dnorm = 0.0;
+          for (int i = 0; i < n; i++) {
+            drt_[b * n + i] = -grad_[b * n + i];
+            d_g -= grad_[b * n + i] * grad_[b * n + i];
+            dnorm += grad_[b * n + i] * grad_[b * n + i];
+          }
+        }
+        dg_[b] = d_g;
+        step_[b] = pairs == 0 ? min(1.0, 1.0 / sqrt(dnorm)) : 1.0;
+      });
+
+    // backtracking line search with the Armijo condition. The problems out
+    // of the line search keep their point, so their values are unchanged
+    for (int ls = 0; ls < param.max_linesearch; ls++) {
+      thrust::for_each(thrust::cuda::par.on(stream), counting, counting + B,
+                       [=] __device__(int b) {
+                         if (!in_ls_[b]) return;
+                         for (int i = 0; i < n; i++) {
+                           x_new_[b * n + i] =
+                             x[b * n + i] + step_[b] * drt_[b * n + i];
+                         }
+                       });
+      f(x_new_, f_new_, nullptr);
+      bool last = ls == param.max_linesearch - 1;
+      thrust::for_each(
+        thrust::cuda::par.on(stream), counting, counting + B,
+        [=] __device__(int b) {
+          if (!in_ls_[b]) return;
+          if (f_new_[b] <= fx[b] + ftol * step_[b] * dg_[b]) {
+            in_ls_[b] = 0;
+            return;
+          }
+          step_[b] *= ls_dec;
+          if (step_[b] < min_step || last) {
+            in_ls_[b] = 0;
+            status[b] = GLM::OPT_LS_FAILED;
+            for (int i = 0; i < n; i++) x_new_[b * n + i] = x[b * n + i];
+          }
+        });
+      int n_in_ls = thrust::count(thrust::cuda::par.on(stream), in_ls_,
+                                  in_ls_ + B, 1);
+      if (n_in_ls == 0) break;
+    }
+
+    // gradient at the new points, history update and convergence test
+    f(x_new_, f_new_, grad_new_);
+    thrust::for_each(
+      thrust::cuda::par.on(stream), counting, counting + B,
+      [=] __device__(int b) {
+        if (status[b] != BATCHED_LBFGS_RUNNING) return;
+        int pos = niter[b] % m;
+        double* s = S_ + (b * m + pos) * n;
+        double* y = Y_ + (b * m + pos) * n;
+        double sy = 0.0, yy = 0.0, xnorm = 0.0, gnorm = 0.0;
+        for (int i = 0; i < n; i++) {
+          s[i] = x_new_[b * n + i] - x[b * n + i];
+          y[i] = grad_new_[b * n + i] - grad_[b * n + i];
+          sy += s[i] * y[i];
+          yy += y[i] * y[i];
+          x[b * n + i] = x_new_[b * n + i];
+          grad_[b * n + i] = grad_new_[b * n + i];
+          xnorm += x[b * n + i] * x[b * n + i];
+          gnorm += grad_[b * n + i] * grad_[b * n + i];
+        }
+        fx[b] = f_new_[b];
+        niter[b]++;
+        if (sy > 1e-10 * yy) {
+          rho_[b * m + pos] = 1.0 / sy;
+          n_pairs_[b] = min(n_pairs_[b] + 1, m);
+        } else {
+          // skip the pair, keeping the ring contiguous
+          n_pairs_[b] = 0;
+        }
+        if (sqrt(gnorm) <= epsilon * max(1.0, sqrt(xnorm))) {
+          status[b] = GLM::OPT_SUCCESS;
+        }
+      });
+    int n_running = thrust::count_if(thrust::cuda::par.on(stream), status,
+                                     status + B, running);
+    if (n_running == 0) break;
+  }
+
+  thrust::for_each(thrust::cuda::par.on(stream), counting, counting + B,
+                   [=] __device__(int b) {
+                     if (status[b] == BATCHED_LBFGS_RUNNING)
+                       status[b] = GLM::OPT_MAX_ITERS_REACHED;
+                   });
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+}  // namespace ML
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "checkpoint.hpp"
+#include <stdio.h>
+#include <vector>
+#include "../../src_prims/utils.h"
+
+namespace ML {
+
+namespace {
+
+/** checkpoint_header starts a snapshot file; it is followed by the state */
+struct checkpoint_header {
+  static const int MAGIC = 0x434b5054;  // "CKPT"
+  static const int VERSION = 1;
+  int magic;
+  int version;
+  int iteration;
+  uint64_t tag;
+  uint64_t bytes;
+};
+
+}  // namespace
+
+checkpointWriter::checkpointWriter(const std::string& path, uint64_t tag)
+  : _path(path),
+    _tag(tag),
+    _staging(nullptr),
+    _capacity(0),
+    _busy(false) {
+  CUDA_CHECK(cudaGetDevice(&_device));
+  CUDA_CHECK(cudaEventCreateWithFlags(&_copied, cudaEventDisableTiming));
+}
+
+checkpointWriter::~checkpointWriter() {
+  // destructors should not throw exceptions, which is why CUDA_CHECK is not
+  // used
+  if (_writer.joinable()) _writer.join();
+  if (_staging != nullptr) cudaFreeHost(_staging);
+  cudaEventDestroy(_copied);
+}
+
+bool checkpointWriter::save(const void* data, size_t bytes, int iteration,
+                            cudaStream_t stream) {
+  if (_busy) return false;
+  wait();
+  if (bytes > _capacity) {
+    if (_staging != nullptr) CUDA_CHECK(cudaFreeHost(_staging));
+    _staging = nullptr;
+    CUDA_CHECK(cudaMallocHost(&_staging, bytes));
+    _capacity = bytes;
+  }
+  CUDA_CHECK(cudaMemcpyAsync(_staging, data, bytes, cudaMemcpyDeviceToHost,
+                             stream));
+  CUDA_CHECK(cudaEventRecord(_copied, stream));
+  _busy = true;
+  _writer = std::thread([this, bytes, iteration]() {
+    try {
+      write(bytes, iteration);
+    } catch (...) {
+      _error = std::current_exception();
+    }
+    _busy = false;
+  });
+  return true;
+}
+
+void checkpointWriter::wait() {
+  if (_writer.joinable()) _writer.join();
+  if (_error) {
+    std::exception_ptr error = _error;
+    _error = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void checkpointWriter::write(size_t bytes, int iteration) {
+  // the current device is per host thread
+  CUDA_CHECK(cudaSetDevice(_device));
+  CUDA_CHECK(cudaEventSynchronize(_copied));
+  checkpoint_header hdr;
+  hdr.magic = checkpoint_header::MAGIC;
+  hdr.version = checkpoint_header::VERSION;
+  hdr.iteration = iteration;
+  hdr.tag = _tag;
+  hdr.bytes = bytes;
+  std::string tmp = _path + ".tmp";
+  FILE* file = fopen(tmp.c_str(), "wb");
+  ASSERT(file != nullptr, "checkpoint: cannot open %s", tmp.c_str());
+  bool ok = fwrite(&hdr, sizeof(hdr), 1, file) == 1 &&
+            fwrite(_staging, 1, bytes, file) == bytes;
+  ok = fclose(file) == 0 && ok;
+  ASSERT(ok, "checkpoint: cannot write %s", tmp.c_str());
+  ASSERT(rename(tmp.c_str(), _path.c_str()) == 0,
+         "checkpoint: cannot rename %s to %s", tmp.c_str(), _path.c_str());
+}
+
+bool loadCheckpoint(const std::string& path, uint64_t tag, void* data,
+                    size_t bytes, int* iteration, cudaStream_t stream) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) return false;
+  checkpoint_header hdr;
+  std::vector<char> state(bytes);
+  bool ok = fread(&hdr, sizeof(hdr), 1, file) == 1 &&
+            hdr.magic == checkpoint_header::MAGIC &&
+            hdr.version == checkpoint_header::VERSION && hdr.tag == tag &&
+            hdr.bytes == bytes && fread(state.data(), 1, bytes, file) == bytes;
+  fclose(file);
+  ASSERT(ok, "checkpoint: %s is not a snapshot of this fit", path.c_str());
+  CUDA_CHECK(cudaMemcpyAsync(data, state.data(), bytes,
+                             cudaMemcpyHostToDevice, stream));
+  // state is pageable and freed on return
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  *iteration = hdr.iteration;
+  return true;
+}
+
+}  // end namespace ML
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_runtime.h>
+#include <stdint.h>
+#include <atomic>
+#include <exception>
+#include <string>
+#include <thread>
+
+namespace ML {
+
+/**
+ * @brief Periodic snapshots of the device state of an iterative fit, eg:
+ *        the centroids of k-means, for a fit killed by a preemption to
+ *        resume from its last snapshot rather than from scratch.
+ *
+ * save copies the state to pinned host memory on the stream of the fit, and
+ * a background thread waits for the copy and writes it to the file, so that
+ * the fit only pays for the device to host copy. A snapshot is written to a
+ * temporary file renamed over the previous snapshot, so that the file always
+ * holds a complete snapshot, and a snapshot requested while the previous one
+ * is still being written is skipped.
+ *
+ * The tag identifies the kind of state, eg: the algorithm, the type and the
+ * shape of its buffers, so that loadCheckpoint rejects the snapshot of
+ * another fit.
+ */
+class checkpointWriter {
+ public:
+  checkpointWriter(const std::string& path, uint64_t tag);
+  /** waits for the pending write, whose errors are then lost */
+  ~checkpointWriter();
+
+  /**
+   * Schedules the snapshot of the bytes bytes of the device buffer data,
+   * the state after iteration iterations.
+   * @return false when the snapshot is skipped
+   */
+  bool save(const void* data, size_t bytes, int iteration,
+            cudaStream_t stream);
+
+  /** waits for the pending write, and throws its error if it failed */
+  void wait();
+
+ private:
+  void write(size_t bytes, int iteration);
+
+  std::string _path;
+  uint64_t _tag;
+  int _device;
+  void* _staging;
+  size_t _capacity;
+  cudaEvent_t _copied;
+  std::thread _writer;
+  std::atomic<bool> _busy;
+  std::exception_ptr _error;
+};
+
+/**
+ * Reads into the device buffer data the snapshot written at path by a
+ * checkpointWriter of the same tag, of bytes bytes.
+ * @param iteration receives the iteration of the snapshot
+ * @return false when there is no file at path
+ */
+bool loadCheckpoint(const std::string& path, uint64_t tag, void* data,
+                    size_t bytes, int* iteration, cudaStream_t stream);
+
+}  // end namespace ML
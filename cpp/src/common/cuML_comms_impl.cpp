@@ -14,7 +14,12 @@
  * limitations under the License.
  */
 
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "common/cuml_comms_iface.hpp"
 #include "common/cuml_comms_int.hpp"
@@ -22,8 +27,36 @@
 
 namespace MLCommon {
 
+namespace {
+
+size_t datatypeSize(cumlCommunicator::datatype_t datatype) {
+  switch (datatype) {
+    case cumlCommunicator::CHAR:
+      return sizeof(char);
+    case cumlCommunicator::UINT8:
+      return sizeof(uint8_t);
+    case cumlCommunicator::INT:
+      return sizeof(int);
+    case cumlCommunicator::UINT:
+      return sizeof(unsigned int);
+    case cumlCommunicator::INT64:
+      return sizeof(int64_t);
+    case cumlCommunicator::UINT64:
+      return sizeof(uint64_t);
+    case cumlCommunicator::FLOAT:
+      return sizeof(float);
+    case cumlCommunicator::DOUBLE:
+      return sizeof(double);
+    case cumlCommunicator::HALF:
+      return 2;
+  }
+  return 0;
+}
+
+}  // namespace
+
 cumlCommunicator::cumlCommunicator(std::unique_ptr<cumlCommunicator_iface> impl)
-  : _impl(impl.release()) {
+  : _impl(impl.release()), _hierarchyMaxBytes(0) {
   ASSERT(nullptr != _impl.get(), "ERROR: Invalid cumlCommunicator_iface used!");
 }
 
@@ -56,12 +89,85 @@ void cumlCommunicator::waitall(int count, request_t array_of_requests[]) const {
   _impl->waitall(count, array_of_requests);
 }
 
+void cumlCommunicator::device_send(const void* buf, int size, int dest,
+                                   cudaStream_t stream) const {
+  _impl->device_send(buf, size, dest, stream);
+}
+
+void cumlCommunicator::device_recv(void* buf, int size, int source,
+                                   cudaStream_t stream) const {
+  _impl->device_recv(buf, size, source, stream);
+}
+
 void cumlCommunicator::allreduce(const void* sendbuff, void* recvbuff,
                                  int count, datatype_t datatype, op_t op,
                                  cudaStream_t stream) const {
+  if (_hierarchyMaxBytes > 0 &&
+      count * datatypeSize(datatype) <= _hierarchyMaxBytes) {
+    // the reduced data is only needed on the first rank of the node, whose
+    // recvbuff then holds the result to broadcast
+    _intraNode->reduce(sendbuff, recvbuff, count, datatype, op, 0, stream);
+    if (_intraNode->getRank() == 0) {
+      _interNode->allreduce(recvbuff, recvbuff, count, datatype, op, stream);
+    }
+    _intraNode->bcast(recvbuff, count, datatype, 0, stream);
+    return;
+  }
   _impl->allreduce(sendbuff, recvbuff, count, datatype, op, stream);
 }
 
+void cumlCommunicator::enableHierarchicalAllreduce(std::size_t maxBytes,
+                                                   cudaStream_t stream) {
+  if (maxBytes == 0) {
+    _hierarchyMaxBytes = 0;
+    return;
+  }
+  const int size = getSize(), rank = getRank();
+  const int nameBytes = HOST_NAME_MAX + 1;
+  // gather the host names of all the ranks through a one-off device buffer,
+  // the collectives only taking GPU accessible buffers
+  std::vector<char> names(size * nameBytes, 0);
+  char* myName = names.data() + rank * nameBytes;
+  ASSERT(gethostname(myName, nameBytes - 1) == 0, "ERROR: gethostname failed");
+  char* names_d;
+  CUDA_CHECK(cudaMalloc(&names_d, names.size()));
+  CUDA_CHECK(cudaMemcpyAsync(names_d + rank * nameBytes, myName, nameBytes,
+                             cudaMemcpyHostToDevice, stream));
+  _impl->allgather(names_d + rank * nameBytes, names_d, nameBytes, CHAR,
+                   stream);
+  CUDA_CHECK(cudaMemcpyAsync(names.data(), names_d, names.size(),
+                             cudaMemcpyDeviceToHost, stream));
+  status_t status = _impl->syncStream(stream);
+  CUDA_CHECK(cudaFree(names_d));
+  ASSERT(status == commStatusSuccess,
+         "ERROR: syncStream failed. This can be caused by a failed rank.");
+
+  // a node is identified by its first rank, the local rank being the number
+  // of ranks of the node before this one
+  auto sameNode = [&names](int r, int q) {
+    return strncmp(names.data() + r * nameBytes,
+                   names.data() + q * nameBytes, nameBytes) == 0;
+  };
+  int node = rank, localRank = 0, nNodes = 0;
+  for (int r = 0; r < size; ++r) {
+    int first = 0;
+    while (!sameNode(first, r)) ++first;
+    if (first == r) ++nNodes;
+    if (r < rank && sameNode(r, rank)) {
+      node = std::min(node, r);
+      ++localRank;
+    }
+  }
+  if (nNodes == 1 || nNodes == size) {
+    // a single level: the flat allreduce is as good
+    _hierarchyMaxBytes = 0;
+    return;
+  }
+  _intraNode = std::make_shared<cumlCommunicator>(commSplit(node, rank));
+  _interNode = std::make_shared<cumlCommunicator>(commSplit(localRank, rank));
+  _hierarchyMaxBytes = maxBytes;
+}
+
 void cumlCommunicator::bcast(void* buff, int count, datatype_t datatype,
                              int root, cudaStream_t stream) const {
   _impl->bcast(buff, count, datatype, root, stream);
@@ -92,6 +198,30 @@ void cumlCommunicator::reducescatter(const void* sendbuff, void* recvbuff,
   _impl->reducescatter(sendbuff, recvbuff, recvcount, datatype, op, stream);
 }
 
+void cumlCommunicator::alltoall(const void* sendbuff, void* recvbuff,
+                                int count, datatype_t datatype,
+                                cudaStream_t stream) const {
+  _impl->alltoall(sendbuff, recvbuff, count, datatype, stream);
+}
+
+void cumlCommunicator::alltoallv(const void* sendbuf, const int sendcounts[],
+                                 const int sdispls[], void* recvbuf,
+                                 const int recvcounts[], const int rdispls[],
+                                 datatype_t datatype,
+                                 cudaStream_t stream) const {
+  _impl->alltoallv(sendbuf, sendcounts, sdispls, recvbuf, recvcounts, rdispls,
+                   datatype, stream);
+}
+
+void cumlCommunicator::groupStart() const { _impl->groupStart(); }
+
+void cumlCommunicator::groupEnd() const { _impl->groupEnd(); }
+
+cumlCommunicator::status_t cumlCommunicator::syncEvent(
+  cudaEvent_t event) const {
+  return _impl->syncEvent(event);
+}
+
 template <>
 cumlCommunicator::datatype_t cumlCommunicator::getDataType<char>() const {
   return cumlCommunicator::CHAR;
@@ -16,6 +16,7 @@
 
 #include "cumlHandle.hpp"
 #include <cuml/common/cuml_allocator.hpp>
+#include <cuml/common/pooledAllocator.hpp>
 #include "../../src_prims/utils.h"
 
 //TODO: Delete CUBLAS_CHECK and CUSOLVER_CHECK once
@@ -172,6 +173,24 @@ void cumlHandle::setHostAllocator(std::shared_ptr<hostAllocator> allocator) {
 std::shared_ptr<hostAllocator> cumlHandle::getHostAllocator() const {
   return _impl->getHostAllocator();
 }
+memoryUsage cumlHandle::getDeviceMemoryUsage(const std::string& tag) const {
+  return _impl->getDeviceMemoryUsage(tag);
+}
+std::vector<std::string> cumlHandle::getDeviceMemoryTags() const {
+  return _impl->getDeviceMemoryTags();
+}
+void cumlHandle::resetDeviceMemoryUsage() { _impl->resetDeviceMemoryUsage(); }
+void cumlHandle::setGraphCapture(bool enable) {
+  _impl->setGraphCapture(enable);
+}
+bool cumlHandle::getGraphCapture() const { return _impl->getGraphCapture(); }
+void cumlHandle::clearGraphs() { _impl->clearGraphs(); }
+void cumlHandle::setProfiling(bool enable) { _impl->setProfiling(enable); }
+bool cumlHandle::getProfiling() const { return _impl->getProfiling(); }
+std::string cumlHandle::getProfileReport() const {
+  return _impl->getProfileReport();
+}
+void cumlHandle::resetProfile() { _impl->resetProfile(); }
 int cumlHandle::getNumInternalStreams() {
   return _impl->getNumInternalStreams();
 }
@@ -179,8 +198,8 @@ const cumlHandle_impl& cumlHandle::getImpl() const { return *_impl.get(); }
 
 cumlHandle_impl& cumlHandle::getImpl() { return *_impl.get(); }
 
-using MLCommon::defaultDeviceAllocator;
-using MLCommon::defaultHostAllocator;
+using MLCommon::pooledDeviceAllocator;
+using MLCommon::pooledHostAllocator;
 
 cumlHandle_impl::cumlHandle_impl(int n_streams)
   : _dev_id([]() -> int {
@@ -189,8 +208,12 @@ cumlHandle_impl::cumlHandle_impl(int n_streams)
       return cur_dev;
     }()),
     _num_streams(n_streams),
-    _deviceAllocator(std::make_shared<defaultDeviceAllocator>()),
-    _hostAllocator(std::make_shared<defaultHostAllocator>()),
+    _memoryTracker(std::make_shared<memoryTracker>()),
+    _deviceAllocator(std::make_shared<trackingDeviceAllocator>(
+      std::make_shared<pooledDeviceAllocator>(), _memoryTracker)),
+    _graphs(std::make_shared<graphCache>()),
+    _profiler(std::make_shared<phaseProfiler>()),
+    _hostAllocator(std::make_shared<pooledHostAllocator>()),
     _userStream(NULL) {
   createResources();
 }
@@ -209,10 +232,16 @@ const cudaDeviceProp& cumlHandle_impl::getDeviceProperties() const {
 
 void cumlHandle_impl::setDeviceAllocator(
   std::shared_ptr<deviceAllocator> allocator) {
-  _deviceAllocator = allocator;
+  // the allocations made through the previous allocator stay accounted to
+  // the same tracker, as that allocator still forwards their deallocation
+  auto tracking = std::dynamic_pointer_cast<trackingDeviceAllocator>(allocator);
+  if (tracking) allocator = tracking->getAllocator();
+  _deviceAllocator =
+    std::make_shared<trackingDeviceAllocator>(allocator, _memoryTracker);
 }
 
 std::shared_ptr<deviceAllocator> cumlHandle_impl::getDeviceAllocator() const {
+  if (_captureAllocator) return _captureAllocator;
   return _deviceAllocator;
 }
 
@@ -225,6 +254,112 @@ std::shared_ptr<hostAllocator> cumlHandle_impl::getHostAllocator() const {
   return _hostAllocator;
 }
 
+void cumlHandle_impl::pushMemoryTag(const std::string& tag) const {
+  _memoryTracker->pushTag(tag);
+}
+
+void cumlHandle_impl::popMemoryTag() const { _memoryTracker->popTag(); }
+
+memoryUsage cumlHandle_impl::getDeviceMemoryUsage(
+  const std::string& tag) const {
+  return _memoryTracker->usage(tag);
+}
+
+std::vector<std::string> cumlHandle_impl::getDeviceMemoryTags() const {
+  return _memoryTracker->tags();
+}
+
+void cumlHandle_impl::resetDeviceMemoryUsage() { _memoryTracker->reset(); }
+
+void cumlHandle_impl::setGraphCapture(bool enable) {
+  _graphs->setEnabled(enable);
+}
+
+bool cumlHandle_impl::getGraphCapture() const { return _graphs->enabled(); }
+
+void cumlHandle_impl::clearGraphs() { _graphs->clear(); }
+
+void cumlHandle_impl::runGraphed(const std::string& key,
+                                 const std::function<void()>& work) const {
+#if CUDART_VERSION >= 10010
+  cudaStream_t stream = _userStream;
+  if (!_graphs->enabled() || _captureAllocator || stream == 0 ||
+      _graphs->uncapturable(key)) {
+    work();
+    return;
+  }
+  if (_graphs->launch(key, stream)) return;
+
+  // eager run, recording the allocations
+  auto arena = std::make_shared<captureArena>(_deviceAllocator, stream);
+  _captureAllocator = arena;
+  try {
+    work();
+  } catch (...) {
+    _captureAllocator.reset();
+    throw;
+  }
+
+  // capture, replaying them
+  arena->replay();
+  cudaGraph_t graph = nullptr;
+  bool captured = false;
+  CUDA_CHECK(cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal));
+  try {
+    work();
+    captured = true;
+  } catch (...) {
+    // the results of the eager run stand, only the graph is given up
+  }
+  _captureAllocator.reset();
+  captured = cudaStreamEndCapture(stream, &graph) == cudaSuccess &&
+             captured && graph != nullptr && arena->complete();
+  cudaGraphExec_t exec = nullptr;
+  if (captured) {
+    captured =
+      cudaGraphInstantiate(&exec, graph, nullptr, nullptr, 0) == cudaSuccess;
+  }
+  if (graph != nullptr) CUDA_CHECK(cudaGraphDestroy(graph));
+  if (captured) {
+    _graphs->insert(key, exec, arena);
+  } else {
+    // clear the errors of the failed capture
+    cudaGetLastError();
+    _graphs->setUncapturable(key);
+  }
+#else
+  work();
+#endif
+}
+
+void cumlHandle_impl::setProfiling(bool enable) {
+  _profiler->setEnabled(enable);
+}
+
+bool cumlHandle_impl::getProfiling() const { return _profiler->enabled(); }
+
+std::string cumlHandle_impl::getProfileReport() const {
+  return _profiler->report();
+}
+
+std::vector<phaseProfiler::phaseStats> cumlHandle_impl::getProfileTimings()
+  const {
+  return _profiler->timings();
+}
+
+void cumlHandle_impl::resetProfile() { _profiler->reset(); }
+
+int cumlHandle_impl::beginPhase(const char* name) const {
+  // events cannot be timed from within a graph, the phases of the calls run
+  // through runGraphed are left out
+  if (_captureAllocator) return -1;
+  return _profiler->begin(name, _userStream);
+}
+
+void cumlHandle_impl::endPhase(int id) const {
+  _profiler->end(id, _userStream);
+}
+
 cublasHandle_t cumlHandle_impl::getCublasHandle() const {
   return _cublas_handle;
 }
@@ -339,25 +474,49 @@ void cumlHandle_impl::destroyResources() {
 
 HandleMap handleMap;
 
+HandleMap::HandleMap() : _nextSlot(0) {
+  for (int c = 0; c < N_CHUNKS; ++c) _chunks[c].store(nullptr);
+}
+
+HandleMap::~HandleMap() {
+  for (int c = 0; c < N_CHUNKS; ++c) delete[] _chunks[c].load();
+}
+
+HandleMap::Slot* HandleMap::findSlot(cumlHandle_t handle) const {
+  if (handle < 0) return nullptr;
+  int slot = handle % MAX_HANDLES;
+  Slot* chunk = _chunks[slot / CHUNK_SIZE].load(std::memory_order_acquire);
+  return chunk == nullptr ? nullptr : &chunk[slot % CHUNK_SIZE];
+}
+
 std::pair<cumlHandle_t, cumlError_t> HandleMap::createAndInsertHandle() {
   cumlError_t status = CUML_SUCCESS;
-  cumlHandle_t chosen_handle;
+  cumlHandle_t chosen_handle = INVALID_HANDLE;
+  ML::cumlHandle* handle_ptr = nullptr;
   try {
-    auto handle_ptr = new ML::cumlHandle();
-    bool inserted;
-    {
-      std::lock_guard<std::mutex> guard(_mapMutex);
-      cumlHandle_t initial_next = _nextHandle;
-      do {
-        // try to insert using next free handle identifier
-        chosen_handle = _nextHandle;
-        inserted = _handleMap.insert({chosen_handle, handle_ptr}).second;
-        _nextHandle += 1;
-      } while (!inserted && _nextHandle != initial_next);
+    handle_ptr = new ML::cumlHandle();
+    std::lock_guard<std::mutex> guard(_mapMutex);
+    int slot = -1;
+    if (!_freeSlots.empty()) {
+      slot = _freeSlots.back();
+      _freeSlots.pop_back();
+    } else if (_nextSlot < MAX_HANDLES) {
+      slot = _nextSlot;
+      if (slot % CHUNK_SIZE == 0) {
+        _chunks[slot / CHUNK_SIZE].store(new Slot[CHUNK_SIZE],
+                                         std::memory_order_release);
+      }
+      _nextSlot += 1;
     }
-    if (!inserted) {
+    if (slot >= 0) {
+      Slot& s = _chunks[slot / CHUNK_SIZE].load()[slot % CHUNK_SIZE];
+      chosen_handle = s.generation * MAX_HANDLES + slot;
+      // a lookup which sees the new ID sees the pointer
+      s.ptr.store(handle_ptr, std::memory_order_release);
+      s.id.store(chosen_handle, std::memory_order_release);
+      handle_ptr = nullptr;
+    } else {
       // no free handle identifier available
-      chosen_handle = INVALID_HANDLE;
       status = CUML_ERROR_UNKNOWN;
     }
   }
@@ -369,32 +528,38 @@ std::pair<cumlHandle_t, cumlError_t> HandleMap::createAndInsertHandle() {
   //}
   catch (...) {
     status = CUML_ERROR_UNKNOWN;
-    chosen_handle = CUML_ERROR_UNKNOWN;
+    chosen_handle = INVALID_HANDLE;
   }
+  delete handle_ptr;
   return std::pair<cumlHandle_t, cumlError_t>(chosen_handle, status);
 }
 
 std::pair<cumlHandle*, cumlError_t> HandleMap::lookupHandlePointer(
   cumlHandle_t handle) const {
-  std::lock_guard<std::mutex> guard(_mapMutex);
-  auto it = _handleMap.find(handle);
-  if (it == _handleMap.end()) {
-    return std::pair<cumlHandle*, cumlError_t>(nullptr, CUML_INVALID_HANDLE);
-  } else {
-    return std::pair<cumlHandle*, cumlError_t>(it->second, CUML_SUCCESS);
+  Slot* s = findSlot(handle);
+  if (s != nullptr && s->id.load(std::memory_order_acquire) == handle) {
+    cumlHandle* handle_ptr = s->ptr.load(std::memory_order_acquire);
+    // the slot was not destroyed meanwhile, as its ID would have changed
+    if (handle_ptr != nullptr &&
+        s->id.load(std::memory_order_acquire) == handle) {
+      return std::pair<cumlHandle*, cumlError_t>(handle_ptr, CUML_SUCCESS);
+    }
   }
+  return std::pair<cumlHandle*, cumlError_t>(nullptr, CUML_INVALID_HANDLE);
 }
 
 cumlError_t HandleMap::removeAndDestroyHandle(cumlHandle_t handle) {
   ML::cumlHandle* handle_ptr;
   {
     std::lock_guard<std::mutex> guard(_mapMutex);
-    auto it = _handleMap.find(handle);
-    if (it == _handleMap.end()) {
+    Slot* s = findSlot(handle);
+    if (s == nullptr || s->id.load() != handle) {
       return CUML_INVALID_HANDLE;
     }
-    handle_ptr = it->second;
-    _handleMap.erase(it);
+    s->id.store(INVALID_HANDLE, std::memory_order_release);
+    handle_ptr = s->ptr.exchange(nullptr);
+    s->generation = (s->generation + 1) % N_GENERATIONS;
+    _freeSlots.push_back(handle % MAX_HANDLES);
   }
   cumlError_t status = CUML_SUCCESS;
   try {
@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <climits>
+#include <functional>
 #include <mutex>
 #include <unordered_map>
 #include <utility>
@@ -32,6 +35,11 @@
 
 #include <cuml/common/cuml_allocator.hpp>
 
+#include "graphCache.hpp"
+#include "memoryTracker.hpp"
+#include "nvtx.hpp"
+#include "profiler.hpp"
+
 namespace ML {
 
 using MLCommon::deviceAllocator;
@@ -52,6 +60,46 @@ class cumlHandle_impl {
   void setHostAllocator(std::shared_ptr<hostAllocator> allocator);
   std::shared_ptr<hostAllocator> getHostAllocator() const;
 
+  void pushMemoryTag(const std::string& tag) const;
+  void popMemoryTag() const;
+  memoryUsage getDeviceMemoryUsage(const std::string& tag) const;
+  std::vector<std::string> getDeviceMemoryTags() const;
+  void resetDeviceMemoryUsage();
+
+  void setGraphCapture(bool enable);
+  bool getGraphCapture() const;
+  void clearGraphs();
+  /**
+   * @brief Run work, the stream-ordered operations of a call on the user
+   *        stream, through a CUDA graph when graph capture is enabled.
+   *
+   * The first run with a key is eager, its device allocations being held
+   * for the graph, then work is captured; the next runs with the key launch
+   * the graph. If the capture fails (eg: work synchronizes the host), the key
+   * is run eagerly from then on. Runs nested in a run are part of it, and
+   * the runs on the default stream, which cannot be captured, are eager.
+   *
+   * @param key    identifies what the kernels of work bake in (see graphKey)
+   * @param work   the call, which must issue the same operations, with the
+   *               same device allocations, on each run with the key
+   */
+  void runGraphed(const std::string& key,
+                  const std::function<void()>& work) const;
+
+  void setProfiling(bool enable);
+  bool getProfiling() const;
+  std::string getProfileReport() const;
+  /** the timings of getProfileReport, unformatted */
+  std::vector<phaseProfiler::phaseStats> getProfileTimings() const;
+  void resetProfile();
+  /**
+   * @brief Start timing the phase name on the user stream (see
+   *        detail::phaseScope)
+   * @return the id to end it with, -1 if profiling is disabled
+   */
+  int beginPhase(const char* name) const;
+  void endPhase(int id) const;
+
   cublasHandle_t getCublasHandle() const;
   cusolverDnHandle_t getcusolverDnHandle() const;
   cusparseHandle_t getcusparseHandle() const;
@@ -78,7 +126,12 @@ class cumlHandle_impl {
   cublasHandle_t _cublas_handle;
   cusolverDnHandle_t _cusolverDn_handle;
   cusparseHandle_t _cusparse_handle;
+  std::shared_ptr<memoryTracker> _memoryTracker;
   std::shared_ptr<deviceAllocator> _deviceAllocator;
+  /** while runGraphed records or captures, the allocator of the call */
+  mutable std::shared_ptr<captureArena> _captureAllocator;
+  std::shared_ptr<graphCache> _graphs;
+  std::shared_ptr<phaseProfiler> _profiler;
   std::shared_ptr<hostAllocator> _hostAllocator;
   cudaStream_t _userStream;
   cudaEvent_t _event;
@@ -91,11 +144,21 @@ class cumlHandle_impl {
 };
 
 /**
- * Map from integral cumlHandle_t identifiers to cumlHandle pointer protected
- * by a mutex for thread-safe access.
+ * Map from integral cumlHandle_t identifiers to cumlHandle pointer for
+ * thread-safe access. The lookups are lock-free, as the C API does one per
+ * call; the creations and destructions are serialized by a mutex.
+ *
+ * A handle ID is generation * MAX_HANDLES + slot: the pointers are in a table
+ * of slots, allocated by chunks which are only freed with the map, and the
+ * generation of a slot is bumped when its handle is destroyed, so that the ID
+ * of a destroyed handle stays invalid when the slot is reused.
  */
 class HandleMap {
  public:
+  HandleMap();
+
+  ~HandleMap();
+
   /**
      * @brief Creates new handle object with associated handle ID and insert into map.
      *
@@ -105,7 +168,8 @@ class HandleMap {
   std::pair<cumlHandle_t, cumlError_t> createAndInsertHandle();
 
   /**
-     * @brief Lookup pointer to handle object for handle ID in map.
+     * @brief Lookup pointer to handle object for handle ID in map, without
+     *        locking.
      *
      * @return std::pair with handle and error code. If error code is not CUML_SUCCESS
      *                   the handle is INVALID_HANDLE. Error code CUML_INAVLID_HANDLE
@@ -126,11 +190,27 @@ class HandleMap {
   static const cumlHandle_t INVALID_HANDLE =
     -1;  //!< sentinel value for invalid ID
 
+  static const int MAX_HANDLES = 1 << 16;  //!< max number of live handles
+
  private:
-  std::unordered_map<cumlHandle_t, cumlHandle*>
-    _handleMap;                  //!< map from ID to pointer
-  mutable std::mutex _mapMutex;  //!< mutex protecting the map
-  cumlHandle_t _nextHandle;      //!< value of next handle ID
+  static const int CHUNK_SIZE = 256;  //!< number of slots per chunk
+  static const int N_CHUNKS = MAX_HANDLES / CHUNK_SIZE;
+  static const int N_GENERATIONS = INT_MAX / MAX_HANDLES;
+
+  struct Slot {
+    Slot() : ptr(nullptr), id(INVALID_HANDLE), generation(0) {}
+
+    std::atomic<cumlHandle*> ptr;  //!< the handle, nullptr when free
+    std::atomic<cumlHandle_t> id;  //!< ID of the handle, set after ptr
+    int generation;                //!< of the next handle, under the mutex
+  };
+
+  Slot* findSlot(cumlHandle_t handle) const;
+
+  std::atomic<Slot*> _chunks[N_CHUNKS];  //!< chunks of the slots table
+  std::vector<int> _freeSlots;  //!< slots of the destroyed handles
+  int _nextSlot;                //!< first slot never used
+  std::mutex _mapMutex;         //!< mutex serializing the map updates
 };
 
 /// Static handle map instance (see cumlHandle.cpp)
@@ -155,6 +235,62 @@ class streamSyncer {
   const cumlHandle_impl& _handle;
 };
 
+/**
+ * @brief Scope of an algorithm call, or of any other section worth its own
+ *        NVTX range, to which the device memory allocated through the handle
+ *        is charged (see cumlHandle::getDeviceMemoryUsage)
+ */
+class memoryTagScope {
+ public:
+  memoryTagScope(const cumlHandle_impl& handle, const char* tag)
+    : _handle(handle) {
+    PUSH_RANGE(tag);
+    _handle.pushMemoryTag(tag);
+  }
+  ~memoryTagScope() {
+    _handle.popMemoryTag();
+    POP_RANGE();
+  }
+
+  memoryTagScope(const memoryTagScope& other) = delete;
+  memoryTagScope& operator=(const memoryTagScope& other) = delete;
+
+ private:
+  const cumlHandle_impl& _handle;
+};
+
+/**
+ * @brief Scope of an algorithm call or of one of its phases: an NVTX range,
+ *        a memory tag as with memoryTagScope and, when profiling is enabled,
+ *        a timed phase of the report of the handle
+ *
+ * The arguments after the name are those of nvtxRange.
+ * @code{.cpp}
+ * ML::detail::phaseScope scope(handle, "ML::Umap::Fit", "rows=%d", n);
+ * @endcode
+ */
+class phaseScope {
+ public:
+  template <typename... Args>
+  phaseScope(const cumlHandle_impl& handle, const char* name, Args... args)
+    : _range(name, args...), _handle(handle) {
+    _handle.pushMemoryTag(name);
+    _id = _handle.beginPhase(name);
+  }
+  ~phaseScope() {
+    _handle.endPhase(_id);
+    _handle.popMemoryTag();
+  }
+
+  phaseScope(const phaseScope& other) = delete;
+  phaseScope& operator=(const phaseScope& other) = delete;
+
+ private:
+  nvtxRange _range;
+  const cumlHandle_impl& _handle;
+  int _id;
+};
+
 }  // end namespace detail
 
 }  // end namespace ML
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/common/deviceGroup.hpp>
+#include <exception>
+#include <thread>
+#include "../../src_prims/utils.h"
+
+namespace ML {
+
+namespace {
+
+/** makes a device current for the lifetime of the object */
+class deviceScope {
+ public:
+  deviceScope(int device) {
+    CUDA_CHECK(cudaGetDevice(&_previous));
+    CUDA_CHECK(cudaSetDevice(device));
+  }
+  ~deviceScope() {
+    // destructors should not throw exceptions, which is why CUDA_CHECK is
+    // not used
+    cudaSetDevice(_previous);
+  }
+
+ private:
+  int _previous;
+};
+
+}  // namespace
+
+cumlDeviceGroup::cumlDeviceGroup(const std::vector<int>& devices,
+                                 int n_streams, bool enable_peer_access)
+  : _devices(devices) {
+  if (_devices.empty()) {
+    int n_devices = 0;
+    CUDA_CHECK(cudaGetDeviceCount(&n_devices));
+    for (int d = 0; d < n_devices; d++) _devices.push_back(d);
+  }
+  ASSERT(!_devices.empty(), "cumlDeviceGroup: no device");
+  int n = size();
+  for (int rank = 0; rank < n; rank++) {
+    // the handle takes the device current at its construction
+    deviceScope scope(_devices[rank]);
+    _handles.emplace_back(new cumlHandle(n_streams));
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+    _streams.push_back(stream);
+    _handles.back()->setStream(stream);
+  }
+  _peerAccess.assign(n * n, 0);
+  for (int rank = 0; rank < n; rank++) {
+    deviceScope scope(_devices[rank]);
+    for (int peer = 0; peer < n; peer++) {
+      if (_devices[peer] == _devices[rank]) {
+        _peerAccess[rank * n + peer] = 1;
+        continue;
+      }
+      int can = 0;
+      CUDA_CHECK(cudaDeviceCanAccessPeer(&can, _devices[rank], _devices[peer]));
+      if (!can || !enable_peer_access) continue;
+      cudaError_t status = cudaDeviceEnablePeerAccess(_devices[peer], 0);
+      if (status == cudaErrorPeerAccessAlreadyEnabled) {
+        // enabled before the group, eg: by another group; clear the error
+        cudaGetLastError();
+      } else {
+        CUDA_CHECK(status);
+      }
+      _peerAccess[rank * n + peer] = 1;
+    }
+  }
+}
+
+cumlDeviceGroup::~cumlDeviceGroup() {
+  // destructors should not throw exceptions, which is why CUDA_CHECK is not
+  // used
+  int previous = 0;
+  cudaGetDevice(&previous);
+  for (int rank = 0; rank < size(); rank++) {
+    cudaSetDevice(_devices[rank]);
+    cudaStreamSynchronize(_streams[rank]);
+    // the handles release their resources on their devices and streams
+    _handles[rank].reset();
+    cudaStreamDestroy(_streams[rank]);
+  }
+  cudaSetDevice(previous);
+}
+
+int cumlDeviceGroup::getDevice(int rank) const {
+  ASSERT(rank >= 0 && rank < size(), "cumlDeviceGroup: invalid rank %d",
+         rank);
+  return _devices[rank];
+}
+
+cumlHandle& cumlDeviceGroup::getHandle(int rank) const {
+  ASSERT(rank >= 0 && rank < size(), "cumlDeviceGroup: invalid rank %d",
+         rank);
+  return *_handles[rank];
+}
+
+cudaStream_t cumlDeviceGroup::getStream(int rank) const {
+  ASSERT(rank >= 0 && rank < size(), "cumlDeviceGroup: invalid rank %d",
+         rank);
+  return _streams[rank];
+}
+
+bool cumlDeviceGroup::canAccessPeer(int rank, int peer) const {
+  ASSERT(rank >= 0 && rank < size() && peer >= 0 && peer < size(),
+         "cumlDeviceGroup: invalid ranks %d, %d", rank, peer);
+  return _peerAccess[rank * size() + peer] != 0;
+}
+
+void cumlDeviceGroup::forEach(
+  const std::function<void(int, cumlHandle&)>& f) const {
+  std::vector<std::exception_ptr> errors(size());
+  std::vector<std::thread> threads;
+  for (int rank = 0; rank < size(); rank++) {
+    threads.emplace_back([this, &f, &errors, rank]() {
+      try {
+        // the current device is per host thread
+        CUDA_CHECK(cudaSetDevice(_devices[rank]));
+        f(rank, *_handles[rank]);
+      } catch (...) {
+        errors[rank] = std::current_exception();
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+  for (auto& e : errors) {
+    if (e) std::rethrow_exception(e);
+  }
+}
+
+void cumlDeviceGroup::synchronize() const {
+  for (auto s : _streams) CUDA_CHECK(cudaStreamSynchronize(s));
+}
+
+}  // end namespace ML
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_runtime.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <cuml/common/cuml_allocator.hpp>
+#include <cuml/common/utils.hpp>
+
+namespace ML {
+
+using MLCommon::deviceAllocator;
+
+/**
+ * @brief deviceAllocator holding the workspace of a captured call for as long
+ *        as its graph lives.
+ *
+ * While recording, during the eager run that precedes a capture, the blocks
+ * are allocated from the underlying allocator and their deallocation is
+ * deferred. While replaying, during the capture itself, the same requests
+ * get the same blocks back in the same order, so that the captured kernels
+ * address memory which stays valid, and no CUDA call is made that the
+ * capture would forbid. A request that does not match the recording throws
+ * and aborts the capture.
+ */
+class captureArena : public deviceAllocator {
+ public:
+  captureArena(std::shared_ptr<deviceAllocator> allocator, cudaStream_t stream)
+    : _allocator(allocator), _stream(stream), _replaying(false), _next(0) {}
+
+  virtual void* allocate(std::size_t n, cudaStream_t stream) {
+    if (!_replaying) {
+      void* p = _allocator->allocate(n, stream);
+      _blocks.push_back(std::make_pair(p, n));
+      return p;
+    }
+    ASSERT(_next < _blocks.size() && _blocks[_next].second == n,
+           "captureArena: allocation of %zu bytes not seen while recording",
+           n);
+    return _blocks[_next++].first;
+  }
+
+  virtual void deallocate(void*, std::size_t, cudaStream_t) {}
+
+  /** start handing out the recorded blocks again, from the first one */
+  void replay() {
+    _replaying = true;
+    _next = 0;
+  }
+
+  /** whether the replay has made all the recorded requests */
+  bool complete() const { return _next == _blocks.size(); }
+
+  /**
+   * release the blocks, stream-ordered after the work of the stream of the
+   * capture, the callers making sure that no replay is still running
+   */
+  virtual ~captureArena() {
+    for (auto& b : _blocks) _allocator->deallocate(b.first, b.second, _stream);
+  }
+
+ private:
+  std::shared_ptr<deviceAllocator> _allocator;
+  cudaStream_t _stream;
+  bool _replaying;
+  std::size_t _next;
+  std::vector<std::pair<void*, std::size_t>> _blocks;
+};
+
+/**
+ * @brief The CUDA graphs of the calls captured on a cumlHandle, by key.
+ *
+ * A key identifies everything that the captured kernels have baked in: the
+ * call, its shapes, the addresses of its inputs and outputs and its host
+ * scalars (see graphKey). The oldest graph is evicted once maxGraphs are
+ * cached. Keys whose capture failed are remembered so that the calls are
+ * simply run eagerly from then on.
+ */
+class graphCache {
+ public:
+  graphCache(std::size_t maxGraphs = 64)
+    : _maxGraphs(maxGraphs), _enabled(false) {}
+
+  void setEnabled(bool enabled) { _enabled = enabled; }
+  bool enabled() const { return _enabled; }
+
+  /** launch the graph of key on stream, false if there is none */
+  bool launch(const std::string& key, cudaStream_t stream) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _graphs.find(key);
+    if (it == _graphs.end()) return false;
+    CUDA_CHECK(cudaGraphLaunch(it->second->exec, stream));
+    CUDA_CHECK(cudaEventRecord(it->second->done, stream));
+    return true;
+  }
+
+  bool uncapturable(const std::string& key) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _uncapturable.count(key) > 0;
+  }
+
+  void setUncapturable(const std::string& key) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _uncapturable.insert(key);
+  }
+
+  /** take ownership of the graph of key and of the arena it addresses */
+  void insert(const std::string& key, cudaGraphExec_t exec,
+              std::shared_ptr<captureArena> arena) {
+    std::unique_ptr<entry> e(new entry(exec, arena));
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_graphs.count(key) > 0) return;
+    if (_graphs.size() >= _maxGraphs) {
+      _graphs.erase(_order.front());
+      _order.pop_front();
+    }
+    _order.push_back(key);
+    _graphs[key] = std::move(e);
+  }
+
+  /** destroy the graphs, after their last launches are done */
+  void clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _graphs.clear();
+    _order.clear();
+    _uncapturable.clear();
+  }
+
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _graphs.size();
+  }
+
+ private:
+  struct entry {
+    cudaGraphExec_t exec;
+    cudaEvent_t done;
+    std::shared_ptr<captureArena> arena;
+
+    entry(cudaGraphExec_t e, std::shared_ptr<captureArena> a)
+      : exec(e), done(nullptr), arena(a) {
+      CUDA_CHECK(cudaEventCreateWithFlags(&done, cudaEventDisableTiming));
+    }
+    ~entry() {
+      // destructors should not throw exceptions, which is why CUDA_CHECK is
+      // not used
+      cudaEventSynchronize(done);
+      cudaEventDestroy(done);
+      cudaGraphExecDestroy(exec);
+    }
+  };
+
+  std::size_t _maxGraphs;
+  bool _enabled;
+  std::unordered_map<std::string, std::unique_ptr<entry>> _graphs;
+  /** keys of the graphs, oldest first */
+  std::list<std::string> _order;
+  std::unordered_set<std::string> _uncapturable;
+  mutable std::mutex _mutex;
+};
+
+namespace detail {
+
+inline void appendKey(std::string& key) {}
+
+template <typename Arg, typename... Args>
+void appendKey(std::string& key, const Arg& arg, const Args&... args) {
+  static_assert(std::is_trivially_copyable<Arg>::value,
+                "graphKey: arguments must be trivially copyable");
+  key.append(reinterpret_cast<const char*>(&arg), sizeof(Arg));
+  appendKey(key, args...);
+}
+
+}  // end namespace detail
+
+/**
+ * @brief Key of a captured call: its name followed by the bytes of the
+ *        arguments that its kernels depend on, pointers and host scalars
+ */
+template <typename... Args>
+std::string graphKey(const char* name, const Args&... args) {
+  std::string key(name);
+  key.push_back('\0');
+  detail::appendKey(key, args...);
+  return key;
+}
+
+}  // end namespace ML
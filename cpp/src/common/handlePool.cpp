@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/common/handlePool.hpp>
+#include "../../src_prims/utils.h"
+
+namespace ML {
+
+cumlHandlePool::lease::lease(cumlHandlePool* pool, cumlHandle* handle)
+  : _pool(pool), _handle(handle) {}
+
+cumlHandlePool::lease::lease(lease&& other)
+  : _pool(other._pool), _handle(other._handle) {
+  other._pool = nullptr;
+  other._handle = nullptr;
+}
+
+cumlHandlePool::lease& cumlHandlePool::lease::operator=(lease&& other) {
+  if (this != &other) {
+    if (_pool != nullptr) _pool->release(_handle);
+    _pool = other._pool;
+    _handle = other._handle;
+    other._pool = nullptr;
+    other._handle = nullptr;
+  }
+  return *this;
+}
+
+cumlHandlePool::lease::~lease() {
+  if (_pool != nullptr) _pool->release(_handle);
+}
+
+void cumlHandlePool::lease::synchronize() const {
+  CUDA_CHECK(cudaStreamSynchronize(_handle->getStream()));
+}
+
+cumlHandlePool::cumlHandlePool(int n_handles, int n_streams,
+                               std::shared_ptr<deviceAllocator> device_alloc,
+                               std::shared_ptr<hostAllocator> host_alloc) {
+  ASSERT(n_handles > 0, "cumlHandlePool: n_handles must be positive");
+  for (int i = 0; i < n_handles; i++) {
+    _handles.emplace_back(new cumlHandle(n_streams));
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+    _streams.push_back(stream);
+    _handles.back()->setStream(stream);
+  }
+  // the allocators of the first handle, unless given, serve all of them
+  _deviceAllocator = device_alloc ? device_alloc
+                                  : _handles[0]->getDeviceAllocator();
+  _hostAllocator = host_alloc ? host_alloc : _handles[0]->getHostAllocator();
+  for (auto& h : _handles) {
+    h->setDeviceAllocator(_deviceAllocator);
+    h->setHostAllocator(_hostAllocator);
+    _free.push_back(h.get());
+  }
+}
+
+cumlHandlePool::~cumlHandlePool() {
+  for (auto s : _streams) {
+    // destructors should not throw exceptions, which is why CUDA_CHECK is
+    // not used
+    cudaStreamSynchronize(s);
+  }
+  // the handles release their resources on their streams
+  _handles.clear();
+  for (auto s : _streams) cudaStreamDestroy(s);
+}
+
+cumlHandlePool::lease cumlHandlePool::acquire() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _freed.wait(lock, [this]() { return !_free.empty(); });
+  cumlHandle* handle = _free.back();
+  _free.pop_back();
+  return lease(this, handle);
+}
+
+int cumlHandlePool::available() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return int(_free.size());
+}
+
+void cumlHandlePool::release(cumlHandle* handle) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _free.push_back(handle);
+  }
+  _freed.notify_one();
+}
+
+}  // end namespace ML
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuml/common/matrixView.hpp>
+
+#include "common/cumlHandle.hpp"
+#include "common/device_buffer.hpp"
+#include "matrix/strided_copy.h"
+
+namespace ML {
+namespace detail {
+
+/**
+ * @brief The matrix of a view as a contiguous matrix of the layout that an
+ *        implementation works on: the data of the view itself when it has
+ *        that layout already, else a copy into buf, on the user stream.
+ *
+ * @param[in]  handle    the handle of the call
+ * @param[in]  view      the input matrix
+ * @param[in]  rowMajor  the layout wanted, row-major or column-major
+ * @param[out] buf       storage of the copy, if one is needed
+ * @return the data, to be read while buf lives
+ */
+template <typename T>
+const T* contiguous(const cumlHandle_impl& handle,
+                    const matrixView<const T>& view, bool rowMajor,
+                    MLCommon::device_buffer<T>& buf) {
+  ASSERT(view.rows >= 0 && view.cols >= 0, "matrixView: invalid shape");
+  if (rowMajor ? view.isRowMajor() : view.isColMajor()) return view.data;
+  cudaStream_t stream = handle.getStream();
+  buf.resize(size_t(view.rows) * view.cols, stream);
+  int64_t rowStride = rowMajor ? view.cols : 1;
+  int64_t colStride = rowMajor ? 1 : view.rows;
+  MLCommon::Matrix::stridedCopy(buf.data(), rowStride, colStride, view.data,
+                                view.rowStride, view.colStride, view.rows,
+                                view.cols, stream);
+  return buf.data();
+}
+
+}  // end namespace detail
+}  // end namespace ML
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cuml/cuml.hpp>
+
+#include <cuml/common/cuml_allocator.hpp>
+
+namespace ML {
+
+using MLCommon::deviceAllocator;
+
+/**
+ * @brief Accounting of the device memory of a cumlHandle, in total and per
+ *        tag.
+ *
+ * The tags form a stack, pushed and popped around algorithm calls or NVTX
+ * ranges (see detail::memoryTagScope). An allocation is charged to the total
+ * and to every tag on the stack when it is made, and is released from the
+ * same ones whenever it is deallocated, so the peak of a tag is that of the
+ * memory allocated within its scope, nested scopes included.
+ *
+ * Thread-safe.
+ */
+class memoryTracker {
+ public:
+  memoryTracker() { tagId(""); }
+
+  void pushTag(const std::string& tag) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tagStack.push_back(tagId(tag));
+  }
+
+  void popTag() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_tagStack.empty()) _tagStack.pop_back();
+  }
+
+  void allocated(void* p, std::size_t n) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    charge(0, n);
+    for (auto id : _tagStack) charge(id, n);
+    _allocations[p] = allocation{n, _tagStack};
+  }
+
+  void deallocated(void* p) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _allocations.find(p);
+    if (it == _allocations.end()) return;
+    std::size_t n = it->second.bytes;
+    _usage[0].bytesInUse -= n;
+    for (auto id : it->second.tags) _usage[id].bytesInUse -= n;
+    _allocations.erase(it);
+  }
+
+  /** usage of a tag, "" for the total, all zeros for an unknown tag */
+  memoryUsage usage(const std::string& tag) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _tagIds.find(tag);
+    return it == _tagIds.end() ? memoryUsage() : _usage[it->second];
+  }
+
+  /** tags seen so far, in the order of their first use */
+  std::vector<std::string> tags() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return std::vector<std::string>(_tagNames.begin() + 1, _tagNames.end());
+  }
+
+  /** restart the peaks from the current usage and the counts from zero */
+  void reset() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& u : _usage) {
+      u.peakBytesInUse = u.bytesInUse;
+      u.nAllocations = 0;
+    }
+  }
+
+ private:
+  struct allocation {
+    std::size_t bytes;
+    std::vector<int> tags;
+  };
+
+  int tagId(const std::string& tag) {
+    auto it = _tagIds.find(tag);
+    if (it != _tagIds.end()) return it->second;
+    int id = int(_usage.size());
+    _tagIds[tag] = id;
+    _tagNames.push_back(tag);
+    _usage.push_back(memoryUsage());
+    return id;
+  }
+
+  void charge(int id, std::size_t n) {
+    auto& u = _usage[id];
+    u.bytesInUse += n;
+    u.peakBytesInUse = std::max(u.peakBytesInUse, u.bytesInUse);
+    u.nAllocations++;
+  }
+
+  std::unordered_map<std::string, int> _tagIds;
+  /** by tag id, the total being id 0 */
+  std::vector<std::string> _tagNames;
+  std::vector<memoryUsage> _usage;
+  std::vector<int> _tagStack;
+  std::unordered_map<void*, allocation> _allocations;
+  mutable std::mutex _mutex;
+};
+
+/**
+ * @brief deviceAllocator reporting the allocations and deallocations made
+ *        through it to a memoryTracker before forwarding them
+ */
+class trackingDeviceAllocator : public deviceAllocator {
+ public:
+  trackingDeviceAllocator(std::shared_ptr<deviceAllocator> allocator,
+                          std::shared_ptr<memoryTracker> tracker)
+    : _allocator(allocator), _tracker(tracker) {}
+
+  virtual void* allocate(std::size_t n, cudaStream_t stream) {
+    void* p = _allocator->allocate(n, stream);
+    _tracker->allocated(p, n);
+    return p;
+  }
+
+  virtual void deallocate(void* p, std::size_t n, cudaStream_t stream) {
+    _tracker->deallocated(p);
+    _allocator->deallocate(p, n, stream);
+  }
+
+  /** the allocator this one forwards to */
+  std::shared_ptr<deviceAllocator> getAllocator() const { return _allocator; }
+
+  virtual ~trackingDeviceAllocator() {}
+
+ private:
+  std::shared_ptr<deviceAllocator> _allocator;
+  std::shared_ptr<memoryTracker> _tracker;
+};
+
+}  // end namespace ML
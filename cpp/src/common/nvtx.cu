@@ -15,7 +15,9 @@
  */
 
 #include "nvtx.hpp"
+#include <stdarg.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <mutex>
 #include <string>
@@ -136,15 +138,47 @@ uint32_t generateNextColor(const std::string &tag) {
 
 #include <nvToolsExt.h>
 
-void PUSH_RANGE(const char *name) {
+/** the nvtx domain of all the ranges of cuML */
+nvtxDomainHandle_t cumlDomain() {
+  static nvtxDomainHandle_t domain = nvtxDomainCreateA("cuML");
+  return domain;
+}
+
+nvtxEventAttributes_t rangeAttributes(const char *name, const char *message) {
   nvtxEventAttributes_t eventAttrib = {0};
   eventAttrib.version = NVTX_VERSION;
   eventAttrib.size = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
   eventAttrib.colorType = NVTX_COLOR_ARGB;
   eventAttrib.color = generateNextColor(name);
   eventAttrib.messageType = NVTX_MESSAGE_TYPE_ASCII;
-  eventAttrib.message.ascii = name;
-  nvtxRangePushEx(&eventAttrib);
+  eventAttrib.message.ascii = message;
+  return eventAttrib;
+}
+
+void PUSH_RANGE(const char *name) {
+  nvtxEventAttributes_t eventAttrib = rangeAttributes(name, name);
+  nvtxDomainRangePushEx(cumlDomain(), &eventAttrib);
+}
+
+void PUSH_RANGE(const char *name, int64_t payload) {
+  nvtxEventAttributes_t eventAttrib = rangeAttributes(name, name);
+  eventAttrib.payloadType = NVTX_PAYLOAD_TYPE_INT64;
+  eventAttrib.payload.llValue = payload;
+  nvtxDomainRangePushEx(cumlDomain(), &eventAttrib);
+}
+
+void PUSH_RANGE_MSG(const char *name, const char *format, ...) {
+  char message[256];
+  int len = snprintf(message, sizeof(message), "%s ", name);
+  if (len > 0 && size_t(len) < sizeof(message)) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message + len, sizeof(message) - len, format, args);
+    va_end(args);
+  }
+  // the message is copied by nvtx
+  nvtxEventAttributes_t eventAttrib = rangeAttributes(name, message);
+  nvtxDomainRangePushEx(cumlDomain(), &eventAttrib);
 }
 
 #ifdef ENABLE_EMPTY_MARKER_KERNEL
@@ -153,7 +187,7 @@ __global__ void emptyMarkerKernel() {
 #endif // ENABLE_EMPTY_MARKER_KERNEL
 
 void POP_RANGE() {
-  nvtxRangePop();
+  nvtxDomainRangePop(cumlDomain());
 #ifdef ENABLE_EMPTY_MARKER_KERNEL
   emptyMarkerKernel<<<1,1>>>();
 #endif
@@ -163,6 +197,10 @@ void POP_RANGE() {
 
 void PUSH_RANGE(const char *name) {}
 
+void PUSH_RANGE(const char *name, int64_t payload) {}
+
+void PUSH_RANGE_MSG(const char *name, const char *format, ...) {}
+
 void POP_RANGE() {}
 
 #endif  // NVTX_ENABLED
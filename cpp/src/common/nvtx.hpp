@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <stdint.h>
+#include <type_traits>
+
 namespace ML {
 
 /**
@@ -24,7 +27,53 @@ namespace ML {
  */
 void PUSH_RANGE(const char *name);
 
+/**
+ * @brief Push a named nvtx range with an integer payload
+ * @param name range name, which also selects its color
+ * @param payload eg: the iteration or the level the range covers
+ */
+void PUSH_RANGE(const char *name, int64_t payload);
+
+/**
+ * @brief Push a named nvtx range described by a printf-style message, which
+ *        is only formatted when nvtx is enabled
+ * @param name range name, prefixing the message and selecting the color
+ * @param format format of the rest of the message, eg: "rows=%d cols=%d"
+ */
+void PUSH_RANGE_MSG(const char *name, const char *format, ...);
+
 /** Pop the latest range */
 void POP_RANGE();
 
+/**
+ * @brief A range for the lifetime of the object, the way to mark entry
+ *        points and phases that return or throw from several places.
+ *
+ * All the ranges of cuML belong to the "cuML" nvtx domain.
+ * @code{.cpp}
+ * nvtxRange fit("ML::Umap::Fit", "rows=%d cols=%d", n, d);
+ * for (int i = 0; i < n_epochs; i++) {
+ *   nvtxRange epoch("Trace::Umap::Epoch", i);
+ *   ...
+ * }
+ * @endcode
+ */
+class nvtxRange {
+ public:
+  nvtxRange(const char *name) { PUSH_RANGE(name); }
+  template <typename Int, typename = typename std::enable_if<
+                            std::is_integral<Int>::value>::type>
+  nvtxRange(const char *name, Int payload) {
+    PUSH_RANGE(name, int64_t(payload));
+  }
+  template <typename... Args>
+  nvtxRange(const char *name, const char *format, Args... args) {
+    PUSH_RANGE_MSG(name, format, args...);
+  }
+  ~nvtxRange() { POP_RANGE(); }
+
+  nvtxRange(const nvtxRange &other) = delete;
+  nvtxRange &operator=(const nvtxRange &other) = delete;
+};
+
 }  // end namespace ML
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_runtime.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <common/Timer.h>
+
+namespace ML {
+
+/**
+ * @brief Per-phase timing of the calls made through a cumlHandle.
+ *
+ * A phase is timed between begin and end (see detail::phaseScope), on the
+ * host and, with a pair of events, on the stream it runs on. The events are
+ * only read once they have completed, when a later phase begins, or when the
+ * report is made, so that profiling never synchronizes the calls it times.
+ * The times of the phases of the same name add up, nested phases being
+ * counted in their enclosing phases too.
+ *
+ * Disabled, begin is a single flag test. Thread-safe.
+ */
+class phaseProfiler {
+ public:
+  /** the timings of the phases of a name, see timings */
+  struct phaseStats {
+    std::string name;
+    std::size_t calls;
+    double gpuMs, maxGpuMs, cpuMs;
+  };
+
+  phaseProfiler() : _enabled(false), _nextId(0) {}
+
+  void setEnabled(bool enabled) { _enabled = enabled; }
+  bool enabled() const { return _enabled; }
+
+  /** start timing the phase name on stream, -1 if profiling is disabled */
+  int begin(const char* name, cudaStream_t stream) {
+    if (!_enabled) return -1;
+    std::lock_guard<std::mutex> lock(_mutex);
+    resolve(false);
+    std::unique_ptr<record> r(new record);
+    r->phase = phaseId(name);
+    r->gpu = takeTimer();
+    r->gpu->start(stream);
+    int id = _nextId++;
+    _open[id] = std::move(r);
+    return id;
+  }
+
+  /** stop timing the phase begun as id, on the stream it began on */
+  void end(int id, cudaStream_t stream) {
+    if (id < 0) return;
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _open.find(id);
+    if (it == _open.end()) return;
+    std::unique_ptr<record> r = std::move(it->second);
+    _open.erase(it);
+    r->gpu->stop(stream);
+    r->cpuMs = r->cpu.getElapsedMilliseconds();
+    _pending.push_back(std::move(r));
+  }
+
+  /**
+   * the timings, waiting for the phases that have ended, in the order the
+   * phases first ran
+   */
+  std::vector<phaseStats> timings() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    resolve(true);
+    return _phases;
+  }
+
+  /**
+   * the timings as JSON, waiting for the phases that have ended:
+   * {"phases":[{"name":..., "calls":..., "gpu_ms":..., "max_gpu_ms":...,
+   * "cpu_ms":...}, ...]}, in the order the phases first ran
+   */
+  std::string report() {
+    std::vector<phaseStats> phases = timings();
+    std::string json("{\"phases\":[");
+    char buf[128];
+    for (std::size_t i = 0; i < phases.size(); ++i) {
+      const phaseStats& p = phases[i];
+      if (i > 0) json.push_back(',');
+      json += "{\"name\":\"";
+      appendEscaped(json, p.name);
+      snprintf(buf, sizeof(buf),
+               "\",\"calls\":%zu,\"gpu_ms\":%.3f,\"max_gpu_ms\":%.3f,"
+               "\"cpu_ms\":%.3f}",
+               p.calls, p.gpuMs, p.maxGpuMs, p.cpuMs);
+      json += buf;
+    }
+    json += "]}";
+    return json;
+  }
+
+  /** forget the timings so far, those of the phases still open included */
+  void reset() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    resolve(true);
+    for (auto& o : _open) _timers.push_back(std::move(o.second->gpu));
+    _open.clear();
+    _phases.clear();
+    _phaseIds.clear();
+  }
+
+ private:
+  struct record {
+    int phase;
+    MLCommon::TimerCPU cpu;
+    std::unique_ptr<MLCommon::TimerGPU> gpu;
+    double cpuMs;
+  };
+
+  int phaseId(const char* name) {
+    auto it = _phaseIds.find(name);
+    if (it != _phaseIds.end()) return it->second;
+    int id = int(_phases.size());
+    _phases.push_back(phaseStats{name, 0, 0.0, 0.0, 0.0});
+    _phaseIds[name] = id;
+    return id;
+  }
+
+  std::unique_ptr<MLCommon::TimerGPU> takeTimer() {
+    if (_timers.empty()) {
+      return std::unique_ptr<MLCommon::TimerGPU>(new MLCommon::TimerGPU);
+    }
+    std::unique_ptr<MLCommon::TimerGPU> t = std::move(_timers.back());
+    _timers.pop_back();
+    return t;
+  }
+
+  /** add up the ended phases, only those already done unless wait */
+  void resolve(bool wait) {
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < _pending.size(); ++i) {
+      record& r = *_pending[i];
+      if (!wait && !r.gpu->ready()) {
+        _pending[kept++] = std::move(_pending[i]);
+        continue;
+      }
+      double gpuMs = r.gpu->getElapsedMilliseconds();
+      phaseStats& p = _phases[r.phase];
+      p.calls++;
+      p.gpuMs += gpuMs;
+      p.maxGpuMs = std::max(p.maxGpuMs, gpuMs);
+      p.cpuMs += r.cpuMs;
+      _timers.push_back(std::move(r.gpu));
+    }
+    _pending.resize(kept);
+  }
+
+  static void appendEscaped(std::string& json, const std::string& s) {
+    for (char c : s) {
+      if (c == '"' || c == '\\') {
+        json.push_back('\\');
+        json.push_back(c);
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\u%04x", c);
+        json += buf;
+      } else {
+        json.push_back(c);
+      }
+    }
+  }
+
+  std::atomic<bool> _enabled;
+  int _nextId;
+  std::vector<phaseStats> _phases;
+  std::unordered_map<std::string, int> _phaseIds;
+  std::unordered_map<int, std::unique_ptr<record>> _open;
+  /** ended phases whose events have not been read yet */
+  std::vector<std::unique_ptr<record>> _pending;
+  /** timers of the resolved phases, for reuse */
+  std::vector<std::unique_ptr<MLCommon::TimerGPU>> _timers;
+  std::mutex _mutex;
+};
+
+}  // end namespace ML
@@ -19,6 +19,9 @@
 #include <common/cumlHandle.hpp>
 #include <common/cuml_comms_int.hpp>
 #include <common/device_buffer.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
 #include <iostream>
 
 namespace ML {
@@ -171,5 +174,248 @@ bool test_pointToPoint_recv_any_rank(const ML::cumlHandle& h, int numTrials) {
   return ret;
 }
 
+bool test_pointToPoint_device_send_recv(const ML::cumlHandle& h,
+                                        int numTrials) {
+  const cumlHandle_impl& handle = h.getImpl();
+  const MLCommon::cumlCommunicator& communicator = handle.getCommunicator();
+  const int rank = communicator.getRank();
+  const int size = communicator.getSize();
+  cudaStream_t stream = handle.getStream();
+
+  MLCommon::device_buffer<int> send_d(handle.getDeviceAllocator(), stream, 1);
+  MLCommon::device_buffer<int> recv_d(handle.getDeviceAllocator(), stream,
+                                      size);
+  CUDA_CHECK(cudaMemcpyAsync(send_d.data(), &rank, sizeof(int),
+                             cudaMemcpyHostToDevice, stream));
+
+  bool ret = true;
+  for (int i = 0; i < numTrials; i++) {
+    CUDA_CHECK(
+      cudaMemsetAsync(recv_d.data(), 0xff, size * sizeof(int), stream));
+    // grouped, so that the sends and receives of all the ranks progress
+    // together whatever their order
+    communicator.groupStart();
+    for (int r = 0; r < size; ++r) {
+      if (r != rank) {
+        communicator.device_send(send_d.data(), 1, r, stream);
+        communicator.device_recv(recv_d.data() + r, 1, r, stream);
+      }
+    }
+    communicator.groupEnd();
+
+    std::vector<int> received_data(size, -1);
+    CUDA_CHECK(cudaMemcpyAsync(received_data.data(), recv_d.data(),
+                               size * sizeof(int), cudaMemcpyDeviceToHost,
+                               stream));
+    if (communicator.syncStream(stream) !=
+        MLCommon::cumlCommunicator::status_t::commStatusSuccess) {
+      return false;
+    }
+    for (int r = 0; r < size; ++r) {
+      if (r != rank && received_data[r] != r) ret = false;
+    }
+    communicator.barrier();
+  }
+
+  if (rank == 0) {
+    std::cout << "Device send/recv " << (ret ? "passed" : "failed") << " on "
+              << size << " ranks" << std::endl;
+  }
+  return ret;
+}
+
+namespace {
+
+/** a collective of the benchmark on its input and output buffers */
+struct benchmarkCase {
+  const char* name;
+  // bus bandwidth / algorithm bandwidth, see nccl-tests
+  double bus_factor;
+  // sets up the output before the calls
+  std::function<void()> prepare;
+  std::function<void()> call;
+  // number of checked output elements on this rank, and their values
+  int check_len;
+  std::function<float(int)> expected;
+};
+
+// The mean duration of a call of the benchmark on the slowest rank, in ms
+float timeCollective(const cumlHandle_impl& handle, const benchmarkCase& c,
+                     int n_iters, int n_warmup, cudaEvent_t start,
+                     cudaEvent_t stop, MLCommon::device_buffer<float>& t_d) {
+  const MLCommon::cumlCommunicator& communicator = handle.getCommunicator();
+  cudaStream_t stream = handle.getStream();
+  for (int i = 0; i < n_warmup; ++i) c.call();
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  communicator.barrier();
+  CUDA_CHECK(cudaEventRecord(start, stream));
+  for (int i = 0; i < n_iters; ++i) c.call();
+  CUDA_CHECK(cudaEventRecord(stop, stream));
+  CUDA_CHECK(cudaEventSynchronize(stop));
+  float ms = 0.f;
+  CUDA_CHECK(cudaEventElapsedTime(&ms, start, stop));
+  ms /= std::max(n_iters, 1);
+  MLCommon::updateDevice(t_d.data(), &ms, 1, stream);
+  communicator.allreduce(t_d.data(), t_d.data(), 1,
+                         MLCommon::cumlCommunicator::MAX, stream);
+  MLCommon::updateHost(&ms, t_d.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  return ms;
+}
+
+// Whether the output is the expected one on all the ranks
+bool checkCollective(const cumlHandle_impl& handle, const benchmarkCase& c,
+                     const float* out_d, MLCommon::device_buffer<int>& ok_d) {
+  const MLCommon::cumlCommunicator& communicator = handle.getCommunicator();
+  cudaStream_t stream = handle.getStream();
+  std::vector<float> out(c.check_len);
+  MLCommon::updateHost(out.data(), out_d, c.check_len, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  int ok = 1;
+  for (int i = 0; i < c.check_len && ok; ++i) ok = out[i] == c.expected(i);
+  MLCommon::updateDevice(ok_d.data(), &ok, 1, stream);
+  communicator.allreduce(ok_d.data(), ok_d.data(), 1,
+                         MLCommon::cumlCommunicator::MIN, stream);
+  MLCommon::updateHost(&ok, ok_d.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  return ok != 0;
+}
+
+}  // namespace
+
+bool benchmark_collectives(const ML::cumlHandle& h, size_t min_bytes,
+                           size_t max_bytes, int n_iters, int n_warmup,
+                           std::vector<commsBenchmarkResult>* results) {
+  const cumlHandle_impl& handle = h.getImpl();
+  ML::detail::streamSyncer _(handle);
+  const MLCommon::cumlCommunicator& communicator = handle.getCommunicator();
+  const int rank = communicator.getRank();
+  const int size = communicator.getSize();
+  cudaStream_t stream = handle.getStream();
+  auto allocator = handle.getDeviceAllocator();
+
+  const int next = (rank + 1) % size, prev = (rank + size - 1) % size;
+  // the sum of rank + 1 over the ranks
+  const float sum = 0.5f * size * (size + 1);
+  const float n = float(size);
+  cudaEvent_t start, stop;
+  CUDA_CHECK(cudaEventCreate(&start));
+  CUDA_CHECK(cudaEventCreate(&stop));
+  MLCommon::device_buffer<float> t_d(allocator, stream, 1);
+  MLCommon::device_buffer<int> ok_d(allocator, stream, 1);
+  std::vector<commsBenchmarkResult> all;
+
+  if (rank == 0) {
+    printf("%14s %12s %12s %10s %10s %6s\n", "collective", "bytes",
+           "time (us)", "algbw", "busbw", "check");
+  }
+  for (size_t bytes = std::max(min_bytes, sizeof(float)); bytes <= max_bytes;
+       bytes *= 2) {
+    // a multiple of the number of ranks, for the collectives of chunks
+    const int count =
+      std::max<int>(size, bytes / sizeof(float) / size * size);
+    const int chunk = count / size;
+    MLCommon::device_buffer<float> in(allocator, stream, count);
+    MLCommon::device_buffer<float> out(allocator, stream, count);
+    std::vector<float> in_h(count, float(rank + 1));
+    MLCommon::updateDevice(in.data(), in_h.data(), count, stream);
+    std::vector<int> counts(size, chunk), displs(size);
+    for (int r = 0; r < size; ++r) displs[r] = r * chunk;
+    auto clear = [&]() {
+      CUDA_CHECK(
+        cudaMemsetAsync(out.data(), 0, count * sizeof(float), stream));
+    };
+    auto chunkOfRank = [=](int i) { return float(i / chunk + 1); };
+
+    std::vector<benchmarkCase> cases = {
+      {"allreduce", 2 * (n - 1) / n, clear,
+       [&]() {
+         communicator.allreduce(in.data(), out.data(), count,
+                                MLCommon::cumlCommunicator::SUM, stream);
+       },
+       count, [=](int) { return sum; }},
+      {"bcast", 1,
+       [&]() {
+         CUDA_CHECK(cudaMemcpyAsync(out.data(), in.data(),
+                                    count * sizeof(float),
+                                    cudaMemcpyDeviceToDevice, stream));
+       },
+       [&]() { communicator.bcast(out.data(), count, 0, stream); }, count,
+       [](int) { return 1.f; }},
+      {"reduce", 1, clear,
+       [&]() {
+         communicator.reduce(in.data(), out.data(), count,
+                             MLCommon::cumlCommunicator::SUM, 0, stream);
+       },
+       rank == 0 ? count : 0, [=](int) { return sum; }},
+      {"allgather", (n - 1) / n, clear,
+       [&]() {
+         communicator.allgather(in.data(), out.data(), chunk, stream);
+       },
+       count, chunkOfRank},
+      {"allgatherv", (n - 1) / n, clear,
+       [&]() {
+         communicator.allgatherv(in.data(), out.data(), counts.data(),
+                                 displs.data(), stream);
+       },
+       count, chunkOfRank},
+      {"reducescatter", (n - 1) / n, clear,
+       [&]() {
+         communicator.reducescatter(in.data(), out.data(), chunk,
+                                    MLCommon::cumlCommunicator::SUM, stream);
+       },
+       chunk, [=](int) { return sum; }},
+      {"alltoall", (n - 1) / n, clear,
+       [&]() { communicator.alltoall(in.data(), out.data(), chunk, stream); },
+       count, chunkOfRank},
+      {"sendrecv", 1, clear,
+       [&]() {
+         communicator.groupStart();
+         try {
+           communicator.device_send(in.data(), count, next, stream);
+           communicator.device_recv(out.data(), count, prev, stream);
+         } catch (...) {
+           communicator.groupEnd();
+           throw;
+         }
+         communicator.groupEnd();
+       },
+       size > 1 ? count : 0, [=](int) { return float(prev + 1); }}};
+
+    for (const benchmarkCase& c : cases) {
+      c.prepare();
+      float ms;
+      try {
+        ms = timeCollective(handle, c, n_iters, n_warmup, start, stop, t_d);
+      } catch (const MLCommon::Exception& e) {
+        // rejected before any communication, and so on all the ranks
+        if (rank == 0 && bytes == std::max(min_bytes, sizeof(float))) {
+          printf("%14s skipped: %s\n", c.name, e.what());
+        }
+        continue;
+      }
+      commsBenchmarkResult r;
+      r.collective = c.name;
+      r.bytes = size_t(count) * sizeof(float);
+      r.time_us = 1e3 * ms;
+      r.alg_bw = ms > 0 ? r.bytes / (1e6 * ms) : 0.0;
+      r.bus_bw = r.alg_bw * c.bus_factor;
+      r.correct = checkCollective(handle, c, out.data(), ok_d);
+      if (rank == 0) {
+        printf("%14s %12zu %12.2f %10.3f %10.3f %6s\n", c.name, r.bytes,
+               r.time_us, r.alg_bw, r.bus_bw, r.correct ? "ok" : "WRONG");
+      }
+      all.push_back(r);
+    }
+  }
+
+  CUDA_CHECK(cudaEventDestroy(start));
+  CUDA_CHECK(cudaEventDestroy(stop));
+  bool ret = true;
+  for (const commsBenchmarkResult& r : all) ret = ret && r.correct;
+  if (results != nullptr) *results = all;
+  return ret;
+}
+
 };  // namespace Comms
 };  // end namespace ML
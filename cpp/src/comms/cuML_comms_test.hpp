@@ -1,43 +1,87 @@
-/*
- * Copyright (c) 2019, NVIDIA CORPORATION.
- *
- * Licensed under the Apache License, Version 2.0 (the "License");
- * you may not use this file except in compliance with the License.
- * You may obtain a copy of the License at
- *
- *     http://www.apache.org/licenses/LICENSE-2.0
- *
- * Unless required by applicable law or agreed to in writing, software
- * distributed under the License is distributed on an "AS IS" BASIS,
- * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
- * See the License for the specific language governing permissions and
- * limitations under the License.
- */
-
-#pragma once
-
-#include <cuml/cuml.hpp>
-
-namespace ML {
-namespace Comms {
-
-/**
- * @brief Simple allreduce test for single integer value of 1. Each rank
- * evaluates whether their allreduced value equals the size of the clique.
- * @param[in] h cumlHandle instance with initialized cumlCommunicator
- */
-bool test_collective_allreduce(const ML::cumlHandle& handle);
-
-/**
- * @brief Simple point-to-point test. Each rank passes its rank to all other
- * ranks and verifies that it received messages from all other ranks.
- * @param[in] h cumlHandle instance with initialized cumlCommunicator
- * @param[in] numTrials number of iterations to pass messages
- */
-bool test_pointToPoint_simple_send_recv(const ML::cumlHandle& handle,
-                                        int n_trials);
-
-bool test_pointToPoint_recv_any_rank(const ML::cumlHandle& handle, int numTrials);
-
-};  // namespace Comms
-};  // end namespace ML
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuml/cuml.hpp>
+#include <string>
+#include <vector>
+
+namespace ML {
+namespace Comms {
+
+/**
+ * @brief Simple allreduce test for single integer value of 1. Each rank
+ * evaluates whether their allreduced value equals the size of the clique.
+ * @param[in] h cumlHandle instance with initialized cumlCommunicator
+ */
+bool test_collective_allreduce(const ML::cumlHandle& handle);
+
+/**
+ * @brief Simple point-to-point test. Each rank passes its rank to all other
+ * ranks and verifies that it received messages from all other ranks.
+ * @param[in] h cumlHandle instance with initialized cumlCommunicator
+ * @param[in] numTrials number of iterations to pass messages
+ */
+bool test_pointToPoint_simple_send_recv(const ML::cumlHandle& handle,
+                                        int n_trials);
+
+bool test_pointToPoint_recv_any_rank(const ML::cumlHandle& handle, int numTrials);
+
+/**
+ * @brief Stream-ordered point-to-point test. Each rank passes its rank to all
+ * other ranks with device_send / device_recv, which only need NCCL, and
+ * verifies that it received messages from all other ranks.
+ * @param[in] h cumlHandle instance with initialized cumlCommunicator
+ * @param[in] numTrials number of iterations to pass messages
+ */
+bool test_pointToPoint_device_send_recv(const ML::cumlHandle& handle,
+                                        int numTrials);
+
+/** the measures of a collective at a message size, see benchmark_collectives */
+struct commsBenchmarkResult {
+  std::string collective;
+  // size of the largest buffer of the collective, eg: the output of allgather
+  size_t bytes;
+  // mean duration of a call on the slowest rank, in microseconds
+  double time_us;
+  // bytes / time, and the bandwidth of the links the collective implies, as
+  // defined by nccl-tests, in GB/s
+  double alg_bw;
+  double bus_bw;
+  // whether the result was the expected one on all the ranks
+  bool correct;
+};
+
+/**
+ * @brief Benchmark of the collectives of the communicator: allreduce, bcast,
+ * reduce, allgather, allgatherv, reducescatter, alltoall and a ring of
+ * device_send / device_recv, on float buffers of min_bytes to max_bytes,
+ * doubling the size. Each collective is timed with cuda events over n_iters
+ * calls, after n_warmup calls, and its result is checked. The collectives
+ * the communicator does not support, eg: the NCCL point-to-point calls
+ * before NCCL 2.7, are skipped. Rank 0 prints a table of the results, to
+ * validate a cluster setup and compare the backends.
+ * @param[in] h cumlHandle instance with initialized cumlCommunicator
+ * @param[out] results the results, the same on all the ranks, or nullptr
+ * @return whether all the results were correct
+ */
+bool benchmark_collectives(const ML::cumlHandle& h, size_t min_bytes,
+                           size_t max_bytes, int n_iters, int n_warmup,
+                           std::vector<commsBenchmarkResult>* results);
+
+};  // namespace Comms
+};  // end namespace ML
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <thrust/execution_policy.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <common/cumlHandle.hpp>
+#include <common/device_buffer.hpp>
+#include <cuml/datasets/make_arima.hpp>
+#include "arima/batched_arima.hpp"
+#include "linalg/transpose.h"
+#include "random/rng.h"
+#include "utils.h"
+
+namespace ML {
+namespace Datasets {
+
+void make_arima(cumlHandle& handle, double* out, int batch_size, int n_obs,
+                const ARIMAOrder& order, double noise_scale,
+                double intercept_scale, uint64_t seed, double* params) {
+  ASSERT(order.s > 0 || (order.P == 0 && order.D == 0 && order.Q == 0),
+         "make_arima: a seasonal model needs a seasonal period s > 0");
+  ASSERT(order.n_exog == 0, "make_arima: no exogenous regressors");
+  auto allocator = handle.getDeviceAllocator();
+  auto stream = handle.getStream();
+  const int N = order.complexity(), B = batch_size;
+  const int p = order.p, q = order.q, P = order.P, Q = order.Q, s = order.s,
+            d = order.d, D = order.D, k = order.k();
+  const int p_exp = order.p_expanded(), q_exp = order.q_expanded();
+  // for the simulated ARMA to forget its zero initial state
+  const int n_burn = 100 + 10 * (p_exp + q_exp);
+  const int n_total = n_burn + n_obs;
+  MLCommon::Random::Rng r(seed);
+
+  MLCommon::device_buffer<double> raw(allocator, stream, N * B);
+  MLCommon::device_buffer<double> Tparams(allocator, stream, N * B);
+  r.uniform(raw.data(), N * B, -1.0, 1.0, stream);
+  batched_jones_transform(handle, order, B, false, raw.data(),
+                          Tparams.data());
+
+  // the series and the innovations, time-major for the series to be
+  // simulated in parallel with coalesced accesses
+  MLCommon::device_buffer<double> y(allocator, stream, size_t(n_total) * B);
+  MLCommon::device_buffer<double> eps(allocator, stream, size_t(n_total) * B);
+  r.normal(eps.data(), n_total * B, 0.0, noise_scale, stream);
+  MLCommon::device_buffer<double> ar_exp(allocator, stream, p_exp * B);
+  MLCommon::device_buffer<double> ma_exp(allocator, stream, q_exp * B);
+  double* Tparams_ = Tparams.data();
+  double* y_ = y.data();
+  const double* eps_ = eps.data();
+  double* ar_exp_ = ar_exp.data();
+  double* ma_exp_ = ma_exp.data();
+  auto counting = thrust::make_counting_iterator(0);
+  thrust::for_each(
+    thrust::cuda::par.on(stream), counting, counting + B,
+    [=] __device__(int bid) {
+      double* param = Tparams_ + bid * N;
+      double mu = 0.0;
+      if (k) {
+        param[0] *= intercept_scale;
+        mu = *param++;
+      }
+      const double *ar = param, *ma = ar + p, *sar = ma + q, *sma = sar + P;
+      // reduced form: (1 - ar(B))(1 - sar(B^s)) and (1 + ma(B))(1 + sma(B^s))
+      double* ar_b = ar_exp_ + bid * p_exp;
+      double* ma_b = ma_exp_ + bid * q_exp;
+      for (int i = 0; i < p_exp; i++) ar_b[i] = 0.0;
+      for (int i = 0; i < p; i++) ar_b[i] = ar[i];
+      for (int j = 0; j < P; j++) {
+        ar_b[(j + 1) * s - 1] += sar[j];
+        for (int i = 0; i < p; i++) ar_b[(j + 1) * s + i] -= ar[i] * sar[j];
+      }
+      for (int i = 0; i < q_exp; i++) ma_b[i] = 0.0;
+      for (int i = 0; i < q; i++) ma_b[i] = ma[i];
+      for (int j = 0; j < Q; j++) {
+        ma_b[(j + 1) * s - 1] += sma[j];
+        for (int i = 0; i < q; i++) ma_b[(j + 1) * s + i] += ma[i] * sma[j];
+      }
+
+      // the centered differenced series, from a zero initial state
+      for (int t = 0; t < n_total; t++) {
+        double x_t = eps_[t * B + bid];
+        for (int i = 0; i < p_exp && i < t; i++) {
+          x_t += ar_b[i] * y_[(t - 1 - i) * B + bid];
+        }
+        for (int i = 0; i < q_exp && i < t; i++) {
+          x_t += ma_b[i] * eps_[(t - 1 - i) * B + bid];
+        }
+        y_[t * B + bid] = x_t;
+      }
+      // shifted by mu, then integrated, in the reverse order of the
+      // differencing of batched_loglike
+      if (k) {
+        for (int t = 0; t < n_total; t++) y_[t * B + bid] += mu;
+      }
+      for (int i = 0; i < d; i++) {
+        for (int t = 1; t < n_total; t++) {
+          y_[t * B + bid] += y_[(t - 1) * B + bid];
+        }
+      }
+      for (int i = 0; i < D; i++) {
+        for (int t = s; t < n_total; t++) {
+          y_[t * B + bid] += y_[(t - s) * B + bid];
+        }
+      }
+    });
+
+  // the series without their burn-in, to the layout (n_obs, batch_size)
+  MLCommon::LinAlg::transpose(y.data() + size_t(n_burn) * B, out, B, n_obs,
+                              handle.getImpl().getCublasHandle(), stream);
+  if (params != nullptr) MLCommon::copy(params, Tparams.data(), N * B, stream);
+}
+
+}  // namespace Datasets
+}  // namespace ML
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019, NVIDIA CORPORATION.
+ * Copyright (c) 2019-2020, NVIDIA CORPORATION.
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -21,6 +21,51 @@
 namespace ML {
 namespace Datasets {
 
+template <typename DataT>
+void make_blobs_shard_helper(const cumlHandle& handle, DataT* out,
+                             int64_t* labels, int64_t row_offset,
+                             int64_t n_rows, int64_t n_cols,
+                             int64_t n_clusters, const DataT* centers,
+                             const DataT* cluster_std,
+                             const DataT cluster_std_scalar,
+                             DataT center_box_min, DataT center_box_max,
+                             uint64_t seed) {
+  MLCommon::Random::make_blobs_shard(
+    out, labels, row_offset, n_rows, n_cols, n_clusters,
+    handle.getDeviceAllocator(), handle.getStream(), centers, cluster_std,
+    cluster_std_scalar, center_box_min, center_box_max, seed);
+}
+
+template <typename DataT>
+void make_blobs_mg_helper(const cumlHandle& handle, DataT* out,
+                          int64_t* labels, int64_t n_rows, int64_t n_cols,
+                          int64_t n_clusters, const DataT* centers,
+                          const DataT* cluster_std,
+                          const DataT cluster_std_scalar, DataT center_box_min,
+                          DataT center_box_max, uint64_t seed) {
+  const auto& comm = handle.getImpl().getCommunicator();
+  int64_t row_offset, rank_rows;
+  shard_rows(n_rows, comm.getSize(), comm.getRank(), &row_offset, &rank_rows);
+  make_blobs_shard_helper(handle, out, labels, row_offset, rank_rows, n_cols,
+                          n_clusters, centers, cluster_std, cluster_std_scalar,
+                          center_box_min, center_box_max, seed);
+}
+
+template <typename DataT>
+void make_blobs_chunked_helper(
+  const cumlHandle& handle, int64_t row_offset, int64_t n_rows,
+  int64_t n_cols, int64_t n_clusters, int64_t chunk_rows,
+  const std::function<void(const DataT*, const int64_t*, int64_t, int64_t)>&
+    consume,
+  const DataT* centers, const DataT* cluster_std,
+  const DataT cluster_std_scalar, DataT center_box_min, DataT center_box_max,
+  uint64_t seed) {
+  MLCommon::Random::make_blobs_chunked(
+    row_offset, n_rows, n_cols, n_clusters, chunk_rows, consume,
+    handle.getDeviceAllocator(), handle.getStream(), centers, cluster_std,
+    cluster_std_scalar, center_box_min, center_box_max, seed);
+}
+
 void make_blobs(const cumlHandle& handle, float* out, int64_t* labels,
                 int64_t n_rows, int64_t n_cols, int64_t n_clusters,
                 const float* centers, const float* cluster_std,
@@ -64,5 +109,76 @@ void make_blobs(const cumlHandle& handle, double* out, int* labels, int n_rows,
                                centers, cluster_std, cluster_std_scalar,
                                shuffle, center_box_min, center_box_max, seed);
 }
+
+void make_blobs_shard(const cumlHandle& handle, float* out, int64_t* labels,
+                      int64_t row_offset, int64_t n_rows, int64_t n_cols,
+                      int64_t n_clusters, const float* centers,
+                      const float* cluster_std, const float cluster_std_scalar,
+                      float center_box_min, float center_box_max,
+                      uint64_t seed) {
+  make_blobs_shard_helper(handle, out, labels, row_offset, n_rows, n_cols,
+                          n_clusters, centers, cluster_std, cluster_std_scalar,
+                          center_box_min, center_box_max, seed);
+}
+
+void make_blobs_shard(const cumlHandle& handle, double* out, int64_t* labels,
+                      int64_t row_offset, int64_t n_rows, int64_t n_cols,
+                      int64_t n_clusters, const double* centers,
+                      const double* cluster_std,
+                      const double cluster_std_scalar, double center_box_min,
+                      double center_box_max, uint64_t seed) {
+  make_blobs_shard_helper(handle, out, labels, row_offset, n_rows, n_cols,
+                          n_clusters, centers, cluster_std, cluster_std_scalar,
+                          center_box_min, center_box_max, seed);
+}
+
+void make_blobs_mg(const cumlHandle& handle, float* out, int64_t* labels,
+                   int64_t n_rows, int64_t n_cols, int64_t n_clusters,
+                   const float* centers, const float* cluster_std,
+                   const float cluster_std_scalar, float center_box_min,
+                   float center_box_max, uint64_t seed) {
+  make_blobs_mg_helper(handle, out, labels, n_rows, n_cols, n_clusters,
+                       centers, cluster_std, cluster_std_scalar,
+                       center_box_min, center_box_max, seed);
+}
+
+void make_blobs_mg(const cumlHandle& handle, double* out, int64_t* labels,
+                   int64_t n_rows, int64_t n_cols, int64_t n_clusters,
+                   const double* centers, const double* cluster_std,
+                   const double cluster_std_scalar, double center_box_min,
+                   double center_box_max, uint64_t seed) {
+  make_blobs_mg_helper(handle, out, labels, n_rows, n_cols, n_clusters,
+                       centers, cluster_std, cluster_std_scalar,
+                       center_box_min, center_box_max, seed);
+}
+
+void make_blobs_chunked(
+  const cumlHandle& handle, int64_t row_offset, int64_t n_rows,
+  int64_t n_cols, int64_t n_clusters, int64_t chunk_rows,
+  const std::function<void(const float*, const int64_t*, int64_t, int64_t)>&
+    consume,
+  const float* centers, const float* cluster_std,
+  const float cluster_std_scalar, float center_box_min, float center_box_max,
+  uint64_t seed) {
+  make_blobs_chunked_helper(handle, row_offset, n_rows, n_cols, n_clusters,
+                            chunk_rows, consume, centers, cluster_std,
+                            cluster_std_scalar, center_box_min,
+                            center_box_max, seed);
+}
+
+void make_blobs_chunked(
+  const cumlHandle& handle, int64_t row_offset, int64_t n_rows,
+  int64_t n_cols, int64_t n_clusters, int64_t chunk_rows,
+  const std::function<void(const double*, const int64_t*, int64_t, int64_t)>&
+    consume,
+  const double* centers, const double* cluster_std,
+  const double cluster_std_scalar, double center_box_min,
+  double center_box_max, uint64_t seed) {
+  make_blobs_chunked_helper(handle, row_offset, n_rows, n_cols, n_clusters,
+                            chunk_rows, consume, centers, cluster_std,
+                            cluster_std_scalar, center_box_min,
+                            center_box_max, seed);
+}
+
 }  // namespace Datasets
 }  // namespace ML
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <common/cumlHandle.hpp>
+#include <cuml/datasets/make_classification.hpp>
+#include "random/make_classification.h"
+
+namespace ML {
+namespace Datasets {
+
+template <typename DataT, typename IdxT>
+void make_classification_helper(const cumlHandle& handle, DataT* out,
+                                IdxT* labels, IdxT n_rows, IdxT n_cols,
+                                IdxT n_classes, IdxT n_clusters_per_class,
+                                IdxT n_informative, IdxT n_redundant,
+                                IdxT n_repeated, DataT flip_y, DataT class_sep,
+                                bool hypercube, DataT shift, DataT scale,
+                                bool shuffle, uint64_t seed) {
+  const auto& handle_impl = handle.getImpl();
+  MLCommon::Random::make_classification(
+    out, labels, n_rows, n_cols, handle_impl.getCublasHandle(),
+    handle_impl.getDeviceAllocator(), handle_impl.getStream(), n_classes,
+    n_clusters_per_class, n_informative, n_redundant, n_repeated, flip_y,
+    class_sep, hypercube, shift, scale, shuffle, seed);
+}
+
+void make_classification(const cumlHandle& handle, float* out, int64_t* labels,
+                         int64_t n_rows, int64_t n_cols, int64_t n_classes,
+                         int64_t n_clusters_per_class, int64_t n_informative,
+                         int64_t n_redundant, int64_t n_repeated, float flip_y,
+                         float class_sep, bool hypercube, float shift,
+                         float scale, bool shuffle, uint64_t seed) {
+  make_classification_helper(handle, out, labels, n_rows, n_cols, n_classes,
+                             n_clusters_per_class, n_informative, n_redundant,
+                             n_repeated, flip_y, class_sep, hypercube, shift,
+                             scale, shuffle, seed);
+}
+
+void make_classification(const cumlHandle& handle, double* out, int64_t* labels,
+                         int64_t n_rows, int64_t n_cols, int64_t n_classes,
+                         int64_t n_clusters_per_class, int64_t n_informative,
+                         int64_t n_redundant, int64_t n_repeated, double flip_y,
+                         double class_sep, bool hypercube, double shift,
+                         double scale, bool shuffle, uint64_t seed) {
+  make_classification_helper(handle, out, labels, n_rows, n_cols, n_classes,
+                             n_clusters_per_class, n_informative, n_redundant,
+                             n_repeated, flip_y, class_sep, hypercube, shift,
+                             scale, shuffle, seed);
+}
+
+void make_classification(const cumlHandle& handle, float* out, int* labels,
+                         int n_rows, int n_cols, int n_classes,
+                         int n_clusters_per_class, int n_informative,
+                         int n_redundant, int n_repeated, float flip_y,
+                         float class_sep, bool hypercube, float shift,
+                         float scale, bool shuffle, uint64_t seed) {
+  make_classification_helper(handle, out, labels, n_rows, n_cols, n_classes,
+                             n_clusters_per_class, n_informative, n_redundant,
+                             n_repeated, flip_y, class_sep, hypercube, shift,
+                             scale, shuffle, seed);
+}
+
+void make_classification(const cumlHandle& handle, double* out, int* labels,
+                         int n_rows, int n_cols, int n_classes,
+                         int n_clusters_per_class, int n_informative,
+                         int n_redundant, int n_repeated, double flip_y,
+                         double class_sep, bool hypercube, double shift,
+                         double scale, bool shuffle, uint64_t seed) {
+  make_classification_helper(handle, out, labels, n_rows, n_cols, n_classes,
+                             n_clusters_per_class, n_informative, n_redundant,
+                             n_repeated, flip_y, class_sep, hypercube, shift,
+                             scale, shuffle, seed);
+}
+
+}  // namespace Datasets
+}  // namespace ML
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019, NVIDIA CORPORATION.
+ * Copyright (c) 2019-2020, NVIDIA CORPORATION.
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -39,6 +39,48 @@ void make_regression_helper(const cumlHandle& handle, DataT* out, DataT* values,
     noise, shuffle, seed);
 }
 
+template <typename DataT>
+void make_regression_shard_helper(const cumlHandle& handle, DataT* out,
+                                  DataT* values, int64_t row_offset,
+                                  int64_t n_rows, int64_t n_cols,
+                                  int64_t n_informative, DataT* coef,
+                                  int64_t n_targets, DataT bias, DataT noise,
+                                  uint64_t seed) {
+  const auto& handle_impl = handle.getImpl();
+  MLCommon::Random::make_regression_shard(
+    out, values, row_offset, n_rows, n_cols, n_informative,
+    handle_impl.getCublasHandle(), handle_impl.getDeviceAllocator(),
+    handle_impl.getStream(), coef, n_targets, bias, noise, seed);
+}
+
+template <typename DataT>
+void make_regression_mg_helper(const cumlHandle& handle, DataT* out,
+                               DataT* values, int64_t n_rows, int64_t n_cols,
+                               int64_t n_informative, DataT* coef,
+                               int64_t n_targets, DataT bias, DataT noise,
+                               uint64_t seed) {
+  const auto& comm = handle.getImpl().getCommunicator();
+  int64_t row_offset, rank_rows;
+  shard_rows(n_rows, comm.getSize(), comm.getRank(), &row_offset, &rank_rows);
+  make_regression_shard_helper(handle, out, values, row_offset, rank_rows,
+                               n_cols, n_informative, coef, n_targets, bias,
+                               noise, seed);
+}
+
+template <typename DataT>
+void make_regression_chunked_helper(
+  const cumlHandle& handle, int64_t row_offset, int64_t n_rows,
+  int64_t n_cols, int64_t n_informative, int64_t chunk_rows,
+  const std::function<void(const DataT*, const DataT*, int64_t, int64_t)>&
+    consume,
+  DataT* coef, int64_t n_targets, DataT bias, DataT noise, uint64_t seed) {
+  const auto& handle_impl = handle.getImpl();
+  MLCommon::Random::make_regression_chunked(
+    row_offset, n_rows, n_cols, n_informative, chunk_rows, consume,
+    handle_impl.getCublasHandle(), handle_impl.getDeviceAllocator(),
+    handle_impl.getStream(), coef, n_targets, bias, noise, seed);
+}
+
 void make_regression(const cumlHandle& handle, float* out, float* values,
                      int64_t n_rows, int64_t n_cols, int64_t n_informative,
                      float* coef, int64_t n_targets, float bias,
@@ -79,5 +121,63 @@ void make_regression(const cumlHandle& handle, double* out, double* values,
                          noise, shuffle, seed);
 }
 
+void make_regression_shard(const cumlHandle& handle, float* out, float* values,
+                           int64_t row_offset, int64_t n_rows, int64_t n_cols,
+                           int64_t n_informative, float* coef,
+                           int64_t n_targets, float bias, float noise,
+                           uint64_t seed) {
+  make_regression_shard_helper(handle, out, values, row_offset, n_rows,
+                               n_cols, n_informative, coef, n_targets, bias,
+                               noise, seed);
+}
+
+void make_regression_shard(const cumlHandle& handle, double* out,
+                           double* values, int64_t row_offset, int64_t n_rows,
+                           int64_t n_cols, int64_t n_informative,
+                           double* coef, int64_t n_targets, double bias,
+                           double noise, uint64_t seed) {
+  make_regression_shard_helper(handle, out, values, row_offset, n_rows,
+                               n_cols, n_informative, coef, n_targets, bias,
+                               noise, seed);
+}
+
+void make_regression_mg(const cumlHandle& handle, float* out, float* values,
+                        int64_t n_rows, int64_t n_cols, int64_t n_informative,
+                        float* coef, int64_t n_targets, float bias, float noise,
+                        uint64_t seed) {
+  make_regression_mg_helper(handle, out, values, n_rows, n_cols,
+                            n_informative, coef, n_targets, bias, noise, seed);
+}
+
+void make_regression_mg(const cumlHandle& handle, double* out, double* values,
+                        int64_t n_rows, int64_t n_cols, int64_t n_informative,
+                        double* coef, int64_t n_targets, double bias,
+                        double noise, uint64_t seed) {
+  make_regression_mg_helper(handle, out, values, n_rows, n_cols,
+                            n_informative, coef, n_targets, bias, noise, seed);
+}
+
+void make_regression_chunked(
+  const cumlHandle& handle, int64_t row_offset, int64_t n_rows,
+  int64_t n_cols, int64_t n_informative, int64_t chunk_rows,
+  const std::function<void(const float*, const float*, int64_t, int64_t)>&
+    consume,
+  float* coef, int64_t n_targets, float bias, float noise, uint64_t seed) {
+  make_regression_chunked_helper(handle, row_offset, n_rows, n_cols,
+                                 n_informative, chunk_rows, consume, coef,
+                                 n_targets, bias, noise, seed);
+}
+
+void make_regression_chunked(
+  const cumlHandle& handle, int64_t row_offset, int64_t n_rows,
+  int64_t n_cols, int64_t n_informative, int64_t chunk_rows,
+  const std::function<void(const double*, const double*, int64_t, int64_t)>&
+    consume,
+  double* coef, int64_t n_targets, double bias, double noise, uint64_t seed) {
+  make_regression_chunked_helper(handle, row_offset, n_rows, n_cols,
+                                 n_informative, chunk_rows, consume, coef,
+                                 n_targets, bias, noise, seed);
+}
+
 }  // namespace Datasets
 }  // namespace ML
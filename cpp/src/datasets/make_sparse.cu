@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/datasets/make_sparse.hpp>
+#include "random/make_sparse.h"
+
+namespace ML {
+namespace Datasets {
+
+void make_sparse_rows(const cumlHandle& handle, int64_t* indptr,
+                      int64_t n_rows, int64_t n_cols, double density,
+                      uint64_t seed) {
+  MLCommon::Random::make_sparse_rows(indptr, n_rows, n_cols, density, seed,
+                                     handle.getStream());
+}
+
+void make_sparse_rows(const cumlHandle& handle, int* indptr, int n_rows,
+                      int n_cols, double density, uint64_t seed) {
+  MLCommon::Random::make_sparse_rows(indptr, n_rows, n_cols, density, seed,
+                                     handle.getStream());
+}
+
+void make_sparse(const cumlHandle& handle, int64_t* indices, float* values,
+                 const int64_t* indptr, int64_t n_rows, int64_t n_cols,
+                 double density, float value_min, float value_max,
+                 uint64_t seed) {
+  MLCommon::Random::make_sparse(indices, values, indptr, n_rows, n_cols,
+                                density, value_min, value_max, seed,
+                                handle.getStream());
+}
+
+void make_sparse(const cumlHandle& handle, int64_t* indices, double* values,
+                 const int64_t* indptr, int64_t n_rows, int64_t n_cols,
+                 double density, double value_min, double value_max,
+                 uint64_t seed) {
+  MLCommon::Random::make_sparse(indices, values, indptr, n_rows, n_cols,
+                                density, value_min, value_max, seed,
+                                handle.getStream());
+}
+
+void make_sparse(const cumlHandle& handle, int* indices, float* values,
+                 const int* indptr, int n_rows, int n_cols, double density,
+                 float value_min, float value_max, uint64_t seed) {
+  MLCommon::Random::make_sparse(indices, values, indptr, n_rows, n_cols,
+                                density, value_min, value_max, seed,
+                                handle.getStream());
+}
+
+void make_sparse(const cumlHandle& handle, int* indices, double* values,
+                 const int* indptr, int n_rows, int n_cols, double density,
+                 double value_min, double value_max, uint64_t seed) {
+  MLCommon::Random::make_sparse(indices, values, indptr, n_rows, n_cols,
+                                density, value_min, value_max, seed,
+                                handle.getStream());
+}
+
+}  // namespace Datasets
+}  // namespace ML
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_utils.h>
+#include <thrust/device_ptr.h>
+#include <thrust/scan.h>
+#include <thrust/transform.h>
+#include <common/allocatorAdapter.hpp>
+#include <common/cumlHandle.hpp>
+#include "../grid.h"
+#include "selection/radius_neighbors.h"
+
+namespace Dbscan {
+namespace AdjGraph {
+namespace Sparse {
+
+static const int TPB = 256;
+
+/**
+ * Builds the CSR epsilon neighborhood graph of the batch straight from the
+ * vertex degrees, without adjacency matrix: the CSR row_ind (ex_scan) is the
+ * exclusive scan of vd, and the neighbors of each vertex are written to
+ * adj_graph from there by a second pass of the tiled distances, or of the
+ * grid search. Fuses the construction of the core points.
+ * @param x the input dataset, row-major, of N rows and D cols
+ * @param N number of points in the dataset
+ * @param D dimensionality of the points
+ * @param eps epsilon neighborhood criterion
+ * @param vd degree of each of the batchSize vertices of the batch
+ * @param ex_scan output CSR row_ind of the batch
+ * @param adj_graph output CSR row_ind_ptr of the batch, of sum(vd) elements
+ * @param core_pts output core point flag of each vertex of the batch
+ * @param minPts core points criterion
+ * @param startVertexId index of the first vertex of the batch
+ * @param batchSize number of vertices in the batch
+ * @param stream cuda stream to use
+ * @param grid null, or the grid of the dataset to search the neighbors from
+ */
+template <typename Type, typename Index_ = int>
+void launcher(const ML::cumlHandle_impl &handle, const Type *x, Index_ N,
+              Index_ D, Type eps, const Index_ *vd, Index_ *ex_scan,
+              Index_ *adj_graph, bool *core_pts, int minPts,
+              Index_ startVertexId, Index_ batchSize, cudaStream_t stream,
+              const GridView<Type, Index_> *grid = nullptr) {
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  thrust::device_ptr<const Index_> dev_vd = thrust::device_pointer_cast(vd);
+  thrust::exclusive_scan(execution_policy, dev_vd, dev_vd + batchSize,
+                         thrust::device_pointer_cast(ex_scan));
+  thrust::transform(execution_policy, dev_vd, dev_vd + batchSize,
+                    thrust::device_pointer_cast(core_pts),
+                    [minPts] __device__(Index_ degree) {
+                      return degree >= minPts;
+                    });
+
+  if (grid != nullptr) {
+    grid_neighbors<Type, Index_>(*grid, x, eps, startVertexId, batchSize,
+                                 ex_scan, adj_graph, stream);
+    return;
+  }
+  MLCommon::Selection::radius_neighbors_launch<TPB, Type, Index_>(
+    x, N, true, x + startVertexId * D, batchSize, true, D, eps, ex_scan,
+    adj_graph, nullptr, stream);
+}
+
+}  // namespace Sparse
+}  // namespace AdjGraph
+}  // namespace Dbscan
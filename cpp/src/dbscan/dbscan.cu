@@ -17,9 +17,12 @@
 #include <common/cumlHandle.hpp>
 #include <cuml/cluster/dbscan.hpp>
 #include "dbscan.h"
+#include "hierarchy.h"
 #include "runner.h"
 #include "utils.h"
 
+#include <vector>
+
 namespace ML {
 
 using namespace Dbscan;
@@ -27,33 +30,188 @@ using namespace Dbscan;
 void dbscanFit(const cumlHandle &handle, float *input, int n_rows, int n_cols,
                float eps, int min_pts, int *labels, size_t max_bytes_per_batch,
                bool verbose) {
+  dbscanFit(handle, input, n_rows, n_cols, eps, min_pts, METRIC_L2, labels,
+            max_bytes_per_batch, verbose);
+}
+
+void dbscanFit(const cumlHandle &handle, float *input, int n_rows, int n_cols,
+               float eps, int min_pts, MetricType metric, int *labels,
+               size_t max_bytes_per_batch, bool verbose) {
   dbscanFitImpl<float, int>(handle.getImpl(), input, n_rows, n_cols, eps,
-                            min_pts, labels, max_bytes_per_batch,
+                            min_pts, metric, labels, max_bytes_per_batch,
                             handle.getStream(), verbose);
 }
 
 void dbscanFit(const cumlHandle &handle, double *input, int n_rows, int n_cols,
                double eps, int min_pts, int *labels, size_t max_bytes_per_batch,
                bool verbose) {
+  dbscanFit(handle, input, n_rows, n_cols, eps, min_pts, METRIC_L2, labels,
+            max_bytes_per_batch, verbose);
+}
+
+void dbscanFit(const cumlHandle &handle, double *input, int n_rows, int n_cols,
+               double eps, int min_pts, MetricType metric, int *labels,
+               size_t max_bytes_per_batch, bool verbose) {
   dbscanFitImpl<double, int>(handle.getImpl(), input, n_rows, n_cols, eps,
-                             min_pts, labels, max_bytes_per_batch,
+                             min_pts, metric, labels, max_bytes_per_batch,
                              handle.getStream(), verbose);
 }
 
 void dbscanFit(const cumlHandle &handle, float *input, int64_t n_rows,
                int64_t n_cols, float eps, int min_pts, int64_t *labels,
                size_t max_bytes_per_batch, bool verbose) {
+  dbscanFit(handle, input, n_rows, n_cols, eps, min_pts, METRIC_L2, labels,
+            max_bytes_per_batch, verbose);
+}
+
+void dbscanFit(const cumlHandle &handle, float *input, int64_t n_rows,
+               int64_t n_cols, float eps, int min_pts, MetricType metric,
+               int64_t *labels, size_t max_bytes_per_batch, bool verbose) {
   dbscanFitImpl<float, int64_t>(handle.getImpl(), input, n_rows, n_cols, eps,
-                                min_pts, labels, max_bytes_per_batch,
+                                min_pts, metric, labels, max_bytes_per_batch,
                                 handle.getStream(), verbose);
 }
 
 void dbscanFit(const cumlHandle &handle, double *input, int64_t n_rows,
                int64_t n_cols, double eps, int min_pts, int64_t *labels,
                size_t max_bytes_per_batch, bool verbose) {
+  dbscanFit(handle, input, n_rows, n_cols, eps, min_pts, METRIC_L2, labels,
+            max_bytes_per_batch, verbose);
+}
+
+void dbscanFit(const cumlHandle &handle, double *input, int64_t n_rows,
+               int64_t n_cols, double eps, int min_pts, MetricType metric,
+               int64_t *labels, size_t max_bytes_per_batch, bool verbose) {
   dbscanFitImpl<double, int64_t>(handle.getImpl(), input, n_rows, n_cols, eps,
-                                 min_pts, labels, max_bytes_per_batch,
+                                 min_pts, metric, labels, max_bytes_per_batch,
                                  handle.getStream(), verbose);
 }
 
+void dbscanFit(const cumlHandle &handle, const int *indptr, const int *indices,
+               const float *distances, int n_rows, float eps, int min_pts,
+               int *labels, bool verbose) {
+  dbscanFitPrecomputedImpl<float, int>(handle.getImpl(), indptr, indices,
+                                       distances, n_rows, eps, min_pts, labels,
+                                       handle.getStream(), verbose);
+}
+
+void dbscanFit(const cumlHandle &handle, const int *indptr, const int *indices,
+               const double *distances, int n_rows, double eps, int min_pts,
+               int *labels, bool verbose) {
+  dbscanFitPrecomputedImpl<double, int>(handle.getImpl(), indptr, indices,
+                                        distances, n_rows, eps, min_pts, labels,
+                                        handle.getStream(), verbose);
+}
+
+void dbscanFit(const cumlHandle &handle, const int64_t *indptr,
+               const int64_t *indices, const float *distances, int64_t n_rows,
+               float eps, int min_pts, int64_t *labels, bool verbose) {
+  dbscanFitPrecomputedImpl<float, int64_t>(handle.getImpl(), indptr, indices,
+                                           distances, n_rows, eps, min_pts,
+                                           labels, handle.getStream(), verbose);
+}
+
+void dbscanFit(const cumlHandle &handle, const int64_t *indptr,
+               const int64_t *indices, const double *distances, int64_t n_rows,
+               double eps, int min_pts, int64_t *labels, bool verbose) {
+  dbscanFitPrecomputedImpl<double, int64_t>(handle.getImpl(), indptr, indices,
+                                            distances, n_rows, eps, min_pts,
+                                            labels, handle.getStream(),
+                                            verbose);
+}
+
+int dbscanHierarchy(const cumlHandle &handle, const float *input, int n_rows,
+                    int n_cols, int min_pts, float max_eps, float *core_dists,
+                    int *mst_src, int *mst_dst, float *mst_weights,
+                    bool verbose) {
+  ASSERT(max_eps > 0, "max_eps must be positive");
+  ML::PUSH_RANGE("ML::Dbscan::Hierarchy");
+  int n_edges = Hierarchy::build(handle.getImpl(), input, n_rows, n_cols,
+                                 max_eps, min_pts, core_dists, mst_src,
+                                 mst_dst, mst_weights, handle.getStream(),
+                                 verbose);
+  ML::POP_RANGE();
+  return n_edges;
+}
+
+void dbscanCutHierarchy(const cumlHandle &handle, const float *core_dists,
+                        const int *mst_src, const int *mst_dst,
+                        const float *mst_weights, int n_edges, int n_rows,
+                        float eps, int *labels) {
+  Hierarchy::cut(handle.getImpl(), core_dists, mst_src, mst_dst, mst_weights,
+                 n_edges, n_rows, eps, labels, handle.getStream());
+}
+
+void hdbscanFit(const cumlHandle &handle, const float *input, int n_rows,
+                int n_cols, int min_pts, int min_cluster_size, float max_eps,
+                int *labels, bool verbose) {
+  ASSERT(min_cluster_size >= 2, "min_cluster_size must be at least 2");
+  cudaStream_t stream = handle.getStream();
+  auto d_alloc = handle.getDeviceAllocator();
+  MLCommon::device_buffer<float> core_dists(d_alloc, stream, n_rows);
+  MLCommon::device_buffer<int> mst_src(d_alloc, stream, n_rows);
+  MLCommon::device_buffer<int> mst_dst(d_alloc, stream, n_rows);
+  MLCommon::device_buffer<float> mst_weights(d_alloc, stream, n_rows);
+  int n_edges = dbscanHierarchy(
+    handle, input, n_rows, n_cols, min_pts, max_eps, core_dists.data(),
+    mst_src.data(), mst_dst.data(), mst_weights.data(), verbose);
+
+  ML::PUSH_RANGE("ML::Dbscan::Condense");
+  std::vector<int> h_src(n_edges), h_dst(n_edges), h_labels;
+  std::vector<float> h_weights(n_edges);
+  MLCommon::updateHost(h_src.data(), mst_src.data(), n_edges, stream);
+  MLCommon::updateHost(h_dst.data(), mst_dst.data(), n_edges, stream);
+  MLCommon::updateHost(h_weights.data(), mst_weights.data(), n_edges, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  Hierarchy::condense(h_src, h_dst, h_weights, n_rows, min_cluster_size,
+                      h_labels);
+  MLCommon::updateDevice(labels, h_labels.data(), n_rows, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  ML::POP_RANGE();
+}
+
+size_t dbscanMaxMbytesPerBatch(const cumlHandle &handle, int n_rows,
+                               int n_cols) {
+  return autoMaxMbytesPerBatch<int>(handle.getImpl(), n_rows, n_cols,
+                                    handle.getStream());
+}
+
+size_t dbscanMaxMbytesPerBatch(const cumlHandle &handle, int64_t n_rows,
+                               int64_t n_cols) {
+  return autoMaxMbytesPerBatch<int64_t>(handle.getImpl(), n_rows, n_cols,
+                                        handle.getStream());
+}
+
+void dbscanFitMG(const cumlHandle &handle, const float *input, int n_rows,
+                 int n_cols, float eps, int min_pts, int *labels,
+                 size_t max_bytes_per_batch, bool verbose) {
+  dbscanFitMGImpl<float, int>(handle.getImpl(), input, n_rows, n_cols, eps,
+                              min_pts, labels, max_bytes_per_batch,
+                              handle.getStream(), verbose);
+}
+
+void dbscanFitMG(const cumlHandle &handle, const double *input, int n_rows,
+                 int n_cols, double eps, int min_pts, int *labels,
+                 size_t max_bytes_per_batch, bool verbose) {
+  dbscanFitMGImpl<double, int>(handle.getImpl(), input, n_rows, n_cols, eps,
+                               min_pts, labels, max_bytes_per_batch,
+                               handle.getStream(), verbose);
+}
+
+void dbscanFitMG(const cumlHandle &handle, const float *input, int64_t n_rows,
+                 int64_t n_cols, float eps, int min_pts, int64_t *labels,
+                 size_t max_bytes_per_batch, bool verbose) {
+  dbscanFitMGImpl<float, int64_t>(handle.getImpl(), input, n_rows, n_cols, eps,
+                                  min_pts, labels, max_bytes_per_batch,
+                                  handle.getStream(), verbose);
+}
+
+void dbscanFitMG(const cumlHandle &handle, const double *input, int64_t n_rows,
+                 int64_t n_cols, double eps, int min_pts, int64_t *labels,
+                 size_t max_bytes_per_batch, bool verbose) {
+  dbscanFitMGImpl<double, int64_t>(handle.getImpl(), input, n_rows, n_cols, eps,
+                                   min_pts, labels, max_bytes_per_batch,
+                                   handle.getStream(), verbose);
+}
+
 };  // end namespace ML
@@ -16,9 +16,13 @@
 
 #pragma once
 
+#include <cuml/neighbors/knn.hpp>
 #include "common/device_buffer.hpp"
 #include "common/nvtx.hpp"
+#include "linalg/matrix_vector_op.h"
+#include "linalg/norm.h"
 #include "runner.h"
+#include "runner_mg.h"
 
 namespace ML {
 
@@ -56,36 +60,119 @@ Index_ computeBatchCount(Index_ n_rows, size_t max_mbytes_per_batch) {
   return n_batches;
 }
 
-template <typename T, typename Index_ = int>
-void dbscanFitImpl(const ML::cumlHandle_impl &handle, T *input, Index_ n_rows,
-                   Index_ n_cols, T eps, int min_pts, Index_ *labels,
-                   size_t max_mbytes_per_batch, cudaStream_t stream,
-                   bool verbose) {
-  ML::PUSH_RANGE("ML::Dbscan::Fit");
-  int algoVd = 1;
-  int algoAdj = 1;
-  int algoCcl = 2;
+/**
+ * Megabytes of the epsilon neighborhood graph of a batch when the caller
+ * leaves it to the fit: the free device memory, less the workspace of
+ * runSparse and the union-find forest, is halved to leave room for the
+ * grid, the temporary allocations of thrust and the fragmentation, and
+ * capped to DEFAULT_MAX_MEM_MBYTES. It is at least 1.
+ */
+template <typename Index_ = int>
+size_t autoMaxMbytesPerBatch(const ML::cumlHandle_impl &handle, Index_ n_rows,
+                             Index_ n_cols, cudaStream_t stream) {
+  size_t workspaceSize = Dbscan::runSparse<int, float, Index_>(
+    handle, nullptr, n_rows, n_cols, 0.f, 0, nullptr, 0, 3, NULL, 0, stream);
+  size_t reserved = workspaceSize + sizeof(Index_) * size_t(n_rows);
+
+  size_t free_mem, total_mem;
+  CUDA_CHECK(cudaMemGetInfo(&free_mem, &total_mem));
+  size_t available = free_mem > reserved ? (free_mem - reserved) / 2 : 0;
+  size_t mbytes = std::min<size_t>(available / 1e6, DEFAULT_MAX_MEM_MBYTES);
+  return std::max<size_t>(mbytes, 1);
+}
 
-  // @todo: Query device for remaining memory
-  Index_ n_batches = computeBatchCount<T, Index_>(n_rows, max_mbytes_per_batch);
+// Scales the rows to unit L2 norm; the rows of zero norm are kept
+template <typename T, typename Index_>
+void normalizeRows(T *out, const T *in, Index_ n_rows, Index_ n_cols,
+                   cudaStream_t stream,
+                   std::shared_ptr<deviceAllocator> d_alloc) {
+  MLCommon::device_buffer<T> norms(d_alloc, stream, n_rows);
+  MLCommon::LinAlg::rowNorm(norms.data(), in, n_cols, n_rows,
+                            MLCommon::LinAlg::L2Norm, true, stream,
+                            [] __device__(T v, Index_ i) { return sqrt(v); });
+  MLCommon::LinAlg::matrixVectorOp(
+    out, in, norms.data(), n_cols, n_rows, true, false,
+    [] __device__(T a, T norm) { return norm > T(0) ? a / norm : a; },
+    stream);
+}
 
-  if (verbose) {
-    Index_ batchSize = ceildiv<Index_>(n_rows, n_batches);
-    if (n_batches > 1) {
-      std::cout << "Running batched training on " << n_batches
-                << " batches w/ ";
-      std::cout << batchSize * n_rows * sizeof(T) * 1e-6 << " megabytes." << std::endl;
-    }
+template <typename T, typename Index_ = int>
+void dbscanFitImpl(const ML::cumlHandle_impl &handle, T *input, Index_ n_rows,
+                   Index_ n_cols, T eps, int min_pts, MetricType metric,
+                   Index_ *labels, size_t max_mbytes_per_batch,
+                   cudaStream_t stream, bool verbose) {
+  // the device memory and the time of the fit are accounted to its phase
+  ML::detail::phaseScope scope(handle, "ML::Dbscan::Fit");
+  // the cosine distance of two rows is half the squared L2 distance of the
+  // rows scaled to unit norm
+  MLCommon::device_buffer<T> normalized(handle.getDeviceAllocator(), stream);
+  switch (metric) {
+    case METRIC_L2:
+      break;
+    case METRIC_COSINE:
+      normalized.resize(size_t(n_rows) * n_cols, stream);
+      normalizeRows(normalized.data(), input, n_rows, n_cols, stream,
+                    handle.getDeviceAllocator());
+      input = normalized.data();
+      eps = sqrt(2 * eps);
+      break;
+    default:
+      ASSERT(false, "Dbscan does not support the metric %d", (int)metric);
   }
+  // low-dimensional points are searched from a grid of eps-sized cells
+  int algoVd = Dbscan::Grid<T, Index_>::supports(n_cols) ? 1 : 0;
+  // union-find does not iterate over the diameter of the clusters
+  int algoCcl = 3;
+
+  // The adjacency graph of a batch is the only allocation that grows with
+  // the batch, by one index per edge
+  if (max_mbytes_per_batch <= 0)
+    max_mbytes_per_batch =
+      autoMaxMbytesPerBatch(handle, n_rows, n_cols, stream);
+  if (verbose)
+    std::cout << "Epsilon graph batches of at most " << max_mbytes_per_batch
+              << "MB." << std::endl;
+  size_t max_edges_per_batch = max_mbytes_per_batch * 1e6 / sizeof(Index_);
 
-  size_t workspaceSize =
-    Dbscan::run(handle, input, n_rows, n_cols, eps, min_pts, labels, algoVd,
-                algoAdj, algoCcl, NULL, n_batches, stream);
+  size_t workspaceSize = Dbscan::runSparse(
+    handle, input, n_rows, n_cols, eps, min_pts, labels, algoVd, algoCcl, NULL,
+    max_edges_per_batch, stream);
 
   MLCommon::device_buffer<char> workspace(handle.getDeviceAllocator(), stream,
                                           workspaceSize);
-  Dbscan::run(handle, input, n_rows, n_cols, eps, min_pts, labels, algoVd,
-              algoAdj, algoCcl, workspace.data(), n_batches, stream, verbose);
+  Dbscan::runSparse(handle, input, n_rows, n_cols, eps, min_pts, labels,
+                    algoVd, algoCcl, workspace.data(), max_edges_per_batch,
+                    stream, verbose);
+}
+
+template <typename T, typename Index_ = int>
+void dbscanFitPrecomputedImpl(const ML::cumlHandle_impl &handle,
+                              const Index_ *indptr, const Index_ *indices,
+                              const T *distances, Index_ n_rows, T eps,
+                              int min_pts, Index_ *labels, cudaStream_t stream,
+                              bool verbose) {
+  ML::PUSH_RANGE("ML::Dbscan::FitPrecomputed");
+  Dbscan::runPrecomputed(handle, indptr, indices, distances, n_rows, eps,
+                         min_pts, labels, stream, verbose);
+  ML::POP_RANGE();
+}
+
+template <typename T, typename Index_ = int>
+void dbscanFitMGImpl(const ML::cumlHandle_impl &handle, const T *input,
+                     Index_ n_rows, Index_ n_cols, T eps, int min_pts,
+                     Index_ *labels, size_t max_mbytes_per_batch,
+                     cudaStream_t stream, bool verbose) {
+  ML::PUSH_RANGE("ML::Dbscan::FitMG");
+  ASSERT(handle.commsInitialized(),
+         "The handle must have a communicator for a distributed fit");
+  int algoVd = Dbscan::Grid<T, Index_>::supports(n_cols) ? 1 : 0;
+  int algoCcl = 2;
+
+  if (max_mbytes_per_batch <= 0) max_mbytes_per_batch = DEFAULT_MAX_MEM_MBYTES;
+  size_t max_edges_per_batch = max_mbytes_per_batch * 1e6 / sizeof(Index_);
+
+  Dbscan::mg::runMG(handle, input, n_rows, n_cols, eps, min_pts, labels,
+                    algoVd, algoCcl, max_edges_per_batch, stream, verbose);
   ML::POP_RANGE();
 }
 
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_utils.h>
+#include <thrust/execution_policy.h>
+#include <thrust/extrema.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <algorithm>
+#include <common/allocatorAdapter.hpp>
+#include <common/cumlHandle.hpp>
+#include <common/device_buffer.hpp>
+#include <limits>
+
+namespace Dbscan {
+
+/**
+ * Lightweight copy of a Grid passed to the kernels by value.
+ */
+template <typename Type, typename Index_>
+struct GridView {
+  static const int kMaxDims = 3;
+
+  /** cell keys of the points, in ascending order */
+  const int64_t *keys;
+  /** the points, sorted by cell key */
+  const Index_ *points;
+  /** lowest corner of the grid */
+  Type origin[kMaxDims];
+  /** number of cells along each dimension */
+  int64_t nCells[kMaxDims];
+  /** side of the cells, at least eps */
+  Type cellSize;
+  /** number of points */
+  Index_ N;
+  /** dimensionality of the points, at most kMaxDims */
+  Index_ D;
+
+  /** coordinate of the cell of point x along dimension d */
+  HDI int64_t cellCoord(const Type *x, int d) const {
+    int64_t c = int64_t((x[d] - origin[d]) / cellSize);
+    return c < nCells[d] ? c : nCells[d] - 1;
+  }
+
+  /** key of the cell of coordinates c */
+  HDI int64_t cellKey(const int64_t *c) const {
+    int64_t key = 0;
+    for (int d = D - 1; d >= 0; --d) key = key * nCells[d] + c[d];
+    return key;
+  }
+
+  /** first position in keys of a key not below 'key' */
+  DI Index_ lowerBound(int64_t key) const {
+    Index_ lo = 0, hi = N;
+    while (lo < hi) {
+      Index_ mid = lo + (hi - lo) / 2;
+      if (keys[mid] < key)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+};
+
+/**
+ * @brief Bins the points in a grid: sets the geometry of the grid in view
+ * and the cell keys and the points sorted by cell key in keys and points.
+ */
+template <typename Type, typename Index_>
+void buildGrid(const ML::cumlHandle_impl &handle, const Type *x, Index_ N,
+               Index_ D, Type eps, GridView<Type, Index_> &view,
+               int64_t *keys, Index_ *points, cudaStream_t stream) {
+  const int kMaxDims = GridView<Type, Index_>::kMaxDims;
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+
+  view.keys = keys;
+  view.points = points;
+  view.N = N;
+  view.D = D;
+
+  Type hi[kMaxDims], extent = 0;
+  for (int d = 0; d < D; ++d) {
+    auto coords = thrust::make_transform_iterator(
+      thrust::make_counting_iterator<Index_>(0),
+      [=] __device__(Index_ i) { return x[i * D + d]; });
+    auto minmax = thrust::minmax_element(execution_policy, coords, coords + N);
+    MLCommon::updateHost(view.origin + d, x + (minmax.first - coords) * D + d,
+                         1, stream);
+    MLCommon::updateHost(hi + d, x + (minmax.second - coords) * D + d, 1,
+                         stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    extent = std::max(extent, hi[d] - view.origin[d]);
+  }
+
+  // The cells are slightly larger than eps so that the rounding of the cell
+  // coordinates never separates neighbors by more than one cell, and there
+  // are at most 2^20 of them along a dimension so that the keys of the
+  // cells fit 64 bits
+  const Type kMaxCells = Type(1 << 20);
+  view.cellSize = std::max(eps * Type(1.0001), extent / kMaxCells);
+  if (view.cellSize <= 0) view.cellSize = 1;
+  for (int d = 0; d < D; ++d)
+    view.nCells[d] = int64_t((hi[d] - view.origin[d]) / view.cellSize) + 1;
+
+  GridView<Type, Index_> v = view;
+  thrust::transform(execution_policy, thrust::make_counting_iterator<Index_>(0),
+                    thrust::make_counting_iterator<Index_>(N), keys,
+                    [=] __device__(Index_ i) {
+                      int64_t c[kMaxDims];
+                      for (int d = 0; d < v.D; ++d)
+                        c[d] = v.cellCoord(x + i * v.D, d);
+                      return v.cellKey(c);
+                    });
+  thrust::sequence(execution_policy, points, points + N);
+  thrust::sort_by_key(execution_policy, keys, keys + N, points);
+}
+
+/**
+ * Uniform grid of cells of side eps over low-dimensional points: all the
+ * points within eps of a point lie in its cell or in the adjacent ones, so
+ * that an epsilon neighborhood only compares the points of 3^D cells. The
+ * cells are not stored: the points are sorted by cell key instead, which
+ * costs O(N) memory whatever the extent of the data.
+ */
+template <typename Type, typename Index_>
+class Grid {
+ public:
+  static const int kMaxDims = GridView<Type, Index_>::kMaxDims;
+
+  /** can the points of dimensionality D be binned in a grid? */
+  static bool supports(Index_ D) { return D >= 1 && D <= kMaxDims; }
+
+  /**
+   * @param handle cuml handle whose allocator holds the grid
+   * @param x the input dataset, row-major, of N rows and D cols
+   * @param N number of points
+   * @param D dimensionality of the points, see supports()
+   * @param eps epsilon neighborhood criterion
+   * @param stream cuda stream to use
+   */
+  Grid(const ML::cumlHandle_impl &handle, const Type *x, Index_ N, Index_ D,
+       Type eps, cudaStream_t stream)
+    : keys(handle.getDeviceAllocator(), stream, N),
+      points(handle.getDeviceAllocator(), stream, N) {
+    ASSERT(supports(D), "the grid supports at most %d dimensions", kMaxDims);
+    buildGrid(handle, x, N, D, eps, view, keys.data(), points.data(), stream);
+  }
+
+  GridView<Type, Index_> view;
+
+ private:
+  MLCommon::device_buffer<int64_t> keys;
+  MLCommon::device_buffer<Index_> points;
+};
+
+/**
+ * Epsilon neighborhoods of a batch of points from a grid, one thread per
+ * point of the batch. Without col_ind, the number of neighbors of each point
+ * is written to row_ind; otherwise the neighbors are written from row_ind.
+ */
+template <typename Type, typename Index_, int TPB>
+__global__ void grid_neighbors_kernel(GridView<Type, Index_> grid,
+                                      const Type *x, Type eps2,
+                                      Index_ startVertexId, Index_ batchSize,
+                                      Index_ *row_ind, Index_ *col_ind) {
+  const int kMaxDims = GridView<Type, Index_>::kMaxDims;
+  Index_ row = (Index_)blockIdx.x * TPB + threadIdx.x;
+  if (row >= batchSize) return;
+
+  Index_ D = grid.D;
+  const Type *p = x + (startVertexId + row) * D;
+  int64_t c[kMaxDims], o[kMaxDims];
+  for (int d = 0; d < D; ++d) c[d] = grid.cellCoord(p, d);
+
+  Index_ pos = col_ind != nullptr ? row_ind[row] : 0;
+  int nNeighborCells = 1;
+  for (int d = 0; d < D; ++d) nNeighborCells *= 3;
+  for (int n = 0; n < nNeighborCells; ++n) {
+    bool inside = true;
+    for (int d = 0, r = n; d < D; ++d, r /= 3) {
+      o[d] = c[d] + r % 3 - 1;
+      inside = inside && o[d] >= 0 && o[d] < grid.nCells[d];
+    }
+    if (!inside) continue;
+
+    int64_t key = grid.cellKey(o);
+    for (Index_ j = grid.lowerBound(key); j < grid.N && grid.keys[j] == key;
+         ++j) {
+      Index_ idx = grid.points[j];
+      const Type *q = x + idx * D;
+      Type acc = 0;
+      for (int d = 0; d < D; ++d) {
+        Type diff = p[d] - q[d];
+        acc += diff * diff;
+      }
+      if (acc <= eps2) {
+        if (col_ind != nullptr) col_ind[pos] = idx;
+        ++pos;
+      }
+    }
+  }
+
+  if (col_ind == nullptr) row_ind[row] = pos;
+}
+
+/**
+ * @brief Epsilon neighborhoods of a batch of points from a grid.
+ * @param grid the grid of the dataset
+ * @param x the input dataset, row-major, of grid.N rows and grid.D cols
+ * @param eps epsilon neighborhood criterion
+ * @param startVertexId index of the first point of the batch
+ * @param batchSize number of points in the batch
+ * @param row_ind without col_ind, the output degrees of the points of the
+ *        batch; otherwise their CSR row offsets
+ * @param col_ind null or the output neighbors of the points of the batch
+ * @param stream cuda stream to use
+ */
+template <typename Type, typename Index_>
+void grid_neighbors(const GridView<Type, Index_> &grid, const Type *x,
+                    Type eps, Index_ startVertexId, Index_ batchSize,
+                    Index_ *row_ind, Index_ *col_ind, cudaStream_t stream) {
+  const int TPB = 256;
+  grid_neighbors_kernel<Type, Index_, TPB>
+    <<<MLCommon::ceildiv<Index_>(batchSize, TPB), TPB, 0, stream>>>(
+      grid, x, eps * eps, startVertexId, batchSize, row_ind, col_ind);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+}  // namespace Dbscan
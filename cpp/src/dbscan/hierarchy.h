@@ -0,0 +1,491 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <thrust/device_ptr.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <common/allocatorAdapter.hpp>
+#include <common/cumlHandle.hpp>
+#include <common/device_buffer.hpp>
+#include "adjgraph/sparse.h"
+#include "grid.h"
+#include "runner.h"
+#include "sparse/csr.h"
+#include "vertexdeg/sparse.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <memory>
+#include <vector>
+
+namespace Dbscan {
+
+// The hierarchy of the DBSCAN* clusters over all eps up to a maximum, as in
+// HDBSCAN*. A point is core at eps when it has at least minPts neighbors
+// within eps, itself included, so from its core distance on; two core points
+// are connected at eps when they are within eps of each other. The clusters
+// at all eps are thus the components of the minimum spanning tree of the
+// mutual reachability graph cut above eps.
+namespace Hierarchy {
+
+// Distance and source of each edge of the CSR graph
+template <int TPB_X = TPB>
+__global__ void edgeDistancesKernel(const float* x, int N, int D,
+                                    const int* row_ind, const int* cols,
+                                    int nnz, int* rows, float* dists) {
+  int tid = threadIdx.x + blockIdx.x * TPB_X;
+  if (tid >= N) return;
+  int stop = tid < N - 1 ? row_ind[tid + 1] : nnz;
+  const float* a = x + size_t(tid) * D;
+  for (int j = row_ind[tid]; j < stop; j++) {
+    const float* b = x + size_t(cols[j]) * D;
+    float acc = 0;
+    for (int d = 0; d < D; d++) {
+      float diff = a[d] - b[d];
+      acc += diff * diff;
+    }
+    rows[j] = tid;
+    dists[j] = sqrtf(acc);
+  }
+}
+
+// The core distance is the minPts-th smallest distance of the row, or
+// FLT_MAX when the point is not core at the maximum eps
+template <int TPB_X = TPB>
+__global__ void coreDistancesKernel(const int* row_ind, const int* vd,
+                                    const float* sorted_dists, int N,
+                                    int minPts, float* core_dists) {
+  int tid = threadIdx.x + blockIdx.x * TPB_X;
+  if (tid >= N) return;
+  core_dists[tid] =
+    vd[tid] >= minPts ? sorted_dists[row_ind[tid] + minPts - 1] : FLT_MAX;
+}
+
+// Mutual reachability weights, in place of the distances; FLT_MAX marks the
+// self loops and the edges of the points that are never core
+template <int TPB_X = TPB>
+__global__ void mutualReachabilityKernel(const int* rows, const int* cols,
+                                         const float* core_dists, int nnz,
+                                         float* weights) {
+  int e = threadIdx.x + blockIdx.x * TPB_X;
+  if (e >= nnz) return;
+  int u = rows[e], v = cols[e];
+  float w = fmaxf(weights[e], fmaxf(core_dists[u], core_dists[v]));
+  weights[e] = u == v ? FLT_MAX : w;
+}
+
+// The edges are ordered by weight, then by their smaller then larger vertex,
+// which is the same for both directions of an edge. With this total order,
+// the lightest edges out of the components form a forest.
+DI unsigned long long edgeKey(int u, int v, int N) {
+  return (unsigned long long)min(u, v) * N + max(u, v);
+}
+
+template <int TPB_X = TPB>
+__global__ void lightestWeightKernel(const int* rows, const int* cols,
+                                     const float* weights, int nnz,
+                                     const int* comp, unsigned int* bestW) {
+  int e = threadIdx.x + blockIdx.x * TPB_X;
+  if (e >= nnz || weights[e] == FLT_MAX) return;
+  int cu = comp[rows[e]];
+  if (cu == comp[cols[e]]) return;
+  // non-negative floats compare as their bits
+  atomicMin(bestW + cu, __float_as_uint(weights[e]));
+}
+
+template <int TPB_X = TPB>
+__global__ void lightestKeyKernel(const int* rows, const int* cols,
+                                  const float* weights, int nnz, int N,
+                                  const int* comp, const unsigned int* bestW,
+                                  unsigned long long* bestKey) {
+  int e = threadIdx.x + blockIdx.x * TPB_X;
+  if (e >= nnz || weights[e] == FLT_MAX) return;
+  int u = rows[e], v = cols[e], cu = comp[u];
+  if (cu == comp[v] || __float_as_uint(weights[e]) != bestW[cu]) return;
+  atomicMin(bestKey + cu, edgeKey(u, v, N));
+}
+
+template <int TPB_X = TPB>
+__global__ void lightestEdgeKernel(const int* rows, const int* cols,
+                                   const float* weights, int nnz, int N,
+                                   const int* comp, const unsigned int* bestW,
+                                   const unsigned long long* bestKey,
+                                   int* bestEdge) {
+  int e = threadIdx.x + blockIdx.x * TPB_X;
+  if (e >= nnz || weights[e] == FLT_MAX) return;
+  int u = rows[e], v = cols[e], cu = comp[u];
+  if (cu == comp[v] || __float_as_uint(weights[e]) != bestW[cu]) return;
+  // only one direction of the edge leaves cu
+  if (edgeKey(u, v, N) == bestKey[cu]) bestEdge[cu] = e;
+}
+
+template <int TPB_X = TPB>
+__global__ void addEdgesKernel(const int* rows, const int* cols,
+                               const float* weights, int N, const int* comp,
+                               const unsigned long long* bestKey,
+                               const int* bestEdge, int* forest, int* mst_src,
+                               int* mst_dst, float* mst_weights,
+                               int* n_edges) {
+  int c = threadIdx.x + blockIdx.x * TPB_X;
+  if (c >= N || bestEdge[c] < 0) return;
+  int e = bestEdge[c];
+  int cv = comp[cols[e]];
+  // when both components chose the same edge, the larger one adds it
+  if (bestKey[cv] == bestKey[c] && c < cv) return;
+  int k = atomicAdd(n_edges, 1);
+  mst_src[k] = rows[e];
+  mst_dst[k] = cols[e];
+  mst_weights[k] = weights[e];
+  MLCommon::Sparse::uf_union(forest, rows[e], cols[e]);
+}
+
+template <int TPB_X = TPB>
+__global__ void componentsKernel(int* forest, int* comp, int N) {
+  int tid = threadIdx.x + blockIdx.x * TPB_X;
+  if (tid < N) comp[tid] = MLCommon::Sparse::uf_find(forest, tid);
+}
+
+/**
+ * Minimum spanning forest of a graph by Boruvka: every round, each component
+ * adds its lightest outgoing edge, so that the number of components at least
+ * halves, in O(log N) rounds of a few kernels each.
+ * @param rows source of each of the nnz edges; the graph is symmetric
+ * @param cols destination of each edge
+ * @param weights weight of each edge, FLT_MAX for the edges to ignore
+ * @param mst_src output sources of the forest edges, of at most N - 1
+ * @param mst_dst output destinations of the forest edges
+ * @param mst_weights output weights of the forest edges
+ * @return the number of edges of the forest
+ */
+inline int boruvka(const ML::cumlHandle_impl& handle, const int* rows,
+                   const int* cols, const float* weights, int nnz, int N,
+                   int* mst_src, int* mst_dst, float* mst_weights,
+                   cudaStream_t stream) {
+  auto d_alloc = handle.getDeviceAllocator();
+  ML::thrustAllocatorAdapter alloc(d_alloc, stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+
+  MLCommon::device_buffer<int> forest(d_alloc, stream, N);
+  MLCommon::device_buffer<int> comp(d_alloc, stream, N);
+  MLCommon::device_buffer<unsigned int> bestW(d_alloc, stream, N);
+  MLCommon::device_buffer<unsigned long long> bestKey(d_alloc, stream, N);
+  MLCommon::device_buffer<int> bestEdge(d_alloc, stream, N);
+  MLCommon::device_buffer<int> d_n_edges(d_alloc, stream, 1);
+  thrust::sequence(execution_policy,
+                   thrust::device_pointer_cast(forest.data()),
+                   thrust::device_pointer_cast(forest.data()) + N);
+  MLCommon::copyAsync(comp.data(), forest.data(), N, stream);
+  CUDA_CHECK(cudaMemsetAsync(d_n_edges.data(), 0, sizeof(int), stream));
+
+  size_t vblks = ceildiv<size_t>(N, TPB), eblks = ceildiv<size_t>(nnz, TPB);
+  int n_edges = 0, prev_n_edges;
+  do {
+    prev_n_edges = n_edges;
+    // all ones are the max unsigned values and the -1 edges
+    CUDA_CHECK(
+      cudaMemsetAsync(bestW.data(), 0xff, sizeof(unsigned int) * N, stream));
+    CUDA_CHECK(cudaMemsetAsync(bestKey.data(), 0xff,
+                               sizeof(unsigned long long) * N, stream));
+    CUDA_CHECK(cudaMemsetAsync(bestEdge.data(), 0xff, sizeof(int) * N, stream));
+    if (nnz > 0) {
+      lightestWeightKernel<TPB><<<eblks, TPB, 0, stream>>>(
+        rows, cols, weights, nnz, comp.data(), bestW.data());
+      CUDA_CHECK(cudaPeekAtLastError());
+      lightestKeyKernel<TPB><<<eblks, TPB, 0, stream>>>(
+        rows, cols, weights, nnz, N, comp.data(), bestW.data(),
+        bestKey.data());
+      CUDA_CHECK(cudaPeekAtLastError());
+      lightestEdgeKernel<TPB><<<eblks, TPB, 0, stream>>>(
+        rows, cols, weights, nnz, N, comp.data(), bestW.data(),
+        bestKey.data(), bestEdge.data());
+      CUDA_CHECK(cudaPeekAtLastError());
+    }
+    addEdgesKernel<TPB><<<vblks, TPB, 0, stream>>>(
+      rows, cols, weights, N, comp.data(), bestKey.data(), bestEdge.data(),
+      forest.data(), mst_src, mst_dst, mst_weights, d_n_edges.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+    componentsKernel<TPB>
+      <<<vblks, TPB, 0, stream>>>(forest.data(), comp.data(), N);
+    CUDA_CHECK(cudaPeekAtLastError());
+    MLCommon::updateHost(&n_edges, d_n_edges.data(), 1, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  } while (n_edges > prev_n_edges);
+  return n_edges;
+}
+
+/**
+ * Core distances of the points and minimum spanning forest of the mutual
+ * reachability graph, whose edges join the points within maxEps of each other
+ * and weigh max(distance, core distances of both ends). The forest is built
+ * from the whole epsilon neighborhood graph at maxEps, by the same vertex
+ * degree and adjacency graph runners as dbscan, so maxEps bounds the memory.
+ * @param x the points, row-major, of N rows and D cols
+ * @param maxEps the largest eps of the hierarchy
+ * @param minPts core points criterion
+ * @param core_dists output core distance of each point, FLT_MAX above maxEps
+ * @param mst_src output sources of the edges of the forest, of size N - 1
+ * @param mst_dst output destinations of the edges of the forest
+ * @param mst_weights output weights of the edges, in ascending order
+ * @return the number of edges of the forest
+ */
+inline int build(const ML::cumlHandle_impl& handle, const float* x, int N,
+                 int D, float maxEps, int minPts, float* core_dists,
+                 int* mst_src, int* mst_dst, float* mst_weights,
+                 cudaStream_t stream, bool verbose = false) {
+  auto d_alloc = handle.getDeviceAllocator();
+  ML::thrustAllocatorAdapter alloc(d_alloc, stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+
+  ML::PUSH_RANGE("Trace::Dbscan::Hierarchy::Graph");
+  std::unique_ptr<Grid<float, int>> grid;
+  if (Grid<float, int>::supports(D))
+    grid.reset(new Grid<float, int>(handle, x, N, D, maxEps, stream));
+  const GridView<float, int>* gridView = grid ? &grid->view : nullptr;
+
+  MLCommon::device_buffer<int> vd(d_alloc, stream, N);
+  VertexDeg::Sparse::launcher<float, int>(x, N, D, maxEps, vd.data(), 0, N,
+                                          stream, gridView);
+  thrust::device_ptr<int> dev_vd = thrust::device_pointer_cast(vd.data());
+  size_t nnz = thrust::reduce(execution_policy, dev_vd, dev_vd + N, size_t(0));
+  ASSERT(nnz <= size_t(INT_MAX),
+         "The graph at max_eps has %zu edges, more than an int can index",
+         nnz);
+  if (verbose)
+    std::cout << "--> Mutual reachability graph of " << nnz << " edges"
+              << std::endl;
+
+  MLCommon::device_buffer<int> ex_scan(d_alloc, stream, N);
+  MLCommon::device_buffer<int> cols(d_alloc, stream, nnz);
+  MLCommon::device_buffer<bool> core_pts(d_alloc, stream, N);
+  AdjGraph::Sparse::launcher<float, int>(
+    handle, x, N, D, maxEps, vd.data(), ex_scan.data(), cols.data(),
+    core_pts.data(), minPts, 0, N, stream, gridView);
+  grid.reset();
+
+  MLCommon::device_buffer<int> rows(d_alloc, stream, nnz);
+  MLCommon::device_buffer<float> weights(d_alloc, stream, nnz);
+  size_t vblks = ceildiv<size_t>(N, TPB), eblks = ceildiv<size_t>(nnz, TPB);
+  edgeDistancesKernel<TPB><<<vblks, TPB, 0, stream>>>(
+    x, N, D, ex_scan.data(), cols.data(), nnz, rows.data(), weights.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+  {
+    // a segmented sort of the distances of each row, by two stable sorts
+    MLCommon::device_buffer<int> sorted_rows(d_alloc, stream, nnz);
+    MLCommon::device_buffer<float> sorted_dists(d_alloc, stream, nnz);
+    MLCommon::copyAsync(sorted_rows.data(), rows.data(), nnz, stream);
+    MLCommon::copyAsync(sorted_dists.data(), weights.data(), nnz, stream);
+    auto dev_rows = thrust::device_pointer_cast(sorted_rows.data());
+    auto dev_dists = thrust::device_pointer_cast(sorted_dists.data());
+    thrust::stable_sort_by_key(execution_policy, dev_dists, dev_dists + nnz,
+                               dev_rows);
+    thrust::stable_sort_by_key(execution_policy, dev_rows, dev_rows + nnz,
+                               dev_dists);
+    coreDistancesKernel<TPB><<<vblks, TPB, 0, stream>>>(
+      ex_scan.data(), vd.data(), sorted_dists.data(), N, minPts, core_dists);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+  if (nnz > 0) {
+    mutualReachabilityKernel<TPB><<<eblks, TPB, 0, stream>>>(
+      rows.data(), cols.data(), core_dists, nnz, weights.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+  ML::POP_RANGE();
+
+  ML::PUSH_RANGE("Trace::Dbscan::Hierarchy::MST");
+  int n_edges = boruvka(handle, rows.data(), cols.data(), weights.data(), nnz,
+                        N, mst_src, mst_dst, mst_weights, stream);
+  auto dev_weights = thrust::device_pointer_cast(mst_weights);
+  thrust::sort_by_key(
+    execution_policy, dev_weights, dev_weights + n_edges,
+    thrust::make_zip_iterator(thrust::make_tuple(
+      thrust::device_pointer_cast(mst_src),
+      thrust::device_pointer_cast(mst_dst))));
+  ML::POP_RANGE();
+  if (verbose)
+    std::cout << "--> Spanning forest of " << n_edges << " edges" << std::endl;
+  return n_edges;
+}
+
+template <int TPB_X = TPB>
+__global__ void cutKernel(const int* mst_src, const int* mst_dst,
+                          const float* mst_weights, int n_edges, float eps,
+                          int* forest) {
+  int e = threadIdx.x + blockIdx.x * TPB_X;
+  if (e < n_edges && mst_weights[e] <= eps)
+    MLCommon::Sparse::uf_union(forest, mst_src[e], mst_dst[e]);
+}
+
+template <int TPB_X = TPB>
+__global__ void cutLabelsKernel(int* forest, const float* core_dists, int N,
+                                float eps, int* labels) {
+  int tid = threadIdx.x + blockIdx.x * TPB_X;
+  if (tid >= N) return;
+  labels[tid] = core_dists[tid] <= eps
+                  ? MLCommon::Sparse::uf_find(forest, tid) + 1
+                  : INT_MAX;
+}
+
+/**
+ * DBSCAN* labels at eps, at most the maxEps of the hierarchy: the
+ * components of the core points at eps in the forest cut above eps. Unlike
+ * dbscan, the border points are noise.
+ */
+inline void cut(const ML::cumlHandle_impl& handle, const float* core_dists,
+                const int* mst_src, const int* mst_dst,
+                const float* mst_weights, int n_edges, int N, float eps,
+                int* labels, cudaStream_t stream) {
+  auto d_alloc = handle.getDeviceAllocator();
+  ML::thrustAllocatorAdapter alloc(d_alloc, stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  MLCommon::device_buffer<int> forest(d_alloc, stream, N);
+  thrust::sequence(execution_policy,
+                   thrust::device_pointer_cast(forest.data()),
+                   thrust::device_pointer_cast(forest.data()) + N);
+  if (n_edges > 0) {
+    cutKernel<TPB><<<ceildiv<size_t>(n_edges, TPB), TPB, 0, stream>>>(
+      mst_src, mst_dst, mst_weights, n_edges, eps, forest.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+  size_t nblks = ceildiv<size_t>(N, TPB);
+  cutLabelsKernel<TPB><<<nblks, TPB, 0, stream>>>(forest.data(), core_dists,
+                                                  N, eps, labels);
+  CUDA_CHECK(cudaPeekAtLastError());
+  final_relabel(labels, N, stream);
+  relabelForSkl<int><<<nblks, TPB, 0, stream>>>(labels, N, INT_MAX);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * Labels of the most stable clusters of the hierarchy, on the host, as the
+ * excess of mass selection of HDBSCAN*: the single linkage tree of the forest
+ * is condensed to the clusters of at least minClusterSize points, whose
+ * stability is the sum over their points of how long, in 1 / eps, the points
+ * stay in them. A cluster is selected over its descendants when it is more
+ * stable than the clusters selected among them. The components of the forest
+ * are children of a root at infinite eps, which is never selected.
+ * @param mst_src sources of the edges of the forest, by ascending weight
+ * @param labels output labels of the N points, -1 for the noise
+ */
+inline void condense(const std::vector<int>& mst_src,
+                     const std::vector<int>& mst_dst,
+                     const std::vector<float>& mst_weights, int N,
+                     int minClusterSize, std::vector<int>& labels) {
+  int m = mst_src.size();
+  // node N + k of the single linkage tree merges the ends of edge k
+  std::vector<int> left(m), right(m), size(N + m, 1), set(N), setNode(N);
+  std::vector<bool> hasParent(N + m, false);
+  for (int i = 0; i < N; i++) set[i] = setNode[i] = i;
+  auto find = [&set](int i) {
+    while (set[i] != i) i = set[i] = set[set[i]];
+    return i;
+  };
+  for (int k = 0; k < m; k++) {
+    int a = find(mst_src[k]), b = find(mst_dst[k]);
+    left[k] = setNode[a];
+    right[k] = setNode[b];
+    hasParent[left[k]] = hasParent[right[k]] = true;
+    size[N + k] = size[left[k]] + size[right[k]];
+    set[b] = a;
+    setNode[a] = N + k;
+  }
+  auto lambda = [&mst_weights](int k) {
+    return 1.0 / std::max<double>(mst_weights[k], 1e-30);
+  };
+
+  // the clusters of the condensed tree; 0 is the root at infinite eps, and
+  // parents come before their children
+  std::vector<int> parent(1, -1);
+  std::vector<double> birth(1, 0), stability(1, 0);
+  std::vector<int> pointCluster(N, 0);
+  auto newCluster = [&](int p, double b) {
+    parent.push_back(p);
+    birth.push_back(b);
+    stability.push_back(0);
+    return int(parent.size()) - 1;
+  };
+  std::vector<int> leaves;
+  auto fallOut = [&](int node, int c, double l) {
+    stability[c] += (l - birth[c]) * size[node];
+    leaves.assign(1, node);
+    while (!leaves.empty()) {
+      int n = leaves.back();
+      leaves.pop_back();
+      if (n < N) {
+        pointCluster[n] = c;
+      } else {
+        leaves.push_back(left[n - N]);
+        leaves.push_back(right[n - N]);
+      }
+    }
+  };
+
+  std::vector<std::pair<int, int>> stack;
+  for (int node = 0; node < N + m; node++) {
+    if (hasParent[node]) continue;
+    if (size[node] >= minClusterSize)
+      stack.push_back(std::make_pair(node, newCluster(0, 0)));
+    else
+      fallOut(node, 0, 0);
+  }
+  while (!stack.empty()) {
+    int node = stack.back().first, c = stack.back().second;
+    stack.pop_back();
+    int k = node - N, a = left[k], b = right[k];
+    double l = lambda(k);
+    bool bigA = size[a] >= minClusterSize, bigB = size[b] >= minClusterSize;
+    if (bigA && bigB) {
+      stability[c] += (l - birth[c]) * size[node];
+      stack.push_back(std::make_pair(a, newCluster(c, l)));
+      stack.push_back(std::make_pair(b, newCluster(c, l)));
+      continue;
+    }
+    if (bigA)
+      stack.push_back(std::make_pair(a, c));
+    else
+      fallOut(a, c, l);
+    if (bigB)
+      stack.push_back(std::make_pair(b, c));
+    else
+      fallOut(b, c, l);
+  }
+
+  // excess of mass, from the leaves of the condensed tree up
+  int n_clusters = parent.size();
+  std::vector<double> childStability(n_clusters, 0);
+  std::vector<bool> selected(n_clusters, false);
+  for (int c = n_clusters - 1; c > 0; c--) {
+    selected[c] = stability[c] >= childStability[c];
+    childStability[parent[c]] += std::max(stability[c], childStability[c]);
+  }
+  // the selected clusters without selected ancestors are labeled, and their
+  // descendants too
+  std::vector<int> clusterLabel(n_clusters, -1);
+  int next = 0;
+  for (int c = 1; c < n_clusters; c++) {
+    int fromParent = clusterLabel[parent[c]];
+    clusterLabel[c] = fromParent >= 0 ? fromParent : selected[c] ? next++ : -1;
+  }
+  labels.resize(N);
+  for (int i = 0; i < N; i++) labels[i] = clusterLabel[pointCluster[i]];
+}
+
+}  // namespace Hierarchy
+}  // namespace Dbscan
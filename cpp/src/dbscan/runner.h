@@ -17,17 +17,27 @@
 #pragma once
 
 #include "adjgraph/runner.h"
+#include "adjgraph/sparse.h"
 #include "common/cumlHandle.hpp"
 #include "common/device_buffer.hpp"
+#include "common/host_buffer.hpp"
 #include "common/nvtx.hpp"
 #include "cuda_utils.h"
+#include "grid.h"
 #include "label/classlabels.h"
 #include "sparse/csr.h"
 #include "vertexdeg/runner.h"
+#include "vertexdeg/sparse.h"
 
 #include "utils.h"
 
+#include <thrust/copy.h>
+#include <thrust/functional.h>
+#include <thrust/transform.h>
+#include <common/allocatorAdapter.hpp>
+
 #include <sys/time.h>
+#include <memory>
 
 namespace Dbscan {
 
@@ -43,9 +53,10 @@ static const int TPB = 256;
 template <typename Index_ = int>
 __global__ void relabelForSkl(Index_* labels, Index_ N, Index_ MAX_LABEL) {
   Index_ tid = threadIdx.x + blockDim.x * blockIdx.x;
+  if (tid >= N) return;
   if (labels[tid] == MAX_LABEL)
     labels[tid] = -1;
-  else if (tid < N)
+  else
     --labels[tid];
 }
 
@@ -215,4 +226,271 @@ size_t run(const ML::cumlHandle_impl& handle, Type_f* x, Index_ N, Index_ D,
   if (verbose) std::cout << "Done." << std::endl;
   return (size_t)0;
 }
+
+/**
+ * Number of points of the largest batch from startVertexId whose graph has
+ * at most maxEdges edges, and at least one point; its number of edges is
+ * written to adjlen.
+ * @param degrees host vertex degrees of the N points
+ */
+template <typename Index_>
+Index_ nextBatchSize(const Index_* degrees, Index_ startVertexId, Index_ N,
+                     size_t maxEdges, size_t& adjlen) {
+  Index_ nPoints = 0;
+  adjlen = 0;
+  while (startVertexId + nPoints < N &&
+         (nPoints == 0 ||
+          adjlen + degrees[startVertexId + nPoints] <= maxEdges)) {
+    adjlen += degrees[startVertexId + nPoints];
+    ++nPoints;
+  }
+  return nPoints;
+}
+
+/* Dbscan on the CSR epsilon neighborhood graph, built without adjacency
+ * matrix, so that the memory of a batch is proportional to its number of
+ * edges: the vertex degrees of all the points are computed first, then the
+ * points are split in batches of at most maxEdgesPerBatch edges, whose
+ * graphs are written from the exclusive scan of their degrees.
+ * @param N number of points
+ * @param D dimensionality of the points
+ * @param eps epsilon neighborhood criterion
+ * @param minPts core points criterion
+ * @param labels the output labels (should be of size N)
+ * @param algoVd 0 to compute the distances to all the points in tiles, 1 to
+ *               compare only the points of neighboring cells of a grid of
+ *               eps-sized cells (Grid::supports(D) must hold)
+ * @param algoCcl the connected components labelling algorithm: 2 for the
+ *                label propagation of weak_cc, 3 for union-find; the labels
+ *                are made monotonic in both cases
+ * @param workspace temporary global memory buffer as for run(); the
+ *                  adjacency graphs and the union-find forest are allocated
+ *                  from the handle
+ * @param maxEdgesPerBatch the maximum number of edges in the graph of a batch;
+ *                         a batch has at least one point
+ * @param stream the cudaStream where to launch the kernels
+ * @return in case the temp buffer is null, this returns the size needed.
+ */
+template <typename Type, typename Type_f, typename Index_ = int>
+size_t runSparse(const ML::cumlHandle_impl& handle, Type_f* x, Index_ N,
+                 Index_ D, Type_f eps, Type minPts, Index_* labels, int algoVd,
+                 int algoCcl, void* workspace, size_t maxEdgesPerBatch,
+                 cudaStream_t stream, bool verbose = false) {
+  const size_t align = 256;
+  size_t corePtsSize = alignTo<size_t>(sizeof(bool) * N, align);
+  size_t xaSize = alignTo<size_t>(sizeof(bool) * N, align);
+  size_t mSize = alignTo<size_t>(sizeof(bool), align);
+  size_t vdSize = alignTo<size_t>(sizeof(Index_) * N, align);
+  size_t exScanSize = alignTo<size_t>(sizeof(Index_) * N, align);
+
+  if (workspace == NULL) {
+    return corePtsSize + 2 * xaSize + mSize + vdSize + exScanSize;
+  }
+
+  // the CSR row_ind of a batch must not overflow Index_
+  Index_ MAX_LABEL = std::numeric_limits<Index_>::max();
+  maxEdgesPerBatch = std::min(maxEdgesPerBatch, size_t(MAX_LABEL));
+
+  char* temp = (char*)workspace;
+  bool* core_pts = (bool*)temp;
+  temp += corePtsSize;
+  bool* xa = (bool*)temp;
+  temp += xaSize;
+  bool* fa = (bool*)temp;
+  temp += xaSize;
+  bool* m = (bool*)temp;
+  temp += mSize;
+  Index_* vd = (Index_*)temp;
+  temp += vdSize;
+  Index_* ex_scan = (Index_*)temp;
+  temp += exScanSize;
+
+  MLCommon::Sparse::WeakCCState state(xa, fa, m);
+  MLCommon::device_buffer<Index_> adj_graph(handle.getDeviceAllocator(),
+                                            stream);
+  ASSERT(algoCcl == 2 || algoCcl == 3, "Incorrect algo passed! '%d'", algoCcl);
+  MLCommon::device_buffer<Index_> parent(handle.getDeviceAllocator(), stream,
+                                         algoCcl == 3 ? N : 0);
+  // xa is free for the seeded vertices when union-find replaces weak_cc
+  MLCommon::Sparse::UnionFindState<Index_> ufState(parent.data(), xa);
+
+  ML::PUSH_RANGE("Trace::Dbscan::VertexDeg");
+  int64_t start_time = curTimeMillis();
+  std::unique_ptr<Grid<Type_f, Index_>> grid;
+  switch (algoVd) {
+    case 0:
+      break;
+    case 1:
+      if (verbose) std::cout << "--> Binning the points" << std::endl;
+      grid.reset(new Grid<Type_f, Index_>(handle, x, N, D, eps, stream));
+      break;
+    default:
+      ASSERT(false, "Incorrect algo passed! '%d'", algoVd);
+  }
+  const GridView<Type_f, Index_>* gridView = grid ? &grid->view : nullptr;
+
+  if (verbose) std::cout << "--> Computing vertex degrees" << std::endl;
+  VertexDeg::Sparse::launcher<Type_f, Index_>(x, N, D, eps, vd, 0, N, stream,
+                                              gridView);
+  MLCommon::host_buffer<Index_> host_vd(handle.getHostAllocator(), stream, N);
+  MLCommon::updateHost(host_vd.data(), vd, N, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  ML::POP_RANGE();
+  if (verbose)
+    std::cout << "    |-> Took " << (curTimeMillis() - start_time) << "ms."
+              << std::endl;
+
+  for (Index_ startVertexId = 0; startVertexId < N;) {
+    size_t adjlen;
+    Index_ nPoints = nextBatchSize(host_vd.data(), startVertexId, N,
+                                   maxEdgesPerBatch, adjlen);
+
+    if (verbose)
+      std::cout << "- Batch of " << nPoints << " samples from " << startVertexId
+                << ", adjacency graph of size " << adjlen << "." << std::endl;
+
+    ML::PUSH_RANGE("Trace::Dbscan::AdjGraph");
+    start_time = curTimeMillis();
+    if (adjlen > adj_graph.size()) adj_graph.resize(adjlen, stream);
+    AdjGraph::Sparse::launcher<Type_f, Index_>(
+      handle, x, N, D, eps, vd + startVertexId, ex_scan, adj_graph.data(),
+      core_pts, minPts, startVertexId, nPoints, stream, gridView);
+    ML::POP_RANGE();
+    if (verbose)
+      std::cout << "    |-> Adjacency graph took "
+                << (curTimeMillis() - start_time) << "ms." << std::endl;
+
+    ML::PUSH_RANGE("Trace::Dbscan::WeakCC");
+    start_time = curTimeMillis();
+    auto isCore = [core_pts] __device__(Index_ tid) { return core_pts[tid]; };
+    if (algoCcl == 3) {
+      MLCommon::Sparse::weak_cc_union_find_batched<Index_, TPB>(
+        labels, ex_scan, adj_graph.data(), Index_(adjlen), N, startVertexId,
+        nPoints, &ufState, stream, isCore);
+    } else {
+      MLCommon::Sparse::weak_cc_batched<Index_, 1024>(
+        labels, ex_scan, adj_graph.data(), Index_(adjlen), N, startVertexId,
+        nPoints, &state, stream, isCore);
+    }
+    ML::POP_RANGE();
+    if (verbose)
+      std::cout << "    |-> Connected components took "
+                << (curTimeMillis() - start_time) << "ms." << std::endl;
+
+    startVertexId += nPoints;
+  }
+
+  ML::PUSH_RANGE("Trace::Dbscan::FinalRelabel");
+  final_relabel(labels, N, stream);
+  size_t nblks = ceildiv<size_t>(N, TPB);
+  relabelForSkl<Index_><<<nblks, TPB, 0, stream>>>(labels, N, MAX_LABEL);
+  CUDA_CHECK(cudaPeekAtLastError());
+  ML::POP_RANGE();
+
+  if (verbose) std::cout << "Done." << std::endl;
+  return (size_t)0;
+}
+
+template <typename Type_f, typename Index_>
+__global__ void countNeighborsKernel(const Index_* indptr, const Type_f* dists,
+                                     Index_ N, Type_f eps, Index_* vd) {
+  Index_ tid = threadIdx.x + blockDim.x * blockIdx.x;
+  if (tid >= N) return;
+  Index_ degree = 0;
+  for (Index_ j = indptr[tid]; j < indptr[tid + 1]; j++)
+    degree += dists[j] <= eps;
+  vd[tid] = degree;
+}
+
+/* Dbscan on a precomputed neighborhood graph, such as a knn graph: the
+ * neighbors of each point are a row of the CSR graph (indptr, indices),
+ * and the degree of a point is the number of its neighbors, so a row should
+ * include the point itself to match dbscan on the points. The graph does not
+ * have to be symmetric.
+ * @param indptr CSR row offsets of the graph, of size N + 1
+ * @param indices CSR column indices of the graph
+ * @param dists null to keep all the neighbors, or the distances of the
+ *              neighbors, of which only those within eps are kept
+ * @param N number of points
+ * @param eps epsilon neighborhood criterion, unused without dists
+ * @param minPts core points criterion
+ * @param labels the output labels (should be of size N)
+ * @param stream the cudaStream where to launch the kernels
+ */
+template <typename Type_f, typename Index_ = int>
+void runPrecomputed(const ML::cumlHandle_impl& handle, const Index_* indptr,
+                    const Index_* indices, const Type_f* dists, Index_ N,
+                    Type_f eps, int minPts, Index_* labels, cudaStream_t stream,
+                    bool verbose = false) {
+  auto d_alloc = handle.getDeviceAllocator();
+  ML::thrustAllocatorAdapter alloc(d_alloc, stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  Index_ MAX_LABEL = std::numeric_limits<Index_>::max();
+
+  Index_ nnz;
+  MLCommon::updateHost(&nnz, indptr + N, 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  ML::PUSH_RANGE("Trace::Dbscan::VertexDeg");
+  MLCommon::device_buffer<Index_> vd(d_alloc, stream, N);
+  MLCommon::device_buffer<Index_> ex_scan(d_alloc, stream);
+  MLCommon::device_buffer<Index_> adj_graph(d_alloc, stream);
+  thrust::device_ptr<Index_> dev_vd = thrust::device_pointer_cast(vd.data());
+  thrust::device_ptr<const Index_> dev_indptr =
+    thrust::device_pointer_cast(indptr);
+  const Index_* row_ind = indptr;
+  const Index_* row_ind_ptr = indices;
+  if (dists == nullptr) {
+    thrust::transform(execution_policy, dev_indptr + 1, dev_indptr + N + 1,
+                      dev_indptr, dev_vd, thrust::minus<Index_>());
+  } else {
+    // only the neighbors within eps are kept, in the order of the rows
+    size_t nblks = ceildiv<size_t>(N, TPB);
+    countNeighborsKernel<Type_f, Index_>
+      <<<nblks, TPB, 0, stream>>>(indptr, dists, N, eps, vd.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+    ex_scan.resize(N, stream);
+    thrust::exclusive_scan(execution_policy, dev_vd, dev_vd + N,
+                           thrust::device_pointer_cast(ex_scan.data()));
+    adj_graph.resize(nnz, stream);
+    auto dev_adj_end = thrust::copy_if(
+      execution_policy, thrust::device_pointer_cast(indices),
+      thrust::device_pointer_cast(indices) + nnz,
+      thrust::device_pointer_cast(dists),
+      thrust::device_pointer_cast(adj_graph.data()),
+      [eps] __device__(Type_f dist) { return dist <= eps; });
+    nnz = dev_adj_end - thrust::device_pointer_cast(adj_graph.data());
+    row_ind = ex_scan.data();
+    row_ind_ptr = adj_graph.data();
+  }
+  MLCommon::device_buffer<bool> core_pts(d_alloc, stream, N);
+  thrust::transform(execution_policy, dev_vd, dev_vd + N,
+                    thrust::device_pointer_cast(core_pts.data()),
+                    [minPts] __device__(Index_ degree) {
+                      return degree >= minPts;
+                    });
+  ML::POP_RANGE();
+  if (verbose)
+    std::cout << "--> Neighborhood graph of " << nnz << " edges" << std::endl;
+
+  ML::PUSH_RANGE("Trace::Dbscan::WeakCC");
+  MLCommon::device_buffer<Index_> parent(d_alloc, stream, N);
+  MLCommon::device_buffer<bool> seeded(d_alloc, stream, N);
+  MLCommon::Sparse::UnionFindState<Index_> state(parent.data(),
+                                                 seeded.data());
+  bool* core = core_pts.data();
+  MLCommon::Sparse::weak_cc_union_find_batched<Index_, TPB>(
+    labels, row_ind, row_ind_ptr, nnz, N, Index_(0), N, &state, stream,
+    [core] __device__(Index_ tid) { return core[tid]; });
+  ML::POP_RANGE();
+
+  ML::PUSH_RANGE("Trace::Dbscan::FinalRelabel");
+  final_relabel(labels, N, stream);
+  size_t nblks = ceildiv<size_t>(N, TPB);
+  relabelForSkl<Index_><<<nblks, TPB, 0, stream>>>(labels, N, MAX_LABEL);
+  CUDA_CHECK(cudaPeekAtLastError());
+  ML::POP_RANGE();
+
+  if (verbose) std::cout << "Done." << std::endl;
+}
 }  // namespace Dbscan
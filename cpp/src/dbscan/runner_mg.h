@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <thrust/device_ptr.h>
+#include <thrust/equal.h>
+#include <thrust/fill.h>
+#include <common/allocatorAdapter.hpp>
+#include <common/cuml_comms_int.hpp>
+#include "runner.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace Dbscan {
+
+// Distributed dbscan: every rank of the communicator of the handle holds a
+// shard of the points, numbered in rank order
+namespace mg {
+
+// Index of the first point of each rank; the last entry is the total # of
+// points
+template <typename Index_>
+std::vector<Index_> getRankOffsets(const ML::cumlHandle_impl& handle,
+                                   Index_ n_local, cudaStream_t stream) {
+  const MLCommon::cumlCommunicator& comm = handle.getCommunicator();
+  int rank = comm.getRank();
+  int n_ranks = comm.getSize();
+
+  MLCommon::device_buffer<Index_> counts(handle.getDeviceAllocator(), stream,
+                                         n_ranks);
+  MLCommon::updateDevice(counts.data() + rank, &n_local, 1, stream);
+  comm.allgather(counts.data() + rank, counts.data(), 1, stream);
+
+  std::vector<Index_> offsets(n_ranks + 1, 0);
+  MLCommon::updateHost(offsets.data() + 1, counts.data(), n_ranks, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  std::partial_sum(offsets.begin() + 1, offsets.end(), offsets.begin() + 1);
+  return offsets;
+}
+
+// The communicator counts the elements of a collective with an int
+static const size_t MAX_COLLECTIVE_COUNT = size_t(1) << 30;
+
+template <typename Index_>
+__global__ void pointerJumpKernel(const Index_* in, Index_* out, Index_ N,
+                                  Index_ MAX_LABEL, bool* changed) {
+  Index_ tid = threadIdx.x + blockDim.x * blockIdx.x;
+  if (tid >= N) return;
+  Index_ l = in[tid];
+  if (l != MAX_LABEL && in[l - 1] < l) {
+    out[tid] = in[l - 1];
+    *changed = true;
+  } else {
+    out[tid] = l;
+  }
+}
+
+/**
+ * Shortcuts the labels in place: the label of each point becomes the label of
+ * the point its label stands for, which is smaller or equal, until no label
+ * changes. Labels are 1 + the index of the point they stand for.
+ * @param tmp buffer of N labels
+ * @param changed device flag
+ */
+template <typename Index_>
+void pointerJump(Index_* labels, Index_* tmp, Index_ N, bool* changed,
+                 cudaStream_t stream) {
+  Index_ MAX_LABEL = std::numeric_limits<Index_>::max();
+  size_t nblks = ceildiv<size_t>(N, TPB);
+  bool host_changed;
+  do {
+    CUDA_CHECK(cudaMemsetAsync(changed, false, sizeof(bool), stream));
+    pointerJumpKernel<Index_>
+      <<<nblks, TPB, 0, stream>>>(labels, tmp, N, MAX_LABEL, changed);
+    CUDA_CHECK(cudaPeekAtLastError());
+    MLCommon::copyAsync(labels, tmp, N, stream);
+    MLCommon::updateHost(&host_changed, changed, 1, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  } while (host_changed);
+}
+
+/**
+ * Dbscan over the ranks of the communicator of the handle. Each rank builds
+ * the epsilon neighborhood graph of its own points, against the points of all
+ * the ranks, and labels its connected components from the current labels of
+ * all the points. The labels are then merged by a min allreduce and
+ * shortcut by pointer jumping, and the rounds repeat until the labels no
+ * longer change. Points whose neighborhoods straddle shards need one round per
+ * crossing of a component between the ranks, so spatially coherent shards
+ * converge in fewer rounds.
+ * @param x_local the points of this rank, row-major, of n_local rows
+ * @param n_local number of points of this rank
+ * @param labels_local the output labels of the points of this rank
+ * @param maxEdgesPerBatch maximum number of edges of the graph of a batch
+ */
+template <typename Type, typename Type_f, typename Index_ = int>
+void runMG(const ML::cumlHandle_impl& handle, const Type_f* x_local,
+           Index_ n_local, Index_ D, Type_f eps, Type minPts,
+           Index_* labels_local, int algoVd, int algoCcl,
+           size_t maxEdgesPerBatch, cudaStream_t stream,
+           bool verbose = false) {
+  const MLCommon::cumlCommunicator& comm = handle.getCommunicator();
+  int rank = comm.getRank();
+  int n_ranks = comm.getSize();
+  auto d_alloc = handle.getDeviceAllocator();
+  ML::thrustAllocatorAdapter alloc(d_alloc, stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+
+  std::vector<Index_> offsets = getRankOffsets(handle, n_local, stream);
+  Index_ N = offsets.back();
+  Index_ offset = offsets[rank];
+  Index_ MAX_LABEL = std::numeric_limits<Index_>::max();
+  maxEdgesPerBatch = std::min(maxEdgesPerBatch, size_t(MAX_LABEL));
+
+  // every rank searches the neighbors of its points among all the points
+  ML::PUSH_RANGE("Trace::Dbscan::GatherPoints");
+  MLCommon::device_buffer<Type_f> x(d_alloc, stream, size_t(N) * D);
+  MLCommon::copyAsync(x.data() + size_t(offset) * D, x_local,
+                      size_t(n_local) * D, stream);
+  for (int r = 0; r < n_ranks; ++r) {
+    size_t begin = size_t(offsets[r]) * D, end = size_t(offsets[r + 1]) * D;
+    for (size_t i = begin; i < end; i += MAX_COLLECTIVE_COUNT) {
+      int count = std::min(end - i, MAX_COLLECTIVE_COUNT);
+      comm.bcast(x.data() + i, count, r, stream);
+    }
+  }
+  ML::POP_RANGE();
+
+  ML::PUSH_RANGE("Trace::Dbscan::VertexDeg");
+  int64_t start_time = curTimeMillis();
+  std::unique_ptr<Grid<Type_f, Index_>> grid;
+  switch (algoVd) {
+    case 0:
+      break;
+    case 1:
+      if (verbose) std::cout << "--> Binning the points" << std::endl;
+      grid.reset(new Grid<Type_f, Index_>(handle, x.data(), N, D, eps, stream));
+      break;
+    default:
+      ASSERT(false, "Incorrect algo passed! '%d'", algoVd);
+  }
+  const GridView<Type_f, Index_>* gridView = grid ? &grid->view : nullptr;
+
+  if (verbose) std::cout << "--> Computing vertex degrees" << std::endl;
+  MLCommon::device_buffer<Index_> vd(d_alloc, stream, n_local);
+  VertexDeg::Sparse::launcher<Type_f, Index_>(x.data(), N, D, eps, vd.data(),
+                                              offset, n_local, stream,
+                                              gridView);
+  MLCommon::host_buffer<Index_> host_vd(handle.getHostAllocator(), stream,
+                                        n_local);
+  MLCommon::updateHost(host_vd.data(), vd.data(), n_local, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  ML::POP_RANGE();
+  if (verbose)
+    std::cout << "    |-> Took " << (curTimeMillis() - start_time) << "ms."
+              << std::endl;
+
+  // local batches, whose graphs fit maxEdgesPerBatch
+  std::vector<Index_> batchStarts, batchSizes;
+  std::vector<size_t> batchEdges;
+  Index_ maxBatchSize = 0;
+  size_t maxAdjlen = 0;
+  for (Index_ start = 0; start < n_local;) {
+    size_t adjlen;
+    Index_ nPoints =
+      nextBatchSize(host_vd.data(), start, n_local, maxEdgesPerBatch, adjlen);
+    batchStarts.push_back(start);
+    batchSizes.push_back(nPoints);
+    batchEdges.push_back(adjlen);
+    maxBatchSize = std::max(maxBatchSize, nPoints);
+    maxAdjlen = std::max(maxAdjlen, adjlen);
+    start += nPoints;
+  }
+  // the graph of a single batch is built once, for all the rounds
+  bool cacheGraph = batchStarts.size() == 1;
+
+  MLCommon::device_buffer<bool> core_pts(d_alloc, stream, maxBatchSize);
+  MLCommon::device_buffer<Index_> ex_scan(d_alloc, stream, maxBatchSize);
+  MLCommon::device_buffer<Index_> adj_graph(d_alloc, stream, maxAdjlen);
+  MLCommon::device_buffer<bool> xa(d_alloc, stream, N);
+  MLCommon::device_buffer<bool> fa(d_alloc, stream, N);
+  MLCommon::device_buffer<bool> m(d_alloc, stream, 1);
+  MLCommon::Sparse::WeakCCState state(xa.data(), fa.data(), m.data());
+
+  MLCommon::device_buffer<Index_> labels(d_alloc, stream, N);
+  MLCommon::device_buffer<Index_> prev(d_alloc, stream, N);
+  MLCommon::device_buffer<Index_> jumped(d_alloc, stream, N);
+  thrust::device_ptr<Index_> dev_labels =
+    thrust::device_pointer_cast(labels.data());
+  thrust::device_ptr<Index_> dev_prev =
+    thrust::device_pointer_cast(prev.data());
+  thrust::fill(execution_policy, dev_labels, dev_labels + N, MAX_LABEL);
+
+  for (int round = 0;; ++round) {
+    MLCommon::copyAsync(prev.data(), labels.data(), N, stream);
+    CUDA_CHECK(cudaMemsetAsync(fa.data(), true, sizeof(bool) * N, stream));
+    CUDA_CHECK(cudaMemsetAsync(xa.data(), false, sizeof(bool) * N, stream));
+
+    ML::PUSH_RANGE("Trace::Dbscan::WeakCC");
+    start_time = curTimeMillis();
+    for (size_t b = 0; b < batchStarts.size(); ++b) {
+      Index_ start = batchStarts[b];
+      Index_ nPoints = batchSizes[b];
+      if (!cacheGraph || round == 0) {
+        AdjGraph::Sparse::launcher<Type_f, Index_>(
+          handle, x.data(), N, D, eps, vd.data() + start, ex_scan.data(),
+          adj_graph.data(), core_pts.data(), minPts, offset + start, nPoints,
+          stream, gridView);
+      }
+      bool* core = core_pts.data();
+      MLCommon::Sparse::weak_cc_label_batched<Index_, 1024>(
+        labels.data(), ex_scan.data(), adj_graph.data(), Index_(batchEdges[b]),
+        N, &state, offset + start, nPoints, stream,
+        [core] __device__(Index_ tid) { return core[tid]; });
+    }
+    ML::POP_RANGE();
+
+    ML::PUSH_RANGE("Trace::Dbscan::MergeLabels");
+    for (size_t i = 0; i < size_t(N); i += MAX_COLLECTIVE_COUNT) {
+      int count = std::min(size_t(N) - i, MAX_COLLECTIVE_COUNT);
+      comm.allreduce(labels.data() + i, labels.data() + i, count,
+                     MLCommon::cumlCommunicator::MIN, stream);
+    }
+    pointerJump(labels.data(), jumped.data(), N, m.data(), stream);
+    ML::POP_RANGE();
+    if (verbose)
+      std::cout << "- Round " << round << " took "
+                << (curTimeMillis() - start_time) << "ms." << std::endl;
+
+    // the labels are the same on all the ranks after the merge
+    if (thrust::equal(execution_policy, dev_labels, dev_labels + N, dev_prev))
+      break;
+  }
+
+  ML::PUSH_RANGE("Trace::Dbscan::FinalRelabel");
+  if (algoCcl == 2) final_relabel(labels.data(), N, stream);
+  size_t nblks = ceildiv<size_t>(N, TPB);
+  relabelForSkl<Index_>
+    <<<nblks, TPB, 0, stream>>>(labels.data(), N, MAX_LABEL);
+  CUDA_CHECK(cudaPeekAtLastError());
+  MLCommon::copyAsync(labels_local, labels.data() + offset, n_local, stream);
+  ML::POP_RANGE();
+
+  if (verbose) std::cout << "Done." << std::endl;
+}
+
+}  // namespace mg
+}  // namespace Dbscan
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_utils.h>
+#include "../grid.h"
+#include "selection/radius_neighbors.h"
+
+namespace Dbscan {
+namespace VertexDeg {
+namespace Sparse {
+
+static const int TPB = 256;
+
+/**
+ * Calculates the vertex degree array of the batch without the adjacency
+ * matrix: the distances are computed in tiles, or only to the points of the
+ * neighboring cells of a grid, and only counted.
+ * @param x the input dataset, row-major, of N rows and D cols
+ * @param N number of points in the dataset
+ * @param D dimensionality of the points
+ * @param eps epsilon neighborhood criterion
+ * @param vd output degree of each of the batchSize vertices of the batch
+ * @param startVertexId index of the first vertex of the batch
+ * @param batchSize number of vertices in the batch
+ * @param stream cuda stream to use
+ * @param grid null, or the grid of the dataset to search the neighbors from
+ */
+template <typename Type, typename Index_ = int>
+void launcher(const Type *x, Index_ N, Index_ D, Type eps, Index_ *vd,
+              Index_ startVertexId, Index_ batchSize, cudaStream_t stream,
+              const GridView<Type, Index_> *grid = nullptr) {
+  if (grid != nullptr) {
+    grid_neighbors<Type, Index_>(*grid, x, eps, startVertexId, batchSize, vd,
+                                 nullptr, stream);
+    return;
+  }
+  MLCommon::Selection::radius_neighbors_launch<TPB, Type, Index_>(
+    x, N, true, x + startVertexId * D, batchSize, true, D, eps, vd, nullptr,
+    nullptr, stream);
+}
+
+}  // namespace Sparse
+}  // namespace VertexDeg
+}  // namespace Dbscan
@@ -34,13 +34,18 @@ namespace DecisionTree {
  * @param[in] cfg_split_criterion: split criterion; default CRITERION_END,
  *            i.e., GINI for classification or MSE for regression
  * @param[in] cfg_quantile_per_tree: compute quantile per tree; default false
+ * @param[in] cfg_shuffle_features: reshuffle features per node; default false
+ * @param[in] cfg_quantize: pre-bin the data once per RF; default false
+ * @param[in] cfg_stream_cols: stream host data in blocks of that many
+ *            columns; default 0 (no streaming)
  */
 void set_tree_params(DecisionTreeParams &params, int cfg_max_depth,
                      int cfg_max_leaves, float cfg_max_features, int cfg_n_bins,
                      int cfg_split_algo, int cfg_min_rows_per_node,
                      float cfg_min_impurity_decrease,
                      bool cfg_bootstrap_features, CRITERION cfg_split_criterion,
-                     bool cfg_quantile_per_tree, bool cfg_shuffle_features) {
+                     bool cfg_quantile_per_tree, bool cfg_shuffle_features,
+                     bool cfg_quantize, int cfg_stream_cols) {
   params.max_depth = cfg_max_depth;
   params.max_leaves = cfg_max_leaves;
   params.max_features = cfg_max_features;
@@ -52,6 +57,8 @@ void set_tree_params(DecisionTreeParams &params, int cfg_max_depth,
   params.quantile_per_tree = cfg_quantile_per_tree;
   params.shuffle_features = cfg_shuffle_features;
   params.min_impurity_decrease = cfg_min_impurity_decrease;
+  params.quantize = cfg_quantize;
+  params.stream_cols = cfg_stream_cols;
 }
 
 /**
@@ -78,6 +85,17 @@ void validity_check(const DecisionTreeParams params) {
            "For GLOBAL_QUANTILE algorithm, only max depth of 32 is currently "
            "supported");
   }
+  ASSERT((params.stream_cols >= 0), "Invalid stream_cols %d",
+         params.stream_cols);
+  if (params.stream_cols > 0) {
+    ASSERT((params.split_algo == SPLIT_ALGO::GLOBAL_QUANTILE) &&
+             !params.quantile_per_tree,
+           "stream_cols requires quantiles computed once per RF with the "
+           "GLOBAL_QUANTILE algorithm");
+    ASSERT((params.max_features == 1.0f) && !params.bootstrap_features &&
+             !params.shuffle_features,
+           "stream_cols requires all the features, in order, at every node");
+  }
 }
 
 /**
@@ -95,6 +113,8 @@ void print(const DecisionTreeParams params) {
   std::cout << "split_criterion: " << params.split_criterion << std::endl;
   std::cout << "quantile_per_tree: " << params.quantile_per_tree << std::endl;
   std::cout << "shuffle_features: " << params.shuffle_features << std::endl;
+  std::cout << "quantize: " << params.quantize << std::endl;
+  std::cout << "stream_cols: " << params.stream_cols << std::endl;
 }
 
 /**
@@ -174,6 +194,82 @@ void decisionTreeClassifierFit(const ML::cumlHandle &handle,
 }
 /** @} */
 
+/**
+ * @defgroup Decision Tree Classifier - Sparse fit functions
+ * @brief Same as decisionTreeClassifierFit, for sparse train data: the
+ *   histograms are built from the nonzeros, without densifying the data.
+ *   Only the GLOBAL_QUANTILE split algorithm is supported, without
+ *   feature shuffling.
+ * @param[in] handle: cumlHandle
+ * @param[in, out] tree: CPU pointer to TreeMetaDataNode. User allocated.
+ * @param[in] csc_ind, csr_ind: offset of the first nonzero of each column
+ *    (ncols, CSC) or row (nrows, CSR). Device pointer.
+ * @param[in] csc_rows, csr_cols: row (CSC, sorted within each column) or
+ *    column (CSR) index of each nonzero. Device pointer.
+ * @param[in] csc_vals, csr_vals: value of each nonzero. Device pointer.
+ * @param[in] nnz: number of nonzeros.
+ * @param[in] ncols: number of features (i.e., columns) excluding target feature.
+ * @param[in] nrows: number of training data samples of the whole unsampled dataset.
+ * @param[in] labels: see decisionTreeClassifierFit.
+ * @param[in,out] rowids: see decisionTreeClassifierFit.
+ * @param[in] n_sampled_rows: number of training samples, after sampling.
+ * @param[in] n_unique_labels: #unique label values. Number of categories of classification.
+ * @param[in] tree_params: Decision Tree training hyper parameter struct.
+ * @{
+ */
+void decisionTreeClassifierFitCSC(
+  const ML::cumlHandle &handle, TreeClassifierF *&tree, const int *csc_ind,
+  const int *csc_rows, const float *csc_vals, const int nnz, const int ncols,
+  const int nrows, int *labels, unsigned int *rowids,
+  const int n_sampled_rows, int unique_labels,
+  DecisionTree::DecisionTreeParams tree_params) {
+  std::shared_ptr<DecisionTreeClassifier<float>> dt_classifier =
+    std::make_shared<DecisionTreeClassifier<float>>();
+  dt_classifier->fit_csc(handle, csc_ind, csc_rows, csc_vals, nnz, ncols,
+                         nrows, labels, rowids, n_sampled_rows, unique_labels,
+                         tree, tree_params);
+}
+
+void decisionTreeClassifierFitCSC(
+  const ML::cumlHandle &handle, TreeClassifierD *&tree, const int *csc_ind,
+  const int *csc_rows, const double *csc_vals, const int nnz,
+  const int ncols, const int nrows, int *labels, unsigned int *rowids,
+  const int n_sampled_rows, int unique_labels,
+  DecisionTree::DecisionTreeParams tree_params) {
+  std::shared_ptr<DecisionTreeClassifier<double>> dt_classifier =
+    std::make_shared<DecisionTreeClassifier<double>>();
+  dt_classifier->fit_csc(handle, csc_ind, csc_rows, csc_vals, nnz, ncols,
+                         nrows, labels, rowids, n_sampled_rows, unique_labels,
+                         tree, tree_params);
+}
+
+void decisionTreeClassifierFitCSR(
+  const ML::cumlHandle &handle, TreeClassifierF *&tree, const int *csr_ind,
+  const int *csr_cols, const float *csr_vals, const int nnz, const int ncols,
+  const int nrows, int *labels, unsigned int *rowids,
+  const int n_sampled_rows, int unique_labels,
+  DecisionTree::DecisionTreeParams tree_params) {
+  std::shared_ptr<DecisionTreeClassifier<float>> dt_classifier =
+    std::make_shared<DecisionTreeClassifier<float>>();
+  dt_classifier->fit_csr(handle, csr_ind, csr_cols, csr_vals, nnz, ncols,
+                         nrows, labels, rowids, n_sampled_rows, unique_labels,
+                         tree, tree_params);
+}
+
+void decisionTreeClassifierFitCSR(
+  const ML::cumlHandle &handle, TreeClassifierD *&tree, const int *csr_ind,
+  const int *csr_cols, const double *csr_vals, const int nnz,
+  const int ncols, const int nrows, int *labels, unsigned int *rowids,
+  const int n_sampled_rows, int unique_labels,
+  DecisionTree::DecisionTreeParams tree_params) {
+  std::shared_ptr<DecisionTreeClassifier<double>> dt_classifier =
+    std::make_shared<DecisionTreeClassifier<double>>();
+  dt_classifier->fit_csr(handle, csr_ind, csr_cols, csr_vals, nnz, ncols,
+                         nrows, labels, rowids, n_sampled_rows, unique_labels,
+                         tree, tree_params);
+}
+/** @} */
+
 /**
  * @defgroup Decision Tree Classifier - Predict function
  * @brief Predict target feature for input data; n-ary classification for
@@ -15,15 +15,18 @@
  */
 
 #include <utils.h>
+#include <algorithm>
 #include <queue>
 #include <random>
 #include <type_traits>
 #include "decisiontree_impl.h"
 #include "levelalgo/levelfunc_classifier.cuh"
+#include "levelalgo/levelfunc_gbdt.cuh"
 #include "levelalgo/levelfunc_regressor.cuh"
 #include "levelalgo/metric.cuh"
 #include "memory.cuh"
 #include "quantile/quantile.cuh"
+#include "sparse/coo.h"
 
 namespace ML {
 
@@ -89,7 +92,7 @@ struct Node_ID_info {
 
 template <class T, class L>
 void build_treelite_tree(TreeBuilderHandle tree_builder,
-                         DecisionTree::TreeMetaDataNode<T, L> *tree_ptr,
+                         const DecisionTree::TreeMetaDataNode<T, L> *tree_ptr,
                          int num_output_group) {
   int node_id = 0;
   TREELITE_CHECK(TreeliteTreeBuilderCreateNode(tree_builder, node_id));
@@ -209,6 +212,7 @@ void DecisionTreeBase<T, L>::print(
  * @param[in] cfg_bootstrap_features: If features need to be bootstarpped.
  * @param[in] cfg_split_criterion: Split criteria to be used. GINI, ENTROPY, MSE, MAE
  * @param[in] quantile_per_tree: If per tree quantile needs to be built.
+ * @param[in] grow: If false, the tree is only prepared for growing; used by DecisionTreeClassifier::fit_batched.
  */
 template <typename T, typename L>
 void DecisionTreeBase<T, L>::plant(
@@ -217,7 +221,7 @@ void DecisionTreeBase<T, L>::plant(
   const int n_sampled_rows, int unique_labels, const int treeid, int maxdepth,
   int max_leaf_nodes, const float colper, int n_bins, int split_algo_flag,
   int cfg_min_rows_per_node, bool cfg_bootstrap_features,
-  CRITERION cfg_split_criterion, bool quantile_per_tree) {
+  CRITERION cfg_split_criterion, bool quantile_per_tree, bool grow) {
   split_algo = split_algo_flag;
   dinfo.NLocalrows = nrows;
   dinfo.NGlobalrows = nrows;
@@ -250,6 +254,7 @@ void DecisionTreeBase<T, L>::plant(
   prepare_time = prepare_fit_timer.getElapsedSeconds();
 
   total_temp_mem = tempmem->totalmem;
+  if (!grow) return;
   MLCommon::TimerCPU timer;
   grow_deep_tree(data, labels, rowids, n_sampled_rows, ncols, colper,
                  dinfo.NLocalrows, sparsetree, treeid, tempmem);
@@ -329,7 +334,7 @@ void DecisionTreeBase<T, L>::base_fit(
   const L *labels, unsigned int *rowids, const int n_sampled_rows,
   int unique_labels, std::vector<SparseTreeNode<T, L>> &sparsetree,
   const int treeid, DecisionTreeParams &tree_params, bool is_classifier,
-  std::shared_ptr<TemporaryMemory<T, L>> in_tempmem) {
+  std::shared_ptr<TemporaryMemory<T, L>> in_tempmem, bool grow) {
   prepare_fit_timer.reset();
   const char *CRITERION_NAME[] = {"GINI", "ENTROPY", "MSE", "MAE", "END"};
   CRITERION default_criterion =
@@ -358,6 +363,8 @@ void DecisionTreeBase<T, L>::base_fit(
   if (in_tempmem != nullptr) {
     tempmem = in_tempmem;
   } else {
+    ASSERT(tree_params.stream_cols == 0,
+           "stream_cols is only supported by the random forest");
     tempmem = std::make_shared<TemporaryMemory<T, L>>(
       device_allocator_in, host_allocator_in, stream_in, nrows, ncols,
       tree_params.max_features, unique_labels, tree_params.n_bins,
@@ -370,7 +377,7 @@ void DecisionTreeBase<T, L>::base_fit(
         unique_labels, treeid, tree_params.max_depth, tree_params.max_leaves,
         tree_params.max_features, tree_params.n_bins, tree_params.split_algo,
         tree_params.min_rows_per_node, tree_params.bootstrap_features,
-        tree_params.split_criterion, tree_params.quantile_per_tree);
+        tree_params.split_criterion, tree_params.quantile_per_tree, grow);
   if (in_tempmem == nullptr) {
     tempmem.reset();
   }
@@ -407,6 +414,127 @@ void DecisionTreeClassifier<T>::fit(
   this->set_metadata(tree);
 }
 
+template <typename T>
+void DecisionTreeClassifier<T>::fit_csc(
+  const ML::cumlHandle &handle, const int *csc_ind, const int *csc_rows,
+  const T *csc_vals, const int nnz, const int ncols, const int nrows,
+  const int *labels, unsigned int *rowids, const int n_sampled_rows,
+  const int unique_labels, TreeMetaDataNode<T, int> *&tree,
+  DecisionTreeParams tree_params) {
+  ASSERT(tree_params.split_algo == SPLIT_ALGO::GLOBAL_QUANTILE,
+         "CSC data requires the GLOBAL_QUANTILE split algorithm");
+  ASSERT(!tree_params.shuffle_features,
+         "CSC data does not support feature shuffling");
+  const cumlHandle_impl &impl = handle.getImpl();
+  // base_fit resets n_bins in the same way, once tempmem is made
+  tree_params.n_bins = std::min(tree_params.n_bins, n_sampled_rows);
+  std::shared_ptr<TemporaryMemory<T, int>> csc_tempmem =
+    std::make_shared<TemporaryMemory<T, int>>(
+      impl, impl.getStream(), nrows, ncols, tree_params.max_features,
+      unique_labels, tree_params.n_bins, tree_params.split_algo,
+      tree_params.max_depth, tree_params.shuffle_features);
+  csc_tempmem->d_csc_ind = csc_ind;
+  csc_tempmem->d_csc_rows = csc_rows;
+  csc_tempmem->d_csc_vals = csc_vals;
+  csc_tempmem->csc_nnz = nnz;
+  preprocess_quantile_csc(csc_ind, csc_vals, nnz, nrows, ncols,
+                          tree_params.n_bins, csc_tempmem);
+  tree_params.quantile_per_tree = false;
+  this->base_fit(impl.getDeviceAllocator(), impl.getHostAllocator(),
+                 impl.getStream(), nullptr, ncols, nrows, labels, rowids,
+                 n_sampled_rows, unique_labels, tree->sparsetree, tree->treeid,
+                 tree_params, true, csc_tempmem);
+  this->set_metadata(tree);
+  this->tempmem.reset();
+}
+
+template <typename T>
+void DecisionTreeClassifier<T>::fit_csr(
+  const ML::cumlHandle &handle, const int *csr_ind, const int *csr_cols,
+  const T *csr_vals, const int nnz, const int ncols, const int nrows,
+  const int *labels, unsigned int *rowids, const int n_sampled_rows,
+  const int unique_labels, TreeMetaDataNode<T, int> *&tree,
+  DecisionTreeParams tree_params) {
+  const cumlHandle_impl &impl = handle.getImpl();
+  cudaStream_t stream = impl.getStream();
+  std::shared_ptr<MLCommon::deviceAllocator> d_alloc =
+    impl.getDeviceAllocator();
+  MLCommon::device_buffer<int> coo_rows(d_alloc, stream, nnz);
+  MLCommon::device_buffer<int> csc_cols(d_alloc, stream, nnz);
+  MLCommon::device_buffer<int> csc_rows(d_alloc, stream, nnz);
+  MLCommon::device_buffer<T> csc_vals(d_alloc, stream, nnz);
+  MLCommon::device_buffer<int> csc_ind(d_alloc, stream, ncols);
+  MLCommon::Sparse::csr_to_coo<32>(csr_ind, nrows, coo_rows.data(), nnz,
+                                   stream);
+
+  // A stable sort on the columns keeps the rows of a column sorted
+  size_t temp_storage_bytes = 0;
+  CUDA_CHECK(cub::DeviceRadixSort::SortPairs(
+    nullptr, temp_storage_bytes, csr_cols, csc_cols.data(), csr_vals,
+    csc_vals.data(), nnz, 0, MLCommon::log2(ncols) + 1, stream));
+  MLCommon::device_buffer<char> temp_storage(d_alloc, stream,
+                                             temp_storage_bytes);
+  CUDA_CHECK(cub::DeviceRadixSort::SortPairs(
+    (void *)temp_storage.data(), temp_storage_bytes, csr_cols, csc_cols.data(),
+    csr_vals, csc_vals.data(), nnz, 0, MLCommon::log2(ncols) + 1, stream));
+  CUDA_CHECK(cub::DeviceRadixSort::SortPairs(
+    (void *)temp_storage.data(), temp_storage_bytes, csr_cols, csc_cols.data(),
+    coo_rows.data(), csc_rows.data(), nnz, 0, MLCommon::log2(ncols) + 1,
+    stream));
+  MLCommon::Sparse::sorted_coo_to_csr(csc_cols.data(), nnz, csc_ind.data(),
+                                      ncols, d_alloc, stream);
+
+  fit_csc(handle, csc_ind.data(), csc_rows.data(), csc_vals.data(), nnz, ncols,
+          nrows, labels, rowids, n_sampled_rows, unique_labels, tree,
+          tree_params);
+  coo_rows.release(stream);
+  csc_cols.release(stream);
+  csc_rows.release(stream);
+  csc_vals.release(stream);
+  csc_ind.release(stream);
+  temp_storage.release(stream);
+}
+
+template <typename T>
+void DecisionTreeClassifier<T>::fit_batched(
+  const std::shared_ptr<MLCommon::deviceAllocator> device_allocator_in,
+  const std::shared_ptr<MLCommon::hostAllocator> host_allocator_in,
+  const cudaStream_t stream_in, const T *data, const int ncols, const int nrows,
+  const int *labels, unsigned int *const *rowids, const int n_sampled_rows,
+  const int unique_labels, DecisionTreeClassifier<T> *dts,
+  TreeMetaDataNode<T, int> **trees, const int n_trees,
+  DecisionTreeParams tree_params,
+  std::shared_ptr<TemporaryMemory<T, int>> *tempmems) {
+  std::vector<std::vector<SparseTreeNode<T, int>> *> sparsetrees(n_trees);
+  std::vector<int> treeids(n_trees);
+  for (int i = 0; i < n_trees; i++) {
+    dts[i].base_fit(device_allocator_in, host_allocator_in, stream_in, data,
+                    ncols, nrows, labels, rowids[i], n_sampled_rows,
+                    unique_labels, trees[i]->sparsetree, trees[i]->treeid,
+                    tree_params, true, tempmems[i], false);
+    sparsetrees[i] = &trees[i]->sparsetree;
+    treeids[i] = trees[i]->treeid;
+  }
+  const DecisionTreeClassifier<T> &dt = dts[0];
+  std::vector<std::shared_ptr<TemporaryMemory<T, int>>> tempmem_vec(
+    tempmems, tempmems + n_trees);
+  std::vector<int> depth_cnt, leaf_cnt;
+  MLCommon::TimerCPU timer;
+  grow_batched_trees_classification(
+    data, labels, rowids, ncols, tree_params.max_features, n_sampled_rows,
+    dt.dinfo.NLocalrows, dt.n_unique_labels, dt.nbins, dt.treedepth,
+    dt.maxleaves, dt.min_rows_per_node, dt.split_criterion, dt.split_algo,
+    dt.min_impurity_decrease, depth_cnt, leaf_cnt, sparsetrees, treeids.data(),
+    tempmem_vec);
+  double train_time = timer.getElapsedSeconds();
+  for (int i = 0; i < n_trees; i++) {
+    dts[i].depth_counter = depth_cnt[i];
+    dts[i].leaf_counter = leaf_cnt[i];
+    dts[i].train_time = train_time;
+    dts[i].set_metadata(trees[i]);
+  }
+}
+
 template <typename T>
 void DecisionTreeRegressor<T>::fit(
   const ML::cumlHandle &handle, const T *data, const int ncols, const int nrows,
@@ -470,6 +598,31 @@ void DecisionTreeRegressor<T>::grow_deep_tree(
   this->leaf_counter = leaf_cnt;
 }
 
+template <class T>
+void grow_gbdt_tree(const T *data, const T *grad, const T *hess,
+                    unsigned int *rowids, const int n_sampled_rows,
+                    const int ncols, const int nrows,
+                    const DecisionTreeParams &tree_params, const float lambda,
+                    const float min_child_weight, const float learning_rate,
+                    TreeMetaDataNode<T, T> *tree,
+                    std::shared_ptr<TemporaryMemory<T, T>> tempmem) {
+  MLCommon::TimerCPU timer;
+  int depth_cnt = 0;
+  int leaf_cnt = 0;
+  int nbins = std::min(tree_params.n_bins, n_sampled_rows);
+  grow_deep_tree_gbdt(
+    data, grad, hess, rowids, ncols, tree_params.max_features, n_sampled_rows,
+    nrows, nbins, tree_params.max_depth, tree_params.max_leaves,
+    tree_params.min_rows_per_node, tree_params.split_algo,
+    tree_params.min_impurity_decrease, lambda, min_child_weight,
+    learning_rate, depth_cnt, leaf_cnt, tree->sparsetree, tree->treeid,
+    tempmem);
+  tree->depth_counter = depth_cnt;
+  tree->leaf_counter = leaf_cnt;
+  tree->prepare_time = 0;
+  tree->train_time = timer.getElapsedSeconds();
+}
+
 //Class specializations
 template class DecisionTreeBase<float, int>;
 template class DecisionTreeBase<float, float>;
@@ -484,17 +637,62 @@ template class DecisionTreeRegressor<double>;
 
 template void build_treelite_tree<float, int>(
   TreeBuilderHandle tree_builder,
-  DecisionTree::TreeMetaDataNode<float, int> *tree_ptr, int num_output_group);
+  const DecisionTree::TreeMetaDataNode<float, int> *tree_ptr,
+  int num_output_group);
 template void build_treelite_tree<double, int>(
   TreeBuilderHandle tree_builder,
-  DecisionTree::TreeMetaDataNode<double, int> *tree_ptr, int num_output_group);
+  const DecisionTree::TreeMetaDataNode<double, int> *tree_ptr,
+  int num_output_group);
 template void build_treelite_tree<float, float>(
   TreeBuilderHandle tree_builder,
-  DecisionTree::TreeMetaDataNode<float, float> *tree_ptr, int num_output_group);
+  const DecisionTree::TreeMetaDataNode<float, float> *tree_ptr,
+  int num_output_group);
 template void build_treelite_tree<double, double>(
   TreeBuilderHandle tree_builder,
-  DecisionTree::TreeMetaDataNode<double, double> *tree_ptr,
+  const DecisionTree::TreeMetaDataNode<double, double> *tree_ptr,
   int num_output_group);
+
+template void grow_gbdt_tree<float>(
+  const float *data, const float *grad, const float *hess,
+  unsigned int *rowids, const int n_sampled_rows, const int ncols,
+  const int nrows, const DecisionTreeParams &tree_params, const float lambda,
+  const float min_child_weight, const float learning_rate,
+  TreeMetaDataNode<float, float> *tree,
+  std::shared_ptr<TemporaryMemory<float, float>> tempmem);
+template void grow_gbdt_tree<double>(
+  const double *data, const double *grad, const double *hess,
+  unsigned int *rowids, const int n_sampled_rows, const int ncols,
+  const int nrows, const DecisionTreeParams &tree_params, const float lambda,
+  const float min_child_weight, const float learning_rate,
+  TreeMetaDataNode<double, double> *tree,
+  std::shared_ptr<TemporaryMemory<double, double>> tempmem);
 }  //End namespace DecisionTree
 
 }  //End namespace ML
+
+// Used by the random forest only
+template void quantize_data<float, int>(
+  const float *data, const int nrows, const int ncols, const int nbins,
+  std::shared_ptr<TemporaryMemory<float, int>> *tempmems, const int n_tempmems,
+  MLCommon::device_buffer<char> &bins);
+template void quantize_data<double, int>(
+  const double *data, const int nrows, const int ncols, const int nbins,
+  std::shared_ptr<TemporaryMemory<double, int>> *tempmems, const int n_tempmems,
+  MLCommon::device_buffer<char> &bins);
+template void quantize_data<float, float>(
+  const float *data, const int nrows, const int ncols, const int nbins,
+  std::shared_ptr<TemporaryMemory<float, float>> *tempmems,
+  const int n_tempmems, MLCommon::device_buffer<char> &bins);
+template void quantize_data<double, double>(
+  const double *data, const int nrows, const int ncols, const int nbins,
+  std::shared_ptr<TemporaryMemory<double, double>> *tempmems,
+  const int n_tempmems, MLCommon::device_buffer<char> &bins);
+template void quantize_data_host<float, int>(
+  const float *h_data, const int nrows, const int ncols, const int nbins,
+  const int stream_cols, std::shared_ptr<TemporaryMemory<float, int>> *tempmems,
+  const int n_tempmems, MLCommon::host_buffer<char> &h_bins);
+template void quantize_data_host<double, int>(
+  const double *h_data, const int nrows, const int ncols, const int nbins,
+  const int stream_cols,
+  std::shared_ptr<TemporaryMemory<double, int>> *tempmems,
+  const int n_tempmems, MLCommon::host_buffer<char> &h_bins);
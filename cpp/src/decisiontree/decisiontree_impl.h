@@ -52,9 +52,31 @@ void print_node(const std::string &prefix,
 
 template <class T, class L>
 void build_treelite_tree(TreeBuilderHandle tree_builder,
-                         DecisionTree::TreeMetaDataNode<T, L> *tree_ptr,
+                         const DecisionTree::TreeMetaDataNode<T, L> *tree_ptr,
                          int num_output_group);
 
+/**
+ * @brief Grow a tree of a gradient boosted model on the gradients grad and
+ *        hessians hess of the loss at the rows of data (see
+ *        grow_deep_tree_gbdt). The leaf values include the shrinkage.
+ * @param[in] tree_params: parameters of the tree; split_criterion is ignored
+ *            and min_impurity_decrease is the minimum gain of a split.
+ * @param[in] lambda: L2 regularization of the leaf values.
+ * @param[in] min_child_weight: minimum hessian sum of each side of a split.
+ * @param[in] learning_rate: shrinkage of the leaf values.
+ * @param[in,out] tree: tree; its treeid seeds the feature sampling.
+ * @param[in] tempmem: temporary memory of a regression tree (see
+ *            get_gh_histograms), with the quantiles of data if needed.
+ */
+template <class T>
+void grow_gbdt_tree(const T *data, const T *grad, const T *hess,
+                    unsigned int *rowids, const int n_sampled_rows,
+                    const int ncols, const int nrows,
+                    const DecisionTreeParams &tree_params, const float lambda,
+                    const float min_child_weight, const float learning_rate,
+                    TreeMetaDataNode<T, T> *tree,
+                    std::shared_ptr<TemporaryMemory<T, T>> tempmem);
+
 struct DataInfo {
   unsigned int NLocalrows;
   unsigned int NGlobalrows;
@@ -91,7 +113,8 @@ class DecisionTreeBase {
              const int treeid, int maxdepth, int max_leaf_nodes,
              const float colper, int n_bins, int split_algo_flag,
              int cfg_min_rows_per_node, bool cfg_bootstrap_features,
-             CRITERION cfg_split_criterion, bool cfg_quantile_per_tree);
+             CRITERION cfg_split_criterion, bool cfg_quantile_per_tree,
+             bool grow = true);
 
   virtual void grow_deep_tree(
     const T *data, const L *labels, unsigned int *rowids,
@@ -107,7 +130,7 @@ class DecisionTreeBase {
     const int n_sampled_rows, int unique_labels,
     std::vector<SparseTreeNode<T, L>> &sparsetree, const int treeid,
     DecisionTreeParams &tree_params, bool is_classifier,
-    std::shared_ptr<TemporaryMemory<T, L>> in_tempmem);
+    std::shared_ptr<TemporaryMemory<T, L>> in_tempmem, bool grow = true);
 
  public:
   // Printing utility for high level tree info.
@@ -152,6 +175,39 @@ class DecisionTreeClassifier : public DecisionTreeBase<T, int> {
            TreeMetaDataNode<T, int> *&tree, DecisionTreeParams tree_params,
            std::shared_ptr<TemporaryMemory<T, int>> in_tempmem);
 
+  // Same as fit, for nrows x ncols CSC data: the nonzeros of column i are
+  // at csc_ind[i] in csc_rows (row indices, sorted within each column) and
+  // csc_vals; the other values are zero. Histograms are built from the
+  // nonzeros. Requires GLOBAL_QUANTILE and no feature shuffling.
+  void fit_csc(const ML::cumlHandle &handle, const int *csc_ind,
+               const int *csc_rows, const T *csc_vals, const int nnz,
+               const int ncols, const int nrows, const int *labels,
+               unsigned int *rowids, const int n_sampled_rows,
+               const int unique_labels, TreeMetaDataNode<T, int> *&tree,
+               DecisionTreeParams tree_params);
+
+  // Same as fit_csc, for CSR data: the nonzeros of row i are at csr_ind[i]
+  // in csr_cols (column indices) and csr_vals.
+  void fit_csr(const ML::cumlHandle &handle, const int *csr_ind,
+               const int *csr_cols, const T *csr_vals, const int nnz,
+               const int ncols, const int nrows, const int *labels,
+               unsigned int *rowids, const int n_sampled_rows,
+               const int unique_labels, TreeMetaDataNode<T, int> *&tree,
+               DecisionTreeParams tree_params);
+
+  // Fits n_trees trees in lock-step, with one histogram kernel launch per
+  // level for all of them. Used by RF: dts[i] fits trees[i] on rowids[i]
+  // with tempmems[i]; all the tempmems must share stream_in.
+  static void fit_batched(
+    const std::shared_ptr<MLCommon::deviceAllocator> device_allocator_in,
+    const std::shared_ptr<MLCommon::hostAllocator> host_allocator_in,
+    const cudaStream_t stream_in, const T *data, const int ncols,
+    const int nrows, const int *labels, unsigned int *const *rowids,
+    const int n_sampled_rows, const int unique_labels,
+    DecisionTreeClassifier<T> *dts, TreeMetaDataNode<T, int> **trees,
+    const int n_trees, DecisionTreeParams tree_params,
+    std::shared_ptr<TemporaryMemory<T, int>> *tempmems);
+
  private:
   void grow_deep_tree(const T *data, const int *labels, unsigned int *rowids,
                       const int n_sampled_rows, const int ncols,
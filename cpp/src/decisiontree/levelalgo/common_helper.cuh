@@ -110,6 +110,46 @@ void setup_sampling(unsigned int *flagsptr, unsigned int *sample_cnt,
   CUDA_CHECK(cudaGetLastError());
 }
 
+/*Calls f(block, col_begin, ncols_block) on the device copy of the host
+ *bins (see TemporaryMemory::h_bins8) of each block of stream_cols columns,
+ *in order; f enqueues its work on tempmem->stream. The copy of the next
+ *block, on copy_stream, overlaps the work on the current one.
+ */
+template <typename T, typename L, typename F>
+void for_each_column_block(const int nrows, const int Ncols,
+                           std::shared_ptr<TemporaryMemory<T, L>> tempmem,
+                           F f) {
+  int bin_bytes = (tempmem->h_bins8 != nullptr) ? sizeof(unsigned char)
+                                                 : sizeof(unsigned short);
+  const char *h_bins = (tempmem->h_bins8 != nullptr)
+                         ? (const char *)tempmem->h_bins8
+                         : (const char *)tempmem->h_bins16;
+  int block_cols = tempmem->stream_cols;
+  int n_blocks = MLCommon::ceildiv(Ncols, block_cols);
+  auto copy_block = [&](int b) {
+    int slot = b % 2;
+    int c0 = b * block_cols;
+    size_t bytes = (size_t)min(block_cols, Ncols - c0) * nrows * bin_bytes;
+    CUDA_CHECK(
+      cudaStreamWaitEvent(tempmem->copy_stream, tempmem->stage_free[slot], 0));
+    CUDA_CHECK(cudaMemcpyAsync(tempmem->d_stage[slot]->data(),
+                               h_bins + (size_t)c0 * nrows * bin_bytes, bytes,
+                               cudaMemcpyHostToDevice, tempmem->copy_stream));
+    CUDA_CHECK(
+      cudaEventRecord(tempmem->stage_copied[slot], tempmem->copy_stream));
+  };
+  copy_block(0);
+  for (int b = 0; b < n_blocks; b++) {
+    int slot = b % 2;
+    int c0 = b * block_cols;
+    if (b + 1 < n_blocks) copy_block(b + 1);
+    CUDA_CHECK(
+      cudaStreamWaitEvent(tempmem->stream, tempmem->stage_copied[slot], 0));
+    f(tempmem->d_stage[slot]->data(), c0, min(block_cols, Ncols - c0));
+    CUDA_CHECK(cudaEventRecord(tempmem->stage_free[slot], tempmem->stream));
+  }
+}
+
 //This function call the split kernel
 template <typename T, typename L>
 void make_level_split(const T *data, const int nrows, const int Ncols,
@@ -128,6 +168,44 @@ void make_level_split(const T *data, const int nrows, const int Ncols,
         data, tempmem->d_globalminmax->data(), tempmem->d_colids->data(),
         d_colstart, split_colidx, split_binidx, nrows, Ncols, ncols_sampled,
         nbins, n_nodes, new_node_flags, flags);
+  } else if (tempmem->d_csc_vals != nullptr) {
+    split_level_kernel_csc<T><<<blocks, threads, 0, tempmem->stream>>>(
+      tempmem->d_csc_ind, tempmem->d_csc_rows, tempmem->d_csc_vals,
+      tempmem->csc_nnz, tempmem->d_quantile->data(), tempmem->d_colids->data(),
+      d_colstart, split_colidx, split_binidx, nrows, Ncols, ncols_sampled,
+      nbins, n_nodes, new_node_flags, flags);
+  } else if (tempmem->stream_cols > 0) {
+    unsigned int *next_flags = tempmem->d_next_flags->data();
+    const unsigned int *colids = tempmem->d_colids->data();
+    CUDA_CHECK(cudaMemsetAsync(next_flags, 0xFF, nrows * sizeof(unsigned int),
+                               tempmem->stream));
+    bool bins8 = tempmem->h_bins8 != nullptr;
+    for_each_column_block(
+      nrows, Ncols, tempmem, [&](const char *block, int c0, int nc) {
+        if (bins8) {
+          split_level_kernel_block<<<blocks, threads, 0, tempmem->stream>>>(
+            (const unsigned char *)block, c0, nc, colids, split_colidx,
+            split_binidx, nrows, new_node_flags, flags, next_flags);
+        } else {
+          split_level_kernel_block<<<blocks, threads, 0, tempmem->stream>>>(
+            (const unsigned short *)block, c0, nc, colids, split_colidx,
+            split_binidx, nrows, new_node_flags, flags, next_flags);
+        }
+        CUDA_CHECK(cudaGetLastError());
+      });
+    MLCommon::copy(flags, next_flags, nrows, tempmem->stream);
+  } else if (tempmem->d_bins8 != nullptr) {
+    split_level_kernel<T, BinQues<T>>
+      <<<blocks, threads, 0, tempmem->stream>>>(
+        tempmem->d_bins8, tempmem->d_quantile->data(),
+        tempmem->d_colids->data(), d_colstart, split_colidx, split_binidx,
+        nrows, Ncols, ncols_sampled, nbins, n_nodes, new_node_flags, flags);
+  } else if (tempmem->d_bins16 != nullptr) {
+    split_level_kernel<T, BinQues<T>>
+      <<<blocks, threads, 0, tempmem->stream>>>(
+        tempmem->d_bins16, tempmem->d_quantile->data(),
+        tempmem->d_colids->data(), d_colstart, split_colidx, split_binidx,
+        nrows, Ncols, ncols_sampled, nbins, n_nodes, new_node_flags, flags);
   } else {
     split_level_kernel<T, QuantileQues<T>>
       <<<blocks, threads, 0, tempmem->stream>>>(
@@ -138,20 +216,6 @@ void make_level_split(const T *data, const int nrows, const int Ncols,
   CUDA_CHECK(cudaGetLastError());
 }
 
-/* node_hist[i] holds the # times label i appear in current data. The vector is computed during gini
-   computation. */
-int get_class_hist(unsigned int *node_hist, const int n_unique_labels) {
-  unsigned int maxval = node_hist[0];
-  int classval = 0;
-  for (int i = 1; i < n_unique_labels; i++) {
-    if (node_hist[i] > maxval) {
-      maxval = node_hist[i];
-      classval = i;
-    }
-  }
-  return classval;
-}
-
 template <typename T>
 T getQuesValue(const T *minmax, const T *quantile, const int nbins,
                const int colid, const int binid, const int nodeid,
@@ -158,9 +158,9 @@ __global__ void setup_flags_kernel(const unsigned int* __restrict__ sample_cnt,
 // This make actual split. A split is done using bits.
 //Least significant Bit 0 means left and 1 means right.
 //As a result a max depth of 32 is supported for now.
-template <typename T, typename QuestionType>
+template <typename T, typename QuestionType, typename D = T>
 __global__ void split_level_kernel(
-  const T* __restrict__ data, const T* __restrict__ question_ptr,
+  const D* __restrict__ data, const T* __restrict__ question_ptr,
   const unsigned int* __restrict__ colids,
   const unsigned int* __restrict__ colstart,
   const int* __restrict__ split_col_index,
@@ -184,10 +184,9 @@ __global__ void split_level_kernel(
                                   colidx, local_flag);
         QuestionType question(question_ptr, colid, colidx, n_nodes, local_flag,
                               nbins);
-        T quesval = question(split_bin_index[local_flag]);
-        T local_data = data[colid * nrows + tid];
+        D local_data = data[colid * nrows + tid];
         //The inverse comparision here to push right instead of left
-        if (local_data <= quesval) {
+        if (local_data <= question(split_bin_index[local_flag])) {
           local_flag = local_leaf_flag << 1;
         } else {
           local_flag = (local_leaf_flag << 1) | PUSHRIGHT;
@@ -200,6 +199,38 @@ __global__ void split_level_kernel(
   }
 }
 
+//Same as split_level_kernel with BinQues, for the bins of columns col_begin
+//to col_begin + ncols_block - 1 at data (see for_each_column_block): only the
+//rows whose split column is among them are split, into next_flags, so that
+//flags are the ones of the current level until all the blocks are done.
+template <typename D>
+__global__ void split_level_kernel_block(
+  const D* __restrict__ data, const int col_begin, const int ncols_block,
+  const unsigned int* __restrict__ colids,
+  const int* __restrict__ split_col_index,
+  const int* __restrict__ split_bin_index, const int nrows,
+  const unsigned int* __restrict__ new_node_flags,
+  const unsigned int* __restrict__ flags, unsigned int* next_flags) {
+  unsigned int threadid = threadIdx.x + blockIdx.x * blockDim.x;
+  for (int tid = threadid; tid < nrows; tid += gridDim.x * blockDim.x) {
+    unsigned int local_flag = flags[tid];
+    if (local_flag == LEAF) continue;
+    unsigned int local_leaf_flag = new_node_flags[local_flag];
+    if (local_leaf_flag == LEAF) {
+      next_flags[tid] = LEAF;
+      continue;
+    }
+    int colid = colids[split_col_index[local_flag]] - col_begin;
+    if (colid < 0 || colid >= ncols_block) continue;
+    D local_data = data[colid * nrows + tid];
+    if (local_data <= split_bin_index[local_flag]) {
+      next_flags[tid] = local_leaf_flag << 1;
+    } else {
+      next_flags[tid] = (local_leaf_flag << 1) | PUSHRIGHT;
+    }
+  }
+}
+
 struct GainIdxPair {
   float gain;
   int idx;
@@ -213,7 +244,10 @@ struct ReducePair {
   DI GainIdxPair operator()(const GainIdxPair& a, const GainIdxPair& b) {
     GainIdxPair retval;
     retval.gain = op(a.gain, b.gain);
-    if (retval.gain == a.gain) {
+    // Ties go to the first split, as in a sequential search
+    if (a.gain == b.gain) {
+      retval.idx = min(a.idx, b.idx);
+    } else if (retval.gain == a.gain) {
       retval.idx = a.idx;
     } else {
       retval.idx = b.idx;
@@ -246,3 +280,78 @@ struct MinMaxQues {
 
   DI T operator()(const int binid) { return (min + (binid + 1) * delta); }
 };
+
+//Question on pre-binned data (see quantize_data), where each value has been
+//replaced by the index of the first quantile of its column not below it.
+template <typename T>
+struct BinQues {
+  DI BinQues(const T* __restrict__ quantile_ptr, const unsigned int colid,
+             const unsigned int colcnt, const int n_nodes,
+             const unsigned int nodeid, const int nbins) {}
+
+  DI int operator()(const int binid) { return binid; }
+};
+
+//Value of row in column col of nrows x Ncols CSC data, whose row indices are
+//sorted within each column.
+template <typename T>
+DI T get_csc_value(const int* __restrict__ csc_ind,
+                   const int* __restrict__ csc_rows,
+                   const T* __restrict__ csc_vals, const int nnz,
+                   const int Ncols, const int row, const int col) {
+  int lo = csc_ind[col];
+  int stop = (col < Ncols - 1) ? csc_ind[col + 1] : nnz;
+  int hi = stop;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (csc_rows[mid] < row) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return (lo < stop && csc_rows[lo] == row) ? csc_vals[lo] : T(0);
+}
+
+//Same as split_level_kernel with QuantileQues, for CSC data.
+template <typename T>
+__global__ void split_level_kernel_csc(
+  const int* __restrict__ csc_ind, const int* __restrict__ csc_rows,
+  const T* __restrict__ csc_vals, const int nnz,
+  const T* __restrict__ question_ptr, const unsigned int* __restrict__ colids,
+  const unsigned int* __restrict__ colstart,
+  const int* __restrict__ split_col_index,
+  const int* __restrict__ split_bin_index, const int nrows, const int Ncols,
+  const int ncols_sampled, const int nbins, const int n_nodes,
+  const unsigned int* __restrict__ new_node_flags,
+  unsigned int* __restrict__ flags) {
+  unsigned int threadid = threadIdx.x + blockIdx.x * blockDim.x;
+  unsigned int local_flag = LEAF;
+
+  for (int tid = threadid; tid < nrows; tid += gridDim.x * blockDim.x) {
+    local_flag = flags[tid];
+
+    if (local_flag != LEAF) {
+      unsigned int local_leaf_flag = new_node_flags[local_flag];
+      if (local_leaf_flag != LEAF) {
+        int colidx = split_col_index[local_flag];
+        int local_colstart = -1;
+        if (colstart != nullptr) local_colstart = colstart[local_flag];
+        int colid = get_column_id(colids, local_colstart, Ncols, ncols_sampled,
+                                  colidx, local_flag);
+        QuantileQues<T> question(question_ptr, colid, colidx, n_nodes,
+                                 local_flag, nbins);
+        T local_data =
+          get_csc_value(csc_ind, csc_rows, csc_vals, nnz, Ncols, tid, colid);
+        if (local_data <= question(split_bin_index[local_flag])) {
+          local_flag = local_leaf_flag << 1;
+        } else {
+          local_flag = (local_leaf_flag << 1) | PUSHRIGHT;
+        }
+      } else {
+        local_flag = LEAF;
+      }
+      flags[tid] = local_flag;
+    }
+  }
+}
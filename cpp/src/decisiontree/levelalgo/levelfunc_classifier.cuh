@@ -14,149 +14,367 @@
  * limitations under the License.
  */
 #pragma once
+#include <algorithm>
 #include <cuml/tree/flatnode.h>
 #include <cuml/tree/decisiontree.hpp>
 #include <iostream>
-#include <numeric>
+#include <memory>
+#include "common/nvtx.hpp"
 #include "common_helper.cuh"
 #include "levelhelper_classifier.cuh"
 #include "metric.cuh"
 
 /*
-This is the driver function for building classification tree
-level by level using a simple for loop.
+This is the state of a classification tree built level by level.
 At each level; following steps are involved.
 1. Compute histograms for all nodes, all cols and all bins.
 2. Find best split col and bin for each node.
 3. Check info gain and then leaf out nodes as needed.
 4. make split.
+begin_level() does the feature sampling of a level and end_level() the
+steps 2 to 4, so that step 1 can be done for one tree
+(grow_deep_tree_classification) or for several trees at once
+(grow_batched_trees_classification).
+When the temporary memory keeps the histogram of the previous level, the
+histogram of the larger of two siblings is not computed in step 1 but is
+the histogram of their parent minus the one of the smaller sibling.
+The tree under construction and the histograms and metrics of the nodes of
+a level stay in device memory: the only copy to the host of a level is the
+number of nodes of the next level, and the tree is copied once by finish().
 */
 template <typename T>
-void grow_deep_tree_classification(
-  const T* data, const int* labels, unsigned int* rowids, const int Ncols,
-  const float colper, int n_sampled_rows, const int nrows,
-  const int n_unique_labels, const int nbins, const int maxdepth,
-  const int maxleaves, const int min_rows_per_node,
-  const ML::CRITERION split_cr, const int split_algo,
-  const float min_impurity_decrease, int& depth_cnt, int& leaf_cnt,
-  std::vector<SparseTreeNode<T, int>>& sparsetree, const int treeid,
-  std::shared_ptr<TemporaryMemory<T, int>> tempmem) {
-  const int ncols_sampled = (int)(colper * Ncols);
-  unsigned int* flagsptr = tempmem->d_flags->data();
-  unsigned int* sample_cnt = tempmem->d_sample_cnt->data();
-  setup_sampling(flagsptr, sample_cnt, rowids, nrows, n_sampled_rows,
-                 tempmem->stream);
-  std::vector<unsigned int> histvec(n_unique_labels, 0);
-  T initial_metric;
-  if (split_cr == ML::CRITERION::GINI) {
-    initial_metric_classification<T, GiniFunctor>(labels, sample_cnt, nrows,
-                                                  n_unique_labels, histvec,
-                                                  initial_metric, tempmem);
-  } else {
-    initial_metric_classification<T, EntropyFunctor>(labels, sample_cnt, nrows,
-                                                     n_unique_labels, histvec,
-                                                     initial_metric, tempmem);
-  }
-  size_t total_nodes = pow(2, (maxdepth + 1)) - 1;
+struct ClassificationTreeBuilder {
+  const T* data;
+  const int* labels;
+  int Ncols;
+  int ncols_sampled;
+  int nrows;
+  int n_unique_labels;
+  int nbins;
+  int maxdepth;
+  int maxleaves;
+  int min_rows_per_node;
+  ML::CRITERION split_cr;
+  int split_algo;
+  float min_impurity_decrease;
+  std::vector<SparseTreeNode<T, int>>* sparsetree;
+  std::shared_ptr<TemporaryMemory<T, int>> tempmem;
+  MLCommon::device_buffer<SparseTreeNode<T, int>> d_sparsetree;
+  int sparsetree_size;
 
-  unsigned int* h_parent_hist = tempmem->h_parent_hist->data();
-  unsigned int* h_child_hist = tempmem->h_child_hist->data();
-  memcpy(h_parent_hist, histvec.data(), n_unique_labels * sizeof(int));
+  int depth_cnt;
+  int leaf_cnt;
+  int n_nodes;
+  int n_nodes_nextitr;
+  int sparsesize;
+  int sparsesize_nextitr;
+  std::vector<unsigned int> feature_selector;
+  //Histogram subtraction (see set_hist_parent)
+  bool subtract_hist;
+  int n_prev_nodes;
+  const int* hist_parent;
 
-  sparsetree.reserve(total_nodes);
-  SparseTreeNode<T, int> sparsenode;
-  sparsenode.best_metric_val = initial_metric;
-  sparsetree.push_back(sparsenode);
-  int sparsesize = 0;
-  int sparsesize_nextitr = 0;
+  //RNG setup
+  std::mt19937 mtg;
+  MLCommon::Random::Rng d_rng;
+  std::uniform_int_distribution<unsigned int> dist;
 
-  int n_nodes = 1;
-  int n_nodes_nextitr = 1;
-  std::vector<int> sparse_nodelist;
-  sparse_nodelist.reserve(pow(2, maxdepth));
-  sparse_nodelist.push_back(0);
+  ClassificationTreeBuilder(
+    const T* data_, const int* labels_, unsigned int* rowids,
+    const int Ncols_, const float colper, int n_sampled_rows,
+    const int nrows_, const int n_unique_labels_, const int nbins_,
+    const int maxdepth_, const int maxleaves_, const int min_rows_per_node_,
+    const ML::CRITERION split_cr_, const int split_algo_,
+    const float min_impurity_decrease_,
+    std::vector<SparseTreeNode<T, int>>& sparsetree_, const int treeid,
+    std::shared_ptr<TemporaryMemory<T, int>> tempmem_)
+    : data(data_),
+      labels(labels_),
+      Ncols(Ncols_),
+      ncols_sampled((int)(colper * Ncols_)),
+      nrows(nrows_),
+      n_unique_labels(n_unique_labels_),
+      nbins(nbins_),
+      maxdepth(maxdepth_),
+      maxleaves(maxleaves_),
+      min_rows_per_node(min_rows_per_node_),
+      split_cr(split_cr_),
+      split_algo(split_algo_),
+      min_impurity_decrease(min_impurity_decrease_),
+      sparsetree(&sparsetree_),
+      tempmem(tempmem_),
+      d_sparsetree(tempmem_->device_allocator, tempmem_->stream, 1),
+      sparsetree_size(1),
+      depth_cnt(0),
+      leaf_cnt(0),
+      n_nodes(1),
+      n_nodes_nextitr(1),
+      sparsesize(0),
+      sparsesize_nextitr(0),
+      subtract_hist(tempmem_->d_prev_histogram != nullptr),
+      n_prev_nodes(0),
+      hist_parent(nullptr),
+      mtg(treeid * 1000),
+      d_rng(treeid * 1000),
+      dist(0, Ncols_ - 1) {
+    unsigned int* flagsptr = tempmem->d_flags->data();
+    unsigned int* sample_cnt = tempmem->d_sample_cnt->data();
+    setup_sampling(flagsptr, sample_cnt, rowids, nrows, n_sampled_rows,
+                   tempmem->stream);
+    std::vector<unsigned int> histvec(n_unique_labels, 0);
+    T initial_metric;
+    if (split_cr == ML::CRITERION::GINI) {
+      initial_metric_classification<T, GiniFunctor>(
+        labels, sample_cnt, nrows, n_unique_labels, histvec, initial_metric,
+        tempmem);
+    } else {
+      initial_metric_classification<T, EntropyFunctor>(
+        labels, sample_cnt, nrows, n_unique_labels, histvec, initial_metric,
+        tempmem);
+    }
+    // The root is the only node of the first level
+    MLCommon::copy(tempmem->d_level_hist->data(),
+                   tempmem->d_parent_hist->data(), n_unique_labels,
+                   tempmem->stream);
+    MLCommon::updateDevice(tempmem->d_level_metric->data(), &initial_metric,
+                           1, tempmem->stream);
+    CUDA_CHECK(cudaMemsetAsync(tempmem->d_nodelist->data(), 0, sizeof(int),
+                               tempmem->stream));
+    SparseTreeNode<T, int> sparsenode;
+    sparsenode.best_metric_val = initial_metric;
+    MLCommon::updateDevice(d_sparsetree.data(), &sparsenode, 1,
+                           tempmem->stream);
 
-  //RNG setup
-  std::mt19937 mtg(treeid * 1000);
-  MLCommon::Random::Rng d_rng(treeid * 1000);
-  std::uniform_int_distribution<unsigned int> dist(0, Ncols - 1);
-  //Setup pointers
-  unsigned int* d_histogram = tempmem->d_histogram->data();
-  unsigned int* h_histogram = tempmem->h_histogram->data();
-  int* h_split_binidx = tempmem->h_split_binidx->data();
-  int* d_split_binidx = tempmem->d_split_binidx->data();
-  int* h_split_colidx = tempmem->h_split_colidx->data();
-  int* d_split_colidx = tempmem->d_split_colidx->data();
-  unsigned int* h_new_node_flags = tempmem->h_new_node_flags->data();
-  unsigned int* d_new_node_flags = tempmem->d_new_node_flags->data();
-  unsigned int* d_colids = tempmem->d_colids->data();
-  unsigned int* h_colids = tempmem->h_colids->data();
-  unsigned int* d_colstart = nullptr;
-  unsigned int* h_colstart = nullptr;
-  if (tempmem->d_colstart != nullptr) {
-    d_colstart = tempmem->d_colstart->data();
-    h_colstart = tempmem->h_colstart->data();
-    CUDA_CHECK(cudaMemsetAsync(
-      d_colstart, 0, tempmem->max_nodes_per_level * sizeof(unsigned int),
-      tempmem->stream));
-    memset(h_colstart, 0, tempmem->max_nodes_per_level * sizeof(unsigned int));
-    MLCommon::updateDevice(d_colids, h_colids, Ncols, tempmem->stream);
+    unsigned int* h_colids = tempmem->h_colids->data();
+    if (tempmem->d_colstart != nullptr) {
+      CUDA_CHECK(cudaMemsetAsync(
+        tempmem->d_colstart->data(), 0,
+        tempmem->max_nodes_per_level * sizeof(unsigned int), tempmem->stream));
+      memset(tempmem->h_colstart->data(), 0,
+             tempmem->max_nodes_per_level * sizeof(unsigned int));
+      MLCommon::updateDevice(tempmem->d_colids->data(), h_colids, Ncols,
+                             tempmem->stream);
+    }
+    feature_selector.assign(h_colids, h_colids + Ncols);
+    // The host copies of the root must outlive the copies to the device
+    CUDA_CHECK(cudaStreamSynchronize(tempmem->stream));
+  }
+
+  // Whether the level at depth is to be built
+  bool active(int depth) const {
+    return (depth < maxdepth) && (n_nodes_nextitr != 0);
   }
-  std::vector<unsigned int> feature_selector(h_colids, h_colids + Ncols);
 
-  for (int depth = 0; (depth < maxdepth) && (n_nodes_nextitr != 0); depth++) {
+  void begin_level(int depth) {
     depth_cnt = depth + 1;
     n_nodes = n_nodes_nextitr;
     sparsesize = sparsesize_nextitr;
-    sparsesize_nextitr = sparsetree.size();
+    sparsesize_nextitr = sparsetree_size;
     ASSERT(
       n_nodes <= tempmem->max_nodes_per_level,
       "Max node limit reached. Requested nodes %d > %d max nodes at depth %d\n",
       n_nodes, tempmem->max_nodes_per_level, depth);
 
-    update_feature_sampling(h_colids, d_colids, h_colstart, d_colstart, Ncols,
-                            ncols_sampled, n_nodes, mtg, dist, feature_selector,
-                            tempmem, d_rng);
-    get_histogram_classification(data, labels, flagsptr, sample_cnt, nrows,
-                                 Ncols, ncols_sampled, n_unique_labels, nbins,
-                                 n_nodes, split_algo, tempmem, d_histogram);
+    unsigned int* d_colstart = nullptr;
+    unsigned int* h_colstart = nullptr;
+    if (tempmem->d_colstart != nullptr) {
+      d_colstart = tempmem->d_colstart->data();
+      h_colstart = tempmem->h_colstart->data();
+    }
+    update_feature_sampling(tempmem->h_colids->data(),
+                            tempmem->d_colids->data(), h_colstart, d_colstart,
+                            Ncols, ncols_sampled, n_nodes, mtg, dist,
+                            feature_selector, tempmem, d_rng);
+    hist_parent = nullptr;
+    if (subtract_hist && depth > 0) set_hist_parent();
+  }
+
+  // Picks, for each pair of siblings of the level, the one whose histogram
+  // is derived from the previous level: the one with more rows
+  void set_hist_parent() {
+    set_hist_parent_classification(n_nodes, n_unique_labels, tempmem);
+    hist_parent = tempmem->d_hist_parent->data();
+  }
+
+  // Computes the histograms of the level (step 1) for this tree alone
+  void get_histogram() {
+    get_histogram_classification(
+      data, labels, tempmem->d_flags->data(), tempmem->d_sample_cnt->data(),
+      nrows, Ncols, ncols_sampled, n_unique_labels, nbins, n_nodes, split_algo,
+      hist_parent, tempmem, tempmem->d_histogram->data());
+    subtract_histogram();
+  }
+
+  // Derives the histograms left out by get_histogram, if any
+  void subtract_histogram() {
+    if (hist_parent == nullptr) return;
+    subtract_histogram_classification(
+      tempmem->d_prev_histogram->data(), hist_parent, ncols_sampled,
+      n_unique_labels, nbins, n_nodes, n_prev_nodes,
+      tempmem->d_histogram->data(), tempmem->stream);
+  }
+
+  void end_level(int depth) {
+    cudaStream_t stream = tempmem->stream;
+    int new_size = sparsetree_size + 2 * n_nodes;
+    if ((size_t)new_size > d_sparsetree.size()) {
+      d_sparsetree.resize(std::max(new_size, 2 * (int)d_sparsetree.size()),
+                          stream);
+    }
 
-    float* infogain = tempmem->h_outgain->data();
+    unsigned int* d_histogram = tempmem->d_histogram->data();
     if (split_cr == ML::CRITERION::GINI) {
-      get_best_split_classification<T, GiniFunctor, GiniDevFunctor>(
-        h_histogram, d_histogram, h_colids, d_colids, h_colstart, d_colstart,
-        Ncols, ncols_sampled, nbins, n_unique_labels, n_nodes, depth,
-        min_rows_per_node, split_algo, infogain, h_parent_hist, h_child_hist,
-        sparsetree, sparsesize, sparse_nodelist, h_split_colidx, h_split_binidx,
-        d_split_colidx, d_split_binidx, tempmem);
+      get_best_split_classification<T, GiniDevFunctor>(
+        d_histogram, ncols_sampled, nbins, n_unique_labels, n_nodes,
+        min_rows_per_node, tempmem);
     } else {
-      get_best_split_classification<T, EntropyFunctor, EntropyDevFunctor>(
-        h_histogram, d_histogram, h_colids, d_colids, h_colstart, d_colstart,
-        Ncols, ncols_sampled, nbins, n_unique_labels, n_nodes, depth,
-        min_rows_per_node, split_algo, infogain, h_parent_hist, h_child_hist,
-        sparsetree, sparsesize, sparse_nodelist, h_split_colidx, h_split_binidx,
-        d_split_colidx, d_split_binidx, tempmem);
+      get_best_split_classification<T, EntropyDevFunctor>(
+        d_histogram, ncols_sampled, nbins, n_unique_labels, n_nodes,
+        min_rows_per_node, tempmem);
     }
 
-    CUDA_CHECK(cudaStreamSynchronize(tempmem->stream));
+    bool leaf_level = (depth == maxdepth);
+    if (maxleaves != -1) leaf_level = leaf_level || (leaf_cnt >= maxleaves);
+    make_level_nodes_classification(
+      Ncols, ncols_sampled, nbins, n_unique_labels, n_nodes,
+      min_impurity_decrease, leaf_level, sparsesize, sparsetree_size,
+      d_sparsetree.data(), tempmem);
+    make_level_split(data, nrows, Ncols, ncols_sampled, nbins, n_nodes,
+                     split_algo, tempmem->d_split_colidx->data(),
+                     tempmem->d_split_binidx->data(),
+                     tempmem->d_new_node_flags->data(),
+                     tempmem->d_flags->data(), tempmem);
 
-    leaf_eval_classification(infogain, depth, min_impurity_decrease, maxdepth,
-                             n_unique_labels, maxleaves, h_new_node_flags,
-                             sparsetree, sparsesize, h_parent_hist,
-                             n_nodes_nextitr, sparse_nodelist, leaf_cnt);
+    // The number of split nodes sizes the launches of the next level
+    int* h_n_split = tempmem->h_n_split->data();
+    MLCommon::updateHost(h_n_split, tempmem->d_n_split->data(), 1, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    leaf_cnt += n_nodes - *h_n_split;
+    n_nodes_nextitr = 2 * *h_n_split;
+    sparsetree_size = new_size;
 
-    MLCommon::updateDevice(d_new_node_flags, h_new_node_flags, n_nodes,
-                           tempmem->stream);
-    make_level_split(data, nrows, Ncols, ncols_sampled, nbins, n_nodes,
-                     split_algo, d_split_colidx, d_split_binidx,
-                     d_new_node_flags, flagsptr, tempmem);
+    std::swap(tempmem->d_level_hist, tempmem->d_next_level_hist);
+    std::swap(tempmem->d_level_metric, tempmem->d_next_level_metric);
+    std::swap(tempmem->d_nodelist, tempmem->d_next_nodelist);
+    if (subtract_hist) {
+      std::swap(tempmem->d_histogram, tempmem->d_prev_histogram);
+      n_prev_nodes = n_nodes;
+    }
+  }
 
-    memcpy(h_parent_hist, h_child_hist,
-           2 * n_nodes * n_unique_labels * sizeof(unsigned int));
+  // Sets the predictions of the nodes of the last level, then copies the
+  // tree to the host
+  void finish() {
+    cudaStream_t stream = tempmem->stream;
+    leaf_predictions_classification(
+      tempmem->d_child_hist->data(), sparsetree_size - sparsesize_nextitr,
+      n_unique_labels, d_sparsetree.data() + sparsesize_nextitr, stream);
+    sparsetree->resize(sparsetree_size);
+    MLCommon::updateHost(sparsetree->data(), d_sparsetree.data(),
+                         sparsetree_size, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    d_sparsetree.release(stream);
+  }
+};
+
+/*
+This is the driver function for building classification tree
+level by level using a simple for loop.
+*/
+template <typename T>
+void grow_deep_tree_classification(
+  const T* data, const int* labels, unsigned int* rowids, const int Ncols,
+  const float colper, int n_sampled_rows, const int nrows,
+  const int n_unique_labels, const int nbins, const int maxdepth,
+  const int maxleaves, const int min_rows_per_node,
+  const ML::CRITERION split_cr, const int split_algo,
+  const float min_impurity_decrease, int& depth_cnt, int& leaf_cnt,
+  std::vector<SparseTreeNode<T, int>>& sparsetree, const int treeid,
+  std::shared_ptr<TemporaryMemory<T, int>> tempmem) {
+  ClassificationTreeBuilder<T> tree(
+    data, labels, rowids, Ncols, colper, n_sampled_rows, nrows,
+    n_unique_labels, nbins, maxdepth, maxleaves, min_rows_per_node, split_cr,
+    split_algo, min_impurity_decrease, sparsetree, treeid, tempmem);
+  ML::nvtxRange range("Trace::DT::GrowClassificationTree", "rows=%d cols=%d",
+                      n_sampled_rows, Ncols);
+  for (int depth = 0; tree.active(depth); depth++) {
+    ML::nvtxRange level("Trace::DT::Level", depth);
+    tree.begin_level(depth);
+    tree.get_histogram();
+    tree.end_level(depth);
+  }
+  tree.finish();
+  depth_cnt = tree.depth_cnt;
+  leaf_cnt = tree.leaf_cnt;
+}
+
+/*
+This is the driver function for building several classification trees
+in lock-step, level by level: the histograms of a level are computed for
+all the trees still growing in one kernel launch. Tree i is built from
+rowids[i] into sparsetrees[i], using tempmems[i]; all the tempmems must
+share one stream. depth_cnt and leaf_cnt receive one value per tree.
+*/
+template <typename T>
+void grow_batched_trees_classification(
+  const T* data, const int* labels, unsigned int* const* rowids,
+  const int Ncols, const float colper, int n_sampled_rows, const int nrows,
+  const int n_unique_labels, const int nbins, const int maxdepth,
+  const int maxleaves, const int min_rows_per_node,
+  const ML::CRITERION split_cr, const int split_algo,
+  const float min_impurity_decrease, std::vector<int>& depth_cnt,
+  std::vector<int>& leaf_cnt,
+  const std::vector<std::vector<SparseTreeNode<T, int>>*>& sparsetrees,
+  const int* treeids,
+  const std::vector<std::shared_ptr<TemporaryMemory<T, int>>>& tempmems) {
+  int n_trees = sparsetrees.size();
+  std::vector<std::unique_ptr<ClassificationTreeBuilder<T>>> trees(n_trees);
+  for (int i = 0; i < n_trees; i++) {
+    trees[i].reset(new ClassificationTreeBuilder<T>(
+      data, labels, rowids[i], Ncols, colper, n_sampled_rows, nrows,
+      n_unique_labels, nbins, maxdepth, maxleaves, min_rows_per_node,
+      split_cr, split_algo, min_impurity_decrease, *sparsetrees[i],
+      treeids[i], tempmems[i]));
+  }
+  MLCommon::device_buffer<HistBatchArgs<T>> d_batch(
+    tempmems[0]->device_allocator, tempmems[0]->stream, n_trees);
+  std::vector<ClassificationTreeBuilder<T>*> level_trees;
+  std::vector<std::shared_ptr<TemporaryMemory<T, int>>> level_tempmems;
+  std::vector<int> level_nodes;
+  std::vector<const int*> level_hist_parents;
+  ML::nvtxRange range("Trace::DT::GrowBatchedClassificationTrees",
+                      "trees=%d rows=%d cols=%d", n_trees, n_sampled_rows,
+                      Ncols);
+  for (int depth = 0;; depth++) {
+    ML::nvtxRange level("Trace::DT::Level", depth);
+    level_trees.clear();
+    level_tempmems.clear();
+    level_nodes.clear();
+    level_hist_parents.clear();
+    for (int i = 0; i < n_trees; i++) {
+      if (!trees[i]->active(depth)) continue;
+      trees[i]->begin_level(depth);
+      level_trees.push_back(trees[i].get());
+      level_tempmems.push_back(tempmems[i]);
+      level_nodes.push_back(trees[i]->n_nodes);
+      level_hist_parents.push_back(trees[i]->hist_parent);
+    }
+    if (level_trees.empty()) break;
+    get_histogram_classification_batched(
+      data, labels, nrows, Ncols, trees[0]->ncols_sampled, n_unique_labels,
+      nbins, split_algo, level_tempmems, level_nodes, level_hist_parents,
+      d_batch);
+    for (ClassificationTreeBuilder<T>* tree : level_trees) {
+      tree->subtract_histogram();
+      tree->end_level(depth);
+    }
   }
-  for (int i = sparsesize_nextitr; i < sparsetree.size(); i++) {
-    sparsetree[i].prediction =
-      get_class_hist(&h_child_hist[(i - sparsesize_nextitr) * n_unique_labels],
-                     n_unique_labels);
+  depth_cnt.resize(n_trees);
+  leaf_cnt.resize(n_trees);
+  for (int i = 0; i < n_trees; i++) {
+    trees[i]->finish();
+    depth_cnt[i] = trees[i]->depth_cnt;
+    leaf_cnt[i] = trees[i]->leaf_cnt;
   }
+  d_batch.release(tempmems[0]->stream);
 }
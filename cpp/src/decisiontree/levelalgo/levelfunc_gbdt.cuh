@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cuml/tree/flatnode.h>
+#include <cuml/tree/decisiontree.hpp>
+#include <numeric>
+#include <vector>
+#include "common/nvtx.hpp"
+#include "common_helper.cuh"
+#include "levelhelper_gbdt.cuh"
+
+/*
+This is the driver function for building a tree of a gradient boosted model
+level by level, on the gradients grad and hessians hess of the loss at the
+rows of data. It follows grow_deep_tree_regression, except that:
+1. The nodes are described by their gradient and hessian sums G and H.
+2. The histograms are the sums of the gradients and hessians of the rows
+   left of each bin, and the split gain is the second order one of
+   gbdt_split_gain, with lambda the L2 regularization of the leaf values.
+3. A leaf has the value -learning_rate * G / (H + lambda).
+Only the split nodes get children in sparsetree.
+*/
+template <typename T>
+void grow_deep_tree_gbdt(
+  const T* data, const T* grad, const T* hess, unsigned int* rowids,
+  const int Ncols, const float colper, const int n_sampled_rows,
+  const int nrows, const int nbins, const int maxdepth, const int maxleaves,
+  const int min_rows_per_node, const int split_algo,
+  const float min_impurity_decrease, const float lambda,
+  const float min_child_weight, const float learning_rate, int& depth_cnt,
+  int& leaf_cnt, std::vector<SparseTreeNode<T, T>>& sparsetree,
+  const int treeid, std::shared_ptr<TemporaryMemory<T, T>> tempmem) {
+  const int ncols_sampled = (int)(colper * Ncols);
+  cudaStream_t stream = tempmem->stream;
+  unsigned int* flagsptr = tempmem->d_flags->data();
+  unsigned int* sample_cnt = tempmem->d_sample_cnt->data();
+  setup_sampling(flagsptr, sample_cnt, rowids, nrows, n_sampled_rows, stream);
+
+  int maxnodes = tempmem->max_nodes_per_level;
+  MLCommon::device_buffer<T> d_node_grad(tempmem->device_allocator, stream,
+                                         maxnodes);
+  MLCommon::device_buffer<T> d_node_hess(tempmem->device_allocator, stream,
+                                         maxnodes);
+  MLCommon::device_buffer<unsigned int> d_node_count(tempmem->device_allocator,
+                                                     stream, maxnodes);
+  std::vector<T> node_grad(maxnodes);
+  std::vector<T> node_hess(maxnodes);
+
+  sparsetree.clear();
+  sparsetree.push_back(SparseTreeNode<T, T>());
+  // Index in sparsetree of the nodes of the level, in the order of the flags
+  std::vector<int> level_nodes(1, 0);
+  std::vector<int> next_nodes;
+
+  //RNG setup
+  std::mt19937 mtg(treeid * 1000);
+  MLCommon::Random::Rng d_rng(treeid * 1000);
+  std::uniform_int_distribution<int> dist(0, Ncols - 1);
+
+  //Setup pointers
+  int* h_split_binidx = tempmem->h_split_binidx->data();
+  int* d_split_binidx = tempmem->d_split_binidx->data();
+  int* h_split_colidx = tempmem->h_split_colidx->data();
+  int* d_split_colidx = tempmem->d_split_colidx->data();
+  float* h_outgain = tempmem->h_outgain->data();
+  unsigned int* h_new_node_flags = tempmem->h_new_node_flags->data();
+  unsigned int* d_new_node_flags = tempmem->d_new_node_flags->data();
+  unsigned int* d_colids = tempmem->d_colids->data();
+  unsigned int* h_colids = tempmem->h_colids->data();
+  unsigned int* d_colstart = nullptr;
+  unsigned int* h_colstart = nullptr;
+  std::iota(h_colids, h_colids + Ncols, 0);
+  if (tempmem->d_colstart != nullptr) {
+    d_colstart = tempmem->d_colstart->data();
+    h_colstart = tempmem->h_colstart->data();
+    CUDA_CHECK(cudaMemsetAsync(d_colstart, 0, maxnodes * sizeof(unsigned int),
+                               stream));
+    memset(h_colstart, 0, maxnodes * sizeof(unsigned int));
+    MLCommon::updateDevice(d_colids, h_colids, Ncols, stream);
+  }
+  std::vector<unsigned int> feature_selector(h_colids, h_colids + Ncols);
+  T* quantile = nullptr;
+  T* minmax = nullptr;
+  if (tempmem->h_quantile != nullptr) quantile = tempmem->h_quantile->data();
+  if (tempmem->h_globalminmax != nullptr)
+    minmax = tempmem->h_globalminmax->data();
+
+  for (int depth = 0; (depth < maxdepth) && !level_nodes.empty(); depth++) {
+    depth_cnt = depth + 1;
+    int n_nodes = level_nodes.size();
+    ML::nvtxRange level("Trace::DT::Level", "depth=%d nodes=%d", depth,
+                        n_nodes);
+    ASSERT(
+      n_nodes <= maxnodes,
+      "Max node limit reached. Requested nodes %d > %d max nodes at depth %d\n",
+      n_nodes, maxnodes, depth);
+    update_feature_sampling(h_colids, d_colids, h_colstart, d_colstart, Ncols,
+                            ncols_sampled, n_nodes, mtg, dist, feature_selector,
+                            tempmem, d_rng);
+
+    get_node_gh(grad, hess, flagsptr, sample_cnt, nrows, n_nodes,
+                d_node_grad.data(), d_node_hess.data(), d_node_count.data(),
+                stream);
+    get_gh_histograms(data, grad, hess, flagsptr, sample_cnt, nrows, Ncols,
+                      ncols_sampled, nbins, n_nodes, split_algo, tempmem);
+    get_best_split_gbdt(d_node_grad.data(), d_node_hess.data(),
+                        d_node_count.data(), ncols_sampled, nbins, n_nodes,
+                        min_rows_per_node, lambda, min_child_weight, tempmem);
+    MLCommon::updateHost(node_grad.data(), d_node_grad.data(), n_nodes, stream);
+    MLCommon::updateHost(node_hess.data(), d_node_hess.data(), n_nodes, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+
+    bool condition_global = (maxleaves != -1) && (leaf_cnt >= maxleaves);
+    int non_leaf_counter = 0;
+    next_nodes.clear();
+    for (int i = 0; i < n_nodes; i++) {
+      int nodeid = level_nodes[i];
+      if (condition_global || h_outgain[i] <= min_impurity_decrease) {
+        sparsetree[nodeid].colid = -1;
+        sparsetree[nodeid].prediction =
+          -learning_rate * node_grad[i] / (node_hess[i] + lambda);
+        h_new_node_flags[i] = LEAF;
+        leaf_cnt++;
+        continue;
+      }
+      int local_colstart = -1;
+      if (h_colstart != nullptr) local_colstart = h_colstart[i];
+      int colid = getQuesColumn(h_colids, local_colstart, Ncols, ncols_sampled,
+                                h_split_colidx[i], i);
+      sparsetree[nodeid].colid = colid;
+      sparsetree[nodeid].quesval =
+        getQuesValue(minmax, quantile, nbins, h_split_colidx[i],
+                     h_split_binidx[i], i, n_nodes, colid, split_algo);
+      sparsetree[nodeid].best_metric_val = h_outgain[i];
+      sparsetree[nodeid].left_child_id = sparsetree.size();
+      next_nodes.push_back(sparsetree.size());
+      next_nodes.push_back(sparsetree.size() + 1);
+      sparsetree.push_back(SparseTreeNode<T, T>());
+      sparsetree.push_back(SparseTreeNode<T, T>());
+      h_new_node_flags[i] = non_leaf_counter++;
+    }
+
+    MLCommon::updateDevice(d_new_node_flags, h_new_node_flags, n_nodes,
+                           stream);
+    make_level_split(data, nrows, Ncols, ncols_sampled, nbins, n_nodes,
+                     split_algo, d_split_colidx, d_split_binidx,
+                     d_new_node_flags, flagsptr, tempmem);
+    level_nodes.swap(next_nodes);
+  }
+
+  // The nodes left after the last level are leaves
+  int n_nodes = level_nodes.size();
+  if (n_nodes != 0) {
+    ASSERT(n_nodes <= maxnodes,
+           "Max node limit reached. Requested nodes %d > %d max nodes\n",
+           n_nodes, maxnodes);
+    get_node_gh(grad, hess, flagsptr, sample_cnt, nrows, n_nodes,
+                d_node_grad.data(), d_node_hess.data(), d_node_count.data(),
+                stream);
+    MLCommon::updateHost(node_grad.data(), d_node_grad.data(), n_nodes, stream);
+    MLCommon::updateHost(node_hess.data(), d_node_hess.data(), n_nodes, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    for (int i = 0; i < n_nodes; i++) {
+      sparsetree[level_nodes[i]].prediction =
+        -learning_rate * node_grad[i] / (node_hess[i] + lambda);
+    }
+    leaf_cnt += n_nodes;
+  }
+  d_node_grad.release(stream);
+  d_node_hess.release(stream);
+  d_node_count.release(stream);
+}
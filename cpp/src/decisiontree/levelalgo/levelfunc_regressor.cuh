@@ -18,6 +18,7 @@
 #include <cuml/tree/decisiontree.hpp>
 #include <iostream>
 #include <numeric>
+#include "common/nvtx.hpp"
 #include "common_helper.cuh"
 #include "levelhelper_regressor.cuh"
 #include "metric.cuh"
@@ -112,6 +113,8 @@ void grow_deep_tree_regression(
   std::vector<unsigned int> feature_selector(h_colids, h_colids + Ncols);
 
   for (int depth = 0; (depth < maxdepth) && (n_nodes_nextitr != 0); depth++) {
+    ML::nvtxRange level("Trace::DT::Level", "depth=%d nodes=%d", depth,
+                        n_nodes_nextitr);
     depth_cnt = depth + 1;
     n_nodes = n_nodes_nextitr;
     update_feature_sampling(h_colids, d_colids, h_colstart, d_colstart, Ncols,
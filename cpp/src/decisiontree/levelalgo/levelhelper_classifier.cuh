@@ -39,287 +39,360 @@ void initial_metric_classification(
   initial_metric = F::exec(histvec, nrows);
 }
 
+template <typename T, typename QuestionType, typename D>
+void launch_hist_kernel(const D *data, const int *labels,
+                        const unsigned int *flags,
+                        const unsigned int *sample_cnt,
+                        const unsigned int *colids,
+                        const unsigned int *colstart, const int nrows,
+                        const int Ncols, const int ncols_sampled,
+                        const int n_unique_labels, const int nbins,
+                        const int n_nodes, const int node_batch,
+                        const T *question_ptr, const int *hist_parent,
+                        unsigned int *histout, cudaStream_t stream) {
+  size_t shmem = nbins * n_unique_labels * sizeof(int) * node_batch;
+  int threads = 256;
+  int blocks = MLCommon::ceildiv(nrows, threads);
+  if ((n_nodes == node_batch)) {
+    get_hist_kernel<T, QuestionType, D><<<blocks, threads, shmem, stream>>>(
+      data, labels, flags, sample_cnt, colids, colstart, nrows, Ncols,
+      ncols_sampled, n_unique_labels, nbins, n_nodes, question_ptr, hist_parent,
+      histout);
+  } else {
+    get_hist_kernel_global<T, QuestionType, D><<<blocks, threads, 0, stream>>>(
+      data, labels, flags, sample_cnt, colids, colstart, nrows, Ncols,
+      ncols_sampled, n_unique_labels, nbins, n_nodes, question_ptr, hist_parent,
+      histout);
+  }
+}
+
+template <typename T>
+void launch_hist_kernel_csc(const int *labels, const unsigned int *flags,
+                            const unsigned int *sample_cnt,
+                            const unsigned int *colids,
+                            const unsigned int *colstart, const int nrows,
+                            const int Ncols, const int ncols_sampled,
+                            const int n_unique_labels, const int nbins,
+                            const int n_nodes, const int *hist_parent,
+                            unsigned int *histout,
+                            std::shared_ptr<TemporaryMemory<T, int>> tempmem) {
+  ASSERT(colstart != nullptr, "CSC data does not support feature shuffling");
+  cudaStream_t stream = tempmem->stream;
+  // d_parent_hist is free once the root histogram is set (see
+  // ClassificationTreeBuilder)
+  unsigned int *nodecnt = tempmem->d_parent_hist->data();
+  CUDA_CHECK(cudaMemsetAsync(
+    nodecnt, 0, n_nodes * n_unique_labels * sizeof(unsigned int), stream));
+  int threads = 256;
+  node_count_kernel<<<MLCommon::ceildiv(nrows, threads), threads, 0,
+                      stream>>>(labels, flags, sample_cnt, nrows,
+                                n_unique_labels, nodecnt);
+  CUDA_CHECK(cudaGetLastError());
+
+  size_t histcount = (size_t)ncols_sampled * nbins * n_unique_labels * n_nodes;
+  int blocks = (int)std::min(MLCommon::ceildiv(histcount, (size_t)threads),
+                             (size_t)65535);
+  get_hist_init_kernel_csc<<<blocks, threads, 0, stream>>>(
+    nodecnt, tempmem->d_quantile->data(), colids, colstart, Ncols,
+    ncols_sampled, n_unique_labels, nbins, n_nodes, hist_parent, histout);
+  CUDA_CHECK(cudaGetLastError());
+
+  // One block row per column, sized for the average number of nonzeros
+  int col_nnz = max(MLCommon::ceildiv(tempmem->csc_nnz, Ncols), 1);
+  dim3 grid(MLCommon::ceildiv(col_nnz, threads), min(Ncols, 65535));
+  get_hist_kernel_csc<<<grid, threads, 0, stream>>>(
+    tempmem->d_csc_ind, tempmem->d_csc_rows, tempmem->d_csc_vals,
+    tempmem->csc_nnz, labels, flags, sample_cnt, colids, colstart, Ncols,
+    ncols_sampled, n_unique_labels, nbins, n_nodes,
+    tempmem->d_quantile->data(), hist_parent, histout);
+}
+
 template <typename T>
 void get_histogram_classification(
   const T *data, const int *labels, unsigned int *flags,
   unsigned int *sample_cnt, const int nrows, const int Ncols,
   const int ncols_sampled, const int n_unique_labels, const int nbins,
-  const int n_nodes, const int split_algo,
+  const int n_nodes, const int split_algo, const int *hist_parent,
   std::shared_ptr<TemporaryMemory<T, int>> tempmem, unsigned int *histout) {
   size_t histcount = ncols_sampled * nbins * n_unique_labels * n_nodes;
   CUDA_CHECK(cudaMemsetAsync(histout, 0, histcount * sizeof(unsigned int),
                              tempmem->stream));
   int node_batch = min(n_nodes, tempmem->max_nodes_class);
-  size_t shmem = nbins * n_unique_labels * sizeof(int) * node_batch;
-  int threads = 256;
-  int blocks = MLCommon::ceildiv(nrows, threads);
+  unsigned int *d_colids = tempmem->d_colids->data();
   unsigned int *d_colstart = nullptr;
   if (tempmem->d_colstart != nullptr) d_colstart = tempmem->d_colstart->data();
   if (split_algo == 0) {
-    get_minmax(data, flags, tempmem->d_colids->data(), d_colstart, nrows, Ncols,
-               ncols_sampled, n_nodes, tempmem->max_nodes_minmax,
+    get_minmax(data, flags, d_colids, d_colstart, nrows, Ncols, ncols_sampled,
+               n_nodes, tempmem->max_nodes_minmax,
                tempmem->d_globalminmax->data(), tempmem->h_globalminmax->data(),
                tempmem->stream);
-    if ((n_nodes == node_batch)) {
-      get_hist_kernel<T, MinMaxQues<T>>
-        <<<blocks, threads, shmem, tempmem->stream>>>(
-          data, labels, flags, sample_cnt, tempmem->d_colids->data(),
-          d_colstart, nrows, Ncols, ncols_sampled, n_unique_labels, nbins,
-          n_nodes, tempmem->d_globalminmax->data(), histout);
-    } else {
-      get_hist_kernel_global<T, MinMaxQues<T>>
-        <<<blocks, threads, 0, tempmem->stream>>>(
-          data, labels, flags, sample_cnt, tempmem->d_colids->data(),
-          d_colstart, nrows, Ncols, ncols_sampled, n_unique_labels, nbins,
-          n_nodes, tempmem->d_globalminmax->data(), histout);
-    }
+    launch_hist_kernel<T, MinMaxQues<T>>(
+      data, labels, flags, sample_cnt, d_colids, d_colstart, nrows, Ncols,
+      ncols_sampled, n_unique_labels, nbins, n_nodes, node_batch,
+      tempmem->d_globalminmax->data(), hist_parent, histout, tempmem->stream);
+  } else if (tempmem->d_csc_vals != nullptr) {
+    launch_hist_kernel_csc(labels, flags, sample_cnt, d_colids, d_colstart,
+                           nrows, Ncols, ncols_sampled, n_unique_labels, nbins,
+                           n_nodes, hist_parent, histout, tempmem);
+  } else if (tempmem->stream_cols > 0) {
+    // All the columns are used in order: the histograms of column block c0
+    // are the ones of columns c0 to c0 + nc - 1
+    bool bins8 = tempmem->h_bins8 != nullptr;
+    size_t col_hist = (size_t)nbins * n_nodes * n_unique_labels;
+    for_each_column_block(
+      nrows, Ncols, tempmem, [&](const char *block, int c0, int nc) {
+        const T *quantile = tempmem->d_quantile->data() + c0 * nbins;
+        if (bins8) {
+          launch_hist_kernel<T, BinQues<T>>(
+            (const unsigned char *)block, labels, flags, sample_cnt, d_colids,
+            d_colstart, nrows, nc, nc, n_unique_labels, nbins, n_nodes,
+            node_batch, quantile, hist_parent, histout + c0 * col_hist,
+            tempmem->stream);
+        } else {
+          launch_hist_kernel<T, BinQues<T>>(
+            (const unsigned short *)block, labels, flags, sample_cnt,
+            d_colids, d_colstart, nrows, nc, nc, n_unique_labels, nbins,
+            n_nodes, node_batch, quantile, hist_parent,
+            histout + c0 * col_hist, tempmem->stream);
+        }
+        CUDA_CHECK(cudaGetLastError());
+      });
+  } else if (tempmem->d_bins8 != nullptr) {
+    launch_hist_kernel<T, BinQues<T>>(
+      tempmem->d_bins8, labels, flags, sample_cnt, d_colids, d_colstart, nrows,
+      Ncols, ncols_sampled, n_unique_labels, nbins, n_nodes, node_batch,
+      tempmem->d_quantile->data(), hist_parent, histout, tempmem->stream);
+  } else if (tempmem->d_bins16 != nullptr) {
+    launch_hist_kernel<T, BinQues<T>>(
+      tempmem->d_bins16, labels, flags, sample_cnt, d_colids, d_colstart,
+      nrows, Ncols, ncols_sampled, n_unique_labels, nbins, n_nodes, node_batch,
+      tempmem->d_quantile->data(), hist_parent, histout, tempmem->stream);
+  } else {
+    launch_hist_kernel<T, QuantileQues<T>>(
+      data, labels, flags, sample_cnt, d_colids, d_colstart, nrows, Ncols,
+      ncols_sampled, n_unique_labels, nbins, n_nodes, node_batch,
+      tempmem->d_quantile->data(), hist_parent, histout, tempmem->stream);
+  }
+  CUDA_CHECK(cudaGetLastError());
+}
 
+template <typename T, typename QuestionType, typename D>
+void launch_hist_kernel_batched(const D *data, const int *labels,
+                                const HistBatchArgs<T> *batch, const int nrows,
+                                const int Ncols, const int ncols_sampled,
+                                const int n_unique_labels, const int nbins,
+                                const int n_trees, const int max_nodes,
+                                const int node_batch, cudaStream_t stream) {
+  size_t shmem = nbins * n_unique_labels * sizeof(int) * node_batch;
+  int threads = 256;
+  dim3 blocks(MLCommon::ceildiv(nrows, threads), n_trees);
+  if (max_nodes == node_batch) {
+    get_hist_kernel_batched<T, QuestionType, D>
+      <<<blocks, threads, shmem, stream>>>(data, labels, batch, nrows, Ncols,
+                                           ncols_sampled, n_unique_labels,
+                                           nbins);
   } else {
-    if ((n_nodes == node_batch)) {
-      get_hist_kernel<T, QuantileQues<T>>
-        <<<blocks, threads, shmem, tempmem->stream>>>(
-          data, labels, flags, sample_cnt, tempmem->d_colids->data(),
-          d_colstart, nrows, Ncols, ncols_sampled, n_unique_labels, nbins,
-          n_nodes, tempmem->d_quantile->data(), histout);
+    get_hist_kernel_global_batched<T, QuestionType, D>
+      <<<blocks, threads, 0, stream>>>(data, labels, batch, nrows, Ncols,
+                                       ncols_sampled, n_unique_labels, nbins);
+  }
+}
+
+/*Histograms of the current level of several trees grown in lock-step,
+ *in one kernel launch; the trees share the stream of tempmems[0] and
+ *n_nodes[i] is the number of nodes of tree i at this level and
+ *hist_parents[i] its hist_parent argument (see get_histogram_classification).
+ *d_batch holds the per tree kernel arguments, one element per tree.
+ */
+template <typename T>
+void get_histogram_classification_batched(
+  const T *data, const int *labels, const int nrows, const int Ncols,
+  const int ncols_sampled, const int n_unique_labels, const int nbins,
+  const int split_algo,
+  const std::vector<std::shared_ptr<TemporaryMemory<T, int>>> &tempmems,
+  const std::vector<int> &n_nodes, const std::vector<const int *> &hist_parents,
+  MLCommon::device_buffer<HistBatchArgs<T>> &d_batch) {
+  int n_trees = tempmems.size();
+  cudaStream_t stream = tempmems[0]->stream;
+  std::vector<HistBatchArgs<T>> h_batch(n_trees);
+  int max_nodes = 0;
+  for (int i = 0; i < n_trees; i++) {
+    std::shared_ptr<TemporaryMemory<T, int>> tempmem = tempmems[i];
+    ASSERT(tempmem->stream == stream,
+           "Trees grown in lock-step must share one stream");
+    HistBatchArgs<T> &args = h_batch[i];
+    args.flags = tempmem->d_flags->data();
+    args.sample_cnt = tempmem->d_sample_cnt->data();
+    args.colids = tempmem->d_colids->data();
+    args.colstart = nullptr;
+    if (tempmem->d_colstart != nullptr)
+      args.colstart = tempmem->d_colstart->data();
+    args.hist_parent = hist_parents[i];
+    args.histout = tempmem->d_histogram->data();
+    args.n_nodes = n_nodes[i];
+    size_t histcount = ncols_sampled * nbins * n_unique_labels * n_nodes[i];
+    CUDA_CHECK(cudaMemsetAsync(args.histout, 0,
+                               histcount * sizeof(unsigned int), stream));
+    if (split_algo == 0) {
+      get_minmax(data, args.flags, args.colids, args.colstart, nrows, Ncols,
+                 ncols_sampled, n_nodes[i], tempmem->max_nodes_minmax,
+                 tempmem->d_globalminmax->data(),
+                 tempmem->h_globalminmax->data(), stream);
+      args.question_ptr = tempmem->d_globalminmax->data();
     } else {
-      get_hist_kernel_global<T, QuantileQues<T>>
-        <<<blocks, threads, 0, tempmem->stream>>>(
-          data, labels, flags, sample_cnt, tempmem->d_colids->data(),
-          d_colstart, nrows, Ncols, ncols_sampled, n_unique_labels, nbins,
-          n_nodes, tempmem->d_quantile->data(), histout);
+      args.question_ptr = tempmem->d_quantile->data();
     }
+    max_nodes = max(max_nodes, n_nodes[i]);
   }
+  MLCommon::updateDevice(d_batch.data(), h_batch.data(), n_trees, stream);
+
+  // the trees of a forest share their pre-binned data, if any
+  std::shared_ptr<TemporaryMemory<T, int>> tempmem = tempmems[0];
+  int node_batch = min(max_nodes, tempmem->max_nodes_class);
+  if (split_algo == 0) {
+    launch_hist_kernel_batched<T, MinMaxQues<T>>(
+      data, labels, d_batch.data(), nrows, Ncols, ncols_sampled,
+      n_unique_labels, nbins, n_trees, max_nodes, node_batch, stream);
+  } else if (tempmem->d_bins8 != nullptr) {
+    launch_hist_kernel_batched<T, BinQues<T>>(
+      tempmem->d_bins8, labels, d_batch.data(), nrows, Ncols, ncols_sampled,
+      n_unique_labels, nbins, n_trees, max_nodes, node_batch, stream);
+  } else if (tempmem->d_bins16 != nullptr) {
+    launch_hist_kernel_batched<T, BinQues<T>>(
+      tempmem->d_bins16, labels, d_batch.data(), nrows, Ncols, ncols_sampled,
+      n_unique_labels, nbins, n_trees, max_nodes, node_batch, stream);
+  } else {
+    launch_hist_kernel_batched<T, QuantileQues<T>>(
+      data, labels, d_batch.data(), nrows, Ncols, ncols_sampled,
+      n_unique_labels, nbins, n_trees, max_nodes, node_batch, stream);
+  }
+  CUDA_CHECK(cudaGetLastError());
+  // h_batch must outlive its copy to the device
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+}
+/*Derives the histograms of the nodes with hist_parent[node] != -1 from the
+ *histogram of the previous level prev_hist, with n_prev_nodes nodes, once
+ *the histograms of their siblings are computed.
+ */
+void subtract_histogram_classification(
+  const unsigned int *prev_hist, const int *hist_parent,
+  const int ncols_sampled, const int n_unique_labels, const int nbins,
+  const int n_nodes, const int n_prev_nodes, unsigned int *hist,
+  cudaStream_t stream) {
+  size_t histcount = (size_t)ncols_sampled * nbins * n_unique_labels * n_nodes;
+  int threads = 256;
+  int blocks = (int)std::min(MLCommon::ceildiv(histcount, (size_t)threads),
+                             (size_t)65535);
+  subtract_hist_kernel<<<blocks, threads, 0, stream>>>(
+    prev_hist, hist_parent, ncols_sampled, n_unique_labels, nbins, n_nodes,
+    n_prev_nodes, hist);
   CUDA_CHECK(cudaGetLastError());
 }
-template <typename T, typename F, typename DF>
+
+template <typename T, typename DF>
 void get_best_split_classification(
-  unsigned int *hist, unsigned int *d_hist, unsigned int *h_colids,
-  unsigned int *d_colids, unsigned int *h_colstart, unsigned int *d_colstart,
-  const int Ncols, const int ncols_sampled, const int nbins,
-  const int n_unique_labels, const int n_nodes, const int depth,
-  const int min_rpn, const int split_algo, float *gain,
-  unsigned int *h_parent_hist, unsigned int *h_child_hist,
-  std::vector<SparseTreeNode<T, int>> &sparsetree, const int sparsesize,
-  std::vector<int> &sparse_nodelist, int *split_colidx, int *split_binidx,
-  int *d_split_colidx, int *d_split_binidx,
+  const unsigned int *d_hist, const int ncols_sampled, const int nbins,
+  const int n_unique_labels, const int n_nodes, const int min_rpn,
   std::shared_ptr<TemporaryMemory<T, int>> tempmem) {
-  T *quantile = nullptr;
-  T *minmax = nullptr;
-  if (tempmem->h_quantile != nullptr) quantile = tempmem->h_quantile->data();
-  if (tempmem->h_globalminmax != nullptr)
-    minmax = tempmem->h_globalminmax->data();
-  if (split_algo == 0) CUDA_CHECK(cudaStreamSynchronize(tempmem->stream));
-  bool use_gpu_flag = false;
-  size_t histcount = ncols_sampled * nbins * n_unique_labels * n_nodes;
-  if (n_nodes > 512) use_gpu_flag = true;
-  memset(gain, 0, n_nodes * sizeof(float));
-  int sparsetree_sz = sparsetree.size();
-  if (use_gpu_flag) {
-    //GPU based best split
-    unsigned int *d_parent_hist, *d_child_hist;
-    T *d_parent_metric, *d_child_best_metric;
-    T *h_parent_metric, *h_child_best_metric;
-    float *d_outgain, *h_outgain;
-    h_parent_metric = tempmem->h_parent_metric->data();
-    h_child_best_metric = tempmem->h_child_best_metric->data();
-    h_outgain = tempmem->h_outgain->data();
+  cudaStream_t stream = tempmem->stream;
+  float *d_outgain = tempmem->d_outgain->data();
+  int *d_split_colidx = tempmem->d_split_colidx->data();
+  int *d_split_binidx = tempmem->d_split_binidx->data();
+  unsigned int *d_child_hist = tempmem->d_child_hist->data();
+  T *d_child_best_metric = tempmem->d_child_best_metric->data();
+  // The kernel sets none of these for the nodes without a valid split
+  CUDA_CHECK(cudaMemsetAsync(d_outgain, 0, n_nodes * sizeof(float), stream));
+  CUDA_CHECK(
+    cudaMemsetAsync(d_split_binidx, 0, n_nodes * sizeof(int), stream));
+  CUDA_CHECK(
+    cudaMemsetAsync(d_split_colidx, 0, n_nodes * sizeof(int), stream));
+  CUDA_CHECK(cudaMemsetAsync(
+    d_child_hist, 0, 2 * n_nodes * n_unique_labels * sizeof(unsigned int),
+    stream));
+  CUDA_CHECK(
+    cudaMemsetAsync(d_child_best_metric, 0, 2 * n_nodes * sizeof(T), stream));
 
-    d_parent_hist = tempmem->d_parent_hist->data();
-    d_child_hist = tempmem->d_child_hist->data();
-    d_parent_metric = tempmem->d_parent_metric->data();
-    d_child_best_metric = tempmem->d_child_best_metric->data();
-    d_outgain = tempmem->d_outgain->data();
-    for (int nodecnt = 0; nodecnt < n_nodes; nodecnt++) {
-      int sparse_nodeid = sparse_nodelist[nodecnt];
-      int parentid = sparsesize + sparse_nodeid;
-      unsigned int *parent_hist =
-        &h_parent_hist[sparse_nodeid * n_unique_labels];
-      h_parent_metric[nodecnt] = sparsetree[parentid].best_metric_val;
-      memcpy(&h_parent_hist[nodecnt * n_unique_labels], parent_hist,
-             n_unique_labels * sizeof(int));
-    }
-
-    MLCommon::updateDevice(d_parent_hist, h_parent_hist,
-                           n_nodes * n_unique_labels, tempmem->stream);
-    MLCommon::updateDevice(d_parent_metric, h_parent_metric, n_nodes,
-                           tempmem->stream);
-    CUDA_CHECK(
-      cudaMemsetAsync(d_outgain, 0, n_nodes * sizeof(float), tempmem->stream));
-    CUDA_CHECK(cudaMemsetAsync(d_split_binidx, 0, n_nodes * sizeof(int),
-                               tempmem->stream));
-    CUDA_CHECK(cudaMemsetAsync(d_split_colidx, 0, n_nodes * sizeof(int),
-                               tempmem->stream));
+  int threads = 64;
+  size_t shmemsz = (threads + 2) * 2 * n_unique_labels * sizeof(int);
+  get_best_split_classification_kernel<T, DF>
+    <<<n_nodes, threads, shmemsz, stream>>>(
+      d_hist, tempmem->d_level_hist->data(), tempmem->d_level_metric->data(),
+      nbins, ncols_sampled, n_nodes, n_unique_labels, min_rpn, d_outgain,
+      d_split_colidx, d_split_binidx, d_child_hist, d_child_best_metric);
+  CUDA_CHECK(cudaGetLastError());
+}
 
-    int threads = 64;
-    size_t shmemsz = (threads + 2) * 2 * n_unique_labels * sizeof(int);
-    get_best_split_classification_kernel<T, DF>
-      <<<n_nodes, threads, shmemsz, tempmem->stream>>>(
-        d_hist, d_parent_hist, d_parent_metric, nbins, ncols_sampled, n_nodes,
-        n_unique_labels, min_rpn, d_outgain, d_split_colidx, d_split_binidx,
-        d_child_hist, d_child_best_metric);
-    CUDA_CHECK(cudaGetLastError());
-    MLCommon::updateHost(h_child_hist, d_child_hist,
-                         2 * n_nodes * n_unique_labels, tempmem->stream);
-    MLCommon::updateHost(h_outgain, d_outgain, n_nodes, tempmem->stream);
-    MLCommon::updateHost(h_child_best_metric, d_child_best_metric, 2 * n_nodes,
-                         tempmem->stream);
-    MLCommon::updateHost(split_binidx, d_split_binidx, n_nodes,
-                         tempmem->stream);
-    MLCommon::updateHost(split_colidx, d_split_colidx, n_nodes,
-                         tempmem->stream);
+// Sets tempmem->d_hist_parent for the level (see hist_parent_kernel)
+template <typename T>
+void set_hist_parent_classification(
+  const int n_nodes, const int n_unique_labels,
+  std::shared_ptr<TemporaryMemory<T, int>> tempmem) {
+  int threads = 128;
+  int blocks = MLCommon::ceildiv(n_nodes / 2, threads);
+  hist_parent_kernel<<<blocks, threads, 0, tempmem->stream>>>(
+    tempmem->d_level_hist->data(), tempmem->d_nodelist->data(), n_nodes,
+    n_unique_labels, tempmem->d_hist_parent->data());
+  CUDA_CHECK(cudaGetLastError());
+}
 
-    CUDA_CHECK(cudaStreamSynchronize(tempmem->stream));
-    for (int nodecnt = 0; nodecnt < n_nodes; nodecnt++) {
-      int sparse_nodeid = sparse_nodelist[nodecnt];
-      //Sparse tree
-      SparseTreeNode<T, int> &curr_node =
-        sparsetree[sparsesize + sparse_nodeid];
-      int local_colstart = -1;
-      if (h_colstart != nullptr) local_colstart = h_colstart[nodecnt];
-      curr_node.colid =
-        getQuesColumn(h_colids, local_colstart, Ncols, ncols_sampled,
-                      split_colidx[nodecnt], nodecnt);
-      curr_node.quesval = getQuesValue(
-        minmax, quantile, nbins, split_colidx[nodecnt], split_binidx[nodecnt],
-        nodecnt, n_nodes, curr_node.colid, split_algo);
+/* Builds the nodes of the level and their children in d_sparsetree from the
+ * best splits (see make_level_nodes_kernel), sets d_new_node_flags for
+ * make_level_split, the next level buffers of tempmem and d_n_split.
+ */
+template <typename T>
+void make_level_nodes_classification(
+  const int Ncols, const int ncols_sampled, const int nbins,
+  const int n_unique_labels, const int n_nodes,
+  const float min_impurity_decrease, const bool leaf_level,
+  const int sparsesize, const int sparsetree_sz,
+  SparseTreeNode<T, int> *d_sparsetree,
+  std::shared_ptr<TemporaryMemory<T, int>> tempmem) {
+  cudaStream_t stream = tempmem->stream;
+  unsigned int *d_split_flags = tempmem->d_split_flags->data();
+  unsigned int *d_new_node_flags = tempmem->d_new_node_flags->data();
+  int threads = 128;
+  int blocks = MLCommon::ceildiv(n_nodes, threads);
+  split_flags_kernel<<<blocks, threads, 0, stream>>>(
+    tempmem->d_outgain->data(), n_nodes, min_impurity_decrease, leaf_level,
+    d_split_flags);
+  CUDA_CHECK(cudaGetLastError());
+  size_t scan_bytes = tempmem->d_scan_temp->size();
+  CUDA_CHECK(cub::DeviceScan::ExclusiveSum(
+    (void *)tempmem->d_scan_temp->data(), scan_bytes, d_split_flags,
+    d_new_node_flags, n_nodes, stream));
 
-      curr_node.left_child_id = sparsetree_sz + 2 * nodecnt;
-      SparseTreeNode<T, int> leftnode, rightnode;
-      leftnode.best_metric_val = h_child_best_metric[2 * nodecnt];
-      rightnode.best_metric_val = h_child_best_metric[2 * nodecnt + 1];
-      sparsetree.push_back(leftnode);
-      sparsetree.push_back(rightnode);
-    }
+  const unsigned int *d_colstart = nullptr;
+  if (tempmem->d_colstart != nullptr) d_colstart = tempmem->d_colstart->data();
+  const T *d_quantile = nullptr;
+  const T *d_minmax = nullptr;
+  if (tempmem->d_globalminmax != nullptr) {
+    d_minmax = tempmem->d_globalminmax->data();
   } else {
-    MLCommon::updateHost(hist, d_hist, histcount, tempmem->stream);
-    CUDA_CHECK(cudaStreamSynchronize(tempmem->stream));
-
-    for (int nodecnt = 0; nodecnt < n_nodes; nodecnt++) {
-      std::vector<T> bestmetric(2, 0);
-      int nodeoffset = nodecnt * nbins * n_unique_labels;
-      int sparse_nodeid = sparse_nodelist[nodecnt];
-      int parentid = sparsesize + sparse_nodeid;
-      int best_col_id = 0;
-      int best_bin_id = 0;
-      std::vector<unsigned int> besthist_left(n_unique_labels, 0);
-      std::vector<unsigned int> besthist_right(n_unique_labels, 0);
-      unsigned int *parent_hist =
-        &h_parent_hist[sparse_nodeid * n_unique_labels];
-      for (int colid = 0; colid < ncols_sampled; colid++) {
-        int coloffset = colid * nbins * n_unique_labels * n_nodes;
-        for (int binid = 0; binid < nbins; binid++) {
-          int binoffset = binid * n_unique_labels;
-          int tmp_lnrows = 0;
-          int tmp_rnrows = 0;
-          std::vector<unsigned int> tmp_histleft(n_unique_labels, 0);
-          std::vector<unsigned int> tmp_histright(n_unique_labels, 0);
-          // Compute gini right and gini left value for each bin.
-          for (int j = 0; j < n_unique_labels; j++) {
-            tmp_histleft[j] = hist[coloffset + binoffset + nodeoffset + j];
-            tmp_histright[j] = parent_hist[j] - tmp_histleft[j];
-          }
-          for (int j = 0; j < n_unique_labels; j++) {
-            tmp_lnrows += tmp_histleft[j];
-            tmp_rnrows += tmp_histright[j];
-          }
-          int totalrows = tmp_lnrows + tmp_rnrows;
-          if (tmp_lnrows == 0 || tmp_rnrows == 0 || totalrows < min_rpn)
-            continue;
-
-          float tmp_gini_left = F::exec(tmp_histleft, tmp_lnrows);
-          float tmp_gini_right = F::exec(tmp_histright, tmp_rnrows);
-
-          float max_value = F::max_val(n_unique_labels);
-
-          ASSERT((tmp_gini_left >= 0.0f) && (tmp_gini_left <= max_value),
-                 "gini left value %f not in [0.0, %f]", tmp_gini_left,
-                 max_value);
-          ASSERT((tmp_gini_right >= 0.0f) && (tmp_gini_right <= max_value),
-                 "gini right value %f not in [0.0, %f]", tmp_gini_right,
-                 max_value);
-
-          float impurity = (tmp_lnrows * 1.0f / totalrows) * tmp_gini_left +
-                           (tmp_rnrows * 1.0f / totalrows) * tmp_gini_right;
-          float info_gain = sparsetree[parentid].best_metric_val - impurity;
-
-          // Compute best information col_gain so far
-          if (info_gain > gain[nodecnt]) {
-            gain[nodecnt] = info_gain;
-            best_bin_id = binid;
-            best_col_id = colid;
-            besthist_left = tmp_histleft;
-            besthist_right = tmp_histright;
-            bestmetric[0] = tmp_gini_left;
-            bestmetric[1] = tmp_gini_right;
-          }
-        }
-      }
-      split_colidx[nodecnt] = best_col_id;
-      split_binidx[nodecnt] = best_bin_id;
-      //Sparse tree
-      SparseTreeNode<T, int> &curr_node =
-        sparsetree[sparsesize + sparse_nodeid];
-      int local_colstart = -1;
-      if (h_colstart != nullptr) local_colstart = h_colstart[nodecnt];
-      curr_node.colid =
-        getQuesColumn(h_colids, local_colstart, Ncols, ncols_sampled,
-                      split_colidx[nodecnt], nodecnt);
-      curr_node.quesval = getQuesValue(
-        minmax, quantile, nbins, split_colidx[nodecnt], split_binidx[nodecnt],
-        nodecnt, n_nodes, curr_node.colid, split_algo);
-
-      curr_node.left_child_id = sparsetree_sz + 2 * nodecnt;
-      SparseTreeNode<T, int> leftnode, rightnode;
-      leftnode.best_metric_val = bestmetric[0];
-      rightnode.best_metric_val = bestmetric[1];
-      sparsetree.push_back(leftnode);
-      sparsetree.push_back(rightnode);
-      memcpy(&h_child_hist[2 * nodecnt * n_unique_labels], besthist_left.data(),
-             n_unique_labels * sizeof(unsigned int));
-      memcpy(&h_child_hist[(2 * nodecnt + 1) * n_unique_labels],
-             besthist_right.data(), n_unique_labels * sizeof(unsigned int));
-    }
-    MLCommon::updateDevice(d_split_binidx, split_binidx, n_nodes,
-                           tempmem->stream);
-    MLCommon::updateDevice(d_split_colidx, split_colidx, n_nodes,
-                           tempmem->stream);
+    d_quantile = tempmem->d_quantile->data();
   }
+  make_level_nodes_kernel<T><<<blocks, threads, 0, stream>>>(
+    d_split_flags, tempmem->d_split_colidx->data(),
+    tempmem->d_split_binidx->data(), tempmem->d_colids->data(), d_colstart,
+    d_quantile, d_minmax, Ncols, ncols_sampled, nbins, n_nodes,
+    n_unique_labels, tempmem->d_nodelist->data(),
+    tempmem->d_level_hist->data(), tempmem->d_child_hist->data(),
+    tempmem->d_child_best_metric->data(), sparsesize, sparsetree_sz,
+    d_new_node_flags, d_sparsetree, tempmem->d_next_nodelist->data(),
+    tempmem->d_next_level_hist->data(), tempmem->d_next_level_metric->data(),
+    tempmem->d_n_split->data());
+  CUDA_CHECK(cudaGetLastError());
 }
 
+// Sets the predictions of n_leaves nodes from their histograms hist
 template <typename T>
-void leaf_eval_classification(
-  float *gain, int curr_depth, const float min_impurity_decrease,
-  const int max_depth, const int n_unique_labels, const int max_leaves,
-  unsigned int *new_node_flags, std::vector<SparseTreeNode<T, int>> &sparsetree,
-  const int sparsesize, unsigned int *sparse_hist, int &n_nodes_next,
-  std::vector<int> &sparse_nodelist, int &tree_leaf_cnt) {
-  std::vector<int> tmp_sparse_nodelist(sparse_nodelist);
-  sparse_nodelist.clear();
-
-  int non_leaf_counter = 0;
-  bool condition_global = (curr_depth == max_depth);
-  if (max_leaves != -1)
-    condition_global = condition_global || (tree_leaf_cnt >= max_leaves);
-
-  for (int i = 0; i < tmp_sparse_nodelist.size(); i++) {
-    unsigned int node_flag;
-    int sparse_nodeid = tmp_sparse_nodelist[i];
-    unsigned int *nodehist = &sparse_hist[sparse_nodeid * n_unique_labels];
-    bool condition = condition_global || (gain[i] <= min_impurity_decrease);
-    if (condition) {
-      node_flag = 0xFFFFFFFF;
-      sparsetree[sparsesize + sparse_nodeid].colid = -1;
-      sparsetree[sparsesize + sparse_nodeid].prediction =
-        get_class_hist(nodehist, n_unique_labels);
-    } else {
-      sparse_nodelist.push_back(2 * i);
-      sparse_nodelist.push_back(2 * i + 1);
-      node_flag = non_leaf_counter;
-      non_leaf_counter++;
-    }
-    new_node_flags[i] = node_flag;
-  }
-  int nleafed = tmp_sparse_nodelist.size() - non_leaf_counter;
-  tree_leaf_cnt += nleafed;
-  n_nodes_next = 2 * non_leaf_counter;
+void leaf_predictions_classification(const unsigned int *hist,
+                                     const int n_leaves,
+                                     const int n_unique_labels,
+                                     SparseTreeNode<T, int> *d_nodes,
+                                     cudaStream_t stream) {
+  int threads = 128;
+  leaf_predictions_kernel<T>
+    <<<MLCommon::ceildiv(n_leaves, threads), threads, 0, stream>>>(
+      hist, n_leaves, n_unique_labels, d_nodes);
+  CUDA_CHECK(cudaGetLastError());
 }
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "levelkernel_gbdt.cuh"
+
+// Gradient and hessian sums and row counts of the n_nodes nodes of a level
+template <typename T>
+void get_node_gh(const T *grad, const T *hess, const unsigned int *flags,
+                 const unsigned int *sample_cnt, const int nrows,
+                 const int n_nodes, T *d_node_grad, T *d_node_hess,
+                 unsigned int *d_node_count, cudaStream_t stream) {
+  CUDA_CHECK(cudaMemsetAsync(d_node_grad, 0, n_nodes * sizeof(T), stream));
+  CUDA_CHECK(cudaMemsetAsync(d_node_hess, 0, n_nodes * sizeof(T), stream));
+  CUDA_CHECK(
+    cudaMemsetAsync(d_node_count, 0, n_nodes * sizeof(unsigned int), stream));
+  int threads = 256;
+  int blocks = MLCommon::ceildiv(nrows, threads);
+  node_gh_kernel<<<blocks, threads, 0, stream>>>(grad, hess, flags, sample_cnt,
+                                                 nrows, d_node_grad,
+                                                 d_node_hess, d_node_count);
+  CUDA_CHECK(cudaGetLastError());
+}
+
+template <typename T, typename QuestionType, typename D>
+void launch_gh_kernels(const D *data, const T *grad, const T *hess,
+                       const unsigned int *flags,
+                       const unsigned int *sample_cnt, const int nrows,
+                       const int Ncols, const int ncols_sampled,
+                       const int nbins, const int n_nodes,
+                       const T *question_ptr,
+                       std::shared_ptr<TemporaryMemory<T, T>> tempmem,
+                       T *d_gradout, T *d_hessout, unsigned int *d_count) {
+  size_t shmem = nbins * (2 * sizeof(T) + sizeof(unsigned int)) * n_nodes;
+  int max_nodes_gh =
+    tempmem->max_shared_mem / (nbins * (2 * sizeof(T) + sizeof(unsigned int)));
+  max_nodes_gh /= 2;  // For occupancy purposes.
+
+  int threads = 256;
+  int blocks = MLCommon::ceildiv(nrows, threads);
+  unsigned int *d_colstart = nullptr;
+  if (tempmem->d_colstart != nullptr) d_colstart = tempmem->d_colstart->data();
+
+  if (n_nodes <= max_nodes_gh) {
+    get_gh_kernel<T, QuestionType, D>
+      <<<blocks, threads, shmem, tempmem->stream>>>(
+        data, grad, hess, flags, sample_cnt, tempmem->d_colids->data(),
+        d_colstart, nrows, Ncols, ncols_sampled, nbins, n_nodes, question_ptr,
+        d_gradout, d_hessout, d_count);
+  } else {
+    get_gh_kernel_global<T, QuestionType, D>
+      <<<blocks, threads, 0, tempmem->stream>>>(
+        data, grad, hess, flags, sample_cnt, tempmem->d_colids->data(),
+        d_colstart, nrows, Ncols, ncols_sampled, nbins, n_nodes, question_ptr,
+        d_gradout, d_hessout, d_count);
+  }
+  CUDA_CHECK(cudaGetLastError());
+}
+
+/* Computes the gradient and hessian histograms of a level. They go into the
+ * regression buffers of tempmem: the gradient sums into d_predout, the
+ * hessian sums into the first half of d_mseout and the counts into d_count.
+ */
+template <typename T>
+void get_gh_histograms(const T *data, const T *grad, const T *hess,
+                       unsigned int *flags, unsigned int *sample_cnt,
+                       const int nrows, const int Ncols,
+                       const int ncols_sampled, const int nbins,
+                       const int n_nodes, const int split_algo,
+                       std::shared_ptr<TemporaryMemory<T, T>> tempmem) {
+  T *d_gradout = tempmem->d_predout->data();
+  T *d_hessout = tempmem->d_mseout->data();
+  unsigned int *d_count = tempmem->d_count->data();
+  size_t predcount = ncols_sampled * nbins * n_nodes;
+  CUDA_CHECK(
+    cudaMemsetAsync(d_gradout, 0, predcount * sizeof(T), tempmem->stream));
+  CUDA_CHECK(
+    cudaMemsetAsync(d_hessout, 0, predcount * sizeof(T), tempmem->stream));
+  CUDA_CHECK(cudaMemsetAsync(d_count, 0, predcount * sizeof(unsigned int),
+                             tempmem->stream));
+
+  if (split_algo == 0) {
+    unsigned int *d_colstart = nullptr;
+    if (tempmem->d_colstart != nullptr)
+      d_colstart = tempmem->d_colstart->data();
+    get_minmax(data, flags, tempmem->d_colids->data(), d_colstart, nrows, Ncols,
+               ncols_sampled, n_nodes, tempmem->max_nodes_minmax,
+               tempmem->d_globalminmax->data(), tempmem->h_globalminmax->data(),
+               tempmem->stream);
+    launch_gh_kernels<T, MinMaxQues<T>>(
+      data, grad, hess, flags, sample_cnt, nrows, Ncols, ncols_sampled, nbins,
+      n_nodes, tempmem->d_globalminmax->data(), tempmem, d_gradout, d_hessout,
+      d_count);
+  } else if (tempmem->d_bins8 != nullptr) {
+    launch_gh_kernels<T, BinQues<T>>(
+      tempmem->d_bins8, grad, hess, flags, sample_cnt, nrows, Ncols,
+      ncols_sampled, nbins, n_nodes, tempmem->d_quantile->data(), tempmem,
+      d_gradout, d_hessout, d_count);
+  } else if (tempmem->d_bins16 != nullptr) {
+    launch_gh_kernels<T, BinQues<T>>(
+      tempmem->d_bins16, grad, hess, flags, sample_cnt, nrows, Ncols,
+      ncols_sampled, nbins, n_nodes, tempmem->d_quantile->data(), tempmem,
+      d_gradout, d_hessout, d_count);
+  } else {
+    launch_gh_kernels<T, QuantileQues<T>>(
+      data, grad, hess, flags, sample_cnt, nrows, Ncols, ncols_sampled, nbins,
+      n_nodes, tempmem->d_quantile->data(), tempmem, d_gradout, d_hessout,
+      d_count);
+  }
+}
+
+/* Finds the best split of each node of a level from the histograms of
+ * get_gh_histograms, and copies the gains and split indices to the
+ * h_outgain, h_split_colidx and h_split_binidx buffers of tempmem.
+ */
+template <typename T>
+void get_best_split_gbdt(const T *d_node_grad, const T *d_node_hess,
+                         const unsigned int *d_node_count,
+                         const int ncols_sampled, const int nbins,
+                         const int n_nodes, const int min_rpn,
+                         const float lambda, const float min_child_weight,
+                         std::shared_ptr<TemporaryMemory<T, T>> tempmem) {
+  float *d_outgain = tempmem->d_outgain->data();
+  int *d_split_colidx = tempmem->d_split_colidx->data();
+  int *d_split_binidx = tempmem->d_split_binidx->data();
+  int threads = 64;
+  get_best_split_gbdt_kernel<<<n_nodes, threads, 0, tempmem->stream>>>(
+    tempmem->d_predout->data(), tempmem->d_mseout->data(),
+    tempmem->d_count->data(), d_node_grad, d_node_hess, d_node_count, nbins,
+    ncols_sampled, n_nodes, min_rpn, lambda, min_child_weight, d_outgain,
+    d_split_colidx, d_split_binidx);
+  CUDA_CHECK(cudaGetLastError());
+  MLCommon::updateHost(tempmem->h_outgain->data(), d_outgain, n_nodes,
+                       tempmem->stream);
+  MLCommon::updateHost(tempmem->h_split_colidx->data(), d_split_colidx,
+                       n_nodes, tempmem->stream);
+  MLCommon::updateHost(tempmem->h_split_binidx->data(), d_split_binidx,
+                       n_nodes, tempmem->stream);
+}
@@ -49,6 +49,57 @@ void initial_metric_regression(const T *labels, unsigned int *sample_cnt,
   initial_metric = tempmem->h_mseout->data()[0] / count;
 }
 
+template <typename T, typename F, typename QuestionType, typename D>
+void launch_mse_kernels(const D *data, const T *labels,
+                        const unsigned int *flags,
+                        const unsigned int *sample_cnt, const int nrows,
+                        const int Ncols, const int ncols_sampled,
+                        const int nbins, const int n_nodes,
+                        const T *question_ptr,
+                        std::shared_ptr<TemporaryMemory<T, T>> tempmem,
+                        T *d_mseout, T *d_predout, unsigned int *d_count) {
+  int node_batch_pred = min(n_nodes, tempmem->max_nodes_pred);
+  int node_batch_mse = min(n_nodes, tempmem->max_nodes_mse);
+  size_t shmempred = nbins * (sizeof(unsigned int) + sizeof(T)) * n_nodes;
+  size_t shmemmse = shmempred + 2 * nbins * n_nodes * sizeof(T);
+
+  int threads = 256;
+  int blocks = MLCommon::ceildiv(nrows, threads);
+  unsigned int *d_colstart = nullptr;
+  if (tempmem->d_colstart != nullptr) d_colstart = tempmem->d_colstart->data();
+
+  if ((n_nodes == node_batch_pred)) {
+    get_pred_kernel<T, QuestionType, D>
+      <<<blocks, threads, shmempred, tempmem->stream>>>(
+        data, labels, flags, sample_cnt, tempmem->d_colids->data(), d_colstart,
+        nrows, Ncols, ncols_sampled, nbins, n_nodes, question_ptr, d_predout,
+        d_count);
+  } else {
+    get_pred_kernel_global<T, QuestionType, D>
+      <<<blocks, threads, 0, tempmem->stream>>>(
+        data, labels, flags, sample_cnt, tempmem->d_colids->data(), d_colstart,
+        nrows, Ncols, ncols_sampled, nbins, n_nodes, question_ptr, d_predout,
+        d_count);
+  }
+  CUDA_CHECK(cudaGetLastError());
+  if ((n_nodes == node_batch_mse)) {
+    get_mse_kernel<T, F, QuestionType, D>
+      <<<blocks, threads, shmemmse, tempmem->stream>>>(
+        data, labels, flags, sample_cnt, tempmem->d_colids->data(), d_colstart,
+        nrows, Ncols, ncols_sampled, nbins, n_nodes, question_ptr,
+        tempmem->d_parent_pred->data(), tempmem->d_parent_count->data(),
+        d_predout, d_count, d_mseout);
+  } else {
+    get_mse_kernel_global<T, F, QuestionType, D>
+      <<<blocks, threads, 0, tempmem->stream>>>(
+        data, labels, flags, sample_cnt, tempmem->d_colids->data(), d_colstart,
+        nrows, Ncols, ncols_sampled, nbins, n_nodes, question_ptr,
+        tempmem->d_parent_pred->data(), tempmem->d_parent_count->data(),
+        d_predout, d_count, d_mseout);
+  }
+  CUDA_CHECK(cudaGetLastError());
+}
+
 template <typename T, typename F>
 void get_mse_regression(const T *data, const T *labels, unsigned int *flags,
                         unsigned int *sample_cnt, const int nrows,
@@ -65,83 +116,33 @@ void get_mse_regression(const T *data, const T *labels, unsigned int *flags,
   CUDA_CHECK(cudaMemsetAsync(d_count, 0, predcount * sizeof(unsigned int),
                              tempmem->stream));
 
-  int node_batch_pred = min(n_nodes, tempmem->max_nodes_pred);
-  int node_batch_mse = min(n_nodes, tempmem->max_nodes_mse);
-  size_t shmempred = nbins * (sizeof(unsigned int) + sizeof(T)) * n_nodes;
-  size_t shmemmse = shmempred + 2 * nbins * n_nodes * sizeof(T);
-
-  int threads = 256;
-  int blocks = MLCommon::ceildiv(nrows, threads);
-  unsigned int *d_colstart = nullptr;
-  if (tempmem->d_colstart != nullptr) d_colstart = tempmem->d_colstart->data();
-
   if (split_algo == 0) {
+    unsigned int *d_colstart = nullptr;
+    if (tempmem->d_colstart != nullptr)
+      d_colstart = tempmem->d_colstart->data();
     get_minmax(data, flags, tempmem->d_colids->data(), d_colstart, nrows, Ncols,
                ncols_sampled, n_nodes, tempmem->max_nodes_minmax,
                tempmem->d_globalminmax->data(), tempmem->h_globalminmax->data(),
                tempmem->stream);
-    if ((n_nodes == node_batch_pred)) {
-      get_pred_kernel<T, MinMaxQues<T>>
-        <<<blocks, threads, shmempred, tempmem->stream>>>(
-          data, labels, flags, sample_cnt, tempmem->d_colids->data(),
-          d_colstart, nrows, Ncols, ncols_sampled, nbins, n_nodes,
-          tempmem->d_globalminmax->data(), d_predout, d_count);
-    } else {
-      get_pred_kernel_global<T, MinMaxQues<T>>
-        <<<blocks, threads, 0, tempmem->stream>>>(
-          data, labels, flags, sample_cnt, tempmem->d_colids->data(),
-          d_colstart, nrows, Ncols, ncols_sampled, nbins, n_nodes,
-          tempmem->d_globalminmax->data(), d_predout, d_count);
-    }
-    CUDA_CHECK(cudaGetLastError());
-    if ((n_nodes == node_batch_mse)) {
-      get_mse_kernel<T, F, MinMaxQues<T>>
-        <<<blocks, threads, shmemmse, tempmem->stream>>>(
-          data, labels, flags, sample_cnt, tempmem->d_colids->data(),
-          d_colstart, nrows, Ncols, ncols_sampled, nbins, n_nodes,
-          tempmem->d_globalminmax->data(), tempmem->d_parent_pred->data(),
-          tempmem->d_parent_count->data(), d_predout, d_count, d_mseout);
-    } else {
-      get_mse_kernel_global<T, F, MinMaxQues<T>>
-        <<<blocks, threads, 0, tempmem->stream>>>(
-          data, labels, flags, sample_cnt, tempmem->d_colids->data(),
-          d_colstart, nrows, Ncols, ncols_sampled, nbins, n_nodes,
-          tempmem->d_globalminmax->data(), tempmem->d_parent_pred->data(),
-          tempmem->d_parent_count->data(), d_predout, d_count, d_mseout);
-    }
-    CUDA_CHECK(cudaGetLastError());
-
+    launch_mse_kernels<T, F, MinMaxQues<T>>(
+      data, labels, flags, sample_cnt, nrows, Ncols, ncols_sampled, nbins,
+      n_nodes, tempmem->d_globalminmax->data(), tempmem, d_mseout, d_predout,
+      d_count);
+  } else if (tempmem->d_bins8 != nullptr) {
+    launch_mse_kernels<T, F, BinQues<T>>(
+      tempmem->d_bins8, labels, flags, sample_cnt, nrows, Ncols, ncols_sampled,
+      nbins, n_nodes, tempmem->d_quantile->data(), tempmem, d_mseout,
+      d_predout, d_count);
+  } else if (tempmem->d_bins16 != nullptr) {
+    launch_mse_kernels<T, F, BinQues<T>>(
+      tempmem->d_bins16, labels, flags, sample_cnt, nrows, Ncols,
+      ncols_sampled, nbins, n_nodes, tempmem->d_quantile->data(), tempmem,
+      d_mseout, d_predout, d_count);
   } else {
-    if ((n_nodes == node_batch_pred)) {
-      get_pred_kernel<T, QuantileQues<T>>
-        <<<blocks, threads, shmempred, tempmem->stream>>>(
-          data, labels, flags, sample_cnt, tempmem->d_colids->data(),
-          d_colstart, nrows, Ncols, ncols_sampled, nbins, n_nodes,
-          tempmem->d_quantile->data(), d_predout, d_count);
-    } else {
-      get_pred_kernel_global<T, QuantileQues<T>>
-        <<<blocks, threads, 0, tempmem->stream>>>(
-          data, labels, flags, sample_cnt, tempmem->d_colids->data(),
-          d_colstart, nrows, Ncols, ncols_sampled, nbins, n_nodes,
-          tempmem->d_quantile->data(), d_predout, d_count);
-    }
-    CUDA_CHECK(cudaGetLastError());
-    if ((n_nodes == node_batch_mse)) {
-      get_mse_kernel<T, F, QuantileQues<T>>
-        <<<blocks, threads, shmemmse, tempmem->stream>>>(
-          data, labels, flags, sample_cnt, tempmem->d_colids->data(),
-          d_colstart, nrows, Ncols, ncols_sampled, nbins, n_nodes,
-          tempmem->d_quantile->data(), tempmem->d_parent_pred->data(),
-          tempmem->d_parent_count->data(), d_predout, d_count, d_mseout);
-    } else {
-      get_mse_kernel_global<T, F, QuantileQues<T>>
-        <<<blocks, threads, 0, tempmem->stream>>>(
-          data, labels, flags, sample_cnt, tempmem->d_colids->data(),
-          d_colstart, nrows, Ncols, ncols_sampled, nbins, n_nodes,
-          tempmem->d_quantile->data(), tempmem->d_parent_pred->data(),
-          tempmem->d_parent_count->data(), d_predout, d_count, d_mseout);
-    }
-    CUDA_CHECK(cudaGetLastError());
+    launch_mse_kernels<T, F, QuantileQues<T>>(
+      data, labels, flags, sample_cnt, nrows, Ncols, ncols_sampled, nbins,
+      n_nodes, tempmem->d_quantile->data(), tempmem, d_mseout, d_predout,
+      d_count);
   }
 }
 template <typename T>
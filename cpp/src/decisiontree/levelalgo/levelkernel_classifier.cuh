@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 #pragma once
+#include <cuml/tree/flatnode.h>
 #include "common_kernel.cuh"
 #include "cub/cub.cuh"
 
@@ -42,17 +43,17 @@ __global__ void sample_count_histogram_kernel(
   return;
 }
 
-//This kernel does histograms for all bins, all cols and all nodes at a given level
-template <typename T, typename QuestionType>
-__global__ void get_hist_kernel(
-  const T* __restrict__ data, const int* __restrict__ labels,
+//This computes histograms for all bins, all cols and all nodes at a given level
+template <typename T, typename QuestionType, typename D = T>
+DI void get_hist_block(
+  const D* __restrict__ data, const int* __restrict__ labels,
   const unsigned int* __restrict__ flags,
   const unsigned int* __restrict__ sample_cnt,
   const unsigned int* __restrict__ colids,
   const unsigned int* __restrict__ colstart, const int nrows, const int Ncols,
   const int ncols_sampled, const int n_unique_labels, const int nbins,
   const int n_nodes, const T* __restrict__ question_ptr,
-  unsigned int* histout) {
+  const int* __restrict__ hist_parent, unsigned int* histout) {
   extern __shared__ unsigned int shmemhist[];
   unsigned int local_flag = LEAF;
   int local_label = -1;
@@ -63,6 +64,11 @@ __global__ void get_hist_kernel(
   if (tid < nrows) {
     local_flag = flags[tid];
   }
+  //Skip the rows of the nodes derived by subtract_hist_kernel
+  if (local_flag != LEAF && hist_parent != nullptr &&
+      hist_parent[local_flag] != -1) {
+    local_flag = LEAF;
+  }
   if (local_flag != LEAF) {
     local_label = labels[tid];
     local_cnt = sample_cnt[tid];
@@ -81,7 +87,7 @@ __global__ void get_hist_kernel(
 
     //Check if leaf
     if (local_flag != LEAF) {
-      T local_data = data[tid + colid * nrows];
+      D local_data = data[tid + colid * nrows];
       QuestionType question(question_ptr, colid, colcnt, n_nodes, local_flag,
                             nbins);
 #pragma unroll(8)
@@ -104,26 +110,31 @@ __global__ void get_hist_kernel(
   }
 }
 
-/*This kernel does histograms for all bins, all cols and all nodes at a given level
+/*This computes histograms for all bins, all cols and all nodes at a given level
  *when nodes cannot fit in shared memory. We use direct global atomics;
  *as this will be faster than shared memory loop due to reduced conjetion for atomics
  */
-template <typename T, typename QuestionType>
-__global__ void get_hist_kernel_global(
-  const T* __restrict__ data, const int* __restrict__ labels,
+template <typename T, typename QuestionType, typename D = T>
+DI void get_hist_block_global(
+  const D* __restrict__ data, const int* __restrict__ labels,
   const unsigned int* __restrict__ flags,
   const unsigned int* __restrict__ sample_cnt,
   const unsigned int* __restrict__ colids,
   const unsigned int* __restrict__ colstart, const int nrows, const int Ncols,
   const int ncols_sampled, const int n_unique_labels, const int nbins,
   const int n_nodes, const T* __restrict__ question_ptr,
-  unsigned int* histout) {
+  const int* __restrict__ hist_parent, unsigned int* histout) {
   unsigned int local_flag;
   int local_label;
   int local_cnt;
   int threadid = threadIdx.x + blockIdx.x * blockDim.x;
   for (int tid = threadid; tid < nrows; tid += gridDim.x * blockDim.x) {
     local_flag = flags[tid];
+    //Skip the rows of the nodes derived by subtract_hist_kernel
+    if (local_flag != LEAF && hist_parent != nullptr &&
+        hist_parent[local_flag] != -1) {
+      local_flag = LEAF;
+    }
     if (local_flag != LEAF) {
       local_label = labels[tid];
       local_cnt = sample_cnt[tid];
@@ -133,7 +144,7 @@ __global__ void get_hist_kernel_global(
       for (unsigned int colcnt = 0; colcnt < ncols_sampled; colcnt++) {
         unsigned int colid = get_column_id(colids, colstart_local, Ncols,
                                            ncols_sampled, colcnt, local_flag);
-        T local_data = data[tid + colid * nrows];
+        D local_data = data[tid + colid * nrows];
         //Loop over nbins
         QuestionType question(question_ptr, colid, colcnt, n_nodes, local_flag,
                               nbins);
@@ -153,6 +164,199 @@ __global__ void get_hist_kernel_global(
   }
 }
 
+template <typename T, typename QuestionType, typename D = T>
+__global__ void get_hist_kernel(
+  const D* __restrict__ data, const int* __restrict__ labels,
+  const unsigned int* __restrict__ flags,
+  const unsigned int* __restrict__ sample_cnt,
+  const unsigned int* __restrict__ colids,
+  const unsigned int* __restrict__ colstart, const int nrows, const int Ncols,
+  const int ncols_sampled, const int n_unique_labels, const int nbins,
+  const int n_nodes, const T* __restrict__ question_ptr,
+  const int* __restrict__ hist_parent, unsigned int* histout) {
+  get_hist_block<T, QuestionType, D>(
+    data, labels, flags, sample_cnt, colids, colstart, nrows, Ncols,
+    ncols_sampled, n_unique_labels, nbins, n_nodes, question_ptr, hist_parent,
+    histout);
+}
+
+template <typename T, typename QuestionType, typename D = T>
+__global__ void get_hist_kernel_global(
+  const D* __restrict__ data, const int* __restrict__ labels,
+  const unsigned int* __restrict__ flags,
+  const unsigned int* __restrict__ sample_cnt,
+  const unsigned int* __restrict__ colids,
+  const unsigned int* __restrict__ colstart, const int nrows, const int Ncols,
+  const int ncols_sampled, const int n_unique_labels, const int nbins,
+  const int n_nodes, const T* __restrict__ question_ptr,
+  const int* __restrict__ hist_parent, unsigned int* histout) {
+  get_hist_block_global<T, QuestionType, D>(
+    data, labels, flags, sample_cnt, colids, colstart, nrows, Ncols,
+    ncols_sampled, n_unique_labels, nbins, n_nodes, question_ptr, hist_parent,
+    histout);
+}
+
+//Per tree arguments of the batched histogram kernels
+template <typename T>
+struct HistBatchArgs {
+  const unsigned int* flags;
+  const unsigned int* sample_cnt;
+  const unsigned int* colids;
+  const unsigned int* colstart;
+  const T* question_ptr;
+  const int* hist_parent;
+  unsigned int* histout;
+  int n_nodes;
+};
+
+/*These kernels do the histograms of the current level of several trees
+ *grown in lock-step in one launch; blockIdx.y is the tree.
+ */
+template <typename T, typename QuestionType, typename D = T>
+__global__ void get_hist_kernel_batched(const D* __restrict__ data,
+                                        const int* __restrict__ labels,
+                                        const HistBatchArgs<T>* batch,
+                                        const int nrows, const int Ncols,
+                                        const int ncols_sampled,
+                                        const int n_unique_labels,
+                                        const int nbins) {
+  const HistBatchArgs<T> args = batch[blockIdx.y];
+  get_hist_block<T, QuestionType, D>(
+    data, labels, args.flags, args.sample_cnt, args.colids, args.colstart,
+    nrows, Ncols, ncols_sampled, n_unique_labels, nbins, args.n_nodes,
+    args.question_ptr, args.hist_parent, args.histout);
+}
+
+template <typename T, typename QuestionType, typename D = T>
+__global__ void get_hist_kernel_global_batched(
+  const D* __restrict__ data, const int* __restrict__ labels,
+  const HistBatchArgs<T>* batch, const int nrows, const int Ncols,
+  const int ncols_sampled, const int n_unique_labels, const int nbins) {
+  const HistBatchArgs<T> args = batch[blockIdx.y];
+  get_hist_block_global<T, QuestionType, D>(
+    data, labels, args.flags, args.sample_cnt, args.colids, args.colstart,
+    nrows, Ncols, ncols_sampled, n_unique_labels, nbins, args.n_nodes,
+    args.question_ptr, args.hist_parent, args.histout);
+}
+
+/*This kernel derives the histogram of each node with hist_parent[node] != -1
+ *as the histogram of that node of the previous level (prev_hist, with
+ *n_prev_nodes nodes) minus the histogram of its sibling.
+ */
+__global__ void subtract_hist_kernel(const unsigned int* __restrict__ prev_hist,
+                                     const int* __restrict__ hist_parent,
+                                     const int ncols_sampled,
+                                     const int n_unique_labels, const int nbins,
+                                     const int n_nodes, const int n_prev_nodes,
+                                     unsigned int* hist) {
+  int nodelen = nbins * n_unique_labels;
+  size_t len = (size_t)ncols_sampled * n_nodes * nodelen;
+  for (size_t i = threadIdx.x + (size_t)blockIdx.x * blockDim.x; i < len;
+       i += (size_t)blockDim.x * gridDim.x) {
+    int node = (i / nodelen) % n_nodes;
+    int parent = hist_parent[node];
+    if (parent == -1) continue;
+    size_t colcnt = i / ((size_t)nodelen * n_nodes);
+    int binlabel = i % nodelen;
+    hist[i] = prev_hist[(colcnt * n_prev_nodes + parent) * nodelen + binlabel] -
+              hist[(colcnt * n_nodes + (node ^ 1)) * nodelen + binlabel];
+  }
+}
+
+//Label counts of the nodes of a level, for the histograms of CSC data
+__global__ void node_count_kernel(const int* __restrict__ labels,
+                                  const unsigned int* __restrict__ flags,
+                                  const unsigned int* __restrict__ sample_cnt,
+                                  const int nrows, const int n_unique_labels,
+                                  unsigned int* nodecnt) {
+  int threadid = threadIdx.x + blockIdx.x * blockDim.x;
+  for (int tid = threadid; tid < nrows; tid += gridDim.x * blockDim.x) {
+    unsigned int local_flag = flags[tid];
+    if (local_flag != LEAF) {
+      atomicAdd(&nodecnt[local_flag * n_unique_labels + labels[tid]],
+                sample_cnt[tid]);
+    }
+  }
+}
+
+/*Histograms of CSC data, first as if all the values were zero: the count
+ *of every bin whose question is not below zero is the node label count.
+ *get_hist_kernel_csc then corrects them for the nonzeros.
+ */
+template <typename T>
+__global__ void get_hist_init_kernel_csc(
+  const unsigned int* __restrict__ nodecnt, const T* __restrict__ question_ptr,
+  const unsigned int* __restrict__ colids,
+  const unsigned int* __restrict__ colstart, const int Ncols,
+  const int ncols_sampled, const int n_unique_labels, const int nbins,
+  const int n_nodes, const int* __restrict__ hist_parent,
+  unsigned int* histout) {
+  int nodelen = nbins * n_unique_labels;
+  size_t len = (size_t)ncols_sampled * n_nodes * nodelen;
+  for (size_t i = threadIdx.x + (size_t)blockIdx.x * blockDim.x; i < len;
+       i += (size_t)blockDim.x * gridDim.x) {
+    int node = (i / nodelen) % n_nodes;
+    if (hist_parent != nullptr && hist_parent[node] != -1) continue;
+    int colcnt = i / ((size_t)nodelen * n_nodes);
+    int binid = (i % nodelen) / n_unique_labels;
+    int label = i % n_unique_labels;
+    unsigned int colid =
+      get_column_id(colids, colstart[node], Ncols, ncols_sampled, colcnt, node);
+    QuantileQues<T> question(question_ptr, colid, colcnt, n_nodes, node,
+                             nbins);
+    histout[i] =
+      (T(0) <= question(binid)) ? nodecnt[node * n_unique_labels + label] : 0;
+  }
+}
+
+/*Adds the nonzeros of CSC data to the histograms set by
+ *get_hist_init_kernel_csc, one thread per nonzero: blockIdx.y strides over
+ *the columns of colids, whose position relative to colstart of the node of
+ *the row is the sampled column.
+ */
+template <typename T>
+__global__ void get_hist_kernel_csc(
+  const int* __restrict__ csc_ind, const int* __restrict__ csc_rows,
+  const T* __restrict__ csc_vals, const int nnz,
+  const int* __restrict__ labels, const unsigned int* __restrict__ flags,
+  const unsigned int* __restrict__ sample_cnt,
+  const unsigned int* __restrict__ colids,
+  const unsigned int* __restrict__ colstart, const int Ncols,
+  const int ncols_sampled, const int n_unique_labels, const int nbins,
+  const int n_nodes, const T* __restrict__ question_ptr,
+  const int* __restrict__ hist_parent, unsigned int* histout) {
+  for (int pos = blockIdx.y; pos < Ncols; pos += gridDim.y) {
+    unsigned int colid = colids[pos];
+    int start = csc_ind[colid];
+    int stop = (colid < Ncols - 1) ? csc_ind[colid + 1] : nnz;
+    for (int j = start + threadIdx.x + blockIdx.x * blockDim.x; j < stop;
+         j += blockDim.x * gridDim.x) {
+      int row = csc_rows[j];
+      unsigned int local_flag = flags[row];
+      if (local_flag == LEAF) continue;
+      if (hist_parent != nullptr && hist_parent[local_flag] != -1) continue;
+      int colcnt = (pos - (int)colstart[local_flag] + Ncols) % Ncols;
+      if (colcnt >= ncols_sampled) continue;
+      T local_data = csc_vals[j];
+      unsigned int local_cnt = sample_cnt[row];
+      QuantileQues<T> question(question_ptr, colid, colcnt, n_nodes,
+                               local_flag, nbins);
+      size_t nodeoff =
+        ((size_t)colcnt * n_nodes + local_flag) * nbins * n_unique_labels;
+      unsigned int* nodehist = histout + nodeoff + labels[row];
+      for (int binid = 0; binid < nbins; binid++) {
+        bool below = local_data <= question(binid);
+        bool zero_below = T(0) <= question(binid);
+        //Unsigned wrap-around subtracts the count added for a zero
+        if (below != zero_below) {
+          atomicAdd(&nodehist[binid * n_unique_labels],
+                    below ? local_cnt : 0u - local_cnt);
+        }
+      }
+    }
+  }
+}
+
 struct GiniDevFunctor {
   static DI float exec(unsigned int* hist, int nrows, int n_unique_labels) {
     float gval = 1.0;
@@ -177,7 +381,6 @@ struct EntropyDevFunctor {
   }
 };
 //This is device equialent of best split finding reduction.
-//Only kicks in when number of node is more than 512. otherwise we use CPU.
 template <typename T, typename F>
 __global__ void get_best_split_classification_kernel(
   const unsigned int* __restrict__ hist,
@@ -289,3 +492,131 @@ __global__ void get_best_split_classification_kernel(
     }
   }
 }
+
+//Most frequent label of a node histogram, the first one on ties
+DI int get_class_device(const unsigned int* __restrict__ hist,
+                        const int n_unique_labels) {
+  unsigned int maxval = hist[0];
+  int classval = 0;
+  for (int i = 1; i < n_unique_labels; i++) {
+    if (hist[i] > maxval) {
+      maxval = hist[i];
+      classval = i;
+    }
+  }
+  return classval;
+}
+
+//For each pair of siblings of the level, the one whose histogram is
+//derived from the one of its parent (nodelist[node] / 2 in the previous
+//level) is the one with more rows; the other one has hist_parent -1.
+__global__ void hist_parent_kernel(const unsigned int* __restrict__ level_hist,
+                                   const int* __restrict__ nodelist,
+                                   const int n_nodes, const int n_unique_labels,
+                                   int* hist_parent) {
+  int node = 2 * (threadIdx.x + blockIdx.x * blockDim.x);
+  if (node >= n_nodes) return;
+  unsigned int lrows = 0, rrows = 0;
+  for (int j = 0; j < n_unique_labels; j++) {
+    lrows += level_hist[node * n_unique_labels + j];
+    rrows += level_hist[(node + 1) * n_unique_labels + j];
+  }
+  int parent = nodelist[node] / 2;
+  hist_parent[node] = (lrows >= rrows) ? parent : -1;
+  hist_parent[node + 1] = (lrows >= rrows) ? -1 : parent;
+}
+
+//A node of the level is split if its info gain is above
+//min_impurity_decrease, unless the whole level is leafed out.
+__global__ void split_flags_kernel(const float* __restrict__ gain,
+                                   const int n_nodes,
+                                   const float min_impurity_decrease,
+                                   const bool leaf_level,
+                                   unsigned int* split_flags) {
+  int node = threadIdx.x + blockIdx.x * blockDim.x;
+  if (node >= n_nodes) return;
+  split_flags[node] = (!leaf_level && gain[node] > min_impurity_decrease);
+}
+
+/*This kernel builds the nodes of a level in the sparse tree. Node i of the
+ *level, at sparsesize + nodelist[i], is either leafed out or split on its
+ *best split, and gets its two children at sparsetree_sz + 2 * i.
+ *On entry new_node_flags holds the exclusive sum of split_flags, i.e. the
+ *rank of each split node among the split nodes of the level; it is set to
+ *LEAF for the leaves. The histograms, metrics and sparse ids (2 * i + side)
+ *of the children of the split node of rank f go at 2 * f + side of the
+ *next level buffers, and n_split receives the number of split nodes.
+ */
+template <typename T>
+__global__ void make_level_nodes_kernel(
+  const unsigned int* __restrict__ split_flags,
+  const int* __restrict__ split_colidx, const int* __restrict__ split_binidx,
+  const unsigned int* __restrict__ colids,
+  const unsigned int* __restrict__ colstart, const T* __restrict__ quantile,
+  const T* __restrict__ minmax, const int Ncols, const int ncols_sampled,
+  const int nbins, const int n_nodes, const int n_unique_labels,
+  const int* __restrict__ nodelist, const unsigned int* __restrict__ level_hist,
+  const unsigned int* __restrict__ child_hist,
+  const T* __restrict__ child_metric, const int sparsesize,
+  const int sparsetree_sz, unsigned int* new_node_flags,
+  SparseTreeNode<T, int>* sparsetree, int* next_nodelist,
+  unsigned int* next_level_hist, T* next_level_metric, int* n_split) {
+  int i = threadIdx.x + blockIdx.x * blockDim.x;
+  if (i >= n_nodes) return;
+  unsigned int split = split_flags[i];
+  unsigned int rank = new_node_flags[i];
+  if (i == n_nodes - 1) *n_split = rank + split;
+
+  SparseTreeNode<T, int>& node = sparsetree[sparsesize + nodelist[i]];
+  node.left_child_id = sparsetree_sz + 2 * i;
+  for (int side = 0; side < 2; side++) {
+    SparseTreeNode<T, int>& child = sparsetree[sparsetree_sz + 2 * i + side];
+    child.prediction = 0;
+    child.colid = -1;
+    child.quesval = 0;
+    child.best_metric_val = split ? child_metric[2 * i + side] : T(0);
+    child.left_child_id = -1;
+  }
+  if (!split) {
+    new_node_flags[i] = LEAF;
+    node.colid = -1;
+    node.prediction =
+      get_class_device(&level_hist[i * n_unique_labels], n_unique_labels);
+    return;
+  }
+
+  int colidx = split_colidx[i];
+  int binidx = split_binidx[i];
+  int colstart_local = (colstart != nullptr) ? colstart[i] : -1;
+  unsigned int col =
+    get_column_id(colids, colstart_local, Ncols, ncols_sampled, colidx, i);
+  node.colid = col;
+  if (minmax != nullptr) {
+    T min = minmax[i + colidx * n_nodes * 2];
+    T delta = (minmax[i + n_nodes + colidx * n_nodes * 2] - min) / nbins;
+    node.quesval = min + delta * (binidx + 1);
+  } else {
+    node.quesval = quantile[col * nbins + binidx];
+  }
+  for (int side = 0; side < 2; side++) {
+    int next = 2 * rank + side;
+    next_nodelist[next] = 2 * i + side;
+    next_level_metric[next] = child_metric[2 * i + side];
+    for (int j = 0; j < n_unique_labels; j++) {
+      next_level_hist[next * n_unique_labels + j] =
+        child_hist[(2 * i + side) * n_unique_labels + j];
+    }
+  }
+}
+
+//Sets the predictions of n_leaves consecutive nodes from their histograms
+template <typename T>
+__global__ void leaf_predictions_kernel(const unsigned int* __restrict__ hist,
+                                        const int n_leaves,
+                                        const int n_unique_labels,
+                                        SparseTreeNode<T, int>* nodes) {
+  int i = threadIdx.x + blockIdx.x * blockDim.x;
+  if (i >= n_leaves) return;
+  nodes[i].prediction =
+    get_class_device(&hist[i * n_unique_labels], n_unique_labels);
+}
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "common_kernel.cuh"
+#include "cub/cub.cuh"
+
+//Gradient and hessian sums and row counts of the nodes of a level
+template <typename T>
+__global__ void node_gh_kernel(const T *__restrict__ grad,
+                               const T *__restrict__ hess,
+                               const unsigned int *__restrict__ flags,
+                               const unsigned int *__restrict__ sample_cnt,
+                               const int nrows, T *node_grad, T *node_hess,
+                               unsigned int *node_count) {
+  for (int tid = threadIdx.x + blockIdx.x * blockDim.x; tid < nrows;
+       tid += blockDim.x * gridDim.x) {
+    unsigned int local_flag = flags[tid];
+    if (local_flag == LEAF) continue;
+    unsigned int local_cnt = sample_cnt[tid];
+    atomicAdd(&node_grad[local_flag], grad[tid] * local_cnt);
+    atomicAdd(&node_hess[local_flag], hess[tid] * local_cnt);
+    atomicAdd(&node_count[local_flag], local_cnt);
+  }
+}
+
+//This kernel computes, like get_pred_kernel, the gradient and hessian sums
+//and the row counts left of each bin, for all cols and all nodes of a level
+template <typename T, typename QuestionType, typename D = T>
+__global__ void get_gh_kernel(
+  const D *__restrict__ data, const T *__restrict__ grad,
+  const T *__restrict__ hess, const unsigned int *__restrict__ flags,
+  const unsigned int *__restrict__ sample_cnt,
+  const unsigned int *__restrict__ colids,
+  const unsigned int *__restrict__ colstart, const int nrows, const int Ncols,
+  const int ncols_sampled, const int nbins, const int n_nodes,
+  const T *__restrict__ question_ptr, T *gradout, T *hessout,
+  unsigned int *countout) {
+  extern __shared__ char shmem_gh_kernel[];
+  T *shmemgrad = (T *)shmem_gh_kernel;
+  T *shmemhess = (T *)(&shmem_gh_kernel[nbins * n_nodes * sizeof(T)]);
+  unsigned int *shmemcount =
+    (unsigned int *)(&shmem_gh_kernel[2 * nbins * n_nodes * sizeof(T)]);
+  unsigned int local_flag = LEAF;
+  T local_grad, local_hess;
+  int local_cnt;
+  int colstart_local = -1;
+  int tid = threadIdx.x + blockIdx.x * blockDim.x;
+  unsigned int colid;
+  if (tid < nrows) {
+    local_flag = flags[tid];
+  }
+  if (local_flag != LEAF) {
+    local_cnt = sample_cnt[tid];
+    local_grad = grad[tid] * local_cnt;
+    local_hess = hess[tid] * local_cnt;
+    if (colstart != nullptr) colstart_local = colstart[local_flag];
+  }
+  for (unsigned int colcnt = 0; colcnt < ncols_sampled; colcnt++) {
+    if (local_flag != LEAF) {
+      colid = get_column_id(colids, colstart_local, Ncols, ncols_sampled,
+                            colcnt, local_flag);
+    }
+    for (unsigned int i = threadIdx.x; i < nbins * n_nodes; i += blockDim.x) {
+      shmemgrad[i] = (T)0;
+      shmemhess[i] = (T)0;
+      shmemcount[i] = 0;
+    }
+    __syncthreads();
+
+    //Check if leaf
+    if (local_flag != LEAF) {
+      D local_data = data[tid + colid * nrows];
+      QuestionType question(question_ptr, colid, colcnt, n_nodes, local_flag,
+                            nbins);
+
+#pragma unroll(8)
+      for (unsigned int binid = 0; binid < nbins; binid++) {
+        if (local_data <= question(binid)) {
+          unsigned int nodeoff = local_flag * nbins;
+          atomicAdd(&shmemgrad[nodeoff + binid], local_grad);
+          atomicAdd(&shmemhess[nodeoff + binid], local_hess);
+          atomicAdd(&shmemcount[nodeoff + binid], local_cnt);
+        }
+      }
+    }
+
+    __syncthreads();
+    for (unsigned int i = threadIdx.x; i < nbins * n_nodes; i += blockDim.x) {
+      unsigned int offset = colcnt * nbins * n_nodes;
+      atomicAdd(&gradout[offset + i], shmemgrad[i]);
+      atomicAdd(&hessout[offset + i], shmemhess[i]);
+      atomicAdd(&countout[offset + i], shmemcount[i]);
+    }
+    __syncthreads();
+  }
+}
+
+//Same as get_gh_kernel, when the nodes do not fit in shared memory
+template <typename T, typename QuestionType, typename D = T>
+__global__ void get_gh_kernel_global(
+  const D *__restrict__ data, const T *__restrict__ grad,
+  const T *__restrict__ hess, const unsigned int *__restrict__ flags,
+  const unsigned int *__restrict__ sample_cnt,
+  const unsigned int *__restrict__ colids,
+  const unsigned int *__restrict__ colstart, const int nrows, const int Ncols,
+  const int ncols_sampled, const int nbins, const int n_nodes,
+  const T *__restrict__ question_ptr, T *gradout, T *hessout,
+  unsigned int *countout) {
+  int threadid = threadIdx.x + blockIdx.x * blockDim.x;
+  for (int tid = threadid; tid < nrows; tid += blockDim.x * gridDim.x) {
+    unsigned int local_flag = flags[tid];
+    //Check if leaf
+    if (local_flag == LEAF) continue;
+    int local_cnt = sample_cnt[tid];
+    T local_grad = grad[tid] * local_cnt;
+    T local_hess = hess[tid] * local_cnt;
+    int colstart_local = -1;
+    if (colstart != nullptr) colstart_local = colstart[local_flag];
+
+    for (unsigned int colcnt = 0; colcnt < ncols_sampled; colcnt++) {
+      unsigned int colid = get_column_id(colids, colstart_local, Ncols,
+                                         ncols_sampled, colcnt, local_flag);
+      unsigned int offset = colcnt * nbins * n_nodes + local_flag * nbins;
+      D local_data = data[tid + colid * nrows];
+      QuestionType question(question_ptr, colid, colcnt, n_nodes, local_flag,
+                            nbins);
+
+#pragma unroll(8)
+      for (unsigned int binid = 0; binid < nbins; binid++) {
+        if (local_data <= question(binid)) {
+          atomicAdd(&gradout[offset + binid], local_grad);
+          atomicAdd(&hessout[offset + binid], local_hess);
+          atomicAdd(&countout[offset + binid], local_cnt);
+        }
+      }
+    }
+  }
+}
+
+//Second order gain of splitting sums G, H into (GL, HL) and (G - GL, H - HL)
+template <typename T>
+DI T gbdt_split_gain(const T G, const T H, const T GL, const T HL,
+                     const float lambda) {
+  T GR = G - GL;
+  T HR = H - HL;
+  return (T)0.5 *
+         (GL * GL / (HL + lambda) + GR * GR / (HR + lambda) -
+          G * G / (H + lambda));
+}
+
+//Best split of each node of a level on the second order gain, with at least
+//min_child_weight hessian sum on each side.
+template <typename T>
+__global__ void get_best_split_gbdt_kernel(
+  const T *__restrict__ gradout, const T *__restrict__ hessout,
+  const unsigned int *__restrict__ countout,
+  const T *__restrict__ node_grad, const T *__restrict__ node_hess,
+  const unsigned int *__restrict__ node_count, const int nbins,
+  const int ncols_sampled, const int n_nodes, const int min_rpn,
+  const float lambda, const float min_child_weight, float *outgain,
+  int *best_col_id, int *best_bin_id) {
+  typedef cub::BlockReduce<GainIdxPair, 64> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+
+  for (unsigned int nodeid = blockIdx.x; nodeid < n_nodes;
+       nodeid += gridDim.x) {
+    T G = node_grad[nodeid];
+    T H = node_hess[nodeid];
+    unsigned int parent_count = node_count[nodeid];
+    int nodeoffset = nodeid * nbins;
+    GainIdxPair tid_pair;
+    tid_pair.gain = 0.0;
+    tid_pair.idx = -1;
+    for (int id = threadIdx.x; id < nbins * ncols_sampled; id += blockDim.x) {
+      int coloffset = ((int)(id / nbins)) * nbins * n_nodes;
+      int threadoffset = coloffset + (id % nbins) + nodeoffset;
+      unsigned int tmp_lnrows = countout[threadoffset];
+      unsigned int tmp_rnrows = parent_count - tmp_lnrows;
+      if (tmp_lnrows == 0 || tmp_rnrows == 0 || parent_count < min_rpn)
+        continue;
+      T HL = hessout[threadoffset];
+      if (HL < min_child_weight || H - HL < min_child_weight) continue;
+      float gain =
+        (float)gbdt_split_gain(G, H, gradout[threadoffset], HL, lambda);
+      if (gain > tid_pair.gain) {
+        tid_pair.gain = gain;
+        tid_pair.idx = id;
+      }
+    }
+    __syncthreads();
+    GainIdxPair ans =
+      BlockReduce(temp_storage).Reduce(tid_pair, ReducePair<cub::Max>());
+
+    if (threadIdx.x == 0) {
+      outgain[nodeid] = (ans.idx != -1) ? ans.gain : 0.0f;
+      best_col_id[nodeid] = (ans.idx != -1) ? (int)(ans.idx / nbins) : 0;
+      best_bin_id[nodeid] = (ans.idx != -1) ? ans.idx % nbins : 0;
+    }
+  }
+}
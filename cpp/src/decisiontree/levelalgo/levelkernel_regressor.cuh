@@ -72,9 +72,9 @@ __global__ void mse_kernel_level(const T *__restrict__ labels,
   return;
 }
 //This kernel computes predictions and count for all colls, all bins and all nodes at a given level
-template <typename T, typename QuestionType>
+template <typename T, typename QuestionType, typename D = T>
 __global__ void get_pred_kernel(
-  const T *__restrict__ data, const T *__restrict__ labels,
+  const D *__restrict__ data, const T *__restrict__ labels,
   const unsigned int *__restrict__ flags,
   const unsigned int *__restrict__ sample_cnt,
   const unsigned int *__restrict__ colids,
@@ -112,7 +112,7 @@ __global__ void get_pred_kernel(
 
     //Check if leaf
     if (local_flag != LEAF) {
-      T local_data = data[tid + colid * nrows];
+      D local_data = data[tid + colid * nrows];
       QuestionType question(question_ptr, colid, colcnt, n_nodes, local_flag,
                             nbins);
 
@@ -137,9 +137,9 @@ __global__ void get_pred_kernel(
 }
 
 //This kernel computes mse/mae for all colls, all bins and all nodes at a given level
-template <typename T, typename F, typename QuestionType>
+template <typename T, typename F, typename QuestionType, typename D = T>
 __global__ void get_mse_kernel(
-  const T *__restrict__ data, const T *__restrict__ labels,
+  const D *__restrict__ data, const T *__restrict__ labels,
   const unsigned int *__restrict__ flags,
   const unsigned int *__restrict__ sample_cnt,
   const unsigned int *__restrict__ colids,
@@ -193,7 +193,7 @@ __global__ void get_mse_kernel(
 
     //Check if leaf
     if (local_flag != LEAF) {
-      T local_data = data[tid + colid * nrows];
+      D local_data = data[tid + colid * nrows];
       QuestionType question(question_ptr, colid, colcnt, n_nodes, local_flag,
                             nbins);
 
@@ -226,9 +226,9 @@ __global__ void get_mse_kernel(
 
 //This kernel computes predictions and count for all colls, all bins and all nodes at a given level
 //This is when nodes dont fit anymore in shared memory.
-template <typename T, typename QuestionType>
+template <typename T, typename QuestionType, typename D = T>
 __global__ void get_pred_kernel_global(
-  const T *__restrict__ data, const T *__restrict__ labels,
+  const D *__restrict__ data, const T *__restrict__ labels,
   const unsigned int *__restrict__ flags,
   const unsigned int *__restrict__ sample_cnt,
   const unsigned int *__restrict__ colids,
@@ -252,7 +252,7 @@ __global__ void get_pred_kernel_global(
         unsigned int colid = get_column_id(colids, colstart_local, Ncols,
                                            ncols_sampled, colcnt, local_flag);
         unsigned int coloffset = colcnt * nbins * n_nodes;
-        T local_data = data[tid + colid * nrows];
+        D local_data = data[tid + colid * nrows];
         QuestionType question(question_ptr, colid, colcnt, n_nodes, local_flag,
                               nbins);
 
@@ -272,9 +272,9 @@ __global__ void get_pred_kernel_global(
 
 //This kernel computes mse/mae for all colls, all bins and all nodes at a given level
 // This is when nodes dont fit in shared memory
-template <typename T, typename F, typename QuestionType>
+template <typename T, typename F, typename QuestionType, typename D = T>
 __global__ void get_mse_kernel_global(
-  const T *__restrict__ data, const T *__restrict__ labels,
+  const D *__restrict__ data, const T *__restrict__ labels,
   const unsigned int *__restrict__ flags,
   const unsigned int *__restrict__ sample_cnt,
   const unsigned int *__restrict__ colids,
@@ -304,7 +304,7 @@ __global__ void get_mse_kernel_global(
         unsigned int colid = get_column_id(colids, colstart_local, Ncols,
                                            ncols_sampled, colcnt, local_flag);
         unsigned int coloff = colcnt * nbins * n_nodes;
-        T local_data = data[tid + colid * nrows];
+        D local_data = data[tid + colid * nrows];
         QuestionType question(question_ptr, colid, colcnt, n_nodes, local_flag,
                               nbins);
 
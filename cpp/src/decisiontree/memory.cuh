@@ -18,6 +18,7 @@
 #include <thrust/extrema.h>
 #include <utils.h>
 #include "cub/cub.cuh"
+#include "cuda_utils.h"
 #include "memory.h"
 
 template <class T, class L>
@@ -25,7 +26,8 @@ TemporaryMemory<T, L>::TemporaryMemory(
   const std::shared_ptr<MLCommon::deviceAllocator> device_allocator_in,
   const std::shared_ptr<MLCommon::hostAllocator> host_allocator_in,
   const cudaStream_t stream_in, int N, int Ncols, float colper, int n_unique,
-  int n_bins, const int split_algo, int depth, bool col_shuffle) {
+  int n_bins, const int split_algo, int depth, bool col_shuffle,
+  std::shared_ptr<TreeWorkspace> workspace_in) {
   stream = stream_in;
   splitalgo = split_algo;
 
@@ -33,6 +35,7 @@ TemporaryMemory<T, L>::TemporaryMemory(
   num_sms = MLCommon::getMultiProcessorCount();
   device_allocator = device_allocator_in;
   host_allocator = host_allocator_in;
+  workspace = workspace_in;
   LevelMemAllocator(N, Ncols, colper, n_unique, n_bins, depth, split_algo,
                     col_shuffle);
 }
@@ -42,7 +45,9 @@ TemporaryMemory<T, L>::TemporaryMemory(const ML::cumlHandle_impl& handle,
                                        cudaStream_t stream_in, int N, int Ncols,
                                        float colper, int n_unique, int n_bins,
                                        const int split_algo, int depth,
-                                       bool col_shuffle) {
+                                       bool col_shuffle,
+                                       std::shared_ptr<TreeWorkspace>
+                                         workspace_in) {
   //Assign Stream from cumlHandle
   stream = stream_in;
   splitalgo = split_algo;
@@ -51,6 +56,7 @@ TemporaryMemory<T, L>::TemporaryMemory(const ML::cumlHandle_impl& handle,
   num_sms = MLCommon::getMultiProcessorCount();
   device_allocator = handle.getDeviceAllocator();
   host_allocator = handle.getHostAllocator();
+  workspace = workspace_in;
   LevelMemAllocator(N, Ncols, colper, n_unique, n_bins, depth, split_algo,
                     col_shuffle);
 }
@@ -58,6 +64,7 @@ TemporaryMemory<T, L>::TemporaryMemory(const ML::cumlHandle_impl& handle,
 template <class T, class L>
 TemporaryMemory<T, L>::~TemporaryMemory() {
   LevelMemCleaner();
+  StreamingMemCleaner();
 }
 
 template <class T, class L>
@@ -71,7 +78,9 @@ void TemporaryMemory<T, L>::LevelMemAllocator(int nrows, int ncols,
                                               float colper, int n_unique,
                                               int nbins, int depth,
                                               const int split_algo,
-                                              bool col_shuffle) {
+                                              bool col_shuffle,
+                                       std::shared_ptr<TreeWorkspace>
+                                         workspace_in) {
   if (depth > 20 || (depth == -1)) {
     max_nodes_per_level = pow(2, 20);
   } else {
@@ -79,62 +88,38 @@ void TemporaryMemory<T, L>::LevelMemAllocator(int nrows, int ncols,
   }
   int maxnodes = max_nodes_per_level;
   int ncols_sampled = (int)(ncols * colper);
-  d_flags =
-    new MLCommon::device_buffer<unsigned int>(device_allocator, stream, nrows);
-  h_split_colidx =
-    new MLCommon::host_buffer<int>(host_allocator, stream, maxnodes);
-  h_split_binidx =
-    new MLCommon::host_buffer<int>(host_allocator, stream, maxnodes);
-  d_split_colidx =
-    new MLCommon::device_buffer<int>(device_allocator, stream, maxnodes);
-  d_split_binidx =
-    new MLCommon::device_buffer<int>(device_allocator, stream, maxnodes);
-  h_new_node_flags =
-    new MLCommon::host_buffer<unsigned int>(host_allocator, stream, maxnodes);
-  d_new_node_flags = new MLCommon::device_buffer<unsigned int>(
-    device_allocator, stream, maxnodes);
-  h_parent_metric =
-    new MLCommon::host_buffer<T>(host_allocator, stream, maxnodes);
-  h_child_best_metric =
-    new MLCommon::host_buffer<T>(host_allocator, stream, 2 * maxnodes);
-  h_outgain =
-    new MLCommon::host_buffer<float>(host_allocator, stream, maxnodes);
-  d_parent_metric =
-    new MLCommon::device_buffer<T>(device_allocator, stream, maxnodes);
-  d_child_best_metric =
-    new MLCommon::device_buffer<T>(device_allocator, stream, 2 * maxnodes);
-  d_outgain =
-    new MLCommon::device_buffer<float>(device_allocator, stream, maxnodes);
+  carve(d_flags, nrows, false);
+  carve(h_split_colidx, maxnodes, true);
+  carve(h_split_binidx, maxnodes, true);
+  carve(d_split_colidx, maxnodes, false);
+  carve(d_split_binidx, maxnodes, false);
+  carve(h_new_node_flags, maxnodes, true);
+  carve(d_new_node_flags, maxnodes, false);
+  carve(h_parent_metric, maxnodes, true);
+  carve(h_child_best_metric, 2 * maxnodes, true);
+  carve(h_outgain, maxnodes, true);
+  carve(d_parent_metric, maxnodes, false);
+  carve(d_child_best_metric, 2 * maxnodes, false);
+  carve(d_outgain, maxnodes, false);
   if (split_algo == 0) {
-    d_globalminmax = new MLCommon::device_buffer<T>(
-      device_allocator, stream, 2 * maxnodes * ncols_sampled);
-    h_globalminmax = new MLCommon::host_buffer<T>(host_allocator, stream,
-                                                  2 * maxnodes * ncols_sampled);
+    carve(d_globalminmax, 2 * maxnodes * ncols_sampled, false);
+    carve(h_globalminmax, 2 * maxnodes * ncols_sampled, true);
     totalmem += maxnodes * ncols * sizeof(T);
   } else {
-    h_quantile =
-      new MLCommon::host_buffer<T>(host_allocator, stream, nbins * ncols);
-    d_quantile =
-      new MLCommon::device_buffer<T>(device_allocator, stream, nbins * ncols);
+    carve(h_quantile, nbins * ncols, true);
+    carve(d_quantile, nbins * ncols, false);
     totalmem += nbins * ncols * sizeof(T);
   }
-  d_sample_cnt =
-    new MLCommon::device_buffer<unsigned int>(device_allocator, stream, nrows);
+  carve(d_sample_cnt, nrows, false);
   if (col_shuffle == true) {
-    d_colids = new MLCommon::device_buffer<unsigned int>(
-      device_allocator, stream, ncols_sampled * maxnodes);
-    h_colids = new MLCommon::host_buffer<unsigned int>(
-      host_allocator, stream, ncols_sampled * maxnodes);
+    carve(d_colids, ncols_sampled * maxnodes, false);
+    carve(h_colids, ncols_sampled * maxnodes, true);
 
   } else {
-    d_colids = new MLCommon::device_buffer<unsigned int>(device_allocator,
-                                                         stream, ncols);
-    d_colstart = new MLCommon::device_buffer<unsigned int>(device_allocator,
-                                                           stream, maxnodes);
-    h_colids =
-      new MLCommon::host_buffer<unsigned int>(host_allocator, stream, ncols);
-    h_colstart =
-      new MLCommon::host_buffer<unsigned int>(host_allocator, stream, maxnodes);
+    carve(d_colids, ncols, false);
+    carve(d_colstart, maxnodes, false);
+    carve(h_colids, ncols, true);
+    carve(h_colstart, maxnodes, true);
   }
   totalmem += nrows * 2 * sizeof(unsigned int);
   totalmem += maxnodes * 3 * sizeof(int);
@@ -143,30 +128,18 @@ void TemporaryMemory<T, L>::LevelMemAllocator(int nrows, int ncols,
   totalmem += (ncols + maxnodes) * sizeof(int);
   //Regression
   if (typeid(L) == typeid(T)) {
-    d_mseout = new MLCommon::device_buffer<T>(
-      device_allocator, stream, 2 * nbins * ncols_sampled * maxnodes);
-    d_predout = new MLCommon::device_buffer<T>(
-      device_allocator, stream, nbins * ncols_sampled * maxnodes);
-    d_count = new MLCommon::device_buffer<unsigned int>(
-      device_allocator, stream, nbins * ncols_sampled * maxnodes);
-    d_parent_pred =
-      new MLCommon::device_buffer<T>(device_allocator, stream, maxnodes);
-    d_parent_count = new MLCommon::device_buffer<unsigned int>(
-      device_allocator, stream, maxnodes);
-    d_child_pred =
-      new MLCommon::device_buffer<T>(device_allocator, stream, 2 * maxnodes);
-    d_child_count = new MLCommon::device_buffer<unsigned int>(
-      device_allocator, stream, 2 * maxnodes);
-    h_mseout = new MLCommon::host_buffer<T>(
-      host_allocator, stream, 2 * nbins * ncols_sampled * maxnodes);
-    h_predout = new MLCommon::host_buffer<T>(host_allocator, stream,
-                                             nbins * ncols_sampled * maxnodes);
-    h_count = new MLCommon::host_buffer<unsigned int>(
-      host_allocator, stream, nbins * ncols_sampled * maxnodes);
-    h_child_pred =
-      new MLCommon::host_buffer<T>(host_allocator, stream, 2 * maxnodes);
-    h_child_count = new MLCommon::host_buffer<unsigned int>(
-      host_allocator, stream, 2 * maxnodes);
+    carve(d_mseout, 2 * nbins * ncols_sampled * maxnodes, false);
+    carve(d_predout, nbins * ncols_sampled * maxnodes, false);
+    carve(d_count, nbins * ncols_sampled * maxnodes, false);
+    carve(d_parent_pred, maxnodes, false);
+    carve(d_parent_count, maxnodes, false);
+    carve(d_child_pred, 2 * maxnodes, false);
+    carve(d_child_count, 2 * maxnodes, false);
+    carve(h_mseout, 2 * nbins * ncols_sampled * maxnodes, true);
+    carve(h_predout, nbins * ncols_sampled * maxnodes, true);
+    carve(h_count, nbins * ncols_sampled * maxnodes, true);
+    carve(h_child_pred, 2 * maxnodes, true);
+    carve(h_child_count, 2 * maxnodes, true);
 
     totalmem += 3 * nbins * ncols_sampled * maxnodes * sizeof(T);
     totalmem += nbins * ncols_sampled * maxnodes * sizeof(unsigned int);
@@ -177,20 +150,52 @@ void TemporaryMemory<T, L>::LevelMemAllocator(int nrows, int ncols,
   //Classification
   if (typeid(L) == typeid(int)) {
     size_t histcount = ncols_sampled * nbins * n_unique * maxnodes;
-    d_histogram = new MLCommon::device_buffer<unsigned int>(device_allocator,
-                                                            stream, histcount);
-    h_histogram = new MLCommon::host_buffer<unsigned int>(host_allocator,
-                                                          stream, histcount);
-    h_parent_hist = new MLCommon::host_buffer<unsigned int>(
-      host_allocator, stream, maxnodes * n_unique);
-    h_child_hist = new MLCommon::host_buffer<unsigned int>(
-      host_allocator, stream, 2 * maxnodes * n_unique);
-    d_parent_hist = new MLCommon::device_buffer<unsigned int>(
-      device_allocator, stream, maxnodes * n_unique);
-    d_child_hist = new MLCommon::device_buffer<unsigned int>(
-      device_allocator, stream, 2 * maxnodes * n_unique);
+    carve(d_histogram, histcount, false);
+    carve(h_parent_hist, maxnodes * n_unique, true);
+    carve(d_parent_hist, maxnodes * n_unique, false);
+    carve(d_child_hist, 2 * maxnodes * n_unique, false);
     totalmem += histcount * sizeof(unsigned int);
     totalmem += n_unique * maxnodes * 3 * sizeof(unsigned int);
+    // The next level has up to twice as many nodes as the current one
+    carve(d_level_hist, 2 * maxnodes * n_unique, false);
+    carve(d_next_level_hist, 2 * maxnodes * n_unique, false);
+    carve(d_level_metric, 2 * maxnodes, false);
+    carve(d_next_level_metric, 2 * maxnodes, false);
+    carve(d_nodelist, 2 * maxnodes, false);
+    carve(d_next_nodelist, 2 * maxnodes, false);
+    carve(d_split_flags, maxnodes, false);
+    size_t scan_bytes = 0;
+    CUDA_CHECK(cub::DeviceScan::ExclusiveSum(
+      nullptr, scan_bytes, d_split_flags->data(), d_new_node_flags->data(),
+      maxnodes, stream));
+    carve(d_scan_temp, scan_bytes, false);
+    carve(d_n_split, 1, false);
+    carve(h_n_split, 1, true);
+    totalmem += 4 * maxnodes * n_unique * sizeof(unsigned int);
+    totalmem += 4 * maxnodes * (sizeof(T) + sizeof(int));
+    totalmem += maxnodes * sizeof(unsigned int) + scan_bytes;
+    // The histograms of siblings can be subtracted from the one of their
+    // parent only if they are over the same columns and bins.
+    if (split_algo != ML::SPLIT_ALGO::HIST && col_shuffle == false &&
+        ncols_sampled == ncols) {
+      carve(d_prev_histogram, histcount, false);
+      carve(d_hist_parent, maxnodes, false);
+      totalmem += histcount * sizeof(unsigned int);
+      totalmem += maxnodes * sizeof(int);
+    }
+  }
+  //The buffers are carved out of the arenas, grown here if they are too
+  //small; their previous contents need not be kept
+  if (workspace == nullptr) {
+    workspace =
+      std::make_shared<TreeWorkspace>(device_allocator, host_allocator, stream);
+  }
+  workspace->device.clear();
+  workspace->device.resize(device_bytes, stream);
+  workspace->host.clear();
+  workspace->host.resize(host_bytes, stream);
+  for (auto& view : views) {
+    view->bind(workspace->device.data(), workspace->host.data());
   }
   //Calculate Max nodes in shared memory.
   if (typeid(L) == typeid(int)) {
@@ -212,94 +217,56 @@ void TemporaryMemory<T, L>::LevelMemAllocator(int nrows, int ncols,
 }
 
 template <class T, class L>
-void TemporaryMemory<T, L>::LevelMemCleaner() {
-  h_new_node_flags->release(stream);
-  d_new_node_flags->release(stream);
-  h_split_colidx->release(stream);
-  d_split_colidx->release(stream);
-  h_split_binidx->release(stream);
-  d_split_binidx->release(stream);
-  h_parent_metric->release(stream);
-  h_child_best_metric->release(stream);
-  h_outgain->release(stream);
-  d_parent_metric->release(stream);
-  d_child_best_metric->release(stream);
-  d_outgain->release(stream);
-  d_flags->release(stream);
-  if (h_quantile != nullptr) h_quantile->release(stream);
-  if (d_quantile != nullptr) d_quantile->release(stream);
-  if (d_globalminmax != nullptr) d_globalminmax->release(stream);
-  if (h_globalminmax != nullptr) h_globalminmax->release(stream);
-  d_sample_cnt->release(stream);
-  d_colids->release(stream);
-  if (d_colstart != nullptr) d_colstart->release(stream);
-  h_colids->release(stream);
-  if (h_colstart != nullptr) h_colstart->release(stream);
-  delete h_new_node_flags;
-  delete d_new_node_flags;
-  delete h_split_colidx;
-  delete d_split_colidx;
-  delete h_split_binidx;
-  delete d_split_binidx;
-  delete h_parent_metric;
-  delete h_child_best_metric;
-  delete h_outgain;
-  delete d_parent_metric;
-  delete d_child_best_metric;
-  delete d_outgain;
-  delete d_flags;
-  if (h_quantile != nullptr) delete h_quantile;
-  if (d_quantile != nullptr) delete d_quantile;
-  if (d_globalminmax != nullptr) delete d_globalminmax;
-  if (h_globalminmax != nullptr) delete h_globalminmax;
-  delete d_sample_cnt;
-  delete d_colids;
-  delete h_colids;
-  if (d_colstart != nullptr) delete d_colstart;
-  if (h_colstart != nullptr) delete h_colstart;
-  //Classification
-  if (typeid(L) == typeid(int)) {
-    h_histogram->release(stream);
-    d_histogram->release(stream);
-    h_parent_hist->release(stream);
-    h_child_hist->release(stream);
-    d_parent_hist->release(stream);
-    d_child_hist->release(stream);
-    delete d_histogram;
-    delete h_histogram;
-    delete h_parent_hist;
-    delete h_child_hist;
-    delete d_parent_hist;
-    delete d_child_hist;
-  }
-  //Regression
-  if (typeid(L) == typeid(T)) {
-    d_parent_pred->release(stream);
-    d_parent_count->release(stream);
-    d_mseout->release(stream);
-    d_predout->release(stream);
-    d_count->release(stream);
-    d_child_pred->release(stream);
-    d_child_count->release(stream);
-
-    h_child_pred->release(stream);
-    h_child_count->release(stream);
-    h_mseout->release(stream);
-    h_predout->release(stream);
-    h_count->release(stream);
+template <class X>
+void TemporaryMemory<T, L>::carve(WorkspaceBuffer<X>*& buf, size_t n,
+                                  bool on_host) {
+  size_t& bytes = on_host ? host_bytes : device_bytes;
+  bytes = MLCommon::alignTo(bytes, (size_t)256);
+  buf = new WorkspaceBuffer<X>(bytes, n, on_host);
+  views.emplace_back(buf);
+  bytes += n * sizeof(X);
+}
 
-    delete d_child_pred;
-    delete d_child_count;
-    delete d_parent_pred;
-    delete d_parent_count;
-    delete d_mseout;
-    delete d_predout;
-    delete d_count;
+template <class T, class L>
+void TemporaryMemory<T, L>::StreamingMemAllocator(int nrows, int block_cols,
+                                                  int bin_bytes) {
+  size_t stage_bytes = (size_t)block_cols * nrows * bin_bytes;
+  for (int i = 0; i < 2; i++) {
+    d_stage[i] = new MLCommon::device_buffer<char>(device_allocator, stream,
+                                                   stage_bytes);
+    CUDA_CHECK(
+      cudaEventCreateWithFlags(&stage_copied[i], cudaEventDisableTiming));
+    CUDA_CHECK(
+      cudaEventCreateWithFlags(&stage_free[i], cudaEventDisableTiming));
+  }
+  d_next_flags =
+    new MLCommon::device_buffer<unsigned int>(device_allocator, stream, nrows);
+  CUDA_CHECK(cudaStreamCreateWithFlags(&copy_stream, cudaStreamNonBlocking));
+  stream_cols = block_cols;
+  totalmem += 2 * stage_bytes + nrows * sizeof(unsigned int);
+}
 
-    delete h_mseout;
-    delete h_predout;
-    delete h_count;
-    delete h_child_pred;
-    delete h_child_count;
+template <class T, class L>
+void TemporaryMemory<T, L>::StreamingMemCleaner() {
+  if (d_next_flags == nullptr) return;
+  CUDA_CHECK(cudaStreamSynchronize(copy_stream));
+  for (int i = 0; i < 2; i++) {
+    d_stage[i]->release(stream);
+    delete d_stage[i];
+    d_stage[i] = nullptr;
+    CUDA_CHECK(cudaEventDestroy(stage_copied[i]));
+    CUDA_CHECK(cudaEventDestroy(stage_free[i]));
   }
+  d_next_flags->release(stream);
+  delete d_next_flags;
+  d_next_flags = nullptr;
+  CUDA_CHECK(cudaStreamDestroy(copy_stream));
+  stream_cols = 0;
+}
+
+template <class T, class L>
+void TemporaryMemory<T, L>::LevelMemCleaner() {
+  views.clear();
+  //The arenas are freed with the last TemporaryMemory using them
+  workspace.reset();
 }
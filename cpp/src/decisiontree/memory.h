@@ -19,23 +19,75 @@
 #include <common/device_buffer.hpp>
 #include <common/host_buffer.hpp>
 #include <cuml/common/cuml_allocator.hpp>
+#include <memory>
+#include <vector>
 #include "common/cumlHandle.hpp"
 
+//Device and host arenas the buffers of a TemporaryMemory are carved out of
+//(see TemporaryMemory::carve). The TemporaryMemory of successive fits on a
+//stream can share one, which then only grows; it must not be shared by two
+//TemporaryMemory in use at the same time.
+struct TreeWorkspace {
+  MLCommon::device_buffer<char> device;
+  MLCommon::host_buffer<char> host;
+  TreeWorkspace(
+    const std::shared_ptr<MLCommon::deviceAllocator> device_allocator,
+    const std::shared_ptr<MLCommon::hostAllocator> host_allocator,
+    cudaStream_t stream)
+    : device(device_allocator, stream), host(host_allocator, stream) {}
+};
+
+//Buffer at offset bytes of the device or host arena of a TreeWorkspace; it
+//does not own its memory and is valid once bound to the arena
+class WorkspaceView {
+ public:
+  WorkspaceView(size_t offset, bool on_host)
+    : offset(offset), on_host(on_host) {}
+  virtual ~WorkspaceView() {}
+  void bind(char *device_base, char *host_base) {
+    ptr = (on_host ? host_base : device_base) + offset;
+  }
+
+ protected:
+  char *ptr = nullptr;
+
+ private:
+  size_t offset;
+  bool on_host;
+};
+
+template <class T>
+class WorkspaceBuffer : public WorkspaceView {
+ public:
+  WorkspaceBuffer(size_t offset, size_t n, bool on_host)
+    : WorkspaceView(offset, on_host), n(n) {}
+  T *data() const { return reinterpret_cast<T *>(ptr); }
+  size_t size() const { return n; }
+
+ private:
+  size_t n;
+};
+
 template <class T, class L>
 struct TemporaryMemory {
   //Allocators parsed from CUML handle
   std::shared_ptr<MLCommon::deviceAllocator> device_allocator;
   std::shared_ptr<MLCommon::hostAllocator> host_allocator;
+  //Arenas of all the buffers but the streaming ones, and these buffers
+  std::shared_ptr<TreeWorkspace> workspace;
+  std::vector<std::unique_ptr<WorkspaceView>> views;
+  size_t device_bytes = 0;
+  size_t host_bytes = 0;
 
   //Temporary data buffer
-  MLCommon::device_buffer<T> *temp_data = nullptr;
+  WorkspaceBuffer<T> *temp_data = nullptr;
   //Host/Device histograms and device minmaxs
-  MLCommon::device_buffer<T> *d_globalminmax = nullptr;
-  MLCommon::host_buffer<T> *h_globalminmax = nullptr;
-  MLCommon::device_buffer<T> *d_mseout = nullptr;
-  MLCommon::device_buffer<T> *d_predout = nullptr;
-  MLCommon::host_buffer<T> *h_mseout = nullptr;
-  MLCommon::host_buffer<T> *h_predout = nullptr;
+  WorkspaceBuffer<T> *d_globalminmax = nullptr;
+  WorkspaceBuffer<T> *h_globalminmax = nullptr;
+  WorkspaceBuffer<T> *d_mseout = nullptr;
+  WorkspaceBuffer<T> *d_predout = nullptr;
+  WorkspaceBuffer<T> *h_mseout = nullptr;
+  WorkspaceBuffer<T> *h_predout = nullptr;
   //Total temp mem
   size_t totalmem = 0;
 
@@ -49,45 +101,84 @@ struct TemporaryMemory {
   size_t max_shared_mem;
 
   //For quantiles and colids; this part is common
-  MLCommon::device_buffer<T> *d_quantile = nullptr;
-  MLCommon::host_buffer<T> *h_quantile = nullptr;
-  MLCommon::device_buffer<unsigned int> *d_colids = nullptr;
-  MLCommon::device_buffer<unsigned int> *d_colstart = nullptr;
-  MLCommon::host_buffer<unsigned int> *h_colids = nullptr;
-  MLCommon::host_buffer<unsigned int> *h_colstart = nullptr;
+  WorkspaceBuffer<T> *d_quantile = nullptr;
+  WorkspaceBuffer<T> *h_quantile = nullptr;
+  //Pre-binned data (see quantize_data), shared by the trees of a forest and
+  //not owned; at most one of them is set
+  const unsigned char *d_bins8 = nullptr;
+  const unsigned short *d_bins16 = nullptr;
+  //CSC data (see DecisionTreeClassifier::fit_csc), used instead of the dense
+  //data when d_csc_vals is set; not owned
+  const int *d_csc_ind = nullptr;
+  const int *d_csc_rows = nullptr;
+  const T *d_csc_vals = nullptr;
+  int csc_nnz = 0;
+  //Pre-binned data in host pinned memory (see quantize_data_host), copied
+  //to the device stream_cols columns at a time, alternately into the two
+  //d_stage buffers on copy_stream; not owned, at most one of them is set
+  const unsigned char *h_bins8 = nullptr;
+  const unsigned short *h_bins16 = nullptr;
+  int stream_cols = 0;
+  MLCommon::device_buffer<char> *d_stage[2] = {nullptr, nullptr};
+  //Node flags of the next level, built one column block at a time
+  MLCommon::device_buffer<unsigned int> *d_next_flags = nullptr;
+  cudaStream_t copy_stream;
+  cudaEvent_t stage_copied[2];
+  cudaEvent_t stage_free[2];
+  WorkspaceBuffer<unsigned int> *d_colids = nullptr;
+  WorkspaceBuffer<unsigned int> *d_colstart = nullptr;
+  WorkspaceBuffer<unsigned int> *h_colids = nullptr;
+  WorkspaceBuffer<unsigned int> *h_colstart = nullptr;
   //Split algo
   int splitalgo;
 
   //For level algorithm
-  MLCommon::device_buffer<unsigned int> *d_flags = nullptr;
-  MLCommon::device_buffer<unsigned int> *d_histogram = nullptr;
-  MLCommon::host_buffer<unsigned int> *h_histogram = nullptr;
-  MLCommon::host_buffer<int> *h_split_colidx = nullptr;
-  MLCommon::host_buffer<int> *h_split_binidx = nullptr;
-  MLCommon::device_buffer<int> *d_split_colidx = nullptr;
-  MLCommon::device_buffer<int> *d_split_binidx = nullptr;
-  MLCommon::host_buffer<unsigned int> *h_new_node_flags = nullptr;
-  MLCommon::device_buffer<unsigned int> *d_new_node_flags = nullptr;
-  MLCommon::host_buffer<unsigned int> *h_parent_hist = nullptr;
-  MLCommon::host_buffer<unsigned int> *h_child_hist = nullptr;
-  MLCommon::device_buffer<unsigned int> *d_parent_hist = nullptr;
-  MLCommon::device_buffer<unsigned int> *d_child_hist = nullptr;
-  MLCommon::host_buffer<T> *h_parent_metric = nullptr;
-  MLCommon::host_buffer<T> *h_child_best_metric = nullptr;
-  MLCommon::host_buffer<float> *h_outgain = nullptr;
-  MLCommon::device_buffer<float> *d_outgain = nullptr;
-  MLCommon::device_buffer<T> *d_parent_metric = nullptr;
-  MLCommon::device_buffer<T> *d_child_best_metric = nullptr;
-  MLCommon::device_buffer<unsigned int> *d_sample_cnt = nullptr;
-
-  MLCommon::device_buffer<T> *d_parent_pred = nullptr;
-  MLCommon::device_buffer<unsigned int> *d_parent_count = nullptr;
-  MLCommon::device_buffer<T> *d_child_pred = nullptr;
-  MLCommon::device_buffer<unsigned int> *d_child_count = nullptr;
-  MLCommon::device_buffer<unsigned int> *d_count = nullptr;
-  MLCommon::host_buffer<unsigned int> *h_count = nullptr;
-  MLCommon::host_buffer<T> *h_child_pred = nullptr;
-  MLCommon::host_buffer<unsigned int> *h_child_count = nullptr;
+  WorkspaceBuffer<unsigned int> *d_flags = nullptr;
+  WorkspaceBuffer<unsigned int> *d_histogram = nullptr;
+  //Histogram of the previous level and, for each node, the node of the
+  //previous level whose histogram is subtracted from (-1 if computed); only
+  //set when all the columns are used by all the nodes (see LevelMemAllocator)
+  WorkspaceBuffer<unsigned int> *d_prev_histogram = nullptr;
+  WorkspaceBuffer<int> *d_hist_parent = nullptr;
+  WorkspaceBuffer<int> *h_split_colidx = nullptr;
+  WorkspaceBuffer<int> *h_split_binidx = nullptr;
+  WorkspaceBuffer<int> *d_split_colidx = nullptr;
+  WorkspaceBuffer<int> *d_split_binidx = nullptr;
+  WorkspaceBuffer<unsigned int> *h_new_node_flags = nullptr;
+  WorkspaceBuffer<unsigned int> *d_new_node_flags = nullptr;
+  WorkspaceBuffer<unsigned int> *h_parent_hist = nullptr;
+  WorkspaceBuffer<unsigned int> *d_parent_hist = nullptr;
+  WorkspaceBuffer<unsigned int> *d_child_hist = nullptr;
+  WorkspaceBuffer<T> *h_parent_metric = nullptr;
+  WorkspaceBuffer<T> *h_child_best_metric = nullptr;
+  WorkspaceBuffer<float> *h_outgain = nullptr;
+  WorkspaceBuffer<float> *d_outgain = nullptr;
+  WorkspaceBuffer<T> *d_parent_metric = nullptr;
+  WorkspaceBuffer<T> *d_child_best_metric = nullptr;
+  WorkspaceBuffer<unsigned int> *d_sample_cnt = nullptr;
+  //Classification trees are built on the device (see
+  //ClassificationTreeBuilder): histograms, metrics and sparse ids of the
+  //nodes of the current and next level, whether each node of the level is
+  //split, the scan of these flags and the number of split nodes
+  WorkspaceBuffer<unsigned int> *d_level_hist = nullptr;
+  WorkspaceBuffer<unsigned int> *d_next_level_hist = nullptr;
+  WorkspaceBuffer<T> *d_level_metric = nullptr;
+  WorkspaceBuffer<T> *d_next_level_metric = nullptr;
+  WorkspaceBuffer<int> *d_nodelist = nullptr;
+  WorkspaceBuffer<int> *d_next_nodelist = nullptr;
+  WorkspaceBuffer<unsigned int> *d_split_flags = nullptr;
+  WorkspaceBuffer<char> *d_scan_temp = nullptr;
+  WorkspaceBuffer<int> *d_n_split = nullptr;
+  WorkspaceBuffer<int> *h_n_split = nullptr;
+
+  WorkspaceBuffer<T> *d_parent_pred = nullptr;
+  WorkspaceBuffer<unsigned int> *d_parent_count = nullptr;
+  WorkspaceBuffer<T> *d_child_pred = nullptr;
+  WorkspaceBuffer<unsigned int> *d_child_count = nullptr;
+  WorkspaceBuffer<unsigned int> *d_count = nullptr;
+  WorkspaceBuffer<unsigned int> *h_count = nullptr;
+  WorkspaceBuffer<T> *h_child_pred = nullptr;
+  WorkspaceBuffer<unsigned int> *h_child_count = nullptr;
 
   int max_nodes_class = 0;
   int max_nodes_pred = 0;
@@ -98,16 +189,24 @@ struct TemporaryMemory {
     const std::shared_ptr<MLCommon::deviceAllocator> device_allocator_in,
     const std::shared_ptr<MLCommon::hostAllocator> host_allocator_in,
     const cudaStream_t stream_in, int N, int Ncols, float colper, int n_unique,
-    int n_bins, const int split_algo, int depth, bool col_shuffle);
+    int n_bins, const int split_algo, int depth, bool col_shuffle,
+    std::shared_ptr<TreeWorkspace> workspace_in = nullptr);
   TemporaryMemory(const ML::cumlHandle_impl &handle, cudaStream_t stream_in,
                   int N, int Ncols, float colper, int n_unique, int n_bins,
-                  const int split_algo, int depth, bool colshuffle);
+                  const int split_algo, int depth, bool colshuffle,
+                  std::shared_ptr<TreeWorkspace> workspace_in = nullptr);
   ~TemporaryMemory();
   void LevelMemAllocator(int nrows, int ncols, float colper, int n_unique,
                          int nbins, int depth, const int split_algo,
                          bool col_shuffle);
 
+  template <class X>
+  void carve(WorkspaceBuffer<X> *&buf, size_t n, bool on_host);
+
+  void StreamingMemAllocator(int nrows, int block_cols, int bin_bytes);
+
   void LevelMemCleaner();
+  void StreamingMemCleaner();
   void print_info();
 };
 #include "memory.cuh"
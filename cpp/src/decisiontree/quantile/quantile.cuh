@@ -15,6 +15,7 @@
  */
 
 #pragma once
+#include <selection/segmented_sort.h>
 #include "cub/cub.cuh"
 #include "quantile.h"
 
@@ -67,6 +68,68 @@ __global__ void get_all_quantiles(const T *__restrict__ data, T *quantile,
   return;
 }
 
+//Same as get_all_quantiles, for columns whose nonzeros are sorted in data
+//(column col between offsets[col] and offsets[col + 1]) and whose other
+//values are zero.
+template <typename T>
+__global__ void get_all_quantiles_csc(const T *__restrict__ data,
+                                      const int *__restrict__ offsets,
+                                      T *quantile, const int nrows,
+                                      const int ncols, const int nbins) {
+  int tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid < nbins * ncols) {
+    int binoff = (int)(nrows / nbins);
+    int start = offsets[tid / nbins];
+    int stop = offsets[tid / nbins + 1];
+    int nzeros = nrows - (stop - start);
+    int lo = start, hi = stop;
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (data[mid] < T(0)) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    int nneg = lo - start;
+    int k = ((tid % nbins) + 1) * binoff - 1;
+    if (k < nneg) {
+      quantile[tid] = data[start + k];
+    } else if (k < nneg + nzeros) {
+      quantile[tid] = T(0);
+    } else {
+      quantile[tid] = data[start + k - nzeros];
+    }
+  }
+  return;
+}
+
+//Replaces each value by the index of the first quantile of its column which
+//is not below it (nbins if there is none, or for nan).
+template <typename T, typename B>
+__global__ void quantize_kernel(const T *__restrict__ data,
+                                const T *__restrict__ quantile,
+                                const int nrows, const int ncols,
+                                const int nbins, B *bins) {
+  size_t len = (size_t)nrows * ncols;
+  for (size_t i = threadIdx.x + (size_t)blockIdx.x * blockDim.x; i < len;
+       i += (size_t)blockDim.x * gridDim.x) {
+    const T *colquantile = quantile + (i / nrows) * nbins;
+    T value = data[i];
+    int lo = 0, hi = nbins;
+    if (isnan(value)) lo = nbins;
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (colquantile[mid] < value) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    bins[i] = lo;
+  }
+}
+
 template <typename T, typename L>
 void preprocess_quantile(const T *data, const unsigned int *rowids,
                          const int n_sampled_rows, const int ncols,
@@ -166,3 +229,166 @@ void preprocess_quantile(const T *data, const unsigned int *rowids,
 
   return;
 }
+
+/* Same as preprocess_quantile, for nrows x ncols CSC data: the nonzeros of
+ * column col are csc_vals[csc_ind[col]] to csc_vals[csc_ind[col + 1] - 1]
+ * (to csc_vals[nnz - 1] for the last column). The quantiles are over all
+ * the rows.
+ */
+template <typename T, typename L>
+void preprocess_quantile_csc(const int *csc_ind, const T *csc_vals,
+                             const int nnz, const int nrows, const int ncols,
+                             const int nbins,
+                             std::shared_ptr<TemporaryMemory<T, L>> tempmem) {
+  int threads = 128;
+  MLCommon::device_buffer<int> d_offsets(tempmem->device_allocator,
+                                         tempmem->stream, ncols + 1);
+  MLCommon::copy(d_offsets.data(), csc_ind, ncols, tempmem->stream);
+  MLCommon::updateDevice(d_offsets.data() + ncols, &nnz, 1, tempmem->stream);
+
+  MLCommon::device_buffer<T> d_keys_out(tempmem->device_allocator,
+                                        tempmem->stream, nnz);
+  MLCommon::Selection::segmentedSortKeys(
+    csc_vals, d_keys_out.data(), nnz, ncols, d_offsets.data(),
+    tempmem->device_allocator, tempmem->stream);
+
+  int blocks = MLCommon::ceildiv(ncols * nbins, threads);
+  get_all_quantiles_csc<<<blocks, threads, 0, tempmem->stream>>>(
+    d_keys_out.data(), d_offsets.data(), tempmem->d_quantile->data(), nrows,
+    ncols, nbins);
+  CUDA_CHECK(cudaGetLastError());
+  MLCommon::updateHost(tempmem->h_quantile->data(), tempmem->d_quantile->data(),
+                       nbins * ncols, tempmem->stream);
+  // nnz must outlive its copy to the device
+  CUDA_CHECK(cudaStreamSynchronize(tempmem->stream));
+  d_keys_out.release(tempmem->stream);
+  d_offsets.release(tempmem->stream);
+  d_temp_storage.release(tempmem->stream);
+}
+
+/* Converts data (nrows x ncols, column major) once into bin indices against
+ * the quantiles of tempmems[0], which the level kernels compare with bin
+ * indices instead of the data against quantiles. The bins (8 bit if nbins
+ * < 256, 16 bit otherwise) are stored in bins and set in the n_tempmems
+ * tempmems, whose quantiles must be the same; bins must outlive their use.
+ */
+template <typename T, typename L>
+void quantize_data(const T *data, const int nrows, const int ncols,
+                   const int nbins,
+                   std::shared_ptr<TemporaryMemory<T, L>> *tempmems,
+                   const int n_tempmems,
+                   MLCommon::device_buffer<char> &bins) {
+  cudaStream_t stream = tempmems[0]->stream;
+  const T *quantile = tempmems[0]->d_quantile->data();
+  size_t len = (size_t)nrows * ncols;
+  int threads = 256;
+  const size_t max_blocks = 65535;
+  int blocks = min(MLCommon::ceildiv<size_t>(len, threads), max_blocks);
+  if (nbins < 256) {
+    bins.resize(len * sizeof(unsigned char), stream);
+    unsigned char *bins8 = (unsigned char *)bins.data();
+    quantize_kernel<<<blocks, threads, 0, stream>>>(data, quantile, nrows,
+                                                   ncols, nbins, bins8);
+    for (int i = 0; i < n_tempmems; i++) tempmems[i]->d_bins8 = bins8;
+  } else {
+    bins.resize(len * sizeof(unsigned short), stream);
+    unsigned short *bins16 = (unsigned short *)bins.data();
+    quantize_kernel<<<blocks, threads, 0, stream>>>(data, quantile, nrows,
+                                                   ncols, nbins, bins16);
+    for (int i = 0; i < n_tempmems; i++) tempmems[i]->d_bins16 = bins16;
+  }
+  CUDA_CHECK(cudaGetLastError());
+  // the other tempmems may use other streams
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+}
+
+/* Same as preprocess_quantile (over all the rows) followed by quantize_data,
+ * for nrows x ncols column major data in host memory: the columns are
+ * copied to the device, sorted and binned stream_cols at a time, and the
+ * bins are stored in the host pinned buffer h_bins. The quantiles are set in
+ * tempmems[0] only, the bins and the buffers to stream them through the
+ * device (see TemporaryMemory::StreamingMemAllocator) in all the n_tempmems
+ * tempmems; h_bins must outlive their use.
+ */
+template <typename T, typename L>
+void quantize_data_host(const T *h_data, const int nrows, const int ncols,
+                        const int nbins, const int stream_cols,
+                        std::shared_ptr<TemporaryMemory<T, L>> *tempmems,
+                        const int n_tempmems,
+                        MLCommon::host_buffer<char> &h_bins) {
+  std::shared_ptr<TemporaryMemory<T, L>> tempmem = tempmems[0];
+  cudaStream_t stream = tempmem->stream;
+  int block_cols = min(stream_cols, ncols);
+  int bin_bytes =
+    (nbins < 256) ? sizeof(unsigned char) : sizeof(unsigned short);
+  size_t block_items = (size_t)block_cols * nrows;
+  h_bins.resize((size_t)ncols * nrows * bin_bytes, stream);
+
+  int threads = 128;
+  MLCommon::device_buffer<int> d_offsets(tempmem->device_allocator, stream,
+                                         block_cols + 1);
+  MLCommon::device_buffer<T> d_keys_in(tempmem->device_allocator, stream,
+                                       block_items);
+  MLCommon::device_buffer<T> d_keys_out(tempmem->device_allocator, stream,
+                                        block_items);
+  MLCommon::device_buffer<char> d_bins(tempmem->device_allocator, stream,
+                                       block_items * bin_bytes);
+  size_t temp_storage_bytes = 0;
+  CUDA_CHECK(cub::DeviceSegmentedRadixSort::SortKeys(
+    nullptr, temp_storage_bytes, d_keys_in.data(), d_keys_out.data(),
+    block_items, block_cols, d_offsets.data(), d_offsets.data() + 1, 0,
+    8 * sizeof(T), stream));
+  MLCommon::device_buffer<char> d_temp_storage(tempmem->device_allocator,
+                                               stream, temp_storage_bytes);
+
+  for (int c0 = 0; c0 < ncols; c0 += block_cols) {
+    int nc = min(block_cols, ncols - c0);
+    size_t items = (size_t)nc * nrows;
+    T *quantile = tempmem->d_quantile->data() + c0 * nbins;
+    MLCommon::updateDevice(d_keys_in.data(), h_data + (size_t)c0 * nrows,
+                           items, stream);
+    int blocks = MLCommon::ceildiv(nc + 1, threads);
+    set_sorting_offset<<<blocks, threads, 0, stream>>>(nrows, nc,
+                                                       d_offsets.data());
+    CUDA_CHECK(cudaGetLastError());
+    CUDA_CHECK(cub::DeviceSegmentedRadixSort::SortKeys(
+      (void *)d_temp_storage.data(), temp_storage_bytes, d_keys_in.data(),
+      d_keys_out.data(), items, nc, d_offsets.data(), d_offsets.data() + 1, 0,
+      8 * sizeof(T), stream));
+    blocks = MLCommon::ceildiv(nc * nbins, threads);
+    get_all_quantiles<<<blocks, threads, 0, stream>>>(
+      d_keys_out.data(), quantile, nrows, nc, nbins);
+    CUDA_CHECK(cudaGetLastError());
+
+    blocks = min(MLCommon::ceildiv<size_t>(items, 256), (size_t)65535);
+    if (bin_bytes == sizeof(unsigned char)) {
+      quantize_kernel<<<blocks, 256, 0, stream>>>(
+        d_keys_in.data(), quantile, nrows, nc, nbins,
+        (unsigned char *)d_bins.data());
+    } else {
+      quantize_kernel<<<blocks, 256, 0, stream>>>(
+        d_keys_in.data(), quantile, nrows, nc, nbins,
+        (unsigned short *)d_bins.data());
+    }
+    CUDA_CHECK(cudaGetLastError());
+    MLCommon::updateHost(h_bins.data() + (size_t)c0 * nrows * bin_bytes,
+                         d_bins.data(), items * bin_bytes, stream);
+  }
+  MLCommon::updateHost(tempmem->h_quantile->data(), tempmem->d_quantile->data(),
+                       nbins * ncols, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  d_offsets.release(stream);
+  d_keys_in.release(stream);
+  d_keys_out.release(stream);
+  d_bins.release(stream);
+  d_temp_storage.release(stream);
+
+  for (int i = 0; i < n_tempmems; i++) {
+    if (bin_bytes == sizeof(unsigned char)) {
+      tempmems[i]->h_bins8 = (const unsigned char *)h_bins.data();
+    } else {
+      tempmems[i]->h_bins16 = (const unsigned short *)h_bins.data();
+    }
+    tempmems[i]->StreamingMemAllocator(nrows, block_cols, bin_bytes);
+  }
+}
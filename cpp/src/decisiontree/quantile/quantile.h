@@ -21,3 +21,23 @@ void preprocess_quantile(const T *data, const unsigned int *rowids,
                          const int n_sampled_rows, const int ncols,
                          const int rowoffset, const int nbins,
                          std::shared_ptr<TemporaryMemory<T, L>> tempmem);
+
+template <typename T, typename L>
+void preprocess_quantile_csc(const int *csc_ind, const T *csc_vals,
+                             const int nnz, const int nrows, const int ncols,
+                             const int nbins,
+                             std::shared_ptr<TemporaryMemory<T, L>> tempmem);
+
+template <typename T, typename L>
+void quantize_data(const T *data, const int nrows, const int ncols,
+                   const int nbins,
+                   std::shared_ptr<TemporaryMemory<T, L>> *tempmems,
+                   const int n_tempmems,
+                   MLCommon::device_buffer<char> &bins);
+
+template <typename T, typename L>
+void quantize_data_host(const T *h_data, const int nrows, const int ncols,
+                        const int nbins, const int stream_cols,
+                        std::shared_ptr<TemporaryMemory<T, L>> *tempmems,
+                        const int n_tempmems,
+                        MLCommon::host_buffer<char> &h_bins);
@@ -41,16 +41,38 @@ __host__ __device__ __forceinline__ int forest_num_nodes(int num_trees,
 // FIL_TPB is the number of threads per block to use with FIL kernels
 const int FIL_TPB = 256;
 
+/** cat_set_contains returns whether the set of categories stored at
+    cat_sets[set] contains the category val; a set is stored as
+    the number of categories n, followed by ceil(n / 32) words of the bitset;
+    negative and non-integer values are truncated towards zero */
+__host__ __device__ __forceinline__ bool cat_set_contains(
+  const unsigned* cat_sets, int set, float val) {
+  unsigned n = cat_sets[set];
+  if (!(val >= 0.0f && val < float(n))) return false;
+  unsigned c = unsigned(val);
+  return (cat_sets[set + 1 + c / 32] >> (c % 32)) & 1;
+}
+
 /** base_node contains common implementation details for dense and sparse nodes */
 struct base_node {
-  static const int FID_MASK = (1 << 30) - 1;
+  static const int FID_MASK = (1 << 29) - 1;
+  static const int IS_CATEGORICAL_MASK = 1 << 29;
   static const int DEF_LEFT_MASK = 1 << 30;
   static const int IS_LEAF_MASK = 1 << 31;
-  float val;
+  // for categorical inner nodes, val stores the index of the set of
+  // categories which go left in the categorical sets of the forest
+  union {
+    float val;
+    int cat_set_idx;
+  };
   int bits;
   __host__ __device__ float output() const { return val; }
   __host__ __device__ float thresh() const { return val; }
+  __host__ __device__ int cat_set() const { return cat_set_idx; }
   __host__ __device__ int fid() const { return bits & FID_MASK; }
+  __host__ __device__ bool is_categorical() const {
+    return bits & IS_CATEGORICAL_MASK;
+  }
   __host__ __device__ bool def_left() const { return bits & DEF_LEFT_MASK; }
   __host__ __device__ bool is_leaf() const { return bits & IS_LEAF_MASK; }
   __host__ __device__ base_node() : val(0.0f), bits(0) {}
@@ -114,35 +136,94 @@ struct sparse_node : base_node {
   __host__ __device__ int left(int curr) const { return left_idx; }
 };
 
+/** sparse_node8 is a node of reduced size (8 bytes) in a sparse forest */
+struct alignas(8) sparse_node8 {
+  static const int FID_NUM_BITS = 14;
+  static const int FID_MASK = (1 << FID_NUM_BITS) - 1;
+  static const int DEF_LEFT_MASK = 1 << FID_NUM_BITS;
+  static const int IS_LEAF_MASK = 1 << (FID_NUM_BITS + 1);
+  static const int LEFT_OFFSET = FID_NUM_BITS + 2;
+  static const int LEFT_NUM_BITS = 16;
+  static const int MAX_LEFT = (1 << LEFT_NUM_BITS) - 1;
+  float val;
+  int bits;
+  __host__ __device__ float output() const { return val; }
+  __host__ __device__ float thresh() const { return val; }
+  __host__ __device__ int cat_set() const { return 0; }
+  __host__ __device__ int fid() const { return bits & FID_MASK; }
+  /** categorical splits are not supported for 8-byte nodes */
+  __host__ __device__ bool is_categorical() const { return false; }
+  __host__ __device__ bool def_left() const { return bits & DEF_LEFT_MASK; }
+  __host__ __device__ bool is_leaf() const { return bits & IS_LEAF_MASK; }
+  __host__ __device__ int left_index() const {
+    return unsigned(bits) >> LEFT_OFFSET;
+  }
+  /** index of the left child, where curr is the index of the current node */
+  __host__ __device__ int left(int curr) const { return left_index(); }
+  __host__ __device__ sparse_node8() : val(0.0f), bits(0) {}
+  sparse_node8(sparse_node8_t node) : val(node.val), bits(node.bits) {}
+  sparse_node8(float output, float thresh, int fid, bool def_left,
+               bool is_leaf, int left_index)
+    : val(is_leaf ? output : thresh) {
+    ASSERT((fid & ~FID_MASK) == 0,
+           "fid == %d: features must be at most %d for 8-byte sparse nodes",
+           fid, FID_MASK);
+    ASSERT((left_index & ~MAX_LEFT) == 0,
+           "left_index == %d: must be at most %d for 8-byte sparse nodes",
+           left_index, MAX_LEFT);
+    bits = fid | (def_left ? DEF_LEFT_MASK : 0) |
+           (is_leaf ? IS_LEAF_MASK : 0) |
+           int(unsigned(left_index) << LEFT_OFFSET);
+  }
+};
+
 /** sparse_tree is a sparse tree */
+template <typename node_t>
 struct sparse_tree {
-  __host__ __device__ sparse_tree(sparse_node* nodes) : nodes_(nodes) {}
-  __host__ __device__ const sparse_node& operator[](int i) const {
+  __host__ __device__ sparse_tree(node_t* nodes) : nodes_(nodes) {}
+  __host__ __device__ const node_t& operator[](int i) const {
     return nodes_[i];
   }
-  sparse_node* nodes_ = nullptr;
+  node_t* nodes_ = nullptr;
 };
 
 /** sparse_storage stores the forest as a collection of sparse nodes */
+template <typename node_t>
 struct sparse_storage {
   int* trees_ = nullptr;
-  sparse_node* nodes_ = nullptr;
+  node_t* nodes_ = nullptr;
   int num_trees_ = 0;
-  __host__ __device__ sparse_storage(int* trees, sparse_node* nodes,
-                                     int num_trees)
+  __host__ __device__ sparse_storage(int* trees, node_t* nodes, int num_trees)
     : trees_(trees), nodes_(nodes), num_trees_(num_trees) {}
   __host__ __device__ int num_trees() const { return num_trees_; }
-  __host__ __device__ sparse_tree operator[](int i) const {
-    return sparse_tree(&nodes_[trees_[i]]);
+  __host__ __device__ sparse_tree<node_t> operator[](int i) const {
+    return sparse_tree<node_t>(&nodes_[trees_[i]]);
   }
 };
 
+/** go_right returns whether a row with value val of feature n.fid()
+    goes to the right child of the inner node n */
+template <typename node_t>
+__host__ __device__ __forceinline__ bool go_right(const node_t& n, float val,
+                                                  const unsigned* cat_sets) {
+  if (isnan(val)) return !n.def_left();
+  if (n.is_categorical()) return !cat_set_contains(cat_sets, n.cat_set(), val);
+  return val >= n.thresh();
+}
+
 // predict_params are parameters for prediction
 struct predict_params {
   // Model parameters.
   int num_cols;
   algo_t algo;
-  int max_items;  // only set and used by infer()
+  // max number of rows predicted per thread block by infer(), and threads
+  // per block of infer() (64, 128 or 256), chosen by the forest
+  int max_items;
+  int threads_per_block;
+  // number of outputs per row; tree i contributes to output i % num_classes
+  int num_classes;
+  // sets of categories for categorical splits, see cat_set_contains()
+  const unsigned* cat_sets;
 
   // Data parameters.
   float* preds;
@@ -157,5 +238,22 @@ struct predict_params {
 template <typename storage_type>
 void infer(storage_type forest, predict_params params, cudaStream_t stream);
 
+// contributions() computes the approximate feature contributions
+// (see fil::predict_contributions()) into params.preds on the stream;
+// node_vals[i] is the expected value of forest.nodes_[i], and the
+// contributions are multiplied by scale, with global_bias added
+// to the bias terms
+template <typename storage_type>
+void contributions(storage_type forest, const float* node_vals,
+                   predict_params params, float scale, float global_bias,
+                   cudaStream_t stream);
+
+// per_tree() writes into params.preds the outputs of each tree for each row,
+// or the indices of the leaves within the trees if leaf_ids is true
+// (see fil::predict_per_tree()), on the stream
+template <typename storage_type>
+void per_tree(storage_type forest, predict_params params, bool leaf_ids,
+              cudaStream_t stream);
+
 }  // namespace fil
 }  // namespace ML
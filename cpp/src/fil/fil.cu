@@ -22,13 +22,17 @@
 #include <treelite/c_api.h>
 #include <treelite/tree.h>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <limits>
 #include <utility>
 
 #include <cuml/fil/fil.h>
 #include <cuml/common/cuml_allocator.hpp>
 #include "common.cuh"
+#include "common/cumlHandle.hpp"
+#include "common/device_buffer.hpp"
 
 namespace ML {
 namespace fil {
@@ -74,6 +78,26 @@ void sparse_node_decode(const sparse_node_t* node, float* output, float* thresh,
   *left_index = n.left_index();
 }
 
+void sparse_node8_init(sparse_node8_t* node, float output, float thresh,
+                       int fid, bool def_left, bool is_leaf, int left_index) {
+  sparse_node8 n(output, thresh, fid, def_left, is_leaf, left_index);
+  node->bits = n.bits;
+  node->val = n.val;
+}
+
+/** sparse_node8_decode extracts individual members from node */
+void sparse_node8_decode(const sparse_node8_t* node, float* output,
+                         float* thresh, int* fid, bool* def_left,
+                         bool* is_leaf, int* left_index) {
+  sparse_node8 n(*node);
+  *output = n.output();
+  *thresh = n.thresh();
+  *fid = n.fid();
+  *def_left = n.def_left();
+  *is_leaf = n.is_leaf();
+  *left_index = n.left_index();
+}
+
 __host__ __device__ float sigmoid(float x) { return 1.0f / (1.0f + expf(-x)); }
 
 /** performs additional transformations on the array of forest predictions
@@ -95,6 +119,144 @@ __global__ void transform_k(float* preds, size_t n, output_t output,
   preds[i] = result;
 }
 
+/** applies softmax to each of the n rows of preds, each row containing
+    num_classes values */
+__global__ void softmax_k(float* preds, size_t n, int num_classes) {
+  size_t i = threadIdx.x + size_t(blockIdx.x) * blockDim.x;
+  if (i >= n) return;
+  float* row = preds + i * num_classes;
+  float max_val = row[0];
+  for (int c = 1; c < num_classes; ++c) max_val = fmaxf(max_val, row[c]);
+  float sum = 0.0f;
+  for (int c = 0; c < num_classes; ++c) {
+    row[c] = expf(row[c] - max_val);
+    sum += row[c];
+  }
+  float inv_sum = 1.0f / sum;
+  for (int c = 0; c < num_classes; ++c) row[c] *= inv_sum;
+}
+
+/** forest_extras holds the data of a forest, apart from the nodes, that is
+    gathered when importing the forest */
+struct forest_extras {
+  // sets of categories for categorical splits, see cat_set_contains()
+  std::vector<unsigned> cat_sets;
+  // covers[i] is the cover of node i, in the order of the nodes passed to
+  // init_*_impl(); negative if unknown, empty if no cover is known
+  std::vector<float> covers;
+  // true if the forest is a shard of a model-parallel forest
+  bool model_parallel;
+  // number of trees per class in the whole model, if model_parallel
+  int model_trees_per_class;
+  forest_extras() : model_parallel(false), model_trees_per_class(0) {}
+};
+
+/** node_expected_values computes into vals the expected values of the subtree
+    of node cur, where cur is relative to the tree root at nodes[root]; the
+    expected value of an inner node is the average of those of its children,
+    weighted by their covers if known, and the function returns that of cur */
+template <typename node_t>
+float node_expected_values(const node_t* nodes,
+                           const std::vector<float>& covers, float* vals,
+                           int root, int cur) {
+  const node_t& n = nodes[root + cur];
+  if (n.is_leaf()) return vals[root + cur] = n.output();
+  int left = n.left(cur);
+  float left_val = node_expected_values(nodes, covers, vals, root, left);
+  float right_val = node_expected_values(nodes, covers, vals, root, left + 1);
+  float left_cover = -1.0f, right_cover = -1.0f;
+  if (size_t(root + left + 1) < covers.size()) {
+    left_cover = covers[root + left];
+    right_cover = covers[root + left + 1];
+  }
+  float val = 0.5f * (left_val + right_val);
+  if (left_cover > 0.0f && right_cover > 0.0f) {
+    val = (left_val * left_cover + right_val * right_cover) /
+          (left_cover + right_cover);
+  }
+  return vals[root + cur] = val;
+}
+
+/** saved_forest_header starts a forest saved by save(); it is followed by
+    the arrays of the forest, each starting at an 8-byte aligned offset */
+struct saved_forest_header {
+  static const int MAGIC = 0x46494c46;  // "FILF"
+  static const int VERSION = 1;
+  int magic;
+  int version;
+  // DENSE, SPARSE or SPARSE8
+  storage_type_t storage_type;
+  int num_trees;
+  int depth;
+  int num_cols;
+  algo_t algo;
+  output_t output;
+  float threshold;
+  float global_bias;
+  int num_classes;
+  // only for sparse forests
+  int num_nodes;
+  int num_cat_words;
+  int num_node_vals;
+  int model_parallel;
+  int trees_per_class;
+};
+
+size_t align8(size_t n) { return (n + 7) / 8 * 8; }
+
+/** save_array appends n bytes of device memory at d to *pbytes, starting
+    at an 8-byte aligned offset */
+void save_array(std::vector<char>* pbytes, const void* d, size_t n,
+                cudaStream_t stream) {
+  size_t offset = align8(pbytes->size());
+  pbytes->resize(offset + n, 0);
+  if (n == 0) return;
+  CUDA_CHECK(cudaMemcpyAsync(pbytes->data() + offset, d, n,
+                             cudaMemcpyDeviceToHost, stream));
+  // the next resize may move the data
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+}
+
+/** load_array allocates n bytes of device memory and copies into it the
+    array at the (aligned) *poffset in bytes of size size, advancing *poffset;
+    returns nullptr if n == 0 */
+void* load_array(const cumlHandle& h, const char* bytes, size_t size,
+                 size_t* poffset, size_t n) {
+  size_t offset = align8(*poffset);
+  ASSERT(offset + n <= size, "saved forest is truncated");
+  *poffset = offset + n;
+  if (n == 0) return nullptr;
+  void* d = h.getDeviceAllocator()->allocate(n, h.getStream());
+  CUDA_CHECK(cudaMemcpyAsync(d, bytes + offset, n, cudaMemcpyHostToDevice,
+                             h.getStream()));
+  return d;
+}
+
+/** max_batch_items returns how many rows a thread walks together through
+    each of its trees with BATCH_TREE_REORG; the paths through deeper trees
+    diverge more, and keeping more of them in registers pays off less */
+int max_batch_items(int depth) { return depth <= 10 ? 4 : depth <= 15 ? 2 : 1; }
+
+/** infer_threads_per_block returns the number of threads per block of
+    infer(); each thread walks every blockDim.x-th tree, and smaller forests
+    leave fewer threads idle and get a shorter reduction in smaller blocks */
+int infer_threads_per_block(int num_trees) {
+  return num_trees <= 64 ? 64 : num_trees <= 128 ? 128 : FIL_TPB;
+}
+
+/** auto_dense_algo returns the algorithm used by ALGO_AUTO for a dense
+    forest; the reorg layouts coalesce the node reads of a block, whether or
+    not its rows are in shared memory, and batching pays off when more than
+    one row fits into the shared memory of a block and the trees are shallow */
+algo_t auto_dense_algo(int depth, int num_cols, int num_classes,
+                       int max_shm) {
+  int class_floats = num_classes > 1 ? num_classes : 0;
+  size_t batch_shm = 2 * sizeof(float) * (num_cols + class_floats);
+  return batch_shm <= size_t(max_shm) && max_batch_items(depth) >= 2
+           ? algo_t::BATCH_TREE_REORG
+           : algo_t::TREE_REORG;
+}
+
 struct forest {
   void init_max_shm() {
     int max_shm_std = 48 * 1024;  // 48 KiB
@@ -107,7 +269,16 @@ struct forest {
     max_shm_ = std::min(max_shm_, max_shm_std);
   }
 
-  void init_common(const forest_params_t* params) {
+  /** init_launch_config sets the number of rows per block and threads per
+      block of infer() for the (resolved) algorithm and shape of the forest */
+  void init_launch_config() {
+    max_items_ =
+      algo_ == algo_t::BATCH_TREE_REORG ? max_batch_items(depth_) : 1;
+    tpb_ = infer_threads_per_block(num_trees_);
+  }
+
+  void init_common(const forest_params_t* params,
+                   const forest_extras& extras) {
     depth_ = params->depth;
     num_trees_ = params->num_trees;
     num_cols_ = params->num_cols;
@@ -115,35 +286,283 @@ struct forest {
     output_ = params->output;
     threshold_ = params->threshold;
     global_bias_ = params->global_bias;
+    num_classes_ = params->num_classes;
+    model_parallel_ = extras.model_parallel;
+    trees_per_class_ = model_parallel_ ? extras.model_trees_per_class
+                                       : num_trees_ / num_classes_;
     init_max_shm();
   }
 
+  /** init_cat_sets copies the sets of categories used by categorical splits
+      to the device */
+  void init_cat_sets(const cumlHandle& h, const std::vector<unsigned>& sets) {
+    num_cat_words_ = sets.size();
+    if (num_cat_words_ == 0) return;
+    cat_sets_ = (unsigned*)h.getDeviceAllocator()->allocate(
+      sizeof(unsigned) * num_cat_words_, h.getStream());
+    CUDA_CHECK(cudaMemcpyAsync(cat_sets_, sets.data(),
+                               sizeof(unsigned) * num_cat_words_,
+                               cudaMemcpyHostToDevice, h.getStream()));
+    // copy must be finished before the host data can be freed
+    CUDA_CHECK(cudaStreamSynchronize(h.getStream()));
+  }
+
+  void free_cat_sets(const cumlHandle& h) {
+    if (num_cat_words_ == 0) return;
+    h.getDeviceAllocator()->deallocate(
+      cat_sets_, sizeof(unsigned) * num_cat_words_, h.getStream());
+  }
+
+  /** init_node_vals copies the expected values of the nodes, in the same
+      layout as the nodes of the forest, to the device */
+  void init_node_vals(const cumlHandle& h, const std::vector<float>& vals) {
+    num_node_vals_ = vals.size();
+    if (num_node_vals_ == 0) return;
+    node_vals_ = (float*)h.getDeviceAllocator()->allocate(
+      sizeof(float) * num_node_vals_, h.getStream());
+    CUDA_CHECK(cudaMemcpyAsync(node_vals_, vals.data(),
+                               sizeof(float) * num_node_vals_,
+                               cudaMemcpyHostToDevice, h.getStream()));
+    // copy must be finished before the host data can be freed
+    CUDA_CHECK(cudaStreamSynchronize(h.getStream()));
+  }
+
+  void free_node_vals(const cumlHandle& h) {
+    if (num_node_vals_ == 0) return;
+    h.getDeviceAllocator()->deallocate(
+      node_vals_, sizeof(float) * num_node_vals_, h.getStream());
+  }
+
   virtual void infer(predict_params params, cudaStream_t stream) = 0;
+  virtual void contributions(predict_params params, float scale,
+                             float global_bias, cudaStream_t stream) = 0;
+  virtual void per_tree(predict_params params, bool leaf_ids,
+                        cudaStream_t stream) = 0;
 
-  void predict(const cumlHandle& h, float* preds, const float* data,
-               size_t num_rows) {
-    // Initialize prediction parameters.
+  predict_params init_params(float* preds, const float* data,
+                             size_t num_rows) {
     predict_params params;
     params.num_cols = num_cols_;
     params.algo = algo_;
+    params.max_items = max_items_;
+    params.threads_per_block = tpb_;
+    params.num_classes = num_classes_;
+    params.cat_sets = cat_sets_;
     params.preds = preds;
     params.data = data;
     params.num_rows = num_rows;
     params.max_shm = max_shm_;
+    return params;
+  }
 
+  /** comm returns the communicator connecting the shards of a model-parallel
+      forest */
+  const MLCommon::cumlCommunicator& comm(const cumlHandle& h) {
+    const cumlHandle_impl& impl = h.getImpl();
+    ASSERT(impl.commsInitialized(),
+           "model-parallel forests require a handle with a communicator");
+    return impl.getCommunicator();
+  }
+
+  /** allreduce sums the partial outputs at d, of size n, over the shards
+      of a model-parallel forest */
+  void allreduce(const cumlHandle& h, float* d, size_t n) {
+    comm(h).allreduce(d, d, int(n), MLCommon::cumlCommunicator::SUM,
+                      h.getStream());
+  }
+
+  void predict(const cumlHandle& h, float* preds, const float* data,
+               size_t num_rows) {
+    if (!model_parallel_) {
+      // the launches bake in the forest, the buffers and the number of rows
+      h.getImpl().runGraphed(
+        graphKey("ML::fil::predict", graph_id_, preds, data, num_rows),
+        [&]() { predict_impl(preds, data, num_rows, h.getStream()); });
+      return;
+    }
+    // each shard computes the partial sums over its trees, and the outputs
+    // are only transformed once the sums are complete
+    infer(init_params(preds, data, num_rows), h.getStream());
+    allreduce(h, preds, num_rows * num_classes_);
+    transform(preds, num_rows, h.getStream());
+  }
+
+  void predict_contributions(const cumlHandle& h, float* preds,
+                             const float* data, size_t num_rows) {
+    // contributions are those to the raw margin; they are averaged
+    // over the trees of a class like the predictions
+    float scale = 1.0f;
+    if ((output_ & output_t::AVG) != 0 && trees_per_class_ > 0) {
+      scale = 1.0f / trees_per_class_;
+    }
+    if (!model_parallel_) {
+      contributions(init_params(preds, data, num_rows), scale, global_bias_,
+                    h.getStream());
+      return;
+    }
+    // global_bias is only added once, by the shard of rank 0
+    bool first = comm(h).getRank() == 0;
+    contributions(init_params(preds, data, num_rows), scale,
+                  first ? global_bias_ : 0.0f, h.getStream());
+    allreduce(h, preds, num_rows * num_classes_ * (num_cols_ + 1));
+  }
+
+  void predict_per_tree(const cumlHandle& h, float* preds, const float* data,
+                        size_t num_rows, bool leaf_ids) {
+    ASSERT(!model_parallel_,
+           "predict_per_tree() is not supported for model-parallel forests");
+    per_tree(init_params(preds, data, num_rows), leaf_ids, h.getStream());
+  }
+
+  void predict_impl(float* preds, const float* data, size_t num_rows,
+                    cudaStream_t stream) {
     // Predict using the forest.
-    cudaStream_t stream = h.getStream();
-    infer(params, stream);
-
-    // Transform the output if necessary.
-    if (output_ != output_t::RAW || global_bias_ != 0.0f) {
-      transform_k<<<ceildiv(int(num_rows), FIL_TPB), FIL_TPB, 0, stream>>>(
-        preds, num_rows, output_, num_trees_ > 0 ? (1.0f / num_trees_) : 1.0f,
-        threshold_, global_bias_);
+    infer(init_params(preds, data, num_rows), stream);
+    transform(preds, num_rows, stream);
+  }
+
+  /** transform applies the output transformations to the predictions */
+  void transform(float* preds, size_t num_rows, cudaStream_t stream) {
+    // Transform the output if necessary; averaging is done over the trees
+    // of each class, and softmax is applied to each row separately.
+    output_t elementwise = output_t(output_ & ~output_t::SOFTMAX);
+    if (elementwise != output_t::RAW || global_bias_ != 0.0f) {
+      size_t num_outputs = num_rows * num_classes_;
+      transform_k<<<ceildiv(int(num_outputs), FIL_TPB), FIL_TPB, 0, stream>>>(
+        preds, num_outputs, elementwise,
+        trees_per_class_ > 0 ? (1.0f / trees_per_class_) : 1.0f, threshold_,
+        global_bias_);
       CUDA_CHECK(cudaPeekAtLastError());
     }
+    if ((output_ & output_t::SOFTMAX) != 0) {
+      softmax_k<<<ceildiv(int(num_rows), FIL_TPB), FIL_TPB, 0, stream>>>(
+        preds, num_rows, num_classes_);
+      CUDA_CHECK(cudaPeekAtLastError());
+    }
+  }
+
+  void predict_host(const cumlHandle& h, float* preds, const float* data,
+                    size_t num_rows, size_t chunk_rows) {
+    const size_t DEFAULT_CHUNK_ROWS = 1 << 16;
+    ASSERT(!model_parallel_,
+           "predict_host() is not supported for model-parallel forests");
+    if (num_rows == 0) return;
+    if (chunk_rows == 0) chunk_rows = DEFAULT_CHUNK_ROWS;
+    chunk_rows = std::min(chunk_rows, num_rows);
+
+    const cumlHandle_impl& impl = h.getImpl();
+    cudaStream_t user_stream = impl.getStream();
+    std::vector<cudaStream_t> streams = impl.getInternalStreams();
+    if (streams.empty()) streams.push_back(user_stream);
+    int num_streams = streams.size();
+
+    // each stream has its own device buffers for a chunk of data and
+    // predictions; work on a single stream is ordered, so the buffers
+    // can be reused by the next chunk of the same stream
+    size_t data_chunk = chunk_rows * num_cols_;
+    size_t preds_chunk = chunk_rows * num_classes_;
+    device_buffer<float> data_d(impl.getDeviceAllocator(), user_stream,
+                                data_chunk * num_streams);
+    device_buffer<float> preds_d(impl.getDeviceAllocator(), user_stream,
+                                 preds_chunk * num_streams);
+    // the internal streams wait for the user stream here, and the user stream
+    // waits for them at the end of the scope, before the buffers are freed
+    ML::detail::streamSyncer _(impl);
+    for (size_t row = 0, chunk = 0; row < num_rows;
+         row += chunk_rows, ++chunk) {
+      int sid = chunk % num_streams;
+      cudaStream_t s = streams[sid];
+      size_t n = std::min(chunk_rows, num_rows - row);
+      float* chunk_data = data_d.data() + sid * data_chunk;
+      float* chunk_preds = preds_d.data() + sid * preds_chunk;
+      CUDA_CHECK(cudaMemcpyAsync(chunk_data, data + row * num_cols_,
+                                 n * num_cols_ * sizeof(float),
+                                 cudaMemcpyHostToDevice, s));
+      predict_impl(chunk_preds, chunk_data, n, s);
+      CUDA_CHECK(cudaMemcpyAsync(preds + row * num_classes_, chunk_preds,
+                                 n * num_classes_ * sizeof(float),
+                                 cudaMemcpyDeviceToHost, s));
+    }
+  }
+
+  /** save_header returns the header of the saved forest, with the fields
+      common to all forests set */
+  saved_forest_header save_header(storage_type_t storage_type) {
+    saved_forest_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = saved_forest_header::MAGIC;
+    hdr.version = saved_forest_header::VERSION;
+    hdr.storage_type = storage_type;
+    hdr.num_trees = num_trees_;
+    hdr.depth = depth_;
+    hdr.num_cols = num_cols_;
+    hdr.algo = algo_;
+    hdr.output = output_;
+    hdr.threshold = threshold_;
+    hdr.global_bias = global_bias_;
+    hdr.num_classes = num_classes_;
+    hdr.num_cat_words = num_cat_words_;
+    hdr.num_node_vals = num_node_vals_;
+    hdr.model_parallel = model_parallel_;
+    hdr.trees_per_class = trees_per_class_;
+    return hdr;
   }
 
+  void load_header(const saved_forest_header& hdr) {
+    num_trees_ = hdr.num_trees;
+    depth_ = hdr.depth;
+    num_cols_ = hdr.num_cols;
+    algo_ = hdr.algo;
+    output_ = hdr.output;
+    threshold_ = hdr.threshold;
+    global_bias_ = hdr.global_bias;
+    num_classes_ = hdr.num_classes;
+    num_cat_words_ = hdr.num_cat_words;
+    num_node_vals_ = hdr.num_node_vals;
+    model_parallel_ = hdr.model_parallel;
+    trees_per_class_ = hdr.trees_per_class;
+    init_max_shm();
+    init_launch_config();
+  }
+
+  /** save writes the forest into *pbytes, see fil::save() */
+  void save(const cumlHandle& h, std::vector<char>* pbytes) {
+    saved_forest_header hdr = save_header(storage_type());
+    pbytes->assign(sizeof(hdr), 0);
+    save_nodes(&hdr, pbytes, h.getStream());
+    save_array(pbytes, cat_sets_, sizeof(unsigned) * num_cat_words_,
+               h.getStream());
+    save_array(pbytes, node_vals_, sizeof(float) * num_node_vals_,
+               h.getStream());
+    // the header is only complete after save_nodes()
+    memcpy(pbytes->data(), &hdr, sizeof(hdr));
+  }
+
+  /** load initializes the forest from bytes of size size, which start at
+      offset with the arrays following hdr, see fil::load() */
+  void load(const cumlHandle& h, const saved_forest_header& hdr,
+            const char* bytes, size_t size, size_t offset) {
+    load_header(hdr);
+    load_nodes(h, hdr, bytes, size, &offset);
+    cat_sets_ = (unsigned*)load_array(h, bytes, size, &offset,
+                                      sizeof(unsigned) * num_cat_words_);
+    node_vals_ = (float*)load_array(h, bytes, size, &offset,
+                                    sizeof(float) * num_node_vals_);
+  }
+
+  /** storage_type returns the type of nodes in the forest */
+  virtual storage_type_t storage_type() = 0;
+
+  /** save_nodes sets the fields of hdr specific to the forest and appends
+      the arrays of trees and nodes to *pbytes */
+  virtual void save_nodes(saved_forest_header* hdr, std::vector<char>* pbytes,
+                          cudaStream_t stream) = 0;
+
+  /** load_nodes loads the arrays of trees and nodes saved by save_nodes()
+      from bytes at *poffset, advancing *poffset */
+  virtual void load_nodes(const cumlHandle& h, const saved_forest_header& hdr,
+                          const char* bytes, size_t size, size_t* poffset) = 0;
+
   virtual void free(const cumlHandle& h) = 0;
   virtual ~forest() {}
 
@@ -152,36 +571,74 @@ struct forest {
   int num_cols_ = 0;
   algo_t algo_ = algo_t::NAIVE;
   int max_shm_ = 0;
+  // rows per block (at most) and threads per block of infer()
+  int max_items_ = 1;
+  int tpb_ = FIL_TPB;
   output_t output_ = output_t::RAW;
   float threshold_ = 0.5;
   float global_bias_ = 0;
+  int num_classes_ = 1;
+  unsigned* cat_sets_ = nullptr;
+  int num_cat_words_ = 0;
+  float* node_vals_ = nullptr;
+  size_t num_node_vals_ = 0;
+  // for a shard of a model-parallel forest, the partial outputs of the shards
+  // are summed before they are transformed
+  bool model_parallel_ = false;
+  // number of trees per class in the whole model, used for averaging
+  int trees_per_class_ = 0;
+  // identifies the forest in the keys of its captured predictions; unlike
+  // its address, it is not reused by the forests created after it is freed
+  unsigned long long graph_id_ = next_graph_id();
+
+  static unsigned long long next_graph_id() {
+    static std::atomic<unsigned long long> next(0);
+    return next++;
+  }
 };
 
 struct dense_forest : forest {
-  void transform_trees(const dense_node_t* nodes) {
-    // populate node information
+  /** transform_trees copies the per-node data from src, with the nodes of
+      each tree stored contiguously, into dst in the reorg layout */
+  template <typename T, typename S>
+  void transform_trees(T* dst, const S* src) {
     for (int i = 0, gid = 0; i < num_trees_; ++i) {
       for (int j = 0, nid = 0; j <= depth_; ++j) {
         for (int k = 0; k < 1 << j; ++k, ++nid, ++gid) {
-          h_nodes_[nid * num_trees_ + i] = dense_node(nodes[gid]);
+          dst[nid * num_trees_ + i] = T(src[gid]);
         }
       }
     }
   }
 
   void init(const cumlHandle& h, const dense_node_t* nodes,
-            const forest_params_t* params) {
-    init_common(params);
+            const forest_params_t* params, const forest_extras& extras) {
+    init_common(params, extras);
+    init_cat_sets(h, extras.cat_sets);
+    if (algo_ == algo_t::ALGO_AUTO) {
+      algo_ = auto_dense_algo(depth_, num_cols_, num_classes_, max_shm_);
+    }
+    init_launch_config();
 
     int num_nodes = forest_num_nodes(num_trees_, depth_);
     nodes_ = (dense_node*)h.getDeviceAllocator()->allocate(
       sizeof(dense_node) * num_nodes, h.getStream());
     h_nodes_.resize(num_nodes);
+    // expected values of the nodes, for contributions
+    std::vector<float> vals(num_nodes), h_vals(num_nodes);
+    const dense_node* fil_nodes = reinterpret_cast<const dense_node*>(nodes);
+    for (int i = 0; i < num_trees_; ++i) {
+      node_expected_values(fil_nodes, extras.covers, vals.data(),
+                           i * tree_num_nodes(depth_), 0);
+    }
     if (algo_ == algo_t::NAIVE) {
       std::copy(nodes, nodes + num_nodes, h_nodes_.begin());
+      h_vals = vals;
     } else {
-      transform_trees(nodes);
+      transform_trees(h_nodes_.data(), nodes);
+      transform_trees(h_vals.data(), vals.data());
     }
+    init_node_vals(h, h_vals);
     CUDA_CHECK(cudaMemcpyAsync(nodes_, h_nodes_.data(),
                                num_nodes * sizeof(dense_node),
                                cudaMemcpyHostToDevice, h.getStream()));
@@ -191,28 +648,83 @@ struct dense_forest : forest {
     h_nodes_.shrink_to_fit();
   }
 
-  virtual void infer(predict_params params, cudaStream_t stream) override {
-    dense_storage forest(nodes_, num_trees_,
+  dense_storage storage() {
+    return dense_storage(nodes_, num_trees_,
                          algo_ == algo_t::NAIVE ? tree_num_nodes(depth_) : 1,
                          algo_ == algo_t::NAIVE ? 1 : num_trees_);
-    fil::infer(forest, params, stream);
+  }
+
+  virtual void infer(predict_params params, cudaStream_t stream) override {
+    fil::infer(storage(), params, stream);
+  }
+
+  virtual void contributions(predict_params params, float scale,
+                             float global_bias, cudaStream_t stream) override {
+    fil::contributions(storage(), node_vals_, params, scale, global_bias,
+                       stream);
+  }
+
+  virtual void per_tree(predict_params params, bool leaf_ids,
+                        cudaStream_t stream) override {
+    fil::per_tree(storage(), params, leaf_ids, stream);
+  }
+
+  virtual storage_type_t storage_type() override {
+    return storage_type_t::DENSE;
+  }
+
+  virtual void save_nodes(saved_forest_header* hdr, std::vector<char>* pbytes,
+                          cudaStream_t stream) override {
+    int num_nodes = forest_num_nodes(num_trees_, depth_);
+    save_array(pbytes, nodes_, sizeof(dense_node) * num_nodes, stream);
+  }
+
+  virtual void load_nodes(const cumlHandle& h, const saved_forest_header& hdr,
+                          const char* bytes, size_t size,
+                          size_t* poffset) override {
+    int num_nodes = forest_num_nodes(num_trees_, depth_);
+    nodes_ = (dense_node*)load_array(h, bytes, size, poffset,
+                                     sizeof(dense_node) * num_nodes);
   }
 
   virtual void free(const cumlHandle& h) override {
     int num_nodes = forest_num_nodes(num_trees_, depth_);
     h.getDeviceAllocator()->deallocate(nodes_, sizeof(dense_node) * num_nodes,
                                        h.getStream());
+    free_cat_sets(h);
+    free_node_vals(h);
   }
 
   dense_node* nodes_ = nullptr;
   thrust::host_vector<dense_node> h_nodes_;
 };
 
+// sparse_forest_node maps the type of nodes passed to init_sparse()
+// to the type of nodes stored in the sparse forest
+template <typename node_t>
+struct sparse_forest_node;
+
+template <>
+struct sparse_forest_node<sparse_node_t> {
+  typedef sparse_node type;
+};
+
+template <>
+struct sparse_forest_node<sparse_node8_t> {
+  typedef sparse_node8 type;
+};
+
+template <typename node_t>
 struct sparse_forest : forest {
-  void init(const cumlHandle& h, const int* trees, const sparse_node_t* nodes,
-            const forest_params_t* params) {
-    init_common(params);
+  typedef typename sparse_forest_node<node_t>::type storage_node;
+
+  void init(const cumlHandle& h, const int* trees, const node_t* nodes,
+            const forest_params_t* params, const forest_extras& extras) {
+    init_common(params, extras);
+    init_cat_sets(h, extras.cat_sets);
+    if (algo_ == algo_t::ALGO_AUTO) algo_ = algo_t::NAIVE;
     depth_ = 0;  // a placeholder value
+    init_launch_config();
     num_nodes_ = params->num_nodes;
 
     // trees
@@ -222,27 +734,76 @@ struct sparse_forest : forest {
                                cudaMemcpyHostToDevice, h.getStream()));
 
     // nodes
-    nodes_ = (sparse_node*)h.getDeviceAllocator()->allocate(
-      sizeof(sparse_node) * num_nodes_, h.getStream());
-    CUDA_CHECK(cudaMemcpyAsync(nodes_, nodes, sizeof(sparse_node) * num_nodes_,
+    nodes_ = (storage_node*)h.getDeviceAllocator()->allocate(
+      sizeof(storage_node) * num_nodes_, h.getStream());
+    CUDA_CHECK(cudaMemcpyAsync(nodes_, nodes,
+                               sizeof(storage_node) * num_nodes_,
                                cudaMemcpyHostToDevice, h.getStream()));
+
+    // expected values of the nodes, for contributions
+    std::vector<float> vals(num_nodes_);
+    const storage_node* fil_nodes =
+      reinterpret_cast<const storage_node*>(nodes);
+    for (int i = 0; i < num_trees_; ++i) {
+      node_expected_values(fil_nodes, extras.covers, vals.data(), trees[i], 0);
+    }
+    init_node_vals(h, vals);
+  }
+
+  sparse_storage<storage_node> storage() {
+    return sparse_storage<storage_node>(trees_, nodes_, num_trees_);
   }
 
   virtual void infer(predict_params params, cudaStream_t stream) override {
-    sparse_storage forest(trees_, nodes_, num_trees_);
-    fil::infer(forest, params, stream);
+    fil::infer(storage(), params, stream);
+  }
+
+  virtual void contributions(predict_params params, float scale,
+                             float global_bias, cudaStream_t stream) override {
+    fil::contributions(storage(), node_vals_, params, scale, global_bias,
+                       stream);
+  }
+
+  virtual void per_tree(predict_params params, bool leaf_ids,
+                        cudaStream_t stream) override {
+    fil::per_tree(storage(), params, leaf_ids, stream);
+  }
+
+  virtual storage_type_t storage_type() override {
+    return sizeof(storage_node) == sizeof(sparse_node8)
+             ? storage_type_t::SPARSE8
+             : storage_type_t::SPARSE;
+  }
+
+  virtual void save_nodes(saved_forest_header* hdr, std::vector<char>* pbytes,
+                          cudaStream_t stream) override {
+    hdr->num_nodes = num_nodes_;
+    save_array(pbytes, trees_, sizeof(int) * num_trees_, stream);
+    save_array(pbytes, nodes_, sizeof(storage_node) * num_nodes_, stream);
+  }
+
+  virtual void load_nodes(const cumlHandle& h, const saved_forest_header& hdr,
+                          const char* bytes, size_t size,
+                          size_t* poffset) override {
+    num_nodes_ = hdr.num_nodes;
+    trees_ =
+      (int*)load_array(h, bytes, size, poffset, sizeof(int) * num_trees_);
+    nodes_ = (storage_node*)load_array(h, bytes, size, poffset,
+                                       sizeof(storage_node) * num_nodes_);
   }
 
   void free(const cumlHandle& h) override {
     h.getDeviceAllocator()->deallocate(trees_, sizeof(int) * num_trees_,
                                        h.getStream());
-    h.getDeviceAllocator()->deallocate(nodes_, sizeof(sparse_node) * num_nodes_,
-                                       h.getStream());
+    h.getDeviceAllocator()->deallocate(
+      nodes_, sizeof(storage_node) * num_nodes_, h.getStream());
+    free_cat_sets(h);
+    free_node_vals(h);
   }
 
   int num_nodes_ = 0;
   int* trees_ = nullptr;
-  sparse_node* nodes_ = nullptr;
+  storage_node* nodes_ = nullptr;
 };
 
 void check_params(const forest_params_t* params, bool dense) {
@@ -251,25 +812,43 @@ void check_params(const forest_params_t* params, bool dense) {
   } else {
     ASSERT(params->num_nodes >= 0,
            "num_nodes must be non-negative for sparse forests");
-    ASSERT(params->algo == algo_t::NAIVE,
-           "only NAIVE algorithm is supported for sparse forests");
+    ASSERT(params->algo == algo_t::NAIVE || params->algo == algo_t::ALGO_AUTO,
+           "only ALGO_AUTO and NAIVE algorithms are supported "
+           "for sparse forests");
   }
   ASSERT(params->num_trees >= 0, "num_trees must be non-negative");
   ASSERT(params->num_cols >= 0, "num_cols must be non-negative");
+  ASSERT(params->num_classes >= 1, "num_classes must be positive");
+  ASSERT(params->num_trees % params->num_classes == 0,
+         "num_trees must be divisible by num_classes");
   switch (params->algo) {
+    case algo_t::ALGO_AUTO:
     case algo_t::NAIVE:
     case algo_t::TREE_REORG:
     case algo_t::BATCH_TREE_REORG:
       break;
     default:
-      ASSERT(false, "aglo should be NAIVE, TREE_REORG or BATCH_TREE_REORG");
+      ASSERT(false,
+             "aglo should be ALGO_AUTO, NAIVE, TREE_REORG or "
+             "BATCH_TREE_REORG");
   }
   // output_t::RAW == 0, and doesn't have a separate flag
-  output_t all_set =
-    output_t(output_t::AVG | output_t::SIGMOID | output_t::THRESHOLD);
+  output_t all_set = output_t(output_t::AVG | output_t::SIGMOID |
+                              output_t::THRESHOLD | output_t::SOFTMAX);
   if ((params->output & ~all_set) != 0) {
     ASSERT(false,
-           "output should be a combination of RAW, AVG, SIGMOID and THRESHOLD");
+           "output should be a combination of RAW, AVG, SIGMOID, SOFTMAX "
+           "and THRESHOLD");
+  }
+  if (params->num_classes > 1) {
+    ASSERT((params->output & output_t::THRESHOLD) == 0,
+           "THRESHOLD is only supported for forests with a single output");
+  }
+  if ((params->output & output_t::SOFTMAX) != 0) {
+    ASSERT(params->num_classes > 1,
+           "SOFTMAX is only supported for multi-class forests");
+    ASSERT((params->output & output_t::SIGMOID) == 0,
+           "SOFTMAX and SIGMOID cannot be used together");
   }
 }
 
@@ -340,84 +919,177 @@ void adjust_threshold(float* pthreshold, int* tl_left, int* tl_right,
   }
 }
 
-void node2fil_dense(std::vector<dense_node_t>* pnodes, int root, int cur,
-                    const tl::Tree& tree, const tl::Tree::Node& node) {
+// add_cat_set appends the set of categories cats to *pcat_sets
+// (in the format described at cat_set_contains()) and returns its index
+int add_cat_set(std::vector<unsigned>* pcat_sets,
+                const std::vector<uint32_t>& cats) {
+  unsigned n =
+    cats.empty() ? 0 : *std::max_element(cats.begin(), cats.end()) + 1;
+  int set = pcat_sets->size();
+  pcat_sets->push_back(n);
+  pcat_sets->resize(set + 1 + (n + 31) / 32, 0);
+  for (uint32_t c : cats) (*pcat_sets)[set + 1 + c / 32] |= 1u << (c % 32);
+  return set;
+}
+
+// set_categorical turns an inner node into a categorical split with
+// the categories going left stored at set
+template <typename node_t>
+void set_categorical(node_t* node, int set) {
+  node->bits |= base_node::IS_CATEGORICAL_MASK;
+  memcpy(&node->val, &set, sizeof(set));
+}
+
+template <>
+void set_categorical<sparse_node8_t>(sparse_node8_t* node, int set) {
+  ASSERT(false, "categorical splits are not supported for 8-byte nodes");
+}
+
+// split_params extracts the threshold, children and default direction
+// of an inner node, converted to the FIL conventions
+void split_params(const tl::Tree::Node& node, float* pthreshold, int* tl_left,
+                  int* tl_right, bool* default_left) {
+  *tl_left = node.cleft();
+  *tl_right = node.cright();
+  *default_left = node.default_left();
+  *pthreshold = 0.0f;
+  switch (node.split_type()) {
+    case tl::SplitFeatureType::kNumerical:
+      *pthreshold = node.threshold();
+      adjust_threshold(pthreshold, tl_left, tl_right, default_left, node);
+      break;
+    case tl::SplitFeatureType::kCategorical:
+      // the categories in node.left_categories() go left,
+      // which is already the FIL convention
+      break;
+    default:
+      ASSERT(false, "only numerical and categorical split nodes are supported");
+  }
+}
+
+// set_cover stores the cover of node, which is at index i in the FIL forest,
+// in *pextras; the cover is the sum of hessians if available, otherwise
+// the data count, and it is negative if unknown
+void set_cover(forest_extras* pextras, size_t i, const tl::Tree::Node& node) {
+  if (pextras->covers.size() <= i) pextras->covers.resize(i + 1, -1.0f);
+  float cover = -1.0f;
+  if (node.has_sum_hess()) {
+    cover = node.sum_hess();
+  } else if (node.has_data_count()) {
+    cover = node.data_count();
+  }
+  pextras->covers[i] = cover;
+}
+
+void node2fil_dense(std::vector<dense_node_t>* pnodes, forest_extras* pextras,
+                    int root, int cur, const tl::Tree& tree,
+                    const tl::Tree::Node& node) {
+  set_cover(pextras, root + cur, node);
   if (node.is_leaf()) {
+    ASSERT(!node.has_leaf_vector(), "vector leaves are not supported");
     dense_node_init(&(*pnodes)[root + cur], node.leaf_value(), 0, 0, false,
                     true);
     return;
   }
 
   // inner node
-  ASSERT(node.split_type() == tl::SplitFeatureType::kNumerical,
-         "only numerical split nodes are supported");
-  int tl_left = node.cleft(), tl_right = node.cright();
-  bool default_left = node.default_left();
-  float threshold = node.threshold();
-  adjust_threshold(&threshold, &tl_left, &tl_right, &default_left, node);
+  int tl_left, tl_right;
+  bool default_left;
+  float threshold;
+  split_params(node, &threshold, &tl_left, &tl_right, &default_left);
   dense_node_init(&(*pnodes)[root + cur], 0, threshold, node.split_index(),
                   default_left, false);
+  if (node.split_type() == tl::SplitFeatureType::kCategorical) {
+    set_categorical(&(*pnodes)[root + cur],
+                    add_cat_set(&pextras->cat_sets, node.left_categories()));
+  }
   int left = 2 * cur + 1;
-  node2fil_dense(pnodes, root, left, tree, tl_node_at(tree, tl_left));
-  node2fil_dense(pnodes, root, left + 1, tree, tl_node_at(tree, tl_right));
+  node2fil_dense(pnodes, pextras, root, left, tree, tl_node_at(tree, tl_left));
+  node2fil_dense(pnodes, pextras, root, left + 1, tree,
+                 tl_node_at(tree, tl_right));
+}
+
+// node_init initializes a sparse node of either size
+inline void node_init(sparse_node_t* node, float output, float thresh,
+                      int fid, bool def_left, bool is_leaf, int left_index) {
+  sparse_node_init(node, output, thresh, fid, def_left, is_leaf, left_index);
 }
 
-void node2fil_sparse(std::vector<sparse_node_t>* pnodes, int root, int cur,
-                     const tl::Tree& tree, const tl::Tree::Node& node) {
+inline void node_init(sparse_node8_t* node, float output, float thresh,
+                      int fid, bool def_left, bool is_leaf, int left_index) {
+  sparse_node8_init(node, output, thresh, fid, def_left, is_leaf, left_index);
+}
+
+template <typename node_t>
+void node2fil_sparse(std::vector<node_t>* pnodes, forest_extras* pextras,
+                     int root, int cur, const tl::Tree& tree,
+                     const tl::Tree::Node& node) {
+  set_cover(pextras, root + cur, node);
   if (node.is_leaf()) {
-    sparse_node_init(&(*pnodes)[root + cur], node.leaf_value(), 0, 0, false,
-                     true, 0);
+    ASSERT(!node.has_leaf_vector(), "vector leaves are not supported");
+    node_init(&(*pnodes)[root + cur], node.leaf_value(), 0, 0, false, true, 0);
     return;
   }
 
   // inner node
-  ASSERT(node.split_type() == tl::SplitFeatureType::kNumerical,
-         "only numerical split nodes are supported");
   // tl_left and tl_right are indices of the children in the treelite tree
   // (stored  as an array of nodes)
-  int tl_left = node.cleft(), tl_right = node.cright();
-  bool default_left = node.default_left();
-  float threshold = node.threshold();
-  adjust_threshold(&threshold, &tl_left, &tl_right, &default_left, node);
+  int tl_left, tl_right;
+  bool default_left;
+  float threshold;
+  split_params(node, &threshold, &tl_left, &tl_right, &default_left);
 
   // reserve space for child nodes
   // left is the offset of the left child node relative to the tree root
   // in the array of all nodes of the FIL sparse forest
   int left = pnodes->size() - root;
-  pnodes->push_back(sparse_node_t());
-  pnodes->push_back(sparse_node_t());
-  sparse_node_init(&(*pnodes)[root + cur], 0, threshold, node.split_index(),
-                   default_left, false, left);
+  pnodes->push_back(node_t());
+  pnodes->push_back(node_t());
+  node_init(&(*pnodes)[root + cur], 0, threshold, node.split_index(),
+            default_left, false, left);
+  if (node.split_type() == tl::SplitFeatureType::kCategorical) {
+    set_categorical(&(*pnodes)[root + cur],
+                    add_cat_set(&pextras->cat_sets, node.left_categories()));
+  }
 
   // init child nodes
-  node2fil_sparse(pnodes, root, left, tree, tl_node_at(tree, tl_left));
-  node2fil_sparse(pnodes, root, left + 1, tree, tl_node_at(tree, tl_right));
+  node2fil_sparse(pnodes, pextras, root, left, tree,
+                  tl_node_at(tree, tl_left));
+  node2fil_sparse(pnodes, pextras, root, left + 1, tree,
+                  tl_node_at(tree, tl_right));
 }
 
-void tree2fil_dense(std::vector<dense_node_t>* pnodes, int root,
-                    const tl::Tree& tree) {
-  node2fil_dense(pnodes, root, 0, tree, tl_node_at(tree, tree_root(tree)));
+void tree2fil_dense(std::vector<dense_node_t>* pnodes, forest_extras* pextras,
+                    int root, const tl::Tree& tree) {
+  node2fil_dense(pnodes, pextras, root, 0, tree,
+                 tl_node_at(tree, tree_root(tree)));
 }
 
-int tree2fil_sparse(std::vector<sparse_node_t>* pnodes, const tl::Tree& tree) {
+template <typename node_t>
+int tree2fil_sparse(std::vector<node_t>* pnodes, forest_extras* pextras,
+                    const tl::Tree& tree) {
   int root = pnodes->size();
-  pnodes->push_back(sparse_node_t());
-  node2fil_sparse(pnodes, root, 0, tree, tl_node_at(tree, tree_root(tree)));
+  pnodes->push_back(node_t());
+  node2fil_sparse(pnodes, pextras, root, 0, tree,
+                  tl_node_at(tree, tree_root(tree)));
   return root;
 }
 
 // tl2fil_common is the part of conversion from a treelite model
 // common for dense and sparse forests
+// tree_ids are the indices of the trees of model imported into the forest
 void tl2fil_common(forest_params_t* params, const tl::Model& model,
-                   const treelite_params_t* tl_params) {
+                   const treelite_params_t* tl_params,
+                   const std::vector<int>& tree_ids) {
   // fill in forest-indendent params
   params->algo = tl_params->algo;
   params->threshold = tl_params->threshold;
 
   // fill in forest-dependent params
   params->num_cols = model.num_feature;
-  ASSERT(model.num_output_group == 1,
-         "multi-class classification not supported");
+  // for multi-class models, treelite assigns tree i to the output group
+  // i % num_output_group, which matches the FIL grouping of trees by class
+  params->num_classes = model.num_output_group;
   const tl::ModelParam& param = model.param;
   ASSERT(param.sigmoid_alpha == 1.0f, "sigmoid_alpha not supported");
   params->global_bias = param.global_bias;
@@ -429,66 +1101,116 @@ void tl2fil_common(forest_params_t* params, const tl::Model& model,
   if (model.random_forest_flag) {
     params->output = output_t(params->output | output_t::AVG);
   }
-  if (param.pred_transform == "sigmoid") {
+  if (param.pred_transform == "sigmoid" ||
+      param.pred_transform == "multiclass_ova") {
     params->output = output_t(params->output | output_t::SIGMOID);
+  } else if (param.pred_transform == "softmax") {
+    params->output = output_t(params->output | output_t::SOFTMAX);
   } else if (param.pred_transform != "identity") {
     ASSERT(false, "%s: unsupported treelite prediction transform",
            param.pred_transform.c_str());
   }
-  params->num_trees = model.trees.size();
+  params->num_trees = tree_ids.size();
 
   int depth = 0;
-  for (const auto& tree : model.trees) depth = std::max(depth, max_depth(tree));
+  for (int i : tree_ids) depth = std::max(depth, max_depth(model.trees[i]));
   params->depth = depth;
 }
 
-// uses treelite model with additional tl_params to initialize FIL params
-// and dense nodes (stored in *pnodes)
-void tl2fil_dense(std::vector<dense_node_t>* pnodes, forest_params_t* params,
-                  const tl::Model& model, const treelite_params_t* tl_params) {
-  tl2fil_common(params, model, tl_params);
+// uses treelite model with additional tl_params to initialize FIL params,
+// dense nodes (stored in *pnodes) and the categorical sets and node covers
+// (stored in *pextras)
+void tl2fil_dense(std::vector<dense_node_t>* pnodes, forest_extras* pextras,
+                  forest_params_t* params, const tl::Model& model,
+                  const treelite_params_t* tl_params,
+                  const std::vector<int>& tree_ids) {
+  tl2fil_common(params, model, tl_params, tree_ids);
 
   // convert the nodes
   int num_nodes = forest_num_nodes(params->num_trees, params->depth);
   pnodes->resize(num_nodes, dense_node_t{0, 0});
-  for (int i = 0; i < model.trees.size(); ++i) {
-    tree2fil_dense(pnodes, i * tree_num_nodes(params->depth), model.trees[i]);
+  for (int i = 0; i < tree_ids.size(); ++i) {
+    tree2fil_dense(pnodes, pextras, i * tree_num_nodes(params->depth),
+                   model.trees[tree_ids[i]]);
   }
 }
 
 // uses treelite model with additional tl_params to initialize FIL params,
-// trees (stored in *ptrees) and sparse nodes (stored in *pnodes)
-void tl2fil_sparse(std::vector<int>* ptrees, std::vector<sparse_node_t>* pnodes,
-                   forest_params_t* params, const tl::Model& model,
-                   const treelite_params_t* tl_params) {
-  tl2fil_common(params, model, tl_params);
+// trees (stored in *ptrees), sparse nodes (stored in *pnodes)
+// and the categorical sets and node covers (stored in *pextras)
+template <typename node_t>
+void tl2fil_sparse(std::vector<int>* ptrees, std::vector<node_t>* pnodes,
+                   forest_extras* pextras, forest_params_t* params,
+                   const tl::Model& model, const treelite_params_t* tl_params,
+                   const std::vector<int>& tree_ids) {
+  tl2fil_common(params, model, tl_params, tree_ids);
 
   // convert the nodes
-  for (int i = 0; i < model.trees.size(); ++i) {
-    int root = tree2fil_sparse(pnodes, model.trees[i]);
+  for (int i : tree_ids) {
+    int root = tree2fil_sparse(pnodes, pextras, model.trees[i]);
     ptrees->push_back(root);
   }
   params->num_nodes = pnodes->size();
 }
 
-void init_dense(const cumlHandle& h, forest_t* pf, const dense_node_t* nodes,
-                const forest_params_t* params) {
+void init_dense_impl(const cumlHandle& h, forest_t* pf,
+                     const dense_node_t* nodes, const forest_params_t* params,
+                     const forest_extras& extras) {
   check_params(params, true);
   dense_forest* f = new dense_forest;
-  f->init(h, nodes, params);
+  f->init(h, nodes, params, extras);
   *pf = f;
 }
 
-void init_sparse(const cumlHandle& h, forest_t* pf, const int* trees,
-                 const sparse_node_t* nodes, const forest_params_t* params) {
+template <typename node_t>
+void init_sparse_impl(const cumlHandle& h, forest_t* pf, const int* trees,
+                      const node_t* nodes, const forest_params_t* params,
+                      const forest_extras& extras) {
   check_params(params, false);
-  sparse_forest* f = new sparse_forest;
-  f->init(h, trees, nodes, params);
+  sparse_forest<node_t>* f = new sparse_forest<node_t>;
+  f->init(h, trees, nodes, params, extras);
   *pf = f;
 }
 
-void from_treelite(const cumlHandle& handle, forest_t* pforest,
-                   ModelHandle model, const treelite_params_t* tl_params) {
+void init_dense(const cumlHandle& h, forest_t* pf, const dense_node_t* nodes,
+                const forest_params_t* params) {
+  init_dense_impl(h, pf, nodes, params, forest_extras());
+}
+
+void init_sparse(const cumlHandle& h, forest_t* pf, const int* trees,
+                 const sparse_node_t* nodes, const forest_params_t* params) {
+  init_sparse_impl(h, pf, trees, nodes, params, forest_extras());
+}
+
+void init_sparse(const cumlHandle& h, forest_t* pf, const int* trees,
+                 const sparse_node8_t* nodes, const forest_params_t* params) {
+  init_sparse_impl(h, pf, trees, nodes, params, forest_extras());
+}
+
+// from_treelite_sparse imports the model as a sparse forest with node_t nodes
+template <typename node_t>
+void from_treelite_sparse(const cumlHandle& handle, forest_t* pforest,
+                          const tl::Model& model,
+                          const treelite_params_t* tl_params,
+                          const std::vector<int>& tree_ids,
+                          forest_extras* pextras) {
+  forest_params_t params;
+  std::vector<int> trees;
+  std::vector<node_t> nodes;
+  tl2fil_sparse(&trees, &nodes, pextras, &params, model, tl_params, tree_ids);
+  init_sparse_impl(handle, pforest, trees.data(), nodes.data(), &params,
+                   *pextras);
+  // sync is necessary as nodes is used in init_sparse_impl(),
+  // but destructed at the end of this function
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
+// from_treelite_impl imports the trees of model with indices tree_ids
+void from_treelite_impl(const cumlHandle& handle, forest_t* pforest,
+                        const tl::Model& model,
+                        const treelite_params_t* tl_params,
+                        const std::vector<int>& tree_ids,
+                        forest_extras* pextras) {
   storage_type_t storage_type = tl_params->storage_type;
   // build dense trees by default
   if (storage_type == storage_type_t::AUTO) {
@@ -499,29 +1221,102 @@ void from_treelite(const cumlHandle& handle, forest_t* pforest,
     case storage_type_t::DENSE: {
       forest_params_t params;
       std::vector<dense_node_t> nodes;
-      tl2fil_dense(&nodes, &params, *(tl::Model*)model, tl_params);
-      init_dense(handle, pforest, nodes.data(), &params);
+      tl2fil_dense(&nodes, pextras, &params, model, tl_params, tree_ids);
+      init_dense_impl(handle, pforest, nodes.data(), &params, *pextras);
       // sync is necessary as nodes is used in init_dense(),
       // but destructed at the end of this function
       CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
       break;
     }
-    case storage_type_t::SPARSE: {
-      forest_params_t params;
-      std::vector<int> trees;
-      std::vector<sparse_node_t> nodes;
-      tl2fil_sparse(&trees, &nodes, &params, *(tl::Model*)model, tl_params);
-      init_sparse(handle, pforest, trees.data(), nodes.data(), &params);
-      // sync is necessary as nodes is used in init_dense(),
-      // but destructed at the end of this function
-      CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+    case storage_type_t::SPARSE:
+      from_treelite_sparse<sparse_node_t>(handle, pforest, model, tl_params,
+                                          tree_ids, pextras);
+      break;
+    case storage_type_t::SPARSE8:
+      from_treelite_sparse<sparse_node8_t>(handle, pforest, model, tl_params,
+                                           tree_ids, pextras);
       break;
-    }
     default:
-      ASSERT(false, "tl_params->sparse must be one of AUTO, DENSE or SPARSE");
+      ASSERT(false,
+             "tl_params->sparse must be one of AUTO, DENSE, SPARSE or SPARSE8");
   }
 }
 
+void from_treelite(const cumlHandle& handle, forest_t* pforest,
+                   ModelHandle model, const treelite_params_t* tl_params) {
+  const tl::Model& tl_model = *(tl::Model*)model;
+  std::vector<int> tree_ids(tl_model.trees.size());
+  for (int i = 0; i < tree_ids.size(); ++i) tree_ids[i] = i;
+  forest_extras extras;
+  from_treelite_impl(handle, pforest, tl_model, tl_params, tree_ids, &extras);
+}
+
+void from_treelite_mg(const cumlHandle& handle, forest_t* pforest,
+                      ModelHandle model, const treelite_params_t* tl_params,
+                      mg_mode_t mode) {
+  if (mode == mg_mode_t::DATA_PARALLEL) {
+    // each rank holds the whole forest and predicts on its own rows
+    from_treelite(handle, pforest, model, tl_params);
+    return;
+  }
+  ASSERT(mode == mg_mode_t::MODEL_PARALLEL,
+         "mode must be DATA_PARALLEL or MODEL_PARALLEL");
+  const cumlHandle_impl& impl = handle.getImpl();
+  ASSERT(impl.commsInitialized(),
+         "model-parallel forests require a handle with a communicator");
+  const MLCommon::cumlCommunicator& comm = impl.getCommunicator();
+  const tl::Model& tl_model = *(tl::Model*)model;
+
+  // groups of num_output_group consecutive trees, one per class, are
+  // distributed cyclically over the ranks, so that tree i of each shard
+  // still belongs to class i % num_output_group
+  int group_size = tl_model.num_output_group;
+  int num_trees = tl_model.trees.size();
+  ASSERT(num_trees % group_size == 0,
+         "number of trees must be a multiple of num_output_group");
+  int num_groups = num_trees / group_size;
+  std::vector<int> tree_ids;
+  for (int g = comm.getRank(); g < num_groups; g += comm.getSize()) {
+    for (int c = 0; c < group_size; ++c) tree_ids.push_back(g * group_size + c);
+  }
+  forest_extras extras;
+  extras.model_parallel = true;
+  extras.model_trees_per_class = num_groups;
+  from_treelite_impl(handle, pforest, tl_model, tl_params, tree_ids, &extras);
+}
+
+void save(const cumlHandle& h, forest_t f, std::vector<char>* pbytes) {
+  f->save(h, pbytes);
+}
+
+void load(const cumlHandle& h, forest_t* pf, const void* bytes, size_t size) {
+  saved_forest_header hdr;
+  ASSERT(size >= sizeof(hdr), "saved forest is truncated");
+  memcpy(&hdr, bytes, sizeof(hdr));
+  ASSERT(hdr.magic == saved_forest_header::MAGIC, "not a saved FIL forest");
+  ASSERT(hdr.version == saved_forest_header::VERSION,
+         "saved forest has version %d, but only version %d is supported",
+         hdr.version, saved_forest_header::VERSION);
+  forest* f = nullptr;
+  switch (hdr.storage_type) {
+    case storage_type_t::DENSE:
+      f = new dense_forest;
+      break;
+    case storage_type_t::SPARSE:
+      f = new sparse_forest<sparse_node_t>;
+      break;
+    case storage_type_t::SPARSE8:
+      f = new sparse_forest<sparse_node8_t>;
+      break;
+    default:
+      ASSERT(false, "saved forest has an invalid storage type");
+  }
+  f->load(h, hdr, (const char*)bytes, size, sizeof(hdr));
+  // copies must be finished before bytes can be unmapped or freed
+  CUDA_CHECK(cudaStreamSynchronize(h.getStream()));
+  *pf = f;
+}
+
 void free(const cumlHandle& h, forest_t f) {
   f->free(h);
   delete f;
@@ -532,5 +1327,20 @@ void predict(const cumlHandle& h, forest_t f, float* preds, const float* data,
   f->predict(h, preds, data, num_rows);
 }
 
+void predict_host(const cumlHandle& h, forest_t f, float* preds,
+                  const float* data, size_t num_rows, size_t chunk_rows) {
+  f->predict_host(h, preds, data, num_rows, chunk_rows);
+}
+
+void predict_contributions(const cumlHandle& h, forest_t f, float* preds,
+                           const float* data, size_t num_rows) {
+  f->predict_contributions(h, preds, data, num_rows);
+}
+
+void predict_per_tree(const cumlHandle& h, forest_t f, float* preds,
+                      const float* data, size_t num_rows, bool leaf_ids) {
+  f->predict_per_tree(h, preds, data, num_rows, leaf_ids);
+}
+
 }  // namespace fil
 }  // namespace ML
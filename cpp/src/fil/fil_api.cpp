@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include "fil/fil_api.h"
+#include <cuml/cuml_api.h>
+#include <cuml/common/utils.hpp>
+#include <cuml/fil/fil.h>
+#include "common/cumlHandle.hpp"
+
+cumlError_t cumlFilLoad(cumlHandle_t handle, cumlFilForest_t *forest,
+                        const void *bytes, size_t size) {
+  cumlError_t status;
+  ML::cumlHandle *handle_ptr;
+  std::tie(handle_ptr, status) = ML::handleMap.lookupHandlePointer(handle);
+  if (status == CUML_SUCCESS) {
+    try {
+      ML::fil::forest_t f;
+      ML::fil::load(*handle_ptr, &f, bytes, size);
+      *forest = f;
+    } catch (...) {
+      status = CUML_ERROR_UNKNOWN;
+    }
+  }
+  return status;
+}
+
+cumlError_t cumlFilFree(cumlHandle_t handle, cumlFilForest_t forest) {
+  cumlError_t status;
+  ML::cumlHandle *handle_ptr;
+  std::tie(handle_ptr, status) = ML::handleMap.lookupHandlePointer(handle);
+  if (status == CUML_SUCCESS) {
+    try {
+      ML::fil::free(*handle_ptr, (ML::fil::forest_t)forest);
+    } catch (...) {
+      status = CUML_ERROR_UNKNOWN;
+    }
+  }
+  return status;
+}
+
+cumlError_t cumlFilPredictAsync(cumlHandle_t handle, cumlFilForest_t forest,
+                                float *preds, const float *data,
+                                size_t num_rows, cudaEvent_t event) {
+  cumlError_t status;
+  ML::cumlHandle *handle_ptr;
+  std::tie(handle_ptr, status) = ML::handleMap.lookupHandlePointer(handle);
+  if (status == CUML_SUCCESS) {
+    try {
+      ML::fil::predict(*handle_ptr, (ML::fil::forest_t)forest, preds, data,
+                       num_rows);
+      if (event != nullptr) {
+        CUDA_CHECK(cudaEventRecord(event, handle_ptr->getStream()));
+      }
+    } catch (...) {
+      status = CUML_ERROR_UNKNOWN;
+    }
+  }
+  return status;
+}
+
+cumlError_t cumlFilPredictHostAsync(cumlHandle_t handle,
+                                    cumlFilForest_t forest, float *preds,
+                                    const float *data, size_t num_rows,
+                                    size_t chunk_rows, cudaEvent_t event) {
+  cumlError_t status;
+  ML::cumlHandle *handle_ptr;
+  std::tie(handle_ptr, status) = ML::handleMap.lookupHandlePointer(handle);
+  if (status == CUML_SUCCESS) {
+    try {
+      // predict_host rejoins its internal streams on the stream of the handle
+      ML::fil::predict_host(*handle_ptr, (ML::fil::forest_t)forest, preds,
+                            data, num_rows, chunk_rows);
+      if (event != nullptr) {
+        CUDA_CHECK(cudaEventRecord(event, handle_ptr->getStream()));
+      }
+    } catch (...) {
+      status = CUML_ERROR_UNKNOWN;
+    }
+  }
+  return status;
+}
+
+cumlError_t cumlFilPredictBatchAsync(cumlHandle_t handle,
+                                     cumlFilForest_t forest, int n_batches,
+                                     float **preds, const float **data,
+                                     const size_t *num_rows,
+                                     cudaEvent_t event) {
+  cumlError_t status;
+  ML::cumlHandle *handle_ptr;
+  std::tie(handle_ptr, status) = ML::handleMap.lookupHandlePointer(handle);
+  if (status == CUML_SUCCESS) {
+    try {
+      for (int b = 0; b < n_batches; ++b) {
+        ML::fil::predict(*handle_ptr, (ML::fil::forest_t)forest, preds[b],
+                         data[b], num_rows[b]);
+      }
+      if (event != nullptr) {
+        CUDA_CHECK(cudaEventRecord(event, handle_ptr->getStream()));
+      }
+    } catch (...) {
+      status = CUML_ERROR_UNKNOWN;
+    }
+  }
+  return status;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#pragma once
+
+#include <cuml/cuml_api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** cumlFilForest_t is the C handle of a FIL forest */
+typedef void *cumlFilForest_t;
+
+/**
+ * @brief Load a forest saved by ML::fil::save, e.g. from Python or C++
+ * @param[in]  handle  the cumlHandle_t to use
+ * @param[out] forest  the loaded forest
+ * @param[in]  bytes   the saved forest, in host memory
+ * @param[in]  size    size of bytes, in bytes
+ * @returns CUML_SUCCESS on success
+ */
+cumlError_t cumlFilLoad(cumlHandle_t handle, cumlFilForest_t *forest,
+                        const void *bytes, size_t size);
+
+/**
+ * @brief Free a forest of cumlFilLoad
+ * @param[in] handle  the cumlHandle_t to use
+ * @param[in] forest  the forest to free
+ * @returns CUML_SUCCESS on success
+ */
+cumlError_t cumlFilFree(cumlHandle_t handle, cumlFilForest_t forest);
+
+/**
+ * @brief Enqueue the predictions of the forest on the stream of the handle,
+ * see ML::fil::predict, without waiting for them
+ * @param[in]  handle    the cumlHandle_t to use
+ * @param[in]  forest    the forest to predict with
+ * @param[out] preds     device array of the predictions
+ * @param[in]  data      device array of the rows (row-major)
+ * @param[in]  num_rows  number of rows
+ * @param[in]  event     if not NULL, recorded on the stream of the handle
+ *                       after the predictions, for the caller to query or
+ *                       synchronize with
+ * @returns CUML_SUCCESS on success
+ */
+cumlError_t cumlFilPredictAsync(cumlHandle_t handle, cumlFilForest_t forest,
+                                float *preds, const float *data,
+                                size_t num_rows, cudaEvent_t event);
+
+/**
+ * @brief cumlFilPredictAsync on host arrays, see ML::fil::predict_host; the
+ * copies are only asynchronous if preds and data are in pinned memory
+ * @param[in]  chunk_rows  number of rows of a chunk, 0 for the default
+ * See cumlFilPredictAsync for the other params
+ */
+cumlError_t cumlFilPredictHostAsync(cumlHandle_t handle,
+                                    cumlFilForest_t forest, float *preds,
+                                    const float *data, size_t num_rows,
+                                    size_t chunk_rows, cudaEvent_t event);
+
+/**
+ * @brief cumlFilPredictAsync on n_batches batches of rows at once, the
+ * predictions of batch b of num_rows[b] rows data[b] going to preds[b], so
+ * that a service pays for one call and one event per group of requests
+ * @param[in] preds  host array of the prediction arrays (dim = n_batches)
+ * @param[in] data   host array of the row arrays (dim = n_batches)
+ * @param[in] event  if not NULL, recorded after the last batch
+ * See cumlFilPredictAsync for the other params
+ */
+cumlError_t cumlFilPredictBatchAsync(cumlHandle_t handle,
+                                     cumlFilForest_t forest, int n_batches,
+                                     float **preds, const float **data,
+                                     const size_t *num_rows,
+                                     cudaEvent_t event);
+
+#ifdef __cplusplus
+}
+#endif
@@ -37,9 +37,24 @@ struct vec {
   }
 };
 
-template <int NITEMS, typename tree_type>
-__device__ __forceinline__ void infer_one_tree(tree_type tree, float* sdata,
-                                               int cols, vec<NITEMS>& out) {
+/** load_feature loads feature i of a row; rows cached in shared memory
+    are read directly, and rows in global memory through the read-only
+    data cache */
+template <bool ROWS_IN_SHMEM>
+__device__ __forceinline__ float load_feature(const float* row, int i) {
+  return row[i];
+}
+
+template <>
+__device__ __forceinline__ float load_feature<false>(const float* row, int i) {
+  return __ldg(row + i);
+}
+
+template <int NITEMS, bool ROWS_IN_SHMEM, typename tree_type>
+__device__ __forceinline__ void infer_one_tree(tree_type tree,
+                                               const float* sdata, int cols,
+                                               const unsigned* cat_sets,
+                                               vec<NITEMS>& out) {
   int curr[NITEMS];
   int mask = (1 << NITEMS) - 1;  // all active
   for (int j = 0; j < NITEMS; ++j) curr[j] = 0;
@@ -52,51 +67,89 @@ __device__ __forceinline__ void infer_one_tree(tree_type tree, float* sdata,
         mask &= ~(1 << j);
         continue;
       }
-      float val = sdata[j * cols + n.fid()];
-      bool cond = isnan(val) ? !n.def_left() : val >= n.thresh();
-      curr[j] = n.left(curr[j]) + cond;
+      float val = load_feature<ROWS_IN_SHMEM>(sdata, j * cols + n.fid());
+      curr[j] = n.left(curr[j]) + go_right(n, val, cat_sets);
     }
   } while (mask != 0);
 #pragma unroll
   for (int j = 0; j < NITEMS; ++j) out[j] += tree[curr[j]].output();
 }
 
-template <typename tree_type>
-__device__ __forceinline__ void infer_one_tree(tree_type tree, float* sdata,
-                                               int cols, vec<1>& out) {
-  int curr = 0;
-  for (;;) {
-    auto n = tree[curr];
-    if (n.is_leaf()) break;
-    float val = sdata[n.fid()];
-    bool cond = isnan(val) ? !n.def_left() : val >= n.thresh();
-    curr = n.left(curr) + cond;
+/** infer_classes sums the outputs of the trees of each class in turn,
+    reducing over the block in a fixed order so that the predictions do not
+    depend on thread scheduling, and stores the sums in shared memory
+    (sout, NITEMS x num_classes) before writing them into the predictions */
+template <int NITEMS, bool ROWS_IN_SHMEM, int TPB, typename storage_type>
+__device__ __forceinline__ void infer_classes(storage_type forest,
+                                              predict_params params,
+                                              const float* sdata,
+                                              float* sout) {
+  int num_classes = params.num_classes;
+  using BlockReduce = cub::BlockReduce<vec<NITEMS>, TPB>;
+  __shared__ typename BlockReduce::TempStorage tmp_storage;
+  for (int c = 0; c < num_classes; ++c) {
+    // tree j belongs to class j % num_classes
+    vec<NITEMS> out;
+    for (int i = 0; i < NITEMS; ++i) out[i] = 0.0f;
+    for (int j = c + threadIdx.x * num_classes; j < forest.num_trees();
+         j += blockDim.x * num_classes) {
+      infer_one_tree<NITEMS, ROWS_IN_SHMEM>(forest[j], sdata, params.num_cols,
+                                            params.cat_sets, out);
+    }
+    out = BlockReduce(tmp_storage).Sum(out);
+    if (threadIdx.x == 0) {
+      for (int i = 0; i < NITEMS; ++i) sout[i * num_classes + c] = out[i];
+    }
+    // tmp_storage is reused for the next class
+    __syncthreads();
+  }
+  for (int i = threadIdx.x; i < NITEMS * num_classes; i += blockDim.x) {
+    size_t row = blockIdx.x * NITEMS + i / num_classes;
+    if (row < params.num_rows)
+      params.preds[row * num_classes + i % num_classes] = sout[i];
   }
-  out[0] = tree[curr].output();
 }
 
-template <int NITEMS, typename storage_type>
+/** infer_k predicts NITEMS rows per thread block; if ROWS_IN_SHMEM is true,
+    the rows are cached in shared memory, otherwise (for rows too wide
+    to fit into shared memory) they are read from global memory, and then
+    NITEMS must be 1; TPB is the number of threads per block */
+template <int NITEMS, bool ROWS_IN_SHMEM, int TPB, typename storage_type>
 __global__ void infer_k(storage_type forest, predict_params params) {
-  // cache the row for all threads to reuse
   extern __shared__ char smem[];
-  float* sdata = (float*)smem;
   size_t rid = blockIdx.x * NITEMS;
-  for (int j = 0; j < NITEMS; ++j) {
-    for (int i = threadIdx.x; i < params.num_cols; i += blockDim.x) {
-      size_t row = rid + j;
-      sdata[j * params.num_cols + i] =
-        row < params.num_rows ? params.data[row * params.num_cols + i] : 0.0f;
+  const float* sdata = params.data + rid * params.num_cols;
+  // per-class sums for multi-class forests are stored after the rows
+  float* sout = (float*)smem;
+  if (ROWS_IN_SHMEM) {
+    // cache the row for all threads to reuse
+    float* srows = (float*)smem;
+    for (int j = 0; j < NITEMS; ++j) {
+      for (int i = threadIdx.x; i < params.num_cols; i += blockDim.x) {
+        size_t row = rid + j;
+        srows[j * params.num_cols + i] =
+          row < params.num_rows ? params.data[row * params.num_cols + i]
+                                : 0.0f;
+      }
     }
+    sdata = srows;
+    sout = srows + NITEMS * params.num_cols;
   }
   __syncthreads();
 
+  if (params.num_classes > 1) {
+    infer_classes<NITEMS, ROWS_IN_SHMEM, TPB>(forest, params, sdata, sout);
+    return;
+  }
+
   // one block works on a single row and the whole forest
   vec<NITEMS> out;
   for (int i = 0; i < NITEMS; ++i) out[i] = 0.0f;
   for (int j = threadIdx.x; j < forest.num_trees(); j += blockDim.x) {
-    infer_one_tree<NITEMS>(forest[j], sdata, params.num_cols, out);
+    infer_one_tree<NITEMS, ROWS_IN_SHMEM>(forest[j], sdata, params.num_cols,
+                                          params.cat_sets, out);
   }
-  using BlockReduce = cub::BlockReduce<vec<NITEMS>, FIL_TPB>;
+  using BlockReduce = cub::BlockReduce<vec<NITEMS>, TPB>;
   __shared__ typename BlockReduce::TempStorage tmp_storage;
   out = BlockReduce(tmp_storage).Sum(out);
   if (threadIdx.x == 0) {
@@ -107,43 +160,179 @@ __global__ void infer_k(storage_type forest, predict_params params) {
   }
 }
 
+/** infer_k_launcher launches infer_k with params.threads_per_block threads
+    per block */
+template <int NITEMS, bool ROWS_IN_SHMEM, typename storage_type>
+void infer_k_launcher(storage_type forest, predict_params params,
+                      int num_blocks, int shm_sz, cudaStream_t stream) {
+  switch (params.threads_per_block) {
+    case 64:
+      infer_k<NITEMS, ROWS_IN_SHMEM, 64>
+        <<<num_blocks, 64, shm_sz, stream>>>(forest, params);
+      break;
+    case 128:
+      infer_k<NITEMS, ROWS_IN_SHMEM, 128>
+        <<<num_blocks, 128, shm_sz, stream>>>(forest, params);
+      break;
+    case 256:
+      infer_k<NITEMS, ROWS_IN_SHMEM, 256>
+        <<<num_blocks, 256, shm_sz, stream>>>(forest, params);
+      break;
+    default:
+      ASSERT(false, "internal error: threads_per_block must be 64, 128 or 256");
+  }
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
 template <typename storage_type>
 void infer(storage_type forest, predict_params params, cudaStream_t stream) {
-  const int MAX_BATCH_ITEMS = 4;
-  params.max_items =
-    params.algo == algo_t::BATCH_TREE_REORG ? MAX_BATCH_ITEMS : 1;
-  int num_items = params.max_shm / (sizeof(float) * params.num_cols);
+  // each row needs num_cols floats for the features, and, for multi-class
+  // forests, num_classes floats for the per-class sums
+  int class_floats = params.num_classes > 1 ? params.num_classes : 0;
+  int row_floats = params.num_cols + class_floats;
+  int num_items = params.max_shm / (sizeof(float) * row_floats);
   if (num_items == 0) {
-    int max_cols = params.max_shm / sizeof(float);
-    ASSERT(false, "p.num_cols == %d: too many features, only %d allowed",
-           params.num_cols, max_cols);
+    // the row does not fit into shared memory; read it from global memory,
+    // and only keep the per-class sums in shared memory
+    int shm_sz = class_floats * sizeof(float);
+    ASSERT(shm_sz <= params.max_shm,
+           "p.num_classes == %d: too many classes, only %d allowed",
+           params.num_classes, int(params.max_shm / sizeof(float)));
+    infer_k_launcher<1, false>(forest, params, params.num_rows, shm_sz,
+                               stream);
+    return;
   }
   num_items = std::min(num_items, params.max_items);
   int num_blocks = ceildiv(int(params.num_rows), num_items);
-  int shm_sz = num_items * sizeof(float) * params.num_cols;
+  int shm_sz = num_items * sizeof(float) * row_floats;
   switch (num_items) {
     case 1:
-      infer_k<1><<<num_blocks, FIL_TPB, shm_sz, stream>>>(forest, params);
+      infer_k_launcher<1, true>(forest, params, num_blocks, shm_sz, stream);
       break;
     case 2:
-      infer_k<2><<<num_blocks, FIL_TPB, shm_sz, stream>>>(forest, params);
+      infer_k_launcher<2, true>(forest, params, num_blocks, shm_sz, stream);
       break;
     case 3:
-      infer_k<3><<<num_blocks, FIL_TPB, shm_sz, stream>>>(forest, params);
+      infer_k_launcher<3, true>(forest, params, num_blocks, shm_sz, stream);
       break;
     case 4:
-      infer_k<4><<<num_blocks, FIL_TPB, shm_sz, stream>>>(forest, params);
+      infer_k_launcher<4, true>(forest, params, num_blocks, shm_sz, stream);
       break;
     default:
       ASSERT(false, "internal error: nitems > 4");
   }
+}
+
+/** contrib_k computes the contributions for a single row per thread block,
+    with the trees distributed cyclically between the threads; params.preds
+    must be zero-initialized */
+template <typename storage_type>
+__global__ void contrib_k(storage_type forest, const float* node_vals,
+                          predict_params params, float scale,
+                          float global_bias) {
+  size_t row = blockIdx.x;
+  int num_cols = params.num_cols;
+  const float* data = params.data + row * num_cols;
+  float* row_contribs =
+    params.preds + row * params.num_classes * (num_cols + 1);
+  for (int j = threadIdx.x; j < forest.num_trees(); j += blockDim.x) {
+    auto tree = forest[j];
+    float* contribs = row_contribs + (j % params.num_classes) * (num_cols + 1);
+    int curr = 0;
+    float curr_val = node_vals[&tree[curr] - forest.nodes_];
+    // the expected value of the tree goes into the bias term
+    atomicAdd(&contribs[num_cols], curr_val * scale);
+    for (;;) {
+      auto n = tree[curr];
+      if (n.is_leaf()) break;
+      float val = __ldg(data + n.fid());
+      curr = n.left(curr) + go_right(n, val, params.cat_sets);
+      float next_val = node_vals[&tree[curr] - forest.nodes_];
+      atomicAdd(&contribs[n.fid()], (next_val - curr_val) * scale);
+      curr_val = next_val;
+    }
+  }
+  for (int c = threadIdx.x; c < params.num_classes; c += blockDim.x) {
+    atomicAdd(&row_contribs[c * (num_cols + 1) + num_cols], global_bias);
+  }
+}
+
+template <typename storage_type>
+void contributions(storage_type forest, const float* node_vals,
+                   predict_params params, float scale, float global_bias,
+                   cudaStream_t stream) {
+  size_t num_contribs =
+    params.num_rows * params.num_classes * (params.num_cols + 1);
+  CUDA_CHECK(cudaMemsetAsync(params.preds, 0, sizeof(float) * num_contribs,
+                             stream));
+  if (params.num_rows == 0) return;
+  contrib_k<<<params.num_rows, FIL_TPB, 0, stream>>>(forest, node_vals, params,
+                                                     scale, global_bias);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/** per_tree_k computes the output (or leaf index) of a single tree for
+    a single row per thread, with consecutive threads handling consecutive
+    trees of a row */
+template <typename storage_type>
+__global__ void per_tree_k(storage_type forest, predict_params params,
+                           bool leaf_ids) {
+  size_t i = threadIdx.x + size_t(blockIdx.x) * blockDim.x;
+  int num_trees = forest.num_trees();
+  if (i >= params.num_rows * num_trees) return;
+  size_t row = i / num_trees;
+  const float* data = params.data + row * params.num_cols;
+  auto tree = forest[i % num_trees];
+  int curr = 0;
+  for (;;) {
+    auto n = tree[curr];
+    if (n.is_leaf()) break;
+    float val = __ldg(data + n.fid());
+    curr = n.left(curr) + go_right(n, val, params.cat_sets);
+  }
+  params.preds[i] = leaf_ids ? float(curr) : tree[curr].output();
+}
+
+template <typename storage_type>
+void per_tree(storage_type forest, predict_params params, bool leaf_ids,
+              cudaStream_t stream) {
+  size_t num_outputs = params.num_rows * forest.num_trees();
+  if (num_outputs == 0) return;
+  per_tree_k<<<ceildiv(num_outputs, size_t(FIL_TPB)), FIL_TPB, 0, stream>>>(
+    forest, params, leaf_ids);
   CUDA_CHECK(cudaPeekAtLastError());
 }
 
 template void infer<dense_storage>(dense_storage forest, predict_params params,
                                    cudaStream_t stream);
-template void infer<sparse_storage>(sparse_storage forest,
-                                    predict_params params, cudaStream_t stream);
+template void infer<sparse_storage<sparse_node>>(
+  sparse_storage<sparse_node> forest, predict_params params,
+  cudaStream_t stream);
+template void infer<sparse_storage<sparse_node8>>(
+  sparse_storage<sparse_node8> forest, predict_params params,
+  cudaStream_t stream);
+
+template void contributions<dense_storage>(dense_storage forest,
+                                           const float* node_vals,
+                                           predict_params params, float scale,
+                                           float global_bias,
+                                           cudaStream_t stream);
+template void contributions<sparse_storage<sparse_node>>(
+  sparse_storage<sparse_node> forest, const float* node_vals,
+  predict_params params, float scale, float global_bias, cudaStream_t stream);
+template void contributions<sparse_storage<sparse_node8>>(
+  sparse_storage<sparse_node8> forest, const float* node_vals,
+  predict_params params, float scale, float global_bias, cudaStream_t stream);
+
+template void per_tree<dense_storage>(dense_storage forest,
+                                      predict_params params, bool leaf_ids,
+                                      cudaStream_t stream);
+template void per_tree<sparse_storage<sparse_node>>(
+  sparse_storage<sparse_node> forest, predict_params params, bool leaf_ids,
+  cudaStream_t stream);
+template void per_tree<sparse_storage<sparse_node8>>(
+  sparse_storage<sparse_node8> forest, predict_params params, bool leaf_ids,
+  cudaStream_t stream);
 
 }  // namespace fil
 }  // namespace ML
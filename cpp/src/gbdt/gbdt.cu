@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuml/ensemble/gbdt.hpp>
+#include <iostream>
+#include <string>
+#include "gbdt_impl.cuh"
+
+namespace ML {
+
+/**
+ * @brief Set GBDT_params parameters members; use default tree parameters.
+ * @param[in,out] params: update with GBDT parameters
+ * @param[in] cfg_n_estimators: number of trees; default 100
+ * @param[in] cfg_learning_rate: shrinkage of the leaf values; default 0.1f
+ * @param[in] cfg_loss: loss; default SQUARED_ERROR
+ * @param[in] cfg_lambda: L2 regularization of the leaf values; default 1.0f
+ * @param[in] cfg_min_child_weight: minimum hessian sum of each child of a
+ *            split; default 1.0f
+ */
+void set_gbdt_params(GBDT_params& params, int cfg_n_estimators,
+                     float cfg_learning_rate, GBDT_loss cfg_loss,
+                     float cfg_lambda, float cfg_min_child_weight) {
+  params.n_estimators = cfg_n_estimators;
+  params.learning_rate = cfg_learning_rate;
+  params.loss = cfg_loss;
+  params.lambda = cfg_lambda;
+  params.min_child_weight = cfg_min_child_weight;
+  DecisionTree::set_tree_params(params.tree_params, 6);
+}
+
+/**
+ * @brief Check validity of all GBDT hyper-parameters.
+ * @param[in] params: GBDT hyper-parameters
+ */
+void validity_check(const GBDT_params params) {
+  ASSERT((params.n_estimators > 0), "Invalid n_estimators %d",
+         params.n_estimators);
+  ASSERT((params.learning_rate > 0), "Invalid learning_rate %f",
+         params.learning_rate);
+  ASSERT((params.lambda >= 0), "Invalid lambda %f", params.lambda);
+  ASSERT((params.min_child_weight >= 0), "Invalid min_child_weight %f",
+         params.min_child_weight);
+  ASSERT(!params.tree_params.bootstrap_features,
+         "bootstrap_features is not supported by GBDT");
+  ASSERT(params.tree_params.stream_cols == 0,
+         "stream_cols is not supported by GBDT");
+  DecisionTree::validity_check(params.tree_params);
+}
+
+/**
+ * @brief Print all GBDT hyper-parameters.
+ * @param[in] params: GBDT hyper-parameters
+ */
+void print(const GBDT_params params) {
+  std::cout << "n_estimators: " << params.n_estimators << std::endl;
+  std::cout << "learning_rate: " << params.learning_rate << std::endl;
+  std::cout << "loss: "
+            << (params.loss == GBDT_loss::LOGISTIC ? "logistic"
+                                                    : "squared_error")
+            << std::endl;
+  std::cout << "lambda: " << params.lambda << std::endl;
+  std::cout << "min_child_weight: " << params.min_child_weight << std::endl;
+  DecisionTree::print(params.tree_params);
+}
+
+/**
+ * @brief Build a treelite model of a gradient boosted model.
+ * @tparam T: data type for input data (float or double).
+ * @param[out] model: treelite model.
+ * @param[in] gbdt: CPU pointer to the GBDTModel.
+ * @param[in] num_features: number of features.
+ */
+template <class T>
+void build_treelite_gbdt(ModelHandle* model, const GBDTModel<T>* gbdt,
+                         int num_features) {
+  // The trees of a gradient boosted model are summed, not averaged
+  int random_forest_flag = 0;
+  int num_output_group = 1;
+  ModelBuilderHandle model_builder;
+  TREELITE_CHECK(TreeliteCreateModelBuilder(
+    num_features, num_output_group, random_forest_flag, &model_builder));
+  if (gbdt->params.loss == GBDT_loss::LOGISTIC) {
+    TREELITE_CHECK(TreeliteModelBuilderSetModelParam(
+      model_builder, "pred_transform", "sigmoid"));
+  }
+  std::string base_score = std::to_string(gbdt->base_score);
+  TREELITE_CHECK(TreeliteModelBuilderSetModelParam(model_builder, "global_bias",
+                                                   base_score.c_str()));
+
+  for (const DecisionTree::TreeMetaDataNode<T, T>& tree : gbdt->trees) {
+    if (tree.sparsetree.size() == 0) continue;
+    TreeBuilderHandle tree_builder;
+    TREELITE_CHECK(TreeliteCreateTreeBuilder(&tree_builder));
+    DecisionTree::build_treelite_tree<T, T>(tree_builder, &tree,
+                                            num_output_group);
+    // The third argument -1 means append to the end of the tree list.
+    TREELITE_CHECK(
+      TreeliteModelBuilderInsertTree(model_builder, tree_builder, -1));
+  }
+
+  TREELITE_CHECK(TreeliteModelBuilderCommitModel(model_builder, model));
+  TREELITE_CHECK(TreeliteDeleteModelBuilder(model_builder));
+}
+
+/**
+ * @defgroup GBDTFit Fit a gradient boosted model
+ * @brief Each tree is grown on the gradients and hessians of the loss at the
+ *   predictions of the previous trees.
+ * @param[in] user_handle: cumlHandle
+ * @param[out] model: fitted model.
+ * @param[in] input: train data (n_rows samples, n_cols features) in column major format. Device pointer.
+ * @param[in] n_rows: number of training data samples.
+ * @param[in] n_cols: number of features.
+ * @param[in] labels: n_rows labels; 0 or 1 for the logistic loss. Device pointer.
+ * @param[in] params: GBDT hyper-parameters.
+ * @{
+ */
+void fit(const cumlHandle& user_handle, GBDTModelF& model, const float* input,
+         int n_rows, int n_cols, const float* labels, GBDT_params params) {
+  gbdt_fit(user_handle, model, input, n_rows, n_cols, labels, params);
+}
+
+void fit(const cumlHandle& user_handle, GBDTModelD& model, const double* input,
+         int n_rows, int n_cols, const double* labels, GBDT_params params) {
+  gbdt_fit(user_handle, model, input, n_rows, n_cols, labels, params);
+}
+/** @} */
+
+/**
+ * @defgroup GBDTPredict Predict with a gradient boosted model
+ * @param[in] user_handle: cumlHandle
+ * @param[in] model: fitted model.
+ * @param[in] input: test data (n_rows samples, n_cols features) in row major format. Device pointer.
+ * @param[in] n_rows: number of data samples.
+ * @param[in] n_cols: number of features.
+ * @param[out] predictions: n_rows predictions; probabilities of the label 1 for the logistic loss. Device pointer, user allocated.
+ * @{
+ */
+void predict(const cumlHandle& user_handle, const GBDTModelF& model,
+             const float* input, int n_rows, int n_cols, float* predictions) {
+  gbdt_predict(user_handle, model, input, n_rows, n_cols, predictions);
+}
+
+void predict(const cumlHandle& user_handle, const GBDTModelD& model,
+             const double* input, int n_rows, int n_cols,
+             double* predictions) {
+  gbdt_predict(user_handle, model, input, n_rows, n_cols, predictions);
+}
+/** @} */
+
+template void build_treelite_gbdt<float>(ModelHandle* model,
+                                         const GBDTModel<float>* gbdt,
+                                         int num_features);
+template void build_treelite_gbdt<double>(ModelHandle* model,
+                                          const GBDTModel<double>* gbdt,
+                                          int num_features);
+
+}  // namespace ML
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <thrust/fill.h>
+#include <thrust/sequence.h>
+#include <algorithm>
+#include <cmath>
+#include <cuml/ensemble/gbdt.hpp>
+#include <vector>
+#include "../decisiontree/decisiontree_impl.h"
+#include "../decisiontree/memory.h"
+#include "../decisiontree/quantile/quantile.h"
+#include "../randomforest/predict_kernels.cuh"
+#include "common/cumlHandle.hpp"
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "stats/mean.h"
+
+namespace ML {
+
+/**
+ * @brief Gradient and hessian of the loss at the margin of each row.
+ */
+template <class T>
+__global__ void gbdt_gradient_kernel(const T* margin, const T* labels,
+                                     int n_rows, GBDT_loss loss, T* grad,
+                                     T* hess) {
+  int row = threadIdx.x + blockIdx.x * blockDim.x;
+  if (row >= n_rows) return;
+  T m = margin[row];
+  if (loss == GBDT_loss::LOGISTIC) {
+    T p = 1 / (1 + exp(-m));
+    grad[row] = p - labels[row];
+    hess[row] = max(p * (1 - p), (T)1e-16);
+  } else {
+    grad[row] = m - labels[row];
+    hess[row] = 1;
+  }
+}
+
+/**
+ * @brief Add the leaf value of tree to the margin of each row of the
+ *        n_rows x n_cols column major input.
+ */
+template <class T>
+__global__ void gbdt_update_kernel(const FlatTreeNode<T, T>* tree,
+                                   const T* input, int n_rows, T* margin) {
+  int row = threadIdx.x + blockIdx.x * blockDim.x;
+  if (row >= n_rows) return;
+  int idx = 0;
+  while (tree[idx].colid != -1) {
+    const FlatTreeNode<T, T>& node = tree[idx];
+    T val = input[row + size_t(node.colid) * n_rows];
+    idx = node.left_child_id + (val <= node.quesval ? 0 : 1);
+  }
+  margin[row] += tree[idx].prediction;
+}
+
+/**
+ * @brief Sum of base_score and of the leaf values of the trees, through a
+ *        sigmoid if logistic, one row of the row major input per thread.
+ */
+template <class T>
+__global__ void gbdt_predict_kernel(const FlatTreeNode<T, T>* nodes,
+                                    const int* roots, int n_trees,
+                                    const T* input, int n_rows, int n_cols,
+                                    T base_score, bool logistic,
+                                    T* predictions) {
+  int row = threadIdx.x + blockIdx.x * blockDim.x;
+  if (row >= n_rows) return;
+  const T* x = input + size_t(row) * n_cols;
+  T sum = base_score;
+  for (int i = 0; i < n_trees; i++) sum += predict_tree(nodes + roots[i], x);
+  predictions[row] = logistic ? 1 / (1 + exp(-sum)) : sum;
+}
+
+template <class T>
+void flatten_tree(const std::vector<SparseTreeNode<T, T>>& tree,
+                  std::vector<FlatTreeNode<T, T>>& nodes) {
+  for (const SparseTreeNode<T, T>& node : tree) {
+    FlatTreeNode<T, T> flat = {node.quesval, node.prediction, node.colid,
+                               node.left_child_id};
+    nodes.push_back(flat);
+  }
+}
+
+/**
+ * @brief Initial margin of the rows: the mean of the labels, or its log
+ *        odds for the logistic loss.
+ */
+template <class T>
+T gbdt_base_score(const cumlHandle_impl& handle, const T* labels, int n_rows,
+                  GBDT_loss loss) {
+  cudaStream_t stream = handle.getStream();
+  MLCommon::device_buffer<T> d_mean(handle.getDeviceAllocator(), stream, 1);
+  MLCommon::Stats::mean(d_mean.data(), labels, 1, n_rows, false, false,
+                        stream);
+  T mean;
+  MLCommon::updateHost(&mean, d_mean.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  d_mean.release(stream);
+  if (loss != GBDT_loss::LOGISTIC) return mean;
+  const T eps = 1e-6;
+  mean = std::min(std::max(mean, eps), 1 - eps);
+  return std::log(mean / (1 - mean));
+}
+
+/**
+ * @brief Fit a gradient boosted model: each tree is grown on the gradients
+ *        and hessians of the loss at the margins of the previous trees, on
+ *        all the rows.
+ * @tparam T: data type for input data (float or double).
+ * @param[in] user_handle: cumlHandle
+ * @param[out] model: fitted model.
+ * @param[in] input: train data (n_rows samples, n_cols features) in column major format. Device pointer.
+ * @param[in] n_rows: number of training data samples.
+ * @param[in] n_cols: number of features.
+ * @param[in] labels: n_rows labels; 0 or 1 for the logistic loss. Device pointer.
+ * @param[in] params: GBDT hyper-parameters.
+ */
+template <class T>
+void gbdt_fit(const cumlHandle& user_handle, GBDTModel<T>& model,
+              const T* input, int n_rows, int n_cols, const T* labels,
+              GBDT_params params) {
+  validity_check(params);
+  ASSERT(input != nullptr, "GBDT Error: input is null");
+  ASSERT(labels != nullptr, "GBDT Error: labels is null");
+  ASSERT((n_rows > 0) && (n_cols > 0),
+         "Invalid n_rows %d and/or n_cols %d", n_rows, n_cols);
+  const cumlHandle_impl& handle = user_handle.getImpl();
+  cudaStream_t stream = handle.getStream();
+  std::shared_ptr<deviceAllocator> d_alloc = handle.getDeviceAllocator();
+  const DecisionTree::DecisionTreeParams& tree_params = params.tree_params;
+  const int TPB = 256;
+  int n_blocks = MLCommon::ceildiv(n_rows, TPB);
+
+  model.params = params;
+  model.trees.clear();
+  model.trees.resize(params.n_estimators);
+  model.base_score = gbdt_base_score(handle, labels, n_rows, params.loss);
+
+  MLCommon::device_buffer<T> margin(d_alloc, stream, n_rows);
+  MLCommon::device_buffer<T> grad(d_alloc, stream, n_rows);
+  MLCommon::device_buffer<T> hess(d_alloc, stream, n_rows);
+  MLCommon::device_buffer<unsigned int> rowids(d_alloc, stream, n_rows);
+  MLCommon::device_buffer<FlatTreeNode<T, T>> nodes(d_alloc, stream, 0);
+  thrust::fill(thrust::cuda::par.on(stream), margin.data(),
+               margin.data() + n_rows, model.base_score);
+  thrust::sequence(thrust::cuda::par.on(stream), rowids.data(),
+                   rowids.data() + n_rows);
+
+  std::shared_ptr<TemporaryMemory<T, T>> tempmem =
+    std::make_shared<TemporaryMemory<T, T>>(
+      handle, stream, n_rows, n_cols, tree_params.max_features, 1,
+      tree_params.n_bins, tree_params.split_algo, tree_params.max_depth,
+      tree_params.shuffle_features);
+  //Preprocess once only per model
+  MLCommon::device_buffer<char> bins(d_alloc, stream, 0);
+  if (tree_params.split_algo == SPLIT_ALGO::GLOBAL_QUANTILE) {
+    preprocess_quantile(input, nullptr, n_rows, n_cols, n_rows,
+                        tree_params.n_bins, tempmem);
+    if (tree_params.quantize) {
+      quantize_data(input, n_rows, n_cols, tree_params.n_bins, &tempmem, 1,
+                    bins);
+    }
+  }
+
+  std::vector<FlatTreeNode<T, T>> h_nodes;
+  for (int i = 0; i < params.n_estimators; i++) {
+    gbdt_gradient_kernel<<<n_blocks, TPB, 0, stream>>>(
+      margin.data(), labels, n_rows, params.loss, grad.data(), hess.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    DecisionTree::TreeMetaDataNode<T, T>* tree = &model.trees[i];
+    tree->treeid = i;
+    DecisionTree::grow_gbdt_tree(input, grad.data(), hess.data(),
+                                 rowids.data(), n_rows, n_cols, n_rows,
+                                 tree_params, params.lambda,
+                                 params.min_child_weight, params.learning_rate,
+                                 tree, tempmem);
+
+    h_nodes.clear();
+    flatten_tree(tree->sparsetree, h_nodes);
+    nodes.resize(h_nodes.size(), stream);
+    MLCommon::updateDevice(nodes.data(), h_nodes.data(), h_nodes.size(),
+                           stream);
+    gbdt_update_kernel<<<n_blocks, TPB, 0, stream>>>(nodes.data(), input,
+                                                     n_rows, margin.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+    // h_nodes must outlive its copy to the device
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  tempmem.reset();
+  bins.release(stream);
+  nodes.release(stream);
+  rowids.release(stream);
+  hess.release(stream);
+  grad.release(stream);
+  margin.release(stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+}
+
+/**
+ * @brief Predict with a gradient boosted model on the GPU.
+ * @tparam T: data type for input data (float or double).
+ * @param[in] user_handle: cumlHandle
+ * @param[in] model: fitted model.
+ * @param[in] input: test data (n_rows samples, n_cols features) in row major format. Device pointer.
+ * @param[in] n_rows: number of data samples.
+ * @param[in] n_cols: number of features.
+ * @param[out] predictions: n_rows predictions; probabilities of the label 1 for the logistic loss. Device pointer, user allocated.
+ */
+template <class T>
+void gbdt_predict(const cumlHandle& user_handle, const GBDTModel<T>& model,
+                  const T* input, int n_rows, int n_cols, T* predictions) {
+  ASSERT(input != nullptr, "GBDT Error: input is null");
+  ASSERT(predictions != nullptr, "GBDT Error: predictions is null");
+  ASSERT((n_rows > 0) && (n_cols > 0),
+         "Invalid n_rows %d and/or n_cols %d", n_rows, n_cols);
+  const cumlHandle_impl& handle = user_handle.getImpl();
+  cudaStream_t stream = handle.getStream();
+  std::shared_ptr<deviceAllocator> d_alloc = handle.getDeviceAllocator();
+  const int TPB = 256;
+
+  std::vector<FlatTreeNode<T, T>> h_nodes;
+  std::vector<int> h_roots;
+  for (int i = 0; i < (int)model.trees.size(); i++) {
+    ASSERT(model.trees[i].sparsetree.size() != 0,
+           "Cannot predict w/ empty tree %d", i);
+    h_roots.push_back(h_nodes.size());
+    flatten_tree(model.trees[i].sparsetree, h_nodes);
+  }
+  int n_trees = h_roots.size();
+
+  MLCommon::device_buffer<FlatTreeNode<T, T>> nodes(d_alloc, stream,
+                                                    h_nodes.size());
+  MLCommon::device_buffer<int> roots(d_alloc, stream, n_trees);
+  MLCommon::updateDevice(nodes.data(), h_nodes.data(), h_nodes.size(), stream);
+  MLCommon::updateDevice(roots.data(), h_roots.data(), n_trees, stream);
+
+  gbdt_predict_kernel<<<MLCommon::ceildiv(n_rows, TPB), TPB, 0, stream>>>(
+    nodes.data(), roots.data(), n_trees, input, n_rows, n_cols,
+    model.base_score, model.params.loss == GBDT_loss::LOGISTIC, predictions);
+  CUDA_CHECK(cudaPeekAtLastError());
+  // the host copies of the trees must outlive the copies to the device
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+}
+
+}  // namespace ML
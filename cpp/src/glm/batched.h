@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <linalg/cublas_wrappers.h>
+#include <linalg/cusolver_wrappers.h>
+#include <matrix/batched_matrix.hpp>
+#include <stats/mean.h>
+#include <stats/mean_center.h>
+#include <algorithm>
+#include <vector>
+#include "common/cumlHandle.hpp"
+#include "common/device_buffer.hpp"
+#include "ml_utils.h"
+
+namespace ML {
+namespace GLM {
+
+using namespace MLCommon;
+
+/**
+ * The batched models are stored contiguously: the feature matrices as
+ * n_batches column-major n_rows x n_cols matrices, one after the other, the
+ * labels as a column-major n_rows x n_batches matrix, and the coefficients
+ * as a column-major n_cols x n_batches matrix. All the models are solved
+ * together, by batched cuBLAS / cuSOLVER calls.
+ */
+
+/** Adds alpha to the diagonal of each n x n matrix of the batch */
+template <typename math_t>
+__global__ void addDiagonalBatchedKernel(math_t *A, int n, math_t alpha) {
+  math_t *A_b = A + size_t(blockIdx.x) * n * n;
+  for (int idx = threadIdx.x; idx < n; idx += blockDim.x) {
+    A_b[idx * (n + 1)] += alpha;
+  }
+}
+
+/**
+ * Centers the columns of the features and the labels of each model by their
+ * means, which are stored in mu_input (n_cols x n_batches) and mu_labels
+ * (n_batches).
+ */
+template <typename math_t>
+void preProcessDataBatched(math_t *input, int n_rows, int n_cols,
+                           int n_batches, math_t *labels, math_t *mu_input,
+                           math_t *mu_labels, cudaStream_t stream) {
+  Stats::mean(mu_input, input, n_cols * n_batches, n_rows, false, false,
+              stream);
+  Stats::meanCenter(input, input, mu_input, n_cols * n_batches, n_rows, false,
+                    true, stream);
+
+  Stats::mean(mu_labels, labels, n_batches, n_rows, false, false, stream);
+  Stats::meanCenter(labels, labels, mu_labels, n_batches, n_rows, false, true,
+                    stream);
+}
+
+/**
+ * Restores the centered features and labels and computes the intercept of
+ * each model, mu_labels - mu_input . coef, by a batched 1 x 1 gemm.
+ */
+template <typename math_t>
+void postProcessDataBatched(const cumlHandle_impl &handle, math_t *input,
+                            int n_rows, int n_cols, int n_batches,
+                            math_t *labels, const math_t *coef,
+                            math_t *intercept, const math_t *mu_input,
+                            const math_t *mu_labels, cudaStream_t stream) {
+  copy(intercept, mu_labels, n_batches, stream);
+  math_t alpha = math_t(-1);
+  math_t beta = math_t(1);
+  CUBLAS_CHECK(LinAlg::cublasgemmStridedBatched(
+    handle.getCublasHandle(), CUBLAS_OP_N, CUBLAS_OP_N, 1, 1, n_cols, &alpha,
+    mu_input, 1, n_cols, coef, n_cols, n_cols, &beta, intercept, 1, 1,
+    n_batches, stream));
+
+  Stats::meanAdd(input, input, mu_input, n_cols * n_batches, n_rows, false,
+                 true, stream);
+  Stats::meanAdd(labels, labels, mu_labels, n_batches, n_rows, false, true,
+                 stream);
+}
+
+/**
+ * Solves the normal equations (X^T X + alpha I) w = X^T y of each model by a
+ * batched Cholesky factorization. The n_cols x n_cols systems are small, so
+ * that it is much lighter than a QR of the feature matrices.
+ */
+template <typename math_t>
+void normalEqSolveBatched(const cumlHandle_impl &handle, const math_t *input,
+                          int n_rows, int n_cols, int n_batches,
+                          const math_t *labels, math_t alpha, math_t *coef,
+                          cudaStream_t stream) {
+  auto cublas_handle = handle.getCublasHandle();
+  auto cusolver_handle = handle.getcusolverDnHandle();
+  auto allocator = handle.getDeviceAllocator();
+
+  Matrix::BatchedMatrix<math_t> G(n_cols, n_cols, n_batches, cublas_handle,
+                                  allocator, stream, false);
+  Matrix::BatchedMatrix<math_t> w(n_cols, 1, n_batches, cublas_handle,
+                                  allocator, stream, false);
+
+  math_t one = math_t(1);
+  math_t zero = math_t(0);
+  CUBLAS_CHECK(LinAlg::cublasgemmStridedBatched(
+    cublas_handle, CUBLAS_OP_T, CUBLAS_OP_N, n_cols, n_cols, n_rows, &one,
+    input, n_rows, n_rows * n_cols, input, n_rows, n_rows * n_cols, &zero,
+    G.raw_data(), n_cols, n_cols * n_cols, n_batches, stream));
+  CUBLAS_CHECK(LinAlg::cublasgemmStridedBatched(
+    cublas_handle, CUBLAS_OP_T, CUBLAS_OP_N, n_cols, 1, n_rows, &one, input,
+    n_rows, n_rows * n_cols, labels, n_rows, n_rows, &zero, w.raw_data(),
+    n_cols, n_cols, n_batches, stream));
+
+  if (alpha != math_t(0)) {
+    addDiagonalBatchedKernel<math_t>
+      <<<n_batches, std::min(1024, n_cols), 0, stream>>>(G.raw_data(), n_cols,
+                                                         alpha);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+
+  device_buffer<int> info(allocator, stream, n_batches);
+  CUSOLVER_CHECK(LinAlg::cusolverDnpotrfBatched(
+    cusolver_handle, CUBLAS_FILL_MODE_LOWER, n_cols, G.data(), n_cols,
+    info.data(), n_batches, stream));
+
+  std::vector<int> info_h(n_batches);
+  updateHost(info_h.data(), info.data(), n_batches, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  int n_failed = n_batches - std::count(info_h.begin(), info_h.end(), 0);
+  ASSERT(n_failed == 0,
+         "normalEqSolveBatched: the normal equations of %d models are not "
+         "positive definite",
+         n_failed);
+
+  CUSOLVER_CHECK(LinAlg::cusolverDnpotrsBatched(
+    cusolver_handle, CUBLAS_FILL_MODE_LOWER, n_cols, 1, G.data(), n_cols,
+    w.data(), n_cols, info.data(), n_batches, stream));
+
+  copy(coef, w.raw_data(), n_cols * n_batches, stream);
+}
+
+/**
+ * Solves the least squares problem of each model by a batched QR
+ * factorization (cublas gelsBatched), on a copy of the features.
+ */
+template <typename math_t>
+void lstsqQRBatched(const cumlHandle_impl &handle, const math_t *input,
+                    int n_rows, int n_cols, int n_batches,
+                    const math_t *labels, math_t *coef, cudaStream_t stream) {
+  ASSERT(n_rows > n_cols,
+         "lstsqQRBatched: only overdetermined systems are supported");
+  auto cublas_handle = handle.getCublasHandle();
+  auto allocator = handle.getDeviceAllocator();
+
+  Matrix::BatchedMatrix<math_t> A(n_rows, n_cols, n_batches, cublas_handle,
+                                  allocator, stream, false);
+  Matrix::BatchedMatrix<math_t> b(n_rows, 1, n_batches, cublas_handle,
+                                  allocator, stream, false);
+  copy(A.raw_data(), input, size_t(n_rows) * n_cols * n_batches, stream);
+  copy(b.raw_data(), labels, size_t(n_rows) * n_batches, stream);
+
+  int info;
+  CUBLAS_CHECK(LinAlg::cublasgelsBatched(cublas_handle, CUBLAS_OP_N, n_rows,
+                                         n_cols, 1, A.data(), n_rows, b.data(),
+                                         n_rows, &info, nullptr, n_batches,
+                                         stream));
+
+  // the solution of each model is held by the first n_cols rows of b
+  CUDA_CHECK(cudaMemcpy2DAsync(coef, n_cols * sizeof(math_t), b.raw_data(),
+                               n_rows * sizeof(math_t),
+                               n_cols * sizeof(math_t), n_batches,
+                               cudaMemcpyDeviceToDevice, stream));
+}
+
+/**
+ * @defgroup Functions fit a batch of ordinary least squares models
+ * @param input         device pointer to the n_batches feature matrices, each
+ *                      n_rows x n_cols
+ * @param n_rows        number of rows of each feature matrix
+ * @param n_cols        number of columns of each feature matrix
+ * @param n_batches     number of models
+ * @param labels        device pointer to the labels, n_rows x n_batches
+ * @param coef          device pointer to hold the weights, n_cols x n_batches
+ * @param intercept     device pointer to hold the bias terms, n_batches
+ * @param fit_intercept if true, fit intercept
+ * @param algo          specifies which solver to use (0: QR-decomposition,
+ *                      1: Cholesky decomposition of the normal equations)
+ * @{
+ */
+template <typename math_t>
+void olsFitBatched(const cumlHandle_impl &handle, math_t *input, int n_rows,
+                   int n_cols, int n_batches, math_t *labels, math_t *coef,
+                   math_t *intercept, bool fit_intercept, cudaStream_t stream,
+                   int algo = 0) {
+  ASSERT(n_cols > 0,
+         "olsFitBatched: number of columns cannot be less than one");
+  ASSERT(n_rows > 1, "olsFitBatched: number of rows cannot be less than two");
+  ASSERT(n_batches > 0,
+         "olsFitBatched: number of batches cannot be less than one");
+
+  auto allocator = handle.getDeviceAllocator();
+  device_buffer<math_t> mu_input(allocator, stream);
+  device_buffer<math_t> mu_labels(allocator, stream);
+
+  if (fit_intercept) {
+    mu_input.resize(n_cols * n_batches, stream);
+    mu_labels.resize(n_batches, stream);
+    preProcessDataBatched(input, n_rows, n_cols, n_batches, labels,
+                          mu_input.data(), mu_labels.data(), stream);
+  }
+
+  if (algo == 0) {
+    lstsqQRBatched(handle, input, n_rows, n_cols, n_batches, labels, coef,
+                   stream);
+  } else if (algo == 1) {
+    normalEqSolveBatched(handle, input, n_rows, n_cols, n_batches, labels,
+                         math_t(0), coef, stream);
+  } else {
+    ASSERT(false,
+           "olsFitBatched: no algorithm with this id has been implemented");
+  }
+
+  if (fit_intercept) {
+    postProcessDataBatched(handle, input, n_rows, n_cols, n_batches, labels,
+                           coef, intercept, mu_input.data(), mu_labels.data(),
+                           stream);
+  } else {
+    CUDA_CHECK(
+      cudaMemsetAsync(intercept, 0, n_batches * sizeof(math_t), stream));
+  }
+}
+
+/**
+ * @defgroup Functions fit a batch of ridge regression models
+ * @param input         device pointer to the n_batches feature matrices, each
+ *                      n_rows x n_cols
+ * @param n_rows        number of rows of each feature matrix
+ * @param n_cols        number of columns of each feature matrix
+ * @param n_batches     number of models
+ * @param labels        device pointer to the labels, n_rows x n_batches
+ * @param alpha         regularization strength, shared by all the models
+ * @param coef          device pointer to hold the weights, n_cols x n_batches
+ * @param intercept     device pointer to hold the bias terms, n_batches
+ * @param fit_intercept if true, fit intercept
+ * @{
+ */
+template <typename math_t>
+void ridgeFitBatched(const cumlHandle_impl &handle, math_t *input, int n_rows,
+                     int n_cols, int n_batches, math_t *labels, math_t alpha,
+                     math_t *coef, math_t *intercept, bool fit_intercept,
+                     cudaStream_t stream) {
+  ASSERT(n_cols > 0,
+         "ridgeFitBatched: number of columns cannot be less than one");
+  ASSERT(n_rows > 1,
+         "ridgeFitBatched: number of rows cannot be less than two");
+  ASSERT(n_batches > 0,
+         "ridgeFitBatched: number of batches cannot be less than one");
+  ASSERT(alpha >= math_t(0), "ridgeFitBatched: alpha cannot be negative");
+
+  auto allocator = handle.getDeviceAllocator();
+  device_buffer<math_t> mu_input(allocator, stream);
+  device_buffer<math_t> mu_labels(allocator, stream);
+
+  if (fit_intercept) {
+    mu_input.resize(n_cols * n_batches, stream);
+    mu_labels.resize(n_batches, stream);
+    preProcessDataBatched(input, n_rows, n_cols, n_batches, labels,
+                          mu_input.data(), mu_labels.data(), stream);
+  }
+
+  normalEqSolveBatched(handle, input, n_rows, n_cols, n_batches, labels, alpha,
+                       coef, stream);
+
+  if (fit_intercept) {
+    postProcessDataBatched(handle, input, n_rows, n_cols, n_batches, labels,
+                           coef, intercept, mu_input.data(), mu_labels.data(),
+                           stream);
+  } else {
+    CUDA_CHECK(
+      cudaMemsetAsync(intercept, 0, n_batches * sizeof(math_t), stream));
+  }
+}
+
+/**
+ * @defgroup Functions to make predictions with a batch of fitted linear models
+ * @param input         device pointer to the n_batches feature matrices, each
+ *                      n_rows x n_cols
+ * @param n_rows        number of rows of each feature matrix
+ * @param n_cols        number of columns of each feature matrix
+ * @param n_batches     number of models
+ * @param coef          weights of the models, n_cols x n_batches
+ * @param intercept     bias terms of the models, n_batches
+ * @param preds         device pointer to store the predictions,
+ *                      n_rows x n_batches
+ * @{
+ */
+template <typename math_t>
+void linearPredictBatched(const cumlHandle_impl &handle, const math_t *input,
+                          int n_rows, int n_cols, int n_batches,
+                          const math_t *coef, const math_t *intercept,
+                          math_t *preds, cudaStream_t stream) {
+  ASSERT(n_cols > 0,
+         "linearPredictBatched: number of columns cannot be less than one");
+  ASSERT(n_rows > 0,
+         "linearPredictBatched: number of rows cannot be less than one");
+
+  math_t alpha = math_t(1);
+  math_t beta = math_t(0);
+  CUBLAS_CHECK(LinAlg::cublasgemmStridedBatched(
+    handle.getCublasHandle(), CUBLAS_OP_N, CUBLAS_OP_N, n_rows, 1, n_cols,
+    &alpha, input, n_rows, n_rows * n_cols, coef, n_cols, n_cols, &beta, preds,
+    n_rows, n_rows, n_batches, stream));
+  Stats::meanAdd(preds, preds, intercept, n_batches, n_rows, false, true,
+                 stream);
+}
+
+/** @} */
+};  // namespace GLM
+};  // namespace ML
+// end namespace ML
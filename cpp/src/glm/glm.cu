@@ -15,8 +15,11 @@
  */
 #include <cuml/cuml.hpp>
 #include <cuml/linear_model/glm.hpp>
+#include "batched.h"
 #include "glm/qn/qn.h"
+#include "glm/qn/qn_mg.h"
 #include "ols.h"
+#include "ols_mg.h"
 #include "ridge.h"
 
 namespace ML {
@@ -40,6 +43,22 @@ void olsFit(const cumlHandle &handle, double *input, int n_rows, int n_cols,
   CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
 }
 
+void olsFitHost(const cumlHandle &handle, const float *input, size_t n_rows,
+                int n_cols, const float *labels, float *coef, float *intercept,
+                bool fit_intercept, int batch_size) {
+  olsFitHost(handle.getImpl(), input, n_rows, n_cols, labels, coef, intercept,
+             fit_intercept, batch_size, handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
+void olsFitHost(const cumlHandle &handle, const double *input, size_t n_rows,
+                int n_cols, const double *labels, double *coef,
+                double *intercept, bool fit_intercept, int batch_size) {
+  olsFitHost(handle.getImpl(), input, n_rows, n_cols, labels, coef, intercept,
+             fit_intercept, batch_size, handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
 void olsPredict(const cumlHandle &handle, const float *input, int n_rows,
                 int n_cols, const float *coef, float intercept, float *preds) {
   olsPredict(handle.getImpl(), input, n_rows, n_cols, coef, intercept, preds,
@@ -55,6 +74,22 @@ void olsPredict(const cumlHandle &handle, const double *input, int n_rows,
   CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
 }
 
+void olsFitMG(const cumlHandle &handle, float *input, int n_rows, int n_cols,
+              float *labels, float *coef, float *intercept,
+              bool fit_intercept) {
+  olsFitMG(handle.getImpl(), input, n_rows, n_cols, labels, coef, intercept,
+           fit_intercept, handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
+void olsFitMG(const cumlHandle &handle, double *input, int n_rows, int n_cols,
+              double *labels, double *coef, double *intercept,
+              bool fit_intercept) {
+  olsFitMG(handle.getImpl(), input, n_rows, n_cols, labels, coef, intercept,
+           fit_intercept, handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
 void ridgeFit(const cumlHandle &handle, float *input, int n_rows, int n_cols,
               float *labels, float *alpha, int n_alpha, float *coef,
               float *intercept, bool fit_intercept, bool normalize, int algo) {
@@ -71,6 +106,42 @@ void ridgeFit(const cumlHandle &handle, double *input, int n_rows, int n_cols,
   CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
 }
 
+void ridgeFitPath(const cumlHandle &handle, float *input, int n_rows,
+                  int n_cols, float *labels, const float *alphas, int n_alphas,
+                  float *coefs, float *intercepts, bool fit_intercept,
+                  bool normalize, int algo) {
+  ridgeFitPath(handle.getImpl(), input, n_rows, n_cols, labels, alphas,
+               n_alphas, coefs, intercepts, fit_intercept, normalize,
+               handle.getStream(), algo);
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
+void ridgeFitPath(const cumlHandle &handle, double *input, int n_rows,
+                  int n_cols, double *labels, const double *alphas,
+                  int n_alphas, double *coefs, double *intercepts,
+                  bool fit_intercept, bool normalize, int algo) {
+  ridgeFitPath(handle.getImpl(), input, n_rows, n_cols, labels, alphas,
+               n_alphas, coefs, intercepts, fit_intercept, normalize,
+               handle.getStream(), algo);
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
+void ridgeFitMG(const cumlHandle &handle, float *input, int n_rows,
+                int n_cols, float *labels, float alpha, float *coef,
+                float *intercept, bool fit_intercept) {
+  ridgeFitMG(handle.getImpl(), input, n_rows, n_cols, labels, alpha, coef,
+             intercept, fit_intercept, handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
+void ridgeFitMG(const cumlHandle &handle, double *input, int n_rows,
+                int n_cols, double *labels, double alpha, double *coef,
+                double *intercept, bool fit_intercept) {
+  ridgeFitMG(handle.getImpl(), input, n_rows, n_cols, labels, alpha, coef,
+             intercept, fit_intercept, handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
 void ridgePredict(const cumlHandle &handle, const float *input, int n_rows,
                   int n_cols, const float *coef, float intercept,
                   float *preds) {
@@ -87,6 +158,56 @@ void ridgePredict(const cumlHandle &handle, const double *input, int n_rows,
   CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
 }
 
+void olsFitBatched(const cumlHandle &handle, float *input, int n_rows,
+                   int n_cols, int n_batches, float *labels, float *coef,
+                   float *intercept, bool fit_intercept, int algo) {
+  olsFitBatched(handle.getImpl(), input, n_rows, n_cols, n_batches, labels,
+                coef, intercept, fit_intercept, handle.getStream(), algo);
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
+void olsFitBatched(const cumlHandle &handle, double *input, int n_rows,
+                   int n_cols, int n_batches, double *labels, double *coef,
+                   double *intercept, bool fit_intercept, int algo) {
+  olsFitBatched(handle.getImpl(), input, n_rows, n_cols, n_batches, labels,
+                coef, intercept, fit_intercept, handle.getStream(), algo);
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
+void ridgeFitBatched(const cumlHandle &handle, float *input, int n_rows,
+                     int n_cols, int n_batches, float *labels, float alpha,
+                     float *coef, float *intercept, bool fit_intercept) {
+  ridgeFitBatched(handle.getImpl(), input, n_rows, n_cols, n_batches, labels,
+                  alpha, coef, intercept, fit_intercept, handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
+void ridgeFitBatched(const cumlHandle &handle, double *input, int n_rows,
+                     int n_cols, int n_batches, double *labels, double alpha,
+                     double *coef, double *intercept, bool fit_intercept) {
+  ridgeFitBatched(handle.getImpl(), input, n_rows, n_cols, n_batches, labels,
+                  alpha, coef, intercept, fit_intercept, handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
+void linearPredictBatched(const cumlHandle &handle, const float *input,
+                          int n_rows, int n_cols, int n_batches,
+                          const float *coef, const float *intercept,
+                          float *preds) {
+  linearPredictBatched(handle.getImpl(), input, n_rows, n_cols, n_batches,
+                       coef, intercept, preds, handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
+void linearPredictBatched(const cumlHandle &handle, const double *input,
+                          int n_rows, int n_cols, int n_batches,
+                          const double *coef, const double *intercept,
+                          double *preds) {
+  linearPredictBatched(handle.getImpl(), input, n_rows, n_cols, n_batches,
+                       coef, intercept, preds, handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
 void qnFit(const cumlHandle &cuml_handle, float *X, float *y, int N, int D,
            int C, bool fit_intercept, float l1, float l2, int max_iter,
            float grad_tol, int linesearch_max_iter, int lbfgs_memory,
@@ -107,18 +228,116 @@ void qnFit(const cumlHandle &cuml_handle, double *X, double *y, int N, int D,
         num_iters, X_col_major, loss_type, cuml_handle.getStream());
 }
 
+void qnFitSparse(const cumlHandle &cuml_handle, float *X_values, int *X_cols,
+                 int *X_row_ids, int X_nnz, float *y, int N, int D, int C,
+                 bool fit_intercept, float l1, float l2, int max_iter,
+                 float grad_tol, int linesearch_max_iter, int lbfgs_memory,
+                 int verbosity, float *w0, float *f, int *num_iters,
+                 int loss_type) {
+  qnFitSparse(cuml_handle.getImpl(), X_values, X_cols, X_row_ids, X_nnz, y, N,
+              D, C, fit_intercept, l1, l2, max_iter, grad_tol,
+              linesearch_max_iter, lbfgs_memory, verbosity, w0, f, num_iters,
+              loss_type, cuml_handle.getStream());
+}
+
+void qnFitSparse(const cumlHandle &cuml_handle, double *X_values, int *X_cols,
+                 int *X_row_ids, int X_nnz, double *y, int N, int D, int C,
+                 bool fit_intercept, double l1, double l2, int max_iter,
+                 double grad_tol, int linesearch_max_iter, int lbfgs_memory,
+                 int verbosity, double *w0, double *f, int *num_iters,
+                 int loss_type) {
+  qnFitSparse(cuml_handle.getImpl(), X_values, X_cols, X_row_ids, X_nnz, y, N,
+              D, C, fit_intercept, l1, l2, max_iter, grad_tol,
+              linesearch_max_iter, lbfgs_memory, verbosity, w0, f, num_iters,
+              loss_type, cuml_handle.getStream());
+}
+
+void qnFitMG(const cumlHandle &cuml_handle, float *X, float *y, int N, int D,
+             int C, bool fit_intercept, float l1, float l2, int max_iter,
+             float grad_tol, int linesearch_max_iter, int lbfgs_memory,
+             int verbosity, float *w0, float *f, int *num_iters,
+             bool X_col_major, int loss_type) {
+  qnFitMG(cuml_handle.getImpl(), X, y, N, D, C, fit_intercept, l1, l2,
+          max_iter, grad_tol, linesearch_max_iter, lbfgs_memory, verbosity, w0,
+          f, num_iters, X_col_major, loss_type, cuml_handle.getStream());
+}
+
+void qnFitMG(const cumlHandle &cuml_handle, double *X, double *y, int N, int D,
+             int C, bool fit_intercept, double l1, double l2, int max_iter,
+             double grad_tol, int linesearch_max_iter, int lbfgs_memory,
+             int verbosity, double *w0, double *f, int *num_iters,
+             bool X_col_major, int loss_type) {
+  qnFitMG(cuml_handle.getImpl(), X, y, N, D, C, fit_intercept, l1, l2,
+          max_iter, grad_tol, linesearch_max_iter, lbfgs_memory, verbosity, w0,
+          f, num_iters, X_col_major, loss_type, cuml_handle.getStream());
+}
+
+void qnFitSparseMG(const cumlHandle &cuml_handle, float *X_values,
+                   int *X_cols, int *X_row_ids, int X_nnz, float *y, int N,
+                   int D, int C, bool fit_intercept, float l1, float l2,
+                   int max_iter, float grad_tol, int linesearch_max_iter,
+                   int lbfgs_memory, int verbosity, float *w0, float *f,
+                   int *num_iters, int loss_type) {
+  qnFitSparseMG(cuml_handle.getImpl(), X_values, X_cols, X_row_ids, X_nnz, y,
+                N, D, C, fit_intercept, l1, l2, max_iter, grad_tol,
+                linesearch_max_iter, lbfgs_memory, verbosity, w0, f, num_iters,
+                loss_type, cuml_handle.getStream());
+}
+
+void qnFitSparseMG(const cumlHandle &cuml_handle, double *X_values,
+                   int *X_cols, int *X_row_ids, int X_nnz, double *y, int N,
+                   int D, int C, bool fit_intercept, double l1, double l2,
+                   int max_iter, double grad_tol, int linesearch_max_iter,
+                   int lbfgs_memory, int verbosity, double *w0, double *f,
+                   int *num_iters, int loss_type) {
+  qnFitSparseMG(cuml_handle.getImpl(), X_values, X_cols, X_row_ids, X_nnz, y,
+                N, D, C, fit_intercept, l1, l2, max_iter, grad_tol,
+                linesearch_max_iter, lbfgs_memory, verbosity, w0, f, num_iters,
+                loss_type, cuml_handle.getStream());
+}
+
 void qnPredict(const cumlHandle &cuml_handle, float *X, int N, int D, int C,
                bool fit_intercept, float *params, bool X_col_major,
                int loss_type, float *preds) {
-  qnPredict(cuml_handle.getImpl(), X, N, D, C, fit_intercept, params,
-            X_col_major, loss_type, preds, cuml_handle.getStream());
+  const cumlHandle_impl &impl = cuml_handle.getImpl();
+  cudaStream_t stream = cuml_handle.getStream();
+  impl.runGraphed(graphKey("ML::GLM::qnPredict", X, N, D, C, fit_intercept,
+                           params, X_col_major, loss_type, preds),
+                  [&]() {
+                    qnPredict(impl, X, N, D, C, fit_intercept, params,
+                              X_col_major, loss_type, preds, stream);
+                  });
 }
 
 void qnPredict(const cumlHandle &cuml_handle, double *X, int N, int D, int C,
                bool fit_intercept, double *params, bool X_col_major,
                int loss_type, double *preds) {
-  qnPredict(cuml_handle.getImpl(), X, N, D, C, fit_intercept, params,
-            X_col_major, loss_type, preds, cuml_handle.getStream());
+  const cumlHandle_impl &impl = cuml_handle.getImpl();
+  cudaStream_t stream = cuml_handle.getStream();
+  impl.runGraphed(graphKey("ML::GLM::qnPredict", X, N, D, C, fit_intercept,
+                           params, X_col_major, loss_type, preds),
+                  [&]() {
+                    qnPredict(impl, X, N, D, C, fit_intercept, params,
+                              X_col_major, loss_type, preds, stream);
+                  });
+}
+
+void qnPredictSparse(const cumlHandle &cuml_handle, float *X_values,
+                     int *X_cols, int *X_row_ids, int X_nnz, int N, int D,
+                     int C, bool fit_intercept, float *params, int loss_type,
+                     float *preds) {
+  qnPredictSparse(cuml_handle.getImpl(), X_values, X_cols, X_row_ids, X_nnz, N,
+                  D, C, fit_intercept, params, loss_type, preds,
+                  cuml_handle.getStream());
+}
+
+void qnPredictSparse(const cumlHandle &cuml_handle, double *X_values,
+                     int *X_cols, int *X_row_ids, int X_nnz, int N, int D,
+                     int C, bool fit_intercept, double *params, int loss_type,
+                     double *preds) {
+  qnPredictSparse(cuml_handle.getImpl(), X_values, X_cols, X_row_ids, X_nnz, N,
+                  D, C, fit_intercept, params, loss_type, preds,
+                  cuml_handle.getStream());
 }
 
 }  // namespace GLM
@@ -19,7 +19,9 @@
 #include <linalg/add.h>
 #include <linalg/gemv.h>
 #include <linalg/lstsq.h>
+#include <linalg/multiply.h>
 #include <linalg/norm.h>
+#include <linalg/reduce.h>
 #include <linalg/subtract.h>
 #include <matrix/math.h>
 #include <matrix/matrix.h>
@@ -27,6 +29,7 @@
 #include <stats/mean_center.h>
 #include <stats/stddev.h>
 #include <stats/sum.h>
+#include <algorithm>
 #include "common/cumlHandle.hpp"
 #include "common/device_buffer.hpp"
 #include "ml_utils.h"
@@ -101,6 +104,206 @@ void olsFit(const cumlHandle_impl &handle, math_t *input, int n_rows,
   }
 }
 
+/**
+ * Adds the contribution of a block of rows to the statistics from which
+ * olsGramSolve solves the least squares problem of all the blocks: the Gram
+ * matrix X^T X (n_cols x n_cols), X^T y (n_cols), and, to fit an intercept,
+ * the sums of the columns (n_cols) and of the labels (1). sum_input and
+ * sum_labels are not used when they are NULL.
+ * @param input         device pointer to the block, n_rows x n_cols
+ * @param n_rows        number of rows of the block
+ * @param n_cols        number of columns of the block
+ * @param labels        device pointer to the labels of the block
+ */
+template <typename math_t>
+void olsGramAccumulate(const cumlHandle_impl &handle, const math_t *input,
+                       int n_rows, int n_cols, const math_t *labels,
+                       math_t *gram, math_t *xty, math_t *sum_input,
+                       math_t *sum_labels, cudaStream_t stream) {
+  auto cublas_handle = handle.getCublasHandle();
+  math_t alpha = math_t(1);
+  math_t beta = math_t(1);
+  LinAlg::gemm(input, n_rows, n_cols, input, gram, n_cols, n_cols, CUBLAS_OP_T,
+               CUBLAS_OP_N, alpha, beta, cublas_handle, stream);
+  LinAlg::gemm(input, n_rows, n_cols, labels, xty, n_cols, 1, CUBLAS_OP_T,
+               CUBLAS_OP_N, alpha, beta, cublas_handle, stream);
+  if (sum_input != NULL) {
+    LinAlg::reduce(sum_input, input, n_cols, n_rows, math_t(0), false, false,
+                   stream, true);
+    LinAlg::reduce(sum_labels, labels, 1, n_rows, math_t(0), false, false,
+                   stream, true);
+  }
+}
+
+/**
+ * Solves the least squares problem of the n_rows rows summed up by
+ * olsGramAccumulate. To fit an intercept, the Gram matrix and X^T y are
+ * centered by the means of the columns and of the labels. The rows may have
+ * been shifted by shift_input and shift_labels before the accumulation, which
+ * avoids the cancellation of the centering when the means are large. gram and
+ * xty are overwritten.
+ * @param shift_input   device pointer to the shift of the columns, or NULL
+ * @param shift_labels  device pointer to the shift of the labels, or NULL
+ * @param coef          device pointer to hold the solution for weights of size n_cols
+ * @param intercept     host pointer to hold the solution for bias term of size 1
+ */
+template <typename math_t>
+void olsGramSolve(const cumlHandle_impl &handle, math_t *gram, math_t *xty,
+                  const math_t *sum_input, const math_t *sum_labels,
+                  const math_t *shift_input, const math_t *shift_labels,
+                  size_t n_rows, int n_cols, math_t *coef, math_t *intercept,
+                  bool fit_intercept, cudaStream_t stream) {
+  auto cublas_handle = handle.getCublasHandle();
+  auto cusolver_handle = handle.getcusolverDnHandle();
+  auto allocator = handle.getDeviceAllocator();
+
+  ASSERT(n_rows > 1, "olsGramSolve: number of rows cannot be less than two");
+
+  if (!fit_intercept) {
+    LinAlg::lstsqGram(gram, n_cols, xty, coef, cusolver_handle, cublas_handle,
+                      allocator, stream);
+    *intercept = math_t(0);
+    return;
+  }
+
+  device_buffer<math_t> mu_input(allocator, stream, n_cols);
+  device_buffer<math_t> mu_labels(allocator, stream, 1);
+  device_buffer<math_t> d_intercept(allocator, stream, 1);
+  math_t inv_n = math_t(1) / n_rows;
+  LinAlg::scalarMultiply(mu_input.data(), sum_input, inv_n, n_cols, stream);
+  LinAlg::scalarMultiply(mu_labels.data(), sum_labels, inv_n, 1, stream);
+
+  // X^T X - n mu_x mu_x^T and X^T y - n mu_x mu_y
+  math_t alpha = -math_t(n_rows);
+  math_t beta = math_t(1);
+  LinAlg::gemm(mu_input.data(), n_cols, 1, mu_input.data(), gram, n_cols,
+               n_cols, CUBLAS_OP_N, CUBLAS_OP_T, alpha, beta, cublas_handle,
+               stream);
+  LinAlg::gemm(mu_input.data(), n_cols, 1, mu_labels.data(), xty, n_cols, 1,
+               CUBLAS_OP_N, CUBLAS_OP_N, alpha, beta, cublas_handle, stream);
+
+  LinAlg::lstsqGram(gram, n_cols, xty, coef, cusolver_handle, cublas_handle,
+                    allocator, stream);
+
+  if (shift_input != NULL) {
+    LinAlg::add(mu_input.data(), mu_input.data(), shift_input, n_cols, stream);
+    LinAlg::add(mu_labels.data(), mu_labels.data(), shift_labels, 1, stream);
+  }
+  LinAlg::gemm(mu_input.data(), 1, n_cols, coef, d_intercept.data(), 1, 1,
+               CUBLAS_OP_N, CUBLAS_OP_N, cublas_handle, stream);
+  LinAlg::subtract(d_intercept.data(), mu_labels.data(), d_intercept.data(), 1,
+                   stream);
+  updateHost(intercept, d_intercept.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+}
+
+/**
+ * Fits an ordinary least squares model, as olsFit, with the input and the
+ * labels in host memory. Blocks of batch_size rows are streamed to the
+ * device on a second stream, in two alternating buffers, so that the copy of
+ * a block overlaps with the accumulation of the previous one into the Gram
+ * matrix. The device memory is O(n_cols^2 + batch_size * n_cols), whatever
+ * the number of rows. To fit an intercept, the rows are shifted by the means
+ * of the first block.
+ * @param input         host pointer to feature matrix n_rows x n_cols
+ * @param n_rows        number of rows of the feature matrix
+ * @param n_cols        number of columns of the feature matrix
+ * @param labels        host pointer to label vector of length n_rows
+ * @param coef          device pointer to hold the solution for weights of size n_cols
+ * @param intercept     host pointer to hold the solution for bias term of size 1
+ * @param fit_intercept if true, fit intercept
+ * @param batch_size    number of rows of a block
+ */
+template <typename math_t>
+void olsFitHost(const cumlHandle_impl &handle, const math_t *input,
+                size_t n_rows, int n_cols, const math_t *labels, math_t *coef,
+                math_t *intercept, bool fit_intercept, int batch_size,
+                cudaStream_t stream) {
+  ASSERT(n_cols > 0, "olsFitHost: number of columns cannot be less than one");
+  ASSERT(n_rows > 1, "olsFitHost: number of rows cannot be less than two");
+  ASSERT(batch_size > 0, "olsFitHost: batch size cannot be less than one");
+  batch_size = std::min(size_t(batch_size), n_rows);
+
+  auto allocator = handle.getDeviceAllocator();
+  device_buffer<math_t> gram(allocator, stream, n_cols * n_cols);
+  device_buffer<math_t> xty(allocator, stream, n_cols);
+  device_buffer<math_t> sum_input(allocator, stream, n_cols);
+  device_buffer<math_t> sum_labels(allocator, stream, 1);
+  device_buffer<math_t> shift_input(allocator, stream, n_cols);
+  device_buffer<math_t> shift_labels(allocator, stream, 1);
+  CUDA_CHECK(cudaMemsetAsync(gram.data(), 0, gram.size() * sizeof(math_t),
+                             stream));
+  CUDA_CHECK(
+    cudaMemsetAsync(xty.data(), 0, xty.size() * sizeof(math_t), stream));
+  CUDA_CHECK(cudaMemsetAsync(sum_input.data(), 0,
+                             sum_input.size() * sizeof(math_t), stream));
+  CUDA_CHECK(cudaMemsetAsync(sum_labels.data(), 0, sizeof(math_t), stream));
+
+  // Double buffered stages: a block of rows, followed by its labels
+  const size_t stage_len = size_t(batch_size) * (n_cols + 1);
+  device_buffer<math_t> d_stage0(allocator, stream, stage_len);
+  device_buffer<math_t> d_stage1(allocator, stream, stage_len);
+  math_t *d_stage[2] = {d_stage0.data(), d_stage1.data()};
+  cudaEvent_t stage_copied[2], stage_free[2];
+  for (int s = 0; s < 2; s++) {
+    CUDA_CHECK(
+      cudaEventCreateWithFlags(&stage_copied[s], cudaEventDisableTiming));
+    CUDA_CHECK(
+      cudaEventCreateWithFlags(&stage_free[s], cudaEventDisableTiming));
+  }
+  cudaStream_t copy_stream;
+  CUDA_CHECK(cudaStreamCreateWithFlags(&copy_stream, cudaStreamNonBlocking));
+  // the stages are allocated on stream, and written on copy_stream
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  int batch = 0;
+  for (size_t j = 0; j < n_rows; j += batch_size, batch++) {
+    const int cbs = std::min(size_t(batch_size), n_rows - j);
+    const int s = batch % 2;
+    math_t *input_batch = d_stage[s];
+    math_t *labels_batch = d_stage[s] + size_t(cbs) * n_cols;
+
+    // the accumulation of this stage two blocks ago has released it
+    CUDA_CHECK(cudaStreamWaitEvent(copy_stream, stage_free[s], 0));
+    CUDA_CHECK(cudaMemcpy2DAsync(input_batch, cbs * sizeof(math_t), input + j,
+                                 n_rows * sizeof(math_t), cbs * sizeof(math_t),
+                                 n_cols, cudaMemcpyHostToDevice, copy_stream));
+    CUDA_CHECK(cudaMemcpyAsync(labels_batch, labels + j, cbs * sizeof(math_t),
+                               cudaMemcpyHostToDevice, copy_stream));
+    CUDA_CHECK(cudaEventRecord(stage_copied[s], copy_stream));
+    CUDA_CHECK(cudaStreamWaitEvent(stream, stage_copied[s], 0));
+
+    if (fit_intercept) {
+      if (batch == 0) {
+        Stats::mean(shift_input.data(), input_batch, n_cols, cbs, false, false,
+                    stream);
+        Stats::mean(shift_labels.data(), labels_batch, 1, cbs, false, false,
+                    stream);
+      }
+      Stats::meanCenter(input_batch, input_batch, shift_input.data(), n_cols,
+                        cbs, false, true, stream);
+      Stats::meanCenter(labels_batch, labels_batch, shift_labels.data(), 1,
+                        cbs, false, true, stream);
+    }
+    olsGramAccumulate(handle, input_batch, cbs, n_cols, labels_batch,
+                      gram.data(), xty.data(),
+                      fit_intercept ? sum_input.data() : (math_t *)NULL,
+                      sum_labels.data(), stream);
+    CUDA_CHECK(cudaEventRecord(stage_free[s], stream));
+  }
+
+  olsGramSolve(handle, gram.data(), xty.data(), sum_input.data(),
+               sum_labels.data(), shift_input.data(), shift_labels.data(),
+               n_rows, n_cols, coef, intercept, fit_intercept, stream);
+
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  for (int s = 0; s < 2; s++) {
+    CUDA_CHECK(cudaEventDestroy(stage_copied[s]));
+    CUDA_CHECK(cudaEventDestroy(stage_free[s]));
+  }
+  CUDA_CHECK(cudaStreamDestroy(copy_stream));
+}
+
 /**
  * @defgroup Functions to make predictions with a fitted ordinary least squares and ridge regression model
  * @param input         device pointer to feature matrix n_rows x n_cols
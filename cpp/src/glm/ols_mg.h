@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <common/cuml_comms_int.hpp>
+#include <stats/mean_center.h>
+#include <stats/sum.h>
+#include "ols.h"
+
+namespace ML {
+namespace GLM {
+
+using namespace MLCommon;
+
+template <typename math_t>
+__global__ void addToDiagonalKernel(math_t *A, int n, math_t alpha) {
+  int i = threadIdx.x + blockIdx.x * blockDim.x;
+  if (i < n) A[i * size_t(n) + i] += alpha;
+}
+
+/**
+ * Fits a ridge regression model, or an ordinary least squares one when alpha
+ * is zero, on the rows of all the ranks of the communicator of the handle,
+ * each rank holding a shard of the rows. A first allreduce of the column
+ * sums and of the row counts gives the means, about which each rank centers
+ * its rows in place, and a second one sums the Gram matrices and X^T y of
+ * the centered rows, solved as by olsGramSolve on every rank. What is sent
+ * is O(n_cols^2) whatever the number of rows. The input and the labels are
+ * restored on return.
+ * @param input         device pointer to the local rows, n_rows x n_cols
+ * @param n_rows        number of local rows, which may be zero
+ * @param n_cols        number of columns of the feature matrix
+ * @param labels        device pointer to the labels of the local rows
+ * @param alpha         the parameter of the l2 regularizer
+ * @param coef          device pointer to hold the solution for weights of size n_cols
+ * @param intercept     host pointer to hold the solution for bias term of size 1
+ * @param fit_intercept if true, fit intercept
+ */
+template <typename math_t>
+void ridgeFitMG(const cumlHandle_impl &handle, math_t *input, int n_rows,
+                int n_cols, math_t *labels, math_t alpha, math_t *coef,
+                math_t *intercept, bool fit_intercept, cudaStream_t stream) {
+  ASSERT(handle.commsInitialized(),
+         "A distributed linear regression requires a handle with a "
+         "communicator");
+  const MLCommon::cumlCommunicator &comm = handle.getCommunicator();
+  auto allocator = handle.getDeviceAllocator();
+
+  ASSERT(n_cols > 0, "ridgeFitMG: number of columns cannot be less than one");
+  ASSERT(n_rows >= 0, "ridgeFitMG: number of rows cannot be negative");
+  ASSERT(alpha >= math_t(0), "ridgeFitMG: alpha cannot be negative");
+
+  // the column sums and the sum of the labels, followed by the number of rows
+  device_buffer<math_t> sums(allocator, stream, n_cols + 2);
+  CUDA_CHECK(
+    cudaMemsetAsync(sums.data(), 0, sums.size() * sizeof(math_t), stream));
+  if (fit_intercept && n_rows > 0) {
+    Stats::sum(sums.data(), input, n_cols, n_rows, false, stream);
+    Stats::sum(sums.data() + n_cols, labels, 1, n_rows, false, stream);
+  }
+  math_t n_local = math_t(n_rows);
+  updateDevice(sums.data() + n_cols + 1, &n_local, 1, stream);
+  comm.allreduce(sums.data(), sums.data(), n_cols + 2,
+                 MLCommon::cumlCommunicator::SUM, stream);
+  math_t n_total;
+  updateHost(&n_total, sums.data() + n_cols + 1, 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  ASSERT(n_total > math_t(1),
+         "ridgeFitMG: number of rows cannot be less than two");
+  math_t *mu_input = sums.data(), *mu_labels = sums.data() + n_cols;
+  LinAlg::scalarMultiply(mu_input, mu_input, math_t(1) / n_total, n_cols + 1,
+                         stream);
+
+  // the Gram matrix, X^T y, and the sums of the centered columns and labels,
+  // reduced at once
+  const size_t len = size_t(n_cols) * n_cols;
+  device_buffer<math_t> stats(allocator, stream, len + 2 * n_cols + 1);
+  CUDA_CHECK(
+    cudaMemsetAsync(stats.data(), 0, stats.size() * sizeof(math_t), stream));
+  math_t *gram = stats.data(), *xty = gram + len, *sum_input = xty + n_cols;
+  math_t *sum_labels = sum_input + n_cols;
+  if (n_rows > 0) {
+    if (fit_intercept) {
+      Stats::meanCenter(input, input, mu_input, n_cols, n_rows, false, true,
+                        stream);
+      Stats::meanCenter(labels, labels, mu_labels, 1, n_rows, false, true,
+                        stream);
+    }
+    olsGramAccumulate(handle, input, n_rows, n_cols, labels, gram, xty,
+                      fit_intercept ? sum_input : (math_t *)NULL, sum_labels,
+                      stream);
+    if (fit_intercept) {
+      Stats::meanAdd(input, input, mu_input, n_cols, n_rows, false, true,
+                     stream);
+      Stats::meanAdd(labels, labels, mu_labels, 1, n_rows, false, true,
+                     stream);
+    }
+  }
+  comm.allreduce(stats.data(), stats.data(), stats.size(),
+                 MLCommon::cumlCommunicator::SUM, stream);
+
+  if (alpha > math_t(0)) {
+    const int TPB = 256;
+    addToDiagonalKernel<math_t>
+      <<<ceildiv(n_cols, TPB), TPB, 0, stream>>>(gram, n_cols, alpha);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+
+  olsGramSolve(handle, gram, xty, sum_input, sum_labels, mu_input, mu_labels,
+               size_t(n_total), n_cols, coef, intercept, fit_intercept,
+               stream);
+}
+
+/**
+ * Fits an ordinary least squares model on the rows of all the ranks of the
+ * communicator of the handle, see ridgeFitMG.
+ */
+template <typename math_t>
+void olsFitMG(const cumlHandle_impl &handle, math_t *input, int n_rows,
+              int n_cols, math_t *labels, math_t *coef, math_t *intercept,
+              bool fit_intercept, cudaStream_t stream) {
+  ridgeFitMG(handle, input, n_rows, n_cols, labels, math_t(0), coef,
+             intercept, fit_intercept, stream);
+}
+
+};  // namespace GLM
+};  // namespace ML
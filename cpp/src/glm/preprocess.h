@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <linalg/add.h>
 #include <linalg/gemm.h>
 #include <linalg/norm.h>
 #include <matrix/math.h>
@@ -95,6 +96,46 @@ void postProcessData(const cumlHandle_impl &handle, math_t *input, int n_rows,
   Stats::meanAdd(labels, labels, mu_labels, 1, n_rows, false, true, stream);
 }
 
+/**
+ * postProcessData for the n_models fits of a regularization path on the same
+ * preprocessed input: coefs holds the n_models weights (n_cols x n_models),
+ * and intercepts receives the n_models bias terms.
+ */
+template <typename math_t>
+void postProcessDataPath(const cumlHandle_impl &handle, math_t *input,
+                         int n_rows, int n_cols, math_t *labels, math_t *coefs,
+                         int n_models, math_t *intercepts, math_t *mu_input,
+                         math_t *mu_labels, math_t *norm2_input,
+                         bool normalize, cudaStream_t stream) {
+  ASSERT(n_cols > 0,
+         "Parameter n_cols: number of columns cannot be less than one");
+  ASSERT(n_rows > 1,
+         "Parameter n_rows: number of rows cannot be less than two");
+
+  cublasHandle_t cublas_handle = handle.getCublasHandle();
+  auto allocator = handle.getDeviceAllocator();
+  device_buffer<math_t> d_intercepts(allocator, stream, n_models);
+
+  if (normalize) {
+    Matrix::matrixVectorBinaryMult(input, norm2_input, n_rows, n_cols, false,
+                                   true, stream);
+    Matrix::matrixVectorBinaryDivSkipZero(coefs, norm2_input, n_models, n_cols,
+                                          true, true, stream, true);
+  }
+
+  LinAlg::gemm(coefs, n_cols, n_models, mu_input, d_intercepts.data(),
+               n_models, 1, CUBLAS_OP_T, CUBLAS_OP_N, math_t(-1), math_t(0),
+               cublas_handle, stream);
+  LinAlg::addDevScalar(d_intercepts.data(), d_intercepts.data(), mu_labels,
+                       n_models, stream);
+  updateHost(intercepts, d_intercepts.data(), n_models, stream);
+
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  Stats::meanAdd(input, input, mu_input, n_cols, n_rows, false, true, stream);
+  Stats::meanAdd(labels, labels, mu_labels, 1, n_rows, false, true, stream);
+}
+
 /** @} */
 };  // namespace GLM
 };  // namespace ML
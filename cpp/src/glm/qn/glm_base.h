@@ -80,6 +80,87 @@ inline void linearBwd(const cumlHandle_impl &handle, SimpleMat<T> &G,
   }
 }
 
+template <typename T>
+inline void linearFwd(const cumlHandle_impl &handle, SimpleMat<T> &Z,
+                      const SimpleSparseMat<T> &X, const SimpleMat<T> &W,
+                      cudaStream_t stream) {
+  // Forward pass:  compute Z <- W * X^T + bias, as Z^T <- X * W^T
+  ASSERT(W.ord == COL_MAJOR && Z.ord == COL_MAJOR,
+         "linearFwd: sparse input requires column major W and Z");
+  const bool has_bias = X.n != W.n;
+  const int D = X.n;
+  const int C = Z.m;
+  const int N = Z.n;
+  SimpleMat<T> weights;
+  col_slice(W, weights, 0, D);
+  if (has_bias) {
+    SimpleVec<T> bias;
+    col_ref(W, bias, D);
+    auto set_bias = [] __device__(const T z, const T b) { return b; };
+    MLCommon::LinAlg::matrixVectorOp(Z.data, Z.data, bias.data, Z.n, Z.m, false,
+                                     false, set_bias, stream);
+  }
+  const T beta = has_bias ? T(1) : T(0);
+  if (C == 1) {
+    // Z and Z^T have the same layout
+    X.csrmm(handle, false, true, C, T(1), weights.data, C, beta, Z.data, N,
+            stream);
+    return;
+  }
+  // cuSPARSE writes column major products only: Z^T goes through a buffer
+  MLCommon::device_buffer<T> Zt(handle.getDeviceAllocator(), stream, N * C);
+  X.csrmm(handle, false, true, C, T(1), weights.data, C, T(0), Zt.data(), N,
+          stream);
+  const T one = 1;
+  CUBLAS_CHECK(MLCommon::LinAlg::cublasgeam(
+    handle.getCublasHandle(), CUBLAS_OP_T, CUBLAS_OP_N, C, N, &one, Zt.data(),
+    N, &beta, Z.data, C, Z.data, C, stream));
+}
+
+template <typename T>
+inline void linearBwd(const cumlHandle_impl &handle, SimpleMat<T> &G,
+                      const SimpleSparseMat<T> &X, const SimpleMat<T> &dZ,
+                      bool setZero, cudaStream_t stream) {
+  // Backward pass:
+  // - compute G <- dZ * X, as G^T <- X^T * dZ^T
+  // - for bias: Gb = mean(dZ, 1)
+  ASSERT(G.ord == COL_MAJOR && dZ.ord == COL_MAJOR,
+         "linearBwd: sparse input requires column major G and dZ");
+  const bool has_bias = X.n != G.n;
+  const int D = X.n;
+  const int C = dZ.m;
+  const int N = dZ.n;
+  const T beta = setZero ? T(0) : T(1);
+  const T invN = T(1) / X.m;
+  SimpleMat<T> Gweights;
+  col_slice(G, Gweights, 0, D);
+  if (has_bias) {
+    SimpleVec<T> Gbias;
+    col_ref(G, Gbias, D);
+    MLCommon::Stats::mean(Gbias.data, dZ.data, dZ.m, dZ.n, false, true, stream);
+  }
+  if (C == 1) {
+    // dZ and G have the same layouts as their transposes
+    X.csrmm(handle, true, false, C, invN, dZ.data, N, beta, Gweights.data, D,
+            stream);
+    return;
+  }
+  auto allocator = handle.getDeviceAllocator();
+  MLCommon::device_buffer<T> dZt(allocator, stream, N * C);
+  MLCommon::device_buffer<T> Gt(allocator, stream, D * C);
+  const T one = 1;
+  const T zero = 0;
+  cublasHandle_t cublas_h = handle.getCublasHandle();
+  CUBLAS_CHECK(MLCommon::LinAlg::cublasgeam(
+    cublas_h, CUBLAS_OP_T, CUBLAS_OP_N, N, C, &one, dZ.data, C, &zero,
+    dZt.data(), N, dZt.data(), N, stream));
+  X.csrmm(handle, true, false, C, invN, dZt.data(), N, zero, Gt.data(), D,
+          stream);
+  CUBLAS_CHECK(MLCommon::LinAlg::cublasgeam(
+    cublas_h, CUBLAS_OP_T, CUBLAS_OP_N, C, D, &one, Gt.data(), D, &beta,
+    Gweights.data, C, Gweights.data, C, stream));
+}
+
 struct GLMDims {
   bool fit_intercept;
   int C, D, dims, n_param;
@@ -90,6 +171,24 @@ struct GLMDims {
   }
 };
 
+/**
+ * Sums the elementwise loss lz(y, z) * invN into loss_val and overwrites z
+ * with its derivative dlz(y, z), in a single pass over y and z
+ */
+template <typename T, class Loss, int TPB>
+__global__ void lossAndDZKernel(T *loss_val, T *z, const T *y, const int len,
+                                const T invN, const Loss *loss) {
+  T acc = 0;
+  const int idx = threadIdx.x + blockIdx.x * blockDim.x;
+  if (idx < len) {
+    const T yi = y[idx];
+    const T zi = z[idx];
+    acc = loss->lz(yi, zi) * invN;
+    z[idx] = loss->dlz(yi, zi);
+  }
+  MLCommon::LinAlg::reduce<T, TPB>(loss_val, acc);
+}
+
 template <typename T, class Loss>
 struct GLMBase : GLMDims {
   typedef SimpleMat<T> Mat;
@@ -112,25 +211,18 @@ struct GLMBase : GLMDims {
     // Base impl assumes simple case C = 1
     Loss *loss = static_cast<Loss *>(this);
     T invN = 1.0 / y.len;
+    static const int TPB = 256;
+    const int nblks = MLCommon::ceildiv(y.len, TPB);
 
-    auto f_l = [=] __device__(const T y, const T z) {
-      return loss->lz(y, z) * invN;
-    };
-
-    // TODO would be nice to have a kernel that fuses these two steps
-    // This would be easy, if mapThenSumReduce allowed outputing the result of
-    // map (supporting inplace)
-    MLCommon::LinAlg::mapThenSumReduce(loss_val, y.len, f_l, stream, y.data,
-                                       Z.data);
-
-    auto f_dl = [=] __device__(const T y, const T z) {
-      return loss->dlz(y, z);
-    };
-    MLCommon::LinAlg::binaryOp(Z.data, y.data, Z.data, y.len, f_dl, stream);
+    CUDA_CHECK(cudaMemsetAsync(loss_val, 0, sizeof(T), stream));
+    lossAndDZKernel<T, Loss, TPB><<<nblks, TPB, 0, stream>>>(
+      loss_val, Z.data, y.data, y.len, invN, loss);
+    CUDA_CHECK(cudaPeekAtLastError());
   }
 
-  inline void loss_grad(T *loss_val, Mat &G, const Mat &W,
-                        const SimpleMat<T> &Xb, const Vec &yb, Mat &Zb,
+  template <class XMat>
+  inline void loss_grad(T *loss_val, Mat &G, const Mat &W, const XMat &Xb,
+                        const Vec &yb, Mat &Zb,
                         cudaStream_t stream, bool initGradZero = true) {
     Loss *loss = static_cast<Loss *>(this);  // static polymorphism
 
@@ -141,12 +233,12 @@ struct GLMBase : GLMDims {
   }
 };
 
-template <typename T, class GLMObjective>
+template <typename T, class GLMObjective, class XMat = SimpleMat<T>>
 struct GLMWithData : GLMDims {
   typedef SimpleMat<T> Mat;
   typedef SimpleVec<T> Vec;
 
-  SimpleMat<T> X;
+  XMat X;
   Mat Z;
   Vec y;
   GLMObjective *objective;
@@ -160,6 +252,13 @@ struct GLMWithData : GLMDims {
       Z(Zptr, obj->C, N),
       GLMDims(obj->C, obj->D, obj->fit_intercept) {}
 
+  GLMWithData(GLMObjective *obj, const XMat &X, T *yptr, T *Zptr)
+    : objective(obj),
+      X(X),
+      y(yptr, X.m),
+      Z(Zptr, obj->C, X.m),
+      GLMDims(obj->C, obj->D, obj->fit_intercept) {}
+
   // interface exposed to typical non-linear optimizers
   inline T operator()(const Vec &wFlat, Vec &gradFlat, T *dev_scalar,
                       cudaStream_t stream) {
@@ -56,8 +56,9 @@ struct RegularizedGLM : GLMDims {
   RegularizedGLM(Loss *loss, Reg *reg)
     : reg(reg), loss(loss), GLMDims(loss->C, loss->D, loss->fit_intercept) {}
 
+  template <class XMat>
   inline void loss_grad(T *loss_val, SimpleMat<T> &G, const SimpleMat<T> &W,
-                        const SimpleMat<T> &Xb, const SimpleVec<T> &yb,
+                        const XMat &Xb, const SimpleVec<T> &yb,
                         SimpleMat<T> &Zb, cudaStream_t stream,
                         bool initGradZero = true) {
     T reg_host, loss_host;
@@ -26,12 +26,13 @@
 
 namespace ML {
 namespace GLM {
-template <typename T, typename LossFunction>
-int qn_fit(const cumlHandle_impl &handle, LossFunction &loss, T *Xptr, T *yptr,
-           T *zptr, int N, T l1, T l2, int max_iter, T grad_tol,
-           int linesearch_max_iter, int lbfgs_memory, int verbosity,
-           T *w0,  // initial value and result
-           T *fx, int *num_iters, STORAGE_ORDER ordX, cudaStream_t stream) {
+template <typename T, typename LossFunction, typename XMat>
+int qn_fit_mat(const cumlHandle_impl &handle, LossFunction &loss,
+               const XMat &X, T *yptr, T *zptr, T l1, T l2, int max_iter,
+               T grad_tol, int linesearch_max_iter, int lbfgs_memory,
+               int verbosity,
+               T *w0,  // initial value and result
+               T *fx, int *num_iters, cudaStream_t stream) {
   LBFGSParam<T> opt_param;
   opt_param.epsilon = grad_tol;
   opt_param.max_iterations = max_iter;
@@ -40,7 +41,7 @@ int qn_fit(const cumlHandle_impl &handle, LossFunction &loss, T *Xptr, T *yptr,
   SimpleVec<T> w(w0, loss.n_param);
 
   if (l2 == 0) {
-    GLMWithData<T, LossFunction> lossWith(&loss, Xptr, yptr, zptr, N, ordX);
+    GLMWithData<T, LossFunction, XMat> lossWith(&loss, X, yptr, zptr);
 
     return qn_minimize(handle, w, fx, num_iters, lossWith, l1, opt_param,
                        stream, verbosity);
@@ -48,21 +49,35 @@ int qn_fit(const cumlHandle_impl &handle, LossFunction &loss, T *Xptr, T *yptr,
   } else {
     Tikhonov<T> reg(l2);
     RegularizedGLM<T, LossFunction, decltype(reg)> obj(&loss, &reg);
-    GLMWithData<T, decltype(obj)> lossWith(&obj, Xptr, yptr, zptr, N, ordX);
+    GLMWithData<T, decltype(obj), XMat> lossWith(&obj, X, yptr, zptr);
 
     return qn_minimize(handle, w, fx, num_iters, lossWith, l1, opt_param,
                        stream, verbosity);
   }
 }
 
-template <typename T>
-void qnFit(const cumlHandle_impl &handle, T *X, T *y, int N, int D, int C,
-           bool fit_intercept, T l1, T l2, int max_iter, T grad_tol,
-           int linesearch_max_iter, int lbfgs_memory, int verbosity, T *w0,
-           T *f, int *num_iters, bool X_col_major, int loss_type,
-           cudaStream_t stream) {
-  STORAGE_ORDER ord = X_col_major ? COL_MAJOR : ROW_MAJOR;
+template <typename T, typename LossFunction>
+int qn_fit(const cumlHandle_impl &handle, LossFunction &loss, T *Xptr, T *yptr,
+           T *zptr, int N, T l1, T l2, int max_iter, T grad_tol,
+           int linesearch_max_iter, int lbfgs_memory, int verbosity,
+           T *w0,  // initial value and result
+           T *fx, int *num_iters, STORAGE_ORDER ordX, cudaStream_t stream) {
+  SimpleMat<T> X(Xptr, N, loss.D, ordX);
+  return qn_fit_mat(handle, loss, X, yptr, zptr, l1, l2, max_iter, grad_tol,
+                    linesearch_max_iter, lbfgs_memory, verbosity, w0, fx,
+                    num_iters, stream);
+}
 
+/**
+ * Fits the GLM of loss_type on the dense or sparse input X, see qnFit.
+ */
+template <typename T, typename XMat>
+void qnFitMat(const cumlHandle_impl &handle, const XMat &X, T *y, int C,
+              bool fit_intercept, T l1, T l2, int max_iter, T grad_tol,
+              int linesearch_max_iter, int lbfgs_memory, int verbosity, T *w0,
+              T *f, int *num_iters, int loss_type, cudaStream_t stream) {
+  const int N = X.m;
+  const int D = X.n;
   MLCommon::device_buffer<T> tmp(handle.getDeviceAllocator(), stream, C * N);
 
   SimpleMat<T> z(tmp.data(), C, N);
@@ -71,23 +86,23 @@ void qnFit(const cumlHandle_impl &handle, T *X, T *y, int N, int D, int C,
     case 0: {
       ASSERT(C == 1, "qn.h: logistic loss invalid C");
       LogisticLoss<T> loss(handle, D, fit_intercept);
-      qn_fit<T, decltype(loss)>(handle, loss, X, y, z.data, N, l1, l2, max_iter,
-                                grad_tol, linesearch_max_iter, lbfgs_memory,
-                                verbosity, w0, f, num_iters, ord, stream);
+      qn_fit_mat(handle, loss, X, y, z.data, l1, l2, max_iter, grad_tol,
+                 linesearch_max_iter, lbfgs_memory, verbosity, w0, f,
+                 num_iters, stream);
     } break;
     case 1: {
       ASSERT(C == 1, "qn.h: squared loss invalid C");
       SquaredLoss<T> loss(handle, D, fit_intercept);
-      qn_fit<T, decltype(loss)>(handle, loss, X, y, z.data, N, l1, l2, max_iter,
-                                grad_tol, linesearch_max_iter, lbfgs_memory,
-                                verbosity, w0, f, num_iters, ord, stream);
+      qn_fit_mat(handle, loss, X, y, z.data, l1, l2, max_iter, grad_tol,
+                 linesearch_max_iter, lbfgs_memory, verbosity, w0, f,
+                 num_iters, stream);
     } break;
     case 2: {
       ASSERT(C > 1, "qn.h: softmax invalid C");
       Softmax<T> loss(handle, D, C, fit_intercept);
-      qn_fit<T, decltype(loss)>(handle, loss, X, y, z.data, N, l1, l2, max_iter,
-                                grad_tol, linesearch_max_iter, lbfgs_memory,
-                                verbosity, w0, f, num_iters, ord, stream);
+      qn_fit_mat(handle, loss, X, y, z.data, l1, l2, max_iter, grad_tol,
+                 linesearch_max_iter, lbfgs_memory, verbosity, w0, f,
+                 num_iters, stream);
     } break;
     default: {
       ASSERT(false, "qn.h: unknown loss function.");
@@ -96,14 +111,39 @@ void qnFit(const cumlHandle_impl &handle, T *X, T *y, int N, int D, int C,
 }
 
 template <typename T>
-void qnPredict(const cumlHandle_impl &handle, T *Xptr, int N, int D, int C,
-               bool fit_intercept, T *params, bool X_col_major, int loss_type,
-               T *preds, cudaStream_t stream) {
-  STORAGE_ORDER ordX = X_col_major ? COL_MAJOR : ROW_MAJOR;
+void qnFit(const cumlHandle_impl &handle, T *X, T *y, int N, int D, int C,
+           bool fit_intercept, T l1, T l2, int max_iter, T grad_tol,
+           int linesearch_max_iter, int lbfgs_memory, int verbosity, T *w0,
+           T *f, int *num_iters, bool X_col_major, int loss_type,
+           cudaStream_t stream) {
+  STORAGE_ORDER ord = X_col_major ? COL_MAJOR : ROW_MAJOR;
+  SimpleMat<T> Xmat(X, N, D, ord);
+  qnFitMat(handle, Xmat, y, C, fit_intercept, l1, l2, max_iter, grad_tol,
+           linesearch_max_iter, lbfgs_memory, verbosity, w0, f, num_iters,
+           loss_type, stream);
+}
+
+template <typename T>
+void qnFitSparse(const cumlHandle_impl &handle, T *X_values, int *X_cols,
+                 int *X_row_ids, int X_nnz, T *y, int N, int D, int C,
+                 bool fit_intercept, T l1, T l2, int max_iter, T grad_tol,
+                 int linesearch_max_iter, int lbfgs_memory, int verbosity,
+                 T *w0, T *f, int *num_iters, int loss_type,
+                 cudaStream_t stream) {
+  SimpleSparseMat<T> Xmat(X_values, X_cols, X_row_ids, X_nnz, N, D);
+  qnFitMat(handle, Xmat, y, C, fit_intercept, l1, l2, max_iter, grad_tol,
+           linesearch_max_iter, lbfgs_memory, verbosity, w0, f, num_iters,
+           loss_type, stream);
+}
 
+template <typename T, typename XMat>
+void qnPredictMat(const cumlHandle_impl &handle, const XMat &X, int C,
+                  bool fit_intercept, T *params, int loss_type, T *preds,
+                  cudaStream_t stream) {
+  const int N = X.m;
+  const int D = X.n;
   GLMDims dims(C, D, fit_intercept);
 
-  SimpleMat<T> X(Xptr, N, D, ordX);
   SimpleMat<T> P(preds, 1, N);
 
   MLCommon::device_buffer<T> tmp(handle.getDeviceAllocator(), stream, C * N);
@@ -135,5 +175,23 @@ void qnPredict(const cumlHandle_impl &handle, T *Xptr, int N, int D, int C,
   }
 }
 
+template <typename T>
+void qnPredict(const cumlHandle_impl &handle, T *Xptr, int N, int D, int C,
+               bool fit_intercept, T *params, bool X_col_major, int loss_type,
+               T *preds, cudaStream_t stream) {
+  STORAGE_ORDER ordX = X_col_major ? COL_MAJOR : ROW_MAJOR;
+  SimpleMat<T> X(Xptr, N, D, ordX);
+  qnPredictMat(handle, X, C, fit_intercept, params, loss_type, preds, stream);
+}
+
+template <typename T>
+void qnPredictSparse(const cumlHandle_impl &handle, T *X_values, int *X_cols,
+                     int *X_row_ids, int X_nnz, int N, int D, int C,
+                     bool fit_intercept, T *params, int loss_type, T *preds,
+                     cudaStream_t stream) {
+  SimpleSparseMat<T> X(X_values, X_cols, X_row_ids, X_nnz, N, D);
+  qnPredictMat(handle, X, C, fit_intercept, params, loss_type, preds, stream);
+}
+
 };  // namespace GLM
 };  // namespace ML
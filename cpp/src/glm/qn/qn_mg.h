@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <glm/qn/qn.h>
+#include <common/cuml_comms_int.hpp>
+
+namespace ML {
+namespace GLM {
+
+/**
+ * The loss of a GLM over the rows of all the ranks, each rank holding a
+ * shard of the rows. The loss and gradient of the local rows, means over
+ * these rows, are weighted by the share of the rows of the rank and summed
+ * over the ranks by a single allreduce. All the ranks thus see the same loss
+ * and gradient, and their optimizers take the same steps.
+ *
+ * It wraps the unregularized loss, so that the regularization is added once.
+ */
+template <typename T, class Loss>
+struct ShardedGLM : GLMDims {
+  Loss *loss;
+  const MLCommon::cumlCommunicator &comm;
+  T weight;
+  // the local gradient, followed by the local loss
+  SimpleVecOwning<T> buf;
+
+  ShardedGLM(const cumlHandle_impl &handle, Loss *loss, T weight,
+             cudaStream_t stream)
+    : GLMDims(loss->C, loss->D, loss->fit_intercept),
+      loss(loss),
+      comm(handle.getCommunicator()),
+      weight(weight),
+      buf(handle.getDeviceAllocator(), loss->n_param + 1, stream) {}
+
+  template <class XMat>
+  inline void loss_grad(T *loss_val, SimpleMat<T> &G, const SimpleMat<T> &W,
+                        const XMat &Xb, const SimpleVec<T> &yb,
+                        SimpleMat<T> &Zb, cudaStream_t stream,
+                        bool initGradZero = true) {
+    SimpleMat<T> G_local(buf.data, G.m, G.n);
+    T *loss_local = buf.data + n_param;
+    loss->loss_grad(loss_local, G_local, W, Xb, yb, Zb, stream, true);
+
+    buf.ax(weight, buf, stream);
+    comm.allreduce(buf.data, buf.data, buf.len,
+                   MLCommon::cumlCommunicator::SUM, stream);
+
+    if (initGradZero) {
+      G.copy_async(G_local, stream);
+    } else {
+      G.axpy(1, G_local, G, stream);
+    }
+    CUDA_CHECK(cudaMemcpyAsync(loss_val, loss_local, sizeof(T),
+                               cudaMemcpyDeviceToDevice, stream));
+  }
+};
+
+template <typename T, typename LossFunction, typename XMat>
+int qn_fit_mg(const cumlHandle_impl &handle, LossFunction &loss,
+              const XMat &X, T *yptr, T *zptr, T l1, T l2, int max_iter,
+              T grad_tol, int linesearch_max_iter, int lbfgs_memory,
+              int verbosity,
+              T *w0,  // initial value and result
+              T *fx, int *num_iters, cudaStream_t stream) {
+  const MLCommon::cumlCommunicator &comm = handle.getCommunicator();
+
+  // rank 0 sets the initial point of all the ranks
+  comm.bcast(w0, loss.n_param, 0, stream);
+
+  MLCommon::device_buffer<int64_t> n_rows(handle.getDeviceAllocator(), stream,
+                                          1);
+  int64_t n_local = X.m, n_total;
+  MLCommon::updateDevice(n_rows.data(), &n_local, 1, stream);
+  comm.allreduce(n_rows.data(), n_rows.data(), 1,
+                 MLCommon::cumlCommunicator::SUM, stream);
+  MLCommon::updateHost(&n_total, n_rows.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  ShardedGLM<T, LossFunction> sharded(handle, &loss, T(n_local) / n_total,
+                                      stream);
+  return qn_fit_mat(handle, sharded, X, yptr, zptr, l1, l2, max_iter,
+                    grad_tol, linesearch_max_iter, lbfgs_memory, verbosity, w0,
+                    fx, num_iters, stream);
+}
+
+/**
+ * Fits the GLM of loss_type on the rows of all the ranks, X and y being the
+ * local shard, see qnFit. The result is the same on all the ranks.
+ */
+template <typename T, typename XMat>
+void qnFitMGMat(const cumlHandle_impl &handle, const XMat &X, T *y, int C,
+                bool fit_intercept, T l1, T l2, int max_iter, T grad_tol,
+                int linesearch_max_iter, int lbfgs_memory, int verbosity,
+                T *w0, T *f, int *num_iters, int loss_type,
+                cudaStream_t stream) {
+  ASSERT(handle.commsInitialized(),
+         "A distributed GLM requires a handle with a communicator");
+  const int N = X.m;
+  const int D = X.n;
+  MLCommon::device_buffer<T> tmp(handle.getDeviceAllocator(), stream, C * N);
+
+  SimpleMat<T> z(tmp.data(), C, N);
+
+  switch (loss_type) {
+    case 0: {
+      ASSERT(C == 1, "qn.h: logistic loss invalid C");
+      LogisticLoss<T> loss(handle, D, fit_intercept);
+      qn_fit_mg(handle, loss, X, y, z.data, l1, l2, max_iter, grad_tol,
+                linesearch_max_iter, lbfgs_memory, verbosity, w0, f,
+                num_iters, stream);
+    } break;
+    case 1: {
+      ASSERT(C == 1, "qn.h: squared loss invalid C");
+      SquaredLoss<T> loss(handle, D, fit_intercept);
+      qn_fit_mg(handle, loss, X, y, z.data, l1, l2, max_iter, grad_tol,
+                linesearch_max_iter, lbfgs_memory, verbosity, w0, f,
+                num_iters, stream);
+    } break;
+    case 2: {
+      ASSERT(C > 1, "qn.h: softmax invalid C");
+      Softmax<T> loss(handle, D, C, fit_intercept);
+      qn_fit_mg(handle, loss, X, y, z.data, l1, l2, max_iter, grad_tol,
+                linesearch_max_iter, lbfgs_memory, verbosity, w0, f,
+                num_iters, stream);
+    } break;
+    default: {
+      ASSERT(false, "qn.h: unknown loss function.");
+    }
+  }
+}
+
+template <typename T>
+void qnFitMG(const cumlHandle_impl &handle, T *X, T *y, int N, int D, int C,
+             bool fit_intercept, T l1, T l2, int max_iter, T grad_tol,
+             int linesearch_max_iter, int lbfgs_memory, int verbosity, T *w0,
+             T *f, int *num_iters, bool X_col_major, int loss_type,
+             cudaStream_t stream) {
+  STORAGE_ORDER ord = X_col_major ? COL_MAJOR : ROW_MAJOR;
+  SimpleMat<T> Xmat(X, N, D, ord);
+  qnFitMGMat(handle, Xmat, y, C, fit_intercept, l1, l2, max_iter, grad_tol,
+             linesearch_max_iter, lbfgs_memory, verbosity, w0, f, num_iters,
+             loss_type, stream);
+}
+
+template <typename T>
+void qnFitSparseMG(const cumlHandle_impl &handle, T *X_values, int *X_cols,
+                   int *X_row_ids, int X_nnz, T *y, int N, int D, int C,
+                   bool fit_intercept, T l1, T l2, int max_iter, T grad_tol,
+                   int linesearch_max_iter, int lbfgs_memory, int verbosity,
+                   T *w0, T *f, int *num_iters, int loss_type,
+                   cudaStream_t stream) {
+  SimpleSparseMat<T> Xmat(X_values, X_cols, X_row_ids, X_nnz, N, D);
+  qnFitMGMat(handle, Xmat, y, C, fit_intercept, l1, l2, max_iter, grad_tol,
+             linesearch_max_iter, lbfgs_memory, verbosity, w0, f, num_iters,
+             loss_type, stream);
+}
+
+};  // namespace GLM
+};  // namespace ML
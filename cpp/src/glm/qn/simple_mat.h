@@ -25,6 +25,7 @@
 #include <linalg/norm.h>
 #include <linalg/ternary_op.h>
 #include <linalg/unary_op.h>
+#include <sparse/cusparse_wrappers.h>
 #include <common/cumlHandle.hpp>
 #include <common/device_buffer.hpp>
 
@@ -198,6 +199,44 @@ struct SimpleVec : SimpleMat<T> {
   inline void reset(T *new_data, int n) { Super::reset(new_data, n, 1); }
 };
 
+/**
+ * A non-owning m x n CSR matrix of nnz values. It is only used as a read-only
+ * operand of sparse x dense products, e.g. for the GLM input data.
+ */
+template <typename T>
+struct SimpleSparseMat {
+  int m, n;
+  T *values;
+  int *cols;
+  int *row_ids;  // row offsets, m + 1 entries
+  int nnz;
+
+  SimpleSparseMat(T *values, int *cols, int *row_ids, int nnz, int m, int n)
+    : values(values), cols(cols), row_ids(row_ids), nnz(nnz), m(m), n(n) {}
+
+  // C = alpha * op(this) * op(B) + beta * C, B and C dense column major, with
+  // n_cols columns in op(B) and C. op(B) can be transposed only if op(this)
+  // is not.
+  inline void csrmm(const cumlHandle_impl &handle, const bool transA,
+                    const bool transB, const int n_cols, const T alpha,
+                    const T *B, const int ldb, const T beta, T *C,
+                    const int ldc, cudaStream_t stream) const {
+    ASSERT(!(transA && transB),
+           "SimpleSparseMat::csrmm: only one operand can be transposed");
+    cusparseMatDescr_t descr;
+    CUSPARSE_CHECK(cusparseCreateMatDescr(&descr));
+    CUSPARSE_CHECK(MLCommon::Sparse::cusparse_csrmm2(
+      handle.getcusparseHandle(),
+      transA ? CUSPARSE_OPERATION_TRANSPOSE
+             : CUSPARSE_OPERATION_NON_TRANSPOSE,
+      transB ? CUSPARSE_OPERATION_TRANSPOSE
+             : CUSPARSE_OPERATION_NON_TRANSPOSE,
+      m, n_cols, n, nnz, &alpha, descr, values, row_ids, cols, B, ldb, &beta,
+      C, ldc, stream));
+    CUSPARSE_CHECK(cusparseDestroyMatDescr(descr));
+  }
+};
+
 template <typename T>
 inline void col_ref(const SimpleMat<T> &mat, SimpleVec<T> &mask_vec, int c) {
   ASSERT(mat.ord == COL_MAJOR, "col_ref only available for column major mats");
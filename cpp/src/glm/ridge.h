@@ -27,7 +27,9 @@
 #include <stats/mean_center.h>
 #include <stats/stddev.h>
 #include <stats/sum.h>
+#include <algorithm>
 #include "common/cumlHandle.hpp"
+#include "common/device_buffer.hpp"
 #include "ml_utils.h"
 #include "preprocess.h"
 
@@ -192,6 +194,91 @@ void ridgeFit(const cumlHandle_impl &handle, math_t *input, int n_rows,
   }
 }
 
+/**
+ * @defgroup Functions fit the ridge regression models of a sequence of alphas.
+ * The data is preprocessed and decomposed once, and each alpha then costs a
+ * ridgeSolve on the decomposition.
+ * @param input         device pointer to feature matrix n_rows x n_cols
+ * @param n_rows        number of rows of the feature matrix
+ * @param n_cols        number of columns of the feature matrix
+ * @param labels        device pointer to label vector of length n_rows
+ * @param alphas        host pointer to the parameters of the l2 regularizer
+ * @param n_alphas      number of regularization parameters
+ * @param coefs         device pointer to hold the weights of each alpha,
+ *                      n_cols x n_alphas
+ * @param intercepts    host pointer to hold the bias terms of each alpha
+ * @param fit_intercept if true, fit intercept
+ * @param normalize     if true, normalize data to zero mean, unit variance
+ * @param algo          specifies which solver to use (0: SVD, 1: Eigendecomposition)
+ * @{
+ */
+template <typename math_t>
+void ridgeFitPath(const cumlHandle_impl &handle, math_t *input, int n_rows,
+                  int n_cols, math_t *labels, const math_t *alphas,
+                  int n_alphas, math_t *coefs, math_t *intercepts,
+                  bool fit_intercept, bool normalize, cudaStream_t stream,
+                  int algo = 0) {
+  auto cublas_handle = handle.getCublasHandle();
+  auto cusolver_handle = handle.getcusolverDnHandle();
+  auto allocator = handle.getDeviceAllocator();
+
+  ASSERT(n_cols > 0,
+         "ridgeFitPath: number of columns cannot be less than one");
+  ASSERT(n_rows > 1, "ridgeFitPath: number of rows cannot be less than two");
+  ASSERT(n_alphas > 0,
+         "ridgeFitPath: number of alphas cannot be less than one");
+
+  device_buffer<math_t> mu_input(allocator, stream);
+  device_buffer<math_t> norm2_input(allocator, stream);
+  device_buffer<math_t> mu_labels(allocator, stream);
+
+  if (fit_intercept) {
+    mu_input.resize(n_cols, stream);
+    mu_labels.resize(1, stream);
+    if (normalize) {
+      norm2_input.resize(n_cols, stream);
+    }
+    preProcessData(handle, input, n_rows, n_cols, labels, intercepts,
+                   mu_input.data(), mu_labels.data(), norm2_input.data(),
+                   fit_intercept, normalize, stream);
+  }
+
+  device_buffer<math_t> U(allocator, stream, n_rows * n_cols);
+  device_buffer<math_t> V(allocator, stream, n_cols * n_cols);
+  device_buffer<math_t> S(allocator, stream, n_cols);
+  if (algo == 0 || n_cols == 1) {
+    LinAlg::svdQR(input, n_rows, n_cols, S.data(), U.data(), V.data(), true,
+                  true, true, cusolver_handle, cublas_handle, allocator,
+                  stream);
+  } else if (algo == 1) {
+    LinAlg::svdEig(input, n_rows, n_cols, S.data(), U.data(), V.data(), true,
+                   cublas_handle, cusolver_handle, stream, allocator);
+  } else {
+    ASSERT(false,
+           "ridgeFitPath: no algorithm with this id has been implemented");
+  }
+
+  // ridgeSolve scales S and V in place, it works on copies of them
+  device_buffer<math_t> S_alpha(allocator, stream, n_cols);
+  device_buffer<math_t> V_alpha(allocator, stream, n_cols * n_cols);
+  for (int k = 0; k < n_alphas; k++) {
+    math_t alpha = alphas[k];
+    copy(S_alpha.data(), S.data(), n_cols, stream);
+    copy(V_alpha.data(), V.data(), n_cols * n_cols, stream);
+    ridgeSolve(handle, S_alpha.data(), V_alpha.data(), U.data(), n_rows,
+               n_cols, labels, &alpha, 1, coefs + k * n_cols, stream);
+  }
+
+  if (fit_intercept) {
+    postProcessDataPath(handle, input, n_rows, n_cols, labels, coefs,
+                        n_alphas, intercepts, mu_input.data(),
+                        mu_labels.data(), norm2_input.data(), normalize,
+                        stream);
+  } else {
+    std::fill(intercepts, intercepts + n_alphas, math_t(0));
+  }
+}
+
 /**
  * @defgroup Functions to make predictions with a fitted ordinary least squares and ridge regression model
  * @param input         device pointer to feature matrix n_rows x n_cols
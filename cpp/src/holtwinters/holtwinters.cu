@@ -65,5 +65,67 @@ void forecast(const ML::cumlHandle &handle, int n, int batch_size,
                                         forecast_d);
 }
 
+void fit(const ML::cumlHandle &handle, int n, int batch_size, int frequency,
+         int start_periods, ML::SeasonalType seasonal, float epsilon,
+         float *data, float *level_d, float *trend_d, float *season_d,
+         float *error_d, float *alpha_d, float *beta_d, float *gamma_d) {
+  ML::HoltWintersFitHelper<float>(handle, n, batch_size, frequency,
+                                  start_periods, seasonal, epsilon, data,
+                                  level_d, trend_d, season_d, error_d, alpha_d,
+                                  beta_d, gamma_d);
+}
+
+void fit(const ML::cumlHandle &handle, int n, int batch_size, int frequency,
+         int start_periods, ML::SeasonalType seasonal, double epsilon,
+         double *data, double *level_d, double *trend_d, double *season_d,
+         double *error_d, double *alpha_d, double *beta_d, double *gamma_d) {
+  ML::HoltWintersFitHelper<double>(handle, n, batch_size, frequency,
+                                   start_periods, seasonal, epsilon, data,
+                                   level_d, trend_d, season_d, error_d,
+                                   alpha_d, beta_d, gamma_d);
+}
+
+void forecast(const ML::cumlHandle &handle, int n, int batch_size,
+              int frequency, int h, ML::SeasonalType seasonal, float *level_d,
+              float *trend_d, float *season_d, const float *alpha_d,
+              const float *beta_d, const float *gamma_d, const float *error_d,
+              float confidence, float *forecast_d, float *lower_d,
+              float *upper_d) {
+  ML::HoltWintersForecastIntervalHelper<float>(
+    handle, n, batch_size, frequency, h, seasonal, level_d, trend_d, season_d,
+    alpha_d, beta_d, gamma_d, error_d, confidence, forecast_d, lower_d,
+    upper_d);
+}
+
+void forecast(const ML::cumlHandle &handle, int n, int batch_size,
+              int frequency, int h, ML::SeasonalType seasonal, double *level_d,
+              double *trend_d, double *season_d, const double *alpha_d,
+              const double *beta_d, const double *gamma_d,
+              const double *error_d, double confidence, double *forecast_d,
+              double *lower_d, double *upper_d) {
+  ML::HoltWintersForecastIntervalHelper<double>(
+    handle, n, batch_size, frequency, h, seasonal, level_d, trend_d, season_d,
+    alpha_d, beta_d, gamma_d, error_d, confidence, forecast_d, lower_d,
+    upper_d);
+}
+
+void update(const ML::cumlHandle &handle, int n, int batch_size, int frequency,
+            int n_new, ML::SeasonalType seasonal, const float *data,
+            const float *alpha_d, const float *beta_d, const float *gamma_d,
+            float *level_d, float *trend_d, float *season_d) {
+  ML::HoltWintersUpdateHelper<float>(handle, n, batch_size, frequency, n_new,
+                                     seasonal, data, alpha_d, beta_d, gamma_d,
+                                     level_d, trend_d, season_d);
+}
+
+void update(const ML::cumlHandle &handle, int n, int batch_size, int frequency,
+            int n_new, ML::SeasonalType seasonal, const double *data,
+            const double *alpha_d, const double *beta_d, const double *gamma_d,
+            double *level_d, double *trend_d, double *season_d) {
+  ML::HoltWintersUpdateHelper<double>(handle, n, batch_size, frequency,
+                                      n_new, seasonal, data, alpha_d, beta_d,
+                                      gamma_d, level_d, trend_d, season_d);
+}
+
 }  // namespace HoltWinters
 }  // namespace ML
@@ -86,4 +86,128 @@ void holtwinters_forecast_gpu(const ML::cumlHandle_impl &handle,
         forecast, h, batch_size, frequency, level_coef, trend_coef, season_coef,
         is_additive);
   }
-}
\ No newline at end of file
+}
+
+// Prediction intervals of the additive error model: the variance of the
+// forecast i steps ahead is sigma^2 (1 + sum_{j<i} c_j^2), with
+// c_j = alpha (1 + j beta) + gamma (1 - alpha) [j % frequency == 0]
+template <typename Dtype>
+__global__ void holtwinters_forecast_interval_kernel(
+  const Dtype *forecast, Dtype *lower, Dtype *upper, int h, int batch_size,
+  int frequency, int n_errors, const Dtype *alpha, const Dtype *beta,
+  const Dtype *gamma, const Dtype *error, Dtype confidence) {
+  int tid = GET_TID;
+  if (tid < batch_size) {
+    const Dtype z = normcdfinv(0.5 + 0.5 * (double)confidence);
+    const Dtype sigma2 = error[tid] / n_errors;
+    const Dtype alpha_ = alpha[tid];
+    const Dtype beta_ = beta ? beta[tid] : 0.;
+    const Dtype gamma_ = gamma ? gamma[tid] : 0.;
+    Dtype c_sum = 0.;
+    for (int i = 0; i < h; ++i) {
+      const Dtype width = z * sqrt(sigma2 * (1 + c_sum));
+      lower[tid + i * batch_size] = forecast[tid + i * batch_size] - width;
+      upper[tid + i * batch_size] = forecast[tid + i * batch_size] + width;
+      const int j = i + 1;
+      Dtype c = alpha_ * (1 + j * beta_);
+      if (gamma && j % frequency == 0) c += gamma_ * (1 - alpha_);
+      c_sum += c * c;
+    }
+  }
+}
+
+template <typename Dtype>
+void holtwinters_forecast_interval_gpu(
+  const ML::cumlHandle_impl &handle, const Dtype *forecast, Dtype *lower,
+  Dtype *upper, int h, int batch_size, int frequency, int n_errors,
+  const Dtype *alpha, const Dtype *beta, const Dtype *gamma,
+  const Dtype *error, Dtype confidence) {
+  cudaStream_t stream = handle.getStream();
+
+  int total_blocks = GET_NUM_BLOCKS(batch_size);
+  int threads_per_block = GET_THREADS_PER_BLOCK(batch_size);
+
+  holtwinters_forecast_interval_kernel<Dtype>
+    <<<total_blocks, threads_per_block, 0, stream>>>(
+      forecast, lower, upper, h, batch_size, frequency, n_errors, alpha, beta,
+      gamma, error, confidence);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+// Runs the smoothing equations of holtwinters_eval_device over new
+// observations, from the last state of a fit. The seasonal coefficients are
+// rotated so that the first one is still that of the next point
+template <typename Dtype>
+__global__ void holtwinters_update_kernel(
+  const Dtype *data, int n_new, int batch_size, int frequency,
+  const Dtype *alpha, const Dtype *beta, const Dtype *gamma,
+  Dtype *level_coef, Dtype *trend_coef, Dtype *season_coef, Dtype *pseason,
+  bool additive) {
+  int tid = GET_TID;
+  if (tid < batch_size) {
+    const Dtype alpha_ = alpha[tid];
+    const Dtype beta_ = beta ? beta[tid] : 0.;
+    const Dtype gamma_ = gamma ? gamma[tid] : 0.;
+    Dtype plevel = level_coef[tid];
+    Dtype ptrend = trend_coef ? trend_coef[tid] : 0.;
+    for (int i = 0; i < n_new; ++i) {
+      const Dtype pts = data[tid * n_new + i];
+      const int s = i % frequency;
+      const Dtype stmp =
+        season_coef ? pseason[tid + s * batch_size] : (Dtype)(!additive);
+      const Dtype leveltrend = plevel + ptrend;
+      Dtype clevel;
+      if (additive) {
+        clevel = alpha_ * (pts - stmp) + (1 - alpha_) * leveltrend;
+      } else {
+        Dtype stmp_eps = abs(stmp) > STMP_EPS ? stmp : STMP_EPS;
+        clevel = alpha_ * (pts / stmp_eps) + (1 - alpha_) * leveltrend;
+      }
+      if (trend_coef) ptrend = beta_ * (clevel - plevel) + (1 - beta_) * ptrend;
+      if (season_coef) {
+        if (additive)
+          pseason[tid + s * batch_size] =
+            gamma_ * (pts - clevel) + (1 - gamma_) * stmp;
+        else
+          pseason[tid + s * batch_size] =
+            gamma_ * (pts / clevel) + (1 - gamma_) * stmp;
+      }
+      plevel = clevel;
+    }
+    level_coef[tid] = plevel;
+    if (trend_coef) trend_coef[tid] = ptrend;
+    if (season_coef) {
+      for (int k = 0; k < frequency; ++k)
+        season_coef[tid + k * batch_size] =
+          pseason[tid + ((k + n_new) % frequency) * batch_size];
+    }
+  }
+}
+
+template <typename Dtype>
+void holtwinters_update_gpu(const ML::cumlHandle_impl &handle,
+                            const Dtype *data, int n_new, int batch_size,
+                            int frequency, const Dtype *alpha,
+                            const Dtype *beta, const Dtype *gamma,
+                            Dtype *level_coef, Dtype *trend_coef,
+                            Dtype *season_coef, ML::SeasonalType seasonal) {
+  cudaStream_t stream = handle.getStream();
+  std::shared_ptr<MLCommon::deviceAllocator> dev_allocator =
+    handle.getDeviceAllocator();
+
+  int total_blocks = GET_NUM_BLOCKS(batch_size);
+  int threads_per_block = GET_THREADS_PER_BLOCK(batch_size);
+  bool is_additive = seasonal == ML::SeasonalType::ADDITIVE;
+
+  MLCommon::device_buffer<Dtype> pseason(dev_allocator, stream,
+                                         season_coef ? batch_size * frequency
+                                                     : 0);
+  if (season_coef)
+    MLCommon::copy(pseason.data(), season_coef, batch_size * frequency,
+                   stream);
+  holtwinters_update_kernel<Dtype>
+    <<<total_blocks, threads_per_block, 0, stream>>>(
+      data, n_new, batch_size, frequency, alpha, beta, gamma, level_coef,
+      trend_coef, season_coef, pseason.data(), is_additive);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
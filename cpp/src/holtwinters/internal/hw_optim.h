@@ -296,6 +296,197 @@ __device__ ML::OptimCriterion holtwinters_bfgs_optim_device(
   return ML::OptimCriterion::OPTIM_BFGS_ITER_LIMIT;
 }
 
+// Number of lanes optimizing a series together in
+// holtwinters_optim_gpu_warp_kernel: lanes 2k and 2k + 1 evaluate the finite
+// difference of the k-th parameter, and the lanes all try one step size of
+// the line search each
+#define HW_OPTIM_LANES 8
+
+template <typename Dtype>
+__device__ Dtype hw_lanes_shfl(unsigned mask, Dtype val, int lane) {
+  return __shfl_sync(mask, val, lane, HW_OPTIM_LANES);
+}
+
+template <typename Dtype>
+__device__ void holtwinters_finite_gradient_lanes_device(
+  int lane, unsigned mask, int tid, const Dtype *ts, int n, int batch_size,
+  int frequency, int shift, Dtype plevel, Dtype ptrend, Dtype *pseason,
+  int pseason_width, const Dtype *start_season, const Dtype *beta,
+  const Dtype *gamma, Dtype alpha_, Dtype beta_, Dtype gamma_, Dtype *g_alpha,
+  Dtype *g_beta, Dtype *g_gamma, Dtype eps, bool ADDITIVE_KERNEL) {
+  int k = lane / 2;
+  Dtype h = lane % 2 ? eps : -eps;
+  bool active = (k == 0 && g_alpha) || (k == 1 && g_beta) ||
+                (k == 2 && g_gamma);
+  Dtype loss = .0;
+  if (active) {
+    loss = holtwinters_eval_device<Dtype>(
+      tid, ts, n, batch_size, frequency, shift, plevel, ptrend, pseason,
+      pseason_width, start_season, beta, gamma, alpha_ + (k == 0 ? h : .0),
+      beta_ + (k == 1 ? h : .0), gamma_ + (k == 2 ? h : .0), nullptr, nullptr,
+      nullptr, nullptr, ADDITIVE_KERNEL);
+  }
+  Dtype *g[3] = {g_alpha, g_beta, g_gamma};
+  for (int j = 0; j < 3; j++) {
+    Dtype left_error = hw_lanes_shfl(mask, loss, 2 * j);
+    Dtype right_error = hw_lanes_shfl(mask, loss, 2 * j + 1);
+    if (g[j]) *g[j] = (right_error - left_error) / (eps * 2.);
+  }
+}
+
+// Same iterations as holtwinters_bfgs_optim_device, HW_OPTIM_LANES lanes
+// evaluating concurrently the finite differences of the gradient and the
+// step sizes of the backtracking line search. All the lanes hold the same
+// state; each has its own seasonal buffer in pseason
+template <typename Dtype>
+__device__ ML::OptimCriterion holtwinters_bfgs_optim_lanes_device(
+  int lane, unsigned mask, int tid, const Dtype *ts, int n, int batch_size,
+  int frequency, int shift, Dtype plevel, Dtype ptrend, Dtype *pseason,
+  int pseason_width, const Dtype *start_season, const Dtype *beta,
+  const Dtype *gamma, bool optim_alpha, Dtype *x1, bool optim_beta, Dtype *x2,
+  bool optim_gamma, Dtype *x3, const ML::OptimParams<Dtype> optim_params,
+  bool ADDITIVE_KERNEL) {
+  Dtype H11 = 1., H12 = .0, H13 = .0, H22 = 1., H23 = .0,
+        H33 = 1.;  // Hessian approximiation (Hessian is symmetric)
+  Dtype g1 = .0, g2 = .0, g3 = .0;  // gradients
+  const int ls_lanes = HW_OPTIM_LANES - 1;
+  const int ls_limit = optim_params.linesearch_iter_limit;
+
+  // initial gradient
+  holtwinters_finite_gradient_lanes_device<Dtype>(
+    lane, mask, tid, ts, n, batch_size, frequency, shift, plevel, ptrend,
+    pseason, pseason_width, start_season, beta, gamma, *x1, *x2, *x3,
+    optim_alpha ? &g1 : nullptr, optim_beta ? &g2 : nullptr,
+    optim_gamma ? &g3 : nullptr, optim_params.eps, ADDITIVE_KERNEL);
+
+  for (int iter = 0; iter < optim_params.bfgs_iter_limit; ++iter) {
+    // Step direction
+    Dtype p1 = -H11 * g1 - H12 * g2 - H13 * g3;
+    Dtype p2 = -H12 * g1 - H22 * g2 - H23 * g3;
+    Dtype p3 = -H13 * g1 - H23 * g2 - H33 * g3;
+
+    const Dtype phi = p1 * g1 + p2 * g2 + p3 * g3;
+    if (phi > 0) {
+      H11 = 1.;
+      H12 = 0.;
+      H13 = 0.;
+      H22 = 1.;
+      H23 = 0.;
+      H33 = 1.;
+      p1 = -g1;
+      p2 = -g2;
+      p3 = -g3;
+    }
+
+    Dtype step0;
+    if (optim_params.linesearch_step_size <= 0)
+      step0 = (Dtype)0.866 / sqrt(p1 * p1 + p2 * p2 + p3 * p3);
+    else
+      step0 = optim_params.linesearch_step_size;
+    const Dtype cauchy =
+      optim_params.linesearch_c * (g1 * p1 + g2 * p2 + g3 * p3);
+
+    // line search: the i-th step size is step0 * tau^i, the first one that
+    // satisfies the Armijo condition is taken, or the last one. The last
+    // lane evaluates the reference loss in the first round
+    Dtype loss_ref = .0, loss = .0, step_size = step0;
+    int chosen = -1;
+    for (int first = 0; chosen < 0; first += ls_lanes) {
+      int i = first + lane;
+      Dtype step_i = step0;
+      for (int j = 0; j < i && j < ls_limit; j++)
+        step_i *= optim_params.linesearch_tau;
+      Dtype loss_i = .0;
+      if ((lane < ls_lanes && i <= ls_limit) ||
+          (first == 0 && lane == ls_lanes)) {
+        Dtype a = lane < ls_lanes ? step_i : .0;
+        loss_i = holtwinters_eval_device<Dtype>(
+          tid, ts, n, batch_size, frequency, shift, plevel, ptrend, pseason,
+          pseason_width, start_season, beta, gamma, *x1 + a * p1,
+          *x2 + a * p2, *x3 + a * p3, nullptr, nullptr, nullptr, nullptr,
+          ADDITIVE_KERNEL);
+      }
+      if (first == 0) loss_ref = hw_lanes_shfl(mask, loss_i, ls_lanes);
+      bool ok = lane < ls_lanes && i <= ls_limit &&
+                !(loss_i > loss_ref + step_i * cauchy);
+      unsigned ballot = __ballot_sync(mask, ok) >>
+                        (threadIdx.x % 32 / HW_OPTIM_LANES * HW_OPTIM_LANES);
+      int src = -1;
+      if (ballot) {
+        src = __ffs(ballot) - 1;
+      } else if (ls_limit < first + ls_lanes) {
+        src = ls_limit - first;
+      }
+      if (src >= 0) {
+        chosen = first + src;
+        loss = hw_lanes_shfl(mask, loss_i, src);
+        step_size = hw_lanes_shfl(mask, step_i, src);
+      }
+    }
+    Dtype nx1 = *x1 + step_size * p1;
+    Dtype nx2 = *x2 + step_size * p2;
+    Dtype nx3 = *x3 + step_size * p3;
+    // end of line search
+
+    // see if new {params} meet stop condition
+    const Dtype dx1 = abs_device(*x1 - nx1);
+    const Dtype dx2 = abs_device(*x2 - nx2);
+    const Dtype dx3 = abs_device(*x3 - nx3);
+    Dtype max = max3(dx1, dx2, dx3);
+    // update {params}
+    *x1 = nx1;
+    *x2 = nx2;
+    *x3 = nx3;
+    if (optim_params.min_param_diff > max)
+      return ML::OptimCriterion::OPTIM_MIN_PARAM_DIFF;
+    if (optim_params.min_error_diff > abs_device(loss - loss_ref))
+      return ML::OptimCriterion::OPTIM_MIN_ERROR_DIFF;
+
+    Dtype ng1 = .0, ng2 = .0, ng3 = .0;  // next gradient
+    holtwinters_finite_gradient_lanes_device<Dtype>(
+      lane, mask, tid, ts, n, batch_size, frequency, shift, plevel, ptrend,
+      pseason, pseason_width, start_season, beta, gamma, nx1, nx2, nx3,
+      optim_alpha ? &ng1 : nullptr, optim_beta ? &ng2 : nullptr,
+      optim_gamma ? &ng3 : nullptr, optim_params.eps, ADDITIVE_KERNEL);
+    // see if new gradients meet stop condition
+    max = max3(abs_device(ng1), abs_device(ng2), abs_device(ng3));
+    if (optim_params.min_grad_norm > max)
+      return ML::OptimCriterion::OPTIM_MIN_GRAD_NORM;
+
+    // s = step_size*p;
+    const Dtype s1 = step_size * p1;
+    const Dtype s2 = step_size * p2;
+    const Dtype s3 = step_size * p3;
+
+    // y = next_grad-grad
+    const Dtype y1 = ng1 - g1;
+    const Dtype y2 = ng2 - g2;
+    const Dtype y3 = ng3 - g3;
+
+    // rho_ = y(*)s; rho = 1/rho_
+    const Dtype rho_ = y1 * s1 + y2 * s2 + y3 * s3;
+    const Dtype rho = 1.0 / rho_;
+
+    const Dtype Hy1 = H11 * y1 + H12 * y2 + H13 * y3;
+    const Dtype Hy2 = H12 * y1 + H22 * y2 + H23 * y3;
+    const Dtype Hy3 = H13 * y1 + H23 * y2 + H33 * y3;
+    const Dtype k = rho * rho * (y1 * Hy1 + y2 * Hy2 + y3 * Hy3 + rho_);
+
+    H11 += k * s1 * s1 - 2. * rho * s1 * Hy1;
+    H12 += k * s1 * s2 - rho * (s2 * Hy1 + s1 * Hy2);
+    H13 += k * s1 * s3 - rho * (s3 * Hy1 + s1 * Hy3);
+    H22 += k * s2 * s2 - 2 * rho * s2 * Hy2;
+    H23 += k * s2 * s3 - rho * (s3 * Hy2 + s2 * Hy3);
+    H33 += k * s3 * s3 - 2. * rho * s3 * Hy3;
+
+    g1 = ng1;
+    g2 = ng2;
+    g3 = ng3;
+  }
+
+  return ML::OptimCriterion::OPTIM_BFGS_ITER_LIMIT;
+}
+
 template <typename Dtype>
 __global__ void holtwinters_optim_gpu_shared_kernel(
   const Dtype *ts, int n, int batch_size, int frequency,
@@ -409,6 +600,62 @@ __global__ void holtwinters_optim_gpu_global_kernel(
   }
 }
 
+// HW_OPTIM_LANES threads per series, for the seasonal periods too long for
+// the shared kernel. The seasonal buffers of the lanes of a series are
+// interleaved in pseason, so that their accesses are coalesced. Only used
+// when several parameters are optimized
+template <typename Dtype>
+__global__ void holtwinters_optim_gpu_warp_kernel(
+  const Dtype *ts, int n, int batch_size, int frequency,
+  const Dtype *start_level, const Dtype *start_trend, const Dtype *start_season,
+  Dtype *pseason, Dtype *alpha, bool optim_alpha, Dtype *beta, bool optim_beta,
+  Dtype *gamma, bool optim_gamma, Dtype *level, Dtype *trend, Dtype *season,
+  Dtype *xhat, Dtype *error, ML::OptimCriterion *optim_result,
+  const ML::OptimParams<Dtype> optim_params, bool ADDITIVE_KERNEL) {
+  int tid = GET_TID / HW_OPTIM_LANES;
+  int lane = GET_TID % HW_OPTIM_LANES;
+  unsigned mask = ((1u << HW_OPTIM_LANES) - 1)
+                  << (threadIdx.x % 32 / HW_OPTIM_LANES * HW_OPTIM_LANES);
+  if (tid < batch_size) {
+    int shift = 1;
+    Dtype plevel = start_level[tid], ptrend = .0;
+    Dtype alpha_ = alpha[tid];
+    Dtype beta_ = beta ? beta[tid] : .0;
+    Dtype gamma_ = gamma ? gamma[tid] : .0;
+
+    if (gamma) {
+      shift = frequency;
+      ptrend = beta ? start_trend[tid] : .0;
+    } else if (beta) {
+      shift = 2;
+      ptrend = start_trend[tid];
+    }
+
+    // Optimization
+    Dtype *pseason_lane = pseason + tid * frequency * HW_OPTIM_LANES + lane;
+    ML::OptimCriterion optim = holtwinters_bfgs_optim_lanes_device<Dtype>(
+      lane, mask, tid, ts, n, batch_size, frequency, shift, plevel, ptrend,
+      pseason_lane, HW_OPTIM_LANES, start_season, beta, gamma, optim_alpha,
+      &alpha_, optim_beta, &beta_, optim_gamma, &gamma_, optim_params,
+      ADDITIVE_KERNEL);
+    if (lane != 0) return;
+
+    if (optim_alpha) alpha[tid] = bound_device(alpha_);
+    if (optim_beta) beta[tid] = bound_device(beta_);
+    if (optim_gamma) gamma[tid] = bound_device(gamma_);
+    if (optim_result) optim_result[tid] = optim;
+
+    if (error || level || trend || season || xhat) {
+      // Final fit
+      Dtype error_ = holtwinters_eval_device<Dtype>(
+        tid, ts, n, batch_size, frequency, shift, plevel, ptrend, pseason_lane,
+        HW_OPTIM_LANES, start_season, beta, gamma, alpha_, beta_, gamma_,
+        level, trend, season, xhat, ADDITIVE_KERNEL);
+      if (error) error[tid] = error_;
+    }
+  }
+}
+
 // Test Global and Shared kernels
 // https://github.com/rapidsai/cuml/issues/890
 template <typename Dtype>
@@ -434,7 +681,19 @@ void holtwinters_optim_gpu(
   bool single_param =
     (optim_alpha + optim_beta + optim_gamma > 1) ? false : true;
 
-  if (sm_needed > MLCommon::getSharedMemPerBlock()) {  // Global memory //
+  if (sm_needed > MLCommon::getSharedMemPerBlock() && !single_param) {
+    // Global memory, several threads per series
+    MLCommon::device_buffer<Dtype> pseason(
+      dev_allocator, stream, batch_size * frequency * HW_OPTIM_LANES);
+    int warp_blocks =
+      (batch_size * HW_OPTIM_LANES - 1) / threads_per_block + 1;
+    holtwinters_optim_gpu_warp_kernel<Dtype>
+      <<<warp_blocks, threads_per_block, 0, stream>>>(
+        ts, n, batch_size, frequency, start_level, start_trend, start_season,
+        pseason.data(), alpha, optim_alpha, beta, optim_beta, gamma,
+        optim_gamma, level, trend, season, xhat, error, optim_result,
+        optim_params, is_additive);
+  } else if (sm_needed > MLCommon::getSharedMemPerBlock()) {  // Global memory
     MLCommon::device_buffer<Dtype> pseason(dev_allocator, stream,
                                            batch_size * frequency);
     holtwinters_optim_gpu_global_kernel<Dtype>
@@ -193,6 +193,46 @@ void HoltWintersForecast(const ML::cumlHandle &handle, Dtype *forecast, int h,
                            level_coef, trend_coef, season_coef, seasonal);
 }
 
+template <typename Dtype>
+void HoltWintersForecastInterval(const ML::cumlHandle &handle,
+                                 const Dtype *forecast, Dtype *lower,
+                                 Dtype *upper, int h, int batch_size,
+                                 int frequency, int n_errors,
+                                 const Dtype *alpha, const Dtype *beta,
+                                 const Dtype *gamma, const Dtype *error,
+                                 Dtype confidence) {
+  const ML::cumlHandle_impl &handle_impl = handle.getImpl();
+  ML::detail::streamSyncer _(handle_impl);
+
+  ASSERT(forecast && lower && upper && alpha && error,
+         "HW error in in line %d", __LINE__);
+  ASSERT(confidence > 0 && confidence < 1, "HW error in in line %d",
+         __LINE__);
+  ASSERT(!(gamma && frequency < 2), "HW error in in line %d", __LINE__);
+  holtwinters_forecast_interval_gpu(handle_impl, forecast, lower, upper, h,
+                                    batch_size, frequency, n_errors, alpha,
+                                    beta, gamma, error, confidence);
+}
+
+template <typename Dtype>
+void HoltWintersUpdate(const ML::cumlHandle &handle, const Dtype *data,
+                       int n_new, int batch_size, int frequency,
+                       const Dtype *alpha, const Dtype *beta,
+                       const Dtype *gamma, Dtype *level_coef,
+                       Dtype *trend_coef, Dtype *season_coef,
+                       ML::SeasonalType seasonal) {
+  const ML::cumlHandle_impl &handle_impl = handle.getImpl();
+  ML::detail::streamSyncer _(handle_impl);
+
+  ASSERT(data && alpha && level_coef, "HW error in in line %d", __LINE__);
+  ASSERT(!((!trend_coef) != (!beta) || (!season_coef) != (!gamma)),
+         "HW error in in line %d", __LINE__);
+  ASSERT(!(season_coef && frequency < 2), "HW error in in line %d", __LINE__);
+  holtwinters_update_gpu(handle_impl, data, n_new, batch_size, frequency,
+                         alpha, beta, gamma, level_coef, trend_coef,
+                         season_coef, seasonal);
+}
+
 // change optim_gamma to false here to test bug in Double Exponential Smoothing
 // https://github.com/rapidsai/cuml/issues/889
 template <typename Dtype>
@@ -200,7 +240,9 @@ void HoltWintersFitHelper(const ML::cumlHandle &handle, int n, int batch_size,
                           int frequency, int start_periods,
                           ML::SeasonalType seasonal, Dtype epsilon, Dtype *data,
                           Dtype *level_d, Dtype *trend_d, Dtype *season_d,
-                          Dtype *error_d) {
+                          Dtype *error_d, Dtype *alpha_out = nullptr,
+                          Dtype *beta_out = nullptr,
+                          Dtype *gamma_out = nullptr) {
   const ML::cumlHandle_impl &handle_impl = handle.getImpl();
   ML::detail::streamSyncer _(handle_impl);
   cudaStream_t stream = handle_impl.getStream();
@@ -268,6 +310,10 @@ void HoltWintersFitHelper(const ML::cumlHandle &handle, int n, int batch_size,
                    (Dtype *)nullptr, error_d, (OptimCriterion *)nullptr,
                    (OptimParams<Dtype> *)nullptr, seasonal);
 
+  if (alpha_out) MLCommon::copy(alpha_out, alpha_d.data(), batch_size, stream);
+  if (beta_out) MLCommon::copy(beta_out, beta_d, batch_size, stream);
+  if (gamma_out) MLCommon::copy(gamma_out, gamma_d, batch_size, stream);
+
   // Free the allocated memory on GPU
   dev_allocator->deallocate(trend_seed_d, sizeof(Dtype) * leveltrend_seed_len,
                             stream);
@@ -311,4 +357,41 @@ void HoltWintersForecastHelper(const ML::cumlHandle &handle, int n,
                       season_d + season_coef_offset, seasonal);
 }
 
+template <typename Dtype>
+void HoltWintersForecastIntervalHelper(
+  const ML::cumlHandle &handle, int n, int batch_size, int frequency, int h,
+  ML::SeasonalType seasonal, Dtype *level_d, Dtype *trend_d, Dtype *season_d,
+  const Dtype *alpha_d, const Dtype *beta_d, const Dtype *gamma_d,
+  const Dtype *error_d, Dtype confidence, Dtype *forecast_d, Dtype *lower_d,
+  Dtype *upper_d) {
+  int components_len;
+  HoltWintersBufferSize(n, batch_size, frequency, true, true, nullptr,
+                        nullptr, &components_len, nullptr, nullptr, nullptr);
+
+  HoltWintersForecastHelper(handle, n, batch_size, frequency, h, seasonal,
+                            level_d, trend_d, season_d, forecast_d);
+  HoltWintersForecastInterval(handle, forecast_d, lower_d, upper_d, h,
+                              batch_size, frequency,
+                              components_len / batch_size, alpha_d, beta_d,
+                              gamma_d, error_d, confidence);
+}
+
+template <typename Dtype>
+void HoltWintersUpdateHelper(const ML::cumlHandle &handle, int n,
+                             int batch_size, int frequency, int n_new,
+                             ML::SeasonalType seasonal, const Dtype *data,
+                             const Dtype *alpha_d, const Dtype *beta_d,
+                             const Dtype *gamma_d, Dtype *level_d,
+                             Dtype *trend_d, Dtype *season_d) {
+  int leveltrend_coef_offset, season_coef_offset;
+  HoltWintersBufferSize(n, batch_size, frequency, true, true, nullptr,
+                        nullptr, nullptr, nullptr, &leveltrend_coef_offset,
+                        &season_coef_offset);
+
+  HoltWintersUpdate(handle, data, n_new, batch_size, frequency, alpha_d,
+                    beta_d, gamma_d, level_d + leveltrend_coef_offset,
+                    trend_d + leveltrend_coef_offset,
+                    season_d + season_coef_offset, seasonal);
+}
+
 }  // namespace ML
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <thrust/execution_policy.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include "cuda_utils.h"
+#include "matrix/batched_matrix.hpp"
+
+namespace kf {
+namespace linear {
+
+using MLCommon::Matrix::BatchedMatrix;
+
+/**
+ * @brief Makes each matrix of a batch of square matrices symmetric, in place,
+ *        by averaging it with its transpose
+ * @param P the batch of matrices
+ */
+template <typename T>
+void batched_symmetrize(BatchedMatrix<T> &P) {
+  int n = P.shape().first;
+  T *P_ = P.raw_data();
+  auto counting = thrust::make_counting_iterator(0);
+  thrust::for_each(thrust::cuda::par.on(P.stream()), counting,
+                   counting + n * n * P.batches(), [=] __device__(int idx) {
+                     int b = idx / (n * n), i = idx % n, j = (idx / n) % n;
+                     if (i >= j) return;
+                     T *Pb = P_ + b * n * n;
+                     T avg = (T)0.5 * (Pb[i + j * n] + Pb[j + i * n]);
+                     Pb[i + j * n] = avg;
+                     Pb[j + i * n] = avg;
+                   });
+}
+
+/**
+ * @brief Predict the states of a batch of independent linear Kalman filters
+ *        for the next step, before the measurements are taken. All the filters
+ *        are advanced by the same sequence of batched cuBLAS calls
+ * @tparam T the data type for computation
+ * @param Phi state transition matrices, dim_x x dim_x per filter
+ * @param Q process noise covariance matrices, dim_x x dim_x per filter
+ * @param x the states, dim_x x 1 per filter, updated in place
+ * @param P the error covariances, dim_x x dim_x per filter, updated in place
+ */
+template <typename T>
+void batched_predict(const BatchedMatrix<T> &Phi, const BatchedMatrix<T> &Q,
+                     BatchedMatrix<T> &x, BatchedMatrix<T> &P) {
+  int dim_x = x.shape().first;
+  int batch_size = x.batches();
+  cudaStream_t stream = x.stream();
+
+  BatchedMatrix<T> x_est = Phi * x;
+  BatchedMatrix<T> PhiP = Phi * P;
+  // P = Phi * P * Phi' + Q
+  MLCommon::copy(P.raw_data(), Q.raw_data(), dim_x * dim_x * batch_size,
+                 stream);
+  b_gemm(false, true, dim_x, dim_x, dim_x, (T)1, PhiP, Phi, (T)1, P);
+  MLCommon::copy(x.raw_data(), x_est.raw_data(), dim_x * batch_size, stream);
+  batched_symmetrize(P);
+}
+
+/**
+ * @brief Update the states of a batch of independent linear Kalman filters
+ *        in-lieu of measurements, with the short (optimal) form of the
+ *        equations and an explicit Kalman gain. Since P and S = H P H' + R
+ *        are symmetric, the transposed gain K' = inv(S) H P is obtained by a
+ *        single batched solve
+ * @tparam T the data type for computation
+ * @param H state to measurement tranformation matrices, dim_z x dim_x per
+ *          filter
+ * @param R measurement noise covariance matrices, dim_z x dim_z per filter
+ * @param z the measurements, dim_z x 1 per filter
+ * @param x the states, dim_x x 1 per filter, updated in place
+ * @param P the error covariances, dim_x x dim_x per filter, updated in place
+ * @note batched_predict must have been called for the step
+ */
+template <typename T>
+void batched_update(const BatchedMatrix<T> &H, const BatchedMatrix<T> &R,
+                    const BatchedMatrix<T> &z, BatchedMatrix<T> &x,
+                    BatchedMatrix<T> &P) {
+  int dim_x = x.shape().first;
+  int dim_z = z.shape().first;
+
+  // innovation y = z - H * x
+  BatchedMatrix<T> y = z.deepcopy();
+  b_gemm(false, false, dim_z, 1, dim_x, (T)-1, H, x, (T)1, y);
+  // innovation covariance S = H * P * H' + R
+  BatchedMatrix<T> HP = H * P;
+  BatchedMatrix<T> S = R.deepcopy();
+  b_gemm(false, true, dim_z, dim_z, dim_x, (T)1, HP, H, (T)1, S);
+  BatchedMatrix<T> KT = b_solve(S, HP);
+  // x = x + K * y, P = P - K * H * P
+  b_gemm(true, false, dim_x, 1, dim_z, (T)1, KT, y, (T)1, x);
+  b_gemm(true, false, dim_x, dim_x, dim_z, (T)-1, KT, HP, (T)1, P);
+  batched_symmetrize(P);
+}
+
+};  // end namespace linear
+};  // end namespace kf
@@ -16,22 +16,36 @@
 
 #pragma once
 
+#include <cuda_fp16.h>
 #include <distance/distance.h>
 #include <linalg/binary_op.h>
+#include <linalg/cublas_wrappers.h>
+#include <linalg/cusparse_wrappers.h>
 #include <linalg/matrix_vector_op.h>
 #include <linalg/mean_squared_error.h>
+#include <linalg/norm.h>
 #include <linalg/reduce_rows_by_key.h>
 #include <matrix/gather.h>
 #include <random/permute.h>
 #include <random/rng.h>
+#include <cfloat>
 #include <random>
+#include <set>
+#include <type_traits>
 
 #include <ml_cuda_utils.h>
 
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
 #include <thrust/execution_policy.h>
 #include <thrust/fill.h>
 #include <thrust/for_each.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/reduce.h>
 #include <thrust/scan.h>
+#include <thrust/transform.h>
+#include <thrust/transform_reduce.h>
 #include <numeric>
 
 #include <common/allocatorAdapter.hpp>
@@ -100,6 +114,42 @@ CountT getDataBatchSize(const KMeansParams &params, CountT n_samples) {
   return std::min(params.batch_size, n_samples);
 }
 
+// Adds a batch of samples, whose sums and counts in each cluster are
+// 'batchSums' and 'batchCounts', to centroids that are the means of
+// 'clusterCounts' samples: the centroids move to the means of all their
+// samples and the counts are updated; centroids without samples in the
+// batch are left unchanged
+template <typename DataT, typename IndexT>
+void updateCentroidsIncrementally(const cumlHandle_impl &handle,
+                                  Tensor<DataT, 2, IndexT> &batchSums,
+                                  Tensor<int, 1, IndexT> &batchCounts,
+                                  Tensor<DataT, 2, IndexT> &centroids,
+                                  Tensor<DataT, 1, IndexT> &clusterCounts,
+                                  cudaStream_t stream) {
+  auto n_clusters = centroids.getSize(0);
+  auto n_features = centroids.getSize(1);
+  DataT *c = centroids.data();
+  const DataT *sums = batchSums.data();
+  const int *bc = batchCounts.data();
+  DataT *counts = clusterCounts.data();
+
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  thrust::for_each(
+    execution_policy, thrust::make_counting_iterator<IndexT>(0),
+    thrust::make_counting_iterator<IndexT>(n_clusters * n_features),
+    [=] __device__(IndexT i) {
+      IndexT k = i / n_features;
+      int nb = bc[k];
+      if (nb == 0) return;
+      c[i] += (sums[i] - nb * c[i]) / (counts[k] + nb);
+    });
+  thrust::transform(
+    execution_policy, clusterCounts.begin(), clusterCounts.end(),
+    batchCounts.begin(), clusterCounts.begin(),
+    [] __device__(DataT count, int nb) { return count + nb; });
+}
+
 // Computes the intensity histogram from a sequence of labels
 template <typename SampleIteratorT, typename CounterT>
 void countLabels(const cumlHandle_impl &handle, SampleIteratorT labels,
@@ -217,6 +267,199 @@ void pairwiseDistance(const cumlHandle_impl &handle,
     n_features, workspace, metric, stream);
 }
 
+// argmin reduction of each row of 'pairwiseDistance[n x k]' returning the
+// <index, value> pair of the closest centroid and the distance to it
+template <typename DataT, typename IndexT>
+void selectMinClusterAndDistance(
+  Tensor<DataT, 2, IndexT> &pairwiseDistance,
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> &minClusterAndDistance,
+  cudaStream_t stream) {
+  cub::KeyValuePair<IndexT, DataT> initial_value(
+    0, std::numeric_limits<DataT>::max());
+  MLCommon::LinAlg::coalescedReduction(
+    minClusterAndDistance.data(), pairwiseDistance.data(),
+    pairwiseDistance.getSize(1), pairwiseDistance.getSize(0), initial_value,
+    stream, false,
+    [=] __device__(const DataT val, const IndexT i) {
+      cub::KeyValuePair<IndexT, DataT> pair;
+      pair.key = i;
+      pair.value = val;
+      return pair;
+    },
+    [=] __device__(cub::KeyValuePair<IndexT, DataT> a,
+                   cub::KeyValuePair<IndexT, DataT> b) {
+      return (b.value < a.value) ? b : a;
+    },
+    [=] __device__(cub::KeyValuePair<IndexT, DataT> pair) { return pair; });
+}
+
+// Are the distances to the centroids computed in mixed precision?
+template <typename DataT>
+bool useMixedPrecision(const KMeansParams &params,
+                       MLCommon::Distance::DistanceType metric) {
+  bool euclidean = metric == MLCommon::Distance::EucExpandedL2 ||
+                   metric == MLCommon::Distance::EucExpandedL2Sqrt ||
+                   metric == MLCommon::Distance::EucUnexpandedL2 ||
+                   metric == MLCommon::Distance::EucUnexpandedL2Sqrt;
+  return std::is_same<DataT, float>::value &&
+         params.precision == KMeansParams::Mixed && euclidean;
+}
+
+// Mixed precision assignment of a batch of samples, a warp per sample: picks
+// the two nearest centroids from the half precision products 'dots[n x k]',
+// recomputes the distance to the nearest in single precision and, when the
+// two are within the refinement margin, assigns the sample again in single
+// precision
+template <typename IndexT, int TPB>
+__global__ void mixedPrecisionAssignKernel(
+  const float *X, const float *centroids, const float *dots,
+  const float *sampleNorms, const float *centroidNorms, IndexT n_samples,
+  IndexT n_features, IndexT n_clusters, float refine_margin, bool sqrt,
+  cub::KeyValuePair<IndexT, float> *minClusterAndDistance) {
+  IndexT row = ((IndexT)blockIdx.x * TPB + threadIdx.x) / MLCommon::WarpSize;
+  int lane = threadIdx.x % MLCommon::WarpSize;
+  if (row >= n_samples) return;
+
+  const float *x = X + row * n_features;
+  const float *dot = dots + row * n_clusters;
+  float xn = sampleNorms[row];
+
+  // the two smallest approximate squared distances; ties go to the lowest
+  // index so that all the lanes agree on the nearest centroid
+  float d1 = FLT_MAX, d2 = FLT_MAX;
+  IndexT i1 = 0;
+  for (IndexT j = lane; j < n_clusters; j += MLCommon::WarpSize) {
+    float d = xn + centroidNorms[j] - 2.f * dot[j];
+    if (d < d1) {
+      d2 = d1;
+      d1 = d;
+      i1 = j;
+    } else if (d < d2) {
+      d2 = d;
+    }
+  }
+  for (int mask = MLCommon::WarpSize / 2; mask > 0; mask /= 2) {
+    float o1 = MLCommon::shfl_xor(d1, mask);
+    float o2 = MLCommon::shfl_xor(d2, mask);
+    IndexT oi1 = MLCommon::shfl_xor(i1, mask);
+    if (o1 < d1 || (o1 == d1 && oi1 < i1)) {
+      d2 = fminf(d1, o2);
+      d1 = o1;
+      i1 = oi1;
+    } else {
+      d2 = fminf(d2, o1);
+    }
+  }
+
+  // squared distance to centroid 'c' in single precision, in all the lanes
+  auto sqDistance = [=](IndexT c) {
+    const float *centroid = centroids + c * n_features;
+    float acc = 0.f;
+    for (IndexT f = lane; f < n_features; f += MLCommon::WarpSize) {
+      float diff = x[f] - centroid[f];
+      acc += diff * diff;
+    }
+    for (int mask = MLCommon::WarpSize / 2; mask > 0; mask /= 2)
+      acc += MLCommon::shfl_xor(acc, mask);
+    return acc;
+  };
+
+  if (d2 - d1 < refine_margin * (xn + centroidNorms[i1])) {
+    d1 = FLT_MAX;
+    for (IndexT c = 0; c < n_clusters; c++) {
+      float d = sqDistance(c);
+      if (d < d1) {
+        d1 = d;
+        i1 = c;
+      }
+    }
+  } else {
+    d1 = sqDistance(i1);
+  }
+
+  if (lane == 0) {
+    cub::KeyValuePair<IndexT, float> pair;
+    pair.key = i1;
+    pair.value = sqrt ? sqrtf(d1) : d1;
+    minClusterAndDistance[row] = pair;
+  }
+}
+
+// minClusterAndDistance with the samples-by-centroids product in half
+// precision accumulated in single precision; requires useMixedPrecision()
+template <typename IndexT>
+void mixedPrecisionMinClusterAndDistance(
+  const cumlHandle_impl &handle, const KMeansParams &params,
+  Tensor<float, 2, IndexT> &X, Tensor<float, 2, IndexT> &centroids,
+  Tensor<float, 2, IndexT> &pairwiseDistance,
+  Tensor<cub::KeyValuePair<IndexT, float>, 1, IndexT> &minClusterAndDistance,
+  MLCommon::Distance::DistanceType metric, cudaStream_t stream) {
+  constexpr int TPB = 256;
+  auto n_samples = X.getSize(0);
+  auto n_features = X.getSize(1);
+  auto n_clusters = centroids.getSize(0);
+  auto dataBatchSize = kmeans::detail::getDataBatchSize(params, n_samples);
+  bool sqrt = metric == MLCommon::Distance::EucExpandedL2Sqrt ||
+              metric == MLCommon::Distance::EucUnexpandedL2Sqrt;
+
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  auto toHalf = [] __device__(float x) { return __float2half(x); };
+
+  MLCommon::device_buffer<__half> centroidsHalf(
+    handle.getDeviceAllocator(), stream, centroids.numElements());
+  thrust::transform(execution_policy, centroids.begin(), centroids.end(),
+                    centroidsHalf.data(), toHalf);
+  MLCommon::device_buffer<float> centroidNorms(handle.getDeviceAllocator(),
+                                               stream, n_clusters);
+  MLCommon::LinAlg::rowNorm(centroidNorms.data(), centroids.data(),
+                            n_features, n_clusters, MLCommon::LinAlg::L2Norm,
+                            true, stream);
+
+  MLCommon::device_buffer<__half> batchHalf(
+    handle.getDeviceAllocator(), stream, dataBatchSize * n_features);
+  MLCommon::device_buffer<float> sampleNorms(handle.getDeviceAllocator(),
+                                             stream, dataBatchSize);
+  float alpha = 1.f, beta = 0.f;
+
+  // tile over the input dataset
+  for (IndexT dIdx = 0; dIdx < n_samples; dIdx += dataBatchSize) {
+    IndexT ns = std::min(dataBatchSize, n_samples - dIdx);
+    auto datasetView = X.template view<2>({ns, n_features}, {dIdx, 0});
+
+    thrust::transform(execution_policy, datasetView.begin(),
+                      datasetView.end(), batchHalf.data(), toHalf);
+    MLCommon::LinAlg::rowNorm(sampleNorms.data(), datasetView.data(),
+                              n_features, ns, MLCommon::LinAlg::L2Norm, true,
+                              stream);
+
+    // row-major dots[ns x n_clusters] is the column-major product
+    // centroids * batch^T
+    CUBLAS_CHECK(MLCommon::LinAlg::cublasgemm(
+      handle.getCublasHandle(), CUBLAS_OP_T, CUBLAS_OP_N, n_clusters, ns,
+      n_features, &alpha, centroidsHalf.data(), n_features, batchHalf.data(),
+      n_features, &beta, pairwiseDistance.data(), n_clusters, stream));
+
+    IndexT n_blocks = MLCommon::ceildiv<IndexT>(ns, TPB / MLCommon::WarpSize);
+    mixedPrecisionAssignKernel<IndexT, TPB><<<n_blocks, TPB, 0, stream>>>(
+      datasetView.data(), centroids.data(), pairwiseDistance.data(),
+      sampleNorms.data(), centroidNorms.data(), ns, n_features, n_clusters,
+      (float)params.refine_margin, sqrt, minClusterAndDistance.data() + dIdx);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+}
+
+// useMixedPrecision() never holds for other than single precision data
+template <typename DataT, typename IndexT>
+void mixedPrecisionMinClusterAndDistance(
+  const cumlHandle_impl &handle, const KMeansParams &params,
+  Tensor<DataT, 2, IndexT> &X, Tensor<DataT, 2, IndexT> &centroids,
+  Tensor<DataT, 2, IndexT> &pairwiseDistance,
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> &minClusterAndDistance,
+  MLCommon::Distance::DistanceType metric, cudaStream_t stream) {
+  ASSERT(false, "mixed precision distances require single precision data");
+}
+
 // Calculates a <key, value> pair for every sample in input 'X' where key is an
 // index to an sample in 'centroids' (index of the nearest centroid) and 'value'
 // is the distance between the sample and the 'centroid[key]'
@@ -228,6 +471,13 @@ void minClusterAndDistance(
   Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> &minClusterAndDistance,
   MLCommon::device_buffer<char> &workspace,
   MLCommon::Distance::DistanceType metric, cudaStream_t stream) {
+  if (kmeans::detail::useMixedPrecision<DataT>(params, metric)) {
+    kmeans::detail::mixedPrecisionMinClusterAndDistance(
+      handle, params, X, centroids, pairwiseDistance, minClusterAndDistance,
+      metric, stream);
+    return;
+  }
+
   auto n_samples = X.getSize(0);
   auto n_features = X.getSize(1);
   auto n_clusters = centroids.getSize(0);
@@ -255,25 +505,8 @@ void minClusterAndDistance(
     kmeans::detail::pairwiseDistance(handle, datasetView, centroids,
                                      distanceView, workspace, metric, stream);
 
-    // argmin reduction returning <index, value> pair
-    // calculates the closest centroid and the distance to the closent centroid
-    cub::KeyValuePair<IndexT, DataT> initial_value(
-      0, std::numeric_limits<DataT>::max());
-    MLCommon::LinAlg::coalescedReduction(
-      minClusterAndDistanceView.data(), distanceView.data(),
-      distanceView.getSize(1), distanceView.getSize(0), initial_value, stream,
-      false,
-      [=] __device__(const DataT val, const IndexT i) {
-        cub::KeyValuePair<IndexT, DataT> pair;
-        pair.key = i;
-        pair.value = val;
-        return pair;
-      },
-      [=] __device__(cub::KeyValuePair<IndexT, DataT> a,
-                     cub::KeyValuePair<IndexT, DataT> b) {
-        return (b.value < a.value) ? b : a;
-      },
-      [=] __device__(cub::KeyValuePair<IndexT, DataT> pair) { return pair; });
+    kmeans::detail::selectMinClusterAndDistance(
+      distanceView, minClusterAndDistanceView, stream);
   }
 }
 
@@ -366,6 +599,24 @@ void shuffleAndGather(const cumlHandle_impl &handle,
                            stream);
 }
 
+// randomly select 'out.getSize(0)' samples from input 'in', with replacement,
+// and stores them in 'out'; 'indices' holds the selected indices
+template <typename DataT, typename IndexT>
+void sampleWithReplacement(const cumlHandle_impl &handle,
+                           const Tensor<DataT, 2, IndexT> &in,
+                           Tensor<DataT, 2, IndexT> &out,
+                           Tensor<IndexT, 1, IndexT> &indices,
+                           MLCommon::Random::Rng &rng, cudaStream_t stream) {
+  auto n_samples_to_gather = out.getSize(0);
+
+  rng.uniformInt(indices.data(), n_samples_to_gather, (IndexT)0,
+                 in.getSize(0), stream);
+
+  MLCommon::Matrix::gather(in.data(), in.getSize(1), in.getSize(0),
+                           indices.data(), n_samples_to_gather, out.data(),
+                           stream);
+}
+
 template <typename DataT, typename IndexT>
 void countSamplesInCluster(const cumlHandle_impl &handle,
                            const KMeansParams &params,
@@ -436,37 +687,53 @@ void kmeansPlusPlus(const cumlHandle_impl &handle, const KMeansParams &params,
     execution_policy, weights.begin(), weights.end(), prob.begin(),
     [] __device__(int weight) { return static_cast<DataT>(weight); });
 
-  MLCommon::host_buffer<DataT> h_prob(handle.getHostAllocator(), stream);
-  h_prob.resize(n_pot_centroids, stream);
+  // the prefix sums of the probabilities, so that sampling a centroid is a
+  // binary search on device
+  Tensor<DataT, 1, IndexT> cumProb({n_pot_centroids},
+                                   handle.getDeviceAllocator(), stream);
 
   std::mt19937 gen(params.seed);
 
   // reset buffer to store the chosen centroid
   centroidsRawData.resize(n_clusters * n_features, stream);
 
+  // distance of the samples to the nearest chosen centroid and to the last
+  // chosen centroid; only the latter is computed in each iteration
   Tensor<DataT, 1, IndexT> minClusterDistance(
     {n_pot_centroids}, handle.getDeviceAllocator(), stream);
+  Tensor<DataT, 1, IndexT> newClusterDistance(
+    {n_pot_centroids}, handle.getDeviceAllocator(), stream);
+  thrust::fill(execution_policy, minClusterDistance.begin(),
+               minClusterDistance.end(), std::numeric_limits<DataT>::max());
 
   int dataBatchSize = kmeans::detail::getDataBatchSize(params, n_pot_centroids);
 
-  MLCommon::device_buffer<DataT> pairwiseDistanceRaw(
-    handle.getDeviceAllocator(), stream);
-  pairwiseDistanceRaw.resize(dataBatchSize * n_clusters, stream);
+  Tensor<DataT, 2, IndexT> pairwiseDistance(
+    {dataBatchSize, 1}, handle.getDeviceAllocator(), stream);
 
   MLCommon::device_buffer<DataT> clusterCost(handle.getDeviceAllocator(),
                                              stream, 1);
 
-  int n_pts_sampled = 0;
   for (int iter = 0; iter < n_clusters; iter++) {
     LOG(params.verbose, "KMeans++ - Iteraton %d/%d\n", iter, n_clusters);
 
-    MLCommon::copy(h_prob.data(), prob.data(), prob.numElements(), stream);
+    thrust::inclusive_scan(execution_policy, prob.begin(), prob.end(),
+                           cumProb.begin());
+    DataT totalProb = 0;
+    MLCommon::copy(&totalProb, cumProb.end() - 1, 1, stream);
     CUDA_CHECK(cudaStreamSynchronize(stream));
 
-    std::discrete_distribution<> d(h_prob.begin(), h_prob.end());
-    // d(gen) returns random # between [0...n_pot_centroids], mod is  unncessary
-    // but just placing it to avoid untested behaviors
-    int cIdx = d(gen) % n_pot_centroids;
+    // samples cIdx with probability prob[cIdx] / totalProb; when all the
+    // probabilities are 0, all the potential centroids are chosen already
+    int cIdx = iter % n_pot_centroids;
+    if (totalProb > 0) {
+      std::uniform_real_distribution<DataT> d(0, totalProb);
+      DataT r = d(gen);
+      cIdx = thrust::upper_bound(execution_policy, cumProb.begin(),
+                                 cumProb.end(), r) -
+             cumProb.begin();
+      cIdx = std::min<int>(cIdx, n_pot_centroids - 1);
+    }
 
     LOG(params.verbose,
         "Chosing centroid-%d randomly from %d potential centroids\n", cIdx,
@@ -474,21 +741,21 @@ void kmeansPlusPlus(const cumlHandle_impl &handle, const KMeansParams &params,
 
     auto curCentroid = C.template view<2>({1, n_features}, {cIdx, 0});
 
-    MLCommon::copy(centroidsRawData.data() + n_pts_sampled * n_features,
+    MLCommon::copy(centroidsRawData.data() + iter * n_features,
                    curCentroid.data(), curCentroid.numElements(), stream);
-    n_pts_sampled++;
-
-    auto centroids = std::move(Tensor<DataT, 2, IndexT>(
-      centroidsRawData.data(), {n_pts_sampled, n_features}));
 
-    Tensor<DataT, 2, IndexT> pairwiseDistance(
-      (DataT *)pairwiseDistanceRaw.data(),
-      {dataBatchSize, centroids.getSize(0)});
+    auto newCentroid = std::move(Tensor<DataT, 2, IndexT>(
+      centroidsRawData.data() + iter * n_features, {1, n_features}));
 
-    kmeans::detail::minClusterDistance(handle, params, C, centroids,
-                                       pairwiseDistance, minClusterDistance,
+    kmeans::detail::minClusterDistance(handle, params, C, newCentroid,
+                                       pairwiseDistance, newClusterDistance,
                                        workspace, metric, stream);
 
+    thrust::transform(execution_policy, minClusterDistance.begin(),
+                      minClusterDistance.end(), newClusterDistance.begin(),
+                      minClusterDistance.begin(),
+                      thrust::minimum<DataT>());
+
     kmeans::detail::computeClusterCost(
       handle, minClusterDistance, workspace, clusterCost.data(),
       [] __device__(const DataT &a, const DataT &b) { return a + b; }, stream);
@@ -496,11 +763,10 @@ void kmeansPlusPlus(const cumlHandle_impl &handle, const KMeansParams &params,
     DataT clusteringCost = 0;
     MLCommon::copy(&clusteringCost, clusterCost.data(), clusterCost.size(),
                    stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
 
     cub::ArgIndexInputIterator<int *> itr_w(weights.data());
 
-    ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
-    auto execution_policy = thrust::cuda::par(alloc).on(stream);
     thrust::transform(
       execution_policy, minClusterDistance.begin(), minClusterDistance.end(),
       itr_w, prob.begin(),
@@ -517,6 +783,834 @@ void kmeansPlusPlus(const cumlHandle_impl &handle, const KMeansParams &params,
   }
 }
 
+// Calculates newCentroids[i] = newCentroids[i] / sampleCountInCluster[i] from
+// the sums of the samples of each cluster in newCentroids; newCentroids[i] is
+// centroids[i] when cluster-i has no samples. sampleCountInCluster holds
+// either the # or the total weight of the samples of each cluster
+template <typename DataT, typename IndexT, typename CountT>
+void computeCentroidMeans(const cumlHandle_impl &handle,
+                          Tensor<DataT, 2, IndexT> &centroids,
+                          Tensor<DataT, 2, IndexT> &newCentroids,
+                          Tensor<CountT, 1, IndexT> &sampleCountInCluster,
+                          MLCommon::device_buffer<char> &workspace,
+                          cudaStream_t stream) {
+  auto n_clusters = centroids.getSize(0);
+
+  // Computes newCentroids[i] = newCentroids[i]/sampleCountInCluster[i] where
+  //   newCentroids[n_samples x n_features] - 2D array, newCentroids[i] has
+  //   sum of all the samples assigned to cluster-i
+  //   sampleCountInCluster[n_clusters] - 1D array, sampleCountInCluster[i]
+  //   contains # of samples in cluster-i.
+  // Note - when sampleCountInCluster[i] is 0, newCentroid[i] is reset to 0
+
+  // transforms int values in sampleCountInCluster to its inverse and more
+  // importantly to DataT because matrixVectorOp supports only when matrix and
+  // vector are of same type
+  workspace.resize(sampleCountInCluster.numElements() * sizeof(DataT), stream);
+  auto sampleCountInClusterInverse = std::move(
+    Tensor<DataT, 1, IndexT>((DataT *)workspace.data(), {n_clusters}));
+
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  thrust::transform(
+    execution_policy, sampleCountInCluster.begin(), sampleCountInCluster.end(),
+    sampleCountInClusterInverse.begin(), [=] __device__(CountT count) {
+      if (count == 0)
+        return static_cast<DataT>(0);
+      else
+        return static_cast<DataT>(1.0) / static_cast<DataT>(count);
+    });
+
+  MLCommon::LinAlg::matrixVectorOp(
+    newCentroids.data(), newCentroids.data(),
+    sampleCountInClusterInverse.data(), newCentroids.getSize(1),
+    newCentroids.getSize(0), true, false,
+    [=] __device__(DataT mat, DataT vec) { return mat * vec; }, stream);
+
+  // copy the centroids[i] to newCentroids[i] when sampleCountInCluster[i] is
+  // 0
+  cub::ArgIndexInputIterator<CountT *> itr_sc(sampleCountInCluster.data());
+  MLCommon::Matrix::gather_if(
+    centroids.data(), centroids.getSize(1), centroids.getSize(0), itr_sc,
+    itr_sc, sampleCountInCluster.numElements(), newCentroids.data(),
+    [=] __device__(cub::KeyValuePair<ptrdiff_t, CountT> map) {  // predicate
+      // copy when the # of samples in the cluster is 0
+      if (map.value == 0)
+        return true;
+      else
+        return false;
+    },
+    [=] __device__(cub::KeyValuePair<ptrdiff_t, CountT> map) {  // map
+      return map.key;
+    },
+    stream);
+}
+
+// Calculates newCentroids[i] as the sum of the samples of X whose label in
+// 'itr' is i, and stores the # of samples of cluster-i in
+// sampleCountInCluster[i]
+template <typename DataT, typename IndexT, typename LabelsIteratorT>
+void computeCentroidSums(const cumlHandle_impl &handle,
+                         Tensor<DataT, 2, IndexT> &X, LabelsIteratorT itr,
+                         Tensor<DataT, 2, IndexT> &newCentroids,
+                         Tensor<int, 1, IndexT> &sampleCountInCluster,
+                         MLCommon::device_buffer<char> &workspace,
+                         cudaStream_t stream) {
+  auto n_samples = X.getSize(0);
+  auto n_clusters = newCentroids.getSize(0);
+
+  workspace.resize(n_samples, stream);
+
+  // Calculates sum of all the samples assigned to cluster-i and store the
+  // result in newCentroids[i]
+  MLCommon::LinAlg::reduce_rows_by_key(
+    X.data(), X.getSize(1), itr, workspace.data(), X.getSize(0), X.getSize(1),
+    n_clusters, newCentroids.data(), stream);
+
+  // count # of samples in each cluster
+  kmeans::detail::countLabels(handle, itr, sampleCountInCluster.data(),
+                              n_samples, n_clusters, workspace, stream);
+}
+
+// Calculates newCentroids[i] as the mean of the samples of X whose label in
+// 'itr' is i, and stores the # of samples of cluster-i in
+// sampleCountInCluster[i]; newCentroids[i] is centroids[i] when cluster-i has
+// no samples
+template <typename DataT, typename IndexT, typename LabelsIteratorT>
+void updateCentroids(const cumlHandle_impl &handle,
+                     Tensor<DataT, 2, IndexT> &X,
+                     Tensor<DataT, 2, IndexT> &centroids, LabelsIteratorT itr,
+                     Tensor<DataT, 2, IndexT> &newCentroids,
+                     Tensor<int, 1, IndexT> &sampleCountInCluster,
+                     MLCommon::device_buffer<char> &workspace,
+                     cudaStream_t stream) {
+  kmeans::detail::computeCentroidSums(handle, X, itr, newCentroids,
+                                      sampleCountInCluster, workspace, stream);
+
+  kmeans::detail::computeCentroidMeans(
+    handle, centroids, newCentroids, sampleCountInCluster, workspace, stream);
+}
+
+// Calculates newCentroids[i] as the sum of the samples of X whose label in
+// 'itr' is i, each multiplied by its weight in sampleWeight, and stores the
+// total weight of the samples of cluster-i in weightInCluster[i]
+template <typename DataT, typename IndexT, typename LabelsIteratorT>
+void computeWeightedCentroidSums(const cumlHandle_impl &handle,
+                                 Tensor<DataT, 2, IndexT> &X,
+                                 const DataT *sampleWeight, LabelsIteratorT itr,
+                                 Tensor<DataT, 2, IndexT> &newCentroids,
+                                 Tensor<DataT, 1, IndexT> &weightInCluster,
+                                 MLCommon::device_buffer<char> &workspace,
+                                 cudaStream_t stream) {
+  auto n_samples = X.getSize(0);
+  auto n_clusters = newCentroids.getSize(0);
+
+  workspace.resize(n_samples, stream);
+
+  MLCommon::LinAlg::reduce_rows_by_key(
+    X.data(), X.getSize(1), itr, sampleWeight, workspace.data(), X.getSize(0),
+    X.getSize(1), n_clusters, newCentroids.data(), stream);
+
+  // the weights are a 1-column matrix whose rows sum by cluster
+  MLCommon::LinAlg::reduce_rows_by_key(
+    const_cast<DataT *>(sampleWeight), 1, itr, workspace.data(), n_samples, 1,
+    n_clusters, weightInCluster.data(), stream);
+}
+
+// Multiplies the distance of each sample to its nearest centroid by the
+// weight of the sample, so that the cluster cost is the weighted inertia
+template <typename DataT, typename IndexT>
+void applySampleWeights(
+  const cumlHandle_impl &handle,
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> &minClusterAndDistance,
+  const DataT *sampleWeight, cudaStream_t stream) {
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  thrust::transform(
+    execution_policy, minClusterAndDistance.begin(),
+    minClusterAndDistance.end(), sampleWeight, minClusterAndDistance.begin(),
+    [=] __device__(cub::KeyValuePair<IndexT, DataT> pair, DataT w) {
+      pair.value *= w;
+      return pair;
+    });
+}
+
+// Calculates the cluster cost phi_x(C) of all the samples of X, one batch of
+// minClusterAndDistance.getSize(0) samples at a time, so that no buffer
+// scales with the # of samples
+template <typename DataT, typename IndexT>
+DataT computeClusterCostInBatches(
+  const cumlHandle_impl &handle, const KMeansParams &params,
+  Tensor<DataT, 2, IndexT> &X, Tensor<DataT, 2, IndexT> &centroids,
+  Tensor<DataT, 2, IndexT> &pairwiseDistance,
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> &minClusterAndDistance,
+  cub::KeyValuePair<IndexT, DataT> *clusterCostD,
+  MLCommon::device_buffer<char> &workspace,
+  MLCommon::Distance::DistanceType metric, cudaStream_t stream) {
+  auto n_samples = X.getSize(0);
+  auto n_features = X.getSize(1);
+  auto batchSize = minClusterAndDistance.getSize(0);
+
+  DataT cost = 0;
+  for (IndexT dIdx = 0; dIdx < n_samples; dIdx += batchSize) {
+    IndexT ns = std::min(batchSize, n_samples - dIdx);
+
+    auto datasetView = X.template view<2>({ns, n_features}, {dIdx, 0});
+    auto minClusterAndDistanceView =
+      minClusterAndDistance.template view<1>({ns}, {0});
+
+    kmeans::detail::minClusterAndDistance(
+      handle, params, datasetView, centroids, pairwiseDistance,
+      minClusterAndDistanceView, workspace, metric, stream);
+
+    kmeans::detail::computeClusterCost(
+      handle, minClusterAndDistanceView, workspace, clusterCostD,
+      [] __device__(const cub::KeyValuePair<IndexT, DataT> &a,
+                    const cub::KeyValuePair<IndexT, DataT> &b) {
+        cub::KeyValuePair<IndexT, DataT> res;
+        res.key = 0;
+        res.value = a.value + b.value;
+        return res;
+      },
+      stream);
+
+    DataT batchCost = 0;
+    MLCommon::copy(&batchCost, &clusterCostD->value, 1, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    cost += batchCost;
+  }
+  return cost;
+}
+
+// Hamerly's bounds of the samples after the centroids moved by 'shift' (at
+// most 'maxShift'): the distance of sample-i to its centroid is at most
+// upper[i] and its distance to any other centroid at least lower[i]. When
+// upper[i] exceeds both lower[i] and halfMinDistance[labels[i]] (half the
+// distance of the centroid to its nearest other centroid), upper[i] is
+// tightened to the distance of sample-i to its centroid, and if it still does,
+// sample-i is flagged in needsUpdate. A warp handles a sample.
+template <typename DataT, typename IndexT, int TPB>
+__global__ void hamerlyBoundsKernel(const DataT *X, IndexT n_samples,
+                                    IndexT n_features, const DataT *centroids,
+                                    const IndexT *labels, const DataT *shift,
+                                    DataT maxShift,
+                                    const DataT *halfMinDistance, DataT *upper,
+                                    DataT *lower, int *needsUpdate) {
+  IndexT i = ((IndexT)blockIdx.x * TPB + threadIdx.x) / MLCommon::WarpSize;
+  int lane = threadIdx.x % MLCommon::WarpSize;
+  if (i >= n_samples) return;
+
+  IndexT c = labels[i];
+  DataT u = upper[i] + shift[c];
+  DataT l = lower[i] - maxShift;
+  DataT m = MLCommon::myMax(halfMinDistance[c], l);
+  // all the lanes of the warp take the same branch
+  if (u > m) {
+    DataT acc = 0;
+    for (IndexT j = lane; j < n_features; j += MLCommon::WarpSize) {
+      DataT diff =
+        X[(size_t)i * n_features + j] - centroids[c * n_features + j];
+      acc += diff * diff;
+    }
+    for (int offset = MLCommon::WarpSize / 2; offset > 0; offset /= 2)
+      acc += MLCommon::shfl_xor(acc, offset);
+    u = MLCommon::mySqrt(acc);
+  }
+  if (lane == 0) {
+    upper[i] = u;
+    lower[i] = l;
+    needsUpdate[i] = u > m;
+  }
+}
+
+// Assigns the samples sampleIndices[0:n_rows) to their nearest centroid given
+// their squared distances to all the centroids, and sets their Hamerly's
+// bounds to the distances to the nearest and the second nearest centroids. A
+// warp handles a sample.
+template <typename DataT, typename IndexT, int TPB>
+__global__ void hamerlyAssignKernel(const DataT *pairwiseDistance,
+                                    IndexT n_rows, IndexT n_clusters,
+                                    const IndexT *sampleIndices,
+                                    DataT maxDistance, IndexT *labels,
+                                    DataT *upper, DataT *lower) {
+  IndexT row = ((IndexT)blockIdx.x * TPB + threadIdx.x) / MLCommon::WarpSize;
+  int lane = threadIdx.x % MLCommon::WarpSize;
+  if (row >= n_rows) return;
+
+  DataT d1 = maxDistance;
+  DataT d2 = maxDistance;
+  IndexT c1 = 0;
+  for (IndexT c = lane; c < n_clusters; c += MLCommon::WarpSize) {
+    DataT d = pairwiseDistance[(size_t)row * n_clusters + c];
+    if (d < d1) {
+      d2 = d1;
+      d1 = d;
+      c1 = c;
+    } else if (d < d2) {
+      d2 = d;
+    }
+  }
+  // merge the nearest two centroids of the lanes, the smaller index first on
+  // ties so that all the lanes agree
+  for (int offset = MLCommon::WarpSize / 2; offset > 0; offset /= 2) {
+    DataT o1 = MLCommon::shfl_xor(d1, offset);
+    DataT o2 = MLCommon::shfl_xor(d2, offset);
+    IndexT oc1 = MLCommon::shfl_xor(c1, offset);
+    if (o1 < d1 || (o1 == d1 && oc1 < c1)) {
+      d2 = MLCommon::myMin(d1, o2);
+      d1 = o1;
+      c1 = oc1;
+    } else {
+      d2 = MLCommon::myMin(d2, o1);
+    }
+  }
+  if (lane == 0) {
+    IndexT i = sampleIndices[row];
+    labels[i] = c1;
+    // the expanded L2 distances can be slightly negative
+    upper[i] = MLCommon::mySqrt(MLCommon::myMax(d1, (DataT)0));
+    lower[i] = MLCommon::mySqrt(MLCommon::myMax(d2, (DataT)0));
+  }
+}
+
+// Updates Hamerly's bounds of all the samples after the centroids moved by
+// 'shift' and flags in needsUpdate the samples which may have a new nearest
+// centroid
+template <typename DataT, typename IndexT>
+void hamerlyBounds(Tensor<DataT, 2, IndexT> &X,
+                   Tensor<DataT, 2, IndexT> &centroids,
+                   Tensor<IndexT, 1, IndexT> &labels,
+                   Tensor<DataT, 1, IndexT> &shift, DataT maxShift,
+                   Tensor<DataT, 1, IndexT> &halfMinDistance,
+                   Tensor<DataT, 1, IndexT> &upper,
+                   Tensor<DataT, 1, IndexT> &lower,
+                   Tensor<int, 1, IndexT> &needsUpdate, cudaStream_t stream) {
+  constexpr int TPB = 256;
+  auto n_samples = X.getSize(0);
+  size_t n_threads = (size_t)n_samples * MLCommon::WarpSize;
+  hamerlyBoundsKernel<DataT, IndexT, TPB>
+    <<<MLCommon::ceildiv<size_t>(n_threads, TPB), TPB, 0, stream>>>(
+      X.data(), n_samples, X.getSize(1), centroids.data(), labels.data(),
+      shift.data(), maxShift, halfMinDistance.data(), upper.data(),
+      lower.data(), needsUpdate.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+// Assigns the samples flagged in needsUpdate to their nearest centroid, one
+// batch of pairwiseDistance.getSize(0) samples at a time, and returns the #
+// of samples assigned
+template <typename DataT, typename IndexT>
+IndexT hamerlyAssign(const cumlHandle_impl &handle, Tensor<DataT, 2, IndexT> &X,
+                     Tensor<DataT, 2, IndexT> &centroids,
+                     Tensor<int, 1, IndexT> &needsUpdate,
+                     Tensor<IndexT, 1, IndexT> &updateIndices,
+                     Tensor<DataT, 2, IndexT> &batch,
+                     Tensor<DataT, 2, IndexT> &pairwiseDistance,
+                     Tensor<IndexT, 1, IndexT> &labels,
+                     Tensor<DataT, 1, IndexT> &upper,
+                     Tensor<DataT, 1, IndexT> &lower,
+                     MLCommon::device_buffer<char> &workspace,
+                     cudaStream_t stream) {
+  constexpr int TPB = 256;
+  auto n_samples = X.getSize(0);
+  auto n_features = X.getSize(1);
+  auto n_clusters = centroids.getSize(0);
+  auto dataBatchSize = batch.getSize(0);
+
+  // indices of the flagged samples
+  Tensor<IndexT, 1> nSelected({1}, handle.getDeviceAllocator(), stream);
+  cub::CountingInputIterator<IndexT> itr(0);
+  size_t temp_storage_bytes = 0;
+  CUDA_CHECK(cub::DeviceSelect::Flagged(
+    nullptr, temp_storage_bytes, itr, needsUpdate.data(), updateIndices.data(),
+    nSelected.data(), n_samples, stream));
+
+  workspace.resize(temp_storage_bytes, stream);
+
+  CUDA_CHECK(cub::DeviceSelect::Flagged(
+    workspace.data(), temp_storage_bytes, itr, needsUpdate.data(),
+    updateIndices.data(), nSelected.data(), n_samples, stream));
+
+  IndexT n_selected = 0;
+  MLCommon::copy(&n_selected, nSelected.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  for (IndexT dIdx = 0; dIdx < n_selected; dIdx += dataBatchSize) {
+    IndexT ns = std::min(dataBatchSize, n_selected - dIdx);
+
+    auto batchView = batch.template view<2>({ns, n_features}, {0, 0});
+    auto distanceView =
+      pairwiseDistance.template view<2>({ns, n_clusters}, {0, 0});
+
+    MLCommon::Matrix::gather(X.data(), n_features, n_samples,
+                             updateIndices.data() + dIdx, ns, batchView.data(),
+                             stream);
+
+    // the bounds hold Euclidean distances whatever the metric
+    kmeans::detail::pairwiseDistance(handle, batchView, centroids,
+                                     distanceView, workspace,
+                                     MLCommon::Distance::EucExpandedL2, stream);
+
+    size_t n_threads = (size_t)ns * MLCommon::WarpSize;
+    hamerlyAssignKernel<DataT, IndexT, TPB>
+      <<<MLCommon::ceildiv<size_t>(n_threads, TPB), TPB, 0, stream>>>(
+        distanceView.data(), ns, n_clusters, updateIndices.data() + dIdx,
+        std::numeric_limits<DataT>::max(), labels.data(), upper.data(),
+        lower.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+  return n_selected;
+}
+
+// Calculates halfMinDistance[i] as half the Euclidean distance between
+// centroids[i] and its nearest other centroid; centroidDistance is a
+// [n_clusters x n_clusters] buffer
+template <typename DataT, typename IndexT>
+void hamerlyHalfMinDistance(const cumlHandle_impl &handle,
+                            Tensor<DataT, 2, IndexT> &centroids,
+                            Tensor<DataT, 2, IndexT> &centroidDistance,
+                            Tensor<DataT, 1, IndexT> &halfMinDistance,
+                            MLCommon::device_buffer<char> &workspace,
+                            cudaStream_t stream) {
+  auto n_clusters = centroids.getSize(0);
+
+  kmeans::detail::pairwiseDistance(handle, centroids, centroids,
+                                   centroidDistance, workspace,
+                                   MLCommon::Distance::EucExpandedL2, stream);
+
+  // a centroid is not its own nearest other centroid
+  DataT *dist = centroidDistance.data();
+  DataT maxDistance = std::numeric_limits<DataT>::max();
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  thrust::for_each(execution_policy, thrust::make_counting_iterator<IndexT>(0),
+                   thrust::make_counting_iterator<IndexT>(n_clusters),
+                   [=] __device__(IndexT c) {
+                     dist[(size_t)c * n_clusters + c] = maxDistance;
+                   });
+
+  MLCommon::LinAlg::coalescedReduction(
+    halfMinDistance.data(), dist, n_clusters, n_clusters,
+    maxDistance, stream, false,
+    [=] __device__(DataT val, IndexT i) {  // MainLambda
+      return val;
+    },
+    [=] __device__(DataT a, DataT b) {  // ReduceLambda
+      return (b < a) ? b : a;
+    },
+    [=] __device__(DataT val) {  // FinalLambda
+      return (DataT)0.5 * MLCommon::mySqrt(MLCommon::myMax(val, (DataT)0));
+    });
+}
+
+// Largest dynamic shared memory of the fused assignment and update kernel
+static const size_t kFusedAssignUpdateSmem = 40 * 1024;
+static const int kFusedAssignUpdateTPB = 256;
+
+// Assigns every sample of X to its nearest centroid in the (squared or not)
+// Euclidean distance and accumulates the samples and their count in the sums
+// and counts of their clusters, in the same pass over X. A warp handles a
+// sample, held in shared memory, and each lane computes the distance to one
+// centroid of a tile of WarpSize centroids shared by the block. With
+// SmemSums, the sums and counts of the block are accumulated in shared memory
+// and added to sums and counts once at the end.
+template <typename DataT, typename IndexT, int TPB, bool SmemSums>
+__global__ void fusedAssignUpdateKernel(
+  const DataT *X, IndexT n_samples, IndexT n_features, const DataT *centroids,
+  IndexT n_clusters, bool sqrtDistance, DataT maxDistance,
+  cub::KeyValuePair<IndexT, DataT> *minClusterAndDistance, DataT *sums,
+  int *counts) {
+  constexpr int kNumWarps = TPB / MLCommon::WarpSize;
+  __shared__ DataT sCentroids[MLCommon::WarpSize][MLCommon::WarpSize + 1];
+  extern __shared__ char smem[];
+  DataT *sX = (DataT *)smem;
+  DataT *sSums = sX + kNumWarps * n_features;
+  int *sCounts = (int *)(sSums + n_clusters * n_features);
+
+  int lane = threadIdx.x % MLCommon::WarpSize;
+  int warp = threadIdx.x / MLCommon::WarpSize;
+  DataT *sample = sX + warp * n_features;
+
+  if (SmemSums) {
+    for (IndexT i = threadIdx.x; i < n_clusters * n_features; i += TPB)
+      sSums[i] = 0;
+    for (IndexT i = threadIdx.x; i < n_clusters; i += TPB) sCounts[i] = 0;
+  }
+
+  // all the warps of the block loop together, as they share the tiles
+  for (IndexT base = blockIdx.x * kNumWarps; base < n_samples;
+       base += gridDim.x * kNumWarps) {
+    IndexT row = base + warp;
+    bool valid = row < n_samples;
+    for (IndexT j = lane; j < n_features; j += MLCommon::WarpSize)
+      sample[j] = valid ? X[(size_t)row * n_features + j] : (DataT)0;
+
+    DataT minDistance = maxDistance;
+    IndexT minCluster = 0;
+    for (IndexT c0 = 0; c0 < n_clusters; c0 += MLCommon::WarpSize) {
+      DataT acc = 0;
+      for (IndexT d0 = 0; d0 < n_features; d0 += MLCommon::WarpSize) {
+        __syncthreads();
+        for (int r = warp; r < MLCommon::WarpSize; r += kNumWarps) {
+          IndexT c = c0 + r, d = d0 + lane;
+          sCentroids[r][lane] = c < n_clusters && d < n_features
+                                  ? centroids[(size_t)c * n_features + d]
+                                  : (DataT)0;
+        }
+        __syncthreads();
+        int nd = MLCommon::myMin<IndexT>(MLCommon::WarpSize, n_features - d0);
+        for (int j = 0; j < nd; j++) {
+          DataT diff = sample[d0 + j] - sCentroids[lane][j];
+          acc += diff * diff;
+        }
+      }
+      IndexT c = c0 + lane;
+      if (c < n_clusters && acc < minDistance) {
+        minDistance = acc;
+        minCluster = c;
+      }
+    }
+    // argmin of the lanes, the smaller index first on ties
+    for (int offset = MLCommon::WarpSize / 2; offset > 0; offset /= 2) {
+      DataT d = MLCommon::shfl_xor(minDistance, offset);
+      IndexT c = MLCommon::shfl_xor(minCluster, offset);
+      if (d < minDistance || (d == minDistance && c < minCluster)) {
+        minDistance = d;
+        minCluster = c;
+      }
+    }
+
+    if (valid) {
+      if (lane == 0) {
+        cub::KeyValuePair<IndexT, DataT> pair;
+        pair.key = minCluster;
+        pair.value = sqrtDistance ? MLCommon::mySqrt(minDistance) : minDistance;
+        minClusterAndDistance[row] = pair;
+      }
+      DataT *clusterSums =
+        (SmemSums ? sSums : sums) + (size_t)minCluster * n_features;
+      for (IndexT j = lane; j < n_features; j += MLCommon::WarpSize)
+        atomicAdd(clusterSums + j, sample[j]);
+      if (lane == 0) atomicAdd((SmemSums ? sCounts : counts) + minCluster, 1);
+    }
+    __syncwarp();
+  }
+
+  if (SmemSums) {
+    __syncthreads();
+    for (IndexT i = threadIdx.x; i < n_clusters * n_features; i += TPB)
+      if (sSums[i] != (DataT)0) atomicAdd(sums + i, sSums[i]);
+    for (IndexT i = threadIdx.x; i < n_clusters; i += TPB)
+      if (sCounts[i] != 0) atomicAdd(counts + i, sCounts[i]);
+  }
+}
+
+// Can fusedAssignUpdate fit data of n_features features with this metric?
+template <typename DataT>
+bool canFuseAssignUpdate(MLCommon::Distance::DistanceType metric,
+                         int n_features) {
+  constexpr int kNumWarps = kFusedAssignUpdateTPB / MLCommon::WarpSize;
+  bool euclidean = metric == MLCommon::Distance::EucExpandedL2 ||
+                   metric == MLCommon::Distance::EucExpandedL2Sqrt ||
+                   metric == MLCommon::Distance::EucUnexpandedL2 ||
+                   metric == MLCommon::Distance::EucUnexpandedL2Sqrt;
+  return euclidean &&
+         kNumWarps * n_features * sizeof(DataT) <= kFusedAssignUpdateSmem;
+}
+
+// Computes minClusterAndDistance of all the samples of X, and the sum and
+// the # of the samples of each cluster in newCentroids and
+// sampleCountInCluster, in a single pass over X without a distance matrix;
+// requires canFuseAssignUpdate()
+template <typename DataT, typename IndexT>
+void fusedAssignAccumulate(
+  const cumlHandle_impl &handle, Tensor<DataT, 2, IndexT> &X,
+  Tensor<DataT, 2, IndexT> &centroids,
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> &minClusterAndDistance,
+  Tensor<DataT, 2, IndexT> &newCentroids,
+  Tensor<int, 1, IndexT> &sampleCountInCluster,
+  MLCommon::device_buffer<char> &workspace,
+  MLCommon::Distance::DistanceType metric, cudaStream_t stream) {
+  constexpr int TPB = kFusedAssignUpdateTPB;
+  constexpr int kNumWarps = TPB / MLCommon::WarpSize;
+  auto n_samples = X.getSize(0);
+  auto n_features = X.getSize(1);
+  auto n_clusters = centroids.getSize(0);
+  bool sqrtDistance = metric == MLCommon::Distance::EucExpandedL2Sqrt ||
+                      metric == MLCommon::Distance::EucUnexpandedL2Sqrt;
+
+  CUDA_CHECK(cudaMemsetAsync(newCentroids.data(), 0,
+                             newCentroids.getSizeInBytes(), stream));
+  CUDA_CHECK(cudaMemsetAsync(sampleCountInCluster.data(), 0,
+                             sampleCountInCluster.getSizeInBytes(), stream));
+
+  // a few blocks per SM, each accumulating many samples
+  int dev, n_sms;
+  CUDA_CHECK(cudaGetDevice(&dev));
+  CUDA_CHECK(
+    cudaDeviceGetAttribute(&n_sms, cudaDevAttrMultiProcessorCount, dev));
+  int n_blocks = std::min<IndexT>(
+    MLCommon::ceildiv<IndexT>(n_samples, kNumWarps), 4 * n_sms);
+
+  size_t smemX = kNumWarps * n_features * sizeof(DataT);
+  size_t smemSums = n_clusters * (n_features * sizeof(DataT) + sizeof(int));
+  if (smemX + smemSums <= kFusedAssignUpdateSmem) {
+    fusedAssignUpdateKernel<DataT, IndexT, TPB, true>
+      <<<n_blocks, TPB, smemX + smemSums, stream>>>(
+        X.data(), n_samples, n_features, centroids.data(), n_clusters,
+        sqrtDistance, std::numeric_limits<DataT>::max(),
+        minClusterAndDistance.data(), newCentroids.data(),
+        sampleCountInCluster.data());
+  } else {
+    fusedAssignUpdateKernel<DataT, IndexT, TPB, false>
+      <<<n_blocks, TPB, smemX, stream>>>(
+        X.data(), n_samples, n_features, centroids.data(), n_clusters,
+        sqrtDistance, std::numeric_limits<DataT>::max(),
+        minClusterAndDistance.data(), newCentroids.data(),
+        sampleCountInCluster.data());
+  }
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+// Computes minClusterAndDistance of all the samples of X and the new
+// centroids as the means of the samples of each cluster in a single pass over
+// X, without a distance matrix; requires canFuseAssignUpdate()
+template <typename DataT, typename IndexT>
+void fusedAssignUpdate(
+  const cumlHandle_impl &handle, Tensor<DataT, 2, IndexT> &X,
+  Tensor<DataT, 2, IndexT> &centroids,
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> &minClusterAndDistance,
+  Tensor<DataT, 2, IndexT> &newCentroids,
+  Tensor<int, 1, IndexT> &sampleCountInCluster,
+  MLCommon::device_buffer<char> &workspace,
+  MLCommon::Distance::DistanceType metric, cudaStream_t stream) {
+  kmeans::detail::fusedAssignAccumulate(
+    handle, X, centroids, minClusterAndDistance, newCentroids,
+    sampleCountInCluster, workspace, metric, stream);
+
+  kmeans::detail::computeCentroidMeans(
+    handle, centroids, newCentroids, sampleCountInCluster, workspace, stream);
+}
+
+// Draws 'n_chosen' distinct indices in [0, n) with Floyd's algorithm, in
+// increasing order
+inline std::vector<int64_t> chooseSamples(int64_t n, int n_chosen,
+                                          uint64_t seed) {
+  std::mt19937 gen(seed);
+  std::set<int64_t> chosen;
+  for (int64_t j = n - n_chosen; j < n; ++j) {
+    std::uniform_int_distribution<int64_t> dis(0, j);
+    int64_t t = dis(gen);
+    chosen.insert(chosen.count(t) ? j : t);
+  }
+  return std::vector<int64_t>(chosen.begin(), chosen.end());
+}
+
+// Non-owning CSR matrix in device memory, laid out as MLCommon::Sparse::CSR:
+// row_ind holds the n_rows + 1 offsets of the rows and row_ind_ptr the column
+// of each nonzero; h_row_ind is a host copy of row_ind
+template <typename DataT>
+struct CsrInput {
+  const DataT *vals;
+  const int *row_ind;
+  const int *row_ind_ptr;
+  std::vector<int> h_row_ind;
+  int n_rows;
+  int n_cols;
+};
+
+template <typename DataT>
+CsrInput<DataT> makeCsrInput(const DataT *vals, const int *row_ind,
+                             const int *row_ind_ptr, int nnz, int n_rows,
+                             int n_cols, cudaStream_t stream) {
+  CsrInput<DataT> X;
+  X.vals = vals;
+  X.row_ind = row_ind;
+  X.row_ind_ptr = row_ind_ptr;
+  X.n_rows = n_rows;
+  X.n_cols = n_cols;
+  X.h_row_ind.resize(n_rows + 1);
+  MLCommon::copy(X.h_row_ind.data(), row_ind, n_rows + 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  ASSERT(X.h_row_ind[n_rows] == nnz,
+         "the last row offset (%d) must be the # of nonzeros (%d)",
+         X.h_row_ind[n_rows], nnz);
+  return X;
+}
+
+template <typename DataT>
+struct SquareOp {
+  __host__ __device__ __forceinline__ DataT operator()(const DataT &a) const {
+    return a * a;
+  }
+};
+
+// Calculates the squared L2 norm of every row of the CSR matrix
+template <typename DataT>
+void sparseRowNorms(const CsrInput<DataT> &X, DataT *rowNorms,
+                    MLCommon::device_buffer<char> &workspace,
+                    cudaStream_t stream) {
+  cub::TransformInputIterator<DataT, SquareOp<DataT>, const DataT *> itr(
+    X.vals, SquareOp<DataT>());
+  size_t temp_storage_bytes = 0;
+  CUDA_CHECK(cub::DeviceSegmentedReduce::Sum(
+    nullptr, temp_storage_bytes, itr, rowNorms, X.n_rows, X.row_ind,
+    X.row_ind + 1, stream));
+
+  workspace.resize(temp_storage_bytes, stream);
+
+  CUDA_CHECK(cub::DeviceSegmentedReduce::Sum(
+    workspace.data(), temp_storage_bytes, itr, rowNorms, X.n_rows, X.row_ind,
+    X.row_ind + 1, stream));
+}
+
+// Copies the rows 'rows' of the CSR matrix to the dense 'out[rows.size() x
+// n_cols]'
+template <typename DataT, typename IndexT>
+void sparseGatherRows(const cumlHandle_impl &handle, const CsrInput<DataT> &X,
+                      const std::vector<int64_t> &rows,
+                      Tensor<DataT, 2, IndexT> &out, cudaStream_t stream) {
+  CUDA_CHECK(cudaMemsetAsync(out.data(), 0, out.getSizeInBytes(), stream));
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  const DataT *vals = X.vals;
+  const int *cols = X.row_ind_ptr;
+  for (size_t i = 0; i < rows.size(); ++i) {
+    DataT *outRow = out.data() + i * out.getSize(1);
+    thrust::for_each(execution_policy,
+                     thrust::make_counting_iterator(X.h_row_ind[rows[i]]),
+                     thrust::make_counting_iterator(X.h_row_ind[rows[i] + 1]),
+                     [=] __device__(int j) { outRow[cols[j]] = vals[j]; });
+  }
+}
+
+// Sparse counterpart of minClusterAndDistance: the distances of a batch of
+// rows of the CSR matrix to the centroids are ||x||^2 + ||c||^2 - 2 x.c, with
+// the dot products computed by a sparse-dense product (cusparse gemmi); only
+// Euclidean metrics are supported. sampleNorms are the sparseRowNorms of X
+template <typename DataT, typename IndexT>
+void sparseMinClusterAndDistance(
+  const cumlHandle_impl &handle, const KMeansParams &params,
+  const CsrInput<DataT> &X, const DataT *sampleNorms,
+  Tensor<DataT, 2, IndexT> &centroids,
+  Tensor<DataT, 2, IndexT> &pairwiseDistance,
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> &minClusterAndDistance,
+  MLCommon::device_buffer<char> &workspace,
+  MLCommon::Distance::DistanceType metric, cudaStream_t stream) {
+  IndexT n_samples = X.n_rows;
+  IndexT n_features = X.n_cols;
+  auto n_clusters = centroids.getSize(0);
+  auto dataBatchSize = kmeans::detail::getDataBatchSize(params, n_samples);
+  bool sqrtDistance = metric == MLCommon::Distance::EucExpandedL2Sqrt ||
+                      metric == MLCommon::Distance::EucUnexpandedL2Sqrt;
+
+  // gemmi takes the dense operand in column-major order
+  Tensor<DataT, 2, IndexT> centroidsT({n_features, n_clusters},
+                                      handle.getDeviceAllocator(), stream);
+  Tensor<DataT, 1, IndexT> centroidNorms({n_clusters},
+                                         handle.getDeviceAllocator(), stream);
+  Tensor<int, 1, IndexT> batchRowInd({dataBatchSize + 1},
+                                     handle.getDeviceAllocator(), stream);
+
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  const DataT *c = centroids.data();
+  DataT *cT = centroidsT.data();
+  thrust::for_each(execution_policy, thrust::make_counting_iterator<IndexT>(0),
+                   thrust::make_counting_iterator<IndexT>(n_clusters *
+                                                          n_features),
+                   [=] __device__(IndexT idx) {
+                     IndexT i = idx / n_features, j = idx % n_features;
+                     cT[j * n_clusters + i] = c[idx];
+                   });
+  MLCommon::LinAlg::rowNorm(centroidNorms.data(), centroids.data(), n_features,
+                            n_clusters, MLCommon::LinAlg::L2Norm, true, stream);
+
+  cusparseHandle_t cusparse_handle = handle.getcusparseHandle();
+  CUSPARSE_CHECK(cusparseSetStream(cusparse_handle, stream));
+  DataT alpha = 1, beta = 0;
+  const DataT *cNorms = centroidNorms.data();
+
+  // tile over the rows of the input dataset
+  for (IndexT dIdx = 0; dIdx < n_samples; dIdx += dataBatchSize) {
+    IndexT ns = std::min(dataBatchSize, n_samples - dIdx);
+    int start = X.h_row_ind[dIdx];
+    int nnz = X.h_row_ind[dIdx + ns] - start;
+
+    // the row offsets of the batch, relative to its first nonzero
+    thrust::transform(execution_policy, X.row_ind + dIdx,
+                      X.row_ind + dIdx + ns + 1, batchRowInd.begin(),
+                      [=] __device__(int offset) { return offset - start; });
+
+    // distanceView [ns x n_clusters], computed as its column-major transpose
+    auto distanceView =
+      pairwiseDistance.template view<2>({ns, n_clusters}, {0, 0});
+    CUSPARSE_CHECK(MLCommon::LinAlg::cusparsegemmi(
+      cusparse_handle, n_clusters, ns, n_features, nnz, &alpha, cT, n_clusters,
+      X.vals + start, batchRowInd.data(), X.row_ind_ptr + start, &beta,
+      distanceView.data(), n_clusters));
+
+    DataT *dist = distanceView.data();
+    const DataT *xNorms = sampleNorms + dIdx;
+    thrust::for_each(
+      execution_policy, thrust::make_counting_iterator<IndexT>(0),
+      thrust::make_counting_iterator<IndexT>(ns * n_clusters),
+      [=] __device__(IndexT idx) {
+        DataT d = xNorms[idx / n_clusters] + cNorms[idx % n_clusters] -
+                  (DataT)2 * dist[idx];
+        d = d > (DataT)0 ? d : (DataT)0;
+        dist[idx] = sqrtDistance ? MLCommon::mySqrt(d) : d;
+      });
+
+    auto minClusterAndDistanceView =
+      minClusterAndDistance.template view<1>({ns}, {dIdx});
+    kmeans::detail::selectMinClusterAndDistance(
+      distanceView, minClusterAndDistanceView, stream);
+  }
+}
+
+// Accumulates the samples of each cluster, a warp per row of the CSR matrix
+template <typename DataT, typename IndexT, int TPB>
+__global__ void sparseCentroidSumsKernel(
+  const DataT *vals, const int *row_ind, const int *row_ind_ptr,
+  IndexT n_samples, IndexT n_features, const DataT *sampleWeight,
+  const cub::KeyValuePair<IndexT, DataT> *minClusterAndDistance, DataT *sums,
+  DataT *weightInCluster) {
+  IndexT row = ((IndexT)blockIdx.x * TPB + threadIdx.x) / MLCommon::WarpSize;
+  int lane = threadIdx.x % MLCommon::WarpSize;
+  if (row >= n_samples) return;
+
+  IndexT key = minClusterAndDistance[row].key;
+  DataT w = sampleWeight != nullptr ? sampleWeight[row] : (DataT)1;
+  DataT *sum = sums + key * n_features;
+  for (int j = row_ind[row] + lane; j < row_ind[row + 1];
+       j += MLCommon::WarpSize)
+    atomicAdd(sum + row_ind_ptr[j], w * vals[j]);
+  if (lane == 0) atomicAdd(weightInCluster + key, w);
+}
+
+// Sparse counterpart of computeWeightedCentroidSums; sampleWeight may be
+// nullptr for unit weights
+template <typename DataT, typename IndexT>
+void sparseCentroidSums(
+  const CsrInput<DataT> &X, const DataT *sampleWeight,
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> &minClusterAndDistance,
+  Tensor<DataT, 2, IndexT> &newCentroids,
+  Tensor<DataT, 1, IndexT> &weightInCluster, cudaStream_t stream) {
+  constexpr int TPB = 256;
+  CUDA_CHECK(cudaMemsetAsync(newCentroids.data(), 0,
+                             newCentroids.getSizeInBytes(), stream));
+  CUDA_CHECK(cudaMemsetAsync(weightInCluster.data(), 0,
+                             weightInCluster.getSizeInBytes(), stream));
+  IndexT n_blocks =
+    MLCommon::ceildiv<IndexT>(X.n_rows, TPB / MLCommon::WarpSize);
+  sparseCentroidSumsKernel<DataT, IndexT, TPB><<<n_blocks, TPB, 0, stream>>>(
+    X.vals, X.row_ind, X.row_ind_ptr, X.n_rows, X.n_cols, sampleWeight,
+    minClusterAndDistance.data(), newCentroids.data(),
+    weightInCluster.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
 };  // end namespace detail
 };  // end namespace kmeans
 };  // end namespace ML
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include "mg_impl.cuh"
 #include "sg_impl.cuh"
 
 namespace ML {
@@ -60,6 +61,96 @@ void fit(const ML::cumlHandle &handle, const KMeansParams &params,
   fit(h, params, X, n_samples, n_features, centroids, inertia, n_iter);
 }
 
+void fit(const ML::cumlHandle &handle, const KMeansParams &params,
+         const float *X, int n_samples, int n_features,
+         const float *sample_weight, float *centroids, float &inertia,
+         int &n_iter) {
+  const ML::cumlHandle_impl &h = handle.getImpl();
+  ML::detail::streamSyncer _(h);
+
+  fit(h, params, X, n_samples, n_features, centroids, inertia, n_iter,
+      sample_weight);
+}
+
+void fit(const ML::cumlHandle &handle, const KMeansParams &params,
+         const double *X, int n_samples, int n_features,
+         const double *sample_weight, double *centroids, double &inertia,
+         int &n_iter) {
+  const ML::cumlHandle_impl &h = handle.getImpl();
+  ML::detail::streamSyncer _(h);
+
+  fit(h, params, X, n_samples, n_features, centroids, inertia, n_iter,
+      sample_weight);
+}
+
+// ----------------------------- fit_sparse ---------------------------//
+
+void fit_sparse(const ML::cumlHandle &handle, const KMeansParams &params,
+                const float *vals, const int *row_ind, const int *row_ind_ptr,
+                int nnz, int n_samples, int n_features,
+                const float *sample_weight, float *centroids, float &inertia,
+                int &n_iter) {
+  const ML::cumlHandle_impl &h = handle.getImpl();
+  ML::detail::streamSyncer _(h);
+
+  fitSparse(h, params, vals, row_ind, row_ind_ptr, nnz, n_samples, n_features,
+            sample_weight, centroids, inertia, n_iter);
+}
+
+void fit_sparse(const ML::cumlHandle &handle, const KMeansParams &params,
+                const double *vals, const int *row_ind, const int *row_ind_ptr,
+                int nnz, int n_samples, int n_features,
+                const double *sample_weight, double *centroids, double &inertia,
+                int &n_iter) {
+  const ML::cumlHandle_impl &h = handle.getImpl();
+  ML::detail::streamSyncer _(h);
+
+  fitSparse(h, params, vals, row_ind, row_ind_ptr, nnz, n_samples, n_features,
+            sample_weight, centroids, inertia, n_iter);
+}
+
+// ----------------------------- fit_mg ---------------------------------//
+
+void fit_mg(const ML::cumlHandle &handle, const KMeansParams &params,
+            const float *X, int n_samples, int n_features, float *centroids,
+            float &inertia, int &n_iter) {
+  const ML::cumlHandle_impl &h = handle.getImpl();
+  ML::detail::streamSyncer _(h);
+
+  mg::fit(h, params, X, n_samples, n_features, centroids, inertia, n_iter);
+}
+
+void fit_mg(const ML::cumlHandle &handle, const KMeansParams &params,
+            const double *X, int n_samples, int n_features, double *centroids,
+            double &inertia, int &n_iter) {
+  const ML::cumlHandle_impl &h = handle.getImpl();
+  ML::detail::streamSyncer _(h);
+
+  mg::fit(h, params, X, n_samples, n_features, centroids, inertia, n_iter);
+}
+
+// ----------------------------- partial_fit -----------------------------//
+
+void partial_fit(const ML::cumlHandle &handle, const KMeansParams &params,
+                 const float *X, int n_samples, int n_features,
+                 float *centroids, float *cluster_counts, float &inertia) {
+  const ML::cumlHandle_impl &h = handle.getImpl();
+  ML::detail::streamSyncer _(h);
+
+  partialFit(h, params, X, n_samples, n_features, centroids, cluster_counts,
+             inertia);
+}
+
+void partial_fit(const ML::cumlHandle &handle, const KMeansParams &params,
+                 const double *X, int n_samples, int n_features,
+                 double *centroids, double *cluster_counts, double &inertia) {
+  const ML::cumlHandle_impl &h = handle.getImpl();
+  ML::detail::streamSyncer _(h);
+
+  partialFit(h, params, X, n_samples, n_features, centroids, cluster_counts,
+             inertia);
+}
+
 // ----------------------------- predict ---------------------------------//
 
 void predict(const ML::cumlHandle &handle, const KMeansParams &params,
@@ -80,6 +171,62 @@ void predict(const ML::cumlHandle &handle, const KMeansParams &params,
   predict(h, params, centroids, X, n_samples, n_features, labels, inertia);
 }
 
+// ----------------------------- predict_async ---------------------------//
+
+void predict_async(const ML::cumlHandle &handle, const KMeansParams &params,
+                   const float *centroids, const float *X, int n_samples,
+                   int n_features, int *labels, float *inertia,
+                   cudaEvent_t done) {
+  const ML::cumlHandle_impl &h = handle.getImpl();
+  {
+    ML::detail::streamSyncer _(h);
+    predictAsync(h, params, centroids, X, n_samples, n_features, labels,
+                 inertia);
+  }
+  // after the user stream has joined the internal streams
+  if (done != nullptr) CUDA_CHECK(cudaEventRecord(done, h.getStream()));
+}
+
+void predict_async(const ML::cumlHandle &handle, const KMeansParams &params,
+                   const double *centroids, const double *X, int n_samples,
+                   int n_features, int *labels, double *inertia,
+                   cudaEvent_t done) {
+  const ML::cumlHandle_impl &h = handle.getImpl();
+  {
+    ML::detail::streamSyncer _(h);
+    predictAsync(h, params, centroids, X, n_samples, n_features, labels,
+                 inertia);
+  }
+  // after the user stream has joined the internal streams
+  if (done != nullptr) CUDA_CHECK(cudaEventRecord(done, h.getStream()));
+}
+
+// ----------------------------- predict_sparse -----------------------//
+
+void predict_sparse(const ML::cumlHandle &handle, const KMeansParams &params,
+                    const float *centroids, const float *vals,
+                    const int *row_ind, const int *row_ind_ptr, int nnz,
+                    int n_samples, int n_features, int *labels,
+                    float &inertia) {
+  const ML::cumlHandle_impl &h = handle.getImpl();
+  ML::detail::streamSyncer _(h);
+
+  predictSparse(h, params, centroids, vals, row_ind, row_ind_ptr, nnz,
+                n_samples, n_features, labels, inertia);
+}
+
+void predict_sparse(const ML::cumlHandle &handle, const KMeansParams &params,
+                    const double *centroids, const double *vals,
+                    const int *row_ind, const int *row_ind_ptr, int nnz,
+                    int n_samples, int n_features, int *labels,
+                    double &inertia) {
+  const ML::cumlHandle_impl &h = handle.getImpl();
+  ML::detail::streamSyncer _(h);
+
+  predictSparse(h, params, centroids, vals, row_ind, row_ind_ptr, nnz,
+                n_samples, n_features, labels, inertia);
+}
+
 // ----------------------------- transform ---------------------------------//
 void transform(const ML::cumlHandle &handle, const KMeansParams &params,
                const float *centroids, const float *X, int n_samples,
@@ -0,0 +1,676 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include "common/checkpoint.hpp"
+#include "sg_impl.cuh"
+
+namespace ML {
+
+namespace kmeans {
+
+// Distributed k-means: every rank of the communicator of the handle holds a
+// shard of the samples, and all the ranks end up with the same centroids
+namespace mg {
+
+// Gathers 'value' from all the ranks, in rank order
+template <typename T>
+std::vector<T> allgatherValue(const ML::cumlHandle_impl &handle, T value) {
+  const MLCommon::cumlCommunicator &comm = handle.getCommunicator();
+  cudaStream_t stream = handle.getStream();
+  int rank = comm.getRank();
+  int n_ranks = comm.getSize();
+
+  MLCommon::device_buffer<T> values(handle.getDeviceAllocator(), stream,
+                                    n_ranks);
+  MLCommon::copy(values.data() + rank, &value, 1, stream);
+  comm.allgather(values.data() + rank, values.data(), 1, stream);
+
+  std::vector<T> h_values(n_ranks);
+  MLCommon::copy(h_values.data(), values.data(), n_ranks, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  return h_values;
+}
+
+// Index of the first sample of each rank when the samples are numbered in
+// rank order; the last entry is the total # of samples
+template <typename IndexT>
+std::vector<int64_t> getRankOffsets(const ML::cumlHandle_impl &handle,
+                                    IndexT n_local_samples) {
+  auto n_rank_samples =
+    allgatherValue<int64_t>(handle, (int64_t)n_local_samples);
+  std::vector<int64_t> offsets(n_rank_samples.size() + 1, 0);
+  std::partial_sum(n_rank_samples.begin(), n_rank_samples.end(),
+                   offsets.begin() + 1);
+  return offsets;
+}
+
+// Sums the cluster cost of the local samples over all the ranks
+template <typename DataT, typename IndexT>
+DataT computeClusterCost(
+  const ML::cumlHandle_impl &handle,
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> &minClusterAndDistance,
+  cub::KeyValuePair<IndexT, DataT> *clusterCostD,
+  MLCommon::device_buffer<char> &workspace) {
+  cudaStream_t stream = handle.getStream();
+  kmeans::detail::computeClusterCost(
+    handle, minClusterAndDistance, workspace, clusterCostD,
+    [] __device__(const cub::KeyValuePair<IndexT, DataT> &a,
+                  const cub::KeyValuePair<IndexT, DataT> &b) {
+      cub::KeyValuePair<IndexT, DataT> res;
+      res.key = 0;
+      res.value = a.value + b.value;
+      return res;
+    },
+    stream);
+
+  handle.getCommunicator().allreduce(&clusterCostD->value,
+                                     &clusterCostD->value, 1,
+                                     MLCommon::cumlCommunicator::SUM, stream);
+
+  DataT cost = 0;
+  MLCommon::copy(&cost, &clusterCostD->value, 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  return cost;
+}
+
+// Selects 'n_clusters' samples uniformly at random from the samples of all
+// the ranks; each rank contributes the chosen samples of its shard
+template <typename DataT, typename IndexT>
+void initRandom(const ML::cumlHandle_impl &handle, const KMeansParams &params,
+                Tensor<DataT, 2, IndexT> &X,
+                MLCommon::device_buffer<DataT> &centroidsRawData) {
+  const MLCommon::cumlCommunicator &comm = handle.getCommunicator();
+  cudaStream_t stream = handle.getStream();
+  auto n_local_samples = X.getSize(0);
+  auto n_features = X.getSize(1);
+  auto n_clusters = params.n_clusters;
+  int rank = comm.getRank();
+
+  auto offsets = getRankOffsets(handle, n_local_samples);
+  int64_t n_samples = offsets.back();
+  ASSERT(n_samples >= n_clusters,
+         "# of samples (%ld) must be >= # of clusters (%d)", (long)n_samples,
+         n_clusters);
+
+  // the seed is the same on all the ranks, so they all draw the same
+  // 'n_clusters' distinct samples
+  auto chosen =
+    kmeans::detail::chooseSamples(n_samples, n_clusters, params.seed);
+
+  centroidsRawData.resize(n_clusters * n_features, stream);
+  CUDA_CHECK(cudaMemsetAsync(centroidsRawData.data(), 0,
+                             centroidsRawData.size() * sizeof(DataT), stream));
+
+  int c = 0;
+  for (int64_t g : chosen) {
+    if (g >= offsets[rank] && g < offsets[rank + 1]) {
+      IndexT i = g - offsets[rank];
+      MLCommon::copy(centroidsRawData.data() + c * n_features,
+                     X.data() + i * n_features, n_features, stream);
+    }
+    ++c;
+  }
+
+  comm.allreduce(centroidsRawData.data(), centroidsRawData.data(),
+                 n_clusters * n_features, MLCommon::cumlCommunicator::SUM,
+                 stream);
+}
+
+/*
+ * @brief Selects 'n_clusters' samples from the shards of all the ranks using
+ * scalable kmeans++ algorithm; see ML::kmeans::initKMeansPlusPlus for the
+ * pseudocode.
+
+ * Each rank samples the potential centroids of step-4 from its own shard,
+ * and they are allgathered so that all the ranks hold the same C. The cost
+ * phi_X (C) and the weights of step-7 are sums over the ranks. Only C is
+ * reclustered in step-8, on every rank, and the result of rank 0 is
+ * broadcast so that all the ranks start the fit from the same centroids.
+ */
+template <typename DataT, typename IndexT>
+void initKMeansPlusPlus(const ML::cumlHandle_impl &handle,
+                        const KMeansParams &params, Tensor<DataT, 2, IndexT> &X,
+                        MLCommon::device_buffer<DataT> &centroidsRawData,
+                        MLCommon::device_buffer<char> &workspace) {
+  const MLCommon::cumlCommunicator &comm = handle.getCommunicator();
+  cudaStream_t stream = handle.getStream();
+  auto n_local_samples = X.getSize(0);
+  auto n_features = X.getSize(1);
+  auto n_clusters = params.n_clusters;
+  int rank = comm.getRank();
+  int n_ranks = comm.getSize();
+  MLCommon::Distance::DistanceType metric =
+    static_cast<MLCommon::Distance::DistanceType>(params.metric);
+
+  // the samples drawn in step-4 must be independent between the ranks
+  MLCommon::Random::Rng rng(params.seed + rank,
+                            MLCommon::Random::GeneratorType::GenPhilox);
+
+  auto offsets = getRankOffsets(handle, n_local_samples);
+  int64_t n_samples = offsets.back();
+
+  // <<<< Step-1 >>> : C <- sample a point uniformly at random from X
+  std::mt19937 gen(params.seed);
+  std::uniform_int_distribution<int64_t> dis(0, n_samples - 1);
+  int64_t cIdx = dis(gen);
+  bool isLocal = cIdx >= offsets[rank] && cIdx < offsets[rank + 1];
+
+  // device buffer to flag the sample that is chosen as initial centroid
+  Tensor<int, 1> isSampleCentroid({n_local_samples},
+                                  handle.getDeviceAllocator(), stream);
+  CUDA_CHECK(cudaMemsetAsync(isSampleCentroid.data(), 0,
+                             isSampleCentroid.getSizeInBytes(), stream));
+
+  MLCommon::device_buffer<DataT> centroidsBuf(handle.getDeviceAllocator(),
+                                              stream);
+
+  // reset buffer to store the chosen centroid, only its rank contributes it
+  centroidsBuf.reserve(n_clusters * n_features, stream);
+  centroidsBuf.resize(n_features, stream);
+  CUDA_CHECK(cudaMemsetAsync(centroidsBuf.data(), 0,
+                             centroidsBuf.size() * sizeof(DataT), stream));
+  if (isLocal) {
+    IndexT i = cIdx - offsets[rank];
+    int flag = 1;
+    MLCommon::copy(isSampleCentroid.data() + i, &flag, 1, stream);
+    MLCommon::copy(centroidsBuf.data(), X.data() + i * n_features, n_features,
+                   stream);
+  }
+  comm.allreduce(centroidsBuf.data(), centroidsBuf.data(), n_features,
+                 MLCommon::cumlCommunicator::SUM, stream);
+
+  auto potentialCentroids = std::move(
+    Tensor<DataT, 2, IndexT>(centroidsBuf.data(), {1, n_features}));
+  // <<< End of Step-1 >>>
+
+  int dataBatchSize = kmeans::detail::getDataBatchSize(params, n_local_samples);
+
+  MLCommon::device_buffer<DataT> pairwiseDistanceRaw(
+    handle.getDeviceAllocator(), stream);
+  pairwiseDistanceRaw.resize(dataBatchSize, stream);
+
+  Tensor<DataT, 1, IndexT> minClusterDistance(
+    {n_local_samples}, handle.getDeviceAllocator(), stream);
+  Tensor<DataT, 1, IndexT> uniformRands({n_local_samples},
+                                        handle.getDeviceAllocator(), stream);
+  MLCommon::device_buffer<DataT> clusterCost(handle.getDeviceAllocator(),
+                                             stream, 1);
+
+  // <<< Step-2 >>>: psi <- phi_X (C)
+  Tensor<DataT, 2, IndexT> pairwiseDistance(
+    (DataT *)pairwiseDistanceRaw.data(), {dataBatchSize, 1});
+
+  kmeans::detail::minClusterDistance(handle, params, X, potentialCentroids,
+                                     pairwiseDistance, minClusterDistance,
+                                     workspace, metric, stream);
+
+  kmeans::detail::computeClusterCost(
+    handle, minClusterDistance, workspace, clusterCost.data(),
+    [] __device__(const DataT &a, const DataT &b) { return a + b; }, stream);
+  comm.allreduce(clusterCost.data(), clusterCost.data(), 1,
+                 MLCommon::cumlCommunicator::SUM, stream);
+
+  DataT psi = 0;
+  MLCommon::copy(&psi, clusterCost.data(), clusterCost.size(), stream);
+
+  // index of the potential centroid nearest to each local sample
+  Tensor<IndexT, 1, IndexT> nearestCentroid(
+    {n_local_samples}, handle.getDeviceAllocator(), stream);
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> newClusterAndDistance(
+    {n_local_samples}, handle.getDeviceAllocator(), stream);
+
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  thrust::fill(execution_policy, nearestCentroid.begin(), nearestCentroid.end(),
+               0);
+  // <<< End of Step-2 >>>
+
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  int niter = std::min(8, (int)ceil(log(psi)));
+  LOG(params.verbose, "KMeans||: psi = %g, log(psi) = %g, niter = %d \n", psi,
+      log(psi), niter);
+
+  std::vector<int> recvCounts(n_ranks), displs(n_ranks);
+
+  // <<<< Step-3 >>> : for O( log(psi) ) times do
+  for (int iter = 0; iter < niter; ++iter) {
+    LOG(params.verbose,
+        "KMeans|| - Iteration %d: # potential centroids sampled - %d\n", iter,
+        potentialCentroids.getSize(0));
+
+    // <<<< Step-4 >>> : Sample each point x in the shard independently and
+    // identify new potentialCentroids
+    rng.uniform(uniformRands.data(), uniformRands.getSize(0), (DataT)0,
+                (DataT)1, stream);
+
+    kmeans::detail::SamplingOp<DataT> select_op(psi, params.oversampling_factor,
+                                                n_clusters, uniformRands.data(),
+                                                isSampleCentroid.data());
+
+    auto inRankCp = kmeans::detail::sampleCentroids(
+      handle, X, minClusterDistance, isSampleCentroid, select_op, workspace,
+      stream);
+    /// <<<< End of Step-4 >>>>
+
+    /// <<<< Step-5 >>> : C = C U C'
+    // append the potential centroids sampled in all the ranks, in rank order
+    auto n_rank_cp = allgatherValue<int>(handle, inRankCp.getSize(0));
+    int n_cp = 0;
+    for (int r = 0; r < n_ranks; ++r) {
+      recvCounts[r] = n_rank_cp[r] * n_features;
+      displs[r] = n_cp * n_features;
+      n_cp += n_rank_cp[r];
+    }
+    if (n_cp == 0) continue;
+
+    IndexT offset = potentialCentroids.getSize(0);
+    centroidsBuf.resize(centroidsBuf.size() + n_cp * n_features, stream);
+    comm.allgatherv<DataT>(inRankCp.data(),
+                           centroidsBuf.data() + offset * n_features,
+                           recvCounts.data(), displs.data(), stream);
+
+    potentialCentroids = std::move(Tensor<DataT, 2, IndexT>(
+      centroidsBuf.data(), {offset + n_cp, n_features}));
+    auto Cp = potentialCentroids.template view<2>({n_cp, n_features},
+                                                  {offset, 0});
+    /// <<<< End of Step-5 >>>
+
+    // the running minimum is merged with the nearest of the new candidates
+    pairwiseDistanceRaw.resize(dataBatchSize * n_cp, stream);
+    Tensor<DataT, 2, IndexT> pairwiseDistance(
+      (DataT *)pairwiseDistanceRaw.data(), {dataBatchSize, n_cp});
+
+    kmeans::detail::minClusterAndDistance(
+      handle, params, X, Cp, pairwiseDistance, newClusterAndDistance, workspace,
+      metric, stream);
+
+    DataT *minDistance = minClusterDistance.data();
+    IndexT *nearest = nearestCentroid.data();
+    const cub::KeyValuePair<IndexT, DataT> *newNearest =
+      newClusterAndDistance.data();
+    thrust::for_each(
+      execution_policy, thrust::make_counting_iterator<IndexT>(0),
+      thrust::make_counting_iterator<IndexT>(n_local_samples),
+      [=] __device__(IndexT i) {
+        if (newNearest[i].value < minDistance[i]) {
+          minDistance[i] = newNearest[i].value;
+          nearest[i] = offset + newNearest[i].key;
+        }
+      });
+
+    kmeans::detail::computeClusterCost(
+      handle, minClusterDistance, workspace, clusterCost.data(),
+      [] __device__(const DataT &a, const DataT &b) { return a + b; }, stream);
+    comm.allreduce(clusterCost.data(), clusterCost.data(), 1,
+                   MLCommon::cumlCommunicator::SUM, stream);
+
+    MLCommon::copy(&psi, clusterCost.data(), clusterCost.size(), stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }  /// <<<< Step-6 >>>
+
+  LOG(params.verbose, "KMeans||: total # potential centroids sampled - %d\n",
+      potentialCentroids.getSize(0));
+
+  if (potentialCentroids.getSize(0) > n_clusters) {
+    // <<< Step-7 >>>: For x in C, set w_x to be the number of pts closest to X
+    Tensor<int, 1, IndexT> weights({potentialCentroids.getSize(0)},
+                                   handle.getDeviceAllocator(), stream);
+
+    kmeans::detail::countLabels(handle, nearestCentroid.data(), weights.data(),
+                                n_local_samples, potentialCentroids.getSize(0),
+                                workspace, stream);
+    comm.allreduce(weights.data(), weights.data(), weights.numElements(),
+                   MLCommon::cumlCommunicator::SUM, stream);
+    // <<< end of Step-7 >>>
+
+    // Step-8: Recluster the weighted points in C into k clusters
+    centroidsRawData.resize(n_clusters * n_features, stream);
+    kmeans::detail::kmeansPlusPlus(handle, params, potentialCentroids, weights,
+                                   metric, workspace, centroidsRawData, stream);
+
+    DataT inertia = 0;
+    int n_iter = 0;
+    KMeansParams default_params;
+    default_params.n_clusters = params.n_clusters;
+
+    ML::kmeans::fit(handle, default_params, potentialCentroids,
+                    centroidsRawData, inertia, n_iter, workspace);
+
+    comm.bcast(centroidsRawData.data(), n_clusters * n_features, 0, stream);
+  } else if (potentialCentroids.getSize(0) < n_clusters) {
+    // supplement with random
+    auto n_random_clusters = n_clusters - potentialCentroids.getSize(0);
+
+    LOG(true,
+        "[Warning!] KMeans||: found fewer than %d centroids during "
+        "initialization (found %d centroids, remaining %d centroids will be "
+        "chosen randomly from input samples)\n",
+        n_clusters, potentialCentroids.getSize(0), n_random_clusters);
+
+    // generate `n_random_clusters` centroids
+    KMeansParams rand_params;
+    rand_params.init = KMeansParams::InitMethod::Random;
+    rand_params.n_clusters = n_random_clusters;
+    rand_params.seed = params.seed;
+    mg::initRandom(handle, rand_params, X, centroidsRawData);
+
+    // copy centroids generated during kmeans|| iteration to the buffer
+    centroidsRawData.resize(n_clusters * n_features, stream);
+    MLCommon::copy(centroidsRawData.data() + n_random_clusters * n_features,
+                   potentialCentroids.data(), potentialCentroids.numElements(),
+                   stream);
+  } else {
+    // found the required n_clusters
+    centroidsRawData.resize(n_clusters * n_features, stream);
+    MLCommon::copy(centroidsRawData.data(), potentialCentroids.data(),
+                   potentialCentroids.numElements(), stream);
+  }
+}
+
+// Identifies the checkpoints of the centroids of a fit
+template <typename DataT>
+uint64_t checkpointTag(int n_clusters, int n_features) {
+  return (uint64_t(n_features) << 32) | (uint64_t(n_clusters) << 8) |
+         sizeof(DataT);
+}
+
+// Lloyd's iterations where the sums and the counts of the samples of each
+// cluster are computed on the local shard and allreduced, from iteration
+// n_iter, eg: that of a checkpoint
+template <typename DataT, typename IndexT>
+void fit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
+         Tensor<DataT, 2, IndexT> &X,
+         MLCommon::device_buffer<DataT> &centroidsRawData, DataT &inertia,
+         int &n_iter, MLCommon::device_buffer<char> &workspace) {
+  const MLCommon::cumlCommunicator &comm = handle.getCommunicator();
+  cudaStream_t stream = handle.getStream();
+  auto n_local_samples = X.getSize(0);
+  auto n_features = X.getSize(1);
+  auto n_clusters = params.n_clusters;
+
+  MLCommon::Distance::DistanceType metric =
+    static_cast<MLCommon::Distance::DistanceType>(params.metric);
+
+  auto dataBatchSize =
+    kmeans::detail::getDataBatchSize(params, n_local_samples);
+
+  bool fused = !kmeans::detail::useMixedPrecision<DataT>(params, metric) &&
+               kmeans::detail::canFuseAssignUpdate<DataT>(metric, n_features);
+
+  // stores (key, value) pair corresponding to each local sample where
+  //   - key is the index of nearest cluster
+  //   - value is the distance to the nearest cluster
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> minClusterAndDistance(
+    {n_local_samples}, handle.getDeviceAllocator(), stream);
+
+  // temporary buffer to store distance matrix, destructor releases the resource
+  Tensor<DataT, 2, IndexT> pairwiseDistance(
+    {fused ? 1 : dataBatchSize, n_clusters}, handle.getDeviceAllocator(),
+    stream);
+
+  // temporary buffer to store intermediate centroids, destructor releases the
+  // resource
+  Tensor<DataT, 2, IndexT> newCentroids({n_clusters, n_features},
+                                        handle.getDeviceAllocator(), stream);
+
+  // temporary buffer to store the sample count per cluster, destructor releases
+  // the resource
+  Tensor<int, 1, IndexT> sampleCountInCluster(
+    {n_clusters}, handle.getDeviceAllocator(), stream);
+
+  cub::KeyValuePair<IndexT, DataT> *clusterCostD =
+    (cub::KeyValuePair<IndexT, DataT> *)handle.getDeviceAllocator()->allocate(
+      sizeof(cub::KeyValuePair<IndexT, DataT>), stream);
+
+  LOG(params.verbose,
+      "Calling KMeans.fit with %d local samples of input data and the "
+      "initialized cluster centers\n",
+      n_local_samples);
+
+  // the centroids are the same on all the ranks, rank 0 writes them
+  std::unique_ptr<checkpointWriter> checkpoint;
+  if (params.checkpoint_interval > 0 && !params.checkpoint_path.empty() &&
+      comm.getRank() == 0) {
+    checkpoint.reset(new checkpointWriter(
+      params.checkpoint_path,
+      checkpointTag<DataT>(n_clusters, n_features)));
+  }
+
+  DataT priorClusteringCost = 0;
+  const int first_iter = n_iter;
+  for (; n_iter < params.max_iter; ++n_iter) {
+    LOG(params.verbose,
+        "KMeans.fit: Iteration-%d: fitting the model using the initialized "
+        "cluster centers\n",
+        n_iter);
+
+    auto centroids = std::move(Tensor<DataT, 2, IndexT>(
+      centroidsRawData.data(), {n_clusters, n_features}));
+
+    // sums and counts of the local samples of each cluster
+    if (fused) {
+      kmeans::detail::fusedAssignAccumulate(
+        handle, X, centroids, minClusterAndDistance, newCentroids,
+        sampleCountInCluster, workspace, metric, stream);
+    } else {
+      kmeans::detail::minClusterAndDistance(
+        handle, params, X, centroids, pairwiseDistance, minClusterAndDistance,
+        workspace, metric, stream);
+
+      kmeans::detail::KeyValueIndexOp<IndexT, DataT> conversion_op;
+      cub::TransformInputIterator<
+        IndexT, kmeans::detail::KeyValueIndexOp<IndexT, DataT>,
+        cub::KeyValuePair<IndexT, DataT> *>
+        itr(minClusterAndDistance.data(), conversion_op);
+
+      kmeans::detail::computeCentroidSums(
+        handle, X, itr, newCentroids, sampleCountInCluster, workspace, stream);
+    }
+
+    comm.allreduce(newCentroids.data(), newCentroids.data(),
+                   newCentroids.numElements(), MLCommon::cumlCommunicator::SUM,
+                   stream);
+    comm.allreduce(sampleCountInCluster.data(), sampleCountInCluster.data(),
+                   sampleCountInCluster.numElements(),
+                   MLCommon::cumlCommunicator::SUM, stream);
+
+    // the sums and counts are the same on all the ranks, and so are the new
+    // centroids and the convergence decisions below
+    kmeans::detail::computeCentroidMeans(
+      handle, centroids, newCentroids, sampleCountInCluster, workspace, stream);
+
+    // compute the squared norm between the newCentroids and the original
+    // centroids, destructor releases the resource
+    Tensor<DataT, 1> sqrdNorm({1}, handle.getDeviceAllocator(), stream);
+    MLCommon::LinAlg::mapThenSumReduce(
+      sqrdNorm.data(), newCentroids.numElements(),
+      [=] __device__(const DataT a, const DataT b) {
+        DataT diff = a - b;
+        return diff * diff;
+      },
+      stream, centroids.data(), newCentroids.data());
+
+    DataT sqrdNormError = 0;
+    MLCommon::copy(&sqrdNormError, sqrdNorm.data(), sqrdNorm.numElements(),
+                   stream);
+
+    MLCommon::copy(centroidsRawData.data(), newCentroids.data(),
+                   newCentroids.numElements(), stream);
+
+    bool done = false;
+    if (params.inertia_check) {
+      // calculate cluster cost phi_x(C) over all the ranks
+      DataT curClusteringCost = mg::computeClusterCost(
+        handle, minClusterAndDistance, clusterCostD, workspace);
+
+      ASSERT(curClusteringCost != (DataT)0.0,
+             "Too few points and centriods being found is getting 0 cost from "
+             "centers\n");
+
+      if (n_iter > first_iter) {
+        DataT delta = curClusteringCost / priorClusteringCost;
+        if (delta > 1 - params.tol) done = true;
+      }
+      priorClusteringCost = curClusteringCost;
+    }
+
+    if (checkpoint && (n_iter + 1) % params.checkpoint_interval == 0) {
+      checkpoint->save(centroidsRawData.data(),
+                       newCentroids.numElements() * sizeof(DataT), n_iter + 1,
+                       stream);
+    }
+
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    if (sqrdNormError < params.tol) done = true;
+
+    if (done) {
+      LOG(params.verbose,
+          "Threshold triggered after %d iterations. Terminating early.\n",
+          n_iter);
+      break;
+    }
+  }
+
+  // calculate cluster cost phi_x(C) over all the ranks
+  inertia = mg::computeClusterCost(handle, minClusterAndDistance,
+                                   clusterCostD, workspace);
+
+  handle.getDeviceAllocator()->deallocate(
+    clusterCostD, sizeof(cub::KeyValuePair<IndexT, DataT>), stream);
+  if (checkpoint) checkpoint->wait();
+}
+
+// Reads the centroids and the iteration of the checkpoint of the fit on rank
+// 0 into centroidsRawData and n_iter on all the ranks; returns false, on all
+// the ranks, when rank 0 has no checkpoint
+template <typename DataT>
+bool resumeFromCheckpoint(const ML::cumlHandle_impl &handle,
+                          const KMeansParams &params, int n_features,
+                          MLCommon::device_buffer<DataT> &centroidsRawData,
+                          int &n_iter) {
+  const MLCommon::cumlCommunicator &comm = handle.getCommunicator();
+  cudaStream_t stream = handle.getStream();
+  const int len = params.n_clusters * n_features;
+  centroidsRawData.resize(len, stream);
+  // -1 without a checkpoint, -2 when it is invalid
+  int iteration = -1;
+  std::exception_ptr error;
+  if (comm.getRank() == 0) {
+    try {
+      if (!loadCheckpoint(params.checkpoint_path,
+                          checkpointTag<DataT>(params.n_clusters, n_features),
+                          centroidsRawData.data(), len * sizeof(DataT),
+                          &iteration, stream)) {
+        iteration = -1;
+      }
+    } catch (...) {
+      // raised once the other ranks know, so that they do not wait for rank 0
+      error = std::current_exception();
+      iteration = -2;
+    }
+  }
+  MLCommon::device_buffer<int> iteration_d(handle.getDeviceAllocator(),
+                                           stream, 1);
+  MLCommon::updateDevice(iteration_d.data(), &iteration, 1, stream);
+  comm.bcast(iteration_d.data(), 1, 0, stream);
+  MLCommon::updateHost(&iteration, iteration_d.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  if (error) std::rethrow_exception(error);
+  ASSERT(iteration != -2, "KMeans.fit: invalid checkpoint on rank 0");
+  if (iteration < 0) return false;
+  comm.bcast(centroidsRawData.data(), len, 0, stream);
+  // at least one iteration, for the assignments of the inertia
+  n_iter = std::min(iteration, params.max_iter - 1);
+  return true;
+}
+
+template <typename DataT, typename IndexT = int>
+void fit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
+         const DataT *X, const int n_local_samples, const int n_features,
+         DataT *centroids, DataT &inertia, int &n_iter) {
+  cudaStream_t stream = handle.getStream();
+
+  ASSERT(handle.commsInitialized(),
+         "A distributed k-means requires a handle with a communicator");
+
+  ASSERT(n_local_samples > 0, "# of local samples must be > 0");
+
+  ASSERT(params.oversampling_factor > 0,
+         "oversampling factor must be > 0 (requested %f)",
+         params.oversampling_factor);
+
+  ASSERT(memory_type(X) == cudaMemoryTypeDevice,
+         "input data must be device accessible");
+
+  ASSERT(params.algorithm == KMeansParams::Algorithm::Lloyd,
+         "a distributed k-means only supports Lloyd's algorithm");
+
+  Tensor<DataT, 2, IndexT> data((DataT *)X, {n_local_samples, n_features});
+
+  // underlying expandable storage that holds centroids data
+  MLCommon::device_buffer<DataT> centroidsRawData(handle.getDeviceAllocator(),
+                                                  stream);
+
+  // Device-accessible allocation of expandable storage used as temorary buffers
+  MLCommon::device_buffer<char> workspace(handle.getDeviceAllocator(), stream);
+
+  n_iter = 0;
+  if (params.resume && !params.checkpoint_path.empty() &&
+      mg::resumeFromCheckpoint(handle, params, n_features, centroidsRawData,
+                               n_iter)) {
+    LOG(params.verbose,
+        "KMeans.fit: resume from the checkpoint of iteration %d.\n", n_iter);
+  } else if (params.init == KMeansParams::InitMethod::Random) {
+    LOG(params.verbose,
+        "KMeans.fit: initialize cluster centers by randomly choosing from the "
+        "input data of all the ranks.\n");
+    mg::initRandom(handle, params, data, centroidsRawData);
+  } else if (params.init == KMeansParams::InitMethod::KMeansPlusPlus) {
+    LOG(params.verbose,
+        "KMeans.fit: initialize cluster centers using k-means++ algorithm over "
+        "all the ranks.\n");
+    mg::initKMeansPlusPlus(handle, params, data, centroidsRawData, workspace);
+  } else if (params.init == KMeansParams::InitMethod::Array) {
+    LOG(params.verbose,
+        "KMeans.fit: initialize cluster centers from the ndarray array input "
+        "passed to init arguement.\n");
+
+    ASSERT(centroids != nullptr,
+           "centroids array is null (require a valid array of centroids for "
+           "the requested initialization method)");
+
+    // the centroids of rank 0 are the initial centroids of all the ranks
+    centroidsRawData.resize(params.n_clusters * n_features, stream);
+    MLCommon::copy(centroidsRawData.begin(), centroids,
+                   params.n_clusters * n_features, stream);
+    handle.getCommunicator().bcast(centroidsRawData.data(),
+                                   params.n_clusters * n_features, 0, stream);
+  } else {
+    THROW("unknown initialization method to select initial centers");
+  }
+
+  mg::fit(handle, params, data, centroidsRawData, inertia, n_iter, workspace);
+
+  MLCommon::copy(centroids, centroidsRawData.data(),
+                 params.n_clusters * n_features, stream);
+}
+
+};  // end namespace mg
+};  // end namespace kmeans
+};  // end namespace ML
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#pragma once
+
 #include "common.cuh"
 
 namespace ML {
@@ -37,11 +39,14 @@ void initRandom(const ML::cumlHandle_impl &handle, const KMeansParams &params,
                                    params.seed, stream);
 }
 
+// Lloyd's algorithm; with sampleWeight, the centroids are the weighted means
+// of their samples and the inertia is weighted
 template <typename DataT, typename IndexT>
 void fit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
          Tensor<DataT, 2, IndexT> &X,
          MLCommon::device_buffer<DataT> &centroidsRawData, DataT &inertia,
-         int &n_iter, MLCommon::device_buffer<char> &workspace) {
+         int &n_iter, MLCommon::device_buffer<char> &workspace,
+         const DataT *sampleWeight = nullptr) {
   cudaStream_t stream = handle.getStream();
   auto n_samples = X.getSize(0);
   auto n_features = X.getSize(1);
@@ -52,6 +57,12 @@ void fit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
 
   auto dataBatchSize = kmeans::detail::getDataBatchSize(params, n_samples);
 
+  // assigns the samples and accumulates the new centroids in the same pass
+  // over X, without distance matrix
+  bool fused = sampleWeight == nullptr &&
+               !kmeans::detail::useMixedPrecision<DataT>(params, metric) &&
+               kmeans::detail::canFuseAssignUpdate<DataT>(metric, n_features);
+
   // stores (key, value) pair corresponding to each sample where
   //   - key is the index of nearest cluster
   //   - value is the distance to the nearest cluster
@@ -60,7 +71,8 @@ void fit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
 
   // temporary buffer to store distance matrix, destructor releases the resource
   Tensor<DataT, 2, IndexT> pairwiseDistance(
-    {dataBatchSize, n_clusters}, handle.getDeviceAllocator(), stream);
+    {fused ? 1 : dataBatchSize, n_clusters}, handle.getDeviceAllocator(),
+    stream);
 
   // temporary buffer to store intermediate centroids, destructor releases the
   // resource
@@ -72,6 +84,10 @@ void fit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
   Tensor<int, 1, IndexT> sampleCountInCluster(
     {n_clusters}, handle.getDeviceAllocator(), stream);
 
+  // total weight of the samples of each cluster, when they are weighted
+  Tensor<DataT, 1, IndexT> weightInCluster({n_clusters},
+                                           handle.getDeviceAllocator(), stream);
+
   cub::KeyValuePair<IndexT, DataT> *clusterCostD =
     (cub::KeyValuePair<IndexT, DataT> *)handle.getDeviceAllocator()->allocate(
       sizeof(cub::KeyValuePair<IndexT, DataT>), stream);
@@ -83,6 +99,7 @@ void fit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
 
   DataT priorClusteringCost = 0;
   for (n_iter = 0; n_iter < params.max_iter; ++n_iter) {
+    ML::nvtxRange iteration("Trace::KMeans::Iteration", n_iter);
     LOG(params.verbose,
         "KMeans.fit: Iteration-%d: fitting the model using the initialized "
         "cluster centers\n",
@@ -91,86 +108,45 @@ void fit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
     auto centroids = std::move(Tensor<DataT, 2, IndexT>(
       centroidsRawData.data(), {n_clusters, n_features}));
 
-    // computes minClusterAndDistance[0:n_samples) where
-    // minClusterAndDistance[i] is a <key, value> pair where
-    //   'key' is index to an sample in 'centroids' (index of the nearest
-    //   centroid) and 'value' is the distance between the sample 'X[i]' and the
-    //   'centroid[key]'
-    kmeans::detail::minClusterAndDistance(
-      handle, params, X, centroids, pairwiseDistance, minClusterAndDistance,
-      workspace, metric, stream);
-
-    // Using TransformInputIteratorT to dereference an array of
-    // cub::KeyValuePair and converting them to just return the Key to be used
-    // in reduce_rows_by_key prims
-    kmeans::detail::KeyValueIndexOp<IndexT, DataT> conversion_op;
-    cub::TransformInputIterator<IndexT,
-                                kmeans::detail::KeyValueIndexOp<IndexT, DataT>,
-                                cub::KeyValuePair<IndexT, DataT> *>
-      itr(minClusterAndDistance.data(), conversion_op);
-
-    workspace.resize(n_samples, stream);
-
-    // Calculates sum of all the samples assigned to cluster-i and store the
-    // result in newCentroids[i]
-    MLCommon::LinAlg::reduce_rows_by_key(
-      X.data(), X.getSize(1), itr, workspace.data(), X.getSize(0), X.getSize(1),
-      n_clusters, newCentroids.data(), stream);
-
-    // count # of samples in each cluster
-    kmeans::detail::countLabels(handle, itr, sampleCountInCluster.data(),
-                                n_samples, n_clusters, workspace, stream);
-
-    // Computes newCentroids[i] = newCentroids[i]/sampleCountInCluster[i] where
-    //   newCentroids[n_samples x n_features] - 2D array, newCentroids[i] has
-    //   sum of all the samples assigned to cluster-i
-    //   sampleCountInCluster[n_clusters] - 1D array, sampleCountInCluster[i]
-    //   contains # of samples in cluster-i.
-    // Note - when sampleCountInCluster[i] is 0, newCentroid[i] is reset to 0
-
-    // transforms int values in sampleCountInCluster to its inverse and more
-    // importantly to DataT because matrixVectorOp supports only when matrix and
-    // vector are of same type
-    workspace.resize(sampleCountInCluster.numElements() * sizeof(DataT),
-                     stream);
-    auto sampleCountInClusterInverse = std::move(
-      Tensor<DataT, 1, IndexT>((DataT *)workspace.data(), {n_clusters}));
-
-    ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
-    auto execution_policy = thrust::cuda::par(alloc).on(stream);
-    thrust::transform(
-      execution_policy, sampleCountInCluster.begin(),
-      sampleCountInCluster.end(), sampleCountInClusterInverse.begin(),
-      [=] __device__(int count) {
-        if (count == 0)
-          return static_cast<DataT>(0);
-        else
-          return static_cast<DataT>(1.0) / static_cast<DataT>(count);
-      });
-
-    MLCommon::LinAlg::matrixVectorOp(
-      newCentroids.data(), newCentroids.data(),
-      sampleCountInClusterInverse.data(), newCentroids.getSize(1),
-      newCentroids.getSize(0), true, false,
-      [=] __device__(DataT mat, DataT vec) { return mat * vec; }, stream);
-
-    // copy the centroids[i] to newCentroids[i] when sampleCountInCluster[i] is
-    // 0
-    cub::ArgIndexInputIterator<int *> itr_sc(sampleCountInCluster.data());
-    MLCommon::Matrix::gather_if(
-      centroids.data(), centroids.getSize(1), centroids.getSize(0), itr_sc,
-      itr_sc, sampleCountInCluster.numElements(), newCentroids.data(),
-      [=] __device__(cub::KeyValuePair<ptrdiff_t, int> map) {  // predicate
-        // copy when the # of samples in the cluster is 0
-        if (map.value == 0)
-          return true;
-        else
-          return false;
-      },
-      [=] __device__(cub::KeyValuePair<ptrdiff_t, int> map) {  // map
-        return map.key;
-      },
-      stream);
+    if (fused) {
+      kmeans::detail::fusedAssignUpdate(
+        handle, X, centroids, minClusterAndDistance, newCentroids,
+        sampleCountInCluster, workspace, metric, stream);
+    } else {
+      // computes minClusterAndDistance[0:n_samples) where
+      // minClusterAndDistance[i] is a <key, value> pair where
+      //   'key' is index to an sample in 'centroids' (index of the nearest
+      //   centroid) and 'value' is the distance between the sample 'X[i]' and
+      //   the 'centroid[key]'
+      kmeans::detail::minClusterAndDistance(
+        handle, params, X, centroids, pairwiseDistance, minClusterAndDistance,
+        workspace, metric, stream);
+
+      // Using TransformInputIteratorT to dereference an array of
+      // cub::KeyValuePair and converting them to just return the Key to be
+      // used in reduce_rows_by_key prims
+      kmeans::detail::KeyValueIndexOp<IndexT, DataT> conversion_op;
+      cub::TransformInputIterator<
+        IndexT, kmeans::detail::KeyValueIndexOp<IndexT, DataT>,
+        cub::KeyValuePair<IndexT, DataT> *>
+        itr(minClusterAndDistance.data(), conversion_op);
+
+      // Calculates newCentroids[i] as the mean of the samples assigned to
+      // cluster-i, or centroids[i] when cluster-i has no samples
+      if (sampleWeight != nullptr) {
+        kmeans::detail::computeWeightedCentroidSums(
+          handle, X, sampleWeight, itr, newCentroids, weightInCluster,
+          workspace, stream);
+        kmeans::detail::computeCentroidMeans(
+          handle, centroids, newCentroids, weightInCluster, workspace, stream);
+        kmeans::detail::applySampleWeights(handle, minClusterAndDistance,
+                                           sampleWeight, stream);
+      } else {
+        kmeans::detail::updateCentroids(handle, X, centroids, itr,
+                                        newCentroids, sampleCountInCluster,
+                                        workspace, stream);
+      }
+    }
 
     // compute the squared norm between the newCentroids and the original
     // centroids, destructor releases the resource
@@ -248,6 +224,330 @@ void fit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
     clusterCostD, sizeof(cub::KeyValuePair<IndexT, DataT>), stream);
 }
 
+/*
+ * @brief Mini-batch k-means: every iteration only assigns 'batch_size'
+ * samples drawn at random from X, and moves each center towards the mean of
+ * its samples in the batch with the per-center learning rate
+ * (# samples of the batch) / (# samples assigned to the center so far).
+
+ * @note  This is the algorithm described in
+ *        "Web-Scale K-Means Clustering", 2010, D. Sculley,
+ *        https://dl.acm.org/citation.cfm?id=1772862
+
+ * The fit stops after 'max_iter' batches, or when the exponentially weighted
+ * average of the batch inertias did not improve by a relative 'tol' for
+ * 'max_no_improvement' consecutive batches. The inertia returned is the one
+ * of all the samples of X.
+ */
+template <typename DataT, typename IndexT>
+void fitMiniBatch(const ML::cumlHandle_impl &handle,
+                  const KMeansParams &params, Tensor<DataT, 2, IndexT> &X,
+                  MLCommon::device_buffer<DataT> &centroidsRawData,
+                  DataT &inertia, int &n_iter,
+                  MLCommon::device_buffer<char> &workspace) {
+  cudaStream_t stream = handle.getStream();
+  auto n_samples = X.getSize(0);
+  auto n_features = X.getSize(1);
+  auto n_clusters = params.n_clusters;
+
+  MLCommon::Distance::DistanceType metric =
+    static_cast<MLCommon::Distance::DistanceType>(params.metric);
+
+  auto batchSize = kmeans::detail::getDataBatchSize(params, n_samples);
+
+  MLCommon::Random::Rng rng(params.seed,
+                            MLCommon::Random::GeneratorType::GenPhilox);
+
+  // temporary buffers holding the samples of the current batch and their
+  // indices in X, destructor releases the resource
+  Tensor<DataT, 2, IndexT> batch({batchSize, n_features},
+                                 handle.getDeviceAllocator(), stream);
+  Tensor<IndexT, 1, IndexT> batchIndices({batchSize},
+                                         handle.getDeviceAllocator(), stream);
+
+  // stores (key, value) pair corresponding to each sample of the batch where
+  //   - key is the index of nearest cluster
+  //   - value is the distance to the nearest cluster
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> minClusterAndDistance(
+    {batchSize}, handle.getDeviceAllocator(), stream);
+
+  // temporary buffer to store distance matrix, destructor releases the resource
+  Tensor<DataT, 2, IndexT> pairwiseDistance(
+    {batchSize, n_clusters}, handle.getDeviceAllocator(), stream);
+
+  // sum and count of the samples of the batch in each cluster
+  Tensor<DataT, 2, IndexT> batchSums({n_clusters, n_features},
+                                     handle.getDeviceAllocator(), stream);
+  Tensor<int, 1, IndexT> batchCounts({n_clusters}, handle.getDeviceAllocator(),
+                                     stream);
+
+  // # of samples assigned to each cluster over all the batches so far
+  Tensor<DataT, 1, IndexT> clusterCounts({n_clusters},
+                                         handle.getDeviceAllocator(), stream);
+
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  thrust::fill(execution_policy, clusterCounts.begin(), clusterCounts.end(),
+               (DataT)0);
+
+  cub::KeyValuePair<IndexT, DataT> *clusterCostD =
+    (cub::KeyValuePair<IndexT, DataT> *)handle.getDeviceAllocator()->allocate(
+      sizeof(cub::KeyValuePair<IndexT, DataT>), stream);
+
+  auto centroids = std::move(Tensor<DataT, 2, IndexT>(
+    centroidsRawData.data(), {n_clusters, n_features}));
+
+  LOG(params.verbose,
+      "Calling KMeans.fit with %d samples of input data in mini-batches of %d "
+      "samples\n",
+      n_samples, batchSize);
+
+  // weight of a batch in the average inertia, as it is done in scikit-learn
+  DataT alpha = std::min((DataT)1, (DataT)2 * batchSize / (n_samples + 1));
+  DataT ewaInertia = 0, minEwaInertia = 0;
+  int noImprovement = 0;
+  for (n_iter = 0; n_iter < params.max_iter; ++n_iter) {
+    ML::nvtxRange iteration("Trace::KMeans::Iteration", n_iter);
+    kmeans::detail::sampleWithReplacement(handle, X, batch, batchIndices, rng,
+                                          stream);
+
+    kmeans::detail::minClusterAndDistance(
+      handle, params, batch, centroids, pairwiseDistance, minClusterAndDistance,
+      workspace, metric, stream);
+
+    kmeans::detail::KeyValueIndexOp<IndexT, DataT> conversion_op;
+    cub::TransformInputIterator<IndexT,
+                                kmeans::detail::KeyValueIndexOp<IndexT, DataT>,
+                                cub::KeyValuePair<IndexT, DataT> *>
+      itr(minClusterAndDistance.data(), conversion_op);
+
+    workspace.resize(batchSize, stream);
+
+    // Calculates sum of all the samples of the batch assigned to cluster-i and
+    // store the result in batchSums[i]
+    MLCommon::LinAlg::reduce_rows_by_key(
+      batch.data(), n_features, itr, workspace.data(), batchSize, n_features,
+      n_clusters, batchSums.data(), stream);
+
+    kmeans::detail::countLabels(handle, itr, batchCounts.data(), batchSize,
+                                n_clusters, workspace, stream);
+
+    // Moving the center by 1 / count towards each of its samples, one at a
+    // time, is moving it towards the mean of its nb samples of the batch by
+    // nb / count
+    kmeans::detail::updateCentroidsIncrementally(
+      handle, batchSums, batchCounts, centroids, clusterCounts, stream);
+
+    // calculate the cost of the batch
+    kmeans::detail::computeClusterCost(
+      handle, minClusterAndDistance, workspace, clusterCostD,
+      [] __device__(const cub::KeyValuePair<IndexT, DataT> &a,
+                    const cub::KeyValuePair<IndexT, DataT> &b) {
+        cub::KeyValuePair<IndexT, DataT> res;
+        res.key = 0;
+        res.value = a.value + b.value;
+        return res;
+      },
+      stream);
+
+    DataT batchInertia = 0;
+    MLCommon::copy(&batchInertia, &clusterCostD->value, 1, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    batchInertia /= batchSize;
+
+    if (n_iter == 0) {
+      ewaInertia = batchInertia;
+      minEwaInertia = batchInertia;
+    } else {
+      ewaInertia = ewaInertia * (1 - alpha) + batchInertia * alpha;
+    }
+
+    LOG(params.verbose,
+        "KMeans.fit: Iteration-%d: mini-batch inertia %g, average %g\n",
+        n_iter, batchInertia, ewaInertia);
+
+    if (ewaInertia < minEwaInertia * (1 - params.tol)) {
+      noImprovement = 0;
+      minEwaInertia = ewaInertia;
+    } else if (n_iter > 0 && ++noImprovement >= params.max_no_improvement) {
+      LOG(params.verbose,
+          "No improvement of the inertia after %d iterations. Terminating "
+          "early.\n",
+          n_iter);
+      break;
+    }
+  }
+
+  // calculate cluster cost phi_x(C) of all the samples, one batch at a time
+  inertia = kmeans::detail::computeClusterCostInBatches(
+    handle, params, X, centroids, pairwiseDistance, minClusterAndDistance,
+    clusterCostD, workspace, metric, stream);
+
+  handle.getDeviceAllocator()->deallocate(
+    clusterCostD, sizeof(cub::KeyValuePair<IndexT, DataT>), stream);
+}
+
+/*
+ * @brief Lloyd's k-means with Hamerly's bounds: every sample keeps an upper
+ * bound of its distance to its centroid and a lower bound of its distance to
+ * the other centroids, updated with the distances the centroids move by, so
+ * that only the samples whose bounds overlap are compared again with all the
+ * centroids. Late iterations, where few samples move, then cost O(n_samples)
+ * instead of O(n_samples x n_clusters) distance computations.
+
+ * @note  This is the algorithm described in
+ *        "Making k-means even faster", 2010, Greg Hamerly,
+ *        https://doi.org/10.1137/1.9781611972801.12
+
+ * The bounds are Euclidean distances, so the metric must be one of the L2
+ * distances, which all have the same nearest centroids.
+ */
+template <typename DataT, typename IndexT>
+void fitHamerly(const ML::cumlHandle_impl &handle, const KMeansParams &params,
+                Tensor<DataT, 2, IndexT> &X,
+                MLCommon::device_buffer<DataT> &centroidsRawData,
+                DataT &inertia, int &n_iter,
+                MLCommon::device_buffer<char> &workspace) {
+  cudaStream_t stream = handle.getStream();
+  auto n_samples = X.getSize(0);
+  auto n_features = X.getSize(1);
+  auto n_clusters = params.n_clusters;
+
+  MLCommon::Distance::DistanceType metric =
+    static_cast<MLCommon::Distance::DistanceType>(params.metric);
+  ASSERT(metric == MLCommon::Distance::EucExpandedL2 ||
+           metric == MLCommon::Distance::EucExpandedL2Sqrt ||
+           metric == MLCommon::Distance::EucUnexpandedL2 ||
+           metric == MLCommon::Distance::EucUnexpandedL2Sqrt,
+         "Hamerly's k-means requires a Euclidean metric");
+
+  auto dataBatchSize = kmeans::detail::getDataBatchSize(params, n_samples);
+
+  // labels and bounds of the samples, and the samples to assign again,
+  // destructor releases the resource
+  Tensor<IndexT, 1, IndexT> labels({n_samples}, handle.getDeviceAllocator(),
+                                   stream);
+  Tensor<DataT, 1, IndexT> upper({n_samples}, handle.getDeviceAllocator(),
+                                 stream);
+  Tensor<DataT, 1, IndexT> lower({n_samples}, handle.getDeviceAllocator(),
+                                 stream);
+  Tensor<int, 1, IndexT> needsUpdate({n_samples}, handle.getDeviceAllocator(),
+                                     stream);
+  Tensor<IndexT, 1, IndexT> updateIndices({n_samples},
+                                          handle.getDeviceAllocator(), stream);
+
+  // temporary buffers to store a batch of samples to assign again and their
+  // distance matrix
+  Tensor<DataT, 2, IndexT> batch({dataBatchSize, n_features},
+                                 handle.getDeviceAllocator(), stream);
+  Tensor<DataT, 2, IndexT> pairwiseDistance(
+    {dataBatchSize, n_clusters}, handle.getDeviceAllocator(), stream);
+
+  // distances between the centroids and their shifts during an iteration
+  Tensor<DataT, 2, IndexT> centroidDistance(
+    {n_clusters, n_clusters}, handle.getDeviceAllocator(), stream);
+  Tensor<DataT, 1, IndexT> halfMinDistance({n_clusters},
+                                           handle.getDeviceAllocator(), stream);
+  Tensor<DataT, 1, IndexT> shift({n_clusters}, handle.getDeviceAllocator(),
+                                 stream);
+
+  // temporary buffer to store intermediate centroids, destructor releases the
+  // resource
+  Tensor<DataT, 2, IndexT> newCentroids({n_clusters, n_features},
+                                        handle.getDeviceAllocator(), stream);
+
+  // temporary buffer to store the sample count per cluster, destructor releases
+  // the resource
+  Tensor<int, 1, IndexT> sampleCountInCluster(
+    {n_clusters}, handle.getDeviceAllocator(), stream);
+
+  auto centroids = std::move(Tensor<DataT, 2, IndexT>(
+    centroidsRawData.data(), {n_clusters, n_features}));
+
+  // all the samples are assigned in the first iteration
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  thrust::fill(execution_policy, needsUpdate.begin(), needsUpdate.end(), 1);
+
+  LOG(params.verbose,
+      "Calling KMeans.fit with %d samples of input data and the initialized "
+      "cluster centers, using Hamerly's bounds\n",
+      n_samples);
+
+  for (n_iter = 0; n_iter < params.max_iter; ++n_iter) {
+    ML::nvtxRange iteration("Trace::KMeans::Iteration", n_iter);
+    if (n_iter > 0) {
+      DataT maxShift =
+        thrust::reduce(execution_policy, shift.begin(), shift.end(), (DataT)0,
+                       thrust::maximum<DataT>());
+      kmeans::detail::hamerlyBounds(X, centroids, labels, shift, maxShift,
+                                    halfMinDistance, upper, lower, needsUpdate,
+                                    stream);
+    }
+
+    IndexT n_assigned = kmeans::detail::hamerlyAssign(
+      handle, X, centroids, needsUpdate, updateIndices, batch,
+      pairwiseDistance, labels, upper, lower, workspace, stream);
+
+    LOG(params.verbose,
+        "KMeans.fit: Iteration-%d: %d samples compared with all the cluster "
+        "centers\n",
+        n_iter, n_assigned);
+
+    // Calculates newCentroids[i] as the mean of the samples assigned to
+    // cluster-i, or centroids[i] when cluster-i has no samples
+    kmeans::detail::updateCentroids(handle, X, centroids, labels.data(),
+                                    newCentroids, sampleCountInCluster,
+                                    workspace, stream);
+
+    // shift[i] = ||newCentroids[i] - centroids[i]||, the squared norm between
+    // the newCentroids and the original centroids is the sum of shift[i]^2;
+    // the differences are stored in centroids, which is then overwritten by
+    // newCentroids
+    MLCommon::LinAlg::binaryOp(
+      centroids.data(), newCentroids.data(), centroids.data(),
+      centroids.numElements(),
+      [] __device__(DataT a, DataT b) { return a - b; }, stream);
+    MLCommon::LinAlg::rowNorm(
+      shift.data(), centroids.data(), n_features, n_clusters,
+      MLCommon::LinAlg::L2Norm, true, stream,
+      [] __device__(DataT in, IndexT i) { return MLCommon::mySqrt(in); });
+    DataT sqrdNormError = thrust::transform_reduce(
+      execution_policy, shift.begin(), shift.end(),
+      [] __device__(DataT s) { return s * s; }, (DataT)0,
+      thrust::plus<DataT>());
+
+    MLCommon::copy(centroidsRawData.data(), newCentroids.data(),
+                   newCentroids.numElements(), stream);
+
+    kmeans::detail::hamerlyHalfMinDistance(handle, centroids, centroidDistance,
+                                           halfMinDistance, workspace, stream);
+
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    if (sqrdNormError < params.tol) {
+      LOG(params.verbose,
+          "Threshold triggered after %d iterations. Terminating early.\n",
+          n_iter);
+      break;
+    }
+  }
+
+  // the bounds are not distances, so the cost is computed again from the
+  // final centroids
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> minClusterAndDistance(
+    {dataBatchSize}, handle.getDeviceAllocator(), stream);
+  cub::KeyValuePair<IndexT, DataT> *clusterCostD =
+    (cub::KeyValuePair<IndexT, DataT> *)handle.getDeviceAllocator()->allocate(
+      sizeof(cub::KeyValuePair<IndexT, DataT>), stream);
+
+  inertia = kmeans::detail::computeClusterCostInBatches(
+    handle, params, X, centroids, pairwiseDistance, minClusterAndDistance,
+    clusterCostD, workspace, metric, stream);
+
+  handle.getDeviceAllocator()->deallocate(
+    clusterCostD, sizeof(cub::KeyValuePair<IndexT, DataT>), stream);
+}
+
 /*
  * @brief Selects 'n_clusters' samples from X using scalable kmeans++ algorithm.
 
@@ -348,6 +648,18 @@ void initKMeansPlusPlus(const ML::cumlHandle_impl &handle,
   DataT psi = 0;
   MLCommon::copy(&psi, clusterCost.data(), clusterCost.size(), stream);
 
+  // index of the potential centroid nearest to each sample, all samples are
+  // closest to the initial centroid at this point
+  Tensor<IndexT, 1, IndexT> nearestCentroid(
+    {n_samples}, handle.getDeviceAllocator(), stream);
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> newClusterAndDistance(
+    {n_samples}, handle.getDeviceAllocator(), stream);
+
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  thrust::fill(execution_policy, nearestCentroid.begin(), nearestCentroid.end(),
+               0);
+
   // <<< End of Step-2 >>>
 
   // Scalable kmeans++ paper claims 8 rounds is sufficient
@@ -362,22 +674,6 @@ void initKMeansPlusPlus(const ML::cumlHandle_impl &handle,
         "KMeans|| - Iteration %d: # potential centroids sampled - %d\n", iter,
         potentialCentroids.getSize(0));
 
-    pairwiseDistanceRaw.resize(dataBatchSize * potentialCentroids.getSize(0),
-                               stream);
-    Tensor<DataT, 2, IndexT> pairwiseDistance(
-      (DataT *)pairwiseDistanceRaw.data(),
-      {dataBatchSize, potentialCentroids.getSize(0)});
-
-    kmeans::detail::minClusterDistance(handle, params, X, potentialCentroids,
-                                       pairwiseDistance, minClusterDistance,
-                                       workspace, metric, stream);
-
-    kmeans::detail::computeClusterCost(
-      handle, minClusterDistance, workspace, clusterCost.data(),
-      [] __device__(const DataT &a, const DataT &b) { return a + b; }, stream);
-
-    MLCommon::copy(&psi, clusterCost.data(), clusterCost.size(), stream);
-    CUDA_CHECK(cudaStreamSynchronize(stream));
     // <<<< Step-4 >>> : Sample each point x in X independently and identify new
     // potentialCentroids
     rng.uniform(uniformRands.data(), uniformRands.getSize(0), (DataT)0,
@@ -398,10 +694,45 @@ void initKMeansPlusPlus(const ML::cumlHandle_impl &handle,
     MLCommon::copy(centroidsBuf.end() - Cp.numElements(), Cp.data(),
                    Cp.numElements(), stream);
 
-    int tot_centroids = potentialCentroids.getSize(0) + Cp.getSize(0);
+    IndexT offset = potentialCentroids.getSize(0);
+    int tot_centroids = offset + Cp.getSize(0);
     potentialCentroids = std::move(Tensor<DataT, 2, IndexT>(
       centroidsBuf.data(), {tot_centroids, n_features}));
     /// <<<< End of Step-5 >>>
+
+    if (Cp.getSize(0) == 0) continue;
+
+    // phi_X (C) only changes by the distances to the newly added candidates,
+    // so the running minimum is merged with the nearest of them instead of
+    // being recomputed against all the potential centroids
+    pairwiseDistanceRaw.resize(dataBatchSize * Cp.getSize(0), stream);
+    Tensor<DataT, 2, IndexT> pairwiseDistance(
+      (DataT *)pairwiseDistanceRaw.data(), {dataBatchSize, Cp.getSize(0)});
+
+    kmeans::detail::minClusterAndDistance(
+      handle, params, X, Cp, pairwiseDistance, newClusterAndDistance, workspace,
+      metric, stream);
+
+    DataT *minDistance = minClusterDistance.data();
+    IndexT *nearest = nearestCentroid.data();
+    const cub::KeyValuePair<IndexT, DataT> *newNearest =
+      newClusterAndDistance.data();
+    thrust::for_each(
+      execution_policy, thrust::make_counting_iterator<IndexT>(0),
+      thrust::make_counting_iterator<IndexT>(n_samples),
+      [=] __device__(IndexT i) {
+        if (newNearest[i].value < minDistance[i]) {
+          minDistance[i] = newNearest[i].value;
+          nearest[i] = offset + newNearest[i].key;
+        }
+      });
+
+    kmeans::detail::computeClusterCost(
+      handle, minClusterDistance, workspace, clusterCost.data(),
+      [] __device__(const DataT &a, const DataT &b) { return a + b; }, stream);
+
+    MLCommon::copy(&psi, clusterCost.data(), clusterCost.size(), stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
   }  /// <<<< Step-6 >>>
 
   LOG(params.verbose, "KMeans||: total # potential centroids sampled - %d\n",
@@ -414,8 +745,10 @@ void initKMeansPlusPlus(const ML::cumlHandle_impl &handle,
     Tensor<int, 1, IndexT> weights({potentialCentroids.getSize(0)},
                                    handle.getDeviceAllocator(), stream);
 
-    kmeans::detail::countSamplesInCluster(handle, params, X, potentialCentroids,
-                                          workspace, metric, weights, stream);
+    // the nearest candidate of every sample is tracked across the rounds
+    kmeans::detail::countLabels(handle, nearestCentroid.data(), weights.data(),
+                                n_samples, potentialCentroids.getSize(0),
+                                workspace, stream);
 
     // <<< end of Step-7 >>>
 
@@ -466,7 +799,11 @@ void initKMeansPlusPlus(const ML::cumlHandle_impl &handle,
 template <typename DataT, typename IndexT = int>
 void fit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
          const DataT *X, const int n_local_samples, const int n_features,
-         DataT *centroids, DataT &inertia, int &n_iter) {
+         DataT *centroids, DataT &inertia, int &n_iter,
+         const DataT *sample_weight = nullptr) {
+  ML::detail::phaseScope range(handle, "ML::KMeans::Fit",
+                               "rows=%d cols=%d k=%d", n_local_samples,
+                               n_features, params.n_clusters);
   cudaStream_t stream = handle.getStream();
 
   ASSERT(n_local_samples > 0, "# of samples must be > 0");
@@ -478,6 +815,15 @@ void fit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
   ASSERT(memory_type(X) == cudaMemoryTypeDevice,
          "input data must be device accessible");
 
+  ASSERT(params.algorithm == KMeansParams::Algorithm::Lloyd ||
+           params.algorithm == KMeansParams::Algorithm::MiniBatch ||
+           params.algorithm == KMeansParams::Algorithm::Hamerly,
+         "unknown k-means algorithm");
+
+  ASSERT(sample_weight == nullptr ||
+           params.algorithm == KMeansParams::Algorithm::Lloyd,
+         "sample weights are only supported by Lloyd's algorithm");
+
   Tensor<DataT, 2, IndexT> data((DataT *)X, {n_local_samples, n_features});
 
   // underlying expandable storage that holds centroids data
@@ -493,6 +839,25 @@ void fit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
         "KMeans.fit: initialize cluster centers by randomly choosing from the "
         "input data.\n");
     initRandom(handle, params, data, centroidsRawData);
+  } else if (params.init == KMeansParams::InitMethod::KMeansPlusPlus &&
+             params.algorithm == KMeansParams::Algorithm::MiniBatch &&
+             n_local_samples > 3 * params.batch_size) {
+    // mini-batch k-means does not pass over all the samples, so neither does
+    // its initialization
+    LOG(params.verbose,
+        "KMeans.fit: initialize cluster centers using k-means++ algorithm on "
+        "%d random samples.\n",
+        3 * params.batch_size);
+    MLCommon::Random::Rng rng(params.seed,
+                              MLCommon::Random::GeneratorType::GenPhilox);
+    Tensor<DataT, 2, IndexT> initSample({3 * params.batch_size, n_features},
+                                        handle.getDeviceAllocator(), stream);
+    Tensor<IndexT, 1, IndexT> initIndices({3 * params.batch_size},
+                                          handle.getDeviceAllocator(), stream);
+    kmeans::detail::sampleWithReplacement(handle, data, initSample,
+                                          initIndices, rng, stream);
+    initKMeansPlusPlus(handle, params, initSample, centroidsRawData,
+                       workspace);
   } else if (params.init == KMeansParams::InitMethod::KMeansPlusPlus) {
     // default method to initialize is kmeans++
     LOG(params.verbose,
@@ -515,16 +880,501 @@ void fit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
     THROW("unknown initialization method to select initial centers");
   }
 
-  fit(handle, params, data, centroidsRawData, inertia, n_iter, workspace);
+  if (params.algorithm == KMeansParams::Algorithm::MiniBatch)
+    fitMiniBatch(handle, params, data, centroidsRawData, inertia, n_iter,
+                 workspace);
+  else if (params.algorithm == KMeansParams::Algorithm::Hamerly)
+    fitHamerly(handle, params, data, centroidsRawData, inertia, n_iter,
+               workspace);
+  else
+    fit(handle, params, data, centroidsRawData, inertia, n_iter, workspace,
+        sample_weight);
+
+  MLCommon::copy(centroids, centroidsRawData.data(),
+                 params.n_clusters * n_features, stream);
+}
+
+/*
+ * @brief Selects 'n_clusters' samples of a CSR matrix with the k-means++
+ * algorithm, each sample being drawn with a probability proportional to its
+ * distance to the nearest centroid already selected, times its weight.
+
+ * Every centroid costs one pass over X, the distances of which only involve
+ * the new centroid.
+ */
+template <typename DataT, typename IndexT>
+void initSparseKMeansPlusPlus(const ML::cumlHandle_impl &handle,
+                              const KMeansParams &params,
+                              const kmeans::detail::CsrInput<DataT> &X,
+                              const DataT *sampleNorms,
+                              const DataT *sampleWeight,
+                              MLCommon::device_buffer<DataT> &centroidsRawData,
+                              MLCommon::device_buffer<char> &workspace) {
+  cudaStream_t stream = handle.getStream();
+  IndexT n_samples = X.n_rows;
+  IndexT n_features = X.n_cols;
+  auto n_clusters = params.n_clusters;
+  MLCommon::Distance::DistanceType metric =
+    static_cast<MLCommon::Distance::DistanceType>(params.metric);
+
+  centroidsRawData.resize(n_clusters * n_features, stream);
+  auto centroids = std::move(Tensor<DataT, 2, IndexT>(
+    centroidsRawData.data(), {n_clusters, n_features}));
+
+  auto dataBatchSize = kmeans::detail::getDataBatchSize(params, n_samples);
+  Tensor<DataT, 2, IndexT> pairwiseDistance(
+    {dataBatchSize, 1}, handle.getDeviceAllocator(), stream);
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> newClusterAndDistance(
+    {n_samples}, handle.getDeviceAllocator(), stream);
+  Tensor<DataT, 1, IndexT> minClusterDistance(
+    {n_samples}, handle.getDeviceAllocator(), stream);
+  Tensor<DataT, 1, IndexT> cumProb({n_samples}, handle.getDeviceAllocator(),
+                                   stream);
+
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  thrust::fill(execution_policy, minClusterDistance.begin(),
+               minClusterDistance.end(), std::numeric_limits<DataT>::max());
+
+  // the first centroid is a sample drawn uniformly at random
+  std::mt19937 gen(params.seed);
+  std::uniform_int_distribution<int64_t> dis(0, n_samples - 1);
+  int64_t cIdx = dis(gen);
+
+  for (int c = 0; c < n_clusters; ++c) {
+    LOG(params.verbose, "KMeans++ - Iteraton %d/%d\n", c, n_clusters);
+    auto centroid = centroids.template view<2>({1, n_features}, {c, 0});
+    kmeans::detail::sparseGatherRows(handle, X, {cIdx}, centroid, stream);
+    if (c == n_clusters - 1) break;
+
+    kmeans::detail::sparseMinClusterAndDistance(
+      handle, params, X, sampleNorms, centroid, pairwiseDistance,
+      newClusterAndDistance, workspace, metric, stream);
+    thrust::transform(
+      execution_policy, minClusterDistance.begin(), minClusterDistance.end(),
+      newClusterAndDistance.begin(), minClusterDistance.begin(),
+      [=] __device__(DataT d, cub::KeyValuePair<IndexT, DataT> pair) {
+        return pair.value < d ? pair.value : d;
+      });
+
+    // the next centroid is drawn from the cumulative weighted distances
+    if (sampleWeight != nullptr) {
+      thrust::transform(execution_policy, minClusterDistance.begin(),
+                        minClusterDistance.end(), sampleWeight,
+                        cumProb.begin(), thrust::multiplies<DataT>());
+    } else {
+      thrust::copy(execution_policy, minClusterDistance.begin(),
+                   minClusterDistance.end(), cumProb.begin());
+    }
+    thrust::inclusive_scan(execution_policy, cumProb.begin(), cumProb.end(),
+                           cumProb.begin());
+
+    DataT totalProb = 0;
+    MLCommon::copy(&totalProb, cumProb.data() + n_samples - 1, 1, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+
+    if (totalProb > 0) {
+      std::uniform_real_distribution<DataT> pick(0, totalProb);
+      DataT r = pick(gen);
+      cIdx = thrust::upper_bound(execution_policy, cumProb.begin(),
+                                 cumProb.end(), r) -
+             cumProb.begin();
+      cIdx = std::min<int64_t>(cIdx, n_samples - 1);
+    } else {
+      cIdx = dis(gen);
+    }
+  }
+}
+
+// Lloyd's algorithm on the samples of a CSR matrix; the distances come from
+// sparse-dense products and the centroids stay dense
+template <typename DataT, typename IndexT>
+void fitSparse(const ML::cumlHandle_impl &handle, const KMeansParams &params,
+               const kmeans::detail::CsrInput<DataT> &X,
+               const DataT *sampleNorms, const DataT *sampleWeight,
+               MLCommon::device_buffer<DataT> &centroidsRawData,
+               DataT &inertia, int &n_iter,
+               MLCommon::device_buffer<char> &workspace) {
+  cudaStream_t stream = handle.getStream();
+  IndexT n_samples = X.n_rows;
+  IndexT n_features = X.n_cols;
+  auto n_clusters = params.n_clusters;
+
+  MLCommon::Distance::DistanceType metric =
+    static_cast<MLCommon::Distance::DistanceType>(params.metric);
+
+  auto dataBatchSize = kmeans::detail::getDataBatchSize(params, n_samples);
+
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> minClusterAndDistance(
+    {n_samples}, handle.getDeviceAllocator(), stream);
+  Tensor<DataT, 2, IndexT> pairwiseDistance(
+    {dataBatchSize, n_clusters}, handle.getDeviceAllocator(), stream);
+  Tensor<DataT, 2, IndexT> newCentroids({n_clusters, n_features},
+                                        handle.getDeviceAllocator(), stream);
+  Tensor<DataT, 1, IndexT> weightInCluster({n_clusters},
+                                           handle.getDeviceAllocator(), stream);
+
+  cub::KeyValuePair<IndexT, DataT> *clusterCostD =
+    (cub::KeyValuePair<IndexT, DataT> *)handle.getDeviceAllocator()->allocate(
+      sizeof(cub::KeyValuePair<IndexT, DataT>), stream);
+
+  LOG(params.verbose,
+      "Calling KMeans.fit with %d sparse samples of input data and the "
+      "initialized cluster centers\n",
+      n_samples);
+
+  DataT priorClusteringCost = 0;
+  for (n_iter = 0; n_iter < params.max_iter; ++n_iter) {
+    ML::nvtxRange iteration("Trace::KMeans::Iteration", n_iter);
+    LOG(params.verbose,
+        "KMeans.fit: Iteration-%d: fitting the model using the initialized "
+        "cluster centers\n",
+        n_iter);
+
+    auto centroids = std::move(Tensor<DataT, 2, IndexT>(
+      centroidsRawData.data(), {n_clusters, n_features}));
+
+    kmeans::detail::sparseMinClusterAndDistance(
+      handle, params, X, sampleNorms, centroids, pairwiseDistance,
+      minClusterAndDistance, workspace, metric, stream);
+
+    kmeans::detail::sparseCentroidSums(X, sampleWeight, minClusterAndDistance,
+                                       newCentroids, weightInCluster, stream);
+    kmeans::detail::computeCentroidMeans(
+      handle, centroids, newCentroids, weightInCluster, workspace, stream);
+
+    if (sampleWeight != nullptr)
+      kmeans::detail::applySampleWeights(handle, minClusterAndDistance,
+                                         sampleWeight, stream);
+
+    // compute the squared norm between the newCentroids and the original
+    // centroids, destructor releases the resource
+    Tensor<DataT, 1> sqrdNorm({1}, handle.getDeviceAllocator(), stream);
+    MLCommon::LinAlg::mapThenSumReduce(
+      sqrdNorm.data(), newCentroids.numElements(),
+      [=] __device__(const DataT a, const DataT b) {
+        DataT diff = a - b;
+        return diff * diff;
+      },
+      stream, centroids.data(), newCentroids.data());
+
+    DataT sqrdNormError = 0;
+    MLCommon::copy(&sqrdNormError, sqrdNorm.data(), sqrdNorm.numElements(),
+                   stream);
+
+    MLCommon::copy(centroidsRawData.data(), newCentroids.data(),
+                   newCentroids.numElements(), stream);
+
+    bool done = false;
+    if (params.inertia_check) {
+      kmeans::detail::computeClusterCost(
+        handle, minClusterAndDistance, workspace, clusterCostD,
+        [] __device__(const cub::KeyValuePair<IndexT, DataT> &a,
+                      const cub::KeyValuePair<IndexT, DataT> &b) {
+          cub::KeyValuePair<IndexT, DataT> res;
+          res.key = 0;
+          res.value = a.value + b.value;
+          return res;
+        },
+        stream);
+
+      DataT curClusteringCost = 0;
+      MLCommon::copy(&curClusteringCost, &clusterCostD->value, 1, stream);
+
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+      ASSERT(curClusteringCost != (DataT)0.0,
+             "Too few points and centriods being found is getting 0 cost from "
+             "centers\n");
+
+      if (n_iter > 0) {
+        DataT delta = curClusteringCost / priorClusteringCost;
+        if (delta > 1 - params.tol) done = true;
+      }
+      priorClusteringCost = curClusteringCost;
+    }
+
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    if (sqrdNormError < params.tol) done = true;
+
+    if (done) {
+      LOG(params.verbose,
+          "Threshold triggered after %d iterations. Terminating early.\n",
+          n_iter);
+      break;
+    }
+  }
+
+  // calculate cluster cost phi_x(C)
+  kmeans::detail::computeClusterCost(
+    handle, minClusterAndDistance, workspace, clusterCostD,
+    [] __device__(const cub::KeyValuePair<IndexT, DataT> &a,
+                  const cub::KeyValuePair<IndexT, DataT> &b) {
+      cub::KeyValuePair<IndexT, DataT> res;
+      res.key = 0;
+      res.value = a.value + b.value;
+      return res;
+    },
+    stream);
+
+  MLCommon::copy(&inertia, &clusterCostD->value, 1, stream);
+
+  handle.getDeviceAllocator()->deallocate(
+    clusterCostD, sizeof(cub::KeyValuePair<IndexT, DataT>), stream);
+}
+
+template <typename DataT, typename IndexT = int>
+void fitSparse(const ML::cumlHandle_impl &handle, const KMeansParams &params,
+               const DataT *vals, const int *row_ind, const int *row_ind_ptr,
+               const int nnz, const int n_samples, const int n_features,
+               const DataT *sample_weight, DataT *centroids, DataT &inertia,
+               int &n_iter) {
+  ML::detail::phaseScope range(handle, "ML::KMeans::FitSparse",
+                               "rows=%d cols=%d nnz=%d k=%d", n_samples,
+                               n_features, nnz, params.n_clusters);
+  cudaStream_t stream = handle.getStream();
+
+  ASSERT(n_samples > 0, "# of samples must be > 0");
+
+  ASSERT(memory_type(vals) == cudaMemoryTypeDevice,
+         "input data must be device accessible");
+
+  ASSERT(params.algorithm == KMeansParams::Algorithm::Lloyd,
+         "sparse input is only supported by Lloyd's algorithm");
+
+  MLCommon::Distance::DistanceType metric =
+    static_cast<MLCommon::Distance::DistanceType>(params.metric);
+  ASSERT(metric == MLCommon::Distance::EucExpandedL2 ||
+           metric == MLCommon::Distance::EucExpandedL2Sqrt ||
+           metric == MLCommon::Distance::EucUnexpandedL2 ||
+           metric == MLCommon::Distance::EucUnexpandedL2Sqrt,
+         "sparse input requires a Euclidean metric");
+
+  auto X = kmeans::detail::makeCsrInput(vals, row_ind, row_ind_ptr, nnz,
+                                        n_samples, n_features, stream);
+
+  // underlying expandable storage that holds centroids data
+  MLCommon::device_buffer<DataT> centroidsRawData(handle.getDeviceAllocator(),
+                                                  stream);
+
+  // Device-accessible allocation of expandable storage used as temorary buffers
+  MLCommon::device_buffer<char> workspace(handle.getDeviceAllocator(), stream);
+
+  Tensor<DataT, 1, IndexT> sampleNorms({n_samples},
+                                       handle.getDeviceAllocator(), stream);
+  kmeans::detail::sparseRowNorms(X, sampleNorms.data(), workspace, stream);
+
+  if (params.init == KMeansParams::InitMethod::Random) {
+    LOG(params.verbose,
+        "KMeans.fit: initialize cluster centers by randomly choosing from the "
+        "input data.\n");
+    centroidsRawData.resize(params.n_clusters * n_features, stream);
+    Tensor<DataT, 2, IndexT> initCentroids(
+      centroidsRawData.data(), {params.n_clusters, n_features});
+    kmeans::detail::sparseGatherRows(
+      handle, X,
+      kmeans::detail::chooseSamples(n_samples, params.n_clusters,
+                                    params.seed),
+      initCentroids, stream);
+  } else if (params.init == KMeansParams::InitMethod::KMeansPlusPlus) {
+    LOG(params.verbose,
+        "KMeans.fit: initialize cluster centers using k-means++ algorithm.\n");
+    initSparseKMeansPlusPlus<DataT, IndexT>(handle, params, X,
+                                            sampleNorms.data(), sample_weight,
+                                            centroidsRawData, workspace);
+  } else if (params.init == KMeansParams::InitMethod::Array) {
+    LOG(params.verbose,
+        "KMeans.fit: initialize cluster centers from the ndarray array input "
+        "passed to init arguement.\n");
+
+    ASSERT(centroids != nullptr,
+           "centroids array is null (require a valid array of centroids for "
+           "the requested initialization method)");
+
+    centroidsRawData.resize(params.n_clusters * n_features, stream);
+    MLCommon::copy(centroidsRawData.begin(), centroids,
+                   params.n_clusters * n_features, stream);
+  } else {
+    THROW("unknown initialization method to select initial centers");
+  }
+
+  fitSparse<DataT, IndexT>(handle, params, X, sampleNorms.data(),
+                           sample_weight, centroidsRawData, inertia, n_iter,
+                           workspace);
 
   MLCommon::copy(centroids, centroidsRawData.data(),
                  params.n_clusters * n_features, stream);
 }
 
 template <typename DataT, typename IndexT = int>
-void predict(const ML::cumlHandle_impl &handle, const KMeansParams &params,
-             const DataT *cptr, const DataT *Xptr, const int n_samples,
-             const int n_features, IndexT *labelsRawPtr, DataT &inertia) {
+void predictSparse(const ML::cumlHandle_impl &handle,
+                   const KMeansParams &params, const DataT *cptr,
+                   const DataT *vals, const int *row_ind,
+                   const int *row_ind_ptr, const int nnz, const int n_samples,
+                   const int n_features, IndexT *labelsRawPtr,
+                   DataT &inertia) {
+  ML::detail::phaseScope range(handle, "ML::KMeans::PredictSparse",
+                               "rows=%d cols=%d nnz=%d", n_samples, n_features,
+                               nnz);
+  cudaStream_t stream = handle.getStream();
+  auto n_clusters = params.n_clusters;
+
+  ASSERT(n_clusters > 0 && cptr != nullptr, "no clusters exist");
+
+  ASSERT(memory_type(vals) == cudaMemoryTypeDevice,
+         "input data must be device accessible");
+
+  MLCommon::Distance::DistanceType metric =
+    static_cast<MLCommon::Distance::DistanceType>(params.metric);
+
+  auto X = kmeans::detail::makeCsrInput(vals, row_ind, row_ind_ptr, nnz,
+                                        n_samples, n_features, stream);
+  Tensor<DataT, 2, IndexT> centroids((DataT *)cptr, {n_clusters, n_features});
+
+  auto dataBatchSize = kmeans::detail::getDataBatchSize(params, n_samples);
+
+  // Device-accessible allocation of expandable storage used as temorary buffers
+  MLCommon::device_buffer<char> workspace(handle.getDeviceAllocator(), stream);
+
+  Tensor<DataT, 1, IndexT> sampleNorms({n_samples},
+                                       handle.getDeviceAllocator(), stream);
+  kmeans::detail::sparseRowNorms(X, sampleNorms.data(), workspace, stream);
+
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> minClusterAndDistance(
+    {n_samples}, handle.getDeviceAllocator(), stream);
+  Tensor<DataT, 2, IndexT> pairwiseDistance(
+    {dataBatchSize, n_clusters}, handle.getDeviceAllocator(), stream);
+  kmeans::detail::sparseMinClusterAndDistance(
+    handle, params, X, sampleNorms.data(), centroids, pairwiseDistance,
+    minClusterAndDistance, workspace, metric, stream);
+
+  // calculate cluster cost phi_x(C)
+  MLCommon::device_buffer<cub::KeyValuePair<IndexT, DataT>> clusterCost(
+    handle.getDeviceAllocator(), stream, 1);
+  kmeans::detail::computeClusterCost(
+    handle, minClusterAndDistance, workspace, clusterCost.data(),
+    [] __device__(const cub::KeyValuePair<IndexT, DataT> &a,
+                  const cub::KeyValuePair<IndexT, DataT> &b) {
+      cub::KeyValuePair<IndexT, DataT> res;
+      res.key = 0;
+      res.value = a.value + b.value;
+      return res;
+    },
+    stream);
+  MLCommon::copy(&inertia, &clusterCost.data()->value, 1, stream);
+
+  ML::thrustAllocatorAdapter alloc(handle.getDeviceAllocator(), stream);
+  auto execution_policy = thrust::cuda::par(alloc).on(stream);
+  thrust::transform(
+    execution_policy, minClusterAndDistance.begin(),
+    minClusterAndDistance.end(), labelsRawPtr,
+    [=] __device__(cub::KeyValuePair<IndexT, DataT> pair) { return pair.key; });
+}
+
+/*
+ * @brief Updates the centroids of a fitted model with new samples only: the
+ * new samples are assigned to their nearest centroids, and every centroid
+ * moves to the mean of its samples of the previous calls, of which there are
+ * 'countsPtr', and of its new samples. This costs a single pass over the new
+ * samples.
+ */
+template <typename DataT, typename IndexT = int>
+void partialFit(const ML::cumlHandle_impl &handle, const KMeansParams &params,
+                const DataT *Xptr, const int n_samples, const int n_features,
+                DataT *cptr, DataT *countsPtr, DataT &inertia) {
+  ML::detail::phaseScope range(handle, "ML::KMeans::PartialFit",
+                               "rows=%d cols=%d", n_samples, n_features);
+  cudaStream_t stream = handle.getStream();
+  auto n_clusters = params.n_clusters;
+
+  ASSERT(n_clusters > 0 && cptr != nullptr, "no clusters exist");
+
+  ASSERT(memory_type(Xptr) == cudaMemoryTypeDevice,
+         "input data must be device accessible");
+
+  ASSERT(memory_type(cptr) == cudaMemoryTypeDevice,
+         "centroid data must be device accessible");
+
+  ASSERT(memory_type(countsPtr) == cudaMemoryTypeDevice,
+         "cluster counts must be device accessible");
+
+  MLCommon::Distance::DistanceType metric =
+    static_cast<MLCommon::Distance::DistanceType>(params.metric);
+
+  Tensor<DataT, 2, IndexT> X((DataT *)Xptr, {n_samples, n_features});
+  Tensor<DataT, 2, IndexT> centroids(cptr, {n_clusters, n_features});
+  Tensor<DataT, 1, IndexT> clusterCounts(countsPtr, {n_clusters});
+
+  auto dataBatchSize = kmeans::detail::getDataBatchSize(params, n_samples);
+
+  // Device-accessible allocation of expandable storage used as temorary buffers
+  MLCommon::device_buffer<char> workspace(handle.getDeviceAllocator(), stream);
+
+  Tensor<cub::KeyValuePair<IndexT, DataT>, 1, IndexT> minClusterAndDistance(
+    {n_samples}, handle.getDeviceAllocator(), stream);
+  Tensor<DataT, 2, IndexT> pairwiseDistance(
+    {dataBatchSize, n_clusters}, handle.getDeviceAllocator(), stream);
+
+  // sum and count of the new samples in each cluster
+  Tensor<DataT, 2, IndexT> batchSums({n_clusters, n_features},
+                                     handle.getDeviceAllocator(), stream);
+  Tensor<int, 1, IndexT> batchCounts({n_clusters}, handle.getDeviceAllocator(),
+                                     stream);
+
+  kmeans::detail::minClusterAndDistance(handle, params, X, centroids,
+                                        pairwiseDistance, minClusterAndDistance,
+                                        workspace, metric, stream);
+
+  kmeans::detail::KeyValueIndexOp<IndexT, DataT> conversion_op;
+  cub::TransformInputIterator<IndexT,
+                              kmeans::detail::KeyValueIndexOp<IndexT, DataT>,
+                              cub::KeyValuePair<IndexT, DataT> *>
+    itr(minClusterAndDistance.data(), conversion_op);
+
+  workspace.resize(n_samples, stream);
+  MLCommon::LinAlg::reduce_rows_by_key(X.data(), n_features, itr,
+                                       workspace.data(), n_samples, n_features,
+                                       n_clusters, batchSums.data(), stream);
+  kmeans::detail::countLabels(handle, itr, batchCounts.data(), n_samples,
+                              n_clusters, workspace, stream);
+
+  kmeans::detail::updateCentroidsIncrementally(
+    handle, batchSums, batchCounts, centroids, clusterCounts, stream);
+
+  // cost of the new samples to the centroids they were assigned to
+  cub::KeyValuePair<IndexT, DataT> *clusterCostD =
+    (cub::KeyValuePair<IndexT, DataT> *)handle.getDeviceAllocator()->allocate(
+      sizeof(cub::KeyValuePair<IndexT, DataT>), stream);
+
+  kmeans::detail::computeClusterCost(
+    handle, minClusterAndDistance, workspace, clusterCostD,
+    [] __device__(const cub::KeyValuePair<IndexT, DataT> &a,
+                  const cub::KeyValuePair<IndexT, DataT> &b) {
+      cub::KeyValuePair<IndexT, DataT> res;
+      res.key = 0;
+      res.value = a.value + b.value;
+      return res;
+    },
+    stream);
+
+  MLCommon::copy(&inertia, &clusterCostD->value, 1, stream);
+
+  handle.getDeviceAllocator()->deallocate(
+    clusterCostD, sizeof(cub::KeyValuePair<IndexT, DataT>), stream);
+}
+
+/**
+ * Predict without synchronizing the host: the labels and the inertia are
+ * written by the work enqueued on the stream of the handle, inertia being a
+ * pointer to device or pinned memory.
+ */
+template <typename DataT, typename IndexT = int>
+void predictAsync(const ML::cumlHandle_impl &handle,
+                  const KMeansParams &params, const DataT *cptr,
+                  const DataT *Xptr, const int n_samples,
+                  const int n_features, IndexT *labelsRawPtr,
+                  DataT *inertia) {
+  ML::detail::phaseScope range(handle, "ML::KMeans::Predict", "rows=%d cols=%d",
+                               n_samples, n_features);
   cudaStream_t stream = handle.getStream();
   auto n_clusters = params.n_clusters;
 
@@ -581,7 +1431,7 @@ void predict(const ML::cumlHandle_impl &handle, const KMeansParams &params,
     },
     stream);
 
-  MLCommon::copy(&inertia, &clusterCostD->value, 1, stream);
+  MLCommon::copy(inertia, &clusterCostD->value, 1, stream);
 
   labelsRawData.resize(n_samples, stream);
 
@@ -599,10 +1449,21 @@ void predict(const ML::cumlHandle_impl &handle, const KMeansParams &params,
   MLCommon::copy(labelsRawPtr, labelsRawData.data(), n_samples, stream);
 }
 
+template <typename DataT, typename IndexT = int>
+void predict(const ML::cumlHandle_impl &handle, const KMeansParams &params,
+             const DataT *cptr, const DataT *Xptr, const int n_samples,
+             const int n_features, IndexT *labelsRawPtr, DataT &inertia) {
+  // the copy of the inertia to pageable memory returns once it is done
+  predictAsync(handle, params, cptr, Xptr, n_samples, n_features,
+               labelsRawPtr, &inertia);
+}
+
 template <typename DataT, typename IndexT = int>
 void transform(const ML::cumlHandle_impl &handle, const KMeansParams &params,
                const DataT *cptr, const DataT *Xptr, int n_samples,
                int n_features, int transform_metric, DataT *X_new) {
+  ML::detail::phaseScope range(handle, "ML::KMeans::Transform",
+                               "rows=%d cols=%d", n_samples, n_features);
   cudaStream_t stream = handle.getStream();
   auto n_clusters = params.n_clusters;
   MLCommon::Distance::DistanceType metric =
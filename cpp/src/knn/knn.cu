@@ -21,22 +21,51 @@
 #include "ml_mg_utils.h"
 
 #include "label/classlabels.h"
+#include "matrix/gather.h"
 #include "selection/knn.h"
+#include "selection/radius_neighbors.h"
 
 #include <cuda_runtime.h>
 #include "cuda_utils.h"
+#include "linalg/unary_op.h"
 
+#include <thrust/execution_policy.h>
+#include <thrust/sequence.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
 #include <sstream>
 #include <vector>
 
 namespace ML {
 
+static MLCommon::Selection::MetricType build_prims_metric(MetricType metric) {
+  switch (metric) {
+    case METRIC_L2:
+      return MLCommon::Selection::METRIC_L2;
+    case METRIC_INNER_PRODUCT:
+      return MLCommon::Selection::METRIC_INNER_PRODUCT;
+    case METRIC_COSINE:
+      return MLCommon::Selection::METRIC_COSINE;
+    case METRIC_L1:
+      return MLCommon::Selection::METRIC_L1;
+    case METRIC_MINKOWSKI:
+      return MLCommon::Selection::METRIC_MINKOWSKI;
+    default:
+      ASSERT(false, "Invalid knn metric %d", (int)metric);
+  }
+  return MLCommon::Selection::METRIC_L2;
+}
+
 void brute_force_knn(cumlHandle &handle, std::vector<float *> &input,
                      std::vector<int> &sizes, int D, float *search_items, int n,
                      int64_t *res_I, float *res_D, int k, bool rowMajorIndex,
-                     bool rowMajorQuery) {
+                     bool rowMajorQuery, MetricType metric, float p) {
   ASSERT(input.size() == sizes.size(),
          "input and sizes vectors must be the same size");
+  ML::detail::phaseScope range(handle.getImpl(), "ML::Knn::BruteForce",
+                               "parts=%d n=%d d=%d k=%d", int(input.size()), n,
+                               D, k);
 
   std::vector<cudaStream_t> int_streams = handle.getImpl().getInternalStreams();
 
@@ -44,11 +73,285 @@ void brute_force_knn(cumlHandle &handle, std::vector<float *> &input,
     input, sizes, D, search_items, n, res_I, res_D, k,
     handle.getImpl().getDeviceAllocator(), handle.getImpl().getStream(),
     int_streams.data(), handle.getImpl().getNumInternalStreams(), rowMajorIndex,
-    rowMajorQuery);
+    rowMajorQuery, nullptr, build_prims_metric(metric), p);
+}
+
+static void negate(float *data, size_t len, cudaStream_t stream) {
+  MLCommon::LinAlg::unaryOp<float>(
+    data, data, len, [] __device__(float input) { return -input; }, stream);
+}
+
+/**
+ * Sorted unique labels of each of the label arrays y of n_samples rows,
+ * allocated with d_alloc.
+ */
+static void unique_labels(std::vector<int *> &y, size_t n_samples,
+                          std::vector<int *> &uniq_labels,
+                          std::vector<int> &n_unique,
+                          std::shared_ptr<deviceAllocator> d_alloc,
+                          cudaStream_t stream) {
+  uniq_labels.resize(y.size());
+  n_unique.resize(y.size());
+  for (int i = 0; i < y.size(); i++) {
+    MLCommon::Label::getUniqueLabels(y[i], n_samples, &(uniq_labels[i]),
+                                     &(n_unique[i]), stream, d_alloc);
+  }
+}
+
+static void release_labels(std::vector<int *> &uniq_labels,
+                           std::vector<int> &n_unique,
+                           std::shared_ptr<deviceAllocator> d_alloc,
+                           cudaStream_t stream) {
+  for (int i = 0; i < uniq_labels.size(); i++) {
+    d_alloc->deallocate(uniq_labels[i], n_unique[i] * sizeof(int), stream);
+  }
+}
+
+/**
+ * The local search of the distributed knn: runs brute_force_knn over the
+ * partitions of this rank for a tile of the queries at a time, the rows of
+ * the partitions being numbered from first_row, and hands each tile to
+ * exchange(start, rows, local_I, local_D). The distances of
+ * METRIC_INNER_PRODUCT are negated, for the merges to keep the smallest.
+ */
+static void knn_mg_local_tiles(
+  const cumlHandle_impl &h, std::vector<float *> &input,
+  std::vector<int> &sizes, int D, float *search_items, int n, int k,
+  int tile_rows, int64_t first_row, bool rowMajorIndex, bool rowMajorQuery,
+  MetricType metric, float p,
+  const std::function<void(int, int, int64_t *, float *)> &exchange) {
+  cudaStream_t stream = h.getStream();
+  std::shared_ptr<deviceAllocator> d_alloc = h.getDeviceAllocator();
+  std::vector<cudaStream_t> int_streams = h.getInternalStreams();
+  std::vector<int64_t> translations;
+  int64_t offset = first_row;
+  for (int size : sizes) {
+    translations.push_back(offset);
+    offset += size;
+  }
+
+  int n_tiles = MLCommon::ceildiv(n, tile_rows);
+  bool stage_query = !rowMajorQuery && n_tiles > 1;
+  size_t tile_len = (size_t)tile_rows * k;
+  MLCommon::device_buffer<float> local_D(d_alloc, stream, tile_len);
+  MLCommon::device_buffer<int64_t> local_I(d_alloc, stream, tile_len);
+  MLCommon::device_buffer<float> query_stage(
+    d_alloc, stream, stage_query ? (size_t)tile_rows * D : 0);
+  MLCommon::Selection::MetricType prims_metric = build_prims_metric(metric);
+
+  for (int t = 0; t < n_tiles; t++) {
+    int start = t * tile_rows;
+    int rows = std::min(tile_rows, n - start);
+    float *tile_items =
+      rowMajorQuery ? search_items + (size_t)start * D : search_items;
+    if (stage_query) {
+      tile_items = query_stage.data();
+      CUDA_CHECK(cudaMemcpy2DAsync(
+        tile_items, rows * sizeof(float), search_items + start,
+        n * sizeof(float), rows * sizeof(float), D, cudaMemcpyDeviceToDevice,
+        stream));
+    }
+
+    MLCommon::Selection::brute_force_knn(
+      input, sizes, D, tile_items, rows, local_I.data(), local_D.data(), k,
+      d_alloc, stream, int_streams.data(), h.getNumInternalStreams(),
+      rowMajorIndex, rowMajorQuery, &translations, prims_metric, p);
+    if (metric == METRIC_INNER_PRODUCT)
+      negate(local_D.data(), (size_t)rows * k, stream);
+    exchange(start, rows, local_I.data(), local_D.data());
+  }
+}
+
+void brute_force_knn_mg(cumlHandle &handle, std::vector<float *> &input,
+                        std::vector<int> &sizes, int D, float *search_items,
+                        int n, int64_t *res_I, float *res_D, int k,
+                        bool rowMajorIndex, bool rowMajorQuery,
+                        MetricType metric, float p) {
+  ASSERT(input.size() == sizes.size(),
+         "input and sizes vectors must be the same size");
+  const cumlHandle_impl &h = handle.getImpl();
+  ASSERT(h.commsInitialized(),
+         "A distributed knn requires a handle with a communicator");
+  const MLCommon::cumlCommunicator &comm = h.getCommunicator();
+  cudaStream_t stream = h.getStream();
+  std::shared_ptr<deviceAllocator> d_alloc = h.getDeviceAllocator();
+  int rank = comm.getRank();
+  int n_ranks = comm.getSize();
+
+  // The rows of the ranks are numbered in rank order
+  int64_t local_rows = 0;
+  for (int size : sizes) local_rows += size;
+  MLCommon::device_buffer<int64_t> rank_rows(d_alloc, stream, n_ranks);
+  MLCommon::updateDevice(rank_rows.data() + rank, &local_rows, 1, stream);
+  comm.allgather(rank_rows.data() + rank, rank_rows.data(), 1, stream);
+  std::vector<int64_t> h_rank_rows(n_ranks);
+  MLCommon::updateHost(h_rank_rows.data(), rank_rows.data(), n_ranks, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  int64_t offset = 0;
+  for (int r = 0; r < rank; r++) offset += h_rank_rows[r];
+
+  // The local results of all the ranks are gathered for a tile of queries
+  // at a time, to bound their memory
+  int tile_rows = MLCommon::Selection::knn_query_tile_rows<int>(
+    n, n_ranks, k, D, !rowMajorQuery, 0);
+  size_t tile_len = (size_t)tile_rows * k;
+  MLCommon::device_buffer<float> all_D(d_alloc, stream, n_ranks * tile_len);
+  MLCommon::device_buffer<int64_t> all_I(d_alloc, stream, n_ranks * tile_len);
+  // The gathered ids are global already
+  MLCommon::device_buffer<int64_t> no_translations(d_alloc, stream, n_ranks);
+  CUDA_CHECK(cudaMemsetAsync(no_translations.data(), 0,
+                             n_ranks * sizeof(int64_t), stream));
+
+  knn_mg_local_tiles(
+    h, input, sizes, D, search_items, n, k, tile_rows, offset, rowMajorIndex,
+    rowMajorQuery, metric, p,
+    [&](int start, int rows, int64_t *local_I, float *local_D) {
+      size_t len = (size_t)rows * k;
+      comm.allgather(local_D, all_D.data(), len, stream);
+      comm.allgather(local_I, all_I.data(), len, stream);
+      MLCommon::Selection::knn_merge_parts(
+        all_D.data(), all_I.data(), res_D + (size_t)start * k,
+        res_I + (size_t)start * k, rows, n_ranks, k, stream,
+        no_translations.data());
+      if (metric == METRIC_INNER_PRODUCT)
+        negate(res_D + (size_t)start * k, len, stream);
+    });
+}
+
+/**
+ * The search of the distributed knn classify and regress, which hands
+ * vote(start, rows, pos, all_y) the neighbors of each tile of queries among
+ * all the ranks, as positions pos in the labels all_y of the local
+ * neighbors of all the ranks. Only the distances and the labels of the
+ * local neighbors are exchanged, the labels staying on their ranks.
+ */
+template <typename LabelT>
+static void knn_mg_vote(
+  const cumlHandle_impl &h, std::vector<float *> &input,
+  std::vector<int> &sizes, int D, float *search_items, int n, int k,
+  std::vector<LabelT *> &y, bool rowMajorIndex, bool rowMajorQuery,
+  const std::function<void(int, int, int64_t *, std::vector<LabelT *> &)>
+    &vote) {
+  ASSERT(input.size() == sizes.size(),
+         "input and sizes vectors must be the same size");
+  ASSERT(h.commsInitialized(),
+         "A distributed knn requires a handle with a communicator");
+  const MLCommon::cumlCommunicator &comm = h.getCommunicator();
+  cudaStream_t stream = h.getStream();
+  std::shared_ptr<deviceAllocator> d_alloc = h.getDeviceAllocator();
+  int n_ranks = comm.getSize();
+  int n_local = 0;
+  for (int size : sizes) n_local += size;
+
+  int tile_rows = MLCommon::Selection::knn_query_tile_rows<int>(
+    n, n_ranks, k, D, !rowMajorQuery, 0);
+  size_t tile_len = (size_t)tile_rows * k;
+  size_t all_len = n_ranks * tile_len;
+  MLCommon::device_buffer<float> all_D(d_alloc, stream, all_len);
+  MLCommon::device_buffer<int64_t> positions(d_alloc, stream, all_len);
+  MLCommon::device_buffer<float> merged_D(d_alloc, stream, tile_len);
+  MLCommon::device_buffer<int64_t> merged_pos(d_alloc, stream, tile_len);
+  MLCommon::device_buffer<LabelT> local_y(d_alloc, stream, tile_len);
+  std::vector<std::unique_ptr<MLCommon::device_buffer<LabelT>>> all_y_bufs;
+  std::vector<LabelT *> all_y;
+  for (int o = 0; o < y.size(); o++) {
+    all_y_bufs.emplace_back(
+      new MLCommon::device_buffer<LabelT>(d_alloc, stream, all_len));
+    all_y.push_back(all_y_bufs.back()->data());
+  }
+  MLCommon::device_buffer<int64_t> no_translations(d_alloc, stream, n_ranks);
+  CUDA_CHECK(cudaMemsetAsync(no_translations.data(), 0,
+                             n_ranks * sizeof(int64_t), stream));
+
+  // The local neighbors are numbered by their local rows, to look up their
+  // labels
+  knn_mg_local_tiles(
+    h, input, sizes, D, search_items, n, k, tile_rows, 0, rowMajorIndex,
+    rowMajorQuery, METRIC_L2, 2.0f,
+    [&](int start, int rows, int64_t *local_I, float *local_D) {
+      int len = rows * k;
+      for (int o = 0; o < y.size(); o++) {
+        MLCommon::Matrix::gather(y[o], 1, n_local, local_I, len,
+                                 local_y.data(), stream);
+        comm.allgather(local_y.data(), all_y[o], len, stream);
+      }
+      comm.allgather(local_D, all_D.data(), len, stream);
+      // the merge takes the positions in the gathered arrays for ids
+      thrust::sequence(thrust::cuda::par.on(stream), positions.data(),
+                       positions.data() + (size_t)n_ranks * len);
+      MLCommon::Selection::knn_merge_parts(
+        all_D.data(), positions.data(), merged_D.data(), merged_pos.data(),
+        rows, n_ranks, k, stream, no_translations.data());
+      vote(start, rows, merged_pos.data(), all_y);
+    });
+}
+
+void brute_force_knn_classify_mg(cumlHandle &handle, int *out,
+                                 std::vector<float *> &input,
+                                 std::vector<int> &sizes, int D,
+                                 float *search_items, int n, int k,
+                                 std::vector<int *> &y, bool rowMajorIndex,
+                                 bool rowMajorQuery) {
+  const cumlHandle_impl &h = handle.getImpl();
+  ML::detail::phaseScope range(h, "ML::Knn::ClassifyMG", "n=%d k=%d", n, k);
+  auto d_alloc = h.getDeviceAllocator();
+  cudaStream_t stream = h.getStream();
+  int n_outputs = y.size();
+  knn_mg_vote<int>(
+    h, input, sizes, D, search_items, n, k, y, rowMajorIndex, rowMajorQuery,
+    [&](int start, int rows, int64_t *pos, std::vector<int *> &all_y) {
+      // only the labels of the candidate neighbors of the tile can win
+      std::vector<int *> uniq_labels;
+      std::vector<int> n_unique;
+      unique_labels(all_y, (size_t)h.getCommunicator().getSize() * rows * k,
+                    uniq_labels, n_unique, d_alloc, stream);
+      MLCommon::Selection::knn_classify(out + (size_t)start * n_outputs, pos,
+                                        all_y, rows, k, uniq_labels, n_unique,
+                                        d_alloc, stream);
+      release_labels(uniq_labels, n_unique, d_alloc, stream);
+    });
+}
+
+void brute_force_knn_regress_mg(cumlHandle &handle, float *out,
+                                std::vector<float *> &input,
+                                std::vector<int> &sizes, int D,
+                                float *search_items, int n, int k,
+                                std::vector<float *> &y, bool rowMajorIndex,
+                                bool rowMajorQuery) {
+  const cumlHandle_impl &h = handle.getImpl();
+  ML::detail::phaseScope range(h, "ML::Knn::RegressMG", "n=%d k=%d", n, k);
+  cudaStream_t stream = h.getStream();
+  int n_outputs = y.size();
+  knn_mg_vote<float>(
+    h, input, sizes, D, search_items, n, k, y, rowMajorIndex, rowMajorQuery,
+    [&](int start, int rows, int64_t *pos, std::vector<float *> &all_y) {
+      MLCommon::Selection::knn_regress(out + (size_t)start * n_outputs, pos,
+                                       all_y, rows, k, stream);
+    });
+}
+
+void radius_neighbors_row_ind(const cumlHandle &handle, const float *input,
+                              int n_index, int D, const float *search_items,
+                              int n, float eps, int *row_ind,
+                              bool rowMajorIndex, bool rowMajorQuery) {
+  MLCommon::Selection::radius_neighbors_row_ind(
+    input, n_index, rowMajorIndex, search_items, n, rowMajorQuery, D, eps,
+    row_ind, handle.getStream());
+}
+
+void radius_neighbors_graph(const cumlHandle &handle, const float *input,
+                            int n_index, int D, const float *search_items,
+                            int n, float eps, const int *row_ind,
+                            int *col_ind, float *vals, bool rowMajorIndex,
+                            bool rowMajorQuery) {
+  MLCommon::Selection::radius_neighbors_fill(
+    input, n_index, rowMajorIndex, search_items, n, rowMajorQuery, D, eps,
+    row_ind, col_ind, vals, handle.getStream());
 }
 
 void knn_classify(cumlHandle &handle, int *out, int64_t *knn_indices,
                   std::vector<int *> &y, size_t n_samples, int k) {
+  ML::nvtxRange range("ML::Knn::Classify", "n=%zu k=%d", n_samples, k);
   auto d_alloc = handle.getDeviceAllocator();
   cudaStream_t stream = handle.getStream();
 
@@ -66,6 +369,7 @@ void knn_classify(cumlHandle &handle, int *out, int64_t *knn_indices,
 
 void knn_regress(cumlHandle &handle, float *out, int64_t *knn_indices,
                  std::vector<float *> &y, size_t n_samples, int k) {
+  ML::nvtxRange range("ML::Knn::Regress", "n=%zu k=%d", n_samples, k);
   MLCommon::Selection::knn_regress(out, knn_indices, y, n_samples, k,
                                    handle.getStream());
 }
@@ -73,6 +377,7 @@ void knn_regress(cumlHandle &handle, float *out, int64_t *knn_indices,
 void knn_class_proba(cumlHandle &handle, std::vector<float *> &out,
                      int64_t *knn_indices, std::vector<int *> &y,
                      size_t n_samples, int k) {
+  ML::nvtxRange range("ML::Knn::ClassProba", "n=%zu k=%d", n_samples, k);
   auto d_alloc = handle.getDeviceAllocator();
   cudaStream_t stream = handle.getStream();
 
@@ -88,6 +393,62 @@ void knn_class_proba(cumlHandle &handle, std::vector<float *> &out,
                                    uniq_labels, n_unique, d_alloc, stream);
 }
 
+static void brute_force_knn_vote(cumlHandle &handle, int *out,
+                                 std::vector<float *> *proba,
+                                 std::vector<float *> &input,
+                                 std::vector<int> &sizes, int D,
+                                 float *search_items, int n, int k,
+                                 std::vector<int *> &y, bool rowMajorIndex,
+                                 bool rowMajorQuery) {
+  auto d_alloc = handle.getDeviceAllocator();
+  cudaStream_t stream = handle.getStream();
+  size_t n_index = 0;
+  for (int size : sizes) n_index += size;
+
+  std::vector<int *> uniq_labels;
+  std::vector<int> n_unique;
+  unique_labels(y, n_index, uniq_labels, n_unique, d_alloc, stream);
+  std::vector<cudaStream_t> int_streams = handle.getImpl().getInternalStreams();
+  MLCommon::Selection::brute_force_knn_classify(
+    input, sizes, D, search_items, n, k, out, proba, y, uniq_labels, n_unique,
+    d_alloc, stream, int_streams.data(),
+    handle.getImpl().getNumInternalStreams(), rowMajorIndex, rowMajorQuery);
+  release_labels(uniq_labels, n_unique, d_alloc, stream);
+}
+
+void brute_force_knn_classify(cumlHandle &handle, int *out,
+                              std::vector<float *> &input,
+                              std::vector<int> &sizes, int D,
+                              float *search_items, int n, int k,
+                              std::vector<int *> &y, bool rowMajorIndex,
+                              bool rowMajorQuery) {
+  brute_force_knn_vote(handle, out, nullptr, input, sizes, D, search_items, n,
+                       k, y, rowMajorIndex, rowMajorQuery);
+}
+
+void brute_force_knn_class_proba(cumlHandle &handle, std::vector<float *> &out,
+                                 std::vector<float *> &input,
+                                 std::vector<int> &sizes, int D,
+                                 float *search_items, int n, int k,
+                                 std::vector<int *> &y, bool rowMajorIndex,
+                                 bool rowMajorQuery) {
+  brute_force_knn_vote(handle, nullptr, &out, input, sizes, D, search_items,
+                       n, k, y, rowMajorIndex, rowMajorQuery);
+}
+
+void brute_force_knn_regress(cumlHandle &handle, float *out,
+                             std::vector<float *> &input,
+                             std::vector<int> &sizes, int D,
+                             float *search_items, int n, int k,
+                             std::vector<float *> &y, bool rowMajorIndex,
+                             bool rowMajorQuery) {
+  std::vector<cudaStream_t> int_streams = handle.getImpl().getInternalStreams();
+  MLCommon::Selection::brute_force_knn_regress(
+    input, sizes, D, search_items, n, k, out, y, handle.getDeviceAllocator(),
+    handle.getStream(), int_streams.data(),
+    handle.getImpl().getNumInternalStreams(), rowMajorIndex, rowMajorQuery);
+}
+
 /**
 	 * Build a kNN object for training and querying a k-nearest neighbors model.
 	 * @param D 	number of features in each vector
@@ -154,6 +515,9 @@ void kNN::fit(std::vector<float *> &input, std::vector<int> &sizes,
 void kNN::search(float *search_items, int n, int64_t *res_I, float *res_D,
                  int k, bool rowMajor) {
   ASSERT(this->indices > 0, "Cannot search before model has been trained.");
+  ML::detail::phaseScope range(handle->getImpl(), "ML::Knn::Search",
+                               "parts=%d n=%d d=%d k=%d", this->indices, n, D,
+                               k);
 
   std::vector<cudaStream_t> int_streams =
     handle->getImpl().getInternalStreams();
@@ -166,6 +530,45 @@ void kNN::search(float *search_items, int n, int64_t *res_I, float *res_D,
 }
 };  // namespace ML
 
+namespace {
+
+/** the C API searches of n_queries query arrays; async searches only use the
+ *  stream of the handle, as brute_force_knn synchronizes the host with its
+ *  internal streams, and record event after the last query */
+cumlError_t knn_search_helper(const cumlHandle_t handle, float **input,
+                              int *sizes, int n_params, int D, int n_queries,
+                              float **search_items, const int *n,
+                              int64_t **res_I, float **res_D, int k,
+                              bool rowMajorIndex, bool rowMajorQuery,
+                              bool async, cudaEvent_t event) {
+  cumlError_t status;
+  ML::cumlHandle *handle_ptr;
+  std::tie(handle_ptr, status) = ML::handleMap.lookupHandlePointer(handle);
+  if (status == CUML_SUCCESS) {
+    try {
+      const ML::cumlHandle_impl &impl = handle_ptr->getImpl();
+      std::vector<float *> input_vec(input, input + n_params);
+      std::vector<int> sizes_vec(sizes, sizes + n_params);
+      std::vector<cudaStream_t> int_streams;
+      if (!async) int_streams = impl.getInternalStreams();
+      for (int q = 0; q < n_queries; q++) {
+        MLCommon::Selection::brute_force_knn(
+          input_vec, sizes_vec, D, search_items[q], n[q], res_I[q], res_D[q],
+          k, impl.getDeviceAllocator(), impl.getStream(), int_streams.data(),
+          int(int_streams.size()), rowMajorIndex, rowMajorQuery);
+      }
+      if (event != nullptr) {
+        CUDA_CHECK(cudaEventRecord(event, impl.getStream()));
+      }
+    } catch (...) {
+      status = CUML_ERROR_UNKNOWN;
+    }
+  }
+  return status;
+}
+
+}  // namespace
+
 /**
  * @brief Flat C API function to perform a brute force knn on
  * a series of input arrays and combine the results into a single
@@ -189,32 +592,32 @@ extern "C" cumlError_t knn_search(const cumlHandle_t handle, float **input,
                                   float *search_items, int n, int64_t *res_I,
                                   float *res_D, int k, bool rowMajorIndex,
                                   bool rowMajorQuery) {
-  cumlError_t status;
-
-  ML::cumlHandle *handle_ptr;
-  std::tie(handle_ptr, status) = ML::handleMap.lookupHandlePointer(handle);
-
-  std::vector<cudaStream_t> int_streams =
-    handle_ptr->getImpl().getInternalStreams();
+  return knn_search_helper(handle, input, sizes, n_params, D, 1,
+                           &search_items, &n, &res_I, &res_D, k,
+                           rowMajorIndex, rowMajorQuery, false, nullptr);
+}
 
-  std::vector<float *> input_vec(n_params);
-  std::vector<int> sizes_vec(n_params);
-  for (int i = 0; i < n_params; i++) {
-    input_vec.push_back(input[i]);
-    sizes_vec.push_back(sizes[i]);
-  }
+/**
+ * @brief knn_search without waiting for the results, see knn_api.h
+ */
+extern "C" cumlError_t knn_search_async(
+  const cumlHandle_t handle, float **input, int *sizes, int n_params, int D,
+  float *search_items, int n, int64_t *res_I, float *res_D, int k,
+  bool rowMajorIndex, bool rowMajorQuery, cudaEvent_t event) {
+  return knn_search_helper(handle, input, sizes, n_params, D, 1,
+                           &search_items, &n, &res_I, &res_D, k,
+                           rowMajorIndex, rowMajorQuery, true, event);
+}
 
-  if (status == CUML_SUCCESS) {
-    try {
-      MLCommon::Selection::brute_force_knn(
-        input_vec, sizes_vec, D, search_items, n, res_I, res_D, k,
-        handle_ptr->getImpl().getDeviceAllocator(),
-        handle_ptr->getImpl().getStream(), int_streams.data(),
-        handle_ptr->getImpl().getNumInternalStreams(), rowMajorIndex,
-        rowMajorQuery);
-    } catch (...) {
-      status = CUML_ERROR_UNKNOWN;
-    }
-  }
-  return status;
+/**
+ * @brief knn_search_async on several query arrays, see knn_api.h
+ */
+extern "C" cumlError_t knn_search_batch_async(
+  const cumlHandle_t handle, float **input, int *sizes, int n_params, int D,
+  int n_queries, float **search_items, const int *n, int64_t **res_I,
+  float **res_D, int k, bool rowMajorIndex, bool rowMajorQuery,
+  cudaEvent_t event) {
+  return knn_search_helper(handle, input, sizes, n_params, D, n_queries,
+                           search_items, n, res_I, res_D, k, rowMajorIndex,
+                           rowMajorQuery, true, event);
 }
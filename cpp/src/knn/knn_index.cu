@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/cumlHandle.hpp"
+
+#include <cuml/neighbors/knn.hpp>
+
+#include <faiss/IndexIVFFlat.h>
+#include <faiss/IndexIVFPQ.h>
+#include <faiss/gpu/GpuCloner.h>
+#include <faiss/gpu/GpuIndexIVFFlat.h>
+#include <faiss/gpu/GpuIndexIVFPQ.h>
+#include <faiss/gpu/StandardGpuResources.h>
+#include <faiss/impl/io.h>
+#include <faiss/index_io.h>
+
+#include <cuda_runtime.h>
+#include "cuda_utils.h"
+#include "linalg/unary_op.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace ML {
+
+/**
+ * FAISS resources and GPU index of a knnIndex; index is null until the
+ * index is built or loaded.
+ */
+struct knnIndexImpl {
+  faiss::gpu::StandardGpuResources res;
+  std::unique_ptr<faiss::gpu::GpuIndexIVF> index;
+  int device;
+};
+
+// k-means of the FAISS IVF indexes uses at most this many training vectors
+// per list (faiss::ClusteringParameters::max_points_per_centroid)
+static const int MAX_TRAIN_PER_LIST = 256;
+
+/**
+ * Make the FAISS calls of impl run on stream, which may have changed since
+ * the previous call.
+ */
+static void set_stream(knnIndexImpl *impl, cudaStream_t stream) {
+  impl->res.setDefaultStream(impl->device, stream);
+}
+
+/**
+ * Create an empty GPU index of the type and parameters of params.
+ */
+static faiss::gpu::GpuIndexIVF *create_index(knnIndexImpl *impl, int D,
+                                             const knnIndexParams &params) {
+  switch (params.type) {
+    case IVF_FLAT: {
+      faiss::gpu::GpuIndexIVFFlatConfig config;
+      config.device = impl->device;
+      return new faiss::gpu::GpuIndexIVFFlat(&impl->res, D, params.n_lists,
+                                              faiss::METRIC_L2, config);
+    }
+    case IVF_PQ: {
+      faiss::gpu::GpuIndexIVFPQConfig config;
+      config.device = impl->device;
+      return new faiss::gpu::GpuIndexIVFPQ(&impl->res, D, params.n_lists,
+                                            params.pq_m, params.pq_bits,
+                                            faiss::METRIC_L2, config);
+    }
+    default:
+      ASSERT(false, "knnIndex: type must be IVF_FLAT or IVF_PQ");
+  }
+  return nullptr;
+}
+
+knnIndex::knnIndex(const cumlHandle &handle, int D,
+                   const knnIndexParams &params)
+  : D(D), params(params), impl(new knnIndexImpl) {
+  ASSERT(D > 0, "knnIndex: invalid number of features %d", D);
+  ASSERT(params.n_lists > 0, "knnIndex: invalid n_lists %d", params.n_lists);
+  ASSERT(params.n_probes > 0, "knnIndex: invalid n_probes %d",
+         params.n_probes);
+  ASSERT(params.type != IVF_PQ || (params.pq_m > 0 && D % params.pq_m == 0),
+         "knnIndex: pq_m must divide the number of features");
+  this->handle = const_cast<cumlHandle *>(&handle);
+  CUDA_CHECK(cudaGetDevice(&impl->device));
+  impl->res.setCudaMallocWarning(false);
+}
+
+knnIndex::~knnIndex() { delete impl; }
+
+void knnIndex::build(const float *input, int n) {
+  ASSERT(n > 0, "knnIndex: cannot build an index on %d vectors", n);
+  cudaStream_t stream = handle->getStream();
+  set_stream(impl, stream);
+  impl->index.reset(create_index(impl, D, params));
+  impl->index->setNumProbes(params.n_probes);
+
+  // FAISS k-means runs on the host and subsamples its input anyway, so only
+  // a strided sample of input is copied there
+  int n_train = std::min(n, MAX_TRAIN_PER_LIST * params.n_lists);
+  int stride = n / n_train;
+  std::vector<float> h_train((size_t)n_train * D);
+  CUDA_CHECK(cudaMemcpy2DAsync(h_train.data(), D * sizeof(float), input,
+                               (size_t)stride * D * sizeof(float),
+                               D * sizeof(float),
+                               n_train, cudaMemcpyDeviceToHost, stream));
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  impl->index->train(n_train, h_train.data());
+  impl->index->add(n, input);
+}
+
+void knnIndex::add(const float *input, int n) {
+  ASSERT(impl->index != nullptr, "knnIndex: add() requires a built index");
+  set_stream(impl, handle->getStream());
+  impl->index->add(n, input);
+}
+
+void knnIndex::search(const float *search_items, int n, int64_t *res_I,
+                      float *res_D, int k) const {
+  ASSERT(impl->index != nullptr, "knnIndex: search() requires a built index");
+  cudaStream_t stream = handle->getStream();
+  set_stream(impl, stream);
+  impl->index->search(n, search_items, k, res_D,
+                      reinterpret_cast<faiss::Index::idx_t *>(res_I));
+  // FAISS returns squared distances
+  MLCommon::LinAlg::unaryOp<float>(
+    res_D, res_D, (size_t)n * k,
+    [] __device__(float input) { return sqrt(input); }, stream);
+}
+
+void knnIndex::set_n_probes(int n_probes) {
+  ASSERT(n_probes > 0, "knnIndex: invalid n_probes %d", n_probes);
+  params.n_probes = n_probes;
+  if (impl->index != nullptr) impl->index->setNumProbes(n_probes);
+}
+
+int64_t knnIndex::size() const {
+  return impl->index == nullptr ? 0 : impl->index->ntotal;
+}
+
+void knnIndex::save(std::vector<char> *pbytes) const {
+  ASSERT(impl->index != nullptr, "knnIndex: save() requires a built index");
+  set_stream(impl, handle->getStream());
+  std::unique_ptr<faiss::Index> cpu_index(
+    faiss::gpu::index_gpu_to_cpu(impl->index.get()));
+  faiss::VectorIOWriter writer;
+  faiss::write_index(cpu_index.get(), &writer);
+  pbytes->assign(writer.data.begin(), writer.data.end());
+}
+
+void knnIndex::load(const void *bytes, size_t size) {
+  set_stream(impl, handle->getStream());
+  faiss::VectorIOReader reader;
+  const uint8_t *data = (const uint8_t *)bytes;
+  reader.data.assign(data, data + size);
+  std::unique_ptr<faiss::Index> cpu_index(faiss::read_index(&reader));
+  ASSERT(cpu_index->d == D,
+         "knnIndex: saved index has %d features instead of %d", cpu_index->d,
+         D);
+
+  const faiss::IndexIVFFlat *ivf_flat =
+    dynamic_cast<const faiss::IndexIVFFlat *>(cpu_index.get());
+  const faiss::IndexIVFPQ *ivf_pq =
+    dynamic_cast<const faiss::IndexIVFPQ *>(cpu_index.get());
+  if (ivf_flat != nullptr) {
+    faiss::gpu::GpuIndexIVFFlatConfig config;
+    config.device = impl->device;
+    impl->index.reset(
+      new faiss::gpu::GpuIndexIVFFlat(&impl->res, ivf_flat, config));
+    params.type = IVF_FLAT;
+    params.n_probes = ivf_flat->nprobe;
+  } else {
+    ASSERT(ivf_pq != nullptr,
+           "knnIndex: saved index is not IVF_FLAT or IVF_PQ");
+    faiss::gpu::GpuIndexIVFPQConfig config;
+    config.device = impl->device;
+    impl->index.reset(
+      new faiss::gpu::GpuIndexIVFPQ(&impl->res, ivf_pq, config));
+    params.type = IVF_PQ;
+    params.n_probes = ivf_pq->nprobe;
+    params.pq_m = ivf_pq->pq.M;
+    params.pq_bits = ivf_pq->pq.nbits;
+  }
+  params.n_lists = impl->index->getNumLists();
+}
+
+};  // namespace ML
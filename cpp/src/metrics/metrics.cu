@@ -18,8 +18,12 @@
 #include <cuml/metrics/metrics.hpp>
 #include "cuda_utils.h"
 #include "metrics/adjustedRandIndex.h"
+#include "metrics/clusteringScores.h"
+#include "metrics/confusionMatrix.h"
 #include "metrics/klDivergence.h"
+#include "metrics/logLoss.h"
 #include "metrics/randIndex.h"
+#include "metrics/rocAucScore.h"
 #include "metrics/silhouetteScore.h"
 #include "metrics/vMeasure.h"
 #include "score/scores.h"
@@ -36,6 +40,21 @@ double r2_score_py(const cumlHandle &handle, double *y, double *y_hat, int n) {
   return MLCommon::Score::r2_score(y, y_hat, n, handle.getStream());
 }
 
+void batched_r2_score(const cumlHandle &handle, float *scores, const float *y,
+                      const float *y_hat, int n_models, int n) {
+  MLCommon::Score::batched_r2_score(scores, y, y_hat, n_models, n,
+                                    handle.getDeviceAllocator(),
+                                    handle.getStream());
+}
+
+void batched_r2_score(const cumlHandle &handle, double *scores,
+                      const double *y, const double *y_hat, int n_models,
+                      int n) {
+  MLCommon::Score::batched_r2_score(scores, y, y_hat, n_models, n,
+                                    handle.getDeviceAllocator(),
+                                    handle.getStream());
+}
+
 double randIndex(const cumlHandle &handle, const double *y, const double *y_hat,
                  int n) {
   return MLCommon::Metrics::computeRandIndex(
@@ -121,6 +140,19 @@ double vMeasure(const cumlHandle &handle, const int *y, const int *y_hat,
     handle.getDeviceAllocator(), handle.getStream());
 }
 
+ClusteringScores clusteringScores(const cumlHandle &handle, const int *y,
+                                  const int *y_hat, const int n,
+                                  const int lower_class_range,
+                                  const int upper_class_range) {
+  MLCommon::Metrics::ClusteringScores scores =
+    MLCommon::Metrics::clusteringScores(y, y_hat, n, lower_class_range,
+                                        upper_class_range,
+                                        handle.getDeviceAllocator(),
+                                        handle.getStream());
+  return {scores.adjustedRandIndex, scores.mutualInfo, scores.homogeneity,
+          scores.completeness, scores.vMeasure};
+}
+
 float accuracy_score_py(const cumlHandle &handle, const int *predictions,
                         const int *ref_predictions, int n) {
   return MLCommon::Score::accuracy_score(predictions, ref_predictions, n,
@@ -128,5 +160,47 @@ float accuracy_score_py(const cumlHandle &handle, const int *predictions,
                                          handle.getStream());
 }
 
+void batched_accuracy_score(const cumlHandle &handle, float *scores,
+                            const int *predictions, const int *ref_predictions,
+                            int n_models, int n) {
+  MLCommon::Score::batched_accuracy_score(scores, predictions, ref_predictions,
+                                          n_models, n, handle.getStream());
+}
+
+void confusion_matrix(const cumlHandle &handle, int *out, const int *y,
+                      const int *y_hat, int n, int lower_class_range,
+                      int upper_class_range) {
+  MLCommon::Metrics::confusionMatrix(y, y_hat, n, out, lower_class_range,
+                                     upper_class_range, handle.getStream());
+}
+
+double roc_auc_score(const cumlHandle &handle, const int *y,
+                     const float *y_score, int n) {
+  return MLCommon::Metrics::rocAucScore(y, y_score, n,
+                                        handle.getDeviceAllocator(),
+                                        handle.getStream());
+}
+
+double roc_auc_score(const cumlHandle &handle, const int *y,
+                     const double *y_score, int n) {
+  return MLCommon::Metrics::rocAucScore(y, y_score, n,
+                                        handle.getDeviceAllocator(),
+                                        handle.getStream());
+}
+
+double log_loss(const cumlHandle &handle, const int *y, const float *probs,
+                int n, int n_classes, double eps) {
+  return MLCommon::Metrics::logLoss(y, probs, n, n_classes,
+                                    handle.getDeviceAllocator(),
+                                    handle.getStream(), eps);
+}
+
+double log_loss(const cumlHandle &handle, const int *y, const double *probs,
+                int n, int n_classes, double eps) {
+  return MLCommon::Metrics::logLoss(y, probs, n, n_classes,
+                                    handle.getDeviceAllocator(),
+                                    handle.getStream(), eps);
+}
+
 }  // namespace Metrics
 }  // namespace ML
@@ -19,16 +19,33 @@
 #include "cuda_utils.h"
 
 #include <cuda_runtime.h>
+#include <limits.h>
+#include <algorithm>
+#include <cuml/common/deviceGroup.hpp>
+#include "common/cumlHandle.hpp"
+#include "common/device_buffer.hpp"
 #include "utils.h"
 
 namespace ML {
 
+/**
+ * The rows [*begin, *begin + *count) of part part of n rows split over
+ * n_parts parts: the numbers of rows of the parts differ by one at most, the
+ * first parts having the extra rows.
+ */
+template <typename T>
+void balanced_rows(T n, int n_parts, int part, T *begin, T *count) {
+  T base = n / n_parts, extra = n % n_parts;
+  *begin = base * part + std::min<T>(part, extra);
+  *count = base + (part < extra ? 1 : 0);
+}
+
 /**
    * Chunk a single host array up into one or many GPUs (determined by the provided
-   * list of device ids)
+   * list of device ids), in balanced chunks of rows
    *
    * @param ptr       an array in host memory to chunk over devices
-   * @param n         number of elements in ptr
+   * @param n         number of rows in ptr
    * @param D         number of cols in ptr
    * @param devices   array of device ids for chunking the ptr
    * @param output    host array of device array pointers for output chunks
@@ -40,23 +57,120 @@ template <typename OutType, typename T = size_t>
 void chunk_to_device(const OutType *ptr, T n, int D, int *devices,
                      OutType **output, T *sizes, int n_chunks,
                      cudaStream_t stream) {
-  size_t chunk_size = MLCommon::ceildiv<size_t>((size_t)n, (size_t)n_chunks);
-
 #pragma omp parallel for
   for (int i = 0; i < n_chunks; i++) {
     int device = devices[i];
     CUDA_CHECK(cudaSetDevice(device));
 
-    T length = chunk_size;
-    if (length * (i + 1) > n) length = length - ((chunk_size * (i + 1)) - n);
+    T begin, length;
+    balanced_rows(n, n_chunks, i, &begin, &length);
 
-    float *ptr_d;
-    MLCommon::allocate(ptr_d, length * D);
-    MLCommon::updateDevice(ptr_d, ptr + (chunk_size * i), length * D, stream);
+    OutType *ptr_d;
+    MLCommon::allocate(ptr_d, size_t(length) * D);
+    MLCommon::updateDevice(ptr_d, ptr + size_t(begin) * D, size_t(length) * D,
+                           stream);
 
     output[i] = ptr_d;
     sizes[i] = length;
   }
 };
 
+/**
+ * Chunk a single host array of n rows of D columns up into the devices of a
+ * group, in rank order and balanced chunks of rows, each chunk being copied
+ * on the stream of its rank.
+ *
+ * @param ptr       an array in host memory to chunk over devices
+ * @param n         number of rows in ptr
+ * @param D         number of cols in ptr
+ * @param group     the devices, one chunk each
+ * @param output    host array of group.size() device pointers for the output
+ *                  chunks, to be freed with cudaFree
+ * @param sizes     host array of group.size() numbers of rows of the chunks
+ */
+template <typename OutType, typename T = size_t>
+void chunk_to_device(const OutType *ptr, T n, int D,
+                     const cumlDeviceGroup &group, OutType **output,
+                     T *sizes) {
+  group.forEach([&](int rank, cumlHandle &) {
+    T begin, length;
+    balanced_rows(n, group.size(), rank, &begin, &length);
+    OutType *ptr_d = nullptr;
+    if (length > 0) MLCommon::allocate(ptr_d, size_t(length) * D);
+    MLCommon::updateDevice(ptr_d, ptr + size_t(begin) * D, size_t(length) * D,
+                           group.getStream(rank));
+    output[rank] = ptr_d;
+    sizes[rank] = length;
+  });
+}
+
+/**
+ * Distribute the n rows of D columns of a row-major host array on root to
+ * the ranks of the communicator of handle, in rank order and balanced
+ * chunks of rows (see balanced_rows), for the processes of a cluster to load
+ * a dataset read by one of them.
+ *
+ * The rows go through the device of root in pieces of at most piece_rows
+ * rows, sent with the stream-ordered point-to-point calls of the
+ * communicator, so that neither root nor the process of any other rank
+ * holds more than its own rows and a piece in device memory.
+ *
+ * @param handle     the handle, with a communicator
+ * @param ptr        the rows in host memory, only read on root
+ * @param n          number of rows of ptr, only read on root
+ * @param D          number of cols of ptr, the same on all the ranks
+ * @param root       the rank holding the data
+ * @param out        receives the rows of this rank
+ * @param first_row  receives the index of the first row of this rank
+ * @param piece_rows rows per transfer
+ * @return           the number of rows of this rank
+ */
+template <typename T>
+int64_t scatter_rows(const cumlHandle_impl &handle, const T *ptr, int64_t n,
+                     int D, int root, MLCommon::device_buffer<T> &out,
+                     int64_t *first_row = nullptr,
+                     int64_t piece_rows = 1 << 20) {
+  const MLCommon::cumlCommunicator &comm = handle.getCommunicator();
+  cudaStream_t stream = handle.getStream();
+  int rank = comm.getRank(), n_ranks = comm.getSize();
+  MLCommon::device_buffer<int64_t> n_d(handle.getDeviceAllocator(), stream, 1);
+  if (rank == root) MLCommon::updateDevice(n_d.data(), &n, 1, stream);
+  comm.bcast(n_d.data(), 1, root, stream);
+  MLCommon::updateHost(&n, n_d.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  int64_t begin, count;
+  balanced_rows(n, n_ranks, rank, &begin, &count);
+  if (first_row != nullptr) *first_row = begin;
+  out.resize(size_t(count) * D, stream);
+  piece_rows = std::max<int64_t>(
+    1, std::min<int64_t>(piece_rows, INT_MAX / (int64_t(D) * sizeof(T))));
+
+  if (rank != root) {
+    for (int64_t p = 0; p < count; p += piece_rows) {
+      int64_t rows = std::min(piece_rows, count - p);
+      comm.device_recv(out.data() + size_t(p) * D, int(rows * D), root,
+                       stream);
+    }
+  } else {
+    MLCommon::updateDevice(out.data(), ptr + size_t(begin) * D,
+                           size_t(count) * D, stream);
+    MLCommon::device_buffer<T> piece(handle.getDeviceAllocator(), stream,
+                                     size_t(std::min(piece_rows, n)) * D);
+    for (int r = 0; r < n_ranks; r++) {
+      if (r == root) continue;
+      int64_t r_begin, r_count;
+      balanced_rows(n, n_ranks, r, &r_begin, &r_count);
+      for (int64_t p = 0; p < r_count; p += piece_rows) {
+        int64_t rows = std::min(piece_rows, r_count - p);
+        // stream-ordered: the piece is only overwritten once it is sent
+        MLCommon::updateDevice(piece.data(), ptr + size_t(r_begin + p) * D,
+                               size_t(rows) * D, stream);
+        comm.device_send(piece.data(), int(rows * D), r, stream);
+      }
+    }
+  }
+  return count;
+}
+
 };  // end namespace ML
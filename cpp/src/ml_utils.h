@@ -78,6 +78,9 @@ class paramsTSVD : public paramsSolver {
   int max_sweeps = 15;
   solver algorithm = solver::COV_EIG_DQ;
   bool trans_input = false;
+  // oversampling and power iterations of the RANDOMIZED solver
+  int n_oversamples = 10;
+  int n_power_iters = 2;
 };
 
 /**
@@ -94,6 +97,8 @@ class paramsTSVD : public paramsSolver {
  * @random_state: RandomState instance or None, optional (default None)
  * @verbose: 0: no error message printing, 1: print error messages
  * @max_sweeps: number of sweeps jacobi method uses. The more the better accuracy.
+ * @n_oversamples: number of random directions sampled beyond n_components by svd_solver == 'RANDOMIZED'.
+ * @n_power_iters: number of power iterations refining the random samples of svd_solver == 'RANDOMIZED'.
  * @{
  */
 
@@ -16,6 +16,7 @@
 
 #include <cuml/decomposition/pca.hpp>
 #include "pca.h"
+#include "pca_mg.h"
 
 namespace ML {
 
@@ -39,6 +40,54 @@ void pcaFit(cumlHandle &handle, double *input, double *components,
          handle.getStream());
 }
 
+void pcaFitMG(cumlHandle &handle, float *input, float *components,
+              float *explained_var, float *explained_var_ratio,
+              float *singular_vals, float *mu, float *noise_vars,
+              paramsPCA prms) {
+  pcaFitMG(handle.getImpl(), input, components, explained_var,
+           explained_var_ratio, singular_vals, mu, noise_vars, prms,
+           handle.getStream());
+}
+
+void pcaFitMG(cumlHandle &handle, double *input, double *components,
+              double *explained_var, double *explained_var_ratio,
+              double *singular_vals, double *mu, double *noise_vars,
+              paramsPCA prms) {
+  pcaFitMG(handle.getImpl(), input, components, explained_var,
+           explained_var_ratio, singular_vals, mu, noise_vars, prms,
+           handle.getStream());
+}
+
+void pcaPartialFit(cumlHandle &handle, float *input, float *mu,
+                   float *scatter, size_t *n_samples_seen, paramsPCA prms) {
+  pcaPartialFit(handle.getImpl(), input, mu, scatter, n_samples_seen, prms,
+                handle.getStream());
+}
+
+void pcaPartialFit(cumlHandle &handle, double *input, double *mu,
+                   double *scatter, size_t *n_samples_seen, paramsPCA prms) {
+  pcaPartialFit(handle.getImpl(), input, mu, scatter, n_samples_seen, prms,
+                handle.getStream());
+}
+
+void pcaFitScatter(cumlHandle &handle, const float *scatter,
+                   size_t n_samples_seen, float *components,
+                   float *explained_var, float *explained_var_ratio,
+                   float *singular_vals, paramsPCA prms) {
+  pcaFitScatter(handle.getImpl(), scatter, n_samples_seen, components,
+                explained_var, explained_var_ratio, singular_vals, prms,
+                handle.getStream());
+}
+
+void pcaFitScatter(cumlHandle &handle, const double *scatter,
+                   size_t n_samples_seen, double *components,
+                   double *explained_var, double *explained_var_ratio,
+                   double *singular_vals, paramsPCA prms) {
+  pcaFitScatter(handle.getImpl(), scatter, n_samples_seen, components,
+                explained_var, explained_var_ratio, singular_vals, prms,
+                handle.getStream());
+}
+
 void pcaFitTransform(cumlHandle &handle, float *input, float *trans_input,
                      float *components, float *explained_var,
                      float *explained_var_ratio, float *singular_vals,
@@ -17,9 +17,13 @@
 #pragma once
 
 #include <cuda_utils.h>
+#include <linalg/add.h>
 #include <linalg/cublas_wrappers.h>
 #include <linalg/eig.h>
 #include <linalg/eltwise.h>
+#include <linalg/gemm.h>
+#include <linalg/matrix_vector_op.h>
+#include <linalg/subtract.h>
 #include <linalg/transpose.h>
 #include <matrix/math.h>
 #include <matrix/matrix.h>
@@ -59,6 +63,45 @@ void truncCompExpVars(const cumlHandle_impl &handle, math_t *in,
                           explained_var_ratio, prms.n_components, 1, stream);
 }
 
+/**
+ * @brief the RANDOMIZED solver of pcaFit: the components and singular values
+ * come from a randomized SVD of the centered input, so that only the
+ * n_components leading directions are computed, and the total variance of
+ * the explained variance ratio from the variances of the columns.
+ */
+template <typename math_t>
+void pcaFitRsvd(const cumlHandle_impl &handle, math_t *input,
+                math_t *components, math_t *explained_var,
+                math_t *explained_var_ratio, math_t *singular_vals,
+                const math_t *mu, paramsPCA prms, cudaStream_t stream) {
+  auto allocator = handle.getDeviceAllocator();
+
+  device_buffer<math_t> vars(allocator, stream, prms.n_cols);
+  Stats::vars(vars.data(), input, mu, prms.n_cols, prms.n_rows, true, false,
+              stream);
+  device_buffer<math_t> total_vars(allocator, stream, 1);
+  Stats::sum(total_vars.data(), vars.data(), 1, prms.n_cols, false, stream);
+
+  Stats::meanCenter(input, input, mu, prms.n_cols, prms.n_rows, false, true,
+                    stream);
+  calCompRsvd(handle, input, components, singular_vals, prms, stream);
+  Stats::meanAdd(input, input, mu, prms.n_cols, prms.n_rows, false, true,
+                 stream);
+
+  math_t scalar = math_t(1) / math_t(prms.n_rows - 1);
+  Matrix::power(singular_vals, explained_var, scalar, prms.n_components,
+                stream);
+
+  // the column major vars are normalized by n_rows, the explained variances
+  // by n_rows - 1
+  math_t total_vars_h;
+  updateHost(&total_vars_h, total_vars.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  total_vars_h *= math_t(prms.n_rows) / math_t(prms.n_rows - 1);
+  LinAlg::scalarMultiply(explained_var_ratio, explained_var,
+                         math_t(1) / total_vars_h, prms.n_components, stream);
+}
+
 /**
  * @brief perform fit operation for the pca. Generates eigenvectors, explained vars, singular vals, etc.
  * @input param handle: cuml handle object
@@ -91,6 +134,12 @@ void pcaFit(const cumlHandle_impl &handle, math_t *input, math_t *components,
 
   Stats::mean(mu, input, prms.n_cols, prms.n_rows, true, false, stream);
 
+  if (prms.algorithm == solver::RANDOMIZED) {
+    pcaFitRsvd(handle, input, components, explained_var, explained_var_ratio,
+               singular_vals, mu, prms, stream);
+    return;
+  }
+
   int len = prms.n_cols * prms.n_cols;
   device_buffer<math_t> cov(handle.getDeviceAllocator(), stream, len);
 
@@ -107,6 +156,110 @@ void pcaFit(const cumlHandle_impl &handle, math_t *input, math_t *components,
                  stream);
 }
 
+/**
+ * @brief updates the mean and the scatter matrix sum (x - mu) (x - mu)^T of
+ * the rows seen so far with a batch of rows, so that PCA can be fitted over
+ * more rows than the device holds: pcaPartialFit is called on the batches in
+ * turn, and pcaFitScatter then fits the components. The statistics are merged
+ * by the pairwise update of Chan et al., which stays accurate over many
+ * batches.
+ * @input param handle: cuml handle object
+ * @input param input: the batch of rows. Size n_rows x n_cols, as indicated in prms. It is restored on return.
+ * @input/output param mu: mean of all the rows seen so far. Size n_cols * 1.
+ * @input/output param scatter: scatter matrix of all the rows seen so far. Size n_cols * n_cols.
+ * @input/output param n_samples_seen: number of rows seen so far. mu and scatter are initialized by the first batch, when it is 0.
+ * @input param prms: data structure that includes all the parameters from input size to algorithm.
+ * @input param stream cuda stream
+ */
+template <typename math_t>
+void pcaPartialFit(const cumlHandle_impl &handle, math_t *input, math_t *mu,
+                   math_t *scatter, size_t *n_samples_seen, paramsPCA prms,
+                   cudaStream_t stream) {
+  auto cublas_handle = handle.getCublasHandle();
+
+  ASSERT(prms.n_cols > 1,
+         "Parameter n_cols: number of columns cannot be less than two");
+  ASSERT(prms.n_rows > 0,
+         "Parameter n_rows: number of rows cannot be less than one");
+
+  const size_t n_a = *n_samples_seen;
+  const size_t n_b = prms.n_rows;
+  const size_t n = n_a + n_b;
+  if (n_a == 0) {
+    CUDA_CHECK(cudaMemsetAsync(
+      scatter, 0, sizeof(math_t) * prms.n_cols * prms.n_cols, stream));
+  }
+
+  device_buffer<math_t> mu_b(handle.getDeviceAllocator(), stream, prms.n_cols);
+  Stats::mean(mu_b.data(), input, prms.n_cols, prms.n_rows, false, false,
+              stream);
+  Stats::meanCenter(input, input, mu_b.data(), prms.n_cols, prms.n_rows, false,
+                    true, stream);
+  math_t alpha = math_t(1);
+  math_t beta = math_t(1);
+  LinAlg::gemm(input, prms.n_rows, prms.n_cols, input, scatter, prms.n_cols,
+               prms.n_cols, CUBLAS_OP_T, CUBLAS_OP_N, alpha, beta,
+               cublas_handle, stream);
+  Stats::meanAdd(input, input, mu_b.data(), prms.n_cols, prms.n_rows, false,
+                 true, stream);
+
+  if (n_a == 0) {
+    copy(mu, mu_b.data(), prms.n_cols, stream);
+  } else {
+    // scatter += n_a n_b / n delta delta^T and mu += n_b / n delta, with
+    // delta = mu_b - mu
+    math_t *delta = mu_b.data();
+    LinAlg::subtract(delta, mu_b.data(), mu, prms.n_cols, stream);
+    alpha = math_t(double(n_a) * double(n_b) / double(n));
+    LinAlg::gemm(delta, prms.n_cols, 1, delta, scatter, prms.n_cols,
+                 prms.n_cols, CUBLAS_OP_N, CUBLAS_OP_T, alpha, beta,
+                 cublas_handle, stream);
+    LinAlg::scalarMultiply(delta, delta, math_t(double(n_b) / double(n)),
+                           prms.n_cols, stream);
+    LinAlg::add(mu, mu, delta, prms.n_cols, stream);
+  }
+  *n_samples_seen = n;
+}
+
+/**
+ * @brief fits the pca from the statistics accumulated by pcaPartialFit, as pcaFit does from the covariance of its input.
+ * @input param handle: cuml handle object
+ * @input param scatter: scatter matrix of the rows. Size n_cols * n_cols.
+ * @input param n_samples_seen: number of rows.
+ * @output param components: the principal components of the rows. Size n_cols * n_components.
+ * @output param explained_var: explained variances (eigenvalues) of the principal components. Size n_components * 1.
+ * @output param explained_var_ratio: the ratio of the explained variance and total variance. Size n_components * 1.
+ * @output param singular_vals: singular values of the data. Size n_components * 1
+ * @input param prms: data structure that includes all the parameters from input size to algorithm.
+ * @input param stream cuda stream
+ */
+template <typename math_t>
+void pcaFitScatter(const cumlHandle_impl &handle, const math_t *scatter,
+                   size_t n_samples_seen, math_t *components,
+                   math_t *explained_var, math_t *explained_var_ratio,
+                   math_t *singular_vals, paramsPCA prms,
+                   cudaStream_t stream) {
+  ASSERT(prms.n_cols > 1,
+         "Parameter n_cols: number of columns cannot be less than two");
+  ASSERT(n_samples_seen > 1,
+         "Parameter n_samples_seen: number of rows cannot be less than two");
+  ASSERT(
+    prms.n_components > 0,
+    "Parameter n_components: number of components cannot be less than one");
+
+  if (prms.n_components > prms.n_cols) prms.n_components = prms.n_cols;
+
+  int len = prms.n_cols * prms.n_cols;
+  device_buffer<math_t> cov(handle.getDeviceAllocator(), stream, len);
+  math_t scalar = math_t(n_samples_seen - 1);
+  LinAlg::scalarMultiply(cov.data(), scatter, math_t(1) / scalar, len, stream);
+
+  truncCompExpVars(handle, cov.data(), components, explained_var,
+                   explained_var_ratio, prms, stream);
+  Matrix::seqRoot(explained_var, singular_vals, scalar, prms.n_components,
+                  stream, true);
+}
+
 /**
  * @brief perform fit and transform operations for the pca. Generates transformed data, eigenvectors, explained vars, singular vals, etc.
  * @input param handle: cuml handle object
@@ -208,10 +361,11 @@ void pcaScoreSamples() {
 /**
  * @brief performs transform operation for the pca. Transforms the data to eigenspace.
  * @input param handle: the internal cuml handle object
- * @input param input: the data is transformed. Size n_rows x n_components.
+ * @input param input: the data is transformed. Size n_rows x n_cols. It is not modified.
  * @input param components: principal components of the input data. Size n_cols * n_components.
  * @output param trans_input:  the transformed data. Size n_rows * n_components.
  * @input param singular_vals: singular values of the data. Size n_components * 1.
+ * @input param mu: mean of features (every column).
  * @input param prms: data structure that includes all the parameters from input size to algorithm.
  * @input param stream cuda stream
  */
@@ -228,28 +382,32 @@ void pcaTransform(const cumlHandle_impl &handle, math_t *input,
     prms.n_components > 0,
     "Parameter n_components: number of components cannot be less than one");
 
-  if (prms.whiten) {
-    math_t scalar = math_t(sqrt(prms.n_rows - 1));
-    LinAlg::scalarMultiply(components, components, scalar,
-                           prms.n_rows * prms.n_components, stream);
-    Matrix::matrixVectorBinaryDivSkipZero(components, singular_vals,
-                                          prms.n_rows, prms.n_components, true,
-                                          true, stream);
-  }
-
-  Stats::meanCenter(input, input, mu, prms.n_cols, prms.n_rows, false, true,
-                    stream);
+  // (x - mu) W^T = x W^T - (W mu)^T: the mean is subtracted from the
+  // product, in the same pass as the whitening, so that the input is only
+  // read by the gemm
+  auto cublas_handle = handle.getCublasHandle();
+  device_buffer<math_t> mu_trans(handle.getDeviceAllocator(), stream,
+                                 prms.n_components);
+  math_t alpha = math_t(1);
+  math_t beta = math_t(0);
+  LinAlg::gemm(components, prms.n_components, prms.n_cols, mu,
+               mu_trans.data(), prms.n_components, 1, CUBLAS_OP_N, CUBLAS_OP_N,
+               alpha, beta, cublas_handle, stream);
   tsvdTransform(handle, input, components, trans_input, prms, stream);
-  Stats::meanAdd(input, input, mu, prms.n_cols, prms.n_rows, false, true,
-                 stream);
 
   if (prms.whiten) {
-    Matrix::matrixVectorBinaryMultSkipZero(components, singular_vals,
-                                           prms.n_rows, prms.n_components, true,
-                                           true, stream);
-    math_t scalar = math_t(1 / sqrt(prms.n_rows - 1));
-    LinAlg::scalarMultiply(components, components, scalar,
-                           prms.n_rows * prms.n_components, stream);
+    math_t scalar = math_t(sqrt(prms.n_rows - 1));
+    LinAlg::matrixVectorOp(
+      trans_input, trans_input, mu_trans.data(), singular_vals,
+      prms.n_components, prms.n_rows, false, true,
+      [scalar] __device__(math_t a, math_t m, math_t s) {
+        a = (a - m) * scalar;
+        return myAbs(s) < math_t(1e-10) ? a : a / s;
+      },
+      stream);
+  } else {
+    Stats::meanCenter(trans_input, trans_input, mu_trans.data(),
+                      prms.n_components, prms.n_rows, false, true, stream);
   }
 }
 
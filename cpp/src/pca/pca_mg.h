@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <common/cuml_comms_int.hpp>
+#include <stats/sum.h>
+#include "pca/pca.h"
+
+namespace ML {
+
+/**
+ * @brief perform fit operation for the pca on the rows of all the ranks of the communicator of the handle, each rank
+ * holding a shard of the rows. The column sums and the row counts are summed by a first allreduce to get the mean,
+ * and the scatter matrices of the local rows about it by a second one. Every rank then computes the same components,
+ * as pcaFit.
+ * @input param handle: the internal cuml handle object, with a communicator
+ * @input param input: the local rows. Size n_rows x n_cols, n_rows being the number of local rows in prms.
+ * @output param components: the principal components of the input data. Size n_cols * n_components.
+ * @output param explained_var: explained variances (eigenvalues) of the principal components. Size n_components * 1.
+ * @output param explained_var_ratio: the ratio of the explained variance and total variance. Size n_components * 1.
+ * @output param singular_vals: singular values of the data. Size n_components * 1
+ * @output param mu: mean of all the features over all the ranks. Size n_cols * 1.
+ * @output param noise_vars: variance of the noise. Size 1 * 1 (scalar).
+ * @input param prms: data structure that includes all the parameters from input size to algorithm.
+ * @input param stream cuda stream
+ */
+template <typename math_t>
+void pcaFitMG(const cumlHandle_impl &handle, math_t *input, math_t *components,
+              math_t *explained_var, math_t *explained_var_ratio,
+              math_t *singular_vals, math_t *mu, math_t *noise_vars,
+              paramsPCA prms, cudaStream_t stream) {
+  ASSERT(handle.commsInitialized(),
+         "A distributed PCA requires a handle with a communicator");
+  const MLCommon::cumlCommunicator &comm = handle.getCommunicator();
+  auto cublas_handle = handle.getCublasHandle();
+  auto allocator = handle.getDeviceAllocator();
+
+  ASSERT(prms.n_cols > 1,
+         "Parameter n_cols: number of columns cannot be less than two");
+  ASSERT(prms.n_rows > 0,
+         "Parameter n_rows: number of local rows cannot be less than one");
+  ASSERT(
+    prms.n_components > 0,
+    "Parameter n_components: number of components cannot be less than one");
+
+  if (prms.n_components > prms.n_cols) prms.n_components = prms.n_cols;
+
+  // the column sums, followed by the number of rows
+  device_buffer<math_t> sums(allocator, stream, prms.n_cols + 1);
+  Stats::sum(sums.data(), input, prms.n_cols, prms.n_rows, false, stream);
+  math_t n_local = math_t(prms.n_rows);
+  updateDevice(sums.data() + prms.n_cols, &n_local, 1, stream);
+  comm.allreduce(sums.data(), sums.data(), prms.n_cols + 1,
+                 MLCommon::cumlCommunicator::SUM, stream);
+  math_t n_total;
+  updateHost(&n_total, sums.data() + prms.n_cols, 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  ASSERT(n_total > math_t(1),
+         "Parameter n_rows: number of rows cannot be less than two");
+  LinAlg::scalarMultiply(mu, sums.data(), math_t(1) / n_total, prms.n_cols,
+                         stream);
+
+  int len = prms.n_cols * prms.n_cols;
+  device_buffer<math_t> cov(allocator, stream, len);
+  Stats::meanCenter(input, input, mu, prms.n_cols, prms.n_rows, false, true,
+                    stream);
+  math_t alpha = math_t(1) / (n_total - math_t(1));
+  math_t beta = math_t(0);
+  LinAlg::gemm(input, prms.n_rows, prms.n_cols, input, cov.data(), prms.n_cols,
+               prms.n_cols, CUBLAS_OP_T, CUBLAS_OP_N, alpha, beta,
+               cublas_handle, stream);
+  Stats::meanAdd(input, input, mu, prms.n_cols, prms.n_rows, false, true,
+                 stream);
+  comm.allreduce(cov.data(), cov.data(), len, MLCommon::cumlCommunicator::SUM,
+                 stream);
+
+  truncCompExpVars(handle, cov.data(), components, explained_var,
+                   explained_var_ratio, prms, stream);
+
+  math_t scalar = n_total - math_t(1);
+  Matrix::seqRoot(explained_var, singular_vals, scalar, prms.n_components,
+                  stream, true);
+}
+
+};  // end namespace ML
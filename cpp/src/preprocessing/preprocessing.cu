@@ -0,0 +1,620 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <thrust/execution_policy.h>
+#include <thrust/fill.h>
+#include <thrust/sequence.h>
+#include <algorithm>
+#include <climits>
+#include <cub/cub.cuh>
+#include <cuml/preprocessing/preprocessing.hpp>
+#include "common/cumlHandle.hpp"
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "stats/mean.h"
+#include "stats/minmax.h"
+#include "stats/stddev.h"
+
+namespace ML {
+namespace Preprocessing {
+
+using namespace MLCommon;
+
+static const int TPB = 256;
+
+/** index of the element (i, j) of an output of n_rows rows and width columns
+ */
+HDI size_t out_index(int i, int j, int n_rows, int width, bool row_major) {
+  return row_major ? size_t(i) * width + j : size_t(j) * n_rows + i;
+}
+
+/** number of blocks of a grid-stride loop over len elements */
+inline int grid_size(size_t len) {
+  return int(std::min<size_t>(ceildiv<size_t>(len, TPB),
+                              8 * getMultiProcessorCount()));
+}
+
+/** out(i, j) = op(X(i, j), j), in the layout of the output */
+template <typename T, typename Lambda>
+__global__ void map_kernel(T* out, const T* X, int n_rows, int n_cols,
+                           bool out_row_major, Lambda op) {
+  size_t len = size_t(n_rows) * n_cols;
+  for (size_t idx = size_t(blockIdx.x) * blockDim.x + threadIdx.x; idx < len;
+       idx += size_t(gridDim.x) * blockDim.x) {
+    int i = idx % n_rows, j = idx / n_rows;
+    out[out_index(i, j, n_rows, n_cols, out_row_major)] = op(X[idx], j);
+  }
+}
+
+/** out(i, op(X(i, j), j)) = 1 when op does not return -1, out being zeroed */
+template <typename T, typename Lambda>
+__global__ void one_hot_kernel(T* out, const T* X, int n_rows, int n_cols,
+                               int width, bool out_row_major, Lambda op) {
+  size_t len = size_t(n_rows) * n_cols;
+  for (size_t idx = size_t(blockIdx.x) * blockDim.x + threadIdx.x; idx < len;
+       idx += size_t(gridDim.x) * blockDim.x) {
+    int i = idx % n_rows, j = idx / n_rows;
+    int col = op(X[idx], j);
+    if (col >= 0) out[out_index(i, col, n_rows, width, out_row_major)] = T(1);
+  }
+}
+
+template <typename T, typename Lambda>
+void map_columns(T* out, const T* X, int n_rows, int n_cols,
+                 bool out_row_major, Lambda op, cudaStream_t stream) {
+  size_t len = size_t(n_rows) * n_cols;
+  if (len == 0) return;
+  map_kernel<<<grid_size(len), TPB, 0, stream>>>(out, X, n_rows, n_cols,
+                                                 out_row_major, op);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+template <typename T, typename Lambda>
+void one_hot_columns(T* out, const T* X, int n_rows, int n_cols, int width,
+                     bool out_row_major, Lambda op, cudaStream_t stream) {
+  CUDA_CHECK(cudaMemsetAsync(out, 0, size_t(n_rows) * width * sizeof(T),
+                             stream));
+  size_t len = size_t(n_rows) * n_cols;
+  if (len == 0) return;
+  one_hot_kernel<<<grid_size(len), TPB, 0, stream>>>(
+    out, X, n_rows, n_cols, width, out_row_major, op);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/** sort each column of X into sorted */
+template <typename T>
+void sort_columns(T* sorted, const T* X, int n_rows, int n_cols,
+                  std::shared_ptr<deviceAllocator> allocator,
+                  cudaStream_t stream) {
+  ASSERT(size_t(n_rows) * n_cols <= size_t(INT_MAX),
+         "sort_columns: n_rows * n_cols must fit in an int");
+  int len = n_rows * n_cols;
+  device_buffer<int> offsets(allocator, stream, n_cols + 1);
+  thrust::sequence(thrust::cuda::par.on(stream), offsets.data(),
+                   offsets.data() + n_cols + 1, 0, n_rows);
+  size_t temp_bytes = 0;
+  CUDA_CHECK(cub::DeviceSegmentedRadixSort::SortKeys(
+    nullptr, temp_bytes, X, sorted, len, n_cols, offsets.data(),
+    offsets.data() + 1, 0, 8 * sizeof(T), stream));
+  device_buffer<char> temp(allocator, stream, temp_bytes);
+  CUDA_CHECK(cub::DeviceSegmentedRadixSort::SortKeys(
+    temp.data(), temp_bytes, X, sorted, len, n_cols, offsets.data(),
+    offsets.data() + 1, 0, 8 * sizeof(T), stream));
+}
+
+/** flag the first occurrence of each value of the sorted columns */
+template <typename T>
+__global__ void unique_flags_kernel(char* flags, int* cols, const T* sorted,
+                                    int n_rows, int n_cols) {
+  size_t len = size_t(n_rows) * n_cols;
+  for (size_t idx = size_t(blockIdx.x) * blockDim.x + threadIdx.x; idx < len;
+       idx += size_t(gridDim.x) * blockDim.x) {
+    int i = idx % n_rows;
+    flags[idx] = i == 0 || sorted[idx] != sorted[idx - 1];
+    cols[idx] = idx / n_rows;
+  }
+}
+
+/** edges(b, j) = op(j, b) for the n_bins + 1 edges of each feature */
+template <typename T, typename Lambda>
+__global__ void edges_kernel(T* edges, int n_cols, int n_bins, Lambda op) {
+  int len = n_cols * (n_bins + 1);
+  for (int idx = blockIdx.x * blockDim.x + threadIdx.x; idx < len;
+       idx += gridDim.x * blockDim.x) {
+    edges[idx] = op(idx / (n_bins + 1), idx % (n_bins + 1));
+  }
+}
+
+/** index of x in the sorted categories of feature j, -1 if not there */
+template <typename T>
+DI int category_index(const T* values, const int* offsets, int j, T x) {
+  int lo = offsets[j], hi = offsets[j + 1];
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (values[mid] < x)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo < offsets[j + 1] && values[lo] == x ? lo - offsets[j] : -1;
+}
+
+/** bin of x among the n_bins + 1 edges, with the tolerance of sklearn */
+template <typename T>
+DI int bin_index(const T* edges, int n_bins, T x) {
+  x += T(1e-8) + T(1e-5) * myAbs(x);
+  // the number of interior edges <= x
+  int lo = 1, hi = n_bins;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (edges[mid] <= x)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo - 1;
+}
+
+/**
+ * The categories concatenated on the device, those of feature j being
+ * values[offsets[j]:offsets[j + 1]]
+ */
+template <typename T>
+struct DeviceCategories {
+  device_buffer<T> values;
+  device_buffer<int> offsets;
+
+  DeviceCategories(const std::vector<std::vector<T>>& categories,
+                   int n_cols, std::shared_ptr<deviceAllocator> allocator,
+                   cudaStream_t stream)
+    : values(allocator, stream), offsets(allocator, stream, n_cols + 1) {
+    ASSERT(categories.size() == size_t(n_cols),
+           "Preprocessing: categories must have n_cols features");
+    std::vector<int> h_offsets(n_cols + 1, 0);
+    std::vector<T> h_values;
+    for (int j = 0; j < n_cols; ++j) {
+      h_values.insert(h_values.end(), categories[j].begin(),
+                      categories[j].end());
+      h_offsets[j + 1] = h_values.size();
+    }
+    values.resize(h_values.size(), stream);
+    updateDevice(values.data(), h_values.data(), h_values.size(), stream);
+    updateDevice(offsets.data(), h_offsets.data(), n_cols + 1, stream);
+    // the host vectors do not outlive the copies
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    width = h_values.size();
+  }
+
+  /** total number of categories */
+  int width;
+};
+
+template <typename T>
+void standard_scaler_fit_helper(const cumlHandle& handle, const T* X,
+                                int n_rows, int n_cols, T* mean, T* scale,
+                                bool with_std) {
+  ASSERT(n_rows > 0 && n_cols > 0,
+         "standardScalerFit: n_rows and n_cols must be positive");
+  cudaStream_t stream = handle.getStream();
+  Stats::mean(mean, X, n_cols, n_rows, false, false, stream);
+  if (with_std) {
+    Stats::stddev(scale, X, mean, n_cols, n_rows, false, false, stream);
+    // the constant features are left alone, as sklearn does
+    map_columns(
+      scale, scale, n_cols, 1, false,
+      [] __device__(T s, int j) { return s == T(0) ? T(1) : s; }, stream);
+  } else {
+    thrust::fill(thrust::cuda::par.on(stream), scale, scale + n_cols, T(1));
+  }
+}
+
+template <typename T>
+void standard_scaler_transform_helper(const cumlHandle& handle, const T* X,
+                                      int n_rows, int n_cols, const T* mean,
+                                      const T* scale, bool with_mean,
+                                      bool with_std, T* out,
+                                      bool out_row_major) {
+  map_columns(
+    out, X, n_rows, n_cols, out_row_major,
+    [=] __device__(T x, int j) {
+      if (with_mean) x -= mean[j];
+      return with_std ? x / scale[j] : x;
+    },
+    handle.getStream());
+}
+
+template <typename T>
+void min_max_scaler_fit_helper(const cumlHandle& handle, const T* X,
+                               int n_rows, int n_cols, T* data_min,
+                               T* data_max) {
+  ASSERT(n_rows > 0 && n_cols > 0,
+         "minMaxScalerFit: n_rows and n_cols must be positive");
+  Stats::minmax(X, (const unsigned*)nullptr, (const unsigned*)nullptr, n_rows,
+                n_cols, n_rows, data_min, data_max, (T*)nullptr,
+                handle.getStream());
+}
+
+template <typename T>
+void min_max_scaler_transform_helper(const cumlHandle& handle, const T* X,
+                                     int n_rows, int n_cols,
+                                     const T* data_min, const T* data_max,
+                                     T feature_min, T feature_max, T* out,
+                                     bool out_row_major) {
+  ASSERT(feature_min < feature_max,
+         "minMaxScalerTransform: feature_min must be less than feature_max");
+  map_columns(
+    out, X, n_rows, n_cols, out_row_major,
+    [=] __device__(T x, int j) {
+      T range = data_max[j] - data_min[j];
+      if (range == T(0)) range = T(1);
+      return (x - data_min[j]) / range * (feature_max - feature_min) +
+             feature_min;
+    },
+    handle.getStream());
+}
+
+template <typename T>
+void encoder_fit_helper(const cumlHandle& handle, const T* X, int n_rows,
+                        int n_cols, std::vector<std::vector<T>>& categories) {
+  ASSERT(n_rows > 0 && n_cols > 0,
+         "encoderFit: n_rows and n_cols must be positive");
+  cudaStream_t stream = handle.getStream();
+  auto allocator = handle.getDeviceAllocator();
+  device_buffer<T> sorted(allocator, stream, size_t(n_rows) * n_cols);
+  // which checks that the number of elements fits in an int
+  sort_columns(sorted.data(), X, n_rows, n_cols, allocator, stream);
+  int len = n_rows * n_cols;
+
+  device_buffer<char> flags(allocator, stream, len);
+  device_buffer<int> cols(allocator, stream, len);
+  unique_flags_kernel<<<grid_size(len), TPB, 0, stream>>>(
+    flags.data(), cols.data(), sorted.data(), n_rows, n_cols);
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  // the unique values and their features, in the same order
+  device_buffer<T> uniques(allocator, stream, len);
+  device_buffer<int> unique_cols(allocator, stream, len);
+  device_buffer<int> n_selected(allocator, stream, 1);
+  size_t values_bytes = 0, cols_bytes = 0;
+  CUDA_CHECK(cub::DeviceSelect::Flagged(nullptr, values_bytes, sorted.data(),
+                                        flags.data(), uniques.data(),
+                                        n_selected.data(), len, stream));
+  CUDA_CHECK(cub::DeviceSelect::Flagged(nullptr, cols_bytes, cols.data(),
+                                        flags.data(), unique_cols.data(),
+                                        n_selected.data(), len, stream));
+  size_t temp_bytes = std::max(values_bytes, cols_bytes);
+  device_buffer<char> temp(allocator, stream, temp_bytes);
+  CUDA_CHECK(cub::DeviceSelect::Flagged(temp.data(), temp_bytes,
+                                        sorted.data(), flags.data(),
+                                        uniques.data(), n_selected.data(),
+                                        len, stream));
+  CUDA_CHECK(cub::DeviceSelect::Flagged(temp.data(), temp_bytes, cols.data(),
+                                        flags.data(), unique_cols.data(),
+                                        n_selected.data(), len, stream));
+
+  int n_unique;
+  updateHost(&n_unique, n_selected.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  std::vector<T> h_uniques(n_unique);
+  std::vector<int> h_cols(n_unique);
+  updateHost(h_uniques.data(), uniques.data(), n_unique, stream);
+  updateHost(h_cols.data(), unique_cols.data(), n_unique, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  categories.assign(n_cols, std::vector<T>());
+  for (int k = 0; k < n_unique; ++k) {
+    categories[h_cols[k]].push_back(h_uniques[k]);
+  }
+}
+
+template <typename T>
+void ordinal_encoder_transform_helper(
+  const cumlHandle& handle, const T* X, int n_rows, int n_cols,
+  const std::vector<std::vector<T>>& categories, T* out, bool out_row_major) {
+  cudaStream_t stream = handle.getStream();
+  DeviceCategories<T> cats(categories, n_cols, handle.getDeviceAllocator(),
+                           stream);
+  const T* values = cats.values.data();
+  const int* offsets = cats.offsets.data();
+  map_columns(
+    out, X, n_rows, n_cols, out_row_major,
+    [=] __device__(T x, int j) {
+      return T(category_index(values, offsets, j, x));
+    },
+    stream);
+}
+
+template <typename T>
+void one_hot_encoder_transform_helper(
+  const cumlHandle& handle, const T* X, int n_rows, int n_cols,
+  const std::vector<std::vector<T>>& categories, T* out, bool out_row_major) {
+  cudaStream_t stream = handle.getStream();
+  DeviceCategories<T> cats(categories, n_cols, handle.getDeviceAllocator(),
+                           stream);
+  const T* values = cats.values.data();
+  const int* offsets = cats.offsets.data();
+  one_hot_columns(
+    out, X, n_rows, n_cols, cats.width, out_row_major,
+    [=] __device__(T x, int j) {
+      int k = category_index(values, offsets, j, x);
+      return k < 0 ? -1 : offsets[j] + k;
+    },
+    stream);
+}
+
+template <typename T>
+void k_bins_discretizer_fit_helper(const cumlHandle& handle, const T* X,
+                                   int n_rows, int n_cols, int n_bins,
+                                   KBinsStrategy strategy, T* bin_edges) {
+  ASSERT(n_rows > 0 && n_cols > 0,
+         "kBinsDiscretizerFit: n_rows and n_cols must be positive");
+  ASSERT(n_bins >= 2, "kBinsDiscretizerFit: n_bins must be at least 2");
+  cudaStream_t stream = handle.getStream();
+  auto allocator = handle.getDeviceAllocator();
+  int n_edges = n_cols * (n_bins + 1);
+  if (strategy == KBINS_UNIFORM) {
+    device_buffer<T> data_min(allocator, stream, n_cols);
+    device_buffer<T> data_max(allocator, stream, n_cols);
+    min_max_scaler_fit_helper(handle, X, n_rows, n_cols, data_min.data(),
+                              data_max.data());
+    const T* dmin = data_min.data();
+    const T* dmax = data_max.data();
+    edges_kernel<<<ceildiv(n_edges, TPB), TPB, 0, stream>>>(
+      bin_edges, n_cols, n_bins, [=] __device__(int j, int b) {
+        return b == n_bins ? dmax[j]
+                           : dmin[j] + (dmax[j] - dmin[j]) * T(b) / n_bins;
+      });
+    CUDA_CHECK(cudaPeekAtLastError());
+  } else {
+    ASSERT(strategy == KBINS_QUANTILE,
+           "kBinsDiscretizerFit: unknown strategy %d", int(strategy));
+    device_buffer<T> sorted(allocator, stream, size_t(n_rows) * n_cols);
+    sort_columns(sorted.data(), X, n_rows, n_cols, allocator, stream);
+    const T* s = sorted.data();
+    edges_kernel<<<ceildiv(n_edges, TPB), TPB, 0, stream>>>(
+      bin_edges, n_cols, n_bins, [=] __device__(int j, int b) {
+        // the linear interpolation of numpy.percentile
+        const T* col = s + size_t(j) * n_rows;
+        T pos = T(b) * (n_rows - 1) / n_bins;
+        int lo = min(int(pos), n_rows - 1);
+        int hi = min(lo + 1, n_rows - 1);
+        return col[lo] + (pos - T(lo)) * (col[hi] - col[lo]);
+      });
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+}
+
+template <typename T>
+void k_bins_discretizer_transform_helper(const cumlHandle& handle,
+                                         const T* X, int n_rows, int n_cols,
+                                         int n_bins, const T* bin_edges,
+                                         bool one_hot, T* out,
+                                         bool out_row_major) {
+  ASSERT(n_bins >= 2, "kBinsDiscretizerTransform: n_bins must be at least 2");
+  cudaStream_t stream = handle.getStream();
+  if (one_hot) {
+    one_hot_columns(
+      out, X, n_rows, n_cols, n_cols * n_bins, out_row_major,
+      [=] __device__(T x, int j) {
+        return j * n_bins +
+               bin_index(bin_edges + size_t(j) * (n_bins + 1), n_bins, x);
+      },
+      stream);
+  } else {
+    map_columns(
+      out, X, n_rows, n_cols, out_row_major,
+      [=] __device__(T x, int j) {
+        return T(bin_index(bin_edges + size_t(j) * (n_bins + 1), n_bins, x));
+      },
+      stream);
+  }
+}
+
+void standardScalerFit(const cumlHandle& handle, const float* X, int n_rows,
+                       int n_cols, float* mean, float* scale, bool with_std) {
+  standard_scaler_fit_helper(handle, X, n_rows, n_cols, mean, scale,
+                             with_std);
+}
+
+void standardScalerFit(const cumlHandle& handle, const double* X, int n_rows,
+                       int n_cols, double* mean, double* scale,
+                       bool with_std) {
+  standard_scaler_fit_helper(handle, X, n_rows, n_cols, mean, scale,
+                             with_std);
+}
+
+void standardScalerTransform(const cumlHandle& handle, const float* X,
+                             int n_rows, int n_cols, const float* mean,
+                             const float* scale, bool with_mean, bool with_std,
+                             float* out, bool out_row_major) {
+  standard_scaler_transform_helper(handle, X, n_rows, n_cols, mean, scale,
+                                   with_mean, with_std, out, out_row_major);
+}
+
+void standardScalerTransform(const cumlHandle& handle, const double* X,
+                             int n_rows, int n_cols, const double* mean,
+                             const double* scale, bool with_mean,
+                             bool with_std, double* out, bool out_row_major) {
+  standard_scaler_transform_helper(handle, X, n_rows, n_cols, mean, scale,
+                                   with_mean, with_std, out, out_row_major);
+}
+
+void standardScalerFitTransform(const cumlHandle& handle, const float* X,
+                                int n_rows, int n_cols, float* mean,
+                                float* scale, bool with_mean, bool with_std,
+                                float* out, bool out_row_major) {
+  standard_scaler_fit_helper(handle, X, n_rows, n_cols, mean, scale,
+                             with_std);
+  standard_scaler_transform_helper(handle, X, n_rows, n_cols, mean, scale,
+                                   with_mean, with_std, out, out_row_major);
+}
+
+void standardScalerFitTransform(const cumlHandle& handle, const double* X,
+                                int n_rows, int n_cols, double* mean,
+                                double* scale, bool with_mean, bool with_std,
+                                double* out, bool out_row_major) {
+  standard_scaler_fit_helper(handle, X, n_rows, n_cols, mean, scale,
+                             with_std);
+  standard_scaler_transform_helper(handle, X, n_rows, n_cols, mean, scale,
+                                   with_mean, with_std, out, out_row_major);
+}
+
+void minMaxScalerFit(const cumlHandle& handle, const float* X, int n_rows,
+                     int n_cols, float* data_min, float* data_max) {
+  min_max_scaler_fit_helper(handle, X, n_rows, n_cols, data_min, data_max);
+}
+
+void minMaxScalerFit(const cumlHandle& handle, const double* X, int n_rows,
+                     int n_cols, double* data_min, double* data_max) {
+  min_max_scaler_fit_helper(handle, X, n_rows, n_cols, data_min, data_max);
+}
+
+void minMaxScalerTransform(const cumlHandle& handle, const float* X,
+                           int n_rows, int n_cols, const float* data_min,
+                           const float* data_max, float feature_min,
+                           float feature_max, float* out, bool out_row_major) {
+  min_max_scaler_transform_helper(handle, X, n_rows, n_cols, data_min,
+                                  data_max, feature_min, feature_max, out,
+                                  out_row_major);
+}
+
+void minMaxScalerTransform(const cumlHandle& handle, const double* X,
+                           int n_rows, int n_cols, const double* data_min,
+                           const double* data_max, double feature_min,
+                           double feature_max, double* out,
+                           bool out_row_major) {
+  min_max_scaler_transform_helper(handle, X, n_rows, n_cols, data_min,
+                                  data_max, feature_min, feature_max, out,
+                                  out_row_major);
+}
+
+void minMaxScalerFitTransform(const cumlHandle& handle, const float* X,
+                              int n_rows, int n_cols, float* data_min,
+                              float* data_max, float feature_min,
+                              float feature_max, float* out,
+                              bool out_row_major) {
+  min_max_scaler_fit_helper(handle, X, n_rows, n_cols, data_min, data_max);
+  min_max_scaler_transform_helper(handle, X, n_rows, n_cols, data_min,
+                                  data_max, feature_min, feature_max, out,
+                                  out_row_major);
+}
+
+void minMaxScalerFitTransform(const cumlHandle& handle, const double* X,
+                              int n_rows, int n_cols, double* data_min,
+                              double* data_max, double feature_min,
+                              double feature_max, double* out,
+                              bool out_row_major) {
+  min_max_scaler_fit_helper(handle, X, n_rows, n_cols, data_min, data_max);
+  min_max_scaler_transform_helper(handle, X, n_rows, n_cols, data_min,
+                                  data_max, feature_min, feature_max, out,
+                                  out_row_major);
+}
+
+void encoderFit(const cumlHandle& handle, const float* X, int n_rows,
+                int n_cols, std::vector<std::vector<float>>& categories) {
+  encoder_fit_helper(handle, X, n_rows, n_cols, categories);
+}
+
+void encoderFit(const cumlHandle& handle, const double* X, int n_rows,
+                int n_cols, std::vector<std::vector<double>>& categories) {
+  encoder_fit_helper(handle, X, n_rows, n_cols, categories);
+}
+
+void ordinalEncoderTransform(
+  const cumlHandle& handle, const float* X, int n_rows, int n_cols,
+  const std::vector<std::vector<float>>& categories, float* out,
+  bool out_row_major) {
+  ordinal_encoder_transform_helper(handle, X, n_rows, n_cols, categories, out,
+                                   out_row_major);
+}
+
+void ordinalEncoderTransform(
+  const cumlHandle& handle, const double* X, int n_rows, int n_cols,
+  const std::vector<std::vector<double>>& categories, double* out,
+  bool out_row_major) {
+  ordinal_encoder_transform_helper(handle, X, n_rows, n_cols, categories, out,
+                                   out_row_major);
+}
+
+void oneHotEncoderTransform(const cumlHandle& handle, const float* X,
+                            int n_rows, int n_cols,
+                            const std::vector<std::vector<float>>& categories,
+                            float* out, bool out_row_major) {
+  one_hot_encoder_transform_helper(handle, X, n_rows, n_cols, categories, out,
+                                   out_row_major);
+}
+
+void oneHotEncoderTransform(
+  const cumlHandle& handle, const double* X, int n_rows, int n_cols,
+  const std::vector<std::vector<double>>& categories, double* out,
+  bool out_row_major) {
+  one_hot_encoder_transform_helper(handle, X, n_rows, n_cols, categories, out,
+                                   out_row_major);
+}
+
+void kBinsDiscretizerFit(const cumlHandle& handle, const float* X, int n_rows,
+                         int n_cols, int n_bins, KBinsStrategy strategy,
+                         float* bin_edges) {
+  k_bins_discretizer_fit_helper(handle, X, n_rows, n_cols, n_bins, strategy,
+                                bin_edges);
+}
+
+void kBinsDiscretizerFit(const cumlHandle& handle, const double* X,
+                         int n_rows, int n_cols, int n_bins,
+                         KBinsStrategy strategy, double* bin_edges) {
+  k_bins_discretizer_fit_helper(handle, X, n_rows, n_cols, n_bins, strategy,
+                                bin_edges);
+}
+
+void kBinsDiscretizerTransform(const cumlHandle& handle, const float* X,
+                               int n_rows, int n_cols, int n_bins,
+                               const float* bin_edges, bool one_hot,
+                               float* out, bool out_row_major) {
+  k_bins_discretizer_transform_helper(handle, X, n_rows, n_cols, n_bins,
+                                      bin_edges, one_hot, out, out_row_major);
+}
+
+void kBinsDiscretizerTransform(const cumlHandle& handle, const double* X,
+                               int n_rows, int n_cols, int n_bins,
+                               const double* bin_edges, bool one_hot,
+                               double* out, bool out_row_major) {
+  k_bins_discretizer_transform_helper(handle, X, n_rows, n_cols, n_bins,
+                                      bin_edges, one_hot, out, out_row_major);
+}
+
+void kBinsDiscretizerFitTransform(const cumlHandle& handle, const float* X,
+                                  int n_rows, int n_cols, int n_bins,
+                                  KBinsStrategy strategy, float* bin_edges,
+                                  bool one_hot, float* out,
+                                  bool out_row_major) {
+  k_bins_discretizer_fit_helper(handle, X, n_rows, n_cols, n_bins, strategy,
+                                bin_edges);
+  k_bins_discretizer_transform_helper(handle, X, n_rows, n_cols, n_bins,
+                                      bin_edges, one_hot, out, out_row_major);
+}
+
+void kBinsDiscretizerFitTransform(const cumlHandle& handle, const double* X,
+                                  int n_rows, int n_cols, int n_bins,
+                                  KBinsStrategy strategy, double* bin_edges,
+                                  bool one_hot, double* out,
+                                  bool out_row_major) {
+  k_bins_discretizer_fit_helper(handle, X, n_rows, n_cols, n_bins, strategy,
+                                bin_edges);
+  k_bins_discretizer_transform_helper(handle, X, n_rows, n_cols, n_bins,
+                                      bin_edges, one_hot, out, out_row_major);
+}
+
+}  // namespace Preprocessing
+}  // namespace ML
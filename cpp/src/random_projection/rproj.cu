@@ -31,5 +31,15 @@ template void RPROJtransform(const cumlHandle& handle, float* input,
 template void RPROJtransform(const cumlHandle& handle, double* input,
                              rand_mat<double>* random_matrix, double* output,
                              paramsRPROJ* params);
+template void RPROJtransformSparse(const cumlHandle& handle,
+                                   const float* values, const int* cols,
+                                   const int* row_ids, int nnz,
+                                   rand_mat<float>* random_matrix,
+                                   float* output, paramsRPROJ* params);
+template void RPROJtransformSparse(const cumlHandle& handle,
+                                   const double* values, const int* cols,
+                                   const int* row_ids, int nnz,
+                                   rand_mat<double>* random_matrix,
+                                   double* output, paramsRPROJ* params);
 
 };  // namespace ML
@@ -16,16 +16,17 @@
 
 #pragma once
 
-#include <vector>
-#include <unordered_set>
-#include <random>
+#include <thrust/execution_policy.h>
+#include <thrust/scan.h>
 
 #include <cuml/random_projection/rproj_c.h>
 #include "utils.hxx"
 #include <linalg/cublas_wrappers.h>
 #include <linalg/cusparse_wrappers.h>
 #include <cuda_utils.h>
+#include <common/allocatorAdapter.hpp>
 #include <common/cumlHandle.hpp>
+#include <common/device_buffer.hpp>
 
 namespace ML {
 
@@ -74,44 +75,45 @@ namespace ML {
 		}
 		else
 		{
-			auto alloc = h.getHostAllocator();
-
-			double max_total_density = params.density * 1.2;
-			size_t indices_alloc = (params.n_features * params.n_components * max_total_density) * sizeof(int);
-			size_t indptr_alloc = (params.n_components + 1) * sizeof(int);
-			int* indices = (int*)alloc->allocate(indices_alloc, stream);
-			int* indptr = (int*)alloc->allocate(indptr_alloc, stream);
-
-			size_t offset = 0;
-			size_t indices_idx = 0;
-			size_t indptr_idx = 0;
-
-			for (size_t i = 0; i < params.n_components; i++)
-			{
-				int n_nonzero = binomial(h, params.n_features, params.density, params.random_state);
-				sample_without_replacement(params.n_features, n_nonzero, indices, indices_idx);
-				indptr[indptr_idx] = offset;
-				indptr_idx++;
-				offset += n_nonzero;
-			}
-
-			indptr[indptr_idx] = offset;
-
-			size_t len = offset;
-            random_matrix->indices = (int*)d_alloc->allocate(len * sizeof(int), stream);
-			updateDevice(random_matrix->indices, indices, len, stream);
-			alloc->deallocate(indices, indices_alloc, stream);
-
-			len = indptr_idx+1;
-            random_matrix->indptr = (int*)d_alloc->allocate(len * sizeof(int), stream);
-			updateDevice(random_matrix->indptr, indptr, len, stream);
-			alloc->deallocate(indptr, indptr_alloc, stream);
-
-			len = offset;
-            random_matrix->sparse_data = (math_t*)d_alloc->allocate(len * sizeof(math_t), stream);
-			auto rng = Random::Rng(params.random_state);
+			// the non zeros are counted by a first walk over the matrix on
+			// device and written by a second one, so that only the CSC
+			// arrays are allocated
+			int n_chunks = ceildiv(params.n_features, FEATURES_PER_THREAD);
+			int n_threads = n_chunks * params.n_components;
 			math_t scale = sqrt(1.0 / params.density) / sqrt(params.n_components);
-			rng.scaled_bernoulli(random_matrix->sparse_data, len, math_t(0.5), scale, stream);
+			device_buffer<int> offsets(d_alloc, stream, n_threads);
+			dim3 grid(ceildiv(n_threads, TPB_X), 1, 1);
+			dim3 blk(TPB_X, 1, 1);
+			sparse_random_walk<math_t><<<grid, blk, 0, stream>>>(
+				params.n_features, n_chunks, params.n_components, params.density,
+				scale, params.random_state, offsets.data(), nullptr, nullptr,
+				nullptr);
+			CUDA_CHECK(cudaPeekAtLastError());
+
+			int last_count, last_offset;
+			updateHost(&last_count, offsets.data() + n_threads - 1, 1, stream);
+			ML::thrustAllocatorAdapter alloc(d_alloc, stream);
+			auto execution_policy = thrust::cuda::par(alloc).on(stream);
+			thrust::exclusive_scan(execution_policy, offsets.data(),
+				offsets.data() + n_threads, offsets.data());
+			updateHost(&last_offset, offsets.data() + n_threads - 1, 1, stream);
+			CUDA_CHECK(cudaStreamSynchronize(stream));
+			size_t len = size_t(last_offset) + last_count;
+
+			random_matrix->indices = (int*)d_alloc->allocate(len * sizeof(int), stream);
+			random_matrix->sparse_data = (math_t*)d_alloc->allocate(len * sizeof(math_t), stream);
+			sparse_random_walk<math_t><<<grid, blk, 0, stream>>>(
+				params.n_features, n_chunks, params.n_components, params.density,
+				scale, params.random_state, nullptr, offsets.data(),
+				random_matrix->indices, random_matrix->sparse_data);
+			CUDA_CHECK(cudaPeekAtLastError());
+
+			random_matrix->indptr = (int*)d_alloc->allocate((params.n_components + 1) * sizeof(int), stream);
+			dim3 grid_indptr(ceildiv(params.n_components + 1, TPB_X), 1, 1);
+			sparse_random_indptr<<<grid_indptr, blk, 0, stream>>>(
+				n_chunks, params.n_components, offsets.data(), len,
+				random_matrix->indptr);
+			CUDA_CHECK(cudaPeekAtLastError());
 
 			random_matrix->sparse_data_size = len;
 		}
@@ -203,6 +205,77 @@ namespace ML {
 		}
 	}
 
+	/**
+	 * @brief transforms a sparse dataset according to generated random matrix,
+	 * without densifying the dataset or the random matrix
+	 * @input param handle: cuML handle
+	 * @input param values: the nnz values of the CSR unprojected dataset,
+	 * n_samples x n_features
+	 * @input param cols: the column indices of the values
+	 * @input param row_ids: the row offsets into values, n_samples + 1 entries
+	 * @input param nnz: number of values
+	 * @input param random_matrix: the random matrix to be allocated and generated
+	 * @output param output: projected dataset, dense column major
+	 * @input param params: data structure that includes all the parameters of the model
+	 */
+	template<typename math_t>
+	void RPROJtransformSparse(const cumlHandle& handle, const math_t *values,
+							const int *cols, const int *row_ids, int nnz,
+							rand_mat<math_t> *random_matrix, math_t *output,
+							paramsRPROJ* params)
+	{
+		cudaStream_t stream = handle.getStream();
+		auto d_alloc = handle.getDeviceAllocator();
+		cusparseHandle_t cusparse_handle = handle.getImpl().getcusparseHandle();
+		CUSPARSE_CHECK(cusparseSetStream(cusparse_handle, stream));
+
+		check_parameters(*params);
+
+		int& m = params->n_samples;
+		int& n = params->n_components;
+		int& k = params->n_features;
+
+		if (random_matrix->dense_data)
+		{
+			const math_t alfa = 1;
+			const math_t beta = 0;
+
+			cusparseMatDescr_t descr;
+			CUSPARSE_CHECK(cusparseCreateMatDescr(&descr));
+			CUSPARSE_CHECK(cusparsecsrmm2(cusparse_handle,
+				CUSPARSE_OPERATION_NON_TRANSPOSE, CUSPARSE_OPERATION_NON_TRANSPOSE,
+				m, n, k, nnz, &alfa, descr, values, row_ids, cols,
+				random_matrix->dense_data, k, &beta, output, m));
+			CUSPARSE_CHECK(cusparseDestroyMatDescr(descr));
+		}
+		else if (random_matrix->sparse_data)
+		{
+			// the CSC arrays of the random matrix are the CSR arrays of its
+			// transpose, whose CSC arrays give its rows by feature
+			int r_nnz = random_matrix->sparse_data_size;
+			device_buffer<math_t> r_values(d_alloc, stream, r_nnz);
+			device_buffer<int> r_cols(d_alloc, stream, r_nnz);
+			device_buffer<int> r_row_ids(d_alloc, stream, k + 1);
+			CUSPARSE_CHECK(cusparsecsr2csc(cusparse_handle, n, k, r_nnz,
+				random_matrix->sparse_data, random_matrix->indptr,
+				random_matrix->indices, r_values.data(), r_cols.data(),
+				r_row_ids.data()));
+
+			CUDA_CHECK(cudaMemsetAsync(output, 0, size_t(m) * n * sizeof(math_t), stream));
+			dim3 grid(ceildiv(m, TPB_X), 1, 1);
+			dim3 blk(TPB_X, 1, 1);
+			sparse_sparse_mult<math_t><<<grid, blk, 0, stream>>>(
+				m, values, cols, row_ids, r_values.data(), r_cols.data(),
+				r_row_ids.data(), output);
+			CUDA_CHECK(cudaPeekAtLastError());
+		}
+		else
+		{
+			ASSERT(false,
+					"Could not find a random matrix. Please perform a fit operation before applying transformation");
+		}
+	}
+
 	/** @} */
 };
 // end namespace ML
@@ -20,77 +20,91 @@
 #include <random/rng.h>
 #include <cuda_utils.h>
 #include <common/cumlHandle.hpp>
-#include "sys/time.h"
 
 const int TPB_X = 256;
 
-inline void sample_without_replacement(size_t n_population, size_t n_samples,
-											int* indices, size_t& indices_idx)
-{
-    std::random_device dev;
-    std::mt19937 gen(dev());
-
-    std::uniform_int_distribution<int> uni_dist(0, n_population-1);
-
-    std::unordered_set<int> s;
-
-    for (size_t i = 0; i < n_samples; i++)
-    {
-        int rand_idx = uni_dist(gen);
-
-        while (s.find(rand_idx) != s.end())
-        {
-            rand_idx = uni_dist(gen);
+// features per thread of the sparse random matrix generation
+const int FEATURES_PER_THREAD = 1024;
+
+/**
+ * @brief walks over the features [chunk * FEATURES_PER_THREAD, ...) of the
+ * column component of the sparse random matrix, jumping from a non zero to
+ * the next by a geometric number of features, so that every entry is non zero
+ * with probability density. Each (component, chunk) pair draws from its own
+ * subsequence, so that counting the non zeros and writing them repeat the
+ * same walk.
+ * @input param n_features: number of rows of the random matrix
+ * @input param density: probability of an entry to be non zero
+ * @input param scale: magnitude of the non zeros, whose sign is random
+ * @input param seed: seed of the generator
+ * @output param counts: number of non zeros of each (component, chunk) pair,
+ * written when indices is null
+ * @input param offsets: first non zero of each (component, chunk) pair, when
+ * the non zeros are written
+ * @output param indices: row of each non zero, when not null
+ * @output param values: value of each non zero, when indices is not null
+ */
+template <typename math_t>
+__global__ void sparse_random_walk(int n_features, int n_chunks,
+                                   int n_components, double density,
+                                   math_t scale, uint64_t seed, int *counts,
+                                   const int *offsets, int *indices,
+                                   math_t *values) {
+    int tid = (blockIdx.x * TPB_X) + threadIdx.x;
+    if (tid >= n_chunks * n_components) return;
+    int chunk = tid % n_chunks;
+    int begin = chunk * FEATURES_PER_THREAD;
+    int end = min(begin + FEATURES_PER_THREAD, n_features);
+
+    MLCommon::Random::detail::PhiloxGenerator gen(seed, tid, 0);
+    double log_q = log1p(-density);
+    int n_nonzero = 0;
+    int out = indices ? offsets[tid] : 0;
+    for (double f = begin - 1;;) {
+        double u, sign;
+        gen.next(u);
+        gen.next(sign);
+        // u is in (0, 1], the gap is the number of zero entries skipped
+        f += floor(log(u) / log_q) + 1;
+        if (f >= end) break;
+        if (indices) {
+            indices[out + n_nonzero] = int(f);
+            values[out + n_nonzero] = sign < 0.5 ? -scale : scale;
         }
-        s.insert(rand_idx);
-        indices[indices_idx] = rand_idx;
-        indices_idx++;
+        n_nonzero++;
     }
+    if (!indices) counts[tid] = n_nonzero;
 }
 
-
-__global__ void sum_bools(bool *in_bools,int n, int *out_val) {
-  int row = (blockIdx.x * TPB_X) + threadIdx.x;
-  if(row < n) {
-    bool v = in_bools[row];
-    if(v)
-      atomicAdd(out_val, (int)in_bools[row]);
-  }
+/** @brief the column pointers of the random matrix, from the scanned counts */
+__global__ void sparse_random_indptr(int n_chunks, int n_components,
+                                     const int *offsets, int nnz,
+                                     int *indptr) {
+    int c = (blockIdx.x * TPB_X) + threadIdx.x;
+    if (c < n_components) indptr[c] = offsets[c * n_chunks];
+    if (c == n_components) indptr[c] = nnz;
 }
 
-inline size_t binomial(const ML::cumlHandle& h, size_t n, double p, int random_state)
-{
-
-    auto alloc = h.getDeviceAllocator();
-
-    struct timeval tp;
-    gettimeofday(&tp, NULL);
-    long long seed = tp.tv_sec * 1000 + tp.tv_usec;
-
-    auto rng = MLCommon::Random::Rng(random_state+seed);
-
-    bool *rand_array = (bool*)alloc->allocate(n * sizeof(bool), h.getStream());
-    int *successes = (int*)alloc->allocate(sizeof(int), h.getStream());
-
-    rng.bernoulli(rand_array, n, p, h.getStream());
-
-    cudaMemsetAsync(successes, 0, sizeof(int), h.getStream());
-
-    dim3 grid_n(MLCommon::ceildiv(n, (size_t)TPB_X), 1, 1);
-    dim3 blk(TPB_X, 1, 1);
-
-    sum_bools<<<grid_n, blk, 0, h.getStream()>>>(rand_array, n, successes);
-    CUDA_CHECK(cudaPeekAtLastError());
-
-    int ret = 0;
-    MLCommon::updateHost(&ret, successes,1,  h.getStream());
-    cudaStreamSynchronize(h.getStream());
-    CUDA_CHECK(cudaPeekAtLastError());
-
-    alloc->deallocate(rand_array, n*sizeof(bool), h.getStream());
-    alloc->deallocate(successes, sizeof(int), h.getStream());
-
-    return n -ret;
+/**
+ * @brief output = input * R for a CSR input and the CSR arrays of the random
+ * matrix R by feature, one thread per row of the input, the output being
+ * column major and zero initialized
+ */
+template <typename math_t>
+__global__ void sparse_sparse_mult(int n_samples, const math_t *values,
+                                   const int *cols, const int *row_ids,
+                                   const math_t *r_values,
+                                   const int *r_cols, const int *r_row_ids,
+                                   math_t *output) {
+    int row = (blockIdx.x * TPB_X) + threadIdx.x;
+    if (row >= n_samples) return;
+    for (int i = row_ids[row]; i < row_ids[row + 1]; i++) {
+        int f = cols[i];
+        math_t v = values[i];
+        for (int j = r_row_ids[f]; j < r_row_ids[f + 1]; j++) {
+            output[size_t(r_cols[j]) * n_samples + row] += v * r_values[j];
+        }
+    }
 }
 
 inline double check_density(double density, size_t n_features)
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <thrust/sort.h>
+#include <cuml/ensemble/randomforest.hpp>
+#include <limits>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "predict_kernels.cuh"
+
+namespace ML {
+
+/**
+ * @brief Out-of-bag vote counts of a classifier: votes[label * n_rows + row]
+ *        is the number of trees which predict label for row without having
+ *        row in their bootstrap sample.
+ */
+struct OobVotes {
+  int* votes;
+  int n_rows;
+  __device__ void operator()(int row, int label) const {
+    atomicAdd(&votes[label * n_rows + row], 1);
+  }
+};
+
+/**
+ * @brief Out-of-bag prediction sums and tree counts of a regressor.
+ */
+template <class T>
+struct OobSums {
+  T* sums;
+  int* counts;
+  __device__ void operator()(int row, T prediction) const {
+    atomicAdd(&sums[row], prediction);
+    atomicAdd(&counts[row], 1);
+  }
+};
+
+/**
+ * @brief Pass of the n_rows x n_cols column major training data through a
+ *        tree, one row per thread. A row out of the bootstrap sample of the
+ *        tree (sample_cnt 0) adds the prediction of the tree to acc. The
+ *        sample_cnt copies of an in-bag row add, at each split node of its
+ *        path, the decrease from the node impurity to the child impurity to
+ *        the importance of the node feature: summed over the rows, this is
+ *        the impurity decrease of the split weighted by the node size. The
+ *        importances are summed in shared memory if shm_importance is set.
+ */
+template <class T, class L, class Acc>
+__global__ void oob_tree_kernel(const FlatTreeNode<T, L>* tree,
+                                const T* impurity, const T* input, int n_rows,
+                                int n_cols, const unsigned int* sample_cnt,
+                                Acc acc, T* importance, bool shm_importance) {
+  extern __shared__ char shm_oob[];
+  T* imp = importance;
+  if (shm_importance) {
+    imp = (T*)shm_oob;
+    for (int c = threadIdx.x; c < n_cols; c += blockDim.x) imp[c] = 0;
+    __syncthreads();
+  }
+  int row = threadIdx.x + blockIdx.x * blockDim.x;
+  if (row < n_rows) {
+    unsigned int cnt = sample_cnt[row];
+    int idx = 0;
+    while (tree[idx].colid != -1) {
+      const FlatTreeNode<T, L>& node = tree[idx];
+      T val = input[row + size_t(node.colid) * n_rows];
+      int next = node.left_child_id + (val <= node.quesval ? 0 : 1);
+      if (cnt != 0)
+        atomicAdd(&imp[node.colid], cnt * (impurity[idx] - impurity[next]));
+      idx = next;
+    }
+    if (cnt == 0) acc(row, tree[idx].prediction);
+  }
+  if (shm_importance) {
+    __syncthreads();
+    for (int c = threadIdx.x; c < n_cols; c += blockDim.x)
+      atomicAdd(&importance[c], imp[c]);
+  }
+}
+
+/**
+ * @brief Add the out-of-bag predictions and the feature importances of a
+ *        tree (see oob_tree_kernel) to acc and importance.
+ * @param[in] tree: CPU pointer to the tree.
+ * @param[in] input: n_rows x n_cols column major training data. GPU pointer.
+ * @param[in] sample_cnt: number of copies of each row in the bootstrap
+ *            sample of the tree (see setup_sampling). GPU pointer.
+ * @param[in] acc: out-of-bag accumulator (OobVotes or OobSums).
+ * @param[in,out] importance: n_cols feature importances. GPU pointer.
+ * @param[in] d_alloc: device allocator.
+ * @param[in] stream: stream of the tree.
+ */
+template <class T, class L, class Acc>
+void oob_tree(const DecisionTree::TreeMetaDataNode<T, L>* tree,
+              const T* input, int n_rows, int n_cols,
+              const unsigned int* sample_cnt, Acc acc, T* importance,
+              std::shared_ptr<deviceAllocator> d_alloc, cudaStream_t stream) {
+  const int TPB = 256;
+  const size_t MAX_SHM = 48 * 1024;
+  const std::vector<SparseTreeNode<T, L>>& sparsetree = tree->sparsetree;
+  std::vector<FlatTreeNode<T, L>> h_nodes;
+  std::vector<T> h_impurity;
+  for (const SparseTreeNode<T, L>& node : sparsetree) {
+    FlatTreeNode<T, L> flat = {node.quesval, node.prediction, node.colid,
+                               node.left_child_id};
+    h_nodes.push_back(flat);
+    h_impurity.push_back(node.best_metric_val);
+  }
+  MLCommon::device_buffer<FlatTreeNode<T, L>> nodes(d_alloc, stream,
+                                                    h_nodes.size());
+  MLCommon::device_buffer<T> impurity(d_alloc, stream, h_impurity.size());
+  MLCommon::updateDevice(nodes.data(), h_nodes.data(), h_nodes.size(), stream);
+  MLCommon::updateDevice(impurity.data(), h_impurity.data(), h_impurity.size(),
+                         stream);
+
+  size_t shm_size = n_cols * sizeof(T);
+  bool shm_importance = shm_size <= MAX_SHM;
+  oob_tree_kernel<<<MLCommon::ceildiv(n_rows, TPB), TPB,
+                    shm_importance ? shm_size : 0, stream>>>(
+    nodes.data(), impurity.data(), input, n_rows, n_cols, sample_cnt, acc,
+    importance, shm_importance);
+  CUDA_CHECK(cudaPeekAtLastError());
+  // the host copies of the tree must outlive the copies to the device
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  nodes.release(stream);
+  impurity.release(stream);
+}
+
+/**
+ * @brief Out-of-bag rows (with at least one vote) and those whose majority
+ *        vote, ties going to the smallest label, is their label.
+ */
+__global__ void oob_accuracy_kernel(const int* votes, const int* labels,
+                                    int n_rows, int n_labels, int* n_oob,
+                                    int* n_correct) {
+  int row = threadIdx.x + blockIdx.x * blockDim.x;
+  if (row >= n_rows) return;
+  int best = 0, best_cnt = 0;
+  for (int c = 0; c < n_labels; c++) {
+    int cnt = votes[c * n_rows + row];
+    if (cnt > best_cnt) {
+      best_cnt = cnt;
+      best = c;
+    }
+  }
+  if (best_cnt == 0) return;
+  atomicAdd(n_oob, 1);
+  if (best == labels[row]) atomicAdd(n_correct, 1);
+}
+
+/**
+ * @brief Absolute and squared error sums of the mean out-of-bag predictions
+ *        of the out-of-bag rows (counts > 0); abs_errors receives the
+ *        absolute error of each row, or not_oob for the other rows.
+ */
+template <class T>
+__global__ void oob_errors_kernel(const T* sums, const int* counts,
+                                  const T* labels, int n_rows, T not_oob,
+                                  int* n_oob, T* error_sums, T* abs_errors) {
+  int row = threadIdx.x + blockIdx.x * blockDim.x;
+  if (row >= n_rows) return;
+  int cnt = counts[row];
+  if (cnt == 0) {
+    abs_errors[row] = not_oob;
+    return;
+  }
+  T err = sums[row] / cnt - labels[row];
+  T abs_err = MLCommon::myAbs(err);
+  abs_errors[row] = abs_err;
+  atomicAdd(n_oob, 1);
+  atomicAdd(&error_sums[0], abs_err);
+  atomicAdd(&error_sums[1], err * err);
+}
+
+/**
+ * @brief Out-of-bag accuracy of a classifier from its vote counts.
+ * @param[in] votes: n_labels x n_rows out-of-bag vote counts (see OobVotes).
+ *            GPU pointer.
+ * @param[in] labels: n_rows labels, from 0 to n_labels - 1. GPU pointer.
+ */
+RF_metrics oob_classifier_metrics(const int* votes, const int* labels,
+                                  int n_rows, int n_labels,
+                                  std::shared_ptr<deviceAllocator> d_alloc,
+                                  cudaStream_t stream) {
+  const int TPB = 256;
+  MLCommon::device_buffer<int> d_counts(d_alloc, stream, 2);
+  CUDA_CHECK(cudaMemsetAsync(d_counts.data(), 0, 2 * sizeof(int), stream));
+  oob_accuracy_kernel<<<MLCommon::ceildiv(n_rows, TPB), TPB, 0, stream>>>(
+    votes, labels, n_rows, n_labels, d_counts.data(), d_counts.data() + 1);
+  CUDA_CHECK(cudaPeekAtLastError());
+  int h_counts[2];
+  MLCommon::updateHost(h_counts, d_counts.data(), 2, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  d_counts.release(stream);
+  float accuracy = h_counts[0] > 0 ? (float)h_counts[1] / h_counts[0] : 0.0f;
+  return set_rf_metrics_classification(accuracy);
+}
+
+/**
+ * @brief Out-of-bag errors of a regressor from its prediction sums.
+ * @param[in] sums: n_rows out-of-bag prediction sums (see OobSums). GPU
+ *            pointer.
+ * @param[in] counts: n_rows out-of-bag tree counts. GPU pointer.
+ * @param[in] labels: n_rows labels. GPU pointer.
+ */
+template <class T>
+RF_metrics oob_regressor_metrics(const T* sums, const int* counts,
+                                 const T* labels, int n_rows,
+                                 std::shared_ptr<deviceAllocator> d_alloc,
+                                 cudaStream_t stream) {
+  const int TPB = 256;
+  MLCommon::device_buffer<int> d_n_oob(d_alloc, stream, 1);
+  MLCommon::device_buffer<T> d_error_sums(d_alloc, stream, 2);
+  MLCommon::device_buffer<T> abs_errors(d_alloc, stream, n_rows);
+  CUDA_CHECK(cudaMemsetAsync(d_n_oob.data(), 0, sizeof(int), stream));
+  CUDA_CHECK(
+    cudaMemsetAsync(d_error_sums.data(), 0, 2 * sizeof(T), stream));
+  oob_errors_kernel<<<MLCommon::ceildiv(n_rows, TPB), TPB, 0, stream>>>(
+    sums, counts, labels, n_rows, std::numeric_limits<T>::max(),
+    d_n_oob.data(), d_error_sums.data(), abs_errors.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+  // the rows which are not out-of-bag sort last
+  thrust::sort(thrust::cuda::par.on(stream), abs_errors.data(),
+               abs_errors.data() + n_rows);
+
+  int n_oob;
+  T error_sums[2];
+  MLCommon::updateHost(&n_oob, d_n_oob.data(), 1, stream);
+  MLCommon::updateHost(error_sums, d_error_sums.data(), 2, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  T median[2] = {0, 0};
+  if (n_oob > 0) {
+    MLCommon::updateHost(median, abs_errors.data() + (n_oob - 1) / 2, 1,
+                         stream);
+    MLCommon::updateHost(median + 1, abs_errors.data() + n_oob / 2, 1, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+  d_n_oob.release(stream);
+  d_error_sums.release(stream);
+  abs_errors.release(stream);
+
+  double denom = n_oob > 0 ? n_oob : 1;
+  return set_rf_metrics_regression(error_sums[0] / denom,
+                                   error_sums[1] / denom,
+                                   ((double)median[0] + median[1]) / 2);
+}
+
+/**
+ * @brief Copy the n_cols feature importances (GPU pointer) to the host,
+ *        normalized to sum to 1 (unless they are all 0).
+ */
+template <class T>
+std::vector<T> normalized_importances(const T* importance, int n_cols,
+                                      cudaStream_t stream) {
+  std::vector<T> h_importance(n_cols);
+  MLCommon::updateHost(h_importance.data(), importance, n_cols, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  T sum = 0;
+  for (T imp : h_importance) sum += imp;
+  if (sum > 0) {
+    for (T& imp : h_importance) imp /= sum;
+  }
+  return h_importance;
+}
+
+}  // namespace ML
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <algorithm>
+#include <cuml/ensemble/randomforest.hpp>
+#include <iostream>
+#include <vector>
+#include "common/cumlHandle.hpp"
+#include "common/device_buffer.hpp"
+#include "common/host_buffer.hpp"
+#include "cuda_utils.h"
+
+namespace ML {
+
+/**
+ * @brief Node of a tree of a random forest, flattened for GPU prediction.
+ *        For classifiers, prediction is the index of the label in the sorted
+ *        list of the labels predicted by the leaves of the forest.
+ */
+template <class T, class L>
+struct FlatTreeNode {
+  T quesval;
+  L prediction;
+  int colid;
+  int left_child_id;
+};
+
+/**
+ * @brief Flatten the trees of a random forest (on the host) for prediction.
+ * @tparam T: data type for input data (float or double).
+ * @tparam L: data type for labels (int type for classification, T type for regression).
+ * @param[in] forest: CPU pointer to RandomForestMetaData struct.
+ * @param[out] nodes: nodes of all trees; the children of each node are
+ *             indexed relative to the root of its tree.
+ * @param[out] roots: index of the root of each tree in nodes.
+ */
+template <class T, class L>
+void flatten_forest(const RandomForestMetaData<T, L>* forest,
+                    std::vector<FlatTreeNode<T, L>>& nodes,
+                    std::vector<int>& roots) {
+  int n_trees = forest->rf_params.n_trees;
+  roots.resize(n_trees);
+  nodes.clear();
+  for (int i = 0; i < n_trees; i++) {
+    const std::vector<SparseTreeNode<T, L>>& tree =
+      forest->trees[i].sparsetree;
+    ASSERT(tree.size() != 0, "Cannot predict w/ empty tree %d", i);
+    roots[i] = nodes.size();
+    for (const SparseTreeNode<T, L>& node : tree) {
+      FlatTreeNode<T, L> flat = {node.quesval, node.prediction, node.colid,
+                                 node.left_child_id};
+      nodes.push_back(flat);
+    }
+  }
+}
+
+/**
+ * @brief Replace the leaf labels of flattened classifier trees by their
+ *        indices in the sorted list of distinct leaf labels (returned).
+ */
+template <class T>
+std::vector<int> index_leaf_labels(std::vector<FlatTreeNode<T, int>>& nodes) {
+  std::vector<int> labels;
+  for (const FlatTreeNode<T, int>& node : nodes) {
+    if (node.colid == -1) labels.push_back(node.prediction);
+  }
+  std::sort(labels.begin(), labels.end());
+  labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+  for (FlatTreeNode<T, int>& node : nodes) {
+    if (node.colid != -1) continue;
+    node.prediction =
+      std::lower_bound(labels.begin(), labels.end(), node.prediction) -
+      labels.begin();
+  }
+  return labels;
+}
+
+/**
+ * @brief Return the prediction of the tree starting at tree for row; same
+ *        traversal as DecisionTreeBase::predict_one
+ */
+template <class T, class L>
+__device__ L predict_tree(const FlatTreeNode<T, L>* tree, const T* row) {
+  int idx = 0;
+  while (tree[idx].colid != -1) {
+    const FlatTreeNode<T, L>& node = tree[idx];
+    idx = node.left_child_id + (row[node.colid] <= node.quesval ? 0 : 1);
+  }
+  return tree[idx].prediction;
+}
+
+/**
+ * @brief Majority vote of the trees of a classifier, one row per thread.
+ *        The vote counts of a row are at votes + row (global memory) or
+ *        in shared memory (if votes is nullptr), with a stride of the
+ *        number of rows or threads, respectively. Ties are broken like in
+ *        the CPU implementation: the label which first reaches the maximum
+ *        count, in the order of the trees, wins.
+ */
+template <class T>
+__global__ void rf_classify_kernel(const FlatTreeNode<T, int>* nodes,
+                                   const int* roots, int n_trees,
+                                   const T* input, int n_rows, int n_cols,
+                                   const int* labels, int n_labels, int* votes,
+                                   int* predictions) {
+  extern __shared__ int shm_votes[];
+  int row = threadIdx.x + blockIdx.x * blockDim.x;
+  if (row >= n_rows) return;
+  int stride = n_rows;
+  if (votes == nullptr) {
+    votes = shm_votes + threadIdx.x;
+    stride = blockDim.x;
+  } else {
+    votes += row;
+  }
+  for (int c = 0; c < n_labels; c++) votes[c * stride] = 0;
+  const T* x = input + size_t(row) * n_cols;
+  int best = 0, best_cnt = 0;
+  for (int i = 0; i < n_trees; i++) {
+    int c = predict_tree(nodes + roots[i], x);
+    int cnt = ++votes[c * stride];
+    if (cnt > best_cnt) {
+      best_cnt = cnt;
+      best = c;
+    }
+  }
+  predictions[row] = labels[best];
+}
+
+/**
+ * @brief Mean of the predictions of the trees of a regressor, one row
+ *        per thread.
+ */
+template <class T>
+__global__ void rf_regress_kernel(const FlatTreeNode<T, T>* nodes,
+                                  const int* roots, int n_trees,
+                                  const T* input, int n_rows, int n_cols,
+                                  T* predictions) {
+  int row = threadIdx.x + blockIdx.x * blockDim.x;
+  if (row >= n_rows) return;
+  const T* x = input + size_t(row) * n_cols;
+  T sum = 0;
+  for (int i = 0; i < n_trees; i++) sum += predict_tree(nodes + roots[i], x);
+  predictions[row] = sum / n_trees;
+}
+
+/**
+ * @brief Copy a host vector to the device through pinned memory of the
+ *        handle, so that the copy is asynchronous and the vector may be
+ *        released as soon as it is enqueued.
+ * @param[in] handle: cumlHandle_impl.
+ * @param[out] dst: src.size() elements. GPU pointer.
+ * @param[in] src: host data.
+ */
+template <class T>
+void stage_to_device(const cumlHandle_impl& handle, T* dst,
+                     const std::vector<T>& src) {
+  cudaStream_t stream = handle.getStream();
+  // the host allocator hands the block out again only once the copy is done
+  MLCommon::host_buffer<T> pinned(handle.getHostAllocator(), stream,
+                                  src.size());
+  std::copy(src.begin(), src.end(), pinned.data());
+  MLCommon::updateDevice(dst, pinned.data(), src.size(), stream);
+}
+
+/**
+ * @brief Predict with a random forest classifier on the GPU.
+ * @tparam T: data type for input data (float or double).
+ * @param[in] handle: cumlHandle_impl.
+ * @param[in] forest: CPU pointer to RandomForestMetaData struct.
+ * @param[in] input: n_rows x n_cols row major data. GPU pointer.
+ * @param[in] n_rows: number of data samples.
+ * @param[in] n_cols: number of features.
+ * @param[out] predictions: n_rows predicted labels. GPU pointer.
+ */
+template <class T>
+void predict_classifier_gpu(const cumlHandle_impl& handle,
+                            const RandomForestMetaData<T, int>* forest,
+                            const T* input, int n_rows, int n_cols,
+                            int* predictions) {
+  const int TPB = 256;
+  const int MIN_TPB = 32;
+  const size_t MAX_SHM = 48 * 1024;
+  cudaStream_t stream = handle.getStream();
+  std::shared_ptr<deviceAllocator> d_alloc = handle.getDeviceAllocator();
+
+  std::vector<FlatTreeNode<T, int>> h_nodes;
+  std::vector<int> h_roots;
+  flatten_forest(forest, h_nodes, h_roots);
+  std::vector<int> h_labels = index_leaf_labels(h_nodes);
+  int n_trees = h_roots.size();
+  int n_labels = h_labels.size();
+
+  MLCommon::device_buffer<FlatTreeNode<T, int>> nodes(d_alloc, stream,
+                                                      h_nodes.size());
+  MLCommon::device_buffer<int> roots(d_alloc, stream, n_trees);
+  MLCommon::device_buffer<int> labels(d_alloc, stream, n_labels);
+  stage_to_device(handle, nodes.data(), h_nodes);
+  stage_to_device(handle, roots.data(), h_roots);
+  stage_to_device(handle, labels.data(), h_labels);
+
+  // vote counts go into shared memory, unless there are too many labels
+  int tpb = TPB;
+  while (tpb > MIN_TPB && tpb * n_labels * sizeof(int) > MAX_SHM) tpb /= 2;
+  size_t shm_size = tpb * n_labels * sizeof(int);
+  MLCommon::device_buffer<int> votes(d_alloc, stream, 0);
+  if (shm_size > MAX_SHM) {
+    votes.resize(size_t(n_rows) * n_labels, stream);
+    shm_size = 0;
+  }
+  rf_classify_kernel<<<MLCommon::ceildiv(n_rows, tpb), tpb, shm_size,
+                       stream>>>(nodes.data(), roots.data(), n_trees, input,
+                                 n_rows, n_cols, labels.data(), n_labels,
+                                 shm_size > 0 ? nullptr : votes.data(),
+                                 predictions);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Predict with a random forest regressor on the GPU.
+ * @tparam T: data type for input data (float or double).
+ * @param[in] handle: cumlHandle_impl.
+ * @param[in] forest: CPU pointer to RandomForestMetaData struct.
+ * @param[in] input: n_rows x n_cols row major data. GPU pointer.
+ * @param[in] n_rows: number of data samples.
+ * @param[in] n_cols: number of features.
+ * @param[out] predictions: n_rows predictions. GPU pointer.
+ */
+template <class T>
+void predict_regressor_gpu(const cumlHandle_impl& handle,
+                           const RandomForestMetaData<T, T>* forest,
+                           const T* input, int n_rows, int n_cols,
+                           T* predictions) {
+  const int TPB = 256;
+  cudaStream_t stream = handle.getStream();
+  std::shared_ptr<deviceAllocator> d_alloc = handle.getDeviceAllocator();
+
+  std::vector<FlatTreeNode<T, T>> h_nodes;
+  std::vector<int> h_roots;
+  flatten_forest(forest, h_nodes, h_roots);
+  int n_trees = h_roots.size();
+
+  MLCommon::device_buffer<FlatTreeNode<T, T>> nodes(d_alloc, stream,
+                                                    h_nodes.size());
+  MLCommon::device_buffer<int> roots(d_alloc, stream, n_trees);
+  stage_to_device(handle, nodes.data(), h_nodes);
+  stage_to_device(handle, roots.data(), h_roots);
+
+  rf_regress_kernel<<<MLCommon::ceildiv(n_rows, TPB), TPB, 0, stream>>>(
+    nodes.data(), roots.data(), n_trees, input, n_rows, n_cols, predictions);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Print the predictions for debugging purposes.
+ * @param[in] handle: cumlHandle_impl.
+ * @param[in] predictions: n_rows predictions. GPU pointer.
+ * @param[in] n_rows: number of data samples.
+ */
+template <class L>
+void print_predictions(const cumlHandle_impl& handle, const L* predictions,
+                       int n_rows) {
+  std::vector<L> h_predictions(n_rows);
+  MLCommon::updateHost(h_predictions.data(), predictions, n_rows,
+                       handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+  for (int i = 0; i < n_rows; i++) {
+    std::cout << "Prediction for sample " << i << ": " << h_predictions[i]
+              << std::endl;
+  }
+}
+
+}  // namespace ML
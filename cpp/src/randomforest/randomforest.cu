@@ -19,12 +19,18 @@
 #define omp_get_max_threads() 1
 #endif
 #include <treelite/tree.h>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <cuml/ensemble/randomforest.hpp>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <string>
+#include <typeinfo>
+#include <utility>
 #include <vector>
+#include "common/matrixView.cuh"
 #include "randomforest_impl.cuh"
 
 namespace ML {
@@ -33,6 +39,18 @@ using namespace MLCommon;
 using namespace std;
 namespace tl = treelite;
 
+/**
+ * @brief The data of a matrix view in the layout that fit (column-major) or
+ *        predict (row-major) works on, copied into buf only if need be.
+ */
+template <typename T>
+T* view_data(const cumlHandle& user_handle, const matrixView<const T>& input,
+             bool rowMajor, device_buffer<T>& buf) {
+  // the implementations take non-const pointers but only read the data
+  return const_cast<T*>(
+    ML::detail::contiguous(user_handle.getImpl(), input, rowMajor, buf));
+}
+
 /**
  * @brief Set RF_metrics.
  * @param[in] rf_type: Random Forest type: classification or regression
@@ -169,6 +187,8 @@ void set_rf_params(RF_params& params, int cfg_n_trees, bool cfg_bootstrap,
               << omp_get_max_threads() << std::endl;
   }
   if (cfg_n_trees < params.n_streams) params.n_streams = cfg_n_trees;
+  params.tree_batch_size = 1;
+  params.oob_score = false;
   set_tree_params(params.tree_params);  // use default tree params
 }
 
@@ -190,6 +210,8 @@ void set_all_rf_params(RF_params& params, int cfg_n_trees, bool cfg_bootstrap,
   params.seed = cfg_seed;
   params.n_streams = min(cfg_n_streams, omp_get_max_threads());
   if (cfg_n_trees < params.n_streams) params.n_streams = cfg_n_trees;
+  params.tree_batch_size = 1;
+  params.oob_score = false;
   set_tree_params(params.tree_params);  // use input tree params
   params.tree_params = cfg_tree_params;
 }
@@ -215,6 +237,8 @@ void print(const RF_params rf_params) {
   std::cout << "bootstrap: " << rf_params.bootstrap << std::endl;
   std::cout << "rows_sample: " << rf_params.rows_sample << std::endl;
   std::cout << "n_streams: " << rf_params.n_streams << std::endl;
+  std::cout << "tree_batch_size: " << rf_params.tree_batch_size << std::endl;
+  std::cout << "oob_score: " << rf_params.oob_score << std::endl;
   DecisionTree::print(rf_params.tree_params);
 }
 
@@ -341,13 +365,344 @@ std::vector<unsigned char> save_model(ModelHandle model) {
   return bytes_info;
 }
 
+/** saved_rf_header starts a forest written by save_forest; it is followed
+    by the tree headers, the feature importances and the nodes of all the
+    trees, each array starting at an 8-byte aligned offset */
+struct saved_rf_header {
+  static const int MAGIC = 0x52464d44;  // "RFMD"
+  static const int VERSION = 1;
+  int magic;
+  int version;
+  // sizeof(T) and sizeof(L), and whether L is int
+  int data_size;
+  int label_size;
+  int classifier;
+  RF_params rf_params;
+  RF_metrics oob_metrics;
+  int n_importances;
+};
+
+struct saved_tree_header {
+  int treeid;
+  int depth_counter;
+  int leaf_counter;
+  int n_nodes;
+};
+
+/** append_array appends the n elements of src to *pbytes, starting at an
+    8-byte aligned offset */
+template <class X>
+void append_array(std::vector<char>* pbytes, const X* src, size_t n) {
+  size_t offset = (pbytes->size() + 7) / 8 * 8;
+  pbytes->resize(offset + n * sizeof(X), 0);
+  if (n > 0) memcpy(pbytes->data() + offset, src, n * sizeof(X));
+}
+
+/** read_array copies into dst the n elements at the (aligned) *poffset in
+    bytes of size size, advancing *poffset */
+template <class X>
+void read_array(X* dst, const char* bytes, size_t size, size_t* poffset,
+                size_t n) {
+  size_t offset = (*poffset + 7) / 8 * 8;
+  ASSERT(offset + n * sizeof(X) <= size, "saved forest is truncated");
+  if (n > 0) memcpy(dst, bytes + offset, n * sizeof(X));
+  *poffset = offset + n * sizeof(X);
+}
+
+/**
+ * @brief Save a random forest in a compact flat binary format.
+ * @tparam T: data type for input data (float or double).
+ * @tparam L: data type for labels (int type for classification, T type for regression).
+ * @param[in] forest: CPU pointer to RandomForestMetaData struct.
+ * @param[out] pbytes: the saved forest; its previous contents are replaced.
+ */
+template <class T, class L>
+void save_forest(const RandomForestMetaData<T, L>* forest,
+                 std::vector<char>* pbytes) {
+  int n_trees = forest->rf_params.n_trees;
+  saved_rf_header hdr;
+  hdr.magic = saved_rf_header::MAGIC;
+  hdr.version = saved_rf_header::VERSION;
+  hdr.data_size = sizeof(T);
+  hdr.label_size = sizeof(L);
+  hdr.classifier = typeid(L) == typeid(int);
+  hdr.rf_params = forest->rf_params;
+  hdr.oob_metrics = forest->oob_metrics;
+  hdr.n_importances = forest->feature_importances.size();
+
+  // The training only fields of the nodes (best_metric_val) are dropped
+  std::vector<saved_tree_header> tree_hdrs(n_trees);
+  std::vector<FlatTreeNode<T, L>> nodes;
+  for (int i = 0; i < n_trees; i++) {
+    const DecisionTree::TreeMetaDataNode<T, L>& tree = forest->trees[i];
+    tree_hdrs[i] = {tree.treeid, tree.depth_counter, tree.leaf_counter,
+                    (int)tree.sparsetree.size()};
+    for (const SparseTreeNode<T, L>& node : tree.sparsetree) {
+      FlatTreeNode<T, L> flat = {node.quesval, node.prediction, node.colid,
+                                 node.left_child_id};
+      nodes.push_back(flat);
+    }
+  }
+
+  pbytes->clear();
+  append_array(pbytes, &hdr, 1);
+  append_array(pbytes, tree_hdrs.data(), n_trees);
+  append_array(pbytes, forest->feature_importances.data(), hdr.n_importances);
+  append_array(pbytes, nodes.data(), nodes.size());
+}
+
+/**
+ * @brief Load a random forest saved by save_forest.
+ * @tparam T: data type for input data (float or double).
+ * @tparam L: data type for labels (int type for classification, T type for regression).
+ * @param[in,out] forest: CPU pointer to RandomForestMetaData struct, with no trees.
+ * @param[in] bytes: the saved forest.
+ * @param[in] size: size of bytes, in bytes.
+ */
+template <class T, class L>
+void load_forest(RandomForestMetaData<T, L>* forest, const void* bytes,
+                 size_t size) {
+  ASSERT(!forest->trees, "Cannot load into an existing forest.");
+  const char* data = (const char*)bytes;
+  size_t offset = 0;
+  saved_rf_header hdr;
+  read_array(&hdr, data, size, &offset, 1);
+  ASSERT(hdr.magic == saved_rf_header::MAGIC, "not a saved random forest");
+  ASSERT(hdr.version == saved_rf_header::VERSION,
+         "saved forest has version %d, but only version %d is supported",
+         hdr.version, saved_rf_header::VERSION);
+  ASSERT(hdr.data_size == (int)sizeof(T) &&
+           hdr.label_size == (int)sizeof(L) &&
+           hdr.classifier == (typeid(L) == typeid(int)),
+         "saved forest has different data or label types");
+  int n_trees = hdr.rf_params.n_trees;
+  ASSERT(n_trees >= 0 && hdr.n_importances >= 0, "saved forest is corrupted");
+
+  std::vector<saved_tree_header> tree_hdrs(n_trees);
+  read_array(tree_hdrs.data(), data, size, &offset, n_trees);
+  std::vector<T> importances(hdr.n_importances);
+  read_array(importances.data(), data, size, &offset, hdr.n_importances);
+  size_t n_nodes = 0;
+  for (const saved_tree_header& tree_hdr : tree_hdrs) {
+    ASSERT(tree_hdr.n_nodes >= 0, "saved forest is corrupted");
+    n_nodes += tree_hdr.n_nodes;
+  }
+  std::vector<FlatTreeNode<T, L>> nodes(n_nodes);
+  read_array(nodes.data(), data, size, &offset, n_nodes);
+
+  forest->rf_params = hdr.rf_params;
+  forest->oob_metrics = hdr.oob_metrics;
+  forest->feature_importances.swap(importances);
+  forest->trees = new DecisionTree::TreeMetaDataNode<T, L>[n_trees];
+  const FlatTreeNode<T, L>* flat = nodes.data();
+  for (int i = 0; i < n_trees; i++) {
+    DecisionTree::TreeMetaDataNode<T, L>& tree = forest->trees[i];
+    tree.treeid = tree_hdrs[i].treeid;
+    tree.depth_counter = tree_hdrs[i].depth_counter;
+    tree.leaf_counter = tree_hdrs[i].leaf_counter;
+    tree.prepare_time = 0;
+    tree.train_time = 0;
+    tree.sparsetree.resize(tree_hdrs[i].n_nodes);
+    for (SparseTreeNode<T, L>& node : tree.sparsetree) {
+      node.prediction = flat->prediction;
+      node.colid = flat->colid;
+      node.quesval = flat->quesval;
+      node.best_metric_val = 0;
+      node.left_child_id = flat->left_child_id;
+      flat++;
+    }
+  }
+}
+
+// FIL goes left if the feature is less than the threshold, and the trees of
+// a forest if it is less than or equal to quesval
+template <class T>
+float fil_threshold(T quesval) {
+  return std::nextafterf((float)quesval,
+                         std::numeric_limits<float>::infinity());
+}
+
+template <class T, class L>
+float fil_leaf_output(const SparseTreeNode<T, L>& node) {
+  if (typeid(L) == typeid(int)) {
+    ASSERT(node.prediction == 0 || node.prediction == 1,
+           "only binary classifiers can be converted to FIL");
+  }
+  return node.prediction;
+}
+
+// fil_tree_depth returns the depth of the deepest leaf of tree
+template <class T, class L>
+int fil_tree_depth(const std::vector<SparseTreeNode<T, L>>& tree) {
+  int depth = 0;
+  std::vector<std::pair<int, int>> stack(1, std::make_pair(0, 0));
+  while (!stack.empty()) {
+    std::pair<int, int> cur = stack.back();
+    stack.pop_back();
+    depth = std::max(depth, cur.second);
+    const SparseTreeNode<T, L>& node = tree[cur.first];
+    if (node.colid == -1) continue;
+    stack.push_back(std::make_pair(node.left_child_id, cur.second + 1));
+    stack.push_back(std::make_pair(node.left_child_id + 1, cur.second + 1));
+  }
+  return depth;
+}
+
+// rf2fil_dense converts the trees of forest to dense FIL trees of the given
+// depth: the children of the node at position p of a tree are at 2 p + 1
+// and 2 p + 2
+template <class T, class L>
+void rf2fil_dense(std::vector<fil::dense_node_t>* pnodes,
+                  const RandomForestMetaData<T, L>* forest, int depth) {
+  int n_trees = forest->rf_params.n_trees;
+  size_t tree_nodes = (size_t(1) << (depth + 1)) - 1;
+  pnodes->assign(tree_nodes * n_trees, fil::dense_node_t{0, 0});
+  for (int i = 0; i < n_trees; i++) {
+    const std::vector<SparseTreeNode<T, L>>& tree = forest->trees[i].sparsetree;
+    fil::dense_node_t* root = pnodes->data() + tree_nodes * i;
+    // pairs of the index of a node in tree and of its FIL position
+    std::vector<std::pair<int, size_t>> stack(1, std::make_pair(0, 0));
+    while (!stack.empty()) {
+      std::pair<int, size_t> cur = stack.back();
+      stack.pop_back();
+      const SparseTreeNode<T, L>& node = tree[cur.first];
+      if (node.colid == -1) {
+        fil::dense_node_init(root + cur.second, fil_leaf_output(node), 0, 0,
+                             false, true);
+        continue;
+      }
+      fil::dense_node_init(root + cur.second, 0, fil_threshold(node.quesval),
+                           node.colid, true, false);
+      size_t left = 2 * cur.second + 1;
+      stack.push_back(std::make_pair(node.left_child_id, left));
+      stack.push_back(std::make_pair(node.left_child_id + 1, left + 1));
+    }
+  }
+}
+
+// fil_node_init initializes a sparse FIL node of either size
+inline void fil_node_init(fil::sparse_node_t* node, float output,
+                          float thresh, int fid, bool is_leaf,
+                          int left_index) {
+  fil::sparse_node_init(node, output, thresh, fid, true, is_leaf, left_index);
+}
+
+inline void fil_node_init(fil::sparse_node8_t* node, float output,
+                          float thresh, int fid, bool is_leaf,
+                          int left_index) {
+  fil::sparse_node8_init(node, output, thresh, fid, true, is_leaf,
+                         left_index);
+}
+
+// rf2fil_sparse converts the trees of forest to sparse FIL trees; as in the
+// forest, the left child of a node is indexed relative to the tree root, and
+// the right one follows it, so the nodes keep their positions
+template <class node_t, class T, class L>
+void rf2fil_sparse(std::vector<int>* ptrees, std::vector<node_t>* pnodes,
+                   const RandomForestMetaData<T, L>* forest) {
+  for (int i = 0; i < forest->rf_params.n_trees; i++) {
+    const std::vector<SparseTreeNode<T, L>>& tree = forest->trees[i].sparsetree;
+    int root = pnodes->size();
+    ptrees->push_back(root);
+    pnodes->resize(root + tree.size());
+    for (int j = 0; j < (int)tree.size(); j++) {
+      const SparseTreeNode<T, L>& node = tree[j];
+      if (node.colid == -1) {
+        fil_node_init(&(*pnodes)[root + j], fil_leaf_output(node), 0, 0, true,
+                      0);
+      } else {
+        fil_node_init(&(*pnodes)[root + j], 0, fil_threshold(node.quesval),
+                      node.colid, false, node.left_child_id);
+      }
+    }
+  }
+}
+
+template <class node_t, class T, class L>
+void build_fil_sparse(const cumlHandle& handle, fil::forest_t* pforest,
+                      const RandomForestMetaData<T, L>* forest,
+                      fil::forest_params_t* params) {
+  std::vector<int> trees;
+  std::vector<node_t> nodes;
+  rf2fil_sparse(&trees, &nodes, forest);
+  params->num_nodes = nodes.size();
+  fil::init_sparse(handle, pforest, trees.data(), nodes.data(), params);
+  // sync is necessary as nodes is used in init_sparse(),
+  // but destructed at the end of this function
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
+/**
+ * @brief Create a FIL forest from a random forest regressor or binary
+ *        classifier, without a treelite model.
+ * @tparam T: data type for input data (float or double).
+ * @tparam L: data type for labels (int type for classification, T type for regression).
+ * @param[in] handle: cumlHandle
+ * @param[out] pforest: pointer to where to store the FIL forest.
+ * @param[in] forest: CPU pointer to RandomForestMetaData struct.
+ * @param[in] num_features: number of features.
+ * @param[in] tl_params: FIL parameters, as for fil::from_treelite.
+ */
+template <class T, class L>
+void build_fil_forest(const cumlHandle& handle, fil::forest_t* pforest,
+                      const RandomForestMetaData<T, L>* forest,
+                      int num_features,
+                      const fil::treelite_params_t* tl_params) {
+  fil::forest_params_t params;
+  params.num_trees = forest->rf_params.n_trees;
+  params.num_cols = num_features;
+  params.algo = tl_params->algo;
+  params.threshold = tl_params->threshold;
+  params.global_bias = 0;
+  params.num_classes = 1;
+  params.num_nodes = 0;
+  params.output = fil::output_t::AVG;
+  if (tl_params->output_class) {
+    params.output = fil::output_t(params.output | fil::output_t::THRESHOLD);
+  }
+  params.depth = 0;
+  for (int i = 0; i < params.num_trees; i++) {
+    const std::vector<SparseTreeNode<T, L>>& tree = forest->trees[i].sparsetree;
+    ASSERT(tree.size() != 0, "Cannot convert empty tree %d", i);
+    params.depth = std::max(params.depth, fil_tree_depth(tree));
+  }
+
+  // build dense trees by default, as fil::from_treelite does
+  fil::storage_type_t storage_type = tl_params->storage_type;
+  if (storage_type == fil::storage_type_t::AUTO) {
+    storage_type = fil::storage_type_t::DENSE;
+  }
+  switch (storage_type) {
+    case fil::storage_type_t::DENSE: {
+      std::vector<fil::dense_node_t> nodes;
+      rf2fil_dense(&nodes, forest, params.depth);
+      fil::init_dense(handle, pforest, nodes.data(), &params);
+      // sync is necessary as nodes is used in init_dense(),
+      // but destructed at the end of this function
+      CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+      break;
+    }
+    case fil::storage_type_t::SPARSE:
+      build_fil_sparse<fil::sparse_node_t>(handle, pforest, forest, &params);
+      break;
+    case fil::storage_type_t::SPARSE8:
+      build_fil_sparse<fil::sparse_node8_t>(handle, pforest, forest, &params);
+      break;
+    default:
+      ASSERT(false,
+             "tl_params->storage_type must be one of AUTO, DENSE, SPARSE or "
+             "SPARSE8");
+  }
+}
+
 /**
  * @defgroup Random Forest Classification - Fit function
  * @brief Build (i.e., fit, train) random forest classifier for input data.
  * @param[in] user_handle: cumlHandle
  * @param[in,out] forest: CPU pointer to RandomForestMetaData object. User allocated.
  * @param[in] input: train data (n_rows samples, n_cols features) in column major format,
- *   excluding labels. Device pointer.
+ *   excluding labels. Device pointer (host pointer if
+ *   rf_params.tree_params.stream_cols > 0).
  * @param[in] n_rows: number of training data samples.
  * @param[in] n_cols: number of features (i.e., columns) excluding target feature.
  * @param[in] labels: 1D array of target features (int only), with one label per
@@ -387,6 +742,44 @@ void fit(const cumlHandle& user_handle, RandomForestClassifierD*& forest,
 }
 /** @} */
 
+/**
+ * @defgroup Random Forest Classification - Distributed fit function
+ * @brief Same as fit, with the trees trained by all the ranks of the
+ *   communicator of user_handle, which must all call it with the same data
+ *   and parameters. Each rank trains a contiguous range of the trees on the
+ *   whole data; the trees are then exchanged, so that every rank ends up
+ *   with the same forest as fit would build.
+ * @{
+ */
+void fit_mg(const cumlHandle& user_handle, RandomForestClassifierF*& forest,
+            float* input, int n_rows, int n_cols, int* labels,
+            int n_unique_labels, RF_params rf_params) {
+  ASSERT(!forest->trees, "Cannot fit an existing forest.");
+  forest->trees =
+    new DecisionTree::TreeMetaDataNode<float, int>[rf_params.n_trees];
+  forest->rf_params = rf_params;
+
+  std::shared_ptr<rfClassifier<float>> rf_classifier =
+    std::make_shared<rfClassifier<float>>(rf_params);
+  rf_classifier->fit(user_handle, input, n_rows, n_cols, labels,
+                     n_unique_labels, forest, true);
+}
+
+void fit_mg(const cumlHandle& user_handle, RandomForestClassifierD*& forest,
+            double* input, int n_rows, int n_cols, int* labels,
+            int n_unique_labels, RF_params rf_params) {
+  ASSERT(!forest->trees, "Cannot fit an existing forest.");
+  forest->trees =
+    new DecisionTree::TreeMetaDataNode<double, int>[rf_params.n_trees];
+  forest->rf_params = rf_params;
+
+  std::shared_ptr<rfClassifier<double>> rf_classifier =
+    std::make_shared<rfClassifier<double>>(rf_params);
+  rf_classifier->fit(user_handle, input, n_rows, n_cols, labels,
+                     n_unique_labels, forest, true);
+}
+/** @} */
+
 /**
  * @defgroup Random Forest Classification - Predict function
  * @brief Predict target feature for input data; n-ary classification for
@@ -422,6 +815,50 @@ void predict(const cumlHandle& user_handle,
 }
 /** @} */
 
+/**
+ * @defgroup Random Forest Classification - Fit and predict from matrix views
+ * @brief As fit and predict, from matrices of any layout.
+ * @{
+ */
+void fit(const cumlHandle& user_handle, RandomForestClassifierF*& forest,
+         const matrixView<const float>& input, int* labels,
+         int n_unique_labels, RF_params rf_params) {
+  device_buffer<float> buf(user_handle.getDeviceAllocator(),
+                           user_handle.getStream());
+  fit(user_handle, forest, view_data(user_handle, input, false, buf),
+      input.rows, input.cols, labels, n_unique_labels, rf_params);
+}
+
+void fit(const cumlHandle& user_handle, RandomForestClassifierD*& forest,
+         const matrixView<const double>& input, int* labels,
+         int n_unique_labels, RF_params rf_params) {
+  device_buffer<double> buf(user_handle.getDeviceAllocator(),
+                            user_handle.getStream());
+  fit(user_handle, forest, view_data(user_handle, input, false, buf),
+      input.rows, input.cols, labels, n_unique_labels, rf_params);
+}
+
+void predict(const cumlHandle& user_handle,
+             const RandomForestClassifierF* forest,
+             const matrixView<const float>& input, int* predictions,
+             bool verbose) {
+  device_buffer<float> buf(user_handle.getDeviceAllocator(),
+                           user_handle.getStream());
+  predict(user_handle, forest, view_data(user_handle, input, true, buf),
+          input.rows, input.cols, predictions, verbose);
+}
+
+void predict(const cumlHandle& user_handle,
+             const RandomForestClassifierD* forest,
+             const matrixView<const double>& input, int* predictions,
+             bool verbose) {
+  device_buffer<double> buf(user_handle.getDeviceAllocator(),
+                            user_handle.getStream());
+  predict(user_handle, forest, view_data(user_handle, input, true, buf),
+          input.rows, input.cols, predictions, verbose);
+}
+/** @} */
+
 /**
  * @defgroup Random Forest Classification - Predict function
  * @brief Predict target feature for input data; n-ary classification for
@@ -554,6 +991,39 @@ void fit(const cumlHandle& user_handle, RandomForestRegressorD*& forest,
 }
 /** @} */
 
+/**
+ * @defgroup Random Forest Regression - Distributed fit function
+ * @brief Same as fit, with the trees trained by all the ranks of the
+ *   communicator of user_handle (see the classification fit_mg).
+ * @{
+ */
+void fit_mg(const cumlHandle& user_handle, RandomForestRegressorF*& forest,
+            float* input, int n_rows, int n_cols, float* labels,
+            RF_params rf_params) {
+  ASSERT(!forest->trees, "Cannot fit an existing forest.");
+  forest->trees =
+    new DecisionTree::TreeMetaDataNode<float, float>[rf_params.n_trees];
+  forest->rf_params = rf_params;
+
+  std::shared_ptr<rfRegressor<float>> rf_regressor =
+    std::make_shared<rfRegressor<float>>(rf_params);
+  rf_regressor->fit(user_handle, input, n_rows, n_cols, labels, forest, true);
+}
+
+void fit_mg(const cumlHandle& user_handle, RandomForestRegressorD*& forest,
+            double* input, int n_rows, int n_cols, double* labels,
+            RF_params rf_params) {
+  ASSERT(!forest->trees, "Cannot fit an existing forest.");
+  forest->trees =
+    new DecisionTree::TreeMetaDataNode<double, double>[rf_params.n_trees];
+  forest->rf_params = rf_params;
+
+  std::shared_ptr<rfRegressor<double>> rf_regressor =
+    std::make_shared<rfRegressor<double>>(rf_params);
+  rf_regressor->fit(user_handle, input, n_rows, n_cols, labels, forest, true);
+}
+/** @} */
+
 /**
  * @defgroup Random Forest Regression - Predict function
  * @brief Predict target feature for input data; regression for single feature supported.
@@ -588,6 +1058,50 @@ void predict(const cumlHandle& user_handle,
 }
 /** @} */
 
+/**
+ * @defgroup Random Forest Regression - Fit and predict from matrix views
+ * @brief As fit and predict, from matrices of any layout.
+ * @{
+ */
+void fit(const cumlHandle& user_handle, RandomForestRegressorF*& forest,
+         const matrixView<const float>& input, float* labels,
+         RF_params rf_params) {
+  device_buffer<float> buf(user_handle.getDeviceAllocator(),
+                           user_handle.getStream());
+  fit(user_handle, forest, view_data(user_handle, input, false, buf),
+      input.rows, input.cols, labels, rf_params);
+}
+
+void fit(const cumlHandle& user_handle, RandomForestRegressorD*& forest,
+         const matrixView<const double>& input, double* labels,
+         RF_params rf_params) {
+  device_buffer<double> buf(user_handle.getDeviceAllocator(),
+                            user_handle.getStream());
+  fit(user_handle, forest, view_data(user_handle, input, false, buf),
+      input.rows, input.cols, labels, rf_params);
+}
+
+void predict(const cumlHandle& user_handle,
+             const RandomForestRegressorF* forest,
+             const matrixView<const float>& input, float* predictions,
+             bool verbose) {
+  device_buffer<float> buf(user_handle.getDeviceAllocator(),
+                           user_handle.getStream());
+  predict(user_handle, forest, view_data(user_handle, input, true, buf),
+          input.rows, input.cols, predictions, verbose);
+}
+
+void predict(const cumlHandle& user_handle,
+             const RandomForestRegressorD* forest,
+             const matrixView<const double>& input, double* predictions,
+             bool verbose) {
+  device_buffer<double> buf(user_handle.getDeviceAllocator(),
+                            user_handle.getStream());
+  predict(user_handle, forest, view_data(user_handle, input, true, buf),
+          input.rows, input.cols, predictions, verbose);
+}
+/** @} */
+
 /**
  * @defgroup Random Forest Regression - Score function
  * @brief Predict target feature for input data and validate against ref_labels.
@@ -663,4 +1177,37 @@ template void build_treelite_forest<float, float>(
 template void build_treelite_forest<double, double>(
   ModelHandle* model, const RandomForestMetaData<double, double>* forest,
   int num_features, int task_category, std::vector<unsigned char>& data);
+template void save_forest<float, int>(
+  const RandomForestMetaData<float, int>* forest, std::vector<char>* pbytes);
+template void load_forest<float, int>(
+  RandomForestMetaData<float, int>* forest, const void* bytes, size_t size);
+template void build_fil_forest<float, int>(
+  const cumlHandle& handle, fil::forest_t* pforest,
+  const RandomForestMetaData<float, int>* forest, int num_features,
+  const fil::treelite_params_t* tl_params);
+template void save_forest<double, int>(
+  const RandomForestMetaData<double, int>* forest, std::vector<char>* pbytes);
+template void load_forest<double, int>(
+  RandomForestMetaData<double, int>* forest, const void* bytes, size_t size);
+template void build_fil_forest<double, int>(
+  const cumlHandle& handle, fil::forest_t* pforest,
+  const RandomForestMetaData<double, int>* forest, int num_features,
+  const fil::treelite_params_t* tl_params);
+template void save_forest<float, float>(
+  const RandomForestMetaData<float, float>* forest, std::vector<char>* pbytes);
+template void load_forest<float, float>(
+  RandomForestMetaData<float, float>* forest, const void* bytes, size_t size);
+template void build_fil_forest<float, float>(
+  const cumlHandle& handle, fil::forest_t* pforest,
+  const RandomForestMetaData<float, float>* forest, int num_features,
+  const fil::treelite_params_t* tl_params);
+template void save_forest<double, double>(
+  const RandomForestMetaData<double, double>* forest,
+  std::vector<char>* pbytes);
+template void load_forest<double, double>(
+  RandomForestMetaData<double, double>* forest, const void* bytes, size_t size);
+template void build_fil_forest<double, double>(
+  const cumlHandle& handle, fil::forest_t* pforest,
+  const RandomForestMetaData<double, double>* forest, int num_features,
+  const fil::treelite_params_t* tl_params);
 }  // End namespace ML
@@ -18,6 +18,8 @@
 #endif
 #include "../decisiontree/memory.h"
 #include "../decisiontree/quantile/quantile.h"
+#include "oob_kernels.cuh"
+#include "predict_kernels.cuh"
 #include "random/permute.h"
 #include "random/rng.h"
 #include "randomforest_impl.h"
@@ -109,13 +111,137 @@ void rf<T, L>::error_checking(const T* input, L* predictions, int n_rows,
   bool input_is_dev_ptr = is_dev_ptr(input);
   bool preds_is_dev_ptr = is_dev_ptr(predictions);
 
-  if (!input_is_dev_ptr || (input_is_dev_ptr != preds_is_dev_ptr)) {
+  if (!predict && rf_params.tree_params.stream_cols > 0) {
+    ASSERT(!input_is_dev_ptr && preds_is_dev_ptr,
+           "RF Error: Expected a host pointer for input and a GPU pointer for "
+           "labels with stream_cols > 0");
+  } else if (!input_is_dev_ptr || (input_is_dev_ptr != preds_is_dev_ptr)) {
     ASSERT(false,
            "RF Error: Expected both input and labels/predictions to be GPU "
            "pointers");
   }
 }
 
+/**
+ * @brief Range [tree_begin, tree_end) of the trees of a forest of n_trees
+ *   trees which rank trains, out of n_ranks, in a distributed fit.
+ */
+void distributed_tree_range(int n_trees, int rank, int n_ranks,
+                            int& tree_begin, int& tree_end) {
+  tree_begin = (int)((long long)n_trees * rank / n_ranks);
+  tree_end = (int)((long long)n_trees * (rank + 1) / n_ranks);
+}
+
+/**
+ * @brief Range [tree_begin, tree_end) of the trees to train on this rank:
+ *   all of them, unless distributed over the ranks of the communicator of
+ *   handle.
+ */
+template <typename T, typename L>
+void rf<T, L>::local_tree_range(const cumlHandle_impl& handle,
+                                bool distributed, int& tree_begin,
+                                int& tree_end) const {
+  tree_begin = 0;
+  tree_end = rf_params.n_trees;
+  if (!distributed) return;
+  ASSERT(handle.commsInitialized(),
+         "A distributed fit requires a handle with a communicator");
+  const MLCommon::cumlCommunicator& comm = handle.getCommunicator();
+  distributed_tree_range(rf_params.n_trees, comm.getRank(), comm.getSize(),
+                         tree_begin, tree_end);
+}
+
+/**
+ * @brief Copy the trees trained by each rank of the communicator of handle
+ *   (see distributed_tree_range) to all the other ranks, so that every rank
+ *   ends up with the whole forest.
+ * @tparam T: data type for input data (float or double).
+ * @tparam L: data type for labels (int type for classification, T type for regression).
+ * @param[in] handle: cumlHandle_impl, with a communicator.
+ * @param[in, out] forest: CPU pointer to RandomForestMetaData struct.
+ */
+template <typename T, typename L>
+void exchange_trees(const cumlHandle_impl& handle,
+                    RandomForestMetaData<T, L>* forest) {
+  const MLCommon::cumlCommunicator& comm = handle.getCommunicator();
+  cudaStream_t stream = handle.getStream();
+  std::shared_ptr<deviceAllocator> d_alloc = handle.getDeviceAllocator();
+  int n_trees = forest->rf_params.n_trees;
+  int rank = comm.getRank();
+  int n_ranks = comm.getSize();
+  int tree_begin, tree_end;
+  distributed_tree_range(n_trees, rank, n_ranks, tree_begin, tree_end);
+
+  // Node, depth and leaf counts and times of each tree: the other ranks
+  // contribute zeros to the sums
+  std::vector<int> h_counts(3 * n_trees, 0);
+  std::vector<double> h_times(2 * n_trees, 0.0);
+  for (int i = tree_begin; i < tree_end; i++) {
+    const DecisionTree::TreeMetaDataNode<T, L>& tree = forest->trees[i];
+    h_counts[3 * i] = tree.sparsetree.size();
+    h_counts[3 * i + 1] = tree.depth_counter;
+    h_counts[3 * i + 2] = tree.leaf_counter;
+    h_times[2 * i] = tree.prepare_time;
+    h_times[2 * i + 1] = tree.train_time;
+  }
+  MLCommon::device_buffer<int> counts(d_alloc, stream, 3 * n_trees);
+  MLCommon::device_buffer<double> times(d_alloc, stream, 2 * n_trees);
+  MLCommon::updateDevice(counts.data(), h_counts.data(), 3 * n_trees, stream);
+  MLCommon::updateDevice(times.data(), h_times.data(), 2 * n_trees, stream);
+  comm.allreduce(counts.data(), counts.data(), 3 * n_trees,
+                 MLCommon::cumlCommunicator::SUM, stream);
+  comm.allreduce(times.data(), times.data(), 2 * n_trees,
+                 MLCommon::cumlCommunicator::SUM, stream);
+  MLCommon::updateHost(h_counts.data(), counts.data(), 3 * n_trees, stream);
+  MLCommon::updateHost(h_times.data(), times.data(), 2 * n_trees, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  for (int i = 0; i < n_trees; i++) {
+    DecisionTree::TreeMetaDataNode<T, L>& tree = forest->trees[i];
+    tree.treeid = i;
+    tree.depth_counter = h_counts[3 * i + 1];
+    tree.leaf_counter = h_counts[3 * i + 2];
+    tree.prepare_time = h_times[2 * i];
+    tree.train_time = h_times[2 * i + 1];
+  }
+
+  // The nodes of the trees of each rank, broadcast from it in one piece
+  typedef SparseTreeNode<T, L> Node;
+  for (int r = 0; r < n_ranks; r++) {
+    int begin, end;
+    distributed_tree_range(n_trees, r, n_ranks, begin, end);
+    size_t n_nodes = 0;
+    for (int i = begin; i < end; i++) n_nodes += h_counts[3 * i];
+    if (n_nodes == 0) continue;
+    size_t n_bytes = n_nodes * sizeof(Node);
+    ASSERT(n_bytes <= INT_MAX,
+           "The trees of rank %d are too large to be broadcast", r);
+    std::vector<Node> h_nodes;
+    MLCommon::device_buffer<Node> nodes(d_alloc, stream, n_nodes);
+    if (r == rank) {
+      for (int i = begin; i < end; i++) {
+        const std::vector<Node>& tree = forest->trees[i].sparsetree;
+        h_nodes.insert(h_nodes.end(), tree.begin(), tree.end());
+      }
+      MLCommon::updateDevice(nodes.data(), h_nodes.data(), n_nodes, stream);
+    }
+    comm.bcast((char*)nodes.data(), (int)n_bytes, r, stream);
+    if (r != rank) {
+      h_nodes.resize(n_nodes);
+      MLCommon::updateHost(h_nodes.data(), nodes.data(), n_nodes, stream);
+    }
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    if (r != rank) {
+      size_t offset = 0;
+      for (int i = begin; i < end; i++) {
+        forest->trees[i].sparsetree.assign(
+          h_nodes.begin() + offset, h_nodes.begin() + offset + h_counts[3 * i]);
+        offset += h_counts[3 * i];
+      }
+    }
+    nodes.release(stream);
+  }
+}
+
 /**
  * @brief Construct rfClassifier object.
  * @tparam T: data type for input data (float or double).
@@ -152,6 +278,7 @@ const DecisionTree::DecisionTreeClassifier<T>* rfClassifier<T>::get_trees_ptr()
  * @param[in] user_handle: cumlHandle
  * @param[in] input: train data (n_rows samples, n_cols features) in column major format,
  *   excluding labels. Device pointer.
+ *   Host pointer if rf_params.tree_params.stream_cols > 0.
  * @param[in] n_rows: number of training data samples.
  * @param[in] n_cols: number of features (i.e., columns) excluding target feature.
  * @param[in] labels: 1D array of target features (int only), with one label per training sample. Device pointer.
@@ -159,12 +286,18 @@ const DecisionTree::DecisionTreeClassifier<T>* rfClassifier<T>::get_trees_ptr()
           needed for current gini impl in decision tree
  * @param[in] n_unique_labels: #unique label values (known during preprocessing)
  * @param[in] forest: CPU point to RandomForestMetaData struct.
+ * @param[in] distributed: whether the trees are trained by the ranks of the
+ *   communicator of user_handle, each on the whole data, and then exchanged.
  */
 template <typename T>
 void rfClassifier<T>::fit(const cumlHandle& user_handle, const T* input,
                           int n_rows, int n_cols, int* labels,
                           int n_unique_labels,
-                          RandomForestMetaData<T, int>*& forest) {
+                          RandomForestMetaData<T, int>*& forest,
+                          bool distributed) {
+  ML::detail::phaseScope range(user_handle.getImpl(), "ML::RF::ClassifierFit",
+                               "rows=%d cols=%d trees=%d", n_rows, n_cols,
+                               this->rf_params.n_trees);
   this->error_checking(input, labels, n_rows, n_cols, false);
 
   const cumlHandle_impl& handle = user_handle.getImpl();
@@ -174,20 +307,53 @@ void rfClassifier<T>::fit(const cumlHandle& user_handle, const T* input,
          "rf_params.n_streams (=%d) should be <= cumlHandle.n_streams (=%d)",
          n_streams, handle.getNumInternalStreams());
 
+  int tree_begin, tree_end;
+  this->local_tree_range(handle, distributed, tree_begin, tree_end);
+
   cudaStream_t stream = handle.getStream();
+  bool streamed = this->rf_params.tree_params.stream_cols > 0;
+  if (streamed) {
+    DecisionTree::validity_check(this->rf_params.tree_params);
+    ASSERT(this->rf_params.tree_batch_size == 1,
+           "stream_cols does not support trees grown in lock-step");
+  }
+  bool oob = this->rf_params.oob_score;
+  ASSERT(!oob || (!streamed && !distributed),
+         "oob_score is not supported with stream_cols or by the distributed "
+         "fit");
+  // Out-of-bag votes and feature importances, summed over the trees
+  size_t n_votes = oob ? size_t(n_rows) * n_unique_labels : 0;
+  MLCommon::device_buffer<int> oob_votes(handle.getDeviceAllocator(), stream,
+                                         n_votes);
+  MLCommon::device_buffer<T> importance(handle.getDeviceAllocator(), stream,
+                                        oob ? n_cols : 0);
+  if (oob) {
+    CUDA_CHECK(
+      cudaMemsetAsync(oob_votes.data(), 0, n_votes * sizeof(int), stream));
+    CUDA_CHECK(
+      cudaMemsetAsync(importance.data(), 0, n_cols * sizeof(T), stream));
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+  OobVotes votes_acc = {oob_votes.data(), n_rows};
+  // Trees grown in lock-step share the user stream, with one workspace
+  // (selected_rows and tempmem) per tree of a batch instead of per stream.
+  int batch_size =
+    min(this->rf_params.tree_batch_size, this->rf_params.n_trees);
+  bool batched = batch_size > 1;
+  int n_slots = batched ? batch_size : n_streams;
   // Select n_sampled_rows (with replacement) numbers from [0, n_rows) per tree.
   // selected_rows: randomly generated IDs for bootstrapped samples (w/ replacement); a device ptr.
-  MLCommon::device_buffer<unsigned int>* selected_rows[n_streams];
-  for (int i = 0; i < n_streams; i++) {
-    auto s = handle.getInternalStream(i);
+  MLCommon::device_buffer<unsigned int>* selected_rows[n_slots];
+  for (int i = 0; i < n_slots; i++) {
+    auto s = batched ? stream : handle.getInternalStream(i);
     selected_rows[i] = new MLCommon::device_buffer<unsigned int>(
       handle.getDeviceAllocator(), s, n_sampled_rows);
   }
 
-  std::shared_ptr<TemporaryMemory<T, int>> tempmem[n_streams];
-  for (int i = 0; i < n_streams; i++) {
+  std::shared_ptr<TemporaryMemory<T, int>> tempmem[n_slots];
+  for (int i = 0; i < n_slots; i++) {
     tempmem[i] = std::make_shared<TemporaryMemory<T, int>>(
-      handle, handle.getInternalStream(i), n_rows, n_cols,
+      handle, batched ? stream : handle.getInternalStream(i), n_rows, n_cols,
       this->rf_params.tree_params.max_features, n_unique_labels,
       this->rf_params.tree_params.n_bins,
       this->rf_params.tree_params.split_algo,
@@ -195,11 +361,22 @@ void rfClassifier<T>::fit(const cumlHandle& user_handle, const T* input,
       this->rf_params.tree_params.shuffle_features);
   }
   //Preprocess once only per forest
+  MLCommon::device_buffer<char> bins(handle.getDeviceAllocator(),
+                                     tempmem[0]->stream, 0);
+  MLCommon::host_buffer<char> h_bins(handle.getHostAllocator(),
+                                     tempmem[0]->stream, 0);
   if ((this->rf_params.tree_params.split_algo == SPLIT_ALGO::GLOBAL_QUANTILE) &&
       !(this->rf_params.tree_params.quantile_per_tree)) {
-    preprocess_quantile(input, nullptr, n_rows, n_cols, n_rows,
-                        this->rf_params.tree_params.n_bins, tempmem[0]);
-    for (int i = 1; i < n_streams; i++) {
+    if (streamed) {
+      quantize_data_host(input, n_rows, n_cols,
+                         this->rf_params.tree_params.n_bins,
+                         this->rf_params.tree_params.stream_cols, tempmem,
+                         n_slots, h_bins);
+    } else {
+      preprocess_quantile(input, nullptr, n_rows, n_cols, n_rows,
+                          this->rf_params.tree_params.n_bins, tempmem[0]);
+    }
+    for (int i = 1; i < n_slots; i++) {
       CUDA_CHECK(cudaMemcpyAsync(
         tempmem[i]->d_quantile->data(), tempmem[0]->d_quantile->data(),
         this->rf_params.tree_params.n_bins * n_cols * sizeof(T),
@@ -208,41 +385,88 @@ void rfClassifier<T>::fit(const cumlHandle& user_handle, const T* input,
              (void*)(tempmem[0]->h_quantile->data()),
              this->rf_params.tree_params.n_bins * n_cols * sizeof(T));
     }
+    if (this->rf_params.tree_params.quantize && !streamed) {
+      quantize_data(input, n_rows, n_cols, this->rf_params.tree_params.n_bins,
+                    tempmem, n_slots, bins);
+    }
   }
 
+  if (batched) {
+    DecisionTree::TreeMetaDataNode<T, int>* tree_ptrs[batch_size];
+    unsigned int* rowids[batch_size];
+    for (int b = tree_begin; b < tree_end; b += batch_size) {
+      int n_batch = min(batch_size, tree_end - b);
+      for (int j = 0; j < n_batch; j++) {
+        rowids[j] = selected_rows[j]->data();
+        this->prepare_fit_per_tree(b + j, n_rows, n_sampled_rows, rowids[j],
+                                   tempmem[j]->num_sms, stream,
+                                   handle.getDeviceAllocator());
+        tree_ptrs[j] = &(forest->trees[b + j]);
+        tree_ptrs[j]->treeid = b + j;
+      }
+      DecisionTree::DecisionTreeClassifier<T>::fit_batched(
+        handle.getDeviceAllocator(), handle.getHostAllocator(), stream, input,
+        n_cols, n_rows, labels, rowids, n_sampled_rows, n_unique_labels,
+        trees + b, tree_ptrs, n_batch, this->rf_params.tree_params, tempmem);
+      for (int j = 0; oob && j < n_batch; j++) {
+        oob_tree(tree_ptrs[j], input, n_rows, n_cols,
+                 tempmem[j]->d_sample_cnt->data(), votes_acc,
+                 importance.data(), handle.getDeviceAllocator(), stream);
+      }
+    }
+  } else {
 #pragma omp parallel for num_threads(n_streams)
-  for (int i = 0; i < this->rf_params.n_trees; i++) {
-    int stream_id = omp_get_thread_num();
-    unsigned int* rowids;
-    rowids = selected_rows[stream_id]->data();
-
-    this->prepare_fit_per_tree(
-      i, n_rows, n_sampled_rows, rowids, tempmem[stream_id]->num_sms,
-      tempmem[stream_id]->stream, handle.getDeviceAllocator());
-
-    /* Build individual tree in the forest.
-       - input is a pointer to orig data that have n_cols features and n_rows rows.
-       - n_sampled_rows: # rows sampled for tree's bootstrap sample.
-       - sorted_selected_rows: points to a list of row #s (w/ n_sampled_rows elements)
-         used to build the bootstrapped sample.
-         Expectation: Each tree node will contain (a) # n_sampled_rows and
-         (b) a pointer to a list of row numbers w.r.t original data.
-    */
-    DecisionTree::TreeMetaDataNode<T, int>* tree_ptr = &(forest->trees[i]);
-    tree_ptr->treeid = i;
-    trees[i].fit(handle.getDeviceAllocator(), handle.getHostAllocator(),
-                 tempmem[stream_id]->stream, input, n_cols, n_rows, labels,
-                 rowids, n_sampled_rows, n_unique_labels, tree_ptr,
-                 this->rf_params.tree_params, tempmem[stream_id]);
+    for (int i = tree_begin; i < tree_end; i++) {
+      int stream_id = omp_get_thread_num();
+      unsigned int* rowids;
+      rowids = selected_rows[stream_id]->data();
+
+      this->prepare_fit_per_tree(
+        i, n_rows, n_sampled_rows, rowids, tempmem[stream_id]->num_sms,
+        tempmem[stream_id]->stream, handle.getDeviceAllocator());
+
+      /* Build individual tree in the forest.
+         - input is a pointer to orig data that have n_cols features and n_rows rows.
+         - n_sampled_rows: # rows sampled for tree's bootstrap sample.
+         - sorted_selected_rows: points to a list of row #s (w/ n_sampled_rows elements)
+           used to build the bootstrapped sample.
+           Expectation: Each tree node will contain (a) # n_sampled_rows and
+           (b) a pointer to a list of row numbers w.r.t original data.
+      */
+      DecisionTree::TreeMetaDataNode<T, int>* tree_ptr = &(forest->trees[i]);
+      tree_ptr->treeid = i;
+      trees[i].fit(handle.getDeviceAllocator(), handle.getHostAllocator(),
+                   tempmem[stream_id]->stream, input, n_cols, n_rows, labels,
+                   rowids, n_sampled_rows, n_unique_labels, tree_ptr,
+                   this->rf_params.tree_params, tempmem[stream_id]);
+      if (oob) {
+        oob_tree(tree_ptr, input, n_rows, n_cols,
+                 tempmem[stream_id]->d_sample_cnt->data(), votes_acc,
+                 importance.data(), handle.getDeviceAllocator(),
+                 tempmem[stream_id]->stream);
+      }
+    }
   }
   //Cleanup
-  for (int i = 0; i < n_streams; i++) {
+  for (int i = 0; i < n_slots; i++) {
     auto s = tempmem[i]->stream;
     CUDA_CHECK(cudaStreamSynchronize(s));
     selected_rows[i]->release(s);
     tempmem[i].reset();
     delete selected_rows[i];
   }
+  bins.release(handle.getStream());
+  h_bins.release(handle.getStream());
+  if (oob) {
+    forest->oob_metrics =
+      oob_classifier_metrics(oob_votes.data(), labels, n_rows, n_unique_labels,
+                             handle.getDeviceAllocator(), stream);
+    forest->feature_importances =
+      normalized_importances(importance.data(), n_cols, stream);
+  }
+  oob_votes.release(stream);
+  importance.release(stream);
+  if (distributed) exchange_trees(handle, forest);
 
   CUDA_CHECK(cudaStreamSynchronize(user_handle.getStream()));
 }
@@ -262,51 +486,15 @@ void rfClassifier<T>::predict(const cumlHandle& user_handle, const T* input,
                               int n_rows, int n_cols, int* predictions,
                               const RandomForestMetaData<T, int>* forest,
                               bool verbose) const {
+  ML::detail::phaseScope range(user_handle.getImpl(),
+                               "ML::RF::ClassifierPredict", "rows=%d cols=%d",
+                               n_rows, n_cols);
   this->error_checking(input, predictions, n_rows, n_cols, true);
-  std::vector<int> h_predictions(n_rows);
   const cumlHandle_impl& handle = user_handle.getImpl();
-  cudaStream_t stream = user_handle.getStream();
-
-  std::vector<T> h_input(n_rows * n_cols);
-  MLCommon::updateHost(h_input.data(), input, n_rows * n_cols, stream);
-  CUDA_CHECK(cudaStreamSynchronize(stream));
-
-  int row_size = n_cols;
-
-  for (int row_id = 0; row_id < n_rows; row_id++) {
-    if (verbose) {
-      std::cout << "\n\n";
-      std::cout << "Predict for sample: ";
-      for (int i = 0; i < n_cols; i++)
-        std::cout << h_input[row_id * row_size + i] << ", ";
-      std::cout << std::endl;
-    }
-
-    std::map<int, int> prediction_to_cnt;
-    std::pair<std::map<int, int>::iterator, bool> ret;
-    int max_cnt_so_far = 0;
-    int majority_prediction = -1;
-
-    for (int i = 0; i < this->rf_params.n_trees; i++) {
-      int prediction;
-      trees[i].predict(user_handle, &forest->trees[i],
-                       &h_input[row_id * row_size], 1, n_cols, &prediction,
-                       verbose);
-      ret = prediction_to_cnt.insert(std::pair<int, int>(prediction, 1));
-      if (!(ret.second)) {
-        ret.first->second += 1;
-      }
-      if (max_cnt_so_far < ret.first->second) {
-        max_cnt_so_far = ret.first->second;
-        majority_prediction = ret.first->first;
-      }
-    }
-
-    h_predictions[row_id] = majority_prediction;
-  }
-
-  MLCommon::updateDevice(predictions, h_predictions.data(), n_rows, stream);
-  CUDA_CHECK(cudaStreamSynchronize(stream));
+  // all rows and trees are processed on the GPU at once, with the majority
+  // vote of the trees done per row on the device
+  predict_classifier_gpu(handle, forest, input, n_rows, n_cols, predictions);
+  if (verbose) print_predictions(handle, predictions, n_rows);
 }
 
 /**
@@ -420,11 +608,19 @@ const DecisionTree::DecisionTreeRegressor<T>* rfRegressor<T>::get_trees_ptr()
  * @param[in] n_cols: number of features (i.e., columns) excluding target feature.
  * @param[in] labels: 1D array of target features (float or double), with one label per training sample. Device pointer.
  * @param[in, out] forest: CPU pointer to RandomForestMetaData struct
+ * @param[in] distributed: whether the trees are trained by the ranks of the
+ *   communicator of user_handle, each on the whole data, and then exchanged.
  */
 template <typename T>
 void rfRegressor<T>::fit(const cumlHandle& user_handle, const T* input,
                          int n_rows, int n_cols, T* labels,
-                         RandomForestMetaData<T, T>*& forest) {
+                         RandomForestMetaData<T, T>*& forest,
+                         bool distributed) {
+  ML::detail::phaseScope range(user_handle.getImpl(), "ML::RF::RegressorFit",
+                               "rows=%d cols=%d trees=%d", n_rows, n_cols,
+                               this->rf_params.n_trees);
+  ASSERT(this->rf_params.tree_params.stream_cols == 0,
+         "stream_cols is only supported by the RF classifier");
   this->error_checking(input, labels, n_rows, n_cols, false);
 
   const cumlHandle_impl& handle = user_handle.getImpl();
@@ -434,7 +630,30 @@ void rfRegressor<T>::fit(const cumlHandle& user_handle, const T* input,
          "rf_params.n_streams (=%d) should be <= cumlHandle.n_streams (=%d)",
          n_streams, handle.getNumInternalStreams());
 
+  int tree_begin, tree_end;
+  this->local_tree_range(handle, distributed, tree_begin, tree_end);
+
   cudaStream_t stream = user_handle.getStream();
+  bool oob = this->rf_params.oob_score;
+  ASSERT(!oob || !distributed,
+         "oob_score is not supported by the distributed fit");
+  // Out-of-bag prediction sums and counts and feature importances, summed
+  // over the trees
+  MLCommon::device_buffer<T> oob_sums(handle.getDeviceAllocator(), stream,
+                                      oob ? n_rows : 0);
+  MLCommon::device_buffer<int> oob_counts(handle.getDeviceAllocator(), stream,
+                                          oob ? n_rows : 0);
+  MLCommon::device_buffer<T> importance(handle.getDeviceAllocator(), stream,
+                                        oob ? n_cols : 0);
+  if (oob) {
+    CUDA_CHECK(cudaMemsetAsync(oob_sums.data(), 0, n_rows * sizeof(T), stream));
+    CUDA_CHECK(
+      cudaMemsetAsync(oob_counts.data(), 0, n_rows * sizeof(int), stream));
+    CUDA_CHECK(
+      cudaMemsetAsync(importance.data(), 0, n_cols * sizeof(T), stream));
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+  OobSums<T> sums_acc = {oob_sums.data(), oob_counts.data()};
   // Select n_sampled_rows (with replacement) numbers from [0, n_rows) per tree.
   // selected_rows: randomly generated IDs for bootstrapped samples (w/ replacement); a device ptr.
   MLCommon::device_buffer<unsigned int>* selected_rows[n_streams];
@@ -455,6 +674,8 @@ void rfRegressor<T>::fit(const cumlHandle& user_handle, const T* input,
       this->rf_params.tree_params.shuffle_features);
   }
   //Preprocess once only per forest
+  MLCommon::device_buffer<char> bins(handle.getDeviceAllocator(),
+                                     tempmem[0]->stream, 0);
   if ((this->rf_params.tree_params.split_algo == SPLIT_ALGO::GLOBAL_QUANTILE) &&
       !(this->rf_params.tree_params.quantile_per_tree)) {
     preprocess_quantile(input, nullptr, n_rows, n_cols, n_rows,
@@ -468,10 +689,14 @@ void rfRegressor<T>::fit(const cumlHandle& user_handle, const T* input,
              (void*)(tempmem[0]->h_quantile->data()),
              this->rf_params.tree_params.n_bins * n_cols * sizeof(T));
     }
+    if (this->rf_params.tree_params.quantize) {
+      quantize_data(input, n_rows, n_cols, this->rf_params.tree_params.n_bins,
+                    tempmem, n_streams, bins);
+    }
   }
 
 #pragma omp parallel for num_threads(n_streams)
-  for (int i = 0; i < this->rf_params.n_trees; i++) {
+  for (int i = tree_begin; i < tree_end; i++) {
     int stream_id = omp_get_thread_num();
     unsigned int* rowids = selected_rows[stream_id]->data();
     this->prepare_fit_per_tree(
@@ -491,6 +716,12 @@ void rfRegressor<T>::fit(const cumlHandle& user_handle, const T* input,
                  tempmem[stream_id]->stream, input, n_cols, n_rows, labels,
                  rowids, n_sampled_rows, tree_ptr, this->rf_params.tree_params,
                  tempmem[stream_id]);
+    if (oob) {
+      oob_tree(tree_ptr, input, n_rows, n_cols,
+               tempmem[stream_id]->d_sample_cnt->data(), sums_acc,
+               importance.data(), handle.getDeviceAllocator(),
+               tempmem[stream_id]->stream);
+    }
   }
   //Cleanup
   for (int i = 0; i < n_streams; i++) {
@@ -500,6 +731,18 @@ void rfRegressor<T>::fit(const cumlHandle& user_handle, const T* input,
     tempmem[i].reset();
     delete selected_rows[i];
   }
+  bins.release(handle.getStream());
+  if (oob) {
+    forest->oob_metrics =
+      oob_regressor_metrics(oob_sums.data(), oob_counts.data(), labels, n_rows,
+                            handle.getDeviceAllocator(), stream);
+    forest->feature_importances =
+      normalized_importances(importance.data(), n_cols, stream);
+  }
+  oob_sums.release(stream);
+  oob_counts.release(stream);
+  importance.release(stream);
+  if (distributed) exchange_trees(handle, forest);
 
   CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
 }
@@ -520,42 +763,15 @@ void rfRegressor<T>::predict(const cumlHandle& user_handle, const T* input,
                              int n_rows, int n_cols, T* predictions,
                              const RandomForestMetaData<T, T>* forest,
                              bool verbose) const {
+  ML::detail::phaseScope range(user_handle.getImpl(),
+                               "ML::RF::RegressorPredict", "rows=%d cols=%d",
+                               n_rows, n_cols);
   this->error_checking(input, predictions, n_rows, n_cols, true);
-
-  std::vector<T> h_predictions(n_rows);
   const cumlHandle_impl& handle = user_handle.getImpl();
-  cudaStream_t stream = user_handle.getStream();
-
-  std::vector<T> h_input(n_rows * n_cols);
-  MLCommon::updateHost(h_input.data(), input, n_rows * n_cols, stream);
-  CUDA_CHECK(cudaStreamSynchronize(stream));
-
-  int row_size = n_cols;
-
-  for (int row_id = 0; row_id < n_rows; row_id++) {
-    if (verbose) {
-      std::cout << "\n\n";
-      std::cout << "Predict for sample: ";
-      for (int i = 0; i < n_cols; i++)
-        std::cout << h_input[row_id * row_size + i] << ", ";
-      std::cout << std::endl;
-    }
-
-    T sum_predictions = 0;
-
-    for (int i = 0; i < this->rf_params.n_trees; i++) {
-      T prediction;
-      trees[i].predict(user_handle, &forest->trees[i],
-                       &h_input[row_id * row_size], 1, n_cols, &prediction,
-                       verbose);
-      sum_predictions += prediction;
-    }
-    // Random forest's prediction is the arithmetic mean of all its decision tree predictions.
-    h_predictions[row_id] = sum_predictions / this->rf_params.n_trees;
-  }
-
-  MLCommon::updateDevice(predictions, h_predictions.data(), n_rows, stream);
-  CUDA_CHECK(cudaStreamSynchronize(stream));
+  // all rows and trees are processed on the GPU at once, with the averaging
+  // of the tree predictions done per row on the device
+  predict_regressor_gpu(handle, forest, input, n_rows, n_cols, predictions);
+  if (verbose) print_predictions(handle, predictions, n_rows);
 }
 
 /**
@@ -35,6 +35,8 @@ class rf {
 
   void error_checking(const T* input, L* predictions, int n_rows, int n_cols,
                       bool is_predict) const;
+  void local_tree_range(const cumlHandle_impl& handle, bool distributed,
+                        int& tree_begin, int& tree_end) const;
 
  public:
   rf(RF_params cfg_rf_params, int cfg_rf_type = RF_type::CLASSIFICATION);
@@ -54,7 +56,7 @@ class rfClassifier : public rf<T, int> {
 
   void fit(const cumlHandle& user_handle, const T* input, int n_rows,
            int n_cols, int* labels, int n_unique_labels,
-           RandomForestMetaData<T, int>*& forest);
+           RandomForestMetaData<T, int>*& forest, bool distributed = false);
   void predict(const cumlHandle& user_handle, const T* input, int n_rows,
                int n_cols, int* predictions,
                const RandomForestMetaData<T, int>* forest,
@@ -78,7 +80,8 @@ class rfRegressor : public rf<T, T> {
   ~rfRegressor();
 
   void fit(const cumlHandle& user_handle, const T* input, int n_rows,
-           int n_cols, T* labels, RandomForestMetaData<T, T>*& forest);
+           int n_cols, T* labels, RandomForestMetaData<T, T>*& forest,
+           bool distributed = false);
   void predict(const cumlHandle& user_handle, const T* input, int n_rows,
                int n_cols, T* predictions,
                const RandomForestMetaData<T, T>* forest,
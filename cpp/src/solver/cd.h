@@ -39,6 +39,110 @@ namespace Solver {
 
 using namespace MLCommon;
 
+/**
+ * One epoch of covariance coordinate descent, run by a single block. The
+ * coordinates ri[0..n_active) are updated in turn from the correlations
+ * q = X^T y - G w with the residual, and q is then updated by the column of
+ * the Gram matrix G = X^T X of the coordinate. max[0] and max[1] receive the
+ * largest change of a coefficient and the largest coefficient.
+ */
+template <typename math_t, int TPB>
+__global__ void cdGramEpochKernel(math_t *coef, math_t *q, const math_t *gram,
+                                  const math_t *squared, const int *ri,
+                                  int n_active, int n_cols, math_t alpha,
+                                  bool l1, math_t *max) {
+  __shared__ math_t delta;
+  math_t coef_max = 0, d_coef_max = 0;
+  for (int j = 0; j < n_active; j++) {
+    const int ci = ri[j];
+    const math_t *gram_col = gram + size_t(ci) * n_cols;
+    if (threadIdx.x == 0) {
+      const math_t w = coef[ci];
+      math_t rho = q[ci] + gram_col[ci] * w;
+      if (l1) {
+        rho = myAbs(rho) > alpha ? (rho > 0 ? rho - alpha : rho + alpha) : 0;
+      }
+      const math_t w_new = squared[ci] == math_t(0) ? 0 : rho / squared[ci];
+      coef[ci] = w_new;
+      delta = w_new - w;
+      d_coef_max = myMax(d_coef_max, myAbs(delta));
+      coef_max = myMax(coef_max, myAbs(w_new));
+    }
+    __syncthreads();
+    const math_t d = delta;
+    if (d != math_t(0)) {
+      for (int k = threadIdx.x; k < n_cols; k += TPB) q[k] -= gram_col[k] * d;
+    }
+    __syncthreads();
+  }
+  if (threadIdx.x == 0) {
+    max[0] = d_coef_max;
+    max[1] = coef_max;
+  }
+}
+
+/**
+ * Runs up to epochs epochs of covariance coordinate descent over the
+ * coordinates ri, from the correlations q of coef, until the largest change
+ * of a coefficient relative to the largest coefficient is below tol.
+ */
+template <typename math_t>
+void cdGramSweeps(const cumlHandle_impl &handle, math_t *coef, math_t *q,
+                  const math_t *gram, const math_t *squared, int n_cols,
+                  int epochs, math_t alpha, bool l1, bool shuffle, math_t tol,
+                  std::vector<int> &ri, std::mt19937 &g, cudaStream_t stream) {
+  static const int TPB = 1024;
+  const int n_active = ri.size();
+  if (n_active == 0) return;
+  auto allocator = handle.getDeviceAllocator();
+  device_buffer<int> d_ri(allocator, stream, n_active);
+  device_buffer<math_t> d_max(allocator, stream, 2);
+  updateDevice(d_ri.data(), ri.data(), n_active, stream);
+
+  math_t h_max[2];
+  for (int i = 0; i < epochs; i++) {
+    if (i > 0 && shuffle) {
+      Solver::shuffle(ri, g);
+      updateDevice(d_ri.data(), ri.data(), n_active, stream);
+    }
+
+    cdGramEpochKernel<math_t, TPB><<<1, TPB, 0, stream>>>(
+      coef, q, gram, squared, d_ri.data(), n_active, n_cols, alpha, l1,
+      d_max.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+    updateHost(h_max, d_max.data(), 2, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+
+    if (h_max[1] == math_t(0) || (h_max[0] / h_max[1]) < tol) break;
+  }
+}
+
+/**
+ * The epochs of cdFit with precompute_gram: the Gram matrix X^T X and X^T y
+ * are computed once, and an epoch is then a single kernel whose coordinate
+ * updates cost O(n_cols) each, instead of O(n_rows) and several kernels.
+ */
+template <typename math_t>
+void cdGramEpochs(const cumlHandle_impl &handle, const math_t *input,
+                  int n_rows, int n_cols, const math_t *labels, math_t *coef,
+                  const math_t *squared, int epochs, math_t alpha, bool l1,
+                  bool shuffle, math_t tol, std::vector<int> &ri,
+                  std::mt19937 &g, cudaStream_t stream) {
+  cublasHandle_t cublas_handle = handle.getCublasHandle();
+  auto allocator = handle.getDeviceAllocator();
+  device_buffer<math_t> gram(allocator, stream, size_t(n_cols) * n_cols);
+  device_buffer<math_t> q(allocator, stream, n_cols);
+
+  LinAlg::gemm(input, n_rows, n_cols, input, gram.data(), n_cols, n_cols,
+               CUBLAS_OP_T, CUBLAS_OP_N, cublas_handle, stream);
+  LinAlg::gemm(input, n_rows, n_cols, labels, q.data(), n_cols, 1,
+               CUBLAS_OP_T, CUBLAS_OP_N, cublas_handle, stream);
+  CUDA_CHECK(cudaMemsetAsync(coef, 0, n_cols * sizeof(math_t), stream));
+
+  cdGramSweeps(handle, coef, q.data(), gram.data(), squared, n_cols, epochs,
+               alpha, l1, shuffle, tol, ri, g, stream);
+}
+
 /**
  * Fits a linear, lasso, and elastic-net regression model using Coordinate Descent solver
  * @param cumlHandle_impl
@@ -75,12 +179,17 @@ using namespace MLCommon;
  *        tolerance to stop the solver
  * @param stream
  *        cuda stream
+ * @param precompute_gram
+ *        boolean parameter to run the coordinate updates on the precomputed
+ *        Gram matrix X^T X, of size n_cols * n_cols, rather than on the
+ *        residual. It is faster when n_rows is much larger than n_cols.
  */
 template <typename math_t>
 void cdFit(const cumlHandle_impl &handle, math_t *input, int n_rows, int n_cols,
            math_t *labels, math_t *coef, math_t *intercept, bool fit_intercept,
            bool normalize, int epochs, ML::loss_funct loss, math_t alpha,
-           math_t l1_ratio, bool shuffle, math_t tol, cudaStream_t stream) {
+           math_t l1_ratio, bool shuffle, math_t tol, cudaStream_t stream,
+           bool precompute_gram = false) {
   ASSERT(n_cols > 0,
          "Parameter n_cols: number of columns cannot be less than one");
   ASSERT(n_rows > 1,
@@ -128,63 +237,69 @@ void cdFit(const cumlHandle_impl &handle, math_t *input, int n_rows, int n_cols,
     LinAlg::addScalar(squared.data(), squared.data(), l2_alpha, n_cols, stream);
   }
 
-  copy(residual.data(), labels, n_rows, stream);
+  if (precompute_gram) {
+    cdGramEpochs(handle, input, n_rows, n_cols, labels, coef, squared.data(),
+                 epochs, alpha, l1_ratio > math_t(0), shuffle, tol, ri, g,
+                 stream);
+  } else {
+    copy(residual.data(), labels, n_rows, stream);
 
-  for (int i = 0; i < epochs; i++) {
-    if (i > 0 && shuffle) {
-      Solver::shuffle(ri, g);
-    }
+    for (int i = 0; i < epochs; i++) {
+      if (i > 0 && shuffle) {
+        Solver::shuffle(ri, g);
+      }
 
-    math_t coef_max = 0.0;
-    math_t d_coef_max = 0.0;
-    math_t coef_prev = 0.0;
+      math_t coef_max = 0.0;
+      math_t d_coef_max = 0.0;
+      math_t coef_prev = 0.0;
 
-    for (int j = 0; j < n_cols; j++) {
-      int ci = ri[j];
-      math_t *coef_loc = coef + ci;
-      math_t *squared_loc = squared.data() + ci;
-      math_t *input_col_loc = input + (ci * n_rows);
+      for (int j = 0; j < n_cols; j++) {
+        int ci = ri[j];
+        math_t *coef_loc = coef + ci;
+        math_t *squared_loc = squared.data() + ci;
+        math_t *input_col_loc = input + (ci * n_rows);
 
-      LinAlg::multiplyScalar(pred.data(), input_col_loc, h_coef[ci], n_rows,
-                             stream);
-      LinAlg::add(residual.data(), residual.data(), pred.data(), n_rows,
-                  stream);
-      LinAlg::gemm(input_col_loc, n_rows, 1, residual.data(), coef_loc, 1, 1,
-                   CUBLAS_OP_T, CUBLAS_OP_N, cublas_handle, stream);
+        LinAlg::multiplyScalar(pred.data(), input_col_loc, h_coef[ci], n_rows,
+                               stream);
+        LinAlg::add(residual.data(), residual.data(), pred.data(), n_rows,
+                    stream);
+        LinAlg::gemm(input_col_loc, n_rows, 1, residual.data(), coef_loc, 1, 1,
+                     CUBLAS_OP_T, CUBLAS_OP_N, cublas_handle, stream);
 
-      if (l1_ratio > math_t(0.0))
-        Functions::softThres(coef_loc, coef_loc, alpha, 1, stream);
+        if (l1_ratio > math_t(0.0))
+          Functions::softThres(coef_loc, coef_loc, alpha, 1, stream);
 
-      LinAlg::eltwiseDivideCheckZero(coef_loc, coef_loc, squared_loc, 1,
-                                     stream);
+        LinAlg::eltwiseDivideCheckZero(coef_loc, coef_loc, squared_loc, 1,
+                                       stream);
 
-      coef_prev = h_coef[ci];
-      updateHost(&(h_coef[ci]), coef_loc, 1, stream);
-      CUDA_CHECK(cudaStreamSynchronize(stream));
+        coef_prev = h_coef[ci];
+        updateHost(&(h_coef[ci]), coef_loc, 1, stream);
+        CUDA_CHECK(cudaStreamSynchronize(stream));
 
-      math_t diff = abs(coef_prev - h_coef[ci]);
+        math_t diff = abs(coef_prev - h_coef[ci]);
 
-      if (diff > d_coef_max) d_coef_max = diff;
+        if (diff > d_coef_max) d_coef_max = diff;
 
-      if (abs(h_coef[ci]) > coef_max) coef_max = abs(h_coef[ci]);
+        if (abs(h_coef[ci]) > coef_max) coef_max = abs(h_coef[ci]);
 
-      LinAlg::multiplyScalar(pred.data(), input_col_loc, h_coef[ci], n_rows,
-                             stream);
-      LinAlg::subtract(residual.data(), residual.data(), pred.data(), n_rows,
-                       stream);
-    }
+        LinAlg::multiplyScalar(pred.data(), input_col_loc, h_coef[ci], n_rows,
+                               stream);
+        LinAlg::subtract(residual.data(), residual.data(), pred.data(), n_rows,
+                         stream);
+      }
 
-    bool flag_continue = true;
-    if (coef_max == math_t(0)) {
-      flag_continue = false;
-    }
+      bool flag_continue = true;
+      if (coef_max == math_t(0)) {
+        flag_continue = false;
+      }
 
-    if ((d_coef_max / coef_max) < tol) {
-      flag_continue = false;
-    }
+      if ((d_coef_max / coef_max) < tol) {
+        flag_continue = false;
+      }
 
-    if (!flag_continue) {
-      break;
+      if (!flag_continue) {
+        break;
+      }
     }
   }
 
@@ -198,6 +313,152 @@ void cdFit(const cumlHandle_impl &handle, math_t *input, int n_rows, int n_cols,
   }
 }
 
+/**
+ * Fits the linear, lasso, and elastic-net regression models of a decreasing
+ * sequence of alphas, by covariance coordinate descent on a Gram matrix
+ * computed once. Each fit starts from the solution of the previous alpha.
+ * The features are screened by the sequential strong rule: a feature whose
+ * correlation with the residual of the previous solution is below
+ * 2 * alpha_k - alpha_k-1 (their l1 parts) is left out of the updates, and
+ * it is put back if it violates the optimality conditions of the solution.
+ * @param alphas
+ *        host pointer to the decreasing sequence of alphas (size of n_alphas)
+ * @param n_alphas
+ *        number of alphas
+ * @param coefs
+ *        pointer to an array for the coefficients of each alpha (size of
+ *        n_cols, n_alphas in column-major format)
+ * @param intercepts
+ *        host pointer to an array for the intercept of each alpha (size of
+ *        n_alphas)
+ * The other parameters are those of cdFit.
+ */
+template <typename math_t>
+void cdFitPath(const cumlHandle_impl &handle, math_t *input, int n_rows,
+               int n_cols, math_t *labels, const math_t *alphas, int n_alphas,
+               math_t *coefs, math_t *intercepts, bool fit_intercept,
+               bool normalize, int epochs, ML::loss_funct loss,
+               math_t l1_ratio, bool shuffle, math_t tol,
+               cudaStream_t stream) {
+  ASSERT(n_cols > 0,
+         "Parameter n_cols: number of columns cannot be less than one");
+  ASSERT(n_rows > 1,
+         "Parameter n_rows: number of rows cannot be less than two");
+  ASSERT(n_alphas > 0,
+         "Parameter n_alphas: number of alphas cannot be less than one");
+  ASSERT(loss == ML::loss_funct::SQRD_LOSS,
+         "Parameter loss: Only SQRT_LOSS function is supported for now");
+  for (int k = 1; k < n_alphas; k++) {
+    ASSERT(alphas[k] <= alphas[k - 1],
+           "Parameter alphas: the alphas must be in decreasing order");
+  }
+
+  cublasHandle_t cublas_handle = handle.getCublasHandle();
+
+  auto allocator = handle.getDeviceAllocator();
+  device_buffer<math_t> norms(allocator, stream, n_cols);
+  device_buffer<math_t> squared(allocator, stream, n_cols);
+  device_buffer<math_t> gram(allocator, stream, size_t(n_cols) * n_cols);
+  device_buffer<math_t> xty(allocator, stream, n_cols);
+  device_buffer<math_t> q(allocator, stream, n_cols);
+  device_buffer<math_t> mu_input(allocator, stream, 0);
+  device_buffer<math_t> mu_labels(allocator, stream, 0);
+  device_buffer<math_t> norm2_input(allocator, stream, 0);
+
+  if (fit_intercept) {
+    mu_input.resize(n_cols, stream);
+    mu_labels.resize(1, stream);
+    if (normalize) {
+      norm2_input.resize(n_cols, stream);
+    }
+
+    GLM::preProcessData(handle, input, n_rows, n_cols, labels, intercepts,
+                        mu_input.data(), mu_labels.data(), norm2_input.data(),
+                        fit_intercept, normalize, stream);
+  }
+
+  if (normalize) {
+    Matrix::setValue(norms.data(), norms.data(), math_t(1), n_cols, stream);
+  } else {
+    LinAlg::colNorm(norms.data(), input, n_cols, n_rows, LinAlg::L2Norm,
+                    false, stream);
+  }
+
+  LinAlg::gemm(input, n_rows, n_cols, input, gram.data(), n_cols, n_cols,
+               CUBLAS_OP_T, CUBLAS_OP_N, cublas_handle, stream);
+  LinAlg::gemm(input, n_rows, n_cols, labels, xty.data(), n_cols, 1,
+               CUBLAS_OP_T, CUBLAS_OP_N, cublas_handle, stream);
+
+  // the correlations with the residual and the coefficients of the previous
+  // solution, which is 0 before the first alpha
+  std::vector<math_t> h_q(n_cols), h_coef(n_cols, math_t(0));
+  updateHost(h_q.data(), xty.data(), n_cols, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  // the smallest l1 penalty of a 0 solution precedes the first alpha
+  math_t l1_prev = math_t(0);
+  for (int j = 0; j < n_cols; j++) l1_prev = std::max(l1_prev, abs(h_q[j]));
+
+  std::vector<int> ri;
+  std::vector<bool> active(n_cols);
+  std::mt19937 g(rand());
+  const bool l1 = l1_ratio > math_t(0);
+
+  for (int k = 0; k < n_alphas; k++) {
+    math_t *coef = coefs + size_t(k) * n_cols;
+    if (k == 0) {
+      CUDA_CHECK(cudaMemsetAsync(coef, 0, n_cols * sizeof(math_t), stream));
+      copy(q.data(), xty.data(), n_cols, stream);
+    } else {
+      // q already holds the correlations of the previous solution
+      copy(coef, coef - n_cols, n_cols, stream);
+    }
+
+    math_t l2_alpha = (1 - l1_ratio) * alphas[k] * n_rows;
+    math_t l1_alpha = l1_ratio * alphas[k] * n_rows;
+    LinAlg::addScalar(squared.data(), norms.data(), l2_alpha, n_cols, stream);
+
+    math_t strong_threshold = 2 * l1_alpha - l1_prev;
+    for (int j = 0; j < n_cols; j++) {
+      active[j] =
+        !l1 || h_coef[j] != math_t(0) || abs(h_q[j]) >= strong_threshold;
+    }
+
+    bool violated = true;
+    while (violated) {
+      ri.clear();
+      for (int j = 0; j < n_cols; j++) {
+        if (active[j]) ri.push_back(j);
+      }
+      cdGramSweeps(handle, coef, q.data(), gram.data(), squared.data(),
+                   n_cols, epochs, l1_alpha, l1, shuffle, tol, ri, g, stream);
+
+      updateHost(h_q.data(), q.data(), n_cols, stream);
+      updateHost(h_coef.data(), coef, n_cols, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+
+      // a screened out coefficient stays 0 if |q_j| <= l1_alpha
+      violated = false;
+      for (int j = 0; j < n_cols; j++) {
+        if (!active[j] && abs(h_q[j]) > l1_alpha) {
+          active[j] = true;
+          violated = true;
+        }
+      }
+    }
+    l1_prev = l1_alpha;
+  }
+
+  if (fit_intercept) {
+    GLM::postProcessDataPath(handle, input, n_rows, n_cols, labels, coefs,
+                             n_alphas, intercepts, mu_input.data(),
+                             mu_labels.data(), norm2_input.data(), normalize,
+                             stream);
+  } else {
+    std::fill(intercepts, intercepts + n_alphas, math_t(0));
+  }
+}
+
 /**
  * Fits a linear, lasso, and elastic-net regression model using Coordinate Descent solver
  * @param input
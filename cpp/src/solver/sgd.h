@@ -21,6 +21,7 @@
 #include <functions/linearReg.h>
 #include <functions/logisticReg.h>
 #include <linalg/add.h>
+#include <linalg/binary_op.h>
 #include <linalg/cublas_wrappers.h>
 #include <linalg/eltwise.h>
 #include <linalg/gemv.h>
@@ -32,6 +33,7 @@
 #include <stats/mean.h>
 #include <stats/mean_center.h>
 #include "common/cumlHandle.hpp"
+#include "common/host_buffer.hpp"
 #include "glm/preprocess.h"
 #include "learning_rate.h"
 #include "ml_utils.h"
@@ -42,6 +44,59 @@ namespace Solver {
 
 using namespace MLCommon;
 
+/**
+ * The gradients of the loss, with its penalty, at coef over the n_rows rows
+ * of the column-major input
+ */
+template <typename math_t>
+void sgdLossGrads(math_t *input, int n_rows, int n_cols, math_t *labels,
+                  math_t *coef, math_t *grads, ML::loss_funct loss,
+                  Functions::penalty penalty, math_t alpha, math_t l1_ratio,
+                  cublasHandle_t cublas_handle,
+                  std::shared_ptr<deviceAllocator> allocator,
+                  cudaStream_t stream) {
+  if (loss == ML::loss_funct::SQRD_LOSS) {
+    Functions::linearRegLossGrads(input, n_rows, n_cols, labels, coef, grads,
+                                  penalty, alpha, l1_ratio, cublas_handle,
+                                  allocator, stream);
+  } else if (loss == ML::loss_funct::LOG) {
+    Functions::logisticRegLossGrads(input, n_rows, n_cols, labels, coef, grads,
+                                    penalty, alpha, l1_ratio, cublas_handle,
+                                    allocator, stream);
+  } else if (loss == ML::loss_funct::HINGE) {
+    Functions::hingeLossGrads(input, n_rows, n_cols, labels, coef, grads,
+                              penalty, alpha, l1_ratio, cublas_handle,
+                              allocator, stream);
+  } else {
+    ASSERT(false, "sgd.h: Other loss functions have not been implemented yet!");
+  }
+}
+
+/**
+ * The loss, with its penalty, at coef over the n_rows rows of the
+ * column-major input
+ */
+template <typename math_t>
+void sgdLoss(math_t *input, int n_rows, int n_cols, math_t *labels,
+             math_t *coef, math_t *loss_value, ML::loss_funct loss,
+             Functions::penalty penalty, math_t alpha, math_t l1_ratio,
+             cublasHandle_t cublas_handle,
+             std::shared_ptr<deviceAllocator> allocator, cudaStream_t stream) {
+  if (loss == ML::loss_funct::SQRD_LOSS) {
+    Functions::linearRegLoss(input, n_rows, n_cols, labels, coef, loss_value,
+                             penalty, alpha, l1_ratio, cublas_handle, allocator,
+                             stream);
+  } else if (loss == ML::loss_funct::LOG) {
+    Functions::logisticRegLoss(input, n_rows, n_cols, labels, coef, loss_value,
+                               penalty, alpha, l1_ratio, cublas_handle,
+                               allocator, stream);
+  } else if (loss == ML::loss_funct::HINGE) {
+    Functions::hingeLoss(input, n_rows, n_cols, labels, coef, loss_value,
+                         penalty, alpha, l1_ratio, cublas_handle, allocator,
+                         stream);
+  }
+}
+
 /**
  * Fits a linear, lasso, and elastic-net regression model using Coordinate Descent solver
  * @param cumlHandle_impl
@@ -164,25 +219,9 @@ void sgdFit(const cumlHandle_impl &handle, math_t *input, int n_rows,
       Matrix::copyRows(labels, n_rows, 1, labels_batch.data(), indices.data(),
                        cbs, stream);
 
-      if (loss == ML::loss_funct::SQRD_LOSS) {
-        Functions::linearRegLossGrads(input_batch.data(), cbs, n_cols,
-                                      labels_batch.data(), coef, grads.data(),
-                                      penalty, alpha, l1_ratio, cublas_handle,
-                                      allocator, stream);
-      } else if (loss == ML::loss_funct::LOG) {
-        Functions::logisticRegLossGrads(input_batch.data(), cbs, n_cols,
-                                        labels_batch.data(), coef, grads.data(),
-                                        penalty, alpha, l1_ratio, cublas_handle,
-                                        allocator, stream);
-      } else if (loss == ML::loss_funct::HINGE) {
-        Functions::hingeLossGrads(input_batch.data(), cbs, n_cols,
-                                  labels_batch.data(), coef, grads.data(),
-                                  penalty, alpha, l1_ratio, cublas_handle,
-                                  allocator, stream);
-      } else {
-        ASSERT(false,
-               "sgd.h: Other loss functions have not been implemented yet!");
-      }
+      sgdLossGrads(input_batch.data(), cbs, n_cols, labels_batch.data(), coef,
+                   grads.data(), loss, penalty, alpha, l1_ratio, cublas_handle,
+                   allocator, stream);
 
       if (lr_type != ML::lr_type::ADAPTIVE)
         learning_rate = calLearningRate(lr_type, eta0, power_t, alpha, t);
@@ -196,19 +235,8 @@ void sgdFit(const cumlHandle_impl &handle, math_t *input, int n_rows,
     }
 
     if (tol > math_t(0)) {
-      if (loss == ML::loss_funct::SQRD_LOSS) {
-        Functions::linearRegLoss(input, n_rows, n_cols, labels, coef,
-                                 loss_value.data(), penalty, alpha, l1_ratio,
-                                 cublas_handle, allocator, stream);
-      } else if (loss == ML::loss_funct::LOG) {
-        Functions::logisticRegLoss(input, n_rows, n_cols, labels, coef,
-                                   loss_value.data(), penalty, alpha, l1_ratio,
-                                   cublas_handle, allocator, stream);
-      } else if (loss == ML::loss_funct::HINGE) {
-        Functions::hingeLoss(input, n_rows, n_cols, labels, coef,
-                             loss_value.data(), penalty, alpha, l1_ratio,
-                             cublas_handle, allocator, stream);
-      }
+      sgdLoss(input, n_rows, n_cols, labels, coef, loss_value.data(), loss,
+              penalty, alpha, l1_ratio, cublas_handle, allocator, stream);
 
       updateHost(&curr_loss_value, loss_value.data(), 1, stream);
       CUDA_CHECK(cudaStreamSynchronize(stream));
@@ -243,6 +271,225 @@ void sgdFit(const cumlHandle_impl &handle, math_t *input, int n_rows,
   }
 }
 
+/**
+ * Gathers the rows idx[0..n) of the column-major host input and its labels
+ * into the column-major batch, followed by the n labels
+ */
+template <typename math_t>
+void gatherHostBatch(const math_t *input, const math_t *labels, int n_rows,
+                     int n_cols, const int *idx, int n, math_t *batch) {
+  for (int c = 0; c < n_cols; c++) {
+    const math_t *col = input + size_t(c) * n_rows;
+    math_t *out = batch + size_t(c) * n;
+    for (int k = 0; k < n; k++) out[k] = col[idx[k]];
+  }
+  math_t *out = batch + size_t(n_cols) * n;
+  for (int k = 0; k < n; k++) out[k] = labels[idx[k]];
+}
+
+/**
+ * Fits a linear model by SGD, as sgdFit, with the input and the labels in
+ * host memory: only two mini-batches are held on the device at a time.
+ *
+ * The mini-batches are gathered into pinned staging buffers and copied on a
+ * second stream, so that the gathering and the copy of a batch overlap with
+ * the gradient step of the previous one. The stopping criterion of tol uses
+ * the mean of the losses of the mini-batches of the epoch, as they are seen,
+ * rather than the loss over all the rows at the end of the epoch.
+ *
+ * @param input
+ *        pointer to a host array in column-major format (size of n_rows,
+ *        n_cols). Pinned memory is not required.
+ * @param labels
+ *        pointer to a host array for labels (size of n_rows)
+ * @param coef
+ *        pointer to a device array for coefficients (size of n_cols)
+ *
+ * The other parameters are as in sgdFit.
+ */
+template <typename math_t>
+void sgdFitHost(const cumlHandle_impl &handle, const math_t *input, int n_rows,
+                int n_cols, const math_t *labels, math_t *coef,
+                math_t *intercept, bool fit_intercept, int batch_size,
+                int epochs, ML::lr_type lr_type, math_t eta0, math_t power_t,
+                ML::loss_funct loss, Functions::penalty penalty, math_t alpha,
+                math_t l1_ratio, bool shuffle, math_t tol,
+                int n_iter_no_change, cudaStream_t stream) {
+  ASSERT(n_cols > 0,
+         "Parameter n_cols: number of columns cannot be less than one");
+  ASSERT(n_rows > 1,
+         "Parameter n_rows: number of rows cannot be less than two");
+  batch_size = std::min(batch_size, n_rows);
+
+  cublasHandle_t cublas_handle = handle.getCublasHandle();
+  auto allocator = handle.getDeviceAllocator();
+
+  // The means of the columns and of the labels center each mini-batch
+  device_buffer<math_t> mu_input(allocator, stream, 0);
+  device_buffer<math_t> mu_labels(allocator, stream, 0);
+  std::vector<math_t> h_mu(n_cols + 1);
+  if (fit_intercept) {
+    for (int c = 0; c <= n_cols; c++) {
+      const math_t *col = c < n_cols ? input + size_t(c) * n_rows : labels;
+      double sum = 0;
+      for (int i = 0; i < n_rows; i++) sum += col[i];
+      h_mu[c] = math_t(sum / n_rows);
+    }
+    mu_input.resize(n_cols, stream);
+    mu_labels.resize(1, stream);
+    updateDevice(mu_input.data(), h_mu.data(), n_cols, stream);
+    updateDevice(mu_labels.data(), h_mu.data() + n_cols, 1, stream);
+  }
+
+  // Double buffered stages: a batch of rows, followed by its labels
+  const size_t stage_len = size_t(batch_size) * (n_cols + 1);
+  auto host_allocator = handle.getHostAllocator();
+  host_buffer<math_t> h_stage0(host_allocator, stream, stage_len);
+  host_buffer<math_t> h_stage1(host_allocator, stream, stage_len);
+  device_buffer<math_t> d_stage0(allocator, stream, stage_len);
+  device_buffer<math_t> d_stage1(allocator, stream, stage_len);
+  math_t *h_stage[2] = {h_stage0.data(), h_stage1.data()};
+  math_t *d_stage[2] = {d_stage0.data(), d_stage1.data()};
+  cudaEvent_t stage_copied[2], stage_free[2];
+  for (int s = 0; s < 2; s++) {
+    CUDA_CHECK(
+      cudaEventCreateWithFlags(&stage_copied[s], cudaEventDisableTiming));
+    CUDA_CHECK(
+      cudaEventCreateWithFlags(&stage_free[s], cudaEventDisableTiming));
+  }
+  cudaStream_t copy_stream;
+  CUDA_CHECK(cudaStreamCreateWithFlags(&copy_stream, cudaStreamNonBlocking));
+  // the stages are allocated on stream, and written on copy_stream
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  device_buffer<math_t> grads(allocator, stream, n_cols);
+  device_buffer<math_t> loss_value(allocator, stream, 1);
+  device_buffer<math_t> epoch_loss(allocator, stream, 1);
+
+  math_t prev_loss_value = math_t(0);
+  math_t curr_loss_value = math_t(0);
+
+  std::vector<int> rand_indices(n_rows);
+  std::mt19937 g(rand());
+  initShuffle(rand_indices, g);
+
+  math_t t = math_t(1);
+  math_t learning_rate = math_t(0);
+  if (lr_type == ML::lr_type::ADAPTIVE) {
+    learning_rate = eta0;
+  } else if (lr_type == ML::lr_type::OPTIMAL) {
+    eta0 = calOptimalInit(alpha);
+  }
+
+  int n_iter_no_change_curr = 0;
+  int batch = 0;
+
+  for (int i = 0; i < epochs; i++) {
+    if (i > 0 && shuffle) {
+      Solver::shuffle(rand_indices, g);
+    }
+    if (tol > math_t(0)) {
+      CUDA_CHECK(
+        cudaMemsetAsync(epoch_loss.data(), 0, sizeof(math_t), stream));
+    }
+
+    for (int j = 0; j < n_rows; j += batch_size, batch++) {
+      const int cbs = std::min(batch_size, n_rows - j);
+      const int s = batch % 2;
+
+      // the copy of this stage two batches ago has been read from the host,
+      // and its compute has released the device stage
+      CUDA_CHECK(cudaEventSynchronize(stage_copied[s]));
+      gatherHostBatch(input, labels, n_rows, n_cols, &rand_indices[j], cbs,
+                      h_stage[s]);
+      CUDA_CHECK(cudaStreamWaitEvent(copy_stream, stage_free[s], 0));
+      CUDA_CHECK(cudaMemcpyAsync(d_stage[s], h_stage[s],
+                                 size_t(cbs) * (n_cols + 1) * sizeof(math_t),
+                                 cudaMemcpyHostToDevice, copy_stream));
+      CUDA_CHECK(cudaEventRecord(stage_copied[s], copy_stream));
+      CUDA_CHECK(cudaStreamWaitEvent(stream, stage_copied[s], 0));
+
+      math_t *input_batch = d_stage[s];
+      math_t *labels_batch = d_stage[s] + size_t(cbs) * n_cols;
+      if (fit_intercept) {
+        Stats::meanCenter(input_batch, input_batch, mu_input.data(), n_cols,
+                          cbs, false, true, stream);
+        Stats::meanCenter(labels_batch, labels_batch, mu_labels.data(), 1, cbs,
+                          false, true, stream);
+      }
+
+      if (tol > math_t(0)) {
+        sgdLoss(input_batch, cbs, n_cols, labels_batch, coef,
+                loss_value.data(), loss, penalty, alpha, l1_ratio,
+                cublas_handle, allocator, stream);
+        const math_t w = math_t(cbs) / n_rows;
+        LinAlg::binaryOp(
+          epoch_loss.data(), epoch_loss.data(), loss_value.data(), 1,
+          [w] __device__(math_t acc, math_t l) { return acc + w * l; },
+          stream);
+      }
+
+      sgdLossGrads(input_batch, cbs, n_cols, labels_batch, coef, grads.data(),
+                   loss, penalty, alpha, l1_ratio, cublas_handle, allocator,
+                   stream);
+      CUDA_CHECK(cudaEventRecord(stage_free[s], stream));
+
+      if (lr_type != ML::lr_type::ADAPTIVE)
+        learning_rate = calLearningRate(lr_type, eta0, power_t, alpha, t);
+
+      LinAlg::scalarMultiply(grads.data(), grads.data(), learning_rate, n_cols,
+                             stream);
+      LinAlg::subtract(coef, coef, grads.data(), n_cols, stream);
+
+      t = t + 1;
+    }
+
+    if (tol > math_t(0)) {
+      updateHost(&curr_loss_value, epoch_loss.data(), 1, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+
+      if (i > 0) {
+        if (curr_loss_value > (prev_loss_value - tol)) {
+          n_iter_no_change_curr = n_iter_no_change_curr + 1;
+          if (n_iter_no_change_curr > n_iter_no_change) {
+            if (lr_type == ML::lr_type::ADAPTIVE &&
+                learning_rate > math_t(1e-6)) {
+              learning_rate = learning_rate / math_t(5);
+              n_iter_no_change_curr = 0;
+            } else {
+              break;
+            }
+          }
+        } else {
+          n_iter_no_change_curr = 0;
+        }
+      }
+
+      prev_loss_value = curr_loss_value;
+    }
+  }
+
+  if (fit_intercept) {
+    // intercept = mu_labels - mu_input . coef
+    device_buffer<math_t> d_intercept(allocator, stream, 1);
+    LinAlg::gemm(mu_input.data(), 1, n_cols, coef, d_intercept.data(), 1, 1,
+                 CUBLAS_OP_N, CUBLAS_OP_N, cublas_handle, stream);
+    LinAlg::subtract(d_intercept.data(), mu_labels.data(), d_intercept.data(),
+                     1, stream);
+    updateHost(intercept, d_intercept.data(), 1, stream);
+  } else {
+    *intercept = math_t(0);
+  }
+
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  CUDA_CHECK(cudaStreamSynchronize(copy_stream));
+  for (int s = 0; s < 2; s++) {
+    CUDA_CHECK(cudaEventDestroy(stage_copied[s]));
+    CUDA_CHECK(cudaEventDestroy(stage_free[s]));
+  }
+  CUDA_CHECK(cudaStreamDestroy(copy_stream));
+}
+
 /**
  * Make predictions
  * @param cumlHandle_impl
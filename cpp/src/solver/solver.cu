@@ -24,6 +24,46 @@ namespace Solver {
 
 using namespace ML;
 
+/** The SGD options of the C++ API, as their enums */
+static void sgdOptions(int loss, int penalty, int lr_type,
+                       ML::loss_funct &loss_funct,
+                       MLCommon::Functions::penalty &pen,
+                       ML::lr_type &learning_rate_type) {
+  if (loss == 0) {
+    loss_funct = ML::loss_funct::SQRD_LOSS;
+  } else if (loss == 1) {
+    loss_funct = ML::loss_funct::LOG;
+  } else if (loss == 2) {
+    loss_funct = ML::loss_funct::HINGE;
+  } else {
+    ASSERT(false, "glm.cu: other functions are not supported yet.");
+  }
+
+  if (penalty == 0) {
+    pen = MLCommon::Functions::penalty::NONE;
+  } else if (penalty == 1) {
+    pen = MLCommon::Functions::penalty::L1;
+  } else if (penalty == 2) {
+    pen = MLCommon::Functions::penalty::L2;
+  } else if (penalty == 3) {
+    pen = MLCommon::Functions::penalty::ELASTICNET;
+  } else {
+    ASSERT(false, "glm.cu: penalty is not supported yet.");
+  }
+
+  if (lr_type == 0) {
+    learning_rate_type = ML::lr_type::OPTIMAL;
+  } else if (lr_type == 1) {
+    learning_rate_type = ML::lr_type::CONSTANT;
+  } else if (lr_type == 2) {
+    learning_rate_type = ML::lr_type::INVSCALING;
+  } else if (lr_type == 3) {
+    learning_rate_type = ML::lr_type::ADAPTIVE;
+  } else {
+    ASSERT(false, "glm.cu: this learning rate type is not supported.");
+  }
+}
+
 void sgdFit(cumlHandle &handle, float *input, int n_rows, int n_cols,
             float *labels, float *coef, float *intercept, bool fit_intercept,
             int batch_size, int epochs, int lr_type, float eta0, float power_t,
@@ -121,6 +161,40 @@ void sgdFit(cumlHandle &handle, double *input, int n_rows, int n_cols,
          handle.getStream());
 }
 
+void sgdFitHost(cumlHandle &handle, const float *input, int n_rows,
+                int n_cols, const float *labels, float *coef, float *intercept,
+                bool fit_intercept, int batch_size, int epochs, int lr_type,
+                float eta0, float power_t, int loss, int penalty, float alpha,
+                float l1_ratio, bool shuffle, float tol,
+                int n_iter_no_change) {
+  ML::loss_funct loss_funct;
+  MLCommon::Functions::penalty pen;
+  ML::lr_type learning_rate_type;
+  sgdOptions(loss, penalty, lr_type, loss_funct, pen, learning_rate_type);
+
+  sgdFitHost(handle.getImpl(), input, n_rows, n_cols, labels, coef, intercept,
+             fit_intercept, batch_size, epochs, learning_rate_type, eta0,
+             power_t, loss_funct, pen, alpha, l1_ratio, shuffle, tol,
+             n_iter_no_change, handle.getStream());
+}
+
+void sgdFitHost(cumlHandle &handle, const double *input, int n_rows,
+                int n_cols, const double *labels, double *coef,
+                double *intercept, bool fit_intercept, int batch_size,
+                int epochs, int lr_type, double eta0, double power_t, int loss,
+                int penalty, double alpha, double l1_ratio, bool shuffle,
+                double tol, int n_iter_no_change) {
+  ML::loss_funct loss_funct;
+  MLCommon::Functions::penalty pen;
+  ML::lr_type learning_rate_type;
+  sgdOptions(loss, penalty, lr_type, loss_funct, pen, learning_rate_type);
+
+  sgdFitHost(handle.getImpl(), input, n_rows, n_cols, labels, coef, intercept,
+             fit_intercept, batch_size, epochs, learning_rate_type, eta0,
+             power_t, loss_funct, pen, alpha, l1_ratio, shuffle, tol,
+             n_iter_no_change, handle.getStream());
+}
+
 void sgdPredict(cumlHandle &handle, const float *input, int n_rows, int n_cols,
                 const float *coef, float intercept, float *preds, int loss) {
   ML::loss_funct loss_funct = ML::loss_funct::SQRD_LOSS;
@@ -134,8 +208,14 @@ void sgdPredict(cumlHandle &handle, const float *input, int n_rows, int n_cols,
     ASSERT(false, "glm.cu: other functions are not supported yet.");
   }
 
-  sgdPredict(handle.getImpl(), input, n_rows, n_cols, coef, intercept, preds,
-             loss_funct, handle.getStream());
+  const cumlHandle_impl &impl = handle.getImpl();
+  cudaStream_t stream = handle.getStream();
+  impl.runGraphed(graphKey("ML::Solver::sgdPredict", input, n_rows, n_cols,
+                           coef, intercept, preds, loss_funct),
+                  [&]() {
+                    sgdPredict(impl, input, n_rows, n_cols, coef, intercept,
+                               preds, loss_funct, stream);
+                  });
 }
 
 void sgdPredict(cumlHandle &handle, const double *input, int n_rows, int n_cols,
@@ -151,8 +231,14 @@ void sgdPredict(cumlHandle &handle, const double *input, int n_rows, int n_cols,
     ASSERT(false, "glm.cu: other functions are not supported yet.");
   }
 
-  sgdPredict(handle.getImpl(), input, n_rows, n_cols, coef, intercept, preds,
-             loss_funct, handle.getStream());
+  const cumlHandle_impl &impl = handle.getImpl();
+  cudaStream_t stream = handle.getStream();
+  impl.runGraphed(graphKey("ML::Solver::sgdPredict", input, n_rows, n_cols,
+                           coef, intercept, preds, loss_funct),
+                  [&]() {
+                    sgdPredict(impl, input, n_rows, n_cols, coef, intercept,
+                               preds, loss_funct, stream);
+                  });
 }
 
 void sgdPredictBinaryClass(cumlHandle &handle, const float *input, int n_rows,
@@ -169,8 +255,14 @@ void sgdPredictBinaryClass(cumlHandle &handle, const float *input, int n_rows,
     ASSERT(false, "glm.cu: other functions are not supported yet.");
   }
 
-  sgdPredictBinaryClass(handle.getImpl(), input, n_rows, n_cols, coef,
-                        intercept, preds, loss_funct, handle.getStream());
+  const cumlHandle_impl &impl = handle.getImpl();
+  cudaStream_t stream = handle.getStream();
+  impl.runGraphed(graphKey("ML::Solver::sgdPredictBinaryClass", input, n_rows,
+                           n_cols, coef, intercept, preds, loss_funct),
+                  [&]() {
+                    sgdPredictBinaryClass(impl, input, n_rows, n_cols, coef,
+                                          intercept, preds, loss_funct, stream);
+                  });
 }
 
 void sgdPredictBinaryClass(cumlHandle &handle, const double *input, int n_rows,
@@ -187,14 +279,20 @@ void sgdPredictBinaryClass(cumlHandle &handle, const double *input, int n_rows,
     ASSERT(false, "glm.cu: other functions are not supported yet.");
   }
 
-  sgdPredictBinaryClass(handle.getImpl(), input, n_rows, n_cols, coef,
-                        intercept, preds, loss_funct, handle.getStream());
+  const cumlHandle_impl &impl = handle.getImpl();
+  cudaStream_t stream = handle.getStream();
+  impl.runGraphed(graphKey("ML::Solver::sgdPredictBinaryClass", input, n_rows,
+                           n_cols, coef, intercept, preds, loss_funct),
+                  [&]() {
+                    sgdPredictBinaryClass(impl, input, n_rows, n_cols, coef,
+                                          intercept, preds, loss_funct, stream);
+                  });
 }
 
 void cdFit(cumlHandle &handle, float *input, int n_rows, int n_cols,
            float *labels, float *coef, float *intercept, bool fit_intercept,
            bool normalize, int epochs, int loss, float alpha, float l1_ratio,
-           bool shuffle, float tol) {
+           bool shuffle, float tol, bool precompute_gram) {
   ASSERT(loss == 0,
          "Parameter loss: Only SQRT_LOSS function is supported for now");
 
@@ -202,13 +300,13 @@ void cdFit(cumlHandle &handle, float *input, int n_rows, int n_cols,
 
   cdFit(handle.getImpl(), input, n_rows, n_cols, labels, coef, intercept,
         fit_intercept, normalize, epochs, loss_funct, alpha, l1_ratio, shuffle,
-        tol, handle.getStream());
+        tol, handle.getStream(), precompute_gram);
 }
 
 void cdFit(cumlHandle &handle, double *input, int n_rows, int n_cols,
            double *labels, double *coef, double *intercept, bool fit_intercept,
            bool normalize, int epochs, int loss, double alpha, double l1_ratio,
-           bool shuffle, double tol) {
+           bool shuffle, double tol, bool precompute_gram) {
   ASSERT(loss == 0,
          "Parameter loss: Only SQRT_LOSS function is supported for now");
 
@@ -216,7 +314,36 @@ void cdFit(cumlHandle &handle, double *input, int n_rows, int n_cols,
 
   cdFit(handle.getImpl(), input, n_rows, n_cols, labels, coef, intercept,
         fit_intercept, normalize, epochs, loss_funct, alpha, l1_ratio, shuffle,
-        tol, handle.getStream());
+        tol, handle.getStream(), precompute_gram);
+}
+
+void cdFitPath(cumlHandle &handle, float *input, int n_rows, int n_cols,
+               float *labels, const float *alphas, int n_alphas, float *coefs,
+               float *intercepts, bool fit_intercept, bool normalize,
+               int epochs, int loss, float l1_ratio, bool shuffle, float tol) {
+  ASSERT(loss == 0,
+         "Parameter loss: Only SQRT_LOSS function is supported for now");
+
+  ML::loss_funct loss_funct = ML::loss_funct::SQRD_LOSS;
+
+  cdFitPath(handle.getImpl(), input, n_rows, n_cols, labels, alphas, n_alphas,
+            coefs, intercepts, fit_intercept, normalize, epochs, loss_funct,
+            l1_ratio, shuffle, tol, handle.getStream());
+}
+
+void cdFitPath(cumlHandle &handle, double *input, int n_rows, int n_cols,
+               double *labels, const double *alphas, int n_alphas,
+               double *coefs, double *intercepts, bool fit_intercept,
+               bool normalize, int epochs, int loss, double l1_ratio,
+               bool shuffle, double tol) {
+  ASSERT(loss == 0,
+         "Parameter loss: Only SQRT_LOSS function is supported for now");
+
+  ML::loss_funct loss_funct = ML::loss_funct::SQRD_LOSS;
+
+  cdFitPath(handle.getImpl(), input, n_rows, n_cols, labels, alphas, n_alphas,
+            coefs, intercepts, fit_intercept, normalize, epochs, loss_funct,
+            l1_ratio, shuffle, tol, handle.getStream());
 }
 
 void cdPredict(cumlHandle &handle, const float *input, int n_rows, int n_cols,
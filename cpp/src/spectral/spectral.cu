@@ -14,9 +14,15 @@
  * limitations under the License.
  */
 
+#include <cuml/cluster/kmeans.hpp>
 #include <cuml/cuml.hpp>
+#include "common/cumlHandle.hpp"
+#include "common/device_buffer.hpp"
+#include "linalg/matrix_vector_op.h"
+#include "linalg/norm.h"
+#include "linalg/transpose.h"
+#include "selection/knn.h"
 #include "sparse/coo.h"
-#include "sparse/nvgraph_wrappers.h"
 
 #include "sparse/spectral.h"
 
@@ -39,9 +45,40 @@ namespace Spectral {
 
 void fit_clusters(const cumlHandle &handle, int *rows, int *cols, float *vals,
                   int nnz, int n, int n_clusters, float eigen_tol, int *out) {
-  MLCommon::Spectral::fit_clusters(rows, cols, vals, nnz, n, n_clusters,
-                                   eigen_tol, out, handle.getDeviceAllocator(),
-                                   handle.getStream());
+  const cumlHandle_impl &h = handle.getImpl();
+  cudaStream_t stream = h.getStream();
+  auto d_alloc = h.getDeviceAllocator();
+
+  MLCommon::device_buffer<float> eig_vectors(d_alloc, stream, n * n_clusters);
+  MLCommon::Spectral::laplacian_eigenvectors(
+    rows, cols, vals, nnz, n, n_clusters, eig_vectors.data(), eigen_tol,
+    h.getCublasHandle(), h.getcusolverDnHandle(), h.getcusparseHandle(),
+    d_alloc, stream);
+
+  // the rows of the eigenvectors, normalized (Ng, Jordan and Weiss 2002),
+  // are the points clustered
+  MLCommon::device_buffer<float> points(d_alloc, stream, n * n_clusters);
+  MLCommon::LinAlg::transpose(eig_vectors.data(), points.data(), n, n_clusters,
+                              h.getCublasHandle(), stream);
+  MLCommon::device_buffer<float> norms(d_alloc, stream, n);
+  MLCommon::LinAlg::rowNorm(norms.data(), points.data(), n_clusters, n,
+                            MLCommon::LinAlg::L2Norm, true, stream,
+                            [] __device__(float v) { return sqrtf(v); });
+  MLCommon::LinAlg::matrixVectorOp(
+    points.data(), points.data(), norms.data(), n_clusters, n, true, false,
+    [] __device__(float v, float norm) {
+      return norm > 0.0f ? v / norm : v;
+    },
+    stream);
+
+  kmeans::KMeansParams params;
+  params.n_clusters = n_clusters;
+  MLCommon::device_buffer<float> centroids(d_alloc, stream,
+                                           n_clusters * n_clusters);
+  float inertia;
+  int n_iter;
+  kmeans::fit_predict(handle, params, points.data(), n, n_clusters,
+                      centroids.data(), out, inertia, n_iter);
 }
 
 /***
@@ -58,9 +95,17 @@ void fit_clusters(const cumlHandle &handle, int *rows, int *cols, float *vals,
 void fit_clusters(const cumlHandle &handle, long *knn_indices, float *knn_dists,
                   int m, int n_neighbors, int n_clusters, float eigen_tol,
                   int *out) {
-  MLCommon::Spectral::fit_clusters(
-    knn_indices, knn_dists, m, n_neighbors, n_clusters, eigen_tol, out,
-    handle.getDeviceAllocator(), handle.getStream());
+  cudaStream_t stream = handle.getStream();
+  auto d_alloc = handle.getDeviceAllocator();
+  MLCommon::device_buffer<int> rows(d_alloc, stream, m * n_neighbors);
+  MLCommon::device_buffer<int> cols(d_alloc, stream, m * n_neighbors);
+  MLCommon::device_buffer<float> vals(d_alloc, stream, m * n_neighbors);
+
+  MLCommon::Sparse::from_knn(knn_indices, knn_dists, m, n_neighbors,
+                             rows.data(), cols.data(), vals.data(), stream);
+
+  fit_clusters(handle, rows.data(), cols.data(), vals.data(), m * n_neighbors,
+               m, n_clusters, eigen_tol, out);
 }
 
 /***
@@ -76,9 +121,22 @@ void fit_clusters(const cumlHandle &handle, long *knn_indices, float *knn_dists,
    */
 void fit_clusters(const cumlHandle &handle, float *X, int m, int n,
                   int n_neighbors, int n_clusters, float eigen_tol, int *out) {
-  MLCommon::Spectral::fit_clusters(X, m, n, n_neighbors, n_clusters, eigen_tol,
-                                   out, handle.getDeviceAllocator(),
-                                   handle.getStream());
+  cudaStream_t stream = handle.getStream();
+  auto d_alloc = handle.getDeviceAllocator();
+  MLCommon::device_buffer<long> knn_indices(d_alloc, stream, m * n_neighbors);
+  MLCommon::device_buffer<float> knn_dists(d_alloc, stream, m * n_neighbors);
+
+  std::vector<float *> ptrs(1);
+  std::vector<int> sizes(1);
+  ptrs[0] = X;
+  sizes[0] = m;
+
+  MLCommon::Selection::brute_force_knn(ptrs, sizes, n, X, m, knn_indices.data(),
+                                       knn_dists.data(), n_neighbors, d_alloc,
+                                       stream);
+
+  fit_clusters(handle, knn_indices.data(), knn_dists.data(), m, n_neighbors,
+               n_clusters, eigen_tol, out);
 }
 
 /**
@@ -96,9 +154,11 @@ void fit_clusters(const cumlHandle &handle, float *X, int m, int n,
    */
 void fit_embedding(const cumlHandle &handle, int *rows, int *cols, float *vals,
                    int nnz, int n, int n_components, float *out) {
-  MLCommon::Spectral::fit_embedding(rows, cols, vals, nnz, n, n_components, out,
-                                    handle.getDeviceAllocator(),
-                                    handle.getStream());
+  const cumlHandle_impl &h = handle.getImpl();
+  MLCommon::Spectral::fit_embedding(
+    rows, cols, vals, nnz, n, n_components, out, h.getCublasHandle(),
+    h.getcusolverDnHandle(), h.getcusparseHandle(), h.getDeviceAllocator(),
+    h.getStream());
 }
 
 /***
@@ -115,9 +175,11 @@ void fit_embedding(const cumlHandle &handle, int *rows, int *cols, float *vals,
 void fit_embedding(const cumlHandle &handle, long *knn_indices,
                    float *knn_dists, int m, int n_neighbors, int n_components,
                    float *out) {
+  const cumlHandle_impl &h = handle.getImpl();
   MLCommon::Spectral::fit_embedding(
     knn_indices, knn_dists, m, n_neighbors, n_components, out,
-    handle.getDeviceAllocator(), handle.getStream());
+    h.getCublasHandle(), h.getcusolverDnHandle(), h.getcusparseHandle(),
+    h.getDeviceAllocator(), h.getStream());
 }
 
 /***
@@ -133,9 +195,11 @@ void fit_embedding(const cumlHandle &handle, long *knn_indices,
    */
 void fit_embedding(const cumlHandle &handle, float *X, int m, int n,
                    int n_neighbors, int n_components, float *out) {
-  MLCommon::Spectral::fit_embedding(X, m, n, n_neighbors, n_components, out,
-                                    handle.getDeviceAllocator(),
-                                    handle.getStream());
+  const cumlHandle_impl &h = handle.getImpl();
+  MLCommon::Spectral::fit_embedding(
+    X, m, n, n_neighbors, n_components, out, h.getCublasHandle(),
+    h.getcusolverDnHandle(), h.getcusparseHandle(), h.getDeviceAllocator(),
+    h.getStream());
 }
 
 }  // namespace Spectral
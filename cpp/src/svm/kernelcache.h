@@ -18,12 +18,17 @@
 
 #include <cuda_utils.h>
 #include <linalg/gemm.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <algorithm>
 #include "cache/cache.h"
 #include "common/cumlHandle.hpp"
 #include "common/host_buffer.hpp"
+#include "linalg/unary_op.h"
 #include "matrix/grammatrix.h"
 #include "matrix/matrix.h"
 #include "ml_utils.h"
+#include "sparse_input.h"
 
 namespace ML {
 namespace SVM {
@@ -40,6 +45,11 @@ namespace SVM {
 *
 * The kernel values can be cached to avoid repeated calculation of the kernel
 * function.
+*
+* A KernelCache can also serve a subset of the training vectors of another,
+* shared, KernelCache: the kernel rows are then looked up in (and stored into)
+* the shared cache by their index in the full training set, so that the
+* sub-problems of a multi-class SVM compute overlapping kernel rows only once.
 */
 template <typename math_t>
 class KernelCache {
@@ -50,6 +60,8 @@ class KernelCache {
     x_ws;  //!< feature vectors in the current working set
   MLCommon::device_buffer<int>
     ws_cache_idx;  //!< cache position of a workspace vectors
+  //! training vector indices of the working set
+  MLCommon::device_buffer<int> ws_x_idx;
   MLCommon::device_buffer<math_t> tile;  //!< Kernel matrix  tile
 
   int n_rows;  //!< number of rows in x
@@ -60,12 +72,25 @@ class KernelCache {
 
   MLCommon::Matrix::GramMatrixBase<math_t> *kernel;
 
-  const cumlHandle_impl handle;
+  const cumlHandle_impl &handle;
 
   const int TPB = 256;  //!< threads per block for kernels launched
 
   MLCommon::Cache::Cache<math_t> cache;
 
+  long long n_hits = 0;    //!< kernel rows served from the cache
+  long long n_misses = 0;  //!< kernel rows that had to be computed
+
+  //! kernel cache over the full training set, if this one serves a subset
+  KernelCache<math_t> *shared;
+  //! index of each of our training vectors in the shared cache, size [n_rows]
+  const int *row_idx;
+  //! inverse of row_idx, size [n_rows of the shared cache]
+  MLCommon::device_buffer<int> local_idx;
+
+  //! the training vectors in CSR format, if they are sparse
+  const MLCommon::Matrix::CsrMatrix<math_t> *csr;
+
   cudaStream_t stream;
 
  public:
@@ -79,14 +104,24 @@ class KernelCache {
    * @param n_cols number of features
    * @param n_ws size of working set
    * @param kernel pointer to kernel (default linear)
-   * @param cache_size (default 200 MiB)
+   * @param cache_size (default 200 MiB), unused if shared is given. A
+   *   negative value sizes the cache from the free device memory, see
+   *   AdaptiveCacheSize
+   * @param shared kernel cache over a superset of the training vectors, whose
+   *   working set size is at least n_ws (default none)
+   * @param row_idx device array of the index of each training vector in the
+   *   training set of shared, size [n_rows]
+   * @param csr the training vectors in CSR format, in which case x is not
+   *   used (default none)
    */
   KernelCache(const cumlHandle_impl &handle, const math_t *x, int n_rows,
               int n_cols, int n_ws,
               MLCommon::Matrix::GramMatrixBase<math_t> *kernel,
-              float cache_size = 200)
+              float cache_size = 200, KernelCache<math_t> *shared = nullptr,
+              const int *row_idx = nullptr,
+              const MLCommon::Matrix::CsrMatrix<math_t> *csr = nullptr)
     : cache(handle.getDeviceAllocator(), handle.getStream(), n_rows,
-            cache_size),
+            shared ? 0 : AdaptiveCacheSize(cache_size, n_rows)),
       kernel(kernel),
       x(x),
       n_rows(n_rows),
@@ -95,21 +130,76 @@ class KernelCache {
       cublas_handle(handle.getCublasHandle()),
       x_ws(handle.getDeviceAllocator(), handle.getStream(), n_ws * n_cols),
       tile(handle.getDeviceAllocator(), handle.getStream(), n_ws * n_rows),
-      ws_cache_idx(handle.getDeviceAllocator(), handle.getStream(), n_ws) {
+      ws_cache_idx(handle.getDeviceAllocator(), handle.getStream(), n_ws),
+      ws_x_idx(handle.getDeviceAllocator(), handle.getStream(), n_ws),
+      shared(shared),
+      row_idx(row_idx),
+      local_idx(handle.getDeviceAllocator(), handle.getStream()),
+      csr(csr),
+      handle(handle) {
     ASSERT(kernel != nullptr, "Kernel pointer required for KernelCache!");
 
     stream = handle.getStream();
+    if (shared) {
+      ASSERT(row_idx != nullptr, "Row indices required for a shared cache");
+      ASSERT(n_ws <= shared->n_ws,
+             "The shared cache has a smaller working set");
+      local_idx.resize(shared->n_rows, stream);
+      int *local_ptr = local_idx.data();
+      thrust::for_each(
+        thrust::cuda::par.on(stream), thrust::make_counting_iterator(0),
+        thrust::make_counting_iterator(n_rows),
+        [local_ptr, row_idx] __device__(int i) { local_ptr[row_idx[i]] = i; });
+    }
   }
 
   ~KernelCache(){};
 
+  /**
+   * Return the cache size in MiB for the cache_size parameter. A negative
+   * cache_size selects half of the device memory that is currently free, but
+   * not more than what is needed to store the kernel rows of all the n_rows
+   * training vectors.
+   */
+  static float AdaptiveCacheSize(float cache_size, int n_rows) {
+    if (cache_size >= 0) return cache_size;
+    size_t free_mem, total_mem;
+    CUDA_CHECK(cudaMemGetInfo(&free_mem, &total_mem));
+    double mib = 1024.0 * 1024.0;
+    double full = (double)n_rows * n_rows * sizeof(math_t) / mib;
+    return std::min(full, free_mem / (2 * mib));
+  }
+
+  /** Number of kernel rows that GetTile served from the cache */
+  long long GetHits() const { return shared ? shared->GetHits() : n_hits; }
+
+  /** Number of kernel rows that GetTile had to compute */
+  long long GetMisses() const {
+    return shared ? shared->GetMisses() : n_misses;
+  }
+
   /**
    * @brief Get all the kernel matrix rows for the working set.
+   *
+   * The working set indices can exceed n_rows, as the dual variables of
+   * EPSILON_SVR do, their training vector being ws_idx[i] mod n_rows. The
+   * cache is keyed by the working set indices.
+   *
    * @param ws_idx indices of the working set
    * @return pointer to the kernel tile [ n_rows x n_ws] K_j,i = K(x_j, x_q)
-   * where j=1..n_rows and q = ws_idx[i], j is the contiguous dimension
+   * where j=1..n_rows and q = ws_idx[i] mod n_rows, j is the contiguous
+   * dimension
+   */
+  math_t *GetTile(int *ws_idx) { return GetTile(ws_idx, n_ws); }
+
+  /**
+   * @brief Get the kernel matrix rows for the first n elements of the working
+   * set, n <= n_ws. ws_idx is permuted the same way as by GetTile(ws_idx).
    */
-  math_t *GetTile(int *ws_idx) {
+  math_t *GetTile(int *ws_idx, int n_ws) {
+    if (shared) {
+      return GetSharedTile(ws_idx, n_ws);
+    }
     if (cache.GetSize() > 0) {
       int n_cached;
       cache.GetCacheIdxPartitioned(ws_idx, n_ws, ws_cache_idx.data(), &n_cached,
@@ -118,6 +208,8 @@ class KernelCache {
       cache.GetVecs(ws_cache_idx.data(), n_cached, tile.data(), stream);
 
       int non_cached = n_ws - n_cached;
+      n_hits += n_cached;
+      n_misses += non_cached;
       if (non_cached > 0) {
         int *ws_idx_new = ws_idx + n_cached;
         // AssignCacheIdx can permute ws_idx_new, therefore it has to come
@@ -128,24 +220,58 @@ class KernelCache {
                              stream);  // cache stream
 
         // collect training vectors for kernel elements that needs to be calculated
-        MLCommon::Matrix::copyRows(x, n_rows, n_cols, x_ws.data(), ws_idx_new,
-                                   non_cached, stream, false);
+        int *x_idx = TrainingIdx(ws_idx_new, non_cached);
+        collectRows(x, csr, n_rows, n_cols, x_idx, non_cached, x_ws.data(),
+                    stream);
         math_t *tile_new = tile.data() + n_cached * n_rows;
-        (*kernel)(x, n_rows, n_cols, x_ws.data(), non_cached, tile_new, stream);
+        kernelRows(handle, kernel, x, csr, n_rows, n_cols, x_ws.data(),
+                   non_cached, tile_new, stream);
         // We need AssignCacheIdx to be finished before calling StoreCols
         cache.StoreVecs(tile_new, n_rows, non_cached,
                         ws_cache_idx.data() + n_cached, stream);
       }
     } else {
+      n_misses += n_ws;
       if (n_ws > 0) {
         // collect all the feature vectors in the working set
-        MLCommon::Matrix::copyRows(x, n_rows, n_cols, x_ws.data(), ws_idx, n_ws,
-                                   stream, false);
-        (*kernel)(x, n_rows, n_cols, x_ws.data(), n_ws, tile.data(), stream);
+        int *x_idx = TrainingIdx(ws_idx, n_ws);
+        collectRows(x, csr, n_rows, n_cols, x_idx, n_ws, x_ws.data(), stream);
+        kernelRows(handle, kernel, x, csr, n_rows, n_cols, x_ws.data(), n_ws,
+                   tile.data(), stream);
       }
     }
     return tile.data();
   }
+
+  /**
+   * The kernel tile from the shared cache. The working set is looked up by
+   * its indices in the shared training set, its permutation is mapped back
+   * to our indices, and our rows are gathered from the shared tile.
+   */
+  math_t *GetSharedTile(int *ws_idx, int n_ws) {
+    const int *row_ptr = row_idx;
+    const int *local_ptr = local_idx.data();
+    int *keys = ws_x_idx.data();
+    MLCommon::LinAlg::unaryOp(
+      keys, ws_idx, n_ws,
+      [row_ptr] __device__(int idx) { return row_ptr[idx]; }, stream);
+    math_t *shared_tile = shared->GetTile(keys, n_ws);
+    MLCommon::LinAlg::unaryOp(
+      ws_idx, keys, n_ws,
+      [local_ptr] __device__(int key) { return local_ptr[key]; }, stream);
+    MLCommon::Matrix::copyRows(shared_tile, shared->n_rows, n_ws, tile.data(),
+                               row_idx, n_rows, stream, false);
+    return tile.data();
+  }
+
+  /** The training vector indices (ws_idx mod n_rows) of n working set ids */
+  int *TrainingIdx(const int *ws_idx, int n) {
+    int n_rows = this->n_rows;
+    MLCommon::LinAlg::unaryOp(
+      ws_x_idx.data(), ws_idx, n,
+      [n_rows] __device__(int idx) { return idx % n_rows; }, stream);
+    return ws_x_idx.data();
+  }
 };
 
 };  // end namespace SVM
@@ -32,6 +32,8 @@
 #include "linalg/map_then_reduce.h"
 #include "linalg/unary_op.h"
 #include "matrix/matrix.h"
+#include "sparse_input.h"
+#include "svm_parameter.h"
 #include "ws_util.h"
 
 namespace ML {
@@ -52,19 +54,26 @@ class Results {
    *
    * @param handle cuML handle implementation
    * @param x training vectors in column major format, size [n_rows x n_cols]
-   * @param y target labels (values +/-1), size [n_rows]
+   * @param y labels of the dual variables (values +/-1), size [n_train]
    * @param n_rows number of training vectors
    * @param n_cols number of features
    * @param C penalty parameter
+   * @param svmType the problem that was solved; EPSILON_SVR has
+   *   n_train = 2 * n_rows dual variables, the others n_train = n_rows
+   * @param csr the training vectors in CSR format, in which case x is not
+   *   used (default none)
    */
   Results(const cumlHandle_impl &handle, const math_t *x, const math_t *y,
-          int n_rows, int n_cols, math_t C)
+          int n_rows, int n_cols, math_t C, SvmType svmType = C_SVC,
+          const MLCommon::Matrix::CsrMatrix<math_t> *csr = nullptr)
     : allocator(handle.getDeviceAllocator()),
       stream(handle.getStream()),
       handle(handle),
       n_rows(n_rows),
+      n_train(svmType == EPSILON_SVR ? 2 * n_rows : n_rows),
       n_cols(n_cols),
       x(x),
+      csr(csr),
       y(y),
       C(C),
       cub_storage(handle.getDeviceAllocator(), stream),
@@ -72,8 +81,9 @@ class Results {
       d_val_reduced(handle.getDeviceAllocator(), stream, 1),
       f_idx(handle.getDeviceAllocator(), stream, n_rows),
       idx_selected(handle.getDeviceAllocator(), stream, n_rows),
-      val_selected(handle.getDeviceAllocator(), stream, n_rows),
-      flag(handle.getDeviceAllocator(), stream, n_rows) {
+      val_selected(handle.getDeviceAllocator(), stream, n_train),
+      coefs(handle.getDeviceAllocator(), stream, n_rows),
+      flag(handle.getDeviceAllocator(), stream, n_train) {
     InitCubBuffers();
     MLCommon::LinAlg::range<<<MLCommon::ceildiv(n_rows, TPB), TPB, 0, stream>>>(
       f_idx.data(), n_rows);
@@ -90,8 +100,8 @@ class Results {
    * All output arrays will be allocated on the device.
    * Note that b is not an array but a host scalar.
    *
-   * @param [in] alpha dual coefficients, size [n_rows]
-   * @param [in] f optimality indicator vector, size [n_rows]
+   * @param [in] alpha dual coefficients, size [n_train]
+   * @param [in] f optimality indicator vector, size [n_train]
    * @param [out] dual_coefs size [n_support]
    * @param [out] n_support number of support vectors
    * @param [out] idx the original training set indices of the support vectors, size [n_support]
@@ -100,14 +110,38 @@ class Results {
    */
   void Get(const math_t *alpha, const math_t *f, math_t **dual_coefs,
            int *n_support, int **idx, math_t **x_support, math_t *b) {
-    GetSupportVectorIndices(alpha, n_support, idx);
+    CombineCoefs(alpha, coefs.data());
+    GetSupportVectorIndices(coefs.data(), n_support, idx);
     if (*n_support > 0) {
       *x_support = CollectSupportVectors(*idx, *n_support);
-      *dual_coefs = GetDualCoefs(*n_support, alpha);
+      *dual_coefs = GetDualCoefs(*n_support, coefs.data());
       *b = CalcB(alpha, f);
     }
   }
 
+  /**
+   * Calculate the coefficient of each training vector, the sum of
+   * alpha * y over its dual variables: coef_i = alpha_i * y_i, plus
+   * alpha_{i + n_rows} * y_{i + n_rows} for EPSILON_SVR.
+   *
+   * @param [in] alpha dual coefficients, size [n_train]
+   * @param [out] coef size [n_rows]
+   */
+  void CombineCoefs(const math_t *alpha, math_t *coef) {
+    MLCommon::LinAlg::binaryOp(
+      coef, alpha, y, n_rows,
+      [] __device__(math_t a, math_t y) { return a * y; }, stream);
+    if (n_train > n_rows) {
+      MLCommon::device_buffer<math_t> math_tmp(allocator, stream, n_rows);
+      MLCommon::LinAlg::binaryOp(
+        math_tmp.data(), alpha + n_rows, y + n_rows, n_rows,
+        [] __device__(math_t a, math_t y) { return a * y; }, stream);
+      MLCommon::LinAlg::binaryOp(
+        coef, coef, math_tmp.data(), n_rows,
+        [] __device__(math_t a, math_t b) { return a + b; }, stream);
+    }
+  }
+
   /**
    * Collect support vectors into a contiguous buffer
    *
@@ -120,44 +154,41 @@ class Results {
     math_t *x_support = (math_t *)allocator->allocate(
       n_support * n_cols * sizeof(math_t), stream);
     // Collect support vectors into a contiguous block
-    MLCommon::Matrix::copyRows(x, n_rows, n_cols, x_support, idx, n_support,
-                               stream);
+    collectRows(x, csr, n_rows, n_cols, idx, n_support, x_support, stream);
     CUDA_CHECK(cudaPeekAtLastError());
     return x_support;
   }
 
-  /* Calculate coefficients = alpha * y
+  /* Collect the non-zero coefficients
    * @param n_support number of support vertors
-   * @param alpha
+   * @param coef coefficients of the training vectors from CombineCoefs,
+   *   size [n_rows]
    * @return buffer with dual coefficients, size [n_support]
    */
-  math_t *GetDualCoefs(int n_support, const math_t *alpha) {
+  math_t *GetDualCoefs(int n_support, const math_t *coef) {
     auto allocator = handle.getDeviceAllocator();
     math_t *dual_coefs =
       (math_t *)allocator->allocate(n_support * sizeof(math_t), stream);
-    MLCommon::device_buffer<math_t> math_tmp(allocator, stream, n_rows);
-    // Calculate dual coefficients = alpha * y
-    MLCommon::LinAlg::binaryOp(
-      math_tmp.data(), alpha, y, n_rows,
-      [] __device__(math_t a, math_t y) { return a * y; }, stream);
     // Return only the non-zero coefficients
-    auto select_op = [] __device__(math_t a) { return 0 < a; };
-    SelectByAlpha(alpha, n_rows, math_tmp.data(), select_op, dual_coefs);
+    auto select_op = [] __device__(math_t a) { return a != 0; };
+    SelectByAlpha(coef, n_rows, coef, select_op, dual_coefs);
     return dual_coefs;
   }
 
   /**
    * Flag support vectors and also collect their indices.
-   * Support vectors are the vectors where alpha > 0.
+   * Support vectors are the vectors with a non-zero coefficient; for C_SVC,
+   * where alpha > 0.
    *
-   * @param [in] alpha dual coefficients, size [n_rows]
+   * @param [in] coef coefficients of the training vectors from CombineCoefs,
+   *   size [n_rows]
    * @param [out] n_support number of support vectors
    * @param [out] idx indices of the suport vectors, size [n_support]
    */
-  void GetSupportVectorIndices(const math_t *alpha, int *n_support, int **idx) {
+  void GetSupportVectorIndices(const math_t *coef, int *n_support, int **idx) {
     *n_support = SelectByAlpha(
-      alpha, n_rows, f_idx.data(),
-      [] __device__(math_t a) -> bool { return 0 < a; }, idx_selected.data());
+      coef, n_rows, f_idx.data(),
+      [] __device__(math_t a) -> bool { return a != 0; }, idx_selected.data());
     if (*n_support > 0) {
       *idx = (int *)allocator->allocate((*n_support) * sizeof(int), stream);
       MLCommon::copy(*idx, idx_selected.data(), *n_support, stream);
@@ -167,8 +198,8 @@ class Results {
   /**
    * Calculate the b constant in the decision function.
    *
-   * @param [in] alpha dual coefficients, size [n_rows]
-   * @param [in] f optimality indicator vector, size [n_rows]
+   * @param [in] alpha dual coefficients, size [n_train]
+   * @param [in] f optimality indicator vector, size [n_train]
    * @return the value of b
  */
   math_t CalcB(const math_t *alpha, const math_t *f) {
@@ -184,7 +215,7 @@ class Results {
     // Select f for unbound support vectors (0 < alpha < C)
     math_t C = this->C;
     auto select = [C] __device__(math_t a) -> bool { return 0 < a && a < C; };
-    int n_free = SelectByAlpha(alpha, n_rows, f, select, val_selected.data());
+    int n_free = SelectByAlpha(alpha, n_train, f, select, val_selected.data());
     if (n_free > 0) {
       cub::DeviceReduce::Sum(cub_storage.data(), cub_bytes, val_selected.data(),
                              d_val_reduced.data(), n_free, stream);
@@ -210,8 +241,11 @@ class Results {
   cudaStream_t stream;
 
   int n_rows;       //!< number of training vectors
+  int n_train;      //!< number of dual variables
   int n_cols;       //!< number of features
   const math_t *x;  //!< training vectors
+  //! training vectors in CSR format, if they are sparse
+  const MLCommon::Matrix::CsrMatrix<math_t> *csr;
   const math_t *y;  //!< labels
   math_t C;
 
@@ -226,6 +260,7 @@ class Results {
   MLCommon::device_buffer<int> f_idx;
   MLCommon::device_buffer<int> idx_selected;
   MLCommon::device_buffer<math_t> val_selected;
+  MLCommon::device_buffer<math_t> coefs;
   MLCommon::device_buffer<bool> flag;
 
   /* Allocate cub temporary buffers for GetResults
@@ -238,13 +273,13 @@ class Results {
                                f_idx.data(), d_num_selected.data(), n_rows,
                                stream);
     cub::DeviceSelect::Flagged(NULL, cub_bytes2, p, flag.data(), p,
-                               d_num_selected.data(), n_rows, stream);
+                               d_num_selected.data(), n_train, stream);
     cub_bytes = max(cub_bytes, cub_bytes2);
     cub::DeviceReduce::Sum(NULL, cub_bytes2, val_selected.data(),
-                           d_val_reduced.data(), n_rows, stream);
+                           d_val_reduced.data(), n_train, stream);
     cub_bytes = max(cub_bytes, cub_bytes2);
     cub::DeviceReduce::Min(NULL, cub_bytes2, val_selected.data(),
-                           d_val_reduced.data(), n_rows, stream);
+                           d_val_reduced.data(), n_train, stream);
     cub_bytes = max(cub_bytes, cub_bytes2);
     cub_storage.resize(cub_bytes, stream);
   }
@@ -274,20 +309,20 @@ class Results {
   }
 
   /** Select values from f, and do a min or max reduction on them.
-   * @param [in] alpha dual coefficients, size [n_rows]
-   * @param [in] f optimality indicator vector, size [n_rows]
+   * @param [in] alpha dual coefficients, size [n_train]
+   * @param [in] f optimality indicator vector, size [n_train]
    * @param flag_op operation to flag values for selection (set_upper/lower)
    * @param return the reduced value.
    */
   math_t SelectReduce(const math_t *alpha, const math_t *f, bool min,
                       void (*flag_op)(bool *, int, const math_t *,
                                       const math_t *, math_t)) {
-    flag_op<<<MLCommon::ceildiv(n_rows, TPB), TPB, 0, stream>>>(
-      flag.data(), n_rows, alpha, y, C);
+    flag_op<<<MLCommon::ceildiv(n_train, TPB), TPB, 0, stream>>>(
+      flag.data(), n_train, alpha, y, C);
     CUDA_CHECK(cudaPeekAtLastError());
     cub::DeviceSelect::Flagged(cub_storage.data(), cub_bytes, f, flag.data(),
                                val_selected.data(), d_num_selected.data(),
-                               n_rows, stream);
+                               n_train, stream);
     int n_selected;
     MLCommon::updateHost(&n_selected, d_num_selected.data(), 1, stream);
     CUDA_CHECK(cudaStreamSynchronize(stream));
@@ -20,6 +20,10 @@
 
 #include <cuda_utils.h>
 #include <stdlib.h>
+#include <thrust/execution_policy.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/transform_reduce.h>
 #include "ml_utils.h"
 #include "selection/kselection.h"
 #include "smo_sets.h"
@@ -106,23 +110,34 @@ namespace SVM {
  * - [3] Z. Wen et al. ThunderSVM: A Fast SVM Library on GPUs and CPUs, Journal
  *      of Machine Learning Research, 19, 1-5 (2018)
  *
+ * The working set can be split into gridDim.x independent sub-blocks, each
+ * solved by one thread block: block b takes the interleaved elements
+ * b, b + gridDim.x, b + 2 * gridDim.x, ... of the working set, so that every
+ * sub-block gets its share of the upper and of the lower set. SMO updates
+ * keep the equality constraint within each sub-block, therefore the combined
+ * update is feasible. The sub-blocks ignore the changes of f caused by each
+ * other, these are accounted for when f is updated after the solver.
+ *
  * @tparam math_t floating point data type
- * @tparam WSIZE working set size (max 1024)
- * @param [in] y_array target labels size [n_rows]
+ * @tparam WSIZE maximal number of working set elements per block (max 1024)
+ * For EPSILON_SVR, the dual variables i and i + n_rows share the training
+ * vector x_i, whose kernel row is at index i mod n_rows of the tile.
+ *
+ * @param [in] y_array target labels size [n_train]
  * @param [in] n_rows number of trainig vectors
- * @param [inout] alpha dual coefficients, size [n_rows]
+ * @param [inout] alpha dual coefficients, size [n_train]
  * @param [in] n_ws number of elements in the working set
  * @param [out] delta_alpha change in the dual coeff of vectors in the working
  *        set, size [n_ws]
- * @param [in] f_array optimality indicator vector, size [n_rows]
+ * @param [in] f_array optimality indicator vector, size [n_train]
  * @param [in] kernel kernel function calculated between the working set and all
  *   other training vectors, size [n_rows * n_ws]
  * @param [in] ws_idx indices of traning vectors in the working set, size [n_ws]
  * @param [in] C penalty parameter
  * @param [in] eps tolerance, iterations will stop if the duality gap is smaller
  *  than this value (or if the gap is smaller than 0.1 times the initial gap)
- * @param [out] return_buff, two valies are returned: duality gap and the number
- *   of iterations
+ * @param [out] return_buff, two valies are returned per block: duality gap and
+ *   the number of iterations, size [2 * gridDim.x]
  * @param [in] max_iter maximum number of iterations
  */
 template <typename math_t, int WSIZE>
@@ -153,7 +168,17 @@ __global__ __launch_bounds__(WSIZE) void SmoBlockSolve(
   __shared__ math_t Kd[WSIZE];  // diagonal elements of the kernel matrix
 
   int tid = threadIdx.x;
-  int idx = ws_idx[tid];
+  int n_blocks = gridDim.x;
+  int n_ws_block = (n_ws - blockIdx.x + n_blocks - 1) / n_blocks;
+  bool active = tid < n_ws_block;
+  int ws_pos = tid * n_blocks + blockIdx.x;  // position in the working set
+  // columns of the kernel tile that belong to this block
+  kernel += blockIdx.x * (size_t)n_rows;
+  size_t ld = n_blocks * (size_t)n_rows;
+  return_buff += 2 * blockIdx.x;
+
+  int idx = active ? ws_idx[ws_pos] : 0;
+  int x_idx = idx % n_rows;  // row of the training vector in the kernel tile
 
   // store values in registers
   math_t y = y_array[idx];
@@ -163,14 +188,15 @@ __global__ __launch_bounds__(WSIZE) void SmoBlockSolve(
   __shared__ math_t diff_end;
   __shared__ math_t diff;
 
-  Kd[tid] = kernel[tid * n_rows + idx];
+  Kd[tid] = active ? kernel[tid * ld + x_idx] : 0;
   int n_iter = 0;
 
   for (; n_iter < max_iter; n_iter++) {
     // mask values outside of X_upper
     math_t f_tmp = in_upper(a, y, C) ? f : INFINITY;
     Pair pair{f_tmp, tid};
-    Pair res = BlockReduce(temp_storage.pair).Reduce(pair, cub::Min(), n_ws);
+    Pair res =
+      BlockReduce(temp_storage.pair).Reduce(pair, cub::Min(), n_ws_block);
     if (tid == 0) {
       f_u = res.val;
       u = res.key;
@@ -178,9 +204,9 @@ __global__ __launch_bounds__(WSIZE) void SmoBlockSolve(
     // select f_max to check stopping condition
     f_tmp = in_lower(a, y, C) ? f : -INFINITY;
     __syncthreads();  // needed because we are reusing the shared memory buffer
-    math_t Kui = kernel[u * n_rows + idx];
-    math_t f_max =
-      BlockReduceFloat(temp_storage.single).Reduce(f_tmp, cub::Max(), n_ws);
+    math_t Kui = kernel[u * ld + x_idx];
+    math_t f_max = BlockReduceFloat(temp_storage.single)
+                     .Reduce(f_tmp, cub::Max(), n_ws_block);
 
     if (tid == 0) {
       // f_max-f_u is used to check stopping condition.
@@ -202,12 +228,12 @@ __global__ __launch_bounds__(WSIZE) void SmoBlockSolve(
       f_tmp = -INFINITY;
     }
     pair = Pair{f_tmp, tid};
-    res = BlockReduce(temp_storage.pair).Reduce(pair, cub::Max(), n_ws);
+    res = BlockReduce(temp_storage.pair).Reduce(pair, cub::Max(), n_ws_block);
     if (tid == 0) {
       l = res.key;
     }
     __syncthreads();
-    math_t Kli = kernel[l * n_rows + idx];
+    math_t Kli = kernel[l * ld + x_idx];
 
     // Update alpha
     // Let's set q = \frac{f_l - f_u}{\eta_{ul}
@@ -237,10 +263,50 @@ __global__ __launch_bounds__(WSIZE) void SmoBlockSolve(
     f += q * (Kui - Kli);
   }
   // save results to global memory before exit
-  alpha[idx] = a;
-  delta_alpha[tid] = (a - a_save) * y;  // it is actuall y * \Delta \alpha
+  if (active) {
+    alpha[idx] = a;
+    delta_alpha[ws_pos] = (a - a_save) * y;  // it is actuall y * \Delta \alpha
+  }
   // f is recalculated in f_update, therefore we do not need to save that
   return_buff[1] = n_iter;
 }
+
+/**
+ * Return the duality gap max{f_i | i in I_lower} - min{f_i | i in I_upper}
+ * over the working set, before it is solved.
+ *
+ * SmoBlockSolve returns this value when it runs a single block. With several
+ * sub-blocks, each block only sees the gap within its own elements, and the
+ * stopping condition of the outer iterations uses this value instead.
+ *
+ * @param [in] y_array labels of the dual variables, size [n_train]
+ * @param [in] alpha dual coefficients, size [n_train]
+ * @param [in] f optimality indicator vector, size [n_train]
+ * @param [in] ws_idx indices of the working set, size [n_ws]
+ * @param [in] n_ws number of elements in the working set
+ * @param [in] C penalty parameter
+ * @param [in] stream cuda stream
+ */
+template <typename math_t>
+math_t WorkingSetDiff(const math_t *y_array, const math_t *alpha,
+                      const math_t *f, const int *ws_idx, int n_ws, math_t C,
+                      cudaStream_t stream) {
+  auto first = thrust::make_counting_iterator(0);
+  math_t f_u = thrust::transform_reduce(
+    thrust::cuda::par.on(stream), first, first + n_ws,
+    [=] __device__(int i) {
+      int k = ws_idx[i];
+      return in_upper(alpha[k], y_array[k], C) ? f[k] : math_t(INFINITY);
+    },
+    math_t(INFINITY), thrust::minimum<math_t>());
+  math_t f_l = thrust::transform_reduce(
+    thrust::cuda::par.on(stream), first, first + n_ws,
+    [=] __device__(int i) {
+      int k = ws_idx[i];
+      return in_lower(alpha[k], y_array[k], C) ? f[k] : math_t(-INFINITY);
+    },
+    math_t(-INFINITY), thrust::maximum<math_t>());
+  return f_l - f_u;
+}
 };  // end namespace SVM
 };  // end namespace ML
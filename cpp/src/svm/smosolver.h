@@ -22,9 +22,22 @@
 #include <limits>
 #include <string>
 #include <type_traits>
+#include <vector>
+
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/device_ptr.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/sequence.h>
+#include <thrust/transform.h>
+#include <thrust/transform_reduce.h>
 
 #include "common/cumlHandle.hpp"
 #include "kernelcache.h"
+#include "linalg/add.h"
 #include "linalg/cublas_wrappers.h"
 #include "linalg/gemv.h"
 #include "linalg/unary_op.h"
@@ -33,6 +46,8 @@
 #include "matrix/kernelparams.h"
 #include "smo_sets.h"
 #include "smoblocksolve.h"
+#include "sparse_input.h"
+#include "svm_parameter.h"
 #include "workingset.h"
 #include "ws_util.h"
 
@@ -42,6 +57,33 @@
 namespace ML {
 namespace SVM {
 
+/**
+ * Update f for the active variables only, see SmoSolver::UpdateF.
+ *
+ * @param [inout] f optimality indicator vector, size [n_train]
+ * @param [in] active_idx indices of the active variables, size [n_active]
+ * @param [in] n_active number of active variables
+ * @param [in] n_rows number of training vectors
+ * @param [in] delta_alpha size [n_ws]
+ * @param [in] n_ws number of elements in the working set
+ * @param [in] tile kernel tile, size [n_rows x n_ws]
+ */
+template <typename math_t>
+__global__ void update_f_active(math_t *f, const int *active_idx, int n_active,
+                                int n_rows, const math_t *delta_alpha, int n_ws,
+                                const math_t *tile) {
+  int tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid < n_active) {
+    int k = active_idx[tid];
+    int row = k % n_rows;
+    math_t sum = 0;
+    for (int j = 0; j < n_ws; j++) {
+      sum += tile[row + j * (size_t)n_rows] * delta_alpha[j];
+    }
+    f[k] += sum;
+  }
+}
+
 /**
  * Solve the quadratic optimization problem using two level decomposition and
  * Sequential Minimal Optimization (SMO).
@@ -51,8 +93,8 @@ namespace SVM {
  * section 11.2 by Joachims [1]). SMO is the extreme case where we choose q=2.
  *
  * Here we follow [2] and [3] and use two level decomposition. First we set
- * q_1=1024, and solve the QP sub-problem for that (let's call it QP1). This is
- * the outer iteration, implemented in SmoSolver::Solve.
+ * q_1=1024 (or ws_size), and solve the QP sub-problem for that (let's call it
+ * QP1). This is the outer iteration, implemented in SmoSolver::Solve.
  *
  * To solve QP1, we use another decomposition, specifically the SMO (q_2 = 2),
  * which is implemented in SmoBlockSolve.
@@ -71,23 +113,85 @@ template <typename math_t>
 class SmoSolver {
  public:
   bool verbose = false;
+  //! Size of the working set. The default 0 selects min(1024, n_train).
+  //! Working sets larger than SMO_WS_SIZE are solved by several thread blocks
+  //! in parallel, see SmoBlockSolve.
+  int ws_size = 0;
+  //! Use the shrinking heuristic, see Shrink
+  bool shrinking = false;
+  /**
+   * @param handle cuML handle implementation
+   * @param C penalty parameter; the one-class SVM bounds the dual coefficients
+   *   by 1 instead
+   * @param tol tolerance for the stopping condition
+   * @param kernel kernel function
+   * @param cache_size size of the kernel cache in MiB, negative to size it
+   *   from the free device memory
+   * @param nochange_steps number of steps with a non-changing diff after which
+   *   the solver stops
+   * @param svmType the problem to solve
+   * @param epsilon width of the insensitive tube of EPSILON_SVR
+   * @param nu fraction of outliers of ONE_CLASS, in (0, 1]
+   */
   SmoSolver(const cumlHandle_impl &handle, math_t C, math_t tol,
             MLCommon::Matrix::GramMatrixBase<math_t> *kernel,
-            float cache_size = 200, int nochange_steps = 1000)
+            float cache_size = 200, int nochange_steps = 1000,
+            SvmType svmType = C_SVC, math_t epsilon = 0.1, math_t nu = 0.5)
     : handle(handle),
       n_rows(n_rows),
-      C(C),
+      C(svmType == ONE_CLASS ? 1 : C),
       tol(tol),
       kernel(kernel),
       cache_size(cache_size),
       nochange_steps(nochange_steps),
+      svmType(svmType),
+      epsilon(epsilon),
+      nu(nu),
       stream(handle.getStream()),
       return_buff(handle.getDeviceAllocator(), stream, 2),
       alpha(handle.getDeviceAllocator(), stream),
       delta_alpha(handle.getDeviceAllocator(), stream),
-      f(handle.getDeviceAllocator(), stream) {}
+      f(handle.getDeviceAllocator(), stream),
+      y_train(handle.getDeviceAllocator(), stream),
+      f_base(handle.getDeviceAllocator(), stream),
+      active(handle.getDeviceAllocator(), stream),
+      active_idx(handle.getDeviceAllocator(), stream) {}
+
+  /**
+   * Look up the kernel rows in a cache shared with other solvers, instead of
+   * a cache of our own.
+   *
+   * @param cache kernel cache over a superset of the training vectors, with
+   *   a working set at least as large as ours
+   * @param row_idx device array of the index of each training vector (given
+   *   to Solve) in the training set of the shared cache, size [n_rows]
+   */
+  void SetSharedCache(KernelCache<math_t> *cache, const int *row_idx) {
+    shared_cache = cache;
+    shared_row_idx = row_idx;
+  }
+
+  /**
+   * Start the next Solve from the dual coefficients of a previous model,
+   * instead of alpha = 0. Not supported for ONE_CLASS.
+   *
+   * @param dual_coefs device array of the dual coefficients (y_i * alpha_i)
+   *   of the previous model, size [n]
+   * @param idx device array of the index of each coefficient in the training
+   *   set given to Solve, size [n]
+   * @param n number of coefficients
+   *
+   * The arrays are not copied, they shall stay valid until Solve returns.
+   */
+  void SetWarmStart(const math_t *dual_coefs, const int *idx, int n) {
+    warm_coefs = dual_coefs;
+    warm_idx = idx;
+    n_warm = n;
+  }
 
 #define SMO_WS_SIZE 1024
+//! Number of outer iterations between two shrinking steps
+#define SMO_SHRINK_STEPS 20
   /**
    * Solve the quadratic optimization problem.
    *
@@ -97,7 +201,8 @@ class SmoSolver {
    * @param [in] x training vectors in column major format, size [n_rows x n_cols]
    * @param [in] n_rows number of rows (training vectors)
    * @param [in] n_cols number of columns (features)
-   * @param [in] y labels (values +/-1), size [n_rows]
+   * @param [in] y labels (values +/-1) for C_SVC, target values for
+   *   EPSILON_SVR, unused (can be nullptr) for ONE_CLASS, size [n_rows]
    * @param [out] dual_coefs, size [n_support] on exit
    * @param [out] n_support number of support vectors
    * @param [out] x_support support vectors in column major format, size [n_support, n_cols]
@@ -105,24 +210,55 @@ class SmoSolver {
    * @param [out] b scalar constant for the decision function
    * @param [in] max_out_iter maximum number of outer iteration (default 100 * n_rows)
    * @param [in] xm_inner_iter maximum number of inner iterations (default 10000)
+   *
+   * The EPSILON_SVR dual has two variables for each training vector: the
+   * first n_rows with label +1, and the second n_rows with label -1 [4]. The
+   * working set, f and alpha span these 2*n_rows variables, while the kernel
+   * is evaluated on the training vector (index mod n_rows) of each variable.
+   * The ONE_CLASS dual has the labels +1, the bound 1 and the constraint
+   * sum(alpha) = nu * n_rows [5].
+   *
+   * [4] C.C. Chang and C.J. Lin, LIBSVM: A library for support vector
+   *     machines, ACM Transactions on Intelligent Systems and Technology,
+   *     2:27:1--27:27 (2011)
+   * [5] B. Schoelkopf et al., Estimating the support of a high-dimensional
+   *     distribution, Neural Computation 13, 1443-1471 (2001)
    */
   void Solve(math_t *x, int n_rows, int n_cols, math_t *y, math_t **dual_coefs,
              int *n_support, math_t **x_support, int **idx, math_t *b,
              int max_outer_iter = -1, int max_inner_iter = 10000) {
+    int n_train = svmType == EPSILON_SVR ? 2 * n_rows : n_rows;
     if (max_outer_iter == -1) {
-      max_outer_iter = n_rows < std::numeric_limits<int>::max() / 100
-                         ? n_rows * 100
+      max_outer_iter = n_train < std::numeric_limits<int>::max() / 100
+                         ? n_train * 100
                          : std::numeric_limits<int>::max();
       max_outer_iter = max(100000, max_outer_iter);
     }
 
-    WorkingSet<math_t> ws(handle, stream, n_rows, SMO_WS_SIZE);
+    WorkingSet<math_t> ws(handle, stream, n_train, ws_size);
     int n_ws = ws.GetSize();
-    ResizeBuffers(n_rows, n_cols, n_ws);
-    Initialize(y);
+    int n_blocks = MLCommon::ceildiv(n_ws, SMO_WS_SIZE);
+    int n_threads = MLCommon::ceildiv(n_ws, n_blocks);
+    ML::nvtxRange range("Trace::Svm::SmoSolve", "rows=%d cols=%d ws=%d",
+                        n_rows, n_cols, n_ws);
+    // Shrinking would not change anything if all the variables are in the
+    // working set
+    bool shrink = shrinking && n_ws < n_train;
+    ResizeBuffers(n_rows, n_cols, n_ws, n_blocks, shrink);
+    y = Initialize(x, y);
+    if (shrink) {
+      // f at alpha = 0, to reconstruct f when unshrinking
+      if (svmType == ONE_CLASS) {
+        CUDA_CHECK(cudaMemsetAsync(f_base.data(), 0,
+                                   n_train * sizeof(math_t), stream));
+      } else {
+        MLCommon::copy(f_base.data(), f.data(), n_train, stream);
+      }
+    }
+    if (n_warm > 0) WarmStart(x, y);
 
     KernelCache<math_t> cache(handle, x, n_rows, n_cols, n_ws, kernel,
-                              cache_size);
+                              cache_size, shared_cache, shared_row_idx, csr_x);
 
     int n_iter = 0;
     int n_inner_iter = 0;
@@ -131,29 +267,53 @@ class SmoSolver {
     bool keep_going = true;
 
     while (n_iter < max_outer_iter && keep_going) {
+      ML::nvtxRange iteration("Trace::Svm::SmoOuterIteration", n_iter);
       CUDA_CHECK(
         cudaMemsetAsync(delta_alpha.data(), 0, n_ws * sizeof(math_t), stream));
       ws.Select(f.data(), alpha.data(), y, C);
 
       math_t *cacheTile = cache.GetTile(ws.GetIndices());
 
-      SmoBlockSolve<math_t, SMO_WS_SIZE><<<1, n_ws, 0, stream>>>(
+      math_t diff = 0;
+      if (n_blocks > 1) {
+        diff = WorkingSetDiff(y, alpha.data(), f.data(), ws.GetIndices(), n_ws,
+                              C, stream);
+      }
+
+      SmoBlockSolve<math_t, SMO_WS_SIZE><<<n_blocks, n_threads, 0, stream>>>(
         y, n_rows, alpha.data(), n_ws, delta_alpha.data(), f.data(), cacheTile,
         ws.GetIndices(), C, tol, return_buff.data(), max_inner_iter);
 
       CUDA_CHECK(cudaPeekAtLastError());
 
-      MLCommon::updateHost(host_return_buff, return_buff.data(), 2, stream);
+      MLCommon::updateHost(host_return_buff.data(), return_buff.data(),
+                           2 * n_blocks, stream);
 
       UpdateF(f.data(), n_rows, delta_alpha.data(), n_ws, cacheTile);
 
       CUDA_CHECK(cudaStreamSynchronize(stream));
 
-      math_t diff = host_return_buff[0];
+      int block_iter = 0;
+      for (int b = 0; b < n_blocks; b++) {
+        block_iter = max(block_iter, (int)host_return_buff[2 * b + 1]);
+      }
+      if (n_blocks == 1) diff = host_return_buff[0];
       keep_going = CheckStoppingCondition(diff);
 
-      n_inner_iter += host_return_buff[1];
+      n_inner_iter += block_iter;
       n_iter++;
+      if (!keep_going && n_active < n_train) {
+        // The shrunk variables might violate the optimality conditions, we
+        // continue with the full problem.
+        Unshrink(x, y);
+        ws.SetActive(nullptr);
+        shrink = false;
+        n_small_diff = 0;
+        keep_going = true;
+      } else if (shrink && n_iter % SMO_SHRINK_STEPS == 0) {
+        Shrink(y, n_ws);
+        ws.SetActive(n_active < n_train ? active.data() : nullptr);
+      }
       if (verbose && n_iter % 500 == 0) {
         std::cout << "SMO iteration " << n_iter << ", diff " << diff << "\n";
       }
@@ -163,12 +323,35 @@ class SmoSolver {
       std::cout << "SMO solver finished after " << n_iter
                 << " outer iterations, " << n_inner_iter
                 << " total inner iterations, and diff " << diff_prev << "\n";
+      std::cout << "Kernel cache: " << cache.GetHits() << " hits, "
+                << cache.GetMisses() << " misses\n";
     }
-    Results<math_t> res(handle, x, y, n_rows, n_cols, C);
+    // Results need the correct f values of all the variables
+    if (n_active < n_train) Unshrink(x, y);
+    Results<math_t> res(handle, x, y, n_rows, n_cols, C, svmType, csr_x);
     res.Get(alpha.data(), f.data(), dual_coefs, n_support, idx, x_support, b);
     ReleaseBuffers();
   }
 
+  /**
+   * Solve the quadratic optimization problem for training vectors in CSR
+   * format. The parameters are the same as for the dense input, except
+   *
+   * @param [in] x training vectors in CSR format, size [n_rows x n_cols]
+   *
+   * The kernel rows are evaluated by sparse matrix - dense matrix products,
+   * while the working set and the support vectors are collected as dense
+   * vectors.
+   */
+  void Solve(const MLCommon::Matrix::CsrMatrix<math_t> &x, math_t *y,
+             math_t **dual_coefs, int *n_support, math_t **x_support, int **idx,
+             math_t *b, int max_outer_iter = -1, int max_inner_iter = 10000) {
+    csr_x = &x;
+    Solve(nullptr, x.n_rows, x.n_cols, y, dual_coefs, n_support, x_support,
+          idx, b, max_outer_iter, max_inner_iter);
+    csr_x = nullptr;
+  }
+
   /**
    * Update the f vector after a block solve step.
    *
@@ -182,24 +365,323 @@ class SmoSolver {
    * @param n_ws
    * @param cacheTile kernel function evaluated for the following set K[X,x_ws], size [n_rows, n_ws]
    * @param cublas_handle
+   *
+   * For EPSILON_SVR, both halves of f are updated, the variables i and
+   * i + n_rows sharing the training vector x_i.
+   *
+   * If some variables are shrunk, then only the active ones are updated.
    */
   void UpdateF(math_t *f, int n_rows, const math_t *delta_alpha, int n_ws,
                const math_t *cacheTile) {
+    int n_train = svmType == EPSILON_SVR ? 2 * n_rows : n_rows;
+    if (n_active < n_train) {
+      update_f_active<<<MLCommon::ceildiv(n_active, TPB), TPB, 0, stream>>>(
+        f, active_idx.data(), n_active, n_rows, delta_alpha, n_ws, cacheTile);
+      CUDA_CHECK(cudaPeekAtLastError());
+      return;
+    }
     math_t one =
       1;  // multipliers used in the equation : f = 1*cachtile * delta_alpha + 1*f
     CUBLAS_CHECK(MLCommon::LinAlg::cublasgemv(
       handle.getCublasHandle(), CUBLAS_OP_N, n_rows, n_ws, &one, cacheTile,
       n_rows, delta_alpha, 1, &one, f, 1, stream));
+    if (svmType == EPSILON_SVR) {
+      CUBLAS_CHECK(MLCommon::LinAlg::cublasgemv(
+        handle.getCublasHandle(), CUBLAS_OP_N, n_rows, n_ws, &one, cacheTile,
+        n_rows, delta_alpha, 1, &one, f + n_rows, 1, stream));
+    }
   }
 
-  /// Initialize the values of alpha and f
-  void Initialize(math_t *y) {
-    // we initialize alpha_i = 0 and
-    // f_i = -y_i
+  /**
+   * Initialize the values of alpha and f, and the labels of the dual
+   * variables.
+   *
+   * The optimality indicator of the variable i is f_i = y_i * grad_i, where
+   * grad is the gradient of the dual objective 1/2 alpha^T Q alpha + p^T alpha.
+   * - C_SVC: alpha = 0, p = -1, therefore f_i = -y_i.
+   * - EPSILON_SVR: alpha = 0, p = [epsilon - y; epsilon + y] and labels
+   *   [+1; -1], therefore f = [epsilon - y; -epsilon - y].
+   * - ONE_CLASS: p = 0 and labels +1. Following LIBSVM, the first
+   *   nu * n_rows dual coefficients are set to 1 (the last one possibly to a
+   *   fraction) to satisfy sum(alpha) = nu * n_rows, and f = K alpha.
+   *
+   * @param [in] x training vectors in column major format, size [n_rows x n_cols]
+   * @param [in] y input labels or targets, size [n_rows]
+   * @return the labels of the dual variables, size [n_train]
+   */
+  math_t *Initialize(const math_t *x, math_t *y) {
+    int n_train = svmType == EPSILON_SVR ? 2 * n_rows : n_rows;
     CUDA_CHECK(
-      cudaMemsetAsync(alpha.data(), 0, n_rows * sizeof(math_t), stream));
-    MLCommon::LinAlg::unaryOp(
-      f.data(), y, n_rows, [] __device__(math_t y) { return -y; }, stream);
+      cudaMemsetAsync(alpha.data(), 0, n_train * sizeof(math_t), stream));
+    switch (svmType) {
+      case EPSILON_SVR: {
+        math_t eps = epsilon;
+        MLCommon::LinAlg::unaryOp(
+          f.data(), y, n_rows, [eps] __device__(math_t y) { return eps - y; },
+          stream);
+        MLCommon::LinAlg::unaryOp(
+          f.data() + n_rows, y, n_rows,
+          [eps] __device__(math_t y) { return -eps - y; }, stream);
+        thrust::device_ptr<math_t> y_ptr(y_train.data());
+        thrust::fill(thrust::cuda::par.on(stream), y_ptr, y_ptr + n_rows, 1);
+        thrust::fill(thrust::cuda::par.on(stream), y_ptr + n_rows,
+                     y_ptr + n_train, -1);
+        return y_train.data();
+      }
+      case ONE_CLASS: {
+        thrust::device_ptr<math_t> y_ptr(y_train.data());
+        thrust::fill(thrust::cuda::par.on(stream), y_ptr, y_ptr + n_rows, 1);
+        OneClassInit(x);
+        return y_train.data();
+      }
+      default:
+        // we initialize alpha_i = 0 and
+        // f_i = -y_i
+        MLCommon::LinAlg::unaryOp(
+          f.data(), y, n_rows, [] __device__(math_t y) { return -y; }, stream);
+        return y;
+    }
+  }
+
+  /**
+   * Set the initial one-class dual coefficients, and f = K alpha. The kernel
+   * rows of the nonzero coefficients are evaluated in batches of the size of
+   * a kernel cache tile.
+   */
+  void OneClassInit(const math_t *x) {
+    math_t nu_n = nu * n_rows;
+    ASSERT(nu > 0 && nu <= 1, "Parameter nu: must be in (0, 1]");
+    int n_nonzero = min(n_rows, (int)ceil(nu_n));
+    math_t *alpha_ptr = alpha.data();
+    thrust::for_each(thrust::cuda::par.on(stream),
+                     thrust::make_counting_iterator(0),
+                     thrust::make_counting_iterator(n_nonzero),
+                     [alpha_ptr, nu_n] __device__(int i) {
+                       alpha_ptr[i] = min(math_t(1), nu_n - i);
+                     });
+    CUDA_CHECK(cudaMemsetAsync(f.data(), 0, n_rows * sizeof(math_t), stream));
+
+    MLCommon::device_buffer<int> idx(handle.getDeviceAllocator(), stream,
+                                     n_nonzero);
+    thrust::device_ptr<int> idx_ptr(idx.data());
+    thrust::sequence(thrust::cuda::par.on(stream), idx_ptr,
+                     idx_ptr + n_nonzero);
+    KernelProduct(x, idx.data(), alpha_ptr, n_nonzero, f.data());
+  }
+
+  /**
+   * Accumulate out += K(X, x_idx) * coef, where X are all the training
+   * vectors. The kernel rows are evaluated in batches of the size of a kernel
+   * cache tile.
+   *
+   * @param [in] x training vectors in column major format
+   * @param [in] idx indices of training vectors, size [n]
+   * @param [in] coef coefficients of these training vectors, size [n]
+   * @param [in] n number of training vectors in idx
+   * @param [inout] out size [n_rows]
+   */
+  void KernelProduct(const math_t *x, const int *idx, const math_t *coef,
+                     int n, math_t *out) {
+    if (n == 0) return;
+    int n_batch = min(n_ws, n);
+    auto allocator = handle.getDeviceAllocator();
+    MLCommon::device_buffer<math_t> tile(allocator, stream, n_batch * n_rows);
+    MLCommon::device_buffer<math_t> x_batch(allocator, stream,
+                                            n_batch * n_cols);
+    math_t one = 1;
+    for (int i = 0; i < n; i += n_batch) {
+      int n_i = min(n_batch, n - i);
+      collectRows(x, csr_x, n_rows, n_cols, idx + i, n_i, x_batch.data(),
+                  stream);
+      kernelRows(handle, kernel, x, csr_x, n_rows, n_cols, x_batch.data(), n_i,
+                 tile.data(), stream);
+      CUBLAS_CHECK(MLCommon::LinAlg::cublasgemv(
+        handle.getCublasHandle(), CUBLAS_OP_N, n_rows, n_i, &one, tile.data(),
+        n_rows, coef + i, 1, &one, out, 1, stream));
+    }
+  }
+
+  /**
+   * Shrink the variables that are unlikely to change.
+   *
+   * Following LIBSVM [4] (see Solve), a variable is shrunk if it is at a
+   * bound, and it cannot form a violating pair with any other active
+   * variable: it is only in the upper set and f_i > max{f_j | j in I_lower},
+   * or it is only in the lower set and f_i < min{f_j | j in I_upper}. The
+   * shrunk variables are excluded from the working set selection, and their
+   * f values are not updated until Unshrink.
+   *
+   * The shrinking is skipped if fewer than n_ws variables would remain.
+   *
+   * @param [in] y labels of the dual variables, size [n_train]
+   * @param [in] n_ws size of the working set
+   */
+  void Shrink(const math_t *y, int n_ws) {
+    int n_train = svmType == EPSILON_SVR ? 2 * n_rows : n_rows;
+    const math_t *alpha_ptr = alpha.data();
+    const math_t *f_ptr = f.data();
+    const bool *active_ptr = active.data();
+    math_t C = this->C;
+    auto first = thrust::make_counting_iterator(0);
+    auto last = first + n_train;
+    auto policy = thrust::cuda::par.on(stream);
+    math_t f_up = thrust::transform_reduce(
+      policy, first, last,
+      [=] __device__(int i) {
+        return active_ptr[i] && in_upper(alpha_ptr[i], y[i], C)
+                 ? f_ptr[i]
+                 : math_t(INFINITY);
+      },
+      math_t(INFINITY), thrust::minimum<math_t>());
+    math_t f_low = thrust::transform_reduce(
+      policy, first, last,
+      [=] __device__(int i) {
+        return active_ptr[i] && in_lower(alpha_ptr[i], y[i], C)
+                 ? f_ptr[i]
+                 : math_t(-INFINITY);
+      },
+      math_t(-INFINITY), thrust::maximum<math_t>());
+
+    MLCommon::device_buffer<bool> new_active(handle.getDeviceAllocator(),
+                                             stream, n_train);
+    thrust::device_ptr<bool> new_ptr(new_active.data());
+    thrust::transform(policy, first, last, new_ptr, [=] __device__(int i) {
+      math_t a = alpha_ptr[i];
+      bool upper = in_upper(a, y[i], C);
+      bool lower = in_lower(a, y[i], C);
+      bool shrunk = (upper && !lower && f_ptr[i] > f_low) ||
+                    (lower && !upper && f_ptr[i] < f_up);
+      return active_ptr[i] && !shrunk;
+    });
+    int n = thrust::count(policy, new_ptr, new_ptr + n_train, true);
+    if (n < n_ws || n == n_active) return;
+    n_active = n;
+    MLCommon::copy(active.data(), new_active.data(), n_train, stream);
+    thrust::device_ptr<int> idx_ptr(active_idx.data());
+    thrust::copy_if(policy, first, last, new_ptr, idx_ptr,
+                    thrust::identity<bool>());
+    if (verbose) {
+      std::cout << "SMO shrinking: " << n_active << " of " << n_train
+                << " variables are active\n";
+    }
+  }
+
+  /**
+   * Reconstruct the f values of all the variables, and make all of them
+   * active again.
+   *
+   * @param [in] x training vectors in column major format
+   * @param [in] y labels of the dual variables, size [n_train]
+   */
+  void Unshrink(const math_t *x, const math_t *y) {
+    int n_train = svmType == EPSILON_SVR ? 2 * n_rows : n_rows;
+    ReconstructF(x, y, f_base.data());
+    thrust::device_ptr<bool> active_ptr(active.data());
+    thrust::fill(thrust::cuda::par.on(stream), active_ptr,
+                 active_ptr + n_train, true);
+    n_active = n_train;
+  }
+
+  /**
+   * Calculate f = f0 + K (alpha * y) from the current dual coefficients,
+   * where f0 is f at alpha = 0. The kernel rows are evaluated for the
+   * training vectors with nonzero coefficient.
+   *
+   * @param [in] x training vectors in column major format
+   * @param [in] y labels of the dual variables, size [n_train]
+   * @param [in] f0 f at alpha = 0, size [n_train], it can be f itself
+   */
+  void ReconstructF(const math_t *x, const math_t *y, const math_t *f0) {
+    int n_rows = this->n_rows;
+    auto allocator = handle.getDeviceAllocator();
+    auto policy = thrust::cuda::par.on(stream);
+    // coefficient of a training vector, summed over its dual variables
+    MLCommon::device_buffer<math_t> coef(allocator, stream, n_rows);
+    const math_t *alpha_ptr = alpha.data();
+    bool svr = svmType == EPSILON_SVR;
+    MLCommon::LinAlg::binaryOp(
+      coef.data(), alpha_ptr, y, n_rows,
+      [] __device__(math_t a, math_t y) { return a * y; }, stream);
+    if (svr) {
+      math_t *coef_ptr = coef.data();
+      thrust::for_each(policy, thrust::make_counting_iterator(0),
+                       thrust::make_counting_iterator(n_rows),
+                       [=] __device__(int i) {
+                         coef_ptr[i] += alpha_ptr[i + n_rows] * y[i + n_rows];
+                       });
+    }
+    MLCommon::device_buffer<int> idx(allocator, stream, n_rows);
+    MLCommon::device_buffer<math_t> coef_nz(allocator, stream, n_rows);
+    thrust::device_ptr<math_t> coef_ptr(coef.data());
+    thrust::device_ptr<int> idx_ptr(idx.data());
+    auto first = thrust::make_counting_iterator(0);
+    auto idx_end =
+      thrust::copy_if(policy, first, first + n_rows, coef_ptr, idx_ptr,
+                      [] __device__(math_t c) { return c != 0; });
+    int n_nz = idx_end - idx_ptr;
+    thrust::device_ptr<math_t> coef_nz_ptr(coef_nz.data());
+    thrust::copy_if(policy, coef_ptr, coef_ptr + n_rows, coef_nz_ptr,
+                    [] __device__(math_t c) { return c != 0; });
+
+    MLCommon::device_buffer<math_t> kf(allocator, stream, n_rows);
+    CUDA_CHECK(
+      cudaMemsetAsync(kf.data(), 0, n_rows * sizeof(math_t), stream));
+    KernelProduct(x, idx.data(), coef_nz.data(), n_nz, kf.data());
+    MLCommon::LinAlg::add(f.data(), f0, kf.data(), n_rows, stream);
+    if (svr) {
+      MLCommon::LinAlg::add(f.data() + n_rows, f0 + n_rows, kf.data(), n_rows,
+                            stream);
+    }
+  }
+
+  /**
+   * Set the initial dual coefficients from the ones given to SetWarmStart.
+   *
+   * alpha_i = clip(dual_coef_i * y_i, 0, C), for both dual variables of a
+   * training vector for EPSILON_SVR. If the clipping (or changed labels)
+   * break the constraint sum_i y_i alpha_i = 0, then the coefficients of the
+   * class with the larger sum are scaled down to restore it. Finally f is
+   * calculated for these coefficients.
+   *
+   * @param [in] x training vectors in column major format
+   * @param [in] y labels of the dual variables, size [n_train]
+   */
+  void WarmStart(const math_t *x, const math_t *y) {
+    ASSERT(svmType != ONE_CLASS,
+           "Warm start is not supported for the one-class SVM");
+    int n_train = svmType == EPSILON_SVR ? 2 * n_rows : n_rows;
+    int n_rows = this->n_rows;
+    math_t C = this->C;
+    bool svr = svmType == EPSILON_SVR;
+    math_t *alpha_ptr = alpha.data();
+    const math_t *coefs = warm_coefs;
+    const int *idx = warm_idx;
+    auto policy = thrust::cuda::par.on(stream);
+    auto first = thrust::make_counting_iterator(0);
+    thrust::for_each(policy, first, first + n_warm, [=] __device__(int i) {
+      int k = idx[i];
+      alpha_ptr[k] = min(max(coefs[i] * y[k], math_t(0)), C);
+      if (svr) {
+        k += n_rows;
+        alpha_ptr[k] = min(max(coefs[i] * y[k], math_t(0)), C);
+      }
+    });
+    math_t sum_pos = thrust::transform_reduce(
+      policy, first, first + n_train,
+      [=] __device__(int i) { return y[i] > 0 ? alpha_ptr[i] : math_t(0); },
+      math_t(0), thrust::plus<math_t>());
+    math_t sum_neg = thrust::transform_reduce(
+      policy, first, first + n_train,
+      [=] __device__(int i) { return y[i] < 0 ? alpha_ptr[i] : math_t(0); },
+      math_t(0), thrust::plus<math_t>());
+    if (sum_pos != sum_neg) {
+      math_t scale_pos = sum_pos > sum_neg ? sum_neg / sum_pos : 1;
+      math_t scale_neg = sum_neg > sum_pos ? sum_pos / sum_neg : 1;
+      thrust::for_each(policy, first, first + n_train, [=] __device__(int i) {
+        alpha_ptr[i] *= y[i] > 0 ? scale_pos : scale_neg;
+      });
+    }
+    ReconstructF(x, y, f.data());
   }
 
  private:
@@ -213,6 +695,8 @@ class SmoSolver {
   // Buffers for the domain [n_rows]
   MLCommon::device_buffer<math_t> alpha;  //!< dual coordinates
   MLCommon::device_buffer<math_t> f;      //!< optimality indicator vector
+  //! labels of the dual variables for EPSILON_SVR and ONE_CLASS
+  MLCommon::device_buffer<math_t> y_train;
 
   // Buffers for the working set [n_ws]
   //! change in alpha parameter during a blocksolve step
@@ -221,13 +705,33 @@ class SmoSolver {
   // Buffers to return some parameters from the kernel (iteration number, and
   // convergence information)
   MLCommon::device_buffer<math_t> return_buff;
-  math_t host_return_buff[2];
+  std::vector<math_t> host_return_buff;
 
   math_t C;
   math_t tol;  //!< tolerance for stopping condition
 
+  SvmType svmType;
+  math_t epsilon;  //!< insensitive tube of EPSILON_SVR
+  math_t nu;       //!< fraction of outliers of ONE_CLASS
+
   MLCommon::Matrix::GramMatrixBase<math_t> *kernel;
   float cache_size;  //!< size of kernel cache in MiB
+  KernelCache<math_t> *shared_cache = nullptr;  //!< see SetSharedCache
+  const int *shared_row_idx = nullptr;
+  //! dual coefficients and their indices to start from, see SetWarmStart
+  const math_t *warm_coefs = nullptr;
+  const int *warm_idx = nullptr;
+  int n_warm = 0;
+  //! the training vectors in CSR format, during a Solve with sparse input
+  const MLCommon::Matrix::CsrMatrix<math_t> *csr_x = nullptr;
+
+  // Buffers of the shrinking heuristic [n_train]
+  MLCommon::device_buffer<math_t> f_base;   //!< f at alpha = 0
+  MLCommon::device_buffer<bool> active;     //!< variables that are not shrunk
+  MLCommon::device_buffer<int> active_idx;  //!< indices of active variables
+  int n_active = 0;  //!< number of active variables
+
+  const int TPB = 256;  //!< threads per block for kernels launched
 
   // Variables to track convergence of training
   math_t diff_prev;
@@ -264,20 +768,38 @@ class SmoSolver {
     return keep_going;
   }
 
-  void ResizeBuffers(int n_rows, int n_cols, int n_ws) {
+  void ResizeBuffers(int n_rows, int n_cols, int n_ws, int n_blocks,
+                     bool shrink) {
     // This needs to know n_ws, therefore it can be only called during the solve step
     this->n_rows = n_rows;
     this->n_cols = n_cols;
     this->n_ws = n_ws;
-    alpha.resize(n_rows, stream);
-    f.resize(n_rows, stream);
+    int n_train = svmType == EPSILON_SVR ? 2 * n_rows : n_rows;
+    alpha.resize(n_train, stream);
+    f.resize(n_train, stream);
     delta_alpha.resize(n_ws, stream);
+    return_buff.resize(2 * n_blocks, stream);
+    host_return_buff.resize(2 * n_blocks);
+    if (svmType != C_SVC) y_train.resize(n_train, stream);
+    n_active = n_train;
+    if (shrink) {
+      f_base.resize(n_train, stream);
+      active.resize(n_train, stream);
+      active_idx.resize(n_train, stream);
+      thrust::device_ptr<bool> active_ptr(active.data());
+      thrust::fill(thrust::cuda::par.on(stream), active_ptr,
+                   active_ptr + n_train, true);
+    }
   }
 
   void ReleaseBuffers() {
     alpha.release(stream);
     delta_alpha.release(stream);
     f.release(stream);
+    y_train.release(stream);
+    f_base.release(stream);
+    active.release(stream);
+    active_idx.release(stream);
   }
 };
 
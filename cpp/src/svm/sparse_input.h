@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+/** @file sparse_input.h
+ * @brief Helpers to access the training vectors of the SVM, that are either
+ * dense in column major format, or sparse in CSR format.
+ */
+
+#include "common/cumlHandle.hpp"
+#include "matrix/grammatrix.h"
+#include "matrix/matrix.h"
+#include "sparse/csr.h"
+
+namespace ML {
+namespace SVM {
+
+/**
+ * Collect training vectors into a dense matrix.
+ *
+ * @param [in] x dense training vectors in column major format, size
+ *   [n_rows x n_cols], unused if csr is given
+ * @param [in] csr training vectors in CSR format, or nullptr
+ * @param [in] n_rows number of training vectors
+ * @param [in] n_cols number of features
+ * @param [in] idx indices of the vectors to collect, size [n]
+ * @param [in] n number of vectors to collect
+ * @param [out] out the collected vectors in column major format,
+ *   size [n x n_cols]
+ * @param [in] stream cuda stream
+ */
+template <typename math_t>
+void collectRows(const math_t *x,
+                 const MLCommon::Matrix::CsrMatrix<math_t> *csr, int n_rows,
+                 int n_cols, const int *idx, int n, math_t *out,
+                 cudaStream_t stream) {
+  if (csr) {
+    MLCommon::Sparse::csr_to_dense_rows(csr->row_ptr, csr->col_ind, csr->vals,
+                                        idx, n, n_cols, out, stream);
+  } else {
+    MLCommon::Matrix::copyRows(x, n_rows, n_cols, out, idx, n, stream, false);
+  }
+}
+
+/**
+ * Evaluate the kernel function between all the training vectors and a dense
+ * vector set: out[j + k * n_rows] = K(x_j, x2_k).
+ *
+ * @param [in] handle cuML handle implementation
+ * @param [in] kernel kernel function
+ * @param [in] x dense training vectors in column major format, size
+ *   [n_rows x n_cols], unused if csr is given
+ * @param [in] csr training vectors in CSR format, or nullptr
+ * @param [in] n_rows number of training vectors
+ * @param [in] n_cols number of features
+ * @param [in] x2 dense vectors in column major format, size [n2 x n_cols]
+ * @param [in] n2 number of vectors in x2
+ * @param [out] out kernel matrix in column major format, size [n_rows x n2]
+ * @param [in] stream cuda stream
+ */
+template <typename math_t>
+void kernelRows(const cumlHandle_impl &handle,
+                MLCommon::Matrix::GramMatrixBase<math_t> *kernel,
+                const math_t *x,
+                const MLCommon::Matrix::CsrMatrix<math_t> *csr, int n_rows,
+                int n_cols, const math_t *x2, int n2, math_t *out,
+                cudaStream_t stream) {
+  if (csr) {
+    kernel->evaluateCsr(*csr, x2, n2, out, handle.getcusparseHandle(),
+                        handle.getDeviceAllocator(), stream, n2, n_rows);
+  } else {
+    (*kernel)(x, n_rows, n_cols, x2, n2, out, stream);
+  }
+}
+
+};  // namespace SVM
+};  // namespace ML
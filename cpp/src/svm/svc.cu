@@ -56,10 +56,87 @@ template void svcPredict<double>(const cumlHandle &handle, double *input,
                                  const svmModel<double> &model, double *preds,
                                  double buffer_size, bool predict_class);
 
+template void svcFitSparse<float>(const cumlHandle &handle, int *indptr,
+                                  int *indices, float *data, int nnz,
+                                  int n_rows, int n_cols, float *labels,
+                                  const svmParameter &param,
+                                  MLCommon::Matrix::KernelParams &kernel_params,
+                                  svmModel<float> &model);
+
+template void svcFitSparse<double>(
+  const cumlHandle &handle, int *indptr, int *indices, double *data, int nnz,
+  int n_rows, int n_cols, double *labels, const svmParameter &param,
+  MLCommon::Matrix::KernelParams &kernel_params, svmModel<double> &model);
+
+template void svcPredictSparse<float>(
+  const cumlHandle &handle, int *indptr, int *indices, float *data, int nnz,
+  int n_rows, int n_cols, MLCommon::Matrix::KernelParams &kernel_params,
+  const svmModel<float> &model, float *preds, float buffer_size,
+  bool predict_class);
+
+template void svcPredictSparse<double>(
+  const cumlHandle &handle, int *indptr, int *indices, double *data, int nnz,
+  int n_rows, int n_cols, MLCommon::Matrix::KernelParams &kernel_params,
+  const svmModel<double> &model, double *preds, double buffer_size,
+  bool predict_class);
+
 template void svmFreeBuffers(const cumlHandle &handle, svmModel<float> &m);
 
 template void svmFreeBuffers(const cumlHandle &handle, svmModel<double> &m);
 
+template void svcFitWarmStart<float>(
+  const cumlHandle &handle, float *input, int n_rows, int n_cols,
+  float *labels, const svmParameter &param,
+  MLCommon::Matrix::KernelParams &kernel_params,
+  const svmModel<float> &warm_start, svmModel<float> &model);
+
+template void svcFitWarmStart<double>(
+  const cumlHandle &handle, double *input, int n_rows, int n_cols,
+  double *labels, const svmParameter &param,
+  MLCommon::Matrix::KernelParams &kernel_params,
+  const svmModel<double> &warm_start, svmModel<double> &model);
+
+template void svmSave(const cumlHandle &handle, const svmModel<float> &model,
+                      std::vector<char> *pbytes);
+
+template void svmSave(const cumlHandle &handle, const svmModel<double> &model,
+                      std::vector<char> *pbytes);
+
+template void svmLoad(const cumlHandle &handle, svmModel<float> &model,
+                      const void *bytes, size_t size);
+
+template void svmLoad(const cumlHandle &handle, svmModel<double> &model,
+                      const void *bytes, size_t size);
+
+template void svcFitMultiClass<float>(
+  const cumlHandle &handle, float *input, int n_rows, int n_cols,
+  float *labels, const svmParameter &param,
+  MLCommon::Matrix::KernelParams &kernel_params,
+  svmMultiClassModel<float> &model);
+
+template void svcFitMultiClass<double>(
+  const cumlHandle &handle, double *input, int n_rows, int n_cols,
+  double *labels, const svmParameter &param,
+  MLCommon::Matrix::KernelParams &kernel_params,
+  svmMultiClassModel<double> &model);
+
+template void svcPredictMultiClass<float>(
+  const cumlHandle &handle, float *input, int n_rows, int n_cols,
+  MLCommon::Matrix::KernelParams &kernel_params,
+  const svmMultiClassModel<float> &model, float *preds, float buffer_size);
+
+template void svcPredictMultiClass<double>(
+  const cumlHandle &handle, double *input, int n_rows, int n_cols,
+  MLCommon::Matrix::KernelParams &kernel_params,
+  const svmMultiClassModel<double> &model, double *preds,
+  double buffer_size);
+
+template void svmFreeBuffers(const cumlHandle &handle,
+                             svmMultiClassModel<float> &m);
+
+template void svmFreeBuffers(const cumlHandle &handle,
+                             svmMultiClassModel<double> &m);
+
 template <typename math_t>
 SVC<math_t>::SVC(cumlHandle &handle, math_t C, math_t tol,
                  Matrix::KernelParams kernel_params, math_t cache_size,
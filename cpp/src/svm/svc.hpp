@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cublas_v2.h>
+#include <vector>
 #include "common/cumlHandle.hpp"
 #include "matrix/kernelparams.h"
 #include "svm_model.h"
@@ -51,6 +52,52 @@ void svcFit(const cumlHandle &handle, math_t *input, int n_rows, int n_cols,
             MLCommon::Matrix::KernelParams &kernel_params,
             svmModel<math_t> &model);
 
+/**
+ * @brief Fit a support vector classifier, starting from the dual
+ * coefficients of a previously trained model.
+ *
+ * Same as svcFit, except that the SMO solver starts from the dual
+ * coefficients of warm_start (clipped to [0, C], and rescaled to fulfill the
+ * equality constraint if needed) instead of zero. This cuts the number of
+ * iterations when a model is retrained on slightly changed data.
+ *
+ * @param [in] warm_start previous binary model with the same classes and
+ *   n_cols. Its support_idx shall refer to the rows of input.
+ */
+template <typename math_t>
+void svcFitWarmStart(const cumlHandle &handle, math_t *input, int n_rows,
+                     int n_cols, math_t *labels, const svmParameter &param,
+                     MLCommon::Matrix::KernelParams &kernel_params,
+                     const svmModel<math_t> &warm_start,
+                     svmModel<math_t> &model);
+
+/**
+ * @brief Fit a support vector classifier to sparse training data.
+ *
+ * Same as svcFit, but the input data is in CSR format. The support vectors of
+ * the model are stored as dense vectors.
+ *
+ * @tparam math_t floating point type
+ * @param [in] handle the cuML handle
+ * @param [in] indptr device pointer for the CSR row offsets of the input
+ *   data, size [n_rows + 1]
+ * @param [in] indices device pointer for the CSR column indices, size [nnz]
+ * @param [in] data device pointer for the CSR values, size [nnz]
+ * @param [in] nnz number of stored values
+ * @param [in] n_rows number of rows
+ * @param [in] n_cols number of colums
+ * @param [in] labels device pointer for the labels. Size [n_rows].
+ * @param [in] param parameters for training
+ * @param [in] kernel_params parameters for the kernel function
+ * @param [out] model parameters of the trained model
+ */
+template <typename math_t>
+void svcFitSparse(const cumlHandle &handle, int *indptr, int *indices,
+                  math_t *data, int nnz, int n_rows, int n_cols,
+                  math_t *labels, const svmParameter &param,
+                  MLCommon::Matrix::KernelParams &kernel_params,
+                  svmModel<math_t> &model);
+
 /**
  * @brief Predict classes or decision function value for samples in input.
  *
@@ -84,6 +131,19 @@ void svcPredict(const cumlHandle &handle, math_t *input, int n_rows, int n_cols,
                 const svmModel<math_t> &model, math_t *preds,
                 math_t buffer_size, bool predict_class = true);
 
+/**
+ * @brief Predict classes or decision function value for sparse samples.
+ *
+ * Same as svcPredict, but the input data is in CSR format: indptr (size
+ * [n_rows + 1]), indices and data (size [nnz]) are device pointers.
+ */
+template <typename math_t>
+void svcPredictSparse(const cumlHandle &handle, int *indptr, int *indices,
+                      math_t *data, int nnz, int n_rows, int n_cols,
+                      MLCommon::Matrix::KernelParams &kernel_params,
+                      const svmModel<math_t> &model, math_t *preds,
+                      math_t buffer_size, bool predict_class = true);
+
 /**
  * Deallocate device buffers in the svmModel struct.
  *
@@ -93,6 +153,91 @@ void svcPredict(const cumlHandle &handle, math_t *input, int n_rows, int n_cols,
 template <typename math_t>
 void svmFreeBuffers(const cumlHandle &handle, svmModel<math_t> &m);
 
+/**
+ * @brief Save an SVM model (classifier or regressor) in a flat binary
+ * format, which uses the byte order and type sizes of the host.
+ *
+ * @param [in] handle the cuML handle
+ * @param [in] model the model to save
+ * @param [out] pbytes the saved model; its previous contents are replaced
+ */
+template <typename math_t>
+void svmSave(const cumlHandle &handle, const svmModel<math_t> &model,
+             std::vector<char> *pbytes);
+
+/**
+ * @brief Load an SVM model saved by svmSave for the same math_t.
+ *
+ * The buffers of the model shall be unallocated on entry, free them with
+ * svmFreeBuffers.
+ *
+ * @param [in] handle the cuML handle
+ * @param [out] model the loaded model
+ * @param [in] bytes the saved model
+ * @param [in] size size of bytes, in bytes
+ */
+template <typename math_t>
+void svmLoad(const cumlHandle &handle, svmModel<math_t> &model,
+             const void *bytes, size_t size);
+
+/**
+ * @brief Fit a one-vs-one multi-class support vector classifier.
+ *
+ * A binary classifier is fitted for each pair of classes. The sub-problems
+ * share a kernel cache keyed by the index of the training vectors in the full
+ * training set, so that kernel rows are not recomputed for every pair.
+ *
+ * The output buffers in model shall be unallocated on entry.
+ *
+ * @tparam math_t floating point type
+ * @param [in] handle the cuML handle
+ * @param [in] input device pointer for the input data in column major format.
+ *   Size n_rows x n_cols.
+ * @param [in] n_rows number of rows
+ * @param [in] n_cols number of colums
+ * @param [in] labels device pointer for the labels. Size [n_rows].
+ * @param [in] param parameters for training
+ * @param [in] kernel_params parameters for the kernel function
+ * @param [out] model parameters of the trained model
+ */
+template <typename math_t>
+void svcFitMultiClass(const cumlHandle &handle, math_t *input, int n_rows,
+                      int n_cols, math_t *labels, const svmParameter &param,
+                      MLCommon::Matrix::KernelParams &kernel_params,
+                      svmMultiClassModel<math_t> &model);
+
+/**
+ * @brief Predict classes with a one-vs-one multi-class classifier, the class
+ * with the most votes of the binary models.
+ *
+ * @tparam math_t floating point type
+ * @param handle the cuML handle
+ * @param [in] input device pointer for the input data in column major format,
+ *   size [n_rows x n_cols].
+ * @param [in] n_rows number of rows (input vectors)
+ * @param [in] n_cols number of colums (features)
+ * @param [in] kernel_params parameters for the kernel function
+ * @param [in] model multi-class SVM model parameters
+ * @param [out] preds device pointer to store the predicted class labels.
+ *    Size [n_rows]. Should be allocated on entry.
+ * @param [in] buffer_size size of temporary buffer in MiB
+ */
+template <typename math_t>
+void svcPredictMultiClass(const cumlHandle &handle, math_t *input, int n_rows,
+                          int n_cols,
+                          MLCommon::Matrix::KernelParams &kernel_params,
+                          const svmMultiClassModel<math_t> &model,
+                          math_t *preds, math_t buffer_size = 200);
+
+/**
+ * Deallocate the buffers of a multi-class model.
+ *
+ * @param [in] handle cuML handle
+ * @param [inout] m multi-class SVM model parameters
+ */
+template <typename math_t>
+void svmFreeBuffers(const cumlHandle &handle, svmMultiClassModel<math_t> &m);
+
 /**
  * @brief C-Support Vector Classification
  *
@@ -20,11 +20,14 @@
  * classifier, and predict with it.
  */
 
+#include <string.h>
 #include <iostream>
+#include <vector>
 
 #include <cublas_v2.h>
 #include <thrust/copy.h>
 #include <thrust/device_ptr.h>
+#include <thrust/for_each.h>
 #include <thrust/iterator/counting_iterator.h>
 #include "common/cumlHandle.hpp"
 #include "common/device_buffer.hpp"
@@ -42,31 +45,20 @@ namespace ML {
 namespace SVM {
 
 /**
- * @brief Fit a support vector classifier to the training data.
- *
- * Each row of the input data stores a feature vector.
- * We use the SMO method to fit the SVM.
- *
- * The output dbuffers shall be unallocated on entry.
- * Note that n_support, n_classes and b are host scalars, all other output
- * pointers are device pointers.
- *
- * @tparam math_t floating point type
- * @param [in] handle the cuML handle
- * @param [in] input device pointer for the input data in column major format.
- *   Size n_rows x n_cols.
- * @param [in] n_rows number of rows
- * @param [in] n_cols number of colums
- * @param [in] labels device pointer for the labels. Size n_rows.
- * @param [in] param parameters for training
- * @param [in] kernel_params parameters for the kernel function
- * @param [out] model parameters of the trained model
+ * @brief Fit a support vector classifier to dense (input) or sparse (csr, if
+ * it is not nullptr) training data, see svcFit. The solver starts from the
+ * dual coefficients of warm_start, if it is not nullptr, see svcFitWarmStart.
  */
 template <typename math_t>
-void svcFit(const cumlHandle &handle, math_t *input, int n_rows, int n_cols,
-            math_t *labels, const svmParameter &param,
-            MLCommon::Matrix::KernelParams &kernel_params,
-            svmModel<math_t> &model) {
+void svcFitInput(const cumlHandle &handle, math_t *input,
+                 const MLCommon::Matrix::CsrMatrix<math_t> *csr, int n_rows,
+                 int n_cols, math_t *labels, const svmParameter &param,
+                 MLCommon::Matrix::KernelParams &kernel_params,
+                 svmModel<math_t> &model,
+                 const svmModel<math_t> *warm_start = nullptr) {
+  ML::detail::phaseScope range(handle.getImpl(), "ML::Svm::SvcFit",
+                               "rows=%d cols=%d sparse=%d", n_rows, n_cols,
+                               int(csr != nullptr));
   ASSERT(n_cols > 0,
          "Parameter n_cols: number of columns cannot be less than one");
   ASSERT(n_rows > 0,
@@ -83,7 +75,19 @@ void svcFit(const cumlHandle &handle, math_t *input, int n_rows, int n_cols,
                                    handle_impl.getDeviceAllocator());
 
   ASSERT(model.n_classes == 2,
-         "Only binary classification is implemented at the moment");
+         "Only binary classification is implemented by svcFit, use "
+         "svcFitMultiClass for more classes");
+
+  if (warm_start) {
+    ASSERT(warm_start->n_classes == 2 && warm_start->n_cols == n_cols,
+           "The warm start model shall be a binary model with n_cols features");
+    math_t labels_new[2], labels_old[2];
+    MLCommon::updateHost(labels_new, model.unique_labels, 2, stream);
+    MLCommon::updateHost(labels_old, warm_start->unique_labels, 2, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    ASSERT(labels_new[0] == labels_old[0] && labels_new[1] == labels_old[1],
+           "The warm start model shall have the same classes");
+  }
 
   MLCommon::device_buffer<math_t> y(handle_impl.getDeviceAllocator(), stream,
                                     n_rows);
@@ -96,96 +100,208 @@ void svcFit(const cumlHandle &handle, math_t *input, int n_rows, int n_cols,
   SmoSolver<math_t> smo(handle_impl, param.C, param.tol, kernel,
                         param.cache_size, param.nochange_steps);
   smo.verbose = param.verbose;
-  smo.Solve(input, n_rows, n_cols, y.data(), &(model.dual_coefs),
-            &(model.n_support), &(model.x_support), &(model.support_idx),
-            &(model.b), param.max_iter);
+  smo.ws_size = param.ws_size;
+  smo.shrinking = param.shrinking;
+  if (warm_start) {
+    smo.SetWarmStart(warm_start->dual_coefs, warm_start->support_idx,
+                     warm_start->n_support);
+  }
+  if (csr) {
+    smo.Solve(*csr, y.data(), &(model.dual_coefs), &(model.n_support),
+              &(model.x_support), &(model.support_idx), &(model.b),
+              param.max_iter);
+  } else {
+    smo.Solve(input, n_rows, n_cols, y.data(), &(model.dual_coefs),
+              &(model.n_support), &(model.x_support), &(model.support_idx),
+              &(model.b), param.max_iter);
+  }
   model.n_cols = n_cols;
   delete kernel;
 }
 
 /**
- * @brief Predict classes or decision function value for samples in input.
+ * @brief Fit a support vector classifier to the training data.
  *
- * We evaluate the decision function f(x_i). Depending on the parameter
- * predict_class, we either return f(x_i) or the label corresponding to
- * sign(f(x_i)).
+ * Each row of the input data stores a feature vector.
+ * We use the SMO method to fit the SVM.
  *
- * The predictions are calculated according to the following formula:
- * f(x_i) = \sum_{j=1}^n_support K(x_i, x_j) * dual_coefs[j] + b)
+ * The output dbuffers shall be unallocated on entry.
+ * Note that n_support, n_classes and b are host scalars, all other output
+ * pointers are device pointers.
  *
- * pred(x_i) = label[sign(f(x_i))], if predict_class==true, or
- * pred(x_i) = f(x_i),       if predict_class==false
+ * @tparam math_t floating point type
+ * @param [in] handle the cuML handle
+ * @param [in] input device pointer for the input data in column major format.
+ *   Size n_rows x n_cols.
+ * @param [in] n_rows number of rows
+ * @param [in] n_cols number of colums
+ * @param [in] labels device pointer for the labels. Size n_rows.
+ * @param [in] param parameters for training
+ * @param [in] kernel_params parameters for the kernel function
+ * @param [out] model parameters of the trained model
+ */
+template <typename math_t>
+void svcFit(const cumlHandle &handle, math_t *input, int n_rows, int n_cols,
+            math_t *labels, const svmParameter &param,
+            MLCommon::Matrix::KernelParams &kernel_params,
+            svmModel<math_t> &model) {
+  svcFitInput(handle, input, (MLCommon::Matrix::CsrMatrix<math_t> *)nullptr,
+              n_rows, n_cols, labels, param, kernel_params, model);
+}
+
+/**
+ * @brief Fit a support vector classifier, starting from the dual
+ * coefficients of a previously trained model.
  *
- * We process the input vectors batchwise, and evaluate the full rows of kernel
- * matrix K(x_i, x_j) for a batch (size n_batch * n_support). The maximum size
- * of this buffer (i.e. the maximum batch_size) is controlled by the
- * buffer_size input parameter. For models where n_support is large, increasing
- * buffer_size might improve prediction performance.
+ * This is useful to retrain a model on slightly changed data: the dual
+ * coefficients of warm_start are clipped to [0, C], rescaled to fulfill the
+ * equality constraint if needed, and the SMO solver starts from them.
+ *
+ * The parameters are the same as for svcFit, and
+ * @param [in] warm_start previous binary model with the same classes and
+ *   n_cols. Its support_idx shall refer to the rows of input, e.g. the model
+ *   was trained on a training set whose rows are kept at the same positions.
+ */
+template <typename math_t>
+void svcFitWarmStart(const cumlHandle &handle, math_t *input, int n_rows,
+                     int n_cols, math_t *labels, const svmParameter &param,
+                     MLCommon::Matrix::KernelParams &kernel_params,
+                     const svmModel<math_t> &warm_start,
+                     svmModel<math_t> &model) {
+  svcFitInput(handle, input, (MLCommon::Matrix::CsrMatrix<math_t> *)nullptr,
+              n_rows, n_cols, labels, param, kernel_params, model,
+              &warm_start);
+}
+
+/**
+ * @brief Fit a support vector classifier to sparse training data.
+ *
+ * The kernel function is evaluated by sparse matrix - dense matrix products
+ * between the training vectors and the working set. The support vectors of
+ * the model are stored as dense vectors.
  *
  * @tparam math_t floating point type
- * @param handle the cuML handle
- * @param [in] input device pointer for the input data in column major format,
- *   size [n_rows x n_cols].
- * @param [in] n_rows number of rows (input vectors)
- * @param [in] n_cols number of colums (features)
+ * @param [in] handle the cuML handle
+ * @param [in] indptr device pointer for the CSR row offsets of the input
+ *   data, size [n_rows + 1]
+ * @param [in] indices device pointer for the CSR column indices, size [nnz]
+ * @param [in] data device pointer for the CSR values, size [nnz]
+ * @param [in] nnz number of stored values
+ * @param [in] n_rows number of rows
+ * @param [in] n_cols number of colums
+ * @param [in] labels device pointer for the labels. Size n_rows.
+ * @param [in] param parameters for training
  * @param [in] kernel_params parameters for the kernel function
- * @param [in] model SVM model parameters
- * @param [out] preds device pointer to store the output, size [n_rows].
- *     Should be allocated on entry.
- * @param [in] buffer_size size of temporary buffer in MiB
- * @param [in] predict_class whether to predict class label (true), or just
- *     return the decision function value (false)
+ * @param [out] model parameters of the trained model
  */
 template <typename math_t>
-void svcPredict(const cumlHandle &handle, math_t *input, int n_rows, int n_cols,
-                MLCommon::Matrix::KernelParams &kernel_params,
-                const svmModel<math_t> &model, math_t *preds,
-                math_t buffer_size, bool predict_class) {
+void svcFitSparse(const cumlHandle &handle, int *indptr, int *indices,
+                  math_t *data, int nnz, int n_rows, int n_cols,
+                  math_t *labels, const svmParameter &param,
+                  MLCommon::Matrix::KernelParams &kernel_params,
+                  svmModel<math_t> &model) {
+  MLCommon::Matrix::CsrMatrix<math_t> csr{indptr, indices, data,
+                                          nnz,    n_rows,  n_cols};
+  svcFitInput(handle, (math_t *)nullptr, &csr, n_rows, n_cols, labels, param,
+              kernel_params, model);
+}
+
+/**
+ * @brief Predict for dense (input) or sparse (csr, if it is not nullptr)
+ * samples, see svcPredict.
+ */
+template <typename math_t>
+void svcPredictInput(const cumlHandle &handle, math_t *input,
+                     const MLCommon::Matrix::CsrMatrix<math_t> *csr,
+                     int n_rows, int n_cols,
+                     MLCommon::Matrix::KernelParams &kernel_params,
+                     const svmModel<math_t> &model, math_t *preds,
+                     math_t buffer_size, bool predict_class) {
+  ML::detail::phaseScope range(handle.getImpl(), "ML::Svm::SvcPredict",
+                               "rows=%d cols=%d sparse=%d", n_rows, n_cols,
+                               int(csr != nullptr));
   ASSERT(n_cols == model.n_cols,
          "Parameter n_cols: shall be the same that was used for fitting");
   // We might want to query the available memory before selecting the batch size.
-  // We will need n_batch * n_support floats for the kernel matrix K.
+  // We will need n_batch * n_sv_batch floats for the kernel matrix K.
   const int N_PRED_BATCH = 4096;
+  // Fewest input rows per batch before we tile over the support vectors too
+  const int N_PRED_MIN_BATCH = 256;
   int n_batch = N_PRED_BATCH < n_rows ? N_PRED_BATCH : n_rows;
+  int n_sv_batch = model.n_support;
 
   // Limit the memory size of the prediction buffer
-  buffer_size = buffer_size * 1024 * 1024;
-  if (n_batch * model.n_support * sizeof(math_t) > buffer_size) {
-    n_batch = buffer_size / (model.n_support * sizeof(math_t));
-    if (n_batch < 1) n_batch = 1;
+  size_t buffer_len = buffer_size * 1024 * 1024 / sizeof(math_t);
+  if ((size_t)n_batch * n_sv_batch > buffer_len) {
+    n_batch = buffer_len / n_sv_batch;
+    int min_batch = min(N_PRED_MIN_BATCH, n_rows);
+    if (n_batch < min_batch) {
+      n_batch = min_batch;
+      n_sv_batch = max((size_t)1, buffer_len / n_batch);
+    }
   }
 
   const cumlHandle_impl &handle_impl = handle.getImpl();
   cudaStream_t stream = handle_impl.getStream();
 
   MLCommon::device_buffer<math_t> K(handle_impl.getDeviceAllocator(), stream,
-                                    n_batch * model.n_support);
+                                    n_batch * n_sv_batch);
   MLCommon::device_buffer<math_t> y(handle_impl.getDeviceAllocator(), stream,
                                     n_rows);
   MLCommon::device_buffer<math_t> x_rbf(handle_impl.getDeviceAllocator(),
                                         stream);
   MLCommon::device_buffer<int> idx(handle_impl.getDeviceAllocator(), stream);
+  MLCommon::device_buffer<math_t> sv_rbf(handle_impl.getDeviceAllocator(),
+                                         stream);
+  MLCommon::device_buffer<int> sv_idx(handle_impl.getDeviceAllocator(),
+                                      stream);
 
   cublasHandle_t cublas_handle = handle_impl.getCublasHandle();
 
   MLCommon::Matrix::GramMatrixBase<math_t> *kernel =
     MLCommon::Matrix::KernelFactory<math_t>::create(kernel_params,
                                                     cublas_handle);
-  if (kernel_params.kernel == MLCommon::Matrix::RBF) {
+  MLCommon::device_buffer<int> batch_row_ptr(handle_impl.getDeviceAllocator(),
+                                             stream);
+  if (csr) {
+    // Row offsets of the CSR batch, see below
+    batch_row_ptr.resize(n_batch + 1, stream);
+  } else if (kernel_params.kernel == MLCommon::Matrix::RBF) {
     // Temporary buffers for the RBF kernel, see below
     x_rbf.resize(n_batch * n_cols, stream);
     idx.resize(n_batch, stream);
+    if (n_sv_batch < model.n_support) {
+      sv_rbf.resize(n_sv_batch * n_cols, stream);
+      sv_idx.resize(n_sv_batch, stream);
+    }
   }
-  // We process the input data batchwise:
-  //  - calculate the kernel values K[x_batch, x_support]
-  //  - calculate y(x_batch) = K[x_batch, x_support] * dual_coeffs
+  // We process the input data batchwise, and within a batch, the support
+  // vectors in tiles of n_sv_batch:
+  //  - calculate the kernel values K[x_batch, x_sv_tile]
+  //  - accumulate y(x_batch) += K[x_batch, x_sv_tile] * dual_coeffs[sv_tile]
+  CUDA_CHECK(cudaMemsetAsync(y.data(), 0, n_rows * sizeof(math_t), stream));
   for (int i = 0; i < n_rows; i += n_batch) {
     if (i + n_batch >= n_rows) {
       n_batch = n_rows - i;
     }
     math_t *x_ptr = nullptr;
     int ld1 = 0;
-    if (kernel_params.kernel == MLCommon::Matrix::RBF) {
+    MLCommon::Matrix::CsrMatrix<math_t> batch;
+    if (csr) {
+      // The rows of the batch form a CSR matrix with the row offsets
+      // shifted to start at zero.
+      int offsets[2];
+      MLCommon::updateHost(offsets, csr->row_ptr + i, 1, stream);
+      MLCommon::updateHost(offsets + 1, csr->row_ptr + i + n_batch, 1, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+      int start = offsets[0];
+      MLCommon::LinAlg::unaryOp(
+        batch_row_ptr.data(), csr->row_ptr + i, n_batch + 1,
+        [start] __device__(int offset) { return offset - start; }, stream);
+      batch = MLCommon::Matrix::CsrMatrix<math_t>{
+        batch_row_ptr.data(), csr->col_ind + start, csr->vals + start,
+        offsets[1] - start,   n_batch,              n_cols};
+    } else if (kernel_params.kernel == MLCommon::Matrix::RBF) {
       // The RBF kernel does not support ld parameters (See issue #1172)
       // To come around this limitation, we copy the batch into a temporary
       // buffer.
@@ -201,13 +317,37 @@ void svcPredict(const cumlHandle &handle, math_t *input, int n_rows, int n_cols,
       x_ptr = input + i;
       ld1 = n_rows;
     }
-    kernel->evaluate(x_ptr, n_batch, n_cols, model.x_support, model.n_support,
-                     K.data(), stream, ld1, model.n_support, n_batch);
-    math_t one = 1;
-    math_t null = 0;
-    CUBLAS_CHECK(MLCommon::LinAlg::cublasgemv(
-      cublas_handle, CUBLAS_OP_N, n_batch, model.n_support, &one, K.data(),
-      n_batch, model.dual_coefs, 1, &null, y.data() + i, 1, stream));
+    for (int j = 0; j < model.n_support; j += n_sv_batch) {
+      int n_sv = min(n_sv_batch, model.n_support - j);
+      const math_t *sv_ptr = model.x_support + j;
+      int ld2 = model.n_support;
+      if (!csr && kernel_params.kernel == MLCommon::Matrix::RBF &&
+          n_sv < model.n_support) {
+        // Same as above, the RBF kernel needs a contiguous tile
+        thrust::counting_iterator<int> first(j);
+        thrust::device_ptr<int> idx_ptr(sv_idx.data());
+        thrust::copy(thrust::cuda::par.on(stream), first, first + n_sv,
+                     idx_ptr);
+        MLCommon::Matrix::copyRows(model.x_support, model.n_support, n_cols,
+                                   sv_rbf.data(), sv_idx.data(), n_sv, stream,
+                                   false);
+        sv_ptr = sv_rbf.data();
+        ld2 = n_sv;
+      }
+      if (csr) {
+        kernel->evaluateCsr(batch, sv_ptr, n_sv, K.data(),
+                            handle_impl.getcusparseHandle(),
+                            handle_impl.getDeviceAllocator(), stream, ld2,
+                            n_batch);
+      } else {
+        kernel->evaluate(x_ptr, n_batch, n_cols, sv_ptr, n_sv, K.data(),
+                         stream, ld1, ld2, n_batch);
+      }
+      math_t one = 1;
+      CUBLAS_CHECK(MLCommon::LinAlg::cublasgemv(
+        cublas_handle, CUBLAS_OP_N, n_batch, n_sv, &one, K.data(), n_batch,
+        model.dual_coefs + j, 1, &one, y.data() + i, 1, stream));
+    }
   }
   math_t *labels = model.unique_labels;
   math_t b = model.b;
@@ -229,6 +369,71 @@ void svcPredict(const cumlHandle &handle, math_t *input, int n_rows, int n_cols,
   delete kernel;
 }
 
+/**
+ * @brief Predict classes or decision function value for samples in input.
+ *
+ * We evaluate the decision function f(x_i). Depending on the parameter
+ * predict_class, we either return f(x_i) or the label corresponding to
+ * sign(f(x_i)).
+ *
+ * The predictions are calculated according to the following formula:
+ * f(x_i) = \sum_{j=1}^n_support K(x_i, x_j) * dual_coefs[j] + b)
+ *
+ * pred(x_i) = label[sign(f(x_i))], if predict_class==true, or
+ * pred(x_i) = f(x_i),       if predict_class==false
+ *
+ * We process the input vectors batchwise, and evaluate the full rows of kernel
+ * matrix K(x_i, x_j) for a batch (size n_batch * n_support). The maximum size
+ * of this buffer (i.e. the maximum batch_size) is controlled by the
+ * buffer_size input parameter. If the buffer would hold only a few rows, the
+ * support vectors are processed in tiles as well, and the decision function
+ * is accumulated over the tiles, so that the memory stays bounded for any
+ * n_support. For models where n_support is large, increasing buffer_size
+ * might improve prediction performance.
+ *
+ * @tparam math_t floating point type
+ * @param handle the cuML handle
+ * @param [in] input device pointer for the input data in column major format,
+ *   size [n_rows x n_cols].
+ * @param [in] n_rows number of rows (input vectors)
+ * @param [in] n_cols number of colums (features)
+ * @param [in] kernel_params parameters for the kernel function
+ * @param [in] model SVM model parameters
+ * @param [out] preds device pointer to store the output, size [n_rows].
+ *     Should be allocated on entry.
+ * @param [in] buffer_size size of temporary buffer in MiB
+ * @param [in] predict_class whether to predict class label (true), or just
+ *     return the decision function value (false)
+ */
+template <typename math_t>
+void svcPredict(const cumlHandle &handle, math_t *input, int n_rows, int n_cols,
+                MLCommon::Matrix::KernelParams &kernel_params,
+                const svmModel<math_t> &model, math_t *preds,
+                math_t buffer_size, bool predict_class) {
+  svcPredictInput(handle, input, (MLCommon::Matrix::CsrMatrix<math_t> *)nullptr,
+                  n_rows, n_cols, kernel_params, model, preds, buffer_size,
+                  predict_class);
+}
+
+/**
+ * @brief Predict classes or decision function value for sparse samples.
+ *
+ * See svcPredict, the input vectors are given here in CSR format: indptr
+ * (size [n_rows + 1]), indices and data (size [nnz]) are device pointers.
+ */
+template <typename math_t>
+void svcPredictSparse(const cumlHandle &handle, int *indptr, int *indices,
+                      math_t *data, int nnz, int n_rows, int n_cols,
+                      MLCommon::Matrix::KernelParams &kernel_params,
+                      const svmModel<math_t> &model, math_t *preds,
+                      math_t buffer_size, bool predict_class) {
+  MLCommon::Matrix::CsrMatrix<math_t> csr{indptr, indices, data,
+                                          nnz,    n_rows,  n_cols};
+  svcPredictInput(handle, (math_t *)nullptr, &csr, n_rows, n_cols,
+                  kernel_params, model, preds, buffer_size, predict_class);
+}
+
+
 template <typename math_t>
 void svmFreeBuffers(const cumlHandle &handle, svmModel<math_t> &m) {
   auto allocator = handle.getImpl().getDeviceAllocator();
@@ -249,5 +454,334 @@ void svmFreeBuffers(const cumlHandle &handle, svmModel<math_t> &m) {
   m.unique_labels = nullptr;
 }
 
+/** saved_svm_header starts a model written by svmSave; it is followed by the
+    dual coefficients, the support vectors, the support indices and the
+    unique labels, each array starting at an 8-byte aligned offset */
+struct saved_svm_header {
+  static const int MAGIC = 0x53564d4d;  // "SVMM"
+  static const int VERSION = 1;
+  int magic;
+  int version;
+  int data_size;  // sizeof(math_t)
+  int n_support;
+  int n_cols;
+  int n_classes;
+  double b;
+};
+
+/** appendDeviceArray appends the n elements of the device array src to
+    *pbytes, starting at an 8-byte aligned offset */
+template <typename X>
+void appendDeviceArray(std::vector<char> *pbytes, const X *src, size_t n,
+                       cudaStream_t stream) {
+  size_t offset = (pbytes->size() + 7) / 8 * 8;
+  pbytes->resize(offset + n * sizeof(X), 0);
+  if (n > 0) {
+    MLCommon::updateHost((X *)(pbytes->data() + offset), src, n, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+}
+
+/** readDeviceArray copies into the device array dst the n elements at the
+    (aligned) *poffset in bytes of size size, advancing *poffset */
+template <typename X>
+void readDeviceArray(X *dst, const char *bytes, size_t size, size_t *poffset,
+                     size_t n, cudaStream_t stream) {
+  size_t offset = (*poffset + 7) / 8 * 8;
+  ASSERT(offset + n * sizeof(X) <= size, "saved SVM model is truncated");
+  if (n > 0) {
+    // the bytes might not be aligned for X
+    std::vector<X> tmp(n);
+    memcpy(tmp.data(), bytes + offset, n * sizeof(X));
+    MLCommon::updateDevice(dst, tmp.data(), n, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+  *poffset = offset + n * sizeof(X);
+}
+
+/**
+ * @brief Save an SVM model in a flat binary format.
+ *
+ * The blob uses the byte order and type sizes of the host which saved it.
+ *
+ * @tparam math_t floating point type
+ * @param [in] handle the cuML handle
+ * @param [in] model the model to save
+ * @param [out] pbytes the saved model; its previous contents are replaced
+ */
+template <typename math_t>
+void svmSave(const cumlHandle &handle, const svmModel<math_t> &model,
+             std::vector<char> *pbytes) {
+  cudaStream_t stream = handle.getStream();
+  saved_svm_header hdr;
+  hdr.magic = saved_svm_header::MAGIC;
+  hdr.version = saved_svm_header::VERSION;
+  hdr.data_size = sizeof(math_t);
+  hdr.n_support = model.n_support;
+  hdr.n_cols = model.n_cols;
+  hdr.n_classes = model.unique_labels ? model.n_classes : 0;
+  hdr.b = model.b;
+
+  pbytes->clear();
+  pbytes->resize(sizeof(hdr));
+  memcpy(pbytes->data(), &hdr, sizeof(hdr));
+  appendDeviceArray(pbytes, model.dual_coefs, hdr.n_support, stream);
+  appendDeviceArray(pbytes, model.x_support, (size_t)hdr.n_support * hdr.n_cols,
+                    stream);
+  appendDeviceArray(pbytes, model.support_idx, hdr.n_support, stream);
+  appendDeviceArray(pbytes, model.unique_labels, hdr.n_classes, stream);
+}
+
+/**
+ * @brief Load an SVM model saved by svmSave for the same math_t.
+ *
+ * The output buffers of the model shall be unallocated on entry, they are
+ * allocated using the allocator of the handle, see svmFreeBuffers.
+ *
+ * @tparam math_t floating point type
+ * @param [in] handle the cuML handle
+ * @param [out] model the loaded model
+ * @param [in] bytes the saved model
+ * @param [in] size size of bytes, in bytes
+ */
+template <typename math_t>
+void svmLoad(const cumlHandle &handle, svmModel<math_t> &model,
+             const void *bytes, size_t size) {
+  const char *data = (const char *)bytes;
+  saved_svm_header hdr;
+  ASSERT(size >= sizeof(hdr), "saved SVM model is truncated");
+  memcpy(&hdr, data, sizeof(hdr));
+  ASSERT(hdr.magic == saved_svm_header::MAGIC, "not a saved SVM model");
+  ASSERT(hdr.version == saved_svm_header::VERSION,
+         "saved SVM model has version %d, but only version %d is supported",
+         hdr.version, saved_svm_header::VERSION);
+  ASSERT(hdr.data_size == (int)sizeof(math_t),
+         "saved SVM model has a different data type");
+  ASSERT(hdr.n_support >= 0 && hdr.n_cols > 0 && hdr.n_classes >= 0,
+         "saved SVM model is corrupted");
+
+  auto allocator = handle.getImpl().getDeviceAllocator();
+  cudaStream_t stream = handle.getStream();
+  model.n_support = hdr.n_support;
+  model.n_cols = hdr.n_cols;
+  model.n_classes = hdr.n_classes;
+  model.b = hdr.b;
+  size_t n_x = (size_t)hdr.n_support * hdr.n_cols;
+  model.dual_coefs =
+    (math_t *)allocator->allocate(hdr.n_support * sizeof(math_t), stream);
+  model.x_support = (math_t *)allocator->allocate(n_x * sizeof(math_t), stream);
+  model.support_idx =
+    (int *)allocator->allocate(hdr.n_support * sizeof(int), stream);
+  model.unique_labels =
+    hdr.n_classes > 0
+      ? (math_t *)allocator->allocate(hdr.n_classes * sizeof(math_t), stream)
+      : nullptr;
+  size_t offset = sizeof(hdr);
+  readDeviceArray(model.dual_coefs, data, size, &offset, hdr.n_support,
+                  stream);
+  readDeviceArray(model.x_support, data, size, &offset, n_x, stream);
+  readDeviceArray(model.support_idx, data, size, &offset, hdr.n_support,
+                  stream);
+  readDeviceArray(model.unique_labels, data, size, &offset, hdr.n_classes,
+                  stream);
+}
+
+/**
+ * @brief Fit a one-vs-one multi-class support vector classifier.
+ *
+ * We fit a binary classifier for each pair of classes, on the training
+ * vectors of the two classes. The sub-problems are solved one after the
+ * other, and they share a kernel cache that is keyed by the index of the
+ * training vectors in the full training set: the kernel rows of a vector are
+ * computed once for all the sub-problems it takes part in, as long as they
+ * stay in the cache.
+ *
+ * The output buffers of model shall be unallocated on entry.
+ *
+ * @tparam math_t floating point type
+ * @param [in] handle the cuML handle
+ * @param [in] input device pointer for the input data in column major format.
+ *   Size n_rows x n_cols.
+ * @param [in] n_rows number of rows
+ * @param [in] n_cols number of colums
+ * @param [in] labels device pointer for the labels. Size n_rows.
+ * @param [in] param parameters for training
+ * @param [in] kernel_params parameters for the kernel function
+ * @param [out] model parameters of the trained model
+ */
+template <typename math_t>
+void svcFitMultiClass(const cumlHandle &handle, math_t *input, int n_rows,
+                      int n_cols, math_t *labels, const svmParameter &param,
+                      MLCommon::Matrix::KernelParams &kernel_params,
+                      svmMultiClassModel<math_t> &model) {
+  ASSERT(n_cols > 0,
+         "Parameter n_cols: number of columns cannot be less than one");
+  ASSERT(n_rows > 0,
+         "Parameter n_rows: number of rows cannot be less than one");
+
+  const cumlHandle_impl &handle_impl = handle.getImpl();
+  cudaStream_t stream = handle_impl.getStream();
+  auto allocator = handle_impl.getDeviceAllocator();
+  MLCommon::Label::getUniqueLabels(labels, n_rows, &(model.unique_labels),
+                                   &(model.n_classes), stream, allocator);
+  int n_classes = model.n_classes;
+  ASSERT(n_classes >= 2, "At least two classes are required for training");
+
+  int n_models = n_classes * (n_classes - 1) / 2;
+  model.models = new svmModel<math_t>[n_models];
+  for (int m = 0; m < n_models; m++) {
+    model.models[m] = svmModel<math_t>{0,       n_cols,  0, nullptr,
+                                       nullptr, nullptr, 2, nullptr};
+  }
+
+  // The class of each training vector
+  MLCommon::device_buffer<int> class_idx(allocator, stream, n_rows);
+  math_t *unique_labels = model.unique_labels;
+  MLCommon::LinAlg::unaryOp(
+    class_idx.data(), labels, n_rows,
+    [unique_labels] __device__(math_t label) {
+      int c = 0;
+      while (unique_labels[c] != label) c++;
+      return c;
+    },
+    stream);
+
+  MLCommon::Matrix::GramMatrixBase<math_t> *kernel =
+    MLCommon::Matrix::KernelFactory<math_t>::create(
+      kernel_params, handle_impl.getCublasHandle());
+  // The working set of a sub-problem is never larger than that of the full
+  // training set
+  KernelCache<math_t> cache(handle_impl, input, n_rows, n_cols,
+                            min(SMO_WS_SIZE, n_rows), kernel, param.cache_size);
+
+  MLCommon::device_buffer<int> row_idx(allocator, stream, n_rows);
+  MLCommon::device_buffer<math_t> x_sub(allocator, stream, n_rows * n_cols);
+  MLCommon::device_buffer<math_t> y_sub(allocator, stream, n_rows);
+  int *class_ptr = class_idx.data();
+  int *row_ptr = row_idx.data();
+  math_t *y_ptr = y_sub.data();
+  int m = 0;
+  for (int i = 0; i < n_classes; i++) {
+    for (int j = i + 1; j < n_classes; j++, m++) {
+      // Collect the training vectors of classes i and j
+      thrust::counting_iterator<int> first(0);
+      int *row_end = thrust::copy_if(
+        thrust::cuda::par.on(stream), first, first + n_rows, row_ptr,
+        [class_ptr, i, j] __device__(int k) {
+          return class_ptr[k] == i || class_ptr[k] == j;
+        });
+      int n_sub = row_end - row_ptr;
+      MLCommon::Matrix::copyRows(input, n_rows, n_cols, x_sub.data(), row_ptr,
+                                 n_sub, stream, false);
+      thrust::for_each(thrust::cuda::par.on(stream), first, first + n_sub,
+                       [class_ptr, row_ptr, y_ptr, j] __device__(int k) {
+                         y_ptr[k] = class_ptr[row_ptr[k]] == j ? 1 : -1;
+                       });
+
+      svmModel<math_t> &sub = model.models[m];
+      SmoSolver<math_t> smo(handle_impl, param.C, param.tol, kernel,
+                            param.cache_size, param.nochange_steps);
+      smo.verbose = param.verbose;
+      smo.ws_size = param.ws_size;
+      smo.shrinking = param.shrinking;
+      smo.SetSharedCache(&cache, row_ptr);
+      smo.Solve(x_sub.data(), n_sub, n_cols, y_ptr, &(sub.dual_coefs),
+                &(sub.n_support), &(sub.x_support), &(sub.support_idx),
+                &(sub.b), param.max_iter);
+      if (sub.n_support > 0) {
+        // Indices of the support vectors in the full training set
+        MLCommon::LinAlg::unaryOp(
+          sub.support_idx, sub.support_idx, sub.n_support,
+          [row_ptr] __device__(int k) { return row_ptr[k]; }, stream);
+      }
+    }
+  }
+  delete kernel;
+}
+
+/**
+ * @brief Predict classes with a one-vs-one multi-class classifier.
+ *
+ * Each binary model votes for one of its two classes, and we predict the
+ * class with the most votes. Ties are broken in favor of the class that comes
+ * first in unique_labels.
+ *
+ * @tparam math_t floating point type
+ * @param handle the cuML handle
+ * @param [in] input device pointer for the input data in column major format,
+ *   size [n_rows x n_cols].
+ * @param [in] n_rows number of rows (input vectors)
+ * @param [in] n_cols number of colums (features)
+ * @param [in] kernel_params parameters for the kernel function
+ * @param [in] model multi-class SVM model parameters
+ * @param [out] preds device pointer to store the predicted class labels,
+ *   size [n_rows]. Should be allocated on entry.
+ * @param [in] buffer_size size of temporary buffer in MiB
+ */
+template <typename math_t>
+void svcPredictMultiClass(const cumlHandle &handle, math_t *input, int n_rows,
+                          int n_cols,
+                          MLCommon::Matrix::KernelParams &kernel_params,
+                          const svmMultiClassModel<math_t> &model,
+                          math_t *preds, math_t buffer_size) {
+  const cumlHandle_impl &handle_impl = handle.getImpl();
+  cudaStream_t stream = handle_impl.getStream();
+  auto allocator = handle_impl.getDeviceAllocator();
+  int n_classes = model.n_classes;
+
+  MLCommon::device_buffer<int> votes(allocator, stream, n_rows * n_classes);
+  MLCommon::device_buffer<math_t> decision(allocator, stream, n_rows);
+  CUDA_CHECK(cudaMemsetAsync(votes.data(), 0,
+                             n_rows * n_classes * sizeof(int), stream));
+  int *votes_ptr = votes.data();
+  math_t *decision_ptr = decision.data();
+  thrust::counting_iterator<int> first(0);
+  int m = 0;
+  for (int i = 0; i < n_classes; i++) {
+    for (int j = i + 1; j < n_classes; j++, m++) {
+      svcPredict(handle, input, n_rows, n_cols, kernel_params, model.models[m],
+                 decision_ptr, buffer_size, false);
+      thrust::for_each(
+        thrust::cuda::par.on(stream), first, first + n_rows,
+        [votes_ptr, decision_ptr, n_rows, i, j] __device__(int k) {
+          int c = decision_ptr[k] < 0 ? i : j;
+          votes_ptr[c * n_rows + k]++;
+        });
+    }
+  }
+  math_t *unique_labels = model.unique_labels;
+  thrust::for_each(
+    thrust::cuda::par.on(stream), first, first + n_rows,
+    [votes_ptr, unique_labels, preds, n_rows, n_classes] __device__(int k) {
+      int best = 0;
+      for (int c = 1; c < n_classes; c++) {
+        if (votes_ptr[c * n_rows + k] > votes_ptr[best * n_rows + k]) best = c;
+      }
+      preds[k] = unique_labels[best];
+    });
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * Deallocate the buffers of a multi-class model.
+ *
+ * @param [in] handle cuML handle
+ * @param [inout] m multi-class SVM model parameters
+ */
+template <typename math_t>
+void svmFreeBuffers(const cumlHandle &handle, svmMultiClassModel<math_t> &m) {
+  if (m.models) {
+    int n_models = m.n_classes * (m.n_classes - 1) / 2;
+    for (int i = 0; i < n_models; i++) svmFreeBuffers(handle, m.models[i]);
+    delete[] m.models;
+  }
+  if (m.unique_labels) {
+    handle.getImpl().getDeviceAllocator()->deallocate(
+      m.unique_labels, m.n_classes * sizeof(math_t), handle.getStream());
+  }
+  m.models = nullptr;
+  m.unique_labels = nullptr;
+}
+
 };  // end namespace SVM
 };  // end namespace ML
@@ -38,6 +38,8 @@ cumlError_t cumlSpSvcFit(cumlHandle_t handle, float *input, int n_rows,
   param.nochange_steps = nochange_steps;
   param.tol = tol;
   param.verbose = verbose;
+  param.ws_size = 0;
+  param.shrinking = false;
 
   MLCommon::Matrix::KernelParams kernel_param;
   kernel_param.kernel = (MLCommon::Matrix::KernelType)kernel;
@@ -90,6 +92,8 @@ cumlError_t cumlDpSvcFit(cumlHandle_t handle, double *input, int n_rows,
   param.nochange_steps = nochange_steps;
   param.tol = tol;
   param.verbose = verbose;
+  param.ws_size = 0;
+  param.shrinking = false;
 
   MLCommon::Matrix::KernelParams kernel_param;
   kernel_param.kernel = (MLCommon::Matrix::KernelType)kernel;
@@ -42,5 +42,22 @@ struct svmModel {
     math_t *unique_labels;
 };
 
+/**
+ * A multi-class SVM model, built of one-vs-one binary models.
+ *
+ * The binary model of the classes i < j separates unique_labels[i] (negative
+ * decision function) from unique_labels[j]. The models are ordered by i, then
+ * by j. Their support_idx refer to the full training set, and their
+ * unique_labels are not set.
+ */
+template<typename math_t>
+struct svmMultiClassModel {
+    int n_classes;  //!< Number of classes found in the input labels
+    //! Device pointer for the unique classes. Size [n_classes]
+    math_t *unique_labels;
+    //! Host array of the binary models, size [n_classes*(n_classes-1)/2].
+    svmModel<math_t> *models;
+};
+
 }; // namespace SVM
 }; // namespace ML
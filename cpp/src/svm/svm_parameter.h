@@ -18,6 +18,13 @@
 namespace ML {
 namespace SVM {
 
+/** The quadratic problems the SMO solver can solve */
+enum SvmType {
+  C_SVC,        //!< binary C-support vector classification
+  EPSILON_SVR,  //!< epsilon-support vector regression
+  ONE_CLASS     //!< one-class SVM for novelty detection
+};
+
 /**
  * Numerical input parameters for an SVM.
  *
@@ -30,14 +37,47 @@ namespace SVM {
  *   outer iterations.
  */
 struct svmParameter {
+  /**
+   * The defaults are those of sklearn; being a constructor rather than
+   * default member initializers, which C++11 aggregates do not allow, the
+   * brace initializations with the leading fields keep working, and the
+   * fields which a caller leaves out always get a defined value.
+   */
+  svmParameter(double C = 1.0, double cache_size = 200.0, int max_iter = -1,
+               int nochange_steps = 1000, double tol = 1e-3, int verbose = 0,
+               double epsilon = 0.1, double nu = 0.5, int ws_size = 0,
+               int shrinking = 0)
+    : C(C),
+      cache_size(cache_size),
+      max_iter(max_iter),
+      nochange_steps(nochange_steps),
+      tol(tol),
+      verbose(verbose),
+      epsilon(epsilon),
+      nu(nu),
+      ws_size(ws_size),
+      shrinking(shrinking) {}
+
   double C;           //!< Penalty term C
-  double cache_size;  //!< kernel cache size in MiB
+  //! kernel cache size in MiB, use a negative value to size the cache from
+  //! the free device memory
+  double cache_size;
   //! maximum number of outer SMO iterations. Use -1 to let the SMO solver set
   //! a default value (100*n_rows).
   int max_iter;
   int nochange_steps;  //<! Number of steps to continue with non-changing diff
   double tol;          //!< Tolerance used to stop fitting.
   int verbose;         //!< Print information about traning
+  //! Width of the insensitive tube around the targets, only used by svrFit
+  double epsilon;
+  //! Upper bound on the fraction of outliers and lower bound on the fraction
+  //! of support vectors in (0, 1], only used by oneClassFit
+  double nu;
+  //! Size of the working set of the SMO solver. Use 0 for the default
+  //! min(1024, n_rows); larger sets are solved by several thread blocks.
+  int ws_size;
+  //! Whether the SMO solver shrinks the variables that are stuck at a bound
+  int shrinking;
 };
 
 };  // namespace SVM
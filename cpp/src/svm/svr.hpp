@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/cumlHandle.hpp"
+#include "matrix/kernelparams.h"
+#include "svm_model.h"
+#include "svm_parameter.h"
+
+namespace ML {
+namespace SVM {
+
+// Forward declarations of the stateless API
+/**
+ * @brief Fit an epsilon-support vector regressor to the training data.
+ *
+ * Each row of the input data stores a feature vector. The regressor is
+ * fitted by the SMO solver in dual space, which has 2 * n_rows dual
+ * variables for this problem.
+ *
+ * The output dbuffers in model shall be unallocated on entry. The fitted
+ * model has n_classes = 0 and no unique_labels. Predict with
+ * svcPredict(..., predict_class = false), which returns the regression
+ * function f(x) = \sum_i dual_coefs[i] K(x_support[i], x) + b.
+ *
+ * @tparam math_t floating point type
+ * @param [in] handle the cuML handle
+ * @param [in] input device pointer for the input data in column major format.
+ *   Size n_rows x n_cols.
+ * @param [in] n_rows number of rows
+ * @param [in] n_cols number of colums
+ * @param [in] y device pointer for the target values. Size [n_rows].
+ * @param [in] param parameters for training, param.epsilon sets the width of
+ *   the insensitive tube
+ * @param [in] kernel_params parameters for the kernel function
+ * @param [out] model parameters of the trained model
+ */
+template <typename math_t>
+void svrFit(const cumlHandle &handle, math_t *input, int n_rows, int n_cols,
+            math_t *y, const svmParameter &param,
+            MLCommon::Matrix::KernelParams &kernel_params,
+            svmModel<math_t> &model);
+
+/**
+ * @brief Fit a one-class SVM to the training data.
+ *
+ * The one-class SVM estimates the support of the training distribution. The
+ * fitted model has n_classes = 0 and no unique_labels. Predict with
+ * svcPredict(..., predict_class = false): inliers have a non-negative
+ * decision function value, outliers a negative one.
+ *
+ * @tparam math_t floating point type
+ * @param [in] handle the cuML handle
+ * @param [in] input device pointer for the input data in column major format.
+ *   Size n_rows x n_cols.
+ * @param [in] n_rows number of rows
+ * @param [in] n_cols number of colums
+ * @param [in] param parameters for training, param.nu in (0, 1] bounds the
+ *   fraction of outliers from above, and the fraction of support vectors
+ *   from below. param.C is not used.
+ * @param [in] kernel_params parameters for the kernel function
+ * @param [out] model parameters of the trained model
+ */
+template <typename math_t>
+void oneClassFit(const cumlHandle &handle, math_t *input, int n_rows,
+                 int n_cols, const svmParameter &param,
+                 MLCommon::Matrix::KernelParams &kernel_params,
+                 svmModel<math_t> &model);
+
+};  // namespace SVM
+};  // namespace ML
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+/** @file svr_impl.h
+ * @brief Implementation of the stateless C++ functions to fit an SVM
+ * regressor and a one-class SVM.
+ */
+
+#include "common/cumlHandle.hpp"
+#include "common/device_buffer.hpp"
+#include "matrix/kernelfactory.h"
+#include "smosolver.h"
+#include "svm_model.h"
+#include "svm_parameter.h"
+
+namespace ML {
+namespace SVM {
+
+/**
+ * @brief Fit an epsilon-support vector regressor to the training data.
+ *
+ * See svr.hpp for the description of the parameters.
+ */
+template <typename math_t>
+void svrFit(const cumlHandle &handle, math_t *input, int n_rows, int n_cols,
+            math_t *y, const svmParameter &param,
+            MLCommon::Matrix::KernelParams &kernel_params,
+            svmModel<math_t> &model) {
+  ASSERT(n_cols > 0,
+         "Parameter n_cols: number of columns cannot be less than one");
+  ASSERT(n_rows > 0,
+         "Parameter n_rows: number of rows cannot be less than one");
+  ASSERT(param.epsilon >= 0, "Parameter epsilon: cannot be negative");
+
+  const cumlHandle_impl &handle_impl = handle.getImpl();
+  model.n_classes = 0;
+  model.unique_labels = nullptr;
+
+  MLCommon::Matrix::GramMatrixBase<math_t> *kernel =
+    MLCommon::Matrix::KernelFactory<math_t>::create(
+      kernel_params, handle_impl.getCublasHandle());
+  SmoSolver<math_t> smo(handle_impl, param.C, param.tol, kernel,
+                        param.cache_size, param.nochange_steps, EPSILON_SVR,
+                        param.epsilon);
+  smo.verbose = param.verbose;
+  smo.ws_size = param.ws_size;
+  smo.shrinking = param.shrinking;
+  smo.Solve(input, n_rows, n_cols, y, &(model.dual_coefs), &(model.n_support),
+            &(model.x_support), &(model.support_idx), &(model.b),
+            param.max_iter);
+  model.n_cols = n_cols;
+  delete kernel;
+}
+
+/**
+ * @brief Fit a one-class SVM to the training data.
+ *
+ * See svr.hpp for the description of the parameters.
+ */
+template <typename math_t>
+void oneClassFit(const cumlHandle &handle, math_t *input, int n_rows,
+                 int n_cols, const svmParameter &param,
+                 MLCommon::Matrix::KernelParams &kernel_params,
+                 svmModel<math_t> &model) {
+  ASSERT(n_cols > 0,
+         "Parameter n_cols: number of columns cannot be less than one");
+  ASSERT(n_rows > 0,
+         "Parameter n_rows: number of rows cannot be less than one");
+
+  const cumlHandle_impl &handle_impl = handle.getImpl();
+  model.n_classes = 0;
+  model.unique_labels = nullptr;
+
+  MLCommon::Matrix::GramMatrixBase<math_t> *kernel =
+    MLCommon::Matrix::KernelFactory<math_t>::create(
+      kernel_params, handle_impl.getCublasHandle());
+  SmoSolver<math_t> smo(handle_impl, 1, param.tol, kernel, param.cache_size,
+                        param.nochange_steps, ONE_CLASS, 0, param.nu);
+  smo.verbose = param.verbose;
+  smo.ws_size = param.ws_size;
+  smo.shrinking = param.shrinking;
+  // The labels of the one-class problem are set up by the solver
+  smo.Solve(input, n_rows, n_cols, nullptr, &(model.dual_coefs),
+            &(model.n_support), &(model.x_support), &(model.support_idx),
+            &(model.b), param.max_iter);
+  model.n_cols = n_cols;
+  delete kernel;
+}
+
+};  // end namespace SVM
+};  // end namespace ML
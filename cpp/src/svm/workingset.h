@@ -87,13 +87,13 @@ class WorkingSet {
    * Set the size of the working set and allocate buffers accordingly.
    *
    * @param n_rows number of training vectors
-   * @param n_ws working set size (default min(1024, n_rows))
+   * @param n_ws working set size, at most n_rows (default min(1024, n_rows))
    */
   void SetSize(int n_rows, int n_ws = 0) {
-    if (n_ws == 0 || n_ws > n_rows) {
-      n_ws = n_rows;
+    if (n_ws == 0) {
+      n_ws = 1024;
     }
-    n_ws = min(1024, n_ws);
+    n_ws = min(n_rows, n_ws);
     this->n_ws = n_ws;
     this->n_rows = n_rows;
     AllocateBuffers();
@@ -105,6 +105,19 @@ class WorkingSet {
   /** Return a pointer the the working set indices */
   int *GetIndices() { return idx.data(); }
 
+  /**
+   * Restrict the selection to the active elements, or allow all the elements
+   * if active is nullptr. The next call to Select picks a completely new
+   * working set.
+   *
+   * @param active device array of flags, size [n_rows], it has to stay valid
+   *   while it is used
+   */
+  void SetActive(const bool *active) {
+    this->active = active;
+    firstcall = true;
+  }
+
   /**
    * Select new elements for a working set.
    *
@@ -152,6 +165,7 @@ class WorkingSet {
     set_upper<<<MLCommon::ceildiv(n_rows, TPB), TPB, 0, stream>>>(
       available, n_rows, alpha, y, C);
     CUDA_CHECK(cudaPeekAtLastError());
+    MaskInactive();
     n_already_selected +=
       GatherAvailable(n_already_selected, n_needed / 2, true);
 
@@ -159,6 +173,7 @@ class WorkingSet {
     set_lower<<<MLCommon::ceildiv(n_rows, TPB), TPB, 0, stream>>>(
       available, n_rows, alpha, y, C);
     CUDA_CHECK(cudaPeekAtLastError());
+    MaskInactive();
     n_already_selected +=
       GatherAvailable(n_already_selected, n_ws - n_already_selected, false);
 
@@ -169,7 +184,11 @@ class WorkingSet {
         std::cout << "Warning: could not fill working set, found only "
                   << n_already_selected << " elements.\n";
       if (verbose) std::cout << "Filling up with unused elements\n";
-      CUDA_CHECK(cudaMemset(available, 1, sizeof(bool) * n_rows));
+      if (active) {
+        MLCommon::copy(available, active, n_rows, stream);
+      } else {
+        CUDA_CHECK(cudaMemset(available, 1, sizeof(bool) * n_rows));
+      }
       n_already_selected +=
         GatherAvailable(n_already_selected, n_ws - n_already_selected, true);
     }
@@ -263,6 +282,8 @@ class WorkingSet {
   cudaStream_t stream;
 
   bool firstcall = true;
+  //! elements that can be selected, nullptr if all of them, see SetActive
+  const bool *active = nullptr;
   int n_rows = 0;
   int n_ws = 0;
 
@@ -386,6 +407,14 @@ class WorkingSet {
     return n_copy;
   }
 
+  /** Mark the inactive elements as unavailable. */
+  void MaskInactive() {
+    if (active == nullptr) return;
+    mask_available<<<MLCommon::ceildiv(n_rows, TPB), TPB, 0, stream>>>(
+      available.data(), n_rows, active);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+
   void Initialize() {
     MLCommon::LinAlg::range<<<MLCommon::ceildiv(n_rows, TPB), TPB>>>(
       f_idx.data(), n_rows);
@@ -31,6 +31,13 @@ __global__ void set_unavailable(bool *available, int n_rows, const int *idx,
   }
 }
 
+__global__ void mask_available(bool *available, int n, const bool *active) {
+  int tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid < n) {
+    available[tid] = available[tid] && active[tid];
+  }
+}
+
 __global__ void update_priority(int *new_priority, int n_selected,
                                 const int *new_idx, int n_ws, const int *idx,
                                 const int *priority) {
@@ -30,6 +30,14 @@ namespace SVM {
 __global__ void set_unavailable(bool *available, int n_rows, const int *idx,
                                 int n_selected);
 
+/**
+ * Mark elements as unavailable if they are not active.
+ * \param [inout] available flag whether an idx is available, size [n]
+ * \param [in] n number of training vectors
+ * \param [in] active flag whether an idx is active, size [n]
+ */
+__global__ void mask_available(bool *available, int n, const bool *active);
+
 /** Set availability to true for elements in the upper set, otherwise false.
  * @param [out] available, size [n]
  * @param [in] n number of elements in the working set
@@ -25,13 +25,15 @@ namespace Stationarity {
 
 template <typename DataT>
 int stationarity_helper(const cumlHandle& handle, const DataT* y_d, int* d,
-                        int n_batches, int n_samples, DataT pval_threshold) {
+                        int n_batches, int n_samples, DataT pval_threshold,
+                        int test = 0, int max_d = 1) {
   const auto& handle_impl = handle.getImpl();
   cudaStream_t stream = handle_impl.getStream();
   auto allocator = handle_impl.getDeviceAllocator();
 
-  return MLCommon::TimeSeries::stationarity(y_d, d, n_batches, n_samples,
-                                            allocator, stream, pval_threshold);
+  return MLCommon::TimeSeries::stationarity(
+    y_d, d, n_batches, n_samples, allocator, stream, pval_threshold,
+    static_cast<MLCommon::TimeSeries::StationarityTestType>(test), max_d);
 }
 
 int stationarity(const cumlHandle& handle, const float* y_d, int* d,
@@ -46,5 +48,19 @@ int stationarity(const cumlHandle& handle, const double* y_d, int* d,
                                      pval_threshold);
 }
 
+int stationarity(const cumlHandle& handle, const float* y_d, int* d,
+                 int n_batches, int n_samples, float pval_threshold, int test,
+                 int max_d) {
+  return stationarity_helper<float>(handle, y_d, d, n_batches, n_samples,
+                                    pval_threshold, test, max_d);
+}
+
+int stationarity(const cumlHandle& handle, const double* y_d, int* d,
+                 int n_batches, int n_samples, double pval_threshold, int test,
+                 int max_d) {
+  return stationarity_helper<double>(handle, y_d, d, n_batches, n_samples,
+                                     pval_threshold, test, max_d);
+}
+
 }  // namespace Stationarity
 }  // namespace ML
@@ -16,11 +16,15 @@
 
 #pragma once
 #include "bh_kernels.h"
+#include "common/device_buffer.hpp"
 #include "utils.h"
 
 namespace ML {
 namespace TSNE {
 
+/** Iterations between the checks of the gradient norm */
+#define BH_CHECK_EVERY 50
+
 /**
  * @brief Fast Dimensionality reduction via TSNE using the Barnes Hut O(NlogN) approximation.
  * @input param VAL: The values in the attractive forces COO matrix.
@@ -68,11 +72,47 @@ void Barnes_Hut(float *VAL, const int *COL, const int *ROW, const int NNZ,
 
   // Allocate more space
   //---------------------------------------------------
-  //int *errl = (int *)d_alloc->allocate(sizeof(int), stream);
-  unsigned *limiter = (unsigned *)d_alloc->allocate(sizeof(unsigned), stream);
-  int *maxdepthd = (int *)d_alloc->allocate(sizeof(int), stream);
-  int *bottomd = (int *)d_alloc->allocate(sizeof(int), stream);
-  float *radiusd = (float *)d_alloc->allocate(sizeof(float), stream);
+  unsigned *limiter;
+  int *maxdepthd, *bottomd, *startl, *childl, *countl, *sortl;
+  float *radiusd, *massl, *maxxl, *maxyl, *minxl, *minyl, *rep_forces,
+    *attr_forces, *norm_add1, *norm, *Z_norm, *radiusd_squared, *grad_norm,
+    *gains_bh, *old_forces, *YY;
+  // All the buffers of the iterations live in a single workspace, sized by a
+  // first pass over them
+  auto carve = [&](Workspace &ws) {
+    limiter = ws.take<unsigned>(1);
+    maxdepthd = ws.take<int>(1);
+    bottomd = ws.take<int>(1);
+    radiusd = ws.take<float>(1);
+    startl = ws.take<int>(nnodes + 1);
+    childl = ws.take<int>((nnodes + 1) * 4);
+    massl = ws.take<float>(nnodes + 1);
+    maxxl = ws.take<float>(blocks * FACTOR1);
+    maxyl = ws.take<float>(blocks * FACTOR1);
+    minxl = ws.take<float>(blocks * FACTOR1);
+    minyl = ws.take<float>(blocks * FACTOR1);
+    // SummarizationKernel
+    countl = ws.take<int>(nnodes + 1);
+    // SortKernel
+    sortl = ws.take<int>(nnodes + 1);
+    // RepulsionKernel
+    rep_forces = ws.take<float>((nnodes + 1) * 2);
+    attr_forces = ws.take<float>(n * 2);
+    norm_add1 = ws.take<float>(n);
+    norm = ws.take<float>(n);
+    Z_norm = ws.take<float>(1);
+    radiusd_squared = ws.take<float>(1);
+    grad_norm = ws.take<float>(1);
+    // Apply
+    gains_bh = ws.take<float>(n * 2);
+    old_forces = ws.take<float>(n * 2);
+    YY = ws.take<float>((nnodes + 1) * 2);
+  };
+  Workspace sizes;
+  carve(sizes);
+  MLCommon::device_buffer<char> workspace(d_alloc, stream, sizes.size);
+  Workspace ws(workspace.data());
+  carve(ws);
 
   TSNE::InitializationKernel<<<1, 1, 0, stream>>>(/*errl,*/ limiter, maxdepthd,
                                                   radiusd);
@@ -83,57 +123,18 @@ void Barnes_Hut(float *VAL, const int *COL, const int *ROW, const int NNZ,
   const float theta_squared = theta * theta;
   const int NNODES = nnodes;
 
-  // Actual mallocs
-  int *startl = (int *)d_alloc->allocate(sizeof(int) * (nnodes + 1), stream);
-  int *childl =
-    (int *)d_alloc->allocate(sizeof(int) * (nnodes + 1) * 4, stream);
-  float *massl =
-    (float *)d_alloc->allocate(sizeof(float) * (nnodes + 1), stream);
   thrust::device_ptr<float> begin_massl = thrust::device_pointer_cast(massl);
   thrust::fill(thrust::cuda::par.on(stream), begin_massl,
                begin_massl + (nnodes + 1), 1.0f);
 
-  float *maxxl =
-    (float *)d_alloc->allocate(sizeof(float) * blocks * FACTOR1, stream);
-  float *maxyl =
-    (float *)d_alloc->allocate(sizeof(float) * blocks * FACTOR1, stream);
-  float *minxl =
-    (float *)d_alloc->allocate(sizeof(float) * blocks * FACTOR1, stream);
-  float *minyl =
-    (float *)d_alloc->allocate(sizeof(float) * blocks * FACTOR1, stream);
-
-  // SummarizationKernel
-  int *countl = (int *)d_alloc->allocate(sizeof(int) * (nnodes + 1), stream);
-
-  // SortKernel
-  int *sortl = (int *)d_alloc->allocate(sizeof(int) * (nnodes + 1), stream);
-
-  // RepulsionKernel
-  float *rep_forces =
-    (float *)d_alloc->allocate(sizeof(float) * (nnodes + 1) * 2, stream);
-  float *attr_forces = (float *)d_alloc->allocate(
-    sizeof(float) * n * 2, stream);  // n*2 double for reduction sum
-
-  float *norm_add1 = (float *)d_alloc->allocate(sizeof(float) * n, stream);
-  float *norm = (float *)d_alloc->allocate(sizeof(float) * n, stream);
-  float *Z_norm = (float *)d_alloc->allocate(sizeof(float), stream);
-
-  float *radiusd_squared = (float *)d_alloc->allocate(sizeof(float), stream);
-
-  // Apply
-  float *gains_bh = (float *)d_alloc->allocate(sizeof(float) * n * 2, stream);
   thrust::device_ptr<float> begin_gains_bh =
     thrust::device_pointer_cast(gains_bh);
   thrust::fill(thrust::cuda::par.on(stream), begin_gains_bh,
                begin_gains_bh + (n * 2), 1.0f);
 
-  float *old_forces = (float *)d_alloc->allocate(sizeof(float) * n * 2, stream);
   CUDA_CHECK(cudaMemsetAsync(old_forces, 0, sizeof(float) * n * 2, stream));
 
-  float *YY =
-    (float *)d_alloc->allocate(sizeof(float) * (nnodes + 1) * 2, stream);
   random_vector(YY, -0.0001f, 0.0001f, (nnodes + 1) * 2, stream, random_state);
-  ASSERT(YY != NULL && rep_forces != NULL, "[ERROR] Possibly no more memory");
 
   // Set cache levels for faster algorithm execution
   //---------------------------------------------------
@@ -154,7 +155,13 @@ void Barnes_Hut(float *VAL, const int *COL, const int *ROW, const int NNZ,
   float momentum = pre_momentum;
   float learning_rate = pre_learning_rate;
 
-  for (int iter = 0; iter < max_iter; iter++) {
+  /**
+   * One gradient update. Its launches are captured into a CUDA graph on the
+   * first iteration of each phase, which the later ones replay. The graphs
+   * need a stream other than the legacy default one, and are skipped when
+   * verbose for the timers between the kernels.
+   */
+  auto iteration = [&]() {
     CUDA_CHECK(
       cudaMemsetAsync(rep_forces, 0, sizeof(float) * (nnodes + 1) * 2, stream));
     CUDA_CHECK(cudaMemsetAsync(attr_forces, 0, sizeof(float) * n * 2, stream));
@@ -162,13 +169,6 @@ void Barnes_Hut(float *VAL, const int *COL, const int *ROW, const int NNZ,
                                                    bottomd, NNODES, radiusd);
     CUDA_CHECK(cudaPeekAtLastError());
 
-    if (iter == exaggeration_iter) {
-      momentum = post_momentum;
-      // Divide perplexities
-      const float div = 1.0f / early_exaggeration;
-      MLCommon::LinAlg::scalarMultiply(VAL, VAL, div, NNZ, stream);
-    }
-
     START_TIMER;
     TSNE::BoundingBoxKernel<<<blocks * FACTOR1, THREADS1, 0, stream>>>(
       startl, childl, massl, YY, YY + nnodes + 1, maxxl, maxyl, minxl, minyl,
@@ -250,7 +250,73 @@ void Barnes_Hut(float *VAL, const int *COL, const int *ROW, const int NNZ,
     CUDA_CHECK(cudaPeekAtLastError());
 
     END_TIMER(IntegrationKernel_time);
+  };
+
+#if CUDART_VERSION >= 10010
+  const bool use_graph = !verbose && stream != 0;
+  cudaGraphExec_t graph_exec;
+  bool graph_ready = false;
+#endif
+
+  for (int iter = 0; iter < max_iter; iter++) {
+    if (iter == exaggeration_iter) {
+      momentum = post_momentum;
+      // Divide perplexities
+      const float div = 1.0f / early_exaggeration;
+      MLCommon::LinAlg::scalarMultiply(VAL, VAL, div, NNZ, stream);
+#if CUDART_VERSION >= 10010
+      // The launches of the last phase hold the old momentum
+      if (graph_ready) CUDA_CHECK(cudaGraphExecDestroy(graph_exec));
+      graph_ready = false;
+#endif
+    }
+
+#if CUDART_VERSION >= 10010
+    if (use_graph) {
+      if (!graph_ready) {
+        cudaGraph_t graph;
+        CUDA_CHECK(
+          cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal));
+        iteration();
+        CUDA_CHECK(cudaStreamEndCapture(stream, &graph));
+        CUDA_CHECK(cudaGraphInstantiate(&graph_exec, graph, NULL, NULL, 0));
+        CUDA_CHECK(cudaGraphDestroy(graph));
+        graph_ready = true;
+      }
+      CUDA_CHECK(cudaGraphLaunch(graph_exec, stream));
+    } else {
+      iteration();
+    }
+#else
+    iteration();
+#endif
+
+    // The gradients are summed on the device, and only read back every
+    // BH_CHECK_EVERY iterations past the early exaggeration
+    if (iter > exaggeration_iter && iter % BH_CHECK_EVERY == 0) {
+      CUDA_CHECK(cudaMemsetAsync(grad_norm, 0, sizeof(float), stream));
+      TSNE::GradientNormKernel<<<blocks * FACTOR6, THREADS6, 0, stream>>>(
+        attr_forces, attr_forces + n, rep_forces, rep_forces + nnodes + 1,
+        Z_norm, grad_norm, n);
+      CUDA_CHECK(cudaPeekAtLastError());
+      float gradient_norm;
+      MLCommon::updateHost(&gradient_norm, grad_norm, 1, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+      gradient_norm = sqrtf(gradient_norm);
+
+      if (gradient_norm < min_grad_norm) {
+        if (verbose)
+          printf(
+            "Gradient norm = %f <= min_grad_norm = %f. Early stopped at iter "
+            "= %d\n",
+            gradient_norm, min_grad_norm, iter);
+        break;
+      }
+    }
   }
+#if CUDART_VERSION >= 10010
+  if (graph_ready) CUDA_CHECK(cudaGraphExecDestroy(graph_exec));
+#endif
   PRINT_TIMES;
 
   // Copy final YY into true output Y
@@ -261,38 +327,6 @@ void Barnes_Hut(float *VAL, const int *COL, const int *ROW, const int NNZ,
   thrust::copy(thrust::cuda::par.on(stream), YY + nnodes + 1,
                YY + nnodes + 1 + n, Y_begin + n);
   CUDA_CHECK(cudaPeekAtLastError());
-
-  // Deallocate everything
-  //d_alloc->deallocate(errl, sizeof(int), stream);
-  d_alloc->deallocate(limiter, sizeof(unsigned), stream);
-  d_alloc->deallocate(maxdepthd, sizeof(int), stream);
-  d_alloc->deallocate(bottomd, sizeof(int), stream);
-  d_alloc->deallocate(radiusd, sizeof(float), stream);
-
-  d_alloc->deallocate(startl, sizeof(int) * (nnodes + 1), stream);
-  d_alloc->deallocate(childl, sizeof(int) * (nnodes + 1) * 4, stream);
-  d_alloc->deallocate(massl, sizeof(float) * (nnodes + 1), stream);
-
-  d_alloc->deallocate(maxxl, sizeof(float) * blocks * FACTOR1, stream);
-  d_alloc->deallocate(maxyl, sizeof(float) * blocks * FACTOR1, stream);
-  d_alloc->deallocate(minxl, sizeof(float) * blocks * FACTOR1, stream);
-  d_alloc->deallocate(minyl, sizeof(float) * blocks * FACTOR1, stream);
-
-  d_alloc->deallocate(countl, sizeof(int) * (nnodes + 1), stream);
-  d_alloc->deallocate(sortl, sizeof(int) * (nnodes + 1), stream);
-
-  d_alloc->deallocate(rep_forces, sizeof(float) * (nnodes + 1) * 2, stream);
-  d_alloc->deallocate(attr_forces, sizeof(float) * n * 2, stream);
-  d_alloc->deallocate(norm, sizeof(float) * n, stream);
-  d_alloc->deallocate(norm_add1, sizeof(float) * n, stream);
-
-  d_alloc->deallocate(Z_norm, sizeof(float), stream);
-  d_alloc->deallocate(radiusd_squared, sizeof(float), stream);
-
-  d_alloc->deallocate(gains_bh, sizeof(float) * n * 2, stream);
-  d_alloc->deallocate(old_forces, sizeof(float) * n * 2, stream);
-
-  d_alloc->deallocate(YY, sizeof(float) * (nnodes + 1) * 2, stream);
 }
 
 }  // namespace TSNE
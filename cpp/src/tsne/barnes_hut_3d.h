@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "barnes_hut.h"
+#include "bh_kernels_3d.h"
+#include "common/device_buffer.hpp"
+#include "utils.h"
+
+namespace ML {
+namespace TSNE {
+
+/**
+ * @brief Fast Dimensionality reduction via TSNE using the Barnes Hut O(NlogN) approximation on an octree, for 3D embeddings.
+ * @input param VAL: The values in the attractive forces COO matrix.
+ * @input param COL: The column indices in the attractive forces COO matrix.
+ * @input param ROW: The row indices in the attractive forces COO matrix.
+ * @input param NNZ: The number of non zeros in the attractive forces COO matrix.
+ * @input param handle: The GPU handle.
+ * @output param Y: The final embedding (n, 3) in column-major. Will overwrite this internally.
+ * @input param n: Number of rows in data X.
+ * @input param theta: Float between 0 and 1. Tradeoff for speed (0) vs accuracy (1).
+ * @input param epssq: A tiny jitter to promote numerical stability.
+ * @input param early_exaggeration: How much early pressure you want the clusters in TSNE to spread out more.
+ * @input param exaggeration_iter: How many iterations you want the early pressure to run for.
+ * @input param min_gain: Rounds up small gradient updates.
+ * @input param pre_learning_rate: The learning rate during the exaggeration phase.
+ * @input param post_learning_rate: The learning rate after the exaggeration phase.
+ * @input param max_iter: The maximum number of iterations TSNE should run for.
+ * @input param min_grad_norm: The smallest gradient norm TSNE should terminate on.
+ * @input param pre_momentum: The momentum used during the exaggeration phase.
+ * @input param post_momentum: The momentum used after the exaggeration phase.
+ * @input param random_state: Set this to -1 for pure random intializations or >= 0 for reproducible outputs.
+ * @input param verbose: Whether to print error messages or not.
+ */
+void Barnes_Hut_3d(float *VAL, const int *COL, const int *ROW, const int NNZ,
+                   const cumlHandle &handle, float *Y, const int n,
+                   const float theta = 0.5f, const float epssq = 0.0025,
+                   const float early_exaggeration = 12.0f,
+                   const int exaggeration_iter = 250,
+                   const float min_gain = 0.01f,
+                   const float pre_learning_rate = 200.0f,
+                   const float post_learning_rate = 500.0f,
+                   const int max_iter = 1000, const float min_grad_norm = 1e-7,
+                   const float pre_momentum = 0.5,
+                   const float post_momentum = 0.8,
+                   const long long random_state = -1,
+                   const bool verbose = true) {
+  auto d_alloc = handle.getDeviceAllocator();
+  cudaStream_t stream = handle.getStream();
+
+  // Get device properites
+  //---------------------------------------------------
+  const int blocks = MLCommon::getMultiProcessorCount();
+
+  int nnodes = n * 2;
+  if (nnodes < 1024 * blocks) nnodes = 1024 * blocks;
+  while ((nnodes & (32 - 1)) != 0) nnodes++;
+  nnodes--;
+  if (verbose) printf("N_nodes = %d blocks = %d\n", nnodes, blocks);
+
+  // Allocate more space
+  //---------------------------------------------------
+  unsigned *limiter;
+  int *maxdepthd, *bottomd, *startl, *childl, *countl, *sortl;
+  float *radiusd, *massl, *maxxl, *maxyl, *maxzl, *minxl, *minyl, *minzl,
+    *rep_forces, *attr_forces, *norm_add1, *norm, *Z_norm, *radiusd_squared,
+    *grad_norm, *gains_bh, *old_forces, *YY;
+  // All the buffers of the iterations live in a single workspace, sized by a
+  // first pass over them
+  auto carve = [&](Workspace &ws) {
+    limiter = ws.take<unsigned>(1);
+    maxdepthd = ws.take<int>(1);
+    bottomd = ws.take<int>(1);
+    radiusd = ws.take<float>(1);
+    startl = ws.take<int>(nnodes + 1);
+    childl = ws.take<int>((nnodes + 1) * 8);
+    massl = ws.take<float>(nnodes + 1);
+    maxxl = ws.take<float>(blocks * FACTOR1);
+    maxyl = ws.take<float>(blocks * FACTOR1);
+    maxzl = ws.take<float>(blocks * FACTOR1);
+    minxl = ws.take<float>(blocks * FACTOR1);
+    minyl = ws.take<float>(blocks * FACTOR1);
+    minzl = ws.take<float>(blocks * FACTOR1);
+    // SummarizationKernel
+    countl = ws.take<int>(nnodes + 1);
+    // SortKernel
+    sortl = ws.take<int>(nnodes + 1);
+    // RepulsionKernel
+    rep_forces = ws.take<float>(n * 3);
+    attr_forces = ws.take<float>(n * 3);
+    norm_add1 = ws.take<float>(n);
+    norm = ws.take<float>(n);
+    Z_norm = ws.take<float>(1);
+    radiusd_squared = ws.take<float>(1);
+    grad_norm = ws.take<float>(1);
+    // Apply
+    gains_bh = ws.take<float>(n * 3);
+    old_forces = ws.take<float>(n * 3);
+    YY = ws.take<float>((nnodes + 1) * 3);
+  };
+  Workspace sizes;
+  carve(sizes);
+  MLCommon::device_buffer<char> workspace(d_alloc, stream, sizes.size);
+  Workspace ws(workspace.data());
+  carve(ws);
+
+  TSNE::InitializationKernel<<<1, 1, 0, stream>>>(limiter, maxdepthd, radiusd);
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  const int EIGHT_NNODES = 8 * nnodes;
+  const int EIGHT_N = 8 * n;
+  const float theta_squared = theta * theta;
+  const int NNODES = nnodes;
+  float *YY1 = YY, *YY2 = YY + nnodes + 1, *YY3 = YY + 2 * (nnodes + 1);
+
+  thrust::device_ptr<float> begin_massl = thrust::device_pointer_cast(massl);
+  thrust::fill(thrust::cuda::par.on(stream), begin_massl,
+               begin_massl + (nnodes + 1), 1.0f);
+
+  thrust::device_ptr<float> begin_gains_bh =
+    thrust::device_pointer_cast(gains_bh);
+  thrust::fill(thrust::cuda::par.on(stream), begin_gains_bh,
+               begin_gains_bh + (n * 3), 1.0f);
+
+  CUDA_CHECK(cudaMemsetAsync(old_forces, 0, sizeof(float) * n * 3, stream));
+
+  random_vector(YY, -0.0001f, 0.0001f, (nnodes + 1) * 3, stream, random_state);
+
+  // Set cache levels for faster algorithm execution
+  //---------------------------------------------------
+  cudaFuncSetCacheConfig(TSNE::BoundingBoxKernel3d, cudaFuncCachePreferShared);
+  cudaFuncSetCacheConfig(TSNE::TreeBuildingKernel3d, cudaFuncCachePreferL1);
+  cudaFuncSetCacheConfig(TSNE::ClearKernel1, cudaFuncCachePreferL1);
+  cudaFuncSetCacheConfig(TSNE::ClearKernel2, cudaFuncCachePreferL1);
+  cudaFuncSetCacheConfig(TSNE::SummarizationKernel3d,
+                         cudaFuncCachePreferShared);
+  cudaFuncSetCacheConfig(TSNE::SortKernel3d, cudaFuncCachePreferL1);
+  cudaFuncSetCacheConfig(TSNE::RepulsionKernel3d, cudaFuncCachePreferL1);
+  cudaFuncSetCacheConfig(TSNE::attractive_kernel_bh3d, cudaFuncCachePreferL1);
+  cudaFuncSetCacheConfig(TSNE::IntegrationKernel3d, cudaFuncCachePreferL1);
+
+  // Do gradient updates
+  //---------------------------------------------------
+  if (verbose) printf("[Info] Start gradient updates!\n");
+
+  float momentum = pre_momentum;
+  float learning_rate = pre_learning_rate;
+
+  // One gradient update, replayed from a CUDA graph as in Barnes_Hut
+  auto iteration = [&]() {
+    CUDA_CHECK(cudaMemsetAsync(rep_forces, 0, sizeof(float) * n * 3, stream));
+    CUDA_CHECK(cudaMemsetAsync(attr_forces, 0, sizeof(float) * n * 3, stream));
+    TSNE::Reset_Normalization<<<1, 1, 0, stream>>>(Z_norm, radiusd_squared,
+                                                   bottomd, NNODES, radiusd);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    START_TIMER;
+    TSNE::BoundingBoxKernel3d<<<blocks * FACTOR1, THREADS1, 0, stream>>>(
+      startl, childl, massl, YY1, YY2, YY3, maxxl, maxyl, maxzl, minxl, minyl,
+      minzl, EIGHT_NNODES, NNODES, n, limiter, radiusd);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    END_TIMER(BoundingBoxKernel_time);
+
+    START_TIMER;
+    TSNE::ClearKernel1<<<blocks, 1024, 0, stream>>>(childl, EIGHT_NNODES,
+                                                    EIGHT_N);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    END_TIMER(ClearKernel1_time);
+
+    START_TIMER;
+    TSNE::TreeBuildingKernel3d<<<blocks * FACTOR2, THREADS2, 0, stream>>>(
+      childl, YY1, YY2, YY3, NNODES, n, maxdepthd, bottomd, radiusd);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    END_TIMER(TreeBuildingKernel_time);
+
+    START_TIMER;
+    TSNE::ClearKernel2<<<blocks * 1, 1024, 0, stream>>>(startl, massl, NNODES,
+                                                        bottomd);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    END_TIMER(ClearKernel2_time);
+
+    START_TIMER;
+    TSNE::SummarizationKernel3d<<<blocks * FACTOR3, THREADS3_3D, 0, stream>>>(
+      countl, childl, massl, YY1, YY2, YY3, NNODES, n, bottomd);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    END_TIMER(SummarizationKernel_time);
+
+    START_TIMER;
+    TSNE::SortKernel3d<<<blocks * FACTOR4, THREADS4, 0, stream>>>(
+      sortl, countl, startl, childl, NNODES, n, bottomd);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    END_TIMER(SortKernel_time);
+
+    START_TIMER;
+    TSNE::RepulsionKernel3d<<<blocks * FACTOR5, THREADS5, 0, stream>>>(
+      theta, epssq, sortl, childl, massl, YY1, YY2, YY3, rep_forces,
+      rep_forces + n, rep_forces + 2 * n, Z_norm, theta_squared, NNODES,
+      EIGHT_NNODES, n, radiusd_squared, maxdepthd);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    END_TIMER(RepulsionTime);
+
+    START_TIMER;
+    TSNE::Find_Normalization<<<1, 1, 0, stream>>>(Z_norm, n);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    END_TIMER(Reduction_time);
+
+    START_TIMER;
+    TSNE::get_norm3d<<<MLCommon::ceildiv(n, 1024), 1024, 0, stream>>>(
+      YY1, YY2, YY3, norm, norm_add1, n);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    TSNE::
+      attractive_kernel_bh3d<<<MLCommon::ceildiv(NNZ, 1024), 1024, 0, stream>>>(
+        VAL, COL, ROW, YY1, YY2, YY3, norm, norm_add1, attr_forces,
+        attr_forces + n, attr_forces + 2 * n, NNZ);
+    CUDA_CHECK(cudaPeekAtLastError());
+    END_TIMER(attractive_time);
+
+    START_TIMER;
+    TSNE::IntegrationKernel3d<<<blocks * FACTOR6, THREADS6, 0, stream>>>(
+      learning_rate, momentum, YY1, YY2, YY3, attr_forces, attr_forces + n,
+      attr_forces + 2 * n, rep_forces, rep_forces + n, rep_forces + 2 * n,
+      gains_bh, old_forces, Z_norm, n);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    END_TIMER(IntegrationKernel_time);
+  };
+
+#if CUDART_VERSION >= 10010
+  const bool use_graph = !verbose && stream != 0;
+  cudaGraphExec_t graph_exec;
+  bool graph_ready = false;
+#endif
+
+  for (int iter = 0; iter < max_iter; iter++) {
+    if (iter == exaggeration_iter) {
+      momentum = post_momentum;
+      // Divide perplexities
+      const float div = 1.0f / early_exaggeration;
+      MLCommon::LinAlg::scalarMultiply(VAL, VAL, div, NNZ, stream);
+#if CUDART_VERSION >= 10010
+      // The launches of the last phase hold the old momentum
+      if (graph_ready) CUDA_CHECK(cudaGraphExecDestroy(graph_exec));
+      graph_ready = false;
+#endif
+    }
+
+#if CUDART_VERSION >= 10010
+    if (use_graph) {
+      if (!graph_ready) {
+        cudaGraph_t graph;
+        CUDA_CHECK(
+          cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal));
+        iteration();
+        CUDA_CHECK(cudaStreamEndCapture(stream, &graph));
+        CUDA_CHECK(cudaGraphInstantiate(&graph_exec, graph, NULL, NULL, 0));
+        CUDA_CHECK(cudaGraphDestroy(graph));
+        graph_ready = true;
+      }
+      CUDA_CHECK(cudaGraphLaunch(graph_exec, stream));
+    } else {
+      iteration();
+    }
+#else
+    iteration();
+#endif
+
+    if (iter > exaggeration_iter && iter % BH_CHECK_EVERY == 0) {
+      CUDA_CHECK(cudaMemsetAsync(grad_norm, 0, sizeof(float), stream));
+      TSNE::GradientNormKernel3d<<<blocks * FACTOR6, THREADS6, 0, stream>>>(
+        attr_forces, attr_forces + n, attr_forces + 2 * n, rep_forces,
+        rep_forces + n, rep_forces + 2 * n, Z_norm, grad_norm, n);
+      CUDA_CHECK(cudaPeekAtLastError());
+      float gradient_norm;
+      MLCommon::updateHost(&gradient_norm, grad_norm, 1, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+      gradient_norm = sqrtf(gradient_norm);
+
+      if (gradient_norm < min_grad_norm) {
+        if (verbose)
+          printf(
+            "Gradient norm = %f <= min_grad_norm = %f. Early stopped at iter "
+            "= %d\n",
+            gradient_norm, min_grad_norm, iter);
+        break;
+      }
+    }
+  }
+#if CUDART_VERSION >= 10010
+  if (graph_ready) CUDA_CHECK(cudaGraphExecDestroy(graph_exec));
+#endif
+  PRINT_TIMES;
+
+  // Copy final YY into true output Y
+  for (int d = 0; d < 3; d++)
+    MLCommon::copyAsync(Y + d * n, YY + d * (nnodes + 1), n, stream);
+}
+
+}  // namespace TSNE
+}  // namespace ML
@@ -839,5 +839,34 @@ IntegrationKernel(const float eta,
   }
 }
 
+/**
+ * Sums the squared gradients IntegrationKernel applied over all points into
+ * grad_norm, for the convergence checks. blockDim must be a multiple of 32.
+ */
+__global__ void
+GradientNormKernel(const float *restrict attract1,
+                   const float *restrict attract2,
+                   const float *restrict repel1,
+                   const float *restrict repel2,
+                   const float *restrict Z,
+                   float *restrict grad_norm,
+                   const int N)
+{
+  const int inc = blockDim.x * gridDim.x;
+  const float Z_norm = Z[0];
+  float sum = 0.0f;
+
+  for (int i = threadIdx.x + blockIdx.x * blockDim.x; i < N; i += inc)
+  {
+    const float dx = attract1[i] - Z_norm * repel1[i];
+    const float dy = attract2[i] - Z_norm * repel2[i];
+    sum += dx * dx + dy * dy;
+  }
+
+  for (int offset = warpSize / 2; offset > 0; offset /= 2)
+    sum += __shfl_down_sync(0xffffffff, sum, offset);
+  if ((threadIdx.x & (warpSize - 1)) == 0) atomicAdd(grad_norm, sum);
+}
+
 }  // namespace TSNE
 }  // namespace ML
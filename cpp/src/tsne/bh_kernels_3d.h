@@ -0,0 +1,824 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "bh_kernels.h"
+
+/**
+ * The octree variants of the Barnes Hut kernels, for 3D embeddings. Every
+ * cell has 8 children instead of 4, and the state independent of the number
+ * of children (InitializationKernel, Reset_Normalization, ClearKernel1,
+ * ClearKernel2 and Find_Normalization) is shared with the quadtree.
+ */
+
+// 8 children per cell double the shared memory of the summarization
+#define THREADS3_3D 512
+
+namespace ML {
+namespace TSNE {
+
+/**
+ * Figures the bounding box of all the points in the embedding.
+ */
+__global__ __launch_bounds__(THREADS1, FACTOR1) void
+BoundingBoxKernel3d(int *restrict startd,
+                    int *restrict childd,
+                    float *restrict massd,
+                    float *restrict posxd,
+                    float *restrict posyd,
+                    float *restrict poszd,
+                    float *restrict maxxd,
+                    float *restrict maxyd,
+                    float *restrict maxzd,
+                    float *restrict minxd,
+                    float *restrict minyd,
+                    float *restrict minzd,
+                    const int EIGHT_NNODES,
+                    const int NNODES,
+                    const int N,
+                    unsigned *restrict limiter,
+                    float *restrict radiusd)
+{
+  float val, minx, maxx, miny, maxy, minz, maxz;
+  __shared__ float sminx[THREADS1], smaxx[THREADS1], sminy[THREADS1],
+    smaxy[THREADS1], sminz[THREADS1], smaxz[THREADS1];
+
+  // initialize with valid data (in case #bodies < #threads)
+  minx = maxx = posxd[0];
+  miny = maxy = posyd[0];
+  minz = maxz = poszd[0];
+
+  // scan all bodies
+  const int i = threadIdx.x;
+  const int inc = THREADS1 * gridDim.x;
+  for (int j = i + blockIdx.x * THREADS1; j < N; j += inc)
+  {
+    val = posxd[j];
+    if (val < minx)      minx = val;
+    else if (val > maxx) maxx = val;
+
+    val = posyd[j];
+    if (val < miny)      miny = val;
+    else if (val > maxy) maxy = val;
+
+    val = poszd[j];
+    if (val < minz)      minz = val;
+    else if (val > maxz) maxz = val;
+  }
+
+  // reduction in shared memory
+  sminx[i] = minx;
+  smaxx[i] = maxx;
+  sminy[i] = miny;
+  smaxy[i] = maxy;
+  sminz[i] = minz;
+  smaxz[i] = maxz;
+
+  for (int j = THREADS1 / 2; j > i; j /= 2)
+  {
+    __syncthreads();
+    const int k = i + j;
+    sminx[i] = minx = fminf(minx, sminx[k]);
+    smaxx[i] = maxx = fmaxf(maxx, smaxx[k]);
+    sminy[i] = miny = fminf(miny, sminy[k]);
+    smaxy[i] = maxy = fmaxf(maxy, smaxy[k]);
+    sminz[i] = minz = fminf(minz, sminz[k]);
+    smaxz[i] = maxz = fmaxf(maxz, smaxz[k]);
+  }
+
+  if (i == 0)
+  {
+    // write block result to global memory
+    const int k = blockIdx.x;
+    minxd[k] = minx;
+    maxxd[k] = maxx;
+    minyd[k] = miny;
+    maxyd[k] = maxy;
+    minzd[k] = minz;
+    maxzd[k] = maxz;
+    __threadfence();
+
+    const int inc = gridDim.x - 1;
+    if (inc != atomicInc(limiter, inc)) return;
+
+    // I'm the last block, so combine all block results
+    for (int j = 0; j <= inc; j++)
+    {
+      minx = fminf(minx, minxd[j]);
+      maxx = fmaxf(maxx, maxxd[j]);
+      miny = fminf(miny, minyd[j]);
+      maxy = fmaxf(maxy, maxyd[j]);
+      minz = fminf(minz, minzd[j]);
+      maxz = fmaxf(maxz, maxzd[j]);
+    }
+
+    // compute 'radius'
+    atomicExch(radiusd,
+               fmaxf(fmaxf(maxx - minx, maxy - miny), maxz - minz) * 0.5f +
+                 1e-5f);
+
+    massd[NNODES] = -1.0f;
+    startd[NNODES] = 0;
+    posxd[NNODES] = (minx + maxx) * 0.5f;
+    posyd[NNODES] = (miny + maxy) * 0.5f;
+    poszd[NNODES] = (minz + maxz) * 0.5f;
+
+    #pragma unroll
+    for (int a = 0; a < 8; a++)
+      childd[EIGHT_NNODES + a] = -1;
+  }
+}
+
+
+/**
+ * Build the actual octree.
+ */
+__global__ __launch_bounds__(THREADS2, FACTOR2) void
+TreeBuildingKernel3d(int *restrict childd,
+                     const float *restrict posxd,
+                     const float *restrict posyd,
+                     const float *restrict poszd,
+                     const int NNODES,
+                     const int N,
+                     int *restrict maxdepthd,
+                     int *restrict bottomd,
+                     const float *restrict radiusd)
+{
+  int j, depth;
+  float x, y, z, r;
+  float px, py, pz;
+  int ch, n, locked, patch;
+
+  // cache root data
+  const float radius = radiusd[0];
+  const float rootx = posxd[NNODES];
+  const float rooty = posyd[NNODES];
+  const float rootz = poszd[NNODES];
+
+  int localmaxdepth = 1;
+  int skip = 1;
+  const int inc = blockDim.x * gridDim.x;
+  int i = threadIdx.x + blockIdx.x * blockDim.x;
+
+  // iterate over all bodies assigned to thread
+  while (i < N)
+  {
+    if (skip != 0)
+    {
+      // new body, so start traversing at root
+      skip = 0;
+      n = NNODES;
+      depth = 1;
+      r = radius * 0.5f;
+
+      x = rootx + ( (rootx < (px = posxd[i])) ?
+                    (j = 1, r) : (j = 0, -r) );
+
+      y = rooty + ( (rooty < (py = posyd[i])) ?
+                    (j |= 2, r) : (-r) );
+
+      z = rootz + ( (rootz < (pz = poszd[i])) ?
+                    (j |= 4, r) : (-r) );
+    }
+
+    // follow path to leaf cell
+    while ((ch = childd[n * 8 + j]) >= N)
+    {
+      n = ch;
+      depth++;
+      r *= 0.5f;
+
+      // determine which child to follow
+      x += ( (x < px) ?
+             (j = 1, r) : (j = 0, -r) );
+
+      y += ( (y < py) ?
+             (j |= 2, r) : (-r) );
+
+      z += ( (z < pz) ?
+             (j |= 4, r) : (-r) );
+    }
+
+
+    if (ch != -2)
+    {
+      // skip if child pointer is locked and try again later
+      locked = n * 8 + j;
+
+      if (ch == -1)
+      {
+        if (atomicCAS(&childd[locked], -1, i) == -1)
+        {
+          if (depth > localmaxdepth)
+            localmaxdepth = depth;
+
+          i += inc;  // move on to next body
+          skip = 1;
+        }
+      }
+      else
+      {
+        if (ch == atomicCAS(&childd[locked], ch, -2))
+        {
+          // try to lock
+          patch = -1;
+
+          while (ch >= 0)
+          {
+            depth++;
+
+            const int cell = atomicSub(bottomd, 1) - 1;
+            if (cell <= N) {
+              atomicExch(bottomd, NNODES);
+            }
+
+            if (patch != -1)
+              childd[n * 8 + j] = cell;
+
+            if (cell > patch)
+              patch = cell;
+
+            j = (x < posxd[ch]) ? 1 : 0;
+            if (y < posyd[ch])
+              j |= 2;
+            if (z < poszd[ch])
+              j |= 4;
+
+            childd[cell * 8 + j] = ch;
+            n = cell;
+            r *= 0.5f;
+
+            x += (
+                (x < px) ?
+                (j = 1, r) : (j = 0, -r)
+              );
+
+            y += (
+                (y < py) ?
+                (j |= 2, r) : (-r)
+              );
+
+            z += (
+                (z < pz) ?
+                (j |= 4, r) : (-r)
+              );
+
+            ch = childd[n * 8 + j];
+            if (r <= 1e-10) break;
+          }
+
+          childd[n * 8 + j] = i;
+
+          if (depth > localmaxdepth)
+            localmaxdepth = depth;
+
+          i += inc;  // move on to next body
+          skip = 2;
+        }
+      }
+    }
+    __threadfence();
+
+    if (skip == 2)
+      childd[locked] = patch;
+  }
+
+  // record maximum tree depth
+  if (localmaxdepth > 32)
+    localmaxdepth = 32;
+
+  atomicMax(maxdepthd, localmaxdepth);
+}
+
+
+/**
+ * Summarize the octree via cell gathering
+ */
+__global__ __launch_bounds__(THREADS3_3D, FACTOR3) void
+SummarizationKernel3d(int *restrict countd,
+                      const int *restrict childd,
+                      volatile float *restrict massd,
+                      float *restrict posxd,
+                      float *restrict posyd,
+                      float *restrict poszd,
+                      const int NNODES,
+                      const int N,
+                      const int *restrict bottomd)
+{
+  bool flag = 0;
+  float cm, px, py, pz;
+  __shared__ int child[THREADS3_3D * 8];
+  __shared__ float mass[THREADS3_3D * 8];
+
+  const int bottom = bottomd[0];
+  const int inc = blockDim.x * gridDim.x;
+  int k = (bottom & -32) + threadIdx.x + blockIdx.x * blockDim.x;
+  if (k < bottom) k += inc;
+
+  const int restart = k;
+
+  for (int j = 0; j < 5; j++) // wait-free pre-passes
+  {
+    // iterate over all cells assigned to thread
+    while (k <= NNODES)
+    {
+      if (massd[k] < 0.0f)
+      {
+        for (int i = 0; i < 8; i++)
+        {
+          const int ch = childd[k * 8 + i];
+          child[i * THREADS3_3D + threadIdx.x] = ch;
+
+          if ((ch >= N) and
+              ((mass[i * THREADS3_3D + threadIdx.x] = massd[ch]) < 0))
+            goto CONTINUE_LOOP;
+        }
+
+        // all children are ready
+        cm = 0.0f;
+        px = 0.0f;
+        py = 0.0f;
+        pz = 0.0f;
+        int cnt = 0;
+
+        #pragma unroll
+        for (int i = 0; i < 8; i++)
+        {
+          const int ch = child[i * THREADS3_3D + threadIdx.x];
+          if (ch >= 0)
+          {
+            const float m =
+              (ch >= N) ? (cnt += countd[ch], mass[i * THREADS3_3D + threadIdx.x])
+                        : (cnt++, massd[ch]);
+            // add child's contribution
+            cm += m;
+            px += posxd[ch] * m;
+            py += posyd[ch] * m;
+            pz += poszd[ch] * m;
+          }
+        }
+
+        countd[k] = cnt;
+        const float m = 1.0f / cm;
+        posxd[k] = px * m;
+        posyd[k] = py * m;
+        poszd[k] = pz * m;
+        __threadfence();  // make sure data are visible before setting mass
+        massd[k] = cm;
+      }
+
+      CONTINUE_LOOP:
+      k += inc;  // move on to next cell
+    }
+    k = restart;
+  }
+
+
+  int j = 0;
+  // iterate over all cells assigned to thread
+  while (k <= NNODES)
+  {
+    if (massd[k] >= 0)
+    {
+      k += inc;
+      goto SKIP_LOOP;
+    }
+
+
+    if (j == 0)
+    {
+      j = 8;
+      for (int i = 0; i < 8; i++)
+      {
+        const int ch = childd[k * 8 + i];
+
+        child[i * THREADS3_3D + threadIdx.x] = ch;
+        if ((ch < N) or
+           ((mass[i * THREADS3_3D + threadIdx.x] = massd[ch]) >= 0))
+          j--;
+
+      }
+    }
+    else
+    {
+      j = 8;
+      for (int i = 0; i < 8; i++)
+      {
+        const int ch = child[i * THREADS3_3D + threadIdx.x];
+
+        if ((ch < N) or
+           (mass[i * THREADS3_3D + threadIdx.x] >= 0) or
+           ((mass[i * THREADS3_3D + threadIdx.x] = massd[ch]) >= 0))
+          j--;
+
+      }
+    }
+
+    if (j == 0)
+    {
+      // all children are ready
+      cm = 0.0f;
+      px = 0.0f;
+      py = 0.0f;
+      pz = 0.0f;
+      int cnt = 0;
+
+      #pragma unroll
+      for (int i = 0; i < 8; i++)
+      {
+        const int ch = child[i * THREADS3_3D + threadIdx.x];
+        if (ch >= 0)
+        {
+          const float m =
+            (ch >= N) ? (cnt += countd[ch], mass[i * THREADS3_3D + threadIdx.x])
+                      : (cnt++, massd[ch]);
+          // add child's contribution
+          cm += m;
+          px += posxd[ch] * m;
+          py += posyd[ch] * m;
+          pz += poszd[ch] * m;
+        }
+      }
+
+      countd[k] = cnt;
+      const float m = 1.0f / cm;
+      posxd[k] = px * m;
+      posyd[k] = py * m;
+      poszd[k] = pz * m;
+      flag = 1;
+    }
+
+
+    SKIP_LOOP:
+    __syncthreads();
+    if (flag != 0)
+    {
+      massd[k] = cm;
+      k += inc;
+      flag = 0;
+    }
+  }
+}
+
+
+/**
+ * Sort the cells
+ */
+__global__ __launch_bounds__(THREADS4, FACTOR4) void
+SortKernel3d(int *restrict sortd,
+             const int *restrict countd,
+             volatile int *restrict startd,
+             int *restrict childd,
+             const int NNODES,
+             const int N,
+             const int *restrict bottomd)
+{
+  const int bottom = bottomd[0];
+  const int dec = blockDim.x * gridDim.x;
+  int k = NNODES + 1 - dec + threadIdx.x + blockIdx.x * blockDim.x;
+  int start;
+  int limiter = 0;
+
+  // iterate over all cells assigned to thread
+  while (k >= bottom)
+  {
+    // To control possible infinite loops
+    if (++limiter > NNODES)
+      break;
+
+    // Not a child so skip
+    if ((start = startd[k]) < 0)
+      continue;
+
+
+    int j = 0;
+    for (int i = 0; i < 8; i++)
+    {
+      const int ch = childd[k * 8 + i];
+      if (ch >= 0)
+      {
+        if (i != j)
+        {
+          // move children to front (needed later for speed)
+          childd[k * 8 + i] = -1;
+          childd[k * 8 + j] = ch;
+        }
+        if (ch >= N)
+        {
+          // child is a cell
+          startd[ch] = start;
+          start += countd[ch];  // add #bodies in subtree
+        }
+        else if (start <= NNODES and start >= 0)
+        {
+          // child is a body
+          sortd[start++] = ch;
+        }
+        j++;
+      }
+    }
+    k -= dec;  // move on to next cell
+  }
+}
+
+
+/**
+ * Calculate the repulsive forces using the octree
+ */
+__global__ __launch_bounds__(THREADS5, FACTOR5) void
+RepulsionKernel3d(const float theta,
+                  const float epssqd,  // correction for zero distance
+                  const int *restrict sortd,
+                  const int *restrict childd,
+                  const float *restrict massd,
+                  const float *restrict posxd,
+                  const float *restrict posyd,
+                  const float *restrict poszd,
+                  float *restrict velxd,
+                  float *restrict velyd,
+                  float *restrict velzd,
+                  float *restrict Z_norm,
+                  const float theta_squared,
+                  const int NNODES,
+                  const int EIGHT_NNODES,
+                  const int N,
+                  const float *restrict radiusd_squared,
+                  const int *restrict maxdepthd)
+{
+  const float EPS_PLUS_1 = epssqd + 1.0f;
+
+  __shared__ int pos[THREADS5], node[THREADS5];
+  __shared__ float dq[THREADS5];
+
+  if (threadIdx.x == 0)
+  {
+    const int max_depth = maxdepthd[0];
+    dq[0] = __fdividef(radiusd_squared[0], theta_squared);
+
+    for (int i = 1; i < max_depth; i++)
+    {
+      dq[i] = dq[i - 1] * 0.25f;
+      dq[i - 1] += epssqd;
+    }
+    dq[max_depth - 1] += epssqd;
+
+    // Add one so EPS_PLUS_1 can be compared
+    for (int i = 0; i < max_depth; i++)
+      dq[i] += 1.0f;
+  }
+
+
+  __syncthreads();
+  // figure out first thread in each warp (lane 0)
+  const int sbase = (threadIdx.x / 32) * 32;
+  const bool SBASE_EQ_THREAD = (sbase == threadIdx.x);
+
+  // make multiple copies to avoid index calculations later
+  const int diff = threadIdx.x - sbase;
+  dq[diff + sbase] = dq[diff];
+
+  __threadfence_block();
+
+  // iterate over all bodies assigned to thread
+  const int MAX_SIZE = EIGHT_NNODES + 8;
+
+  for (int k = threadIdx.x + blockIdx.x * blockDim.x; k < N; k += blockDim.x * gridDim.x)
+  {
+    const int i = sortd[k];  // get permuted/sorted index
+    // cache position info
+    if (i < 0 or i >= MAX_SIZE)
+      continue;
+
+    const float px = posxd[i];
+    const float py = posyd[i];
+    const float pz = poszd[i];
+
+    float vx = 0.0f;
+    float vy = 0.0f;
+    float vz = 0.0f;
+    float normsum = 0.0f;
+
+    // initialize iteration stack, i.e., push root node onto stack
+    int depth = sbase;
+
+    if (SBASE_EQ_THREAD == true)
+    {
+      pos[sbase] = 0;
+      node[sbase] = EIGHT_NNODES;
+    }
+
+    do {
+
+      // stack is not empty
+      int pd = pos[depth];
+      int nd = node[depth];
+
+
+      while (pd < 8)
+      {
+        const int index = nd + pd++;
+        if (index < 0 or index >= MAX_SIZE)
+          break;
+
+        const int n = childd[index];  // load child pointer
+
+        // Non child
+        if (n < 0 or n > NNODES)
+          break;
+
+        const float dx = px - posxd[n];
+        const float dy = py - posyd[n];
+        const float dz = pz - poszd[n];
+        const float dxyz1 = dx*dx + dy*dy + dz*dz + EPS_PLUS_1;
+
+
+        if ((n < N) or __all_sync(__activemask(), dxyz1 >= dq[depth]))
+        {
+          const float tdist_2 = __fdividef(massd[n], dxyz1 * dxyz1);
+          normsum += tdist_2 * dxyz1;
+          vx += dx * tdist_2;
+          vy += dy * tdist_2;
+          vz += dz * tdist_2;
+        }
+        else
+        {
+          // push cell onto stack
+          if (SBASE_EQ_THREAD == true)
+          {
+            pos[depth] = pd;
+            node[depth] = nd;
+          }
+          depth++;
+          pd = 0;
+          nd = n * 8;
+        }
+      }
+
+
+    } while (--depth >= sbase); // done with this level
+
+
+    // update velocity
+    velxd[i] += vx;
+    velyd[i] += vy;
+    velzd[i] += vz;
+    atomicAdd(Z_norm, normsum);
+  }
+}
+
+
+/**
+ * Find the norm(Y)
+ */
+__global__ void
+get_norm3d(const float *restrict Y1,
+           const float *restrict Y2,
+           const float *restrict Y3,
+           float *restrict norm,
+           float *restrict norm_add1,
+           const int N)
+{
+  const int i = (blockIdx.x * blockDim.x) + threadIdx.x;
+  if (i >= N) return;
+  norm[i] = Y1[i] * Y1[i] + Y2[i] * Y2[i] + Y3[i] * Y3[i];
+  norm_add1[i] = norm[i] + 1.0f;
+}
+
+/**
+ * Fast attractive kernel. Uses COO matrix.
+ */
+__global__ void
+attractive_kernel_bh3d(const float *restrict VAL,
+                       const int *restrict COL,
+                       const int *restrict ROW,
+                       const float *restrict Y1,
+                       const float *restrict Y2,
+                       const float *restrict Y3,
+                       const float *restrict norm,
+                       const float *restrict norm_add1,
+                       float *restrict attract1,
+                       float *restrict attract2,
+                       float *restrict attract3,
+                       const int NNZ)
+{
+  const int index = (blockIdx.x * blockDim.x) + threadIdx.x;
+  if (index >= NNZ) return;
+  const int i = ROW[index];
+  const int j = COL[index];
+
+  const float PQ = __fdividef(
+    VAL[index],
+    norm_add1[i] + norm[j] -
+      2.0f * (Y1[i] * Y1[j] + Y2[i] * Y2[j] + Y3[i] * Y3[j]));  // P*Q
+
+  // Apply forces
+  atomicAdd(&attract1[i], PQ * (Y1[i] - Y1[j]));
+  atomicAdd(&attract2[i], PQ * (Y2[i] - Y2[j]));
+  atomicAdd(&attract3[i], PQ * (Y3[i] - Y3[j]));
+}
+
+/**
+ * The gain and momentum update of one coordinate, as in IntegrationKernel.
+ */
+__device__ float
+integrate_coordinate(const float eta,
+                     const float momentum,
+                     const float d,
+                     float *restrict gains,
+                     float *restrict old_forces)
+{
+  float u = old_forces[0];
+  float g = (signbit(d) != signbit(u)) ? gains[0] + 0.2f : gains[0] * 0.8f;
+  if (g < 0.01f) g = 0.01f;
+  gains[0] = g;
+  old_forces[0] = u = momentum * u - eta * g * d;
+  return u;
+}
+
+/**
+ * Apply gradient updates.
+ */
+__global__ __launch_bounds__(THREADS6, FACTOR6) void
+IntegrationKernel3d(const float eta,
+                    const float momentum,
+                    float *restrict Y1,
+                    float *restrict Y2,
+                    float *restrict Y3,
+                    const float *restrict attract1,
+                    const float *restrict attract2,
+                    const float *restrict attract3,
+                    const float *restrict repel1,
+                    const float *restrict repel2,
+                    const float *restrict repel3,
+                    float *restrict gains,
+                    float *restrict old_forces,
+                    const float *restrict Z,
+                    const int N)
+{
+  // iterate over all bodies assigned to thread
+  const int inc = blockDim.x * gridDim.x;
+  const float Z_norm = Z[0];
+
+  for (int i = threadIdx.x + blockIdx.x * blockDim.x; i < N; i += inc)
+  {
+    const float dx = attract1[i] - Z_norm * repel1[i];
+    const float dy = attract2[i] - Z_norm * repel2[i];
+    const float dz = attract3[i] - Z_norm * repel3[i];
+
+    Y1[i] += integrate_coordinate(eta, momentum, dx, gains + i,
+                                  old_forces + i);
+    Y2[i] += integrate_coordinate(eta, momentum, dy, gains + N + i,
+                                  old_forces + N + i);
+    Y3[i] += integrate_coordinate(eta, momentum, dz, gains + 2 * N + i,
+                                  old_forces + 2 * N + i);
+  }
+}
+
+/**
+ * Sums the squared gradients IntegrationKernel3d applied over all points
+ * into grad_norm, for the convergence checks. blockDim must be a multiple
+ * of 32.
+ */
+__global__ void
+GradientNormKernel3d(const float *restrict attract1,
+                     const float *restrict attract2,
+                     const float *restrict attract3,
+                     const float *restrict repel1,
+                     const float *restrict repel2,
+                     const float *restrict repel3,
+                     const float *restrict Z,
+                     float *restrict grad_norm,
+                     const int N)
+{
+  const int inc = blockDim.x * gridDim.x;
+  const float Z_norm = Z[0];
+  float sum = 0.0f;
+
+  for (int i = threadIdx.x + blockIdx.x * blockDim.x; i < N; i += inc)
+  {
+    const float dx = attract1[i] - Z_norm * repel1[i];
+    const float dy = attract2[i] - Z_norm * repel2[i];
+    const float dz = attract3[i] - Z_norm * repel3[i];
+    sum += dx * dx + dy * dy + dz * dz;
+  }
+
+  for (int offset = warpSize / 2; offset > 0; offset /= 2)
+    sum += __shfl_down_sync(0xffffffff, sum, offset);
+  if ((threadIdx.x & (warpSize - 1)) == 0) atomicAdd(grad_norm, sum);
+}
+
+}  // namespace TSNE
+}  // namespace ML
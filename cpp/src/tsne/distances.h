@@ -16,8 +16,11 @@
 
 #pragma once
 
+#include <cuml/neighbors/knn.hpp>
 #include <linalg/eltwise.h>
 #include <selection/knn.h>
+#include <selection/knn_graph.h>
+#include <selection/sparse_knn.h>
 #include "sparse/coo.h"
 #include "utils.h"
 
@@ -32,23 +35,49 @@ namespace TSNE {
  * @output param indices: The output indices from KNN.
  * @output param distances: The output sorted distances from KNN.
  * @input param n_neighbors: The number of nearest neighbors you want.
+ * @input param knn_index: Index of the rows of X searched instead of a brute force KNN if not null.
  * @input param stream: The GPU stream.
  */
 void get_distances(const float *X, const int n, const int p, long *indices,
                    float *distances, const int n_neighbors,
+                   const knnIndex *knn_index,
                    std::shared_ptr<deviceAllocator> d_alloc,
                    cudaStream_t stream) {
+  if (knn_index != nullptr) {
+    ASSERT(knn_index->size() == n && knn_index->dim() == p,
+           "knn_index must hold the %d rows of X", n);
+    knn_index->search(X, n, indices, distances, n_neighbors);
+    return;
+  }
+
   // TODO: for TSNE transform first fit some points then transform with 1/(1+d^2)
   // #861
-  float **knn_input = new float *[1];
-  int *sizes = new int[1];
-  knn_input[0] = (float *)X;
-  sizes[0] = n;
+  MLCommon::Selection::knn_graph_self_join(X, n, p, n_neighbors, true, indices,
+                                           distances, d_alloc, stream);
+}
 
-  MLCommon::Selection::brute_force_knn(knn_input, sizes, 1, p,
-                                       const_cast<float *>(X), n, indices,
-                                       distances, n_neighbors, d_alloc, stream);
-  delete knn_input, sizes;
+/**
+ * @brief Finds the top n_neighbors of the rows of the CSR matrix X, without densifying it.
+ * @input param vals: The nonzero values of X (nnz).
+ * @input param row_ind: The offsets of the rows of X in vals (n + 1).
+ * @input param row_ind_ptr: The column of each nonzero of X (nnz).
+ * @input param nnz: The number of nonzeros of X.
+ * @input param n: The number of rows in the data X.
+ * @input param p: The number of columns in the data X.
+ * @output param indices: The output indices from KNN.
+ * @output param distances: The output sorted distances from KNN.
+ * @input param n_neighbors: The number of nearest neighbors you want.
+ * @input param stream: The GPU stream.
+ */
+void get_distances(const float *vals, const int *row_ind,
+                   const int *row_ind_ptr, const int nnz, const int n,
+                   const int p, long *indices, float *distances,
+                   const int n_neighbors,
+                   std::shared_ptr<deviceAllocator> d_alloc,
+                   cudaStream_t stream) {
+  MLCommon::Selection::sparse_brute_force_knn(
+    vals, row_ind, row_ind_ptr, nnz, n, vals, row_ind, row_ind_ptr, n, p,
+    n_neighbors, indices, distances, d_alloc, stream);
 }
 
 /**
@@ -74,7 +103,7 @@ void normalize_distances(const int n, float *distances, const int n_neighbors,
 }
 
 /**
- * @brief Performs P + P.T.
+ * @brief Performs P + P.T, with one entry per pair of points.
  * @input param P: The perplexity matrix (n, k)
  * @input param indices: The input sorted indices from KNN.
  * @input param n: The number of rows in the data X.
@@ -86,8 +115,9 @@ void normalize_distances(const int n, float *distances, const int n_neighbors,
  * @input param handle: The GPU handle.
  */
 template <int TPB_X = 32>
-void symmetrize_perplexity(float *P, long *indices, const int n, const int k,
-                           const float P_sum, const float exaggeration,
+void symmetrize_perplexity(float *P, const long *indices, const int n,
+                           const int k, const float P_sum,
+                           const float exaggeration,
                            MLCommon::Sparse::COO<float> *COO_Matrix,
                            cudaStream_t stream, const cumlHandle &handle) {
   // Perform (P + P.T) / P_sum * early_exaggeration
@@ -95,12 +125,9 @@ void symmetrize_perplexity(float *P, long *indices, const int n, const int k,
   MLCommon::LinAlg::scalarMultiply(P, P, div, n * k, stream);
 
   // Symmetrize to form P + P.T
-  MLCommon::Sparse::from_knn_symmetrize_matrix(
+  MLCommon::Sparse::from_knn_symmetrize_merged(
     indices, P, n, k, COO_Matrix, stream, handle.getDeviceAllocator());
 
-  handle.getDeviceAllocator()->deallocate(P, sizeof(float) * n * k, stream);
-  handle.getDeviceAllocator()->deallocate(indices, sizeof(long) * n * k,
-                                          stream);
 }
 
 }  // namespace TSNE
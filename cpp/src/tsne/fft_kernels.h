@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cufft.h>
+#include "bh_kernels.h"
+#include "utils.h"
+
+/** check for cufft runtime API errors and assert accordingly */
+#define CUFFT_CHECK(call)                                              \
+  do {                                                                 \
+    cufftResult status = call;                                         \
+    ASSERT(status == CUFFT_SUCCESS, "FAIL: call='%s'. Reason:%d\n", \
+           #call, status);                                             \
+  } while (0)
+
+namespace ML {
+namespace TSNE {
+
+/** Interpolation nodes per box and per dimension */
+#define FFT_N_INTERP 3
+
+/**
+ * The Lagrange weights, over the FFT_N_INTERP nodes of a box at
+ * (k + 0.5) / FFT_N_INTERP, of a point at u in [0, 1] within the box.
+ */
+__device__ void fft_lagrange_weights(const float u, float *w) {
+#pragma unroll
+  for (int k = 0; k < FFT_N_INTERP; k++) {
+    const float xk = (k + 0.5f) / FFT_N_INTERP;
+    float wk = 1.0f;
+#pragma unroll
+    for (int l = 0; l < FFT_N_INTERP; l++) {
+      if (l == k) continue;
+      const float xl = (l + 0.5f) / FFT_N_INTERP;
+      wk *= (u - xl) / (xk - xl);
+    }
+    w[k] = wk;
+  }
+}
+
+/**
+ * The first grid node, along a dimension, of the box of a point at x, and
+ * its Lagrange weights over the nodes of the box.
+ */
+__device__ int fft_point_nodes(const float x, const float coord_min,
+                               const float box_width, const int n_boxes,
+                               float *w) {
+  int box = (int)((x - coord_min) / box_width);
+  box = min(max(box, 0), n_boxes - 1);
+  fft_lagrange_weights((x - coord_min) / box_width - box, w);
+  return box * FFT_N_INTERP;
+}
+
+/**
+ * Spreads the charges 1, Y1 and Y2 of every point onto the grid nodes of
+ * its box. The charge grids are 3 padded 2m x 2m row-major grids,
+ * whose top-left m x m corner holds the nodes.
+ */
+__global__ void fft_spread_kernel(const float *restrict Y1,
+                                  const float *restrict Y2,
+                                  float *restrict charges, const int N,
+                                  const float coord_min, const float box_width,
+                                  const int n_boxes, const int m) {
+  const int i = (blockIdx.x * blockDim.x) + threadIdx.x;
+  if (i >= N) return;
+  float wx[FFT_N_INTERP], wy[FFT_N_INTERP];
+  const float y1 = Y1[i], y2 = Y2[i];
+  const int gx = fft_point_nodes(y1, coord_min, box_width, n_boxes, wx);
+  const int gy = fft_point_nodes(y2, coord_min, box_width, n_boxes, wy);
+  const int grid_len = 4 * m * m;
+#pragma unroll
+  for (int a = 0; a < FFT_N_INTERP; a++) {
+#pragma unroll
+    for (int b = 0; b < FFT_N_INTERP; b++) {
+      const float w = wx[a] * wy[b];
+      const int idx = (gx + a) * 2 * m + gy + b;
+      atomicAdd(charges + idx, w);
+      atomicAdd(charges + grid_len + idx, w * y1);
+      atomicAdd(charges + 2 * grid_len + idx, w * y2);
+    }
+  }
+}
+
+/**
+ * The circulant embeddings, on the padded 2m x 2m grid of spacing h, of
+ * the kernels 1 / (1 + d^2) and 1 / (1 + d^2)^2 between grid nodes.
+ */
+__global__ void fft_kernel_grid_kernel(float *restrict kernels, const int m,
+                                       const float h) {
+  const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
+  const int two_m = 2 * m;
+  if (idx >= two_m * two_m) return;
+  const int a = idx / two_m, b = idx % two_m;
+  float q = 0.0f;
+  if (a != m && b != m) {
+    const float dx = (a < m ? a : a - two_m) * h;
+    const float dy = (b < m ? b : b - two_m) * h;
+    q = 1.0f / (1.0f + dx * dx + dy * dy);
+  }
+  kernels[idx] = q;
+  kernels[two_m * two_m + idx] = q * q;
+}
+
+/**
+ * Multiplies the transformed charges by the transformed kernels, into the
+ * 4 products K1 * 1, K2 * 1, K2 * Y1 and K2 * Y2, scaled for the inverse
+ * transform. len is the size of one transformed grid.
+ */
+__global__ void fft_multiply_kernel(const cufftComplex *restrict kernels_hat,
+                                    const cufftComplex *restrict charges_hat,
+                                    cufftComplex *restrict products_hat,
+                                    const int len, const float scale) {
+  const int idx = (blockIdx.x * blockDim.x) + threadIdx.x;
+  if (idx >= 4 * len) return;
+  const int p = idx / len, e = idx % len;
+  const cufftComplex k = kernels_hat[(p == 0 ? 0 : 1) * len + e];
+  const cufftComplex c = charges_hat[(p == 0 ? 0 : p - 1) * len + e];
+  cufftComplex out;
+  out.x = (k.x * c.x - k.y * c.y) * scale;
+  out.y = (k.x * c.y + k.y * c.x) * scale;
+  products_hat[idx] = out;
+}
+
+/**
+ * Interpolates the 4 potentials back to every point, into its unnormalized
+ * repulsive forces and its contribution to the normalization Z, summed
+ * over the points with the self terms included.
+ */
+__global__ void fft_gather_kernel(const float *restrict Y1,
+                                  const float *restrict Y2,
+                                  const float *restrict potentials,
+                                  float *restrict repel1,
+                                  float *restrict repel2,
+                                  float *restrict Z_norm, const int N,
+                                  const float coord_min, const float box_width,
+                                  const int n_boxes, const int m) {
+  const int i = (blockIdx.x * blockDim.x) + threadIdx.x;
+  if (i >= N) return;
+  float wx[FFT_N_INTERP], wy[FFT_N_INTERP];
+  const float y1 = Y1[i], y2 = Y2[i];
+  const int gx = fft_point_nodes(y1, coord_min, box_width, n_boxes, wx);
+  const int gy = fft_point_nodes(y2, coord_min, box_width, n_boxes, wy);
+  const int grid_len = 4 * m * m;
+  float phi[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+#pragma unroll
+  for (int a = 0; a < FFT_N_INTERP; a++) {
+#pragma unroll
+    for (int b = 0; b < FFT_N_INTERP; b++) {
+      const float w = wx[a] * wy[b];
+      const int idx = (gx + a) * 2 * m + gy + b;
+#pragma unroll
+      for (int p = 0; p < 4; p++) phi[p] += w * potentials[p * grid_len + idx];
+    }
+  }
+  repel1[i] = y1 * phi[1] - phi[2];
+  repel2[i] = y2 * phi[1] - phi[3];
+  atomicAdd(Z_norm, phi[0]);
+}
+
+}  // namespace TSNE
+}  // namespace ML
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <thrust/extrema.h>
+#include <algorithm>
+#include "common/device_buffer.hpp"
+#include "fft_kernels.h"
+#include "utils.h"
+
+namespace ML {
+namespace TSNE {
+
+/** Fewest boxes per dimension of the interpolation grid */
+#define FFT_MIN_BOXES 50
+
+/**
+ * The cuFFT plans of the interpolation grid of m x m nodes, padded to
+ * 2m x 2m, and the grids they transform. They are rebuilt only when m
+ * changes, as the embedding expands.
+ */
+struct FFTGrids {
+  int m;
+  cufftHandle plan_charges, plan_kernels, plan_inverse;
+  MLCommon::device_buffer<float> charges, kernels, potentials;
+  MLCommon::device_buffer<cufftComplex> charges_hat, kernels_hat, products_hat;
+
+  FFTGrids(std::shared_ptr<deviceAllocator> d_alloc, cudaStream_t stream)
+    : m(0),
+      charges(d_alloc, stream),
+      kernels(d_alloc, stream),
+      potentials(d_alloc, stream),
+      charges_hat(d_alloc, stream),
+      kernels_hat(d_alloc, stream),
+      products_hat(d_alloc, stream) {}
+
+  void destroy_plans() {
+    if (m == 0) return;
+    CUFFT_CHECK(cufftDestroy(plan_charges));
+    CUFFT_CHECK(cufftDestroy(plan_kernels));
+    CUFFT_CHECK(cufftDestroy(plan_inverse));
+  }
+
+  void resize(int new_m, cudaStream_t stream) {
+    if (new_m == m) return;
+    destroy_plans();
+    m = new_m;
+
+    const int two_m = 2 * m;
+    const size_t grid_len = size_t(two_m) * two_m;
+    const size_t hat_len = size_t(two_m) * (m + 1);
+    charges.resize(3 * grid_len, stream);
+    kernels.resize(2 * grid_len, stream);
+    potentials.resize(4 * grid_len, stream);
+    charges_hat.resize(3 * hat_len, stream);
+    kernels_hat.resize(2 * hat_len, stream);
+    products_hat.resize(4 * hat_len, stream);
+
+    int dims[2] = {two_m, two_m};
+    CUFFT_CHECK(cufftPlanMany(&plan_charges, 2, dims, NULL, 1, 0, NULL, 1, 0,
+                              CUFFT_R2C, 3));
+    CUFFT_CHECK(cufftPlanMany(&plan_kernels, 2, dims, NULL, 1, 0, NULL, 1, 0,
+                              CUFFT_R2C, 2));
+    CUFFT_CHECK(cufftPlanMany(&plan_inverse, 2, dims, NULL, 1, 0, NULL, 1, 0,
+                              CUFFT_C2R, 4));
+    CUFFT_CHECK(cufftSetStream(plan_charges, stream));
+    CUFFT_CHECK(cufftSetStream(plan_kernels, stream));
+    CUFFT_CHECK(cufftSetStream(plan_inverse, stream));
+  }
+};
+
+/**
+ * @brief Fast Dimensionality reduction via TSNE, with the repulsive forces interpolated on a grid and convolved by FFT O(N) (FIt-SNE [1]). 2D embeddings only.
+ * [1] Linderman, G. et al, 2019. "Fast interpolation-based t-SNE for improved visualization of single-cell RNA-seq data"
+ * @input param VAL: The values in the attractive forces COO matrix.
+ * @input param COL: The column indices in the attractive forces COO matrix.
+ * @input param ROW: The row indices in the attractive forces COO matrix.
+ * @input param NNZ: The number of non zeros in the attractive forces COO matrix.
+ * @input param handle: The GPU handle.
+ * @output param Y: The final embedding (n, 2) in column-major. Will overwrite this internally.
+ * @input param n: Number of rows in data X.
+ * @input param early_exaggeration: How much early pressure you want the clusters in TSNE to spread out more.
+ * @input param exaggeration_iter: How many iterations you want the early pressure to run for.
+ * @input param min_gain: Rounds up small gradient updates.
+ * @input param pre_learning_rate: The learning rate during the exaggeration phase.
+ * @input param post_learning_rate: The learning rate after the exaggeration phase.
+ * @input param max_iter: The maximum number of iterations TSNE should run for.
+ * @input param min_grad_norm: The smallest gradient norm TSNE should terminate on.
+ * @input param pre_momentum: The momentum used during the exaggeration phase.
+ * @input param post_momentum: The momentum used after the exaggeration phase.
+ * @input param random_state: Set this to -1 for pure random intializations or >= 0 for reproducible outputs.
+ * @input param verbose: Whether to print error messages or not.
+ * @input param intialize_embeddings: Whether to overwrite the current Y vector with random noise.
+ */
+void FFT_TSNE(float *VAL, const int *COL, const int *ROW, const int NNZ,
+              const cumlHandle &handle, float *Y, const int n,
+              const float early_exaggeration = 12.0f,
+              const int exaggeration_iter = 250, const float min_gain = 0.01f,
+              const float pre_learning_rate = 200.0f,
+              const float post_learning_rate = 500.0f,
+              const int max_iter = 1000, const float min_grad_norm = 1e-7,
+              const float pre_momentum = 0.5, const float post_momentum = 0.8,
+              const long long random_state = -1, const bool verbose = true,
+              const bool intialize_embeddings = true) {
+  auto d_alloc = handle.getDeviceAllocator();
+  cudaStream_t stream = handle.getStream();
+  const int blocks = MLCommon::getMultiProcessorCount();
+
+  if (intialize_embeddings)
+    random_vector(Y, -0.0001f, 0.0001f, n * 2, stream, random_state);
+  float *Y1 = Y;
+  float *Y2 = Y + n;
+
+  // Allocate space
+  //---------------------------------------------------
+  if (verbose) printf("[Info] Now allocating memory for TSNE.\n");
+  MLCommon::device_buffer<float> attr_forces(d_alloc, stream, n * 2);
+  MLCommon::device_buffer<float> rep_forces(d_alloc, stream, n * 2);
+  MLCommon::device_buffer<float> norm(d_alloc, stream, n);
+  MLCommon::device_buffer<float> norm_add1(d_alloc, stream, n);
+  MLCommon::device_buffer<float> Z_norm(d_alloc, stream, 1);
+
+  MLCommon::device_buffer<float> gains(d_alloc, stream, n * 2);
+  thrust::device_ptr<float> begin_gains =
+    thrust::device_pointer_cast(gains.data());
+  thrust::fill(thrust::cuda::par.on(stream), begin_gains, begin_gains + n * 2,
+               1.0f);
+
+  MLCommon::device_buffer<float> old_forces(d_alloc, stream, n * 2);
+  CUDA_CHECK(
+    cudaMemsetAsync(old_forces.data(), 0, sizeof(float) * n * 2, stream));
+
+  FFTGrids grids(d_alloc, stream);
+  //---------------------------------------------------
+
+  if (verbose) printf("[Info] Start gradient updates!\n");
+  float momentum = pre_momentum;
+  float learning_rate = pre_learning_rate;
+  thrust::device_ptr<float> begin_Y = thrust::device_pointer_cast(Y);
+
+  for (int iter = 0; iter < max_iter; iter++) {
+    if (iter == exaggeration_iter) {
+      momentum = post_momentum;
+      // Divide perplexities
+      const float div = 1.0f / early_exaggeration;
+      MLCommon::LinAlg::scalarMultiply(VAL, VAL, div, NNZ, stream);
+      learning_rate = post_learning_rate;
+    }
+
+    START_TIMER;
+    // The square box of the embedding, split into boxes of width about 1,
+    // each holding FFT_N_INTERP x FFT_N_INTERP equispaced grid nodes
+    auto minmax = thrust::minmax_element(thrust::cuda::par.on(stream),
+                                         begin_Y, begin_Y + n * 2);
+    const float coord_min = *minmax.first;
+    float coord_range = *minmax.second - coord_min;
+    if (coord_range <= 0.0f) coord_range = 1.0f;
+    const int n_boxes = std::max(FFT_MIN_BOXES, (int)ceilf(coord_range));
+    const float box_width = coord_range / n_boxes;
+    const float h = box_width / FFT_N_INTERP;
+    const int m = n_boxes * FFT_N_INTERP;
+    grids.resize(m, stream);
+
+    const int grid_len = 4 * m * m;
+    const int hat_len = 2 * m * (m + 1);
+
+    CUDA_CHECK(cudaMemsetAsync(grids.charges.data(), 0,
+                               sizeof(float) * 3 * grid_len, stream));
+    TSNE::fft_spread_kernel<<<MLCommon::ceildiv(n, 1024), 1024, 0, stream>>>(
+      Y1, Y2, grids.charges.data(), n, coord_min, box_width, n_boxes, m);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    TSNE::fft_kernel_grid_kernel<<<MLCommon::ceildiv(grid_len, 1024), 1024, 0,
+                                   stream>>>(grids.kernels.data(), m, h);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    CUFFT_CHECK(cufftExecR2C(grids.plan_kernels, grids.kernels.data(),
+                             grids.kernels_hat.data()));
+    CUFFT_CHECK(cufftExecR2C(grids.plan_charges, grids.charges.data(),
+                             grids.charges_hat.data()));
+    TSNE::fft_multiply_kernel<<<MLCommon::ceildiv(4 * hat_len, 1024), 1024, 0,
+                                stream>>>(
+      grids.kernels_hat.data(), grids.charges_hat.data(),
+      grids.products_hat.data(), hat_len, 1.0f / grid_len);
+    CUDA_CHECK(cudaPeekAtLastError());
+    CUFFT_CHECK(cufftExecC2R(grids.plan_inverse, grids.products_hat.data(),
+                             grids.potentials.data()));
+
+    CUDA_CHECK(cudaMemsetAsync(Z_norm.data(), 0, sizeof(float), stream));
+    TSNE::fft_gather_kernel<<<MLCommon::ceildiv(n, 1024), 1024, 0, stream>>>(
+      Y1, Y2, grids.potentials.data(), rep_forces.data(),
+      rep_forces.data() + n, Z_norm.data(), n, coord_min, box_width, n_boxes,
+      m);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    TSNE::Find_Normalization<<<1, 1, 0, stream>>>(Z_norm.data(), n);
+    CUDA_CHECK(cudaPeekAtLastError());
+    END_TIMER(RepulsionTime);
+
+    START_TIMER;
+    CUDA_CHECK(
+      cudaMemsetAsync(attr_forces.data(), 0, sizeof(float) * n * 2, stream));
+    TSNE::get_norm<<<MLCommon::ceildiv(n, 1024), 1024, 0, stream>>>(
+      Y1, Y2, norm.data(), norm_add1.data(), n);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    TSNE::
+      attractive_kernel_bh<<<MLCommon::ceildiv(NNZ, 1024), 1024, 0, stream>>>(
+        VAL, COL, ROW, Y1, Y2, norm.data(), norm_add1.data(),
+        attr_forces.data(), attr_forces.data() + n, NNZ);
+    CUDA_CHECK(cudaPeekAtLastError());
+    END_TIMER(attractive_time);
+
+    START_TIMER;
+    TSNE::IntegrationKernel<<<blocks * FACTOR6, THREADS6, 0, stream>>>(
+      learning_rate, momentum, early_exaggeration, Y1, Y2, attr_forces.data(),
+      attr_forces.data() + n, rep_forces.data(), rep_forces.data() + n,
+      gains.data(), gains.data() + n, old_forces.data(), old_forces.data() + n,
+      Z_norm.data(), n);
+    CUDA_CHECK(cudaPeekAtLastError());
+    END_TIMER(IntegrationKernel_time);
+  }
+  PRINT_TIMES;
+
+  grids.destroy_plans();
+}
+
+}  // namespace TSNE
+}  // namespace ML
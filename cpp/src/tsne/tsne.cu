@@ -20,41 +20,22 @@
 #include "utils.h"
 
 #include "barnes_hut.h"
+#include "barnes_hut_3d.h"
 #include "exact_tsne.h"
+#include "fft_tsne.h"
+#include "tsne_mg.h"
 
 namespace ML {
 
 /**
- * @brief Dimensionality reduction via TSNE using either Barnes Hut O(NlogN) or brute force O(N^2).
- * @input param handle: The GPU handle.
- * @input param X: The dataset you want to apply TSNE on.
- * @output param Y: The final embedding. Will overwrite this internally.
- * @input param n: Number of rows in data X.
- * @input param p: Number of columns in data X.
- * @input param dim: Number of output dimensions for embeddings Y.
- * @input param n_neighbors: Number of nearest neighbors used.
- * @input param theta: Float between 0 and 1. Tradeoff for speed (0) vs accuracy (1) for Barnes Hut only.
- * @input param epssq: A tiny jitter to promote numerical stability.
- * @input param perplexity: How many nearest neighbors are used during the construction of Pij.
- * @input param perplexity_max_iter: Number of iterations used to construct Pij.
- * @input param perplexity_tol: The small tolerance used for Pij to ensure numerical stability.
- * @input param early_exaggeration: How much early pressure you want the clusters in TSNE to spread out more.
- * @input param exaggeration_iter: How many iterations you want the early pressure to run for.
- * @input param min_gain: Rounds up small gradient updates.
- * @input param pre_learning_rate: The learning rate during the exaggeration phase.
- * @input param post_learning_rate: The learning rate after the exaggeration phase.
- * @input param max_iter: The maximum number of iterations TSNE should run for.
- * @input param min_grad_norm: The smallest gradient norm TSNE should terminate on.
- * @input param pre_momentum: The momentum used during the exaggeration phase.
- * @input param post_momentum: The momentum used after the exaggeration phase.
- * @input param random_state: Set this to -1 for pure random intializations or >= 0 for reproducible outputs.
- * @input param verbose: Whether to print error messages or not.
- * @input param intialize_embeddings: Whether to overwrite the current Y vector with random noise.
- * @input param barnes_hut: Whether to use the fast Barnes Hut or use the slower exact version.
+ * @brief Runs TSNE from the kNN graph of the rows of X, shared by TSNE_fit and TSNE_fit_knn.
+ * @input param indices: The indices of the n_neighbors nearest neighbors of every row (n, n_neighbors), each row included.
+ * @input param distances: The distances to the n_neighbors nearest neighbors of every row (n, n_neighbors), sorted. Normalized in place.
+ * See TSNE_fit for the other parameters.
  */
-void TSNE_fit(const cumlHandle &handle, const float *X, float *Y, const int n,
-              const int p, const int dim, int n_neighbors, const float theta,
-              const float epssq, float perplexity,
+void _fit_knn(const cumlHandle &handle, const long *indices, float *distances,
+              float *Y, const int n, const int dim, const int n_neighbors,
+              const float theta, const float epssq, float perplexity,
               const int perplexity_max_iter, const float perplexity_tol,
               const float early_exaggeration, const int exaggeration_iter,
               const float min_gain, const float pre_learning_rate,
@@ -62,27 +43,29 @@ void TSNE_fit(const cumlHandle &handle, const float *X, float *Y, const int n,
               const float min_grad_norm, const float pre_momentum,
               const float post_momentum, const long long random_state,
               const bool verbose, const bool intialize_embeddings,
-              bool barnes_hut) {
-  ASSERT(n > 0 && p > 0 && dim > 0 && n_neighbors > 0 && X != NULL && Y != NULL,
-         "Wrong input args");
-  if (dim > 2 and barnes_hut) {
+              bool barnes_hut, bool fft) {
+  ML::detail::phaseScope range(handle.getImpl(), "Trace::Tsne::Optimize",
+                               "n=%d dim=%d k=%d iters=%d", n, dim, n_neighbors,
+                               max_iter);
+  if (dim > 2 and fft) {
+    fft = false;
+    printf(
+      "[Warn]  FFT interpolation only works for dim == 2. Switching to "
+      "Barnes Hut or exact solution.\n");
+  }
+  if (dim > 3 and barnes_hut) {
     barnes_hut = false;
     printf(
-      "[Warn]  Barnes Hut only works for dim == 2. Switching to exact "
+      "[Warn]  Barnes Hut only works for dim <= 3. Switching to exact "
       "solution.\n");
   }
-  if (n_neighbors > n) n_neighbors = n;
-  if (n_neighbors > 1023) {
-    printf("[Warn]  FAISS only supports maximum n_neighbors = 1023.\n");
-    n_neighbors = 1023;
-  }
   // Perplexity must be less than number of datapoints
   // "How to Use t-SNE Effectively" https://distill.pub/2016/misread-tsne/
   if (perplexity > n) perplexity = n;
 
   if (verbose) {
-    printf("[Info]  Data size = (%d, %d) with dim = %d perplexity = %f\n", n, p,
-           dim, perplexity);
+    printf("[Info]  Data size = %d with dim = %d perplexity = %f\n", n, dim,
+           perplexity);
     if (perplexity < 5 or perplexity > 50)
       printf(
         "[Warn]  Perplexity should be within ranges (5, 50). Your results "
@@ -96,19 +79,6 @@ void TSNE_fit(const cumlHandle &handle, const float *X, float *Y, const int n,
   auto d_alloc = handle.getDeviceAllocator();
   cudaStream_t stream = handle.getStream();
 
-  START_TIMER;
-  //---------------------------------------------------
-  // Get distances
-  if (verbose) printf("[Info] Getting distances.\n");
-  float *distances =
-    (float *)d_alloc->allocate(sizeof(float) * n * n_neighbors, stream);
-  long *indices =
-    (long *)d_alloc->allocate(sizeof(long) * n * n_neighbors, stream);
-  TSNE::get_distances(X, n, p, indices, distances, n_neighbors, d_alloc,
-                      stream);
-  //---------------------------------------------------
-  END_TIMER(DistancesTime);
-
   START_TIMER;
   //---------------------------------------------------
   // Normalize distances
@@ -123,12 +93,11 @@ void TSNE_fit(const cumlHandle &handle, const float *X, float *Y, const int n,
   // Optimal perplexity
   if (verbose)
     printf("[Info] Searching for optimal perplexity via bisection search.\n");
-  float *P =
-    (float *)d_alloc->allocate(sizeof(float) * n * n_neighbors, stream);
+  MLCommon::device_buffer<float> P(d_alloc, stream, n * n_neighbors);
   const float P_sum =
-    TSNE::perplexity_search(distances, P, perplexity, perplexity_max_iter,
-                            perplexity_tol, n, n_neighbors, handle);
-  d_alloc->deallocate(distances, sizeof(float) * n * n_neighbors, stream);
+    TSNE::perplexity_search(distances, P.data(), perplexity,
+                            perplexity_max_iter, perplexity_tol, n,
+                            n_neighbors, handle);
   if (verbose) printf("[Info] Perplexity sum = %f\n", P_sum);
   //---------------------------------------------------
   END_TIMER(PerplexityTime);
@@ -137,8 +106,9 @@ void TSNE_fit(const cumlHandle &handle, const float *X, float *Y, const int n,
   //---------------------------------------------------
   // Convert data to COO layout
   MLCommon::Sparse::COO<float> COO_Matrix(d_alloc, stream);
-  TSNE::symmetrize_perplexity(P, indices, n, n_neighbors, P_sum,
+  TSNE::symmetrize_perplexity(P.data(), indices, n, n_neighbors, P_sum,
                               early_exaggeration, &COO_Matrix, stream, handle);
+  P.release(stream);
   const int NNZ = COO_Matrix.nnz;
   float *VAL = COO_Matrix.vals();
   const int *COL = COO_Matrix.cols();
@@ -146,7 +116,18 @@ void TSNE_fit(const cumlHandle &handle, const float *X, float *Y, const int n,
   //---------------------------------------------------
   END_TIMER(SymmetrizeTime);
 
-  if (barnes_hut) {
+  if (fft) {
+    TSNE::FFT_TSNE(VAL, COL, ROW, NNZ, handle, Y, n, early_exaggeration,
+                   exaggeration_iter, min_gain, pre_learning_rate,
+                   post_learning_rate, max_iter, min_grad_norm, pre_momentum,
+                   post_momentum, random_state, verbose, intialize_embeddings);
+  } else if (barnes_hut and dim == 3) {
+    TSNE::Barnes_Hut_3d(VAL, COL, ROW, NNZ, handle, Y, n, theta, epssq,
+                        early_exaggeration, exaggeration_iter, min_gain,
+                        pre_learning_rate, post_learning_rate, max_iter,
+                        min_grad_norm, pre_momentum, post_momentum,
+                        random_state, verbose);
+  } else if (barnes_hut) {
     TSNE::Barnes_Hut(VAL, COL, ROW, NNZ, handle, Y, n, theta, epssq,
                      early_exaggeration, exaggeration_iter, min_gain,
                      pre_learning_rate, post_learning_rate, max_iter,
@@ -161,4 +142,274 @@ void TSNE_fit(const cumlHandle &handle, const float *X, float *Y, const int n,
   }
 }
 
+/**
+ * @brief Dimensionality reduction via TSNE using either Barnes Hut O(NlogN), FFT-accelerated interpolation O(N) or brute force O(N^2).
+ * @input param handle: The GPU handle.
+ * @input param X: The dataset you want to apply TSNE on.
+ * @output param Y: The final embedding. Will overwrite this internally.
+ * @input param n: Number of rows in data X.
+ * @input param p: Number of columns in data X.
+ * @input param dim: Number of output dimensions for embeddings Y.
+ * @input param n_neighbors: Number of nearest neighbors used.
+ * @input param theta: Float between 0 and 1. Tradeoff for speed (0) vs accuracy (1) for Barnes Hut only.
+ * @input param epssq: A tiny jitter to promote numerical stability.
+ * @input param perplexity: How many nearest neighbors are used during the construction of Pij.
+ * @input param perplexity_max_iter: Number of iterations used to construct Pij.
+ * @input param perplexity_tol: The small tolerance used for Pij to ensure numerical stability.
+ * @input param early_exaggeration: How much early pressure you want the clusters in TSNE to spread out more.
+ * @input param exaggeration_iter: How many iterations you want the early pressure to run for.
+ * @input param min_gain: Rounds up small gradient updates.
+ * @input param pre_learning_rate: The learning rate during the exaggeration phase.
+ * @input param post_learning_rate: The learning rate after the exaggeration phase.
+ * @input param max_iter: The maximum number of iterations TSNE should run for.
+ * @input param min_grad_norm: The smallest gradient norm TSNE should terminate on.
+ * @input param pre_momentum: The momentum used during the exaggeration phase.
+ * @input param post_momentum: The momentum used after the exaggeration phase.
+ * @input param random_state: Set this to -1 for pure random intializations or >= 0 for reproducible outputs.
+ * @input param verbose: Whether to print error messages or not.
+ * @input param intialize_embeddings: Whether to overwrite the current Y vector with random noise.
+ * @input param barnes_hut: Whether to use the fast Barnes Hut, on a quadtree for dim == 2 and an octree for dim == 3, or use the slower exact version.
+ * @input param knn_index: Optional approximate nearest neighbors index holding the rows of X in order, created with handle, searched instead of a brute force kNN.
+ * @input param fft: Whether to compute the repulsive forces by FFT-accelerated interpolation (FIt-SNE), for dim == 2 only; overrides barnes_hut.
+ */
+void TSNE_fit(const cumlHandle &handle, const float *X, float *Y, const int n,
+              const int p, const int dim, int n_neighbors, const float theta,
+              const float epssq, float perplexity,
+              const int perplexity_max_iter, const float perplexity_tol,
+              const float early_exaggeration, const int exaggeration_iter,
+              const float min_gain, const float pre_learning_rate,
+              const float post_learning_rate, const int max_iter,
+              const float min_grad_norm, const float pre_momentum,
+              const float post_momentum, const long long random_state,
+              const bool verbose, const bool intialize_embeddings,
+              bool barnes_hut, const knnIndex *knn_index, bool fft) {
+  ASSERT(n > 0 && p > 0 && dim > 0 && n_neighbors > 0 && X != NULL && Y != NULL,
+         "Wrong input args");
+  if (n_neighbors > n) n_neighbors = n;
+  if (n_neighbors > 1023) {
+    printf("[Warn]  FAISS only supports maximum n_neighbors = 1023.\n");
+    n_neighbors = 1023;
+  }
+  if (verbose) printf("[Info]  Data size = (%d, %d)\n", n, p);
+  ML::detail::phaseScope range(handle.getImpl(), "ML::Tsne::Fit",
+                               "rows=%d cols=%d", n, p);
+
+  auto d_alloc = handle.getDeviceAllocator();
+  cudaStream_t stream = handle.getStream();
+
+  START_TIMER;
+  //---------------------------------------------------
+  // Get distances
+  if (verbose) printf("[Info] Getting distances.\n");
+  MLCommon::device_buffer<float> distances(d_alloc, stream, n * n_neighbors);
+  MLCommon::device_buffer<long> indices(d_alloc, stream, n * n_neighbors);
+  {
+    ML::detail::phaseScope knn(handle.getImpl(), "Trace::Tsne::KnnGraph",
+                               "n=%d d=%d k=%d", n, p, n_neighbors);
+    TSNE::get_distances(X, n, p, indices.data(), distances.data(),
+                        n_neighbors, knn_index, d_alloc, stream);
+  }
+  //---------------------------------------------------
+  END_TIMER(DistancesTime);
+
+  _fit_knn(handle, indices.data(), distances.data(), Y, n, dim, n_neighbors,
+           theta, epssq, perplexity, perplexity_max_iter, perplexity_tol,
+           early_exaggeration, exaggeration_iter, min_gain, pre_learning_rate,
+           post_learning_rate, max_iter, min_grad_norm, pre_momentum,
+           post_momentum, random_state, verbose, intialize_embeddings,
+           barnes_hut, fft);
+}
+
+/**
+ * @brief Dimensionality reduction via TSNE of the rows of a CSR matrix, whose kNN graph is found without densifying it.
+ * @input param handle: The GPU handle.
+ * @input param vals: The nonzero values of the CSR matrix X (nnz).
+ * @input param row_ind: The offsets of the rows of X in vals (n + 1).
+ * @input param row_ind_ptr: The column of each nonzero of X (nnz).
+ * @input param nnz: The number of nonzeros of X.
+ * @output param Y: The final embedding. Will overwrite this internally.
+ * @input param n: Number of rows in data X.
+ * @input param p: Number of columns in data X.
+ * See TSNE_fit for the other parameters.
+ */
+void TSNE_fit_sparse(const cumlHandle &handle, const float *vals,
+                     const int *row_ind, const int *row_ind_ptr, const int nnz,
+                     float *Y, const int n, const int p, const int dim,
+                     int n_neighbors, const float theta, const float epssq,
+                     float perplexity, const int perplexity_max_iter,
+                     const float perplexity_tol,
+                     const float early_exaggeration,
+                     const int exaggeration_iter, const float min_gain,
+                     const float pre_learning_rate,
+                     const float post_learning_rate, const int max_iter,
+                     const float min_grad_norm, const float pre_momentum,
+                     const float post_momentum, const long long random_state,
+                     const bool verbose, const bool intialize_embeddings,
+                     bool barnes_hut, bool fft) {
+  ASSERT(n > 0 && p > 0 && dim > 0 && n_neighbors > 0 && vals != NULL &&
+           row_ind != NULL && row_ind_ptr != NULL && Y != NULL,
+         "Wrong input args");
+  if (n_neighbors > n) n_neighbors = n;
+  if (n_neighbors > 1024) {
+    printf("[Warn]  The sparse kNN supports maximum n_neighbors = 1024.\n");
+    n_neighbors = 1024;
+  }
+  if (verbose) printf("[Info]  Data size = (%d, %d), nnz = %d\n", n, p, nnz);
+  ML::detail::phaseScope range(handle.getImpl(), "ML::Tsne::FitSparse",
+                               "rows=%d cols=%d nnz=%d", n, p, nnz);
+
+  auto d_alloc = handle.getDeviceAllocator();
+  cudaStream_t stream = handle.getStream();
+
+  START_TIMER;
+  //---------------------------------------------------
+  // Get distances
+  if (verbose) printf("[Info] Getting distances.\n");
+  MLCommon::device_buffer<float> distances(d_alloc, stream, n * n_neighbors);
+  MLCommon::device_buffer<long> indices(d_alloc, stream, n * n_neighbors);
+  {
+    ML::detail::phaseScope knn(handle.getImpl(), "Trace::Tsne::KnnGraph",
+                               "n=%d d=%d k=%d", n, p, n_neighbors);
+    TSNE::get_distances(vals, row_ind, row_ind_ptr, nnz, n, p, indices.data(),
+                        distances.data(), n_neighbors, d_alloc, stream);
+  }
+  //---------------------------------------------------
+  END_TIMER(DistancesTime);
+
+  _fit_knn(handle, indices.data(), distances.data(), Y, n, dim, n_neighbors,
+           theta, epssq, perplexity, perplexity_max_iter, perplexity_tol,
+           early_exaggeration, exaggeration_iter, min_gain, pre_learning_rate,
+           post_learning_rate, max_iter, min_grad_norm, pre_momentum,
+           post_momentum, random_state, verbose, intialize_embeddings,
+           barnes_hut, fft);
+}
+
+/**
+ * @brief Dimensionality reduction via TSNE from a precomputed kNN graph, skipping the nearest neighbors search of TSNE_fit.
+ * @input param handle: The GPU handle.
+ * @input param knn_indices: The indices of the n_neighbors nearest neighbors of every row (n, n_neighbors), each row included as its own nearest neighbor.
+ * @input param knn_dists: The distances to the n_neighbors nearest neighbors of every row (n, n_neighbors), sorted. Left unchanged.
+ * @output param Y: The final embedding. Will overwrite this internally.
+ * @input param n: Number of rows in the kNN graph.
+ * @input param n_neighbors: Number of nearest neighbors in the kNN graph.
+ * See TSNE_fit for the other parameters.
+ */
+void TSNE_fit_knn(const cumlHandle &handle, const long *knn_indices,
+                  const float *knn_dists, float *Y, const int n, const int dim,
+                  const int n_neighbors, const float theta, const float epssq,
+                  float perplexity, const int perplexity_max_iter,
+                  const float perplexity_tol, const float early_exaggeration,
+                  const int exaggeration_iter, const float min_gain,
+                  const float pre_learning_rate,
+                  const float post_learning_rate, const int max_iter,
+                  const float min_grad_norm, const float pre_momentum,
+                  const float post_momentum, const long long random_state,
+                  const bool verbose, const bool intialize_embeddings,
+                  bool barnes_hut, bool fft) {
+  ASSERT(n > 0 && dim > 0 && n_neighbors > 0 && n_neighbors <= n &&
+           knn_indices != NULL && knn_dists != NULL && Y != NULL,
+         "Wrong input args");
+  cudaStream_t stream = handle.getStream();
+
+  // The distances are normalized in place
+  MLCommon::device_buffer<float> distances(handle.getDeviceAllocator(), stream,
+                                           n * n_neighbors);
+  MLCommon::copyAsync(distances.data(), knn_dists, n * n_neighbors, stream);
+
+  _fit_knn(handle, knn_indices, distances.data(), Y, n, dim, n_neighbors, theta,
+           epssq, perplexity, perplexity_max_iter, perplexity_tol,
+           early_exaggeration, exaggeration_iter, min_gain, pre_learning_rate,
+           post_learning_rate, max_iter, min_grad_norm, pre_momentum,
+           post_momentum, random_state, verbose, intialize_embeddings,
+           barnes_hut, fft);
+}
+
+/**
+ * @brief Dimensionality reduction via Barnes Hut TSNE over the ranks of the communicator of the handle, each rank holding a shard of the rows of X, numbered in rank order. The kNN graph and the rows of P are split across the ranks, and each rank gets the embeddings of its own rows.
+ * @input param handle: The GPU handle, with a communicator.
+ * @input param X: The rows of X of this rank (n_local, p) in row-major.
+ * @output param Y: The final embedding of the rows of this rank (n_local, 2) in column-major.
+ * @input param n_local: Number of rows of X on this rank, at least 1.
+ * @input param p: Number of columns in data X.
+ * See TSNE_fit for the other parameters.
+ */
+void TSNE_fit_mg(const cumlHandle &handle, float *X, float *Y,
+                 const int n_local, const int p, int n_neighbors,
+                 const float theta, const float epssq, float perplexity,
+                 const int perplexity_max_iter, const float perplexity_tol,
+                 const float early_exaggeration, const int exaggeration_iter,
+                 const float min_gain, const float pre_learning_rate,
+                 const float post_learning_rate, const int max_iter,
+                 const float min_grad_norm, const float pre_momentum,
+                 const float post_momentum, const long long random_state,
+                 const bool verbose) {
+  const cumlHandle_impl &h = handle.getImpl();
+  ASSERT(h.commsInitialized(),
+         "TSNE_fit_mg requires a handle with a communicator");
+  ASSERT(n_local > 0 && p > 0 && n_neighbors > 0 && X != NULL && Y != NULL,
+         "Wrong input args");
+  auto d_alloc = handle.getDeviceAllocator();
+  cudaStream_t stream = handle.getStream();
+
+  const std::vector<int> offsets =
+    TSNE::mg::rank_offsets(h, n_local, stream);
+  const int n = offsets.back();
+  if (n_neighbors > n) n_neighbors = n;
+  if (n_neighbors > 1023) {
+    printf("[Warn]  FAISS only supports maximum n_neighbors = 1023.\n");
+    n_neighbors = 1023;
+  }
+  if (perplexity > n) perplexity = n;
+  if (verbose)
+    printf("[Info]  Data size = (%d, %d), %d on this rank\n", n, p, n_local);
+
+  START_TIMER;
+  //---------------------------------------------------
+  // Get distances
+  if (verbose) printf("[Info] Getting distances.\n");
+  MLCommon::device_buffer<float> distances(d_alloc, stream,
+                                           n_local * n_neighbors);
+  MLCommon::device_buffer<long> indices(d_alloc, stream,
+                                        n_local * n_neighbors);
+  TSNE::mg::get_distances(handle, X, n_local, p, offsets, indices.data(),
+                          distances.data(), n_neighbors, stream);
+  //---------------------------------------------------
+  END_TIMER(DistancesTime);
+
+  START_TIMER;
+  TSNE::mg::normalize_distances(h, n_local, distances.data(), n_neighbors,
+                                stream);
+  END_TIMER(NormalizeTime);
+
+  START_TIMER;
+  //---------------------------------------------------
+  // Optimal perplexity, each row on its own
+  MLCommon::device_buffer<float> P(d_alloc, stream, n_local * n_neighbors);
+  float P_sum = TSNE::perplexity_search(distances.data(), P.data(),
+                                        perplexity, perplexity_max_iter,
+                                        perplexity_tol, n_local, n_neighbors,
+                                        handle);
+  P_sum = TSNE::mg::allreduce(h, P_sum, MLCommon::cumlCommunicator::SUM,
+                              stream);
+  if (verbose) printf("[Info] Perplexity sum = %f\n", P_sum);
+  distances.release(stream);
+  //---------------------------------------------------
+  END_TIMER(PerplexityTime);
+
+  START_TIMER;
+  MLCommon::Sparse::COO<float> COO_Matrix(d_alloc, stream);
+  TSNE::mg::symmetrize_perplexity(h, offsets, P.data(), indices.data(),
+                                  n_neighbors, P_sum, early_exaggeration,
+                                  &COO_Matrix, stream);
+  P.release(stream);
+  indices.release(stream);
+  END_TIMER(SymmetrizeTime);
+
+  TSNE::mg::Barnes_Hut(
+    COO_Matrix.vals(), COO_Matrix.cols(), COO_Matrix.rows(), COO_Matrix.nnz,
+    handle, Y, offsets, theta, epssq, early_exaggeration, exaggeration_iter,
+    min_gain, pre_learning_rate, post_learning_rate, max_iter, min_grad_norm,
+    pre_momentum, post_momentum, random_state, verbose);
+}
+
 }  // namespace ML
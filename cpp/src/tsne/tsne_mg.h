@@ -0,0 +1,562 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <common/cuml_comms_int.hpp>
+#include <common/cumlHandle.hpp>
+#include <cuml/neighbors/knn.hpp>
+
+#include <thrust/binary_search.h>
+#include <thrust/extrema.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <thrust/sort.h>
+
+#include <algorithm>
+#include <climits>
+#include <numeric>
+#include <vector>
+
+#include "barnes_hut.h"
+#include "common/device_buffer.hpp"
+#include "utils.h"
+
+namespace ML {
+namespace TSNE {
+
+// Distributed TSNE: every rank of the communicator of the handle holds a
+// shard of the rows of X, numbered in rank order
+namespace mg {
+
+// The communicator counts the elements of a collective with an int
+static const size_t MAX_COLLECTIVE_COUNT = size_t(1) << 30;
+
+/**
+ * Index of the first row of each rank; the last entry is the total # of rows
+ */
+std::vector<int> rank_offsets(const cumlHandle_impl &h, const int n_local,
+                              cudaStream_t stream) {
+  const MLCommon::cumlCommunicator &comm = h.getCommunicator();
+  const int rank = comm.getRank();
+  const int n_ranks = comm.getSize();
+
+  MLCommon::device_buffer<int> counts(h.getDeviceAllocator(), stream,
+                                      n_ranks);
+  MLCommon::updateDevice(counts.data() + rank, &n_local, 1, stream);
+  comm.allgather(counts.data() + rank, counts.data(), 1, stream);
+
+  std::vector<int> offsets(n_ranks + 1, 0);
+  MLCommon::updateHost(offsets.data() + 1, counts.data(), n_ranks, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  std::partial_sum(offsets.begin() + 1, offsets.end(), offsets.begin() + 1);
+  return offsets;
+}
+
+/** In place allreduce of a device array of any length */
+void allreduce(const MLCommon::cumlCommunicator &comm, float *buf,
+               const size_t len, MLCommon::cumlCommunicator::op_t op,
+               cudaStream_t stream) {
+  for (size_t i = 0; i < len; i += MAX_COLLECTIVE_COUNT) {
+    const int count = std::min(len - i, MAX_COLLECTIVE_COUNT);
+    comm.allreduce(buf + i, buf + i, count, op, stream);
+  }
+}
+
+/** The allreduce of a host scalar over the ranks */
+float allreduce(const cumlHandle_impl &h, const float value,
+                MLCommon::cumlCommunicator::op_t op, cudaStream_t stream) {
+  MLCommon::device_buffer<float> buf(h.getDeviceAllocator(), stream, 1);
+  MLCommon::updateDevice(buf.data(), &value, 1, stream);
+  allreduce(h.getCommunicator(), buf.data(), 1, op, stream);
+  float out;
+  MLCommon::updateHost(&out, buf.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  return out;
+}
+
+/**
+ * @brief The kNN graph of the rows of this rank among the rows of all the ranks. The shard of each rank in turn is broadcast and searched against the shards of all the ranks, and that rank keeps the merged neighbors.
+ * @input param handle: The GPU handle, with a communicator.
+ * @input param X: The rows of this rank (n_local, p) in row-major.
+ * @input param n_local: The number of rows of this rank.
+ * @input param p: The number of columns in the data X.
+ * @input param offsets: The first row of each rank, from rank_offsets.
+ * @output param indices: The global indices of the neighbors (n_local, n_neighbors).
+ * @output param distances: The sorted squared distances to the neighbors (n_local, n_neighbors).
+ * @input param n_neighbors: The number of nearest neighbors you want.
+ * @input param stream: The GPU stream.
+ */
+void get_distances(const cumlHandle &handle, float *X, const int n_local,
+                   const int p, const std::vector<int> &offsets, long *indices,
+                   float *distances, const int n_neighbors,
+                   cudaStream_t stream) {
+  const cumlHandle_impl &h = handle.getImpl();
+  const MLCommon::cumlCommunicator &comm = h.getCommunicator();
+  auto d_alloc = h.getDeviceAllocator();
+  const int rank = comm.getRank();
+  const int n_ranks = comm.getSize();
+
+  int max_rows = 0;
+  for (int r = 0; r < n_ranks; r++)
+    max_rows = std::max(max_rows, offsets[r + 1] - offsets[r]);
+  MLCommon::device_buffer<float> query(d_alloc, stream, (size_t)max_rows * p);
+  MLCommon::device_buffer<long> other_indices(
+    d_alloc, stream, (size_t)max_rows * n_neighbors);
+  MLCommon::device_buffer<float> other_distances(
+    d_alloc, stream, (size_t)max_rows * n_neighbors);
+
+  std::vector<float *> input(1, X);
+  std::vector<int> sizes(1, n_local);
+  for (int r = 0; r < n_ranks; r++) {
+    const int rows = offsets[r + 1] - offsets[r];
+    const size_t len = (size_t)rows * p;
+    if (r == rank) MLCommon::copyAsync(query.data(), X, len, stream);
+    for (size_t i = 0; i < len; i += MAX_COLLECTIVE_COUNT) {
+      const int count = std::min(len - i, MAX_COLLECTIVE_COUNT);
+      comm.bcast(query.data() + i, count, r, stream);
+    }
+    ML::brute_force_knn_mg(
+      const_cast<cumlHandle &>(handle), input, sizes, p, query.data(), rows,
+      r == rank ? indices : other_indices.data(),
+      r == rank ? distances : other_distances.data(), n_neighbors, true, true);
+  }
+}
+
+/**
+ * @brief Divides the distances of this rank by the largest distance of all the ranks, so exp(D) doesn't explode.
+ * @input param h: The GPU handle implementation, with a communicator.
+ * @input param n_local: The number of rows of this rank.
+ * @input param distances: The distances to the neighbors (n_local, n_neighbors).
+ * @input param n_neighbors: The number of nearest neighbors.
+ * @input param stream: The GPU stream.
+ */
+void normalize_distances(const cumlHandle_impl &h, const int n_local,
+                         float *distances, const int n_neighbors,
+                         cudaStream_t stream) {
+  thrust::device_ptr<float> begin = thrust::device_pointer_cast(distances);
+  float maxNorm = *thrust::max_element(thrust::cuda::par.on(stream), begin,
+                                       begin + n_local * n_neighbors);
+  maxNorm = allreduce(h, maxNorm, MLCommon::cumlCommunicator::MAX, stream);
+  if (maxNorm == 0.0f) maxNorm = 1.0f;
+
+  const float div = 1.0f / maxNorm;
+  MLCommon::LinAlg::scalarMultiply(distances, distances, div,
+                                   n_local * n_neighbors, stream);
+}
+
+/**
+ * Sends each edge (rows, cols, vals) of this rank, whose rows and cols are
+ * global, to the rank owning its col, and receives the edges of the other
+ * ranks whose cols are rows of this rank into recv_rows, recv_cols and
+ * recv_vals. The edges of this rank are reordered by owner of their col.
+ * @return the number of edges received
+ */
+int exchange_edges(const cumlHandle_impl &h, const std::vector<int> &offsets,
+                   int *rows, int *cols, float *vals, const int nnz,
+                   MLCommon::device_buffer<int> &recv_rows,
+                   MLCommon::device_buffer<int> &recv_cols,
+                   MLCommon::device_buffer<float> &recv_vals,
+                   cudaStream_t stream) {
+  const MLCommon::cumlCommunicator &comm = h.getCommunicator();
+  auto d_alloc = h.getDeviceAllocator();
+  const int rank = comm.getRank();
+  const int n_ranks = comm.getSize();
+  auto policy = thrust::cuda::par.on(stream);
+
+  // owner is 1 + the rank owning the col of each edge
+  MLCommon::device_buffer<int> d_offsets(d_alloc, stream, n_ranks + 1);
+  MLCommon::device_buffer<int> owner(d_alloc, stream, nnz);
+  MLCommon::device_buffer<int> send_ind(d_alloc, stream, n_ranks + 1);
+  MLCommon::updateDevice(d_offsets.data(), offsets.data(), n_ranks + 1,
+                         stream);
+  thrust::upper_bound(policy, d_offsets.data(),
+                      d_offsets.data() + n_ranks + 1, cols, cols + nnz,
+                      owner.data());
+  thrust::stable_sort_by_key(
+    policy, owner.data(), owner.data() + nnz,
+    thrust::make_zip_iterator(thrust::make_tuple(rows, cols, vals)));
+  thrust::lower_bound(policy, owner.data(), owner.data() + nnz,
+                      thrust::make_counting_iterator(1),
+                      thrust::make_counting_iterator(n_ranks + 2),
+                      send_ind.data());
+
+  // The number of edges each rank sends to each rank
+  std::vector<int> h_send_ind(n_ranks + 1), send_counts(n_ranks);
+  MLCommon::updateHost(h_send_ind.data(), send_ind.data(), n_ranks + 1,
+                       stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  for (int r = 0; r < n_ranks; r++)
+    send_counts[r] = h_send_ind[r + 1] - h_send_ind[r];
+  MLCommon::device_buffer<int> all_counts(d_alloc, stream, n_ranks * n_ranks);
+  MLCommon::updateDevice(all_counts.data() + rank * n_ranks,
+                         send_counts.data(), n_ranks, stream);
+  comm.allgather(all_counts.data() + rank * n_ranks, all_counts.data(),
+                 n_ranks, stream);
+  std::vector<int> h_all_counts(n_ranks * n_ranks);
+  MLCommon::updateHost(h_all_counts.data(), all_counts.data(),
+                       n_ranks * n_ranks, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  std::vector<int> recv_ind(n_ranks + 1, 0);
+  for (int r = 0; r < n_ranks; r++)
+    recv_ind[r + 1] = recv_ind[r] + h_all_counts[r * n_ranks + rank];
+  const int recv_nnz = recv_ind[n_ranks];
+  recv_rows.resize(recv_nnz, stream);
+  recv_cols.resize(recv_nnz, stream);
+  recv_vals.resize(recv_nnz, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  std::vector<MLCommon::cumlCommunicator::request_t> requests;
+  requests.reserve(6 * n_ranks);
+  auto send = [&](const void *buf, size_t bytes, int r, int tag) {
+    ASSERT(bytes <= INT_MAX, "TSNE_fit_mg: %zu bytes to send to rank %d",
+           bytes, r);
+    requests.emplace_back();
+    comm.isend(buf, (int)bytes, r, tag, &requests.back());
+  };
+  auto recv = [&](void *buf, size_t bytes, int r, int tag) {
+    requests.emplace_back();
+    comm.irecv(buf, (int)bytes, r, tag, &requests.back());
+  };
+  for (int r = 0; r < n_ranks; r++) {
+    const int s0 = h_send_ind[r], s_n = send_counts[r];
+    const int r0 = recv_ind[r], r_n = recv_ind[r + 1] - r0;
+    if (r == rank) {
+      MLCommon::copyAsync(recv_rows.data() + r0, rows + s0, s_n, stream);
+      MLCommon::copyAsync(recv_cols.data() + r0, cols + s0, s_n, stream);
+      MLCommon::copyAsync(recv_vals.data() + r0, vals + s0, s_n, stream);
+      continue;
+    }
+    if (s_n > 0) {
+      send(rows + s0, s_n * sizeof(int), r, 0);
+      send(cols + s0, s_n * sizeof(int), r, 1);
+      send(vals + s0, s_n * sizeof(float), r, 2);
+    }
+    if (r_n > 0) {
+      recv(recv_rows.data() + r0, r_n * sizeof(int), r, 0);
+      recv(recv_cols.data() + r0, r_n * sizeof(int), r, 1);
+      recv(recv_vals.data() + r0, r_n * sizeof(float), r, 2);
+    }
+  }
+  comm.waitall(requests.size(), requests.data());
+  return recv_nnz;
+}
+
+/**
+ * @brief Performs P + P.T for the rows of this rank, whose transposed entries come from the ranks owning the neighbors. The entries of a pair found from both of its ends are kept apart, which sums the same in the attractive forces.
+ * @input param h: The GPU handle implementation, with a communicator.
+ * @input param offsets: The first row of each rank, from rank_offsets.
+ * @input param P: The perplexity matrix of this rank (n_local, k).
+ * @input param indices: The global indices of the neighbors (n_local, k).
+ * @input param k: The number of nearest neighbors.
+ * @input param P_sum: The sum of P over all the ranks.
+ * @input param exaggeration: How much early pressure you want the clusters in TSNE to spread out more.
+ * @output param COO_Matrix: The entries of P + P.T in the rows of this rank, with global rows and cols.
+ * @input param stream: The GPU stream.
+ */
+void symmetrize_perplexity(const cumlHandle_impl &h,
+                           const std::vector<int> &offsets, const float *P,
+                           const long *indices, const int k, const float P_sum,
+                           const float exaggeration,
+                           MLCommon::Sparse::COO<float> *COO_Matrix,
+                           cudaStream_t stream) {
+  auto d_alloc = h.getDeviceAllocator();
+  const int rank = h.getCommunicator().getRank();
+  const int n = offsets.back();
+  const int offset = offsets[rank];
+  const int n_local = offsets[rank + 1] - offset;
+  const int own_nnz = n_local * k;
+  auto policy = thrust::cuda::par.on(stream);
+
+  // Perform (P + P.T) / P_sum * early_exaggeration
+  const float div = exaggeration / (2.0f * P_sum);
+  MLCommon::device_buffer<int> rows(d_alloc, stream, own_nnz);
+  MLCommon::device_buffer<int> cols(d_alloc, stream, own_nnz);
+  MLCommon::device_buffer<float> vals(d_alloc, stream, own_nnz);
+  int *d_rows = rows.data(), *d_cols = cols.data();
+  float *d_vals = vals.data();
+  thrust::for_each(policy, thrust::make_counting_iterator(0),
+                   thrust::make_counting_iterator(own_nnz),
+                   [=] __device__(int e) {
+                     d_rows[e] = offset + e / k;
+                     d_cols[e] = (int)indices[e];
+                     d_vals[e] = P[e] * div;
+                   });
+
+  MLCommon::device_buffer<int> recv_rows(d_alloc, stream);
+  MLCommon::device_buffer<int> recv_cols(d_alloc, stream);
+  MLCommon::device_buffer<float> recv_vals(d_alloc, stream);
+  const int recv_nnz =
+    exchange_edges(h, offsets, d_rows, d_cols, d_vals, own_nnz, recv_rows,
+                   recv_cols, recv_vals, stream);
+
+  // The edges of this rank, then the received ones transposed
+  const int nnz = own_nnz + recv_nnz;
+  COO_Matrix->allocate(nnz, n, n, false, stream);
+  int *o_rows = COO_Matrix->rows(), *o_cols = COO_Matrix->cols();
+  float *o_vals = COO_Matrix->vals();
+  MLCommon::copyAsync(o_rows, d_rows, own_nnz, stream);
+  MLCommon::copyAsync(o_cols, d_cols, own_nnz, stream);
+  MLCommon::copyAsync(o_vals, d_vals, own_nnz, stream);
+  MLCommon::copyAsync(o_rows + own_nnz, recv_cols.data(), recv_nnz, stream);
+  MLCommon::copyAsync(o_cols + own_nnz, recv_rows.data(), recv_nnz, stream);
+  MLCommon::copyAsync(o_vals + own_nnz, recv_vals.data(), recv_nnz, stream);
+}
+
+/**
+ * @brief Barnes Hut TSNE over the ranks of the communicator of the handle. Every rank holds the whole embedding and builds the same quadtree over it. The repulsive forces of the bodies are split across the ranks by chunks of the order of the tree of rank 0, and the attractive forces by the rows of P each rank holds; both are summed over the ranks with their Z by one allreduce per iteration, after which every rank applies the same update to the whole embedding.
+ * @input param VAL: The values in the attractive forces COO matrix of this rank, from symmetrize_perplexity.
+ * @input param COL: The global column indices in the attractive forces COO matrix.
+ * @input param ROW: The global row indices in the attractive forces COO matrix.
+ * @input param NNZ: The number of non zeros in the attractive forces COO matrix.
+ * @input param handle: The GPU handle, with a communicator.
+ * @output param Y: The final embedding of the rows of this rank (n_local, 2) in column-major.
+ * @input param offsets: The first row of each rank, from rank_offsets.
+ * See Barnes_Hut for the other parameters.
+ */
+void Barnes_Hut(float *VAL, const int *COL, const int *ROW, const int NNZ,
+                const cumlHandle &handle, float *Y,
+                const std::vector<int> &offsets, const float theta,
+                const float epssq, const float early_exaggeration,
+                const int exaggeration_iter, const float min_gain,
+                const float pre_learning_rate, const float post_learning_rate,
+                const int max_iter, const float min_grad_norm,
+                const float pre_momentum, const float post_momentum,
+                const long long random_state, const bool verbose) {
+  const cumlHandle_impl &h = handle.getImpl();
+  const MLCommon::cumlCommunicator &comm = h.getCommunicator();
+  auto d_alloc = handle.getDeviceAllocator();
+  cudaStream_t stream = handle.getStream();
+  const int rank = comm.getRank();
+  const int n_ranks = comm.getSize();
+  const int n = offsets[n_ranks];
+  const int offset = offsets[rank];
+  const int n_local = offsets[rank + 1] - offset;
+
+  const int blocks = MLCommon::getMultiProcessorCount();
+
+  int nnodes = n * 2;
+  if (nnodes < 1024 * blocks) nnodes = 1024 * blocks;
+  while ((nnodes & (32 - 1)) != 0) nnodes++;
+  nnodes--;
+  if (verbose) printf("N_nodes = %d blocks = %d\n", nnodes, blocks);
+
+  /**
+   * The bodies this rank repels are the positions [sort_begin, sort_end) of
+   * the sorted order, in chunks of whole warps so that the warps of the
+   * RepulsionKernel, which traverse the tree together, are all in or out
+   */
+  const int warps = MLCommon::ceildiv(n, 32);
+  const int chunk = MLCommon::ceildiv(warps, n_ranks) * 32;
+  const int sort_begin = std::min(rank * chunk, n);
+  const int sort_end = std::min(sort_begin + chunk, n);
+
+  unsigned *limiter;
+  int *maxdepthd, *bottomd, *startl, *childl, *countl, *sortl;
+  float *radiusd, *massl, *maxxl, *maxyl, *minxl, *minyl, *forces, *norm_add1,
+    *norm, *radiusd_squared, *grad_norm, *gains_bh, *old_forces, *YY;
+  auto carve = [&](Workspace &ws) {
+    limiter = ws.take<unsigned>(1);
+    maxdepthd = ws.take<int>(1);
+    bottomd = ws.take<int>(1);
+    radiusd = ws.take<float>(1);
+    startl = ws.take<int>(nnodes + 1);
+    childl = ws.take<int>((nnodes + 1) * 4);
+    massl = ws.take<float>(nnodes + 1);
+    maxxl = ws.take<float>(blocks * FACTOR1);
+    maxyl = ws.take<float>(blocks * FACTOR1);
+    minxl = ws.take<float>(blocks * FACTOR1);
+    minyl = ws.take<float>(blocks * FACTOR1);
+    countl = ws.take<int>(nnodes + 1);
+    sortl = ws.take<int>(nnodes + 1);
+    // The attractive forces, the repulsive forces and Z, summed over the
+    // ranks in one allreduce
+    forces = ws.take<float>(n * 4 + 1);
+    norm_add1 = ws.take<float>(n);
+    norm = ws.take<float>(n);
+    radiusd_squared = ws.take<float>(1);
+    grad_norm = ws.take<float>(1);
+    gains_bh = ws.take<float>(n * 2);
+    old_forces = ws.take<float>(n * 2);
+    YY = ws.take<float>((nnodes + 1) * 2);
+  };
+  Workspace sizes;
+  carve(sizes);
+  MLCommon::device_buffer<char> workspace(d_alloc, stream, sizes.size);
+  Workspace ws(workspace.data());
+  carve(ws);
+
+  float *attr_forces = forces;
+  float *rep_forces = forces + n * 2;
+  float *Z_norm = forces + n * 4;
+
+  TSNE::InitializationKernel<<<1, 1, 0, stream>>>(limiter, maxdepthd,
+                                                  radiusd);
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  const int FOUR_NNODES = 4 * nnodes;
+  const int FOUR_N = 4 * n;
+  const float theta_squared = theta * theta;
+  const int NNODES = nnodes;
+
+  thrust::device_ptr<float> begin_massl = thrust::device_pointer_cast(massl);
+  thrust::fill(thrust::cuda::par.on(stream), begin_massl,
+               begin_massl + (nnodes + 1), 1.0f);
+
+  thrust::device_ptr<float> begin_gains_bh =
+    thrust::device_pointer_cast(gains_bh);
+  thrust::fill(thrust::cuda::par.on(stream), begin_gains_bh,
+               begin_gains_bh + (n * 2), 1.0f);
+
+  CUDA_CHECK(cudaMemsetAsync(old_forces, 0, sizeof(float) * n * 2, stream));
+
+  // All the ranks start from the embedding of rank 0
+  random_vector(YY, -0.0001f, 0.0001f, (nnodes + 1) * 2, stream, random_state);
+  comm.bcast(YY, n, 0, stream);
+  comm.bcast(YY + nnodes + 1, n, 0, stream);
+
+  cudaFuncSetCacheConfig(TSNE::BoundingBoxKernel, cudaFuncCachePreferShared);
+  cudaFuncSetCacheConfig(TSNE::TreeBuildingKernel, cudaFuncCachePreferL1);
+  cudaFuncSetCacheConfig(TSNE::ClearKernel1, cudaFuncCachePreferL1);
+  cudaFuncSetCacheConfig(TSNE::ClearKernel2, cudaFuncCachePreferL1);
+  cudaFuncSetCacheConfig(TSNE::SummarizationKernel, cudaFuncCachePreferShared);
+  cudaFuncSetCacheConfig(TSNE::SortKernel, cudaFuncCachePreferL1);
+  cudaFuncSetCacheConfig(TSNE::RepulsionKernel, cudaFuncCachePreferL1);
+  cudaFuncSetCacheConfig(TSNE::attractive_kernel_bh, cudaFuncCachePreferL1);
+  cudaFuncSetCacheConfig(TSNE::IntegrationKernel, cudaFuncCachePreferL1);
+
+  if (verbose) printf("[Info] Start gradient updates!\n");
+
+  float momentum = pre_momentum;
+  float learning_rate = pre_learning_rate;
+
+  for (int iter = 0; iter < max_iter; iter++) {
+    if (iter == exaggeration_iter) {
+      momentum = post_momentum;
+      // Divide perplexities
+      const float div = 1.0f / early_exaggeration;
+      MLCommon::LinAlg::scalarMultiply(VAL, VAL, div, NNZ, stream);
+      learning_rate = post_learning_rate;
+    }
+
+    CUDA_CHECK(cudaMemsetAsync(forces, 0, sizeof(float) * (n * 4 + 1), stream));
+    TSNE::Reset_Normalization<<<1, 1, 0, stream>>>(Z_norm, radiusd_squared,
+                                                   bottomd, NNODES, radiusd);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    START_TIMER;
+    TSNE::BoundingBoxKernel<<<blocks * FACTOR1, THREADS1, 0, stream>>>(
+      startl, childl, massl, YY, YY + nnodes + 1, maxxl, maxyl, minxl, minyl,
+      FOUR_NNODES, NNODES, n, limiter, radiusd);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    TSNE::ClearKernel1<<<blocks, 1024, 0, stream>>>(childl, FOUR_NNODES,
+                                                    FOUR_N);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    TSNE::TreeBuildingKernel<<<blocks * FACTOR2, THREADS2, 0, stream>>>(
+      childl, YY, YY + nnodes + 1, NNODES, n, maxdepthd, bottomd, radiusd);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    TSNE::ClearKernel2<<<blocks * 1, 1024, 0, stream>>>(startl, massl, NNODES,
+                                                        bottomd);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    TSNE::SummarizationKernel<<<blocks * FACTOR3, THREADS3, 0, stream>>>(
+      countl, childl, massl, YY, YY + nnodes + 1, NNODES, n, bottomd);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    TSNE::SortKernel<<<blocks * FACTOR4, THREADS4, 0, stream>>>(
+      sortl, countl, startl, childl, NNODES, n, bottomd);
+    CUDA_CHECK(cudaPeekAtLastError());
+    END_TIMER(TreeBuildingKernel_time);
+
+    START_TIMER;
+    // The trees of the ranks may number their cells apart, so the chunks are
+    // of the order of rank 0; the bodies out of the chunk of this rank are
+    // masked with -1, which the RepulsionKernel skips
+    comm.bcast(sortl, n, 0, stream);
+    CUDA_CHECK(cudaMemsetAsync(sortl, 0xFF, sizeof(int) * sort_begin, stream));
+    CUDA_CHECK(cudaMemsetAsync(sortl + sort_end, 0xFF,
+                               sizeof(int) * (n - sort_end), stream));
+    TSNE::RepulsionKernel<<<blocks * FACTOR5, THREADS5, 0, stream>>>(
+      theta, epssq, sortl, childl, massl, YY, YY + nnodes + 1, rep_forces,
+      rep_forces + n, Z_norm, theta_squared, NNODES, FOUR_NNODES, n,
+      radiusd_squared, maxdepthd);
+    CUDA_CHECK(cudaPeekAtLastError());
+    END_TIMER(RepulsionTime);
+
+    START_TIMER;
+    TSNE::get_norm<<<MLCommon::ceildiv(n, 1024), 1024, 0, stream>>>(
+      YY, YY + nnodes + 1, norm, norm_add1, n);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    TSNE::
+      attractive_kernel_bh<<<MLCommon::ceildiv(NNZ, 1024), 1024, 0, stream>>>(
+        VAL, COL, ROW, YY, YY + nnodes + 1, norm, norm_add1, attr_forces,
+        attr_forces + n, NNZ);
+    CUDA_CHECK(cudaPeekAtLastError());
+    END_TIMER(attractive_time);
+
+    START_TIMER;
+    allreduce(comm, forces, n * 4 + 1, MLCommon::cumlCommunicator::SUM,
+              stream);
+    TSNE::Find_Normalization<<<1, 1, 0, stream>>>(Z_norm, n);
+    CUDA_CHECK(cudaPeekAtLastError());
+    END_TIMER(Reduction_time);
+
+    START_TIMER;
+    TSNE::IntegrationKernel<<<blocks * FACTOR6, THREADS6, 0, stream>>>(
+      learning_rate, momentum, early_exaggeration, YY, YY + nnodes + 1,
+      attr_forces, attr_forces + n, rep_forces, rep_forces + n, gains_bh,
+      gains_bh + n, old_forces, old_forces + n, Z_norm, n);
+    CUDA_CHECK(cudaPeekAtLastError());
+    END_TIMER(IntegrationKernel_time);
+
+    // The forces are the same on all the ranks, which all stop together
+    if (iter > exaggeration_iter && iter % BH_CHECK_EVERY == 0) {
+      CUDA_CHECK(cudaMemsetAsync(grad_norm, 0, sizeof(float), stream));
+      TSNE::GradientNormKernel<<<blocks * FACTOR6, THREADS6, 0, stream>>>(
+        attr_forces, attr_forces + n, rep_forces, rep_forces + n, Z_norm,
+        grad_norm, n);
+      CUDA_CHECK(cudaPeekAtLastError());
+      float gradient_norm;
+      MLCommon::updateHost(&gradient_norm, grad_norm, 1, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+      gradient_norm = sqrtf(gradient_norm);
+
+      if (gradient_norm < min_grad_norm) {
+        if (verbose)
+          printf(
+            "Gradient norm = %f <= min_grad_norm = %f. Early stopped at iter "
+            "= %d\n",
+            gradient_norm, min_grad_norm, iter);
+        break;
+      }
+    }
+  }
+  PRINT_TIMES;
+
+  // Copy the rows of this rank into Y
+  MLCommon::copyAsync(Y, YY + offset, n_local, stream);
+  MLCommon::copyAsync(Y + n_local, YY + nnodes + 1 + offset, n_local, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+}
+
+}  // namespace mg
+}  // namespace TSNE
+}  // namespace ML
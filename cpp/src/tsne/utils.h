@@ -63,6 +63,24 @@ void random_vector(float *vector, const float minimum, const float maximum,
   CUDA_CHECK(cudaPeekAtLastError());
 }
 
+/**
+ * @brief Carves 256 byte aligned buffers out of one pre-sized workspace. A
+ * first pass over the buffers with a null base only sums up its size.
+ */
+struct Workspace {
+  char *base;
+  size_t size;
+
+  Workspace(char *base = nullptr) : base(base), size(0) {}
+
+  template <typename T>
+  T *take(const size_t len) {
+    T *out = (T *)(base + size);
+    size += MLCommon::alignTo<size_t>(sizeof(T) * len, 256);
+    return out;
+  }
+};
+
 long start, end;
 struct timeval timecheck;
 double SymmetrizeTime = 0, DistancesTime = 0, NormalizeTime = 0,
@@ -16,6 +16,7 @@
 
 #include <cuml/decomposition/tsvd.hpp>
 #include "tsvd.h"
+#include "tsvd_mg.h"
 
 namespace ML {
 
@@ -33,6 +34,48 @@ void tsvdFit(cumlHandle &handle, double *input, double *components,
           handle.getStream());
 }
 
+void tsvdFitMG(cumlHandle &handle, float *input, float *components,
+               float *singular_vals, paramsTSVD prms) {
+  tsvdFitMG(handle.getImpl(), input, components, singular_vals, prms,
+            handle.getStream());
+}
+
+void tsvdFitMG(cumlHandle &handle, double *input, double *components,
+               double *singular_vals, paramsTSVD prms) {
+  tsvdFitMG(handle.getImpl(), input, components, singular_vals, prms,
+            handle.getStream());
+}
+
+void tsvdFitSparse(cumlHandle &handle, const float *values, const int *cols,
+                   const int *row_ids, int nnz, float *components,
+                   float *singular_vals, paramsTSVD prms) {
+  tsvdFitSparse(handle.getImpl(), values, cols, row_ids, nnz, components,
+                singular_vals, prms, handle.getStream());
+}
+
+void tsvdFitSparse(cumlHandle &handle, const double *values, const int *cols,
+                   const int *row_ids, int nnz, double *components,
+                   double *singular_vals, paramsTSVD prms) {
+  tsvdFitSparse(handle.getImpl(), values, cols, row_ids, nnz, components,
+                singular_vals, prms, handle.getStream());
+}
+
+void tsvdTransformSparse(cumlHandle &handle, const float *values,
+                         const int *cols, const int *row_ids, int nnz,
+                         float *components, float *trans_input,
+                         paramsTSVD prms) {
+  tsvdTransformSparse(handle.getImpl(), values, cols, row_ids, nnz, components,
+                      trans_input, prms, handle.getStream());
+}
+
+void tsvdTransformSparse(cumlHandle &handle, const double *values,
+                         const int *cols, const int *row_ids, int nnz,
+                         double *components, double *trans_input,
+                         paramsTSVD prms) {
+  tsvdTransformSparse(handle.getImpl(), values, cols, row_ids, nnz, components,
+                      trans_input, prms, handle.getStream());
+}
+
 void tsvdFitTransform(cumlHandle &handle, float *input, float *trans_input,
                       float *components, float *explained_var,
                       float *explained_var_ratio, float *singular_vals,
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cuda_utils.h>
 #include <linalg/binary_op.h>
 #include <linalg/cublas_wrappers.h>
@@ -26,6 +27,8 @@
 #include <linalg/transpose.h>
 #include <matrix/math.h>
 #include <matrix/matrix.h>
+#include <random/rng.h>
+#include <sparse/cusparse_wrappers.h>
 #include <stats/mean.h>
 #include <stats/stddev.h>
 #include <stats/sum.h>
@@ -40,45 +43,47 @@ namespace ML {
 
 using namespace MLCommon;
 
+/**
+ * @brief computes the leading right singular vectors and singular values of
+ * the input by randomized SVD, without forming the n_cols x n_cols cross
+ * product: the input is sketched onto n_components + n_oversamples random
+ * directions, refined by n_power_iters power iterations.
+ * @input param handle: the internal cuml handle object
+ * @input param in: the input data. Size n_rows x n_cols.
+ * @output param components: the leading right singular vectors, as rows. Size n_components * n_cols.
+ * @output param singular_vals: singular values of the data. Size n_components * 1
+ * @input param prms: data structure that includes all the parameters from input size to algorithm.
+ * @input param stream cuda stream
+ */
 template <typename math_t>
-void calCompExpVarsSvd(const cumlHandle_impl &handle, math_t *in,
-                       math_t *components, math_t *singular_vals,
-                       math_t *explained_vars, math_t *explained_var_ratio,
-                       paramsTSVD prms, cudaStream_t stream) {
+void calCompRsvd(const cumlHandle_impl &handle, math_t *in,
+                 math_t *components, math_t *singular_vals, paramsTSVD prms,
+                 cudaStream_t stream) {
   auto cusolver_handle = handle.getcusolverDnHandle();
   auto cublas_handle = handle.getCublasHandle();
   auto allocator = handle.getDeviceAllocator();
 
-  int diff = prms.n_cols - prms.n_components;
-  math_t ratio = math_t(diff) / math_t(prms.n_cols);
-  ASSERT(ratio >= math_t(0.2),
-         "Number of components should be less than at least 80 percent of the "
-         "number of features");
-
-  int p = int(math_t(0.1) * math_t(prms.n_cols));
-  // int p = int(math_t(prms.n_cols) / math_t(4));
-  ASSERT(p >= 5,
-         "RSVD should be used where the number of columns are at least 50");
-
-  int total_random_vecs = prms.n_components + p;
-  ASSERT(total_random_vecs < prms.n_cols,
-         "RSVD should be used where the number of columns are at least 50");
-
-  device_buffer<math_t> components_temp(allocator, stream,
-                                        prms.n_cols * prms.n_components);
-  math_t *left_eigvec = nullptr;
-  LinAlg::rsvdFixedRank(in, prms.n_rows, prms.n_cols, singular_vals,
-                        left_eigvec, components_temp.data(), prms.n_components,
-                        p, true, false, true, false, (math_t)prms.tol,
-                        prms.n_iterations, cusolver_handle, cublas_handle,
-                        stream);
-
-  LinAlg::transpose(components_temp.data(), components, prms.n_cols,
-                    prms.n_components, cublas_handle, stream);
-  Matrix::power(singular_vals, explained_vars, math_t(1), prms.n_components,
-                stream);
-  Matrix::ratio(explained_vars, explained_var_ratio, prms.n_components, stream,
-                allocator);
+  ASSERT(prms.n_oversamples >= 0,
+         "Parameter n_oversamples: cannot be negative");
+  ASSERT(prms.n_power_iters >= 0,
+         "Parameter n_power_iters: cannot be negative");
+  int k = prms.n_components;
+  int rank = std::min(prms.n_rows, prms.n_cols);
+  ASSERT(k <= rank,
+         "The randomized solver computes at most min(n_rows, n_cols) "
+         "components");
+  int p = std::min(prms.n_oversamples, rank - k);
+
+  device_buffer<math_t> components_temp(allocator, stream, prms.n_cols * k);
+  math_t *right_vec = components_temp.data();
+  math_t *left_vec = nullptr;
+  LinAlg::rsvdFixedRank(in, prms.n_rows, prms.n_cols, singular_vals, left_vec,
+                        right_vec, k, p, false, false, true, false,
+                        (math_t)prms.tol, prms.n_iterations, cusolver_handle,
+                        cublas_handle, stream, allocator, prms.n_power_iters);
+
+  LinAlg::transpose(right_vec, components, prms.n_cols, k, cublas_handle,
+                    stream);
 }
 
 template <typename math_t>
@@ -178,6 +183,11 @@ void tsvdFit(const cumlHandle_impl &handle, math_t *input, math_t *components,
 
   if (prms.n_components > prms.n_cols) prms.n_components = prms.n_cols;
 
+  if (prms.algorithm == solver::RANDOMIZED) {
+    calCompRsvd(handle, input, components, singular_vals, prms, stream);
+    return;
+  }
+
   int len = prms.n_cols * prms.n_cols;
   device_buffer<math_t> input_cross_mult(allocator, stream, len);
 
@@ -201,6 +211,143 @@ void tsvdFit(const cumlHandle_impl &handle, math_t *input, math_t *components,
                   prms.n_components, stream);
 }
 
+/**
+ * C = op(A) B with A the n_rows x n_cols CSR input of tsvdFitSparse, B and C
+ * dense column major with n_vecs columns
+ */
+template <typename math_t>
+void tsvdCsrmm(const cumlHandle_impl &handle, const math_t *values,
+               const int *cols, const int *row_ids, int nnz, int n_rows,
+               int n_cols, bool transA, const math_t *B, int n_vecs, math_t *C,
+               cudaStream_t stream) {
+  math_t alpha = math_t(1);
+  math_t beta = math_t(0);
+  cusparseMatDescr_t descr;
+  CUSPARSE_CHECK(cusparseCreateMatDescr(&descr));
+  CUSPARSE_CHECK(Sparse::cusparse_csrmm2(
+    handle.getcusparseHandle(),
+    transA ? CUSPARSE_OPERATION_TRANSPOSE : CUSPARSE_OPERATION_NON_TRANSPOSE,
+    CUSPARSE_OPERATION_NON_TRANSPOSE, n_rows, n_vecs, n_cols, nnz, &alpha,
+    descr, values, row_ids, cols, B, transA ? n_rows : n_cols, &beta, C,
+    transA ? n_cols : n_rows, stream));
+  CUSPARSE_CHECK(cusparseDestroyMatDescr(descr));
+}
+
+/**
+ * @brief perform fit operation for the tsvd on a sparse input, without densifying it. The components are those of
+ * a randomized SVD, see calCompRsvd, whose products with the input are CSR x dense products.
+ * @input param handle: the internal cuml handle object
+ * @input param values: the nnz values of the CSR input. Size n_rows x n_cols, as indicated in prms.
+ * @input param cols: the column indices of the values
+ * @input param row_ids: the row offsets into values. Size n_rows + 1.
+ * @input param nnz: number of values
+ * @output param components: the principal components of the input data. Size n_cols * n_components.
+ * @output param singular_vals: singular values of the data. Size n_components * 1
+ * @input param prms: data structure that includes all the parameters from input size to algorithm.
+ * @input param stream cuda stream
+ */
+template <typename math_t>
+void tsvdFitSparse(const cumlHandle_impl &handle, const math_t *values,
+                   const int *cols, const int *row_ids, int nnz,
+                   math_t *components, math_t *singular_vals, paramsTSVD prms,
+                   cudaStream_t stream) {
+  auto cusolver_handle = handle.getcusolverDnHandle();
+  auto cublas_handle = handle.getCublasHandle();
+  auto allocator = handle.getDeviceAllocator();
+
+  ASSERT(prms.n_cols > 1,
+         "Parameter n_cols: number of columns cannot be less than two");
+  ASSERT(prms.n_rows > 1,
+         "Parameter n_rows: number of rows cannot be less than two");
+  ASSERT(
+    prms.n_components > 0,
+    "Parameter n_components: number of components cannot be less than one");
+  ASSERT(prms.n_oversamples >= 0,
+         "Parameter n_oversamples: cannot be negative");
+  ASSERT(prms.n_power_iters >= 0,
+         "Parameter n_power_iters: cannot be negative");
+
+  int m = prms.n_rows, n = prms.n_cols;
+  int k = prms.n_components;
+  int rank = std::min(m, n);
+  ASSERT(k <= rank,
+         "The sparse solver computes at most min(n_rows, n_cols) components");
+  int l = k + std::min(prms.n_oversamples, rank - k);
+
+  // the range of the input is sampled as Y = A R, refined by the power
+  // iterations Y = A A^T Y, orthonormalized at each product
+  device_buffer<math_t> R(allocator, stream, n * l);
+  Random::Rng rng(484);
+  rng.normal(R.data(), n * l, math_t(0), math_t(1), stream);
+  device_buffer<math_t> Y(allocator, stream, m * l);
+  device_buffer<math_t> Q(allocator, stream, m * l);
+  device_buffer<math_t> Z(allocator, stream, n * l);
+  tsvdCsrmm(handle, values, cols, row_ids, nnz, m, n, false, R.data(), l,
+            Y.data(), stream);
+  for (int i = 0; i < prms.n_power_iters; i++) {
+    LinAlg::qrGetQ(Y.data(), Q.data(), m, l, cusolver_handle, stream,
+                   allocator);
+    tsvdCsrmm(handle, values, cols, row_ids, nnz, m, n, true, Q.data(), l,
+              Z.data(), stream);
+    LinAlg::qrGetQ(Z.data(), R.data(), n, l, cusolver_handle, stream,
+                   allocator);
+    tsvdCsrmm(handle, values, cols, row_ids, nnz, m, n, false, R.data(), l,
+              Y.data(), stream);
+  }
+  LinAlg::qrGetQ(Y.data(), Q.data(), m, l, cusolver_handle, stream, allocator);
+
+  // A ~ Q B with B^T = A^T Q = Qhat Rhat, so that the right singular vectors
+  // of A are Qhat times the left ones of Rhat
+  tsvdCsrmm(handle, values, cols, row_ids, nnz, m, n, true, Q.data(), l,
+            Z.data(), stream);
+  device_buffer<math_t> Rhat(allocator, stream, l * l);
+  LinAlg::qrGetQR(Z.data(), R.data(), Rhat.data(), n, l, cusolver_handle,
+                  stream, allocator);
+  device_buffer<math_t> S(allocator, stream, l);
+  device_buffer<math_t> Uhat(allocator, stream, l * l);
+  device_buffer<math_t> Vhat(allocator, stream, l * l);
+  LinAlg::svdQR(Rhat.data(), l, l, S.data(), Uhat.data(), Vhat.data(), true,
+                true, true, cusolver_handle, cublas_handle, allocator, stream);
+  copy(singular_vals, S.data(), k, stream);
+
+  device_buffer<math_t> V(allocator, stream, n * k);
+  math_t alpha = math_t(1);
+  math_t beta = math_t(0);
+  LinAlg::gemm(R.data(), n, l, Uhat.data(), V.data(), n, k, CUBLAS_OP_N,
+               CUBLAS_OP_N, alpha, beta, cublas_handle, stream);
+  LinAlg::transpose(V.data(), components, n, k, cublas_handle, stream);
+}
+
+/**
+ * @brief performs transform operation for the tsvd on a sparse input, see tsvdFitSparse.
+ * @input param handle the internal cuml handle object
+ * @input param values: the nnz values of the CSR input. Size n_rows x n_cols, as indicated in prms.
+ * @input param cols: the column indices of the values
+ * @input param row_ids: the row offsets into values. Size n_rows + 1.
+ * @input param nnz: number of values
+ * @input param components: principal components of the input data. Size n_cols * n_components.
+ * @output param trans_input: the transformed data. Size n_rows * n_components.
+ * @input param prms: data structure that includes all the parameters from input size to algorithm.
+ * @input param stream cuda stream
+ */
+template <typename math_t>
+void tsvdTransformSparse(const cumlHandle_impl &handle, const math_t *values,
+                         const int *cols, const int *row_ids, int nnz,
+                         math_t *components, math_t *trans_input,
+                         paramsTSVD prms, cudaStream_t stream) {
+  ASSERT(
+    prms.n_components > 0,
+    "Parameter n_components: number of components cannot be less than one");
+
+  device_buffer<math_t> components_t(handle.getDeviceAllocator(), stream,
+                                     prms.n_cols * prms.n_components);
+  LinAlg::transpose(components, components_t.data(), prms.n_components,
+                    prms.n_cols, handle.getCublasHandle(), stream);
+  tsvdCsrmm(handle, values, cols, row_ids, nnz, prms.n_rows, prms.n_cols,
+            false, components_t.data(), prms.n_components, trans_input,
+            stream);
+}
+
 /**
  * @brief performs fit and transform operations for the tsvd. Generates transformed data, eigenvectors, explained vars, singular vals, etc.
  * @input param handle: the internal cuml handle object
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <common/cuml_comms_int.hpp>
+#include "tsvd/tsvd.h"
+
+namespace ML {
+
+/**
+ * @brief perform fit operation for the tsvd on the rows of all the ranks of the communicator of the handle, each rank
+ * holding a shard of the rows. The n_cols x n_cols cross products of the local rows are summed by one allreduce, and
+ * every rank then computes the same components, as tsvdFit.
+ * @input param handle: the internal cuml handle object, with a communicator
+ * @input param input: the local rows. Size n_rows x n_cols, n_rows being the number of local rows in prms.
+ * @output param components: the principal components of the input data. Size n_cols * n_components.
+ * @output param singular_vals: singular values of the data. Size n_components * 1
+ * @input param prms: data structure that includes all the parameters from input size to algorithm.
+ * @input param stream cuda stream
+ */
+template <typename math_t>
+void tsvdFitMG(const cumlHandle_impl &handle, math_t *input,
+               math_t *components, math_t *singular_vals, paramsTSVD prms,
+               cudaStream_t stream) {
+  ASSERT(handle.commsInitialized(),
+         "A distributed TSVD requires a handle with a communicator");
+  const MLCommon::cumlCommunicator &comm = handle.getCommunicator();
+  auto cublas_handle = handle.getCublasHandle();
+  auto allocator = handle.getDeviceAllocator();
+
+  ASSERT(prms.n_cols > 1,
+         "Parameter n_cols: number of columns cannot be less than two");
+  ASSERT(prms.n_rows > 0,
+         "Parameter n_rows: number of local rows cannot be less than one");
+  ASSERT(
+    prms.n_components > 0,
+    "Parameter n_components: number of components cannot be less than one");
+
+  if (prms.n_components > prms.n_cols) prms.n_components = prms.n_cols;
+
+  int len = prms.n_cols * prms.n_cols;
+  device_buffer<math_t> input_cross_mult(allocator, stream, len);
+
+  math_t alpha = math_t(1);
+  math_t beta = math_t(0);
+  LinAlg::gemm(input, prms.n_rows, prms.n_cols, input, input_cross_mult.data(),
+               prms.n_cols, prms.n_cols, CUBLAS_OP_T, CUBLAS_OP_N, alpha, beta,
+               cublas_handle, stream);
+  comm.allreduce(input_cross_mult.data(), input_cross_mult.data(), len,
+                 MLCommon::cumlCommunicator::SUM, stream);
+
+  device_buffer<math_t> components_all(allocator, stream, len);
+  device_buffer<math_t> explained_var_all(allocator, stream, prms.n_cols);
+
+  calEig(handle, input_cross_mult.data(), components_all.data(),
+         explained_var_all.data(), prms, stream);
+
+  Matrix::truncZeroOrigin(components_all.data(), prms.n_cols, components,
+                          prms.n_components, prms.n_cols, stream);
+
+  math_t scalar = math_t(1);
+  Matrix::seqRoot(explained_var_all.data(), singular_vals, scalar,
+                  prms.n_components, stream);
+}
+
+};  // end namespace ML
@@ -345,10 +345,11 @@ void launcher(int n, const long *knn_indices, const float *knn_dists,
 
   /**
    * Combines all the fuzzy simplicial sets into a global
-   * one via a fuzzy union. (Symmetrize knn graph).
+   * one via a fuzzy union. (Symmetrize knn graph). The result
+   * is sorted and has no zeros.
    */
   float set_op_mix_ratio = params->set_op_mix_ratio;
-  MLCommon::Sparse::coo_symmetrize<TPB_X, T>(
+  MLCommon::Sparse::coo_symmetrize_csr<TPB_X, T>(
     &in, out,
     [set_op_mix_ratio] __device__(int row, int col, T result, T transpose) {
       T prod_matrix = result * transpose;
@@ -357,8 +358,6 @@ void launcher(int n, const long *knn_indices, const float *knn_dists,
       return res;
     },
     d_alloc, stream);
-
-  MLCommon::Sparse::coo_sort<T>(out, d_alloc, stream);
 }
 }  // namespace Naive
 }  // namespace FuzzySimplSet
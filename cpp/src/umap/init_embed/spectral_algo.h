@@ -20,13 +20,17 @@
 #include "common/device_buffer.hpp"
 
 #include "sparse/coo.h"
+#include "sparse/csr.h"
+#include "sparse/cusparse_wrappers.h"
+#include "sparse/lanczos.h"
 
 #include "linalg/add.h"
 
 #include "linalg/transpose.h"
 #include "random/rng.h"
 
-#include <cuml/cluster/spectral.hpp>
+#include "random_algo.h"
+
 #include <iostream>
 
 namespace UMAPAlgo {
@@ -38,24 +42,189 @@ namespace SpectralInit {
 using namespace ML;
 
 /**
-   * Performs a spectral layout initialization
-   */
+ * Sets q to the square root of the degree of each vertex, or to 1 for an
+ * isolated vertex; per connected component, q spans the eigenvector of
+ * D^-1/2 A D^-1/2 of the largest eigenvalue, 1.
+ */
+template <int TPB_X, typename T>
+__global__ void spectral_degree_kernel(const int *row_ind, const T *vals,
+                                       int n, T *q) {
+  int row = blockIdx.x * TPB_X + threadIdx.x;
+  if (row < n) {
+    T degree = 0;
+    for (int e = row_ind[row]; e < row_ind[row + 1]; e++) degree += vals[e];
+    q[row] = degree > T(0) ? sqrt(degree) : T(1);
+  }
+}
+
+template <int TPB_X, typename T>
+__global__ void spectral_normalize_kernel(const int *rows, const int *cols,
+                                          const T *vals, int nnz, const T *q,
+                                          T *norm_vals) {
+  int e = blockIdx.x * TPB_X + threadIdx.x;
+  if (e < nnz) norm_vals[e] = vals[e] / (q[rows[e]] * q[cols[e]]);
+}
+
+/**
+ * Accumulates the dot product of x and q over each connected component,
+ * indexed by the labels of the components, numbered from 1
+ */
+template <int TPB_X, typename T>
+__global__ void spectral_component_dot_kernel(const T *x, const T *q,
+                                              const int *labels, int n,
+                                              T *dots) {
+  int row = blockIdx.x * TPB_X + threadIdx.x;
+  if (row < n) atomicAdd(dots + labels[row] - 1, q[row] * x[row]);
+}
+
+/**
+ * Projects x out of the per-component restrictions of q
+ */
+template <int TPB_X, typename T>
+__global__ void spectral_deflate_kernel(T *x, const T *q, const int *labels,
+                                        const T *dots, const T *q_norms,
+                                        int n) {
+  int row = blockIdx.x * TPB_X + threadIdx.x;
+  if (row < n) {
+    int c = labels[row] - 1;
+    x[row] -= q[row] * dots[c] / q_norms[c];
+  }
+}
+
+template <int TPB_X, typename T>
+__global__ void spectral_offset_kernel(T *embedding, const T *offsets,
+                                       const int *labels, int n,
+                                       int n_components) {
+  int idx = blockIdx.x * TPB_X + threadIdx.x;
+  if (idx < n * n_components) {
+    int row = idx / n_components, col = idx % n_components;
+    embedding[idx] += offsets[(labels[row] - 1) * n_components + col];
+  }
+}
+
+/**
+ * Performs a spectral layout initialization: the embedding is made of the
+ * eigenvectors of the n_components smallest nontrivial eigenvalues of the
+ * normalized Laplacian I - D^-1/2 A D^-1/2 of the graph, computed by Lanczos
+ * iterations on I + D^-1/2 A D^-1/2 from which the eigenvectors of the
+ * eigenvalue 2, one per connected component, are deflated. When the graph
+ * is disconnected, each component is then shifted by its own random offset,
+ * drawn as the random initialization draws its coordinates. Falls back to
+ * the random initialization when the graph has too many components for
+ * n_components nontrivial eigenvectors or when Lanczos does not converge.
+ */
 template <typename T>
 void launcher(const cumlHandle &handle, const T *X, int n, int d,
               const long *knn_indices, const T *knn_dists,
               MLCommon::Sparse::COO<float> *coo, UMAPParams *params,
               T *embedding) {
+  constexpr int TPB_X = 256;
   cudaStream_t stream = handle.getStream();
+  auto d_alloc = handle.getDeviceAllocator();
+  int k = params->n_components;
 
-  ASSERT(n > params->n_components,
-         "Spectral layout requires n_samples > n_components");
+  ASSERT(n > k, "Spectral layout requires n_samples > n_components");
 
-  MLCommon::device_buffer<T> tmp_storage(handle.getDeviceAllocator(), stream,
-                                         n * params->n_components);
+  /**
+   * CSR of the graph and its connected components
+   */
+  MLCommon::Sparse::coo_sort<T>(coo, d_alloc, stream);
+  int nnz = coo->nnz;
+  MLCommon::device_buffer<int> row_ind(d_alloc, stream, n + 1);
+  MLCommon::Sparse::sorted_coo_to_csr(coo->rows(), nnz, row_ind.data(), n,
+                                      d_alloc, stream);
+  MLCommon::updateDevice(row_ind.data() + n, &nnz, 1, stream);
+
+  MLCommon::device_buffer<int> labels(d_alloc, stream, n);
+  int n_graph_components = MLCommon::Sparse::weak_cc_union_find<int, TPB_X>(
+    labels.data(), row_ind.data(), coo->cols(), nnz, n, d_alloc, stream);
+
+  if (params->verbose)
+    std::cout << "Spectral init: " << n_graph_components
+              << " connected components" << std::endl;
+
+  if (n - n_graph_components <= k) {
+    if (params->verbose)
+      std::cout << "Spectral init: too many connected components, "
+                << "falling back to random init" << std::endl;
+    RandomInit::launcher(X, n, d, knn_indices, knn_dists, params, embedding,
+                         stream);
+    return;
+  }
+
+  /**
+   * The operator I + D^-1/2 A D^-1/2, deflated of its eigenvalue 2
+   */
+  dim3 grid_n(MLCommon::ceildiv(n, TPB_X), 1, 1);
+  dim3 grid_nnz(MLCommon::ceildiv(nnz, TPB_X), 1, 1);
+  dim3 blk(TPB_X, 1, 1);
+
+  MLCommon::device_buffer<T> q(d_alloc, stream, n);
+  MLCommon::device_buffer<T> norm_vals(d_alloc, stream, nnz);
+  MLCommon::device_buffer<T> dots(d_alloc, stream, n);
+  MLCommon::device_buffer<T> q_norms(d_alloc, stream, n);
+
+  spectral_degree_kernel<TPB_X, T>
+    <<<grid_n, blk, 0, stream>>>(row_ind.data(), coo->vals(), n, q.data());
+  spectral_normalize_kernel<TPB_X, T><<<grid_nnz, blk, 0, stream>>>(
+    coo->rows(), coo->cols(), coo->vals(), nnz, q.data(), norm_vals.data());
+  CUDA_CHECK(cudaMemsetAsync(q_norms.data(), 0, n * sizeof(T), stream));
+  spectral_component_dot_kernel<TPB_X, T><<<grid_n, blk, 0, stream>>>(
+    q.data(), q.data(), labels.data(), n, q_norms.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  auto deflate = [&](T *x) {
+    CUDA_CHECK(cudaMemsetAsync(dots.data(), 0, n * sizeof(T), stream));
+    spectral_component_dot_kernel<TPB_X, T><<<grid_n, blk, 0, stream>>>(
+      x, q.data(), labels.data(), n, dots.data());
+    spectral_deflate_kernel<TPB_X, T><<<grid_n, blk, 0, stream>>>(
+      x, q.data(), labels.data(), dots.data(), q_norms.data(), n);
+    CUDA_CHECK(cudaPeekAtLastError());
+  };
 
-  Spectral::fit_embedding(handle, coo->rows(), coo->cols(), coo->vals(),
-                          coo->nnz, n, params->n_components,
-                          tmp_storage.data());
+  cusparseHandle_t cusparse_h = handle.getImpl().getcusparseHandle();
+  cusparseMatDescr_t descr;
+  CUSPARSE_CHECK(cusparseCreateMatDescr(&descr));
+  CUSPARSE_CHECK(cusparseSetMatType(descr, CUSPARSE_MATRIX_TYPE_GENERAL));
+  CUSPARSE_CHECK(cusparseSetMatIndexBase(descr, CUSPARSE_INDEX_BASE_ZERO));
+
+  const T one = 1;
+  auto op = [&](const T *x, T *y) {
+    MLCommon::copyAsync(y, x, n, stream);
+    CUSPARSE_CHECK(MLCommon::Sparse::cusparse_csrmv(
+      cusparse_h, CUSPARSE_OPERATION_NON_TRANSPOSE, n, n, nnz, &one, descr,
+      norm_vals.data(), row_ind.data(), coo->cols(), x, &one, y, stream));
+    deflate(y);
+  };
+
+  long long seed = params->random_state;
+  if (seed < 0) {
+    struct timeval tp;
+    gettimeofday(&tp, NULL);
+    seed = tp.tv_sec * 1000 + tp.tv_usec;
+  }
+  MLCommon::Random::Rng r(seed);
+
+  MLCommon::device_buffer<T> v0(d_alloc, stream, n);
+  r.normal(v0.data(), n, T(0), T(1), stream);
+  deflate(v0.data());
+
+  MLCommon::device_buffer<T> eig_vals(d_alloc, stream, k);
+  MLCommon::device_buffer<T> tmp_storage(d_alloc, stream, n * k);
+  bool converged = MLCommon::Sparse::lanczos_largest<T>(
+    op, n, k, v0.data(), eig_vals.data(), tmp_storage.data(),
+    handle.getImpl().getCublasHandle(), handle.getImpl().getcusolverDnHandle(),
+    d_alloc, stream);
+  CUSPARSE_CHECK(cusparseDestroyMatDescr(descr));
+
+  if (!converged) {
+    if (params->verbose)
+      std::cout << "Spectral init: Lanczos did not converge, "
+                << "falling back to random init" << std::endl;
+    RandomInit::launcher(X, n, d, knn_indices, knn_dists, params, embedding,
+                         stream);
+    return;
+  }
 
   MLCommon::LinAlg::transpose(tmp_storage.data(), embedding, n,
                               params->n_components,
@@ -69,11 +238,6 @@ void launcher(const cumlHandle &handle, const T *X, int n, int d,
   T max = *(thrust::max_element(thrust::cuda::par.on(stream), d_ptr,
                                 d_ptr + (n * params->n_components)));
 
-  struct timeval tp;
-  gettimeofday(&tp, NULL);
-  long long seed = tp.tv_sec * 1000 + tp.tv_usec;
-
-  MLCommon::Random::Rng r(seed);
   r.normal(tmp_storage.data(), n * params->n_components, 0.0f, 0.0001f, stream);
 
   MLCommon::LinAlg::unaryOp<T>(
@@ -83,6 +247,13 @@ void launcher(const cumlHandle &handle, const T *X, int n, int d,
   MLCommon::LinAlg::add(embedding, embedding, tmp_storage.data(),
                         n * params->n_components, stream);
 
+  if (n_graph_components > 1) {
+    r.uniform<T>(tmp_storage.data(), n * k, -10, 10, stream);
+    dim3 grid_nk(MLCommon::ceildiv(n * k, TPB_X), 1, 1);
+    spectral_offset_kernel<TPB_X, T><<<grid_nk, blk, 0, stream>>>(
+      embedding, tmp_storage.data(), labels.data(), n, k);
+  }
+
   CUDA_CHECK(cudaPeekAtLastError());
 }
 }  // namespace SpectralInit
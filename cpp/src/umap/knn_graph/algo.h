@@ -16,9 +16,12 @@
 
 #include <cuda_utils.h>
 #include <cuml/manifold/umapparams.h>
+#include <cuml/neighbors/knn.hpp>
 #include <iostream>
 #include "linalg/unary_op.h"
 #include "selection/knn.h"
+#include "selection/knn_graph.h"
+#include "selection/sparse_knn.h"
 
 #pragma once
 
@@ -31,8 +34,9 @@ namespace Algo {
 using namespace ML;
 
 /**
- * Initial implementation calls out to FAISS to do its work.
- * TODO: cuML kNN implementation should support FAISS' approx NN variants (e.g. IVFPQ GPU).
+ * Calls out to FAISS to do its work: a brute force search, or a search of
+ * the approximate index params->knn_index (e.g. IVFPQ GPU), which must have
+ * been created with the cumlHandle of the UMAP call.
  */
 
 /**
@@ -45,19 +49,56 @@ void launcher(float *X, int x_n, float *X_query, int x_q_n, int d,
               long *knn_indices, T *knn_dists, int n_neighbors,
               UMAPParams *params, std::shared_ptr<deviceAllocator> d_alloc,
               cudaStream_t stream) {
-  std::vector<float *> ptrs(1);
-  std::vector<int> sizes(1);
-  ptrs[0] = X;
-  sizes[0] = x_n;
+  if (params->knn_index != nullptr) {
+    ASSERT(params->knn_index->size() == x_n && params->knn_index->dim() == d,
+           "knn_index must hold the %d rows of X", x_n);
+    params->knn_index->search(X_query, x_q_n, knn_indices, knn_dists,
+                              n_neighbors);
+  } else if (X_query == X && x_q_n == x_n) {
+    // The kNN graph of X: each tile of distances serves both its rows and
+    // its cols
+    MLCommon::Selection::knn_graph_self_join(X, x_n, d, n_neighbors, true,
+                                             knn_indices, knn_dists, d_alloc,
+                                             stream);
+  } else {
+    std::vector<float *> ptrs(1);
+    std::vector<int> sizes(1);
+    ptrs[0] = X;
+    sizes[0] = x_n;
 
-  MLCommon::Selection::brute_force_knn(ptrs, sizes, d, X_query, x_q_n,
-                                       knn_indices, knn_dists, n_neighbors,
-                                       d_alloc, stream);
+    MLCommon::Selection::brute_force_knn(ptrs, sizes, d, X_query, x_q_n,
+                                         knn_indices, knn_dists, n_neighbors,
+                                         d_alloc, stream);
+  }
 
   MLCommon::LinAlg::unaryOp<T>(
     knn_dists, knn_dists, x_n * n_neighbors,
     [] __device__(T input) { return sqrt(input); }, stream);
 }
+
+/**
+ * The counterpart of launcher for CSR X and X_query, searched without
+ * densifying them.
+ */
+template <typename T>
+void launcher_sparse(const float *vals, const int *row_ind,
+                     const int *row_ind_ptr, int nnz, int x_n,
+                     const float *q_vals, const int *q_row_ind,
+                     const int *q_row_ind_ptr, int x_q_n, int d,
+                     long *knn_indices, T *knn_dists, int n_neighbors,
+                     UMAPParams *params,
+                     std::shared_ptr<deviceAllocator> d_alloc,
+                     cudaStream_t stream) {
+  ASSERT(params->knn_index == nullptr,
+         "knn_index cannot search sparse inputs");
+  MLCommon::Selection::sparse_brute_force_knn(
+    vals, row_ind, row_ind_ptr, nnz, x_n, q_vals, q_row_ind, q_row_ind_ptr,
+    x_q_n, d, n_neighbors, knn_indices, knn_dists, d_alloc, stream);
+
+  MLCommon::LinAlg::unaryOp<T>(
+    knn_dists, knn_dists, x_q_n * n_neighbors,
+    [] __device__(T input) { return sqrt(input); }, stream);
+}
 }  // namespace Algo
 }  // namespace kNNGraph
 };  // namespace UMAPAlgo
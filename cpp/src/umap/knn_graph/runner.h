@@ -57,5 +57,22 @@ void run(T *X, int n, T *query, int q_n, int d, long *knn_indices, T *knn_dists,
       break;
   }
 }
+
+/**
+  * @brief The counterpart of run for CSR X and query matrices
+  * (nonzero values, row offsets and col of each nonzero), which are
+  * searched without densifying them.
+ */
+template <typename T = float>
+void run_sparse(const T *vals, const int *row_ind, const int *row_ind_ptr,
+                int nnz, int n, const T *q_vals, const int *q_row_ind,
+                const int *q_row_ind_ptr, int q_n, int d, long *knn_indices,
+                T *knn_dists, int n_neighbors, UMAPParams *params,
+                std::shared_ptr<deviceAllocator> d_alloc,
+                cudaStream_t stream) {
+  Algo::launcher_sparse(vals, row_ind, row_ind_ptr, nnz, n, q_vals, q_row_ind,
+                        q_row_ind_ptr, q_n, d, knn_indices, knn_dists,
+                        n_neighbors, params, d_alloc, stream);
+}
 }  // namespace kNNGraph
 };  // namespace UMAPAlgo
@@ -37,7 +37,10 @@
 
 #include "cuda_utils.h"
 
+#include <common/cumlHandle.hpp>
+
 #include <cuda_runtime.h>
+#include <algorithm>
 #include <iostream>
 
 namespace UMAPAlgo {
@@ -79,108 +82,109 @@ void find_ab(UMAPParams *params, std::shared_ptr<deviceAllocator> d_alloc,
   Optimize::find_params_ab(params, d_alloc, stream);
 }
 
+/**
+ * Points knn_indices and knn_dists at the kNN graph of X. A graph passed in
+ * by the caller (both pointers non-null) is used as is; otherwise the graph
+ * is computed into the given workspace.
+ */
+template <typename T>
+void get_knn_graph(T *X, int n, int d, int64_t *&knn_indices, T *&knn_dists,
+                   MLCommon::device_buffer<int64_t> &knn_indices_buf,
+                   MLCommon::device_buffer<T> &knn_dists_buf,
+                   UMAPParams *params, std::shared_ptr<deviceAllocator> d_alloc,
+                   cudaStream_t stream) {
+  ASSERT((knn_indices == nullptr) == (knn_dists == nullptr),
+         "knn_indices and knn_dists must be passed together");
+  if (knn_indices != nullptr) return;
+
+  int k = params->n_neighbors;
+  ML::nvtxRange range("Trace::Umap::KnnGraph", "n=%d d=%d k=%d", n, d, k);
+  knn_indices_buf.resize(n * k, stream);
+  knn_dists_buf.resize(n * k, stream);
+  knn_indices = knn_indices_buf.data();
+  knn_dists = knn_dists_buf.data();
+
+  kNNGraph::run(X, n, X, n, d, knn_indices, knn_dists, k, params, d_alloc,
+                stream);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * Builds the fuzzy simplicial set of the n rows of X into graph, with its
+ * zeros removed. When knn_indices and knn_dists are given, they are the kNN
+ * graph of X and X is not read.
+ */
 template <typename T, int TPB_X>
-void _fit(const cumlHandle &handle,
-          T *X,   // input matrix
-          int n,  // rows
-          int d,  // cols
-          UMAPParams *params, T *embeddings) {
+void _fuzzy_graph(const cumlHandle &handle,
+                  T *X,   // input matrix
+                  int n,  // rows
+                  int d,  // cols
+                  UMAPParams *params, COO<T> *graph,
+                  int64_t *knn_indices = nullptr, T *knn_dists = nullptr) {
   cudaStream_t stream = handle.getStream();
   auto d_alloc = handle.getDeviceAllocator();
 
   int k = params->n_neighbors;
+  ML::detail::phaseScope range(handle.getImpl(), "Trace::Umap::FuzzyGraph",
+                               "n=%d d=%d k=%d", n, d, k);
 
   if (params->verbose)
     std::cout << "n_neighbors=" << params->n_neighbors << std::endl;
-  find_ab(params, d_alloc, stream);
 
   /**
-   * Allocate workspace for kNN graph
+   * Allocate workspace for kNN graph, unless one was passed in
    */
-  MLCommon::device_buffer<int64_t> knn_indices(d_alloc, stream, n * k);
-  MLCommon::device_buffer<T> knn_dists(d_alloc, stream, n * k);
-
-  kNNGraph::run(X, n, X, n, d, knn_indices.data(), knn_dists.data(), k, params, d_alloc,
-                stream);
-  CUDA_CHECK(cudaPeekAtLastError());
-
-  COO<T> rgraph_coo(d_alloc, stream);
-
-  FuzzySimplSet::run<TPB_X, T>(n, knn_indices.data(), knn_dists.data(), k,
-                               &rgraph_coo, params, d_alloc, stream);
+  MLCommon::device_buffer<int64_t> knn_indices_buf(d_alloc, stream);
+  MLCommon::device_buffer<T> knn_dists_buf(d_alloc, stream);
+  get_knn_graph(X, n, d, knn_indices, knn_dists, knn_indices_buf,
+                knn_dists_buf, params, d_alloc, stream);
 
   /**
-   * Remove zeros from simplicial set
+   * The simplicial set comes sorted and without zeros
    */
-  COO<T> cgraph_coo(d_alloc, stream);
-  MLCommon::Sparse::coo_remove_zeros<TPB_X, T>(&rgraph_coo, &cgraph_coo,
-                                               d_alloc, stream);
-
-  /**
-   * Run initialization method
-   */
-  InitEmbed::run(handle, X, n, d, knn_indices.data(), knn_dists.data(),
-                 &cgraph_coo, params, embeddings, stream, params->init);
-
-  if (params->callback) {
-    params->callback->setup<T>(n, params->n_components);
-    params->callback->on_preprocess_end(embeddings);
-  }
-
-  /**
-		 * Run simplicial set embedding to approximate low-dimensional representation
-		 */
-  SimplSetEmbed::run<TPB_X, T>(X, n, d, &cgraph_coo, params, embeddings,
+  FuzzySimplSet::run<TPB_X, T>(n, knn_indices, knn_dists, k, graph, params,
                                d_alloc, stream);
-
-  if (params->callback) params->callback->on_train_end(embeddings);
 }
 
+/**
+ * Builds the fuzzy simplicial set of the n rows of X intersected with the
+ * simplicial set of their labels y into graph, with its zeros removed.
+ */
 template <typename T, int TPB_X>
-void _fit(const cumlHandle &handle,
-          T *X,  // input matrix
-          T *y,  // labels
-          int n, int d, UMAPParams *params, T *embeddings) {
+void _fuzzy_graph(const cumlHandle &handle,
+                  T *X,  // input matrix
+                  T *y,  // labels
+                  int n, int d, UMAPParams *params, COO<T> *graph,
+                  int64_t *knn_indices = nullptr, T *knn_dists = nullptr) {
   std::shared_ptr<deviceAllocator> d_alloc = handle.getDeviceAllocator();
   cudaStream_t stream = handle.getStream();
-
-  int k = params->n_neighbors;
+  ML::detail::phaseScope range(handle.getImpl(),
+                               "Trace::Umap::SupervisedFuzzyGraph",
+                               "n=%d d=%d k=%d", n, d, params->n_neighbors);
 
   if (params->target_n_neighbors == -1)
     params->target_n_neighbors = params->n_neighbors;
 
-  find_ab(params, d_alloc, stream);
-
   /**
-   * Allocate workspace for kNN graph
+   * Allocate workspace for kNN graph, unless one was passed in
    */
-  MLCommon::device_buffer<int64_t> knn_indices(d_alloc, stream, n * k);
-  MLCommon::device_buffer<T> knn_dists(d_alloc, stream, n * k);
-
-  kNNGraph::run(X, n, X, n, d, knn_indices.data(), knn_dists.data(), k, params, d_alloc,
-                stream);
-  CUDA_CHECK(cudaPeekAtLastError());
+  MLCommon::device_buffer<int64_t> knn_indices_buf(d_alloc, stream);
+  MLCommon::device_buffer<T> knn_dists_buf(d_alloc, stream);
+  get_knn_graph(X, n, d, knn_indices, knn_dists, knn_indices_buf,
+                knn_dists_buf, params, d_alloc, stream);
 
   /**
    * Allocate workspace for fuzzy simplicial set.
    */
   COO<T> rgraph_coo(d_alloc, stream);
-  COO<T> tmp_coo(d_alloc, stream);
 
   /**
-   * Run Fuzzy simplicial set
+   * Run Fuzzy simplicial set, which comes sorted and without zeros
    */
-  //int nnz = n*k*2;
-  FuzzySimplSet::run<TPB_X, T>(n, knn_indices.data(), knn_dists.data(),
-                               params->n_neighbors, &tmp_coo, params, d_alloc,
-                               stream);
+  FuzzySimplSet::run<TPB_X, T>(n, knn_indices, knn_dists, params->n_neighbors,
+                               &rgraph_coo, params, d_alloc, stream);
   CUDA_CHECK(cudaPeekAtLastError());
 
-  MLCommon::Sparse::coo_remove_zeros<TPB_X, T>(&tmp_coo, &rgraph_coo, d_alloc,
-                                               stream);
-
-  COO<T> final_coo(d_alloc, stream);
-
   /**
    * If target metric is 'categorical', perform
    * categorical simplicial set intersection.
@@ -189,7 +193,7 @@ void _fit(const cumlHandle &handle,
     if (params->verbose)
       std::cout << "Performing categorical intersection" << std::endl;
     Supervised::perform_categorical_intersection<TPB_X, T>(
-      y, &rgraph_coo, &final_coo, params, d_alloc, stream);
+      y, &rgraph_coo, graph, params, d_alloc, stream);
 
     /**
      * Otherwise, perform general simplicial set intersection
@@ -198,31 +202,52 @@ void _fit(const cumlHandle &handle,
     if (params->verbose)
       std::cout << "Performing general intersection" << std::endl;
     Supervised::perform_general_intersection<TPB_X, T>(
-      handle, y, &rgraph_coo, &final_coo, params, stream);
+      handle, y, &rgraph_coo, graph, params, stream);
   }
 
-  /**
-   * Remove zeros
-   */
-  MLCommon::Sparse::coo_sort<T>(&final_coo, d_alloc, stream);
+  // the local connectivity reset leaves the graph sorted and without zeros
+  CUDA_CHECK(cudaPeekAtLastError());
+}
 
-  COO<T> ocoo(d_alloc, stream);
-  MLCommon::Sparse::coo_remove_zeros<TPB_X, T>(&final_coo, &ocoo, d_alloc,
-                                               stream);
+/**
+ * Initializes and optimizes the embeddings of the n vertices of graph, as
+ * set by the embedding settings of params (min_dist, spread, n_components,
+ * n_epochs, init, ...). The graph is consumed: the edges too weak to be
+ * sampled within params->n_epochs are zeroed in it.
+ */
+template <typename T, int TPB_X>
+void _embed(const cumlHandle &handle, int n, COO<T> *graph,
+            UMAPParams *params, T *embeddings) {
+  cudaStream_t stream = handle.getStream();
+  auto d_alloc = handle.getDeviceAllocator();
+
+  find_ab(params, d_alloc, stream);
 
   /**
-   * Initialize embeddings
+   * Run initialization method
    */
-  InitEmbed::run(handle, X, n, d, knn_indices.data(), knn_dists.data(), &ocoo,
-                 params, embeddings, stream, params->init);
+  {
+    ML::detail::phaseScope range(handle.getImpl(), "Trace::Umap::InitEmbed",
+                                 "n=%d nnz=%d", n, graph->nnz);
+    InitEmbed::run<T>(handle, nullptr, n, 0, nullptr, nullptr, graph, params,
+                      embeddings, stream, params->init);
+  }
 
-  if (params->callback) params->callback->on_preprocess_end(embeddings);
+  if (params->callback) {
+    params->callback->setup<T>(n, params->n_components);
+    params->callback->on_preprocess_end(embeddings);
+  }
 
   /**
    * Run simplicial set embedding to approximate low-dimensional representation
    */
-  SimplSetEmbed::run<TPB_X, T>(X, n, d, &ocoo, params, embeddings, d_alloc,
-                               stream);
+  {
+    ML::detail::phaseScope range(handle.getImpl(), "Trace::Umap::Optimize",
+                                 "n=%d nnz=%d epochs=%d", n, graph->nnz,
+                                 params->n_epochs);
+    SimplSetEmbed::run<TPB_X, T>(nullptr, n, 0, graph, params, embeddings,
+                                 d_alloc, stream);
+  }
 
   if (params->callback) params->callback->on_train_end(embeddings);
 
@@ -230,26 +255,83 @@ void _fit(const cumlHandle &handle,
 }
 
 /**
-	 *
-	 */
+ * Embeds a copy of graph, built once by _fuzzy_graph, so that graph can be
+ * embedded again with other embedding settings.
+ */
 template <typename T, int TPB_X>
-void _transform(const cumlHandle &handle, float *X, int n, int d, float *orig_X,
-                int orig_n, T *embedding, int embedding_n, UMAPParams *params,
-                T *transformed) {
-  std::shared_ptr<deviceAllocator> d_alloc = handle.getDeviceAllocator();
+void _embed_copy(const cumlHandle &handle, int n, COO<T> *graph,
+                 UMAPParams *params, T *embeddings) {
   cudaStream_t stream = handle.getStream();
+  auto d_alloc = handle.getDeviceAllocator();
+
+  COO<T> graph_copy(d_alloc, stream, graph->nnz, graph->n_rows,
+                    graph->n_cols);
+  MLCommon::copyAsync(graph_copy.rows(), graph->rows(), graph->nnz, stream);
+  MLCommon::copyAsync(graph_copy.cols(), graph->cols(), graph->nnz, stream);
+  MLCommon::copyAsync(graph_copy.vals(), graph->vals(), graph->nnz, stream);
+
+  _embed<T, TPB_X>(handle, n, &graph_copy, params, embeddings);
+}
+
+template <typename T, int TPB_X>
+void _fit(const cumlHandle &handle,
+          T *X,   // input matrix
+          int n,  // rows
+          int d,  // cols
+          UMAPParams *params, T *embeddings, int64_t *knn_indices = nullptr,
+          T *knn_dists = nullptr) {
+  ML::detail::phaseScope range(handle.getImpl(), "ML::Umap::Fit",
+                               "rows=%d cols=%d", n, d);
+  COO<T> graph(handle.getDeviceAllocator(), handle.getStream());
+  _fuzzy_graph<T, TPB_X>(handle, X, n, d, params, &graph, knn_indices,
+                         knn_dists);
+  _embed<T, TPB_X>(handle, n, &graph, params, embeddings);
+}
+
+template <typename T, int TPB_X>
+void _fit(const cumlHandle &handle,
+          T *X,  // input matrix
+          T *y,  // labels
+          int n, int d, UMAPParams *params, T *embeddings,
+          int64_t *knn_indices = nullptr, T *knn_dists = nullptr) {
+  ML::detail::phaseScope range(handle.getImpl(), "ML::Umap::SupervisedFit",
+                               "rows=%d cols=%d", n, d);
+  COO<T> graph(handle.getDeviceAllocator(), handle.getStream());
+  _fuzzy_graph<T, TPB_X>(handle, X, y, n, d, params, &graph, knn_indices,
+                         knn_dists);
+  _embed<T, TPB_X>(handle, n, &graph, params, embeddings);
+}
+
+/**
+ * Transforms the n rows of X, a batch of the total_n rows being transformed,
+ * on the given stream. The number of epochs follows from total_n, so that
+ * all the batches are optimized alike. When knn_indices_in and knn_dists_in
+ * are given, they are the neighbors of X in orig_X and X is not read.
+ */
+template <typename T, int TPB_X>
+void _transform_batch(const cumlHandle &handle, float *X, int n, int d,
+                      float *orig_X, int orig_n, T *embedding,
+                      int embedding_n, UMAPParams *params, T *transformed,
+                      int total_n, int64_t *knn_indices_in,
+                      T *knn_dists_in, cudaStream_t stream) {
+  std::shared_ptr<deviceAllocator> d_alloc = handle.getDeviceAllocator();
 
   /**
-   * Perform kNN of X
+   * Perform kNN of X, unless the neighbors of X in orig_X were passed in
    */
-  MLCommon::device_buffer<int64_t> knn_indices(d_alloc, stream,
-                                            n * params->n_neighbors);
-  MLCommon::device_buffer<T> knn_dists(d_alloc, stream,
-                                       n * params->n_neighbors);
-
-  kNNGraph::run(orig_X, orig_n, X, n, d, knn_indices.data(), knn_dists.data(),
-                params->n_neighbors, params, d_alloc, stream);
-  CUDA_CHECK(cudaPeekAtLastError());
+  MLCommon::device_buffer<int64_t> knn_indices(d_alloc, stream);
+  MLCommon::device_buffer<T> knn_dists(d_alloc, stream);
+
+  if (knn_indices_in == nullptr) {
+    knn_indices.resize(n * params->n_neighbors, stream);
+    knn_dists.resize(n * params->n_neighbors, stream);
+    kNNGraph::run(orig_X, orig_n, X, n, d, knn_indices.data(),
+                  knn_dists.data(), params->n_neighbors, params, d_alloc,
+                  stream);
+    CUDA_CHECK(cudaPeekAtLastError());
+    knn_indices_in = knn_indices.data();
+    knn_dists_in = knn_dists.data();
+  }
 
   float adjusted_local_connectivity =
     max(0.0, params->local_connectivity - 1.0);
@@ -266,7 +348,7 @@ void _transform(const cumlHandle &handle, float *X, int n, int d, float *orig_X,
   dim3 blk(TPB_X, 1, 1);
 
   FuzzySimplSetImpl::smooth_knn_dist<TPB_X, T>(
-    n, knn_indices.data(), knn_dists.data(), rhos.data(), sigmas.data(), params,
+    n, knn_indices_in, knn_dists_in, rhos.data(), sigmas.data(), params,
     params->n_neighbors, adjusted_local_connectivity, d_alloc, stream);
 
   /**
@@ -284,8 +366,8 @@ void _transform(const cumlHandle &handle, float *X, int n, int d, float *orig_X,
   COO<T> graph_coo(d_alloc, stream, nnz, n, n);
 
   FuzzySimplSetImpl::compute_membership_strength_kernel<TPB_X>
-    <<<grid_n, blk, 0, stream>>>(knn_indices.data(), knn_dists.data(),
-                                 sigmas.data(), rhos.data(), graph_coo.vals(),
+    <<<grid_n, blk, 0, stream>>>(knn_indices_in, knn_dists_in, sigmas.data(),
+                                 rhos.data(), graph_coo.vals(),
                                  graph_coo.rows(), graph_coo.cols(),
                                  graph_coo.n_rows, params->n_neighbors);
   CUDA_CHECK(cudaPeekAtLastError());
@@ -324,7 +406,7 @@ void _transform(const cumlHandle &handle, float *X, int n, int d, float *orig_X,
 
   int n_epochs = params->n_epochs;
   if (params->n_epochs <= 0) {
-    if (n <= 10000)
+    if (total_n <= 10000)
       n_epochs = 100;
     else
       n_epochs = 30;
@@ -366,4 +448,116 @@ void _transform(const cumlHandle &handle, float *X, int n, int d, float *orig_X,
     params, n_epochs, d_alloc, stream);
 }
 
+/**
+ * Calls batch(start, rows, stream) on the batches of
+ * params->transform_batch_size rows of the n rows to transform, round-robin
+ * over the internal streams of the handle so that the kNN search of a batch
+ * overlaps the optimization of the previous ones. All the rows are one
+ * batch on the user stream when transform_batch_size <= 0, and the batches
+ * stay on the user stream when params->knn_index is searched.
+ */
+template <typename Lambda>
+void transform_batches(const cumlHandle &handle, int n, UMAPParams *params,
+                       Lambda batch) {
+  const cumlHandle_impl &h = handle.getImpl();
+  int batch_size = params->transform_batch_size;
+  int n_streams = params->knn_index == nullptr ? h.getNumInternalStreams() : 0;
+  if (batch_size <= 0 || batch_size >= n) {
+    batch(0, n, h.getStream());
+    return;
+  }
+
+  ML::detail::streamSyncer _(h);
+  for (int start = 0, b = 0; start < n; start += batch_size, b++) {
+    int rows = std::min(batch_size, n - start);
+    batch(start, rows,
+          n_streams > 0 ? h.getInternalStream(b % n_streams) : h.getStream());
+  }
+}
+
+template <typename T, int TPB_X>
+void _transform(const cumlHandle &handle, float *X, int n, int d, float *orig_X,
+                int orig_n, T *embedding, int embedding_n, UMAPParams *params,
+                T *transformed) {
+  ML::detail::phaseScope range(handle.getImpl(), "ML::Umap::Transform",
+                               "rows=%d cols=%d", n, d);
+  int n_components = params->n_components;
+  transform_batches(
+    handle, n, params, [&](int start, int rows, cudaStream_t stream) {
+      _transform_batch<T, TPB_X>(
+        handle, X + (size_t)start * d, rows, d, orig_X, orig_n, embedding,
+        embedding_n, params, transformed + (size_t)start * n_components, n,
+        nullptr, nullptr, stream);
+    });
+}
+
+/**
+ * Fits UMAP on the CSR matrix X (nonzero values, row offsets and col of each
+ * nonzero), whose kNN graph is searched without densifying it; the fit past
+ * the kNN graph does not need X. y is nullptr for an unsupervised fit.
+ */
+template <typename T, int TPB_X>
+void _fit_sparse(const cumlHandle &handle, const T *vals, const int *row_ind,
+                 const int *row_ind_ptr, int nnz, T *y, int n, int d,
+                 UMAPParams *params, T *embeddings) {
+  ML::detail::phaseScope range(handle.getImpl(), "ML::Umap::FitSparse",
+                               "rows=%d cols=%d nnz=%d", n, d, nnz);
+  std::shared_ptr<deviceAllocator> d_alloc = handle.getDeviceAllocator();
+  cudaStream_t stream = handle.getStream();
+  int k = params->n_neighbors;
+
+  MLCommon::device_buffer<int64_t> knn_indices(d_alloc, stream, n * k);
+  MLCommon::device_buffer<T> knn_dists(d_alloc, stream, n * k);
+  {
+    ML::detail::phaseScope knn(handle.getImpl(), "Trace::Umap::KnnGraph",
+                               "n=%d d=%d k=%d", n, d, k);
+    kNNGraph::run_sparse(vals, row_ind, row_ind_ptr, nnz, n, vals, row_ind,
+                         row_ind_ptr, n, d, knn_indices.data(),
+                         knn_dists.data(), k, params, d_alloc, stream);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+
+  if (y == nullptr)
+    _fit<T, TPB_X>(handle, nullptr, n, d, params, embeddings,
+                   knn_indices.data(), knn_dists.data());
+  else
+    _fit<T, TPB_X>(handle, nullptr, y, n, d, params, embeddings,
+                   knn_indices.data(), knn_dists.data());
+}
+
+/**
+ * Projects the rows of the CSR matrix X into the embedding of the CSR matrix
+ * orig_X fitted with _fit_sparse.
+ */
+template <typename T, int TPB_X>
+void _transform_sparse(const cumlHandle &handle, const T *vals,
+                       const int *row_ind, const int *row_ind_ptr, int n,
+                       int d, const T *orig_vals, const int *orig_row_ind,
+                       const int *orig_row_ind_ptr, int orig_nnz, int orig_n,
+                       T *embedding, int embedding_n, UMAPParams *params,
+                       T *transformed) {
+  ML::detail::phaseScope range(handle.getImpl(), "ML::Umap::TransformSparse",
+                               "rows=%d cols=%d", n, d);
+  std::shared_ptr<deviceAllocator> d_alloc = handle.getDeviceAllocator();
+  int k = params->n_neighbors;
+  int n_components = params->n_components;
+
+  transform_batches(
+    handle, n, params, [&](int start, int rows, cudaStream_t stream) {
+      // The row offsets of the batch still index the whole of vals
+      MLCommon::device_buffer<int64_t> knn_indices(d_alloc, stream, rows * k);
+      MLCommon::device_buffer<T> knn_dists(d_alloc, stream, rows * k);
+      kNNGraph::run_sparse(orig_vals, orig_row_ind, orig_row_ind_ptr,
+                           orig_nnz, orig_n, vals, row_ind + start,
+                           row_ind_ptr, rows, d, knn_indices.data(),
+                           knn_dists.data(), k, params, d_alloc, stream);
+      CUDA_CHECK(cudaPeekAtLastError());
+
+      _transform_batch<T, TPB_X>(
+        handle, nullptr, rows, d, nullptr, orig_n, embedding, embedding_n,
+        params, transformed + (size_t)start * n_components, n,
+        knn_indices.data(), knn_dists.data(), stream);
+    });
+}
+
 }  // namespace UMAPAlgo
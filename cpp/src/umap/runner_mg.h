@@ -0,0 +1,519 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuml/manifold/umapparams.h>
+#include <common/cuml_comms_int.hpp>
+#include <common/cumlHandle.hpp>
+#include <cuml/neighbors/knn.hpp>
+#include "runner.h"
+
+#include <thrust/binary_search.h>
+#include <thrust/extrema.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/remove.h>
+#include <thrust/sort.h>
+#include <thrust/system/cuda/execution_policy.h>
+#include <thrust/transform.h>
+
+#include <sys/time.h>
+#include <algorithm>
+#include <climits>
+#include <numeric>
+#include <vector>
+
+namespace UMAPAlgo {
+
+// Distributed UMAP: every rank of the communicator of the handle holds a
+// shard of the rows of X, numbered in rank order
+namespace mg {
+
+using namespace ML;
+
+// The communicator counts the elements of a collective with an int
+static const size_t MAX_COLLECTIVE_COUNT = size_t(1) << 30;
+
+/**
+ * Index of the first row of each rank; the last entry is the total # of rows
+ */
+inline std::vector<int> rank_offsets(const cumlHandle_impl &h, int n_local,
+                                     cudaStream_t stream) {
+  const MLCommon::cumlCommunicator &comm = h.getCommunicator();
+  int rank = comm.getRank();
+  int n_ranks = comm.getSize();
+
+  MLCommon::device_buffer<int> counts(h.getDeviceAllocator(), stream,
+                                      n_ranks);
+  MLCommon::updateDevice(counts.data() + rank, &n_local, 1, stream);
+  comm.allgather(counts.data() + rank, counts.data(), 1, stream);
+
+  std::vector<int> offsets(n_ranks + 1, 0);
+  MLCommon::updateHost(offsets.data() + 1, counts.data(), n_ranks, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  std::partial_sum(offsets.begin() + 1, offsets.end(), offsets.begin() + 1);
+  return offsets;
+}
+
+/**
+ * The kNN graph of the rows of this rank among the rows of all the ranks.
+ * The shard of each rank in turn is broadcast and searched against the
+ * shards of all the ranks with brute_force_knn_mg, and that rank keeps the
+ * merged neighbors. The distances are mapped as in kNNGraph::Algo.
+ */
+template <typename T>
+void knn_graph(const cumlHandle &handle, T *X, int n_local, int d,
+               const std::vector<int> &offsets, int64_t *knn_indices,
+               T *knn_dists, UMAPParams *params, cudaStream_t stream) {
+  const cumlHandle_impl &h = handle.getImpl();
+  const MLCommon::cumlCommunicator &comm = h.getCommunicator();
+  std::shared_ptr<deviceAllocator> d_alloc = h.getDeviceAllocator();
+  int rank = comm.getRank();
+  int n_ranks = comm.getSize();
+  int k = params->n_neighbors;
+
+  int max_rows = 0;
+  for (int r = 0; r < n_ranks; r++)
+    max_rows = std::max(max_rows, offsets[r + 1] - offsets[r]);
+  MLCommon::device_buffer<T> query(d_alloc, stream, (size_t)max_rows * d);
+  MLCommon::device_buffer<int64_t> other_indices(d_alloc, stream,
+                                                 (size_t)max_rows * k);
+  MLCommon::device_buffer<T> other_dists(d_alloc, stream,
+                                         (size_t)max_rows * k);
+
+  std::vector<float *> input(1, X);
+  std::vector<int> sizes(1, n_local);
+  for (int r = 0; r < n_ranks; r++) {
+    int rows = offsets[r + 1] - offsets[r];
+    size_t len = (size_t)rows * d;
+    if (r == rank) MLCommon::copyAsync(query.data(), X, len, stream);
+    for (size_t i = 0; i < len; i += MAX_COLLECTIVE_COUNT) {
+      int count = std::min(len - i, MAX_COLLECTIVE_COUNT);
+      comm.bcast(query.data() + i, count, r, stream);
+    }
+    ML::brute_force_knn_mg(
+      const_cast<cumlHandle &>(handle), input, sizes, d, query.data(), rows,
+      r == rank ? knn_indices : other_indices.data(),
+      r == rank ? knn_dists : other_dists.data(), k, true, true);
+  }
+
+  MLCommon::LinAlg::unaryOp<T>(
+    knn_dists, knn_dists, n_local * k,
+    [] __device__(T input) { return sqrt(input); }, stream);
+}
+
+/**
+ * Sends each edge (rows, cols, vals) of this rank, whose rows and cols are
+ * global, to the rank owning its col, and receives the edges of the other
+ * ranks whose cols are rows of this rank into recv_rows, recv_cols and
+ * recv_vals. The edges of this rank are reordered by owner of their col.
+ * @return the number of edges received
+ */
+template <typename T>
+int exchange_edges(const cumlHandle_impl &h, const std::vector<int> &offsets,
+                   int *rows, int *cols, T *vals, int nnz,
+                   MLCommon::device_buffer<int> &recv_rows,
+                   MLCommon::device_buffer<int> &recv_cols,
+                   MLCommon::device_buffer<T> &recv_vals,
+                   cudaStream_t stream) {
+  const MLCommon::cumlCommunicator &comm = h.getCommunicator();
+  std::shared_ptr<deviceAllocator> d_alloc = h.getDeviceAllocator();
+  int rank = comm.getRank();
+  int n_ranks = comm.getSize();
+  auto policy = thrust::cuda::par.on(stream);
+
+  // owner is 1 + the rank owning the col of each edge
+  MLCommon::device_buffer<int> d_offsets(d_alloc, stream, n_ranks + 1);
+  MLCommon::device_buffer<int> owner(d_alloc, stream, nnz);
+  MLCommon::device_buffer<int> send_ind(d_alloc, stream, n_ranks + 1);
+  MLCommon::updateDevice(d_offsets.data(), offsets.data(), n_ranks + 1,
+                         stream);
+  thrust::upper_bound(policy, d_offsets.data(),
+                      d_offsets.data() + n_ranks + 1, cols, cols + nnz,
+                      owner.data());
+  thrust::stable_sort_by_key(
+    policy, owner.data(), owner.data() + nnz,
+    thrust::make_zip_iterator(thrust::make_tuple(rows, cols, vals)));
+  thrust::lower_bound(policy, owner.data(), owner.data() + nnz,
+                      thrust::make_counting_iterator(1),
+                      thrust::make_counting_iterator(n_ranks + 2),
+                      send_ind.data());
+
+  // The number of edges each rank sends to each rank
+  std::vector<int> h_send_ind(n_ranks + 1), send_counts(n_ranks);
+  MLCommon::updateHost(h_send_ind.data(), send_ind.data(), n_ranks + 1,
+                       stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  for (int r = 0; r < n_ranks; r++)
+    send_counts[r] = h_send_ind[r + 1] - h_send_ind[r];
+  MLCommon::device_buffer<int> all_counts(d_alloc, stream, n_ranks * n_ranks);
+  MLCommon::updateDevice(all_counts.data() + rank * n_ranks,
+                         send_counts.data(), n_ranks, stream);
+  comm.allgather(all_counts.data() + rank * n_ranks, all_counts.data(),
+                 n_ranks, stream);
+  std::vector<int> h_all_counts(n_ranks * n_ranks);
+  MLCommon::updateHost(h_all_counts.data(), all_counts.data(),
+                       n_ranks * n_ranks, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  std::vector<int> recv_ind(n_ranks + 1, 0);
+  for (int r = 0; r < n_ranks; r++)
+    recv_ind[r + 1] = recv_ind[r] + h_all_counts[r * n_ranks + rank];
+  int recv_nnz = recv_ind[n_ranks];
+  recv_rows.resize(recv_nnz, stream);
+  recv_cols.resize(recv_nnz, stream);
+  recv_vals.resize(recv_nnz, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  std::vector<MLCommon::cumlCommunicator::request_t> requests;
+  requests.reserve(6 * n_ranks);
+  auto send = [&](const void *buf, size_t bytes, int r, int tag) {
+    ASSERT(bytes <= INT_MAX, "UMAP fit_mg: %zu bytes to send to rank %d",
+           bytes, r);
+    requests.emplace_back();
+    comm.isend(buf, (int)bytes, r, tag, &requests.back());
+  };
+  auto recv = [&](void *buf, size_t bytes, int r, int tag) {
+    requests.emplace_back();
+    comm.irecv(buf, (int)bytes, r, tag, &requests.back());
+  };
+  for (int r = 0; r < n_ranks; r++) {
+    int s0 = h_send_ind[r], s_n = send_counts[r];
+    int r0 = recv_ind[r], r_n = recv_ind[r + 1] - r0;
+    if (r == rank) {
+      MLCommon::copyAsync(recv_rows.data() + r0, rows + s0, s_n, stream);
+      MLCommon::copyAsync(recv_cols.data() + r0, cols + s0, s_n, stream);
+      MLCommon::copyAsync(recv_vals.data() + r0, vals + s0, s_n, stream);
+      continue;
+    }
+    if (s_n > 0) {
+      send(rows + s0, s_n * sizeof(int), r, 0);
+      send(cols + s0, s_n * sizeof(int), r, 1);
+      send(vals + s0, s_n * sizeof(T), r, 2);
+    }
+    if (r_n > 0) {
+      recv(recv_rows.data() + r0, r_n * sizeof(int), r, 0);
+      recv(recv_cols.data() + r0, r_n * sizeof(int), r, 1);
+      recv(recv_vals.data() + r0, r_n * sizeof(T), r, 2);
+    }
+  }
+  comm.waitall(requests.size(), requests.data());
+  return recv_nnz;
+}
+
+/** Sums, products and counts of the weights of the same edge */
+template <typename T>
+struct FuzzyUnionReduce {
+  typedef thrust::tuple<T, T, int> Tuple;
+  __host__ __device__ Tuple operator()(const Tuple &a, const Tuple &b) const {
+    return thrust::make_tuple(thrust::get<0>(a) + thrust::get<0>(b),
+                              thrust::get<1>(a) * thrust::get<1>(b),
+                              thrust::get<2>(a) + thrust::get<2>(b));
+  }
+};
+
+/**
+ * The fuzzy simplicial set of the rows of this rank: the membership
+ * strengths of their kNN edges, combined by the fuzzy union of
+ * FuzzySimplSet::Naive with the transposed edges received from the ranks
+ * owning the neighbors. out holds the edges sorted by row, with rows local
+ * to this rank and global cols.
+ */
+template <int TPB_X, typename T>
+void fuzzy_simpl_set(const cumlHandle_impl &h, int n_local,
+                     const std::vector<int> &offsets,
+                     const int64_t *knn_indices, const T *knn_dists,
+                     MLCommon::Sparse::COO<T> *out, UMAPParams *params,
+                     cudaStream_t stream) {
+  std::shared_ptr<deviceAllocator> d_alloc = h.getDeviceAllocator();
+  int rank = h.getCommunicator().getRank();
+  int n = offsets.back();
+  int offset = offsets[rank];
+  int k = params->n_neighbors;
+  auto policy = thrust::cuda::par.on(stream);
+
+  MLCommon::device_buffer<T> sigmas(d_alloc, stream, n_local);
+  MLCommon::device_buffer<T> rhos(d_alloc, stream, n_local);
+  CUDA_CHECK(cudaMemsetAsync(sigmas.data(), 0, n_local * sizeof(T), stream));
+  CUDA_CHECK(cudaMemsetAsync(rhos.data(), 0, n_local * sizeof(T), stream));
+  FuzzySimplSetImpl::smooth_knn_dist<TPB_X, T>(
+    n_local, knn_indices, knn_dists, rhos.data(), sigmas.data(), params, k,
+    params->local_connectivity, d_alloc, stream);
+
+  COO<T> in(d_alloc, stream, n_local * k, n_local, n);
+  dim3 grid(MLCommon::ceildiv(n_local, TPB_X), 1, 1);
+  dim3 blk(TPB_X, 1, 1);
+  FuzzySimplSetImpl::compute_membership_strength_kernel<TPB_X>
+    <<<grid, blk, 0, stream>>>(knn_indices, knn_dists, sigmas.data(),
+                               rhos.data(), in.vals(), in.rows(), in.cols(),
+                               in.n_rows, k);
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  // The kernel recognizes the self edges from local rows, so they are
+  // zeroed here; the rows of the remaining edges then become global
+  const int *in_rows = in.rows(), *in_cols = in.cols();
+  T *in_vals = in.vals();
+  thrust::for_each(policy, thrust::make_counting_iterator(0),
+                   thrust::make_counting_iterator(in.nnz),
+                   [=] __device__(int e) {
+                     if (in_cols[e] == in_rows[e] + offset) in_vals[e] = 0;
+                   });
+  COO<T> nz(d_alloc, stream);
+  MLCommon::Sparse::coo_remove_zeros<TPB_X, T>(&in, &nz, d_alloc, stream);
+  thrust::transform(policy, nz.rows(), nz.rows() + nz.nnz, nz.rows(),
+                    [=] __device__(int row) { return row + offset; });
+
+  MLCommon::device_buffer<int> recv_rows(d_alloc, stream);
+  MLCommon::device_buffer<int> recv_cols(d_alloc, stream);
+  MLCommon::device_buffer<T> recv_vals(d_alloc, stream);
+  int recv_nnz = exchange_edges(h, offsets, nz.rows(), nz.cols(), nz.vals(),
+                                nz.nnz, recv_rows, recv_cols, recv_vals,
+                                stream);
+
+  // The edges of this rank and the transposed received edges, keyed by
+  // (local row, col), with the (sum, product, count) of their weights
+  int nnz = nz.nnz + recv_nnz;
+  MLCommon::device_buffer<int64_t> keys(d_alloc, stream, nnz);
+  MLCommon::device_buffer<T> sums(d_alloc, stream, nnz);
+  MLCommon::device_buffer<T> prods(d_alloc, stream, nnz);
+  MLCommon::device_buffer<int> counts(d_alloc, stream, nnz);
+  int64_t *d_keys = keys.data();
+  T *d_sums = sums.data();
+  const int *nz_rows = nz.rows(), *nz_cols = nz.cols();
+  const T *nz_vals = nz.vals();
+  const int *r_rows = recv_rows.data(), *r_cols = recv_cols.data();
+  const T *r_vals = recv_vals.data();
+  int own_nnz = nz.nnz;
+  thrust::for_each(policy, thrust::make_counting_iterator(0),
+                   thrust::make_counting_iterator(nnz),
+                   [=] __device__(int e) {
+                     if (e < own_nnz) {
+                       d_keys[e] = int64_t(nz_rows[e] - offset) * n +
+                                   nz_cols[e];
+                       d_sums[e] = nz_vals[e];
+                     } else {
+                       int f = e - own_nnz;
+                       d_keys[e] = int64_t(r_cols[f] - offset) * n +
+                                   r_rows[f];
+                       d_sums[e] = r_vals[f];
+                     }
+                   });
+  MLCommon::copyAsync(prods.data(), sums.data(), nnz, stream);
+  thrust::fill(policy, counts.data(), counts.data() + nnz, 1);
+  auto weights = thrust::make_zip_iterator(
+    thrust::make_tuple(sums.data(), prods.data(), counts.data()));
+  thrust::sort_by_key(policy, keys.data(), keys.data() + nnz, weights);
+
+  MLCommon::device_buffer<int64_t> out_keys(d_alloc, stream, nnz);
+  MLCommon::device_buffer<T> out_sums(d_alloc, stream, nnz);
+  MLCommon::device_buffer<T> out_prods(d_alloc, stream, nnz);
+  MLCommon::device_buffer<int> out_counts(d_alloc, stream, nnz);
+  auto out_weights = thrust::make_zip_iterator(thrust::make_tuple(
+    out_sums.data(), out_prods.data(), out_counts.data()));
+  auto ends = thrust::reduce_by_key(
+    policy, keys.data(), keys.data() + nnz, weights, out_keys.data(),
+    out_weights, thrust::equal_to<int64_t>(), FuzzyUnionReduce<T>());
+  int out_nnz = ends.first - out_keys.data();
+
+  out->allocate(out_nnz, n_local, n, false, stream);
+  int *o_rows = out->rows(), *o_cols = out->cols();
+  T *o_vals = out->vals();
+  const int64_t *o_keys = out_keys.data();
+  const T *o_sums = out_sums.data(), *o_prods = out_prods.data();
+  const int *o_counts = out_counts.data();
+  float set_op_mix_ratio = params->set_op_mix_ratio;
+  thrust::for_each(policy, thrust::make_counting_iterator(0),
+                   thrust::make_counting_iterator(out_nnz),
+                   [=] __device__(int e) {
+                     // A weight without its transpose is against a 0
+                     T prod_matrix = o_counts[e] == 2 ? o_prods[e] : T(0);
+                     o_rows[e] = o_keys[e] / n;
+                     o_cols[e] = o_keys[e] % n;
+                     o_vals[e] =
+                       set_op_mix_ratio * (o_sums[e] - prod_matrix) +
+                       (1.0 - set_op_mix_ratio) * prod_matrix;
+                   });
+}
+
+/**
+ * Fits UMAP over the ranks of the communicator of the handle, each rank
+ * holding n_local > 0 rows of X and getting their embeddings. The kNN graph
+ * and the fuzzy simplicial set are built by rank, each rank keeping the
+ * edges of its own rows. The epochs run the deterministic scheme of
+ * SimplSetEmbed::Algo on the edges of each rank, which update only the
+ * embeddings of its rows; the embeddings of all the rows, which the
+ * negative samples need, are gathered after each epoch. As each edge moves
+ * only its head, its attraction is doubled to keep the balance of the
+ * epochs of a single GPU, where both ends move. The embedding is always
+ * initialized at random.
+ */
+template <typename T, int TPB_X>
+void _fit(const cumlHandle &handle, T *X, int n_local, int d,
+          UMAPParams *params, T *embeddings) {
+  const cumlHandle_impl &h = handle.getImpl();
+  ASSERT(h.commsInitialized(),
+         "UMAP fit_mg requires a handle with a communicator");
+  const MLCommon::cumlCommunicator &comm = h.getCommunicator();
+  std::shared_ptr<deviceAllocator> d_alloc = h.getDeviceAllocator();
+  cudaStream_t stream = h.getStream();
+  int rank = comm.getRank();
+  int n_ranks = comm.getSize();
+  int k = params->n_neighbors;
+  int n_components = params->n_components;
+  auto policy = thrust::cuda::par.on(stream);
+
+  ASSERT(n_local > 0, "UMAP fit_mg: every rank needs rows");
+  ASSERT(params->knn_index == nullptr,
+         "UMAP fit_mg: knn_index is not supported");
+  std::vector<int> offsets = rank_offsets(h, n_local, stream);
+  int n = offsets[n_ranks];
+  int offset = offsets[rank];
+  find_ab(params, d_alloc, stream);
+
+  MLCommon::device_buffer<int64_t> knn_indices(d_alloc, stream, n_local * k);
+  MLCommon::device_buffer<T> knn_dists(d_alloc, stream, n_local * k);
+  knn_graph(handle, X, n_local, d, offsets, knn_indices.data(),
+            knn_dists.data(), params, stream);
+
+  COO<T> graph(d_alloc, stream);
+  fuzzy_simpl_set<TPB_X, T>(h, n_local, offsets, knn_indices.data(),
+                            knn_dists.data(), &graph, params, stream);
+  knn_indices.release(stream);
+  knn_dists.release(stream);
+
+  int n_epochs = params->n_epochs;
+  if (n_epochs <= 0) n_epochs = n <= 10000 ? 500 : 200;
+
+  /**
+   * Drop the edges weaker than vals.max() / n_epochs, the max being over
+   * all the ranks, and sample the others in proportion to their weights
+   */
+  MLCommon::device_buffer<T> weights_max(d_alloc, stream, 1);
+  T local_max = 0;
+  if (graph.nnz > 0)
+    local_max = *thrust::max_element(policy, graph.vals(),
+                                     graph.vals() + graph.nnz);
+  MLCommon::updateDevice(weights_max.data(), &local_max, 1, stream);
+  comm.allreduce(weights_max.data(), weights_max.data(), 1,
+                 MLCommon::cumlCommunicator::MAX, stream);
+  T max;
+  MLCommon::updateHost(&max, weights_max.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  T threshold = max / T(n_epochs);
+  auto edges = thrust::make_zip_iterator(
+    thrust::make_tuple(graph.rows(), graph.cols(), graph.vals()));
+  int nnz = thrust::remove_if(policy, edges, edges + graph.nnz,
+                              [=] __device__(thrust::tuple<int, int, T> e) {
+                                return thrust::get<2>(e) < threshold;
+                              }) -
+            edges;
+
+  MLCommon::device_buffer<T> epochs_per_sample(d_alloc, stream, nnz);
+  MLCommon::LinAlg::unaryOp<T>(
+    epochs_per_sample.data(), graph.vals(), nnz,
+    [=] __device__(T input) {
+      T v = n_epochs * (input / max);
+      return v > 0 ? T(n_epochs) / v : T(-1.0);
+    },
+    stream);
+  int nsr = params->negative_sample_rate;
+  MLCommon::device_buffer<T> epochs_per_negative_sample(d_alloc, stream, nnz);
+  MLCommon::LinAlg::unaryOp<T>(
+    epochs_per_negative_sample.data(), epochs_per_sample.data(), nnz,
+    [=] __device__(T input) { return input / T(nsr); }, stream);
+  MLCommon::device_buffer<T> epoch_of_next_negative_sample(d_alloc, stream,
+                                                           nnz);
+  MLCommon::copy(epoch_of_next_negative_sample.data(),
+                 epochs_per_negative_sample.data(), nnz, stream);
+  MLCommon::device_buffer<T> epoch_of_next_sample(d_alloc, stream, nnz);
+  MLCommon::copy(epoch_of_next_sample.data(), epochs_per_sample.data(), nnz,
+                 stream);
+
+  // The edges of each local row
+  MLCommon::device_buffer<int> head_ind(d_alloc, stream, n_local + 1);
+  thrust::lower_bound(policy, graph.rows(), graph.rows() + nnz,
+                      thrust::make_counting_iterator(0),
+                      thrust::make_counting_iterator(n_local + 1),
+                      head_ind.data());
+
+  /**
+   * Random initialization of the rows of each rank, gathered on all the
+   * ranks
+   */
+  long long seed = params->random_state;
+  if (seed < 0) {
+    struct timeval tp;
+    gettimeofday(&tp, NULL);
+    seed = tp.tv_sec * 1000 + tp.tv_usec;
+  }
+  MLCommon::device_buffer<T> embedding(d_alloc, stream, n * n_components);
+  T *local_embedding = embedding.data() + offset * n_components;
+  MLCommon::Random::Rng r(seed + rank);
+  r.uniform<T>(local_embedding, n_local * n_components, -10, 10, stream);
+
+  std::vector<int> counts(n_ranks), displs(n_ranks);
+  for (int i = 0; i < n_ranks; i++) {
+    counts[i] = (offsets[i + 1] - offsets[i]) * n_components;
+    displs[i] = offsets[i] * n_components;
+  }
+  MLCommon::device_buffer<T> send(d_alloc, stream, n_local * n_components);
+  auto gather = [&]() {
+    MLCommon::copyAsync(send.data(), local_embedding, n_local * n_components,
+                        stream);
+    comm.allgatherv<T>(send.data(), embedding.data(), counts.data(),
+                       displs.data(), stream);
+  };
+  gather();
+
+  MLCommon::device_buffer<T> head_grads(d_alloc, stream,
+                                        n_local * n_components);
+  dim3 grid_n(MLCommon::ceildiv(n_local, TPB_X), 1, 1);
+  dim3 blk(TPB_X, 1, 1);
+  T alpha = params->initial_alpha;
+  for (int epoch = 0; epoch < n_epochs; epoch++) {
+    // The negative samples of the ranks are drawn apart
+    long long epoch_seed = seed + epoch + (long long)rank * n_epochs;
+    SimplSetEmbedImpl::optimize_vertex_kernel<T, TPB_X>
+      <<<grid_n, blk, 0, stream>>>(
+        local_embedding, n_local, embedding.data(), n, head_ind.data(),
+        graph.cols(), epochs_per_sample.data(), false,
+        epochs_per_negative_sample.data(),
+        epoch_of_next_negative_sample.data(), epoch_of_next_sample.data(),
+        alpha, epoch, params->repulsion_strength, epoch_seed, *params,
+        offset, 2.0, head_grads.data(), nullptr);
+    CUDA_CHECK(cudaGetLastError());
+    SimplSetEmbedImpl::apply_grads_kernel<T, TPB_X>
+      <<<grid_n, blk, 0, stream>>>(local_embedding, n_local,
+                                   head_grads.data(), nullptr, nullptr,
+                                   nullptr, n_components);
+    CUDA_CHECK(cudaGetLastError());
+    gather();
+
+    alpha = params->initial_alpha * (1.0 - (T(epoch) / T(n_epochs)));
+  }
+
+  MLCommon::copyAsync(embeddings, local_embedding, n_local * n_components,
+                      stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+}
+
+}  // namespace mg
+}  // namespace UMAPAlgo
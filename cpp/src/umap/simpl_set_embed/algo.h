@@ -16,16 +16,23 @@
 
 #include <cuml/manifold/umapparams.h>
 
+#include "common/nvtx.hpp"
 #include "random/rng_impl.h"
 
 #include <cstdlib>
 
 #include "sparse/coo.h"
+#include "vectorized.h"
 
 #include <curand.h>
 
+#include <thrust/binary_search.h>
 #include <thrust/device_ptr.h>
 #include <thrust/extrema.h>
+#include <thrust/gather.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
 #include <thrust/system/cuda/execution_policy.h>
 
 #include <math.h>
@@ -225,6 +232,302 @@ __global__ void optimize_batch_kernel(
   }
 }
 
+/**
+ * Loads the N_COMPONENTS coordinates of an embedding row into registers,
+ * VEC_LEN at a time. The plain (not read-only cache) loads see the updates
+ * made to the embedding earlier in the epoch.
+ */
+template <typename T, int N_COMPONENTS, int VEC_LEN>
+DI void load_embedding_row(T *row, T *out) {
+#pragma unroll
+  for (int d = 0; d < N_COMPONENTS; d += VEC_LEN) {
+    MLCommon::TxN_t<T, VEC_LEN> v;
+    v.load(row, d);
+#pragma unroll
+    for (int l = 0; l < VEC_LEN; l++) out[d + l] = v.val.data[l];
+  }
+}
+
+/**
+ * optimize_batch_kernel specialized on n_components: the coordinates of
+ * the head of each edge are loaded once, with vectorized loads, and kept in
+ * registers with the updates of the thread applied, and those of the tail
+ * and of the negative samples are loaded once each. Only the updates go to
+ * the embeddings, with one atomicAdd per coordinate as before.
+ */
+template <typename T, int TPB_X, int N_COMPONENTS, int VEC_LEN>
+__global__ void optimize_batch_kernel_vec(
+  T *head_embedding, int head_n, T *tail_embedding, int tail_n, const int *head,
+  const int *tail, int nnz, T *epochs_per_sample, int n_vertices,
+  bool move_other, T *epochs_per_negative_sample,
+  T *epoch_of_next_negative_sample, T *epoch_of_next_sample, double alpha,
+  int epoch, double gamma, uint64_t seed, UMAPParams params) {
+  int row = (blockIdx.x * TPB_X) + threadIdx.x;
+  if (row >= nnz || epoch_of_next_sample[row] > epoch) return;
+
+  /**
+   * Positive sample stage (attractive forces)
+   */
+  int j = head[row];
+  int k = tail[row];
+
+  T *current = head_embedding + (j * N_COMPONENTS);
+  T *other = tail_embedding + (k * N_COMPONENTS);
+
+  T cur[N_COMPONENTS], oth[N_COMPONENTS];
+  load_embedding_row<T, N_COMPONENTS, VEC_LEN>(current, cur);
+  load_embedding_row<T, N_COMPONENTS, VEC_LEN>(other, oth);
+
+  double dist_squared = rdist(cur, oth, N_COMPONENTS);
+  double attractive_grad_coeff = 0.0;
+  if (dist_squared > 0.0) {
+    attractive_grad_coeff = attractive_grad(dist_squared, params);
+  }
+
+#pragma unroll
+  for (int d = 0; d < N_COMPONENTS; d++) {
+    double grad_d =
+      clip(attractive_grad_coeff * (cur[d] - oth[d]), -4.0f, 4.0f);
+    atomicAdd(current + d, grad_d * alpha);
+    cur[d] += grad_d * alpha;
+    if (move_other) atomicAdd(other + d, -grad_d * alpha);
+  }
+
+  epoch_of_next_sample[row] += epochs_per_sample[row];
+
+  int n_neg_samples = int(T(epoch - epoch_of_next_negative_sample[row]) /
+                          epochs_per_negative_sample[row]);
+
+  /**
+   * Negative sampling stage
+   */
+  MLCommon::Random::detail::PhiloxGenerator gen((uint64_t)seed, (uint64_t)row,
+                                                0);
+  for (int p = 0; p < n_neg_samples; p++) {
+    int r;
+    gen.next(r);
+    int t = r % tail_n;
+    T neg[N_COMPONENTS];
+    load_embedding_row<T, N_COMPONENTS, VEC_LEN>(
+      tail_embedding + (t * N_COMPONENTS), neg);
+    dist_squared = rdist(cur, neg, N_COMPONENTS);
+
+    double repulsive_grad_coeff = 0.0;
+    if (dist_squared > 0.0) {
+      repulsive_grad_coeff = repulsive_grad(dist_squared, gamma, params);
+    } else if (j == t)
+      continue;
+
+#pragma unroll
+    for (int d = 0; d < N_COMPONENTS; d++) {
+      double grad_d = 0.0;
+      if (repulsive_grad_coeff > 0.0)
+        grad_d = clip(repulsive_grad_coeff * (cur[d] - neg[d]), -4.0f, 4.0f);
+      else
+        grad_d = 4.0;
+      atomicAdd(current + d, grad_d * alpha);
+      cur[d] += grad_d * alpha;
+    }
+
+    epoch_of_next_negative_sample[row] +=
+      n_neg_samples * epochs_per_negative_sample[row];
+  }
+}
+
+/**
+ * Launches optimize_batch_kernel_vec, with the widest vectorized loads the
+ * alignment of the embeddings allows
+ */
+template <typename T, int TPB_X, int N_COMPONENTS>
+void optimize_batch_vec(dim3 grid, dim3 blk, cudaStream_t stream,
+                        T *head_embedding, int head_n, T *tail_embedding,
+                        int tail_n, const int *head, const int *tail, int nnz,
+                        T *epochs_per_sample, int n_vertices, bool move_other,
+                        T *epochs_per_negative_sample,
+                        T *epoch_of_next_negative_sample,
+                        T *epoch_of_next_sample, double alpha, int epoch,
+                        double gamma, uint64_t seed, UMAPParams params) {
+  constexpr int VEC_LEN = sizeof(T) == 4 && N_COMPONENTS % 4 == 0
+                            ? 4
+                            : N_COMPONENTS % 2 == 0 ? 2 : 1;
+  constexpr size_t VEC_BYTES = VEC_LEN * sizeof(T);
+  bool aligned = size_t(head_embedding) % VEC_BYTES == 0 &&
+                 size_t(tail_embedding) % VEC_BYTES == 0;
+  if (aligned) {
+    optimize_batch_kernel_vec<T, TPB_X, N_COMPONENTS, VEC_LEN>
+      <<<grid, blk, 0, stream>>>(
+        head_embedding, head_n, tail_embedding, tail_n, head, tail, nnz,
+        epochs_per_sample, n_vertices, move_other, epochs_per_negative_sample,
+        epoch_of_next_negative_sample, epoch_of_next_sample, alpha, epoch,
+        gamma, seed, params);
+  } else {
+    optimize_batch_kernel_vec<T, TPB_X, N_COMPONENTS, 1>
+      <<<grid, blk, 0, stream>>>(
+        head_embedding, head_n, tail_embedding, tail_n, head, tail, nnz,
+        epochs_per_sample, n_vertices, move_other, epochs_per_negative_sample,
+        epoch_of_next_negative_sample, epoch_of_next_sample, alpha, epoch,
+        gamma, seed, params);
+  }
+}
+
+/**
+ * Runs an epoch of optimize_batch_kernel, specialized on n_components
+ * from 2 to 16
+ */
+template <typename T, int TPB_X>
+void optimize_batch(dim3 grid, dim3 blk, cudaStream_t stream,
+                    T *head_embedding, int head_n, T *tail_embedding,
+                    int tail_n, const int *head, const int *tail, int nnz,
+                    T *epochs_per_sample, int n_vertices, bool move_other,
+                    T *epochs_per_negative_sample,
+                    T *epoch_of_next_negative_sample, T *epoch_of_next_sample,
+                    double alpha, int epoch, double gamma, uint64_t seed,
+                    UMAPParams params) {
+#define UMAP_OPTIMIZE_BATCH_VEC(N)                                           \
+  case N:                                                                    \
+    optimize_batch_vec<T, TPB_X, N>(                                         \
+      grid, blk, stream, head_embedding, head_n, tail_embedding, tail_n,     \
+      head, tail, nnz, epochs_per_sample, n_vertices, move_other,            \
+      epochs_per_negative_sample, epoch_of_next_negative_sample,             \
+      epoch_of_next_sample, alpha, epoch, gamma, seed, params);              \
+    break;
+
+  switch (params.n_components) {
+    UMAP_OPTIMIZE_BATCH_VEC(2)
+    UMAP_OPTIMIZE_BATCH_VEC(3)
+    UMAP_OPTIMIZE_BATCH_VEC(4)
+    UMAP_OPTIMIZE_BATCH_VEC(5)
+    UMAP_OPTIMIZE_BATCH_VEC(6)
+    UMAP_OPTIMIZE_BATCH_VEC(7)
+    UMAP_OPTIMIZE_BATCH_VEC(8)
+    UMAP_OPTIMIZE_BATCH_VEC(9)
+    UMAP_OPTIMIZE_BATCH_VEC(10)
+    UMAP_OPTIMIZE_BATCH_VEC(11)
+    UMAP_OPTIMIZE_BATCH_VEC(12)
+    UMAP_OPTIMIZE_BATCH_VEC(13)
+    UMAP_OPTIMIZE_BATCH_VEC(14)
+    UMAP_OPTIMIZE_BATCH_VEC(15)
+    UMAP_OPTIMIZE_BATCH_VEC(16)
+    default:
+      optimize_batch_kernel<T, TPB_X><<<grid, blk, 0, stream>>>(
+        head_embedding, head_n, tail_embedding, tail_n, head, tail, nnz,
+        epochs_per_sample, n_vertices, move_other, epochs_per_negative_sample,
+        epoch_of_next_negative_sample, epoch_of_next_sample, alpha, epoch,
+        gamma, seed, params);
+  }
+#undef UMAP_OPTIMIZE_BATCH_VEC
+}
+
+/**
+ * The deterministic counterpart of optimize_batch_kernel, a thread per head
+ * vertex j, whose edges are head_ind[j] to head_ind[j + 1]. The embeddings
+ * are read only: the gradient of j is gathered in head_grads and, when
+ * move_other, the gradient of the tail of each edge is stored in
+ * edge_grads, so that apply_grads_kernel applies them all without atomics
+ * and in a fixed order. The edges are sampled as in optimize_batch_kernel.
+ * The head vertices are the tail vertices head_offset to
+ * head_offset + head_n, and attraction scales their attractive gradients.
+ */
+template <typename T, int TPB_X>
+__global__ void optimize_vertex_kernel(
+  const T *head_embedding, int head_n, const T *tail_embedding, int tail_n,
+  const int *head_ind, const int *tail, T *epochs_per_sample, bool move_other,
+  T *epochs_per_negative_sample, T *epoch_of_next_negative_sample,
+  T *epoch_of_next_sample, double alpha, int epoch, double gamma,
+  uint64_t seed, UMAPParams params, int head_offset, double attraction,
+  T *head_grads, T *edge_grads) {
+  int j = (blockIdx.x * TPB_X) + threadIdx.x;
+  if (j >= head_n) return;
+
+  const T *current = head_embedding + (j * params.n_components);
+  T *grad = head_grads + (j * params.n_components);
+  for (int d = 0; d < params.n_components; d++) grad[d] = 0;
+
+  for (int row = head_ind[j]; row < head_ind[j + 1]; row++) {
+    T *other_grad =
+      move_other ? edge_grads + (row * params.n_components) : nullptr;
+    if (move_other)
+      for (int d = 0; d < params.n_components; d++) other_grad[d] = 0;
+    if (epoch_of_next_sample[row] > epoch) continue;
+
+    /**
+     * Positive sample stage (attractive forces)
+     */
+    int k = tail[row];
+    const T *other = tail_embedding + (k * params.n_components);
+    double dist_squared = rdist(current, other, params.n_components);
+    double attractive_grad_coeff = 0.0;
+    if (dist_squared > 0.0) {
+      attractive_grad_coeff = attractive_grad(dist_squared, params);
+    }
+    for (int d = 0; d < params.n_components; d++) {
+      double grad_d =
+        clip(attractive_grad_coeff * (current[d] - other[d]), -4.0f, 4.0f);
+      grad[d] += attraction * grad_d * alpha;
+      if (move_other) other_grad[d] = -grad_d * alpha;
+    }
+
+    epoch_of_next_sample[row] += epochs_per_sample[row];
+    int n_neg_samples = int(T(epoch - epoch_of_next_negative_sample[row]) /
+                            epochs_per_negative_sample[row]);
+
+    /**
+     * Negative sampling stage
+     */
+    MLCommon::Random::detail::PhiloxGenerator gen((uint64_t)seed,
+                                                  (uint64_t)row, 0);
+    for (int p = 0; p < n_neg_samples; p++) {
+      int r;
+      gen.next(r);
+      int t = r % tail_n;
+      const T *negative_sample = tail_embedding + (t * params.n_components);
+      dist_squared = rdist(current, negative_sample, params.n_components);
+
+      double repulsive_grad_coeff = 0.0;
+      if (dist_squared > 0.0) {
+        repulsive_grad_coeff = repulsive_grad(dist_squared, gamma, params);
+      } else if (j + head_offset == t)
+        continue;
+
+      for (int d = 0; d < params.n_components; d++) {
+        double grad_d = 0.0;
+        if (repulsive_grad_coeff > 0.0)
+          grad_d =
+            clip(repulsive_grad_coeff * (current[d] - negative_sample[d]),
+                 -4.0f, 4.0f);
+        else
+          grad_d = 4.0;
+        grad[d] += grad_d * alpha;
+      }
+
+      epoch_of_next_negative_sample[row] +=
+        n_neg_samples * epochs_per_negative_sample[row];
+    }
+  }
+}
+
+/**
+ * Applies the gradients of an epoch of optimize_vertex_kernel, a thread per
+ * head vertex j: its own gradient and, when edge_grads is not nullptr, the
+ * gradients of the edges whose tail is j, which are
+ * tail_perm[tail_ind[j]] to tail_perm[tail_ind[j + 1] - 1].
+ */
+template <typename T, int TPB_X>
+__global__ void apply_grads_kernel(T *head_embedding, int head_n,
+                                   const T *head_grads, const T *edge_grads,
+                                   const int *tail_ind, const int *tail_perm,
+                                   int n_components) {
+  int j = (blockIdx.x * TPB_X) + threadIdx.x;
+  if (j >= head_n) return;
+  for (int d = 0; d < n_components; d++) {
+    T acc = head_grads[j * n_components + d];
+    if (edge_grads != nullptr)
+      for (int e = tail_ind[j]; e < tail_ind[j + 1]; e++)
+        acc += edge_grads[tail_perm[e] * n_components + d];
+    head_embedding[j * n_components + d] += acc;
+  }
+}
+
 /**
  * Runs gradient descent using sampling weights defined on
  * both the attraction and repulsion vectors.
@@ -246,6 +549,64 @@ void optimize_layout(T *head_embedding, int head_n, T *tail_embedding,
 
   T alpha = params->initial_alpha;
 
+  /**
+   * The deterministic epochs need the edges sorted by (head, tail) and
+   * the offsets of the edges of each head; when move_other, also the edges
+   * grouped by tail.
+   */
+  MLCommon::device_buffer<int> sorted_head(d_alloc, stream);
+  MLCommon::device_buffer<int> sorted_tail(d_alloc, stream);
+  MLCommon::device_buffer<T> sorted_epochs_per_sample(d_alloc, stream);
+  MLCommon::device_buffer<int> head_ind(d_alloc, stream);
+  MLCommon::device_buffer<int> tail_ind(d_alloc, stream);
+  MLCommon::device_buffer<int> tail_perm(d_alloc, stream);
+  MLCommon::device_buffer<T> head_grads(d_alloc, stream);
+  MLCommon::device_buffer<T> edge_grads(d_alloc, stream);
+  if (params->deterministic) {
+    auto policy = thrust::cuda::par.on(stream);
+    MLCommon::device_buffer<int> perm(d_alloc, stream, nnz);
+    MLCommon::device_buffer<int> keys(d_alloc, stream, nnz);
+    sorted_head.resize(nnz, stream);
+    sorted_tail.resize(nnz, stream);
+    sorted_epochs_per_sample.resize(nnz, stream);
+    thrust::sequence(policy, perm.data(), perm.data() + nnz);
+    MLCommon::copy(keys.data(), tail, nnz, stream);
+    thrust::stable_sort_by_key(policy, keys.data(), keys.data() + nnz,
+                               perm.data());
+    thrust::gather(policy, perm.data(), perm.data() + nnz, head, keys.data());
+    thrust::stable_sort_by_key(policy, keys.data(), keys.data() + nnz,
+                               perm.data());
+    MLCommon::copy(sorted_head.data(), keys.data(), nnz, stream);
+    thrust::gather(policy, perm.data(), perm.data() + nnz, tail,
+                   sorted_tail.data());
+    thrust::gather(policy, perm.data(), perm.data() + nnz, epochs_per_sample,
+                   sorted_epochs_per_sample.data());
+    head = sorted_head.data();
+    tail = sorted_tail.data();
+    epochs_per_sample = sorted_epochs_per_sample.data();
+
+    head_ind.resize(head_n + 1, stream);
+    thrust::lower_bound(policy, head, head + nnz,
+                        thrust::make_counting_iterator(0),
+                        thrust::make_counting_iterator(head_n + 1),
+                        head_ind.data());
+    head_grads.resize(head_n * params->n_components, stream);
+
+    if (move_other) {
+      tail_ind.resize(head_n + 1, stream);
+      tail_perm.resize(nnz, stream);
+      thrust::sequence(policy, tail_perm.data(), tail_perm.data() + nnz);
+      MLCommon::copy(keys.data(), tail, nnz, stream);
+      thrust::stable_sort_by_key(policy, keys.data(), keys.data() + nnz,
+                                 tail_perm.data());
+      thrust::lower_bound(policy, keys.data(), keys.data() + nnz,
+                          thrust::make_counting_iterator(0),
+                          thrust::make_counting_iterator(head_n + 1),
+                          tail_ind.data());
+      edge_grads.resize(nnz * params->n_components, stream);
+    }
+  }
+
   MLCommon::device_buffer<T> epochs_per_negative_sample(d_alloc, stream, nnz);
 
   int nsr = params->negative_sample_rate;
@@ -264,16 +625,38 @@ void optimize_layout(T *head_embedding, int head_n, T *tail_embedding,
   dim3 grid(MLCommon::ceildiv(nnz, TPB_X), 1, 1);
   dim3 blk(TPB_X, 1, 1);
 
+  dim3 grid_n(MLCommon::ceildiv(head_n, TPB_X), 1, 1);
+
   for (int n = 0; n < n_epochs; n++) {
-    struct timeval tp;
-    gettimeofday(&tp, NULL);
-    long long seed = tp.tv_sec * 1000 + tp.tv_usec;
-
-    optimize_batch_kernel<T, TPB_X><<<grid, blk, 0, stream>>>(
-      head_embedding, head_n, tail_embedding, tail_n, head, tail, nnz,
-      epochs_per_sample, n_vertices, move_other,
-      epochs_per_negative_sample.data(), epoch_of_next_negative_sample.data(),
-      epoch_of_next_sample.data(), alpha, n, gamma, seed, *params);
+    ML::nvtxRange epoch("Trace::Umap::Epoch", n);
+    long long seed = params->random_state + n;
+    if (params->random_state < 0) {
+      struct timeval tp;
+      gettimeofday(&tp, NULL);
+      seed = tp.tv_sec * 1000 + tp.tv_usec;
+    }
+
+    if (params->deterministic) {
+      optimize_vertex_kernel<T, TPB_X><<<grid_n, blk, 0, stream>>>(
+        head_embedding, head_n, tail_embedding, tail_n, head_ind.data(), tail,
+        epochs_per_sample, move_other, epochs_per_negative_sample.data(),
+        epoch_of_next_negative_sample.data(), epoch_of_next_sample.data(),
+        alpha, n, gamma, seed, *params, 0, 1.0, head_grads.data(),
+        edge_grads.data());
+      CUDA_CHECK(cudaGetLastError());
+
+      apply_grads_kernel<T, TPB_X><<<grid_n, blk, 0, stream>>>(
+        head_embedding, head_n, head_grads.data(),
+        move_other ? edge_grads.data() : nullptr, tail_ind.data(),
+        tail_perm.data(), params->n_components);
+    } else {
+      optimize_batch<T, TPB_X>(
+        grid, blk, stream, head_embedding, head_n, tail_embedding, tail_n,
+        head, tail, nnz, epochs_per_sample, n_vertices, move_other,
+        epochs_per_negative_sample.data(),
+        epoch_of_next_negative_sample.data(), epoch_of_next_sample.data(),
+        alpha, n, gamma, seed, *params);
+    }
 
     CUDA_CHECK(cudaGetLastError());
 
@@ -78,7 +78,7 @@ void reset_local_connectivity(COO<T> *in_coo, COO<T> *out_coo,
     stream);
   CUDA_CHECK(cudaPeekAtLastError());
 
-  MLCommon::Sparse::coo_symmetrize<TPB_X, T>(
+  MLCommon::Sparse::coo_symmetrize_csr<TPB_X, T>(
     in_coo, out_coo,
     [] __device__(int row, int col, T result, T transpose) {
       T prod_matrix = result * transpose;
@@ -289,17 +289,15 @@ void perform_general_intersection(const cumlHandle &handle, T *y,
   CUDA_CHECK(cudaMemsetAsync(yrow_ind.data(), 0,
                              ygraph_coo.n_rows * sizeof(int), stream));
 
-  COO<T> cygraph_coo(d_alloc, stream);
-  coo_remove_zeros<TPB_X, T>(&ygraph_coo, &cygraph_coo, d_alloc, stream);
-
-  MLCommon::Sparse::sorted_coo_to_csr(&cygraph_coo, yrow_ind.data(), d_alloc,
+  // the fuzzy simplicial set has no zeros already
+  MLCommon::Sparse::sorted_coo_to_csr(&ygraph_coo, yrow_ind.data(), d_alloc,
                                       stream);
   MLCommon::Sparse::sorted_coo_to_csr(rgraph_coo, xrow_ind.data(), d_alloc,
                                       stream);
 
   COO<T> result_coo(d_alloc, stream);
   general_simplicial_set_intersection<T, TPB_X>(
-    xrow_ind.data(), rgraph_coo, yrow_ind.data(), &cygraph_coo, &result_coo,
+    xrow_ind.data(), rgraph_coo, yrow_ind.data(), &ygraph_coo, &result_coo,
     params->target_weights, d_alloc, stream);
 
   /**
@@ -17,6 +17,7 @@
 #include <cuml/manifold/umapparams.h>
 #include <cuml/manifold/umap.hpp>
 #include "runner.h"
+#include "runner_mg.h"
 
 #include <iostream>
 
@@ -44,6 +45,62 @@ void fit(const cumlHandle &handle,
          UMAPParams *params, float *embeddings) {
   UMAPAlgo::_fit<float, TPB_X>(handle, X, n, d, params, embeddings);
 }
+
+void fit(const cumlHandle &handle, float *X, int n, int d,
+         int64_t *knn_indices, float *knn_dists, UMAPParams *params,
+         float *embeddings) {
+  UMAPAlgo::_fit<float, TPB_X>(handle, X, n, d, params, embeddings,
+                               knn_indices, knn_dists);
+}
+
+void fit(const cumlHandle &handle, float *X, float *y, int n, int d,
+         int64_t *knn_indices, float *knn_dists, UMAPParams *params,
+         float *embeddings) {
+  UMAPAlgo::_fit<float, TPB_X>(handle, X, y, n, d, params, embeddings,
+                               knn_indices, knn_dists);
+}
+void fit_sparse(const cumlHandle &handle, const float *vals,
+                const int *row_ind, const int *row_ind_ptr, int nnz, int n,
+                int d, UMAPParams *params, float *embeddings) {
+  UMAPAlgo::_fit_sparse<float, TPB_X>(handle, vals, row_ind, row_ind_ptr, nnz,
+                                      nullptr, n, d, params, embeddings);
+}
+
+void fit_sparse(const cumlHandle &handle, const float *vals,
+                const int *row_ind, const int *row_ind_ptr, int nnz, float *y,
+                int n, int d, UMAPParams *params, float *embeddings) {
+  UMAPAlgo::_fit_sparse<float, TPB_X>(handle, vals, row_ind, row_ind_ptr, nnz,
+                                      y, n, d, params, embeddings);
+}
+
+void transform_sparse(const cumlHandle &handle, const float *vals,
+                      const int *row_ind, const int *row_ind_ptr, int n, int d,
+                      const float *orig_vals, const int *orig_row_ind,
+                      const int *orig_row_ind_ptr, int orig_nnz, int orig_n,
+                      float *embedding, int embedding_n, UMAPParams *params,
+                      float *transformed) {
+  UMAPAlgo::_transform_sparse<float, TPB_X>(
+    handle, vals, row_ind, row_ind_ptr, n, d, orig_vals, orig_row_ind,
+    orig_row_ind_ptr, orig_nnz, orig_n, embedding, embedding_n, params,
+    transformed);
+}
+
+void fit_mg(const cumlHandle &handle, float *X, int n, int d,
+            UMAPParams *params, float *embeddings) {
+  UMAPAlgo::mg::_fit<float, TPB_X>(handle, X, n, d, params, embeddings);
+}
+
+/**
+ * The fuzzy simplicial set kept between fit_graph and fit_embedding
+ */
+struct UMAP_API::FuzzyGraph {
+  MLCommon::Sparse::COO<float> coo;
+  int n;
+
+  FuzzyGraph(const cumlHandle &handle, int n)
+    : coo(handle.getDeviceAllocator(), handle.getStream()), n(n) {}
+};
+
 UMAP_API::UMAP_API(const cumlHandle &handle, UMAPParams *params)
   : params(params) {
   this->handle = const_cast<cumlHandle *>(&handle);
@@ -78,6 +135,44 @@ void UMAP_API::fit(float *X, float *y, int n, int d, float *embeddings) {
                                embeddings);
 }
 
+void UMAP_API::fit(float *X, int n, int d, int64_t *knn_indices,
+                   float *knn_dists, float *embeddings) {
+  this->orig_X = X;
+  this->orig_n = n;
+  UMAPAlgo::_fit<float, TPB_X>(*this->handle, X, n, d, get_params(),
+                               embeddings, knn_indices, knn_dists);
+}
+
+void UMAP_API::fit(float *X, float *y, int n, int d, int64_t *knn_indices,
+                   float *knn_dists, float *embeddings) {
+  this->orig_X = X;
+  this->orig_n = n;
+  UMAPAlgo::_fit<float, TPB_X>(*this->handle, X, y, n, d, get_params(),
+                               embeddings, knn_indices, knn_dists);
+}
+
+void UMAP_API::fit_graph(float *X, int n, int d) {
+  this->orig_X = X;
+  this->orig_n = n;
+  graph.reset(new FuzzyGraph(*this->handle, n));
+  UMAPAlgo::_fuzzy_graph<float, TPB_X>(*this->handle, X, n, d, get_params(),
+                                       &graph->coo);
+}
+
+void UMAP_API::fit_graph(float *X, float *y, int n, int d) {
+  this->orig_X = X;
+  this->orig_n = n;
+  graph.reset(new FuzzyGraph(*this->handle, n));
+  UMAPAlgo::_fuzzy_graph<float, TPB_X>(*this->handle, X, y, n, d,
+                                       get_params(), &graph->coo);
+}
+
+void UMAP_API::fit_embedding(UMAPParams *embed_params, float *embeddings) {
+  ASSERT(graph != nullptr, "UMAP_API::fit_embedding needs fit_graph first");
+  UMAPAlgo::_embed_copy<float, TPB_X>(*this->handle, graph->n, &graph->coo,
+                                      embed_params, embeddings);
+}
+
 /**
  * Project a set of X vectors into the embedding space.
  * @param X
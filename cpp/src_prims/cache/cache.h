@@ -17,27 +17,73 @@
 #pragma once
 
 #include <cuda_utils.h>
+#include <algorithm>
 #include <cub/cub.cuh>
+#include <mutex>
 #include "cache_util.h"
 #include "common/device_buffer.hpp"
+#include "common/host_buffer.hpp"
 #include "ml_utils.h"
 
 namespace MLCommon {
 namespace Cache {
 
+/** Replacement policy of the cache sets */
+enum CachePolicy {
+  /** replace the least recently used entries */
+  LRU,
+  /** replace the entries in clock order, giving a second chance to the ones
+   * that were accessed since the hand last passed them */
+  CLOCK
+};
+
+/** Hit statistics of a cache */
+struct CacheStats {
+  /** number of keys looked up */
+  uint64_t n_lookups;
+  /** number of keys that were found in the cache */
+  uint64_t n_hits;
+  /** number of the hits that were found in the host tier */
+  uint64_t n_host_hits;
+
+  /** fraction of the lookups that hit, 0 without lookups */
+  double HitRate() const {
+    return n_lookups > 0 ? double(n_hits) / double(n_lookups) : 0.0;
+  }
+};
+
 /**
-* @brief Associative cache with least recently used replacement policy.
+* @brief Associative cache with least recently used or clock replacement
+* policy.
 *
 * SW managed cache in device memory, for ML algos where we can trade memory
 * access for computation. The two main functions of this class are the
 * management of cache indices, and methods to retrieve/store data using the
 * cache indices.
 *
-* The index management can be considered as a hash map<int, int>, where the int
+* The index management can be considered as a hash map<key_t, int>, where the
 * keys are the original vector indices that we want to store, and the values are
 * the cache location of these vectors. The keys are hashed into a bucket
 * whose size equals the associativity. These are the cache sets. If a cache
-* set is full, then new indices are stored by replacing the oldest entries.
+* set is full, then new indices are stored by replacing the oldest entries
+* (LRU), or the entries that the hand of the set reaches first without them
+* having been accessed since its last pass (CLOCK).
+*
+* The vectors can be stored in a narrower type than the one they are computed
+* in, eg. store_t = __half for math_t = float, to cache twice as many of them.
+*
+* The entries evicted from the device can be spilled to a second tier in
+* pinned host memory, with the same number of sets, instead of being dropped:
+* the lookup of a key that is found in the host tier promotes its vector back
+* to the device, over PCIe instead of recomputing it, and Prefetch promotes
+* the entries of the keys expected in the next lookup ahead of time, eg. on a
+* side stream while the current working set is processed.
+*
+* The cache counts its lookups and hits, see GetStats. A cache can be used from
+* several host threads and streams: every call is ordered after the previous
+* one, whichever its stream, and a sequence of calls that must not interleave
+* with the calls of other threads, like the lookup, assign and store below,
+* holds the lock that Lock returns.
 *
 * Using this index mapping we implement methods to store and retrive data from
 * the cache buffer, where a unit of data that we are storing is math_t[n_vec].
@@ -101,7 +147,8 @@ namespace Cache {
 * }
 * @endcode
 */
-template <typename math_t, int associativity = 32>
+template <typename math_t, int associativity = 32, typename key_t = int,
+          typename store_t = math_t>
 class Cache {
  public:
   bool verbose;  //!< Enable verbose output
@@ -111,6 +158,8 @@ class Cache {
    *
    * @tparam math_t type of elements to be cached
    * @tparam associativity number of vectors in a cache set
+   * @tparam key_t type of the keys
+   * @tparam store_t type the elements are stored in
    *
    * @param allocator device memory allocator
    * @param stream cuda stream
@@ -118,39 +167,81 @@ class Cache {
    *   cache entry
    * @param cache_size in MiB
    * @param verbose enable verbose output
+   * @param policy replacement policy of the cache sets
+   * @param host_cache_size size of the host tier in MiB, 0 to drop the
+   *   evicted entries
+   * @param host_allocator allocator of pinned host memory for the host tier,
+   *   defaultHostAllocator if nullptr
    */
   Cache(std::shared_ptr<deviceAllocator> allocator, cudaStream_t stream,
-        int n_vec, float cache_size = 200, bool verbose = false)
+        int n_vec, float cache_size = 200, bool verbose = false,
+        CachePolicy policy = LRU, float host_cache_size = 0,
+        std::shared_ptr<hostAllocator> host_allocator = nullptr)
     : allocator(allocator),
       n_vec(n_vec),
       cache_size(cache_size),
+      policy(policy),
       cache(allocator, stream),
       cached_keys(allocator, stream),
       cache_time(allocator, stream),
+      cache_ref(allocator, stream),
+      clock_hand(allocator, stream),
+      host_cache(host_allocator != nullptr
+                   ? host_allocator
+                   : std::shared_ptr<hostAllocator>(new defaultHostAllocator()),
+                 stream),
+      host_keys(allocator, stream),
+      host_time(allocator, stream),
+      n_hits(allocator, stream, 2),
       is_cached(allocator, stream),
       ws_tmp(allocator, stream),
       idx_tmp(allocator, stream),
+      host_idx_tmp(allocator, stream),
+      promote_set(allocator, stream),
+      promote_pos(allocator, stream),
+      sorted_set(allocator, stream),
+      sorted_pos(allocator, stream),
+      sorted_keys(allocator, stream),
+      sorted_host_idx(allocator, stream),
+      sorted_cache_idx(allocator, stream),
+      evicted(allocator, stream),
+      evicted_keys(allocator, stream),
+      spill_idx(allocator, stream),
       d_num_selected_out(allocator, stream, 1),
       d_temp_storage(allocator, stream),
       verbose(verbose) {
     ASSERT(n_vec > 0, "Parameter n_vec: shall be larger than zero");
     ASSERT(associativity > 0, "Associativity shall be larger than zero");
     ASSERT(cache_size >= 0, "Cache size should not be negative");
+    ASSERT(host_cache_size >= 0, "Host cache size should not be negative");
+
+    CUDA_CHECK(cudaEventCreateWithFlags(&last_op, cudaEventDisableTiming));
+    CUDA_CHECK(cudaMemsetAsync(n_hits.data(), 0,
+                               n_hits.size() * sizeof(unsigned long long),
+                               stream));
 
     // Calculate how many vectors would fit the cache
-    int n_cache_vecs = (cache_size * 1024 * 1024) / (sizeof(math_t) * n_vec);
+    int n_cache_vecs = (cache_size * 1024 * 1024) / (sizeof(store_t) * n_vec);
 
     // The available memory shall be enough for at least one cache set
     if (n_cache_vecs >= associativity) {
       n_cache_sets = n_cache_vecs / associativity;
       n_cache_vecs = n_cache_sets * associativity;
-      cache.resize(n_cache_vecs * n_vec, stream);
+      cache.resize((size_t)n_cache_vecs * n_vec, stream);
       cached_keys.resize(n_cache_vecs, stream);
       cache_time.resize(n_cache_vecs, stream);
       CUDA_CHECK(cudaMemsetAsync(cached_keys.data(), 0,
-                                 cached_keys.size() * sizeof(int), stream));
+                                 cached_keys.size() * sizeof(key_t), stream));
       CUDA_CHECK(cudaMemsetAsync(cache_time.data(), 0,
                                  cache_time.size() * sizeof(int), stream));
+      if (policy == CLOCK) {
+        cache_ref.resize(n_cache_vecs, stream);
+        clock_hand.resize(n_cache_sets, stream);
+        CUDA_CHECK(cudaMemsetAsync(cache_ref.data(), 0,
+                                   cache_ref.size() * sizeof(int), stream));
+        CUDA_CHECK(cudaMemsetAsync(clock_hand.data(), 0,
+                                   clock_hand.size() * sizeof(int), stream));
+      }
     } else {
       if (cache_size > 0) {
         std::cout << "Warning: not enough memory to cache a single set of "
@@ -159,18 +250,62 @@ class Cache {
       n_cache_sets = 0;
       cache_size = 0;
     }
+
+    // The host tier has the sets of the device tier, with their own
+    // associativity
+    int n_host_vecs =
+      (host_cache_size * 1024 * 1024) / (sizeof(store_t) * n_vec);
+    if (n_cache_sets > 0 && n_host_vecs >= n_cache_sets) {
+      host_associativity = n_host_vecs / n_cache_sets;
+      n_host_vecs = n_cache_sets * host_associativity;
+      host_cache.resize((size_t)n_host_vecs * n_vec, stream);
+      host_keys.resize(n_host_vecs, stream);
+      host_time.resize(n_host_vecs, stream);
+      CUDA_CHECK(cudaMemsetAsync(host_time.data(), 0,
+                                 host_time.size() * sizeof(int), stream));
+    } else {
+      if (host_cache_size > 0) {
+        std::cout << "Warning: not enough host memory to spill a single "
+                     "vector per set, not using host cache\n";
+      }
+      n_host_vecs = 0;
+    }
     if (verbose) {
       std::cout << "Creating cache with size " << cache_size
                 << " MiB, to store " << n_cache_vecs << " vectors, in "
                 << n_cache_sets << " sets with associativity " << associativity
                 << "\n";
+      if (host_associativity > 0) {
+        std::cout << "Spilling to the host up to " << n_host_vecs
+                  << " vectors, with associativity " << host_associativity
+                  << "\n";
+      }
     }
+    CUDA_CHECK(cudaEventRecord(last_op, stream));
   }
 
   Cache(const Cache &other) = delete;
 
   Cache &operator=(const Cache &other) = delete;
 
+  ~Cache() {
+    // the buffers are released on the stream of the constructor
+    CUDA_CHECK_NO_THROW(cudaEventSynchronize(last_op));
+    CUDA_CHECK_NO_THROW(cudaEventDestroy(last_op));
+  }
+
+  /**
+   * @brief Lock the cache for a sequence of calls from the current thread.
+   *
+   * The calls themselves lock the cache, but a sequence that relies on the
+   * state left by its previous calls, eg. GetCacheIdxPartitioned,
+   * AssignCacheIdx, then StoreVecs, must hold the returned lock when other
+   * threads use the same cache.
+   */
+  std::unique_lock<std::recursive_mutex> Lock() {
+    return std::unique_lock<std::recursive_mutex>(mtx);
+  }
+
   /** @brief Collect cached data into contiguous memory space.
    *
    * On exit, the tile array is filled the following way:
@@ -183,6 +318,7 @@ class Cache {
    * @param [in] stream cuda stream
    */
   void GetVecs(const int *idx, int n, math_t *out, cudaStream_t stream) {
+    Op op(*this, stream);
     if (n > 0) {
       get_vecs<<<ceildiv(n * n_vec, TPB), TPB, 0, stream>>>(cache.data(), n_vec,
                                                             idx, n, out);
@@ -214,6 +350,7 @@ class Cache {
   */
   void StoreVecs(const math_t *tile, int n_tile, int n, int *cache_idx,
                  cudaStream_t stream, const int *tile_idx = nullptr) {
+    Op op(*this, stream);
     if (n > 0) {
       store_vecs<<<ceildiv(n * n_vec, TPB), TPB, 0, stream>>>(
         tile, n_tile, n_vec, tile_idx, n, cache_idx, cache.data(),
@@ -244,14 +381,51 @@ class Cache {
    *   cache, size [n]
    * @param [in] stream
    */
-  void GetCacheIdx(int *keys, int n, int *cache_idx, bool *is_cached,
+  void GetCacheIdx(key_t *keys, int n, int *cache_idx, bool *is_cached,
                    cudaStream_t stream) {
+    Op op(*this, stream);
     n_iter++;  // we increase the iteration counter, that is used to time stamp
     // accessing entries from the cache
+    if (n <= 0) return;
+    n_lookups += n;
+    get_cache_idx<<<ceildiv(n, TPB), TPB, 0, stream>>>(
+      keys, n, cached_keys.data(), n_cache_sets, associativity,
+      cache_time.data(), cache_idx, is_cached, n_iter,
+      policy == CLOCK ? cache_ref.data() : nullptr, n_hits.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+    if (host_associativity > 0) {
+      Promote(keys, n, cache_idx, is_cached, true, stream);
+    }
+  }
+
+  /**
+   * @brief Promote the host tier entries of the keys expected in the next
+   * lookup to the device tier.
+   *
+   * The work is only enqueued on the stream, so that with a side stream the
+   * transfers overlap with the work of the current working set. Without a
+   * host tier this is a no-op. The lookups of Prefetch are not counted in the
+   * stats.
+   *
+   * @Note: Prefetch starts a new time step, like GetCacheIdx: call it before
+   *   or after, but not within, a sequence of GetCacheIdxPartitioned,
+   *   AssignCacheIdx and StoreVecs.
+   *
+   * @param [in] keys device array of keys, size [n]
+   * @param [in] n number of keys
+   * @param [in] stream cuda stream
+   */
+  void Prefetch(const key_t *keys, int n, cudaStream_t stream) {
+    Op op(*this, stream);
+    if (n <= 0 || host_associativity == 0) return;
+    n_iter++;
+    ResizeTmpBuffers(n, stream);
     get_cache_idx<<<ceildiv(n, TPB), TPB, 0, stream>>>(
       keys, n, cached_keys.data(), n_cache_sets, associativity,
-      cache_time.data(), cache_idx, is_cached, n_iter);
+      cache_time.data(), ws_tmp.data(), is_cached.data(), n_iter,
+      policy == CLOCK ? cache_ref.data() : nullptr);
     CUDA_CHECK(cudaPeekAtLastError());
+    Promote(keys, n, ws_tmp.data(), is_cached.data(), false, stream);
   }
 
   /** @brief Map a set of keys to cache indices.
@@ -270,8 +444,13 @@ class Cache {
    * @param [out] n_cached number of elements that are cached
    * @param [in] stream cuda stream
    */
-  void GetCacheIdxPartitioned(int *keys, int n, int *cache_idx, int *n_cached,
-                              cudaStream_t stream) {
+  void GetCacheIdxPartitioned(key_t *keys, int n, int *cache_idx,
+                              int *n_cached, cudaStream_t stream) {
+    Op op(*this, stream);
+    if (n <= 0) {
+      *n_cached = 0;
+      return;
+    }
     ResizeTmpBuffers(n, stream);
 
     GetCacheIdx(keys, n, ws_tmp.data(), is_cached.data(), stream);
@@ -284,9 +463,9 @@ class Cache {
     updateHost(n_cached, d_num_selected_out.data(), 1, stream);
 
     // Similarily re-group the input indices
-    copy(ws_tmp.data(), keys, n, stream);
+    copy(idx_tmp.data(), keys, n, stream);
     cub::DevicePartition::Flagged(d_temp_storage.data(), d_temp_storage_size,
-                                  ws_tmp.data(), is_cached.data(), keys,
+                                  idx_tmp.data(), is_cached.data(), keys,
                                   d_num_selected_out.data(), n, stream);
 
     CUDA_CHECK(cudaStreamSynchronize(stream));
@@ -304,8 +483,10 @@ class Cache {
    *   size[n]
    * @param [in] stream cuda stream
    */
-  void AssignCacheIdx(int *keys, int n, int *cidx, cudaStream_t stream) {
+  void AssignCacheIdx(key_t *keys, int n, int *cidx, cudaStream_t stream) {
+    Op op(*this, stream);
     if (n <= 0) return;
+    ResizeTmpBuffers(n, stream);
     cub::DeviceRadixSort::SortPairs(d_temp_storage.data(), d_temp_storage_size,
                                     cidx, ws_tmp.data(), keys, idx_tmp.data(),
                                     n, 0, sizeof(int) * 8, stream);
@@ -314,14 +495,10 @@ class Cache {
 
     // set it to -1
     CUDA_CHECK(cudaMemsetAsync(cidx, 255, n * sizeof(int), stream));
-    const int nthreads = associativity <= 32 ? associativity : 32;
-
-    assign_cache_idx<nthreads, associativity>
-      <<<n_cache_sets, nthreads, 0, stream>>>(keys, n, ws_tmp.data(),
-                                              cached_keys.data(), n_cache_sets,
-                                              cache_time.data(), n_iter, cidx);
+    if (n_cache_sets == 0) return;
 
-    CUDA_CHECK(cudaPeekAtLastError());
+    Assign(keys, n, ws_tmp.data(), cidx, stream);
+    if (host_associativity > 0) Spill(n, ws_tmp.data(), cidx, stream);
     if (debug_mode) CUDA_CHECK(cudaDeviceSynchronize());
   }
 
@@ -333,26 +510,102 @@ class Cache {
    */
   int GetSize() const { return cached_keys.size(); }
 
+  /**
+   * Returns the number of vectors that can be spilled to the host tier.
+   */
+  int GetHostSize() const { return host_keys.size(); }
+
+  /** Returns the replacement policy. */
+  CachePolicy GetPolicy() const { return policy; }
+
+  /**
+   * @brief Return the lookups and hits since the construction or the last
+   * ResetStats, synchronizing the stream.
+   */
+  CacheStats GetStats(cudaStream_t stream) {
+    Op op(*this, stream);
+    unsigned long long h_hits[2];
+    updateHost(h_hits, n_hits.data(), 2, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CacheStats stats;
+    stats.n_lookups = n_lookups;
+    stats.n_hits = h_hits[0];
+    stats.n_host_hits = h_hits[1];
+    return stats;
+  }
+
+  /** @brief Reset the counts of the lookups and hits. */
+  void ResetStats(cudaStream_t stream) {
+    Op op(*this, stream);
+    n_lookups = 0;
+    CUDA_CHECK(cudaMemsetAsync(n_hits.data(), 0,
+                               n_hits.size() * sizeof(unsigned long long),
+                               stream));
+  }
+
  private:
+  /* Scope of a call: locks the cache, and orders the work of the call on its
+   * stream after the work of the previous call */
+  class Op {
+   public:
+    Op(Cache &c, cudaStream_t stream) : c(c), stream(stream), guard(c.mtx) {
+      CUDA_CHECK(cudaStreamWaitEvent(stream, c.last_op, 0));
+    }
+    ~Op() { CUDA_CHECK_NO_THROW(cudaEventRecord(c.last_op, stream)); }
+
+   private:
+    Cache &c;
+    cudaStream_t stream;
+    std::lock_guard<std::recursive_mutex> guard;
+  };
+
   std::shared_ptr<deviceAllocator> allocator;
 
-  int n_vec;         //!< Number of elements in a cached vector
-  float cache_size;  //!< in MiB
-  int n_cache_sets;  //!< number of cache sets
+  int n_vec;           //!< Number of elements in a cached vector
+  float cache_size;    //!< in MiB
+  int n_cache_sets;    //!< number of cache sets
+  CachePolicy policy;  //!< replacement policy
+  int host_associativity = 0;  //!< host entries per set, 0 without host tier
 
   const int TPB = 256;  //!< threads per block for kernel launch
   int n_iter = 0;       //!< Counter for time stamping cache operation
 
   bool debug_mode = false;
 
-  MLCommon::device_buffer<math_t> cache;     //!< The value of cached vectors
-  MLCommon::device_buffer<int> cached_keys;  //!< Keys stored at each cache loc
-  MLCommon::device_buffer<int> cache_time;   //!< Time stamp for LRU cache
+  MLCommon::device_buffer<store_t> cache;  //!< The value of cached vectors
+  MLCommon::device_buffer<key_t> cached_keys;  //!< Keys stored at each loc
+  MLCommon::device_buffer<int> cache_time;     //!< Time stamp for LRU cache
+  MLCommon::device_buffer<int> cache_ref;   //!< Reference bits for CLOCK cache
+  MLCommon::device_buffer<int> clock_hand;  //!< Hand of each CLOCK cache set
+
+  MLCommon::host_buffer<store_t> host_cache;  //!< The spilled vectors
+  MLCommon::device_buffer<key_t> host_keys;   //!< Keys of the host tier
+  MLCommon::device_buffer<int> host_time;     //!< Time stamps of the host tier
+
+  uint64_t n_lookups = 0;  //!< Keys looked up
+  //! Keys found, and keys found in the host tier
+  MLCommon::device_buffer<unsigned long long> n_hits;
+
+  std::recursive_mutex mtx;  //!< Serializes the calls
+  cudaEvent_t last_op;       //!< Recorded at the end of every call
 
   // Helper arrays for GetCacheIdx
   MLCommon::device_buffer<bool> is_cached;
   MLCommon::device_buffer<int> ws_tmp;
-  MLCommon::device_buffer<int> idx_tmp;
+  MLCommon::device_buffer<key_t> idx_tmp;
+
+  // Helper arrays for the host tier
+  MLCommon::device_buffer<int> host_idx_tmp;
+  MLCommon::device_buffer<int> promote_set;
+  MLCommon::device_buffer<int> promote_pos;
+  MLCommon::device_buffer<int> sorted_set;
+  MLCommon::device_buffer<int> sorted_pos;
+  MLCommon::device_buffer<key_t> sorted_keys;
+  MLCommon::device_buffer<int> sorted_host_idx;
+  MLCommon::device_buffer<int> sorted_cache_idx;
+  MLCommon::device_buffer<bool> evicted;
+  MLCommon::device_buffer<key_t> evicted_keys;
+  MLCommon::device_buffer<int> spill_idx;
 
   // Helper arrays for cub
   MLCommon::device_buffer<int> d_num_selected_out;
@@ -364,11 +617,128 @@ class Cache {
       ws_tmp.resize(n, stream);
       is_cached.resize(n, stream);
       idx_tmp.resize(n, stream);
+      // the temp storage serves the partitions of the cache indices and of
+      // the keys, and the sort by cache set
+      size_t part_idx_size = 0, part_key_size = 0, sort_size = 0;
+      size_t sort_pos_size = 0;
+      cub::DevicePartition::Flagged(
+        NULL, part_idx_size, ws_tmp.data(), is_cached.data(), ws_tmp.data(),
+        d_num_selected_out.data(), n, stream);
       cub::DevicePartition::Flagged(
-        NULL, d_temp_storage_size, cached_keys.data(), is_cached.data(),
-        cached_keys.data(), d_num_selected_out.data(), n, stream);
+        NULL, part_key_size, idx_tmp.data(), is_cached.data(), idx_tmp.data(),
+        d_num_selected_out.data(), n, stream);
+      cub::DeviceRadixSort::SortPairs(NULL, sort_size, ws_tmp.data(),
+                                      ws_tmp.data(), idx_tmp.data(),
+                                      idx_tmp.data(), n, 0, sizeof(int) * 8,
+                                      stream);
+      // and the sort of the positions of the keys to promote
+      cub::DeviceRadixSort::SortPairs(NULL, sort_pos_size, ws_tmp.data(),
+                                      ws_tmp.data(), ws_tmp.data(),
+                                      ws_tmp.data(), n, 0, sizeof(int) * 8,
+                                      stream);
+      d_temp_storage_size =
+        std::max(std::max(part_idx_size, part_key_size),
+                 std::max(sort_size, sort_pos_size));
       d_temp_storage.resize(d_temp_storage_size, stream);
     }
+    if (host_associativity > 0 && sorted_keys.size() < n) {
+      host_idx_tmp.resize(n, stream);
+      promote_set.resize(n, stream);
+      promote_pos.resize(n, stream);
+      sorted_set.resize(n, stream);
+      sorted_pos.resize(n, stream);
+      sorted_keys.resize(n, stream);
+      sorted_host_idx.resize(n, stream);
+      sorted_cache_idx.resize(n, stream);
+      evicted.resize(n, stream);
+      evicted_keys.resize(n, stream);
+      spill_idx.resize(n, stream);
+    }
+  }
+
+  /* Assign device locations to the keys, sorted by their cache set, the
+   * locations of valid entries being recorded in evicted with a host tier */
+  void Assign(const key_t *keys, int n, const int *cache_set, int *cidx,
+              cudaStream_t stream) {
+    bool *evicted_ptr = nullptr;
+    key_t *evicted_keys_ptr = nullptr;
+    if (host_associativity > 0) {
+      CUDA_CHECK(cudaMemsetAsync(evicted.data(), 0, n * sizeof(bool), stream));
+      evicted_ptr = evicted.data();
+      evicted_keys_ptr = evicted_keys.data();
+    }
+    if (policy == CLOCK) {
+      assign_cache_idx_clock<associativity>
+        <<<ceildiv(n_cache_sets, TPB), TPB, 0, stream>>>(
+          keys, n, cache_set, cached_keys.data(), n_cache_sets,
+          cache_time.data(), cache_ref.data(), clock_hand.data(), n_iter, cidx,
+          evicted_ptr, evicted_keys_ptr);
+    } else {
+      const int nthreads = associativity <= 32 ? associativity : 32;
+      assign_cache_idx<nthreads, associativity>
+        <<<n_cache_sets, nthreads, 0, stream>>>(
+          keys, n, cache_set, cached_keys.data(), n_cache_sets,
+          cache_time.data(), n_iter, cidx, evicted_ptr, evicted_keys_ptr);
+    }
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+
+  /* Spill the entries that Assign evicted to the host tier, before their
+   * device locations are overwritten */
+  void Spill(int n, const int *cache_set, const int *cidx,
+             cudaStream_t stream) {
+    CUDA_CHECK(cudaMemsetAsync(spill_idx.data(), 255, n * sizeof(int), stream));
+    spill_cache_idx<<<ceildiv(n_cache_sets, TPB), TPB, 0, stream>>>(
+      cache_set, n, evicted.data(), evicted_keys.data(), host_keys.data(),
+      host_time.data(), n_cache_sets, host_associativity, n_iter,
+      spill_idx.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+    copy_vecs<<<ceildiv(n * n_vec, TPB), TPB, 0, stream>>>(
+      cache.data(), cidx, host_cache.data(), spill_idx.data(), n, n_vec);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+
+  /* Promote the keys that missed the device tier but are found in the host
+   * tier: they are assigned device locations, possibly spilling other
+   * entries, their vectors are copied from the host, and they are reported as
+   * cached in cache_idx and is_cached */
+  void Promote(const key_t *keys, int n, int *cache_idx, bool *is_cached,
+               bool count, cudaStream_t stream) {
+    ResizeTmpBuffers(n, stream);
+    get_host_idx<<<ceildiv(n, TPB), TPB, 0, stream>>>(
+      keys, n, is_cached, cache_idx, host_keys.data(), host_time.data(),
+      n_cache_sets, host_associativity, n_iter, host_idx_tmp.data(),
+      promote_set.data(), promote_pos.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    // the keys not found in the host tier are sorted last, with the set
+    // n_cache_sets that Assign and Spill skip
+    cub::DeviceRadixSort::SortPairs(d_temp_storage.data(), d_temp_storage_size,
+                                    promote_set.data(), sorted_set.data(),
+                                    promote_pos.data(), sorted_pos.data(), n,
+                                    0, sizeof(int) * 8, stream);
+    gather_promoted<<<ceildiv(n, TPB), TPB, 0, stream>>>(
+      keys, host_idx_tmp.data(), sorted_pos.data(), n, sorted_keys.data(),
+      sorted_host_idx.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    CUDA_CHECK(cudaMemsetAsync(sorted_cache_idx.data(), 255, n * sizeof(int),
+                               stream));
+    Assign(sorted_keys.data(), n, sorted_set.data(), sorted_cache_idx.data(),
+           stream);
+    Spill(n, sorted_set.data(), sorted_cache_idx.data(), stream);
+    // the host entries being promoted carry the current time stamp, so the
+    // spilled entries did not overwrite them
+    copy_vecs<<<ceildiv(n * n_vec, TPB), TPB, 0, stream>>>(
+      host_cache.data(), sorted_host_idx.data(), cache.data(),
+      sorted_cache_idx.data(), n, n_vec);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    finish_promotion<<<ceildiv(n, TPB), TPB, 0, stream>>>(
+      sorted_pos.data(), sorted_host_idx.data(), sorted_cache_idx.data(), n,
+      host_time.data(), cache_idx, is_cached,
+      count ? n_hits.data() : nullptr, count ? n_hits.data() + 1 : nullptr);
+    CUDA_CHECK(cudaPeekAtLastError());
   }
 };
 
@@ -16,8 +16,10 @@
 
 #pragma once
 
+#include <cuda_fp16.h>
 #include <cuda_utils.h>
 #include <cub/cub.cuh>
+#include <climits>
 #include "common/device_buffer.hpp"
 #include "ml_utils.h"
 #include "selection/kselection.h"
@@ -25,6 +27,27 @@
 namespace MLCommon {
 namespace Cache {
 
+/**
+ * @brief Conversion between the type of the cached elements and the type of
+ * their storage, through float for half precision storage.
+ */
+template <typename out_t, typename in_t>
+struct StoreCast {
+  static HDI out_t cast(in_t x) { return static_cast<out_t>(x); }
+};
+template <typename in_t>
+struct StoreCast<__half, in_t> {
+  static DI __half cast(in_t x) { return __float2half(static_cast<float>(x)); }
+};
+template <typename out_t>
+struct StoreCast<out_t, __half> {
+  static DI out_t cast(__half x) { return static_cast<out_t>(__half2float(x)); }
+};
+template <>
+struct StoreCast<__half, __half> {
+  static HDI __half cast(__half x) { return x; }
+};
+
 /**
  * @brief Collect vectors of data from the cache into a contiguous memory buffer.
  *
@@ -36,14 +59,17 @@ namespace Cache {
  * out[i + n_vec*k] = cache[i + n_vec * cache_idx[k]]), where i=0..n_vec-1, and
  *   k = 0..n-1
  *
+ * @tparam math_t type of the collected elements
+ * @tparam store_t type of the elements in the cache
+ *
  * @param [in] cache stores the cached data, size [n_vec x n_cached_vectors]
  * @param [in] n_vec number of elements in a cached vector
  * @param [in] cache_idx cache indices, size [n]
  * @param [in] n the number of elements that need to be collected
  * @param [out] out vectors collected from the cache, size [n_vec * n]
  */
-template <typename math_t>
-__global__ void get_vecs(const math_t *cache, int n_vec, const int *cache_idx,
+template <typename math_t, typename store_t>
+__global__ void get_vecs(const store_t *cache, int n_vec, const int *cache_idx,
                          int n, math_t *out) {
   int tid = threadIdx.x + blockIdx.x * blockDim.x;
   int row = tid % n_vec;  // row idx
@@ -51,7 +77,8 @@ __global__ void get_vecs(const math_t *cache, int n_vec, const int *cache_idx,
     int out_col = tid / n_vec;  // col idx
     int cache_col = cache_idx[out_col];
     if (row + out_col * n_vec < n_vec * n) {
-      out[tid] = cache[row + cache_col * n_vec];
+      out[tid] = StoreCast<math_t, store_t>::cast(
+        cache[row + (size_t)cache_col * n_vec]);
     }
   }
 }
@@ -73,6 +100,9 @@ __global__ void get_vecs(const math_t *cache, int n_vec, const int *cache_idx,
  * cache[i + cache_idx[k]*n_vec] = tile[i + tile_idx[k]*n_vec],
  * for i=0..n_vec-1, k=0..n-1
  *
+ * @tparam math_t type of the elements of the tile
+ * @tparam store_t type of the elements in the cache
+ *
  * @param [in] tile stores the data to be cashed cached, size [n_vec x n_tile]
  * @param [in] n_tile number of vectors in the input tile
  * @param [in] n_vec number of elements in a cached vector
@@ -82,10 +112,10 @@ __global__ void get_vecs(const math_t *cache, int n_vec, const int *cache_idx,
  * @param [inout] cache updated cache
  * @param [in] n_cache_vecs
  */
-template <typename math_t>
+template <typename math_t, typename store_t>
 __global__ void store_vecs(const math_t *tile, int n_tile, int n_vec,
                            const int *tile_idx, int n, const int *cache_idx,
-                           math_t *cache, int n_cache_vecs) {
+                           store_t *cache, int n_cache_vecs) {
   int tid = threadIdx.x + blockIdx.x * blockDim.x;
   int row = tid % n_vec;  // row idx
   if (tid < n_vec * n) {
@@ -96,7 +126,8 @@ __global__ void store_vecs(const math_t *tile, int n_tile, int n_vec,
     // We ignore negative values. The rest of the checks should be fulfilled
     // if the cache is used properly
     if (cache_col >= 0 && cache_col < n_cache_vecs && data_col < n_tile) {
-      cache[row + cache_col * n_vec] = tile[row + data_col * n_vec];
+      cache[row + (size_t)cache_col * n_vec] =
+        StoreCast<store_t, math_t>::cast(tile[row + (size_t)data_col * n_vec]);
     }
   }
 }
@@ -104,7 +135,8 @@ __global__ void store_vecs(const math_t *tile, int n_tile, int n_vec,
 /**
  * Map a key to a cache set.
  */
-int DI hash(int key, int n_cache_sets, int associativity) {
+template <typename key_t>
+int DI hash(key_t key, int n_cache_sets, int associativity) {
   return key % n_cache_sets;
 }
 
@@ -205,7 +237,7 @@ DI void rank_set_entries(const int *cache_time, int n_cache_sets, int *rank) {
 
   for (int j = 0; j < items_per_thread; j++) {
     int k = threadIdx.x + j * nthreads;
-    int t = (k < associativity) ? cache_time[block_offset + k] : 32768;
+    int t = (k < associativity) ? cache_time[block_offset + k] : INT_MAX;
     key[j] = t;
     val[j] = k;
   }
@@ -233,6 +265,7 @@ DI void rank_set_entries(const int *cache_time, int n_cache_sets, int *rank) {
  *
  * @tparam nthreads number of threads per block
  * @tparam assaciativity number of keys in a cache set
+ * @tparam key_t type of the keys
  *
  * @param [in] keys that we want to cache size [n]
  * @param [in] n number of keys
@@ -246,11 +279,17 @@ DI void rank_set_entries(const int *cache_time, int n_cache_sets, int *rank) {
  * @param [in] time time stamp
  * @param [out] cache_idx the cache idx assigned to the input, or -1 if it could
  *   not be cached, size [n]
+ * @param [out] evicted if not nullptr, set to true for the keys whose cache
+ *   location held a valid entry, size [n]
+ * @param [out] evicted_keys if not nullptr, the keys of these entries,
+ *   size [n]
  */
-template <int nthreads, int associativity>
-__global__ void assign_cache_idx(const int *keys, int n, const int *cache_set,
-                                 int *cached_keys, int n_cache_sets,
-                                 int *cache_time, int time, int *cache_idx) {
+template <int nthreads, int associativity, typename key_t>
+__global__ void assign_cache_idx(const key_t *keys, int n, const int *cache_set,
+                                 key_t *cached_keys, int n_cache_sets,
+                                 int *cache_time, int time, int *cache_idx,
+                                 bool *evicted = nullptr,
+                                 key_t *evicted_keys = nullptr) {
   int block_offset = blockIdx.x * associativity;
 
   const int items_per_thread = ceildiv(associativity, nthreads);
@@ -280,7 +319,11 @@ __global__ void assign_cache_idx(const int *keys, int n, const int *cache_set,
     if (mask) {
       int k = find_nth_occurrence(cache_set, n, blockIdx.x, rank[i]);
       if (k > -1) {
-        int key_val = keys[k];
+        key_t key_val = keys[k];
+        if (evicted != nullptr && cache_time[t_idx] > 0) {
+          evicted[k] = true;
+          evicted_keys[k] = cached_keys[t_idx];
+        }
         cached_keys[t_idx] = key_val;
         cache_idx[k] = t_idx;
         cache_time[t_idx] = time;
@@ -289,9 +332,77 @@ __global__ void assign_cache_idx(const int *keys, int n, const int *cache_set,
   }
 }
 
-/* Unnamed namespace is used to avoid multiple definition error for the
-  following non-template function */
-namespace {
+/**
+ * @brief Assign cache location to a set of keys using the clock (second
+ * chance) replacement policy.
+ *
+ * The keys and the corresponding cache_set arrays shall be sorted according
+ * to cache_set in ascending order. One thread handles a cache set: its hand
+ * sweeps the entries of the set, clearing the reference bit of the entries
+ * that have it set, and replaces the first entry whose bit is already clear.
+ * As for assign_cache_idx, entries that were accessed at the current time are
+ * not reassigned, and keys for which no entry is left get -1.
+ *
+ * @tparam associativity number of keys in a cache set
+ * @tparam key_t type of the keys
+ *
+ * @param [in] keys that we want to cache size [n]
+ * @param [in] n number of keys
+ * @param [in] cache_set assigned to keys, size [n]
+ * @param [inout] cached_keys keys of already cached vectors,
+ *   size [n_cache_sets*associativity], on exit it will be updated with the
+ *   cached elements from keys.
+ * @param [in] n_cache_sets number of cache sets
+ * @param [inout] cache_time will be updated to "time" for those elements that
+ *   could be assigned to a cache location, size [n_cache_sets*associativity]
+ * @param [inout] cache_ref reference bits, size [n_cache_sets*associativity]
+ * @param [inout] clock_hand position of the hand in each set,
+ *   size [n_cache_sets]
+ * @param [in] time time stamp
+ * @param [out] cache_idx the cache idx assigned to the input, or -1 if it could
+ *   not be cached, size [n]
+ * @param [out] evicted if not nullptr, set to true for the keys whose cache
+ *   location held a valid entry, size [n]
+ * @param [out] evicted_keys if not nullptr, the keys of these entries,
+ *   size [n]
+ */
+template <int associativity, typename key_t>
+__global__ void assign_cache_idx_clock(
+  const key_t *keys, int n, const int *cache_set, key_t *cached_keys,
+  int n_cache_sets, int *cache_time, int *cache_ref, int *clock_hand, int time,
+  int *cache_idx, bool *evicted = nullptr, key_t *evicted_keys = nullptr) {
+  int set = threadIdx.x + blockIdx.x * blockDim.x;
+  if (set >= n_cache_sets) return;
+  int block_offset = set * associativity;
+  int hand = clock_hand[set];
+  for (int k = arg_first_ge(cache_set, n, set); k < n && cache_set[k] == set;
+       k++) {
+    // two sweeps clear all the reference bits, so that an entry is found
+    // unless all of them were accessed at the current time
+    int t_idx = -1;
+    for (int i = 0; i < 2 * associativity && t_idx < 0; i++) {
+      int s = block_offset + hand;
+      hand = (hand + 1) % associativity;
+      if (cache_time[s] == time) continue;
+      if (cache_ref[s]) {
+        cache_ref[s] = 0;
+      } else {
+        t_idx = s;
+      }
+    }
+    if (t_idx < 0) break;
+    if (evicted != nullptr && cache_time[t_idx] > 0) {
+      evicted[k] = true;
+      evicted_keys[k] = cached_keys[t_idx];
+    }
+    cached_keys[t_idx] = keys[k];
+    cache_idx[k] = t_idx;
+    cache_time[t_idx] = time;
+    cache_ref[t_idx] = 1;
+  }
+  clock_hand[set] = hand;
+}
+
 /**
  * @brief Get the cache indices for keys stored in the cache.
  *
@@ -306,27 +417,38 @@ namespace {
  *
  * Cache_time is assigned to the time input argument for all elements in idx.
  *
+ * @tparam key_t type of the keys
+ *
  * @param [in] keys array of keys that we want to look up in the cache, size [n]
  * @param [in] n number of keys to look up
- * @param [inout] cached_keys keys stored in the cache, size [n_cache_sets * associativity]
+ * @param [in] cached_keys keys stored in the cache,
+ *   size [n_cache_sets * associativity]
  * @param [in] n_cache_sets number of cache sets
  * @param [in] associativity number of keys in cache set
- * @param [inout] cache_time time stamp when the indices were cached, size [n_cache_sets * associativity]
+ * @param [inout] cache_time time stamp when the indices were cached,
+ *   size [n_cache_sets * associativity]
  * @param [out] cache_idx cache indices of the working set elements, size [n]
  * @param [out] is_cached whether the element is cached size[n]
  * @param [in] time iteration counter (used for time stamping)
+ * @param [out] cache_ref if not nullptr, the reference bit of the entries that
+ *   are found is set, size [n_cache_sets * associativity]
+ * @param [inout] n_hits if not nullptr, incremented by the number of keys that
+ *   are found
  */
-__global__ void get_cache_idx(int *keys, int n, int *cached_keys,
-                              int n_cache_sets, int associativity,
-                              int *cache_time, int *cache_idx, bool *is_cached,
-                              int time) {
+template <typename key_t>
+__global__ void get_cache_idx(const key_t *keys, int n,
+                              const key_t *cached_keys, int n_cache_sets,
+                              int associativity, int *cache_time,
+                              int *cache_idx, bool *is_cached, int time,
+                              int *cache_ref = nullptr,
+                              unsigned long long *n_hits = nullptr) {
   int tid = threadIdx.x + blockIdx.x * blockDim.x;
+  bool found = false;
   if (tid < n) {
-    int widx = keys[tid];
+    key_t widx = keys[tid];
     int sidx = hash(widx, n_cache_sets, associativity);
     int cidx = sidx * associativity;
     int i = 0;
-    bool found = false;
     // search for empty spot and the least recently used spot
     while (i < associativity && !found) {
       found = (cache_time[cidx + i] > 0 && cached_keys[cidx + i] == widx);
@@ -336,11 +458,220 @@ __global__ void get_cache_idx(int *keys, int n, int *cached_keys,
     if (found) {
       cidx = cidx + i - 1;
       cache_time[cidx] = time;  //update time stamp
-      cache_idx[tid] = cidx;    //exact cache idx
+      if (cache_ref != nullptr) cache_ref[cidx] = 1;
+      cache_idx[tid] = cidx;  //exact cache idx
     } else {
       cache_idx[tid] = sidx;  // assign cache set
     }
   }
+  if (n_hits != nullptr) {
+    // one atomic per warp
+    unsigned int hits = __ballot_sync(0xffffffff, found);
+    if ((threadIdx.x & 31) == 0 && hits != 0) {
+      atomicAdd(n_hits, (unsigned long long)__popc(hits));
+    }
+  }
+}
+
+/**
+ * @brief Copy vectors between two cache buffers.
+ *
+ * dst[i + dst_idx[k]*n_vec] = src[i + src_idx[k]*n_vec], for i=0..n_vec-1,
+ * k=0..n-1, skipping the k where either index is negative. Either buffer can
+ * be in pinned host memory, which the kernel accesses directly.
+ *
+ * @param [in] src source buffer
+ * @param [in] src_idx source vector indices, size [n]
+ * @param [out] dst destination buffer
+ * @param [in] dst_idx destination vector indices, size [n]
+ * @param [in] n number of vectors
+ * @param [in] n_vec number of elements in a cached vector
+ */
+template <typename store_t>
+__global__ void copy_vecs(const store_t *src, const int *src_idx, store_t *dst,
+                          const int *dst_idx, int n, int n_vec) {
+  int tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid < n_vec * n) {
+    int row = tid % n_vec;
+    int k = tid / n_vec;
+    int s = src_idx[k];
+    int d = dst_idx[k];
+    if (s >= 0 && d >= 0) {
+      dst[row + (size_t)d * n_vec] = src[row + (size_t)s * n_vec];
+    }
+  }
+}
+
+/**
+ * @brief Assign host tier locations to the entries evicted from the device
+ * tier.
+ *
+ * The host tier has as many sets as the device tier, so that the entries
+ * evicted from a device set go to the host set of the same index. The
+ * cache_set array shall be sorted in ascending order, as for
+ * assign_cache_idx. One thread handles a set, replacing the least recently
+ * used host entries that were not accessed at the current time.
+ *
+ * @param [in] cache_set the device set of the keys, size [n]
+ * @param [in] n number of keys
+ * @param [in] evicted whether the location assigned to the key held an entry
+ *   that has to be spilled, size [n]
+ * @param [in] evicted_keys keys of the spilled entries, size [n]
+ * @param [inout] host_keys keys of the host tier,
+ *   size [n_cache_sets * host_associativity]
+ * @param [inout] host_time time stamps of the host tier,
+ *   size [n_cache_sets * host_associativity]
+ * @param [in] n_cache_sets number of cache sets
+ * @param [in] host_associativity number of entries in a host set
+ * @param [in] time time stamp
+ * @param [out] spill_idx host location of the spilled entries, -1 for the
+ *   entries that could not be spilled, left unchanged for the keys without
+ *   an evicted entry, size [n]
+ */
+template <typename key_t>
+__global__ void spill_cache_idx(const int *cache_set, int n,
+                                const bool *evicted, const key_t *evicted_keys,
+                                key_t *host_keys, int *host_time,
+                                int n_cache_sets, int host_associativity,
+                                int time, int *spill_idx) {
+  int set = threadIdx.x + blockIdx.x * blockDim.x;
+  if (set >= n_cache_sets) return;
+  int offset = set * host_associativity;
+  for (int k = arg_first_ge(cache_set, n, set); k < n && cache_set[k] == set;
+       k++) {
+    if (!evicted[k]) continue;
+    int h_idx = -1;
+    for (int i = 0; i < host_associativity; i++) {
+      int t = host_time[offset + i];
+      if (t != time && (h_idx < 0 || t < host_time[h_idx])) h_idx = offset + i;
+    }
+    spill_idx[k] = h_idx;
+    if (h_idx >= 0) {
+      host_keys[h_idx] = evicted_keys[k];
+      host_time[h_idx] = time;
+    }
+  }
+}
+
+/**
+ * @brief Look up the keys that missed the device tier in the host tier.
+ *
+ * The host entries that are found get the time stamp, so that they are not
+ * replaced before they are promoted to the device tier. To sort the keys to
+ * promote by device set, the keys that are not found get the set n_cache_sets.
+ *
+ * @param [in] keys the keys looked up, size [n]
+ * @param [in] n number of keys
+ * @param [in] is_cached whether the key was found in the device tier, size [n]
+ * @param [in] cache_set the device set of the keys not found, size [n]
+ * @param [in] host_keys keys of the host tier,
+ *   size [n_cache_sets * host_associativity]
+ * @param [inout] host_time time stamps of the host tier,
+ *   size [n_cache_sets * host_associativity]
+ * @param [in] n_cache_sets number of cache sets
+ * @param [in] host_associativity number of entries in a host set
+ * @param [in] time time stamp
+ * @param [out] host_idx host location of the key, or -1, size [n]
+ * @param [out] promote_set device set of the keys found, or n_cache_sets,
+ *   size [n]
+ * @param [out] pos the positions 0..n-1, size [n]
+ */
+template <typename key_t>
+__global__ void get_host_idx(const key_t *keys, int n, const bool *is_cached,
+                             const int *cache_set, const key_t *host_keys,
+                             int *host_time, int n_cache_sets,
+                             int host_associativity, int time, int *host_idx,
+                             int *promote_set, int *pos) {
+  int tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid < n) {
+    int h_idx = -1;
+    int set = n_cache_sets;
+    if (!is_cached[tid]) {
+      key_t key = keys[tid];
+      int offset = cache_set[tid] * host_associativity;
+      for (int i = 0; i < host_associativity && h_idx < 0; i++) {
+        if (host_time[offset + i] > 0 && host_keys[offset + i] == key) {
+          h_idx = offset + i;
+        }
+      }
+      if (h_idx >= 0) {
+        host_time[h_idx] = time;
+        set = cache_set[tid];
+      }
+    }
+    host_idx[tid] = h_idx;
+    promote_set[tid] = set;
+    pos[tid] = tid;
+  }
+}
+
+/**
+ * @brief Gather the keys and host locations of the keys to promote in the
+ * order of their device set.
+ *
+ * @param [in] keys the keys looked up, size [n]
+ * @param [in] host_idx host location of the keys, size [n]
+ * @param [in] pos position of the keys in the order of their device set,
+ *   size [n]
+ * @param [in] n number of keys
+ * @param [out] sorted_keys keys[pos[j]], size [n]
+ * @param [out] sorted_host_idx host_idx[pos[j]], size [n]
+ */
+template <typename key_t>
+__global__ void gather_promoted(const key_t *keys, const int *host_idx,
+                                const int *pos, int n, key_t *sorted_keys,
+                                int *sorted_host_idx) {
+  int j = threadIdx.x + blockIdx.x * blockDim.x;
+  if (j < n) {
+    sorted_keys[j] = keys[pos[j]];
+    sorted_host_idx[j] = host_idx[pos[j]];
+  }
+}
+
+/* Unnamed namespace is used to avoid multiple definition error for the
+  following non-template function */
+namespace {
+/**
+ * @brief Complete the promotion of the host entries to the device tier.
+ *
+ * The promoted keys are reported as cached at their new device location, and
+ * their host entries are released.
+ *
+ * @param [in] pos position of the keys in the lookup, size [n]
+ * @param [in] host_idx host location of the keys, or -1, size [n]
+ * @param [in] device_idx device location assigned to the keys, or -1,
+ *   size [n]
+ * @param [in] n number of keys
+ * @param [inout] host_time time stamps of the host tier
+ * @param [inout] cache_idx cache indices of the lookup, size [n]
+ * @param [inout] is_cached whether the keys of the lookup are cached, size [n]
+ * @param [inout] n_hits if not nullptr, incremented by the number of keys
+ *   promoted
+ * @param [inout] n_host_hits if not nullptr, incremented by the number of
+ *   keys promoted
+ */
+__global__ void finish_promotion(const int *pos, const int *host_idx,
+                                 const int *device_idx, int n, int *host_time,
+                                 int *cache_idx, bool *is_cached,
+                                 unsigned long long *n_hits,
+                                 unsigned long long *n_host_hits) {
+  int j = threadIdx.x + blockIdx.x * blockDim.x;
+  bool promoted = false;
+  if (j < n) {
+    promoted = host_idx[j] >= 0 && device_idx[j] >= 0;
+    if (promoted) {
+      host_time[host_idx[j]] = 0;
+      is_cached[pos[j]] = true;
+      cache_idx[pos[j]] = device_idx[j];
+    }
+  }
+  if (n_hits != nullptr) {
+    unsigned int hits = __ballot_sync(0xffffffff, promoted);
+    if ((threadIdx.x & 31) == 0 && hits != 0) {
+      atomicAdd(n_hits, (unsigned long long)__popc(hits));
+      atomicAdd(n_host_hits, (unsigned long long)__popc(hits));
+    }
+  }
 }
 };  // end unnamed namespace
 };  // end namespace Cache
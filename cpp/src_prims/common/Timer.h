@@ -15,7 +15,9 @@
  */
 
 #pragma once
+#include <cuda_runtime.h>
 #include <chrono>
+#include "utils.h"
 
 namespace MLCommon {
 class TimerCPU {
@@ -39,4 +41,48 @@ class TimerCPU {
  private:
   std::chrono::high_resolution_clock::time_point time;
 };
+
+/**
+ * @brief Times the work of a stream between start() and stop() with a pair of
+ *        events, without synchronizing until the elapsed time is read.
+ */
+class TimerGPU {
+ public:
+  TimerGPU() {
+    CUDA_CHECK(cudaEventCreate(&this->begin));
+    CUDA_CHECK(cudaEventCreate(&this->end));
+  }
+
+  ~TimerGPU() {
+    // destructors should not throw exceptions, which is why CUDA_CHECK is not
+    // used
+    cudaEventDestroy(this->begin);
+    cudaEventDestroy(this->end);
+  }
+
+  TimerGPU(const TimerGPU &other) = delete;
+  TimerGPU &operator=(const TimerGPU &other) = delete;
+
+  void start(cudaStream_t stream) {
+    CUDA_CHECK(cudaEventRecord(this->begin, stream));
+  }
+
+  void stop(cudaStream_t stream) {
+    CUDA_CHECK(cudaEventRecord(this->end, stream));
+  }
+
+  /** whether the work up to stop() is done, so that reading does not block */
+  bool ready() const { return cudaEventQuery(this->end) == cudaSuccess; }
+
+  /** waits for the work up to stop() */
+  float getElapsedMilliseconds() const {
+    float ms = 0.f;
+    CUDA_CHECK(cudaEventSynchronize(this->end));
+    CUDA_CHECK(cudaEventElapsedTime(&ms, this->begin, this->end));
+    return ms;
+  }
+
+ private:
+  cudaEvent_t begin, end;
+};
 }  // End namespace MLCommon
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_fp16.h>
+#include <cub/cub.cuh>
+#include <cuml/common/cuml_allocator.hpp>
+#include <memory>
+#include "common/cuml_comms_int.hpp"
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+
+namespace MLCommon {
+
+template <typename T>
+struct CompressedAbsOp {
+  DI T operator()(T x) const { return myAbs(x); }
+};
+
+// v = x + r, the input compensated for what the previous calls lost
+template <typename T, int TPB>
+__global__ void compensateKernel(T *v, const T *x, const T *r, int len) {
+  int i = threadIdx.x + blockIdx.x * TPB;
+  if (i < len) v[i] = r != nullptr ? x[i] + r[i] : x[i];
+}
+
+// turn the largest magnitude over the ranks into the scale of the values,
+// bounding them by 2^15 / n_ranks so that their sum over the ranks stays below
+// the largest half, 65504
+template <typename T>
+__global__ void compressionScaleKernel(T *scale, int n_ranks) {
+  T maxAbs = *scale;
+  *scale = maxAbs > T(0) ? T(32768) / (maxAbs * n_ranks) : T(1);
+}
+
+template <typename T, int TPB>
+__global__ void compressKernel(__half *q, T *r, const T *v, const T *scale,
+                               int len) {
+  int i = threadIdx.x + blockIdx.x * TPB;
+  if (i >= len) return;
+  T s = *scale;
+  __half h = __float2half(float(v[i] * s));
+  q[i] = h;
+  if (r != nullptr) r[i] = v[i] - T(__half2float(h)) / s;
+}
+
+template <typename T, int TPB>
+__global__ void decompressKernel(T *out, const __half *q, const T *scale,
+                                 int len) {
+  int i = threadIdx.x + blockIdx.x * TPB;
+  if (i < len) out[i] = T(__half2float(q[i])) / *scale;
+}
+
+/**
+ * @brief Sum allreduce and reduce of float or double buffers, sent in half
+ *        precision to halve (float) or quarter (double) the bytes on the
+ *        network, for the bandwidth-bound collectives of the MG algorithms,
+ *        eg: histograms or gradients.
+ *
+ * The values are scaled by a common factor so that their sum over the ranks
+ * fits in half precision, at the cost of one more allreduce of a single
+ * value. With error feedback, what the rounding to half loses on a rank is
+ * added to the input of its next call, so that over many calls, eg: the
+ * iterations of an optimizer, the errors do not accumulate.
+ *
+ * An instance holds the buffers, and the error feedback, of the collectives
+ * of one size issued at one place: an algorithm opts in by routing those
+ * collectives through it instead of through the communicator. Only SUM is
+ * supported, and the comms must support HALF, ie: NCCL.
+ *
+ * @code{.cpp}
+ * MLCommon::compressedAllreduce<float> compressed(comm, allocator, n, stream);
+ * for (int it = 0; it < n_iter; ++it) {
+ *   ...  // the local gradient in grad
+ *   compressed.allreduce(grad, grad, stream);
+ * }
+ * @endcode
+ */
+template <typename T>
+class compressedAllreduce {
+ public:
+  /**
+   * @param comm the communicator to reduce over
+   * @param allocator the device allocator of the buffers
+   * @param count number of elements of the reduced buffers
+   * @param stream cuda stream where to initialize the buffers
+   * @param error_feedback whether to carry the rounding errors of a call to
+   *                       the next
+   */
+  compressedAllreduce(const cumlCommunicator &comm,
+                      std::shared_ptr<deviceAllocator> allocator, int count,
+                      cudaStream_t stream, bool error_feedback = true)
+    : _comm(comm),
+      _count(count),
+      _errorFeedback(error_feedback),
+      _residual(allocator, stream, error_feedback ? count : 0),
+      _compensated(allocator, stream, count),
+      _packed(allocator, stream, count),
+      _scale(allocator, stream, 1),
+      _workspace(allocator, stream) {
+    if (_errorFeedback) resetErrorFeedback(stream);
+    CompressedAbsOp<T> absOp;
+    cub::TransformInputIterator<T, CompressedAbsOp<T>, const T *> absIt(
+      _compensated.data(), absOp);
+    size_t bytes = 0;
+    CUDA_CHECK(cub::DeviceReduce::Max(nullptr, bytes, absIt, _scale.data(),
+                                      _count, stream));
+    _workspace.resize(bytes, stream);
+  }
+
+  /** forget the rounding errors carried so far */
+  void resetErrorFeedback(cudaStream_t stream) {
+    if (!_errorFeedback) return;
+    CUDA_CHECK(
+      cudaMemsetAsync(_residual.data(), 0, _count * sizeof(T), stream));
+  }
+
+  /**
+   * recvbuff = the sum of sendbuff over the ranks, up to the rounding to half
+   * (sendbuff and recvbuff may alias)
+   */
+  void allreduce(const T *sendbuff, T *recvbuff, cudaStream_t stream) {
+    compress(sendbuff, stream);
+    _comm.allreduce(_packed.data(), _packed.data(), _count,
+                    cumlCommunicator::HALF, cumlCommunicator::SUM, stream);
+    decompress(recvbuff, stream);
+  }
+
+  /**
+   * recvbuff = the sum of sendbuff over the ranks on root, recvbuff being
+   * left untouched on the other ranks
+   */
+  void reduce(const T *sendbuff, T *recvbuff, int root, cudaStream_t stream) {
+    compress(sendbuff, stream);
+    _comm.reduce(_packed.data(), _packed.data(), _count,
+                 cumlCommunicator::HALF, cumlCommunicator::SUM, root, stream);
+    if (_comm.getRank() == root) decompress(recvbuff, stream);
+  }
+
+ private:
+  static const int TPB = 256;
+
+  void compress(const T *sendbuff, cudaStream_t stream) {
+    if (_count <= 0) return;
+    int nblks = ceildiv(_count, TPB);
+    T *residual = _errorFeedback ? _residual.data() : nullptr;
+    compensateKernel<T, TPB><<<nblks, TPB, 0, stream>>>(
+      _compensated.data(), sendbuff, residual, _count);
+    CUDA_CHECK(cudaPeekAtLastError());
+    CompressedAbsOp<T> absOp;
+    cub::TransformInputIterator<T, CompressedAbsOp<T>, const T *> absIt(
+      _compensated.data(), absOp);
+    size_t bytes = _workspace.size();
+    CUDA_CHECK(cub::DeviceReduce::Max(_workspace.data(), bytes, absIt,
+                                      _scale.data(), _count, stream));
+    _comm.allreduce(_scale.data(), _scale.data(), 1, cumlCommunicator::MAX,
+                    stream);
+    compressionScaleKernel<T><<<1, 1, 0, stream>>>(_scale.data(),
+                                                   _comm.getSize());
+    CUDA_CHECK(cudaPeekAtLastError());
+    compressKernel<T, TPB><<<nblks, TPB, 0, stream>>>(
+      _packed.data(), residual, _compensated.data(), _scale.data(), _count);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+
+  void decompress(T *recvbuff, cudaStream_t stream) {
+    if (_count <= 0) return;
+    decompressKernel<T, TPB><<<ceildiv(_count, TPB), TPB, 0, stream>>>(
+      recvbuff, _packed.data(), _scale.data(), _count);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+
+  const cumlCommunicator &_comm;
+  int _count;
+  bool _errorFeedback;
+  device_buffer<T> _residual;
+  device_buffer<T> _compensated;
+  device_buffer<__half> _packed;
+  device_buffer<T> _scale;
+  device_buffer<char> _workspace;
+};
+
+};  // end namespace MLCommon
@@ -60,6 +60,12 @@ class cumlCommunicator_iface {
 
   virtual void waitall(int count, request_t array_of_requests[]) const = 0;
 
+  virtual void device_send(const void* buf, int size, int dest,
+                           cudaStream_t stream) const = 0;
+
+  virtual void device_recv(void* buf, int size, int source,
+                           cudaStream_t stream) const = 0;
+
   virtual void allreduce(const void* sendbuff, void* recvbuff, int count,
                          datatype_t datatype, op_t op,
                          cudaStream_t stream) const = 0;
@@ -81,6 +87,20 @@ class cumlCommunicator_iface {
   virtual void reducescatter(const void* sendbuff, void* recvbuff,
                              int recvcount, datatype_t datatype, op_t op,
                              cudaStream_t stream) const = 0;
+
+  virtual void alltoall(const void* sendbuff, void* recvbuff, int count,
+                        datatype_t datatype, cudaStream_t stream) const = 0;
+
+  virtual void alltoallv(const void* sendbuf, const int sendcounts[],
+                         const int sdispls[], void* recvbuf,
+                         const int recvcounts[], const int rdispls[],
+                         datatype_t datatype, cudaStream_t stream) const = 0;
+
+  virtual void groupStart() const = 0;
+
+  virtual void groupEnd() const = 0;
+
+  virtual status_t syncEvent(cudaEvent_t event) const = 0;
 };
 
 }  // namespace MLCommon
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <memory>
 
 #include <cuda_runtime.h>
@@ -40,7 +41,17 @@ class cumlCommunicator_iface;
 class cumlCommunicator {
  public:
   typedef unsigned int request_t;
-  enum datatype_t { CHAR, UINT8, INT, UINT, INT64, UINT64, FLOAT, DOUBLE };
+  enum datatype_t {
+    CHAR,
+    UINT8,
+    INT,
+    UINT,
+    INT64,
+    UINT64,
+    FLOAT,
+    DOUBLE,
+    HALF  // IEEE 754 half precision, only supported by the NCCL collectives
+  };
   enum op_t { SUM, PROD, MIN, MAX };
 
   static const int CUML_ANY_SOURCE = -1;
@@ -161,11 +172,54 @@ class cumlCommunicator {
      */
   void waitall(int count, request_t array_of_requests[]) const;
 
+  /**
+     * Stream-ordered send following the semantics of ncclSend: the message is sent once the work
+     * enqueued on stream before it is done, and the work enqueued after it waits for the send,
+     * without any progress to be made by the host, unlike isend.
+     *
+     * The matching device_recv must be issued by dest; several sends and receives between the
+     * same ranks, eg: an exchange, should be issued in a group (see groupStart).
+     *
+     * @param[in]   buf     address of GPU accessible send buffer
+     * @param[in]   size    size of the message to send in bytes
+     * @param[in]   dest    rank of destination
+     * @param[in]   stream  stream to submit this asynchronous (with respect to the CPU) operation to
+     */
+  void device_send(const void* buf, int size, int dest,
+                   cudaStream_t stream) const;
+
+  /**
+     * Stream-ordered receive following the semantics of ncclRecv, see device_send.
+     *
+     * @param[in]   buf     address of GPU accessible receive buffer
+     * @param[in]   size    size of the message to receive in bytes
+     * @param[in]   source  rank of source
+     * @param[in]   stream  stream to submit this asynchronous (with respect to the CPU) operation to
+     */
+  void device_recv(void* buf, int size, int source, cudaStream_t stream) const;
+
+  /**
+     * Convience wrapper around device_send deducing message size from sizeof(T).
+     */
+  template <typename T>
+  void device_send(const T* buf, int n, int dest, cudaStream_t stream) const {
+    device_send(static_cast<const void*>(buf), n * sizeof(T), dest, stream);
+  }
+
+  /**
+     * Convience wrapper around device_recv deducing message size from sizeof(T).
+     */
+  template <typename T>
+  void device_recv(T* buf, int n, int source, cudaStream_t stream) const {
+    device_recv(static_cast<void*>(buf), n * sizeof(T), source, stream);
+  }
+
   /**
      * Reduce data arrays of length count in sendbuff using op operation and leaves identical copies of the 
      * result on each recvbuff.
      *
      * Follows the semantics of ncclAllReduce. In-place operation will happen if sendbuff == recvbuff .
+     * Once enableHierarchicalAllreduce has been called, the small allreduces are hierarchical.
      *
      * @param[in]   sendbuff    address of GPU accessible send buffer
      * @param[in]   recvbuff    address of GPU accessible receive buffer (might alias with sendbuff)
@@ -177,6 +231,22 @@ class cumlCommunicator {
   void allreduce(const void* sendbuff, void* recvbuff, int count,
                  datatype_t datatype, op_t op, cudaStream_t stream) const;
 
+  /**
+     * Makes the allreduces of at most maxBytes bytes hierarchical: a reduce to the first rank of
+     * each node, over NVLink or PCIe, an allreduce across the nodes between those ranks only, and a
+     * broadcast within each node. For the small and frequent allreduces of the distributed fits,
+     * eg: KMeans centroids or histograms, this takes a few steps where a flat allreduce across
+     * many GPUs is bound by the latency of the network.
+     *
+     * Collective: all the ranks must call it, before issuing any other collective. The nodes are
+     * told apart by host name. Nothing changes when all the ranks are on one node or each on a node
+     * of its own. Requires comms supporting commSplit.
+     *
+     * @param[in]   maxBytes    size up to which the allreduces are hierarchical, 0 to disable
+     * @param[in]   stream      stream to exchange the host names on
+     */
+  void enableHierarchicalAllreduce(std::size_t maxBytes, cudaStream_t stream);
+
   /**
      * Convience wrapper around allreduce deducing datatype_t from T.
      */
@@ -325,8 +395,101 @@ class cumlCommunicator {
     reducescatter(sendbuff, recvbuff, recvcount, getDataType<T>(), op, stream);
   }
 
+  /**
+     * Sends count elements of sendbuff to each rank and receives count elements from each rank:
+     * block i of sendbuff goes to rank i, and block i of recvbuff comes from rank i.
+     *
+     * Follows the semantics of MPI_Alltoall.
+     *
+     * @param[in]   sendbuff    address of GPU accessible send buffer, of getSize()*count elements
+     * @param[in]   recvbuff    address of GPU accessible receive buffer, of getSize()*count elements
+     * @param[in]   count       number of elements sent to and received from each rank
+     * @param[in]   datatype    data type of sendbuff and recvbuff
+     * @param[in]   stream      stream to submit this asynchronous (with respect to the CPU) operation to
+     */
+  void alltoall(const void* sendbuff, void* recvbuff, int count,
+                datatype_t datatype, cudaStream_t stream) const;
+
+  /**
+     * Convience wrapper around alltoall deducing datatype_t from T.
+     */
+  template <typename T>
+  void alltoall(const T* sendbuff, T* recvbuff, int count,
+                cudaStream_t stream) const {
+    alltoall(sendbuff, recvbuff, count, getDataType<T>(), stream);
+  }
+
+  /**
+     * Sends a different amount of data to each rank and receives a different amount of data from
+     * each rank, eg: to shuffle the rows of a distributed matrix to the ranks owning them.
+     *
+     * Follows the semantics of MPI_Alltoallv. The counts must be consistent across the ranks:
+     * sendcounts[j] on rank i equals recvcounts[i] on rank j.
+     *
+     * @param[in]   sendbuf     address of GPU accessible send buffer
+     * @param[in]   sendcounts  array (of length group size), the number of elements sent to each rank
+     * @param[in]   sdispls     array (of length group size). Entry i specifies the displacement
+     *                          (relative to sendbuf) of the data sent to rank i.
+     * @param[in]   recvbuf     address of GPU accessible receive buffer (must not alias sendbuf)
+     * @param[in]   recvcounts  array (of length group size), the number of elements received from
+     *                          each rank
+     * @param[in]   rdispls     array (of length group size). Entry i specifies the displacement
+     *                          (relative to recvbuf) at which to place the incoming data from rank i.
+     * @param[in]   datatype    data type of sendbuf and recvbuf
+     * @param[in]   stream      stream to submit this asynchronous (with respect to the CPU) operation to
+     */
+  void alltoallv(const void* sendbuf, const int sendcounts[],
+                 const int sdispls[], void* recvbuf, const int recvcounts[],
+                 const int rdispls[], datatype_t datatype,
+                 cudaStream_t stream) const;
+
+  /**
+     * Convience wrapper around alltoallv deducing datatype_t from T.
+     */
+  template <typename T>
+  void alltoallv(const T* sendbuf, const int sendcounts[], const int sdispls[],
+                 T* recvbuf, const int recvcounts[], const int rdispls[],
+                 cudaStream_t stream) const {
+    alltoallv(sendbuf, sendcounts, sdispls, recvbuf, recvcounts, rdispls,
+              getDataType<T>(), stream);
+  }
+
+  /**
+     * Starts a group of collectives, following the semantics of ncclGroupStart: the collectives
+     * issued until groupEnd are only launched at groupEnd, together, eg: to allreduce several
+     * buffers at the cost of one launch. Groups may be nested.
+     *
+     * Note: the collectives of a group complete in any order; none of their results can be used
+     *       by a later collective of the same group.
+     */
+  void groupStart() const;
+
+  /**
+     * Ends a group of collectives started by groupStart, launching them if it is the outermost.
+     */
+  void groupEnd() const;
+
+  /**
+   * Waits for an event recorded on a stream after collectives, with the handling of asynchronous
+   * errors of syncStream.
+   *
+   * Together with cudaStreamWaitEvent this lets an algorithm overlap communication with
+   * computation: issue the collectives on a stream of their own, record an event after them,
+   * keep computing on another stream and make it, or the host with syncEvent, wait for the event
+   * only where the result is needed.
+   *
+   * @param[in] event  the event to wait for
+   * @return           resulting status of the synchronization, see syncStream
+   */
+  status_t syncEvent(cudaEvent_t event) const;
+
  private:
   std::unique_ptr<cumlCommunicator_iface> _impl;
+  /** ranks of the node of this rank, see enableHierarchicalAllreduce */
+  std::shared_ptr<cumlCommunicator> _intraNode;
+  /** ranks of the same rank within their nodes */
+  std::shared_ptr<cumlCommunicator> _interNode;
+  std::size_t _hierarchyMaxBytes;
 };
 
 }  // end namespace MLCommon
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "distance/cosine.h"
+#include "linalg/reduce.h"
+#include "stats/mean_center.h"
+
+namespace MLCommon {
+namespace Distance {
+
+/**
+ * @brief the expanded correlation distance matrix calculation, one minus the
+ *  Pearson correlation of the rows, as the cosine of the mean-centered rows
+ *  It computes the following equation: C = op(1 - cos(A - mean(A),
+ *  B - mean(B)))
+ * @tparam IType input data-type (for A and B matrices)
+ * @tparam AccType accumulation data-type
+ * @tparam OType output data-type (for C and D matrices)
+ * @tparam OutputTile_ output tile size for the thread block
+ * @tparam FinalLambda user-defined epilogue lamba
+ * @tparam Index_ Index type
+ * @param m number of rows of A and C/D
+ * @param n number of columns of B and C/D
+ * @param k number of cols of A and rows of B
+ * @param pA input matrix
+ * @param pB input matrix
+ * @param pD output matrix
+ * @param workspace temporary workspace needed for computations, holding the
+ *  row norms of cosineAlgo1 followed by the centered copies of A and B
+ * @param worksize number of bytes of the workspace
+ * @param fin_op the final gemm epilogue lambda
+ * @param stream cuda stream where to launch work
+ * @param isRowMajor whether the input and output matrices are row major
+ */
+template <typename InType, typename AccType, typename OutType,
+          typename OutputTile_, typename FinalLambda, typename Index_ = int>
+void correlationImpl(Index_ m, Index_ n, Index_ k, const InType *pA,
+                     const InType *pB, OutType *pD, AccType *workspace,
+                     size_t worksize, FinalLambda fin_op, cudaStream_t stream,
+                     bool isRowMajor) {
+  Index_ nVecs = pA != pB ? m + n : m;
+  if (worksize < nVecs * (sizeof(AccType) + k * sizeof(InType))) {
+    THROW("workspace size error");
+  }
+  if (workspace == nullptr) {
+    THROW("workspace is null");
+  }
+
+  // the row means are held where cosineAlgo1 puts the norms
+  AccType *means = workspace;
+  InType *centeredA = reinterpret_cast<InType *>(workspace + nVecs);
+  InType *centeredB = pA != pB ? centeredA + m * k : centeredA;
+  AccType invK = AccType(1) / AccType(k);
+  auto mean_op = [invK] __device__(AccType in) { return in * invK; };
+  LinAlg::reduce(means, pA, k, m, AccType(0), isRowMajor, true, stream, false,
+                 Nop<InType, Index_>(), Sum<AccType>(), mean_op);
+  Stats::meanCenter(centeredA, pA, means, k, m, isRowMajor, false, stream);
+  if (pA != pB) {
+    LinAlg::reduce(means + m, pB, k, n, AccType(0), isRowMajor, true, stream,
+                   false, Nop<InType, Index_>(), Sum<AccType>(), mean_op);
+    Stats::meanCenter(centeredB, pB, means + m, k, n, isRowMajor, false,
+                      stream);
+  }
+
+  auto correlation_op = [fin_op] __device__(AccType val, Index_ g_idx) {
+    return fin_op(AccType(1) - val, g_idx);
+  };
+  cosineAlgo1<InType, AccType, OutType, OutputTile_, decltype(correlation_op),
+              Index_>(m, n, k, centeredA, centeredB, pD, workspace,
+                      nVecs * sizeof(AccType), correlation_op, stream,
+                      isRowMajor);
+}
+
+};  // end namespace Distance
+};  // end namespace MLCommon
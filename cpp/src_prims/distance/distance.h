@@ -20,14 +20,59 @@
 #include <cutlass/shape.h>
 #include "common/device_buffer.hpp"
 #include "cuda_utils.h"
+#include "distance/chebyshev.h"
+#include "distance/correlation.h"
 #include "distance/cosine.h"
 #include "distance/euclidean.h"
+#include "distance/hamming.h"
+#include "distance/haversine.h"
+#include "distance/jaccard.h"
 #include "distance/l1.h"
+#include "distance/minkowski.h"
 
 namespace MLCommon {
 namespace Distance {
 
 typedef cutlass::Shape<8, 128, 128> OutputTile_8x128x128;
+typedef cutlass::Shape<8, 64, 128> OutputTile_8x64x128;
+typedef cutlass::Shape<8, 64, 64> OutputTile_8x64x64;
+
+/** enum of the output tiles to pick from at runtime, smallest first */
+enum OutputTileShape {
+  /** 2 warps per block */
+  Tile_8x64x64 = 0,
+  /** 4 warps per block */
+  Tile_8x64x128,
+  /** 8 warps per block, the default of the distance prims */
+  Tile_8x128x128,
+};
+
+/**
+ * @brief Pick the output tile of a distance computation from its size and the
+ * device: the largest tile which still puts at least two blocks on each SM, or
+ * the smallest one. Large outputs keep the reuse of the 128x128 tiles, while
+ * small ones, such as those of a few queries or centroids against many points
+ * with a large k, get enough blocks to fill the device.
+ * @tparam Index_ indexing type
+ * @param m number of points in x
+ * @param n number of points in y
+ * @return the output tile to run the distance with
+ */
+template <typename Index_>
+OutputTileShape chooseOutputTile(Index_ m, Index_ n) {
+  int dev, nSMs;
+  CUDA_CHECK(cudaGetDevice(&dev));
+  CUDA_CHECK(
+    cudaDeviceGetAttribute(&nSMs, cudaDevAttrMultiProcessorCount, dev));
+  size_t minBlocks = 2 * size_t(nSMs);
+  // the tiles are H x W over the n x m output of the gemm
+  auto nBlocks = [m, n](size_t h, size_t w) {
+    return ceildiv<size_t>(m, h) * ceildiv<size_t>(n, w);
+  };
+  if (nBlocks(128, 128) >= minBlocks) return Tile_8x128x128;
+  if (nBlocks(64, 128) >= minBlocks) return Tile_8x64x128;
+  return Tile_8x64x64;
+}
 
 /** enum to tell how to compute euclidean distance */
 enum DistanceType {
@@ -43,6 +88,18 @@ enum DistanceType {
   EucUnexpandedL2,
   /** same as above, but inside the epilogue, perform square root operation */
   EucUnexpandedL2Sqrt,
+  /** Chebyshev distance, dist_ij = max(|x_ik - y_jk|) */
+  EucUnexpandedLinf,
+  /** Minkowski distance, dist_ij = (sum(|x_ik - y_jk|^p))^(1/p) */
+  EucUnexpandedMinkowski,
+  /** Hamming distance, the fraction of the k coordinates that differ */
+  EucUnexpandedHamming,
+  /** Jaccard distance of binary inputs, 1 - |x_i & y_j| / |x_i | y_j| */
+  EucExpandedJaccard,
+  /** correlation distance, 1 - the Pearson correlation of x_i and y_j */
+  EucExpandedCorrelation,
+  /** haversine distance on the unit sphere between (lat, lon) in radians */
+  EucUnexpandedHaversine,
 };
 
 namespace {
@@ -52,7 +109,7 @@ template <DistanceType distanceType, typename InType, typename AccType,
 struct DistanceImpl {
   void run(const InType *x, const InType *y, OutType *dist, Index_ m, Index_ n,
            Index_ k, void *workspace, size_t worksize, FinalLambda fin_op,
-           cudaStream_t stream, bool isRowMajor) {}
+           cudaStream_t stream, bool isRowMajor, InType metric_arg) {}
 };
 
 template <typename InType, typename AccType, typename OutType,
@@ -61,7 +118,15 @@ struct DistanceImpl<EucExpandedL2, InType, AccType, OutType, OutputTile_,
                     FinalLambda, Index_> {
   void run(const InType *x, const InType *y, OutType *dist, Index_ m, Index_ n,
            Index_ k, void *workspace, size_t worksize, FinalLambda fin_op,
-           cudaStream_t stream, bool isRowMajor) {
+           cudaStream_t stream, bool isRowMajor, InType metric_arg) {
+    // without a workspace for the norms, the squared differences are summed
+    // in the main loop instead
+    if (workspace == nullptr) {
+      euclideanAlgo2<InType, AccType, OutType, OutputTile_, FinalLambda,
+                     Index_>(m, n, k, x, y, dist, false, fin_op, stream,
+                             isRowMajor);
+      return;
+    }
     euclideanAlgo1<InType, AccType, OutType, OutputTile_, FinalLambda, Index_>(
       m, n, k, x, y, dist, false, (AccType *)workspace, worksize, fin_op,
       stream, isRowMajor);
@@ -74,7 +139,15 @@ struct DistanceImpl<EucExpandedL2Sqrt, InType, AccType, OutType, OutputTile_,
                     FinalLambda, Index_> {
   void run(const InType *x, const InType *y, OutType *dist, Index_ m, Index_ n,
            Index_ k, void *workspace, size_t worksize, FinalLambda fin_op,
-           cudaStream_t stream, bool isRowMajor) {
+           cudaStream_t stream, bool isRowMajor, InType metric_arg) {
+    // without a workspace for the norms, the squared differences are summed
+    // in the main loop instead
+    if (workspace == nullptr) {
+      euclideanAlgo2<InType, AccType, OutType, OutputTile_, FinalLambda,
+                     Index_>(m, n, k, x, y, dist, true, fin_op, stream,
+                             isRowMajor);
+      return;
+    }
     euclideanAlgo1<InType, AccType, OutType, OutputTile_, FinalLambda, Index_>(
       m, n, k, x, y, dist, true, (AccType *)workspace, worksize, fin_op, stream,
       isRowMajor);
@@ -87,7 +160,7 @@ struct DistanceImpl<EucExpandedCosine, InType, AccType, OutType, OutputTile_,
                     FinalLambda, Index_> {
   void run(const InType *x, const InType *y, OutType *dist, Index_ m, Index_ n,
            Index_ k, void *workspace, size_t worksize, FinalLambda fin_op,
-           cudaStream_t stream, bool isRowMajor) {
+           cudaStream_t stream, bool isRowMajor, InType metric_arg) {
     cosineAlgo1<InType, AccType, OutType, OutputTile_, FinalLambda, Index_>(
       m, n, k, x, y, dist, (AccType *)workspace, worksize, fin_op, stream,
       isRowMajor);
@@ -100,7 +173,7 @@ struct DistanceImpl<EucUnexpandedL2, InType, AccType, OutType, OutputTile_,
                     FinalLambda, Index_> {
   void run(const InType *x, const InType *y, OutType *dist, Index_ m, Index_ n,
            Index_ k, void *workspace, size_t worksize, FinalLambda fin_op,
-           cudaStream_t stream, bool isRowMajor) {
+           cudaStream_t stream, bool isRowMajor, InType metric_arg) {
     euclideanAlgo2<InType, AccType, OutType, OutputTile_, FinalLambda, Index_>(
       m, n, k, x, y, dist, false, fin_op, stream, isRowMajor);
   }
@@ -112,7 +185,7 @@ struct DistanceImpl<EucUnexpandedL2Sqrt, InType, AccType, OutType, OutputTile_,
                     FinalLambda, Index_> {
   void run(const InType *x, const InType *y, OutType *dist, Index_ m, Index_ n,
            Index_ k, void *workspace, size_t worksize, FinalLambda fin_op,
-           cudaStream_t stream, bool isRowMajor) {
+           cudaStream_t stream, bool isRowMajor, InType metric_arg) {
     euclideanAlgo2<InType, AccType, OutType, OutputTile_, FinalLambda, Index_>(
       m, n, k, x, y, dist, true, fin_op, stream, isRowMajor);
   }
@@ -124,12 +197,86 @@ struct DistanceImpl<EucUnexpandedL1, InType, AccType, OutType, OutputTile_,
                     FinalLambda, Index_> {
   void run(const InType *x, const InType *y, OutType *dist, Index_ m, Index_ n,
            Index_ k, void *workspace, size_t worksize, FinalLambda fin_op,
-           cudaStream_t stream, bool isRowMajor) {
+           cudaStream_t stream, bool isRowMajor, InType metric_arg) {
     l1Impl<InType, AccType, OutType, OutputTile_, FinalLambda, Index_>(
       m, n, k, x, y, dist, fin_op, stream, isRowMajor);
   }
 };
 
+template <typename InType, typename AccType, typename OutType,
+          typename OutputTile_, typename FinalLambda, typename Index_>
+struct DistanceImpl<EucUnexpandedLinf, InType, AccType, OutType, OutputTile_,
+                    FinalLambda, Index_> {
+  void run(const InType *x, const InType *y, OutType *dist, Index_ m, Index_ n,
+           Index_ k, void *workspace, size_t worksize, FinalLambda fin_op,
+           cudaStream_t stream, bool isRowMajor, InType metric_arg) {
+    chebyshevImpl<InType, AccType, OutType, OutputTile_, FinalLambda, Index_>(
+      m, n, k, x, y, dist, fin_op, stream, isRowMajor);
+  }
+};
+
+template <typename InType, typename AccType, typename OutType,
+          typename OutputTile_, typename FinalLambda, typename Index_>
+struct DistanceImpl<EucUnexpandedMinkowski, InType, AccType, OutType,
+                    OutputTile_, FinalLambda, Index_> {
+  void run(const InType *x, const InType *y, OutType *dist, Index_ m, Index_ n,
+           Index_ k, void *workspace, size_t worksize, FinalLambda fin_op,
+           cudaStream_t stream, bool isRowMajor, InType metric_arg) {
+    minkowskiImpl<InType, AccType, OutType, FinalLambda, Index_>(
+      m, n, k, x, y, dist, AccType(metric_arg), fin_op, stream, isRowMajor);
+  }
+};
+
+template <typename InType, typename AccType, typename OutType,
+          typename OutputTile_, typename FinalLambda, typename Index_>
+struct DistanceImpl<EucUnexpandedHamming, InType, AccType, OutType, OutputTile_,
+                    FinalLambda, Index_> {
+  void run(const InType *x, const InType *y, OutType *dist, Index_ m, Index_ n,
+           Index_ k, void *workspace, size_t worksize, FinalLambda fin_op,
+           cudaStream_t stream, bool isRowMajor, InType metric_arg) {
+    hammingImpl<InType, AccType, OutType, OutputTile_, FinalLambda, Index_>(
+      m, n, k, x, y, dist, fin_op, stream, isRowMajor);
+  }
+};
+
+template <typename InType, typename AccType, typename OutType,
+          typename OutputTile_, typename FinalLambda, typename Index_>
+struct DistanceImpl<EucExpandedJaccard, InType, AccType, OutType, OutputTile_,
+                    FinalLambda, Index_> {
+  void run(const InType *x, const InType *y, OutType *dist, Index_ m, Index_ n,
+           Index_ k, void *workspace, size_t worksize, FinalLambda fin_op,
+           cudaStream_t stream, bool isRowMajor, InType metric_arg) {
+    jaccardAlgo1<InType, AccType, OutType, OutputTile_, FinalLambda, Index_>(
+      m, n, k, x, y, dist, (AccType *)workspace, worksize, fin_op, stream,
+      isRowMajor);
+  }
+};
+
+template <typename InType, typename AccType, typename OutType,
+          typename OutputTile_, typename FinalLambda, typename Index_>
+struct DistanceImpl<EucExpandedCorrelation, InType, AccType, OutType,
+                    OutputTile_, FinalLambda, Index_> {
+  void run(const InType *x, const InType *y, OutType *dist, Index_ m, Index_ n,
+           Index_ k, void *workspace, size_t worksize, FinalLambda fin_op,
+           cudaStream_t stream, bool isRowMajor, InType metric_arg) {
+    correlationImpl<InType, AccType, OutType, OutputTile_, FinalLambda,
+                    Index_>(m, n, k, x, y, dist, (AccType *)workspace,
+                            worksize, fin_op, stream, isRowMajor);
+  }
+};
+
+template <typename InType, typename AccType, typename OutType,
+          typename OutputTile_, typename FinalLambda, typename Index_>
+struct DistanceImpl<EucUnexpandedHaversine, InType, AccType, OutType,
+                    OutputTile_, FinalLambda, Index_> {
+  void run(const InType *x, const InType *y, OutType *dist, Index_ m, Index_ n,
+           Index_ k, void *workspace, size_t worksize, FinalLambda fin_op,
+           cudaStream_t stream, bool isRowMajor, InType metric_arg) {
+    haversineImpl<InType, AccType, OutType, FinalLambda, Index_>(
+      m, n, k, x, y, dist, fin_op, stream, isRowMajor);
+  }
+};
+
 }  // anonymous namespace
 
 /**
@@ -153,11 +300,18 @@ template <DistanceType distanceType, typename InType, typename AccType,
 size_t getWorkspaceSize(const InType *x, const InType *y, Index_ m, Index_ n,
                         Index_ k) {
   size_t worksize = 0;
-  constexpr bool is_allocated = distanceType <= EucExpandedCosine;
+  constexpr bool is_allocated = distanceType <= EucExpandedCosine ||
+                                distanceType == EucExpandedJaccard ||
+                                distanceType == EucExpandedCorrelation;
   if (is_allocated) {
     worksize += m * sizeof(AccType);
     if (x != y) worksize += n * sizeof(AccType);
   }
+  // the correlation also centers copies of the inputs
+  if (distanceType == EucExpandedCorrelation) {
+    worksize += m * k * sizeof(InType);
+    if (x != y) worksize += n * k * sizeof(InType);
+  }
   return worksize;
 }
 
@@ -178,32 +332,39 @@ size_t getWorkspaceSize(const InType *x, const InType *y, Index_ m, Index_ n,
  * @tparam Index_ Index type
  * @param x first set of points
  * @param y second set of points
- * @param dist output distance matrix
+ * @param dist output distance matrix, or nullptr for none to be stored
  * @param m number of points in x
  * @param n number of points in y
  * @param k dimensionality
- * @param workspace temporary workspace needed for computations
+ * @param workspace temporary workspace needed for computations; the L2
+ * distances can be given nullptr, to be evaluated in their unexpanded form
  * @param worksize number of bytes of the workspace
  * @param fin_op the final gemm epilogue lambda
  * @param stream cuda stream
  * @param isRowMajor whether the matrices are row-major or col-major
+ * @param metric_arg the parameter of the distance, if any: the order p of
+ * EucUnexpandedMinkowski
  *
  * @note fin_op: This is a device lambda which is supposed to operate upon the
  * input which is AccType and returns the output in OutType. It's signature is
  * as follows:  <pre>OutType fin_op(AccType in, int g_idx);</pre>. If one needs
- * any other parameters, feel free to pass them via closure.
+ * any other parameters, feel free to pass them via closure. With a null dist,
+ * the values it returns are dropped, so that a fin_op reducing the distances
+ * through its closure never writes the m x n matrix (see
+ * distance_reduction.h).
  */
 template <DistanceType distanceType, typename InType, typename AccType,
           typename OutType, typename OutputTile_, typename FinalLambda,
           typename Index_ = int>
 void distance(const InType *x, const InType *y, OutType *dist, Index_ m,
               Index_ n, Index_ k, void *workspace, size_t worksize,
-              FinalLambda fin_op, cudaStream_t stream, bool isRowMajor = true) {
+              FinalLambda fin_op, cudaStream_t stream, bool isRowMajor = true,
+              InType metric_arg = 2) {
   DistanceImpl<distanceType, InType, AccType, OutType, OutputTile_, FinalLambda,
                Index_>
     distImpl;
   distImpl.run(x, y, dist, m, n, k, workspace, worksize, fin_op, stream,
-               isRowMajor);
+               isRowMajor, metric_arg);
   CUDA_CHECK(cudaPeekAtLastError());
 }
 
@@ -224,6 +385,8 @@ void distance(const InType *x, const InType *y, OutType *dist, Index_ m,
  * @param worksize number of bytes of the workspace
  * @param stream cuda stream
  * @param isRowMajor whether the matrices are row-major or col-major
+ * @param metric_arg the parameter of the distance, if any: the order p of
+ * EucUnexpandedMinkowski
  *
  * @note if workspace is passed as nullptr, this will return in
  *  worksize, the number of bytes of workspace required
@@ -232,17 +395,65 @@ template <DistanceType distanceType, typename InType, typename AccType,
           typename OutType, typename OutputTile_, typename Index_ = int>
 void distance(const InType *x, const InType *y, OutType *dist, Index_ m,
               Index_ n, Index_ k, void *workspace, size_t worksize,
-              cudaStream_t stream, bool isRowMajor = true) {
+              cudaStream_t stream, bool isRowMajor = true,
+              InType metric_arg = 2) {
   auto default_fin_op = [] __device__(AccType d_val, Index_ g_d_idx) {
     return d_val;
   };
   distance<distanceType, InType, AccType, OutType, OutputTile_,
            decltype(default_fin_op), Index_>(x, y, dist, m, n, k, workspace,
                                              worksize, default_fin_op, stream,
-                                             isRowMajor);
+                                             isRowMajor, metric_arg);
   CUDA_CHECK(cudaPeekAtLastError());
 }
 
+/**
+ * @brief Evaluate pairwise distances as distance() does, with the output tile
+ * picked by chooseOutputTile
+ * @tparam DistanceType which distance to evaluate
+ * @tparam InType input argument type
+ * @tparam AccType accumulation type
+ * @tparam OutType output type
+ * @tparam FinalLambda user-defined epilogue lamba
+ * @tparam Index_ Index type
+ * @param x first set of points
+ * @param y second set of points
+ * @param dist output distance matrix, or nullptr for none to be stored
+ * @param m number of points in x
+ * @param n number of points in y
+ * @param k dimensionality
+ * @param workspace temporary workspace needed for computations, which can be
+ * nullptr for the L2 distances
+ * @param worksize number of bytes of the workspace
+ * @param fin_op the final gemm epilogue lambda
+ * @param stream cuda stream
+ * @param isRowMajor whether the matrices are row-major or col-major
+ * @param metric_arg the parameter of the distance, if any
+ */
+template <DistanceType distanceType, typename InType, typename AccType,
+          typename OutType, typename FinalLambda, typename Index_ = int>
+void distanceAutoTile(const InType *x, const InType *y, OutType *dist,
+                      Index_ m, Index_ n, Index_ k, void *workspace,
+                      size_t worksize, FinalLambda fin_op, cudaStream_t stream,
+                      bool isRowMajor = true, InType metric_arg = 2) {
+  switch (chooseOutputTile(m, n)) {
+    case Tile_8x64x64:
+      distance<distanceType, InType, AccType, OutType, OutputTile_8x64x64,
+               FinalLambda, Index_>(x, y, dist, m, n, k, workspace, worksize,
+                                    fin_op, stream, isRowMajor, metric_arg);
+      break;
+    case Tile_8x64x128:
+      distance<distanceType, InType, AccType, OutType, OutputTile_8x64x128,
+               FinalLambda, Index_>(x, y, dist, m, n, k, workspace, worksize,
+                                    fin_op, stream, isRowMajor, metric_arg);
+      break;
+    default:
+      distance<distanceType, InType, AccType, OutType, OutputTile_8x128x128,
+               FinalLambda, Index_>(x, y, dist, m, n, k, workspace, worksize,
+                                    fin_op, stream, isRowMajor, metric_arg);
+  }
+}
+
 #if CUDART_VERSION >= 10010
 // Undo special optimization options set earlier
 #pragma GCC reset_options
@@ -266,47 +477,75 @@ void distance(const InType *x, const InType *y, OutType *dist, Index_ m,
  * @param metric distance metric
  * @param stream cuda stream
  * @param isRowMajor whether the matrices are row-major or col-major
+ * @param metric_arg the parameter of the distance metric, if any
  */
 template <typename Type, typename Index_, DistanceType DistType>
 void pairwiseDistanceImpl(const Type *x, const Type *y, Type *dist, Index_ m,
                           Index_ n, Index_ k, device_buffer<char> &workspace,
-                          cudaStream_t stream, bool isRowMajor) {
+                          cudaStream_t stream, bool isRowMajor,
+                          Type metric_arg) {
   auto worksize =
     getWorkspaceSize<DistType, Type, Type, Type, Index_>(x, y, m, n, k);
   workspace.resize(worksize, stream);
-  distance<DistType, Type, Type, Type, OutputTile_8x128x128, Index_>(
-    x, y, dist, m, n, k, workspace.data(), worksize, stream, isRowMajor);
+  auto fin_op = [] __device__(Type d_val, Index_ g_d_idx) { return d_val; };
+  distanceAutoTile<DistType, Type, Type, Type, decltype(fin_op), Index_>(
+    x, y, dist, m, n, k, workspace.data(), worksize, fin_op, stream,
+    isRowMajor, metric_arg);
 }
 
 template <typename Type, typename Index_ = int>
 void pairwiseDistance(const Type *x, const Type *y, Type *dist, Index_ m,
                       Index_ n, Index_ k, device_buffer<char> &workspace,
                       DistanceType metric, cudaStream_t stream,
-                      bool isRowMajor = true) {
+                      bool isRowMajor = true, Type metric_arg = 2) {
   switch (metric) {
     case DistanceType::EucExpandedL2:
       pairwiseDistanceImpl<Type, Index_, DistanceType::EucExpandedL2>(
-        x, y, dist, m, n, k, workspace, stream, isRowMajor);
+        x, y, dist, m, n, k, workspace, stream, isRowMajor, metric_arg);
       break;
     case DistanceType::EucExpandedL2Sqrt:
       pairwiseDistanceImpl<Type, Index_, DistanceType::EucExpandedL2Sqrt>(
-        x, y, dist, m, n, k, workspace, stream, isRowMajor);
+        x, y, dist, m, n, k, workspace, stream, isRowMajor, metric_arg);
       break;
     case DistanceType::EucExpandedCosine:
       pairwiseDistanceImpl<Type, Index_, DistanceType::EucExpandedCosine>(
-        x, y, dist, m, n, k, workspace, stream, isRowMajor);
+        x, y, dist, m, n, k, workspace, stream, isRowMajor, metric_arg);
       break;
     case DistanceType::EucUnexpandedL1:
       pairwiseDistanceImpl<Type, Index_, DistanceType::EucUnexpandedL1>(
-        x, y, dist, m, n, k, workspace, stream, isRowMajor);
+        x, y, dist, m, n, k, workspace, stream, isRowMajor, metric_arg);
       break;
     case DistanceType::EucUnexpandedL2:
       pairwiseDistanceImpl<Type, Index_, DistanceType::EucUnexpandedL2>(
-        x, y, dist, m, n, k, workspace, stream, isRowMajor);
+        x, y, dist, m, n, k, workspace, stream, isRowMajor, metric_arg);
       break;
     case DistanceType::EucUnexpandedL2Sqrt:
       pairwiseDistanceImpl<Type, Index_, DistanceType::EucUnexpandedL2Sqrt>(
-        x, y, dist, m, n, k, workspace, stream, isRowMajor);
+        x, y, dist, m, n, k, workspace, stream, isRowMajor, metric_arg);
+      break;
+    case DistanceType::EucUnexpandedLinf:
+      pairwiseDistanceImpl<Type, Index_, DistanceType::EucUnexpandedLinf>(
+        x, y, dist, m, n, k, workspace, stream, isRowMajor, metric_arg);
+      break;
+    case DistanceType::EucUnexpandedMinkowski:
+      pairwiseDistanceImpl<Type, Index_, DistanceType::EucUnexpandedMinkowski>(
+        x, y, dist, m, n, k, workspace, stream, isRowMajor, metric_arg);
+      break;
+    case DistanceType::EucUnexpandedHamming:
+      pairwiseDistanceImpl<Type, Index_, DistanceType::EucUnexpandedHamming>(
+        x, y, dist, m, n, k, workspace, stream, isRowMajor, metric_arg);
+      break;
+    case DistanceType::EucExpandedJaccard:
+      pairwiseDistanceImpl<Type, Index_, DistanceType::EucExpandedJaccard>(
+        x, y, dist, m, n, k, workspace, stream, isRowMajor, metric_arg);
+      break;
+    case DistanceType::EucExpandedCorrelation:
+      pairwiseDistanceImpl<Type, Index_, DistanceType::EucExpandedCorrelation>(
+        x, y, dist, m, n, k, workspace, stream, isRowMajor, metric_arg);
+      break;
+    case DistanceType::EucUnexpandedHaversine:
+      pairwiseDistanceImpl<Type, Index_, DistanceType::EucUnexpandedHaversine>(
+        x, y, dist, m, n, k, workspace, stream, isRowMajor, metric_arg);
       break;
     default:
       THROW("Unknown distance metric '%d'!", metric);
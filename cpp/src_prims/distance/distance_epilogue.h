@@ -63,6 +63,26 @@ CUTLASS_HOST_DEVICE void extract_index_from_iterator(
   iterator.params.predicate_offset = current_pred_offset;
 }
 
+/** advances the iterator past a fragment as iterator_store would, storing
+ * nothing */
+template <typename OutputIterator>
+CUTLASS_HOST_DEVICE void skip_iterator_store(OutputIterator &iterator) {
+  for (int d = 0; d < OutputIterator::Iterations::kD; ++d) {
+    for (int h = 0; h < OutputIterator::Iterations::kH; ++h) {
+      for (int w = 0; w < OutputIterator::Iterations::kW - 1; ++w) {
+        iterator.inc_w();
+      }
+      if (h < OutputIterator::Iterations::kH - 1) {
+        iterator.inc_h();
+      }
+    }
+    if (d < OutputIterator::Iterations::kD - 1) {
+      iterator.inc_d();
+    }
+  }
+  iterator.inc_advance();
+}
+
 }  // end anonymous namespace
 
 /**
@@ -308,8 +328,13 @@ struct ExpandedDistanceGemmEpilogue : public BaseClass {
         typename GlobalTransformerD::OutputFragment transformed_d;
         transformer_d.transform(fragment_d, transformed_d);
 
-        // Copy the results to global memory.
-        iterator_store(global_store_iterator, transformed_d);
+        // Copy the results to global memory, unless fin_op reduces them and
+        // there is no output matrix.
+        if (global_base_ptr != nullptr) {
+          iterator_store(global_store_iterator, transformed_d);
+        } else {
+          skip_iterator_store(global_store_iterator);
+        }
       }
     }
   }
@@ -435,8 +460,13 @@ struct UnexpandedDistanceGemmEpilogue : public BaseClass {
         typename GlobalTransformerD::OutputFragment transformed_d;
         transformer_d.transform(fragment_d, transformed_d);
 
-        // Copy the results to global memory.
-        iterator_store(global_store_iterator, transformed_d);
+        // Copy the results to global memory, unless fin_op reduces them and
+        // there is no output matrix.
+        if (global_base_ptr != nullptr) {
+          iterator_store(global_store_iterator, transformed_d);
+        } else {
+          skip_iterator_store(global_store_iterator);
+        }
       }
     }
   }
@@ -83,6 +83,21 @@ struct CosFusedDistance {
   }
 };
 
+struct JaccardFusedDistance {
+  /// Ctor.
+  CUTLASS_DEVICE JaccardFusedDistance() {}
+
+  template <bool enable_sqrt_, typename CdElement_, typename ColElement_,
+            typename RowElement_>
+  CUTLASS_DEVICE void fused_distance(CdElement_ &accum,
+                                     ColElement_ const &col_elem,
+                                     RowElement_ const &row_elem) {
+    // the union of two empty sets is empty, and so is their distance
+    CdElement_ uni = col_elem + row_elem - accum;
+    accum = uni > CdElement_(0) ? CdElement_(1) - accum / uni : CdElement_(0);
+  }
+};
+
 /**
  * @brief Fragment-level epilogue function called by UnexpandedEpilogueFunctor,
  *  which calls the user lambda
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cublas_v2.h>
+#include <cuda_fp16.h>
+#include <algorithm>
+#include <cuml/common/cuml_allocator.hpp>
+#include <type_traits>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "distance/distance.h"
+#include "linalg/cublas_wrappers.h"
+#include "linalg/norm.h"
+
+namespace MLCommon {
+namespace Distance {
+
+/**
+ * @defgroup DistanceMixedPrecision
+ * @{
+ * @brief The expanded distances between x (m x k) and y (n x k), both row
+ * major, with the x.y^T gemm run on the tensor cores in reduced precision and
+ * accumulated in single precision. The norms and the epilogue stay in single
+ * precision, so only the products are rounded.
+ */
+
+/** enum to tell in which precision to run the gemm of the expanded distances */
+enum GemmPrecision {
+  /** the single precision SIMT gemm of distance() */
+  GemmFp32 = 0,
+  /** products of inputs rounded to half, for Volta and later */
+  GemmFp16,
+  /** products of inputs rounded to bfloat16, for Ampere and CUDA 11 */
+  GemmBf16,
+  /** products of inputs rounded to tf32, for Ampere and CUDA 11 */
+  GemmTf32,
+};
+
+template <typename LowT>
+struct ToLowPrecisionOp;
+
+template <>
+struct ToLowPrecisionOp<__half> {
+  DI __half operator()(float x) const { return __float2half(x); }
+};
+
+#if CUDART_VERSION >= 11000
+template <>
+struct ToLowPrecisionOp<__nv_bfloat16> {
+  DI __nv_bfloat16 operator()(float x) const { return __float2bfloat16(x); }
+};
+#endif
+
+template <typename LowT, typename Index_, int TPB>
+__global__ void toLowPrecisionKernel(LowT *out, const float *in, Index_ len) {
+  ToLowPrecisionOp<LowT> op;
+  for (Index_ i = threadIdx.x + (Index_)blockIdx.x * TPB; i < len;
+       i += (Index_)gridDim.x * TPB) {
+    out[i] = op(in[i]);
+  }
+}
+
+template <DistanceType distanceType, typename OutType, typename FinalLambda,
+          typename Index_, int TPB>
+__global__ void mixedPrecisionEpilogueKernel(OutType *dist, const float *dots,
+                                             const float *xNorms,
+                                             const float *yNorms, Index_ m,
+                                             Index_ n, FinalLambda fin_op) {
+  Index_ len = m * n;
+  for (Index_ idx = threadIdx.x + (Index_)blockIdx.x * TPB; idx < len;
+       idx += (Index_)gridDim.x * TPB) {
+    Index_ i = idx / n;
+    Index_ j = idx - i * n;
+    float val;
+    if (distanceType == EucExpandedCosine) {
+      val = dots[idx] / (xNorms[i] * yNorms[j]);
+    } else {
+      // the rounded products can take the nearest distances below zero
+      val = myMax(xNorms[i] + yNorms[j] - 2.f * dots[idx], 0.f);
+      if (distanceType == EucExpandedL2Sqrt) val = mySqrt(val);
+    }
+    OutType out = fin_op(val, idx);
+    if (dist != nullptr) dist[idx] = out;
+  }
+}
+
+template <typename LowT, typename Index_>
+void toLowPrecision(LowT *out, const float *in, Index_ len,
+                    cudaStream_t stream) {
+  constexpr int TPB = 256;
+  int nblks = std::min<Index_>(ceildiv<Index_>(len, TPB), 65535);
+  toLowPrecisionKernel<LowT, Index_, TPB>
+    <<<nblks, TPB, 0, stream>>>(out, in, len);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Evaluate the expanded pairwise distances with the gemm run in the
+ * given precision
+ * @tparam distanceType one of EucExpandedL2, EucExpandedL2Sqrt and
+ * EucExpandedCosine, the latter being the cosine similarity as in distance()
+ * @tparam OutType output type
+ * @tparam FinalLambda user-defined epilogue lambda, as in distance()
+ * @tparam Index_ indexing type
+ * @param x first set of points (m x k)
+ * @param y second set of points (n x k)
+ * @param dist output distance matrix (m x n), or nullptr for none to be stored
+ * @param m number of points in x
+ * @param n number of points in y
+ * @param k dimensionality
+ * @param precision precision of the gemm; the tensor core kernels of cublas
+ * are used for all but GemmFp32, which is the same as distance()
+ * @param fin_op the final epilogue lambda, of signature
+ * <pre>OutType fin_op(float in, Index_ g_idx);</pre>
+ * @param cublasHandle cublas handle
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ *
+ * @note The squared L2 distances are clamped at zero before the square root,
+ * as the rounding of the products can make them slightly negative. The
+ * reduced precision gemm needs k to be a multiple of 8 to run on the tensor
+ * cores; otherwise cublas falls back to its regular kernels.
+ */
+template <DistanceType distanceType, typename OutType, typename FinalLambda,
+          typename Index_ = int>
+void mixedPrecisionDistance(const float *x, const float *y, OutType *dist,
+                            Index_ m, Index_ n, Index_ k,
+                            GemmPrecision precision, FinalLambda fin_op,
+                            cublasHandle_t cublasHandle,
+                            std::shared_ptr<deviceAllocator> allocator,
+                            cudaStream_t stream) {
+  static_assert(distanceType == EucExpandedL2 ||
+                  distanceType == EucExpandedL2Sqrt ||
+                  distanceType == EucExpandedCosine,
+                "mixedPrecisionDistance: only the expanded distances are a "
+                "gemm");
+  if (precision == GemmFp32) {
+    size_t worksize =
+      getWorkspaceSize<distanceType, float, float, OutType, Index_>(x, y, m, n,
+                                                                    k);
+    device_buffer<char> workspace(allocator, stream, worksize);
+    distance<distanceType, float, float, OutType, OutputTile_8x128x128,
+             FinalLambda, Index_>(x, y, dist, m, n, k, workspace.data(),
+                                  worksize, fin_op, stream);
+    return;
+  }
+#if CUDART_VERSION < 11000
+  ASSERT(precision == GemmFp16,
+         "mixedPrecisionDistance: bfloat16 and tf32 need CUDA 11");
+#endif
+
+  constexpr int TPB = 256;
+  device_buffer<float> xNorms(allocator, stream, m);
+  device_buffer<float> yNorms(allocator, stream, n);
+  if (distanceType == EucExpandedCosine) {
+    auto norm_op = [] __device__(float in) { return mySqrt(in); };
+    LinAlg::rowNorm(xNorms.data(), x, k, m, LinAlg::L2Norm, true, stream,
+                    norm_op);
+    LinAlg::rowNorm(yNorms.data(), y, k, n, LinAlg::L2Norm, true, stream,
+                    norm_op);
+  } else {
+    LinAlg::rowNorm(xNorms.data(), x, k, m, LinAlg::L2Norm, true, stream);
+    LinAlg::rowNorm(yNorms.data(), y, k, n, LinAlg::L2Norm, true, stream);
+  }
+
+  // the dot products go straight to dist when it can hold them
+  bool inPlace = std::is_same<OutType, float>::value && dist != nullptr;
+  device_buffer<float> dotsBuffer(allocator, stream, inPlace ? 0 : m * n);
+  float *dots = inPlace ? (float *)dist : dotsBuffer.data();
+
+  // row-major dots[m x n] is the column-major product y * x^T
+  float alpha = 1.f, beta = 0.f;
+  if (precision == GemmFp16) {
+    device_buffer<__half> xLow(allocator, stream, m * k);
+    device_buffer<__half> yLow(allocator, stream, n * k);
+    toLowPrecision(xLow.data(), x, m * k, stream);
+    toLowPrecision(yLow.data(), y, n * k, stream);
+    CUBLAS_CHECK(LinAlg::cublasgemm(cublasHandle, CUBLAS_OP_T, CUBLAS_OP_N, n,
+                                    m, k, &alpha, yLow.data(), k, xLow.data(),
+                                    k, &beta, dots, n, stream));
+  }
+#if CUDART_VERSION >= 11000
+  else if (precision == GemmBf16) {
+    device_buffer<__nv_bfloat16> xLow(allocator, stream, m * k);
+    device_buffer<__nv_bfloat16> yLow(allocator, stream, n * k);
+    toLowPrecision(xLow.data(), x, m * k, stream);
+    toLowPrecision(yLow.data(), y, n * k, stream);
+    CUBLAS_CHECK(LinAlg::cublasgemm(cublasHandle, CUBLAS_OP_T, CUBLAS_OP_N, n,
+                                    m, k, &alpha, yLow.data(), k, xLow.data(),
+                                    k, &beta, dots, n, stream));
+  } else {
+    CUBLAS_CHECK(LinAlg::cublasgemmTf32(cublasHandle, CUBLAS_OP_T,
+                                        CUBLAS_OP_N, n, m, k, &alpha, y, k, x,
+                                        k, &beta, dots, n, stream));
+  }
+#endif
+
+  int nblks = std::min<Index_>(ceildiv<Index_>(m * n, TPB), 65535);
+  mixedPrecisionEpilogueKernel<distanceType, OutType, FinalLambda, Index_, TPB>
+    <<<nblks, TPB, 0, stream>>>(dist, dots, xNorms.data(), yNorms.data(), m, n,
+                                fin_op);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Evaluate the expanded pairwise distances with the gemm run in the
+ * given precision, for the simple use case
+ * @tparam distanceType one of EucExpandedL2, EucExpandedL2Sqrt and
+ * EucExpandedCosine
+ * @tparam Index_ indexing type
+ * @param x first set of points (m x k)
+ * @param y second set of points (n x k)
+ * @param dist output distance matrix (m x n)
+ * @param m number of points in x
+ * @param n number of points in y
+ * @param k dimensionality
+ * @param precision precision of the gemm
+ * @param cublasHandle cublas handle
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ */
+template <DistanceType distanceType, typename Index_ = int>
+void mixedPrecisionDistance(const float *x, const float *y, float *dist,
+                            Index_ m, Index_ n, Index_ k,
+                            GemmPrecision precision,
+                            cublasHandle_t cublasHandle,
+                            std::shared_ptr<deviceAllocator> allocator,
+                            cudaStream_t stream) {
+  auto default_fin_op = [] __device__(float d_val, Index_ g_d_idx) {
+    return d_val;
+  };
+  mixedPrecisionDistance<distanceType, float, decltype(default_fin_op),
+                         Index_>(x, y, dist, m, n, k, precision,
+                                 default_fin_op, cublasHandle, allocator,
+                                 stream);
+}
+/** @} */
+
+};  // end namespace Distance
+};  // end namespace MLCommon
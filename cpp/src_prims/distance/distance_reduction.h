@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cub/cub.cuh>
+#include <cuml/common/cuml_allocator.hpp>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "distance/distance.h"
+
+namespace MLCommon {
+namespace Distance {
+
+/**
+ * @defgroup DistanceReduction
+ * @{
+ * @brief Row-wise reductions of the pairwise distances between x (m x k) and
+ * y (n x k), both row major, fused into the epilogue of the distance gemm: the
+ * fin_op accumulates each distance into the outputs with atomics and no m x n
+ * matrix is ever written. The gemm indexes the distances with Index_, so m * n
+ * must fit in it.
+ */
+
+/** maps a float to an unsigned key of the same order */
+DI uint32_t orderedKey(float val) {
+  uint32_t bits = __float_as_uint(val);
+  return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+/** maps a double to an unsigned key of the same order */
+DI unsigned long long orderedKey(double val) {
+  unsigned long long bits = __double_as_longlong(val);
+  return (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull;
+}
+
+/** inverse of orderedKey */
+DI float orderedKeyToValue(uint32_t key) {
+  return __uint_as_float((key & 0x80000000u) ? key & 0x7fffffffu : ~key);
+}
+
+/** inverse of orderedKey */
+DI double orderedKeyToValue(unsigned long long key) {
+  return __longlong_as_double((key & 0x8000000000000000ull)
+                                ? key & 0x7fffffffffffffffull
+                                : ~key);
+}
+
+template <typename KeyT, typename Index_>
+__global__ void minAndArgMinInitKernel(unsigned long long *argminKeys,
+                                       KeyT *minKeys, Index_ m) {
+  Index_ i = threadIdx.x + blockIdx.x * blockDim.x;
+  if (i < m) {
+    argminKeys[i] = ~0ull;
+    minKeys[i] = ~KeyT(0);
+  }
+}
+
+template <typename KeyT, typename DataT, typename Index_>
+__global__ void minAndArgMinDecodeKernel(
+  const unsigned long long *argminKeys, const KeyT *minKeys, Index_ m,
+  cub::KeyValuePair<Index_, DataT> *out) {
+  Index_ i = threadIdx.x + blockIdx.x * blockDim.x;
+  if (i < m) {
+    out[i].key = Index_(argminKeys[i] & 0xffffffffull);
+    out[i].value = orderedKeyToValue(minKeys[i]);
+  }
+}
+
+/**
+ * @brief the distance from each row of x to its closest row of y, and the
+ * index of that row, as in the kmeans minClusterAndDistance or a 1-NN search
+ *
+ * The minimum is exact; the argmin ranks the distances rounded to float, ties
+ * going to the lowest index, so that it fits in a single 64-bit atomicMin
+ * with the index. In double, it may point to a row whose distance is within
+ * float rounding of the minimum.
+ *
+ * @tparam distanceType which distance to evaluate
+ * @tparam DataT input, accumulation and output type
+ * @tparam Index_ indexing type
+ * @param x first set of points (m x k)
+ * @param y second set of points (n x k)
+ * @param m number of points in x
+ * @param n number of points in y
+ * @param k dimensionality
+ * @param minAndArgMin output index (key) and distance (value) of the closest
+ * row of y to each row of x (m)
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ */
+template <DistanceType distanceType, typename DataT, typename Index_ = int,
+          typename OutputTile_ = OutputTile_8x128x128>
+void minAndArgMinDistance(const DataT *x, const DataT *y, Index_ m, Index_ n,
+                          Index_ k,
+                          cub::KeyValuePair<Index_, DataT> *minAndArgMin,
+                          std::shared_ptr<deviceAllocator> allocator,
+                          cudaStream_t stream) {
+  typedef decltype(orderedKey(DataT(0))) KeyT;
+  constexpr int TPB = 256;
+  device_buffer<unsigned long long> argminKeys(allocator, stream, m);
+  device_buffer<KeyT> minKeys(allocator, stream, m);
+  minAndArgMinInitKernel<KeyT, Index_>
+    <<<ceildiv<Index_>(m, TPB), TPB, 0, stream>>>(argminKeys.data(),
+                                                    minKeys.data(), m);
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  unsigned long long *pArgmin = argminKeys.data();
+  KeyT *pMin = minKeys.data();
+  auto reduce_op = [=] __device__(DataT val, Index_ g_idx) {
+    Index_ row = g_idx / n;
+    unsigned long long key =
+      ((unsigned long long)orderedKey(float(val)) << 32) |
+      (unsigned long long)(g_idx - row * n);
+    // most distances are no closer than the running minimum of their row
+    if (key < pArgmin[row]) atomicMin(pArgmin + row, key);
+    KeyT minKey = orderedKey(val);
+    if (minKey < pMin[row]) atomicMin(pMin + row, minKey);
+    return val;
+  };
+  size_t worksize =
+    getWorkspaceSize<distanceType, DataT, DataT, DataT, Index_>(x, y, m, n, k);
+  device_buffer<char> workspace(allocator, stream, worksize);
+  distance<distanceType, DataT, DataT, DataT, OutputTile_, decltype(reduce_op),
+           Index_>(x, y, (DataT *)nullptr, m, n, k, workspace.data(), worksize,
+                   reduce_op, stream);
+
+  minAndArgMinDecodeKernel<KeyT, DataT, Index_>
+    <<<ceildiv<Index_>(m, TPB), TPB, 0, stream>>>(
+      argminKeys.data(), minKeys.data(), m, minAndArgMin);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief the number of rows of y within eps of each row of x, as the vertex
+ * degrees of the epsilon neighborhood graph
+ * @tparam distanceType which distance to evaluate
+ * @tparam DataT input and accumulation type
+ * @tparam Index_ indexing type
+ * @param x first set of points (m x k)
+ * @param y second set of points (n x k)
+ * @param m number of points in x
+ * @param n number of points in y
+ * @param k dimensionality
+ * @param eps the threshold, squared if the distance is
+ * @param counts output count of the distances to each row of x that are at
+ * most eps (m); accumulated, so it must be zeroed by the caller
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ */
+template <DistanceType distanceType, typename DataT, typename Index_ = int,
+          typename OutputTile_ = OutputTile_8x128x128>
+void countWithinDistance(const DataT *x, const DataT *y, Index_ m, Index_ n,
+                         Index_ k, DataT eps, Index_ *counts,
+                         std::shared_ptr<deviceAllocator> allocator,
+                         cudaStream_t stream) {
+  auto reduce_op = [=] __device__(DataT val, Index_ g_idx) {
+    if (val <= eps) atomicAdd(counts + g_idx / n, Index_(1));
+    return val;
+  };
+  size_t worksize =
+    getWorkspaceSize<distanceType, DataT, DataT, DataT, Index_>(x, y, m, n, k);
+  device_buffer<char> workspace(allocator, stream, worksize);
+  distance<distanceType, DataT, DataT, DataT, OutputTile_, decltype(reduce_op),
+           Index_>(x, y, (DataT *)nullptr, m, n, k, workspace.data(), worksize,
+                   reduce_op, stream);
+}
+
+/**
+ * @brief the sums of the distances from each row of x to the rows of y of
+ * each label, as in the silhouette score
+ * @tparam distanceType which distance to evaluate
+ * @tparam DataT input, accumulation and output type
+ * @tparam LabelT type of the labels
+ * @tparam Index_ indexing type
+ * @param x first set of points (m x k)
+ * @param y second set of points (n x k)
+ * @param m number of points in x
+ * @param n number of points in y
+ * @param k dimensionality
+ * @param labels labels of the rows of y, in [0, nLabels) (n)
+ * @param nLabels number of labels
+ * @param sums output sums of the distances, row major (m x nLabels);
+ * accumulated, so it must be zeroed by the caller
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ */
+template <DistanceType distanceType, typename DataT, typename LabelT,
+          typename Index_ = int, typename OutputTile_ = OutputTile_8x128x128>
+void sumDistanceByLabel(const DataT *x, const DataT *y, Index_ m, Index_ n,
+                        Index_ k, const LabelT *labels, int nLabels,
+                        DataT *sums, std::shared_ptr<deviceAllocator> allocator,
+                        cudaStream_t stream) {
+  auto reduce_op = [=] __device__(DataT val, Index_ g_idx) {
+    Index_ row = g_idx / n;
+    atomicAdd(sums + row * nLabels + (int)labels[g_idx - row * n], val);
+    return val;
+  };
+  size_t worksize =
+    getWorkspaceSize<distanceType, DataT, DataT, DataT, Index_>(x, y, m, n, k);
+  device_buffer<char> workspace(allocator, stream, worksize);
+  distance<distanceType, DataT, DataT, DataT, OutputTile_, decltype(reduce_op),
+           Index_>(x, y, (DataT *)nullptr, m, n, k, workspace.data(), worksize,
+                   reduce_op, stream);
+}
+/** @} */
+
+};  // end namespace Distance
+};  // end namespace MLCommon
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "distance/unexpanded.h"
+
+namespace MLCommon {
+namespace Distance {
+
+/**
+ * @brief the unexpanded Hamming distance matrix calculation, the fraction of
+ *  the coordinates that differ
+ *  It computes the following equation: cij = op(sum_k (aik != bjk) / k)
+ * @tparam InType input data-type (for A and B matrices)
+ * @tparam AccType accumulation data-type
+ * @tparam OutType output data-type (for C and D matrices)
+ * @tparam OutputTile_ output tile size for the thread block
+ * @tparam FinalLambda user-defined epilogue lamba
+ * @tparam Index_ Index type
+ * @param m number of rows of A and C/D
+ * @param n number of columns of B and C/D
+ * @param k number of cols of A and rows of B
+ * @param pA input matrix
+ * @param pB input matrix
+ * @param pD output matrix
+ * @param fin_op the final element-wise epilogue lambda
+ * @param stream cuda stream where to launch work
+ * @param isRowMajor whether the input and output matrices are row major
+ */
+template <typename InType, typename AccType, typename OutType,
+          typename OutputTile_, typename FinalLambda, typename Index_ = int>
+void hammingImpl(Index_ m, Index_ n, Index_ k, const InType *pA,
+                 const InType *pB, OutType *pD, FinalLambda fin_op,
+                 cudaStream_t stream, bool isRowMajor) {
+  AccType invK = AccType(1) / AccType(k);
+  auto hamming_op = [fin_op, invK] __device__(AccType val, Index_ g_idx) {
+    return fin_op(val * invK, g_idx);
+  };
+  unexpandedDistanceAlgo<InType, AccType, OutType, OutputTile_,
+                         LinAlg::ThreadHammingAdd, decltype(hamming_op),
+                         Index_>(m, n, k, pA, pB, pD, false, hamming_op,
+                                 stream, isRowMajor);
+}
+
+};  // end namespace Distance
+};  // end namespace MLCommon
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "cuda_utils.h"
+
+namespace MLCommon {
+namespace Distance {
+
+/**
+ * @brief kernel of the haversine distances, one per thread
+ */
+template <typename InType, typename AccType, typename OutType,
+          typename FinalLambda, typename Index_, int TILE>
+__global__ void haversineKernel(Index_ m, Index_ n, const InType *pA,
+                                const InType *pB, OutType *pD,
+                                FinalLambda fin_op, bool isRowMajor) {
+  Index_ row = blockIdx.y * TILE + threadIdx.y;
+  Index_ col = blockIdx.x * TILE + threadIdx.x;
+  if (row >= m || col >= n) return;
+  AccType lat1 = pA[isRowMajor ? 2 * row : row];
+  AccType lon1 = pA[isRowMajor ? 2 * row + 1 : row + m];
+  AccType lat2 = pB[isRowMajor ? 2 * col : col];
+  AccType lon2 = pB[isRowMajor ? 2 * col + 1 : col + n];
+  AccType sinLat = sin(AccType(0.5) * (lat2 - lat1));
+  AccType sinLon = sin(AccType(0.5) * (lon2 - lon1));
+  AccType a = sinLat * sinLat + cos(lat1) * cos(lat2) * sinLon * sinLon;
+  // rounding can take a just above 1 for the antipodes
+  AccType val = AccType(2) * asin(mySqrt(a < AccType(1) ? a : AccType(1)));
+  Index_ idx = isRowMajor ? row * n + col : row + col * m;
+  OutType out = fin_op(val, idx);
+  if (pD != nullptr) pD[idx] = out;
+}
+
+/**
+ * @brief the haversine (great circle) distance matrix calculation, on the
+ *  unit sphere, between points given as (latitude, longitude) in radians
+ *  It computes the following equation:
+ *  cij = op(2 asin(sqrt(sin^2(dlat/2) + cos(lat_i) cos(lat_j) sin^2(dlon/2))))
+ * @tparam InType input data-type (for A and B matrices)
+ * @tparam AccType accumulation data-type
+ * @tparam OutType output data-type (for C and D matrices)
+ * @tparam FinalLambda user-defined epilogue lamba
+ * @tparam Index_ Index type
+ * @param m number of rows of A and C/D
+ * @param n number of columns of B and C/D
+ * @param k number of cols of A and rows of B, which must be 2
+ * @param pA input matrix
+ * @param pB input matrix
+ * @param pD output matrix
+ * @param fin_op the final element-wise epilogue lambda, which scales the
+ *  angle by the radius for a distance on the earth
+ * @param stream cuda stream where to launch work
+ * @param isRowMajor whether the input and output matrices are row major
+ */
+template <typename InType, typename AccType, typename OutType,
+          typename FinalLambda, typename Index_ = int>
+void haversineImpl(Index_ m, Index_ n, Index_ k, const InType *pA,
+                   const InType *pB, OutType *pD, FinalLambda fin_op,
+                   cudaStream_t stream, bool isRowMajor) {
+  ASSERT(k == 2, "haversineImpl: the points must be (latitude, longitude)");
+  constexpr int TILE = 16;
+  dim3 blk(TILE, TILE);
+  dim3 grid(ceildiv<Index_>(n, TILE), ceildiv<Index_>(m, TILE));
+  haversineKernel<InType, AccType, OutType, FinalLambda, Index_, TILE>
+    <<<grid, blk, 0, stream>>>(m, n, pA, pB, pD, fin_op, isRowMajor);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+};  // end namespace Distance
+};  // end namespace MLCommon
@@ -15,10 +15,7 @@
  */
 
 #pragma once
-#include "linalg/custom_accum.h"
-#include "linalg/gemm.h"
-
-#include <type_traits>
+#include "distance/unexpanded.h"
 
 namespace MLCommon {
 namespace Distance {
@@ -47,72 +44,9 @@ template <typename InType, typename AccType, typename OutType,
 void l1Impl(int m, int n, int k, const InType *pA, const InType *pB,
             OutType *pD, FinalLambda fin_op, cudaStream_t stream,
             bool isRowMajor) {
-  typedef std::is_same<OutType, bool> is_bool;
-  typedef typename std::conditional<is_bool::value, AccType, OutType>::type
-    EffOutType;
-  EffOutType *pDCast =
-    reinterpret_cast<EffOutType *>(pD);  // Pretend to be EffOutType;
-
-  typedef cutlass::Shape<8, 8, 8> AccumulatorsPerThread_;
-  typedef LinAlg::ThreadL1NormAdd<
-    AccumulatorsPerThread_, cutlass::Shape<1, 4, 8>, InType, InType, AccType>
-    MainLoopFunctor_;
-  typedef LinAlg::CustomGemmConfig<InType, AccType, EffOutType, OutputTile_,
-                                   AccumulatorsPerThread_, MainLoopFunctor_>
-    GemmConfig_;
-
-  typedef UnexpandedDistanceFragmentMultiplyAdd FragmentMultiplyAdd_;
-
-  typedef UnexpandedDistanceEpilogueFunctor<EffOutType, GemmConfig_,
-                                            FragmentMultiplyAdd_>
-    EpilogueFunctor_;
-
-  typedef typename std::conditional<
-    is_bool::value,
-    BoolEpilogueTraitsHelper<GemmConfig_, EpilogueFunctor_, Index_>,
-    cutlass::gemm::GemmEpilogueTraitsHelper<
-      GemmConfig_, EpilogueFunctor_, Index_>>::type EpilogueTraitsHelper_;
-
-  typedef typename cutlass::gemm::SimplifiedGemmEpilogueTraits<
-    GemmConfig_, EpilogueFunctor_, Index_, EpilogueTraitsHelper_>
-    GemmEpilogueTraits_;
-  typedef UnexpandedDistanceGemmEpilogue<GemmEpilogueTraits_> GemmEpilogue_;
-  typedef typename EpilogueFunctor_::Params EpiParams;
-
-  cublasOperation_t transa, transb;
-  const InType *aPtr, *bPtr;
-  Index_ lda, ldb, ldd;
-  Index_ gemm_m, gemm_n;
-  if (isRowMajor) {
-    transa = CUBLAS_OP_T;
-    transb = CUBLAS_OP_N;
-    aPtr = pB;
-    bPtr = pA;
-    lda = ldb = k;
-    ldd = n;
-    gemm_m = n;
-    gemm_n = m;
-  } else {
-    transa = CUBLAS_OP_N;
-    transb = CUBLAS_OP_T;
-    aPtr = pA;
-    bPtr = pB;
-    lda = m;
-    ldb = n;
-    ldd = m;
-    gemm_m = m;
-    gemm_n = n;
-  }
-  LinAlg::gemm<InType, AccType, EffOutType, OutputTile_, AccumulatorsPerThread_,
-               MainLoopFunctor_, Index_, GemmConfig_, EpilogueFunctor_,
-               GemmEpilogueTraits_, GemmEpilogue_>(
-    transa, transb, gemm_m, gemm_n, k, (EffOutType)1, aPtr, lda, bPtr, ldb,
-    (EffOutType)0, nullptr, ldd, pDCast,
-    [] HD(EpiParams & p) {
-      int err = p.initializeExtra(nullptr, nullptr, false);
-      return err;
-    },
-    fin_op, stream);
+  unexpandedDistanceAlgo<InType, AccType, OutType, OutputTile_,
+                         LinAlg::ThreadL1NormAdd, FinalLambda, Index_>(
+    m, n, k, pA, pB, pD, false, fin_op, stream, isRowMajor);
 }
 }  // namespace Distance
 }  // namespace MLCommon
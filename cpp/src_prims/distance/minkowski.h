@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "cuda_utils.h"
+
+namespace MLCommon {
+namespace Distance {
+
+/**
+ * @brief kernel of the Minkowski distances, each block computing a
+ * TILE x TILE block of the output from shared-memory tiles of A and B
+ */
+template <typename InType, typename AccType, typename OutType,
+          typename FinalLambda, typename Index_, int TILE>
+__global__ void minkowskiKernel(Index_ m, Index_ n, Index_ k, const InType *pA,
+                                const InType *pB, OutType *pD, AccType p,
+                                FinalLambda fin_op, bool isRowMajor) {
+  __shared__ InType sA[TILE][TILE + 1];
+  __shared__ InType sB[TILE][TILE + 1];
+  Index_ aBase = blockIdx.y * TILE, bBase = blockIdx.x * TILE;
+  Index_ aRow = aBase + threadIdx.y, bRow = bBase + threadIdx.y;
+  AccType acc = AccType(0);
+  for (Index_ t = 0; t < k; t += TILE) {
+    Index_ c = t + threadIdx.x;
+    sA[threadIdx.y][threadIdx.x] =
+      aRow < m && c < k ? pA[isRowMajor ? aRow * k + c : aRow + c * m]
+                        : InType(0);
+    sB[threadIdx.y][threadIdx.x] =
+      bRow < n && c < k ? pB[isRowMajor ? bRow * k + c : bRow + c * n]
+                        : InType(0);
+    __syncthreads();
+    // the zero padding past k adds nothing as p > 0
+#pragma unroll
+    for (int j = 0; j < TILE; ++j) {
+      AccType diff = myAbs(AccType(sA[threadIdx.y][j]) -
+                           AccType(sB[threadIdx.x][j]));
+      acc += myPow(diff, p);
+    }
+    __syncthreads();
+  }
+  Index_ row = aRow, col = bBase + threadIdx.x;
+  if (row < m && col < n) {
+    Index_ idx = isRowMajor ? row * n + col : row + col * m;
+    OutType out = fin_op(myPow(acc, AccType(1) / p), idx);
+    if (pD != nullptr) pD[idx] = out;
+  }
+}
+
+/**
+ * @brief the unexpanded Minkowski distance matrix calculation
+ *  It computes the following equation: cij = op((sum_k |aik-bjk|^p)^(1/p))
+ * @tparam InType input data-type (for A and B matrices)
+ * @tparam AccType accumulation data-type
+ * @tparam OutType output data-type (for C and D matrices)
+ * @tparam FinalLambda user-defined epilogue lamba
+ * @tparam Index_ Index type
+ * @param m number of rows of A and C/D
+ * @param n number of columns of B and C/D
+ * @param k number of cols of A and rows of B
+ * @param pA input matrix
+ * @param pB input matrix
+ * @param pD output matrix
+ * @param p the order of the norm, positive
+ * @param fin_op the final element-wise epilogue lambda
+ * @param stream cuda stream where to launch work
+ * @param isRowMajor whether the input and output matrices are row major
+ *
+ * @note The order is only known at runtime, which the cutlass main loop
+ *  functors cannot take, so this runs its own tiled kernel.
+ */
+template <typename InType, typename AccType, typename OutType,
+          typename FinalLambda, typename Index_ = int>
+void minkowskiImpl(Index_ m, Index_ n, Index_ k, const InType *pA,
+                   const InType *pB, OutType *pD, AccType p,
+                   FinalLambda fin_op, cudaStream_t stream, bool isRowMajor) {
+  ASSERT(p > AccType(0), "minkowskiImpl: the order p must be positive");
+  constexpr int TILE = 16;
+  dim3 blk(TILE, TILE);
+  dim3 grid(ceildiv<Index_>(n, TILE), ceildiv<Index_>(m, TILE));
+  minkowskiKernel<InType, AccType, OutType, FinalLambda, Index_, TILE>
+    <<<grid, blk, 0, stream>>>(m, n, k, pA, pB, pD, p, fin_op, isRowMajor);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+};  // end namespace Distance
+};  // end namespace MLCommon
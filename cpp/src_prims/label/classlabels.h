@@ -17,6 +17,9 @@
 #pragma once
 
 #include <cub/cub.cuh>
+#include <algorithm>
+#include <climits>
+#include <type_traits>
 
 #include "common/cumlHandle.hpp"
 #include "common/device_buffer.hpp"
@@ -182,5 +185,271 @@ void make_monotonic(Type *out, Type *in, size_t N, cudaStream_t stream) {
   make_monotonic<Type>(out, in, N, stream,
                        [] __device__(Type val) { return false; });
 }
+
+/**
+ * Open addressing hash table of labels in device memory, with linear probing.
+ * The keys are stored as their bits so that they can be inserted with
+ * atomicCAS, the all ones pattern marking the empty slots: the label with
+ * that pattern, eg. -1 for 64-bit integers, gets the extra slot capacity.
+ * Each slot also holds the first index at which its label occurs, and the id
+ * of the label.
+ */
+template <typename Type>
+struct LabelHashTable {
+  static_assert(sizeof(Type) == 4 || sizeof(Type) == 8,
+                "LabelHashTable: labels shall be 4 or 8 bytes");
+  typedef typename std::conditional<sizeof(Type) == 4, unsigned int,
+                                    unsigned long long>::type bits_t;
+
+  bits_t *keys;               //!< size [capacity + 1]
+  unsigned long long *first;  //!< size [capacity + 1]
+  int *ids;                   //!< size [capacity + 1]
+  int *overflow;              //!< set when a label could not be inserted
+  int capacity;               //!< number of slots, a power of two
+
+  static HDI bits_t empty() { return ~bits_t(0); }
+
+  static DI bits_t toBits(Type v) {
+    // -0.0 and 0.0 are the same label
+    if (v == Type(0)) v = Type(0);
+    return *reinterpret_cast<const bits_t *>(&v);
+  }
+
+  static DI unsigned long long mix(unsigned long long x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+  }
+
+  /** slot of the label, inserting it if needed, or -1 if the table is full */
+  DI int insert(Type v) {
+    bits_t b = toBits(v);
+    if (b == empty()) return capacity;
+    int s = int(mix(b) & (capacity - 1));
+    for (int probe = 0; probe < capacity; probe++) {
+      bits_t old = atomicCAS(keys + s, empty(), b);
+      if (old == empty() || old == b) return s;
+      s = (s + 1) & (capacity - 1);
+    }
+    return -1;
+  }
+};
+
+template <typename Type, typename Lambda>
+__global__ void hash_insert_kernel(const Type *in, size_t N, Lambda filter_op,
+                                   LabelHashTable<Type> table, int *slot) {
+  for (size_t i = size_t(blockIdx.x) * blockDim.x + threadIdx.x; i < N;
+       i += size_t(gridDim.x) * blockDim.x) {
+    int s = -1;
+    if (!filter_op(in[i])) {
+      s = table.insert(in[i]);
+      if (s < 0) {
+        *table.overflow = 1;
+        s = -2;
+      } else {
+        atomicMin(table.first + s, (unsigned long long)i);
+      }
+    }
+    slot[i] = s;
+  }
+}
+
+template <typename Type>
+__global__ void hash_first_kernel(size_t N, LabelHashTable<Type> table,
+                                  const int *slot, int *pos) {
+  for (size_t i = size_t(blockIdx.x) * blockDim.x + threadIdx.x; i < N;
+       i += size_t(gridDim.x) * blockDim.x) {
+    int s = slot[i];
+    pos[i] = s >= 0 && table.first[s] == i ? 1 : 0;
+  }
+}
+
+template <typename Type>
+__global__ void hash_assign_kernel(const Type *in, size_t N,
+                                   LabelHashTable<Type> table, const int *slot,
+                                   const int *pos, Type *y_unique,
+                                   int *n_unique) {
+  for (size_t i = size_t(blockIdx.x) * blockDim.x + threadIdx.x; i < N;
+       i += size_t(gridDim.x) * blockDim.x) {
+    int s = slot[i];
+    bool is_first = s >= 0 && table.first[s] == i;
+    if (is_first) {
+      table.ids[s] = pos[i];
+      if (y_unique != nullptr) y_unique[pos[i]] = in[i];
+    }
+    if (i == N - 1 && n_unique != nullptr) {
+      *n_unique = *table.overflow ? -1 : pos[i] + (is_first ? 1 : 0);
+    }
+  }
+}
+
+template <typename Type>
+__global__ void hash_map_kernel(Type *out, size_t N,
+                                LabelHashTable<Type> table, const int *slot) {
+  for (size_t i = size_t(blockIdx.x) * blockDim.x + threadIdx.x; i < N;
+       i += size_t(gridDim.x) * blockDim.x) {
+    int s = slot[i];
+    if (s >= 0) out[i] = Type(table.ids[s] + 1);
+  }
+}
+
+/* Internal auxiliary function numbering the labels of in that filter_op does
+ * not filter in the order of their first occurrence, see
+ * make_monotonic_hashed and getUniqueLabelsHashed */
+template <typename Type, typename Lambda>
+void hash_labels(Type *out, const Type *in, size_t N, Type *y_unique,
+                 int *n_unique, cudaStream_t stream,
+                 std::shared_ptr<deviceAllocator> allocator, Lambda filter_op,
+                 size_t max_unique) {
+  ASSERT(N <= size_t(INT_MAX), "hash_labels: more than INT_MAX labels");
+  if (N == 0) {
+    if (n_unique != nullptr) {
+      CUDA_CHECK(cudaMemsetAsync(n_unique, 0, sizeof(int), stream));
+    }
+    return;
+  }
+  if (max_unique == 0 || max_unique > N) max_unique = N;
+  // a load factor of at most 1/2
+  size_t capacity = 1;
+  while (capacity < 2 * max_unique) capacity *= 2;
+  ASSERT(capacity <= size_t(1) << 30, "hash_labels: max_unique too large");
+
+  typedef typename LabelHashTable<Type>::bits_t bits_t;
+  device_buffer<bits_t> keys(allocator, stream, capacity + 1);
+  device_buffer<unsigned long long> first(allocator, stream, capacity + 1);
+  device_buffer<int> ids(allocator, stream, capacity + 1);
+  device_buffer<int> overflow(allocator, stream, 1);
+  device_buffer<int> slot(allocator, stream, N);
+  device_buffer<int> pos(allocator, stream, N);
+  CUDA_CHECK(
+    cudaMemsetAsync(keys.data(), 255, keys.size() * sizeof(bits_t), stream));
+  CUDA_CHECK(cudaMemsetAsync(first.data(), 255,
+                             first.size() * sizeof(unsigned long long),
+                             stream));
+  CUDA_CHECK(cudaMemsetAsync(overflow.data(), 0, sizeof(int), stream));
+
+  LabelHashTable<Type> table;
+  table.keys = keys.data();
+  table.first = first.data();
+  table.ids = ids.data();
+  table.overflow = overflow.data();
+  table.capacity = int(capacity);
+
+  static const int TPB = 256;
+  int nblks = int(std::min<size_t>(ceildiv<size_t>(N, TPB),
+                                   8 * getMultiProcessorCount()));
+  hash_insert_kernel<<<nblks, TPB, 0, stream>>>(in, N, filter_op, table,
+                                                slot.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+  hash_first_kernel<<<nblks, TPB, 0, stream>>>(N, table, slot.data(),
+                                               pos.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  // the ids are the ranks of the first occurrences
+  size_t bytes = 0;
+  cub::DeviceScan::ExclusiveSum(NULL, bytes, pos.data(), pos.data(), int(N),
+                                stream);
+  device_buffer<char> cub_storage(allocator, stream, bytes);
+  cub::DeviceScan::ExclusiveSum(cub_storage.data(), bytes, pos.data(),
+                                pos.data(), int(N), stream);
+
+  hash_assign_kernel<<<nblks, TPB, 0, stream>>>(
+    in, N, table, slot.data(), pos.data(), y_unique, n_unique);
+  CUDA_CHECK(cudaPeekAtLastError());
+  if (out != nullptr) {
+    hash_map_kernel<<<nblks, TPB, 0, stream>>>(out, N, table, slot.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+}
+
+/**
+ * Get the unique class labels with a hash table.
+ *
+ * Unlike getUniqueLabels, which sorts the labels and copies their number to
+ * the host, this makes a single pass over the labels and keeps the output on
+ * the device, without synchronizing the stream. The unique labels are in the
+ * order of their first occurrence in y, not sorted.
+ *
+ * \tparam math_t numeric type of the labels, of 4 or 8 bytes
+ * \param [in] y device array of labels, size [n]
+ * \param [in] n number of labels
+ * \param [out] y_unique device array of the unique labels, allocated by the
+ *   caller with size [min(n, max_unique)]
+ * \param [out] n_unique device pointer to the number of unique labels, -1 if
+ *   there are more than max_unique
+ * \param stream cuda stream
+ * \param allocator device allocator of the hash table
+ * \param max_unique upper bound of the number of unique labels, which sizes
+ *   the hash table, 0 for n
+ */
+template <typename math_t>
+void getUniqueLabelsHashed(const math_t *y, size_t n, math_t *y_unique,
+                           int *n_unique, cudaStream_t stream,
+                           std::shared_ptr<deviceAllocator> allocator,
+                           size_t max_unique = 0) {
+  hash_labels<math_t>(
+    nullptr, y, n, y_unique, n_unique, stream, allocator,
+    [] __device__(math_t val) { return false; }, max_unique);
+}
+
+/**
+ * Maps an input array into a monotonically increasing set of labels, like
+ * make_monotonic, with a hash table: a single pass over the input instead of
+ * sorting it, and a search of the label per element in expected constant
+ * time instead of one growing with the number of labels, without
+ * synchronizing the stream.
+ *
+ * The labels are numbered from 1 in the order of their first occurrence in
+ * the input, rather than in the order of their values as with make_monotonic.
+ * The elements that filter_op selects are not written.
+ *
+ * @tparam Type the numeric type of the input and output arrays, of 4 or 8
+ * bytes
+ * @tparam Lambda the type of the filter function
+ * @param out the output array, size [N]
+ * @param in the input array, size [N]
+ * @param N number of elements in the input array
+ * @param stream cuda stream to use
+ * @param allocator device allocator of the hash table
+ * @param filter_op a function for specifying which values should have
+ * monotonically increasing labels applied to them
+ * @param n_unique if not nullptr, device pointer to the number of labels, -1
+ * if there are more than max_unique
+ * @param max_unique upper bound of the number of labels, which sizes the hash
+ * table, 0 for N. Beyond it, the labels that cannot be inserted are not
+ * written.
+ */
+template <typename Type, typename Lambda>
+void make_monotonic_hashed(Type *out, const Type *in, size_t N,
+                           cudaStream_t stream,
+                           std::shared_ptr<deviceAllocator> allocator,
+                           Lambda filter_op, int *n_unique = nullptr,
+                           size_t max_unique = 0) {
+  hash_labels<Type>(out, in, N, nullptr, n_unique, stream, allocator,
+                    filter_op, max_unique);
+}
+
+/**
+ * Maps an input array into a monotonically increasing set of labels, numbered
+ * in the order of their first occurrence, with a hash table, see the filtered
+ * make_monotonic_hashed.
+ * @tparam Type the numeric type of the input and output arrays, of 4 or 8
+ * bytes
+ * @param out the output array, size [N]
+ * @param in the input array, size [N]
+ * @param N number of elements in the input array
+ * @param stream cuda stream to use
+ * @param allocator device allocator of the hash table
+ */
+template <typename Type>
+void make_monotonic_hashed(Type *out, const Type *in, size_t N,
+                           cudaStream_t stream,
+                           std::shared_ptr<deviceAllocator> allocator) {
+  make_monotonic_hashed<Type>(out, in, N, stream, allocator,
+                              [] __device__(Type val) { return false; });
+}
 };  // namespace Label
 };  // end namespace MLCommon
@@ -17,6 +17,10 @@
 #pragma once
 
 #include <cublas_v2.h>
+#include <cuda_fp16.h>
+#if CUDART_VERSION >= 11000
+#include <cuda_bf16.h>
+#endif
 #include "cuda_utils.h"
 
 namespace MLCommon {
@@ -179,6 +183,59 @@ inline cublasStatus_t cublasgemm(cublasHandle_t handle,
   return cublasDgemm(handle, transA, transB, m, n, k, alfa, A, lda, B, ldb,
                      beta, C, ldc);
 }
+
+/**
+ * @brief gemm of half precision A and B accumulated and stored in single
+ * precision C, on the tensor cores where the device has them
+ */
+inline cublasStatus_t cublasgemm(cublasHandle_t handle,
+                                 cublasOperation_t transA,
+                                 cublasOperation_t transB, int m, int n, int k,
+                                 const float *alfa, const __half *A, int lda,
+                                 const __half *B, int ldb, const float *beta,
+                                 float *C, int ldc, cudaStream_t stream) {
+  CUBLAS_CHECK(cublasSetStream(handle, stream));
+  return cublasGemmEx(handle, transA, transB, m, n, k, alfa, A, CUDA_R_16F,
+                      lda, B, CUDA_R_16F, ldb, beta, C, CUDA_R_32F, ldc,
+                      CUDA_R_32F, CUBLAS_GEMM_DEFAULT_TENSOR_OP);
+}
+
+#if CUDART_VERSION >= 11000
+/**
+ * @brief gemm of bfloat16 A and B accumulated and stored in single precision
+ * C, on the tensor cores of Ampere and later
+ */
+inline cublasStatus_t cublasgemm(cublasHandle_t handle,
+                                 cublasOperation_t transA,
+                                 cublasOperation_t transB, int m, int n, int k,
+                                 const float *alfa, const __nv_bfloat16 *A,
+                                 int lda, const __nv_bfloat16 *B, int ldb,
+                                 const float *beta, float *C, int ldc,
+                                 cudaStream_t stream) {
+  CUBLAS_CHECK(cublasSetStream(handle, stream));
+  return cublasGemmEx(handle, transA, transB, m, n, k, alfa, A, CUDA_R_16BF,
+                      lda, B, CUDA_R_16BF, ldb, beta, C, CUDA_R_32F, ldc,
+                      CUBLAS_COMPUTE_32F, CUBLAS_GEMM_DEFAULT_TENSOR_OP);
+}
+
+/**
+ * @brief gemm of single precision A, B and C whose products are computed in
+ * tf32 on the tensor cores of Ampere and later
+ */
+inline cublasStatus_t cublasgemmTf32(cublasHandle_t handle,
+                                     cublasOperation_t transA,
+                                     cublasOperation_t transB, int m, int n,
+                                     int k, const float *alfa, const float *A,
+                                     int lda, const float *B, int ldb,
+                                     const float *beta, float *C, int ldc,
+                                     cudaStream_t stream) {
+  CUBLAS_CHECK(cublasSetStream(handle, stream));
+  return cublasGemmEx(handle, transA, transB, m, n, k, alfa, A, CUDA_R_32F,
+                      lda, B, CUDA_R_32F, ldb, beta, C, CUDA_R_32F, ldc,
+                      CUBLAS_COMPUTE_32F_FAST_TF32,
+                      CUBLAS_GEMM_DEFAULT_TENSOR_OP);
+}
+#endif
 /** @} */
 
 /**
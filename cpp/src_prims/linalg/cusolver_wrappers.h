@@ -516,6 +516,72 @@ inline cusolverStatus_t cusolverDnpotrs(cusolverDnHandle_t handle,
 }
 /** @} */
 
+/**
+ * @defgroup potrfBatched cusolver batched potrf operations
+ * @{
+ */
+template <typename T>
+cusolverStatus_t cusolverDnpotrfBatched(cusolverDnHandle_t handle,
+                                        cublasFillMode_t uplo, int n,
+                                        T **Aarray, int lda, int *infoArray,
+                                        int batchSize, cudaStream_t stream);
+
+template <>
+inline cusolverStatus_t cusolverDnpotrfBatched(cusolverDnHandle_t handle,
+                                               cublasFillMode_t uplo, int n,
+                                               float **Aarray, int lda,
+                                               int *infoArray, int batchSize,
+                                               cudaStream_t stream) {
+  CUSOLVER_CHECK(cusolverDnSetStream(handle, stream));
+  return cusolverDnSpotrfBatched(handle, uplo, n, Aarray, lda, infoArray,
+                                 batchSize);
+}
+
+template <>
+inline cusolverStatus_t cusolverDnpotrfBatched(cusolverDnHandle_t handle,
+                                               cublasFillMode_t uplo, int n,
+                                               double **Aarray, int lda,
+                                               int *infoArray, int batchSize,
+                                               cudaStream_t stream) {
+  CUSOLVER_CHECK(cusolverDnSetStream(handle, stream));
+  return cusolverDnDpotrfBatched(handle, uplo, n, Aarray, lda, infoArray,
+                                 batchSize);
+}
+/** @} */
+
+/**
+ * @defgroup potrsBatched cusolver batched potrs operations
+ * @note cuSOLVER only supports nrhs == 1
+ * @{
+ */
+template <typename T>
+cusolverStatus_t cusolverDnpotrsBatched(cusolverDnHandle_t handle,
+                                        cublasFillMode_t uplo, int n, int nrhs,
+                                        T **Aarray, int lda, T **Barray,
+                                        int ldb, int *info, int batchSize,
+                                        cudaStream_t stream);
+
+template <>
+inline cusolverStatus_t cusolverDnpotrsBatched(
+  cusolverDnHandle_t handle, cublasFillMode_t uplo, int n, int nrhs,
+  float **Aarray, int lda, float **Barray, int ldb, int *info, int batchSize,
+  cudaStream_t stream) {
+  CUSOLVER_CHECK(cusolverDnSetStream(handle, stream));
+  return cusolverDnSpotrsBatched(handle, uplo, n, nrhs, Aarray, lda, Barray,
+                                 ldb, info, batchSize);
+}
+
+template <>
+inline cusolverStatus_t cusolverDnpotrsBatched(
+  cusolverDnHandle_t handle, cublasFillMode_t uplo, int n, int nrhs,
+  double **Aarray, int lda, double **Barray, int ldb, int *info, int batchSize,
+  cudaStream_t stream) {
+  CUSOLVER_CHECK(cusolverDnSetStream(handle, stream));
+  return cusolverDnDpotrsBatched(handle, uplo, n, nrhs, Aarray, lda, Barray,
+                                 ldb, info, batchSize);
+}
+/** @} */
+
 /**
  * @defgroup geqrf cusolver geqrf operations
  * @{
@@ -661,5 +727,125 @@ inline cusolverStatus_t cusolverDnormqr_bufferSize(
 }
 /** @} */
 
+/**
+ * @defgroup syevjBatched cusolver batched syevj operations
+ * @note cuSOLVER only supports n <= 32
+ * @{
+ */
+template <typename T>
+cusolverStatus_t cusolverDnsyevjBatched_bufferSize(
+  cusolverDnHandle_t handle, cusolverEigMode_t jobz, cublasFillMode_t uplo,
+  int n, const T *A, int lda, const T *W, int *lwork, syevjInfo_t params,
+  int batchSize);
+
+template <>
+inline cusolverStatus_t cusolverDnsyevjBatched_bufferSize(
+  cusolverDnHandle_t handle, cusolverEigMode_t jobz, cublasFillMode_t uplo,
+  int n, const float *A, int lda, const float *W, int *lwork,
+  syevjInfo_t params, int batchSize) {
+  return cusolverDnSsyevjBatched_bufferSize(handle, jobz, uplo, n, A, lda, W,
+                                            lwork, params, batchSize);
+}
+
+template <>
+inline cusolverStatus_t cusolverDnsyevjBatched_bufferSize(
+  cusolverDnHandle_t handle, cusolverEigMode_t jobz, cublasFillMode_t uplo,
+  int n, const double *A, int lda, const double *W, int *lwork,
+  syevjInfo_t params, int batchSize) {
+  return cusolverDnDsyevjBatched_bufferSize(handle, jobz, uplo, n, A, lda, W,
+                                            lwork, params, batchSize);
+}
+
+template <typename T>
+cusolverStatus_t cusolverDnsyevjBatched(cusolverDnHandle_t handle,
+                                        cusolverEigMode_t jobz,
+                                        cublasFillMode_t uplo, int n, T *A,
+                                        int lda, T *W, T *work, int lwork,
+                                        int *info, syevjInfo_t params,
+                                        int batchSize, cudaStream_t stream);
+
+template <>
+inline cusolverStatus_t cusolverDnsyevjBatched(
+  cusolverDnHandle_t handle, cusolverEigMode_t jobz, cublasFillMode_t uplo,
+  int n, float *A, int lda, float *W, float *work, int lwork, int *info,
+  syevjInfo_t params, int batchSize, cudaStream_t stream) {
+  CUSOLVER_CHECK(cusolverDnSetStream(handle, stream));
+  return cusolverDnSsyevjBatched(handle, jobz, uplo, n, A, lda, W, work, lwork,
+                                 info, params, batchSize);
+}
+
+template <>
+inline cusolverStatus_t cusolverDnsyevjBatched(
+  cusolverDnHandle_t handle, cusolverEigMode_t jobz, cublasFillMode_t uplo,
+  int n, double *A, int lda, double *W, double *work, int lwork, int *info,
+  syevjInfo_t params, int batchSize, cudaStream_t stream) {
+  CUSOLVER_CHECK(cusolverDnSetStream(handle, stream));
+  return cusolverDnDsyevjBatched(handle, jobz, uplo, n, A, lda, W, work, lwork,
+                                 info, params, batchSize);
+}
+/** @} */
+
+/**
+ * @defgroup gesvdjBatched cusolver batched gesvdj operations
+ * @note cuSOLVER only supports m, n <= 32
+ * @{
+ */
+template <typename T>
+cusolverStatus_t cusolverDngesvdjBatched_bufferSize(
+  cusolverDnHandle_t handle, cusolverEigMode_t jobz, int m, int n, const T *A,
+  int lda, const T *S, const T *U, int ldu, const T *V, int ldv, int *lwork,
+  gesvdjInfo_t params, int batchSize);
+
+template <>
+inline cusolverStatus_t cusolverDngesvdjBatched_bufferSize(
+  cusolverDnHandle_t handle, cusolverEigMode_t jobz, int m, int n,
+  const float *A, int lda, const float *S, const float *U, int ldu,
+  const float *V, int ldv, int *lwork, gesvdjInfo_t params, int batchSize) {
+  return cusolverDnSgesvdjBatched_bufferSize(handle, jobz, m, n, A, lda, S, U,
+                                             ldu, V, ldv, lwork, params,
+                                             batchSize);
+}
+
+template <>
+inline cusolverStatus_t cusolverDngesvdjBatched_bufferSize(
+  cusolverDnHandle_t handle, cusolverEigMode_t jobz, int m, int n,
+  const double *A, int lda, const double *S, const double *U, int ldu,
+  const double *V, int ldv, int *lwork, gesvdjInfo_t params, int batchSize) {
+  return cusolverDnDgesvdjBatched_bufferSize(handle, jobz, m, n, A, lda, S, U,
+                                             ldu, V, ldv, lwork, params,
+                                             batchSize);
+}
+
+template <typename T>
+cusolverStatus_t cusolverDngesvdjBatched(cusolverDnHandle_t handle,
+                                         cusolverEigMode_t jobz, int m, int n,
+                                         T *A, int lda, T *S, T *U, int ldu,
+                                         T *V, int ldv, T *work, int lwork,
+                                         int *info, gesvdjInfo_t params,
+                                         int batchSize, cudaStream_t stream);
+
+template <>
+inline cusolverStatus_t cusolverDngesvdjBatched(
+  cusolverDnHandle_t handle, cusolverEigMode_t jobz, int m, int n, float *A,
+  int lda, float *S, float *U, int ldu, float *V, int ldv, float *work,
+  int lwork, int *info, gesvdjInfo_t params, int batchSize,
+  cudaStream_t stream) {
+  CUSOLVER_CHECK(cusolverDnSetStream(handle, stream));
+  return cusolverDnSgesvdjBatched(handle, jobz, m, n, A, lda, S, U, ldu, V,
+                                  ldv, work, lwork, info, params, batchSize);
+}
+
+template <>
+inline cusolverStatus_t cusolverDngesvdjBatched(
+  cusolverDnHandle_t handle, cusolverEigMode_t jobz, int m, int n, double *A,
+  int lda, double *S, double *U, int ldu, double *V, int ldv, double *work,
+  int lwork, int *info, gesvdjInfo_t params, int batchSize,
+  cudaStream_t stream) {
+  CUSOLVER_CHECK(cusolverDnSetStream(handle, stream));
+  return cusolverDnDgesvdjBatched(handle, jobz, m, n, A, lda, S, U, ldu, V,
+                                  ldv, work, lwork, info, params, batchSize);
+}
+/** @} */
+
 };  // end namespace LinAlg
 };  // end namespace MLCommon
@@ -58,24 +58,62 @@ namespace LinAlg {
     }                                                                    \
   }
 
-cusparseStatus_t cusparsegemmi(cusparseHandle_t handle, int m, int n, int k,
-                               int nnz, const float *alpha, const float *A,
-                               int lda, const float *cscValB,
-                               const int *cscColPtrB, const int *cscRowIndB,
-                               const float *beta, float *C, int ldc) {
+inline cusparseStatus_t cusparsegemmi(
+  cusparseHandle_t handle, int m, int n, int k, int nnz, const float *alpha,
+  const float *A, int lda, const float *cscValB, const int *cscColPtrB,
+  const int *cscRowIndB, const float *beta, float *C, int ldc) {
   return cusparseSgemmi(handle, m, n, k, nnz, alpha, A, lda, cscValB,
                         cscColPtrB, cscRowIndB, beta, C, ldc);
 }
 
-cusparseStatus_t cusparsegemmi(cusparseHandle_t handle, int m, int n, int k,
-                               int nnz, const double *alpha, const double *A,
-                               int lda, const double *cscValB,
-                               const int *cscColPtrB, const int *cscRowIndB,
-                               const double *beta, double *C, int ldc) {
+inline cusparseStatus_t cusparsegemmi(
+  cusparseHandle_t handle, int m, int n, int k, int nnz, const double *alpha,
+  const double *A, int lda, const double *cscValB, const int *cscColPtrB,
+  const int *cscRowIndB, const double *beta, double *C, int ldc) {
   return cusparseDgemmi(handle, m, n, k, nnz, alpha, A, lda, cscValB,
                         cscColPtrB, cscRowIndB, beta, C, ldc);
 }
 
+inline cusparseStatus_t cusparsecsrmm2(
+  cusparseHandle_t handle, cusparseOperation_t transA,
+  cusparseOperation_t transB, int m, int n, int k, int nnz, const float *alpha,
+  const cusparseMatDescr_t descr, const float *csrValA, const int *csrRowPtrA,
+  const int *csrColIndA, const float *B, int ldb, const float *beta, float *C,
+  int ldc) {
+  return cusparseScsrmm2(handle, transA, transB, m, n, k, nnz, alpha, descr,
+                         csrValA, csrRowPtrA, csrColIndA, B, ldb, beta, C,
+                         ldc);
+}
+
+inline cusparseStatus_t cusparsecsrmm2(
+  cusparseHandle_t handle, cusparseOperation_t transA,
+  cusparseOperation_t transB, int m, int n, int k, int nnz, const double *alpha,
+  const cusparseMatDescr_t descr, const double *csrValA, const int *csrRowPtrA,
+  const int *csrColIndA, const double *B, int ldb, const double *beta,
+  double *C, int ldc) {
+  return cusparseDcsrmm2(handle, transA, transB, m, n, k, nnz, alpha, descr,
+                         csrValA, csrRowPtrA, csrColIndA, B, ldb, beta, C,
+                         ldc);
+}
+
+inline cusparseStatus_t cusparsecsr2csc(
+  cusparseHandle_t handle, int m, int n, int nnz, const float *csrVal,
+  const int *csrRowPtr, const int *csrColInd, float *cscVal, int *cscRowInd,
+  int *cscColPtr) {
+  return cusparseScsr2csc(handle, m, n, nnz, csrVal, csrRowPtr, csrColInd,
+                          cscVal, cscRowInd, cscColPtr, CUSPARSE_ACTION_NUMERIC,
+                          CUSPARSE_INDEX_BASE_ZERO);
+}
+
+inline cusparseStatus_t cusparsecsr2csc(
+  cusparseHandle_t handle, int m, int n, int nnz, const double *csrVal,
+  const int *csrRowPtr, const int *csrColInd, double *cscVal, int *cscRowInd,
+  int *cscColPtr) {
+  return cusparseDcsr2csc(handle, m, n, nnz, csrVal, csrRowPtr, csrColInd,
+                          cscVal, cscRowInd, cscColPtr, CUSPARSE_ACTION_NUMERIC,
+                          CUSPARSE_INDEX_BASE_ZERO);
+}
+
 /** @} */
 
 };  // namespace LinAlg
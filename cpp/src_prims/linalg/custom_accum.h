@@ -112,5 +112,94 @@ struct ThreadL1NormAdd {
   }
 };
 
+/// Template performing matrix Linf-norm operation within a thread
+template <typename AccumulatorsPerThread_, typename ThreadsPerWarp_,
+          typename ScalarA_, typename ScalarB_, typename ScalarC_>
+struct ThreadLinfNormAdd {
+  /// The shape of the instruction.
+  typedef cutlass::Shape<1, 1, 1, 1> InstructionShape;
+  /// The number of accumulators per thread.
+  typedef AccumulatorsPerThread_ AccumulatorsPerThread;
+  /// The number of threads per warp.
+  typedef ThreadsPerWarp_ ThreadsPerWarp;
+  /// The number of accumulators per warp.
+  typedef
+    typename cutlass::ShapeMul<AccumulatorsPerThread, ThreadsPerWarp>::Shape
+      AccumulatorsPerWarp;
+  /// The type for A.
+  typedef ScalarA_ ScalarA;
+  /// The fragment for A.
+  typedef cutlass::Fragment<ScalarA, AccumulatorsPerThread::kW> FragmentA;
+  /// The type for B.
+  typedef ScalarB_ ScalarB;
+  /// The fragment for B.
+  typedef cutlass::Fragment<ScalarB, AccumulatorsPerThread::kH> FragmentB;
+  /// The type for C and D.
+  typedef ScalarC_ ScalarC;
+  /// The accumulators.
+  typedef cutlass::Fragment<
+    ScalarC, AccumulatorsPerThread::kH * AccumulatorsPerThread::kW, 16>
+    Accumulators;
+
+  /// Ctor.
+  CUTLASS_DEVICE ThreadLinfNormAdd() {}
+
+  /// Multiply : d = max(|a-b|, c).
+  CUTLASS_DEVICE void multiply_add(FragmentA const &a, FragmentB const &b,
+                                   Accumulators const &c, Accumulators &d) {
+    for (int j = 0; j < AccumulatorsPerThread::kH; ++j) {
+      for (int i = 0; i < AccumulatorsPerThread::kW; ++i) {
+        auto diff = a[i] < b[j] ? b[j] - a[i] : a[i] - b[j];
+        const auto idx = j * AccumulatorsPerThread::kW + i;
+        d[idx] = diff > c[idx] ? diff : c[idx];
+      }
+    }
+  }
+};
+
+/// Template counting the differing elements of the matrices within a thread
+template <typename AccumulatorsPerThread_, typename ThreadsPerWarp_,
+          typename ScalarA_, typename ScalarB_, typename ScalarC_>
+struct ThreadHammingAdd {
+  /// The shape of the instruction.
+  typedef cutlass::Shape<1, 1, 1, 1> InstructionShape;
+  /// The number of accumulators per thread.
+  typedef AccumulatorsPerThread_ AccumulatorsPerThread;
+  /// The number of threads per warp.
+  typedef ThreadsPerWarp_ ThreadsPerWarp;
+  /// The number of accumulators per warp.
+  typedef
+    typename cutlass::ShapeMul<AccumulatorsPerThread, ThreadsPerWarp>::Shape
+      AccumulatorsPerWarp;
+  /// The type for A.
+  typedef ScalarA_ ScalarA;
+  /// The fragment for A.
+  typedef cutlass::Fragment<ScalarA, AccumulatorsPerThread::kW> FragmentA;
+  /// The type for B.
+  typedef ScalarB_ ScalarB;
+  /// The fragment for B.
+  typedef cutlass::Fragment<ScalarB, AccumulatorsPerThread::kH> FragmentB;
+  /// The type for C and D.
+  typedef ScalarC_ ScalarC;
+  /// The accumulators.
+  typedef cutlass::Fragment<
+    ScalarC, AccumulatorsPerThread::kH * AccumulatorsPerThread::kW, 16>
+    Accumulators;
+
+  /// Ctor.
+  CUTLASS_DEVICE ThreadHammingAdd() {}
+
+  /// Multiply : d = (a != b) + c.
+  CUTLASS_DEVICE void multiply_add(FragmentA const &a, FragmentB const &b,
+                                   Accumulators const &c, Accumulators &d) {
+    for (int j = 0; j < AccumulatorsPerThread::kH; ++j) {
+      for (int i = 0; i < AccumulatorsPerThread::kW; ++i) {
+        const auto idx = j * AccumulatorsPerThread::kW + i;
+        d[idx] = (a[i] != b[j] ? ScalarC(1) : ScalarC(0)) + c[idx];
+      }
+    }
+  }
+};
+
 };  // end namespace LinAlg
 };  // end namespace MLCommon
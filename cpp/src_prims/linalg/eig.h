@@ -189,5 +189,51 @@ void eigJacobi(const math_t *in, int n_rows, int n_cols, math_t *eig_vectors,
   CUSOLVER_CHECK(cusolverDnDestroySyevjInfo(syevj_params));
 }
 
+/**
+ * @defgroup batched eig decomp with Jacobi method of many small column-major
+ * symmetric matrices, stored one after the other
+ * @param in: the batch_size input matrices, n x n each
+ * @param n: the order of the matrices, at most 32
+ * @param batch_size: number of matrices
+ * @param eig_vectors: the eigenvectors, n x n per matrix
+ * @param eig_vals: the eigenvalues in ascending order, n per matrix
+ * @param cusolverH cusolver handle
+ * @param stream cuda stream
+ * @param allocator device allocator for temporary buffers during computation
+ * @param tol: error tolerance for the jacobi method
+ * @param sweeps: maximum number of sweeps in the Jacobi algorithm
+ * @{
+ */
+template <typename math_t>
+void eigJacobiBatched(const math_t *in, int n, int batch_size,
+                      math_t *eig_vectors, math_t *eig_vals,
+                      cusolverDnHandle_t cusolverH, cudaStream_t stream,
+                      std::shared_ptr<deviceAllocator> allocator,
+                      math_t tol = 1.e-7, int sweeps = 15) {
+  ASSERT(n <= 32, "eigJacobiBatched: matrices are limited to 32 x 32");
+  syevjInfo_t syevj_params = nullptr;
+  CUSOLVER_CHECK(cusolverDnCreateSyevjInfo(&syevj_params));
+  CUSOLVER_CHECK(cusolverDnXsyevjSetTolerance(syevj_params, tol));
+  CUSOLVER_CHECK(cusolverDnXsyevjSetMaxSweeps(syevj_params, sweeps));
+
+  int lwork;
+  CUSOLVER_CHECK(cusolverDnsyevjBatched_bufferSize(
+    cusolverH, CUSOLVER_EIG_MODE_VECTOR, CUBLAS_FILL_MODE_UPPER, n,
+    eig_vectors, n, eig_vals, &lwork, syevj_params, batch_size));
+
+  device_buffer<math_t> d_work(allocator, stream, lwork);
+  device_buffer<int> dev_info(allocator, stream, batch_size);
+
+  MLCommon::copy(eig_vectors, in, n * n * batch_size, stream);
+
+  CUSOLVER_CHECK(cusolverDnsyevjBatched(
+    cusolverH, CUSOLVER_EIG_MODE_VECTOR, CUBLAS_FILL_MODE_UPPER, n,
+    eig_vectors, n, eig_vals, d_work.data(), lwork, dev_info.data(),
+    syevj_params, batch_size, stream));
+
+  CUDA_CHECK(cudaGetLastError());
+  CUSOLVER_CHECK(cusolverDnDestroySyevjInfo(syevj_params));
+}
+
 };  // end namespace LinAlg
 };  // end namespace MLCommon
@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cub/cub.cuh>
+#include <cuml/common/cuml_allocator.hpp>
+#include <utility>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "vectorized.h"
+
+namespace MLCommon {
+namespace LinAlg {
+
+/**
+ * @defgroup FusedReduction
+ * @{
+ * @brief Reductions of the rows or the columns of a matrix of any layout
+ * through a chain of elementwise maps, in a single pass over the matrix.
+ * The maps all take the value and its (row, col) in the matrix, whatever its
+ * layout, so that a stage can use the vectors of the rows or the columns
+ * (eg: dividing by the norms of the rows before summing the columns):
+ * <pre>T (*Map)(T val, IdxType row, IdxType col);</pre>
+ * and composeMaps chains them, the output of each being the input of the
+ * next, into the map of fusedReduction.
+ */
+
+/** the map of (val, row, col) doing f, then g */
+template <typename F, typename G>
+struct ComposedMap {
+  F f;
+  G g;
+  ComposedMap(F _f, G _g) : f(_f), g(_g) {}
+
+  template <typename T, typename IdxType>
+  DI auto operator()(T val, IdxType row, IdxType col)
+    -> decltype(std::declval<G>()(std::declval<F>()(val, row, col), row,
+                                  col)) {
+    return g(f(val, row, col), row, col);
+  }
+};
+
+template <typename... Maps>
+struct MapChain;
+
+template <typename F>
+struct MapChain<F> {
+  typedef F type;
+  static type make(F f) { return f; }
+};
+
+template <typename F, typename G, typename... Rest>
+struct MapChain<F, G, Rest...> {
+  typedef typename MapChain<ComposedMap<F, G>, Rest...>::type type;
+  static type make(F f, G g, Rest... rest) {
+    return MapChain<ComposedMap<F, G>, Rest...>::make(ComposedMap<F, G>(f, g),
+                                                      rest...);
+  }
+};
+
+/**
+ * @brief the map applying the maps in the order of the arguments
+ * @tparam Maps the types of the maps
+ * @param maps the elementwise maps of (val, row, col)
+ * @return the composed map of (val, row, col)
+ */
+template <typename... Maps>
+typename MapChain<Maps...>::type composeMaps(Maps... maps) {
+  return MapChain<Maps...>::make(maps...);
+}
+
+/** the identity map of (val, row, col) */
+template <typename Type, typename IdxType = int>
+struct IdentityMap {
+  HDI Type operator()(Type val, IdxType row, IdxType col) { return val; }
+};
+
+// One block per line of the matrix along its contiguous dimension, each
+// thread loading VecLen consecutive values at once
+template <typename InType, typename OutType, typename IdxType, int TPB,
+          int VecLen, bool LineIsRow, typename MapOp, typename ReduceLambda,
+          typename FinalLambda>
+__global__ void fusedCoalescedKernel(OutType *dots, const InType *data,
+                                     IdxType D, OutType init, MapOp map,
+                                     ReduceLambda reduce_op,
+                                     FinalLambda final_op, bool inplace) {
+  typedef cub::BlockReduce<OutType, TPB> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+  TxN_t<InType, VecLen> vec;
+  OutType thread_data = init;
+  IdxType line = blockIdx.x;
+  IdxType lineStart = line * D;
+  for (IdxType i = threadIdx.x * VecLen; i < D; i += TPB * VecLen) {
+    vec.load(data, lineStart + i);
+#pragma unroll
+    for (int j = 0; j < VecLen; ++j) {
+      IdxType k = i + j;
+      OutType v = LineIsRow ? map(vec.val.data[j], line, k)
+                            : map(vec.val.data[j], k, line);
+      thread_data = reduce_op(thread_data, v);
+    }
+  }
+  OutType acc = BlockReduce(temp_storage).Reduce(thread_data, reduce_op);
+  if (threadIdx.x == 0) {
+    dots[line] = final_op(inplace ? reduce_op(dots[line], acc) : acc);
+  }
+}
+
+// Blocks of TPBX x TPBY threads over the lines along the strided dimension,
+// each thread loading VecLen consecutive lines at once. A grid of more than
+// one block along y leaves its partial results in partials, for
+// fusedFinalizeKernel to reduce, instead of going through atomics.
+template <typename InType, typename OutType, typename IdxType, int TPBX,
+          int TPBY, int VecLen, bool LineIsRow, typename MapOp,
+          typename ReduceLambda, typename FinalLambda>
+__global__ void fusedStridedKernel(OutType *dots, OutType *partials,
+                                   const InType *data, IdxType D, IdxType N,
+                                   OutType init, MapOp map,
+                                   ReduceLambda reduce_op,
+                                   FinalLambda final_op, bool inplace) {
+  __shared__ OutType smem[TPBY][TPBX * VecLen];
+  TxN_t<InType, VecLen> vec;
+  OutType acc[VecLen];
+#pragma unroll
+  for (int j = 0; j < VecLen; ++j) acc[j] = init;
+  IdxType lineStart = (IdxType(blockIdx.x) * TPBX + threadIdx.x) * VecLen;
+  if (lineStart < D) {
+    for (IdxType r = IdxType(blockIdx.y) * TPBY + threadIdx.y; r < N;
+         r += IdxType(gridDim.y) * TPBY) {
+      vec.load(data, r * D + lineStart);
+#pragma unroll
+      for (int j = 0; j < VecLen; ++j) {
+        IdxType line = lineStart + j;
+        OutType v = LineIsRow ? map(vec.val.data[j], line, r)
+                              : map(vec.val.data[j], r, line);
+        acc[j] = reduce_op(acc[j], v);
+      }
+    }
+  }
+#pragma unroll
+  for (int j = 0; j < VecLen; ++j) {
+    smem[threadIdx.y][threadIdx.x + j * TPBX] = acc[j];
+  }
+  __syncthreads();
+  for (int s = TPBY / 2; s > 0; s /= 2) {
+    if (threadIdx.y < s) {
+#pragma unroll
+      for (int j = 0; j < VecLen; ++j) {
+        int c = threadIdx.x + j * TPBX;
+        smem[threadIdx.y][c] = reduce_op(smem[threadIdx.y][c],
+                                         smem[threadIdx.y + s][c]);
+      }
+    }
+    __syncthreads();
+  }
+  if (threadIdx.y != 0 || lineStart >= D) return;
+#pragma unroll
+  for (int j = 0; j < VecLen; ++j) {
+    IdxType line = lineStart + j;
+    OutType res = smem[0][threadIdx.x + j * TPBX];
+    if (gridDim.y > 1) {
+      partials[IdxType(blockIdx.y) * D + line] = res;
+    } else {
+      dots[line] = final_op(inplace ? reduce_op(dots[line], res) : res);
+    }
+  }
+}
+
+template <typename OutType, typename IdxType, int TPB, typename ReduceLambda,
+          typename FinalLambda>
+__global__ void fusedFinalizeKernel(OutType *dots, const OutType *partials,
+                                    IdxType D, int nParts,
+                                    ReduceLambda reduce_op,
+                                    FinalLambda final_op, bool inplace) {
+  IdxType line = IdxType(blockIdx.x) * TPB + threadIdx.x;
+  if (line >= D) return;
+  OutType res = partials[line];
+  for (int p = 1; p < nParts; ++p) {
+    res = reduce_op(res, partials[IdxType(p) * D + line]);
+  }
+  dots[line] = final_op(inplace ? reduce_op(dots[line], res) : res);
+}
+
+template <typename InType, typename OutType, typename IdxType, int VecLen,
+          bool LineIsRow, typename MapOp, typename ReduceLambda,
+          typename FinalLambda>
+void fusedCoalescedImpl(OutType *dots, const InType *data, IdxType D,
+                        IdxType N, OutType init, cudaStream_t stream,
+                        bool inplace, MapOp map, ReduceLambda reduce_op,
+                        FinalLambda final_op) {
+  // as coalescedReduction, the block is sized by the length of the lines
+  if (D <= 32 * VecLen) {
+    fusedCoalescedKernel<InType, OutType, IdxType, 32, VecLen, LineIsRow>
+      <<<N, 32, 0, stream>>>(dots, data, D, init, map, reduce_op, final_op,
+                             inplace);
+  } else if (D <= 128 * VecLen) {
+    fusedCoalescedKernel<InType, OutType, IdxType, 128, VecLen, LineIsRow>
+      <<<N, 128, 0, stream>>>(dots, data, D, init, map, reduce_op, final_op,
+                              inplace);
+  } else {
+    fusedCoalescedKernel<InType, OutType, IdxType, 256, VecLen, LineIsRow>
+      <<<N, 256, 0, stream>>>(dots, data, D, init, map, reduce_op, final_op,
+                              inplace);
+  }
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+template <typename InType, typename OutType, typename IdxType, int VecLen,
+          bool LineIsRow, typename MapOp, typename ReduceLambda,
+          typename FinalLambda>
+void fusedStridedImpl(OutType *dots, const InType *data, IdxType D, IdxType N,
+                      OutType init, std::shared_ptr<deviceAllocator> allocator,
+                      cudaStream_t stream, bool inplace, MapOp map,
+                      ReduceLambda reduce_op, FinalLambda final_op) {
+  constexpr int TPBX = 32, TPBY = 8, TPB = 256;
+  int nblksX = ceildiv<IdxType>(D, IdxType(TPBX * VecLen));
+  // enough blocks along y to fill the device, each over 16 rows or more
+  int maxY = std::max(1, 4 * getMultiProcessorCount() / nblksX);
+  int nblksY = std::min<IdxType>(ceildiv<IdxType>(N, IdxType(TPBY * 16)),
+                                 IdxType(std::min(maxY, 65535)));
+  nblksY = std::max(nblksY, 1);
+  device_buffer<OutType> partials(allocator, stream,
+                                  nblksY > 1 ? size_t(nblksY) * D : 0);
+  fusedStridedKernel<InType, OutType, IdxType, TPBX, TPBY, VecLen, LineIsRow>
+    <<<dim3(nblksX, nblksY), dim3(TPBX, TPBY), 0, stream>>>(
+      dots, partials.data(), data, D, N, init, map, reduce_op, final_op,
+      inplace);
+  CUDA_CHECK(cudaPeekAtLastError());
+  if (nblksY > 1) {
+    fusedFinalizeKernel<OutType, IdxType, TPB>
+      <<<ceildiv<IdxType>(D, TPB), TPB, 0, stream>>>(
+        dots, partials.data(), D, nblksY, reduce_op, final_op, inplace);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+}
+
+template <typename InType, typename OutType, typename IdxType, int VecLen,
+          typename MapOp, typename ReduceLambda, typename FinalLambda>
+void fusedReductionImpl(OutType *dots, const InType *data, IdxType D,
+                        IdxType N, OutType init, bool rowMajor, bool alongRows,
+                        std::shared_ptr<deviceAllocator> allocator,
+                        cudaStream_t stream, bool inplace, MapOp map,
+                        ReduceLambda reduce_op, FinalLambda final_op) {
+  if (rowMajor && alongRows) {
+    fusedCoalescedImpl<InType, OutType, IdxType, VecLen, true>(
+      dots, data, D, N, init, stream, inplace, map, reduce_op, final_op);
+  } else if (rowMajor && !alongRows) {
+    fusedStridedImpl<InType, OutType, IdxType, VecLen, false>(
+      dots, data, D, N, init, allocator, stream, inplace, map, reduce_op,
+      final_op);
+  } else if (!rowMajor && alongRows) {
+    fusedStridedImpl<InType, OutType, IdxType, VecLen, true>(
+      dots, data, N, D, init, allocator, stream, inplace, map, reduce_op,
+      final_op);
+  } else {
+    fusedCoalescedImpl<InType, OutType, IdxType, VecLen, false>(
+      dots, data, N, D, init, stream, inplace, map, reduce_op, final_op);
+  }
+}
+
+/**
+ * @brief Compute reduction of the input matrix along the requested dimension
+ * through a chain of maps, fused into a single pass over the matrix
+ *
+ * This is LinAlg::reduce for chains of elementwise operations, which it
+ * applies on the fly instead of writing their intermediate matrices. The loads
+ * are vectorized whenever the lines along the contiguous dimension are 16-byte
+ * aligned, and the reductions along the strided dimension combine the
+ * partials of their blocks in a second kernel rather than with atomics, so
+ * that any reduce_op works and the results are deterministic.
+ *
+ * @tparam InType the data type of the input
+ * @tparam OutType the data type of the output (as well as the data type for
+ *  which reduction is performed)
+ * @tparam IdxType data type of the indices of the array
+ * @tparam MapOp the elementwise map, usually built with composeMaps
+ * It must be a 'callable' supporting the following input and output:
+ * <pre>OutType (*MapOp)(InType, IdxType row, IdxType col);</pre>
+ * @tparam ReduceLambda Binary lambda applied for reduction (eg: addition(+) for L2 norm)
+ * It must be a 'callable' supporting the following input and output:
+ * <pre>OutType (*ReduceLambda)(OutType, OutType);</pre>
+ * @tparam FinalLambda the final lambda applied before STG (eg: Sqrt for L2 norm)
+ * It must be a 'callable' supporting the following input and output:
+ * <pre>OutType (*FinalLambda)(OutType);</pre>
+ * @param dots the output reduction vector
+ * @param data the input matrix
+ * @param D number of columns
+ * @param N number of rows
+ * @param init initial value to use for the reduction
+ * @param rowMajor input matrix is row-major or not
+ * @param alongRows whether to reduce along rows or columns
+ * @param allocator device allocator for the partials of the strided
+ * reductions
+ * @param stream cuda stream where to launch work
+ * @param map elementwise operation to apply before reduction
+ * @param inplace reduction result added inplace or overwrites old values?
+ * @param reduce_op binary reduction operation
+ * @param final_op elementwise operation to apply before storing results
+ */
+template <typename InType, typename OutType = InType, typename IdxType = int,
+          typename MapOp = IdentityMap<InType, IdxType>,
+          typename ReduceLambda = Sum<OutType>,
+          typename FinalLambda = Nop<OutType>>
+void fusedReduction(OutType *dots, const InType *data, IdxType D, IdxType N,
+                    OutType init, bool rowMajor, bool alongRows,
+                    std::shared_ptr<deviceAllocator> allocator,
+                    cudaStream_t stream,
+                    MapOp map = IdentityMap<InType, IdxType>(),
+                    bool inplace = false,
+                    ReduceLambda reduce_op = Sum<OutType>(),
+                    FinalLambda final_op = Nop<OutType>()) {
+  if (D <= 0 || N <= 0) return;
+  constexpr int VecLen = 16 / sizeof(InType) > 0 ? 16 / sizeof(InType) : 1;
+  IdxType contiguous = rowMajor ? D : N;
+  if (VecLen > 1 && contiguous % VecLen == 0 && uint64_t(data) % 16 == 0) {
+    fusedReductionImpl<InType, OutType, IdxType, VecLen>(
+      dots, data, D, N, init, rowMajor, alongRows, allocator, stream, inplace,
+      map, reduce_op, final_op);
+  } else {
+    fusedReductionImpl<InType, OutType, IdxType, 1>(
+      dots, data, D, N, init, rowMajor, alongRows, allocator, stream, inplace,
+      map, reduce_op, final_op);
+  }
+}
+/** @} */
+
+};  // end namespace LinAlg
+};  // end namespace MLCommon
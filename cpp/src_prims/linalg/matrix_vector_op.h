@@ -17,7 +17,7 @@
 #pragma once
 
 #include "cuda_utils.h"
-#include "vectorized.h"
+#include "vectorized_map.h"
 
 namespace MLCommon {
 namespace LinAlg {
@@ -63,7 +63,7 @@ void matrixVectorOpImpl(Type *out, const Type *matrix, const Type *vec,
                         IdxType D, IdxType N, bool rowMajor,
                         bool bcastAlongRows, Lambda op, cudaStream_t stream) {
   IdxType len = N * D;
-  IdxType nblks = ceildiv(veclen_ ? len / veclen_ : veclen_, (IdxType)TPB);
+  IdxType nblks = ceildiv(veclen_ ? len / veclen_ : len, (IdxType)TPB);
   matrixVectorOpKernel<Type, veclen_, Lambda, IdxType>
     <<<nblks, TPB, 0, stream>>>(out, matrix, vec, D, N, rowMajor,
                                 bcastAlongRows, op);
@@ -93,16 +93,20 @@ void matrixVectorOp(Type *out, const Type *matrix, const Type *vec, IdxType D,
                     cudaStream_t stream) {
   IdxType stride = rowMajor ? D : N;
   size_t bytes = stride * sizeof(Type);
-  if (16 / sizeof(Type) && bytes % 16 == 0) {
+  if (16 / sizeof(Type) && bytes % 16 == 0 &&
+      vecAligned(IdxType(0), 16 / sizeof(Type), out, matrix, vec)) {
     matrixVectorOpImpl<Type, 16 / sizeof(Type), Lambda, IdxType, TPB>(
       out, matrix, vec, D, N, rowMajor, bcastAlongRows, op, stream);
-  } else if (8 / sizeof(Type) && bytes % 8 == 0) {
+  } else if (8 / sizeof(Type) && bytes % 8 == 0 &&
+             vecAligned(IdxType(0), 8 / sizeof(Type), out, matrix, vec)) {
     matrixVectorOpImpl<Type, 8 / sizeof(Type), Lambda, IdxType, TPB>(
       out, matrix, vec, D, N, rowMajor, bcastAlongRows, op, stream);
-  } else if (4 / sizeof(Type) && bytes % 4 == 0) {
+  } else if (4 / sizeof(Type) && bytes % 4 == 0 &&
+             vecAligned(IdxType(0), 4 / sizeof(Type), out, matrix, vec)) {
     matrixVectorOpImpl<Type, 4 / sizeof(Type), Lambda, IdxType, TPB>(
       out, matrix, vec, D, N, rowMajor, bcastAlongRows, op, stream);
-  } else if (2 / sizeof(Type) && bytes % 2 == 0) {
+  } else if (2 / sizeof(Type) && bytes % 2 == 0 &&
+             vecAligned(IdxType(0), 2 / sizeof(Type), out, matrix, vec)) {
     matrixVectorOpImpl<Type, 2 / sizeof(Type), Lambda, IdxType, TPB>(
       out, matrix, vec, D, N, rowMajor, bcastAlongRows, op, stream);
   } else if (1 / sizeof(Type)) {
@@ -189,16 +193,23 @@ void matrixVectorOp(Type *out, const Type *matrix, const Type *vec1,
                     bool bcastAlongRows, Lambda op, cudaStream_t stream) {
   IdxType stride = rowMajor ? D : N;
   size_t bytes = stride * sizeof(Type);
-  if (16 / sizeof(Type) && bytes % 16 == 0) {
+  if (16 / sizeof(Type) && bytes % 16 == 0 &&
+      vecAligned(IdxType(0), 16 / sizeof(Type), out, matrix, vec1, vec2)) {
     matrixVectorOpImpl<Type, 16 / sizeof(Type), Lambda, IdxType, TPB>(
       out, matrix, vec1, vec2, D, N, rowMajor, bcastAlongRows, op, stream);
-  } else if (8 / sizeof(Type) && bytes % 8 == 0) {
+  } else if (8 / sizeof(Type) && bytes % 8 == 0 &&
+             vecAligned(IdxType(0), 8 / sizeof(Type), out, matrix, vec1,
+                        vec2)) {
     matrixVectorOpImpl<Type, 8 / sizeof(Type), Lambda, IdxType, TPB>(
       out, matrix, vec1, vec2, D, N, rowMajor, bcastAlongRows, op, stream);
-  } else if (4 / sizeof(Type) && bytes % 4 == 0) {
+  } else if (4 / sizeof(Type) && bytes % 4 == 0 &&
+             vecAligned(IdxType(0), 4 / sizeof(Type), out, matrix, vec1,
+                        vec2)) {
     matrixVectorOpImpl<Type, 4 / sizeof(Type), Lambda, IdxType, TPB>(
       out, matrix, vec1, vec2, D, N, rowMajor, bcastAlongRows, op, stream);
-  } else if (2 / sizeof(Type) && bytes % 2 == 0) {
+  } else if (2 / sizeof(Type) && bytes % 2 == 0 &&
+             vecAligned(IdxType(0), 2 / sizeof(Type), out, matrix, vec1,
+                        vec2)) {
     matrixVectorOpImpl<Type, 2 / sizeof(Type), Lambda, IdxType, TPB>(
       out, matrix, vec1, vec2, D, N, rowMajor, bcastAlongRows, op, stream);
   } else if (1 / sizeof(Type)) {
@@ -84,11 +84,13 @@ struct quadSum {
 
 #define SUM_ROWS_SMALL_K_DIMX 256
 #define SUM_ROWS_BY_KEY_SMALL_K_MAX_K 4
-template <typename DataIteratorT>
+template <typename DataIteratorT, typename WeightT>
 __launch_bounds__(SUM_ROWS_SMALL_K_DIMX, 4) __global__
   void sum_rows_by_key_small_nkeys_kernel(const DataIteratorT d_A, int lda,
-                                          char *d_keys, int nrows, int ncols,
-                                          int nkeys, DataIteratorT d_sums) {
+                                          char *d_keys,
+                                          const WeightT *d_weights, int nrows,
+                                          int ncols, int nkeys,
+                                          DataIteratorT d_sums) {
   typedef typename std::iterator_traits<DataIteratorT>::value_type DataType;
   typedef cub::BlockReduce<quad<DataType>, SUM_ROWS_SMALL_K_DIMX> BlockReduce;
   __shared__ typename BlockReduce::TempStorage temp_storage;
@@ -110,6 +112,7 @@ __launch_bounds__(SUM_ROWS_SMALL_K_DIMX, 4) __global__
          block_offset_irow += blockDim.x * gridDim.x) {
       int irow = block_offset_irow + threadIdx.x;
       DataType val = (irow < nrows) ? d_A[irow * lda + idim] : 0.0;
+      if (d_weights && irow < nrows) val *= d_weights[irow];
       // we are not reusing the keys - after profiling
       // d_keys is mainly loaded from L2, and this kernel is DRAM BW bounded
       // (experimentation gave a 10% speed up - not worth the many code lines added)
@@ -147,10 +150,11 @@ __launch_bounds__(SUM_ROWS_SMALL_K_DIMX, 4) __global__
   }
 }
 
-template <typename DataIteratorT>
+template <typename DataIteratorT, typename WeightT>
 void sum_rows_by_key_small_nkeys(const DataIteratorT d_A, int lda, char *d_keys,
-                                 int nrows, int ncols, int nkeys,
-                                 DataIteratorT d_sums, cudaStream_t st) {
+                                 const WeightT *d_weights, int nrows, int ncols,
+                                 int nkeys, DataIteratorT d_sums,
+                                 cudaStream_t st) {
   dim3 grid, block;
   block.x = SUM_ROWS_SMALL_K_DIMX;
   block.y = 1;  // Necessary
@@ -160,7 +164,7 @@ void sum_rows_by_key_small_nkeys(const DataIteratorT d_A, int lda, char *d_keys,
   grid.y = ncols;
   grid.y = std::min(grid.y, MAX_BLOCKS);
   sum_rows_by_key_small_nkeys_kernel<<<grid, block, 0, st>>>(
-    d_A, lda, d_keys, nrows, ncols, nkeys, d_sums);
+    d_A, lda, d_keys, d_weights, nrows, ncols, nkeys, d_sums);
 }
 
 //
@@ -231,10 +235,11 @@ void sum_rows_by_key_large_nkeys_colmajor(const DataIteratorT d_A, int lda,
 
 #define RRBK_SHMEM_SZ 32
 //#define RRBK_SHMEM
-template <typename DataIteratorT, typename KeysIteratorT>
+template <typename DataIteratorT, typename KeysIteratorT, typename WeightT>
 __global__ void sum_rows_by_key_large_nkeys_kernel_rowmajor(
-  const DataIteratorT d_A, int lda, KeysIteratorT d_keys, int nrows, int ncols,
-  int key_offset, int nkeys, DataIteratorT d_sums) {
+  const DataIteratorT d_A, int lda, KeysIteratorT d_keys,
+  const WeightT *d_weights, int nrows, int ncols, int key_offset, int nkeys,
+  DataIteratorT d_sums) {
   typedef typename std::iterator_traits<KeysIteratorT>::value_type KeyType;
   typedef typename std::iterator_traits<DataIteratorT>::value_type DataType;
 
@@ -273,15 +278,18 @@ __global__ void sum_rows_by_key_large_nkeys_kernel_rowmajor(
                  // same for the whole block
 #endif
     //if ((end_row-start_row) / (r-start_row) != global_key) continue;
-    sum += __ldcg(&d_A[r * lda + this_col]);
+    DataType val = __ldcg(&d_A[r * lda + this_col]);
+    if (d_weights) val *= d_weights[r];
+    sum += val;
   }
 
   if (sum != 0.0) myAtomicAdd(&d_sums[global_key * ncols + this_col], sum);
 }
 
-template <typename DataIteratorT, typename KeysIteratorT>
+template <typename DataIteratorT, typename KeysIteratorT, typename WeightT>
 void sum_rows_by_key_large_nkeys_rowmajor(const DataIteratorT d_A, int lda,
-                                          KeysIteratorT d_keys, int nrows,
+                                          KeysIteratorT d_keys,
+                                          const WeightT *d_weights, int nrows,
                                           int ncols, int key_offset, int nkeys,
                                           DataIteratorT d_sums,
                                           cudaStream_t st) {
@@ -301,7 +309,7 @@ void sum_rows_by_key_large_nkeys_rowmajor(const DataIteratorT d_A, int lda,
   //std::cout << "block = " << block.x << ", " << block.y << std::endl;
   //std::cout << "grid = " << grid.x << ", " << grid.y << ", " << grid.z << std::endl;
   sum_rows_by_key_large_nkeys_kernel_rowmajor<<<grid, block, 0, st>>>(
-    d_A, lda, d_keys, nrows, ncols, key_offset, nkeys, d_sums);
+    d_A, lda, d_keys, d_weights, nrows, ncols, key_offset, nkeys, d_sums);
 }
 
 /**
@@ -311,6 +319,8 @@ void sum_rows_by_key_large_nkeys_rowmajor(const DataIteratorT d_A, int lda,
  * @param[in]  d_A         Input data array (lda x nrows)
  * @param[in]  lda         Real row size for input data, d_A
  * @param[in]  d_keys      Keys for each row (1 x nrows)
+ * @param[in]  d_weights   Weight of each row (1 x nrows), the rows are
+ *                         multiplied by their weight before the reduction
  * @param      d_keys_char Scratch memory for conversion of keys to char
  * @param[in]  nrows       Number of rows in d_A and d_keys
  * @param[in]  ncols       Number of data columns in d_A
@@ -318,11 +328,11 @@ void sum_rows_by_key_large_nkeys_rowmajor(const DataIteratorT d_A, int lda,
  * @param[out] d_sums      Row sums by key (ncols x d_keys)
  * @param[in]  stream      CUDA stream
  */
-template <typename DataIteratorT, typename KeysIteratorT>
+template <typename DataIteratorT, typename KeysIteratorT, typename WeightT>
 void reduce_rows_by_key(const DataIteratorT d_A, int lda,
-                        const KeysIteratorT d_keys, char *d_keys_char,
-                        int nrows, int ncols, int nkeys, DataIteratorT d_sums,
-                        cudaStream_t stream) {
+                        const KeysIteratorT d_keys, const WeightT *d_weights,
+                        char *d_keys_char, int nrows, int ncols, int nkeys,
+                        DataIteratorT d_sums, cudaStream_t stream) {
   typedef typename std::iterator_traits<KeysIteratorT>::value_type KeyType;
   typedef typename std::iterator_traits<DataIteratorT>::value_type DataType;
 
@@ -334,18 +344,32 @@ void reduce_rows_by_key(const DataIteratorT d_A, int lda,
     // with doubles we have ~20% speed up - with floats we can hope something around 2x
     // Converting d_keys to char
     convert_array(d_keys_char, d_keys, nrows, stream);
-    sum_rows_by_key_small_nkeys(d_A, lda, d_keys_char, nrows, ncols, nkeys,
-                                d_sums, stream);
+    sum_rows_by_key_small_nkeys(d_A, lda, d_keys_char, d_weights, nrows, ncols,
+                                nkeys, d_sums, stream);
   } else {
     for (KeyType key_offset = 0; key_offset < nkeys;
          key_offset += SUM_ROWS_BY_KEY_LARGE_K_MAX_K) {
       KeyType this_call_nkeys = std::min(SUM_ROWS_BY_KEY_LARGE_K_MAX_K, nkeys);
-      sum_rows_by_key_large_nkeys_rowmajor(d_A, lda, d_keys, nrows, ncols,
-                                           key_offset, this_call_nkeys, d_sums,
-                                           stream);
+      sum_rows_by_key_large_nkeys_rowmajor(d_A, lda, d_keys, d_weights, nrows,
+                                           ncols, key_offset, this_call_nkeys,
+                                           d_sums, stream);
     }
   }
 }
 
+/**
+ * @brief Computes the reduction of matrix rows for each given key, all the
+ * rows having a weight of 1; see the overload above for the parameters
+ */
+template <typename DataIteratorT, typename KeysIteratorT>
+void reduce_rows_by_key(const DataIteratorT d_A, int lda,
+                        const KeysIteratorT d_keys, char *d_keys_char,
+                        int nrows, int ncols, int nkeys, DataIteratorT d_sums,
+                        cudaStream_t stream) {
+  typedef typename std::iterator_traits<DataIteratorT>::value_type DataType;
+  reduce_rows_by_key(d_A, lda, d_keys, static_cast<const DataType *>(nullptr),
+                     d_keys_char, nrows, ncols, nkeys, d_sums, stream);
+}
+
 };  // end namespace LinAlg
 };  // end namespace MLCommon
@@ -49,6 +49,7 @@ namespace LinAlg {
  * @param cusolverH cusolver handle
  * @param cublasH cublas handle
  * @param allocator device allocator for temporary buffers during computation
+ * @param n_power_iters: no. of power iterations refining the random samples
  * @{
  */
 template <typename math_t>
@@ -57,14 +58,15 @@ void rsvdFixedRank(math_t *M, int n_rows, int n_cols, math_t *&S_vec,
                    bool gen_left_vec, bool gen_right_vec, bool use_jacobi,
                    math_t tol, int max_sweeps, cusolverDnHandle_t cusolverH,
                    cublasHandle_t cublasH, cudaStream_t stream,
-                   std::shared_ptr<deviceAllocator> allocator) {
+                   std::shared_ptr<deviceAllocator> allocator,
+                   int n_power_iters = 1) {
   // All the notations are following Algorithm 4 & 5 in S. Voronin's paper:
   // https://arxiv.org/abs/1502.05366
 
   int m = n_rows, n = n_cols;
   int l =
     k + p;  // Total number of singular values to be computed before truncation
-  int q = 2;  // Number of power sampling counts
+  int q = n_power_iters + 1;  // Number of power sampling counts
   int s = 1;  // Frequency controller for QR decomposition during power sampling
               // scheme. s = 1: 2 QR per iteration; s = 2: 1 QR per iteration; s
               // > 2: less frequent QR
@@ -189,6 +189,59 @@ void svdJacobi(math_t *in, int n_rows, int n_cols, math_t *sing_vals,
   CUSOLVER_CHECK(cusolverDnDestroyGesvdjInfo(gesvdj_params));
 }
 
+/**
+ * @defgroup batched singular value decomposition with the Jacobi method of
+ * many small column-major matrices, stored one after the other
+ * @param in: the batch_size input matrices, n_rows x n_cols each. They are
+ * overwritten
+ * @param n_rows: number rows of the matrices, at most 32
+ * @param n_cols: number columns of the matrices, at most 32
+ * @param batch_size: number of matrices
+ * @param sing_vals: singular values in descending order, min(n_rows, n_cols)
+ * per matrix
+ * @param left_sing_vecs: left singular vectors, n_rows x n_rows per matrix
+ * @param right_sing_vecs: right singular vectors, n_cols x n_cols per matrix
+ * @param tol: error tolerance for the jacobi method
+ * @param max_sweeps: maximum number of sweeps in the Jacobi algorithm
+ * @param cusolverH cusolver handle
+ * @param stream cuda stream
+ * @param allocator device allocator for temporary buffers during computation
+ * @{
+ */
+template <typename math_t>
+void svdJacobiBatched(math_t *in, int n_rows, int n_cols, int batch_size,
+                      math_t *sing_vals, math_t *left_sing_vecs,
+                      math_t *right_sing_vecs, math_t tol, int max_sweeps,
+                      cusolverDnHandle_t cusolverH, cudaStream_t stream,
+                      std::shared_ptr<deviceAllocator> allocator) {
+  ASSERT(n_rows <= 32 && n_cols <= 32,
+         "svdJacobiBatched: matrices are limited to 32 x 32");
+  gesvdjInfo_t gesvdj_params = NULL;
+
+  CUSOLVER_CHECK(cusolverDnCreateGesvdjInfo(&gesvdj_params));
+  CUSOLVER_CHECK(cusolverDnXgesvdjSetTolerance(gesvdj_params, tol));
+  CUSOLVER_CHECK(cusolverDnXgesvdjSetMaxSweeps(gesvdj_params, max_sweeps));
+
+  int m = n_rows;
+  int n = n_cols;
+
+  device_buffer<int> devInfo(allocator, stream, batch_size);
+
+  int lwork = 0;
+  CUSOLVER_CHECK(cusolverDngesvdjBatched_bufferSize(
+    cusolverH, CUSOLVER_EIG_MODE_VECTOR, m, n, in, m, sing_vals,
+    left_sing_vecs, m, right_sing_vecs, n, &lwork, gesvdj_params, batch_size));
+
+  device_buffer<math_t> d_work(allocator, stream, lwork);
+
+  CUSOLVER_CHECK(cusolverDngesvdjBatched(
+    cusolverH, CUSOLVER_EIG_MODE_VECTOR, m, n, in, m, sing_vals,
+    left_sing_vecs, m, right_sing_vecs, n, d_work.data(), lwork,
+    devInfo.data(), gesvdj_params, batch_size, stream));
+
+  CUSOLVER_CHECK(cusolverDnDestroyGesvdjInfo(gesvdj_params));
+}
+
 /**
  * @defgroup reconstruct a matrix use left and right singular vectors and
  * singular values
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuml/common/cuml_allocator.hpp>
+#include "../matrix/matrix.h"
+#include "common/cuml_comms_int.hpp"
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "cusolver_wrappers.h"
+
+namespace MLCommon {
+namespace LinAlg {
+
+/**
+ * @defgroup R factor of the QR decomposition of a block of rows of a
+ * column-major matrix, written to the rows of a taller column-major matrix
+ * @param M: the block, n_rows x n_cols, with leading dimension ld_M
+ * @param R: the upper triangular n_cols x n_cols R factor, lower part zeroed,
+ * with leading dimension ld_R
+ * @param n_rows: number rows of the block, at least n_cols
+ * @param n_cols: number columns of the block
+ * @param cusolverH cusolver handle
+ * @param stream cuda stream
+ * @param allocator device allocator for temporary buffers during computation
+ * @{
+ */
+template <typename math_t>
+void qrGetRBlock(const math_t *M, int ld_M, math_t *R, int ld_R, int n_rows,
+                 int n_cols, cusolverDnHandle_t cusolverH, cudaStream_t stream,
+                 std::shared_ptr<deviceAllocator> allocator) {
+  int m = n_rows, n = n_cols;
+  device_buffer<math_t> work(allocator, stream, m * n);
+  CUDA_CHECK(cudaMemcpy2DAsync(work.data(), sizeof(math_t) * m, M,
+                               sizeof(math_t) * ld_M, sizeof(math_t) * m, n,
+                               cudaMemcpyDeviceToDevice, stream));
+
+  device_buffer<math_t> tau(allocator, stream, n);
+  device_buffer<int> devInfo(allocator, stream, 1);
+  int Lwork;
+  CUSOLVER_CHECK(
+    cusolverDngeqrf_bufferSize(cusolverH, m, n, work.data(), m, &Lwork));
+  device_buffer<math_t> workspace(allocator, stream, Lwork);
+  CUSOLVER_CHECK(cusolverDngeqrf(cusolverH, m, n, work.data(), m, tau.data(),
+                                 workspace.data(), Lwork, devInfo.data(),
+                                 stream));
+
+  device_buffer<math_t> R_tmp(allocator, stream, n * n);
+  CUDA_CHECK(
+    cudaMemsetAsync(R_tmp.data(), 0, sizeof(math_t) * n * n, stream));
+  Matrix::copyUpperTriangular(work.data(), R_tmp.data(), m, n, stream);
+  CUDA_CHECK(cudaMemcpy2DAsync(R, sizeof(math_t) * ld_R, R_tmp.data(),
+                               sizeof(math_t) * n, sizeof(math_t) * n, n,
+                               cudaMemcpyDeviceToDevice, stream));
+}
+/** @} */
+
+/**
+ * @defgroup R factor of the QR decomposition of a tall-skinny matrix by TSQR.
+ * The row blocks are factored independently and their stacked R factors are
+ * factored again, until a single block is left. Only a block and the stacked
+ * R factors are in the workspace, never a copy of the whole matrix.
+ *
+ * The R factors of two row blocks, stacked, have the R factor of the two
+ * blocks: an out-of-core caller merges the R of each chunk of rows with the
+ * running R this way. For least squares, the last column of the R factor of
+ * [X y] is Q^T y, the right hand side of the triangular system.
+ *
+ * @param M: column-major input matrix, n_rows x n_cols
+ * @param R: the n_cols x n_cols upper triangular R factor, lower part zeroed.
+ * The signs of its rows may differ from those of qrGetQR
+ * @param n_rows: number rows of input matrix, at least n_cols
+ * @param n_cols: number columns of input matrix
+ * @param block_rows: number rows of the blocks factored at once, at least
+ * 2 * n_cols. The last block also takes the remaining rows
+ * @param cusolverH cusolver handle
+ * @param stream cuda stream
+ * @param allocator device allocator for temporary buffers during computation
+ * @{
+ */
+template <typename math_t>
+void tsqrGetR(const math_t *M, math_t *R, int n_rows, int n_cols,
+              int block_rows, cusolverDnHandle_t cusolverH,
+              cudaStream_t stream, std::shared_ptr<deviceAllocator> allocator) {
+  int m = n_rows, n = n_cols;
+  ASSERT(m >= n, "tsqrGetR: the matrix must have at least as many rows as"
+                 " columns");
+  ASSERT(block_rows >= 2 * n, "tsqrGetR: block_rows must be at least twice"
+                              " the number of columns");
+  if (m <= block_rows) {
+    qrGetRBlock(M, m, R, n, m, n, cusolverH, stream, allocator);
+    return;
+  }
+
+  int n_blocks = m / block_rows;
+  int stacked_rows = n_blocks * n;
+  device_buffer<math_t> stacked(allocator, stream, stacked_rows * n);
+  for (int b = 0; b < n_blocks; b++) {
+    int rows = b == n_blocks - 1 ? m - b * block_rows : block_rows;
+    qrGetRBlock(M + b * block_rows, m, stacked.data() + b * n, stacked_rows,
+                rows, n, cusolverH, stream, allocator);
+  }
+  tsqrGetR(stacked.data(), R, stacked_rows, n, block_rows, cusolverH, stream,
+           allocator);
+}
+/** @} */
+
+/**
+ * @defgroup R factor of the QR decomposition of a tall-skinny matrix whose
+ * rows are sharded over the ranks of a communicator. The local R factors are
+ * allgathered and factored again, so that all the ranks get the same R.
+ * @param comm: the communicator
+ * @param M: column-major local rows, n_rows x n_cols
+ * @param R: the n_cols x n_cols upper triangular R factor of all the rows
+ * @param n_rows: number local rows, at least n_cols
+ * @param n_cols: number columns
+ * @param block_rows: number rows of the blocks factored at once, see tsqrGetR
+ * @param cusolverH cusolver handle
+ * @param stream cuda stream
+ * @param allocator device allocator for temporary buffers during computation
+ * @{
+ */
+template <typename math_t>
+void tsqrGetRMG(const cumlCommunicator &comm, const math_t *M, math_t *R,
+                int n_rows, int n_cols, int block_rows,
+                cusolverDnHandle_t cusolverH, cudaStream_t stream,
+                std::shared_ptr<deviceAllocator> allocator) {
+  int n = n_cols, n_ranks = comm.getSize();
+  device_buffer<math_t> R_local(allocator, stream, n * n);
+  device_buffer<math_t> R_all(allocator, stream, n_ranks * n * n);
+  tsqrGetR(M, R_local.data(), n_rows, n, block_rows, cusolverH, stream,
+           allocator);
+  comm.allgather(R_local.data(), R_all.data(), n * n, stream);
+
+  // rank r holds the columns of its R factor at R_all + r * n * n: move them
+  // to the rows r * n of the stacked column-major matrix
+  device_buffer<math_t> stacked(allocator, stream, n_ranks * n * n);
+  for (int r = 0; r < n_ranks; r++) {
+    CUDA_CHECK(cudaMemcpy2DAsync(
+      stacked.data() + r * n, sizeof(math_t) * n_ranks * n,
+      R_all.data() + r * n * n, sizeof(math_t) * n, sizeof(math_t) * n, n,
+      cudaMemcpyDeviceToDevice, stream));
+  }
+  tsqrGetR(stacked.data(), R, n_ranks * n, n, max(block_rows, n_ranks * n),
+           cusolverH, stream, allocator);
+}
+/** @} */
+
+};  // end namespace LinAlg
+};  // end namespace MLCommon
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include "cuda_utils.h"
+#include "vectorized.h"
+
+namespace MLCommon {
+namespace LinAlg {
+
+/** the largest of the sizes of the types */
+template <typename... Types>
+struct MaxSizeOf;
+
+template <typename Type>
+struct MaxSizeOf<Type> {
+  static const size_t value = sizeof(Type);
+};
+
+template <typename Type, typename... Types>
+struct MaxSizeOf<Type, Types...> {
+  static const size_t value = sizeof(Type) > MaxSizeOf<Types...>::value
+                                ? sizeof(Type)
+                                : MaxSizeOf<Types...>::value;
+};
+
+/**
+ * @brief The vectors of VecLen elements of each of the input arrays at the
+ *        same index, loaded through TxN_t, and the application of the op to
+ *        their j-th elements.
+ */
+template <int VecLen, typename... InTypes>
+struct VecArgs;
+
+template <int VecLen>
+struct VecArgs<VecLen> {
+  DI VecArgs() {}
+
+  template <typename IdxType>
+  DI void load(IdxType idx) {}
+
+  template <typename OutType, typename Lambda, typename... Vals>
+  DI OutType apply(Lambda &op, int j, Vals... vals) {
+    return op(vals...);
+  }
+};
+
+template <int VecLen, typename InType, typename... InTypes>
+struct VecArgs<VecLen, InType, InTypes...> {
+  const InType *ptr;
+  TxN_t<InType, VecLen> vec;
+  VecArgs<VecLen, InTypes...> rest;
+
+  DI VecArgs(const InType *p, const InTypes *... ps) : ptr(p), rest(ps...) {}
+
+  template <typename IdxType>
+  DI void load(IdxType idx) {
+    vec.load(ptr, idx);
+    rest.load(idx);
+  }
+
+  template <typename OutType, typename Lambda, typename... Vals>
+  DI OutType apply(Lambda &op, int j, Vals... vals) {
+    return rest.template apply<OutType>(op, j, vals..., vec.val.data[j]);
+  }
+};
+
+// Grid-stride loop over the aligned vectors of [head, len - nTail), then the
+// head and tail elements peeled off them by the first threads of the grid
+template <typename OutType, int VecLen, typename Lambda, typename IdxType,
+          typename... InTypes>
+__global__ void vectorizedMapKernel(OutType *out, IdxType len, IdxType head,
+                                    IdxType nVecs, Lambda op,
+                                    const InTypes *... in) {
+  IdxType tid = threadIdx.x + IdxType(blockIdx.x) * blockDim.x;
+  IdxType stride = IdxType(gridDim.x) * blockDim.x;
+  for (IdxType v = tid; v < nVecs; v += stride) {
+    IdxType idx = head + v * VecLen;
+    VecArgs<VecLen, InTypes...> args(in...);
+    args.load(idx);
+    TxN_t<OutType, VecLen> res;
+#pragma unroll
+    for (int j = 0; j < VecLen; ++j) {
+      res.val.data[j] = args.template apply<OutType>(op, j);
+    }
+    res.store(out, idx);
+  }
+  IdxType nTail = len - head - nVecs * VecLen;
+  if (tid < head + nTail) {
+    IdxType idx = tid < head ? tid : len - nTail + (tid - head);
+    VecArgs<1, InTypes...> args(in...);
+    args.load(idx);
+    out[idx] = args.template apply<OutType>(op, 0);
+  }
+}
+
+/** whether the elements at head of all the arrays are aligned to VecLen */
+template <typename IdxType>
+bool vecAligned(IdxType head, int vecLen) {
+  return true;
+}
+
+template <typename IdxType, typename Type, typename... Types>
+bool vecAligned(IdxType head, int vecLen, const Type *ptr,
+                const Types *... ptrs) {
+  uint64_t addr = uint64_t(ptr);
+  return addr % sizeof(Type) == 0 &&
+         (addr / sizeof(Type) + uint64_t(head)) % uint64_t(vecLen) == 0 &&
+         vecAligned(head, vecLen, ptrs...);
+}
+
+/**
+ * @brief Launch with the widest vectors to which the arrays can all be
+ *        aligned after peeling the same head, halving VecLen until they can
+ */
+template <int VecLen>
+struct VectorizedMapDispatch {
+  template <typename OutType, typename Lambda, typename IdxType, int TPB,
+            typename... InTypes>
+  static void run(OutType *out, IdxType len, Lambda op, cudaStream_t stream,
+                  const InTypes *... in) {
+    uint64_t addr = uint64_t(out);
+    IdxType head = IdxType((VecLen - (addr / sizeof(OutType)) % VecLen) %
+                           VecLen);
+    if (len < IdxType(2 * VecLen) || addr % sizeof(OutType) != 0 ||
+        !vecAligned(head, VecLen, in...)) {
+      VectorizedMapDispatch<VecLen / 2>::template run<OutType, Lambda,
+                                                      IdxType, TPB>(
+        out, len, op, stream, in...);
+      return;
+    }
+    IdxType nVecs = (len - head) / VecLen;
+    // enough blocks to fill the device, the grid-stride loop doing the rest
+    IdxType maxBlks = IdxType(8 * getMultiProcessorCount());
+    IdxType nblks =
+      std::max(IdxType(1), std::min(ceildiv(nVecs, IdxType(TPB)), maxBlks));
+    vectorizedMapKernel<OutType, VecLen, Lambda, IdxType, InTypes...>
+      <<<nblks, TPB, 0, stream>>>(out, len, head, nVecs, op, in...);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+};
+
+template <>
+struct VectorizedMapDispatch<1> {
+  template <typename OutType, typename Lambda, typename IdxType, int TPB,
+            typename... InTypes>
+  static void run(OutType *out, IdxType len, Lambda op, cudaStream_t stream,
+                  const InTypes *... in) {
+    IdxType maxBlks = IdxType(8 * getMultiProcessorCount());
+    IdxType nblks = std::min(ceildiv(len, IdxType(TPB)), maxBlks);
+    vectorizedMapKernel<OutType, 1, Lambda, IdxType, InTypes...>
+      <<<nblks, TPB, 0, stream>>>(out, len, IdxType(0), len, op, in...);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+};
+
+/**
+ * @brief perform element-wise operation on any number of input arrays,
+ *        out[i] = op(in[i]...), with vectorized loads and stores
+ *
+ * The elements before the first index at which all the arrays are aligned to
+ * the widest vectors that their types allow, and those after the last whole
+ * vector, are peeled off and handled one by one, so that the bulk of the
+ * arrays is vectorized whatever their length or offset (eg: column slices).
+ * Only if the arrays are misaligned with each other do the vectors get
+ * narrower, down to single elements.
+ *
+ * @tparam OutType output data-type
+ * @tparam Lambda the device-lambda performing the actual operation
+ * @tparam IdxType Integer type used to for addressing
+ * @tparam TPB threads-per-block in the final kernel launched
+ * @tparam InTypes input data-types
+ * @param out the output array
+ * @param len number of elements in the arrays
+ * @param op the device-lambda
+ * @param stream cuda stream where to launch work
+ * @param in the input arrays
+ * @note Lambda must be a functor with the following signature:
+ *       `OutType func(const InTypes&... vals);`
+ */
+template <typename OutType, typename Lambda, typename IdxType = int,
+          int TPB = 256, typename... InTypes>
+void vectorizedMap(OutType *out, IdxType len, Lambda op, cudaStream_t stream,
+                   const InTypes *... in) {
+  if (len <= 0) return;  //silently skip in case of 0 length input
+  constexpr size_t maxSize = MaxSizeOf<OutType, InTypes...>::value;
+  constexpr int VecLen = maxSize >= 16 ? 1 : int(16 / maxSize);
+  VectorizedMapDispatch<VecLen>::template run<OutType, Lambda, IdxType, TPB>(
+    out, len, op, stream, in...);
+}
+
+};  // end namespace LinAlg
+};  // end namespace MLCommon
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <functional>
 #include <stdexcept>
 #include <tuple>
@@ -24,6 +25,8 @@
 
 #include <linalg/binary_op.h>
 #include <linalg/cublas_wrappers.h>
+#include <linalg/eig.h>
+#include <linalg/svd.h>
 #include <memory>
 
 #include <thrust/for_each.h>
@@ -39,24 +42,18 @@ namespace Matrix {
 /**
  * @brief An allocation function for `BatchedMatrixMemory`.
  * 
- * @note Written as a free function because I had trouble getting the
- *       __device__ lambda to compile as a member function of the
- *       `BatchedMatrixMemory` struct.
- * 
  * @param[in]  shape        Shape of each matrix (rows, columns)
  * @param[in]  num_batches  Number of matrices in the batch
  * @param[in]  setZero      Whether to initialize the allocated matrix with all zeros
  * @param[in]  allocator    Device memory allocator
  * @param[in]  stream       CUDA stream
  * 
- * @return Pair (A_dense, A_array): pointer to the raw data and pointer
- *         to the array of pointers to each matrix in the batch
+ * @return Pointer to the raw data
  */
 template <typename T>
-std::pair<T*, T**> BMM_Allocate(std::pair<int, int> shape, int num_batches,
-                                bool setZero,
-                                std::shared_ptr<ML::deviceAllocator> allocator,
-                                cudaStream_t stream) {
+T* BMM_Allocate(std::pair<int, int> shape, int num_batches, bool setZero,
+                std::shared_ptr<ML::deviceAllocator> allocator,
+                cudaStream_t stream) {
   int m = shape.first;
   int n = shape.second;
 
@@ -65,15 +62,38 @@ std::pair<T*, T**> BMM_Allocate(std::pair<int, int> shape, int num_batches,
   if (setZero)
     CUDA_CHECK(
       cudaMemsetAsync(A_dense, 0, sizeof(T) * m * n * num_batches, stream));
+  return A_dense;
+}
 
-  // Allocate and fill array of pointers to each batch matrix
+/**
+ * @brief Allocates and fills the array of pointers to each matrix of a batch,
+ *        for the cuBLAS routines which have no strided version.
+ * 
+ * @note Written as a free function because I had trouble getting the
+ *       __device__ lambda to compile as a member function of the
+ *       `BatchedMatrixMemory` struct.
+ * 
+ * @param[in]  A_dense      Pointer to the raw data
+ * @param[in]  shape        Shape of each matrix (rows, columns)
+ * @param[in]  num_batches  Number of matrices in the batch
+ * @param[in]  allocator    Device memory allocator
+ * @param[in]  stream       CUDA stream
+ * 
+ * @return Pointer to the array of pointers to each matrix in the batch
+ */
+template <typename T>
+T** BMM_PointerArray(T* A_dense, std::pair<int, int> shape, int num_batches,
+                     std::shared_ptr<ML::deviceAllocator> allocator,
+                     cudaStream_t stream) {
+  int m = shape.first;
+  int n = shape.second;
   T** A_array = (T**)allocator->allocate(sizeof(T*) * num_batches, stream);
   // Fill array of pointers to each batch matrix.
   auto counting = thrust::make_counting_iterator(0);
   thrust::for_each(
     thrust::cuda::par.on(stream), counting, counting + num_batches,
     [=] __device__(int bid) { A_array[bid] = &(A_dense[bid * m * n]); });
-  return std::make_pair(A_dense, A_array);
+  return A_array;
 }
 
 /**
@@ -142,7 +162,7 @@ class BatchedMatrix {
     m_shape = std::make_pair(m, n);
 
     // Allocate memory
-    auto memory =
+    T* memory =
       BMM_Allocate<T>(m_shape, num_batches, setZero, allocator, stream);
 
     /* Take these references to extract them from member-storage for the
@@ -157,14 +177,9 @@ class BatchedMatrix {
         A, num_batches * shape.first * shape.second * sizeof(T), stream);
     };
 
-    auto f2 = [allocator, num_batches, stream](T** A) {
-      allocator->deallocate(A, sizeof(T*) * num_batches, stream);
-    };
-
     // When this shared pointer count goes to 0, `f` is called to deallocate
     // the memory
-    m_A_dense = std::shared_ptr<T>(memory.first, f1);
-    m_A_batches = std::shared_ptr<T*>(memory.second, f2);
+    m_A_dense = std::shared_ptr<T>(memory, f1);
   }
 
   //! Return batches
@@ -182,8 +197,25 @@ class BatchedMatrix {
   //! Return shape
   const std::pair<int, int>& shape() const { return m_shape; }
 
-  //! Return pointer array
-  T** data() const { return m_A_batches.get(); }
+  /**
+   * @brief Return pointer array, which is only built on the first call, as
+   *        most operations use the strided layout of the raw data instead
+   */
+  T** data() const {
+    if (!m_A_batches) {
+      auto allocator = m_allocator;
+      auto num_batches = m_num_batches;
+      auto stream = m_stream;
+      auto f2 = [allocator, num_batches, stream](T** A) {
+        allocator->deallocate(A, sizeof(T*) * num_batches, stream);
+      };
+      m_A_batches = std::shared_ptr<T*>(
+        BMM_PointerArray<T>(m_A_dense.get(), m_shape, m_num_batches,
+                            m_allocator, m_stream),
+        f2);
+    }
+    return m_A_batches.get();
+  }
 
   //! Return pointer to the underlying memory
   T* raw_data() const { return m_A_dense.get(); }
@@ -309,8 +341,8 @@ class BatchedMatrix {
   //! Shape (rows, cols) of matrices. We assume all matrices in batch have same shape.
   std::pair<int, int> m_shape;
 
-  //! Array(pointer) to each matrix.
-  std::shared_ptr<T*> m_A_batches;
+  //! Array(pointer) to each matrix, built on demand by data()
+  mutable std::shared_ptr<T*> m_A_batches;
 
   //! Data pointer to first element of dense matrix data.
   std::shared_ptr<T> m_A_dense;
@@ -362,6 +394,108 @@ __global__ void kronecker_product_kernel(const T* A, int m, int n, const T* B,
   }
 }
 
+/**
+ * @brief Batched GEMM of small matrices, C = alpha*op(A)*op(B) + beta*C,
+ *        for m, n, k <= MaxDim
+ * 
+ * @note Each block handles BatchesPerBlock batches: op(A) is staged in
+ *       shared memory, and each thread keeps a column of op(B) in registers
+ *       and computes the corresponding column of C. This avoids the launch
+ *       and tiling overheads of cuBLAS for the tiny matrices of ARIMA and
+ *       Kalman filters.
+ * 
+ * @param[in]      aT       Is `A` transposed?
+ * @param[in]      bT       Is `B` transposed?
+ * @param[in]      m        Number of rows of op(A) and C
+ * @param[in]      n        Number of columns of op(B) and C
+ * @param[in]      k        Number of columns of op(A) and rows of op(B)
+ * @param[in]      alpha    Parameter alpha
+ * @param[in]      A        Pointer to the raw data of the batch A
+ * @param[in]      lda      Leading dimension of each matrix of A
+ * @param[in]      strideA  Distance between two matrices of A
+ * @param[in]      B        Pointer to the raw data of the batch B
+ * @param[in]      ldb      Leading dimension of each matrix of B
+ * @param[in]      strideB  Distance between two matrices of B
+ * @param[in]      beta     Parameter beta
+ * @param[in,out]  C        Pointer to the raw data of the batch C
+ * @param[in]      ldc      Leading dimension of each matrix of C
+ * @param[in]      strideC  Distance between two matrices of C
+ * @param[in]      num_batches  Number of matrices in the batch
+ */
+template <typename T, int MaxDim, int BatchesPerBlock>
+__global__ void small_gemm_kernel(bool aT, bool bT, int m, int n, int k,
+                                  T alpha, const T* A, int lda, int strideA,
+                                  const T* B, int ldb, int strideB, T beta,
+                                  T* C, int ldc, int strideC,
+                                  int num_batches) {
+  constexpr int MatSize = MaxDim * MaxDim;
+  __shared__ T sA[BatchesPerBlock][MatSize];
+  int first_batch = blockIdx.x * BatchesPerBlock;
+
+  // Stage op(A) of the batches of this block, column-major and zero-padded
+  for (int idx = threadIdx.x; idx < BatchesPerBlock * MatSize;
+       idx += blockDim.x) {
+    int lb = idx / MatSize;
+    int i = idx % MaxDim;
+    int ik = (idx % MatSize) / MaxDim;
+    int bid = first_batch + lb;
+    T val = 0;
+    if (bid < num_batches && i < m && ik < k) {
+      const T* A_b = A + bid * strideA;
+      val = aT ? A_b[ik + i * lda] : A_b[i + ik * lda];
+    }
+    sA[lb][i + ik * MaxDim] = val;
+  }
+  __syncthreads();
+
+  int lb = threadIdx.x / MaxDim;
+  int j = threadIdx.x % MaxDim;
+  int bid = first_batch + lb;
+  if (bid >= num_batches || j >= n) return;
+
+  // Column j of op(B)
+  const T* B_b = B + bid * strideB;
+  T b_col[MaxDim];
+#pragma unroll
+  for (int ik = 0; ik < MaxDim; ik++) {
+    b_col[ik] = ik < k ? (bT ? B_b[j + ik * ldb] : B_b[ik + j * ldb]) : T(0);
+  }
+
+  T* C_b = C + bid * strideC;
+#pragma unroll
+  for (int i = 0; i < MaxDim; i++) {
+    if (i < m) {
+      T acc = 0;
+#pragma unroll
+      for (int ik = 0; ik < MaxDim; ik++) {
+        acc += sA[lb][i + ik * MaxDim] * b_col[ik];
+      }
+      // As in cuBLAS, C is not read when beta is zero
+      T res = alpha * acc;
+      if (beta != T(0)) res += beta * C_b[i + j * ldc];
+      C_b[i + j * ldc] = res;
+    }
+  }
+}
+
+template <typename T, int MaxDim>
+void small_gemm(bool aT, bool bT, int m, int n, int k, T alpha,
+                const BatchedMatrix<T>& A, const BatchedMatrix<T>& B, T beta,
+                const BatchedMatrix<T>& C) {
+  // One thread per column of C, for 256 threads per block
+  constexpr int BatchesPerBlock = 256 / MaxDim;
+  int num_batches = A.batches();
+  if (num_batches == 0) return;
+  int nblks = ceildiv(num_batches, BatchesPerBlock);
+  small_gemm_kernel<T, MaxDim, BatchesPerBlock>
+    <<<nblks, BatchesPerBlock * MaxDim, 0, A.stream()>>>(
+      aT, bT, m, n, k, alpha, A.raw_data(), A.shape().first,
+      A.shape().first * A.shape().second, B.raw_data(), B.shape().first,
+      B.shape().first * B.shape().second, beta, C.raw_data(), C.shape().first,
+      C.shape().first * C.shape().second, num_batches);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
 /**
  * @brief Batched GEMM operation (exhaustive version)
  *        [C1, C2, ...] = [alpha*A1*B1+beta*C1, alpha*A2*B2+beta*C2, ...]
@@ -396,6 +530,19 @@ void b_gemm(bool aT, bool bT, int m, int n, int k, T alpha,
     ASSERT(n <= C.shape().second, "n should be <= number of columns of C");
   }
 
+  // Small matrices: register-tiled kernel
+  int max_dim = std::max(std::max(m, n), k);
+  if (max_dim <= 4) {
+    small_gemm<T, 4>(aT, bT, m, n, k, alpha, A, B, beta, C);
+    return;
+  } else if (max_dim <= 8) {
+    small_gemm<T, 8>(aT, bT, m, n, k, alpha, A, B, beta, C);
+    return;
+  } else if (max_dim <= 16) {
+    small_gemm<T, 16>(aT, bT, m, n, k, alpha, A, B, beta, C);
+    return;
+  }
+
   // Set transpose modes
   cublasOperation_t opA = aT ? CUBLAS_OP_T : CUBLAS_OP_N;
   cublasOperation_t opB = bT ? CUBLAS_OP_T : CUBLAS_OP_N;
@@ -470,6 +617,59 @@ void b_gels(const BatchedMatrix<T>& A, BatchedMatrix<T>& C) {
     &info, nullptr, A.batches()));
 }
 
+/**
+ * @brief Eigen decomposition of a batch of small symmetric matrices, with
+ *        cuSOLVER batched Jacobi
+ *
+ * @param[in]   A         Batched matrix A of square symmetric matrices of
+ *                        order at most 32. It is not modified
+ * @param[out]  V         Batched matrix of the eigenvectors (same shape as A)
+ * @param[out]  eig_vals  Eigenvalues in ascending order, n per batch member
+ * @param[in]   cusolverH cuSOLVER handle
+ */
+template <typename T>
+void b_eig(const BatchedMatrix<T>& A, BatchedMatrix<T>& V, T* eig_vals,
+           cusolverDnHandle_t cusolverH) {
+  int n = A.shape().first;
+  ASSERT(A.shape().second == n, "b_eig: A must be square");
+  ASSERT(V.shape().first == n && V.shape().second == n &&
+           V.batches() == A.batches(),
+         "b_eig: V must have the shape of A");
+  MLCommon::LinAlg::eigJacobiBatched(A.raw_data(), n, A.batches(),
+                                     V.raw_data(), eig_vals, cusolverH,
+                                     A.stream(), A.allocator());
+}
+
+/**
+ * @brief Singular value decomposition A = U S V^T of a batch of small
+ *        matrices, with cuSOLVER batched Jacobi
+ *
+ * @param[in]   A         Batched matrix A (m x n, m and n at most 32). It is
+ *                        copied to avoid modifying the original one
+ * @param[out]  U         Batched matrix of the left singular vectors (m x m)
+ * @param[out]  V         Batched matrix of the right singular vectors (n x n)
+ * @param[out]  sing_vals Singular values in descending order, min(m, n) per
+ *                        batch member
+ * @param[in]   cusolverH cuSOLVER handle
+ */
+template <typename T>
+void b_svd(const BatchedMatrix<T>& A, BatchedMatrix<T>& U,
+           BatchedMatrix<T>& V, T* sing_vals, cusolverDnHandle_t cusolverH) {
+  int m = A.shape().first;
+  int n = A.shape().second;
+  ASSERT(U.shape().first == m && U.shape().second == m &&
+           U.batches() == A.batches(),
+         "b_svd: U must be m x m");
+  ASSERT(V.shape().first == n && V.shape().second == n &&
+           V.batches() == A.batches(),
+         "b_svd: V must be n x n");
+
+  BatchedMatrix<T> Acopy = A.deepcopy();
+  MLCommon::LinAlg::svdJacobiBatched(
+    Acopy.raw_data(), m, n, A.batches(), sing_vals, U.raw_data(), V.raw_data(),
+    T(1e-7), 15, cusolverH, A.stream(), A.allocator());
+}
+
 /**
  * @brief A utility method to implement pointwise operations between elements
  *        of two batched matrices.
@@ -20,10 +20,28 @@
 #include <distance/distance.h>
 #include <linalg/cublas_wrappers.h>
 #include <linalg/gemm.h>
+#include <sparse/cusparse_wrappers.h>
+#include <memory>
+#include "common/device_buffer.hpp"
+#include "cuml/common/cuml_allocator.hpp"
 
 namespace MLCommon {
 namespace Matrix {
 
+/**
+ * A matrix in CSR format, that does not own its buffers. All pointers are
+ * device pointers.
+ */
+template <typename math_t>
+struct CsrMatrix {
+  const int *row_ptr;  //!< row offsets, size [n_rows + 1]
+  const int *col_ind;  //!< column indices, size [nnz]
+  const math_t *vals;  //!< values, size [nnz]
+  int nnz;             //!< number of stored values
+  int n_rows;          //!< number of rows
+  int n_cols;          //!< number of columns
+};
+
 /**
  * Base class for general Gram matrices
  * A Gram matrix is the Hermitian matrix of inner probucts G_ik = <x_i, x_k>
@@ -97,6 +115,30 @@ class GramMatrixBase {
     linear(x1, n1, n_cols, x2, n2, out, stream, ld1, ld2, ld_out);
   }
 
+  /** Evaluate the Gram matrix between the rows of a sparse matrix and a
+   * dense vector set.
+   *
+   * @param [in] x1 matrix in CSR format, its n1 = x1.n_rows rows are the
+   *   vectors of the first set, with n_cols = x1.n_cols features
+   * @param [in] x2 device array of vectors in column major format,
+   *   size [n2*n_cols]
+   * @param [in] n2 number vectors in x2
+   * @param [out] out device buffer to store the Gram matrix in column major
+   *   format, size [n1*n2]
+   * @param [in] cusparse_handle
+   * @param [in] allocator device allocator for temporary buffers
+   * @param [in] stream cuda stream
+   * @param ld2 leading dimension of x2 (usually it is n2)
+   * @param ld_out leading dimension of out (usually it is n1)
+   */
+  virtual void evaluateCsr(const CsrMatrix<math_t> &x1, const math_t *x2,
+                           int n2, math_t *out,
+                           cusparseHandle_t cusparse_handle,
+                           std::shared_ptr<deviceAllocator> allocator,
+                           cudaStream_t stream, int ld2, int ld_out) {
+    linearCsr(x1, x2, n2, out, cusparse_handle, stream, ld2, ld_out);
+  }
+
   //private:
   // The following methods should be private, they are kept public to avoid:
   // "error: The enclosing parent function ("distance") for an extended
@@ -129,6 +171,36 @@ class GramMatrixBase {
                                     out, ld_out, stream));
   }
 
+  /** Calculates the Gram matrix using simple dot product between the rows of
+   * a sparse matrix and a dense vector set, by a sparse matrix - dense matrix
+   * product.
+   *
+   * @param [in] x1 matrix in CSR format, size [n1 x n_cols]
+   * @param [in] x2 device array of vectors in column major format,
+   *   size [n2*n_cols]
+   * @param [in] n2 number vectors in x2
+   * @param [out] out device buffer to store the Gram matrix in column major
+   *   format, size [n1*n2]
+   * @param [in] cusparse_handle
+   * @param [in] stream cuda stream
+   * @param ld2 leading dimension of x2 (usually it is n2)
+   * @param ld_out leading dimension of out (usually it is n1)
+   */
+  void linearCsr(const CsrMatrix<math_t> &x1, const math_t *x2, int n2,
+                 math_t *out, cusparseHandle_t cusparse_handle,
+                 cudaStream_t stream, int ld2, int ld_out) {
+    math_t alpha = 1.0;
+    math_t beta = 0.0;
+    cusparseMatDescr_t descr;
+    CUSPARSE_CHECK(cusparseCreateMatDescr(&descr));
+    CUSPARSE_CHECK(Sparse::cusparse_csrmm2(
+      cusparse_handle, CUSPARSE_OPERATION_NON_TRANSPOSE,
+      CUSPARSE_OPERATION_TRANSPOSE, x1.n_rows, n2, x1.n_cols, x1.nnz, &alpha,
+      descr, x1.vals, x1.row_ptr, x1.col_ind, x2, ld2, &beta, out, ld_out,
+      stream));
+    CUSPARSE_CHECK(cusparseDestroyMatDescr(descr));
+  }
+
   /** Calculates the Gram matrix using Euclidean distance.
    *
    * Can be used as a building block for more complex kernel functions.
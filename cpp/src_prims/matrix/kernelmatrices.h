@@ -100,6 +100,65 @@ __global__ void tanh_kernel(math_t *inout, int ld, int rows, int cols,
     }
 }
 
+/** Squared L2 norm of the rows of a CSR matrix.
+ * @param row_ptr CSR row offsets, size [n_rows + 1]
+ * @param vals CSR values
+ * @param n_rows number of rows
+ * @param norm output, size [n_rows]
+ */
+template <typename math_t>
+__global__ void csr_row_norm_sq(const int *row_ptr, const math_t *vals,
+                                int n_rows, math_t *norm) {
+  int row = threadIdx.x + blockIdx.x * blockDim.x;
+  if (row >= n_rows) return;
+  math_t sum = 0;
+  for (int i = row_ptr[row]; i < row_ptr[row + 1]; i++) {
+    sum += vals[i] * vals[i];
+  }
+  norm[row] = sum;
+}
+
+/** Squared L2 norm of the rows of a dense column major matrix.
+ * @param x device array in column major format, size [ld * cols]
+ * @param ld leading dimension of x
+ * @param rows number of rows (rows <= ld)
+ * @param cols number of colums
+ * @param norm output, size [rows]
+ */
+template <typename math_t>
+__global__ void dense_row_norm_sq(const math_t *x, int ld, int rows, int cols,
+                                  math_t *norm) {
+  int row = threadIdx.x + blockIdx.x * blockDim.x;
+  if (row >= rows) return;
+  math_t sum = 0;
+  for (int c = 0; c < cols; c++) sum += x[row + c * ld] * x[row + c * ld];
+  norm[row] = sum;
+}
+
+/** Epiloge function for the RBF kernel of a matrix of dot products.
+ * Calculates output = exp(-gain * (norm1_i + norm2_k - 2 * input_ik))
+ * @param inout device vector in column major format, size [ld * cols]
+ * @param ld leading dimension of the inout buffer
+ * @param rows number of rows (rows <= ld)
+ * @param cols number of colums
+ * @param norm1 squared norm of the vectors of the rows, size [rows]
+ * @param norm2 squared norm of the vectors of the columns, size [cols]
+ * @param gain
+ */
+template <typename math_t>
+__global__ void rbf_kernel_expanded(math_t *inout, int ld, int rows, int cols,
+                                    const math_t *norm1, const math_t *norm2,
+                                    math_t gain) {
+  for (int tidy = threadIdx.y + blockIdx.y * blockDim.y; tidy < cols;
+       tidy += blockDim.y * gridDim.y)
+    for (int tidx = threadIdx.x + blockIdx.x * blockDim.x; tidx < rows;
+         tidx += blockDim.x * gridDim.x) {
+      math_t d = norm1[tidx] + norm2[tidy] - 2 * inout[tidx + tidy * ld];
+      // rounding can make the expanded squared distance slightly negative
+      inout[tidx + tidy * ld] = exp(-gain * (d > 0 ? d : 0));
+    }
+}
+
 /**
  * Create a kernel matrix using polynomial kernel function.
  */
@@ -168,6 +227,18 @@ class PolynomialKernel : public GramMatrixBase<math_t> {
                                    ld2, ld_out);
     applyKernel(out, ld_out, n1, n2, stream);
   }
+
+  /** Evaluate the polynomial kernel matrix between the rows of a CSR matrix
+   * and a dense vector set. See GramMatrixBase::evaluateCsr.
+   */
+  void evaluateCsr(const CsrMatrix<math_t> &x1, const math_t *x2, int n2,
+                   math_t *out, cusparseHandle_t cusparse_handle,
+                   std::shared_ptr<deviceAllocator> allocator,
+                   cudaStream_t stream, int ld2, int ld_out) {
+    GramMatrixBase<math_t>::linearCsr(x1, x2, n2, out, cusparse_handle, stream,
+                                      ld2, ld_out);
+    applyKernel(out, ld_out, x1.n_rows, n2, stream);
+  }
 };
 
 /**
@@ -230,6 +301,18 @@ class TanhKernel : public GramMatrixBase<math_t> {
                                    ld2, ld_out);
     applyKernel(out, ld_out, n1, n2, stream);
   }
+
+  /** Evaluate the tanh kernel matrix between the rows of a CSR matrix and a
+   * dense vector set. See GramMatrixBase::evaluateCsr.
+   */
+  void evaluateCsr(const CsrMatrix<math_t> &x1, const math_t *x2, int n2,
+                   math_t *out, cusparseHandle_t cusparse_handle,
+                   std::shared_ptr<deviceAllocator> allocator,
+                   cudaStream_t stream, int ld2, int ld_out) {
+    GramMatrixBase<math_t>::linearCsr(x1, x2, n2, out, cusparse_handle, stream,
+                                      ld2, ld_out);
+    applyKernel(out, ld_out, x1.n_rows, n2, stream);
+  }
 };
 
 /**
@@ -290,6 +373,34 @@ class RBFKernel : public GramMatrixBase<math_t> {
     distance(x1, n1, n_cols, x2, n2, out, stream, ld1, ld2, ld_out);
   }
 
+  /** Evaluate the RBF kernel matrix between the rows of a CSR matrix and a
+   * dense vector set. See GramMatrixBase::evaluateCsr.
+   *
+   * The squared distances are expanded as
+   * |x1_i - x2_k|^2 = |x1_i|^2 + |x2_k|^2 - 2 <x1_i, x2_k>, where the dot
+   * products come from a sparse matrix - dense matrix product.
+   */
+  void evaluateCsr(const CsrMatrix<math_t> &x1, const math_t *x2, int n2,
+                   math_t *out, cusparseHandle_t cusparse_handle,
+                   std::shared_ptr<deviceAllocator> allocator,
+                   cudaStream_t stream, int ld2, int ld_out) {
+    int n1 = x1.n_rows;
+    device_buffer<math_t> norm1(allocator, stream, n1);
+    device_buffer<math_t> norm2(allocator, stream, n2);
+    csr_row_norm_sq<<<ceildiv(n1, 128), 128, 0, stream>>>(
+      x1.row_ptr, x1.vals, n1, norm1.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+    dense_row_norm_sq<<<ceildiv(n2, 128), 128, 0, stream>>>(
+      x2, ld2, n2, x1.n_cols, norm2.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+    GramMatrixBase<math_t>::linearCsr(x1, x2, n2, out, cusparse_handle, stream,
+                                      ld2, ld_out);
+    rbf_kernel_expanded<<<dim3(ceildiv(n1, 32), min(ceildiv(n2, 4), 65535), 1),
+                          dim3(32, 4, 1), 0, stream>>>(
+      out, ld_out, n1, n2, norm1.data(), norm2.data(), gain);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+
   /** Customize distance function withe RBF epilogue */
   void distance(const math_t *x1, int n1, int n_cols, const math_t *x2, int n2,
                 math_t *out, cudaStream_t stream, int ld1, int ld2,
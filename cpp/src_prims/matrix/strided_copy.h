@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "cuda_utils.h"
+
+namespace MLCommon {
+namespace Matrix {
+
+static const int StridedCopyTile = 32;
+static const int StridedCopyRows = 8;
+
+// Copy of a tile of the matrix through shared memory, read along the unit
+// stride of the input and written along that of the output, so that both
+// sides are coalesced even when the copy transposes
+template <typename m_t>
+__global__ void stridedCopyKernel(m_t *out, int64_t outRowStride,
+                                  int64_t outColStride, const m_t *in,
+                                  int64_t inRowStride, int64_t inColStride,
+                                  int n_rows, int n_cols, bool inAlongCols,
+                                  bool outAlongCols) {
+  __shared__ m_t tile[StridedCopyTile][StridedCopyTile + 1];
+  int i0 = blockIdx.x * StridedCopyTile, j0 = blockIdx.y * StridedCopyTile;
+  for (int k = threadIdx.y; k < StridedCopyTile; k += StridedCopyRows) {
+    int di = inAlongCols ? k : threadIdx.x;
+    int dj = inAlongCols ? threadIdx.x : k;
+    int i = i0 + di, j = j0 + dj;
+    if (i < n_rows && j < n_cols) {
+      tile[di][dj] = in[i * inRowStride + j * inColStride];
+    }
+  }
+  __syncthreads();
+  for (int k = threadIdx.y; k < StridedCopyTile; k += StridedCopyRows) {
+    int di = outAlongCols ? k : threadIdx.x;
+    int dj = outAlongCols ? threadIdx.x : k;
+    int i = i0 + di, j = j0 + dj;
+    if (i < n_rows && j < n_cols) {
+      out[i * outRowStride + j * outColStride] = tile[di][dj];
+    }
+  }
+}
+
+/**
+ * @brief Copy a matrix between any two strided layouts, out(i, j) = in(i, j)
+ *
+ * Element (i, j) of a matrix is at data[i * rowStride + j * colStride]. When
+ * the unit strides of the input and of the output match, eg: padded to
+ * contiguous row-major, the copy is a 2D memcpy, else a tiled transposition.
+ *
+ * @param out the output matrix
+ * @param outRowStride, outColStride the strides of out, in elements
+ * @param in the input matrix
+ * @param inRowStride, inColStride the strides of in, in elements
+ * @param n_rows, n_cols the shape of the matrices
+ * @param stream cuda stream where to launch work
+ */
+template <typename m_t>
+void stridedCopy(m_t *out, int64_t outRowStride, int64_t outColStride,
+                 const m_t *in, int64_t inRowStride, int64_t inColStride,
+                 int n_rows, int n_cols, cudaStream_t stream) {
+  if (n_rows <= 0 || n_cols <= 0) return;
+  if (inColStride == 1 && outColStride == 1) {
+    CUDA_CHECK(cudaMemcpy2DAsync(out, outRowStride * sizeof(m_t), in,
+                                 inRowStride * sizeof(m_t),
+                                 n_cols * sizeof(m_t), n_rows,
+                                 cudaMemcpyDeviceToDevice, stream));
+    return;
+  }
+  if (inRowStride == 1 && outRowStride == 1) {
+    CUDA_CHECK(cudaMemcpy2DAsync(out, outColStride * sizeof(m_t), in,
+                                 inColStride * sizeof(m_t),
+                                 n_rows * sizeof(m_t), n_cols,
+                                 cudaMemcpyDeviceToDevice, stream));
+    return;
+  }
+  dim3 grid(ceildiv(n_rows, StridedCopyTile), ceildiv(n_cols, StridedCopyTile));
+  dim3 block(StridedCopyTile, StridedCopyRows);
+  stridedCopyKernel<m_t><<<grid, block, 0, stream>>>(
+    out, outRowStride, outColStride, in, inRowStride, inColStride, n_rows,
+    n_cols, inColStride == 1, outColStride == 1);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+};  // end namespace Matrix
+};  // end namespace MLCommon
@@ -70,25 +70,6 @@ double computeAdjustedRandIndex(
 
   int numUniqueClasses = upperLabelRange - lowerLabelRange + 1;
 
-  //declaring, allocating and initializing memory for the contingency marix
-  MLCommon::device_buffer<int> dContingencyMatrix(
-    allocator, stream, numUniqueClasses * numUniqueClasses);
-  CUDA_CHECK(cudaMemsetAsync(dContingencyMatrix.data(), 0,
-                             numUniqueClasses * numUniqueClasses * sizeof(int),
-                             stream));
-
-  //workspace allocation
-  char* pWorkspace = nullptr;
-  size_t workspaceSz = MLCommon::Metrics::getContingencyMatrixWorkspaceSize(
-    size, firstClusterArray, stream, lowerLabelRange, upperLabelRange);
-  if (workspaceSz != 0) MLCommon::allocate(pWorkspace, workspaceSz);
-
-  //calculating the contingency matrix
-  MLCommon::Metrics::contingencyMatrix(
-    firstClusterArray, secondClusterArray, (int)size,
-    (int*)dContingencyMatrix.data(), stream, (void*)pWorkspace, workspaceSz,
-    lowerLabelRange, upperLabelRange);
-
   //creating device buffers for all the parameters involved in ARI calculation
   //device variables
   MLCommon::device_buffer<int> a(allocator, stream, numUniqueClasses);
@@ -110,20 +91,56 @@ double computeAdjustedRandIndex(
   CUDA_CHECK(cudaMemsetAsync(d_bCTwoSum.data(), 0, sizeof(int), stream));
   CUDA_CHECK(cudaMemsetAsync(d_nChooseTwoSum.data(), 0, sizeof(int), stream));
 
-  //calculating the sum of NijC2
-  MLCommon::LinAlg::mapThenSumReduce<int, nCTwo<int>>(
-    d_nChooseTwoSum.data(), numUniqueClasses * numUniqueClasses, nCTwo<int>(),
-    stream, dContingencyMatrix.data(), dContingencyMatrix.data());
-
-  //calculating the row-wise sums
-  MLCommon::LinAlg::reduce<int, int, int>(a.data(), dContingencyMatrix.data(),
-                                          numUniqueClasses, numUniqueClasses, 0,
-                                          true, true, stream);
-
-  //calculating the column-wise sums
-  MLCommon::LinAlg::reduce<int, int, int>(b.data(), dContingencyMatrix.data(),
-                                          numUniqueClasses, numUniqueClasses, 0,
-                                          true, false, stream);
+  if (MLCommon::Metrics::useSparseContingencyMatrix(numUniqueClasses)) {
+    //the nonzeros of the contingency matrix, and its row and column sums
+    MLCommon::device_buffer<int> rows(allocator, stream, size);
+    MLCommon::device_buffer<int> cols(allocator, stream, size);
+    MLCommon::device_buffer<int> counts(allocator, stream, size);
+    int nnz = MLCommon::Metrics::sparseContingencyMatrix(
+      firstClusterArray, secondClusterArray, size, rows.data(), cols.data(),
+      counts.data(), lowerLabelRange, upperLabelRange, allocator, stream);
+    MLCommon::Metrics::sparseContingencyMarginals(
+      rows.data(), cols.data(), counts.data(), nnz, a.data(), b.data(), stream);
+
+    //calculating the sum of NijC2
+    MLCommon::LinAlg::mapThenSumReduce<int, nCTwo<int>>(
+      d_nChooseTwoSum.data(), nnz, nCTwo<int>(), stream, counts.data(),
+      counts.data());
+  } else {
+    //declaring, allocating and initializing memory for the contingency marix
+    MLCommon::device_buffer<int> dContingencyMatrix(
+      allocator, stream, numUniqueClasses * numUniqueClasses);
+    CUDA_CHECK(cudaMemsetAsync(
+      dContingencyMatrix.data(), 0,
+      numUniqueClasses * numUniqueClasses * sizeof(int), stream));
+
+    //workspace allocation
+    size_t workspaceSz = MLCommon::Metrics::getContingencyMatrixWorkspaceSize(
+      size, firstClusterArray, stream, lowerLabelRange, upperLabelRange);
+    MLCommon::device_buffer<char> pWorkspace(allocator, stream, workspaceSz);
+
+    //calculating the contingency matrix
+    MLCommon::Metrics::contingencyMatrix(
+      firstClusterArray, secondClusterArray, (int)size,
+      (int*)dContingencyMatrix.data(), stream, (void*)pWorkspace.data(),
+      workspaceSz, lowerLabelRange, upperLabelRange);
+
+    //calculating the sum of NijC2
+    MLCommon::LinAlg::mapThenSumReduce<int, nCTwo<int>>(
+      d_nChooseTwoSum.data(), numUniqueClasses * numUniqueClasses,
+      nCTwo<int>(), stream, dContingencyMatrix.data(),
+      dContingencyMatrix.data());
+
+    //calculating the row-wise sums
+    MLCommon::LinAlg::reduce<int, int, int>(
+      a.data(), dContingencyMatrix.data(), numUniqueClasses, numUniqueClasses,
+      0, true, true, stream);
+
+    //calculating the column-wise sums
+    MLCommon::LinAlg::reduce<int, int, int>(
+      b.data(), dContingencyMatrix.data(), numUniqueClasses, numUniqueClasses,
+      0, true, false, stream);
+  }
 
   //calculating the sum of number of unordered pairs for every element in a
   MLCommon::LinAlg::mapThenSumReduce<int, nCTwo<int>>(
@@ -139,9 +156,7 @@ double computeAdjustedRandIndex(
   MLCommon::updateHost(&h_nChooseTwoSum, d_nChooseTwoSum.data(), 1, stream);
   MLCommon::updateHost(&h_aCTwoSum, d_aCTwoSum.data(), 1, stream);
   MLCommon::updateHost(&h_bCTwoSum, d_bCTwoSum.data(), 1, stream);
-
-  //freeing the memories in the device
-  if (pWorkspace) CUDA_CHECK(cudaFree(pWorkspace));
+  CUDA_CHECK(cudaStreamSynchronize(stream));
 
   //calculating the ARI
   int nChooseTwo = ((size) * (size - 1)) / 2;
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+* @file clusteringScores.h
+* @brief The scores comparing two labelings which derive from their
+* contingency matrix: the adjusted Rand index, the mutual information, the
+* homogeneity, the completeness and the V-measure, all from a single
+* contingency matrix and its marginals.
+*/
+
+#pragma once
+
+#include <math.h>
+#include <cub/cub.cuh>
+#include <cuml/common/cuml_allocator.hpp>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "linalg/reduce.h"
+#include "metrics/contingencyMatrix.h"
+
+namespace MLCommon {
+namespace Metrics {
+
+/**
+ * @brief the scores of a labeling against the ground truth
+ */
+struct ClusteringScores {
+  double adjustedRandIndex;
+  double mutualInfo;
+  double homogeneity;
+  double completeness;
+  double vMeasure;
+};
+
+/**
+ * @brief kernel accumulating, over the nonzeros of a contingency matrix, the
+ * sum of their unordered pairs and the unnormalized mutual information
+ * @param counts: the values of the entries of the contingency matrix
+ * @param rows: the rows of the entries, or nullptr if counts is dense
+ * @param cols: the columns of the entries, or nullptr if counts is dense
+ * @param nnz: the number of entries
+ * @param numUniqueClasses: the width of the dense contingency matrix
+ * @param a: the row wise sum of the contingency matrix
+ * @param b: the column wise sum of the contingency matrix
+ * @param size: the number of samples
+ * @param sums: the sum of pairs and the mutual information, accumulated
+ */
+template <int TPB_X>
+__global__ void contingencyEntrySumsKernel(const int *counts, const int *rows,
+                                           const int *cols, int nnz,
+                                           int numUniqueClasses, const int *a,
+                                           const int *b, int size,
+                                           double *sums) {
+  int e = threadIdx.x + blockIdx.x * TPB_X;
+  double pairs = 0.0, mi = 0.0;
+  if (e < nnz && counts[e] > 0) {
+    double nij = counts[e];
+    int i = rows ? rows[e] : e / numUniqueClasses;
+    int j = cols ? cols[e] : e % numUniqueClasses;
+    pairs = nij * (nij - 1) / 2;
+    mi = nij * (log(double(size) * nij) - log(double(a[i]) * double(b[j])));
+  }
+
+  typedef cub::BlockReduce<double, TPB_X> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+  pairs = BlockReduce(temp_storage).Sum(pairs);
+  __syncthreads();
+  mi = BlockReduce(temp_storage).Sum(mi);
+
+  if (threadIdx.x == 0) {
+    myAtomicAdd(sums, pairs);
+    myAtomicAdd(sums + 1, mi);
+  }
+}
+
+/**
+ * @brief kernel accumulating, over the classes, the sums of the unordered
+ * pairs and the entropies of the row and column sums of a contingency matrix
+ * @param a: the row wise sum of the contingency matrix
+ * @param b: the column wise sum of the contingency matrix
+ * @param numUniqueClasses: the size of a and b
+ * @param size: the number of samples
+ * @param sums: the pairs of a, of b, and the entropies of a, of b,
+ * accumulated
+ */
+template <int TPB_X>
+__global__ void contingencyMarginalSumsKernel(const int *a, const int *b,
+                                              int numUniqueClasses, int size,
+                                              double *sums) {
+  int i = threadIdx.x + blockIdx.x * TPB_X;
+  double vals[4] = {0.0, 0.0, 0.0, 0.0};
+  if (i < numUniqueClasses) {
+    double ai = a[i], bi = b[i];
+    vals[0] = ai * (ai - 1) / 2;
+    vals[1] = bi * (bi - 1) / 2;
+    if (ai > 0) vals[2] = -(ai / size) * log(ai / size);
+    if (bi > 0) vals[3] = -(bi / size) * log(bi / size);
+  }
+
+  typedef cub::BlockReduce<double, TPB_X> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+#pragma unroll
+  for (int s = 0; s < 4; s++) {
+    double sum = BlockReduce(temp_storage).Sum(vals[s]);
+    if (threadIdx.x == 0) myAtomicAdd(sums + s, sum);
+    __syncthreads();
+  }
+}
+
+/**
+* @brief Function to calculate the adjusted Rand index, the mutual
+* information, the homogeneity, the completeness and the V-measure of a
+* labeling against the ground truth. The contingency matrix, sparse for
+* many classes as in mutualInfoScore, and its marginals are computed once
+* for all the scores, with a single synchronization.
+* @param truthClusterArray: the array of truth classes of type T
+* @param predClusterArray: the array of predicted classes of type T
+* @param size: the size of the data points of type int
+* @param lowerLabelRange: the lower bound of the range of labels
+* @param upperLabelRange: the upper bound of the range of labels
+* @param allocator: object that takes care of temporary device memory allocation of type std::shared_ptr<MLCommon::deviceAllocator>
+* @param stream: the cudaStream object
+* @param beta: the weight of the homogeneity against the completeness in the V-measure
+*/
+template <typename T>
+ClusteringScores clusteringScores(
+  const T *truthClusterArray, const T *predClusterArray, int size,
+  T lowerLabelRange, T upperLabelRange,
+  std::shared_ptr<MLCommon::deviceAllocator> allocator, cudaStream_t stream,
+  double beta = 1.0) {
+  //rand index for size less than 2 is not defined
+  ASSERT(size >= 2, "Rand Index for size less than 2 not defined!");
+
+  int numUniqueClasses = upperLabelRange - lowerLabelRange + 1;
+  static const int TPB_X = 256;
+
+  MLCommon::device_buffer<int> a(allocator, stream, numUniqueClasses);
+  MLCommon::device_buffer<int> b(allocator, stream, numUniqueClasses);
+  MLCommon::device_buffer<double> d_sums(allocator, stream, 6);
+  CUDA_CHECK(
+    cudaMemsetAsync(a.data(), 0, numUniqueClasses * sizeof(int), stream));
+  CUDA_CHECK(
+    cudaMemsetAsync(b.data(), 0, numUniqueClasses * sizeof(int), stream));
+  CUDA_CHECK(cudaMemsetAsync(d_sums.data(), 0, 6 * sizeof(double), stream));
+
+  if (useSparseContingencyMatrix(numUniqueClasses)) {
+    MLCommon::device_buffer<int> rows(allocator, stream, size);
+    MLCommon::device_buffer<int> cols(allocator, stream, size);
+    MLCommon::device_buffer<int> counts(allocator, stream, size);
+    int nnz = sparseContingencyMatrix(
+      truthClusterArray, predClusterArray, size, rows.data(), cols.data(),
+      counts.data(), lowerLabelRange, upperLabelRange, allocator, stream);
+    sparseContingencyMarginals(rows.data(), cols.data(), counts.data(), nnz,
+                               a.data(), b.data(), stream);
+    contingencyEntrySumsKernel<TPB_X>
+      <<<ceildiv<int>(nnz, TPB_X), TPB_X, 0, stream>>>(
+        counts.data(), rows.data(), cols.data(), nnz, numUniqueClasses,
+        a.data(), b.data(), size, d_sums.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+  } else {
+    int nnz = numUniqueClasses * numUniqueClasses;
+    MLCommon::device_buffer<int> dContingencyMatrix(allocator, stream, nnz);
+    size_t workspaceSz = getContingencyMatrixWorkspaceSize(
+      size, truthClusterArray, stream, lowerLabelRange, upperLabelRange);
+    MLCommon::device_buffer<char> pWorkspace(allocator, stream, workspaceSz);
+    contingencyMatrix(truthClusterArray, predClusterArray, size,
+                      dContingencyMatrix.data(), stream,
+                      (void *)pWorkspace.data(), workspaceSz, lowerLabelRange,
+                      upperLabelRange);
+
+    //calculating the row-wise and column-wise sums
+    MLCommon::LinAlg::reduce<int, int, int>(
+      a.data(), dContingencyMatrix.data(), numUniqueClasses, numUniqueClasses,
+      0, true, true, stream);
+    MLCommon::LinAlg::reduce<int, int, int>(
+      b.data(), dContingencyMatrix.data(), numUniqueClasses, numUniqueClasses,
+      0, true, false, stream);
+    contingencyEntrySumsKernel<TPB_X>
+      <<<ceildiv<int>(nnz, TPB_X), TPB_X, 0, stream>>>(
+        dContingencyMatrix.data(), nullptr, nullptr, nnz, numUniqueClasses,
+        a.data(), b.data(), size, d_sums.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+
+  contingencyMarginalSumsKernel<TPB_X>
+    <<<ceildiv<int>(numUniqueClasses, TPB_X), TPB_X, 0, stream>>>(
+      a.data(), b.data(), numUniqueClasses, size, d_sums.data() + 2);
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  double h_sums[6];
+  MLCommon::updateHost(h_sums, d_sums.data(), 6, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  double nijCTwoSum = h_sums[0], aCTwoSum = h_sums[2], bCTwoSum = h_sums[3];
+  double truthEntropy = h_sums[4], predEntropy = h_sums[5];
+
+  ClusteringScores scores;
+
+  //calculating the ARI
+  double nChooseTwo = double(size) * (size - 1) / 2;
+  double expectedIndex = aCTwoSum * bCTwoSum / nChooseTwo;
+  double maxIndex = (aCTwoSum + bCTwoSum) / 2;
+  if (maxIndex - expectedIndex)
+    scores.adjustedRandIndex =
+      (nijCTwoSum - expectedIndex) / (maxIndex - expectedIndex);
+  else
+    scores.adjustedRandIndex = 0;
+
+  scores.mutualInfo = h_sums[1] / size;
+  scores.homogeneity = truthEntropy ? scores.mutualInfo / truthEntropy : 1.0;
+  scores.completeness = predEntropy ? scores.mutualInfo / predEntropy : 1.0;
+
+  if (scores.completeness + scores.homogeneity == 0.0)
+    scores.vMeasure = 0.0;
+  else
+    scores.vMeasure = (1 + beta) * scores.homogeneity * scores.completeness /
+                      (beta * scores.homogeneity + scores.completeness);
+
+  return scores;
+}
+
+};  //end namespace Metrics
+};  //end namespace MLCommon
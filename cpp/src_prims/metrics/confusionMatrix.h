@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+* @file confusionMatrix.h
+* @brief The confusion matrix counts, for every pair of classes (i, j), the
+* samples of true class i which were predicted as class j.
+*/
+
+#pragma once
+
+#include "cuda_utils.h"
+#include "stats/histogram.h"
+
+namespace MLCommon {
+namespace Metrics {
+
+/**
+* @brief the binner of the histogram of ground truth labels mapping each
+* sample to its (true class, predicted class) entry of the confusion matrix
+*
+* @tparam T: the type of the labels
+*/
+template <typename T>
+struct ConfusionMatrixBinner {
+  const T *predicted;
+  T lowerLabelRange;
+  int nClasses;
+
+  DI int operator()(T truth, int row, int col) {
+    return int(truth - lowerLabelRange) * nClasses +
+           int(predicted[row] - lowerLabelRange);
+  }
+};
+
+/**
+* @brief Function to calculate the confusion matrix of predicted labels
+* against the ground truth, as the histogram of the pairs of labels
+*
+* @tparam T: the type of the labels
+* @param groundTruth: the array of true labels of type T
+* @param predicted: the array of predicted labels of type T
+* @param nSamples: the number of samples
+* @param outMat: the output row major confusion matrix, of nClasses x nClasses
+* with nClasses = upperLabelRange - lowerLabelRange + 1; its entry (i, j) is
+* the number of samples of true class i predicted as class j
+* @param lowerLabelRange: the lowest value in the range of labels
+* @param upperLabelRange: the highest value in the range of labels
+* @param stream: the cudaStream object
+*/
+template <typename T>
+void confusionMatrix(const T *groundTruth, const T *predicted, int nSamples,
+                     int *outMat, T lowerLabelRange, T upperLabelRange,
+                     cudaStream_t stream) {
+  int nClasses = upperLabelRange - lowerLabelRange + 1;
+  ConfusionMatrixBinner<T> binner = {predicted, lowerLabelRange, nClasses};
+  Stats::histogram<T, int, ConfusionMatrixBinner<T>>(
+    Stats::HistTypeAuto, outMat, nClasses * nClasses, groundTruth, nSamples, 1,
+    stream, binner);
+}
+
+};  //end namespace Metrics
+};  //end namespace MLCommon
@@ -19,7 +19,11 @@
 #include <math.h>
 #include <thrust/device_ptr.h>
 #include <thrust/reduce.h>
+#include <algorithm>
+#include <cstdint>
 #include <cub/cub.cuh>
+#include <cuml/common/cuml_allocator.hpp>
+#include "common/device_buffer.hpp"
 #include "cuda_utils.h"
 
 namespace MLCommon {
@@ -308,5 +312,141 @@ void contingencyMatrix(const T *groundTruth, const T *predictedLabel,
       break;
   }
 }
+
+/**
+ * @brief whether the metrics built on the contingency matrix should use its
+ * sparse form: when the dense matrix does not fit in L2, the dense path sorts
+ * the samples anyway, and its size grows quadratically with the number of
+ * classes while the sparse one is bounded by the number of samples
+ * @param nUniqueClasses: number of classes, maxLabel - minLabel + 1
+ */
+inline bool useSparseContingencyMatrix(int nUniqueClasses) {
+  return getImplVersion(nUniqueClasses) == SORT_AND_GATOMICS;
+}
+
+template <typename T>
+__global__ void devEncodeLabelPairs(const T *groundTruth, const T *predicted,
+                                    const int nSamples, T minLabel,
+                                    uint64_t nUniqueClasses, uint64_t *keys) {
+  int elementId = threadIdx.x + blockDim.x * blockIdx.x;
+  if (elementId < nSamples) {
+    keys[elementId] = uint64_t(groundTruth[elementId] - minLabel) *
+                        nUniqueClasses +
+                      uint64_t(predicted[elementId] - minLabel);
+  }
+}
+
+template <typename IdxT>
+__global__ void devDecodeLabelPairs(const uint64_t *keys, const IdxT *nnz,
+                                    uint64_t nUniqueClasses, IdxT *rows,
+                                    IdxT *cols) {
+  int elementId = threadIdx.x + blockDim.x * blockIdx.x;
+  if (elementId < *nnz) {
+    rows[elementId] = IdxT(keys[elementId] / nUniqueClasses);
+    cols[elementId] = IdxT(keys[elementId] % nUniqueClasses);
+  }
+}
+
+template <typename IdxT>
+__global__ void devSparseContingencyMarginals(const IdxT *rows,
+                                              const IdxT *cols,
+                                              const int *counts, const int nnz,
+                                              int *rowSums, int *colSums) {
+  int elementId = threadIdx.x + blockDim.x * blockIdx.x;
+  if (elementId < nnz) {
+    myAtomicAdd(&rowSums[rows[elementId]], counts[elementId]);
+    myAtomicAdd(&colSums[cols[elementId]], counts[elementId]);
+  }
+}
+
+/**
+ * @brief contruct the nonzeros of the contingency matrix, in COO form sorted
+ * by row then column. The (groundTruth, predictedLabel) pairs are encoded in
+ * a 64b key each, radix sorted and run-length encoded, so that the memory is
+ * linear in nSamples whatever the number of classes.
+ * @param groundTruth: device 1-d array for ground truth (num of rows)
+ * @param predictedLabel: device 1-d array for prediction (num of columns)
+ * @param nSamples: number of elements in input array
+ * @param rows: output rows of the nonzeros, groundTruth - minLabel (nSamples)
+ * @param cols: output columns of the nonzeros, predictedLabel - minLabel
+ * (nSamples)
+ * @param counts: output values of the nonzeros (nSamples)
+ * @param minLabel: min value in input arrays
+ * @param maxLabel: max value in input arrays
+ * @param allocator: device allocator for the temporary buffers
+ * @param stream: cuda stream for execution
+ * @return the number of nonzeros
+ */
+template <typename T>
+int sparseContingencyMatrix(const T *groundTruth, const T *predictedLabel,
+                            const int nSamples, int *rows, int *cols,
+                            int *counts, T minLabel, T maxLabel,
+                            std::shared_ptr<deviceAllocator> allocator,
+                            cudaStream_t stream) {
+  uint64_t nUniqueClasses = uint64_t(maxLabel - minLabel) + 1;
+  int bitsToSort = 0;
+  while (bitsToSort < 64 &&
+         (uint64_t(1) << bitsToSort) < nUniqueClasses * nUniqueClasses)
+    bitsToSort++;
+
+  device_buffer<uint64_t> keys(allocator, stream, nSamples);
+  device_buffer<uint64_t> sortedKeys(allocator, stream, nSamples);
+  device_buffer<int> nnz(allocator, stream, 1);
+  dim3 block(128, 1, 1);
+  dim3 grid((nSamples + block.x - 1) / block.x);
+  devEncodeLabelPairs<<<grid, block, 0, stream>>>(
+    groundTruth, predictedLabel, nSamples, minLabel, nUniqueClasses,
+    keys.data());
+  CUDA_CHECK(cudaGetLastError());
+
+  size_t sortBytes = 0, encodeBytes = 0;
+  CUDA_CHECK(cub::DeviceRadixSort::SortKeys(nullptr, sortBytes, keys.data(),
+                                            sortedKeys.data(), nSamples, 0,
+                                            bitsToSort, stream));
+  CUDA_CHECK(cub::DeviceRunLengthEncode::Encode(
+    nullptr, encodeBytes, sortedKeys.data(), keys.data(), counts, nnz.data(),
+    nSamples, stream));
+  device_buffer<char> workspace(allocator, stream,
+                                std::max(sortBytes, encodeBytes));
+  CUDA_CHECK(cub::DeviceRadixSort::SortKeys(workspace.data(), sortBytes,
+                                            keys.data(), sortedKeys.data(),
+                                            nSamples, 0, bitsToSort, stream));
+  // the unique keys overwrite the unsorted ones
+  CUDA_CHECK(cub::DeviceRunLengthEncode::Encode(
+    workspace.data(), encodeBytes, sortedKeys.data(), keys.data(), counts,
+    nnz.data(), nSamples, stream));
+
+  devDecodeLabelPairs<<<grid, block, 0, stream>>>(keys.data(), nnz.data(),
+                                                  nUniqueClasses, rows, cols);
+  CUDA_CHECK(cudaGetLastError());
+
+  int h_nnz;
+  updateHost(&h_nnz, nnz.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  return h_nnz;
+}
+
+/**
+ * @brief the row and column sums of a sparse contingency matrix, the bin
+ * counts of the ground truth and predicted labels
+ * @param rows: rows of the nonzeros (nnz)
+ * @param cols: columns of the nonzeros (nnz)
+ * @param counts: values of the nonzeros (nnz)
+ * @param nnz: number of nonzeros
+ * @param rowSums: output row sums, zeroed by the caller (nUniqueClasses)
+ * @param colSums: output column sums, zeroed by the caller (nUniqueClasses)
+ * @param stream: cuda stream for execution
+ */
+template <typename IdxT>
+void sparseContingencyMarginals(const IdxT *rows, const IdxT *cols,
+                                const int *counts, const int nnz, int *rowSums,
+                                int *colSums, cudaStream_t stream) {
+  if (nnz == 0) return;
+  dim3 block(128, 1, 1);
+  dim3 grid((nnz + block.x - 1) / block.x);
+  devSparseContingencyMarginals<<<grid, block, 0, stream>>>(
+    rows, cols, counts, nnz, rowSums, colSums);
+  CUDA_CHECK(cudaGetLastError());
+}
 };  // namespace Metrics
 };  // namespace MLCommon
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+* @file logLoss.h
+* @brief The log loss, or cross-entropy loss, is the mean negative
+* log-likelihood of the true labels under the predicted probabilities.
+*/
+
+#pragma once
+
+#include <math.h>
+#include <cub/cub.cuh>
+#include <cuml/common/cuml_allocator.hpp>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+
+namespace MLCommon {
+namespace Metrics {
+
+/**
+* @brief kernel accumulating the negative log of the predicted probability of
+* the true label of each sample, clipped to [eps, 1 - eps]
+* @param truth: the true labels, in [0, nClasses)
+* @param probs: the row major predicted probabilities, of nSamples x nClasses
+* @param nSamples: the number of samples
+* @param nClasses: the number of classes
+* @param eps: the clipping bound of the probabilities
+* @param loss: the sum of the negative log-likelihoods, accumulated
+*/
+template <typename T, typename DataT, int TPB_X>
+__global__ void logLossKernel(const T *truth, const DataT *probs, int nSamples,
+                              int nClasses, double eps, double *loss) {
+  int i = threadIdx.x + blockIdx.x * TPB_X;
+  double nll = 0.0;
+  if (i < nSamples) {
+    double p = probs[(size_t)i * nClasses + int(truth[i])];
+    nll = -log(min(max(p, eps), 1.0 - eps));
+  }
+
+  typedef cub::BlockReduce<double, TPB_X> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+  nll = BlockReduce(temp_storage).Sum(nll);
+  if (threadIdx.x == 0) myAtomicAdd(loss, nll);
+}
+
+/**
+* @brief Function to calculate the log loss of predicted class probabilities
+* against the true labels. As the probabilities are clipped to
+* [eps, 1 - eps], a sure but wrong prediction costs -log(eps) rather than an
+* infinite loss. For a binary classifier, the probabilities are those of
+* both classes, with nClasses = 2.
+*
+* @tparam T: the type of the labels
+* @tparam DataT: the type of the probabilities
+* @param truth: the array of true labels, in [0, nClasses)
+* @param probs: the row major predicted probabilities, of nSamples x nClasses
+* @param nSamples: the number of samples
+* @param nClasses: the number of classes
+* @param allocator: object that takes care of temporary device memory allocation of type std::shared_ptr<MLCommon::deviceAllocator>
+* @param stream: the cudaStream object
+* @param eps: the clipping bound of the probabilities
+* @return the mean negative log-likelihood
+*/
+template <typename T, typename DataT>
+double logLoss(const T *truth, const DataT *probs, int nSamples, int nClasses,
+               std::shared_ptr<MLCommon::deviceAllocator> allocator,
+               cudaStream_t stream, double eps = 1e-15) {
+  static const int TPB_X = 256;
+  ASSERT(nSamples >= 1, "Log loss for size less than 1 not defined!");
+
+  MLCommon::device_buffer<double> d_loss(allocator, stream, 1);
+  CUDA_CHECK(cudaMemsetAsync(d_loss.data(), 0, sizeof(double), stream));
+  logLossKernel<T, DataT, TPB_X>
+    <<<ceildiv<int>(nSamples, TPB_X), TPB_X, 0, stream>>>(
+      truth, probs, nSamples, nClasses, eps, d_loss.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  double h_loss;
+  MLCommon::updateHost(&h_loss, d_loss.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  return h_loss / nSamples;
+}
+
+};  //end namespace Metrics
+};  //end namespace MLCommon
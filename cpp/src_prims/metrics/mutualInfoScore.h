@@ -81,6 +81,41 @@ __global__ void mutualInfoKernel(const int *dContingencyMatrix, const int *a,
   }
 }
 
+/**
+ * @brief kernel to calculate the mutual info score from the nonzeros of a
+ * sparse contingency matrix
+ * @param rows: the rows of the nonzeros of the contingency matrix
+ * @param cols: the columns of the nonzeros of the contingency matrix
+ * @param counts: the values of the nonzeros of the contingency matrix
+ * @param nnz: the number of nonzeros
+ * @param a: the row wise sum of the contingency matrix
+ * @param b: the column wise sum of the contingency matrix
+ * @param size: the number of samples
+ * @param d_MI: pointer to the device memory that stores the aggreggate mutual information
+ */
+template <int BLOCK_DIM_X>
+__global__ void sparseMutualInfoKernel(const int *rows, const int *cols,
+                                       const int *counts, int nnz,
+                                       const int *a, const int *b, int size,
+                                       double *d_MI) {
+  int e = threadIdx.x + blockIdx.x * blockDim.x;
+
+  //thread-local variable to count the mutual info
+  double localMI = 0.0;
+  if (e < nnz) {
+    double nij = counts[e];
+    localMI = nij * (log(double(size) * nij) -
+                     log(double(a[rows[e]]) * double(b[cols[e]])));
+  }
+
+  typedef cub::BlockReduce<double, BLOCK_DIM_X> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+  localMI = BlockReduce(temp_storage).Sum(localMI);
+
+  //executed once per block
+  if (threadIdx.x == 0) myAtomicAdd(d_MI, localMI);
+}
+
 /**
 * @brief Function to calculate the mutual information between two clusters
 * <a href="https://en.wikipedia.org/wiki/Mutual_information">more info on mutual information</a> 
@@ -100,24 +135,6 @@ double mutualInfoScore(const T *firstClusterArray, const T *secondClusterArray,
                        cudaStream_t stream) {
   int numUniqueClasses = upperLabelRange - lowerLabelRange + 1;
 
-  //declaring, allocating and initializing memory for the contingency marix
-  MLCommon::device_buffer<int> dContingencyMatrix(
-    allocator, stream, numUniqueClasses * numUniqueClasses);
-  CUDA_CHECK(cudaMemsetAsync(dContingencyMatrix.data(), 0,
-                             numUniqueClasses * numUniqueClasses * sizeof(int),
-                             stream));
-
-  //workspace allocation
-  size_t workspaceSz = MLCommon::Metrics::getContingencyMatrixWorkspaceSize(
-    size, firstClusterArray, stream, lowerLabelRange, upperLabelRange);
-  device_buffer<char> pWorkspace(allocator, stream, workspaceSz);
-
-  //calculating the contingency matrix
-  MLCommon::Metrics::contingencyMatrix(
-    firstClusterArray, secondClusterArray, (int)size,
-    (int *)dContingencyMatrix.data(), stream, (void *)pWorkspace.data(),
-    workspaceSz, lowerLabelRange, upperLabelRange);
-
   //creating device buffers for all the parameters involved in ARI calculation
   //device variables
   MLCommon::device_buffer<int> a(allocator, stream, numUniqueClasses);
@@ -134,27 +151,64 @@ double mutualInfoScore(const T *firstClusterArray, const T *secondClusterArray,
     cudaMemsetAsync(b.data(), 0, numUniqueClasses * sizeof(int), stream));
   CUDA_CHECK(cudaMemsetAsync(d_MI.data(), 0, sizeof(double), stream));
 
-  //calculating the row-wise sums
-  MLCommon::LinAlg::reduce<int, int, int>(a.data(), dContingencyMatrix.data(),
-                                          numUniqueClasses, numUniqueClasses, 0,
-                                          true, true, stream);
-
-  //calculating the column-wise sums
-  MLCommon::LinAlg::reduce<int, int, int>(b.data(), dContingencyMatrix.data(),
-                                          numUniqueClasses, numUniqueClasses, 0,
-                                          true, false, stream);
-
-  //kernel configuration
-  static const int BLOCK_DIM_Y = 16, BLOCK_DIM_X = 16;
-  dim3 numThreadsPerBlock(BLOCK_DIM_X, BLOCK_DIM_Y);
-  dim3 numBlocks(ceildiv<int>(size, numThreadsPerBlock.x),
-                 ceildiv<int>(size, numThreadsPerBlock.y));
-
-  //calling the kernel
-  mutualInfoKernel<T, BLOCK_DIM_X, BLOCK_DIM_Y>
-    <<<numBlocks, numThreadsPerBlock, 0, stream>>>(
-      dContingencyMatrix.data(), a.data(), b.data(), numUniqueClasses, size,
-      d_MI.data());
+  if (MLCommon::Metrics::useSparseContingencyMatrix(numUniqueClasses)) {
+    //the nonzeros of the contingency matrix, and its row and column sums
+    MLCommon::device_buffer<int> rows(allocator, stream, size);
+    MLCommon::device_buffer<int> cols(allocator, stream, size);
+    MLCommon::device_buffer<int> counts(allocator, stream, size);
+    int nnz = MLCommon::Metrics::sparseContingencyMatrix(
+      firstClusterArray, secondClusterArray, size, rows.data(), cols.data(),
+      counts.data(), lowerLabelRange, upperLabelRange, allocator, stream);
+    MLCommon::Metrics::sparseContingencyMarginals(
+      rows.data(), cols.data(), counts.data(), nnz, a.data(), b.data(), stream);
+
+    static const int BLOCK_DIM_X = 256;
+    sparseMutualInfoKernel<BLOCK_DIM_X>
+      <<<ceildiv<int>(nnz, BLOCK_DIM_X), BLOCK_DIM_X, 0, stream>>>(
+        rows.data(), cols.data(), counts.data(), nnz, a.data(), b.data(), size,
+        d_MI.data());
+    CUDA_CHECK(cudaPeekAtLastError());
+  } else {
+    //declaring, allocating and initializing memory for the contingency marix
+    MLCommon::device_buffer<int> dContingencyMatrix(
+      allocator, stream, numUniqueClasses * numUniqueClasses);
+    CUDA_CHECK(cudaMemsetAsync(
+      dContingencyMatrix.data(), 0,
+      numUniqueClasses * numUniqueClasses * sizeof(int), stream));
+
+    //workspace allocation
+    size_t workspaceSz = MLCommon::Metrics::getContingencyMatrixWorkspaceSize(
+      size, firstClusterArray, stream, lowerLabelRange, upperLabelRange);
+    device_buffer<char> pWorkspace(allocator, stream, workspaceSz);
+
+    //calculating the contingency matrix
+    MLCommon::Metrics::contingencyMatrix(
+      firstClusterArray, secondClusterArray, (int)size,
+      (int *)dContingencyMatrix.data(), stream, (void *)pWorkspace.data(),
+      workspaceSz, lowerLabelRange, upperLabelRange);
+
+    //calculating the row-wise sums
+    MLCommon::LinAlg::reduce<int, int, int>(
+      a.data(), dContingencyMatrix.data(), numUniqueClasses, numUniqueClasses,
+      0, true, true, stream);
+
+    //calculating the column-wise sums
+    MLCommon::LinAlg::reduce<int, int, int>(
+      b.data(), dContingencyMatrix.data(), numUniqueClasses, numUniqueClasses,
+      0, true, false, stream);
+
+    //kernel configuration
+    static const int BLOCK_DIM_Y = 16, BLOCK_DIM_X = 16;
+    dim3 numThreadsPerBlock(BLOCK_DIM_X, BLOCK_DIM_Y);
+    dim3 numBlocks(ceildiv<int>(size, numThreadsPerBlock.x),
+                   ceildiv<int>(size, numThreadsPerBlock.y));
+
+    //calling the kernel
+    mutualInfoKernel<T, BLOCK_DIM_X, BLOCK_DIM_Y>
+      <<<numBlocks, numThreadsPerBlock, 0, stream>>>(
+        dContingencyMatrix.data(), a.data(), b.data(), numUniqueClasses, size,
+        d_MI.data());
+  }
 
   //updating in the host memory
   MLCommon::updateHost(&h_MI, d_MI.data(), 1, stream);
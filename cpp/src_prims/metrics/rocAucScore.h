@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+* @file rocAucScore.h
+* @brief The area under the ROC curve of a binary classifier, the probability
+* that a random positive sample scores higher than a random negative one.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cub/cub.cuh>
+#include <cuml/common/cuml_allocator.hpp>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+
+namespace MLCommon {
+namespace Metrics {
+
+/**
+* @brief maps a binary label to 1 for the positive class, 0 otherwise
+*/
+template <typename T>
+struct IsPositiveOp {
+  HDI int operator()(T label) const { return label != T(0); }
+};
+
+/**
+* @brief maps a binary label to 1 for the negative class, 0 otherwise
+*/
+template <typename T>
+struct IsNegativeOp {
+  HDI int operator()(T label) const { return label == T(0); }
+};
+
+/**
+* @brief kernel accumulating, over the runs of equal sorted scores, the
+* positives times the negatives scoring lower, ties counting half, and the
+* positives
+* @param runPositives: the number of positive samples of each run
+* @param runNegatives: the number of negative samples of each run
+* @param negativesBefore: the number of negative samples of the lower runs
+* @param nRuns: the number of runs, on the device
+* @param sums: the sum of positive-negative pairs and the positives,
+* accumulated
+*/
+template <int TPB_X>
+__global__ void rocAucRunSumsKernel(const int *runPositives,
+                                    const int *runNegatives,
+                                    const int *negativesBefore,
+                                    const int *nRuns, double *sums) {
+  int r = threadIdx.x + blockIdx.x * TPB_X;
+  double pairs = 0.0, positives = 0.0;
+  if (r < *nRuns) {
+    positives = runPositives[r];
+    pairs = positives * (negativesBefore[r] + 0.5 * runNegatives[r]);
+  }
+
+  typedef cub::BlockReduce<double, TPB_X> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+  pairs = BlockReduce(temp_storage).Sum(pairs);
+  __syncthreads();
+  positives = BlockReduce(temp_storage).Sum(positives);
+
+  if (threadIdx.x == 0) {
+    myAtomicAdd(sums, pairs);
+    myAtomicAdd(sums + 1, positives);
+  }
+}
+
+/**
+* @brief Function to calculate the area under the ROC curve of the scores of
+* a binary classifier. The samples are sorted by score, and the runs of equal
+* scores are the thresholds of the curve: each positive sample of a run
+* counts the negative samples of the lower runs, plus half the negative
+* samples of its own run, so that ties are linearly interpolated as in the
+* trapezoidal rule.
+*
+* @tparam T: the type of the labels
+* @tparam DataT: the type of the scores
+* @param truth: the array of binary labels, nonzero for the positive class
+* @param scores: the array of scores, higher for the positive class
+* @param nSamples: the number of samples
+* @param allocator: object that takes care of temporary device memory allocation of type std::shared_ptr<MLCommon::deviceAllocator>
+* @param stream: the cudaStream object
+* @return the area under the ROC curve
+*/
+template <typename T, typename DataT>
+double rocAucScore(const T *truth, const DataT *scores, int nSamples,
+                   std::shared_ptr<MLCommon::deviceAllocator> allocator,
+                   cudaStream_t stream) {
+  static const int TPB_X = 256;
+  ASSERT(nSamples >= 2, "ROC AUC score for size less than 2 not defined!");
+
+  MLCommon::device_buffer<DataT> sortedScores(allocator, stream, nSamples);
+  MLCommon::device_buffer<T> sortedTruth(allocator, stream, nSamples);
+  MLCommon::device_buffer<DataT> uniqueScores(allocator, stream, nSamples);
+  MLCommon::device_buffer<int> runPositives(allocator, stream, nSamples);
+  MLCommon::device_buffer<int> runNegatives(allocator, stream, nSamples);
+  MLCommon::device_buffer<int> negativesBefore(allocator, stream, nSamples);
+  MLCommon::device_buffer<int> nRuns(allocator, stream, 1);
+  MLCommon::device_buffer<double> d_sums(allocator, stream, 2);
+  CUDA_CHECK(cudaMemsetAsync(d_sums.data(), 0, 2 * sizeof(double), stream));
+
+  cub::TransformInputIterator<int, IsPositiveOp<T>, const T *> isPositive(
+    sortedTruth.data(), IsPositiveOp<T>());
+  cub::TransformInputIterator<int, IsNegativeOp<T>, const T *> isNegative(
+    sortedTruth.data(), IsNegativeOp<T>());
+
+  size_t sortBytes = 0, reduceBytes = 0, scanBytes = 0;
+  CUDA_CHECK(cub::DeviceRadixSort::SortPairs(
+    nullptr, sortBytes, scores, sortedScores.data(), truth, sortedTruth.data(),
+    nSamples, 0, sizeof(DataT) * 8, stream));
+  CUDA_CHECK(cub::DeviceReduce::ReduceByKey(
+    nullptr, reduceBytes, sortedScores.data(), uniqueScores.data(), isPositive,
+    runPositives.data(), nRuns.data(), cub::Sum(), nSamples, stream));
+  CUDA_CHECK(cub::DeviceScan::ExclusiveSum(nullptr, scanBytes,
+                                           runNegatives.data(),
+                                           negativesBefore.data(), nSamples,
+                                           stream));
+  MLCommon::device_buffer<char> workspace(
+    allocator, stream, std::max(sortBytes, std::max(reduceBytes, scanBytes)));
+
+  CUDA_CHECK(cub::DeviceRadixSort::SortPairs(
+    workspace.data(), sortBytes, scores, sortedScores.data(), truth,
+    sortedTruth.data(), nSamples, 0, sizeof(DataT) * 8, stream));
+  // both reductions have the same runs of equal scores
+  CUDA_CHECK(cub::DeviceReduce::ReduceByKey(
+    workspace.data(), reduceBytes, sortedScores.data(), uniqueScores.data(),
+    isPositive, runPositives.data(), nRuns.data(), cub::Sum(), nSamples,
+    stream));
+  CUDA_CHECK(cub::DeviceReduce::ReduceByKey(
+    workspace.data(), reduceBytes, sortedScores.data(), uniqueScores.data(),
+    isNegative, runNegatives.data(), nRuns.data(), cub::Sum(), nSamples,
+    stream));
+  // the entries past the last run are left unused by the kernel
+  CUDA_CHECK(cub::DeviceScan::ExclusiveSum(workspace.data(), scanBytes,
+                                           runNegatives.data(),
+                                           negativesBefore.data(), nSamples,
+                                           stream));
+
+  rocAucRunSumsKernel<TPB_X>
+    <<<ceildiv<int>(nSamples, TPB_X), TPB_X, 0, stream>>>(
+      runPositives.data(), runNegatives.data(), negativesBefore.data(),
+      nRuns.data(), d_sums.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  double h_sums[2];
+  MLCommon::updateHost(h_sums, d_sums.data(), 2, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  double nPositives = h_sums[1], nNegatives = nSamples - h_sums[1];
+  ASSERT(nPositives > 0 && nNegatives > 0,
+         "ROC AUC score is not defined with a single class!");
+
+  return h_sums[0] / (nPositives * nNegatives);
+}
+
+};  //end namespace Metrics
+};  //end namespace MLCommon
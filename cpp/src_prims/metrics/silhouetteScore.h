@@ -15,9 +15,11 @@
  */
 
 #include <distance/distance.h>
+#include <distance/distance_reduction.h>
 #include <linalg/binary_op.h>
 #include <math.h>
 #include <algorithm>
+#include <climits>
 #include <cub/cub.cuh>
 #include <cuml/common/cuml_allocator.hpp>
 #include <iostream>
@@ -28,7 +30,6 @@
 #include "linalg/map_then_reduce.h"
 #include "linalg/matrix_vector_op.h"
 #include "linalg/reduce.h"
-#include "linalg/reduce_cols_by_key.h"
 
 namespace MLCommon {
 namespace Metrics {
@@ -157,6 +158,76 @@ struct MinOp {
   }
 };
 
+/**
+* @brief function that computes the sum of distances from every sample to every cluster, tileRows samples at a time, the distances being reduced in the epilogue of the distance computation so that no distance matrix is ever written
+* @tparam DataT: type of the data samples
+* @tparam LabelT: type of the labels
+* @param X_in: pointer to the input Data samples array (nRows x nCols)
+* @param nRows: number of data samples
+* @param nCols: number of features
+* @param labels: the pointer to the array containing labels for every data sample (1 x nRows)
+* @param nLabels: number of Labels
+* @param sampleToClusterSumOfDistances: the pointer to the 2D array of the sums (nRows x nLabels)
+* @param tileRows: number of samples per tile
+* @param allocator: default allocator to allocate device memory
+* @param stream: the cuda stream where to launch this kernel
+* @param metric: the distance metric to be used in the calculations
+*/
+template <typename DataT, typename LabelT>
+void computeSampleToClusterSumOfDistances(
+  const DataT *X_in, int nRows, int nCols, const LabelT *labels, int nLabels,
+  DataT *sampleToClusterSumOfDistances, int tileRows,
+  std::shared_ptr<MLCommon::deviceAllocator> allocator, cudaStream_t stream,
+  Distance::DistanceType metric) {
+  CUDA_CHECK(cudaMemsetAsync(sampleToClusterSumOfDistances, 0,
+                             nRows * nLabels * sizeof(DataT), stream));
+  for (int start = 0; start < nRows; start += tileRows) {
+    int rows = std::min(tileRows, nRows - start);
+    const DataT *X_tile = X_in + (size_t)start * nCols;
+    DataT *sums = sampleToClusterSumOfDistances + (size_t)start * nLabels;
+    switch (metric) {
+      case Distance::DistanceType::EucExpandedL2:
+        Distance::sumDistanceByLabel<Distance::DistanceType::EucExpandedL2,
+                                     DataT, LabelT>(
+          X_tile, X_in, rows, nRows, nCols, labels, nLabels, sums, allocator,
+          stream);
+        break;
+      case Distance::DistanceType::EucExpandedL2Sqrt:
+        Distance::sumDistanceByLabel<Distance::DistanceType::EucExpandedL2Sqrt,
+                                     DataT, LabelT>(
+          X_tile, X_in, rows, nRows, nCols, labels, nLabels, sums, allocator,
+          stream);
+        break;
+      case Distance::DistanceType::EucExpandedCosine:
+        Distance::sumDistanceByLabel<Distance::DistanceType::EucExpandedCosine,
+                                     DataT, LabelT>(
+          X_tile, X_in, rows, nRows, nCols, labels, nLabels, sums, allocator,
+          stream);
+        break;
+      case Distance::DistanceType::EucUnexpandedL1:
+        Distance::sumDistanceByLabel<Distance::DistanceType::EucUnexpandedL1,
+                                     DataT, LabelT>(
+          X_tile, X_in, rows, nRows, nCols, labels, nLabels, sums, allocator,
+          stream);
+        break;
+      case Distance::DistanceType::EucUnexpandedL2:
+        Distance::sumDistanceByLabel<Distance::DistanceType::EucUnexpandedL2,
+                                     DataT, LabelT>(
+          X_tile, X_in, rows, nRows, nCols, labels, nLabels, sums, allocator,
+          stream);
+        break;
+      case Distance::DistanceType::EucUnexpandedL2Sqrt:
+        Distance::sumDistanceByLabel<
+          Distance::DistanceType::EucUnexpandedL2Sqrt, DataT, LabelT>(
+          X_tile, X_in, rows, nRows, nCols, labels, nLabels, sums, allocator,
+          stream);
+        break;
+      default:
+        THROW("Unknown distance metric '%d'!", metric);
+    };
+  }
+}
+
 /**
 * @brief main function that returns the average silhouette score for a given set of data and its clusterings
 * @tparam DataT: type of the data samples
@@ -170,24 +241,22 @@ struct MinOp {
 * @param allocator: default allocator to allocate device memory
 * @param stream: the cuda stream where to launch this kernel 
 * @param metric: the numerical value that maps to the type of distance metric to be used in the calculations
+* @param tileRows: number of samples whose distances to all the samples are computed at a time; if 0, as many as the int indexing of the distances allows
 */
 template <typename DataT, typename LabelT>
 DataT silhouetteScore(DataT *X_in, int nRows, int nCols, LabelT *labels,
                       int nLabels, DataT *silhouetteScorePerSample,
                       std::shared_ptr<MLCommon::deviceAllocator> allocator,
-                      cudaStream_t stream, int metric = 4) {
+                      cudaStream_t stream, int metric = 4, int tileRows = 0) {
   ASSERT(nLabels >= 2 && nLabels <= (nRows - 1),
          "silhouette Score not defined for the given number of labels!");
 
-  //compute the distance matrix
-  MLCommon::device_buffer<DataT> distanceMatrix(allocator, stream,
-                                                nRows * nRows);
+  //the distances of a tile of rows to all the samples are reduced on the fly,
+  //the tile is only bounded by the int indexing of its distances
+  if (tileRows <= 0) tileRows = INT_MAX / nRows;
+  tileRows = std::max(1, std::min(tileRows, nRows));
   MLCommon::device_buffer<char> workspace(allocator, stream, 1);
 
-  Distance::pairwiseDistance(
-    X_in, X_in, distanceMatrix.data(), nRows, nRows, nCols, workspace,
-    static_cast<Distance::DistanceType>(metric), stream);
-
   //deciding on the array of silhouette scores for each dataPoint
   MLCommon::device_buffer<DataT> silhouetteScoreSamples(allocator, stream, 0);
   DataT *perSampleSilScore = nullptr;
@@ -210,11 +279,9 @@ DataT silhouetteScore(DataT *X_in, int nRows, int nCols, LabelT *labels,
   //calculating the sample-cluster-distance-sum-array
   device_buffer<DataT> sampleToClusterSumOfDistances(allocator, stream,
                                                      nRows * nLabels);
-  CUDA_CHECK(cudaMemsetAsync(sampleToClusterSumOfDistances.data(), 0,
-                             nRows * nLabels * sizeof(DataT), stream));
-  LinAlg::reduce_cols_by_key<DataT, LabelT>(
-    distanceMatrix.data(), labels, sampleToClusterSumOfDistances.data(), nRows,
-    nRows, nLabels, stream);
+  computeSampleToClusterSumOfDistances(
+    X_in, nRows, nCols, labels, nLabels, sampleToClusterSumOfDistances.data(),
+    tileRows, allocator, stream, static_cast<Distance::DistanceType>(metric));
 
   //creating the a array and b array
   device_buffer<DataT> d_aArray(allocator, stream, nRows);
@@ -21,6 +21,7 @@
 #include "common/device_buffer.hpp"
 #include "permute.h"
 #include "rng.h"
+#include "stateless_rng.h"
 #include "utils.h"
 
 namespace MLCommon {
@@ -129,5 +130,155 @@ void make_blobs(DataT* out, IdxT* labels, IdxT n_rows, IdxT n_cols,
   }
 }
 
+/**
+ * @defgroup ShardedMakeBlobs
+ * @{
+ * @brief The blobs of make_blobs as shards, for datasets too large for a
+ * device: the rows [row_offset, row_offset + n_rows) of a dataset which is,
+ * from the seed alone, the same whichever way it is cut in shards or chunks
+ * and whichever rank generates them. Its values are counter-based (see
+ * StatelessRng), in the streams of the seed:
+ *  - 0, the centers, when they are generated
+ *  - 1, the label of each global row, drawn uniformly among the clusters,
+ *    which also makes the dataset shuffled: no permutation is needed
+ *  - 2, the values, at the global index of their element in row-major order
+ */
+
+/** the streams of the seed of the sharded make_blobs */
+enum BlobsStream : uint64_t {
+  BlobsCenters = 0,
+  BlobsLabels = 1,
+  BlobsValues = 2
+};
+
+/**
+ * @brief Generate the centers of the sharded make_blobs, the same on all the
+ * ranks sharing the seed
+ * @param centers the output centers on device (dim = n_clusters x n_cols)
+ * @param n_cols number of columns in the generated data
+ * @param n_clusters number of clusters (or classes) to generate
+ * @param center_box_min min value of the box from which to pick the centers
+ * @param center_box_max max value of the box from which to pick the centers
+ * @param seed the seed of the whole dataset
+ * @param stream cuda stream to schedule the work on
+ */
+template <typename DataT, typename IdxT>
+void make_blobs_centers(DataT* centers, IdxT n_cols, IdxT n_clusters,
+                        DataT center_box_min, DataT center_box_max,
+                        uint64_t seed, cudaStream_t stream) {
+  statelessUniform<DataT, int64_t>(centers, int64_t(n_clusters) * n_cols,
+                                   center_box_min, center_box_max, seed,
+                                   BlobsCenters, 0, stream);
+}
+
+/**
+ * @brief Generate the rows [row_offset, row_offset + n_rows) of the sharded
+ * make_blobs
+ * @tparam DataT output data type
+ * @tparam IdxT type of the labels and of the dimensions
+ * @param out the generated rows on device (dim = n_rows x n_cols) in
+ * row-major layout
+ * @param labels labels of the generated rows on device (dim = n_rows x 1)
+ * @param row_offset the global index of the first generated row
+ * @param n_rows number of rows to generate
+ * @param n_cols number of columns in the generated data
+ * @param n_clusters number of clusters (or classes) to generate
+ * @param allocator device allocator to help allocate temporary buffers
+ * @param stream cuda stream to schedule the work on
+ * @param centers centers of each of the cluster on device (dim = n_clusters x
+ * n_cols), or nullptr for the ones of make_blobs_centers
+ * @param cluster_std standard deviation of each of the cluster center on
+ * device (dim = n_clusters x 1), or nullptr to use 'cluster_std_scalar'
+ * @param cluster_std_scalar if 'cluster_std' is nullptr, then use this as the
+ * standard deviation across all dimensions.
+ * @param center_box_min min value of the box from which to pick the cluster
+ * centers. Useful only if 'centers' is nullptr
+ * @param center_box_max max value of the box from which to pick the cluster
+ * centers. Useful only if 'centers' is nullptr
+ * @param seed the seed of the whole dataset
+ */
+template <typename DataT, typename IdxT>
+void make_blobs_shard(DataT* out, IdxT* labels, int64_t row_offset,
+                      int64_t n_rows, IdxT n_cols, IdxT n_clusters,
+                      std::shared_ptr<deviceAllocator> allocator,
+                      cudaStream_t stream, const DataT* centers = nullptr,
+                      const DataT* cluster_std = nullptr,
+                      const DataT cluster_std_scalar = (DataT)1.0,
+                      DataT center_box_min = (DataT)-10.0,
+                      DataT center_box_max = (DataT)10.0,
+                      uint64_t seed = 0ULL) {
+  ASSERT(row_offset >= 0 && n_rows >= 0, "make_blobs_shard: bad rows");
+  device_buffer<DataT> rand_centers(allocator, stream);
+  if (centers == nullptr) {
+    rand_centers.resize(n_clusters * n_cols, stream);
+    make_blobs_centers(rand_centers.data(), n_cols, n_clusters,
+                       center_box_min, center_box_max, seed, stream);
+    centers = rand_centers.data();
+  }
+  statelessUniformInt<IdxT, int64_t>(labels, n_rows, IdxT(0), n_clusters,
+                                     seed, BlobsLabels, uint64_t(row_offset),
+                                     stream);
+  // the element of global index idx is in the row idx / n_cols
+  uint64_t first = uint64_t(row_offset) * n_cols;
+  uint64_t cols = n_cols;
+  const IdxT* _labels = labels;
+  statelessRandImpl(
+    out, n_rows * n_cols, first,
+    [=] __device__(uint64_t idx) {
+      uint64_t row = idx / cols;
+      IdxT c = _labels[row - uint64_t(row_offset)];
+      DataT sigma = cluster_std == nullptr ? cluster_std_scalar
+                                           : cluster_std[c];
+      DataT mu = centers[c * cols + (idx - row * cols)];
+      return statelessNormalAt(seed, BlobsValues, idx, mu, sigma);
+    },
+    stream);
+}
+
+/**
+ * @brief Generate the rows [row_offset, row_offset + n_rows) of the sharded
+ * make_blobs in chunks of at most chunk_rows rows, handing each over to the
+ * consumer as soon as generated, so that the shard needs not fit in memory.
+ * The chunks reuse the same buffers: the consumer is called as
+ * `consume(out, labels, chunk_offset, chunk_rows)`, with the global index of
+ * the first row of the chunk, and has to be done with the buffers when on the
+ * stream the generation of the next chunk starts.
+ * @param chunk_rows the max number of rows of a chunk
+ * @param consume the consumer of the chunks
+ * For the other params, see make_blobs_shard
+ */
+template <typename DataT, typename IdxT, typename Consumer>
+void make_blobs_chunked(int64_t row_offset, int64_t n_rows, IdxT n_cols,
+                        IdxT n_clusters, int64_t chunk_rows, Consumer consume,
+                        std::shared_ptr<deviceAllocator> allocator,
+                        cudaStream_t stream, const DataT* centers = nullptr,
+                        const DataT* cluster_std = nullptr,
+                        const DataT cluster_std_scalar = (DataT)1.0,
+                        DataT center_box_min = (DataT)-10.0,
+                        DataT center_box_max = (DataT)10.0,
+                        uint64_t seed = 0ULL) {
+  ASSERT(chunk_rows > 0, "make_blobs_chunked: chunk_rows must be positive");
+  chunk_rows = std::min(chunk_rows, n_rows);
+  device_buffer<DataT> rand_centers(allocator, stream);
+  if (centers == nullptr) {
+    rand_centers.resize(n_clusters * n_cols, stream);
+    make_blobs_centers(rand_centers.data(), n_cols, n_clusters,
+                       center_box_min, center_box_max, seed, stream);
+    centers = rand_centers.data();
+  }
+  device_buffer<DataT> out(allocator, stream, chunk_rows * n_cols);
+  device_buffer<IdxT> labels(allocator, stream, chunk_rows);
+  for (int64_t done = 0; done < n_rows; done += chunk_rows) {
+    int64_t rows = std::min(chunk_rows, n_rows - done);
+    make_blobs_shard(out.data(), labels.data(), row_offset + done, rows,
+                     n_cols, n_clusters, allocator, stream, centers,
+                     cluster_std, cluster_std_scalar, center_box_min,
+                     center_box_max, seed);
+    consume(static_cast<const DataT*>(out.data()),
+            static_cast<const IdxT*>(labels.data()), row_offset + done, rows);
+  }
+}
+/** @} */
+
 }  // end namespace Random
 }  // end namespace MLCommon
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Adapted from scikit-learn
+ * https://github.com/scikit-learn/scikit-learn/blob/master/sklearn/datasets/_samples_generator.py
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cuml/common/cuml_allocator.hpp>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "common/device_buffer.hpp"
+#include "linalg/cublas_wrappers.h"
+#include "linalg/transpose.h"
+#include "linalg/unary_op.h"
+#include "permute.h"
+#include "rng.h"
+#include "utils.h"
+
+namespace MLCommon {
+namespace Random {
+
+/* Internal auxiliary function giving the cluster of a row, the n_rows rows
+ * being cut in n_clusters contiguous blocks, the first n_rows % n_clusters of
+ * which have one more row */
+template <typename IdxT>
+HDI IdxT _cluster_of_row(IdxT row, IdxT n_rows, IdxT n_clusters) {
+  IdxT base = n_rows / n_clusters, extra = n_rows % n_clusters;
+  IdxT big = extra * (base + 1);
+  return row < big ? row / (base + 1) : extra + (row - big) / base;
+}
+
+/* Internal auxiliary function to move the informative features of each row,
+ * column-major, to the centroid of its cluster */
+template <typename DataT, typename IdxT>
+static __global__ void _add_centroids_kernel(DataT* out,
+                                             const DataT* centroids,
+                                             IdxT n_rows, IdxT n_informative,
+                                             IdxT n_clusters) {
+  IdxT tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid < n_rows * n_informative) {
+    IdxT row = tid % n_rows, col = tid / n_rows;
+    IdxT k = _cluster_of_row(row, n_rows, n_clusters);
+    out[tid] += centroids[k * n_informative + col];
+  }
+}
+
+/* Internal auxiliary function to generate the labels, with the given ratio
+ * of them drawn at random instead of being the class of their cluster */
+template <typename DataT, typename IdxT>
+static __global__ void _classification_labels_kernel(
+  IdxT* labels, const DataT* flip_draws, const IdxT* random_labels,
+  DataT flip_y, IdxT n_rows, IdxT n_classes, IdxT n_clusters) {
+  IdxT tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid < n_rows) {
+    labels[tid] = flip_draws[tid] < flip_y
+                    ? random_labels[tid]
+                    : _cluster_of_row(tid, n_rows, n_clusters) % n_classes;
+  }
+}
+
+template <typename IdxT>
+static __global__ void _gather_labels_kernel(IdxT* out, const IdxT* in,
+                                             const IdxT* perms, IdxT len) {
+  IdxT tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid < len) out[tid] = in[perms[tid]];
+}
+
+/* Internal auxiliary function to generate the centroids of the clusters on
+ * the host, distinct vertices of the hypercube of side 2 * class_sep in the
+ * space of the informative features, optionally scaled at random */
+template <typename DataT, typename IdxT>
+static std::vector<DataT> _make_centroids(IdxT n_clusters, IdxT n_informative,
+                                          DataT class_sep, bool hypercube,
+                                          std::mt19937_64& gen) {
+  std::bernoulli_distribution coin;
+  std::set<std::vector<bool>> vertices;
+  std::vector<DataT> centroids(n_clusters * n_informative);
+  for (IdxT k = 0; k < n_clusters; ++k) {
+    std::vector<bool> v(n_informative);
+    do {
+      for (IdxT j = 0; j < n_informative; ++j) v[j] = coin(gen);
+    } while (!vertices.insert(v).second);
+    for (IdxT j = 0; j < n_informative; ++j) {
+      centroids[k * n_informative + j] = v[j] ? class_sep : -class_sep;
+    }
+  }
+  if (!hypercube) {
+    std::uniform_real_distribution<double> unif;
+    std::vector<DataT> col_scale(n_informative);
+    for (IdxT j = 0; j < n_informative; ++j) col_scale[j] = unif(gen);
+    for (IdxT k = 0; k < n_clusters; ++k) {
+      DataT row_scale = unif(gen);
+      for (IdxT j = 0; j < n_informative; ++j) {
+        centroids[k * n_informative + j] *= row_scale * col_scale[j];
+      }
+    }
+  }
+  return centroids;
+}
+
+/**
+ * @brief GPU-equivalent of sklearn.datasets.make_classification as documented
+ * at:
+ * https://scikit-learn.org/stable/modules/generated/sklearn.datasets.make_classification.html
+ *
+ * The rows of each class are clusters of normally distributed points around
+ * the vertices of a hypercube in the space of the n_informative features,
+ * each with its own random covariance. The n_redundant features are random
+ * linear combinations of the informative ones, the n_repeated ones copies of
+ * random informative or redundant ones, and the remaining ones noise.
+ *
+ * @tparam  DataT  Scalar type
+ * @tparam  IdxT   Index type
+ *
+ * @param[out]  out                 Row-major (samples, features) matrix of
+ *                                  the generated samples
+ * @param[out]  labels              The class of each sample (dim = n_rows)
+ * @param[in]   n_rows              Number of samples
+ * @param[in]   n_cols              Number of features
+ * @param[in]   cublas_handle       cuBLAS handle
+ * @param[in]   allocator           Device memory allocator
+ * @param[in]   stream              CUDA stream
+ * @param[in]   n_classes           Number of classes
+ * @param[in]   n_clusters_per_class Number of clusters of each class
+ * @param[in]   n_informative       Number of informative features
+ * @param[in]   n_redundant         Number of redundant features
+ * @param[in]   n_repeated          Number of repeated features
+ * @param[in]   flip_y              Ratio of the labels drawn at random, to
+ *                                  make the problem harder
+ * @param[in]   class_sep           Half the side of the hypercube; larger
+ *                                  values make the problem easier
+ * @param[in]   hypercube           Whether the centroids are the vertices of
+ *                                  the hypercube, or are scaled at random
+ *                                  from them
+ * @param[in]   shift               A scalar added to all the features
+ * @param[in]   scale               A scalar by which all the features are
+ *                                  multiplied, after the shift
+ * @param[in]   shuffle             Shuffle the samples and the features
+ * @param[in]   seed                Seed for the random number generator
+ * @param[in]   type                Random generator type
+ */
+template <typename DataT, typename IdxT>
+void make_classification(
+  DataT* out, IdxT* labels, IdxT n_rows, IdxT n_cols,
+  cublasHandle_t cublas_handle, std::shared_ptr<deviceAllocator> allocator,
+  cudaStream_t stream, IdxT n_classes = (IdxT)2,
+  IdxT n_clusters_per_class = (IdxT)2, IdxT n_informative = (IdxT)2,
+  IdxT n_redundant = (IdxT)2, IdxT n_repeated = (IdxT)0,
+  DataT flip_y = (DataT)0.01, DataT class_sep = (DataT)1.0,
+  bool hypercube = true, DataT shift = (DataT)0.0, DataT scale = (DataT)1.0,
+  bool shuffle = true, uint64_t seed = 0ULL, GeneratorType type = GenPhilox) {
+  IdxT n_clusters = n_classes * n_clusters_per_class;
+  ASSERT(n_informative > 0, "make_classification: n_informative must be > 0");
+  ASSERT(n_informative + n_redundant + n_repeated <= n_cols,
+         "make_classification: the informative, redundant and repeated "
+         "features must fit in n_cols");
+  ASSERT(n_informative >= 62 ||
+           uint64_t(n_clusters) <= (uint64_t(1) << n_informative),
+         "make_classification: n_classes * n_clusters_per_class must be "
+         "smaller or equal 2**n_informative");
+  ASSERT(n_rows >= n_clusters,
+         "make_classification: fewer samples than clusters");
+  cublasSetPointerMode(cublas_handle, CUBLAS_POINTER_MODE_HOST);
+  Rng r(seed, type);
+  std::mt19937_64 gen(seed);
+  constexpr IdxT Nthreads = 256;
+
+  // the column-major samples, their informative features being first drawn
+  // in a buffer of their own for the covariances to be applied
+  device_buffer<DataT> samples(allocator, stream, n_rows * n_cols);
+  device_buffer<DataT> normals(allocator, stream, n_rows * n_informative);
+  r.normal(normals.data(), n_rows * n_informative, (DataT)0.0, (DataT)1.0,
+           stream);
+
+  // a random covariance per cluster, then the centroids
+  device_buffer<DataT> covs(allocator, stream,
+                            n_clusters * n_informative * n_informative);
+  r.uniform(covs.data(), n_clusters * n_informative * n_informative,
+            (DataT)-1.0, (DataT)1.0, stream);
+  DataT alpha = (DataT)1.0, beta = (DataT)0.0;
+  for (IdxT k = 0, first = 0; k < n_clusters; ++k) {
+    IdxT rows = n_rows / n_clusters + (k < n_rows % n_clusters ? 1 : 0);
+    CUBLAS_CHECK(LinAlg::cublasgemm(
+      cublas_handle, CUBLAS_OP_N, CUBLAS_OP_N, rows, n_informative,
+      n_informative, &alpha, normals.data() + first, n_rows,
+      covs.data() + k * n_informative * n_informative, n_informative, &beta,
+      samples.data() + first, n_rows, stream));
+    first += rows;
+  }
+  std::vector<DataT> h_centroids = _make_centroids(
+    n_clusters, n_informative, class_sep, hypercube, gen);
+  device_buffer<DataT> centroids(allocator, stream, h_centroids.size());
+  updateDevice(centroids.data(), h_centroids.data(), h_centroids.size(),
+               stream);
+  IdxT nblks = ceildiv<IdxT>(n_rows * n_informative, Nthreads);
+  _add_centroids_kernel<<<nblks, Nthreads, 0, stream>>>(
+    samples.data(), centroids.data(), n_rows, n_informative, n_clusters);
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  // the redundant features
+  if (n_redundant > 0) {
+    device_buffer<DataT> comb(allocator, stream, n_informative * n_redundant);
+    r.uniform(comb.data(), n_informative * n_redundant, (DataT)-1.0,
+              (DataT)1.0, stream);
+    CUBLAS_CHECK(LinAlg::cublasgemm(
+      cublas_handle, CUBLAS_OP_N, CUBLAS_OP_N, n_rows, n_redundant,
+      n_informative, &alpha, samples.data(), n_rows, comb.data(),
+      n_informative, &beta, samples.data() + n_informative * n_rows, n_rows,
+      stream));
+  }
+
+  // the repeated features
+  std::uniform_int_distribution<IdxT> source(0, n_informative + n_redundant -
+                                                  1);
+  for (IdxT j = n_informative + n_redundant;
+       j < n_informative + n_redundant + n_repeated; ++j) {
+    copy(samples.data() + j * n_rows, samples.data() + source(gen) * n_rows,
+         n_rows, stream);
+  }
+
+  // the useless features
+  IdxT n_useful = n_informative + n_redundant + n_repeated;
+  if (n_useful < n_cols) {
+    r.normal(samples.data() + n_useful * n_rows, (n_cols - n_useful) * n_rows,
+             (DataT)0.0, (DataT)1.0, stream);
+  }
+
+  if (shift != (DataT)0.0 || scale != (DataT)1.0) {
+    LinAlg::unaryOp(
+      samples.data(), samples.data(), n_rows * n_cols,
+      [=] __device__(DataT x) { return (x + shift) * scale; }, stream);
+  }
+
+  // the labels, some of them flipped
+  device_buffer<IdxT> tmp_labels(allocator, stream);
+  IdxT* _labels = labels;
+  if (shuffle) {
+    tmp_labels.resize(n_rows, stream);
+    _labels = tmp_labels.data();
+  }
+  device_buffer<DataT> flip_draws(allocator, stream, n_rows);
+  device_buffer<IdxT> random_labels(allocator, stream, n_rows);
+  r.uniform(flip_draws.data(), n_rows, (DataT)0.0, (DataT)1.0, stream);
+  r.uniformInt(random_labels.data(), n_rows, (IdxT)0, n_classes, stream);
+  nblks = ceildiv<IdxT>(n_rows, Nthreads);
+  _classification_labels_kernel<<<nblks, Nthreads, 0, stream>>>(
+    _labels, flip_draws.data(), random_labels.data(), flip_y, n_rows,
+    n_classes, n_clusters);
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  if (!shuffle) {
+    // Transpose from column-major to row-major
+    LinAlg::transpose(samples.data(), out, n_rows, n_cols, cublas_handle,
+                      stream);
+    return;
+  }
+  device_buffer<DataT> tmp_out(allocator, stream, n_rows * n_cols);
+  device_buffer<IdxT> perms_samples(allocator, stream, n_rows);
+  device_buffer<IdxT> perms_features(allocator, stream, n_cols);
+  LinAlg::transpose(samples.data(), tmp_out.data(), n_rows, n_cols,
+                    cublas_handle, stream);
+  // Shuffle the samples from tmp_out to samples
+  permute<DataT, IdxT, IdxT>(perms_samples.data(), samples.data(),
+                             tmp_out.data(), n_cols, n_rows, true, stream);
+  _gather_labels_kernel<<<nblks, Nthreads, 0, stream>>>(
+    labels, _labels, perms_samples.data(), n_rows);
+  CUDA_CHECK(cudaPeekAtLastError());
+  // Shuffle the features from samples to out
+  permute<DataT, IdxT, IdxT>(perms_features.data(), out, samples.data(),
+                             n_rows, n_cols, false, stream);
+}
+
+}  // namespace Random
+}  // namespace MLCommon
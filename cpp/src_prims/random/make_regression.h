@@ -21,6 +21,7 @@
 #pragma once
 
 #include <algorithm>
+#include <climits>
 #include <cuml/common/cuml_allocator.hpp>
 
 #include "linalg/add.h"
@@ -31,6 +32,7 @@
 #include "matrix/matrix.h"
 #include "permute.h"
 #include "rng.h"
+#include "stateless_rng.h"
 #include "utils.h"
 
 namespace MLCommon {
@@ -282,5 +284,172 @@ void make_regression(DataT* out, DataT* values, IdxT n_rows, IdxT n_cols,
   }
 }
 
+/**
+ * @defgroup ShardedMakeRegression
+ * @{
+ * @brief The well conditioned problems of make_regression as shards, for
+ * datasets too large for a device: the rows [row_offset, row_offset + n_rows)
+ * of a problem which is, from the seed alone, the same whichever way it is
+ * cut in shards or chunks and whichever rank generates them. Its values are
+ * counter-based (see StatelessRng), in the streams of the seed:
+ *  - 0, the samples, at the global index of their element in row-major order
+ *  - 1, the coefficients of the informative features
+ *  - 2, the noise, at the global index of its value in row-major order
+ * The rows being independent, shuffling the samples would not change the
+ * distribution of the shards, and the informative features are the first
+ * n_informative. The low rank inputs, which need the whole data matrix, have
+ * no sharded version.
+ */
+
+/** the streams of the seed of the sharded make_regression */
+enum RegressionStream : uint64_t {
+  RegressionSamples = 0,
+  RegressionCoefs = 1,
+  RegressionNoise = 2
+};
+
+/**
+ * @brief Generate the coefficients of the sharded make_regression, the same
+ * on all the ranks sharing the seed
+ * @param[out]  coef          Row-major (features, targets) matrix of the
+ *                            coefficients
+ * @param[in]   n_cols        Number of features
+ * @param[in]   n_informative Number of informative features
+ * @param[in]   n_targets     Number of targets
+ * @param[in]   seed          The seed of the whole problem
+ * @param[in]   stream        CUDA stream
+ */
+template <typename DataT, typename IdxT>
+void make_regression_coef(DataT* coef, IdxT n_cols, IdxT n_informative,
+                          IdxT n_targets, uint64_t seed, cudaStream_t stream) {
+  n_informative = std::min(n_informative, n_cols);
+  statelessUniform<DataT, int64_t>(coef, int64_t(n_informative) * n_targets,
+                                   (DataT)1.0, (DataT)100.0, seed,
+                                   RegressionCoefs, 0, stream);
+  if (n_informative != n_cols) {
+    CUDA_CHECK(cudaMemsetAsync(
+      coef + n_informative * n_targets, 0,
+      (n_cols - n_informative) * n_targets * sizeof(DataT), stream));
+  }
+}
+
+/**
+ * @brief Generate the rows [row_offset, row_offset + n_rows) of the sharded
+ * make_regression
+ *
+ * @tparam  DataT  Scalar type
+ * @tparam  IdxT   Index type
+ *
+ * @param[out]  out             Row-major (samples, features) matrix of the
+ *                              generated rows
+ * @param[out]  values          Row-major (samples, targets) matrix of their
+ *                              values
+ * @param[in]   row_offset      The global index of the first generated row
+ * @param[in]   n_rows          Number of rows to generate, less than 2^31
+ * @param[in]   n_cols          Number of features
+ * @param[in]   n_informative   Number of informative features (non-zero
+ *                              coefficients)
+ * @param[in]   cublas_handle   cuBLAS handle
+ * @param[in]   allocator       Device memory allocator
+ * @param[in]   stream          CUDA stream
+ * @param[out]  coef            Row-major (features, targets) matrix to store
+ *                              the coefficients used to generate the values
+ *                              for the regression problem. If nullptr is
+ *                              given, nothing will be written
+ * @param[in]   n_targets       Number of targets (generated values per sample)
+ * @param[in]   bias            A scalar that will be added to the values
+ * @param[in]   noise           Standard deviation of the gaussian noise
+ *                              applied to the output
+ * @param[in]   seed            The seed of the whole problem
+ */
+template <typename DataT, typename IdxT>
+void make_regression_shard(DataT* out, DataT* values, int64_t row_offset,
+                           int64_t n_rows, IdxT n_cols, IdxT n_informative,
+                           cublasHandle_t cublas_handle,
+                           std::shared_ptr<deviceAllocator> allocator,
+                           cudaStream_t stream, DataT* coef = nullptr,
+                           IdxT n_targets = (IdxT)1, DataT bias = (DataT)0.0,
+                           DataT noise = (DataT)0.0, uint64_t seed = 0ULL) {
+  ASSERT(row_offset >= 0 && n_rows >= 0 && n_rows <= INT_MAX,
+         "make_regression_shard: bad rows, generate large shards in chunks");
+  n_informative = std::min(n_informative, n_cols);
+  cublasSetPointerMode(cublas_handle, CUBLAS_POINTER_MODE_HOST);
+  statelessNormal<DataT, int64_t>(out, n_rows * n_cols, (DataT)0.0,
+                                  (DataT)1.0, seed, RegressionSamples,
+                                  uint64_t(row_offset) * n_cols, stream);
+
+  device_buffer<DataT> tmp_coef(allocator, stream);
+  DataT* _coef = coef;
+  if (coef == nullptr) {
+    tmp_coef.resize(n_cols * n_targets, stream);
+    _coef = tmp_coef.data();
+  }
+  make_regression_coef(_coef, n_cols, n_informative, n_targets, seed, stream);
+
+  // the row-major values are the column-major (targets, samples) product of
+  // the transposes
+  DataT alpha = (DataT)1.0, beta = (DataT)0.0;
+  if (n_rows > 0) {
+    CUBLAS_CHECK(LinAlg::cublasgemm(
+      cublas_handle, CUBLAS_OP_N, CUBLAS_OP_N, n_targets, int(n_rows),
+      n_informative, &alpha, _coef, n_targets, out, n_cols, &beta, values,
+      n_targets, stream));
+  }
+
+  if (bias != 0.0) {
+    LinAlg::addScalar(values, values, bias, n_rows * n_targets, stream);
+  }
+
+  device_buffer<DataT> white_noise(allocator, stream);
+  if (noise != 0.0) {
+    white_noise.resize(n_rows * n_targets, stream);
+    statelessNormal<DataT, int64_t>(white_noise.data(), n_rows * n_targets,
+                                    (DataT)0.0, noise, seed, RegressionNoise,
+                                    uint64_t(row_offset) * n_targets, stream);
+    LinAlg::add(values, values, white_noise.data(), n_rows * n_targets,
+                stream);
+  }
+}
+
+/**
+ * @brief Generate the rows [row_offset, row_offset + n_rows) of the sharded
+ * make_regression in chunks of at most chunk_rows rows, handing each over to
+ * the consumer as soon as generated, so that the shard needs not fit in
+ * memory. The chunks reuse the same buffers: the consumer is called as
+ * `consume(out, values, chunk_offset, chunk_rows)`, with the global index of
+ * the first row of the chunk, and has to be done with the buffers when on the
+ * stream the generation of the next chunk starts.
+ * @param[in]   chunk_rows      The max number of rows of a chunk
+ * @param[in]   consume         The consumer of the chunks
+ * For the other params, see make_regression_shard
+ */
+template <typename DataT, typename IdxT, typename Consumer>
+void make_regression_chunked(int64_t row_offset, int64_t n_rows, IdxT n_cols,
+                             IdxT n_informative, int64_t chunk_rows,
+                             Consumer consume, cublasHandle_t cublas_handle,
+                             std::shared_ptr<deviceAllocator> allocator,
+                             cudaStream_t stream, DataT* coef = nullptr,
+                             IdxT n_targets = (IdxT)1, DataT bias = (DataT)0.0,
+                             DataT noise = (DataT)0.0, uint64_t seed = 0ULL) {
+  ASSERT(chunk_rows > 0 && chunk_rows <= INT_MAX,
+         "make_regression_chunked: chunk_rows must be in [1, 2^31)");
+  chunk_rows = std::min(chunk_rows, n_rows);
+  if (coef != nullptr) {
+    make_regression_coef(coef, n_cols, n_informative, n_targets, seed, stream);
+  }
+  device_buffer<DataT> out(allocator, stream, chunk_rows * n_cols);
+  device_buffer<DataT> values(allocator, stream, chunk_rows * n_targets);
+  for (int64_t done = 0; done < n_rows; done += chunk_rows) {
+    int64_t rows = std::min(chunk_rows, n_rows - done);
+    make_regression_shard<DataT, IdxT>(
+      out.data(), values.data(), row_offset + done, rows, n_cols,
+      n_informative, cublas_handle, allocator, stream, nullptr, n_targets,
+      bias, noise, seed);
+    consume(static_cast<const DataT*>(out.data()),
+            static_cast<const DataT*>(values.data()), row_offset + done, rows);
+  }
+}
+/** @} */
+
 }  // namespace Random
 }  // namespace MLCommon
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <thrust/execution_policy.h>
+#include <thrust/scan.h>
+#include <algorithm>
+#include "cuda_utils.h"
+#include "stateless_rng.h"
+
+namespace MLCommon {
+namespace Random {
+
+/**
+ * @defgroup MakeSparse
+ * @{
+ * @brief Random CSR matrices, the equivalent of scipy.sparse.random: each
+ * element is non-zero with probability density, with a value uniform in
+ * [value_min, value_max). The columns of the non-zeros of a row are the
+ * successive sums of geometric gaps, so that a row costs its number of
+ * non-zeros rather than n_cols, and, being counter-based (see StatelessRng),
+ * the matrix is drawn in two passes: make_sparse_rows, for the row pointers
+ * and so the nnz, with which the caller allocates the indices and the values,
+ * then make_sparse, which draws the same columns again to fill them.
+ */
+
+/** the streams of the seed of make_sparse */
+enum SparseStream : uint64_t { SparseColumns = 0, SparseValues = 1 };
+
+/* Internal auxiliary function walking the columns of the non-zeros of a row,
+ * calling op(k, col) for the k-th of them */
+template <typename IdxT, typename Lambda>
+DI IdxT _sparse_row_walk(IdxT row, IdxT n_cols, double density, uint64_t seed,
+                         Lambda op) {
+  if (density <= 0.0) return 0;
+  double log_q = log1p(-density);
+  IdxT k = 0;
+  double col = -1.0;
+  // a row has at most n_cols non-zeros, so n_cols + 1 draws
+  uint64_t first = uint64_t(row) * (uint64_t(n_cols) + 1);
+  while (true) {
+    double u = statelessUniformAt(seed, SparseColumns, first + k, 0.0, 1.0);
+    // 1 - u is in (0, 1]; with density 1, log_q is -inf and all the gaps 0
+    col += 1.0 + (density >= 1.0 ? 0.0 : floor(log1p(-u) / log_q));
+    if (col >= double(n_cols)) break;
+    op(k, IdxT(col));
+    ++k;
+  }
+  return k;
+}
+
+template <typename IdxT>
+__global__ void _sparse_rows_kernel(IdxT* row_nnz, IdxT n_rows, IdxT n_cols,
+                                    double density, uint64_t seed) {
+  for (IdxT row = IdxT(blockIdx.x) * blockDim.x + threadIdx.x; row < n_rows;
+       row += IdxT(gridDim.x) * blockDim.x) {
+    row_nnz[row] = _sparse_row_walk(row, n_cols, density, seed,
+                                    [](IdxT k, IdxT col) {});
+  }
+}
+
+template <typename DataT, typename IdxT>
+__global__ void _sparse_fill_kernel(IdxT* indices, DataT* values,
+                                    const IdxT* indptr, IdxT n_rows,
+                                    IdxT n_cols, double density,
+                                    DataT value_min, DataT value_max,
+                                    uint64_t seed) {
+  for (IdxT row = IdxT(blockIdx.x) * blockDim.x + threadIdx.x; row < n_rows;
+       row += IdxT(gridDim.x) * blockDim.x) {
+    IdxT start = indptr[row];
+    _sparse_row_walk(row, n_cols, density, seed, [&](IdxT k, IdxT col) {
+      indices[start + k] = col;
+      values[start + k] = statelessUniformAt(
+        seed, SparseValues, uint64_t(start + k), value_min, value_max);
+    });
+  }
+}
+
+/**
+ * @brief Generate the row pointers of the random CSR matrix
+ * @tparam IdxT type of the row pointers and the column indices
+ * @param indptr the output row pointers on device (dim = n_rows + 1), the
+ * last of which is the nnz
+ * @param n_rows number of rows of the matrix
+ * @param n_cols number of columns of the matrix
+ * @param density the probability of an element being non-zero, in [0, 1]
+ * @param seed the seed of the matrix
+ * @param stream cuda stream to schedule the work on
+ */
+template <typename IdxT>
+void make_sparse_rows(IdxT* indptr, IdxT n_rows, IdxT n_cols, double density,
+                      uint64_t seed, cudaStream_t stream) {
+  ASSERT(density >= 0.0 && density <= 1.0,
+         "make_sparse_rows: density must be in [0, 1]");
+  CUDA_CHECK(cudaMemsetAsync(indptr, 0, sizeof(IdxT), stream));
+  if (n_rows <= 0) return;
+  constexpr int TPB = 256;
+  int nblks = std::min<IdxT>(ceildiv<IdxT>(n_rows, TPB),
+                             8 * getMultiProcessorCount());
+  _sparse_rows_kernel<<<nblks, TPB, 0, stream>>>(indptr + 1, n_rows, n_cols,
+                                                 density, seed);
+  CUDA_CHECK(cudaPeekAtLastError());
+  thrust::inclusive_scan(thrust::cuda::par.on(stream), indptr + 1,
+                         indptr + n_rows + 1, indptr + 1);
+}
+
+/**
+ * @brief Generate the column indices and the values of the random CSR matrix
+ * whose row pointers make_sparse_rows generated with the same params
+ * @tparam DataT type of the values
+ * @tparam IdxT type of the row pointers and the column indices
+ * @param indices the output column indices on device (dim = nnz), sorted in
+ * each row
+ * @param values the output values on device (dim = nnz)
+ * @param indptr the row pointers of make_sparse_rows on device
+ * (dim = n_rows + 1)
+ * @param n_rows number of rows of the matrix
+ * @param n_cols number of columns of the matrix
+ * @param density the probability of an element being non-zero, in [0, 1]
+ * @param value_min min value of the non-zeros
+ * @param value_max max value of the non-zeros, excluded
+ * @param seed the seed of the matrix
+ * @param stream cuda stream to schedule the work on
+ */
+template <typename DataT, typename IdxT>
+void make_sparse(IdxT* indices, DataT* values, const IdxT* indptr,
+                 IdxT n_rows, IdxT n_cols, double density, DataT value_min,
+                 DataT value_max, uint64_t seed, cudaStream_t stream) {
+  ASSERT(density >= 0.0 && density <= 1.0,
+         "make_sparse: density must be in [0, 1]");
+  if (n_rows <= 0) return;
+  constexpr int TPB = 256;
+  int nblks = std::min<IdxT>(ceildiv<IdxT>(n_rows, TPB),
+                             8 * getMultiProcessorCount());
+  _sparse_fill_kernel<<<nblks, TPB, 0, stream>>>(indices, values, indptr,
+                                                 n_rows, n_cols, density,
+                                                 value_min, value_max, seed);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+/** @} */
+
+}  // namespace Random
+}  // namespace MLCommon
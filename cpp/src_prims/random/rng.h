@@ -22,10 +22,10 @@
 #include <cuml/common/cuml_allocator.hpp>
 #include <random>
 #include <type_traits>
-#include "common/cub_wrappers.h"
 #include "common/scatter.h"
 #include "cuda_utils.h"
 #include "rng_impl.h"
+#include "sampling.h"
 
 namespace MLCommon {
 namespace Random {
@@ -479,7 +479,6 @@ class Rng {
     ASSERT(sampledLen <= len,
            "sampleWithoutReplacement: 'sampledLen' cant be more than 'len'.");
     device_buffer<WeightsT> expWts(allocator, stream, len);
-    device_buffer<WeightsT> sortedWts(allocator, stream, len);
     device_buffer<IdxT> inIdx(allocator, stream, len);
     device_buffer<IdxT> outIdxBuff(allocator, stream);
     auto *inIdxPtr = inIdx.data();
@@ -496,18 +495,17 @@ class Rng {
         return exp;
       },
       NumThreads, nBlocks, type, stream);
-    ///@todo: use a more efficient partitioning scheme instead of full sort
-    // sort the array and pick the top sampledLen items
+    // pick the sampledLen smallest keys, sorted among themselves only
     IdxT *outIdxPtr;
     if (outIdx == nullptr) {
-      outIdxBuff.resize(len, stream);
+      outIdxBuff.resize(sampledLen, stream);
       outIdxPtr = outIdxBuff.data();
     } else {
       outIdxPtr = outIdx;
     }
-    device_buffer<char> workspace(allocator, stream);
-    sortPairs(workspace, expWts.data(), sortedWts.data(), inIdxPtr, outIdxPtr,
-              (int)len, stream);
+    if (sampledLen <= 0) return;
+    detail::sortedSmallestKeys(outIdxPtr, expWts.data(), inIdxPtr, sampledLen,
+                               len, allocator, stream);
     scatter<DataT, IdxT>(out, in, outIdxPtr, sampledLen, stream);
   }
 
@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+#include <math_constants.h>
+#include <cub/cub.cuh>
+#include <cuml/common/cuml_allocator.hpp>
+#include "common/cub_wrappers.h"
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "random/stateless_rng.h"
+#include "selection/radix_topk.h"
+#include "selection/segmented_sort.h"
+
+namespace MLCommon {
+namespace Random {
+
+/**
+ * @defgroup Sampling
+ * @{
+ * @brief Sampling of indices of a population of n on the device, in time that
+ * grows with the sample rather than with a sort of the population. The draws
+ * come from the stateless stream (seed, streamId) of stateless_rng.h, so the
+ * samples only depend on their arguments.
+ */
+
+/** the streams of a seed used by the samplers, one per kind of draw */
+enum SamplingStream {
+  SamplingStreamUniform = 0,
+  SamplingStreamWeighted,
+  SamplingStreamWithReplacement
+};
+
+namespace detail {
+
+/**
+ * @brief the indices of the k smallest keys, sorted by key, with a full sort
+ * of the keys for the types radixTopKWide does not take
+ */
+template <typename WeightsT, typename IdxT>
+void sortedSmallestKeys(IdxT *outIdx, const WeightsT *keys, const IdxT *idx,
+                        IdxT k, IdxT len,
+                        std::shared_ptr<deviceAllocator> allocator,
+                        cudaStream_t stream) {
+  device_buffer<WeightsT> sortedKeys(allocator, stream, len);
+  device_buffer<IdxT> sortedIdx(allocator, stream, len);
+  device_buffer<char> workspace(allocator, stream);
+  sortPairs(workspace, keys, sortedKeys.data(), idx, sortedIdx.data(),
+            (int)len, stream);
+  copyAsync(outIdx, sortedIdx.data(), k, stream);
+}
+
+/**
+ * @brief the indices of the k smallest keys, sorted by key, with a radix
+ * select of the k keys before their sort
+ */
+inline void sortedSmallestKeys(int *outIdx, const float *keys, const int *idx,
+                               int k, int len,
+                               std::shared_ptr<deviceAllocator> allocator,
+                               cudaStream_t stream) {
+  device_buffer<float> selKeys(allocator, stream, k);
+  device_buffer<int> selIdx(allocator, stream, k);
+  Selection::radixTopKWide<float, int, true>(selKeys.data(), selIdx.data(),
+                                             keys, k, len, allocator, stream);
+  Selection::segmentedSortPairs(selKeys.data(), (float *)nullptr,
+                                selIdx.data(), outIdx, k, 1,
+                                (const int *)nullptr, allocator, stream);
+}
+
+template <typename WeightsT, typename IdxT, int TPB>
+__global__ void weightedSampleKeysKernel(float *keys, const WeightsT *wts,
+                                         IdxT n, uint64_t seed) {
+  for (IdxT i = threadIdx.x + IdxT(blockIdx.x) * TPB; i < n;
+       i += IdxT(gridDim.x) * TPB) {
+    float u = statelessUniformAt(seed, SamplingStreamWeighted, uint64_t(i),
+                                 0.f, 1.f);
+    // exponential of rate wts[i]; the null weights are never picked first
+    float e = -myLog(1.f - u);
+    float w = wts == nullptr ? 1.f : float(wts[i]);
+    keys[i] = w > 0.f ? e / w : CUDART_INF_F;
+  }
+}
+
+template <typename OutT, typename InT, typename IdxT, int TPB>
+__global__ void castKernel(OutT *out, const InT *in, IdxT len) {
+  for (IdxT i = threadIdx.x + IdxT(blockIdx.x) * TPB; i < len;
+       i += IdxT(gridDim.x) * TPB) {
+    out[i] = OutT(in[i]);
+  }
+}
+
+template <typename IdxT, int TPB>
+__global__ void bitmapDrawKernel(uint32_t *bitmap, unsigned long long *count,
+                                 IdxT n, IdxT nDraws, uint64_t firstDraw,
+                                 uint64_t seed) {
+  for (IdxT i = threadIdx.x + IdxT(blockIdx.x) * TPB; i < nDraws;
+       i += IdxT(gridDim.x) * TPB) {
+    IdxT idx = statelessUniformIntAt(seed, SamplingStreamUniform,
+                                     firstDraw + uint64_t(i), IdxT(0), n);
+    uint32_t bit = 1u << (idx % 32);
+    uint32_t old = atomicOr(bitmap + idx / 32, bit);
+    if (!(old & bit)) atomicAdd(count, 1ull);
+  }
+}
+
+template <typename IdxT, int TPB>
+__global__ void bitmapPopcKernel(IdxT *counts, const uint32_t *bitmap,
+                                 IdxT nWords) {
+  for (IdxT w = threadIdx.x + IdxT(blockIdx.x) * TPB; w < nWords;
+       w += IdxT(gridDim.x) * TPB) {
+    counts[w] = __popc(bitmap[w]);
+  }
+}
+
+template <typename IdxT, int TPB>
+__global__ void bitmapCompactKernel(IdxT *outIdx, const uint32_t *bitmap,
+                                    const IdxT *starts, IdxT nWords) {
+  for (IdxT w = threadIdx.x + IdxT(blockIdx.x) * TPB; w < nWords;
+       w += IdxT(gridDim.x) * TPB) {
+    uint32_t bits = bitmap[w];
+    IdxT pos = starts[w];
+    while (bits) {
+      int b = __ffs(bits) - 1;
+      outIdx[pos++] = w * 32 + b;
+      bits &= bits - 1;
+    }
+  }
+}
+
+template <typename IdxT, int TPB>
+__global__ void cdfSampleKernel(IdxT *outIdx, const double *cdf, IdxT k,
+                                IdxT n, uint64_t seed) {
+  double total = cdf[n - 1];
+  for (IdxT i = threadIdx.x + IdxT(blockIdx.x) * TPB; i < k;
+       i += IdxT(gridDim.x) * TPB) {
+    double u = statelessUniformAt(seed, SamplingStreamWithReplacement,
+                                  uint64_t(i), 0.0, 1.0) *
+               total;
+    // the first index whose inclusive cdf is above u
+    IdxT lo = 0, hi = n - 1;
+    while (lo < hi) {
+      IdxT mid = lo + (hi - lo) / 2;
+      if (cdf[mid] > u) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    outIdx[i] = lo;
+  }
+}
+
+template <typename IdxT>
+int samplingGridSize(IdxT len, int tpb) {
+  return int(std::min<IdxT>(ceildiv<IdxT>(len, IdxT(tpb)),
+                            IdxT(4 * getMultiProcessorCount())));
+}
+
+};  // end namespace detail
+
+/**
+ * @brief Sample k distinct indices uniformly from [0, n)
+ *
+ * Up to n / 2, the indices are drawn with replacement into a bitmap of the
+ * population, each round drawing as many as are still missing, until k are
+ * distinct: the first k distinct draws of a sequence of uniform draws are a
+ * uniform sample, and as no round overshoots, the bitmap only ever holds
+ * those. Beyond n / 2 the unweighted keys of weightedSampleWithoutReplacement
+ * select the sample. The time is then in O(k) draws plus O(n / 32) words of
+ * the bitmap, or the O(n) keys of the select, with no sort of the population.
+ *
+ * @tparam IdxT index type
+ * @param outIdx the sampled indices, increasing up to n / 2, in no particular
+ * order otherwise (k)
+ * @param k size of the sample
+ * @param n size of the population
+ * @param seed seed of the draws
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ */
+template <typename IdxT = int>
+void uniformSampleWithoutReplacement(IdxT *outIdx, IdxT k, IdxT n,
+                                     uint64_t seed,
+                                     std::shared_ptr<deviceAllocator> allocator,
+                                     cudaStream_t stream);
+
+/**
+ * @brief Sample k distinct indices from [0, n), each draw picking an index
+ * with a probability proportional to its weight among those left
+ *
+ * The sample is the k smallest of the exponential keys -log(u_i) / w_i
+ * (Efraimidis and Spirakis), which a grid-wide radix select finds in a few
+ * passes over the keys instead of sorting them all, as k-means init and the
+ * bootstraps of the forests need.
+ *
+ * @tparam WeightsT weights type
+ * @tparam IdxT index type
+ * @param outIdx the sampled indices, in no particular order (k)
+ * @param wts the nonnegative weights (n), or nullptr for all to be the same;
+ * the null weights are only sampled once all the others are
+ * @param k size of the sample
+ * @param n size of the population
+ * @param seed seed of the draws
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ */
+template <typename WeightsT, typename IdxT = int>
+void weightedSampleWithoutReplacement(
+  IdxT *outIdx, const WeightsT *wts, IdxT k, IdxT n, uint64_t seed,
+  std::shared_ptr<deviceAllocator> allocator, cudaStream_t stream) {
+  ASSERT(k <= n, "weightedSampleWithoutReplacement: k=%d more than n=%d",
+         int(k), int(n));
+  ASSERT(n <= IdxT(std::numeric_limits<int>::max()),
+         "weightedSampleWithoutReplacement: the select counts in int");
+  if (k <= 0) return;
+  constexpr int TPB = 256;
+  device_buffer<float> keys(allocator, stream, n);
+  detail::weightedSampleKeysKernel<WeightsT, IdxT, TPB>
+    <<<detail::samplingGridSize(n, TPB), TPB, 0, stream>>>(keys.data(), wts, n,
+                                                           seed);
+  CUDA_CHECK(cudaPeekAtLastError());
+  device_buffer<int> selIdx(allocator, stream, k);
+  Selection::radixTopKWide<float, int, true>(
+    (float *)nullptr, selIdx.data(), keys.data(), int(k), int(n), allocator,
+    stream);
+  detail::castKernel<IdxT, int, IdxT, TPB>
+    <<<detail::samplingGridSize(k, TPB), TPB, 0, stream>>>(outIdx,
+                                                           selIdx.data(), k);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+template <typename IdxT>
+void uniformSampleWithoutReplacement(IdxT *outIdx, IdxT k, IdxT n,
+                                     uint64_t seed,
+                                     std::shared_ptr<deviceAllocator> allocator,
+                                     cudaStream_t stream) {
+  ASSERT(k <= n, "uniformSampleWithoutReplacement: k=%d more than n=%d",
+         int(k), int(n));
+  if (k <= 0) return;
+  if (k > n / 2) {
+    weightedSampleWithoutReplacement(outIdx, (const float *)nullptr, k, n,
+                                     seed, allocator, stream);
+    return;
+  }
+  constexpr int TPB = 256;
+  IdxT nWords = ceildiv<IdxT>(n, IdxT(32));
+  device_buffer<uint32_t> bitmap(allocator, stream, nWords);
+  device_buffer<unsigned long long> count(allocator, stream, 1);
+  CUDA_CHECK(
+    cudaMemsetAsync(bitmap.data(), 0, nWords * sizeof(uint32_t), stream));
+  CUDA_CHECK(cudaMemsetAsync(count.data(), 0, sizeof(unsigned long long),
+                             stream));
+  unsigned long long nDistinct = 0;
+  uint64_t nDrawn = 0;
+  while (nDistinct < (unsigned long long)k) {
+    IdxT nDraws = k - IdxT(nDistinct);
+    detail::bitmapDrawKernel<IdxT, TPB>
+      <<<detail::samplingGridSize(nDraws, TPB), TPB, 0, stream>>>(
+        bitmap.data(), count.data(), n, nDraws, nDrawn, seed);
+    CUDA_CHECK(cudaPeekAtLastError());
+    nDrawn += uint64_t(nDraws);
+    updateHost(&nDistinct, count.data(), 1, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  device_buffer<IdxT> counts(allocator, stream, nWords);
+  device_buffer<IdxT> starts(allocator, stream, nWords);
+  detail::bitmapPopcKernel<IdxT, TPB>
+    <<<detail::samplingGridSize(nWords, TPB), TPB, 0, stream>>>(
+      counts.data(), bitmap.data(), nWords);
+  CUDA_CHECK(cudaPeekAtLastError());
+  size_t bytes = 0;
+  CUDA_CHECK(cub::DeviceScan::ExclusiveSum(nullptr, bytes, counts.data(),
+                                           starts.data(), nWords, stream));
+  device_buffer<char> storage(allocator, stream, bytes);
+  CUDA_CHECK(cub::DeviceScan::ExclusiveSum(storage.data(), bytes,
+                                           counts.data(), starts.data(),
+                                           nWords, stream));
+  detail::bitmapCompactKernel<IdxT, TPB>
+    <<<detail::samplingGridSize(nWords, TPB), TPB, 0, stream>>>(
+      outIdx, bitmap.data(), starts.data(), nWords);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Sample k indices from [0, n) with replacement, each with a
+ * probability proportional to its weight, as the candidates of k-means++ or
+ * the negative samples of UMAP
+ *
+ * The draws are searched in the cumulative sums of the weights, in double for
+ * the small weights not to be lost in the large sums.
+ *
+ * @tparam WeightsT weights type
+ * @tparam IdxT index type
+ * @param outIdx the sampled indices, in the order of the draws (k)
+ * @param wts the nonnegative weights, not all zero (n)
+ * @param k size of the sample
+ * @param n size of the population
+ * @param seed seed of the draws
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ */
+template <typename WeightsT, typename IdxT = int>
+void weightedSampleWithReplacement(IdxT *outIdx, const WeightsT *wts, IdxT k,
+                                   IdxT n, uint64_t seed,
+                                   std::shared_ptr<deviceAllocator> allocator,
+                                   cudaStream_t stream) {
+  if (k <= 0) return;
+  ASSERT(n > 0, "weightedSampleWithReplacement: empty population");
+  constexpr int TPB = 256;
+  device_buffer<double> cdf(allocator, stream, n);
+  detail::castKernel<double, WeightsT, IdxT, TPB>
+    <<<detail::samplingGridSize(n, TPB), TPB, 0, stream>>>(cdf.data(), wts, n);
+  CUDA_CHECK(cudaPeekAtLastError());
+  size_t bytes = 0;
+  CUDA_CHECK(cub::DeviceScan::InclusiveSum(nullptr, bytes, cdf.data(),
+                                           cdf.data(), n, stream));
+  device_buffer<char> storage(allocator, stream, bytes);
+  CUDA_CHECK(cub::DeviceScan::InclusiveSum(storage.data(), bytes, cdf.data(),
+                                           cdf.data(), n, stream));
+  detail::cdfSampleKernel<IdxT, TPB>
+    <<<detail::samplingGridSize(k, TPB), TPB, 0, stream>>>(outIdx, cdf.data(),
+                                                           k, n, seed);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+/** @} */
+
+};  // end namespace Random
+};  // end namespace MLCommon
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <type_traits>
+#include "cuda_utils.h"
+
+namespace MLCommon {
+namespace Random {
+
+/**
+ * @defgroup StatelessRng
+ * @{
+ * @brief Counter-based random numbers without any state: the value at index
+ * idx of the random stream (seed, streamId) is a function of those three
+ * alone, the Philox4x32-10 block of the counter (idx, streamId) under the key
+ * seed. Unlike Rng, whose results depend on the order of its calls and on the
+ * launch configuration, any rank or kernel can thus produce any slice of a
+ * globally consistent stream, skipping ahead to its first index for free.
+ * Each index uses a block of its own: the 32-bit types take its first word,
+ * the 64-bit ones its first two and the normals all four.
+ */
+
+/** one Philox4x32 round on the 4 words of the counter */
+HDI uint4 philoxRound(uint4 ctr, uint2 key) {
+  const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+#ifdef __CUDA_ARCH__
+  uint32_t hi0 = __umulhi(M0, ctr.x), hi1 = __umulhi(M1, ctr.z);
+#else
+  uint32_t hi0 = uint32_t((uint64_t(M0) * ctr.x) >> 32);
+  uint32_t hi1 = uint32_t((uint64_t(M1) * ctr.z) >> 32);
+#endif
+  uint32_t lo0 = M0 * ctr.x, lo1 = M1 * ctr.z;
+  return make_uint4(hi1 ^ ctr.y ^ key.x, lo1, hi0 ^ ctr.w ^ key.y, lo0);
+}
+
+/** the Philox4x32-10 block of index idx of the stream (seed, streamId) */
+HDI uint4 philox4x32(uint64_t seed, uint64_t streamId, uint64_t idx) {
+  const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+  uint4 ctr = make_uint4(uint32_t(idx), uint32_t(idx >> 32), uint32_t(streamId),
+                         uint32_t(streamId >> 32));
+  uint2 key = make_uint2(uint32_t(seed), uint32_t(seed >> 32));
+#pragma unroll
+  for (int r = 0; r < 9; ++r) {
+    ctr = philoxRound(ctr, key);
+    key.x += W0;
+    key.y += W1;
+  }
+  return philoxRound(ctr, key);
+}
+
+/** uniform in [0, 1), with all the 24 bits of the float mantissa random */
+HDI float toUniform(uint32_t bits, float) {
+  return float(bits >> 8) * (1.f / 16777216.f);
+}
+
+/** uniform in [0, 1), with all the 53 bits of the double mantissa random */
+HDI double toUniform(uint32_t lo, uint32_t hi, double) {
+  uint64_t bits = (uint64_t(hi) << 32) | lo;
+  return double(bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief the uniform random number in [start, end) at index idx of the stream
+ * (seed, streamId)
+ */
+template <typename Type>
+HDI Type statelessUniformAt(uint64_t seed, uint64_t streamId, uint64_t idx,
+                            Type start, Type end) {
+  static_assert(std::is_floating_point<Type>::value,
+                "Type for 'uniform' can only be floating point type!");
+  uint4 b = philox4x32(seed, streamId, idx);
+  Type u = sizeof(Type) == 4 ? Type(toUniform(b.x, float()))
+                             : Type(toUniform(b.x, b.y, double()));
+  return u * (end - start) + start;
+}
+
+/**
+ * @brief the uniform random integer in [start, end) at index idx of the
+ * stream (seed, streamId), reduced modulo the range as Rng::uniformInt
+ */
+template <typename IntType>
+HDI IntType statelessUniformIntAt(uint64_t seed, uint64_t streamId,
+                                  uint64_t idx, IntType start, IntType end) {
+  static_assert(std::is_integral<IntType>::value,
+                "Type for 'uniformInt' can only be integer type!");
+  uint4 b = philox4x32(seed, streamId, idx);
+  uint64_t range = uint64_t(end - start);
+  uint64_t bits = sizeof(IntType) <= 4 ? uint64_t(b.x)
+                                       : (uint64_t(b.y) << 32) | b.x;
+  return IntType(bits % range) + start;
+}
+
+/**
+ * @brief the normal random number of mean mu and std-dev sigma at index idx
+ * of the stream (seed, streamId), by Box-Muller on the uniforms of its block
+ */
+template <typename Type>
+DI Type statelessNormalAt(uint64_t seed, uint64_t streamId, uint64_t idx,
+                          Type mu, Type sigma) {
+  static_assert(std::is_floating_point<Type>::value,
+                "Type for 'normal' can only be floating point type!");
+  uint4 b = philox4x32(seed, streamId, idx);
+  Type u1, u2;
+  if (sizeof(Type) == 4) {
+    u1 = Type(toUniform(b.x, float()));
+    u2 = Type(toUniform(b.y, float()));
+  } else {
+    u1 = Type(toUniform(b.x, b.y, double()));
+    u2 = Type(toUniform(b.z, b.w, double()));
+  }
+  // 1 - u1 is in (0, 1], for the log to be finite
+  Type R = mySqrt(Type(-2.0) * myLog(Type(1.0) - u1));
+  Type s, c;
+  mySinCos(Type(2.0) * Type(3.141592653589793) * u2, s, c);
+  return R * c * sigma + mu;
+}
+
+template <typename OutType, typename LenType, typename Lambda>
+__global__ void statelessRandKernel(OutType *ptr, LenType len,
+                                    uint64_t firstIdx, Lambda randOp) {
+  for (LenType i = LenType(blockIdx.x) * blockDim.x + threadIdx.x; i < len;
+       i += LenType(gridDim.x) * blockDim.x) {
+    ptr[i] = randOp(firstIdx + uint64_t(i));
+  }
+}
+
+template <typename OutType, typename LenType, typename Lambda>
+void statelessRandImpl(OutType *ptr, LenType len, uint64_t firstIdx,
+                       Lambda randOp, cudaStream_t stream) {
+  if (len <= 0) return;
+  constexpr int TPB = 256;
+  // the values do not depend on the grid, so it is sized for occupancy only
+  int nblks = std::min<LenType>(ceildiv<LenType>(len, TPB),
+                                4 * getMultiProcessorCount());
+  statelessRandKernel<OutType, LenType, Lambda>
+    <<<nblks, TPB, 0, stream>>>(ptr, len, firstIdx, randOp);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Generate the uniform random numbers of indices [firstIdx,
+ * firstIdx + len) of the stream (seed, streamId)
+ * @tparam Type data type of output random number
+ * @tparam LenType data type used to represent length of the arrays
+ * @param ptr the output array
+ * @param len the number of elements in the output
+ * @param start start of the range
+ * @param end end of the range
+ * @param seed the key of the stream
+ * @param streamId which of the streams of the seed
+ * @param firstIdx index in the stream of ptr[0]
+ * @param stream stream where to launch the kernel
+ */
+template <typename Type, typename LenType = int>
+void statelessUniform(Type *ptr, LenType len, Type start, Type end,
+                      uint64_t seed, uint64_t streamId, uint64_t firstIdx,
+                      cudaStream_t stream) {
+  statelessRandImpl(
+    ptr, len, firstIdx,
+    [=] __device__(uint64_t idx) {
+      return statelessUniformAt(seed, streamId, idx, start, end);
+    },
+    stream);
+}
+
+/**
+ * @brief Generate the uniform random integers of indices [firstIdx,
+ * firstIdx + len) of the stream (seed, streamId)
+ * @tparam IntType data type of output random number
+ * @tparam LenType data type used to represent length of the arrays
+ * @param ptr the output array
+ * @param len the number of elements in the output
+ * @param start start of the range
+ * @param end end of the range, excluded
+ * @param seed the key of the stream
+ * @param streamId which of the streams of the seed
+ * @param firstIdx index in the stream of ptr[0]
+ * @param stream stream where to launch the kernel
+ */
+template <typename IntType, typename LenType = int>
+void statelessUniformInt(IntType *ptr, LenType len, IntType start, IntType end,
+                         uint64_t seed, uint64_t streamId, uint64_t firstIdx,
+                         cudaStream_t stream) {
+  statelessRandImpl(
+    ptr, len, firstIdx,
+    [=] __device__(uint64_t idx) {
+      return statelessUniformIntAt(seed, streamId, idx, start, end);
+    },
+    stream);
+}
+
+/**
+ * @brief Generate the normal random numbers of indices [firstIdx,
+ * firstIdx + len) of the stream (seed, streamId)
+ * @tparam Type data type of output random number
+ * @tparam LenType data type used to represent length of the arrays
+ * @param ptr the output array
+ * @param len the number of elements in the output
+ * @param mu mean of the distribution
+ * @param sigma std-dev of the distribution
+ * @param seed the key of the stream
+ * @param streamId which of the streams of the seed
+ * @param firstIdx index in the stream of ptr[0]
+ * @param stream stream where to launch the kernel
+ */
+template <typename Type, typename LenType = int>
+void statelessNormal(Type *ptr, LenType len, Type mu, Type sigma,
+                     uint64_t seed, uint64_t streamId, uint64_t firstIdx,
+                     cudaStream_t stream) {
+  statelessRandImpl(
+    ptr, len, firstIdx,
+    [=] __device__(uint64_t idx) {
+      return statelessNormalAt(seed, streamId, idx, mu, sigma);
+    },
+    stream);
+}
+
+/**
+ * @brief Generate the coin tosses of indices [firstIdx, firstIdx + len) of
+ * the stream (seed, streamId), true with probability prob
+ * @tparam Type data type in which to compute the probabilities
+ * @tparam LenType data type used to represent length of the arrays
+ * @param ptr the output array
+ * @param len the number of elements in the output
+ * @param prob the probability of true
+ * @param seed the key of the stream
+ * @param streamId which of the streams of the seed
+ * @param firstIdx index in the stream of ptr[0]
+ * @param stream stream where to launch the kernel
+ */
+template <typename Type, typename LenType = int>
+void statelessBernoulli(bool *ptr, LenType len, Type prob, uint64_t seed,
+                        uint64_t streamId, uint64_t firstIdx,
+                        cudaStream_t stream) {
+  statelessRandImpl(
+    ptr, len, firstIdx,
+    [=] __device__(uint64_t idx) {
+      return statelessUniformAt(seed, streamId, idx, Type(0), Type(1)) < prob;
+    },
+    stream);
+}
+/** @} */
+
+};  // end namespace Random
+};  // end namespace MLCommon
@@ -18,14 +18,16 @@
 
 #include "linalg/eltwise.h"
 #include "linalg/power.h"
+#include "linalg/reduce.h"
 #include "linalg/subtract.h"
 #include "stats/mean.h"
 
+#include <algorithm>
 #include <memory>
 
 #include <cuml/common/cuml_allocator.hpp>
 
-#include <selection/columnWiseSort.h>
+#include "common/device_buffer.hpp"
 #include "distance/distance.h"
 #include "selection/knn.h"
 
@@ -39,31 +41,58 @@ namespace MLCommon {
 namespace Score {
 
 /**
- * @brief Compute a the rank of trustworthiness score
- * @input param ind_X: indexes given by pairwise distance and sorting
- * @input param ind_X_embedded: indexes given by KNN
- * @input param n: Number of samples
- * @input param n_neighbors: Number of neighbors considered by trustworthiness score
- * @input param work: Batch to consider (to do it at once use n * n_neighbors)
- * @output param rank: Resulting rank
+ * @brief Accumulates the trustworthiness penalties of a batch of samples, a
+ * block per sample. The rank in the original space of each embedded neighbor
+ * is the number of samples closer to the sample than it, counted for up to
+ * K_CHUNK neighbors at a time in a single pass over the row of distances, so
+ * that the row needs not be sorted.
+ * @param dist: distances of the batch to all the samples (batchSize x n)
+ * @param ind_X_embedded: indexes of the neighbors in the embedding of the
+ * batch, the sample itself first (batchSize x (n_neighbors + 1))
+ * @param n: Number of samples
+ * @param n_neighbors: Number of neighbors considered by trustworthiness score
+ * @param rank: sum of the ranks beyond n_neighbors
  */
-template <typename math_t, typename knn_index_t>
-__global__ void compute_rank(math_t *ind_X, knn_index_t *ind_X_embedded, int n,
-                             int n_neighbors, int work, double *rank) {
-  int i = blockIdx.x * blockDim.x + threadIdx.x;
-  if (i >= work) return;
-
-  int n_idx = i / n_neighbors;
-  int nn_idx = (i % n_neighbors) + 1;
-
-  knn_index_t idx = ind_X_embedded[n_idx * (n_neighbors + 1) + nn_idx];
-  math_t *sample_i = &ind_X[n_idx * n];
-  for (int r = 1; r < n; r++) {
-    if (sample_i[r] == idx) {
-      int tmp = r - n_neighbors;
+template <typename math_t, typename knn_index_t, int TPB, int K_CHUNK>
+__global__ void compute_rank(const math_t *dist,
+                             const knn_index_t *ind_X_embedded, int n,
+                             int n_neighbors, double *rank) {
+  __shared__ math_t thresholds[K_CHUNK];
+  __shared__ int counts[K_CHUNK];
+  const math_t *sample_dist = dist + (size_t)blockIdx.x * n;
+  const knn_index_t *sample_nn =
+    ind_X_embedded + (size_t)blockIdx.x * (n_neighbors + 1) + 1;
+
+  for (int start = 0; start < n_neighbors; start += K_CHUNK) {
+    int chunk = min(K_CHUNK, n_neighbors - start);
+    if (threadIdx.x < chunk) {
+      thresholds[threadIdx.x] = sample_dist[sample_nn[start + threadIdx.x]];
+      counts[threadIdx.x] = 0;
+    }
+    __syncthreads();
+
+    int closer[K_CHUNK];
+#pragma unroll
+    for (int j = 0; j < K_CHUNK; j++) closer[j] = 0;
+    for (int l = threadIdx.x; l < n; l += TPB) {
+      math_t d = sample_dist[l];
+#pragma unroll
+      for (int j = 0; j < K_CHUNK; j++)
+        closer[j] += j < chunk && d < thresholds[j];
+    }
+#pragma unroll
+    for (int j = 0; j < K_CHUNK; j++) {
+      int sum = warpReduce(closer[j]);
+      if (laneId() == 0 && j < chunk) atomicAdd(counts + j, sum);
+    }
+    __syncthreads();
+
+    // the sample itself is among the closer ones, as rank 0 of its sort
+    if (threadIdx.x < chunk) {
+      int tmp = counts[threadIdx.x] - n_neighbors;
       if (tmp > 0) atomicAdd(rank, tmp);
-      break;
     }
+    __syncthreads();
   }
 }
 
@@ -108,74 +137,67 @@ long *get_knn_indexes(math_t *input, int n, int d, int n_neighbors,
  * @param n_neighbors Number of neighbors considered by trustworthiness score
  * @param d_alloc device allocator to use for temp device memory
  * @param stream the cuda stream to use
+ * @param batchSize number of samples whose distances to all the samples are
+ * computed at a time; if 0, at most MAX_BATCH_SIZE, fewer if the free device
+ * memory is short
  * @return Trustworthiness score
  */
 template <typename math_t, Distance::DistanceType distance_type>
 double trustworthiness_score(math_t *X, math_t *X_embedded, int n, int m, int d,
                              int n_neighbors,
                              std::shared_ptr<deviceAllocator> d_alloc,
-                             cudaStream_t stream) {
-  const int TMP_SIZE = MAX_BATCH_SIZE * n;
-
-  size_t workspaceSize =
-    0;  // EucUnexpandedL2Sqrt does not require workspace (may need change for other distances)
+                             cudaStream_t stream, int batchSize = 0) {
   typedef cutlass::Shape<8, 128, 128> OutputTile_t;
-  bool bAllocWorkspace = false;
+  constexpr int K_CHUNK = 32;
+
+  if (batchSize <= 0) {
+    size_t freeMem, totalMem;
+    CUDA_CHECK(cudaMemGetInfo(&freeMem, &totalMem));
+    batchSize = (int)std::min<size_t>(MAX_BATCH_SIZE,
+                                      freeMem / 2 / (n * sizeof(math_t)));
+  }
+  batchSize = std::max(1, std::min(batchSize, n));
 
-  math_t *d_pdist_tmp =
-    (math_t *)d_alloc->allocate(TMP_SIZE * sizeof(math_t), stream);
-  int *d_ind_X_tmp = (int *)d_alloc->allocate(TMP_SIZE * sizeof(int), stream);
+  device_buffer<math_t> d_pdist_tmp(d_alloc, stream, (size_t)batchSize * n);
+  device_buffer<char> workspace(d_alloc, stream, 1);
 
   int64_t *ind_X_embedded =
     get_knn_indexes(X_embedded, n, d, n_neighbors + 1, d_alloc, stream);
 
-  double t_tmp = 0.0;
   double t = 0.0;
-  double *d_t = (double *)d_alloc->allocate(sizeof(double), stream);
+  device_buffer<double> d_t(d_alloc, stream, 1);
+  CUDA_CHECK(cudaMemsetAsync(d_t.data(), 0, sizeof(double), stream));
 
-  int toDo = n;
-  while (toDo > 0) {
-    int batchSize = min(toDo, MAX_BATCH_SIZE);
-    // Takes at most MAX_BATCH_SIZE vectors at a time
+  for (int start = 0; start < n; start += batchSize) {
+    int rows = std::min(batchSize, n - start);
+    const math_t *X_batch = X + (size_t)start * m;
 
+    size_t workspaceSize =
+      Distance::getWorkspaceSize<distance_type, math_t, math_t, math_t>(
+        X_batch, X, rows, n, m);
+    workspace.resize(workspaceSize, stream);
     MLCommon::Distance::distance<distance_type, math_t, math_t, math_t,
                                  OutputTile_t>(
-      &X[(n - toDo) * m], X, d_pdist_tmp, batchSize, n, m, (void *)nullptr,
+      X_batch, X, d_pdist_tmp.data(), rows, n, m, (void *)workspace.data(),
       workspaceSize, stream);
     CUDA_CHECK(cudaPeekAtLastError());
 
-    MLCommon::Selection::sortColumnsPerRow(d_pdist_tmp, d_ind_X_tmp, batchSize,
-                                           n, bAllocWorkspace, NULL,
-                                           workspaceSize, stream);
+    compute_rank<math_t, int64_t, N_THREADS, K_CHUNK>
+      <<<rows, N_THREADS, 0, stream>>>(
+        d_pdist_tmp.data(), ind_X_embedded + (size_t)start * (n_neighbors + 1),
+        n, n_neighbors, d_t.data());
     CUDA_CHECK(cudaPeekAtLastError());
-
-    t_tmp = 0.0;
-    updateDevice(d_t, &t_tmp, 1, stream);
-
-    int work = batchSize * n_neighbors;
-    int n_blocks = work / N_THREADS + 1;
-    compute_rank<<<n_blocks, N_THREADS, 0, stream>>>(
-      d_ind_X_tmp, &ind_X_embedded[(n - toDo) * (n_neighbors + 1)], n,
-      n_neighbors, batchSize * n_neighbors, d_t);
-    CUDA_CHECK(cudaPeekAtLastError());
-
-    updateHost(&t_tmp, d_t, 1, stream);
-    CUDA_CHECK(cudaStreamSynchronize(stream));
-
-    t += t_tmp;
-
-    toDo -= batchSize;
   }
 
+  updateHost(&t, d_t.data(), 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
   t =
     1.0 -
     ((2.0 / ((n * n_neighbors) * ((2.0 * n) - (3.0 * n_neighbors) - 1.0))) * t);
 
   d_alloc->deallocate(ind_X_embedded, n * (n_neighbors + 1) * sizeof(int64_t),
                       stream);
-  d_alloc->deallocate(d_pdist_tmp, TMP_SIZE * sizeof(math_t), stream);
-  d_alloc->deallocate(d_ind_X_tmp, TMP_SIZE * sizeof(int), stream);
-  d_alloc->deallocate(d_t, sizeof(double), stream);
 
   return t;
 }
@@ -259,6 +281,77 @@ float accuracy_score(const math_t *predictions, const math_t *ref_predictions,
   return accuracy;
 }
 
+/**
+ * @brief Computes the R-squared scores of n_models predictions of the same
+ * ground truth at once. The mean and the total sum of squares of y are
+ * computed once, and the sums of squared errors of all the models come from
+ * a single segmented reduction, without any synchronization.
+ * @tparam math_t: data type of the responses
+ * @param[out] scores: the R-squared value of each model (GPU pointer, size n_models)
+ * @param[in] y: array of ground-truth response variables (GPU pointer, size n)
+ * @param[in] y_hat: the predictions of the models, row major (GPU pointer, size n_models x n)
+ * @param[in] n_models: number of models
+ * @param[in] n: number of elements in y and in each row of y_hat
+ * @param[in] d_alloc: device allocator.
+ * @param[in] stream: cuda stream.
+ */
+template <typename math_t>
+void batched_r2_score(math_t *scores, const math_t *y, const math_t *y_hat,
+                      int n_models, int n,
+                      std::shared_ptr<deviceAllocator> d_alloc,
+                      cudaStream_t stream) {
+  device_buffer<math_t> y_stats(d_alloc, stream, 2);
+  math_t *y_bar = y_stats.data();
+  math_t *ssto = y_stats.data() + 1;
+
+  const math_t inv_n = math_t(1) / n;
+  LinAlg::reduce(
+    y_bar, y, n, 1, math_t(0), true, true, stream, false,
+    Nop<math_t, int>(), Sum<math_t>(),
+    [inv_n] __device__(math_t sum) { return sum * inv_n; });
+  LinAlg::reduce(
+    ssto, y, n, 1, math_t(0), true, true, stream, false,
+    [y_bar] __device__(math_t v, int j) {
+      math_t diff = v - *y_bar;
+      return diff * diff;
+    });
+  LinAlg::reduce(
+    scores, y_hat, n, n_models, math_t(0), true, true, stream, false,
+    [y] __device__(math_t v, int j) {
+      math_t diff = y[j] - v;
+      return diff * diff;
+    },
+    Sum<math_t>(),
+    [ssto] __device__(math_t sse) { return math_t(1) - sse / *ssto; });
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Computes the accuracies of n_models predictions of the same
+ * reference at once, from a single segmented reduction.
+ * @tparam math_t: data type for predictions (e.g., int for classification)
+ * @param[out] scores: the accuracy of each model in [0, 1] (GPU pointer, size n_models)
+ * @param[in] predictions: the predictions of the models, row major (GPU pointer, size n_models x n)
+ * @param[in] ref_predictions: array of reference (ground-truth) predictions (GPU pointer, size n)
+ * @param[in] n_models: number of models
+ * @param[in] n: number of elements in ref_predictions and in each row of predictions
+ * @param[in] stream: cuda stream.
+ */
+template <typename math_t>
+void batched_accuracy_score(float *scores, const math_t *predictions,
+                            const math_t *ref_predictions, int n_models, int n,
+                            cudaStream_t stream) {
+  const float inv_n = 1.0f / n;
+  LinAlg::reduce(
+    scores, predictions, n, n_models, 0.0f, true, true, stream, false,
+    [ref_predictions] __device__(math_t p, int j) {
+      return p == ref_predictions[j] ? 1.0f : 0.0f;
+    },
+    Sum<float>(),
+    [inv_n] __device__(float correct) { return correct * inv_n; });
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
 template <typename T>
 __global__ void reg_metrics_kernel(const T *predictions,
                                    const T *ref_predictions, int n,
@@ -19,6 +19,7 @@
 #include "cuda_utils.h"
 
 #include "distance/distance.h"
+#include "sweet_knn.h"
 
 #include <faiss/Heap.h>
 #include <faiss/gpu/GpuDistance.h>
@@ -28,13 +29,17 @@
 #include <faiss/gpu/utils/Limits.cuh>
 #include <faiss/gpu/utils/Select.cuh>
 
+#include <cub/cub.cuh>
+#include <cuda_fp16.h>
 #include <thrust/device_vector.h>
 #include <thrust/iterator/transform_iterator.h>
 
 #include <cuml/common/cuml_allocator.hpp>
 #include "common/device_buffer.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 
 namespace MLCommon {
 namespace Selection {
@@ -53,11 +58,28 @@ inline cudaStream_t select_stream(cudaStream_t user_stream,
   return n_int_streams > 0 ? int_streams[idx % n_int_streams] : user_stream;
 }
 
-template <int warp_q, int thread_q, int tpb>
-__global__ void knn_merge_parts_kernel(float *inK, int64_t *inV, float *outK,
-                                       int64_t *outV, size_t n_samples,
-                                       int n_parts, float initK, int64_t initV,
-                                       int k, int64_t *translations) {
+/**
+ * Output of knn_merge_parts: the merged distances and index rows.
+ */
+struct KnnMergeWriter {
+  float *outK;
+  int64_t *outV;
+
+  /** Called by the whole block with the k merged neighbors of row */
+  DI void operator()(int row, const float *smemK, const int64_t *smemV,
+                     int k) const {
+    for (int i = threadIdx.x; i < k; i += blockDim.x) {
+      outK[row * k + i] = smemK[i];
+      outV[row * k + i] = smemV[i];
+    }
+  }
+};
+
+template <int warp_q, int thread_q, int tpb, typename Output>
+__global__ void knn_merge_parts_kernel(float *inK, int64_t *inV,
+                                       size_t n_samples, int n_parts,
+                                       float initK, int64_t initV, int k,
+                                       int64_t *translations, Output output) {
   constexpr int kNumWarps = tpb / faiss::gpu::kWarpSize;
 
   __shared__ float smemK[kNumWarps * warp_q];
@@ -109,17 +131,14 @@ __global__ void knn_merge_parts_kernel(float *inK, int64_t *inV, float *outK,
 
   heap.reduce();
 
-  for (int i = threadIdx.x; i < k; i += tpb) {
-    outK[row * k + i] = smemK[i];
-    outV[row * k + i] = smemV[i];
-  }
+  output(row, smemK, smemV, k);
 }
 
-template <int warp_q, int thread_q>
-inline void knn_merge_parts_impl(float *inK, int64_t *inV, float *outK,
-                                 int64_t *outV, size_t n_samples, int n_parts,
-                                 int k, cudaStream_t stream,
-                                 int64_t *translations) {
+template <int warp_q, int thread_q, typename Output>
+inline void knn_merge_parts_impl(float *inK, int64_t *inV, size_t n_samples,
+                                 int n_parts, int k, cudaStream_t stream,
+                                 int64_t *translations, Output output,
+                                 size_t smem) {
   auto grid = dim3(n_samples);
 
   constexpr int n_threads = (warp_q <= 1024) ? 128 : 64;
@@ -128,11 +147,55 @@ inline void knn_merge_parts_impl(float *inK, int64_t *inV, float *outK,
   auto kInit = faiss::gpu::Limits<float>::getMax();
   auto vInit = -1;
   knn_merge_parts_kernel<warp_q, thread_q, n_threads>
-    <<<grid, block, 0, stream>>>(inK, inV, outK, outV, n_samples, n_parts,
-                                 kInit, vInit, k, translations);
+    <<<grid, block, smem, stream>>>(inK, inV, n_samples, n_parts, kInit,
+                                    vInit, k, translations, output);
   CUDA_CHECK(cudaPeekAtLastError());
 }
 
+/**
+ * @brief Merge knn distances and index matrix, which have been partitioned
+ * by row, handing the k-nearest neighbors of each row to output.
+ *
+ * @tparam Output functor called by a block with the merged neighbors of a row
+ *         in shared memory, like KnnMergeWriter
+ * @param inK partitioned knn distance matrix
+ * @param inV partitioned knn index matrix
+ * @param n_samples number of samples per partition
+ * @param n_parts number of partitions
+ * @param k number of neighbors per partition (also number of merged neighbors)
+ * @param stream CUDA stream to use
+ * @param translations mapping of index offsets for each partition
+ * @param output the output functor
+ * @param smem bytes of dynamic shared memory used by output
+ */
+template <typename Output>
+void knn_merge_parts_output(float *inK, int64_t *inV, size_t n_samples,
+                            int n_parts, int k, cudaStream_t stream,
+                            int64_t *translations, Output output,
+                            size_t smem = 0) {
+  if (k == 1)
+    knn_merge_parts_impl<1, 1>(inK, inV, n_samples, n_parts, k, stream,
+                               translations, output, smem);
+  else if (k <= 32)
+    knn_merge_parts_impl<32, 2>(inK, inV, n_samples, n_parts, k, stream,
+                                translations, output, smem);
+  else if (k <= 64)
+    knn_merge_parts_impl<64, 3>(inK, inV, n_samples, n_parts, k, stream,
+                                translations, output, smem);
+  else if (k <= 128)
+    knn_merge_parts_impl<128, 3>(inK, inV, n_samples, n_parts, k, stream,
+                                 translations, output, smem);
+  else if (k <= 256)
+    knn_merge_parts_impl<256, 4>(inK, inV, n_samples, n_parts, k, stream,
+                                 translations, output, smem);
+  else if (k <= 512)
+    knn_merge_parts_impl<512, 8>(inK, inV, n_samples, n_parts, k, stream,
+                                 translations, output, smem);
+  else if (k <= 1024)
+    knn_merge_parts_impl<1024, 8>(inK, inV, n_samples, n_parts, k, stream,
+                                  translations, output, smem);
+}
+
 /**
  * @brief Merge knn distances and index matrix, which have been partitioned
  * by row, into a single matrix with only the k-nearest neighbors.
@@ -150,71 +213,655 @@ inline void knn_merge_parts_impl(float *inK, int64_t *inV, float *outK,
 inline void knn_merge_parts(float *inK, int64_t *inV, float *outK,
                             int64_t *outV, size_t n_samples, int n_parts, int k,
                             cudaStream_t stream, int64_t *translations) {
-  if (k == 1)
-    knn_merge_parts_impl<1, 1>(inK, inV, outK, outV, n_samples, n_parts, k,
-                               stream, translations);
-  else if (k <= 32)
-    knn_merge_parts_impl<32, 2>(inK, inV, outK, outV, n_samples, n_parts, k,
-                                stream, translations);
+  KnnMergeWriter writer = {outK, outV};
+  knn_merge_parts_output(inK, inV, n_samples, n_parts, k, stream,
+                         translations, writer);
+}
+
+/** Metrics of brute_force_knn */
+enum MetricType {
+  /** L2 distance */
+  METRIC_L2,
+  /** inner product; a similarity, the neighbors have the largest ones */
+  METRIC_INNER_PRODUCT,
+  /** cosine distance, 1 - cosine similarity */
+  METRIC_COSINE,
+  /** L1 distance */
+  METRIC_L1,
+  /** Minkowski distance, (sum |x_i - y_i|^p)^(1/p) */
+  METRIC_MINKOWSKI
+};
+
+/** Largest k searched by fused_knn */
+static const int FUSED_KNN_MAX_K = 1024;
+
+/**
+ * Largest k for which the L2 and inner product searches use fused_knn
+ * instead of the GEMM based faiss::gpu::bruteForceKnn; other metrics always
+ * use fused_knn
+ */
+static const int FUSED_KNN_GEMM_K = 32;
+
+/** Reads the features of a float index */
+struct KnnFloatLoader {
+  const float *data;
+  /** feature c of the index, at element i of data */
+  DI float operator()(size_t i, int c) const { return data[i]; }
+};
+
+/** Reads the features of an fp16 index */
+struct KnnHalfLoader {
+  const __half *data;
+  DI float operator()(size_t i, int c) const { return __half2float(data[i]); }
+};
+
+/** Reads the features of an int8 index, quantized per feature as
+    offset[c] + scale[c] * code */
+struct KnnInt8Loader {
+  const int8_t *data;
+  const float *scale;
+  const float *offset;
+  DI float operator()(size_t i, int c) const {
+    return offset[c] + scale[c] * data[i];
+  }
+};
+
+/**
+ * Each warp selects the k nearest index rows of one query. The index is
+ * streamed through shared memory in tiles of kWarpSize rows and features,
+ * shared by the kNumWarps queries of the block, and each lane accumulates
+ * the distance of one index row of the tile in registers, which goes
+ * straight to the warp queue. The distances are those of fused_knn.
+ */
+template <int warp_q, int thread_q, int tpb, typename Loader>
+__global__ void fused_knn_kernel(Loader index, size_t n_index,
+                                 bool rowMajorIndex, const float *query,
+                                 size_t n_query, bool rowMajorQuery, int D,
+                                 int k, MetricType metric, float p,
+                                 float initK, int64_t initV, float *outK,
+                                 int64_t *outV) {
+  constexpr int kTile = faiss::gpu::kWarpSize;
+  constexpr int kNumWarps = tpb / kTile;
+
+  __shared__ float sIndex[kTile][kTile + 1];
+  __shared__ float sQuery[kNumWarps][kTile];
+
+  faiss::gpu::WarpSelect<float, int64_t, false, faiss::gpu::Comparator<float>,
+                         warp_q, thread_q, tpb>
+    heap(initK, initV, k);
+
+  int lane = threadIdx.x % kTile;
+  int warp = threadIdx.x / kTile;
+  // Warps past the last query still help loading the tiles
+  size_t row = (size_t)blockIdx.x * kNumWarps + warp;
+
+  for (size_t start = 0; start < n_index; start += kTile) {
+    // acc is the sum over the features; the cosine also needs the norms
+    float acc = 0, index_norm = 0, query_norm = 0;
+    for (int d0 = 0; d0 < D; d0 += kTile) {
+      __syncthreads();
+      // Consecutive lanes load consecutive addresses in either layout
+      for (int r = warp; r < kTile; r += kNumWarps) {
+        size_t i = rowMajorIndex ? start + r : start + lane;
+        int c = rowMajorIndex ? d0 + lane : d0 + r;
+        float val = 0;
+        if (i < n_index && c < D)
+          val = rowMajorIndex ? index(i * D + c, c)
+                              : index(i + c * n_index, c);
+        if (rowMajorIndex)
+          sIndex[r][lane] = val;
+        else
+          sIndex[lane][r] = val;
+      }
+      int c = d0 + lane;
+      float q = 0;
+      if (row < n_query && c < D)
+        q = rowMajorQuery ? query[row * D + c] : query[row + c * n_query];
+      sQuery[warp][lane] = q;
+      __syncthreads();
+
+      // Padded features are 0 in both tiles, so they add 0 to every sum
+      switch (metric) {
+        case METRIC_L2:
+          for (int j = 0; j < kTile; j++) {
+            float diff = sQuery[warp][j] - sIndex[lane][j];
+            acc += diff * diff;
+          }
+          break;
+        case METRIC_INNER_PRODUCT:
+          for (int j = 0; j < kTile; j++)
+            acc += sQuery[warp][j] * sIndex[lane][j];
+          break;
+        case METRIC_COSINE:
+          for (int j = 0; j < kTile; j++) {
+            float x = sIndex[lane][j], y = sQuery[warp][j];
+            acc += x * y;
+            index_norm += x * x;
+            query_norm += y * y;
+          }
+          break;
+        case METRIC_L1:
+          for (int j = 0; j < kTile; j++)
+            acc += myAbs(sQuery[warp][j] - sIndex[lane][j]);
+          break;
+        case METRIC_MINKOWSKI:
+          for (int j = 0; j < kTile; j++)
+            acc += myPow(myAbs(sQuery[warp][j] - sIndex[lane][j]), p);
+          break;
+      }
+    }
+
+    float dist = acc;
+    if (metric == METRIC_INNER_PRODUCT) {
+      dist = -acc;
+    } else if (metric == METRIC_COSINE) {
+      float norms = mySqrt(index_norm * query_norm);
+      dist = norms > 0 ? 1 - acc / norms : 1;
+    }
+    // Padded index rows are never selected
+    size_t idx = start + lane;
+    heap.add(idx < n_index ? dist : initK, idx);
+  }
+
+  heap.reduce();
+  if (row < n_query) heap.writeOut(outK + row * k, outV + row * k, k);
+}
+
+template <int warp_q, int thread_q, typename Loader>
+inline void fused_knn_impl(Loader index, size_t n_index,
+                           bool rowMajorIndex, const float *query,
+                           size_t n_query, bool rowMajorQuery, int D, int k,
+                           MetricType metric, float p, float *outD,
+                           int64_t *outI, cudaStream_t stream) {
+  constexpr int tpb = 128;
+  constexpr int queries_per_block = tpb / faiss::gpu::kWarpSize;
+  auto kInit = faiss::gpu::Limits<float>::getMax();
+  auto vInit = -1;
+  fused_knn_kernel<warp_q, thread_q, tpb, Loader>
+    <<<ceildiv<size_t>(n_query, queries_per_block), tpb, 0, stream>>>(
+      index, n_index, rowMajorIndex, query, n_query, rowMajorQuery, D, k,
+      metric, p, kInit, vInit, outD, outI);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief fused_knn on an index read through the Loader, one of
+ * KnnFloatLoader, KnnHalfLoader or KnnInt8Loader; the distances are
+ * accumulated in fp32 whatever the storage of the index.
+ */
+template <typename Loader>
+void fused_knn_load(Loader index, size_t n_index, bool rowMajorIndex,
+                    const float *query, size_t n_query, bool rowMajorQuery,
+                    int D, int k, MetricType metric, float p, float *outD,
+                    int64_t *outI, cudaStream_t stream) {
+  ASSERT(k <= FUSED_KNN_MAX_K, "fused_knn: k=%d is larger than %d", k,
+         FUSED_KNN_MAX_K);
+  if (k <= 32)
+    fused_knn_impl<32, 2>(index, n_index, rowMajorIndex, query, n_query,
+                          rowMajorQuery, D, k, metric, p, outD, outI, stream);
   else if (k <= 64)
-    knn_merge_parts_impl<64, 3>(inK, inV, outK, outV, n_samples, n_parts, k,
-                                stream, translations);
+    fused_knn_impl<64, 3>(index, n_index, rowMajorIndex, query, n_query,
+                          rowMajorQuery, D, k, metric, p, outD, outI, stream);
   else if (k <= 128)
-    knn_merge_parts_impl<128, 3>(inK, inV, outK, outV, n_samples, n_parts, k,
-                                 stream, translations);
+    fused_knn_impl<128, 3>(index, n_index, rowMajorIndex, query, n_query,
+                           rowMajorQuery, D, k, metric, p, outD, outI, stream);
   else if (k <= 256)
-    knn_merge_parts_impl<256, 4>(inK, inV, outK, outV, n_samples, n_parts, k,
-                                 stream, translations);
+    fused_knn_impl<256, 4>(index, n_index, rowMajorIndex, query, n_query,
+                           rowMajorQuery, D, k, metric, p, outD, outI, stream);
   else if (k <= 512)
-    knn_merge_parts_impl<512, 8>(inK, inV, outK, outV, n_samples, n_parts, k,
-                                 stream, translations);
-  else if (k <= 1024)
-    knn_merge_parts_impl<1024, 8>(inK, inV, outK, outV, n_samples, n_parts, k,
-                                  stream, translations);
+    fused_knn_impl<512, 8>(index, n_index, rowMajorIndex, query, n_query,
+                           rowMajorQuery, D, k, metric, p, outD, outI, stream);
+  else
+    fused_knn_impl<1024, 8>(index, n_index, rowMajorIndex, query, n_query,
+                            rowMajorQuery, D, k, metric, p, outD, outI,
+                            stream);
 }
 
 /**
-   * Search the kNN for the k-nearest neighbors of a set of query vectors
-   * @param input vector of device device memory array pointers to search
-   * @param sizes vector of memory sizes for each device array pointer in input
-   * @param D number of cols in input and search_items
-   * @param search_items set of vectors to query for neighbors
-   * @param n        number of items in search_items
-   * @param res_I    pointer to device memory for returning k nearest indices
-   * @param res_D    pointer to device memory for returning k nearest distances
-   * @param k        number of neighbors to query
-   * @param allocator the device memory allocator to use for temporary scratch memory
-   * @param userStream the main cuda stream to use
-   * @param internalStreams optional when n_params > 0, the index partitions can be
-   *        queried in parallel using these streams. Note that n_int_streams also
-   *        has to be > 0 for these to be used and their cardinality does not need
-   *        to correspond to n_parts.
-   * @param n_int_streams size of internalStreams. When this is <= 0, only the
-   *        user stream will be used.
-   * @param rowMajorIndex are the index arrays in row-major layout?
-   * @param rowMajorQuery are the query array in row-major layout?
-   * @param translations translation ids for indices when index rows represent
-   *        non-contiguous partitions
-   */
-template <typename IntType = int,
-          Distance::DistanceType DistanceType = Distance::EucUnexpandedL2>
-void brute_force_knn(std::vector<float *> &input, std::vector<int> &sizes,
-                     IntType D, float *search_items, IntType n, int64_t *res_I,
-                     float *res_D, IntType k,
-                     std::shared_ptr<deviceAllocator> allocator,
-                     cudaStream_t userStream,
-                     cudaStream_t *internalStreams = nullptr,
-                     int n_int_streams = 0, bool rowMajorIndex = true,
-                     bool rowMajorQuery = true,
-                     std::vector<int64_t> *translations = nullptr) {
-  ASSERT(DistanceType == Distance::EucUnexpandedL2 ||
-           DistanceType == Distance::EucUnexpandedL2Sqrt,
-         "Only EucUnexpandedL2Sqrt and EucUnexpandedL2 metrics are supported "
-         "currently.");
+ * @brief Search the k nearest neighbors of the query rows in one index
+ * partition, computing the distances and selecting them in a single kernel
+ * so the distance matrix is never written to global memory.
+ *
+ * The output is in the format of faiss::gpu::bruteForceKnn: for each query,
+ * k distances in ascending order and the corresponding index rows, local to
+ * the partition. Like faiss, they are the squared distances for METRIC_L2;
+ * they are the negated inner products for METRIC_INNER_PRODUCT and the sums
+ * of |x_i - y_i|^p for METRIC_MINKOWSKI. knn_finalize_distances() maps them
+ * to the distances of the metric.
+ *
+ * @param index index partition, of n_index rows and D cols
+ * @param n_index number of rows in index
+ * @param rowMajorIndex is index in row-major layout?
+ * @param query query rows, of n_query rows and D cols
+ * @param n_query number of rows in query
+ * @param rowMajorQuery is query in row-major layout?
+ * @param D number of cols in index and query
+ * @param k number of neighbors to query, at most FUSED_KNN_MAX_K
+ * @param metric distance metric
+ * @param p exponent of METRIC_MINKOWSKI
+ * @param outD output distances (n_query x k, row-major)
+ * @param outI output index rows (n_query x k, row-major)
+ * @param stream CUDA stream to use
+ */
+inline void fused_knn(const float *index, size_t n_index, bool rowMajorIndex,
+                      const float *query, size_t n_query, bool rowMajorQuery,
+                      int D, int k, MetricType metric, float p, float *outD,
+                      int64_t *outI, cudaStream_t stream) {
+  KnnFloatLoader loader = {index};
+  fused_knn_load(loader, n_index, rowMajorIndex, query, n_query,
+                 rowMajorQuery, D, k, metric, p, outD, outI, stream);
+}
+
+/**
+ * @brief Map the merged outputs of fused_knn or faiss::gpu::bruteForceKnn
+ * to the distances of metric, in place.
+ * @param dists the n distances
+ * @param n number of distances
+ * @param metric distance metric
+ * @param p exponent of METRIC_MINKOWSKI
+ * @param stream CUDA stream to use
+ */
+inline void knn_finalize_distances(float *dists, size_t n, MetricType metric,
+                                   float p, cudaStream_t stream) {
+  switch (metric) {
+    case METRIC_L2:
+      MLCommon::LinAlg::unaryOp<float>(
+        dists, dists, n, [] __device__(float input) { return sqrt(input); },
+        stream);
+      break;
+    case METRIC_INNER_PRODUCT:
+      MLCommon::LinAlg::unaryOp<float>(
+        dists, dists, n, [] __device__(float input) { return -input; },
+        stream);
+      break;
+    case METRIC_MINKOWSKI: {
+      float inv_p = 1 / p;
+      MLCommon::LinAlg::unaryOp<float>(
+        dists, dists, n,
+        [inv_p] __device__(float input) { return myPow(input, inv_p); },
+        stream);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/** Storage of the features of a KnnQuantizedIndex */
+enum KnnStorage {
+  /** fp16, half the memory of fp32 */
+  KNN_STORAGE_FP16,
+  /** int8 scalar quantization per feature, a quarter of the memory of fp32 */
+  KNN_STORAGE_INT8
+};
+
+/**
+ * Index partition stored in reduced precision for fused_knn_load, in the
+ * layout of the fp32 partition it was built from.
+ */
+struct KnnQuantizedIndex {
+  KnnQuantizedIndex(std::shared_ptr<deviceAllocator> allocator,
+                    cudaStream_t stream)
+    : halves(allocator, stream, 0),
+      codes(allocator, stream, 0),
+      scale(allocator, stream, 0),
+      offset(allocator, stream, 0) {}
+
+  KnnStorage storage = KNN_STORAGE_FP16;
+  size_t n_rows = 0;
+  int D = 0;
+  bool rowMajor = true;
+  /** features of KNN_STORAGE_FP16 */
+  device_buffer<__half> halves;
+  /** features of KNN_STORAGE_INT8 */
+  device_buffer<int8_t> codes;
+  /** D scales and offsets of the features of KNN_STORAGE_INT8 */
+  device_buffer<float> scale;
+  device_buffer<float> offset;
+};
 
+/**
+ * One block per feature maps the range [min, max] of the feature to the 256
+ * codes of int8, with the code 0 at the middle of the range.
+ */
+template <int tpb>
+__global__ void knn_int8_range_kernel(const float *index, size_t n_index,
+                                      bool rowMajorIndex, int D, float *scale,
+                                      float *offset) {
+  typedef cub::BlockReduce<float, tpb> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+
+  int c = blockIdx.x;
+  float lo = faiss::gpu::Limits<float>::getMax();
+  float hi = -lo;
+  for (size_t i = threadIdx.x; i < n_index; i += tpb) {
+    float x = rowMajorIndex ? index[i * D + c] : index[i + c * n_index];
+    lo = myMin(lo, x);
+    hi = myMax(hi, x);
+  }
+  lo = BlockReduce(temp_storage).Reduce(lo, cub::Min());
+  __syncthreads();
+  hi = BlockReduce(temp_storage).Reduce(hi, cub::Max());
+  if (threadIdx.x == 0) {
+    float s = (hi - lo) / 255.f;
+    scale[c] = s;
+    offset[c] = lo + 128.f * s;
+  }
+}
+
+static __global__ void knn_int8_quantize_kernel(const float *index,
+                                                size_t n_index,
+                                                bool rowMajorIndex, int D,
+                                                const float *scale,
+                                                const float *offset,
+                                                int8_t *codes) {
+  size_t i = threadIdx.x + (size_t)blockIdx.x * blockDim.x;
+  if (i >= n_index * D) return;
+  int c = rowMajorIndex ? i % D : i / n_index;
+  float s = scale[c];
+  float code = s > 0 ? rintf((index[i] - offset[c]) / s) : 0.f;
+  codes[i] = (int8_t)myMax(-128.f, myMin(127.f, code));
+}
+
+/**
+ * @brief Build a reduced precision copy of an index partition, after which
+ * the fp32 partition need not stay on the device.
+ * @param qindex the index to build
+ * @param index index partition, of n_index rows and D cols
+ * @param n_index number of rows in index
+ * @param rowMajorIndex is index in row-major layout?
+ * @param D number of cols in index
+ * @param storage storage of the features
+ * @param stream CUDA stream to use
+ */
+inline void knn_quantized_build(KnnQuantizedIndex *qindex, const float *index,
+                                size_t n_index, bool rowMajorIndex, int D,
+                                KnnStorage storage, cudaStream_t stream) {
+  qindex->storage = storage;
+  qindex->n_rows = n_index;
+  qindex->D = D;
+  qindex->rowMajor = rowMajorIndex;
+  size_t len = n_index * D;
+  if (storage == KNN_STORAGE_FP16) {
+    qindex->halves.resize(len, stream);
+    qindex->codes.resize(0, stream);
+    MLCommon::LinAlg::unaryOp<float>(
+      qindex->halves.data(), index, len,
+      [] __device__(float input) { return __float2half(input); }, stream);
+    return;
+  }
+
+  constexpr int tpb = 256;
+  qindex->halves.resize(0, stream);
+  qindex->codes.resize(len, stream);
+  qindex->scale.resize(D, stream);
+  qindex->offset.resize(D, stream);
+  knn_int8_range_kernel<tpb><<<D, tpb, 0, stream>>>(
+    index, n_index, rowMajorIndex, D, qindex->scale.data(),
+    qindex->offset.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+  knn_int8_quantize_kernel<<<ceildiv<size_t>(len, tpb), tpb, 0, stream>>>(
+    index, n_index, rowMajorIndex, D, qindex->scale.data(),
+    qindex->offset.data(), qindex->codes.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/** Distance in the format of fused_knn of the points x and y, with strides
+    of x_stride and y_stride between their cols */
+DI float knn_exact_distance(const float *x, size_t x_stride, const float *y,
+                            size_t y_stride, int D, MetricType metric,
+                            float p) {
+  float acc = 0, x_norm = 0, y_norm = 0;
+  for (int c = 0; c < D; c++) {
+    float a = x[c * x_stride], b = y[c * y_stride];
+    switch (metric) {
+      case METRIC_L2:
+        acc += (a - b) * (a - b);
+        break;
+      case METRIC_INNER_PRODUCT:
+        acc += a * b;
+        break;
+      case METRIC_COSINE:
+        acc += a * b;
+        x_norm += a * a;
+        y_norm += b * b;
+        break;
+      case METRIC_L1:
+        acc += myAbs(a - b);
+        break;
+      case METRIC_MINKOWSKI:
+        acc += myPow(myAbs(a - b), p);
+        break;
+    }
+  }
+  if (metric == METRIC_INNER_PRODUCT) return -acc;
+  if (metric == METRIC_COSINE) {
+    float norms = mySqrt(x_norm * y_norm);
+    return norms > 0 ? 1 - acc / norms : 1;
+  }
+  return acc;
+}
+
+/**
+ * Each warp selects the k nearest of the n_cand candidates of one query by
+ * their exact distances, each lane computing the distance of one candidate.
+ */
+template <int warp_q, int thread_q, int tpb>
+__global__ void knn_rerank_kernel(const float *index, size_t n_index,
+                                  bool rowMajorIndex, const float *query,
+                                  size_t n_query, bool rowMajorQuery, int D,
+                                  const int64_t *candI, int n_cand, int k,
+                                  MetricType metric, float p, float initK,
+                                  int64_t initV, float *outK, int64_t *outV) {
+  constexpr int kNumWarps = tpb / faiss::gpu::kWarpSize;
+
+  faiss::gpu::WarpSelect<float, int64_t, false, faiss::gpu::Comparator<float>,
+                         warp_q, thread_q, tpb>
+    heap(initK, initV, k);
+
+  int lane = threadIdx.x % faiss::gpu::kWarpSize;
+  int warp = threadIdx.x / faiss::gpu::kWarpSize;
+  size_t row = (size_t)blockIdx.x * kNumWarps + warp;
+  // A warp exits as a whole, so the warp selection has all its lanes
+  if (row >= n_query) return;
+
+  const float *y = rowMajorQuery ? query + row * D : query + row;
+  size_t y_stride = rowMajorQuery ? 1 : n_query;
+  size_t x_stride = rowMajorIndex ? 1 : n_index;
+  for (int j0 = 0; j0 < n_cand; j0 += faiss::gpu::kWarpSize) {
+    int j = j0 + lane;
+    int64_t id = j < n_cand ? candI[row * n_cand + j] : initV;
+    float dist = initK;
+    if (id >= 0) {
+      const float *x = rowMajorIndex ? index + id * D : index + id;
+      dist = knn_exact_distance(x, x_stride, y, y_stride, D, metric, p);
+    }
+    heap.add(dist, id);
+  }
+
+  heap.reduce();
+  heap.writeOut(outK + row * k, outV + row * k, k);
+}
+
+template <int warp_q, int thread_q>
+inline void knn_rerank_impl(const float *index, size_t n_index,
+                            bool rowMajorIndex, const float *query,
+                            size_t n_query, bool rowMajorQuery, int D,
+                            const int64_t *candI, int n_cand, int k,
+                            MetricType metric, float p, float *outD,
+                            int64_t *outI, cudaStream_t stream) {
+  constexpr int tpb = 128;
+  constexpr int queries_per_block = tpb / faiss::gpu::kWarpSize;
+  auto kInit = faiss::gpu::Limits<float>::getMax();
+  auto vInit = -1;
+  knn_rerank_kernel<warp_q, thread_q, tpb>
+    <<<ceildiv<size_t>(n_query, queries_per_block), tpb, 0, stream>>>(
+      index, n_index, rowMajorIndex, query, n_query, rowMajorQuery, D, candI,
+      n_cand, k, metric, p, kInit, vInit, outD, outI);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Select the k nearest of n_cand candidate index rows of each query
+ * by their exact fp32 distances, in the output format of fused_knn.
+ * @param index fp32 index partition, of n_index rows and D cols; it need
+ *        only be readable from the device, e.g. mapped host memory
+ * @param n_index number of rows in index
+ * @param rowMajorIndex is index in row-major layout?
+ * @param query query rows, of n_query rows and D cols
+ * @param n_query number of rows in query
+ * @param rowMajorQuery is query in row-major layout?
+ * @param D number of cols in index and query
+ * @param candI candidate index rows (n_query x n_cand, row-major); those
+ *        which are negative are skipped
+ * @param n_cand number of candidates of each query, at least k
+ * @param k number of neighbors to query, at most FUSED_KNN_MAX_K
+ * @param metric distance metric
+ * @param p exponent of METRIC_MINKOWSKI
+ * @param outD output distances (n_query x k, row-major)
+ * @param outI output index rows (n_query x k, row-major)
+ * @param stream CUDA stream to use
+ */
+inline void knn_rerank(const float *index, size_t n_index, bool rowMajorIndex,
+                       const float *query, size_t n_query, bool rowMajorQuery,
+                       int D, const int64_t *candI, int n_cand, int k,
+                       MetricType metric, float p, float *outD, int64_t *outI,
+                       cudaStream_t stream) {
+  ASSERT(k <= FUSED_KNN_MAX_K, "knn_rerank: k=%d is larger than %d", k,
+         FUSED_KNN_MAX_K);
+  ASSERT(n_cand >= k, "knn_rerank: %d candidates for k=%d", n_cand, k);
+  if (k <= 32)
+    knn_rerank_impl<32, 2>(index, n_index, rowMajorIndex, query, n_query,
+                           rowMajorQuery, D, candI, n_cand, k, metric, p,
+                           outD, outI, stream);
+  else if (k <= 64)
+    knn_rerank_impl<64, 3>(index, n_index, rowMajorIndex, query, n_query,
+                           rowMajorQuery, D, candI, n_cand, k, metric, p,
+                           outD, outI, stream);
+  else if (k <= 128)
+    knn_rerank_impl<128, 3>(index, n_index, rowMajorIndex, query, n_query,
+                            rowMajorQuery, D, candI, n_cand, k, metric, p,
+                            outD, outI, stream);
+  else if (k <= 256)
+    knn_rerank_impl<256, 4>(index, n_index, rowMajorIndex, query, n_query,
+                            rowMajorQuery, D, candI, n_cand, k, metric, p,
+                            outD, outI, stream);
+  else if (k <= 512)
+    knn_rerank_impl<512, 8>(index, n_index, rowMajorIndex, query, n_query,
+                            rowMajorQuery, D, candI, n_cand, k, metric, p,
+                            outD, outI, stream);
+  else
+    knn_rerank_impl<1024, 8>(index, n_index, rowMajorIndex, query, n_query,
+                             rowMajorQuery, D, candI, n_cand, k, metric, p,
+                             outD, outI, stream);
+}
+
+/**
+ * @brief fused_knn on a reduced precision index partition. With an fp32
+ * copy of the partition, the n_cand nearest candidates by the reduced
+ * precision distances are re-ranked by their exact distances.
+ * @param qindex the reduced precision index partition
+ * @param query query rows, of n_query rows and D cols
+ * @param n_query number of rows in query
+ * @param rowMajorQuery is query in row-major layout?
+ * @param k number of neighbors to query, at most FUSED_KNN_MAX_K
+ * @param metric distance metric
+ * @param p exponent of METRIC_MINKOWSKI
+ * @param outD output distances (n_query x k, row-major)
+ * @param outI output index rows (n_query x k, row-major)
+ * @param allocator the device memory allocator of the candidates
+ * @param stream CUDA stream to use
+ * @param rerank_index optional fp32 partition qindex was built from, read
+ *        for the candidates only, so it may be mapped host memory
+ * @param n_cand number of candidates to re-rank; it is clamped to
+ *        [k, min(FUSED_KNN_MAX_K, number of rows)]
+ */
+inline void knn_quantized_search(
+  const KnnQuantizedIndex &qindex, const float *query, size_t n_query,
+  bool rowMajorQuery, int k, MetricType metric, float p, float *outD,
+  int64_t *outI, std::shared_ptr<deviceAllocator> allocator,
+  cudaStream_t stream, const float *rerank_index = nullptr, int n_cand = 0) {
+  n_cand = std::min<size_t>(std::min(n_cand, FUSED_KNN_MAX_K), qindex.n_rows);
+  bool rerank = rerank_index != nullptr && n_cand > k;
+  int n_search = rerank ? n_cand : k;
+  device_buffer<float> cand_D(allocator, stream, rerank ? n_query * n_cand : 0);
+  device_buffer<int64_t> cand_I(allocator, stream,
+                                rerank ? n_query * n_cand : 0);
+  float *search_D = rerank ? cand_D.data() : outD;
+  int64_t *search_I = rerank ? cand_I.data() : outI;
+
+  if (qindex.storage == KNN_STORAGE_FP16) {
+    KnnHalfLoader loader = {qindex.halves.data()};
+    fused_knn_load(loader, qindex.n_rows, qindex.rowMajor, query, n_query,
+                   rowMajorQuery, qindex.D, n_search, metric, p, search_D,
+                   search_I, stream);
+  } else {
+    KnnInt8Loader loader = {qindex.codes.data(), qindex.scale.data(),
+                            qindex.offset.data()};
+    fused_knn_load(loader, qindex.n_rows, qindex.rowMajor, query, n_query,
+                   rowMajorQuery, qindex.D, n_search, metric, p, search_D,
+                   search_I, stream);
+  }
+
+  if (rerank) {
+    knn_rerank(rerank_index, qindex.n_rows, qindex.rowMajor, query, n_query,
+               rowMajorQuery, qindex.D, cand_I.data(), n_cand, k, metric, p,
+               outD, outI, stream);
+  }
+}
+
+/**
+ * @brief Number of queries brute_force_knn searches at a time so that its
+ * temporaries fit in half of the free device memory, the other half being
+ * left to the distance tiles of FAISS. Each of max(1, n_int_streams)
+ * concurrent tiles holds the k partial results of the n_parts partitions,
+ * plus a copy of its queries if they are column major.
+ * @param n number of queries
+ * @param n_parts number of index partitions
+ * @param k number of neighbors to query
+ * @param D number of cols in the queries
+ * @param stage_query are the queries of each tile copied out?
+ * @param n_int_streams number of internal streams
+ */
+template <typename IntType>
+IntType knn_query_tile_rows(IntType n, size_t n_parts, IntType k, IntType D,
+                            bool stage_query, int n_int_streams) {
+  size_t free_mem, total_mem;
+  CUDA_CHECK(cudaMemGetInfo(&free_mem, &total_mem));
+  size_t budget = free_mem / 2;
+  size_t row_bytes = n_parts * k * (sizeof(float) + sizeof(int64_t));
+
+  // A single tile needs no query copy
+  if (row_bytes * n <= budget) return n;
+
+  if (stage_query) row_bytes += D * sizeof(float);
+  size_t rows = budget / (row_bytes * std::max(1, n_int_streams));
+  return (IntType)std::max<size_t>(1, std::min<size_t>(rows, n));
+}
+
+/**
+ * @brief Search of brute_force_knn, which hands the partial results of the
+ * partitions for each tile of queries to
+ * merge(tile_D, tile_I, start, rows, trans, stream), trans being the device
+ * translations of the partitions and stream the one to merge on.
+ */
+template <typename IntType, typename MergeFn>
+void brute_force_knn_tiles(std::vector<float *> &input,
+                           std::vector<int> &sizes, IntType D,
+                           float *search_items, IntType n, IntType k,
+                           std::shared_ptr<deviceAllocator> allocator,
+                           cudaStream_t userStream,
+                           cudaStream_t *internalStreams, int n_int_streams,
+                           bool rowMajorIndex, bool rowMajorQuery,
+                           std::vector<int64_t> *translations,
+                           MetricType metric, float p, IntType max_tile_rows,
+                           MergeFn merge) {
   ASSERT(input.size() == sizes.size(),
          "input and sizes vectors should be the same size");
 
+  ASSERT(metric != METRIC_MINKOWSKI || p > 0,
+         "The Minkowski exponent p must be positive");
+
   std::vector<int64_t> *id_ranges;
   if (translations == nullptr) {
     // If we don't have explicit translations
@@ -237,47 +884,199 @@ void brute_force_knn(std::vector<float *> &input, std::vector<int> &sizes,
   device_buffer<int64_t> trans(allocator, userStream, id_ranges->size());
   updateDevice(trans.data(), id_ranges->data(), id_ranges->size(), userStream);
 
-  device_buffer<float> all_D(allocator, userStream, input.size() * k * n);
-  device_buffer<int64_t> all_I(allocator, userStream, input.size() * k * n);
+  // The queries are searched in tiles of tile_rows, with the partial results
+  // of all the partitions for a tile merged before the next tile reuses
+  // them. Several tiles are searched at once on the internal streams, one
+  // set of partial results per stream. A single tile spreads its partitions
+  // over the internal streams instead.
+  size_t n_parts = input.size();
+  IntType tile_rows =
+    max_tile_rows > 0
+      ? std::min(n, max_tile_rows)
+      : knn_query_tile_rows<IntType>(n, n_parts, k, D, !rowMajorQuery,
+                                     n_int_streams);
+  IntType n_tiles = ceildiv(n, tile_rows);
+  int n_slots = n_tiles > 1 ? std::max(1, std::min<int>(n_int_streams, n_tiles))
+                            : 1;
+  size_t slot_size = n_parts * k * tile_rows;
+  bool stage_query = !rowMajorQuery && n_tiles > 1;
+
+  device_buffer<float> all_D(allocator, userStream, n_slots * slot_size);
+  device_buffer<int64_t> all_I(allocator, userStream, n_slots * slot_size);
+  size_t stage_size = stage_query ? (size_t)n_slots * tile_rows * D : 0;
+  device_buffer<float> query_stage(allocator, userStream, stage_size);
+
+  // Partitions with few dimensions and enough rows for the triangle
+  // inequality pruning to pay off are clustered once for all the tiles
+  std::vector<std::unique_ptr<SweetKnnIndex>> sweet(n_parts);
+  for (int i = 0; i < n_parts; i++) {
+    if (metric == METRIC_L2 && sweet_knn_pays_off(sizes[i], n, D, k)) {
+      sweet[i].reset(new SweetKnnIndex(allocator, userStream));
+      sweet_knn_build(sweet[i].get(), input[i], sizes[i], rowMajorIndex, D, 0,
+                      allocator, userStream);
+    }
+  }
 
   // Sync user stream only if using other streams to parallelize query
   if (n_int_streams > 0) CUDA_CHECK(cudaStreamSynchronize(userStream));
 
-  for (int i = 0; i < input.size(); i++) {
-    faiss::gpu::StandardGpuResources gpu_res;
+  // FAISS resources of each stream, created once per slot as a slot serves
+  // many tiles
+  std::vector<std::unique_ptr<faiss::gpu::StandardGpuResources>> gpu_res(
+    n_tiles > 1 ? n_slots : n_parts);
+
+  for (IntType t = 0; t < n_tiles; t++) {
+    IntType start = t * tile_rows;
+    IntType rows = std::min(tile_rows, n - start);
+    int slot = t % n_slots;
+    cudaStream_t tile_stream =
+      n_tiles > 1 ? select_stream(userStream, internalStreams, n_int_streams, t)
+                  : userStream;
+    float *tile_D = all_D.data() + slot * slot_size;
+    int64_t *tile_I = all_I.data() + slot * slot_size;
+
+    // A tile of column major queries is strided, so it is copied out
+    float *tile_items =
+      rowMajorQuery ? search_items + (size_t)start * D : search_items;
+    if (stage_query) {
+      tile_items = query_stage.data() + (size_t)slot * tile_rows * D;
+      CUDA_CHECK(cudaMemcpy2DAsync(
+        tile_items, rows * sizeof(float), search_items + start,
+        n * sizeof(float), rows * sizeof(float), D, cudaMemcpyDeviceToDevice,
+        tile_stream));
+    }
 
-    cudaStream_t stream =
-      select_stream(userStream, internalStreams, n_int_streams, i);
+    for (int i = 0; i < n_parts; i++) {
+      int res_idx = n_tiles > 1 ? slot : i;
+      cudaStream_t stream =
+        n_tiles > 1
+          ? tile_stream
+          : select_stream(userStream, internalStreams, n_int_streams, i);
+      float *part_D = tile_D + ((size_t)i * k * rows);
+      int64_t *part_I = tile_I + ((size_t)i * k * rows);
+
+      if (sweet[i] != nullptr) {
+        sweet_knn_search(*sweet[i], tile_items, rows, rowMajorQuery, k,
+                         part_D, part_I, stream);
+        continue;
+      }
 
-    gpu_res.noTempMemory();
-    gpu_res.setCudaMallocWarning(false);
-    gpu_res.setDefaultStream(device, stream);
+      // For small k, writing and reading back the distances of each query
+      // to the whole partition costs more than computing them
+      if (k <= FUSED_KNN_GEMM_K ||
+          (metric != METRIC_L2 && metric != METRIC_INNER_PRODUCT)) {
+        fused_knn(input[i], sizes[i], rowMajorIndex, tile_items, rows,
+                  rowMajorQuery, D, k, metric, p, part_D, part_I, stream);
+        continue;
+      }
 
-    faiss::gpu::bruteForceKnn(
-      &gpu_res, faiss::METRIC_L2, input[i], rowMajorIndex, sizes[i],
-      search_items, rowMajorQuery, n, D, k, all_D.data() + (i * k * n),
-      all_I.data() + (i * k * n));
+      if (gpu_res[res_idx] == nullptr) {
+        gpu_res[res_idx].reset(new faiss::gpu::StandardGpuResources());
+        gpu_res[res_idx]->noTempMemory();
+        gpu_res[res_idx]->setCudaMallocWarning(false);
+        gpu_res[res_idx]->setDefaultStream(device, stream);
+      }
 
-    CUDA_CHECK(cudaPeekAtLastError());
-  }
+      faiss::gpu::bruteForceKnn(
+        gpu_res[res_idx].get(),
+        metric == METRIC_L2 ? faiss::METRIC_L2 : faiss::METRIC_INNER_PRODUCT,
+        input[i], rowMajorIndex, sizes[i], tile_items, rowMajorQuery, rows, D,
+        k, part_D, part_I);
 
-  // Sync internal streams if used. We don't need to
-  // sync the user stream because we'll already have
-  // fully serial execution.
-  for (int i = 0; i < n_int_streams; i++) {
-    CUDA_CHECK(cudaStreamSynchronize(internalStreams[i]));
-  }
+      CUDA_CHECK(cudaPeekAtLastError());
 
-  knn_merge_parts(all_D.data(), all_I.data(), res_D, res_I, n, input.size(), k,
-                  userStream, trans.data());
+      // The merge keeps the smallest values, like for fused_knn
+      if (metric == METRIC_INNER_PRODUCT) {
+        MLCommon::LinAlg::unaryOp<float>(
+          part_D, part_D, (size_t)rows * k,
+          [] __device__(float input) { return -input; }, stream);
+      }
+    }
 
-  MLCommon::LinAlg::unaryOp<float>(
-    res_D, res_D, n * k, [] __device__(float input) { return sqrt(input); },
-    userStream);
+    // Sync internal streams if used by the partitions of a single tile.
+    // We don't need to sync the user stream because we'll already have
+    // fully serial execution.
+    if (n_tiles == 1) {
+      for (int i = 0; i < n_int_streams; i++) {
+        CUDA_CHECK(cudaStreamSynchronize(internalStreams[i]));
+      }
+    }
+
+    merge(tile_D, tile_I, start, rows, trans.data(), tile_stream);
+  }
+
+  // The tiles on the internal streams must be done before the partial
+  // results are released on the user stream
+  if (n_tiles > 1) {
+    for (int i = 0; i < n_int_streams; i++) {
+      CUDA_CHECK(cudaStreamSynchronize(internalStreams[i]));
+    }
+  }
 
   if (translations == nullptr) delete id_ranges;
 };
 
+/**
+   * Search the kNN for the k-nearest neighbors of a set of query vectors
+   * @param input vector of device device memory array pointers to search
+   * @param sizes vector of memory sizes for each device array pointer in input
+   * @param D number of cols in input and search_items
+   * @param search_items set of vectors to query for neighbors
+   * @param n        number of items in search_items
+   * @param res_I    pointer to device memory for returning k nearest indices
+   * @param res_D    pointer to device memory for returning k nearest distances
+   * @param k        number of neighbors to query
+   * @param allocator the device memory allocator to use for temporary scratch memory
+   * @param userStream the main cuda stream to use
+   * @param internalStreams optional when n_params > 0, the index partitions can be
+   *        queried in parallel using these streams. Note that n_int_streams also
+   *        has to be > 0 for these to be used and their cardinality does not need
+   *        to correspond to n_parts.
+   * @param n_int_streams size of internalStreams. When this is <= 0, only the
+   *        user stream will be used.
+   * @param rowMajorIndex are the index arrays in row-major layout?
+   * @param rowMajorQuery are the query array in row-major layout?
+   * @param translations translation ids for indices when index rows represent
+   *        non-contiguous partitions
+   * @param metric distance metric; res_D holds the inner products, largest
+   *        first, for METRIC_INNER_PRODUCT
+   * @param p exponent of METRIC_MINKOWSKI
+   * @param max_tile_rows maximum number of queries searched at a time. When
+   *        this is <= 0, it is sized from the free device memory.
+   */
+template <typename IntType = int,
+          Distance::DistanceType DistanceType = Distance::EucUnexpandedL2>
+void brute_force_knn(std::vector<float *> &input, std::vector<int> &sizes,
+                     IntType D, float *search_items, IntType n, int64_t *res_I,
+                     float *res_D, IntType k,
+                     std::shared_ptr<deviceAllocator> allocator,
+                     cudaStream_t userStream,
+                     cudaStream_t *internalStreams = nullptr,
+                     int n_int_streams = 0, bool rowMajorIndex = true,
+                     bool rowMajorQuery = true,
+                     std::vector<int64_t> *translations = nullptr,
+                     MetricType metric = METRIC_L2, float p = 2.0f,
+                     IntType max_tile_rows = 0) {
+  ASSERT(DistanceType == Distance::EucUnexpandedL2 ||
+           DistanceType == Distance::EucUnexpandedL2Sqrt,
+         "Only EucUnexpandedL2Sqrt and EucUnexpandedL2 metrics are supported "
+         "currently.");
+
+  int n_parts = input.size();
+  brute_force_knn_tiles(
+    input, sizes, D, search_items, n, k, allocator, userStream,
+    internalStreams, n_int_streams, rowMajorIndex, rowMajorQuery,
+    translations, metric, p, max_tile_rows,
+    [&](float *tile_D, int64_t *tile_I, IntType start, IntType rows,
+        int64_t *trans, cudaStream_t stream) {
+      knn_merge_parts(tile_D, tile_I, res_D + (size_t)start * k,
+                      res_I + (size_t)start * k, rows, n_parts, k, stream,
+                      trans);
+      knn_finalize_distances(res_D + (size_t)start * k, (size_t)rows * k,
+                             metric, p, stream);
+    });
+}
+
 template <typename IntType = int,
           Distance::DistanceType DistanceType = Distance::EucUnexpandedL2>
 void brute_force_knn(float **input, int *sizes, int n_params, IntType D,
@@ -288,7 +1087,9 @@ void brute_force_knn(float **input, int *sizes, int n_params, IntType D,
                      cudaStream_t *internalStreams = nullptr,
                      int n_int_streams = 0, bool rowMajorIndex = true,
                      bool rowMajorQuery = true,
-                     std::vector<int64_t> *translations = nullptr) {
+                     std::vector<int64_t> *translations = nullptr,
+                     MetricType metric = METRIC_L2, float p = 2.0f,
+                     IntType max_tile_rows = 0) {
   std::vector<float *> input_vec(n_params);
   std::vector<int> sizes_vec(n_params);
 
@@ -300,7 +1101,7 @@ void brute_force_knn(float **input, int *sizes, int n_params, IntType D,
   brute_force_knn<IntType, DistanceType>(
     input_vec, sizes_vec, D, search_items, n, res_I, res_D, k, allocator,
     userStream, internalStreams, n_int_streams, rowMajorIndex, rowMajorQuery,
-    translations);
+    translations, metric, p, max_tile_rows);
 }
 
 /**
@@ -602,5 +1403,197 @@ void knn_regress(ValType *out, const int64_t *knn_indices,
   }
 }
 
+/**
+ * Output of knn_merge_parts_output voting the labels of the merged
+ * neighbors of each row: their frequencies in proba and the most frequent
+ * one in out, either of which may be null. The votes are counted in
+ * n_uniq_labels floats of dynamic shared memory.
+ */
+struct KnnClassVote {
+  int *out;
+  int n_outputs;
+  int output_offset;
+  float *proba;
+  const int *labels;
+  int *unique_labels;
+  int n_uniq_labels;
+
+  DI void operator()(int row, const float *smemK, const int64_t *smemV,
+                     int k) const {
+    extern __shared__ float knn_vote_counts[];
+    for (int j = threadIdx.x; j < n_uniq_labels; j += blockDim.x)
+      knn_vote_counts[j] = 0;
+    __syncthreads();
+    for (int i = threadIdx.x; i < k; i += blockDim.x) {
+      // Rows with fewer than k index rows have missing neighbors
+      if (smemV[i] < 0) continue;
+      int idx =
+        label_binary_search(unique_labels, n_uniq_labels, labels[smemV[i]]);
+      atomicAdd(knn_vote_counts + idx, 1.0f);
+    }
+    __syncthreads();
+
+    if (proba != nullptr) {
+      float n_neigh_inv = 1.0f / k;
+      for (int j = threadIdx.x; j < n_uniq_labels; j += blockDim.x)
+        proba[(size_t)row * n_uniq_labels + j] =
+          knn_vote_counts[j] * n_neigh_inv;
+    }
+    if (out != nullptr && threadIdx.x == 0) {
+      // Ties go to the smallest label, like knn_classify
+      int cur_label = 0;
+      for (int j = 1; j < n_uniq_labels; j++) {
+        if (knn_vote_counts[j] > knn_vote_counts[cur_label]) cur_label = j;
+      }
+      out[(size_t)row * n_outputs + output_offset] = unique_labels[cur_label];
+    }
+  }
+};
+
+/**
+ * Output of knn_merge_parts_output averaging the labels of the merged
+ * neighbors of each row.
+ */
+template <typename ValType>
+struct KnnRegressAvg {
+  ValType *out;
+  int n_outputs;
+  int output_offset;
+  const ValType *labels;
+
+  DI void operator()(int row, const float *smemK, const int64_t *smemV,
+                     int k) const {
+    if (threadIdx.x != 0) return;
+    ValType pred = 0;
+    for (int i = 0; i < k; i++) {
+      if (smemV[i] >= 0) pred += labels[smemV[i]];
+    }
+    out[(size_t)row * n_outputs + output_offset] = pred / (ValType)k;
+  }
+};
+
+/** Static shared memory of the knn_merge_parts_kernel of k neighbors */
+inline size_t knn_merge_parts_smem(int k) {
+  int warp_q = k == 1 ? 1 : 32;
+  while (warp_q < k) warp_q *= 2;
+  return (128 / faiss::gpu::kWarpSize) * warp_q *
+         (sizeof(float) + sizeof(int64_t));
+}
+
+/**
+ * @brief brute_force_knn followed by knn_classify and class_probs, with the
+ * labels voted inside the merge of the partial results, so the n x k
+ * neighbors are never written out.
+ *
+ * @param input vector of device memory array pointers to search
+ * @param sizes vector of memory sizes for each device array pointer in input
+ * @param D number of cols in input and search_items
+ * @param search_items set of vectors to query for neighbors
+ * @param n number of items in search_items
+ * @param k number of neighbors to query, at most 512
+ * @param out optional output labels of size (n * y.size())
+ * @param proba optional vector of output class probabilities, of size
+ *        (n * n_unique[i]) for y[i]
+ * @param y vector of label arrays of the index rows, in the order of the
+ *        partitions
+ * @param uniq_labels vector of the sorted unique labels for each array in y
+ * @param n_unique vector of sizes for each array in uniq_labels
+ * @param allocator the device memory allocator of the partial results
+ * @param userStream the main cuda stream to use
+ * @param internalStreams optional internal streams, as for brute_force_knn
+ * @param n_int_streams size of internalStreams
+ * @param rowMajorIndex are the index arrays in row-major layout?
+ * @param rowMajorQuery are the query array in row-major layout?
+ * @param metric distance metric
+ * @param p exponent of METRIC_MINKOWSKI
+ */
+template <typename IntType = int>
+void brute_force_knn_classify(
+  std::vector<float *> &input, std::vector<int> &sizes, IntType D,
+  float *search_items, IntType n, IntType k, int *out,
+  std::vector<float *> *proba, std::vector<int *> &y,
+  std::vector<int *> &uniq_labels, std::vector<int> &n_unique,
+  std::shared_ptr<deviceAllocator> allocator, cudaStream_t userStream,
+  cudaStream_t *internalStreams = nullptr, int n_int_streams = 0,
+  bool rowMajorIndex = true, bool rowMajorQuery = true,
+  MetricType metric = METRIC_L2, float p = 2.0f) {
+  for (int i = 0; i < y.size(); i++) {
+    ASSERT(knn_merge_parts_smem(k) + n_unique[i] * sizeof(float) <=
+             48 * 1024,
+           "brute_force_knn_classify: too many labels (%d) for k=%d",
+           n_unique[i], k);
+  }
+
+  int n_parts = input.size();
+  int n_outputs = y.size();
+  brute_force_knn_tiles(
+    input, sizes, D, search_items, n, k, allocator, userStream,
+    internalStreams, n_int_streams, rowMajorIndex, rowMajorQuery, nullptr,
+    metric, p, (IntType)0,
+    [&](float *tile_D, int64_t *tile_I, IntType start, IntType rows,
+        int64_t *trans, cudaStream_t stream) {
+      int *tile_out =
+        out != nullptr ? out + (size_t)start * n_outputs : nullptr;
+      for (int i = 0; i < n_outputs; i++) {
+        float *tile_proba =
+          proba != nullptr ? (*proba)[i] + (size_t)start * n_unique[i]
+                           : nullptr;
+        KnnClassVote vote = {tile_out, n_outputs, i, tile_proba,
+                             y[i], uniq_labels[i], n_unique[i]};
+        knn_merge_parts_output(tile_D, tile_I, rows, n_parts, k, stream,
+                               trans, vote, n_unique[i] * sizeof(float));
+      }
+    });
+}
+
+/**
+ * @brief brute_force_knn followed by knn_regress, with the labels averaged
+ * inside the merge of the partial results, so the n x k neighbors are never
+ * written out.
+ *
+ * @tparam ValType data type of the labels
+ * @param input vector of device memory array pointers to search
+ * @param sizes vector of memory sizes for each device array pointer in input
+ * @param D number of cols in input and search_items
+ * @param search_items set of vectors to query for neighbors
+ * @param n number of items in search_items
+ * @param k number of neighbors to query
+ * @param out output array of size (n * y.size())
+ * @param y vector of label arrays of the index rows, in the order of the
+ *        partitions
+ * @param allocator the device memory allocator of the partial results
+ * @param userStream the main cuda stream to use
+ * @param internalStreams optional internal streams, as for brute_force_knn
+ * @param n_int_streams size of internalStreams
+ * @param rowMajorIndex are the index arrays in row-major layout?
+ * @param rowMajorQuery are the query array in row-major layout?
+ * @param metric distance metric
+ * @param p exponent of METRIC_MINKOWSKI
+ */
+template <typename ValType, typename IntType = int>
+void brute_force_knn_regress(
+  std::vector<float *> &input, std::vector<int> &sizes, IntType D,
+  float *search_items, IntType n, IntType k, ValType *out,
+  const std::vector<ValType *> &y, std::shared_ptr<deviceAllocator> allocator,
+  cudaStream_t userStream, cudaStream_t *internalStreams = nullptr,
+  int n_int_streams = 0, bool rowMajorIndex = true, bool rowMajorQuery = true,
+  MetricType metric = METRIC_L2, float p = 2.0f) {
+  int n_parts = input.size();
+  int n_outputs = y.size();
+  brute_force_knn_tiles(
+    input, sizes, D, search_items, n, k, allocator, userStream,
+    internalStreams, n_int_streams, rowMajorIndex, rowMajorQuery, nullptr,
+    metric, p, (IntType)0,
+    [&](float *tile_D, int64_t *tile_I, IntType start, IntType rows,
+        int64_t *trans, cudaStream_t stream) {
+      for (int i = 0; i < n_outputs; i++) {
+        KnnRegressAvg<ValType> avg = {out + (size_t)start * n_outputs,
+                                      n_outputs, i, y[i]};
+        knn_merge_parts_output(tile_D, tile_I, rows, n_parts, k, stream,
+                               trans, avg);
+      }
+    });
+}
+
 };  // namespace Selection
 };  // namespace MLCommon
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cuda_utils.h"
+
+#include "distance/distance.h"
+#include "knn.h"
+#include "sparse/coo.h"
+
+#include <faiss/gpu/utils/Limits.cuh>
+#include <faiss/gpu/utils/Select.cuh>
+
+#include <thrust/device_ptr.h>
+#include <thrust/execution_policy.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <cuml/common/cuml_allocator.hpp>
+#include "common/device_buffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace MLCommon {
+namespace Selection {
+
+/** Largest tile of rows of the self-join, whose distances take 256MB */
+static const int KNN_GRAPH_MAX_TILE = 8192;
+
+/**
+ * @brief Rows of the square tiles of the self-join of n rows, so that the
+ * distances of a tile fit in half of the free device memory.
+ */
+inline int knn_graph_tile_rows(int n) {
+  size_t free_mem, total_mem;
+  CUDA_CHECK(cudaMemGetInfo(&free_mem, &total_mem));
+  size_t rows = std::sqrt((double)(free_mem / 2 / sizeof(float)));
+  rows = std::min<size_t>(rows, KNN_GRAPH_MAX_TILE);
+  return (int)std::max<size_t>(1, std::min<size_t>(rows, n));
+}
+
+/**
+ * Each warp selects the k nearest of the n_cols distances of one row of a
+ * tile of distances, the distance of (row, col) being at
+ * row * row_stride + col * col_stride, so the same kernel selects along the
+ * rows or the cols of a tile. The first tile col is col_offset; with
+ * exclude_diag, (row, row) is skipped.
+ */
+template <int warp_q, int thread_q, int tpb>
+__global__ void knn_graph_select_kernel(const float *dists, int n_rows,
+                                        int n_cols, size_t row_stride,
+                                        size_t col_stride, int k,
+                                        int64_t col_offset, bool exclude_diag,
+                                        float initK, int64_t initV,
+                                        float *outK, int64_t *outV) {
+  constexpr int kNumWarps = tpb / faiss::gpu::kWarpSize;
+
+  faiss::gpu::WarpSelect<float, int64_t, false, faiss::gpu::Comparator<float>,
+                         warp_q, thread_q, tpb>
+    heap(initK, initV, k);
+
+  int lane = threadIdx.x % faiss::gpu::kWarpSize;
+  int warp = threadIdx.x / faiss::gpu::kWarpSize;
+  int row = blockIdx.x * kNumWarps + warp;
+  // A warp exits as a whole, so the warp selection has all its lanes
+  if (row >= n_rows) return;
+
+  for (int c0 = 0; c0 < n_cols; c0 += faiss::gpu::kWarpSize) {
+    int col = c0 + lane;
+    float dist = initK;
+    int64_t id = initV;
+    if (col < n_cols && !(exclude_diag && col == row)) {
+      // The expanded L2 distances can be slightly negative
+      dist = myMax(0.f, dists[row * row_stride + col * col_stride]);
+      id = col_offset + col;
+    }
+    heap.add(dist, id);
+  }
+
+  heap.reduce();
+  heap.writeOut(outK + (size_t)row * k, outV + (size_t)row * k, k);
+}
+
+template <int warp_q, int thread_q>
+inline void knn_graph_select_impl(const float *dists, int n_rows, int n_cols,
+                                  size_t row_stride, size_t col_stride, int k,
+                                  int64_t col_offset, bool exclude_diag,
+                                  float *outK, int64_t *outV,
+                                  cudaStream_t stream) {
+  constexpr int tpb = 128;
+  constexpr int rows_per_block = tpb / faiss::gpu::kWarpSize;
+  auto kInit = faiss::gpu::Limits<float>::getMax();
+  auto vInit = -1;
+  knn_graph_select_kernel<warp_q, thread_q, tpb>
+    <<<ceildiv(n_rows, rows_per_block), tpb, 0, stream>>>(
+      dists, n_rows, n_cols, row_stride, col_stride, k, col_offset,
+      exclude_diag, kInit, vInit, outK, outV);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+inline void knn_graph_select(const float *dists, int n_rows, int n_cols,
+                             size_t row_stride, size_t col_stride, int k,
+                             int64_t col_offset, bool exclude_diag,
+                             float *outK, int64_t *outV, cudaStream_t stream) {
+  if (k <= 32)
+    knn_graph_select_impl<32, 2>(dists, n_rows, n_cols, row_stride,
+                                 col_stride, k, col_offset, exclude_diag, outK,
+                                 outV, stream);
+  else if (k <= 64)
+    knn_graph_select_impl<64, 3>(dists, n_rows, n_cols, row_stride,
+                                 col_stride, k, col_offset, exclude_diag, outK,
+                                 outV, stream);
+  else if (k <= 128)
+    knn_graph_select_impl<128, 3>(dists, n_rows, n_cols, row_stride,
+                                  col_stride, k, col_offset, exclude_diag,
+                                  outK, outV, stream);
+  else if (k <= 256)
+    knn_graph_select_impl<256, 4>(dists, n_rows, n_cols, row_stride,
+                                  col_stride, k, col_offset, exclude_diag,
+                                  outK, outV, stream);
+  else if (k <= 512)
+    knn_graph_select_impl<512, 8>(dists, n_rows, n_cols, row_stride,
+                                  col_stride, k, col_offset, exclude_diag,
+                                  outK, outV, stream);
+  else
+    knn_graph_select_impl<1024, 8>(dists, n_rows, n_cols, row_stride,
+                                   col_stride, k, col_offset, exclude_diag,
+                                   outK, outV, stream);
+}
+
+/**
+ * @brief k nearest neighbors of every row of X among the rows of X. The
+ * distance matrix is computed in square tiles of its upper triangle only,
+ * each tile giving candidates both to its rows and, transposed, to its cols,
+ * which are merged into the neighbors found so far.
+ *
+ * @param X the rows (n x D, row-major)
+ * @param n number of rows in X
+ * @param D number of cols in X
+ * @param k number of neighbors of each row, at most FUSED_KNN_MAX_K
+ * @param include_self is each row its own nearest neighbor?
+ * @param res_I output neighbors (n x k, row-major)
+ * @param res_D output L2 distances (n x k, row-major)
+ * @param allocator the device memory allocator of the temporaries
+ * @param stream CUDA stream to use
+ * @param tile_rows rows of the tiles; when this is <= 0, it is sized from
+ *        the free device memory
+ */
+inline void knn_graph_self_join(const float *X, int n, int D, int k,
+                                bool include_self, int64_t *res_I,
+                                float *res_D,
+                                std::shared_ptr<deviceAllocator> allocator,
+                                cudaStream_t stream, int tile_rows = 0) {
+  ASSERT(k <= FUSED_KNN_MAX_K, "knn_graph_self_join: k=%d is larger than %d",
+         k, FUSED_KNN_MAX_K);
+  ASSERT(k <= (include_self ? n : n - 1),
+         "knn_graph_self_join: %d rows have fewer than k=%d neighbors", n, k);
+  typedef cutlass::Shape<8, 128, 128> OutputTile_t;
+
+  if (tile_rows <= 0) tile_rows = knn_graph_tile_rows(n);
+  tile_rows = std::min(tile_rows, n);
+  int n_tiles = ceildiv(n, tile_rows);
+
+  device_buffer<float> tile_dists(allocator, stream,
+                                  (size_t)tile_rows * tile_rows);
+  size_t worksize =
+    Distance::getWorkspaceSize<Distance::EucExpandedL2, float, float, float>(
+      X, X + 1, tile_rows, tile_rows, D);
+  device_buffer<char> workspace(allocator, stream, worksize);
+  // The neighbors found so far of a tile of rows, then its new candidates
+  device_buffer<float> merge_D(allocator, stream, 2 * (size_t)tile_rows * k);
+  device_buffer<int64_t> merge_I(allocator, stream,
+                                 2 * (size_t)tile_rows * k);
+  // The candidate ids are global already
+  device_buffer<int64_t> no_translations(allocator, stream, 2);
+  CUDA_CHECK(cudaMemsetAsync(no_translations.data(), 0, 2 * sizeof(int64_t),
+                             stream));
+
+  // Merges the candidates in the second half of merge_D and merge_I into
+  // the neighbors of the rows r0 to r0 + rows
+  auto merge = [&](int r0, int rows) {
+    size_t len = (size_t)rows * k;
+    copyAsync(merge_D.data(), res_D + (size_t)r0 * k, len, stream);
+    copyAsync(merge_I.data(), res_I + (size_t)r0 * k, len, stream);
+    knn_merge_parts(merge_D.data(), merge_I.data(), res_D + (size_t)r0 * k,
+                    res_I + (size_t)r0 * k, rows, 2, k, stream,
+                    no_translations.data());
+  };
+
+  // The rows of a tile get candidates from the tiles before it, then from
+  // the diagonal tile and from the tiles after it
+  thrust::fill_n(thrust::cuda::par.on(stream),
+                 thrust::device_pointer_cast(res_D), (size_t)n * k,
+                 faiss::gpu::Limits<float>::getMax());
+  thrust::fill_n(thrust::cuda::par.on(stream),
+                 thrust::device_pointer_cast(res_I), (size_t)n * k,
+                 (int64_t)-1);
+
+  for (int s = 0; s < n_tiles; s++) {
+    int s0 = s * tile_rows;
+    int s_rows = std::min(tile_rows, n - s0);
+    for (int t = s; t < n_tiles; t++) {
+      int t0 = t * tile_rows;
+      int t_rows = std::min(tile_rows, n - t0);
+      const float *x = X + (size_t)s0 * D;
+      const float *y = X + (size_t)t0 * D;
+      // With x == y, the distance prim computes the norms only once
+      Distance::distance<Distance::EucExpandedL2, float, float, float,
+                         OutputTile_t>(x, s == t ? x : y, tile_dists.data(),
+                                       s_rows, t_rows, D,
+                                       (void *)workspace.data(), worksize,
+                                       stream);
+
+      float *cand_D = merge_D.data() + (size_t)s_rows * k;
+      int64_t *cand_I = merge_I.data() + (size_t)s_rows * k;
+      knn_graph_select(tile_dists.data(), s_rows, t_rows, t_rows, 1, k, t0,
+                       s == t && !include_self, cand_D, cand_I, stream);
+      merge(s0, s_rows);
+      if (t == s) continue;
+
+      // The transposed tile gives the rows of t their candidates among the
+      // rows of s
+      cand_D = merge_D.data() + (size_t)t_rows * k;
+      cand_I = merge_I.data() + (size_t)t_rows * k;
+      knn_graph_select(tile_dists.data(), t_rows, s_rows, 1, t_rows, k, s0,
+                       false, cand_D, cand_I, stream);
+      merge(t0, t_rows);
+    }
+  }
+
+  knn_finalize_distances(res_D, (size_t)n * k, METRIC_L2, 2.0f, stream);
+}
+
+/**
+ * @brief knn_graph_self_join emitting the graph as a COO of n * k edges from
+ * each row to its neighbors, weighted by their L2 distances.
+ *
+ * @param X the rows (n x D, row-major)
+ * @param n number of rows in X
+ * @param D number of cols in X
+ * @param k number of neighbors of each row, at most FUSED_KNN_MAX_K
+ * @param include_self is each row its own nearest neighbor?
+ * @param out the output graph
+ * @param allocator the device memory allocator of the temporaries
+ * @param stream CUDA stream to use
+ */
+inline void knn_graph_self_join(const float *X, int n, int D, int k,
+                                bool include_self, Sparse::COO<float> *out,
+                                std::shared_ptr<deviceAllocator> allocator,
+                                cudaStream_t stream) {
+  size_t nnz = (size_t)n * k;
+  device_buffer<int64_t> knn_I(allocator, stream, nnz);
+  out->allocate(nnz, n, false, stream);
+  knn_graph_self_join(X, n, D, k, include_self, knn_I.data(), out->vals(),
+                      allocator, stream);
+
+  int *rows = out->rows();
+  int *cols = out->cols();
+  const int64_t *ids = knn_I.data();
+  thrust::for_each(thrust::cuda::par.on(stream),
+                   thrust::make_counting_iterator<size_t>(0),
+                   thrust::make_counting_iterator<size_t>(nnz),
+                   [=] __device__(size_t i) {
+                     rows[i] = i / k;
+                     cols[i] = ids[i];
+                   });
+}
+
+};  // namespace Selection
+};  // namespace MLCommon
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cuda_utils.h"
+
+#include <thrust/device_ptr.h>
+#include <thrust/execution_policy.h>
+#include <thrust/scan.h>
+
+#include "sparse/csr.h"
+
+namespace MLCommon {
+namespace Selection {
+
+/**
+ * Each warp finds the index rows within eps of one query. The index is
+ * streamed through shared memory in tiles of WarpSize rows and features,
+ * shared by the queries of the block, and each lane computes the distance of
+ * one index row of the tile. Without col_ind, the number of neighbors of
+ * each query is written to row_ind; otherwise the neighbors are written from
+ * row_ind, in ascending order of index row, with their distances in vals
+ * unless it is null.
+ */
+template <typename T, typename Index_, int tpb>
+__global__ void radius_neighbors_kernel(const T *index, Index_ n_index,
+                                        bool rowMajorIndex, const T *query,
+                                        Index_ n_query, bool rowMajorQuery,
+                                        Index_ D, T eps2, Index_ *row_ind,
+                                        Index_ *col_ind, T *vals) {
+  constexpr int kNumWarps = tpb / WarpSize;
+
+  __shared__ T sIndex[WarpSize][WarpSize + 1];
+  __shared__ T sQuery[kNumWarps][WarpSize];
+
+  int lane = threadIdx.x % WarpSize;
+  int warp = threadIdx.x / WarpSize;
+  // Warps past the last query still help loading the tiles
+  Index_ row = (Index_)blockIdx.x * kNumWarps + warp;
+  Index_ pos = col_ind != nullptr && row < n_query ? row_ind[row] : 0;
+
+  for (Index_ start = 0; start < n_index; start += WarpSize) {
+    T acc = 0;
+    for (Index_ d0 = 0; d0 < D; d0 += WarpSize) {
+      __syncthreads();
+      // Consecutive lanes load consecutive addresses in either layout
+      for (int r = warp; r < WarpSize; r += kNumWarps) {
+        Index_ i = rowMajorIndex ? start + r : start + lane;
+        Index_ c = rowMajorIndex ? d0 + lane : d0 + r;
+        T val = 0;
+        if (i < n_index && c < D)
+          val = rowMajorIndex ? index[(size_t)i * D + c]
+                              : index[i + (size_t)c * n_index];
+        if (rowMajorIndex)
+          sIndex[r][lane] = val;
+        else
+          sIndex[lane][r] = val;
+      }
+      Index_ c = d0 + lane;
+      T q = 0;
+      if (row < n_query && c < D)
+        q = rowMajorQuery ? query[(size_t)row * D + c]
+                          : query[row + (size_t)c * n_query];
+      sQuery[warp][lane] = q;
+      __syncthreads();
+
+      // Padded features are 0 in both tiles, so they add 0 to the sum
+      for (int j = 0; j < WarpSize; j++) {
+        T diff = sQuery[warp][j] - sIndex[lane][j];
+        acc += diff * diff;
+      }
+    }
+
+    Index_ idx = start + lane;
+    unsigned mask = __ballot_sync(0xffffffff, idx < n_index && acc <= eps2);
+    if (col_ind != nullptr && row < n_query && (mask >> lane) & 1) {
+      Index_ out = pos + __popc(mask & ((1u << lane) - 1));
+      col_ind[out] = idx;
+      if (vals != nullptr) vals[out] = mySqrt(acc);
+    }
+    pos += __popc(mask);
+  }
+
+  if (col_ind == nullptr && row < n_query && lane == 0) row_ind[row] = pos;
+}
+
+template <int tpb, typename T, typename Index_>
+void radius_neighbors_launch(const T *index, Index_ n_index,
+                             bool rowMajorIndex, const T *query,
+                             Index_ n_query, bool rowMajorQuery, Index_ D,
+                             T eps, Index_ *row_ind, Index_ *col_ind, T *vals,
+                             cudaStream_t stream) {
+  constexpr int queries_per_block = tpb / WarpSize;
+  radius_neighbors_kernel<T, Index_, tpb>
+    <<<ceildiv<Index_>(n_query, queries_per_block), tpb, 0, stream>>>(
+      index, n_index, rowMajorIndex, query, n_query, rowMajorQuery, D,
+      eps * eps, row_ind, col_ind, vals);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief First pass of the radius neighbors graph: the CSR row offsets of
+ * the index rows within L2 distance eps of each query.
+ * @param index index rows, of n_index rows and D cols
+ * @param n_index number of rows in index
+ * @param rowMajorIndex is index in row-major layout?
+ * @param query query rows, of n_query rows and D cols
+ * @param n_query number of rows in query
+ * @param rowMajorQuery is query in row-major layout?
+ * @param D number of cols in index and query
+ * @param eps radius of the neighborhoods
+ * @param row_ind output n_query + 1 row offsets; the last one is the number
+ *        of edges of the graph
+ * @param stream CUDA stream to use
+ */
+inline void radius_neighbors_row_ind(const float *index, int n_index,
+                                     bool rowMajorIndex, const float *query,
+                                     int n_query, bool rowMajorQuery, int D,
+                                     float eps, int *row_ind,
+                                     cudaStream_t stream) {
+  CUDA_CHECK(cudaMemsetAsync(row_ind + n_query, 0, sizeof(int), stream));
+  radius_neighbors_launch<128, float, int>(
+    index, n_index, rowMajorIndex, query, n_query, rowMajorQuery, D, eps,
+    row_ind, nullptr, nullptr, stream);
+  thrust::device_ptr<int> d_row_ind = thrust::device_pointer_cast(row_ind);
+  thrust::exclusive_scan(thrust::cuda::par.on(stream), d_row_ind,
+                         d_row_ind + n_query + 1, d_row_ind);
+}
+
+/**
+ * @brief Second pass of the radius neighbors graph: the index rows within
+ * L2 distance eps of each query, in ascending order, and their distances.
+ * @param index index rows, of n_index rows and D cols
+ * @param n_index number of rows in index
+ * @param rowMajorIndex is index in row-major layout?
+ * @param query query rows, of n_query rows and D cols
+ * @param n_query number of rows in query
+ * @param rowMajorQuery is query in row-major layout?
+ * @param D number of cols in index and query
+ * @param eps radius of the neighborhoods
+ * @param row_ind the row offsets from radius_neighbors_row_ind
+ * @param col_ind output index rows, of row_ind[n_query] elements
+ * @param vals output distances, of row_ind[n_query] elements
+ * @param stream CUDA stream to use
+ */
+inline void radius_neighbors_fill(const float *index, int n_index,
+                                  bool rowMajorIndex, const float *query,
+                                  int n_query, bool rowMajorQuery, int D,
+                                  float eps, const int *row_ind, int *col_ind,
+                                  float *vals, cudaStream_t stream) {
+  radius_neighbors_launch<128, float, int>(
+    index, n_index, rowMajorIndex, query, n_query, rowMajorQuery, D, eps,
+    const_cast<int *>(row_ind), col_ind, vals, stream);
+}
+
+/**
+ * @brief Radius neighbors graph of the query rows, with memory proportional
+ * to its number of edges: the distances of the pairs are computed in tiles
+ * on the fly, once to size the graph and once to fill it.
+ * @param index index rows, of n_index rows and D cols
+ * @param n_index number of rows in index
+ * @param rowMajorIndex is index in row-major layout?
+ * @param query query rows, of n_query rows and D cols
+ * @param n_query number of rows in query
+ * @param rowMajorQuery is query in row-major layout?
+ * @param D number of cols in index and query
+ * @param eps radius of the neighborhoods
+ * @param out output graph of n_query rows and n_index cols: the row offsets
+ *        in row_ind (n_query + 1 of them), the index rows within eps in
+ *        row_ind_ptr and their L2 distances in vals
+ * @param stream CUDA stream to use
+ */
+inline void radius_neighbors(const float *index, int n_index,
+                             bool rowMajorIndex, const float *query,
+                             int n_query, bool rowMajorQuery, int D, float eps,
+                             Sparse::CSR<float> *out, cudaStream_t stream) {
+  out->allocate(0, n_query, n_index, false, stream);
+  radius_neighbors_row_ind(index, n_index, rowMajorIndex, query, n_query,
+                           rowMajorQuery, D, eps, out->row_ind(), stream);
+  int nnz;
+  updateHost(&nnz, out->row_ind() + n_query, 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  // Resizing keeps the row offsets
+  out->allocate(nnz, n_query, n_index, false, stream);
+  radius_neighbors_fill(index, n_index, rowMajorIndex, query, n_query,
+                        rowMajorQuery, D, eps, out->row_ind(),
+                        out->row_ind_ptr(), out->vals(), stream);
+}
+
+};  // namespace Selection
+};  // namespace MLCommon
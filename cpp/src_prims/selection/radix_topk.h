@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cub/cub.cuh>
+#include <cuml/common/cuml_allocator.hpp>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "selection/columnWiseSort.h"
+#include "selection/kselection.h"
+
+namespace MLCommon {
+namespace Selection {
+
+/** largest k for which topK() dispatches to warpTopK */
+static const int WarpSelectMaxK = 256;
+
+/**
+ * @brief maps a float to an unsigned key whose ascending order is the order
+ * in which topK() keeps the values
+ * @tparam Greater as in warpTopK, true to keep the smallest values
+ */
+template <bool Greater>
+DI uint32_t radixSelectKey(float val) {
+  uint32_t bits = __float_as_uint(val);
+  uint32_t key = (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+  return Greater ? key : ~key;
+}
+
+/**
+ * One block per row: 8 bits of the k-th key are found per pass, from a block
+ * histogram of the digits of the keys that share the bits found so far. The
+ * last pass writes the keys below the k-th one and as many of its ties as
+ * needed, in no particular order.
+ */
+template <typename TypeV, typename TypeK, bool Greater, int TPB>
+__global__ void radixTopKKernel(TypeV *outV, TypeK *outK, const TypeV *arr,
+                                int k, TypeK cols) {
+  constexpr int RadixBits = 8;
+  constexpr int NDigits = 1 << RadixBits;
+  static_assert(TPB == NDigits, "radixTopKKernel: one thread per digit");
+  typedef cub::BlockScan<int, TPB> BlockScan;
+  __shared__ typename BlockScan::TempStorage scanStorage;
+  __shared__ int hist[NDigits];
+  __shared__ uint32_t sPrefix;
+  __shared__ int sRemaining, nLess, nEq;
+
+  const TypeV *row = arr + size_t(blockIdx.x) * cols;
+  uint32_t prefix = 0, mask = 0;
+  int remaining = k;
+  for (int shift = 32 - RadixBits; shift >= 0; shift -= RadixBits) {
+    hist[threadIdx.x] = 0;
+    __syncthreads();
+    for (TypeK c = threadIdx.x; c < cols; c += TPB) {
+      uint32_t key = radixSelectKey<Greater>(row[c]);
+      if ((key & mask) == prefix) {
+        atomicAdd(hist + ((key >> shift) & (NDigits - 1)), 1);
+      }
+    }
+    __syncthreads();
+    int count = hist[threadIdx.x], before;
+    BlockScan(scanStorage).ExclusiveSum(count, before);
+    // exactly one digit holds the remaining-th key
+    if (before < remaining && remaining <= before + count) {
+      sPrefix = prefix | (uint32_t(threadIdx.x) << shift);
+      sRemaining = remaining - before;
+    }
+    __syncthreads();
+    prefix = sPrefix;
+    remaining = sRemaining;
+    mask |= uint32_t(NDigits - 1) << shift;
+  }
+
+  if (threadIdx.x == 0) {
+    nLess = 0;
+    nEq = 0;
+  }
+  __syncthreads();
+  size_t outOffset = size_t(blockIdx.x) * k;
+  for (TypeK c = threadIdx.x; c < cols; c += TPB) {
+    TypeV val = row[c];
+    uint32_t key = radixSelectKey<Greater>(val);
+    int pos = -1;
+    if (key < prefix) {
+      pos = atomicAdd(&nLess, 1);
+    } else if (key == prefix) {
+      int eq = atomicAdd(&nEq, 1);
+      if (eq < remaining) pos = k - remaining + eq;
+    }
+    if (pos >= 0) {
+      if (outV != nullptr) outV[outOffset + pos] = val;
+      if (outK != nullptr) outK[outOffset + pos] = c;
+    }
+  }
+}
+
+/**
+ * @brief Perform a radix-select based top-k selection on each row of the
+ * input matrix, for any k up to the number of columns
+ * @tparam TypeV value type
+ * @tparam TypeK key type
+ * @tparam Greater as in warpTopK, true to keep the k smallest values
+ * @tparam Sort whether to sort the top-k of each row, ascending if Greater
+ * and descending otherwise; else they come in no particular order
+ * @param outV output values (rows x k), or nullptr if Sort is false and they
+ * are not needed
+ * @param outK output column indices of the values (rows x k), or nullptr if
+ * Sort is false and they are not needed
+ * @param arr the row major input matrix (rows x cols)
+ * @param k number of values to keep in each row
+ * @param rows number of rows
+ * @param cols number of columns
+ * @param allocator device allocator for the temporaries of the sort
+ * @param stream cuda stream
+ * @note each row is read five times, but the time of a pass does not depend
+ * on k, which makes it faster than warpTopK for the large ones
+ */
+template <typename TypeV, typename TypeK, bool Greater, bool Sort>
+void radixTopK(TypeV *outV, TypeK *outK, const TypeV *arr, int k, int rows,
+               TypeK cols, std::shared_ptr<deviceAllocator> allocator,
+               cudaStream_t stream) {
+  static_assert(
+    std::is_same<TypeV, float>::value && (std::is_same<TypeK, int>::value),
+    "type not support");
+  ASSERT(k >= 1 && k <= cols, "radixTopK: k=%d must be in [1, %d]", k, cols);
+  if (rows <= 0) return;
+  constexpr int TPB = 256;
+  if (!Sort) {
+    radixTopKKernel<TypeV, TypeK, Greater, TPB>
+      <<<rows, TPB, 0, stream>>>(outV, outK, arr, k, cols);
+    CUDA_CHECK(cudaPeekAtLastError());
+    return;
+  }
+
+  ASSERT(outV != nullptr && outK != nullptr,
+         "radixTopK: the sort needs both the values and the keys");
+  int len = rows * k;
+  device_buffer<TypeV> selV(allocator, stream, len);
+  device_buffer<TypeK> selK(allocator, stream, len);
+  device_buffer<int> offsets(allocator, stream, rows + 1);
+  radixTopKKernel<TypeV, TypeK, Greater, TPB>
+    <<<rows, TPB, 0, stream>>>(selV.data(), selK.data(), arr, k, cols);
+  CUDA_CHECK(cudaPeekAtLastError());
+  CUDA_CHECK(layoutSortOffset(offsets.data(), k, rows + 1, stream));
+
+  size_t workspaceSize = 0;
+  if (Greater) {
+    CUDA_CHECK(cub::DeviceSegmentedRadixSort::SortPairs(
+      nullptr, workspaceSize, selV.data(), outV, selK.data(), outK, len, rows,
+      offsets.data(), offsets.data() + 1, 0, sizeof(TypeV) * 8, stream));
+  } else {
+    CUDA_CHECK(cub::DeviceSegmentedRadixSort::SortPairsDescending(
+      nullptr, workspaceSize, selV.data(), outV, selK.data(), outK, len, rows,
+      offsets.data(), offsets.data() + 1, 0, sizeof(TypeV) * 8, stream));
+  }
+  device_buffer<char> workspace(allocator, stream, workspaceSize);
+  if (Greater) {
+    CUDA_CHECK(cub::DeviceSegmentedRadixSort::SortPairs(
+      workspace.data(), workspaceSize, selV.data(), outV, selK.data(), outK,
+      len, rows, offsets.data(), offsets.data() + 1, 0, sizeof(TypeV) * 8,
+      stream));
+  } else {
+    CUDA_CHECK(cub::DeviceSegmentedRadixSort::SortPairsDescending(
+      workspace.data(), workspaceSize, selV.data(), outV, selK.data(), outK,
+      len, rows, offsets.data(), offsets.data() + 1, 0, sizeof(TypeV) * 8,
+      stream));
+  }
+}
+
+/** the k-th key found so far by radixTopKWide, and the output counters */
+struct RadixSelectState {
+  uint32_t prefix;
+  int remaining, nLess, nEq;
+};
+
+template <typename TypeV, bool Greater, int TPB>
+__global__ void radixWideHistKernel(int *hist, const TypeV *arr, int len,
+                                    const RadixSelectState *state,
+                                    uint32_t mask, int shift) {
+  constexpr int NDigits = 256;
+  static_assert(TPB == NDigits, "radixWideHistKernel: one thread per digit");
+  __shared__ int shist[NDigits];
+  shist[threadIdx.x] = 0;
+  __syncthreads();
+  uint32_t prefix = state->prefix;
+  for (int i = threadIdx.x + blockIdx.x * TPB; i < len; i += gridDim.x * TPB) {
+    uint32_t key = radixSelectKey<Greater>(arr[i]);
+    if ((key & mask) == prefix) {
+      atomicAdd(shist + ((key >> shift) & (NDigits - 1)), 1);
+    }
+  }
+  __syncthreads();
+  if (shist[threadIdx.x] > 0) atomicAdd(hist + threadIdx.x, shist[threadIdx.x]);
+}
+
+template <int TPB>
+__global__ void radixWideDigitKernel(int *hist, RadixSelectState *state,
+                                     int shift) {
+  typedef cub::BlockScan<int, TPB> BlockScan;
+  __shared__ typename BlockScan::TempStorage scanStorage;
+  int count = hist[threadIdx.x], before;
+  int remaining = state->remaining;
+  // left zeroed for the next pass
+  hist[threadIdx.x] = 0;
+  BlockScan(scanStorage).ExclusiveSum(count, before);
+  if (before < remaining && remaining <= before + count) {
+    state->prefix |= uint32_t(threadIdx.x) << shift;
+    state->remaining = remaining - before;
+  }
+}
+
+template <typename TypeV, typename TypeK, bool Greater, int TPB>
+__global__ void radixWideSelectKernel(TypeV *outV, TypeK *outK,
+                                      const TypeV *arr, int len, int k,
+                                      RadixSelectState *state) {
+  uint32_t prefix = state->prefix;
+  int remaining = state->remaining;
+  for (int i = threadIdx.x + blockIdx.x * TPB; i < len; i += gridDim.x * TPB) {
+    TypeV val = arr[i];
+    uint32_t key = radixSelectKey<Greater>(val);
+    int pos = -1;
+    if (key < prefix) {
+      pos = atomicAdd(&state->nLess, 1);
+    } else if (key == prefix) {
+      int eq = atomicAdd(&state->nEq, 1);
+      if (eq < remaining) pos = k - remaining + eq;
+    }
+    if (pos >= 0) {
+      if (outV != nullptr) outV[pos] = val;
+      if (outK != nullptr) outK[pos] = TypeK(i);
+    }
+  }
+}
+
+/**
+ * @brief Perform a radix-select based top-k selection on a single long array,
+ * with the whole grid on each pass rather than one block per row as in
+ * radixTopK. The k-th key is found 8 bits per pass, the passes exchanging it
+ * through device memory, so that nothing is synchronized with the host.
+ * @tparam TypeV value type
+ * @tparam TypeK key type
+ * @tparam Greater as in warpTopK, true to keep the k smallest values
+ * @param outV output values in no particular order (k), or nullptr
+ * @param outK output indices of the values in no particular order (k), or
+ * nullptr
+ * @param arr the input array (len)
+ * @param k number of values to keep
+ * @param len length of the array
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ */
+template <typename TypeV, typename TypeK, bool Greater>
+void radixTopKWide(TypeV *outV, TypeK *outK, const TypeV *arr, int k, int len,
+                   std::shared_ptr<deviceAllocator> allocator,
+                   cudaStream_t stream) {
+  static_assert(std::is_same<TypeV, float>::value, "type not support");
+  ASSERT(k >= 1 && k <= len, "radixTopKWide: k=%d must be in [1, %d]", k,
+         len);
+  constexpr int TPB = 256;
+  device_buffer<int> hist(allocator, stream, TPB);
+  device_buffer<RadixSelectState> state(allocator, stream, 1);
+  RadixSelectState init = {0u, k, 0, 0};
+  CUDA_CHECK(cudaMemsetAsync(hist.data(), 0, TPB * sizeof(int), stream));
+  updateDevice(state.data(), &init, 1, stream);
+  int nblks = std::min(ceildiv(len, TPB), 4 * getMultiProcessorCount());
+  uint32_t mask = 0;
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    radixWideHistKernel<TypeV, Greater, TPB>
+      <<<nblks, TPB, 0, stream>>>(hist.data(), arr, len, state.data(), mask,
+                                  shift);
+    CUDA_CHECK(cudaPeekAtLastError());
+    radixWideDigitKernel<TPB>
+      <<<1, TPB, 0, stream>>>(hist.data(), state.data(), shift);
+    CUDA_CHECK(cudaPeekAtLastError());
+    mask |= 0xffu << shift;
+  }
+  radixWideSelectKernel<TypeV, TypeK, Greater, TPB>
+    <<<nblks, TPB, 0, stream>>>(outV, outK, arr, len, k, state.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Perform top-k selection on each row of the input matrix, with
+ * warpTopK up to WarpSelectMaxK and radixTopK, sorted, above it
+ * @tparam TypeV value type
+ * @tparam TypeK key type
+ * @tparam Greater as in warpTopK, true to keep the k smallest values
+ * @param outV output values (rows x k)
+ * @param outK output column indices of the values (rows x k)
+ * @param arr the row major input matrix (rows x cols)
+ * @param k number of values to keep in each row
+ * @param rows number of rows
+ * @param cols number of columns
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ */
+template <typename TypeV, typename TypeK, bool Greater>
+void topK(TypeV *outV, TypeK *outK, const TypeV *arr, int k, int rows,
+          TypeK cols, std::shared_ptr<deviceAllocator> allocator,
+          cudaStream_t stream) {
+  if (k <= WarpSelectMaxK) {
+    warpTopK<TypeV, TypeK, Greater, false>(outV, outK, arr, k, rows, cols,
+                                           stream);
+  } else {
+    radixTopK<TypeV, TypeK, Greater, true>(outV, outK, arr, k, rows, cols,
+                                           allocator, stream);
+  }
+}
+
+};  // end namespace Selection
+};  // end namespace MLCommon
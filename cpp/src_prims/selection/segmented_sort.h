@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cub/cub.cuh>
+#include <cuml/common/cuml_allocator.hpp>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "selection/columnWiseSort.h"
+
+namespace MLCommon {
+namespace Selection {
+
+/**
+ * @defgroup SegmentedSort
+ * @{
+ * @brief Radix sorts of the segments of an array, for any key cub can radix
+ * sort, the 64-bit ones included. The segments are given by device offsets
+ * (nSegments + 1), or are the rows of a row major matrix for sortRowsKeys()
+ * and sortRowsPairs(). The input is first copied into a temporary buffer the
+ * sort may overwrite, so that the output may be the input itself, and the
+ * temporaries come from the allocator, so that no workspace needs to be
+ * queried first.
+ */
+
+template <typename KeyT, typename ValT, typename OffsetT>
+struct SegmentedSortOp {
+  bool descending;
+  int beginBit, endBit;
+  cudaStream_t stream;
+
+  cudaError_t operator()(void *storage, size_t &bytes,
+                         cub::DoubleBuffer<KeyT> &keys,
+                         cub::DoubleBuffer<ValT> &vals, int nItems,
+                         int nSegments, const OffsetT *offsets) const {
+    if (nSegments == 1) {
+      return descending
+               ? cub::DeviceRadixSort::SortPairsDescending(
+                   storage, bytes, keys, vals, nItems, beginBit, endBit, stream)
+               : cub::DeviceRadixSort::SortPairs(storage, bytes, keys, vals,
+                                                 nItems, beginBit, endBit,
+                                                 stream);
+    }
+    return descending
+             ? cub::DeviceSegmentedRadixSort::SortPairsDescending(
+                 storage, bytes, keys, vals, nItems, nSegments, offsets,
+                 offsets + 1, beginBit, endBit, stream)
+             : cub::DeviceSegmentedRadixSort::SortPairs(
+                 storage, bytes, keys, vals, nItems, nSegments, offsets,
+                 offsets + 1, beginBit, endBit, stream);
+  }
+
+  cudaError_t operator()(void *storage, size_t &bytes,
+                         cub::DoubleBuffer<KeyT> &keys, int nItems,
+                         int nSegments, const OffsetT *offsets) const {
+    if (nSegments == 1) {
+      return descending ? cub::DeviceRadixSort::SortKeysDescending(
+                            storage, bytes, keys, nItems, beginBit, endBit,
+                            stream)
+                        : cub::DeviceRadixSort::SortKeys(storage, bytes, keys,
+                                                         nItems, beginBit,
+                                                         endBit, stream);
+    }
+    return descending
+             ? cub::DeviceSegmentedRadixSort::SortKeysDescending(
+                 storage, bytes, keys, nItems, nSegments, offsets, offsets + 1,
+                 beginBit, endBit, stream)
+             : cub::DeviceSegmentedRadixSort::SortKeys(
+                 storage, bytes, keys, nItems, nSegments, offsets, offsets + 1,
+                 beginBit, endBit, stream);
+  }
+};
+
+/**
+ * @brief Sort the keys of each segment
+ * @tparam KeyT key type
+ * @tparam OffsetT type of the offsets
+ * @param inKeys input keys (nItems)
+ * @param outKeys output keys (nItems), which may be inKeys
+ * @param nItems number of keys
+ * @param nSegments number of segments
+ * @param offsets start of each segment followed by nItems, on the device
+ * (nSegments + 1)
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ * @param descending whether to sort in descending order
+ * @param beginBit first bit of the keys to sort on
+ * @param endBit one past the last bit of the keys to sort on
+ */
+template <typename KeyT, typename OffsetT>
+void segmentedSortKeys(const KeyT *inKeys, KeyT *outKeys, int nItems,
+                       int nSegments, const OffsetT *offsets,
+                       std::shared_ptr<deviceAllocator> allocator,
+                       cudaStream_t stream, bool descending = false,
+                       int beginBit = 0, int endBit = sizeof(KeyT) * 8) {
+  if (nItems <= 0 || nSegments <= 0) return;
+  device_buffer<KeyT> altKeys(allocator, stream, nItems);
+  copyAsync(altKeys.data(), inKeys, nItems, stream);
+  cub::DoubleBuffer<KeyT> keys(altKeys.data(), outKeys);
+  SegmentedSortOp<KeyT, cub::NullType, OffsetT> op = {descending, beginBit,
+                                                      endBit, stream};
+  size_t bytes = 0;
+  CUDA_CHECK(op(nullptr, bytes, keys, nItems, nSegments, offsets));
+  device_buffer<char> storage(allocator, stream, bytes);
+  CUDA_CHECK(op(storage.data(), bytes, keys, nItems, nSegments, offsets));
+  if (keys.Current() != outKeys) {
+    copyAsync(outKeys, keys.Current(), nItems, stream);
+  }
+}
+
+/**
+ * @brief Sort the key-value pairs of each segment by key
+ * @tparam KeyT key type
+ * @tparam ValT value type
+ * @tparam OffsetT type of the offsets
+ * @param inKeys input keys (nItems)
+ * @param outKeys output keys (nItems), which may be inKeys, or nullptr if only
+ * the values are needed
+ * @param inVals input values (nItems)
+ * @param outVals output values (nItems), which may be inVals
+ * @param nItems number of pairs
+ * @param nSegments number of segments
+ * @param offsets start of each segment followed by nItems, on the device
+ * (nSegments + 1)
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ * @param descending whether to sort in descending order
+ * @param beginBit first bit of the keys to sort on
+ * @param endBit one past the last bit of the keys to sort on
+ * @note the sort is stable, so that the values of equal keys keep their order
+ */
+template <typename KeyT, typename ValT, typename OffsetT>
+void segmentedSortPairs(const KeyT *inKeys, KeyT *outKeys, const ValT *inVals,
+                        ValT *outVals, int nItems, int nSegments,
+                        const OffsetT *offsets,
+                        std::shared_ptr<deviceAllocator> allocator,
+                        cudaStream_t stream, bool descending = false,
+                        int beginBit = 0, int endBit = sizeof(KeyT) * 8) {
+  if (nItems <= 0 || nSegments <= 0) return;
+  device_buffer<KeyT> altKeys(allocator, stream, nItems);
+  device_buffer<KeyT> keysOut(allocator, stream,
+                              outKeys == nullptr ? nItems : 0);
+  if (outKeys == nullptr) outKeys = keysOut.data();
+  device_buffer<ValT> altVals(allocator, stream, nItems);
+  copyAsync(altKeys.data(), inKeys, nItems, stream);
+  copyAsync(altVals.data(), inVals, nItems, stream);
+  cub::DoubleBuffer<KeyT> keys(altKeys.data(), outKeys);
+  cub::DoubleBuffer<ValT> vals(altVals.data(), outVals);
+  SegmentedSortOp<KeyT, ValT, OffsetT> op = {descending, beginBit, endBit,
+                                              stream};
+  size_t bytes = 0;
+  CUDA_CHECK(op(nullptr, bytes, keys, vals, nItems, nSegments, offsets));
+  device_buffer<char> storage(allocator, stream, bytes);
+  CUDA_CHECK(op(storage.data(), bytes, keys, vals, nItems, nSegments, offsets));
+  // the keys and the values always end up in the same one of their buffers
+  if (keys.Current() != outKeys) {
+    copyAsync(outKeys, keys.Current(), nItems, stream);
+    copyAsync(outVals, vals.Current(), nItems, stream);
+  }
+}
+
+/**
+ * @brief Sort the keys of each row of a row major matrix
+ * @tparam KeyT key type
+ * @param inKeys input matrix (rows x cols)
+ * @param outKeys output matrix (rows x cols), which may be inKeys
+ * @param rows number of rows
+ * @param cols number of columns
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ * @param descending whether to sort in descending order
+ */
+template <typename KeyT>
+void sortRowsKeys(const KeyT *inKeys, KeyT *outKeys, int rows, int cols,
+                  std::shared_ptr<deviceAllocator> allocator,
+                  cudaStream_t stream, bool descending = false) {
+  if (rows <= 0 || cols <= 0) return;
+  device_buffer<int> offsets(allocator, stream, rows + 1);
+  CUDA_CHECK(layoutSortOffset(offsets.data(), cols, rows + 1, stream));
+  segmentedSortKeys(inKeys, outKeys, rows * cols, rows,
+                    (const int *)offsets.data(), allocator, stream,
+                    descending);
+}
+
+/**
+ * @brief Sort the key-value pairs of each row of row major matrices by key
+ * @tparam KeyT key type
+ * @tparam ValT value type
+ * @param inKeys input keys (rows x cols)
+ * @param outKeys output keys (rows x cols), which may be inKeys, or nullptr
+ * if only the values are needed
+ * @param inVals input values (rows x cols)
+ * @param outVals output values (rows x cols), which may be inVals
+ * @param rows number of rows
+ * @param cols number of columns
+ * @param allocator device allocator for the temporaries
+ * @param stream cuda stream
+ * @param descending whether to sort in descending order
+ */
+template <typename KeyT, typename ValT>
+void sortRowsPairs(const KeyT *inKeys, KeyT *outKeys, const ValT *inVals,
+                   ValT *outVals, int rows, int cols,
+                   std::shared_ptr<deviceAllocator> allocator,
+                   cudaStream_t stream, bool descending = false) {
+  if (rows <= 0 || cols <= 0) return;
+  device_buffer<int> offsets(allocator, stream, rows + 1);
+  CUDA_CHECK(layoutSortOffset(offsets.data(), cols, rows + 1, stream));
+  segmentedSortPairs(inKeys, outKeys, inVals, outVals, rows * cols, rows,
+                     (const int *)offsets.data(), allocator, stream,
+                     descending);
+}
+/** @} */
+
+};  // end namespace Selection
+};  // end namespace MLCommon
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cuda_utils.h"
+
+#include "knn.h"
+#include "knn_graph.h"
+#include "sparse/csr.h"
+
+#include <faiss/gpu/utils/Limits.cuh>
+
+#include <thrust/binary_search.h>
+#include <thrust/device_ptr.h>
+#include <thrust/execution_policy.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <thrust/sort.h>
+
+#include <cuml/common/cuml_allocator.hpp>
+#include "common/device_buffer.hpp"
+
+#include <algorithm>
+
+namespace MLCommon {
+namespace Selection {
+
+/** Largest tile of query rows of sparse_brute_force_knn */
+static const int SPARSE_KNN_MAX_TILE = 8192;
+
+/**
+ * @brief Query rows of the tiles of sparse_brute_force_knn, so that the
+ * distances of a tile to the n_index rows fit in half of the free device
+ * memory.
+ */
+inline int sparse_knn_tile_rows(int n_query, int n_index) {
+  size_t free_mem, total_mem;
+  CUDA_CHECK(cudaMemGetInfo(&free_mem, &total_mem));
+  size_t rows = free_mem / 2 / sizeof(float) / std::max(n_index, 1);
+  rows = std::min<size_t>(rows, SPARSE_KNN_MAX_TILE);
+  return (int)std::max<size_t>(1, std::min<size_t>(rows, n_query));
+}
+
+/** Squared L2 norm of each row of a CSR matrix, a thread per row */
+template <int TPB_X = 256>
+__global__ void csr_row_sq_norms_kernel(const float *vals, const int *row_ind,
+                                        int n_rows, float *norms) {
+  int row = blockIdx.x * TPB_X + threadIdx.x;
+  if (row >= n_rows) return;
+  float acc = 0.f;
+  for (int j = row_ind[row]; j < row_ind[row + 1]; j++)
+    acc += vals[j] * vals[j];
+  norms[row] = acc;
+}
+
+/**
+ * Inner products of the query rows r0 to r0 + n_rows with all the n_index
+ * rows of the index, a warp per query row. Each nonzero (c, v) of a query
+ * row is multiplied with the nonzeros of col c of the index, which is stored
+ * in CSC (col_ind offsets, csc_rows, csc_vals), so only the pairs of
+ * nonzeros sharing a col are visited.
+ */
+template <int TPB_X = 256>
+__global__ void sparse_knn_dots_kernel(const float *q_vals,
+                                       const int *q_row_ind, const int *q_cols,
+                                       int r0, int n_rows,
+                                       const float *csc_vals,
+                                       const int *col_ind,
+                                       const int *csc_rows, int n_index,
+                                       float *dots) {
+  int row = (blockIdx.x * TPB_X + threadIdx.x) / WarpSize;
+  int lane = threadIdx.x % WarpSize;
+  if (row >= n_rows) return;
+
+  float *out = dots + (size_t)row * n_index;
+  for (int j = q_row_ind[r0 + row]; j < q_row_ind[r0 + row + 1]; j++) {
+    int c = q_cols[j];
+    float v = q_vals[j];
+    // The lanes of the warp can be on different nonzeros of the query row
+    for (int e = col_ind[c] + lane; e < col_ind[c + 1]; e += WarpSize)
+      atomicAdd(out + csc_rows[e], v * csc_vals[e]);
+  }
+}
+
+/**
+ * @brief k nearest neighbors, in L2 distance, of the rows of a CSR query
+ * matrix among the rows of a CSR index matrix, without densifying either.
+ * The index is transposed to CSC once; the queries are then searched in
+ * tiles of rows, whose expanded L2 distances to all the index rows are
+ * built from the inner products of the pairs of nonzeros sharing a col and
+ * selected with knn_graph_select.
+ *
+ * @param idx_vals nonzero values of the index (idx_nnz)
+ * @param idx_row_ind offsets of the index rows in idx_vals (n_index + 1)
+ * @param idx_row_ind_ptr col of each nonzero of the index (idx_nnz)
+ * @param idx_nnz number of nonzeros of the index
+ * @param n_index number of rows of the index
+ * @param q_vals nonzero values of the queries
+ * @param q_row_ind offsets of the query rows in q_vals (n_query + 1)
+ * @param q_row_ind_ptr col of each nonzero of the queries
+ * @param n_query number of rows of the queries
+ * @param D number of cols of the index and the queries
+ * @param k number of neighbors of each query, at most n_index and 1024
+ * @param res_I output neighbors (n_query x k, row-major)
+ * @param res_D output L2 distances (n_query x k, row-major)
+ * @param allocator the device memory allocator of the temporaries
+ * @param stream CUDA stream to use
+ * @param tile_rows query rows of the tiles; when this is <= 0, it is sized
+ *        from the free device memory
+ */
+inline void sparse_brute_force_knn(
+  const float *idx_vals, const int *idx_row_ind, const int *idx_row_ind_ptr,
+  int idx_nnz, int n_index, const float *q_vals, const int *q_row_ind,
+  const int *q_row_ind_ptr, int n_query, int D, int k, int64_t *res_I,
+  float *res_D, std::shared_ptr<deviceAllocator> allocator,
+  cudaStream_t stream, int tile_rows = 0) {
+  constexpr int TPB_X = 256;
+  ASSERT(k <= 1024, "sparse_brute_force_knn: k=%d is larger than 1024", k);
+  ASSERT(k <= n_index, "sparse_brute_force_knn: %d rows have fewer than k=%d",
+         n_index, k);
+
+  // The index in CSC: its nonzeros sorted by col
+  device_buffer<int> csc_cols(allocator, stream, idx_nnz);
+  device_buffer<int> csc_rows(allocator, stream, idx_nnz);
+  device_buffer<float> csc_vals(allocator, stream, idx_nnz);
+  device_buffer<int> col_ind(allocator, stream, D + 1);
+  copyAsync(csc_cols.data(), idx_row_ind_ptr, idx_nnz, stream);
+  copyAsync(csc_vals.data(), idx_vals, idx_nnz, stream);
+  Sparse::csr_to_coo<TPB_X>(idx_row_ind, n_index, csc_rows.data(), idx_nnz,
+                            stream);
+  auto policy = thrust::cuda::par.on(stream);
+  thrust::stable_sort_by_key(
+    policy, csc_cols.data(), csc_cols.data() + idx_nnz,
+    thrust::make_zip_iterator(
+      thrust::make_tuple(csc_rows.data(), csc_vals.data())));
+  thrust::lower_bound(policy, csc_cols.data(), csc_cols.data() + idx_nnz,
+                      thrust::make_counting_iterator(0),
+                      thrust::make_counting_iterator(D + 1), col_ind.data());
+
+  device_buffer<float> idx_norms(allocator, stream, n_index);
+  device_buffer<float> q_norms(allocator, stream, n_query);
+  csr_row_sq_norms_kernel<TPB_X>
+    <<<ceildiv(n_index, TPB_X), TPB_X, 0, stream>>>(idx_vals, idx_row_ind,
+                                                     n_index, idx_norms.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+  csr_row_sq_norms_kernel<TPB_X>
+    <<<ceildiv(n_query, TPB_X), TPB_X, 0, stream>>>(q_vals, q_row_ind,
+                                                     n_query, q_norms.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  if (tile_rows <= 0) tile_rows = sparse_knn_tile_rows(n_query, n_index);
+  tile_rows = std::min(tile_rows, n_query);
+  device_buffer<float> tile_dists(allocator, stream,
+                                  (size_t)tile_rows * n_index);
+  constexpr int rows_per_block = TPB_X / WarpSize;
+
+  for (int r0 = 0; r0 < n_query; r0 += tile_rows) {
+    int rows = std::min(tile_rows, n_query - r0);
+    size_t len = (size_t)rows * n_index;
+    float *dists = tile_dists.data();
+    CUDA_CHECK(cudaMemsetAsync(dists, 0, len * sizeof(float), stream));
+    sparse_knn_dots_kernel<TPB_X>
+      <<<ceildiv(rows, rows_per_block), TPB_X, 0, stream>>>(
+        q_vals, q_row_ind, q_row_ind_ptr, r0, rows, csc_vals.data(),
+        col_ind.data(), csc_rows.data(), n_index, dists);
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    const float *qn = q_norms.data() + r0;
+    const float *in = idx_norms.data();
+    thrust::for_each(policy, thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator<size_t>(len),
+                     [=] __device__(size_t i) {
+                       dists[i] = qn[i / n_index] + in[i % n_index] -
+                                  2.f * dists[i];
+                     });
+
+    knn_graph_select(dists, rows, n_index, n_index, 1, k, 0, false,
+                     res_D + (size_t)r0 * k, res_I + (size_t)r0 * k, stream);
+  }
+
+  knn_finalize_distances(res_D, (size_t)n_query * k, METRIC_L2, 2.0f, stream);
+}
+
+};  // namespace Selection
+};  // namespace MLCommon
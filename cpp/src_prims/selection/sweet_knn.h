@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cuda_utils.h"
+
+#include <faiss/gpu/utils/Limits.cuh>
+#include <faiss/gpu/utils/Select.cuh>
+
+#include <cuml/common/cuml_allocator.hpp>
+#include "common/cub_wrappers.h"
+#include "common/device_buffer.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+namespace MLCommon {
+namespace Selection {
+
+/** Largest dimensionality for which brute_force_knn uses sweet_knn */
+static const int SWEET_KNN_MAX_DIM = 16;
+
+/** Smallest index partition for which brute_force_knn uses sweet_knn */
+static const size_t SWEET_KNN_MIN_ROWS = 1 << 16;
+
+/** Smallest number of queries for which brute_force_knn uses sweet_knn */
+static const size_t SWEET_KNN_MIN_QUERIES = 1 << 12;
+
+/** Largest k searched by sweet_knn_search */
+static const int SWEET_KNN_MAX_K = 1024;
+
+/**
+ * Index of the triangle inequality kNN search (Sweet KNN): the index rows
+ * are clustered around n_reps representatives and stored by cluster, in
+ * ascending order of their distance to the representative.
+ */
+struct SweetKnnIndex {
+  SweetKnnIndex(std::shared_ptr<deviceAllocator> allocator,
+                cudaStream_t stream)
+    : reps(allocator, stream, 0),
+      points(allocator, stream, 0),
+      dists(allocator, stream, 0),
+      ids(allocator, stream, 0),
+      offsets(allocator, stream, 0) {}
+
+  int D = 0;
+  int n_reps = 0;
+  /** representatives (n_reps x D, row-major) */
+  device_buffer<float> reps;
+  /** index rows ordered by cluster (n_rows x D, row-major) */
+  device_buffer<float> points;
+  /** distance of each of points to its representative */
+  device_buffer<float> dists;
+  /** row in the index of each of points */
+  device_buffer<int64_t> ids;
+  /** n_reps + 1 offsets of the clusters in points */
+  device_buffer<int64_t> offsets;
+};
+
+/**
+ * @brief Whether the pruning of sweet_knn is expected to beat a brute force
+ * search: the data has few dimensions, and the index and the queries are
+ * large enough to amortize the clustering of the index.
+ * @param n_index number of rows in the index
+ * @param n_query number of queries
+ * @param D number of cols
+ * @param k number of neighbors to query
+ */
+inline bool sweet_knn_pays_off(size_t n_index, size_t n_query, int D, int k) {
+  return D <= SWEET_KNN_MAX_DIM && n_index >= SWEET_KNN_MIN_ROWS &&
+         n_index <= INT_MAX && n_query >= SWEET_KNN_MIN_QUERIES &&
+         k <= SWEET_KNN_MAX_K;
+}
+
+/** Squared L2 distance of the point at x, with a stride of x_stride between
+    its cols, and the row-major point y */
+DI float sweet_sq_dist(const float *x, size_t x_stride, const float *y,
+                       int D) {
+  float acc = 0;
+  for (int c = 0; c < D; c++) {
+    float diff = x[c * x_stride] - y[c];
+    acc += diff * diff;
+  }
+  return acc;
+}
+
+/** First of the n sorted values not less than (upper = false) or greater
+    than (upper = true) val */
+DI int64_t sweet_bound(const float *values, int64_t n, float val,
+                       bool upper) {
+  int64_t lo = 0;
+  while (n > 0) {
+    int64_t half = n / 2;
+    float v = values[lo + half];
+    if (upper ? v <= val : v < val) {
+      lo += half + 1;
+      n -= half + 1;
+    } else {
+      n = half;
+    }
+  }
+  return lo;
+}
+
+static __global__ void sweet_gather_reps_kernel(const float *index,
+                                                size_t n_index,
+                                                bool rowMajorIndex, int D,
+                                                int n_reps, size_t stride,
+                                                float *reps) {
+  size_t tid = threadIdx.x + (size_t)blockIdx.x * blockDim.x;
+  if (tid >= (size_t)n_reps * D) return;
+  size_t row = (tid / D) * stride;
+  int c = tid % D;
+  reps[tid] = rowMajorIndex ? index[row * D + c] : index[row + c * n_index];
+}
+
+/**
+ * The key of each index row sorts it by nearest representative, then by
+ * distance to it: the representative in the high 32 bits and the bits of
+ * the non negative float distance in the low ones.
+ */
+static __global__ void sweet_assign_kernel(const float *index, size_t n_index,
+                                           bool rowMajorIndex, int D,
+                                           const float *reps, int n_reps,
+                                           uint64_t *keys, int64_t *rows,
+                                           int *counts) {
+  size_t row = threadIdx.x + (size_t)blockIdx.x * blockDim.x;
+  if (row >= n_index) return;
+  const float *x = rowMajorIndex ? index + row * D : index + row;
+  size_t x_stride = rowMajorIndex ? 1 : n_index;
+  float best = sweet_sq_dist(x, x_stride, reps, D);
+  int best_rep = 0;
+  for (int r = 1; r < n_reps; r++) {
+    float dist = sweet_sq_dist(x, x_stride, reps + (size_t)r * D, D);
+    if (dist < best) {
+      best = dist;
+      best_rep = r;
+    }
+  }
+  keys[row] = ((uint64_t)best_rep << 32) | __float_as_uint(sqrtf(best));
+  rows[row] = row;
+  atomicAdd(counts + best_rep, 1);
+}
+
+static __global__ void sweet_gather_points_kernel(
+  const float *index, size_t n_index, bool rowMajorIndex, int D,
+  const uint64_t *keys, const int64_t *ids, float *points, float *dists) {
+  size_t tid = threadIdx.x + (size_t)blockIdx.x * blockDim.x;
+  if (tid >= n_index * D) return;
+  size_t j = tid / D;
+  int c = tid % D;
+  size_t row = ids[j];
+  points[tid] = rowMajorIndex ? index[row * D + c] : index[row + c * n_index];
+  if (c == 0) dists[j] = __uint_as_float((unsigned int)(keys[j] & 0xffffffff));
+}
+
+/**
+ * @brief Cluster the index rows around representatives for
+ * sweet_knn_search().
+ * @param sweet the index to build
+ * @param index index rows, of n_index rows and D cols
+ * @param n_index number of rows in index, at most INT_MAX
+ * @param rowMajorIndex is index in row-major layout?
+ * @param D number of cols in index
+ * @param n_reps number of representatives; when this is <= 0, sqrt(n_index)
+ * @param allocator the device memory allocator to use for temporary memory
+ * @param stream CUDA stream to use
+ */
+inline void sweet_knn_build(SweetKnnIndex *sweet, const float *index,
+                            size_t n_index, bool rowMajorIndex, int D,
+                            int n_reps,
+                            std::shared_ptr<deviceAllocator> allocator,
+                            cudaStream_t stream) {
+  ASSERT(n_index > 0 && n_index <= INT_MAX,
+         "sweet_knn: invalid number of index rows %zu", n_index);
+  if (n_reps <= 0) n_reps = std::max(1, (int)std::sqrt((double)n_index));
+  n_reps = std::min<size_t>(n_reps, n_index);
+  sweet->D = D;
+  sweet->n_reps = n_reps;
+  const int TPB = 256;
+
+  // The representatives are evenly spaced index rows
+  sweet->reps.resize((size_t)n_reps * D, stream);
+  sweet_gather_reps_kernel<<<ceildiv<size_t>((size_t)n_reps * D, TPB), TPB, 0,
+                             stream>>>(index, n_index, rowMajorIndex, D,
+                                       n_reps, n_index / n_reps,
+                                       sweet->reps.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  device_buffer<uint64_t> keys(allocator, stream, n_index);
+  device_buffer<uint64_t> sorted_keys(allocator, stream, n_index);
+  device_buffer<int64_t> rows(allocator, stream, n_index);
+  device_buffer<int> counts(allocator, stream, n_reps);
+  CUDA_CHECK(cudaMemsetAsync(counts.data(), 0, n_reps * sizeof(int), stream));
+  sweet_assign_kernel<<<ceildiv<size_t>(n_index, TPB), TPB, 0, stream>>>(
+    index, n_index, rowMajorIndex, D, sweet->reps.data(), n_reps, keys.data(),
+    rows.data(), counts.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  sweet->ids.resize(n_index, stream);
+  device_buffer<char> workspace(allocator, stream, 0);
+  sortPairs(workspace, keys.data(), sorted_keys.data(), rows.data(),
+            sweet->ids.data(), (int)n_index, stream);
+
+  sweet->points.resize(n_index * D, stream);
+  sweet->dists.resize(n_index, stream);
+  sweet_gather_points_kernel<<<ceildiv<size_t>(n_index * D, TPB), TPB, 0,
+                               stream>>>(
+    index, n_index, rowMajorIndex, D, sorted_keys.data(), sweet->ids.data(),
+    sweet->points.data(), sweet->dists.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  std::vector<int> h_counts(n_reps);
+  std::vector<int64_t> h_offsets(n_reps + 1, 0);
+  updateHost(h_counts.data(), counts.data(), n_reps, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  for (int r = 0; r < n_reps; r++)
+    h_offsets[r + 1] = h_offsets[r] + h_counts[r];
+  sweet->offsets.resize(n_reps + 1, stream);
+  updateDevice(sweet->offsets.data(), h_offsets.data(), n_reps + 1, stream);
+  // h_offsets must outlive its copy to the device
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+}
+
+/**
+ * Each warp selects the k nearest index rows of one query. It scans its
+ * nearest cluster first, then the others, skipping any point whose
+ * distance to the query is bounded below by the distance to the k-th
+ * neighbor so far, theta, by the triangle inequality:
+ * |d(q, r) - d(p, r)| <= d(q, p) for the representative r of p. As the
+ * clusters are sorted by d(p, r), the points left are a range found by
+ * binary search, and whole clusters are skipped when
+ * d(q, r) - max d(p, r) > theta.
+ */
+template <int warp_q, int thread_q, int tpb>
+__global__ void sweet_knn_kernel(const float *points, const float *dists,
+                                 const int64_t *ids, const int64_t *offsets,
+                                 const float *reps, int n_reps, int D,
+                                 const float *query, size_t n_query,
+                                 bool rowMajorQuery, int k, float initK,
+                                 int64_t initV, float *outK, int64_t *outV) {
+  constexpr int kNumWarps = tpb / faiss::gpu::kWarpSize;
+  // Relative slack of the bounds, for the rounding of the distances
+  const float kSlack = 1e-4f;
+
+  faiss::gpu::WarpSelect<float, int64_t, false, faiss::gpu::Comparator<float>,
+                         warp_q, thread_q, tpb>
+    heap(initK, initV, k);
+
+  int lane = threadIdx.x % faiss::gpu::kWarpSize;
+  int warp = threadIdx.x / faiss::gpu::kWarpSize;
+  size_t row = (size_t)blockIdx.x * kNumWarps + warp;
+  // Whole warps exit together, and there is no block level synchronization
+  if (row >= n_query) return;
+  const float *q = rowMajorQuery ? query + row * D : query + row;
+  size_t q_stride = rowMajorQuery ? 1 : n_query;
+
+  float best = initK;
+  int nearest = 0;
+  for (int r = lane; r < n_reps; r += faiss::gpu::kWarpSize) {
+    float dist = sweet_sq_dist(q, q_stride, reps + (size_t)r * D, D);
+    if (dist < best) {
+      best = dist;
+      nearest = r;
+    }
+  }
+  for (int mask = faiss::gpu::kWarpSize / 2; mask > 0; mask /= 2) {
+    float other = shfl_xor(best, mask);
+    int other_rep = shfl_xor(nearest, mask);
+    if (other < best || (other == best && other_rep < nearest)) {
+      best = other;
+      nearest = other_rep;
+    }
+  }
+
+  for (int i = -1; i < n_reps; i++) {
+    if (i == nearest) continue;
+    int r = i < 0 ? nearest : i;
+    int64_t begin = offsets[r], end = offsets[r + 1];
+    if (begin == end) continue;
+    float q2r = sqrtf(sweet_sq_dist(q, q_stride, reps + (size_t)r * D, D));
+    float theta = sqrtf(heap.warpKTop) * (1 + kSlack);
+    if (q2r - dists[end - 1] > theta) continue;
+
+    int64_t lo = begin + sweet_bound(dists + begin, end - begin,
+                                     q2r - theta, false);
+    int64_t hi = begin + sweet_bound(dists + begin, end - begin,
+                                     q2r + theta, true);
+    for (int64_t base = lo; base < hi; base += faiss::gpu::kWarpSize) {
+      // theta only decreases, so it is refreshed for each warp of points
+      theta = sqrtf(heap.warpKTop) * (1 + kSlack);
+      int64_t j = base + lane;
+      float dist = initK;
+      int64_t id = initV;
+      if (j < hi && fabsf(q2r - dists[j]) <= theta) {
+        dist = sweet_sq_dist(q, q_stride, points + j * D, D);
+        id = ids[j];
+      }
+      heap.add(dist, id);
+    }
+  }
+
+  heap.reduce();
+  heap.writeOut(outK + row * k, outV + row * k, k);
+}
+
+template <int warp_q, int thread_q>
+inline void sweet_knn_search_impl(const SweetKnnIndex &sweet,
+                                  const float *query, size_t n_query,
+                                  bool rowMajorQuery, int k, float *outD,
+                                  int64_t *outI, cudaStream_t stream) {
+  constexpr int tpb = 128;
+  constexpr int queries_per_block = tpb / faiss::gpu::kWarpSize;
+  auto kInit = faiss::gpu::Limits<float>::getMax();
+  auto vInit = -1;
+  sweet_knn_kernel<warp_q, thread_q, tpb>
+    <<<ceildiv<size_t>(n_query, queries_per_block), tpb, 0, stream>>>(
+      sweet.points.data(), sweet.dists.data(), sweet.ids.data(),
+      sweet.offsets.data(), sweet.reps.data(), sweet.n_reps, sweet.D, query,
+      n_query, rowMajorQuery, k, kInit, vInit, outD, outI);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Search the k nearest neighbors of the query rows in an index built
+ * by sweet_knn_build(), with the exact L2 distance.
+ *
+ * The output is in the format of faiss::gpu::bruteForceKnn: for each query,
+ * the k squared L2 distances in ascending order, and the corresponding rows
+ * of the index.
+ *
+ * @param sweet the index
+ * @param query query rows, of n_query rows and sweet.D cols
+ * @param n_query number of rows in query
+ * @param rowMajorQuery is query in row-major layout?
+ * @param k number of neighbors to query, at most SWEET_KNN_MAX_K
+ * @param outD output squared distances (n_query x k, row-major)
+ * @param outI output index rows (n_query x k, row-major)
+ * @param stream CUDA stream to use
+ */
+inline void sweet_knn_search(const SweetKnnIndex &sweet, const float *query,
+                             size_t n_query, bool rowMajorQuery, int k,
+                             float *outD, int64_t *outI, cudaStream_t stream) {
+  ASSERT(k <= SWEET_KNN_MAX_K, "sweet_knn: k=%d is larger than %d", k,
+         SWEET_KNN_MAX_K);
+  if (k <= 32)
+    sweet_knn_search_impl<32, 2>(sweet, query, n_query, rowMajorQuery, k,
+                                 outD, outI, stream);
+  else if (k <= 64)
+    sweet_knn_search_impl<64, 3>(sweet, query, n_query, rowMajorQuery, k,
+                                 outD, outI, stream);
+  else if (k <= 128)
+    sweet_knn_search_impl<128, 3>(sweet, query, n_query, rowMajorQuery, k,
+                                  outD, outI, stream);
+  else if (k <= 256)
+    sweet_knn_search_impl<256, 4>(sweet, query, n_query, rowMajorQuery, k,
+                                  outD, outI, stream);
+  else if (k <= 512)
+    sweet_knn_search_impl<512, 8>(sweet, query, n_query, rowMajorQuery, k,
+                                  outD, outI, stream);
+  else
+    sweet_knn_search_impl<1024, 8>(sweet, query, n_query, rowMajorQuery, k,
+                                   outD, outI, stream);
+}
+
+};  // namespace Selection
+};  // namespace MLCommon
@@ -20,12 +20,21 @@
 #include "cusparse_wrappers.h"
 
 #include "common/device_buffer.hpp"
+#include "selection/segmented_sort.h"
 
 #include <cusparse_v2.h>
 
+#include <cub/cub.cuh>
+
 #include <thrust/device_ptr.h>
 #include <thrust/device_vector.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <thrust/reduce.h>
 #include <thrust/scan.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/tuple.h>
 
 #include <cuda_runtime.h>
 #include "cuda_utils.h"
@@ -169,7 +178,8 @@ class COO {
   /**
     * @brief Send human-readable state information to output stream
     */
-  friend std::ostream &operator<<(std::ostream &out, const COO<T> &c) {
+  friend std::ostream &operator<<(std::ostream &out,
+                                  const COO<T, Index_Type> &c) {
     if (c.validate_size() && c.validate_mem()) {
       cudaStream_t stream;
       cudaStreamCreate(&stream);
@@ -194,7 +204,7 @@ class COO {
     * @param n_rows: number of rows in the dense matrix
     * @param n_cols: number of columns in the dense matrix
     */
-  void setSize(int n_rows, int n_cols) {
+  void setSize(Index_Type n_rows, Index_Type n_cols) {
     this->n_rows = n_rows;
     this->n_cols = n_cols;
   }
@@ -203,7 +213,7 @@ class COO {
     * @brief Set the number of rows and cols for a square dense matrix
     * @param n: number of rows and cols
     */
-  void setSize(int n) {
+  void setSize(Index_Type n) {
     this->n_rows = n;
     this->n_cols = n;
   }
@@ -214,7 +224,7 @@ class COO {
     * @param init: should values be initialized to 0?
     * @param stream: CUDA stream to use
     */
-  void allocate(int nnz, bool init, cudaStream_t stream) {
+  void allocate(Index_Type nnz, bool init, cudaStream_t stream) {
     this->allocate(nnz, 0, init, stream);
   }
 
@@ -225,7 +235,8 @@ class COO {
     * @param init: should values be initialized to 0?
     * @param stream: CUDA stream to use
     */
-  void allocate(int nnz, int size, bool init, cudaStream_t stream) {
+  void allocate(Index_Type nnz, Index_Type size, bool init,
+                cudaStream_t stream) {
     this->allocate(nnz, size, size, init, stream);
   }
 
@@ -237,8 +248,8 @@ class COO {
     * @param init: should values be initialized to 0?
     * @param stream: stream to use for init
     */
-  void allocate(int nnz, int n_rows, int n_cols, bool init,
-                cudaStream_t stream) {
+  void allocate(Index_Type nnz, Index_Type n_rows, Index_Type n_cols,
+                bool init, cudaStream_t stream) {
     this->n_rows = n_rows;
     this->n_cols = n_cols;
     this->nnz = nnz;
@@ -295,6 +306,27 @@ void coo_sort(int m, int n, int nnz, int *rows, int *cols, T *vals,
   CUSPARSE_CHECK(cusparseDestroy(handle));
 }
 
+/**
+ * @brief Sorts the arrays that comprise the coo matrix by row, then by
+ * column, for the index types cuSPARSE does not support (64-bit)
+ *
+ * @param m number of rows in coo matrix
+ * @param n number of cols in coo matrix
+ * @param rows rows array from coo matrix
+ * @param cols cols array from coo matrix
+ * @param vals vals array from coo matrix
+ * @param alloc device allocator for temporary buffers
+ * @param stream: cuda stream to use
+ */
+template <typename T, typename Index_>
+void coo_sort(Index_ m, Index_ n, Index_ nnz, Index_ *rows, Index_ *cols,
+              T *vals, std::shared_ptr<deviceAllocator> d_alloc,
+              cudaStream_t stream) {
+  auto keys = thrust::make_zip_iterator(thrust::make_tuple(rows, cols));
+  thrust::sort_by_key(thrust::cuda::par.on(stream), keys, keys + nnz, vals);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
 /**
  * @brief Sort the underlying COO arrays by row
  * @tparam T: the type name of the underlying value array
@@ -302,26 +334,27 @@ void coo_sort(int m, int n, int nnz, int *rows, int *cols, T *vals,
  * @param alloc device allocator for temporary buffers
  * @param stream: the cuda stream to use
  */
-template <typename T>
-void coo_sort(COO<T> *const in, std::shared_ptr<deviceAllocator> d_alloc,
-              cudaStream_t stream) {
+template <typename T, typename Index_ = int>
+void coo_sort(COO<T, Index_> *const in,
+              std::shared_ptr<deviceAllocator> d_alloc, cudaStream_t stream) {
   coo_sort<T>(in->n_rows, in->n_cols, in->nnz, in->rows(), in->cols(),
               in->vals(), d_alloc, stream);
 }
 
-template <int TPB_X, typename T>
-__global__ void coo_remove_zeros_kernel(const int *rows, const int *cols,
-                                        const T *vals, int nnz, int *crows,
-                                        int *ccols, T *cvals, int *ex_scan,
-                                        int *cur_ex_scan, int m) {
-  int row = (blockIdx.x * TPB_X) + threadIdx.x;
+template <int TPB_X, typename T, typename Index_ = int>
+__global__ void coo_remove_zeros_kernel(const Index_ *rows, const Index_ *cols,
+                                        const T *vals, Index_ nnz,
+                                        Index_ *crows, Index_ *ccols, T *cvals,
+                                        Index_ *ex_scan, Index_ *cur_ex_scan,
+                                        Index_ m) {
+  Index_ row = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
 
   if (row < m) {
-    int start = cur_ex_scan[row];
-    int stop = MLCommon::Sparse::get_stop_idx(row, m, nnz, cur_ex_scan);
-    int cur_out_idx = ex_scan[row];
+    Index_ start = cur_ex_scan[row];
+    Index_ stop = MLCommon::Sparse::get_stop_idx(row, m, nnz, cur_ex_scan);
+    Index_ cur_out_idx = ex_scan[row];
 
-    for (int idx = start; idx < stop; idx++) {
+    for (Index_ idx = start; idx < stop; idx++) {
       if (vals[idx] != 0.0) {
         crows[cur_out_idx] = rows[idx];
         ccols[cur_out_idx] = cols[idx];
@@ -332,19 +365,21 @@ __global__ void coo_remove_zeros_kernel(const int *rows, const int *cols,
   }
 }
 
-template <int TPB_X, typename T>
-__global__ void coo_remove_scalar_kernel(const int *rows, const int *cols,
-                                         const T *vals, int nnz, int *crows,
-                                         int *ccols, T *cvals, int *ex_scan,
-                                         int *cur_ex_scan, int m, T scalar) {
-  int row = (blockIdx.x * TPB_X) + threadIdx.x;
+template <int TPB_X, typename T, typename Index_ = int>
+__global__ void coo_remove_scalar_kernel(const Index_ *rows, const Index_ *cols,
+                                         const T *vals, Index_ nnz,
+                                         Index_ *crows, Index_ *ccols,
+                                         T *cvals, Index_ *ex_scan,
+                                         Index_ *cur_ex_scan, Index_ m,
+                                         T scalar) {
+  Index_ row = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
 
   if (row < m) {
-    int start = cur_ex_scan[row];
-    int stop = MLCommon::Sparse::get_stop_idx(row, m, nnz, cur_ex_scan);
-    int cur_out_idx = ex_scan[row];
+    Index_ start = cur_ex_scan[row];
+    Index_ stop = MLCommon::Sparse::get_stop_idx(row, m, nnz, cur_ex_scan);
+    Index_ cur_out_idx = ex_scan[row];
 
-    for (int idx = start; idx < stop; idx++) {
+    for (Index_ idx = start; idx < stop; idx++) {
       if (vals[idx] != scalar) {
         crows[cur_out_idx] = rows[idx];
         ccols[cur_out_idx] = cols[idx];
@@ -364,11 +399,12 @@ __global__ void coo_remove_scalar_kernel(const int *rows, const int *cols,
  * @param nnz the size of the rows array
  * @param results array to place results
  */
-template <int TPB_X>
-__global__ void coo_row_count_kernel(const int *rows, int nnz, int *results) {
-  int row = (blockIdx.x * TPB_X) + threadIdx.x;
+template <int TPB_X, typename Index_ = int>
+__global__ void coo_row_count_kernel(const Index_ *rows, Index_ nnz,
+                                     Index_ *results) {
+  Index_ row = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
   if (row < nnz) {
-    atomicAdd(results + rows[row], 1);
+    atomic_add_index(results + rows[row], Index_(1));
   }
 }
 
@@ -380,13 +416,13 @@ __global__ void coo_row_count_kernel(const int *rows, int nnz, int *results) {
  * @param results: output result array
  * @param stream: cuda stream to use
  */
-template <int TPB_X>
-void coo_row_count(const int *rows, int nnz, int *results,
+template <int TPB_X, typename Index_ = int>
+void coo_row_count(const Index_ *rows, Index_ nnz, Index_ *results,
                    cudaStream_t stream) {
-  dim3 grid_rc(MLCommon::ceildiv(nnz, TPB_X), 1, 1);
+  dim3 grid_rc(MLCommon::ceildiv(nnz, Index_(TPB_X)), 1, 1);
   dim3 blk_rc(TPB_X, 1, 1);
 
-  coo_row_count_kernel<TPB_X>
+  coo_row_count_kernel<TPB_X, Index_>
     <<<grid_rc, blk_rc, 0, stream>>>(rows, nnz, results);
   CUDA_CHECK(cudaGetLastError());
 }
@@ -399,31 +435,32 @@ void coo_row_count(const int *rows, int nnz, int *results,
  * @param results: output array with row counts (size=in->n_rows)
  * @param stream: cuda stream to use
  */
-template <int TPB_X, typename T>
-void coo_row_count(COO<T> *in, int *results, cudaStream_t stream) {
-  dim3 grid_rc(MLCommon::ceildiv(in->nnz, TPB_X), 1, 1);
+template <int TPB_X, typename T, typename Index_ = int>
+void coo_row_count(COO<T, Index_> *in, Index_ *results, cudaStream_t stream) {
+  dim3 grid_rc(MLCommon::ceildiv(in->nnz, Index_(TPB_X)), 1, 1);
   dim3 blk_rc(TPB_X, 1, 1);
 
-  coo_row_count_kernel<TPB_X>
+  coo_row_count_kernel<TPB_X, Index_>
     <<<grid_rc, blk_rc, 0, stream>>>(in->rows(), in->nnz, results);
   CUDA_CHECK(cudaGetLastError());
 }
 
-template <int TPB_X, typename T>
-__global__ void coo_row_count_nz_kernel(const int *rows, const T *vals, int nnz,
-                                        int *results) {
-  int row = (blockIdx.x * TPB_X) + threadIdx.x;
+template <int TPB_X, typename T, typename Index_ = int>
+__global__ void coo_row_count_nz_kernel(const Index_ *rows, const T *vals,
+                                        Index_ nnz, Index_ *results) {
+  Index_ row = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
   if (row < nnz && vals[row] != 0.0) {
-    atomicAdd(results + rows[row], 1);
+    atomic_add_index(results + rows[row], Index_(1));
   }
 }
 
-template <int TPB_X, typename T>
-__global__ void coo_row_count_scalar_kernel(const int *rows, const T *vals,
-                                            int nnz, T scalar, int *results) {
-  int row = (blockIdx.x * TPB_X) + threadIdx.x;
+template <int TPB_X, typename T, typename Index_ = int>
+__global__ void coo_row_count_scalar_kernel(const Index_ *rows, const T *vals,
+                                            Index_ nnz, T scalar,
+                                            Index_ *results) {
+  Index_ row = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
   if (row < nnz && vals[row] != scalar) {
-    atomicAdd(results + rows[row], 1);
+    atomic_add_index(results + rows[row], Index_(1));
   }
 }
 
@@ -436,14 +473,15 @@ __global__ void coo_row_count_scalar_kernel(const int *rows, const T *vals,
  * @param results: output row counts
  * @param stream: cuda stream to use
  */
-template <int TPB_X, typename T>
-void coo_row_count_scalar(COO<T> *in, T scalar, int *results,
+template <int TPB_X, typename T, typename Index_ = int>
+void coo_row_count_scalar(COO<T, Index_> *in, T scalar, Index_ *results,
                           cudaStream_t stream) {
-  dim3 grid_rc(MLCommon::ceildiv(in->nnz, TPB_X), 1, 1);
+  dim3 grid_rc(MLCommon::ceildiv(in->nnz, Index_(TPB_X)), 1, 1);
   dim3 blk_rc(TPB_X, 1, 1);
 
-  coo_row_count_scalar_kernel<TPB_X, T><<<grid_rc, blk_rc, 0, stream>>>(
-    in->rows(), in->vals(), in->nnz, scalar, results);
+  coo_row_count_scalar_kernel<TPB_X, T, Index_>
+    <<<grid_rc, blk_rc, 0, stream>>>(in->rows(), in->vals(), in->nnz, scalar,
+                                     results);
   CUDA_CHECK(cudaGetLastError());
 }
 
@@ -459,13 +497,13 @@ void coo_row_count_scalar(COO<T> *in, T scalar, int *results,
  * @param results: output row counts
  * @param stream: cuda stream to use
  */
-template <int TPB_X, typename T>
-void coo_row_count_scalar(const int *rows, const T *vals, int nnz, T scalar,
-                          int *results, cudaStream_t stream = 0) {
-  dim3 grid_rc(MLCommon::ceildiv(nnz, TPB_X), 1, 1);
+template <int TPB_X, typename T, typename Index_ = int>
+void coo_row_count_scalar(const Index_ *rows, const T *vals, Index_ nnz,
+                          T scalar, Index_ *results, cudaStream_t stream = 0) {
+  dim3 grid_rc(MLCommon::ceildiv(nnz, Index_(TPB_X)), 1, 1);
   dim3 blk_rc(TPB_X, 1, 1);
 
-  coo_row_count_scalar_kernel<TPB_X, T>
+  coo_row_count_scalar_kernel<TPB_X, T, Index_>
     <<<grid_rc, blk_rc, 0, stream>>>(rows, vals, nnz, scalar, results);
   CUDA_CHECK(cudaGetLastError());
 }
@@ -481,13 +519,13 @@ void coo_row_count_scalar(const int *rows, const T *vals, int nnz, T scalar,
  * @param results: output row counts
  * @param stream: cuda stream to use
  */
-template <int TPB_X, typename T>
-void coo_row_count_nz(const int *rows, const T *vals, int nnz, int *results,
-                      cudaStream_t stream) {
-  dim3 grid_rc(MLCommon::ceildiv(nnz, TPB_X), 1, 1);
+template <int TPB_X, typename T, typename Index_ = int>
+void coo_row_count_nz(const Index_ *rows, const T *vals, Index_ nnz,
+                      Index_ *results, cudaStream_t stream) {
+  dim3 grid_rc(MLCommon::ceildiv(nnz, Index_(TPB_X)), 1, 1);
   dim3 blk_rc(TPB_X, 1, 1);
 
-  coo_row_count_nz_kernel<TPB_X, T>
+  coo_row_count_nz_kernel<TPB_X, T, Index_>
     <<<grid_rc, blk_rc, 0, stream>>>(rows, vals, nnz, results);
   CUDA_CHECK(cudaGetLastError());
 }
@@ -500,12 +538,13 @@ void coo_row_count_nz(const int *rows, const T *vals, int nnz, int *results,
  * @param results: output row counts
  * @param stream: cuda stream to use
  */
-template <int TPB_X, typename T>
-void coo_row_count_nz(COO<T> *in, int *results, cudaStream_t stream) {
-  dim3 grid_rc(MLCommon::ceildiv(in->nnz, TPB_X), 1, 1);
+template <int TPB_X, typename T, typename Index_ = int>
+void coo_row_count_nz(COO<T, Index_> *in, Index_ *results,
+                      cudaStream_t stream) {
+  dim3 grid_rc(MLCommon::ceildiv(in->nnz, Index_(TPB_X)), 1, 1);
   dim3 blk_rc(TPB_X, 1, 1);
 
-  coo_row_count_nz_kernel<TPB_X, T>
+  coo_row_count_nz_kernel<TPB_X, T, Index_>
     <<<grid_rc, blk_rc, 0, stream>>>(in->rows(), in->vals(), in->nnz, results);
   CUDA_CHECK(cudaGetLastError());
 }
@@ -527,36 +566,38 @@ void coo_row_count_nz(COO<T> *in, int *results, cudaStream_t stream) {
  * @param alloc device allocator for temporary buffers
  * @param stream: cuda stream to use
  */
-template <int TPB_X, typename T>
-void coo_remove_scalar(const int *rows, const int *cols, const T *vals, int nnz,
-                       int *crows, int *ccols, T *cvals, int *cnnz,
-                       int *cur_cnnz, T scalar, int n,
+template <int TPB_X, typename T, typename Index_ = int>
+void coo_remove_scalar(const Index_ *rows, const Index_ *cols, const T *vals,
+                       Index_ nnz, Index_ *crows, Index_ *ccols, T *cvals,
+                       Index_ *cnnz, Index_ *cur_cnnz, T scalar, Index_ n,
                        std::shared_ptr<deviceAllocator> d_alloc,
                        cudaStream_t stream) {
-  device_buffer<int> ex_scan(d_alloc, stream, n);
-  device_buffer<int> cur_ex_scan(d_alloc, stream, n);
+  device_buffer<Index_> ex_scan(d_alloc, stream, n);
+  device_buffer<Index_> cur_ex_scan(d_alloc, stream, n);
 
-  CUDA_CHECK(cudaMemsetAsync(ex_scan.data(), 0, n * sizeof(int), stream));
-  CUDA_CHECK(cudaMemsetAsync(cur_ex_scan.data(), 0, n * sizeof(int), stream));
+  CUDA_CHECK(cudaMemsetAsync(ex_scan.data(), 0, n * sizeof(Index_), stream));
+  CUDA_CHECK(
+    cudaMemsetAsync(cur_ex_scan.data(), 0, n * sizeof(Index_), stream));
 
-  thrust::device_ptr<int> dev_cnnz = thrust::device_pointer_cast(cnnz);
-  thrust::device_ptr<int> dev_ex_scan =
+  thrust::device_ptr<Index_> dev_cnnz = thrust::device_pointer_cast(cnnz);
+  thrust::device_ptr<Index_> dev_ex_scan =
     thrust::device_pointer_cast(ex_scan.data());
   thrust::exclusive_scan(thrust::cuda::par.on(stream), dev_cnnz, dev_cnnz + n,
                          dev_ex_scan);
   CUDA_CHECK(cudaPeekAtLastError());
 
-  thrust::device_ptr<int> dev_cur_cnnz = thrust::device_pointer_cast(cur_cnnz);
-  thrust::device_ptr<int> dev_cur_ex_scan =
+  thrust::device_ptr<Index_> dev_cur_cnnz =
+    thrust::device_pointer_cast(cur_cnnz);
+  thrust::device_ptr<Index_> dev_cur_ex_scan =
     thrust::device_pointer_cast(cur_ex_scan.data());
   thrust::exclusive_scan(thrust::cuda::par.on(stream), dev_cur_cnnz,
                          dev_cur_cnnz + n, dev_cur_ex_scan);
   CUDA_CHECK(cudaPeekAtLastError());
 
-  dim3 grid(ceildiv(n, TPB_X), 1, 1);
+  dim3 grid(ceildiv(n, Index_(TPB_X)), 1, 1);
   dim3 blk(TPB_X, 1, 1);
 
-  coo_remove_scalar_kernel<TPB_X><<<grid, blk, 0, stream>>>(
+  coo_remove_scalar_kernel<TPB_X, T, Index_><<<grid, blk, 0, stream>>>(
     rows, cols, vals, nnz, crows, ccols, cvals, dev_ex_scan.get(),
     dev_cur_ex_scan.get(), n, scalar);
   CUDA_CHECK(cudaPeekAtLastError());
@@ -571,17 +612,17 @@ void coo_remove_scalar(const int *rows, const int *cols, const T *vals, int nnz,
  * @param alloc device allocator for temporary buffers
  * @param stream: cuda stream to use
  */
-template <int TPB_X, typename T>
-void coo_remove_scalar(COO<T> *in, COO<T> *out, T scalar,
+template <int TPB_X, typename T, typename Index_ = int>
+void coo_remove_scalar(COO<T, Index_> *in, COO<T, Index_> *out, T scalar,
                        std::shared_ptr<deviceAllocator> d_alloc,
                        cudaStream_t stream) {
-  device_buffer<int> row_count_nz(d_alloc, stream, in->n_rows);
-  device_buffer<int> row_count(d_alloc, stream, in->n_rows);
+  device_buffer<Index_> row_count_nz(d_alloc, stream, in->n_rows);
+  device_buffer<Index_> row_count(d_alloc, stream, in->n_rows);
 
+  CUDA_CHECK(cudaMemsetAsync(row_count_nz.data(), 0,
+                             in->n_rows * sizeof(Index_), stream));
   CUDA_CHECK(
-    cudaMemsetAsync(row_count_nz.data(), 0, in->n_rows * sizeof(int), stream));
-  CUDA_CHECK(
-    cudaMemsetAsync(row_count.data(), 0, in->n_rows * sizeof(int), stream));
+    cudaMemsetAsync(row_count.data(), 0, in->n_rows * sizeof(Index_), stream));
 
   MLCommon::Sparse::coo_row_count<TPB_X>(in->rows(), in->nnz, row_count.data(),
                                          stream);
@@ -591,17 +632,17 @@ void coo_remove_scalar(COO<T> *in, COO<T> *out, T scalar,
     in->rows(), in->vals(), in->nnz, scalar, row_count_nz.data(), stream);
   CUDA_CHECK(cudaPeekAtLastError());
 
-  thrust::device_ptr<int> d_row_count_nz =
+  thrust::device_ptr<Index_> d_row_count_nz =
     thrust::device_pointer_cast(row_count_nz.data());
-  int out_nnz = thrust::reduce(thrust::cuda::par.on(stream), d_row_count_nz,
-                               d_row_count_nz + in->n_rows);
+  Index_ out_nnz = thrust::reduce(thrust::cuda::par.on(stream),
+                                  d_row_count_nz, d_row_count_nz + in->n_rows);
 
   out->allocate(out_nnz, in->n_rows, in->n_cols, stream);
 
-  coo_remove_scalar<TPB_X, T>(in->rows(), in->cols(), in->vals(), in->nnz,
-                              out->rows(), out->cols(), out->vals(),
-                              row_count_nz.data(), row_count.data(), scalar,
-                              in->n_rows, d_alloc, stream);
+  coo_remove_scalar<TPB_X, T, Index_>(
+    in->rows(), in->cols(), in->vals(), in->nnz, out->rows(), out->cols(),
+    out->vals(), row_count_nz.data(), row_count.data(), scalar, in->n_rows,
+    d_alloc, stream);
   CUDA_CHECK(cudaPeekAtLastError());
 }
 
@@ -613,20 +654,20 @@ void coo_remove_scalar(COO<T> *in, COO<T> *out, T scalar,
  * @param alloc device allocator for temporary buffers
  * @param stream: cuda stream to use
  */
-template <int TPB_X, typename T>
-void coo_remove_zeros(COO<T> *in, COO<T> *out,
+template <int TPB_X, typename T, typename Index_ = int>
+void coo_remove_zeros(COO<T, Index_> *in, COO<T, Index_> *out,
                       std::shared_ptr<deviceAllocator> d_alloc,
                       cudaStream_t stream) {
-  coo_remove_scalar<TPB_X, T>(in, out, T(0.0), d_alloc, stream);
+  coo_remove_scalar<TPB_X, T, Index_>(in, out, T(0.0), d_alloc, stream);
 }
 
-template <int TPB_X, typename T>
+template <int TPB_X, typename T, typename Index_ = int>
 __global__ void from_knn_graph_kernel(const long *knn_indices,
-                                      const T *knn_dists, int m, int k,
-                                      int *rows, int *cols, T *vals) {
-  int row = (blockIdx.x * TPB_X) + threadIdx.x;
+                                      const T *knn_dists, Index_ m, Index_ k,
+                                      Index_ *rows, Index_ *cols, T *vals) {
+  Index_ row = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
   if (row < m) {
-    for (int i = 0; i < k; i++) {
+    for (Index_ i = 0; i < k; i++) {
       rows[row * k + i] = row;
       cols[row * k + i] = knn_indices[row * k + i];
       vals[row * k + i] = knn_dists[row * k + i];
@@ -645,14 +686,15 @@ __global__ void from_knn_graph_kernel(const long *knn_indices,
  * @param rows: output COO row array
  * @param cols: output COO col array
  * @param vals: output COO val array
+ * @param stream: CUDA stream to use
  */
-template <typename T>
-void from_knn(const long *knn_indices, const T *knn_dists, int m, int k,
-              int *rows, int *cols, T *vals) {
-  dim3 grid(ceildiv(m, 32), 1, 1);
+template <typename T, typename Index_ = int>
+void from_knn(const long *knn_indices, const T *knn_dists, Index_ m, Index_ k,
+              Index_ *rows, Index_ *cols, T *vals, cudaStream_t stream = 0) {
+  dim3 grid(ceildiv(m, Index_(32)), 1, 1);
   dim3 blk(32, 1, 1);
-  from_knn_graph_kernel<32, T>
-    <<<grid, blk>>>(knn_indices, knn_dists, m, k, rows, cols, vals);
+  from_knn_graph_kernel<32, T, Index_>
+    <<<grid, blk, 0, stream>>>(knn_indices, knn_dists, m, k, rows, cols, vals);
   CUDA_CHECK(cudaGetLastError());
 }
 
@@ -664,12 +706,13 @@ void from_knn(const long *knn_indices, const T *knn_dists, int m, int k,
  * @param out: The output COO graph from the KNN matrices
  * @param stream: CUDA stream to use
  */
-template <typename T>
-void from_knn(const long *knn_indices, const T *knn_dists, int m, int k,
-              COO<T> *out, cudaStream_t stream) {
+template <typename T, typename Index_ = int>
+void from_knn(const long *knn_indices, const T *knn_dists, Index_ m, Index_ k,
+              COO<T, Index_> *out, cudaStream_t stream) {
   out->allocate(m * k, m, m, stream);
 
-  from_knn(knn_indices, knn_dists, m, k, out->rows(), out->cols(), out->vals());
+  from_knn(knn_indices, knn_dists, m, k, out->rows(), out->cols(), out->vals(),
+           stream);
 }
 
 /**
@@ -683,7 +726,7 @@ void from_knn(const long *knn_indices, const T *knn_dists, int m, int k,
  * @param stream: cuda stream to use
  */
 template <typename T>
-void sorted_coo_to_csr(const T *rows, int nnz, T *row_ind, int m,
+void sorted_coo_to_csr(const T *rows, T nnz, T *row_ind, T m,
                        std::shared_ptr<deviceAllocator> d_alloc,
                        cudaStream_t stream) {
   device_buffer<T> row_counts(d_alloc, stream, m);
@@ -708,40 +751,42 @@ void sorted_coo_to_csr(const T *rows, int nnz, T *row_ind, int m,
  * @param alloc device allocator for temporary buffers
  * @param stream: cuda stream to use
  */
-template <typename T>
-void sorted_coo_to_csr(COO<T> *coo, int *row_ind,
+template <typename T, typename Index_ = int>
+void sorted_coo_to_csr(COO<T, Index_> *coo, Index_ *row_ind,
                        std::shared_ptr<deviceAllocator> d_alloc,
                        cudaStream_t stream) {
   sorted_coo_to_csr(coo->rows(), coo->nnz, row_ind, coo->n_rows, d_alloc,
                     stream);
 }
 
-template <int TPB_X, typename T, typename Lambda>
-__global__ void coo_symmetrize_kernel(int *row_ind, int *rows, int *cols,
-                                      T *vals, int *orows, int *ocols, T *ovals,
-                                      int n, int cnnz, Lambda reduction_op) {
-  int row = (blockIdx.x * TPB_X) + threadIdx.x;
+template <int TPB_X, typename T, typename Lambda, typename Index_ = int>
+__global__ void coo_symmetrize_kernel(Index_ *row_ind, Index_ *rows,
+                                      Index_ *cols, T *vals, Index_ *orows,
+                                      Index_ *ocols, T *ovals, Index_ n,
+                                      Index_ cnnz, Lambda reduction_op) {
+  Index_ row = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
 
   if (row < n) {
-    int start_idx = row_ind[row];  // each thread processes one row
-    int stop_idx = MLCommon::Sparse::get_stop_idx(row, n, cnnz, row_ind);
+    Index_ start_idx = row_ind[row];  // each thread processes one row
+    Index_ stop_idx = MLCommon::Sparse::get_stop_idx(row, n, cnnz, row_ind);
 
-    int row_nnz = 0;
-    int out_start_idx = start_idx * 2;
+    Index_ row_nnz = 0;
+    Index_ out_start_idx = start_idx * 2;
 
-    for (int idx = 0; idx < stop_idx - start_idx; idx++) {
-      int cur_row = rows[idx + start_idx];
-      int cur_col = cols[idx + start_idx];
+    for (Index_ idx = 0; idx < stop_idx - start_idx; idx++) {
+      Index_ cur_row = rows[idx + start_idx];
+      Index_ cur_col = cols[idx + start_idx];
       T cur_val = vals[idx + start_idx];
 
-      int lookup_row = cur_col;
-      int t_start = row_ind[lookup_row];  // Start at
-      int t_stop = MLCommon::Sparse::get_stop_idx(lookup_row, n, cnnz, row_ind);
+      Index_ lookup_row = cur_col;
+      Index_ t_start = row_ind[lookup_row];  // Start at
+      Index_ t_stop =
+        MLCommon::Sparse::get_stop_idx(lookup_row, n, cnnz, row_ind);
 
       T transpose = 0.0;
 
       bool found_match = false;
-      for (int t_idx = t_start; t_idx < t_stop; t_idx++) {
+      for (Index_ t_idx = t_start; t_idx < t_stop; t_idx++) {
         // If we find a match, let's get out of the loop. We won't
         // need to modify the transposed value, since that will be
         // done in a different thread.
@@ -793,23 +838,23 @@ __global__ void coo_symmetrize_kernel(int *row_ind, int *rows, int *cols,
  * @param alloc device allocator for temporary buffers
  * @param stream: cuda stream to use
  */
-template <int TPB_X, typename T, typename Lambda>
-void coo_symmetrize(COO<T> *in, COO<T> *out,
+template <int TPB_X, typename T, typename Lambda, typename Index_ = int>
+void coo_symmetrize(COO<T, Index_> *in, COO<T, Index_> *out,
                     Lambda reduction_op,  // two-argument reducer
                     std::shared_ptr<deviceAllocator> d_alloc,
                     cudaStream_t stream) {
-  dim3 grid(ceildiv(in->n_rows, TPB_X), 1, 1);
+  dim3 grid(ceildiv(in->n_rows, Index_(TPB_X)), 1, 1);
   dim3 blk(TPB_X, 1, 1);
 
   ASSERT(!out->validate_mem(), "Expecting unallocated COO for output");
 
-  device_buffer<int> in_row_ind(d_alloc, stream, in->n_rows);
+  device_buffer<Index_> in_row_ind(d_alloc, stream, in->n_rows);
 
   sorted_coo_to_csr(in, in_row_ind.data(), d_alloc, stream);
 
   out->allocate(in->nnz * 2, in->n_rows, in->n_cols, stream);
 
-  coo_symmetrize_kernel<TPB_X, T><<<grid, blk, 0, stream>>>(
+  coo_symmetrize_kernel<TPB_X, T, Lambda, Index_><<<grid, blk, 0, stream>>>(
     in_row_ind.data(), in->rows(), in->cols(), in->vals(), out->rows(),
     out->cols(), out->vals(), in->n_rows, in->nnz, reduction_op);
   CUDA_CHECK(cudaPeekAtLastError());
@@ -971,5 +1016,374 @@ void from_knn_symmetrize_matrix(const long *restrict knn_indices,
   CUDA_CHECK(cudaPeekAtLastError());
 }
 
+/**
+ * @brief Finds the edge (row, col) among the kNN edges of row, whose keys
+ * row * n + col are sorted within each row of k.
+ *
+ * @param keys: Input sorted knn keys(n, k)
+ * @param vals: Input knn values(n, k), in the order of keys
+ * @param row: Row of the edge
+ * @param col: Col of the edge
+ * @param n: Number of rows
+ * @param k: Number of n_neighbors
+ * @param val: Output value of the edge, if found
+ * @return whether the edge exists
+ */
+template <typename math_t>
+__device__ bool find_knn_edge(const long *restrict keys,
+                              const math_t *restrict vals, const int row,
+                              const long col, const int n, const int k,
+                              math_t *val) {
+  const long key = row * long(n) + col;
+  const int end = (row + 1) * k;
+  int lo = row * k, hi = end;
+  while (lo < hi) {
+    const int mid = (lo + hi) / 2;
+    if (keys[mid] < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo == end || keys[lo] != key) return false;
+  *val = vals[lo];
+  return true;
+}
+
+/**
+ * @brief Counts, for every row, the edges of data.T missing from data.
+ *
+ * @param keys: Input sorted knn keys(n, k)
+ * @param vals: Input knn values(n, k), in the order of keys
+ * @param n: Number of rows
+ * @param k: Number of n_neighbors
+ * @param extra: Output count of the transposed edges of each row(n)
+ */
+template <typename math_t>
+__global__ static void symmetric_merged_find_size(const long *restrict keys,
+                                                  const math_t *restrict vals,
+                                                  const int n, const int k,
+                                                  int *restrict extra) {
+  const int index = (blockIdx.x * blockDim.x) + threadIdx.x;
+  if (index >= n * k) return;
+  const int row = index / k;
+  const long col = keys[index] - row * long(n);
+  math_t trans;
+  if (!find_knn_edge(keys, vals, col, row, n, k, &trans))
+    atomicAdd(&extra[col], 1);
+}
+
+/**
+ * @brief Writes data + data.T with one entry per edge. Row i holds its k
+ * edges first, summed with their transposes, then the transposed edges which
+ * only exist in data.T.
+ *
+ * @param keys: Input sorted knn keys(n, k)
+ * @param vals: Input knn values(n, k), in the order of keys
+ * @param extra_offsets: Input exclusive scan of the extra edges of the rows
+ * @param extra_fill: Input zeroed counters of the extra edges written(n)
+ * @param VAL: Output values for data + data.T
+ * @param COL: Output column indices for data + data.T
+ * @param ROW: Output row indices for data + data.T
+ * @param n: Number of rows
+ * @param k: Number of n_neighbors
+ */
+template <typename math_t>
+__global__ static void symmetric_merged_sum(
+  const long *restrict keys, const math_t *restrict vals,
+  const int *restrict extra_offsets, int *restrict extra_fill,
+  math_t *restrict VAL, int *restrict COL, int *restrict ROW, const int n,
+  const int k) {
+  const int index = (blockIdx.x * blockDim.x) + threadIdx.x;
+  if (index >= n * k) return;
+  const int row = index / k;
+  const int col = keys[index] - row * long(n);
+  const math_t val = vals[index];
+
+  math_t trans;
+  const int original = index + extra_offsets[row];
+  ROW[original] = row;
+  COL[original] = col;
+  if (find_knn_edge(keys, vals, col, row, n, k, &trans)) {
+    VAL[original] = val + trans;
+  } else {
+    VAL[original] = val;
+    const int transpose =
+      (col + 1) * k + extra_offsets[col] + atomicAdd(&extra_fill[col], 1);
+    VAL[transpose] = val;
+    ROW[transpose] = col;
+    COL[transpose] = row;
+  }
+}
+
+/**
+ * @brief The offsets of the rows of data + data.T, written by
+ * symmetric_merged_sum.
+ */
+__global__ static void symmetric_merged_row_ind(
+  const int *restrict extra_offsets, int *restrict row_ind, const int n,
+  const int k, const int nnz) {
+  const int i = (blockIdx.x * blockDim.x) + threadIdx.x;
+  if (i < n) row_ind[i] = i * k + extra_offsets[i];
+  if (i == n) row_ind[n] = nnz;
+}
+
+/**
+ * @brief Perform data + data.T on raw KNN data, merging the edges found in
+ * both into a single entry, unlike from_knn_symmetrize_matrix which keeps
+ * them as 2 * n * k entries. The result is built once, in CSR order:
+ * (1) Sort the neighbors of every row by index
+ * (2) Count the transposed edges missing from every row, by binary search
+ * (3) Scan the counts into the row offsets and allocate the exact space
+ * (4) Write every edge, and its transpose if it is missing
+ *
+ * @param knn_indices: Input knn indices(n, k)
+ * @param knn_dists: Input knn distances(n, k)
+ * @param n: Number of rows
+ * @param k: Number of n_neighbors
+ * @param out: Output COO Matrix class, whose entries are grouped by row
+ * @param stream: Input cuda stream
+ * @param d_alloc device allocator for temporary buffers
+ * @param row_ind: Optional output row offsets of out as a CSR matrix(n + 1)
+ */
+template <typename math_t, int TPB_X = 256>
+void from_knn_symmetrize_merged(const long *restrict knn_indices,
+                                const math_t *restrict knn_dists, const int n,
+                                const int k, COO<math_t> *out,
+                                cudaStream_t stream,
+                                std::shared_ptr<deviceAllocator> d_alloc,
+                                int *row_ind = nullptr) {
+  const int nk = n * k;
+  auto policy = thrust::cuda::par.on(stream);
+
+  // (1) Sort the neighbors of every row by index, as row * n + col keys
+  device_buffer<long> keys(d_alloc, stream, nk);
+  device_buffer<math_t> vals(d_alloc, stream, nk);
+  copyAsync(vals.data(), knn_dists, nk, stream);
+  thrust::transform(policy, thrust::counting_iterator<int>(0),
+                    thrust::counting_iterator<int>(nk), knn_indices,
+                    keys.data(), [=] __device__(int index, long col) {
+                      return (index / k) * long(n) + col;
+                    });
+  thrust::sort_by_key(policy, keys.data(), keys.data() + nk, vals.data());
+
+  // (2) Count the transposed edges missing from every row
+  device_buffer<int> extra(d_alloc, stream, n);
+  CUDA_CHECK(cudaMemsetAsync(extra.data(), 0, sizeof(int) * n, stream));
+  symmetric_merged_find_size<<<ceildiv(nk, TPB_X), TPB_X, 0, stream>>>(
+    keys.data(), vals.data(), n, k, extra.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  // (3) Scan them and allocate the exact space
+  device_buffer<int> extra_offsets(d_alloc, stream, n);
+  thrust::exclusive_scan(policy, extra.data(), extra.data() + n,
+                         extra_offsets.data());
+  const int n_extra = thrust::reduce(policy, extra.data(), extra.data() + n);
+  const int nnz = nk + n_extra;
+  out->allocate(nnz, n, n, stream);
+
+  // (4) Write every edge, and its transpose if it is missing
+  CUDA_CHECK(cudaMemsetAsync(extra.data(), 0, sizeof(int) * n, stream));
+  symmetric_merged_sum<<<ceildiv(nk, TPB_X), TPB_X, 0, stream>>>(
+    keys.data(), vals.data(), extra_offsets.data(), extra.data(), out->vals(),
+    out->cols(), out->rows(), n, k);
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  if (row_ind != nullptr) {
+    symmetric_merged_row_ind<<<ceildiv(n + 1, TPB_X), TPB_X, 0, stream>>>(
+      extra_offsets.data(), row_ind, n, k, nnz);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+}
+
+/**
+ * @brief Counts the entries of every row of A + A.T, an edge of A counting
+ * for its row and, transposed, for its column.
+ */
+template <int TPB_X, typename Index_ = int>
+__global__ void coo_symmetric_count_kernel(const Index_ *rows,
+                                           const Index_ *cols, Index_ nnz,
+                                           Index_ *counts) {
+  Index_ e = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
+  if (e < nnz) {
+    atomic_add_index(counts + rows[e], Index_(1));
+    atomic_add_index(counts + cols[e], Index_(1));
+  }
+}
+
+/**
+ * @brief Buckets the entries of A + A.T by row: each slot gets its row, its
+ * column as sort key and the index 2 * e (A) or 2 * e + 1 (A.T) of its edge.
+ */
+template <int TPB_X, typename Index_ = int>
+__global__ void coo_symmetric_bucket_kernel(const Index_ *rows,
+                                            const Index_ *cols, Index_ nnz,
+                                            Index_ *fill, Index_ *slot_rows,
+                                            Index_ *slot_cols,
+                                            Index_ *slot_edges) {
+  Index_ e = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
+  if (e < nnz) {
+    Index_ r = rows[e], c = cols[e];
+    Index_ pos = atomic_add_index(fill + r, Index_(1));
+    slot_rows[pos] = r;
+    slot_cols[pos] = c;
+    slot_edges[pos] = 2 * e;
+    pos = atomic_add_index(fill + c, Index_(1));
+    slot_rows[pos] = c;
+    slot_cols[pos] = r;
+    slot_edges[pos] = 2 * e + 1;
+  }
+}
+
+/**
+ * @brief Reduces the runs of equal (row, col) slots, sorted by column within
+ * every row, into the value of the symmetrized edge. The first slot of a run
+ * sums the values of A and of A.T in the run, applies reduction_op to them
+ * and is kept when the result is not zero.
+ */
+template <int TPB_X, typename T, typename Lambda, typename Index_ = int>
+__global__ void coo_symmetric_reduce_kernel(
+  const Index_ *slot_rows, const Index_ *slot_cols, const Index_ *slot_edges,
+  const T *vals, const Index_ *row_offsets, Index_ n_slots,
+  Lambda reduction_op, T *slot_vals, Index_ *keep, Index_ *row_counts) {
+  Index_ p = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
+  if (p >= n_slots) return;
+  Index_ row = slot_rows[p], col = slot_cols[p];
+  bool head = p == row_offsets[row] || slot_cols[p - 1] != col;
+  keep[p] = 0;
+  if (!head) return;
+  T val = 0.0, transpose = 0.0;
+  Index_ end = row_offsets[row + 1];
+  for (Index_ q = p; q < end && slot_cols[q] == col; q++) {
+    Index_ edge = slot_edges[q];
+    if (edge % 2 == 0)
+      val += vals[edge / 2];
+    else
+      transpose += vals[edge / 2];
+  }
+  T res = reduction_op(row, col, val, transpose);
+  slot_vals[p] = res;
+  if (res != 0.0) {
+    keep[p] = 1;
+    atomic_add_index(row_counts + row, Index_(1));
+  }
+}
+
+template <int TPB_X, typename T, typename Index_ = int>
+__global__ void coo_symmetric_compact_kernel(
+  const Index_ *slot_rows, const Index_ *slot_cols, const T *slot_vals,
+  const Index_ *keep, const Index_ *positions, Index_ n_slots, Index_ *orows,
+  Index_ *ocols, T *ovals) {
+  Index_ p = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
+  if (p < n_slots && keep[p]) {
+    Index_ out = positions[p];
+    orows[out] = slot_rows[p];
+    ocols[out] = slot_cols[p];
+    ovals[out] = slot_vals[p];
+  }
+}
+
+/**
+ * @brief Builds the symmetrized graph of a COO matrix A, which may be
+ * unsorted and have duplicates, in a single pipeline stage:
+ * (1) Bucket the entries of A and A.T by row (counting sort)
+ * (2) Sort every row by column with a segmented radix sort
+ * (3) Reduce every (row, col) run: the values of A and of A.T in the run are
+ *     summed (deduplicated), then combined by reduction_op
+ * (4) Compact the nonzero results into the only output allocation
+ *
+ * The output is in CSR order (sorted by row, then by column) and has no
+ * zeros, so that it replaces coo_symmetrize followed by coo_sort and
+ * coo_remove_zeros. With more than 2^31 slots (64-bit indices), the rows
+ * are sorted by a global sort on (row, col) instead, cub's segmented sort
+ * counting its items in int.
+ *
+ * @param in: Input COO matrix, square
+ * @param out: Output symmetrized COO matrix, unallocated
+ * @param reduction_op: a custom reduction function of (row, col, value of A,
+ * value of A.T), the values being 0 for a missing edge
+ * @param d_alloc device allocator for temporary buffers
+ * @param stream: cuda stream to use
+ * @param row_ind: Optional output row offsets of out as a CSR matrix(n + 1)
+ */
+template <int TPB_X, typename T, typename Lambda, typename Index_ = int>
+void coo_symmetrize_csr(COO<T, Index_> *in, COO<T, Index_> *out,
+                        Lambda reduction_op,
+                        std::shared_ptr<deviceAllocator> d_alloc,
+                        cudaStream_t stream, Index_ *row_ind = nullptr) {
+  ASSERT(!out->validate_mem(), "Expecting unallocated COO for output");
+  ASSERT(in->n_rows == in->n_cols, "Expecting a square COO matrix");
+  const Index_ n = in->n_rows, nnz = in->nnz, n_slots = 2 * nnz;
+  auto policy = thrust::cuda::par.on(stream);
+  dim3 grid_nnz(ceildiv(nnz, Index_(TPB_X)), 1, 1);
+  dim3 grid_slots(ceildiv(n_slots, Index_(TPB_X)), 1, 1);
+  dim3 blk(TPB_X, 1, 1);
+
+  // (1) Bucket the entries by row
+  device_buffer<Index_> offsets(d_alloc, stream, n + 1);
+  device_buffer<Index_> fill(d_alloc, stream, n + 1);
+  CUDA_CHECK(cudaMemsetAsync(fill.data(), 0, (n + 1) * sizeof(Index_), stream));
+  coo_symmetric_count_kernel<TPB_X, Index_><<<grid_nnz, blk, 0, stream>>>(
+    in->rows(), in->cols(), nnz, fill.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+  thrust::exclusive_scan(policy, fill.data(), fill.data() + n + 1,
+                         offsets.data());
+  copyAsync(fill.data(), offsets.data(), n + 1, stream);
+
+  device_buffer<Index_> slot_rows(d_alloc, stream, n_slots);
+  device_buffer<Index_> slot_cols(d_alloc, stream, n_slots);
+  device_buffer<Index_> slot_edges(d_alloc, stream, n_slots);
+  coo_symmetric_bucket_kernel<TPB_X, Index_><<<grid_nnz, blk, 0, stream>>>(
+    in->rows(), in->cols(), nnz, fill.data(), slot_rows.data(),
+    slot_cols.data(), slot_edges.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  // (2) Sort every row by column, on the bits of the largest column only
+  device_buffer<Index_> sorted_cols(d_alloc, stream, n_slots);
+  device_buffer<Index_> sorted_edges(d_alloc, stream, n_slots);
+  if (n_slots <= Index_(std::numeric_limits<int>::max())) {
+    int end_bit = 1;
+    while (end_bit < 8 * int(sizeof(Index_)) - 1 && (Index_(1) << end_bit) < n)
+      end_bit++;
+    Selection::segmentedSortPairs(
+      slot_cols.data(), sorted_cols.data(), slot_edges.data(),
+      sorted_edges.data(), int(n_slots), int(n), offsets.data(), d_alloc,
+      stream, false, 0, end_bit);
+  } else {
+    copyAsync(sorted_cols.data(), slot_cols.data(), n_slots, stream);
+    copyAsync(sorted_edges.data(), slot_edges.data(), n_slots, stream);
+    auto keys = thrust::make_zip_iterator(
+      thrust::make_tuple(slot_rows.data(), sorted_cols.data()));
+    thrust::sort_by_key(policy, keys, keys + n_slots, sorted_edges.data());
+  }
+
+  // (3) Reduce the runs of equal slots. The rows of the slots are unchanged
+  // by the sort within the rows
+  device_buffer<T> slot_vals(d_alloc, stream, n_slots);
+  device_buffer<Index_> keep(d_alloc, stream, n_slots);
+  CUDA_CHECK(cudaMemsetAsync(fill.data(), 0, (n + 1) * sizeof(Index_), stream));
+  coo_symmetric_reduce_kernel<TPB_X, T, Lambda, Index_>
+    <<<grid_slots, blk, 0, stream>>>(
+      slot_rows.data(), sorted_cols.data(), sorted_edges.data(), in->vals(),
+      offsets.data(), n_slots, reduction_op, slot_vals.data(), keep.data(),
+      fill.data());
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  // (4) Compact into the output
+  device_buffer<Index_> positions(d_alloc, stream, n_slots);
+  thrust::exclusive_scan(policy, keep.data(), keep.data() + n_slots,
+                         positions.data());
+  Index_ out_nnz = thrust::reduce(policy, keep.data(), keep.data() + n_slots);
+  out->allocate(out_nnz, n, n, false, stream);
+  coo_symmetric_compact_kernel<TPB_X, T, Index_>
+    <<<grid_slots, blk, 0, stream>>>(
+      slot_rows.data(), sorted_cols.data(), slot_vals.data(), keep.data(),
+      positions.data(), n_slots, out->rows(), out->cols(), out->vals());
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  if (row_ind != nullptr) {
+    thrust::exclusive_scan(policy, fill.data(), fill.data() + n + 1, row_ind);
+  }
+}
+
 };  // namespace Sparse
 };  // namespace MLCommon
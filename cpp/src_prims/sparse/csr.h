@@ -25,6 +25,7 @@
 #include <cuda_runtime.h>
 #include <stdio.h>
 
+#include <cstdint>
 #include <iostream>
 
 namespace MLCommon {
@@ -194,7 +195,7 @@ class CSR {
     * @param n_rows: number of rows in the dense matrix
     * @param n_cols: number of columns in the dense matrix
     */
-  void setSize(int n_rows, int n_cols) {
+  void setSize(Index_Type n_rows, Index_Type n_cols) {
     this->n_rows = n_rows;
     this->n_cols = n_cols;
   }
@@ -203,7 +204,7 @@ class CSR {
     * @brief Set the number of rows and cols for a square dense matrix
     * @param n: number of rows and cols
     */
-  void setSize(int n) {
+  void setSize(Index_Type n) {
     this->n_rows = n;
     this->n_cols = n;
   }
@@ -214,7 +215,7 @@ class CSR {
     * @param init: should values be initialized to 0?
     * @param stream: CUDA stream to use
     */
-  void allocate(int nnz, bool init, cudaStream_t stream) {
+  void allocate(Index_Type nnz, bool init, cudaStream_t stream) {
     this->allocate(nnz, 0, init, stream);
   }
 
@@ -225,7 +226,8 @@ class CSR {
     * @param init: should values be initialized to 0?
     * @param stream: CUDA stream to use
     */
-  void allocate(int nnz, int size, bool init, cudaStream_t stream) {
+  void allocate(Index_Type nnz, Index_Type size, bool init,
+                cudaStream_t stream) {
     this->allocate(nnz, size, size, init, stream);
   }
 
@@ -237,8 +239,8 @@ class CSR {
     * @param init: should values be initialized to 0?
     * @param stream: stream to use for init
     */
-  void allocate(int nnz, int n_rows, int n_cols, bool init,
-                cudaStream_t stream) {
+  void allocate(Index_Type nnz, Index_Type n_rows, Index_Type n_cols,
+                bool init, cudaStream_t stream) {
     this->n_rows = n_rows;
     this->n_cols = n_cols;
     this->nnz = nnz;
@@ -251,31 +253,31 @@ class CSR {
   }
 };
 
-template <int TPB_X, typename T>
+template <int TPB_X, typename T, typename Index_ = int>
 __global__ void csr_row_normalize_l1_kernel(
-  const int *ia,           // csr row ex_scan (sorted by row)
-  const T *vals, int nnz,  // array of values and number of non-zeros
-  int m,                   // num rows in csr
-  T *result) {             // output array
+  const Index_ *ia,           // csr row ex_scan (sorted by row)
+  const T *vals, Index_ nnz,  // array of values and number of non-zeros
+  Index_ m,                   // num rows in csr
+  T *result) {                // output array
 
   // row-based matrix 1 thread per row
-  int row = (blockIdx.x * TPB_X) + threadIdx.x;
+  Index_ row = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
 
   // sum all vals_arr for row and divide each val by sum
   if (row < m) {
-    int start_idx = ia[row];
-    int stop_idx = 0;
+    Index_ start_idx = ia[row];
+    Index_ stop_idx = 0;
     if (row < m - 1) {
       stop_idx = ia[row + 1];
     } else
       stop_idx = nnz;
 
     T sum = T(0.0);
-    for (int j = start_idx; j < stop_idx; j++) {
+    for (Index_ j = start_idx; j < stop_idx; j++) {
       sum = sum + vals[j];
     }
 
-    for (int j = start_idx; j < stop_idx; j++) {
+    for (Index_ j = start_idx; j < stop_idx; j++) {
       if (sum != 0.0) {
         T val = vals[j];
         result[j] = val / sum;
@@ -296,48 +298,48 @@ __global__ void csr_row_normalize_l1_kernel(
  * @param result: l1 normalized data array
  * @param stream: cuda stream to use
  */
-template <int TPB_X = 32, typename T>
-void csr_row_normalize_l1(const int *ia,  // csr row ex_scan (sorted by row)
+template <int TPB_X = 32, typename T, typename Index_ = int>
+void csr_row_normalize_l1(const Index_ *ia,  // csr row ex_scan (sorted by row)
                           const T *vals,
-                          int nnz,  // array of values and number of non-zeros
-                          int m,    // num rows in csr
+                          Index_ nnz,  // number of non-zeros
+                          Index_ m,    // num rows in csr
                           T *result,
                           cudaStream_t stream) {  // output array
 
-  dim3 grid(MLCommon::ceildiv(m, TPB_X), 1, 1);
+  dim3 grid(MLCommon::ceildiv(m, Index_(TPB_X)), 1, 1);
   dim3 blk(TPB_X, 1, 1);
 
-  csr_row_normalize_l1_kernel<TPB_X, T>
+  csr_row_normalize_l1_kernel<TPB_X, T, Index_>
     <<<grid, blk, 0, stream>>>(ia, vals, nnz, m, result);
   CUDA_CHECK(cudaGetLastError());
 }
 
-template <int TPB_X = 32, typename T>
+template <int TPB_X = 32, typename T, typename Index_ = int>
 __global__ void csr_row_normalize_max_kernel(
-  const int *ia,           // csr row ind array (sorted by row)
-  const T *vals, int nnz,  // array of values and number of non-zeros
-  int m,                   // num total rows in csr
-  T *result) {             // output array
+  const Index_ *ia,           // csr row ind array (sorted by row)
+  const T *vals, Index_ nnz,  // array of values and number of non-zeros
+  Index_ m,                   // num total rows in csr
+  T *result) {                // output array
 
   // row-based matrix 1 thread per row
-  int row = (blockIdx.x * TPB_X) + threadIdx.x;
+  Index_ row = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
 
   // find max across columns and divide
   if (row < m) {
-    int start_idx = ia[row];
-    int stop_idx = 0;
+    Index_ start_idx = ia[row];
+    Index_ stop_idx = 0;
     if (row < m - 1) {
       stop_idx = ia[row + 1];
     } else
       stop_idx = nnz;
 
     T max = MIN_FLOAT;
-    for (int j = start_idx; j < stop_idx; j++) {
+    for (Index_ j = start_idx; j < stop_idx; j++) {
       if (vals[j] > max) max = vals[j];
     }
 
     // divide nonzeros in current row by max
-    for (int j = start_idx; j < stop_idx; j++) {
+    for (Index_ j = start_idx; j < stop_idx; j++) {
       if (max != 0.0 && max > MIN_FLOAT) {
         T val = vals[j];
         result[j] = val / max;
@@ -359,23 +361,23 @@ __global__ void csr_row_normalize_max_kernel(
  * @param stream: cuda stream to use
  */
 
-template <int TPB_X = 32, typename T>
-void csr_row_normalize_max(const int *ia,  // csr row ind array (sorted by row)
+template <int TPB_X = 32, typename T, typename Index_ = int>
+void csr_row_normalize_max(const Index_ *ia,  // csr row ind array (sorted)
                            const T *vals,
-                           int nnz,  // array of values and number of non-zeros
-                           int m,    // num total rows in csr
+                           Index_ nnz,  // array of values and number of nnz
+                           Index_ m,    // num total rows in csr
                            T *result, cudaStream_t stream) {
-  dim3 grid(MLCommon::ceildiv(m, TPB_X), 1, 1);
+  dim3 grid(MLCommon::ceildiv(m, Index_(TPB_X)), 1, 1);
   dim3 blk(TPB_X, 1, 1);
 
-  csr_row_normalize_max_kernel<TPB_X, T>
+  csr_row_normalize_max_kernel<TPB_X, T, Index_>
     <<<grid, blk, 0, stream>>>(ia, vals, nnz, m, result);
   CUDA_CHECK(cudaGetLastError());
 }
 
 template <typename T>
-__device__ int get_stop_idx(T row, T m, T nnz, const T *ind) {
-  int stop_idx = 0;
+__device__ T get_stop_idx(T row, T m, T nnz, const T *ind) {
+  T stop_idx = 0;
   if (row < (m - 1))
     stop_idx = ind[row + 1];
   else
@@ -384,15 +386,29 @@ __device__ int get_stop_idx(T row, T m, T nnz, const T *ind) {
   return stop_idx;
 }
 
-template <int TPB_X = 32>
-__global__ void csr_to_coo_kernel(const int *row_ind, int m, int *coo_rows,
-                                  int nnz) {
+/**
+ * @brief atomicAdd on the 32 and 64-bit index types of the sparse prims,
+ * returning the old value. The 64-bit one goes through the unsigned
+ * overload, which wraps around the same way.
+ */
+__device__ inline int atomic_add_index(int *address, int val) {
+  return atomicAdd(address, val);
+}
+
+__device__ inline int64_t atomic_add_index(int64_t *address, int64_t val) {
+  return int64_t(atomicAdd(reinterpret_cast<unsigned long long *>(address),
+                           static_cast<unsigned long long>(val)));
+}
+
+template <int TPB_X = 32, typename Index_ = int>
+__global__ void csr_to_coo_kernel(const Index_ *row_ind, Index_ m,
+                                  Index_ *coo_rows, Index_ nnz) {
   // row-based matrix 1 thread per row
-  int row = (blockIdx.x * TPB_X) + threadIdx.x;
+  Index_ row = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
   if (row < m) {
-    int start_idx = row_ind[row];
-    int stop_idx = get_stop_idx(row, m, nnz, row_ind);
-    for (int i = start_idx; i < stop_idx; i++) coo_rows[i] = row;
+    Index_ start_idx = row_ind[row];
+    Index_ stop_idx = get_stop_idx(row, m, nnz, row_ind);
+    for (Index_ i = start_idx; i < stop_idx; i++) coo_rows[i] = row;
   }
 }
 
@@ -404,52 +420,86 @@ __global__ void csr_to_coo_kernel(const int *row_ind, int m, int *coo_rows,
  * @param nnz: size of output COO row array
  * @param stream: cuda stream to use
  */
-template <int TPB_X>
-void csr_to_coo(const int *row_ind, int m, int *coo_rows, int nnz,
+template <int TPB_X, typename Index_ = int>
+void csr_to_coo(const Index_ *row_ind, Index_ m, Index_ *coo_rows, Index_ nnz,
                 cudaStream_t stream) {
-  dim3 grid(MLCommon::ceildiv(m, TPB_X), 1, 1);
+  dim3 grid(MLCommon::ceildiv(m, Index_(TPB_X)), 1, 1);
   dim3 blk(TPB_X, 1, 1);
 
-  csr_to_coo_kernel<TPB_X><<<grid, blk, 0, stream>>>(row_ind, m, coo_rows, nnz);
+  csr_to_coo_kernel<TPB_X, Index_>
+    <<<grid, blk, 0, stream>>>(row_ind, m, coo_rows, nnz);
   CUDA_CHECK(cudaGetLastError());
 }
 
 template <typename T, int TPB_X = 32>
+__global__ void csr_to_dense_rows_kernel(const int *row_ptr, const int *col_ind,
+                                         const T *vals, const int *rows, int n,
+                                         T *out) {
+  // one block per gathered row
+  int k = blockIdx.x;
+  int row = rows[k];
+  for (int i = row_ptr[row] + threadIdx.x; i < row_ptr[row + 1]; i += TPB_X)
+    out[k + col_ind[i] * n] = vals[i];
+}
+
+/**
+ * @brief Gather rows of a CSR matrix into a dense column major matrix
+ * @param row_ptr: CSR row offsets, size [n_rows + 1]
+ * @param col_ind: CSR column indices, size [nnz]
+ * @param vals: CSR values, size [nnz]
+ * @param rows: indices of the rows to gather, size [n]
+ * @param n: number of rows to gather
+ * @param n_cols: number of columns of the CSR matrix
+ * @param out: output dense matrix in column major format, size [n x n_cols]
+ * @param stream: cuda stream to use
+ */
+template <typename T, int TPB_X = 32>
+void csr_to_dense_rows(const int *row_ptr, const int *col_ind, const T *vals,
+                       const int *rows, int n, int n_cols, T *out,
+                       cudaStream_t stream) {
+  CUDA_CHECK(cudaMemsetAsync(out, 0, n * n_cols * sizeof(T), stream));
+  if (n == 0) return;
+  csr_to_dense_rows_kernel<T, TPB_X>
+    <<<n, TPB_X, 0, stream>>>(row_ptr, col_ind, vals, rows, n, out);
+  CUDA_CHECK(cudaGetLastError());
+}
+
+template <typename T, int TPB_X = 32, typename Index_ = int>
 __global__ void csr_add_calc_row_counts_kernel(
-  const int *a_ind, const int *a_indptr, const T *a_val, int nnz1,
-  const int *b_ind, const int *b_indptr, const T *b_val, int nnz2, int m,
-  int *out_rowcounts) {
+  const Index_ *a_ind, const Index_ *a_indptr, const T *a_val, Index_ nnz1,
+  const Index_ *b_ind, const Index_ *b_indptr, const T *b_val, Index_ nnz2,
+  Index_ m, Index_ *out_rowcounts) {
   // loop through columns in each set of rows and
   // calculate number of unique cols across both rows
-  int row = (blockIdx.x * TPB_X) + threadIdx.x;
+  Index_ row = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
 
   if (row < m) {
-    int a_start_idx = a_ind[row];
-    int a_stop_idx = get_stop_idx(row, m, nnz1, a_ind);
+    Index_ a_start_idx = a_ind[row];
+    Index_ a_stop_idx = get_stop_idx(row, m, nnz1, a_ind);
 
-    int b_start_idx = b_ind[row];
-    int b_stop_idx = get_stop_idx(row, m, nnz2, b_ind);
+    Index_ b_start_idx = b_ind[row];
+    Index_ b_stop_idx = get_stop_idx(row, m, nnz2, b_ind);
 
     /**
          * Union of columns within each row of A and B so that we can scan through
          * them, adding their values together.
          */
-    int max_size = (a_stop_idx - a_start_idx) + (b_stop_idx - b_start_idx);
+    Index_ max_size = (a_stop_idx - a_start_idx) + (b_stop_idx - b_start_idx);
 
-    int *arr = new int[max_size];
-    int cur_arr_idx = 0;
-    for (int j = a_start_idx; j < a_stop_idx; j++) {
+    Index_ *arr = new Index_[max_size];
+    Index_ cur_arr_idx = 0;
+    for (Index_ j = a_start_idx; j < a_stop_idx; j++) {
       arr[cur_arr_idx] = a_indptr[j];
       cur_arr_idx++;
     }
 
-    int arr_size = cur_arr_idx;
-    int final_size = arr_size;
+    Index_ arr_size = cur_arr_idx;
+    Index_ final_size = arr_size;
 
-    for (int j = b_start_idx; j < b_stop_idx; j++) {
-      int cur_col = b_indptr[j];
+    for (Index_ j = b_start_idx; j < b_stop_idx; j++) {
+      Index_ cur_col = b_indptr[j];
       bool found = false;
-      for (int k = 0; k < arr_size; k++) {
+      for (Index_ k = 0; k < arr_size; k++) {
         if (arr[k] == cur_col) {
           found = true;
           break;
@@ -462,42 +512,43 @@ __global__ void csr_add_calc_row_counts_kernel(
     }
 
     out_rowcounts[row] = final_size;
-    atomicAdd(out_rowcounts + m, final_size);
+    atomic_add_index(out_rowcounts + m, final_size);
 
-    delete arr;
+    delete[] arr;
   }
 }
 
-template <typename T, int TPB_X = 32>
-__global__ void csr_add_kernel(const int *a_ind, const int *a_indptr,
-                               const T *a_val, int nnz1, const int *b_ind,
-                               const int *b_indptr, const T *b_val, int nnz2,
-                               int m, int *out_ind, int *out_indptr,
+template <typename T, int TPB_X = 32, typename Index_ = int>
+__global__ void csr_add_kernel(const Index_ *a_ind, const Index_ *a_indptr,
+                               const T *a_val, Index_ nnz1,
+                               const Index_ *b_ind, const Index_ *b_indptr,
+                               const T *b_val, Index_ nnz2, Index_ m,
+                               Index_ *out_ind, Index_ *out_indptr,
                                T *out_val) {
   // 1 thread per row
-  int row = (blockIdx.x * TPB_X) + threadIdx.x;
+  Index_ row = (Index_(blockIdx.x) * TPB_X) + threadIdx.x;
 
   if (row < m) {
-    int a_start_idx = a_ind[row];
-    int a_stop_idx = get_stop_idx(row, m, nnz1, a_ind);
+    Index_ a_start_idx = a_ind[row];
+    Index_ a_stop_idx = get_stop_idx(row, m, nnz1, a_ind);
 
-    int b_start_idx = b_ind[row];
-    int b_stop_idx = get_stop_idx(row, m, nnz2, b_ind);
+    Index_ b_start_idx = b_ind[row];
+    Index_ b_stop_idx = get_stop_idx(row, m, nnz2, b_ind);
 
-    int o_idx = out_ind[row];
+    Index_ o_idx = out_ind[row];
 
-    int cur_o_idx = o_idx;
-    for (int j = a_start_idx; j < a_stop_idx; j++) {
+    Index_ cur_o_idx = o_idx;
+    for (Index_ j = a_start_idx; j < a_stop_idx; j++) {
       out_indptr[cur_o_idx] = a_indptr[j];
       out_val[cur_o_idx] = a_val[j];
       cur_o_idx++;
     }
 
-    int arr_size = cur_o_idx - o_idx;
-    for (int j = b_start_idx; j < b_stop_idx; j++) {
-      int cur_col = b_indptr[j];
+    Index_ arr_size = cur_o_idx - o_idx;
+    for (Index_ j = b_start_idx; j < b_stop_idx; j++) {
+      Index_ cur_col = b_indptr[j];
       bool found = false;
-      for (int k = o_idx; k < o_idx + arr_size; k++) {
+      for (Index_ k = o_idx; k < o_idx + arr_size; k++) {
         // If we found a match, sum the two values
         if (out_indptr[k] == cur_col) {
           out_val[k] += b_val[j];
@@ -532,35 +583,36 @@ __global__ void csr_add_kernel(const int *a_ind, const int *a_indptr,
  * @param alloc: deviceAllocator to use for temp memory
  * @param stream: cuda stream to use
  */
-template <typename T, int TPB_X = 32>
-size_t csr_add_calc_inds(const int *a_ind, const int *a_indptr, const T *a_val,
-                         int nnz1, const int *b_ind, const int *b_indptr,
-                         const T *b_val, int nnz2, int m, int *out_ind,
+template <typename T, int TPB_X = 32, typename Index_ = int>
+size_t csr_add_calc_inds(const Index_ *a_ind, const Index_ *a_indptr,
+                         const T *a_val, Index_ nnz1, const Index_ *b_ind,
+                         const Index_ *b_indptr, const T *b_val, Index_ nnz2,
+                         Index_ m, Index_ *out_ind,
                          std::shared_ptr<deviceAllocator> d_alloc,
                          cudaStream_t stream) {
-  dim3 grid(ceildiv(m, TPB_X), 1, 1);
+  dim3 grid(ceildiv(m, Index_(TPB_X)), 1, 1);
   dim3 blk(TPB_X, 1, 1);
 
-  device_buffer<int> row_counts(d_alloc, stream, m + 1);
+  device_buffer<Index_> row_counts(d_alloc, stream, m + 1);
   CUDA_CHECK(
-    cudaMemsetAsync(row_counts.data(), 0, (m + 1) * sizeof(int), stream));
+    cudaMemsetAsync(row_counts.data(), 0, (m + 1) * sizeof(Index_), stream));
 
-  csr_add_calc_row_counts_kernel<T, TPB_X>
+  csr_add_calc_row_counts_kernel<T, TPB_X, Index_>
     <<<grid, blk, 0, stream>>>(a_ind, a_indptr, a_val, nnz1, b_ind, b_indptr,
                                b_val, nnz2, m, row_counts.data());
   CUDA_CHECK(cudaPeekAtLastError());
 
   CUDA_CHECK(cudaStreamSynchronize(stream));
 
-  int cnnz = 0;
+  Index_ cnnz = 0;
   MLCommon::updateHost(&cnnz, row_counts.data() + m, 1, stream);
 
   // create csr compressed row index from row counts
-  thrust::device_ptr<int> row_counts_d =
+  thrust::device_ptr<Index_> row_counts_d =
     thrust::device_pointer_cast(row_counts.data());
-  thrust::device_ptr<int> c_ind_d = thrust::device_pointer_cast(out_ind);
+  thrust::device_ptr<Index_> c_ind_d = thrust::device_pointer_cast(out_ind);
   exclusive_scan(thrust::cuda::par.on(stream), row_counts_d, row_counts_d + m,
-                 c_ind_d);
+                 c_ind_d, Index_(0));
 
   return cnnz;
 }
@@ -582,15 +634,16 @@ size_t csr_add_calc_inds(const int *a_ind, const int *a_indptr, const T *a_val,
  * @param c_val: output data array
  * @param stream: cuda stream to use
  */
-template <typename T, int TPB_X = 32>
-void csr_add_finalize(const int *a_ind, const int *a_indptr, const T *a_val,
-                      int nnz1, const int *b_ind, const int *b_indptr,
-                      const T *b_val, int nnz2, int m, int *c_ind,
-                      int *c_indptr, T *c_val, cudaStream_t stream) {
-  dim3 grid(MLCommon::ceildiv(m, TPB_X), 1, 1);
+template <typename T, int TPB_X = 32, typename Index_ = int>
+void csr_add_finalize(const Index_ *a_ind, const Index_ *a_indptr,
+                      const T *a_val, Index_ nnz1, const Index_ *b_ind,
+                      const Index_ *b_indptr, const T *b_val, Index_ nnz2,
+                      Index_ m, Index_ *c_ind, Index_ *c_indptr, T *c_val,
+                      cudaStream_t stream) {
+  dim3 grid(MLCommon::ceildiv(m, Index_(TPB_X)), 1, 1);
   dim3 blk(TPB_X, 1, 1);
 
-  csr_add_kernel<T, TPB_X>
+  csr_add_kernel<T, TPB_X, Index_>
     <<<grid, blk, 0, stream>>>(a_ind, a_indptr, a_val, nnz1, b_ind, b_indptr,
                                b_val, nnz2, m, c_ind, c_indptr, c_val);
   CUDA_CHECK(cudaPeekAtLastError());
@@ -977,5 +1030,252 @@ void weak_cc(Index_ *labels, const Index_ *row_ind, const Index_ *row_ind_ptr,
                                  stream, [](Index_) { return true; });
 }
 
+/**
+ * State of the union-find connected components, kept between the batches:
+ * the parent of each of the N vertices in a forest whose roots are the
+ * smallest vertex of their tree, and whether each vertex seeds a label.
+ */
+template <typename Index_>
+struct UnionFindState {
+ public:
+  Index_ *parent;
+  bool *seeded;
+
+  UnionFindState(Index_ *parent, bool *seeded)
+    : parent(parent), seeded(seeded) {}
+};
+
+template <typename Index_>
+__device__ Index_ uf_find(Index_ *parent, Index_ x) {
+  volatile Index_ *vparent = parent;
+  Index_ p = vparent[x];
+  while (p != x) {
+    // path halving; grandparents are smaller, so the trees stay the same
+    Index_ gp = vparent[p];
+    if (gp != p) vparent[x] = gp;
+    x = p;
+    p = gp;
+  }
+  return x;
+}
+
+template <typename Index_>
+__device__ Index_ uf_cas(Index_ *address, Index_ compare, Index_ val) {
+  if (sizeof(Index_) == 4)
+    return atomicCAS((int *)address, (int)compare, (int)val);
+  else
+    return atomicCAS((unsigned long long int *)address,
+                     (unsigned long long int)compare,
+                     (unsigned long long int)val);
+}
+
+/** Merges the trees of a and b, hooking the larger root under the smaller */
+template <typename Index_>
+__device__ void uf_union(Index_ *parent, Index_ a, Index_ b) {
+  while (true) {
+    a = uf_find(parent, a);
+    b = uf_find(parent, b);
+    if (a == b) return;
+    if (a < b) {
+      Index_ t = a;
+      a = b;
+      b = t;
+    }
+    // retry if another thread hooked a first
+    if (uf_cas(parent + a, a, b) == a) return;
+  }
+}
+
+template <typename Index_, int TPB_X = 32, typename Lambda>
+__global__ void uf_hook_kernel(Index_ *parent, bool *seeded,
+                               const Index_ *row_ind,
+                               const Index_ *row_ind_ptr, Index_ nnz,
+                               Index_ startVertexId, Index_ batchSize,
+                               Lambda filter_op) {
+  Index_ tid = threadIdx.x + blockIdx.x * TPB_X;
+  if (tid >= batchSize) return;
+  if (filter_op(tid)) seeded[startVertexId + tid] = true;
+  Index_ stop = tid < batchSize - 1 ? row_ind[tid + 1] : nnz;
+  for (Index_ j = row_ind[tid]; j < stop; j++)
+    uf_union(parent, startVertexId + tid, row_ind_ptr[j]);
+}
+
+template <typename Index_, int TPB_X = 32>
+__global__ void uf_init_kernel(Index_ *parent, bool *seeded, Index_ N) {
+  Index_ tid = threadIdx.x + blockIdx.x * TPB_X;
+  if (tid < N) {
+    parent[tid] = tid;
+    seeded[tid] = false;
+  }
+}
+
+template <typename Index_, int TPB_X = 32>
+__global__ void uf_compress_kernel(Index_ *parent, Index_ *labels, Index_ N,
+                                   Index_ MAX_LABEL) {
+  Index_ tid = threadIdx.x + blockIdx.x * TPB_X;
+  if (tid < N) {
+    parent[tid] = uf_find(parent, tid);
+    labels[tid] = MAX_LABEL;
+  }
+}
+
+template <typename Index_, int TPB_X = 32>
+__global__ void uf_seed_kernel(const Index_ *parent, const bool *seeded,
+                               Index_ *labels, Index_ N) {
+  Index_ tid = threadIdx.x + blockIdx.x * TPB_X;
+  if (tid < N && seeded[tid]) {
+    if (sizeof(Index_) == 4)
+      atomicMin((int *)(labels + parent[tid]), tid + 1);
+    else if (sizeof(Index_) == 8)
+      atomicMin((long long int *)(labels + parent[tid]), tid + 1);
+  }
+}
+
+template <typename Index_, int TPB_X = 32>
+__global__ void uf_label_kernel(const Index_ *parent, Index_ *labels,
+                                Index_ N) {
+  Index_ tid = threadIdx.x + blockIdx.x * TPB_X;
+  // only the roots are read, and a root keeps its own label
+  if (tid < N) labels[tid] = labels[parent[tid]];
+}
+
+/**
+ * @brief Compute weakly connected components by union-find, with the labels
+ * weak_cc_batched converges to: each vertex is labeled 1 + the smallest
+ * seeded vertex of its component, or the max value of Index_ if none is
+ * seeded.
+ *
+ * Instead of propagating the labels one level per iteration, with a host
+ * synchronization each, the edges of the batch are merged into a forest by
+ * lock-free hooking of the larger root under the smaller one, with path
+ * halving, as in [1]. Every batch costs a fixed number of kernel launches and
+ * no synchronization, whatever the diameter of the components.
+ *
+ * [1] Jaiganesh, J. and Burtscher, M., 2018. "A high-performance connected
+ * components implementation for GPUs"
+ *
+ * @tparam Index_ the numeric type of non-floating point elements
+ * @tparam TPB_X the threads to use per block when configuring the kernel
+ * @tparam Lambda the type of a filter function (Index_)->bool of the vertices
+ * of the batch which seed a label
+ * @param labels an array for the output labels of the N vertices
+ * @param row_ind the compressed row index of the CSR array of the batch
+ * @param row_ind_ptr the row index pointer of the CSR array of the batch
+ * @param nnz the size of row_ind_ptr array
+ * @param N number of vertices
+ * @param startVertexId the starting vertex index for the current batch
+ * @param batchSize number of vertices for current batch
+ * @param state instance of inter-batch state management
+ * @param stream the cuda stream to use
+ * @param filter_op the filter of the vertices of the batch which seed a label
+ */
+template <typename Index_, int TPB_X = 32, typename Lambda>
+void weak_cc_union_find_batched(Index_ *labels, const Index_ *row_ind,
+                                const Index_ *row_ind_ptr, Index_ nnz,
+                                Index_ N, Index_ startVertexId,
+                                Index_ batchSize, UnionFindState<Index_> *state,
+                                cudaStream_t stream, Lambda filter_op) {
+  ASSERT(sizeof(Index_) == 4 || sizeof(Index_) == 8,
+         "Index_ should be 4 or 8 bytes");
+  dim3 blocks(ceildiv(N, Index_(TPB_X)));
+  dim3 threads(TPB_X);
+  Index_ MAX_LABEL = std::numeric_limits<Index_>::max();
+
+  if (startVertexId == 0) {
+    uf_init_kernel<Index_, TPB_X>
+      <<<blocks, threads, 0, stream>>>(state->parent, state->seeded, N);
+    CUDA_CHECK(cudaPeekAtLastError());
+  }
+
+  dim3 batch_blocks(ceildiv(batchSize, Index_(TPB_X)));
+  uf_hook_kernel<Index_, TPB_X><<<batch_blocks, threads, 0, stream>>>(
+    state->parent, state->seeded, row_ind, row_ind_ptr, nnz, startVertexId,
+    batchSize, filter_op);
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  uf_compress_kernel<Index_, TPB_X>
+    <<<blocks, threads, 0, stream>>>(state->parent, labels, N, MAX_LABEL);
+  CUDA_CHECK(cudaPeekAtLastError());
+  uf_seed_kernel<Index_, TPB_X>
+    <<<blocks, threads, 0, stream>>>(state->parent, state->seeded, labels, N);
+  CUDA_CHECK(cudaPeekAtLastError());
+  uf_label_kernel<Index_, TPB_X>
+    <<<blocks, threads, 0, stream>>>(state->parent, labels, N);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/** Seeds every vertex, for the unbatched connected components */
+template <typename Index_>
+struct WeakCCAllSeeded {
+  HDI bool operator()(Index_) const { return true; }
+};
+
+template <typename Index_, int TPB_X = 32>
+__global__ void cc_root_kernel(const Index_ *labels, Index_ *root_ids,
+                               Index_ N) {
+  Index_ tid = threadIdx.x + blockIdx.x * TPB_X;
+  if (tid < N) root_ids[tid] = labels[tid] == tid + 1;
+}
+
+template <typename Index_, int TPB_X = 32>
+__global__ void cc_monotonic_kernel(Index_ *labels, const Index_ *root_ids,
+                                    Index_ N) {
+  Index_ tid = threadIdx.x + blockIdx.x * TPB_X;
+  if (tid < N) labels[tid] = root_ids[labels[tid] - 1];
+}
+
+/**
+ * @brief Compute the weakly connected components of a whole graph by
+ * union-find, and number them as Label::make_monotonic would: the component
+ * of the smallest vertex is 1, the next one 2 and so on. The direction of
+ * the edges is ignored, so the graph needs not be symmetric.
+ *
+ * Unlike make_monotonic, whose cost grows with the number of labels, the
+ * roots of the forest are numbered by a scan over the vertices.
+ *
+ * @tparam Index_ the numeric type of non-floating point elements
+ * @tparam TPB_X the threads to use per block when configuring the kernel
+ * @param labels an array for the output labels of the N vertices
+ * @param row_ind the compressed row index of the CSR array (size N)
+ * @param row_ind_ptr the column indices of the CSR array (size nnz)
+ * @param nnz the size of row_ind_ptr array
+ * @param N number of vertices
+ * @param d_alloc device allocator for temporary buffers
+ * @param stream the cuda stream to use
+ * @return the number of connected components
+ */
+template <typename Index_, int TPB_X = 32>
+Index_ weak_cc_union_find(Index_ *labels, const Index_ *row_ind,
+                          const Index_ *row_ind_ptr, Index_ nnz, Index_ N,
+                          std::shared_ptr<deviceAllocator> d_alloc,
+                          cudaStream_t stream) {
+  if (N == 0) return 0;
+  device_buffer<Index_> parent(d_alloc, stream, N);
+  device_buffer<bool> seeded(d_alloc, stream, N);
+  UnionFindState<Index_> state(parent.data(), seeded.data());
+  weak_cc_union_find_batched<Index_, TPB_X>(labels, row_ind, row_ind_ptr, nnz,
+                                            N, Index_(0), N, &state, stream,
+                                            WeakCCAllSeeded<Index_>());
+
+  // the roots are labeled 1 + themselves; parent is free for their numbers
+  dim3 blocks(ceildiv(N, Index_(TPB_X)));
+  dim3 threads(TPB_X);
+  cc_root_kernel<Index_, TPB_X>
+    <<<blocks, threads, 0, stream>>>(labels, parent.data(), N);
+  CUDA_CHECK(cudaPeekAtLastError());
+  thrust::device_ptr<Index_> root_ids =
+    thrust::device_pointer_cast(parent.data());
+  thrust::inclusive_scan(thrust::cuda::par.on(stream), root_ids, root_ids + N,
+                         root_ids);
+  cc_monotonic_kernel<Index_, TPB_X>
+    <<<blocks, threads, 0, stream>>>(labels, parent.data(), N);
+  CUDA_CHECK(cudaPeekAtLastError());
+
+  Index_ n_components;
+  updateHost(&n_components, parent.data() + N - 1, 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  return n_components;
+}
+
 };  // namespace Sparse
 };  // namespace MLCommon
@@ -46,5 +46,56 @@ inline cusparseStatus_t cusparse_gthr(cusparseHandle_t handle, int nnz,
   return cusparseSgthr(handle, nnz, vals, vals_sorted, d_P,
                        CUSPARSE_INDEX_BASE_ZERO);
 }
+
+/**
+ * y = alpha * op(A) * x + beta * y, with A an m x n CSR matrix of nnz values
+ */
+inline cusparseStatus_t cusparse_csrmv(
+  cusparseHandle_t handle, cusparseOperation_t trans, int m, int n, int nnz,
+  const float *alpha, const cusparseMatDescr_t descr, const float *csr_vals,
+  const int *csr_row_ptr, const int *csr_col_ind, const float *x,
+  const float *beta, float *y, cudaStream_t stream) {
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseScsrmv(handle, trans, m, n, nnz, alpha, descr, csr_vals,
+                        csr_row_ptr, csr_col_ind, x, beta, y);
+}
+
+inline cusparseStatus_t cusparse_csrmv(
+  cusparseHandle_t handle, cusparseOperation_t trans, int m, int n, int nnz,
+  const double *alpha, const cusparseMatDescr_t descr, const double *csr_vals,
+  const int *csr_row_ptr, const int *csr_col_ind, const double *x,
+  const double *beta, double *y, cudaStream_t stream) {
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseDcsrmv(handle, trans, m, n, nnz, alpha, descr, csr_vals,
+                        csr_row_ptr, csr_col_ind, x, beta, y);
+}
+
+/**
+ * C = alpha * op(A) * op(B) + beta * C, with A an m x k CSR matrix of nnz
+ * values, B and C dense column major matrices, op(B) of size k x n
+ */
+inline cusparseStatus_t cusparse_csrmm2(
+  cusparseHandle_t handle, cusparseOperation_t transA,
+  cusparseOperation_t transB, int m, int n, int k, int nnz, const float *alpha,
+  const cusparseMatDescr_t descr, const float *csr_vals,
+  const int *csr_row_ptr, const int *csr_col_ind, const float *B, int ldb,
+  const float *beta, float *C, int ldc, cudaStream_t stream) {
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseScsrmm2(handle, transA, transB, m, n, k, nnz, alpha, descr,
+                         csr_vals, csr_row_ptr, csr_col_ind, B, ldb, beta, C,
+                         ldc);
+}
+
+inline cusparseStatus_t cusparse_csrmm2(
+  cusparseHandle_t handle, cusparseOperation_t transA,
+  cusparseOperation_t transB, int m, int n, int k, int nnz,
+  const double *alpha, const cusparseMatDescr_t descr, const double *csr_vals,
+  const int *csr_row_ptr, const int *csr_col_ind, const double *B, int ldb,
+  const double *beta, double *C, int ldc, cudaStream_t stream) {
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseDcsrmm2(handle, transA, transB, m, n, k, nnz, alpha, descr,
+                         csr_vals, csr_row_ptr, csr_col_ind, B, ldb, beta, C,
+                         ldc);
+}
 };  // namespace Sparse
 };  // namespace MLCommon
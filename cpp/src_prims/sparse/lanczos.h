@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cublas_v2.h>
+#include <cusolverDn.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "cuml/common/cuml_allocator.hpp"
+#include "linalg/cublas_wrappers.h"
+#include "linalg/eig.h"
+#include "linalg/eltwise.h"
+#include "matrix/matrix.h"
+
+namespace MLCommon {
+namespace Sparse {
+
+/**
+ * @brief Computes the n_eig largest eigenvalues, and their eigenvectors, of
+ * a symmetric n x n operator by Lanczos iterations with full
+ * reorthogonalization and thick restarts [1].
+ *
+ * Every restart keeps the largest Ritz pairs of the ncv Lanczos vectors and
+ * the last of them, so the memory stays at (ncv + 1) vectors of size n and
+ * only the small ncv x ncv projected problem is solved densely.
+ *
+ * [1] Wu, K. and Simon, H., 2000. "Thick-restart Lanczos method for large
+ * symmetric eigenvalue problems"
+ *
+ * @tparam T the data type
+ * @tparam Op the type of a host callable (const T *x, T *y) which computes
+ * y = A * x for the device vectors x and y of size n, on stream
+ * @param op the operator A
+ * @param n size of the operator
+ * @param n_eig number of eigenpairs to compute, in [1, n)
+ * @param v0 start vector of size n, which must not be orthogonal to the
+ * wanted eigenvectors
+ * @param eig_vals output eigenvalues (n_eig), largest first
+ * @param eig_vectors output eigenvectors (n, n_eig) in column-major
+ * @param cublas_h cublas handle
+ * @param cusolver_h cusolver handle
+ * @param d_alloc device allocator for temporary buffers
+ * @param stream cuda stream to use
+ * @param ncv number of Lanczos vectors, in (n_eig, n]; 0 picks
+ * min(n, max(2 * n_eig + 1, 20))
+ * @param max_restarts maximum number of restarts
+ * @param tol the residual of each Ritz pair relative to the largest Ritz
+ * value under which it is converged
+ * @return whether all the eigenpairs converged, which they may not have
+ * after max_restarts; the eigenpairs returned are the last Ritz pairs either
+ * way. An invariant subspace found before n_eig vectors counts as not
+ * converged.
+ */
+template <typename T, typename Op>
+bool lanczos_largest(Op op, int n, int n_eig, const T *v0, T *eig_vals,
+                     T *eig_vectors, cublasHandle_t cublas_h,
+                     cusolverDnHandle_t cusolver_h,
+                     std::shared_ptr<deviceAllocator> d_alloc,
+                     cudaStream_t stream, int ncv = 0, int max_restarts = 50,
+                     T tol = 1e-4) {
+  ASSERT(n_eig > 0 && n_eig < n, "lanczos_largest: n_eig must be in [1, n)");
+  int m = ncv > 0 ? ncv : std::min(n, std::max(2 * n_eig + 1, 20));
+  ASSERT(m > n_eig && m <= n, "lanczos_largest: ncv must be in (n_eig, n]");
+
+  device_buffer<T> V(d_alloc, stream, size_t(n) * (m + 1));
+  device_buffer<T> U(d_alloc, stream, size_t(n) * m);
+  device_buffer<T> h(d_alloc, stream, m);
+  device_buffer<T> T_d(d_alloc, stream, m * m);
+  device_buffer<T> S_d(d_alloc, stream, m * m);
+  device_buffer<T> theta_d(d_alloc, stream, m);
+
+  // the projected operator, column-major with leading dimension m
+  std::vector<T> T_h(m * m, T(0));
+  std::vector<T> T_sub(m * m), S_h(m * m), theta_h(m), coef(m), h_h(m);
+
+  copyAsync(V.data(), v0, n, stream);
+  T v0_norm = Matrix::getL2Norm(V.data(), n, cublas_h, stream);
+  ASSERT(v0_norm > T(0), "lanczos_largest: v0 must not be zero");
+  LinAlg::scalarMultiply(V.data(), V.data(), T(1) / v0_norm, n, stream);
+
+  const T one = 1, zero = 0, minus_one = -1;
+  T beta = 0, a_norm = 0;
+  int k = 0;
+  for (int restart = 0;; restart++) {
+    int m_cur = m;
+    for (int j = k; j < m; j++) {
+      T *v = V.data() + size_t(j) * n;
+      T *w = v + n;
+      op(v, w);
+
+      // project w out of V[:, :j + 1] twice, which keeps V orthonormal in
+      // finite precision; the projections are the column j of T
+      std::fill(coef.begin(), coef.begin() + j + 1, T(0));
+      for (int pass = 0; pass < 2; pass++) {
+        CUBLAS_CHECK(LinAlg::cublasgemv(cublas_h, CUBLAS_OP_T, n, j + 1, &one,
+                                        V.data(), n, w, 1, &zero, h.data(), 1,
+                                        stream));
+        CUBLAS_CHECK(LinAlg::cublasgemv(cublas_h, CUBLAS_OP_N, n, j + 1,
+                                        &minus_one, V.data(), n, h.data(), 1,
+                                        &one, w, 1, stream));
+        updateHost(h_h.data(), h.data(), j + 1, stream);
+        CUDA_CHECK(cudaStreamSynchronize(stream));
+        for (int i = 0; i <= j; i++) coef[i] += h_h[i];
+      }
+
+      T col_norm = 0;
+      for (int i = 0; i <= j; i++) {
+        T_h[j * m + i] = T_h[i * m + j] = coef[i];
+        col_norm += coef[i] * coef[i];
+      }
+
+      beta = Matrix::getL2Norm(w, n, cublas_h, stream);
+      a_norm = std::max(a_norm, std::sqrt(col_norm + beta * beta));
+      if (beta <= std::numeric_limits<T>::epsilon() * a_norm) {
+        // V[:, :j + 1] spans an invariant subspace: its Ritz pairs are exact
+        m_cur = j + 1;
+        beta = 0;
+        break;
+      }
+      LinAlg::scalarMultiply(w, w, T(1) / beta, n, stream);
+    }
+    if (m_cur < n_eig) return false;
+
+    /**
+     * Rayleigh-Ritz on V[:, :m_cur]; the residual of the Ritz pair i is
+     * beta times the last component of its eigenvector in T
+     */
+    for (int c = 0; c < m_cur; c++)
+      for (int r = 0; r < m_cur; r++) T_sub[c * m_cur + r] = T_h[c * m + r];
+    updateDevice(T_d.data(), T_sub.data(), m_cur * m_cur, stream);
+    LinAlg::eigDC(T_d.data(), m_cur, m_cur, S_d.data(), theta_d.data(),
+                  cusolver_h, stream, d_alloc);
+    updateHost(S_h.data(), S_d.data(), m_cur * m_cur, stream);
+    updateHost(theta_h.data(), theta_d.data(), m_cur, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+
+    T theta_max = 0;
+    for (int i = 0; i < m_cur; i++)
+      theta_max = std::max(theta_max, std::abs(theta_h[i]));
+    bool converged = true;
+    for (int i = m_cur - n_eig; i < m_cur; i++) {
+      T residual = std::abs(beta * S_h[i * m_cur + m_cur - 1]);
+      if (residual > tol * theta_max) converged = false;
+    }
+
+    if (converged || restart == max_restarts) {
+      // the n_eig largest Ritz vectors are the last columns of S
+      CUBLAS_CHECK(LinAlg::cublasgemm(
+        cublas_h, CUBLAS_OP_N, CUBLAS_OP_N, n, n_eig, m_cur, &one, V.data(), n,
+        S_d.data() + (m_cur - n_eig) * m_cur, m_cur, &zero, U.data(), n,
+        stream));
+      std::vector<T> vals_h(n_eig);
+      for (int i = 0; i < n_eig; i++) {
+        copyAsync(eig_vectors + size_t(i) * n,
+                  U.data() + size_t(n_eig - 1 - i) * n, n, stream);
+        vals_h[i] = theta_h[m_cur - 1 - i];
+      }
+      updateDevice(eig_vals, vals_h.data(), n_eig, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+      return converged;
+    }
+
+    /**
+     * Thick restart from the k largest Ritz vectors, followed by the last
+     * Lanczos vector, on which A projects the Ritz vectors
+     */
+    k = n_eig + (m - n_eig) / 2;
+    CUBLAS_CHECK(LinAlg::cublasgemm(
+      cublas_h, CUBLAS_OP_N, CUBLAS_OP_N, n, k, m, &one, V.data(), n,
+      S_d.data() + (m - k) * m, m, &zero, U.data(), n, stream));
+    copyAsync(V.data(), U.data(), size_t(n) * k, stream);
+    copyAsync(V.data() + size_t(n) * k, V.data() + size_t(n) * m, n, stream);
+
+    std::fill(T_h.begin(), T_h.end(), T(0));
+    for (int i = 0; i < k; i++) T_h[i * m + i] = theta_h[m - k + i];
+  }
+}
+
+};  // namespace Sparse
+};  // namespace MLCommon
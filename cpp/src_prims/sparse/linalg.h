@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_runtime.h>
+#include <cusparse_v2.h>
+
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "cuml/common/cuml_allocator.hpp"
+#include "linalg/norm.h"
+#include "sparse/csr.h"
+#include "sparse/cusparse_wrappers.h"
+
+namespace MLCommon {
+namespace Sparse {
+
+/**
+ * The sparse compute layer of the algorithms on CSR inputs: products of a
+ * CSR matrix with dense vectors and matrices, sampled dense-dense products
+ * and row norms. The CSR matrices have int indices, zero based, and the
+ * dense matrices are column major. Every call is queued on the given stream;
+ * the workspaces come from the allocator.
+ *
+ * The products go through the generic cuSPARSE API when it is available
+ * (CUDA 10.2 and later) and the legacy csrmv / csrmm2 otherwise.
+ */
+
+#if CUDART_VERSION >= 10020
+template <typename T>
+struct cusparse_value_type;
+
+template <>
+struct cusparse_value_type<float> {
+  static constexpr cudaDataType_t value = CUDA_R_32F;
+};
+
+template <>
+struct cusparse_value_type<double> {
+  static constexpr cudaDataType_t value = CUDA_R_64F;
+};
+
+/** Descriptor of a CSR matrix for the generic API */
+template <typename T>
+cusparseSpMatDescr_t create_csr_descr(const int *row_ind, const int *cols,
+                                      const T *vals, int nnz, int n_rows,
+                                      int n_cols) {
+  cusparseSpMatDescr_t descr;
+  CUSPARSE_CHECK(cusparseCreateCsr(
+    &descr, n_rows, n_cols, nnz, const_cast<int *>(row_ind),
+    const_cast<int *>(cols), const_cast<T *>(vals), CUSPARSE_INDEX_32I,
+    CUSPARSE_INDEX_32I, CUSPARSE_INDEX_BASE_ZERO,
+    cusparse_value_type<T>::value));
+  return descr;
+}
+#endif
+
+/**
+ * @brief y = alpha * op(A) * x + beta * y, with A a CSR matrix
+ * @param handle cusparse handle
+ * @param trans whether A is transposed
+ * @param row_ind CSR row offsets of A (size n_rows + 1)
+ * @param cols CSR column indices of A (size nnz)
+ * @param vals CSR values of A (size nnz)
+ * @param nnz number of nonzeros of A
+ * @param n_rows number of rows of A
+ * @param n_cols number of columns of A
+ * @param alpha scale of the product
+ * @param x input vector (size n_cols, or n_rows when transposed)
+ * @param beta scale of y
+ * @param y output vector (size n_rows, or n_cols when transposed)
+ * @param d_alloc device allocator for the workspace
+ * @param stream cuda stream to use
+ */
+template <typename T>
+void csr_spmv(cusparseHandle_t handle, bool trans, const int *row_ind,
+              const int *cols, const T *vals, int nnz, int n_rows, int n_cols,
+              T alpha, const T *x, T beta, T *y,
+              std::shared_ptr<deviceAllocator> d_alloc, cudaStream_t stream) {
+  cusparseOperation_t op =
+    trans ? CUSPARSE_OPERATION_TRANSPOSE : CUSPARSE_OPERATION_NON_TRANSPOSE;
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+#if CUDART_VERSION >= 10020
+  int x_len = trans ? n_rows : n_cols, y_len = trans ? n_cols : n_rows;
+  cusparseSpMatDescr_t matA =
+    create_csr_descr(row_ind, cols, vals, nnz, n_rows, n_cols);
+  cusparseDnVecDescr_t vecX, vecY;
+  CUSPARSE_CHECK(cusparseCreateDnVec(&vecX, x_len, const_cast<T *>(x),
+                                     cusparse_value_type<T>::value));
+  CUSPARSE_CHECK(
+    cusparseCreateDnVec(&vecY, y_len, y, cusparse_value_type<T>::value));
+  size_t ws_bytes = 0;
+  CUSPARSE_CHECK(cusparseSpMV_bufferSize(
+    handle, op, &alpha, matA, vecX, &beta, vecY, cusparse_value_type<T>::value,
+    CUSPARSE_MV_ALG_DEFAULT, &ws_bytes));
+  device_buffer<char> ws(d_alloc, stream, ws_bytes);
+  CUSPARSE_CHECK(cusparseSpMV(handle, op, &alpha, matA, vecX, &beta, vecY,
+                              cusparse_value_type<T>::value,
+                              CUSPARSE_MV_ALG_DEFAULT, ws.data()));
+  CUSPARSE_CHECK(cusparseDestroyDnVec(vecX));
+  CUSPARSE_CHECK(cusparseDestroyDnVec(vecY));
+  CUSPARSE_CHECK(cusparseDestroySpMat(matA));
+#else
+  cusparseMatDescr_t descr;
+  CUSPARSE_CHECK(cusparseCreateMatDescr(&descr));
+  CUSPARSE_CHECK(cusparse_csrmv(handle, op, n_rows, n_cols, nnz, &alpha, descr,
+                                vals, row_ind, cols, x, &beta, y, stream));
+  CUSPARSE_CHECK(cusparseDestroyMatDescr(descr));
+#endif
+}
+
+/**
+ * @brief C = alpha * op(A) * op(B) + beta * C, with A a CSR matrix and B, C
+ * dense column major matrices
+ * @param handle cusparse handle
+ * @param transA whether A is transposed
+ * @param transB whether B is transposed
+ * @param row_ind CSR row offsets of A (size n_rows + 1)
+ * @param cols CSR column indices of A (size nnz)
+ * @param vals CSR values of A (size nnz)
+ * @param nnz number of nonzeros of A
+ * @param n_rows number of rows of A
+ * @param n_cols number of columns of A
+ * @param n number of columns of op(B) and C
+ * @param alpha scale of the product
+ * @param B input dense matrix, op(B) of size (n_cols, n), or (n_rows, n) when
+ * A is transposed
+ * @param ldb leading dimension of B
+ * @param beta scale of C
+ * @param C output dense matrix, n_rows x n, or n_cols x n when A is
+ * transposed
+ * @param ldc leading dimension of C
+ * @param d_alloc device allocator for the workspace
+ * @param stream cuda stream to use
+ */
+template <typename T>
+void csr_spmm(cusparseHandle_t handle, bool transA, bool transB,
+              const int *row_ind, const int *cols, const T *vals, int nnz,
+              int n_rows, int n_cols, int n, T alpha, const T *B, int ldb,
+              T beta, T *C, int ldc, std::shared_ptr<deviceAllocator> d_alloc,
+              cudaStream_t stream) {
+  cusparseOperation_t opA =
+    transA ? CUSPARSE_OPERATION_TRANSPOSE : CUSPARSE_OPERATION_NON_TRANSPOSE;
+  cusparseOperation_t opB =
+    transB ? CUSPARSE_OPERATION_TRANSPOSE : CUSPARSE_OPERATION_NON_TRANSPOSE;
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+#if CUDART_VERSION >= 10020
+  int k = transA ? n_rows : n_cols, m = transA ? n_cols : n_rows;
+  int b_rows = transB ? n : k, b_cols = transB ? k : n;
+  cusparseSpMatDescr_t matA =
+    create_csr_descr(row_ind, cols, vals, nnz, n_rows, n_cols);
+  cusparseDnMatDescr_t matB, matC;
+  CUSPARSE_CHECK(cusparseCreateDnMat(&matB, b_rows, b_cols, ldb,
+                                     const_cast<T *>(B),
+                                     cusparse_value_type<T>::value,
+                                     CUSPARSE_ORDER_COL));
+  CUSPARSE_CHECK(cusparseCreateDnMat(&matC, m, n, ldc, C,
+                                     cusparse_value_type<T>::value,
+                                     CUSPARSE_ORDER_COL));
+  size_t ws_bytes = 0;
+  CUSPARSE_CHECK(cusparseSpMM_bufferSize(
+    handle, opA, opB, &alpha, matA, matB, &beta, matC,
+    cusparse_value_type<T>::value, CUSPARSE_MM_ALG_DEFAULT, &ws_bytes));
+  device_buffer<char> ws(d_alloc, stream, ws_bytes);
+  CUSPARSE_CHECK(cusparseSpMM(handle, opA, opB, &alpha, matA, matB, &beta,
+                              matC, cusparse_value_type<T>::value,
+                              CUSPARSE_MM_ALG_DEFAULT, ws.data()));
+  CUSPARSE_CHECK(cusparseDestroyDnMat(matB));
+  CUSPARSE_CHECK(cusparseDestroyDnMat(matC));
+  CUSPARSE_CHECK(cusparseDestroySpMat(matA));
+#else
+  cusparseMatDescr_t descr;
+  CUSPARSE_CHECK(cusparseCreateMatDescr(&descr));
+  CUSPARSE_CHECK(cusparse_csrmm2(handle, opA, opB, n_rows, n, n_cols, nnz,
+                                 &alpha, descr, vals, row_ind, cols, B, ldb,
+                                 &beta, C, ldc, stream));
+  CUSPARSE_CHECK(cusparseDestroyMatDescr(descr));
+#endif
+}
+
+template <typename T, int TPB_X>
+__global__ void csr_sddmm_kernel(const int *rows, const int *cols, int nnz,
+                                 int k, T alpha, const T *A, int lda,
+                                 const T *B, int ldb, T beta, T *vals) {
+  // a warp per nonzero
+  int e = (blockIdx.x * TPB_X + threadIdx.x) / WarpSize;
+  if (e >= nnz) return;
+  int i = rows[e], j = cols[e];
+  T dot = T(0);
+  for (int l = laneId(); l < k; l += WarpSize) {
+    dot += A[i + l * lda] * B[j + l * ldb];
+  }
+  dot = warpReduce(dot);
+  if (laneId() == 0) {
+    vals[e] = beta == T(0) ? alpha * dot : alpha * dot + beta * vals[e];
+  }
+}
+
+/**
+ * @brief Sampled dense-dense product: the values of a CSR matrix S become
+ * S = alpha * (A * B') o spy(S) + beta * S, only the products at the
+ * nonzeros of S being computed
+ * @param row_ind CSR row offsets of S (size n_rows + 1)
+ * @param cols CSR column indices of S (size nnz)
+ * @param vals CSR values of S (size nnz), updated in place
+ * @param nnz number of nonzeros of S
+ * @param n_rows number of rows of S and of A
+ * @param k number of columns of A and of B
+ * @param alpha scale of the product
+ * @param A dense column major matrix (n_rows, k)
+ * @param lda leading dimension of A
+ * @param B dense column major matrix (number of columns of S, k)
+ * @param ldb leading dimension of B
+ * @param beta scale of the values of S; they are not read when it is 0
+ * @param d_alloc device allocator for temporary buffers
+ * @param stream cuda stream to use
+ * @note cuSPARSE has SDDMM only since CUDA 11.2, so it is a kernel of a
+ * warp per nonzero here
+ */
+template <typename T>
+void csr_sddmm(const int *row_ind, const int *cols, T *vals, int nnz,
+               int n_rows, int k, T alpha, const T *A, int lda, const T *B,
+               int ldb, T beta, std::shared_ptr<deviceAllocator> d_alloc,
+               cudaStream_t stream) {
+  constexpr int TPB_X = 256;
+  if (nnz == 0) return;
+  device_buffer<int> rows(d_alloc, stream, nnz);
+  csr_to_coo<TPB_X>(row_ind, n_rows, rows.data(), nnz, stream);
+  int n_blocks = ceildiv(nnz, TPB_X / WarpSize);
+  csr_sddmm_kernel<T, TPB_X><<<n_blocks, TPB_X, 0, stream>>>(
+    rows.data(), cols, nnz, k, alpha, A, lda, B, ldb, beta, vals);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+template <typename T, int TPB_X, typename Lambda>
+__global__ void csr_row_norm_kernel(T *out, const int *row_ind, const T *vals,
+                                    int n_rows, LinAlg::NormType type,
+                                    Lambda fin_op) {
+  int row = blockIdx.x * TPB_X + threadIdx.x;
+  if (row >= n_rows) return;
+  T acc = T(0);
+  for (int idx = row_ind[row]; idx < row_ind[row + 1]; idx++) {
+    acc += type == LinAlg::L1Norm ? myAbs(vals[idx]) : vals[idx] * vals[idx];
+  }
+  out[row] = fin_op(acc);
+}
+
+/**
+ * @brief Norms of the rows of a CSR matrix, as LinAlg::rowNorm for a dense
+ * one: the L1 norms or the squared L2 norms, then fin_op
+ * @param out the output norms (size n_rows)
+ * @param row_ind CSR row offsets (size n_rows + 1)
+ * @param vals CSR values
+ * @param n_rows number of rows
+ * @param type the norm, L1Norm or L2Norm
+ * @param stream cuda stream to use
+ * @param fin_op the final lambda op applied to every norm
+ */
+template <typename T, typename Lambda = Nop<T>>
+void csr_row_norm(T *out, const int *row_ind, const T *vals, int n_rows,
+                  LinAlg::NormType type, cudaStream_t stream,
+                  Lambda fin_op = Nop<T>()) {
+  constexpr int TPB_X = 256;
+  csr_row_norm_kernel<T, TPB_X>
+    <<<ceildiv(n_rows, TPB_X), TPB_X, 0, stream>>>(out, row_ind, vals, n_rows,
+                                                   type, fin_op);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+};  // namespace Sparse
+};  // namespace MLCommon
@@ -1,30 +0,0 @@
-/*
- * Copyright (c) 2019, NVIDIA CORPORATION.
- *
- * Licensed under the Apache License, Version 2.0 (the "License");
- * you may not use this file except in compliance with the License.
- * You may obtain a copy of the License at
- *
- *     http://www.apache.org/licenses/LICENSE-2.0
- *
- * Unless required by applicable law or agreed to in writing, software
- * distributed under the License is distributed on an "AS IS" BASIS,
- * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
- * See the License for the specific language governing permissions and
- * limitations under the License.
- */
-
-#pragma once
-
-#include <nvgraph.h>
-
-namespace MLCommon {
-namespace Sparse {
-#define NVGRAPH_CHECK(call)                                                    \
-  do {                                                                         \
-    nvgraphStatus_t status = call;                                             \
-    ASSERT(status == NVGRAPH_STATUS_SUCCESS, "FAIL: call='%s', status='%d'\n", \
-           #call, status);                                                     \
-  } while (0)
-};  // namespace Sparse
-};  // namespace MLCommon
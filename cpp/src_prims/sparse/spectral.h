@@ -14,194 +14,175 @@
  * limitations under the License.
  */
 
-#include <nvgraph.h>
+#pragma once
 
-#include "sparse/nvgraph_wrappers.h"
+#include <cublas_v2.h>
+#include <cusolverDn.h>
+#include <cusparse_v2.h>
 
 #include "selection/knn.h"
 #include "sparse/coo.h"
+#include "sparse/cusparse_wrappers.h"
+#include "sparse/lanczos.h"
 
 #include "common/device_buffer.hpp"
 #include "cuml/common/cuml_allocator.hpp"
+#include "linalg/unary_op.h"
+#include "random/rng.h"
 
 #include "cuda_utils.h"
 
 namespace MLCommon {
 namespace Spectral {
 
-template <typename T>
-void fit_clusters(int *rows, int *cols, T *vals, int nnz, int n, int n_clusters,
-                  float eigen_tol, int *out,
-                  std::shared_ptr<deviceAllocator> d_alloc,
-                  cudaStream_t stream) {
-  nvgraphHandle_t graphHandle;
-  cudaDataType_t edge_dimT = CUDA_R_32F;
-  NVGRAPH_CHECK(nvgraphCreate(&graphHandle));
-
-  // Allocate csr arrays
-  device_buffer<int> src_offsets(d_alloc, stream, n + 1);
-  device_buffer<int> dst_indices(d_alloc, stream, nnz);
-
-  nvgraphCOOTopology32I_st *COO_input = new nvgraphCOOTopology32I_st();
-  COO_input->nedges = nnz;
-  COO_input->nvertices = n;
-  COO_input->source_indices = rows;
-  COO_input->destination_indices = cols;
-
-  nvgraphCSRTopology32I_st *CSR_input = new nvgraphCSRTopology32I_st();
-  CSR_input->destination_indices = dst_indices.data();
-  CSR_input->nedges = nnz;
-  CSR_input->nvertices = n;
-  CSR_input->source_offsets = src_offsets.data();
-
-  NVGRAPH_CHECK(nvgraphConvertTopology(
-    graphHandle, NVGRAPH_COO_32, (void *)COO_input, (void *)vals, &edge_dimT,
-    NVGRAPH_CSR_32, (void *)CSR_input, (void *)vals));
-
-  int weight_index = 0;
-
-  device_buffer<T> eigVals(d_alloc, stream, n_clusters);
-  device_buffer<T> embedding(d_alloc, stream, n * n_clusters);
-
-  CUDA_CHECK(cudaStreamSynchronize(stream));
-
-  // Spectral clustering parameters
-  struct SpectralClusteringParameter clustering_params;
-  clustering_params.n_clusters = n_clusters;
-  clustering_params.n_eig_vects = n_clusters;
-  clustering_params.algorithm = NVGRAPH_BALANCED_CUT_LANCZOS;
-  clustering_params.evs_tolerance = eigen_tol;
-  clustering_params.evs_max_iter = 0;
-  clustering_params.kmean_tolerance = 0.0f;
-  clustering_params.kmean_max_iter = 0;
-
-  nvgraphGraphDescr_t graph;
-  NVGRAPH_CHECK(nvgraphCreateGraphDescr(graphHandle, &graph));
-  NVGRAPH_CHECK(nvgraphSetGraphStructure(graphHandle, graph, (void *)CSR_input,
-                                         NVGRAPH_CSR_32));
-  NVGRAPH_CHECK(nvgraphAllocateEdgeData(graphHandle, graph, 1, &edge_dimT));
-  NVGRAPH_CHECK(nvgraphSetEdgeData(graphHandle, graph, (void *)vals, 0));
-
-  NVGRAPH_CHECK(nvgraphSpectralClustering(graphHandle, graph, weight_index,
-                                          &clustering_params, out,
-                                          eigVals.data(), embedding.data()));
-
-  NVGRAPH_CHECK(nvgraphDestroyGraphDescr(graphHandle, graph));
-  NVGRAPH_CHECK(nvgraphDestroy(graphHandle));
-
-  free(COO_input);
-  free(CSR_input);
+/**
+ * Accumulates the degrees of the vertices in the symmetrized graph
+ * (A + A') / 2, of which each edge of A counts half for both of its vertices
+ */
+template <int TPB_X, typename T>
+__global__ void symmetric_degree_kernel(const int *rows, const int *cols,
+                                        const T *vals, int nnz, T *degree) {
+  int e = blockIdx.x * TPB_X + threadIdx.x;
+  if (e < nnz) {
+    T half = vals[e] / T(2);
+    atomicAdd(degree + rows[e], half);
+    atomicAdd(degree + cols[e], half);
+  }
 }
 
-template <typename T>
-void fit_clusters(long *knn_indices, T *knn_dists, int m, int n_neighbors,
-                  int n_clusters, float eigen_tol, int *out,
-                  std::shared_ptr<deviceAllocator> d_alloc,
-                  cudaStream_t stream) {
-  device_buffer<int> rows(d_alloc, stream, m * n_neighbors);
-  device_buffer<int> cols(d_alloc, stream, m * n_neighbors);
-  device_buffer<T> vals(d_alloc, stream, m * n_neighbors);
-
-  MLCommon::Sparse::from_knn(knn_indices, knn_dists, m, n_neighbors,
-                             rows.data(), cols.data(), vals.data());
-
-  fit_clusters(rows.data(), cols.data(), vals.data(), m * n_neighbors, m,
-               n_clusters, eigen_tol, out, d_alloc, stream);
+/**
+ * Weights of the edges of D^-1/2 A D^-1/2 / 2, where q is the square root of
+ * the degrees
+ */
+template <int TPB_X, typename T>
+__global__ void normalize_edges_kernel(const int *rows, const int *cols,
+                                       const T *vals, int nnz, const T *q,
+                                       T *norm_vals) {
+  int e = blockIdx.x * TPB_X + threadIdx.x;
+  if (e < nnz) norm_vals[e] = vals[e] / (T(2) * q[rows[e]] * q[cols[e]]);
 }
 
+/**
+ * @brief Computes the eigenvectors of the n_eig smallest eigenvalues of the
+ * normalized Laplacian I - D^-1/2 W D^-1/2 of a weighted graph, with
+ * W = (A + A') / 2 so that the graph needs not be symmetric. They are the
+ * eigenvectors of the n_eig largest eigenvalues of I + D^-1/2 W D^-1/2, whose
+ * spectrum is in [0, 2], computed by thick-restart Lanczos iterations over
+ * cuSPARSE products with the CSR matrix of the graph. An isolated vertex
+ * gets a degree of 1.
+ *
+ * All the work is queued on stream and the temporaries come from d_alloc.
+ * A disconnected graph has the eigenvalue 0 once per connected component,
+ * an eigenspace that single-vector Lanczos iterations resolve slowly.
+ *
+ * @param rows source vertices of the graph (size nnz)
+ * @param cols destination vertices of the graph (size nnz)
+ * @param vals edge weights of the graph (size nnz)
+ * @param nnz number of edges
+ * @param n number of vertices
+ * @param n_eig number of eigenvectors, in [1, n)
+ * @param eig_vectors output eigenvectors (n, n_eig) in column-major, smallest
+ * eigenvalue first
+ * @param eigen_tol tolerance of the eigensolver, see lanczos_largest
+ * @param cublas_h cublas handle
+ * @param cusolver_h cusolver handle
+ * @param cusparse_h cusparse handle
+ * @param d_alloc device allocator for temporary buffers
+ * @param stream cuda stream to use
+ * @param seed seed of the start vector of the Lanczos iterations
+ * @return whether the eigensolver converged; the eigenvectors are the last
+ * Ritz vectors either way
+ */
 template <typename T>
-void fit_clusters(T *X, int m, int n, int n_neighbors, int n_clusters,
-                  float eigen_tol, int *out,
-                  std::shared_ptr<deviceAllocator> d_alloc,
-                  cudaStream_t stream) {
-  device_buffer<long> knn_indices(d_alloc, stream, m * n_neighbors);
-  device_buffer<float> knn_dists(d_alloc, stream, m * n_neighbors);
-
-  std::vector<float *> ptrs(1);
-  std::vector<int> sizes(1);
-  ptrs[0] = X;
-  sizes[0] = m;
-
-  MLCommon::Selection::brute_force_knn(ptrs, sizes, n, X, m, knn_indices.data(),
-                                       knn_dists.data(), n_neighbors, d_alloc,
-                                       stream);
-
-  fit_clusters(knn_indices.data(), knn_dists.data(), m, n_neighbors, n_clusters,
-               eigen_tol, out, d_alloc, stream);
+bool laplacian_eigenvectors(const int *rows, const int *cols, const T *vals,
+                            int nnz, int n, int n_eig, T *eig_vectors,
+                            T eigen_tol, cublasHandle_t cublas_h,
+                            cusolverDnHandle_t cusolver_h,
+                            cusparseHandle_t cusparse_h,
+                            std::shared_ptr<deviceAllocator> d_alloc,
+                            cudaStream_t stream, uint64_t seed = 1234ULL) {
+  constexpr int TPB_X = 256;
+  ASSERT(n_eig >= 1 && n_eig < n,
+         "Spectral: the number of eigenvectors must be in [1, n_samples)");
+
+  // CSR of the graph, from a sorted copy of the COO arrays
+  device_buffer<int> csr_rows(d_alloc, stream, nnz);
+  device_buffer<int> csr_cols(d_alloc, stream, nnz);
+  device_buffer<T> csr_vals(d_alloc, stream, nnz);
+  copyAsync(csr_rows.data(), rows, nnz, stream);
+  copyAsync(csr_cols.data(), cols, nnz, stream);
+  copyAsync(csr_vals.data(), vals, nnz, stream);
+  Sparse::coo_sort<T>(n, n, nnz, csr_rows.data(), csr_cols.data(),
+                      csr_vals.data(), d_alloc, stream);
+  device_buffer<int> row_ind(d_alloc, stream, n + 1);
+  Sparse::sorted_coo_to_csr(csr_rows.data(), nnz, row_ind.data(), n, d_alloc,
+                            stream);
+  updateDevice(row_ind.data() + n, &nnz, 1, stream);
+
+  dim3 grid_nnz(ceildiv(nnz, TPB_X), 1, 1);
+  dim3 blk(TPB_X, 1, 1);
+
+  device_buffer<T> q(d_alloc, stream, n);
+  CUDA_CHECK(cudaMemsetAsync(q.data(), 0, n * sizeof(T), stream));
+  symmetric_degree_kernel<TPB_X, T><<<grid_nnz, blk, 0, stream>>>(
+    csr_rows.data(), csr_cols.data(), csr_vals.data(), nnz, q.data());
+  LinAlg::unaryOp<T>(
+    q.data(), q.data(), n,
+    [] __device__(T degree) { return degree > T(0) ? sqrt(degree) : T(1); },
+    stream);
+  normalize_edges_kernel<TPB_X, T><<<grid_nnz, blk, 0, stream>>>(
+    csr_rows.data(), csr_cols.data(), csr_vals.data(), nnz, q.data(),
+    csr_vals.data());
+  CUDA_CHECK(cudaPeekAtLastError());
 
+  cusparseMatDescr_t descr;
+  CUSPARSE_CHECK(cusparseCreateMatDescr(&descr));
+  CUSPARSE_CHECK(cusparseSetMatType(descr, CUSPARSE_MATRIX_TYPE_GENERAL));
+  CUSPARSE_CHECK(cusparseSetMatIndexBase(descr, CUSPARSE_INDEX_BASE_ZERO));
+
+  // y = x + N x + N' x, with N = D^-1/2 A D^-1/2 / 2
+  const T one = 1;
+  auto op = [&](const T *x, T *y) {
+    copyAsync(y, x, n, stream);
+    CUSPARSE_CHECK(Sparse::cusparse_csrmv(
+      cusparse_h, CUSPARSE_OPERATION_NON_TRANSPOSE, n, n, nnz, &one, descr,
+      csr_vals.data(), row_ind.data(), csr_cols.data(), x, &one, y, stream));
+    CUSPARSE_CHECK(Sparse::cusparse_csrmv(
+      cusparse_h, CUSPARSE_OPERATION_TRANSPOSE, n, n, nnz, &one, descr,
+      csr_vals.data(), row_ind.data(), csr_cols.data(), x, &one, y, stream));
+  };
+
+  Random::Rng r(seed);
+  device_buffer<T> v0(d_alloc, stream, n);
+  r.normal(v0.data(), n, T(0), T(1), stream);
+
+  device_buffer<T> eig_vals(d_alloc, stream, n_eig);
+  bool converged = Sparse::lanczos_largest<T>(
+    op, n, n_eig, v0.data(), eig_vals.data(), eig_vectors, cublas_h,
+    cusolver_h, d_alloc, stream, 0, 50, eigen_tol);
+  CUSPARSE_CHECK(cusparseDestroyMatDescr(descr));
+  return converged;
 }
 
 template <typename T>
 void fit_embedding(int *rows, int *cols, T *vals, int nnz, int n,
-                   int n_components, T *out,
+                   int n_components, T *out, cublasHandle_t cublas_h,
+                   cusolverDnHandle_t cusolver_h, cusparseHandle_t cusparse_h,
                    std::shared_ptr<deviceAllocator> d_alloc,
                    cudaStream_t stream) {
-  nvgraphHandle_t grapHandle;
-  cudaDataType_t edge_dimT = CUDA_R_32F;
-  NVGRAPH_CHECK(nvgraphCreate(&grapHandle));
-
-  device_buffer<int> src_offsets(d_alloc, stream, n + 1);
-  device_buffer<int> dst_indices(d_alloc, stream, nnz);
-
-  nvgraphCOOTopology32I_st *COO_input = new nvgraphCOOTopology32I_st();
-  COO_input->nedges = nnz;
-  COO_input->nvertices = n;
-  COO_input->source_indices = rows;
-  COO_input->destination_indices = cols;
-
-  nvgraphCSRTopology32I_st *CSR_input = new nvgraphCSRTopology32I_st();
-  CSR_input->destination_indices = dst_indices.data();
-  CSR_input->nedges = nnz;
-  CSR_input->nvertices = n;
-  CSR_input->source_offsets = src_offsets.data();
-
-  NVGRAPH_CHECK(nvgraphConvertTopology(
-    grapHandle, NVGRAPH_COO_32, (void *)COO_input, (void *)vals, &edge_dimT,
-    NVGRAPH_CSR_32, (void *)CSR_input, (void *)vals));
-
-  int weight_index = 0;
-
-  device_buffer<T> eigVals(d_alloc, stream, n_components + 1);
-  device_buffer<T> eigVecs(d_alloc, stream, n * (n_components + 1));
-  device_buffer<int> labels(d_alloc, stream, n);
-
-  CUDA_CHECK(cudaStreamSynchronize(stream));
-
-  // Spectral clustering parameters
-  struct SpectralClusteringParameter clustering_params;
-  clustering_params.n_clusters = n_components + 1;
-  clustering_params.n_eig_vects = n_components + 1;
-  clustering_params.algorithm = NVGRAPH_BALANCED_CUT_LANCZOS;
-  clustering_params.evs_tolerance = 0.01f;
-  clustering_params.evs_max_iter = 0;
-  clustering_params.kmean_tolerance = 0.0f;
-  clustering_params.kmean_max_iter = 1;
-
-  nvgraphGraphDescr_t graph;
-  NVGRAPH_CHECK(nvgraphCreateGraphDescr(grapHandle, &graph));
-  NVGRAPH_CHECK(nvgraphSetGraphStructure(grapHandle, graph, (void *)CSR_input,
-                                         NVGRAPH_CSR_32));
-  NVGRAPH_CHECK(nvgraphAllocateEdgeData(grapHandle, graph, 1, &edge_dimT));
-  NVGRAPH_CHECK(nvgraphSetEdgeData(grapHandle, graph, (void *)vals, 0));
-
-  NVGRAPH_CHECK(nvgraphSpectralClustering(grapHandle, graph, weight_index,
-                                          &clustering_params, labels.data(),
-                                          eigVals.data(), eigVecs.data()));
-
-  NVGRAPH_CHECK(nvgraphDestroyGraphDescr(grapHandle, graph));
-  NVGRAPH_CHECK(nvgraphDestroy(grapHandle));
-
-  MLCommon::copy<T>(out, eigVecs.data() + n, n * n_components, stream);
-
+  // the eigenvector of the smallest eigenvalue, 0, is dropped
+  device_buffer<T> eig_vectors(d_alloc, stream, n * (n_components + 1));
+  laplacian_eigenvectors<T>(rows, cols, vals, nnz, n, n_components + 1,
+                            eig_vectors.data(), T(0.01), cublas_h, cusolver_h,
+                            cusparse_h, d_alloc, stream);
+  copy<T>(out, eig_vectors.data() + n, n * n_components, stream);
   CUDA_CHECK(cudaPeekAtLastError());
-
-  free(COO_input);
-  free(CSR_input);
 }
 
 template <typename T>
 void fit_embedding(long *knn_indices, float *knn_dists, int m, int n_neighbors,
-                   int n_components, T *out,
+                   int n_components, T *out, cublasHandle_t cublas_h,
+                   cusolverDnHandle_t cusolver_h, cusparseHandle_t cusparse_h,
                    std::shared_ptr<deviceAllocator> d_alloc,
                    cudaStream_t stream) {
   device_buffer<int> rows(d_alloc, stream, m * n_neighbors);
@@ -209,15 +190,18 @@ void fit_embedding(long *knn_indices, float *knn_dists, int m, int n_neighbors,
   device_buffer<T> vals(d_alloc, stream, m * n_neighbors);
 
   MLCommon::Sparse::from_knn(knn_indices, knn_dists, m, n_neighbors,
-                             rows.data(), cols.data(), vals.data());
+                             rows.data(), cols.data(), vals.data(), stream);
 
   fit_embedding(rows.data(), cols.data(), vals.data(), m * n_neighbors, m,
-                n_components, out, d_alloc, stream);
+                n_components, out, cublas_h, cusolver_h, cusparse_h, d_alloc,
+                stream);
 }
 
 template <typename T>
 void fit_embedding(T *X, int m, int n, int n_neighbors, int n_components,
-                   T *out, std::shared_ptr<deviceAllocator> d_alloc,
+                   T *out, cublasHandle_t cublas_h,
+                   cusolverDnHandle_t cusolver_h, cusparseHandle_t cusparse_h,
+                   std::shared_ptr<deviceAllocator> d_alloc,
                    cudaStream_t stream) {
   device_buffer<int64_t> knn_indices(d_alloc, stream, m * n_neighbors);
   device_buffer<float> knn_dists(d_alloc, stream, m * n_neighbors);
@@ -232,8 +216,8 @@ void fit_embedding(T *X, int m, int n, int n_neighbors, int n_components,
                                        stream);
 
   fit_embedding(knn_indices.data(), knn_dists.data(), m, n_neighbors,
-                n_components, out, d_alloc, stream);
-
+                n_components, out, cublas_h, cusolver_h, cusparse_h, d_alloc,
+                stream);
 }
 }  // namespace Spectral
 }  // namespace MLCommon
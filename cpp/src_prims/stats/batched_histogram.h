@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuml/common/cuml_allocator.hpp>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "stats/histogram.h"
+
+namespace MLCommon {
+namespace Stats {
+
+/**
+ * @defgroup BatchedHistogram
+ * @{
+ * @brief Histograms of every column of a column major dataset for every node
+ * of a tree level in one pass, as the split search of the tree builders and
+ * the quantile computation need. Column `col` has its own number of bins,
+ * given by the prefix sums `binOffsets` (ncols + 1), and each row belongs to
+ * the node `nodeIds[row]` in [0, nnodes), a negative id leaving the row out.
+ * The outputs are node major: the bin `b` of column `col` of node `node` is at
+ * `node * totalBins + binOffsets[col] + b`, totalBins being
+ * `binOffsets[ncols]`.
+ */
+
+/**
+ * Maps a row to its bin in the padded [col][node][maxBins] layout, the rows
+ * out of a node and the tail of the last vector load going to the extra bin
+ * at nnodes * maxBins.
+ */
+template <typename DataT, typename IdxT, typename BinnerOp>
+struct NodeBinner {
+  const int* nodeIds;
+  IdxT nrows, maxBins;
+  int trashBin;
+  BinnerOp binner;
+
+  DI int operator()(DataT val, IdxT row, IdxT col) {
+    if (row >= nrows) return trashBin;
+    int node = nodeIds == nullptr ? 0 : nodeIds[row];
+    return node < 0 ? trashBin : node * maxBins + binner(val, row, col);
+  }
+};
+
+template <typename IdxT, int TPB>
+__global__ void compactNodeBinsKernel(int* bins, const int* paddedBins,
+                                      const IdxT* binOffsets, IdxT ncols,
+                                      IdxT nnodes, IdxT maxBins) {
+  IdxT colStride = nnodes * maxBins + 1;
+  IdxT len = ncols * nnodes * maxBins;
+  IdxT totalBins = binOffsets[ncols];
+  for (IdxT i = threadIdx.x + IdxT(blockIdx.x) * TPB; i < len;
+       i += IdxT(gridDim.x) * TPB) {
+    IdxT col = i / (nnodes * maxBins);
+    IdxT rem = i - col * nnodes * maxBins;
+    IdxT node = rem / maxBins;
+    IdxT b = rem - node * maxBins;
+    IdxT start = binOffsets[col];
+    if (b < binOffsets[col + 1] - start) {
+      bins[node * totalBins + start + b] = paddedBins[col * colStride + rem];
+    }
+  }
+}
+
+template <typename DataT, typename BinnerOp, typename IdxT, bool UseSmem>
+__global__ void weightedHistKernel(float* sums, const DataT* data,
+                                   const float* weights, IdxT nrows,
+                                   const int* nodeIds, IdxT nnodes,
+                                   const IdxT* binOffsets, BinnerOp binner) {
+  extern __shared__ float ssums[];
+  IdxT col = blockIdx.y;
+  IdxT start = binOffsets[col];
+  IdxT nbins = binOffsets[col + 1] - start;
+  IdxT totalBins = binOffsets[gridDim.y];
+  if (UseSmem) {
+    for (IdxT i = threadIdx.x; i < nnodes * nbins; i += blockDim.x) {
+      ssums[i] = 0.f;
+    }
+    __syncthreads();
+  }
+  for (IdxT row = threadIdx.x + IdxT(blockIdx.x) * blockDim.x; row < nrows;
+       row += IdxT(gridDim.x) * blockDim.x) {
+    int node = nodeIds == nullptr ? 0 : nodeIds[row];
+    if (node < 0) continue;
+    int binId = binner(data[col * nrows + row], row, col);
+    float w = weights[row];
+    if (UseSmem) {
+      atomicAdd(ssums + node * nbins + binId, w);
+    } else {
+      atomicAdd(sums + node * totalBins + start + binId, w);
+    }
+  }
+  if (UseSmem) {
+    __syncthreads();
+    for (IdxT i = threadIdx.x; i < nnodes * nbins; i += blockDim.x) {
+      auto val = ssums[i];
+      if (val != 0.f) {
+        IdxT node = i / nbins;
+        atomicAdd(sums + node * totalBins + start + i - node * nbins, val);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Count the rows of each node falling in each bin of each column. The
+ * node histograms of a column are packed one after the other, padded to
+ * maxBins, and the strategy of histogram() is chosen for that many bins, so
+ * that the bit-packed shared memory bins take over once the full counters no
+ * longer fit.
+ * @tparam DataT input data type
+ * @tparam IdxT data type used to compute indices
+ * @tparam BinnerOp takes the input data and computes its bin index within its
+ * column, with the signature of histogram()'s
+ * @param type histogram implementation type to choose
+ * @param bins the output counts (nnodes * binOffsets[ncols]), overwritten
+ * @param binOffsets prefix sums of the number of bins of each column, starting
+ * with 0, on the device (ncols + 1)
+ * @param maxBins largest number of bins of a column
+ * @param data column major input data (nrows * ncols)
+ * @param nrows number of rows
+ * @param ncols number of columns
+ * @param nodeIds node of each row, negative for none, or nullptr for all the
+ * rows to be of node 0 (nrows)
+ * @param nnodes number of nodes
+ * @param allocator device allocator for the padded counts
+ * @param stream cuda stream
+ * @param binner the operation that computes the bin index of the input data
+ */
+template <typename DataT, typename IdxT = int,
+          typename BinnerOp = IdentityBinner<DataT, IdxT>>
+void batchedHistogram(HistType type, int* bins, const IdxT* binOffsets,
+                      IdxT maxBins, const DataT* data, IdxT nrows, IdxT ncols,
+                      const int* nodeIds, IdxT nnodes,
+                      std::shared_ptr<deviceAllocator> allocator,
+                      cudaStream_t stream,
+                      BinnerOp binner = IdentityBinner<DataT, IdxT>()) {
+  ASSERT(maxBins > 0 && nnodes > 0,
+         "batchedHistogram: need at least a bin and a node");
+  IdxT paddedNbins = nnodes * maxBins + 1;
+  device_buffer<int> paddedBins(allocator, stream, ncols * paddedNbins);
+  NodeBinner<DataT, IdxT, BinnerOp> nodeBinner = {
+    nodeIds, nrows, maxBins, int(nnodes * maxBins), binner};
+  if (nrows > 0) {
+    histogram<DataT, IdxT, NodeBinner<DataT, IdxT, BinnerOp>>(
+      type, paddedBins.data(), paddedNbins, data, nrows, ncols, stream,
+      nodeBinner);
+  } else {
+    CUDA_CHECK(cudaMemsetAsync(paddedBins.data(), 0,
+                               ncols * paddedNbins * sizeof(int), stream));
+  }
+
+  constexpr int TPB = 256;
+  IdxT len = ncols * nnodes * maxBins;
+  int nblks = std::min<IdxT>(ceildiv<IdxT>(len, TPB), 65535);
+  compactNodeBinsKernel<IdxT, TPB><<<nblks, TPB, 0, stream>>>(
+    bins, paddedBins.data(), binOffsets, ncols, nnodes, maxBins);
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Sum the weights, such as the gradients of a boosting round, of the
+ * rows of each node falling in each bin of each column. The sums of a block's
+ * column are accumulated in shared memory when the nnodes * maxBins floats
+ * fit in it, and with global atomics otherwise.
+ * @tparam DataT input data type
+ * @tparam IdxT data type used to compute indices
+ * @tparam BinnerOp takes the input data and computes its bin index within its
+ * column, with the signature of histogram()'s
+ * @param sums the output sums (nnodes * binOffsets[ncols]), overwritten
+ * @param weights weight of each row (nrows)
+ * @param binOffsets prefix sums of the number of bins of each column, starting
+ * with 0, on the device (ncols + 1)
+ * @param maxBins largest number of bins of a column
+ * @param data column major input data (nrows * ncols)
+ * @param nrows number of rows
+ * @param ncols number of columns
+ * @param nodeIds node of each row, negative for none, or nullptr for all the
+ * rows to be of node 0 (nrows)
+ * @param nnodes number of nodes
+ * @param stream cuda stream
+ * @param binner the operation that computes the bin index of the input data
+ * @note the order of the atomics varies from run to run, and so do the
+ * rounding errors of the sums
+ */
+template <typename DataT, typename IdxT = int,
+          typename BinnerOp = IdentityBinner<DataT, IdxT>>
+void batchedWeightedHistogram(float* sums, const float* weights,
+                              const IdxT* binOffsets, IdxT maxBins,
+                              const DataT* data, IdxT nrows, IdxT ncols,
+                              const int* nodeIds, IdxT nnodes,
+                              cudaStream_t stream,
+                              BinnerOp binner = IdentityBinner<DataT, IdxT>()) {
+  ASSERT(maxBins > 0 && nnodes > 0,
+         "batchedWeightedHistogram: need at least a bin and a node");
+  IdxT totalBins;
+  updateHost(&totalBins, binOffsets + ncols, 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  CUDA_CHECK(
+    cudaMemsetAsync(sums, 0, nnodes * totalBins * sizeof(float), stream));
+  if (nrows <= 0) return;
+
+  size_t smemSize = nnodes * maxBins * sizeof(float);
+  if (smemSize <= getSharedMemPerBlock()) {
+    auto blks = computeGridDim<IdxT, 1>(
+      nrows, ncols,
+      (const void*)weightedHistKernel<DataT, BinnerOp, IdxT, true>);
+    weightedHistKernel<DataT, BinnerOp, IdxT, true>
+      <<<blks, ThreadsPerBlock, smemSize, stream>>>(
+        sums, data, weights, nrows, nodeIds, nnodes, binOffsets, binner);
+  } else {
+    auto blks = computeGridDim<IdxT, 1>(
+      nrows, ncols,
+      (const void*)weightedHistKernel<DataT, BinnerOp, IdxT, false>);
+    weightedHistKernel<DataT, BinnerOp, IdxT, false>
+      <<<blks, ThreadsPerBlock, 0, stream>>>(sums, data, weights, nrows,
+                                             nodeIds, nnodes, binOffsets,
+                                             binner);
+  }
+  CUDA_CHECK(cudaPeekAtLastError());
+}
+/** @} */
+
+};  // end namespace Stats
+};  // end namespace MLCommon
@@ -13,318 +13,431 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+
+#pragma once
+
 /**
 * @file stationarity.h
 * @brief Compute the recommended trend parameter for a batched series.
-* Reference: 'Testing the null hypothesis of stationarity against the
-* alternative of a unit root', Kwiatkowski et al. 1992.
-* See https://www.statsmodels.org/dev/_modules/statsmodels/tsa/stattools.html#kpss
+* References: 'Testing the null hypothesis of stationarity against the
+* alternative of a unit root', Kwiatkowski et al. 1992, for the KPSS test;
+* 'Distribution of the estimators for autoregressive time series with a unit
+* root', Dickey and Fuller 1979, and 'Critical values for cointegration
+* tests', MacKinnon 2010, for the augmented Dickey-Fuller test.
+* See https://www.statsmodels.org/dev/_modules/statsmodels/tsa/stattools.html
 * for additional details.
 */
 
 #include <math.h>
-#include <thrust/device_ptr.h>
-#include <thrust/execution_policy.h>
-#include <thrust/iterator/counting_iterator.h>
-#include <thrust/iterator/transform_iterator.h>
-#include <thrust/scan.h>
+#include <algorithm>
+#include <cub/cub.cuh>
 #include <vector>
 
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
 #include "cuml/common/cuml_allocator.hpp"
-#include "linalg/cublas_wrappers.h"
-#include "linalg/matrix_vector_op.h"
-#include "linalg/reduce.h"
-#include "stats/mean.h"
 #include "utils.h"
 
 namespace MLCommon {
 
 namespace TimeSeries {
 
+/** The stationarity tests */
+enum StationarityTestType {
+  /** Null hypothesis of (level) stationarity, Kwiatkowski et al. 1992 */
+  KPSS = 0,
+  /** Null hypothesis of a unit root, augmented Dickey-Fuller */
+  ADF = 1
+};
+
+//! Maximum number of lagged differences in the ADF regression
+constexpr int ADF_MAX_LAGS = 30;
+
 /**
-* @brief Auxiliary function to decide the block dimensions
-*
-* @tparam     TPB        Threads per block
-* @tparam     IdxT       Integer type of the indices
-* @param[in]  n_batches  Number of batches in the input data
-* @return                The block dimensions
-*/
-template <int TPB, typename IdxT>
-static inline dim3 choose_block_dims(IdxT n_batches) {
-  uint tpb_y = n_batches > 8 ? 4 : 1;
-  dim3 block(TPB / tpb_y, tpb_y);
-  return block;
+ * @brief Value of the d-th difference of a series at a given index
+ *
+ * @tparam     DataT  Scalar type of the data (float or double)
+ * @param[in]  y      The series
+ * @param[in]  i      Index in the differenced series (uses y[i..i+d])
+ * @param[in]  d      Order of differencing
+ * @return            sum over k of (-1)^(d-k) C(d,k) y[i+k]
+ */
+template <typename DataT>
+DI DataT diff_value(const DataT* y, int i, int d) {
+  DataT res = static_cast<DataT>(0.0);
+  DataT coeff = static_cast<DataT>(1.0);
+  for (int k = 0; k <= d; k++) {
+    res += ((d - k) % 2 ? -coeff : coeff) * y[i + k];
+    coeff = coeff * static_cast<DataT>(d - k) / static_cast<DataT>(k + 1);
+  }
+  return res;
 }
 
+/** Shared memory of the block-wide primitives of the fused kernel */
+template <typename DataT, int TPB>
+union StationarityTempStorage {
+  typename cub::BlockReduce<DataT, TPB>::TempStorage reduce;
+  typename cub::BlockScan<DataT, TPB>::TempStorage scan;
+};
+
 /**
-* @brief Kernel to batch the first differences of a selection of series
-*
-* @details The kernel combines 2 operations: selecting a number of series from
-*          the original data and derivating them (calculating the difference of
-*          consecutive terms)
-*
-* @note The number of batches in the input matrix is not known by this function
-*       which trusts the gather_map array to hold correct column numbers. The
-*       number of samples in the input matrix is one more than in the output.
-*
-* @tparam      DataT           Scalar type of the data (float or double)
-* @tparam      IdxT            Integer type of the indices
-* @param[out]  diff            Output matrix
-* @param[in]   data            Input matrix
-* @param[in]   gather_map      Array that indicates the source column in the
-                               input matrix for each column of the output matrix
-* @param[in]   n_diff_batches  Number of columns in the output matrix
-* @param[in]   n_diff_samples  Number of rows in the output matrix
-*/
-template <typename DataT, typename IdxT>
-static __global__ void gather_diff_kernel(DataT* diff, const DataT* data,
-                                          IdxT* gather_map, IdxT n_diff_batches,
-                                          IdxT n_diff_samples) {
-  IdxT sample_idx = blockIdx.x * blockDim.x + threadIdx.x;
-  IdxT batch_idx = blockIdx.y * blockDim.y + threadIdx.y;
-
-  if (batch_idx < n_diff_batches && sample_idx < n_diff_samples) {
-    IdxT source_batch_idx = gather_map[batch_idx];
-    IdxT source_location = source_batch_idx * (n_diff_samples + 1) + sample_idx;
-    diff[batch_idx * n_diff_samples + sample_idx] =
-      data[source_location + 1] - data[source_location];
+ * @brief Block-wide sum, broadcast to all the threads of the block
+ *
+ * @tparam      DataT      Scalar type of the data (float or double)
+ * @tparam      TPB        Threads per block
+ * @param[in]   val        Contribution of the thread
+ * @param[in]   temp       Shared memory of the block primitives
+ * @param[in]   broadcast  Shared variable used for the broadcast
+ * @return                 The sum of the contributions
+ */
+template <typename DataT, int TPB>
+DI DataT block_sum(DataT val, StationarityTempStorage<DataT, TPB>& temp,
+                   DataT* broadcast) {
+  DataT total = cub::BlockReduce<DataT, TPB>(temp.reduce).Sum(val);
+  if (threadIdx.x == 0) *broadcast = total;
+  __syncthreads();
+  total = *broadcast;
+  __syncthreads();
+  return total;
+}
+
+/**
+ * @brief Interpolate the p-value of the KPSS statistic in Table 1 of
+ *        Kwiatkowski 1992
+ */
+template <typename DataT>
+DI DataT kpss_pvalue(DataT kpss_stat) {
+  const DataT crit_vals[4] = {0.347, 0.463, 0.574, 0.739};
+  const DataT pvals[4] = {0.10, 0.05, 0.025, 0.01};
+
+  DataT pvalue = pvals[0];
+#pragma unroll
+  for (int k = 0; k < 3; k++) {
+    if (kpss_stat >= crit_vals[k] && kpss_stat < crit_vals[k + 1]) {
+      pvalue = pvals[k] + (pvals[k + 1] - pvals[k]) *
+                            (kpss_stat - crit_vals[k]) /
+                            (crit_vals[k + 1] - crit_vals[k]);
+    }
+  }
+  if (kpss_stat >= crit_vals[3]) {
+    pvalue = pvals[3];
   }
+  return pvalue;
 }
 
 /**
- * @brief Auxiliary kernel for the computation of s2 (Kwiatkowski 1992 eq.10)
- * 
- * @details The kernel computes partial sums for the term of equation 10.
- *          A reduction is performed to get the full sum.
- *          If y is a series and z the accumulator, this kernel computes:
- *          z[t] = w(k) * sum from k=1 to lags of y[t]*y[t+k]
- *          padded with zeros and where w(k)=2/ns*(1-k/(lags+1))
- * 
- * @note The accumulator has one extra element per series, which avoids some
- *       index calculations and it has the right size anyway since it is
- *       recycled for another operation.
- *       Performance note: this kernel could use shared memory
- * 
- * @tparam      DataT        Scalar type of the data (float or double)
- * @tparam      IdxT         Integer type of the indices
- * @param[out]  accumulator  Output matrix that holds the partial sums
- * @param[in]   data         Source data
- * @param[in]   lags         Number of lags
- * @param[in]   n_batches    Number of columns in the data
- * @param[in]   n_samples    Number of rows in the data
- * @param[in]   coeff_a      Part of the calculation for w(k)=a*k+b
- * @param[in]   coeff_b      Part of the calculation for w(k)=a*k+b
-*/
-template <typename DataT, typename IdxT>
-static __global__ void s2B_accumulation_kernel(DataT* accumulator,
-                                               const DataT* data, IdxT lags,
-                                               IdxT n_batches, IdxT n_samples,
-                                               DataT coeff_a, DataT coeff_b) {
-  IdxT sample_idx = blockIdx.x * blockDim.x + threadIdx.x;
-  IdxT batch_idx = blockIdx.y * blockDim.y + threadIdx.y;
-
-  if (sample_idx < n_samples && batch_idx < n_batches) {
-    IdxT idx = batch_idx * n_samples + sample_idx;
-    accumulator[idx] = static_cast<DataT>(0.0);
-    for (IdxT k = 1; k <= lags && sample_idx < n_samples - k; k++) {
-      DataT dp = data[idx] * data[idx + k];
-      DataT coeff = coeff_a * static_cast<DataT>(k) + coeff_b;
-      accumulator[idx] += coeff * dp;
+ * @brief Interpolate the p-value of the ADF statistic (with a constant) in
+ *        the finite-sample critical values of MacKinnon 2010 (Table 2)
+ */
+template <typename DataT>
+DI DataT adf_pvalue(DataT adf_stat, int n_obs) {
+  const DataT b0[3] = {-3.43035, -2.86154, -2.56677};
+  const DataT b1[3] = {-6.5393, -2.8903, -1.5384};
+  const DataT b2[3] = {-16.786, -4.234, -2.809};
+  const DataT pvals[3] = {0.01, 0.05, 0.10};
+  DataT invn = static_cast<DataT>(1.0) / static_cast<DataT>(n_obs);
+  DataT crit_vals[3];
+#pragma unroll
+  for (int k = 0; k < 3; k++) {
+    crit_vals[k] = b0[k] + invn * (b1[k] + invn * b2[k]);
+  }
+
+  DataT pvalue = pvals[0];
+#pragma unroll
+  for (int k = 0; k < 2; k++) {
+    if (adf_stat >= crit_vals[k] && adf_stat < crit_vals[k + 1]) {
+      pvalue = pvals[k] + (pvals[k + 1] - pvals[k]) *
+                            (adf_stat - crit_vals[k]) /
+                            (crit_vals[k + 1] - crit_vals[k]);
     }
   }
+  if (adf_stat >= crit_vals[2]) {
+    pvalue = pvals[2];
+  }
+  return pvalue;
 }
 
 /**
- * @brief Kernel to decide whether the series are stationary or not
- * 
- * @details The kernel uses the results of the different equations to
- *          make the final decision for each series.
+ * @brief KPSS statistic of the d-th difference of a series, computed by a
+ *        block of threads
  *
- * @tparam      DataT           Scalar type of the data (float or double)
- * @tparam      IdxT            Integer type of the indices
- * @param[out]  results         Boolean array to store the results.
- * @param[in]   s2A             1st component of eq.10 (before division by ns)
- * @param[in]   s2B             2nd component of eq.10
- * @param[in]   eta             Eq.11 (before division by ns^2)
- * @param[in]   n_batches       Number of batches
- * @param[in]   n_samples_f     Number of samples (floating-point number)
- * @param[in]   pval_threshold  P-value threshold above which the series is
- *                              considered stationary
-*/
-template <typename DataT, typename IdxT>
-static __global__ void stationarity_check_kernel(
-  bool* results, const DataT* s2A, const DataT* s2B, const DataT* eta,
-  IdxT n_batches, DataT n_samples_f, DataT pval_threshold) {
-  // Table 1, Kwiatkowski 1992
-  const DataT crit_vals[4] = {0.347, 0.463, 0.574, 0.739};
-  const DataT pvals[4] = {0.10, 0.05, 0.025, 0.01};
-
-  IdxT i = blockIdx.x * blockDim.x + threadIdx.x;
+ * @details Following Kwiatkowski 1992, the series is centered around its mean,
+ *          then the long-run variance s^2 (eq. 10) and eta (eq. 11) are
+ *          reduced over the block. The cumulative sum of eq. 11 is a scan over
+ *          contiguous chunks of the series, one per thread.
+ *
+ * @tparam      DataT      Scalar type of the data (float or double)
+ * @tparam      TPB        Threads per block
+ * @param[in]   y          The series (shared or global memory)
+ * @param[in]   n_d        Number of samples of the differenced series
+ * @param[in]   d          Order of differencing
+ * @param[in]   temp       Shared memory of the block primitives
+ * @param[in]   broadcast  Shared variable used for the broadcasts
+ * @return                 The KPSS statistic
+ */
+template <typename DataT, int TPB>
+DI DataT kpss_block(const DataT* y, int n_d, int d,
+                    StationarityTempStorage<DataT, TPB>& temp,
+                    DataT* broadcast) {
+  DataT n_d_f = static_cast<DataT>(n_d);
+
+  DataT thread_sum = static_cast<DataT>(0.0);
+  for (int i = threadIdx.x; i < n_d; i += TPB) {
+    thread_sum += diff_value(y, i, d);
+  }
+  DataT mean = block_sum(thread_sum, temp, broadcast) / n_d_f;
 
-  if (i < n_batches) {
-    DataT s2Ai = s2A[i];
-    DataT etai = eta[i];
-    DataT s2Bi = s2B[i];
+  // From Kwiatkowski et al. referencing Schwert (1989)
+  DataT lags_f = ceil(12.0 * pow(n_d_f / 100.0, 0.25));
+  int lags = static_cast<int>(lags_f);
+  DataT coeff_base = static_cast<DataT>(2.0) / n_d_f;
+  DataT coeff_a = -coeff_base / (lags_f + static_cast<DataT>(1.0));
+
+  // The two sums of eq. 10
+  DataT thread_s2A = static_cast<DataT>(0.0);
+  DataT thread_s2B = static_cast<DataT>(0.0);
+  for (int i = threadIdx.x; i < n_d; i += TPB) {
+    DataT yi = diff_value(y, i, d) - mean;
+    thread_s2A += yi * yi;
+    for (int k = 1; k <= lags && i < n_d - k; k++) {
+      DataT coeff = coeff_a * static_cast<DataT>(k) + coeff_base;
+      thread_s2B += coeff * yi * (diff_value(y, i + k, d) - mean);
+    }
+  }
+  DataT s2A = block_sum(thread_s2A, temp, broadcast) / n_d_f;
+  DataT s2B = block_sum(thread_s2B, temp, broadcast);
+
+  // Eq. 11, the offset of each chunk in the cumulative sum by a block scan
+  int chunk = ceildiv<int>(n_d, TPB);
+  int start = min(static_cast<int>(threadIdx.x) * chunk, n_d);
+  int end = min(start + chunk, n_d);
+  DataT chunk_sum = static_cast<DataT>(0.0);
+  for (int i = start; i < end; i++) chunk_sum += diff_value(y, i, d) - mean;
+  DataT csum;
+  cub::BlockScan<DataT, TPB>(temp.scan).ExclusiveSum(chunk_sum, csum);
+  __syncthreads();
+  DataT thread_eta = static_cast<DataT>(0.0);
+  for (int i = start; i < end; i++) {
+    csum += diff_value(y, i, d) - mean;
+    thread_eta += csum * csum;
+  }
+  DataT eta = block_sum(thread_eta, temp, broadcast) / (n_d_f * n_d_f);
 
-    s2Ai /= n_samples_f;
-    etai /= n_samples_f * n_samples_f;
+  return eta / (s2A + s2B);
+}
 
-    DataT kpss_stat = etai / (s2Ai + s2Bi);
+/**
+ * @brief Regressor of the ADF regression of the differenced series x
+ *
+ * @details The regression of x[t] - x[t-1] on 1, x[t-1] and the lagged
+ *          differences x[t-l] - x[t-l-1]. The level is centered, which leaves
+ *          its coefficient unchanged and keeps the normal equations well
+ *          conditioned
+ *
+ * @param[in]  y     The series before differencing
+ * @param[in]  t     Time index in the differenced series
+ * @param[in]  j     0 for the constant, 1 for the level, l+1 for the lag l,
+ *                   -1 for the response
+ * @param[in]  d     Order of differencing
+ * @param[in]  mean  Mean of the differenced series
+ */
+template <typename DataT>
+DI DataT adf_regressor(const DataT* y, int t, int j, int d, DataT mean) {
+  if (j == 0) return static_cast<DataT>(1.0);
+  if (j == 1) return diff_value(y, t - 1, d) - mean;
+  int l = j == -1 ? 0 : j - 1;
+  return diff_value(y, t - l, d) - diff_value(y, t - l - 1, d);
+}
 
-    // Interpolate the pvalue (y) based on the kpss stat (x)
-    DataT pvalue = pvals[0];
-#pragma unroll
-    for (IdxT k = 0; k < 3; k++) {
-      if (kpss_stat >= crit_vals[k] && kpss_stat < crit_vals[k + 1]) {
-        pvalue = pvals[k] + (pvals[k + 1] - pvals[k]) *
-                              (kpss_stat - crit_vals[k]) /
-                              (crit_vals[k + 1] - crit_vals[k]);
+/**
+ * @brief ADF statistic of the d-th difference of a series, computed by a
+ *        block of threads
+ *
+ * @details The normal equations of the regression are accumulated in shared
+ *          memory, one entry per thread, and solved by a Cholesky
+ *          factorization on the first thread. The statistic is the t-ratio of
+ *          the coefficient of the level. A degenerate regression (e.g a
+ *          constant series) gives -inf, i.e the unit root is rejected
+ *
+ * @tparam      DataT      Scalar type of the data (float or double)
+ * @tparam      TPB        Threads per block
+ * @param[in]   y          The series (shared or global memory)
+ * @param[in]   n_d        Number of samples of the differenced series
+ * @param[in]   d          Order of differencing
+ * @param[in]   temp       Shared memory of the block primitives
+ * @param[in]   xtx        Shared normal equations, (ADF_MAX_LAGS + 2)^2 +
+ *                         ADF_MAX_LAGS + 3 elements
+ * @param[in]   broadcast  Shared variable used for the broadcasts
+ * @return                 The ADF statistic
+ */
+template <typename DataT, int TPB>
+DI DataT adf_block(const DataT* y, int n_d, int d,
+                   StationarityTempStorage<DataT, TPB>& temp, DataT* xtx,
+                   DataT* broadcast) {
+  DataT n_d_f = static_cast<DataT>(n_d);
+
+  DataT thread_sum = static_cast<DataT>(0.0);
+  for (int i = threadIdx.x; i < n_d; i += TPB) {
+    thread_sum += diff_value(y, i, d);
+  }
+  DataT mean = block_sum(thread_sum, temp, broadcast) / n_d_f;
+
+  // Schwert (1989), as in the KPSS test, leaving enough observations
+  int lags = static_cast<int>(ceil(12.0 * pow(n_d_f / 100.0, 0.25)));
+  lags = max(0, min(min(lags, ADF_MAX_LAGS), n_d / 2 - 3));
+  int k = lags + 2;
+  int t0 = lags + 1;
+  int n_obs = n_d - t0;
+
+  // X'X (k x k), then X'y (k) and y'y
+  DataT* xty = xtx + k * k;
+  for (int e = threadIdx.x; e < k * k + k + 1; e += TPB) {
+    int a, b;
+    if (e < k * k) {
+      a = e / k;
+      b = e % k;
+    } else {
+      a = -1;
+      b = e < k * k + k ? e - k * k : -1;
+    }
+    DataT acc = static_cast<DataT>(0.0);
+    for (int t = t0; t < n_d; t++) {
+      acc += adf_regressor(y, t, a, d, mean) * adf_regressor(y, t, b, d, mean);
+    }
+    xtx[e] = acc;
+  }
+  __syncthreads();
+
+  if (threadIdx.x == 0) {
+    DataT stat = -INFINITY;
+    bool degenerate = false;
+    // Cholesky factorization X'X = L L', in the lower part
+    for (int j = 0; j < k; j++) {
+      DataT diag = xtx[j * k + j];
+      for (int l = 0; l < j; l++) diag -= xtx[j * k + l] * xtx[j * k + l];
+      if (!(diag > static_cast<DataT>(0.0))) {
+        degenerate = true;
+        break;
+      }
+      diag = sqrt(diag);
+      xtx[j * k + j] = diag;
+      for (int i = j + 1; i < k; i++) {
+        DataT v = xtx[i * k + j];
+        for (int l = 0; l < j; l++) v -= xtx[i * k + l] * xtx[j * k + l];
+        xtx[i * k + j] = v / diag;
       }
     }
-    if (kpss_stat >= crit_vals[3]) {
-      pvalue = pvals[3];
+    if (!degenerate) {
+      // z = inv(L) X'y, w = inv(L) e_1, then beta_1 = (inv(L') z)_1 and
+      // inv(X'X)_11 = w'w
+      DataT rss = xty[k];
+      for (int i = 0; i < k; i++) {
+        DataT v = xty[i];
+        for (int l = 0; l < i; l++) v -= xtx[i * k + l] * xty[l];
+        xty[i] = v / xtx[i * k + i];
+        rss -= xty[i] * xty[i];
+      }
+      for (int i = k - 1; i >= 0; i--) {
+        DataT v = xty[i];
+        for (int l = i + 1; l < k; l++) v -= xtx[l * k + i] * xty[l];
+        xty[i] = v / xtx[i * k + i];
+      }
+      DataT inv11 = static_cast<DataT>(0.0);
+      DataT w[ADF_MAX_LAGS + 2];
+      for (int i = 1; i < k; i++) {
+        DataT v = i == 1 ? static_cast<DataT>(1.0) : static_cast<DataT>(0.0);
+        for (int l = 1; l < i; l++) v -= xtx[i * k + l] * w[l];
+        w[i] = v / xtx[i * k + i];
+        inv11 += w[i] * w[i];
+      }
+      DataT sigma2 = rss / static_cast<DataT>(n_obs - k);
+      if (sigma2 > static_cast<DataT>(0.0)) {
+        stat = xty[1] / sqrt(sigma2 * inv11);
+      }
     }
-
-    // A higher pvalue means a higher chance that the data is stationary
-    results[i] = (pvalue > pval_threshold);
+    *broadcast = stat;
   }
+  __syncthreads();
+  DataT stat = *broadcast;
+  __syncthreads();
+  return stat;
 }
 
-/* A structure that defines a function to get the column of an element of
- * a matrix from its index. This makes possible a 2d scan with thrust.
- * Found in thrust/examples/scan_matrix_by_rows.cu
- */
-template <typename IdxT>
-struct which_col : thrust::unary_function<IdxT, IdxT> {
-  IdxT col_length;
-  __host__ __device__ which_col(IdxT col_length_) : col_length(col_length_) {}
-  __host__ __device__ IdxT operator()(IdxT idx) const {
-    return idx / col_length;
-  }
-};
-
 /**
- * @brief Applies the stationarity test to the given series
- * 
- * @details The following algorithm is based on Kwiatkowski 1992:
- *          - Center each series around its mean
- *          - Calculate s^2 (eq. 10) and eta (eq. 11)
- *          - Deduce the p-value and compare against the threshold
- * 
- * @note The data is a column-major matrix where the series are columns.
- *       This function will be called at most twice by `stationarity`
+ * @brief Fused kernel of the stationarity tests, one block per series
+ *
+ * @details The series is loaded once (in shared memory when it fits) and its
+ *          differences are computed on the fly, so that all the orders from 0
+ *          to max_d are tested in a single pass. The first order that passes
+ *          the test is kept, or -1 if none does
  *
  * @tparam      DataT           Scalar type of the data (float or double)
- * @tparam      IdxT            Integer type of the indices
- * @param[in]   y_d             Input data
- * @param[out]  results         Boolean array to store the results of the test
- * @param[in]   n_batches       Number of batches
+ * @tparam      TPB             Threads per block
+ * @param[out]  d_out           Selected order of differencing of each series
+ * @param[in]   y_d             Input data (column-major, series are columns)
  * @param[in]   n_samples       Number of samples
- * @param[in]   allocator       cuML device memory allocator
- * @param[in]   stream          CUDA stream
- * @param[in]   pval_threshold  P-value threshold above which a series is
- *                              considered stationary 
+ * @param[in]   max_d           Maximum order of differencing
+ * @param[in]   test            The stationarity test
+ * @param[in]   pval_threshold  P-value threshold of the test
+ * @param[in]   use_smem        Whether the series is copied to shared memory
  */
-template <typename DataT, typename IdxT>
-static void _is_stationary(const DataT* y_d, bool* results, IdxT n_batches,
-                           IdxT n_samples,
-                           std::shared_ptr<MLCommon::deviceAllocator> allocator,
-                           cudaStream_t stream, DataT pval_threshold) {
-  constexpr int TPB = 256;
-  dim3 block = choose_block_dims<TPB>(n_batches);
-  dim3 grid(ceildiv<IdxT>(n_samples, block.x),
-            ceildiv<IdxT>(n_batches, block.y));
-
-  DataT n_samples_f = static_cast<DataT>(n_samples);
-
-  // Compute mean
-  DataT* y_means_d =
-    (DataT*)allocator->allocate(n_batches * sizeof(DataT), stream);
-  MLCommon::Stats::mean(y_means_d, y_d, n_batches, n_samples, false, false,
-                        stream);
-
-  // Center the data around its mean
-  DataT* y_cent_d =
-    (DataT*)allocator->allocate(n_batches * n_samples * sizeof(DataT), stream);
-  MLCommon::LinAlg::matrixVectorOp(
-    y_cent_d, y_d, y_means_d, n_batches, n_samples, false, true,
-    [] __device__(DataT a, DataT b) { return a - b; }, stream);
-
-  // This calculates the first sum in eq. 10 (first part of s^2)
-  DataT* s2A_d = (DataT*)allocator->allocate(n_batches * sizeof(DataT), stream);
-  MLCommon::LinAlg::reduce(s2A_d, y_cent_d, n_batches, n_samples,
-                           static_cast<DataT>(0.0), false, false, stream, false,
-                           L2Op<DataT>(), Sum<DataT>());
-
-  // From Kwiatkowski et al. referencing Schwert (1989)
-  DataT lags_f = ceil(12.0 * pow(n_samples_f / 100.0, 0.25));
-  IdxT lags = static_cast<IdxT>(lags_f);
-
-  /* This accumulator will be used for both the calculation of s2B, and later
-   * the cumulative sum or y_cent_d */
-  DataT* accumulator_d =
-    (DataT*)allocator->allocate(n_batches * n_samples * sizeof(DataT), stream);
-
-  // This calculates the second sum in eq. 10 (second part of s^2)
-  DataT coeff_base = static_cast<DataT>(2.0) / n_samples_f;
-  s2B_accumulation_kernel<<<grid, block, 0, stream>>>(
-    accumulator_d, y_cent_d, lags, n_batches, n_samples,
-    -coeff_base / (lags_f + static_cast<DataT>(1.0)), coeff_base);
-  CUDA_CHECK(cudaPeekAtLastError());
-  DataT* s2B_d = (DataT*)allocator->allocate(n_batches * sizeof(DataT), stream);
-  MLCommon::LinAlg::reduce(s2B_d, accumulator_d, n_batches, n_samples,
-                           static_cast<DataT>(0.0), false, false, stream,
-                           false);
-
-  // Cumulative sum (inclusive scan with + operator)
-  thrust::counting_iterator<IdxT> c_first(0);
-  thrust::transform_iterator<which_col<IdxT>, thrust::counting_iterator<IdxT>>
-    t_first(c_first, which_col<IdxT>(n_samples));
-  thrust::device_ptr<DataT> __y_cent = thrust::device_pointer_cast(y_cent_d);
-  thrust::device_ptr<DataT> __csum = thrust::device_pointer_cast(accumulator_d);
-  thrust::inclusive_scan_by_key(thrust::cuda::par.on(stream), t_first,
-                                t_first + n_batches * n_samples, __y_cent,
-                                __csum);
-
-  // Eq. 11 (eta)
-  DataT* eta_d = (DataT*)allocator->allocate(n_batches * sizeof(DataT), stream);
-  MLCommon::LinAlg::reduce(eta_d, accumulator_d, n_batches, n_samples,
-                           static_cast<DataT>(0.0), false, false, stream, false,
-                           L2Op<DataT>(), Sum<DataT>());
-
-  /* The following kernel will decide whether each series is stationary based on
-   * s^2 and eta */
-  bool* results_d =
-    (bool*)allocator->allocate(n_batches * sizeof(bool), stream);
-  stationarity_check_kernel<<<ceildiv<int>(n_batches, TPB), TPB, 0, stream>>>(
-    results_d, s2A_d, s2B_d, eta_d, n_batches, n_samples_f, pval_threshold);
-  CUDA_CHECK(cudaPeekAtLastError());
-
-  MLCommon::updateHost(results, results_d, n_batches, stream);
-  CUDA_CHECK(cudaStreamSynchronize(stream));
+template <typename DataT, int TPB>
+__global__ void stationarity_fused_kernel(int* d_out, const DataT* y_d,
+                                          int n_samples, int max_d,
+                                          StationarityTestType test,
+                                          DataT pval_threshold,
+                                          bool use_smem) {
+  extern __shared__ char stationarity_smem[];
+  __shared__ StationarityTempStorage<DataT, TPB> temp;
+  __shared__ DataT xtx[(ADF_MAX_LAGS + 2) * (ADF_MAX_LAGS + 3) + 1];
+  __shared__ DataT broadcast;
+
+  const DataT* y = y_d + static_cast<size_t>(blockIdx.x) * n_samples;
+  if (use_smem) {
+    DataT* y_shared = (DataT*)stationarity_smem;
+    for (int i = threadIdx.x; i < n_samples; i += TPB) y_shared[i] = y[i];
+    __syncthreads();
+    y = y_shared;
+  }
 
-  /* Free device memory */
-  allocator->deallocate(y_means_d, n_batches * sizeof(DataT), stream);
-  allocator->deallocate(y_cent_d, n_batches * n_samples * sizeof(DataT),
-                        stream);
-  allocator->deallocate(accumulator_d, n_batches * n_samples * sizeof(DataT),
-                        stream);
-  allocator->deallocate(eta_d, n_batches * sizeof(DataT), stream);
-  allocator->deallocate(s2A_d, n_batches * sizeof(DataT), stream);
-  allocator->deallocate(s2B_d, n_batches * sizeof(DataT), stream);
-  allocator->deallocate(results_d, n_batches * sizeof(bool), stream);
+  int result = -1;
+  for (int d = 0; d <= max_d; d++) {
+    int n_d = n_samples - d;
+    bool is_statio;
+    if (test == KPSS) {
+      // A higher pvalue means a higher chance that the data is stationary
+      DataT kpss_stat = kpss_block(y, n_d, d, temp, &broadcast);
+      is_statio = kpss_pvalue(kpss_stat) > pval_threshold;
+    } else {
+      // A lower pvalue means a higher chance that there is no unit root
+      DataT adf_stat = adf_block(y, n_d, d, temp, xtx, &broadcast);
+      is_statio = adf_pvalue(adf_stat, n_d) < pval_threshold;
+    }
+    if (is_statio) {
+      result = d;
+      break;
+    }
+  }
+  if (threadIdx.x == 0) d_out[blockIdx.x] = result;
 }
 
 /**
- * @brief Compute recommended trend parameter (d=0 or 1) for a batched series
- * 
+ * @brief Compute recommended trend parameter (d=0 to max_d) for a batched
+ *        series
+ *
  * @details This function operates a stationarity test on the given series
- *          and for the series that fails the test, differenciates them
- *          and runs the test again on the first difference.
- * 
+ *          and its successive differences, and selects for each series the
+ *          smallest order of differencing that passes the test. All the
+ *          orders are tested by a single fused kernel with a block per
+ *          series.
+ *
  * @note The data is a column-major matrix where the series are columns.
  *       The output is an array of size n_batches.
- * 
+ *       The KPSS test is a test of level stationarity: a series is stationary
+ *       if the p-value is above the threshold. The ADF test is a test of a
+ *       unit root, with a constant: a series is stationary if the p-value is
+ *       below the threshold.
+ *
  * @tparam      DataT           Scalar type of the data (float or double)
  * @tparam      IdxT            Integer type of the indices
  * @param[in]   y_d             Input data
@@ -333,74 +446,48 @@ static void _is_stationary(const DataT* y_d, bool* results, IdxT n_batches,
  * @param[in]   n_samples       Number of samples
  * @param[in]   allocator       cuML device memory allocator
  * @param[in]   stream          CUDA stream
- * @param[in]   pval_threshold  P-value threshold above which a series is
- *                              considered stationary
- * 
+ * @param[in]   pval_threshold  P-value threshold of the test
+ * @param[in]   test            The stationarity test (KPSS or ADF)
+ * @param[in]   max_d           Maximum order of differencing
+ *
  * @return      An integer to track if some series failed the test
  * @retval  -1  Some series failed the test
  * @retval   0  All series passed the test for d=0
- * @retval   1  Some series passed for d=0, the others for d=1
+ * @retval   k  All the series passed the test, some for d=k and the others
+ *              for d<k
  */
 template <typename DataT, typename IdxT>
 int stationarity(const DataT* y_d, int* d, IdxT n_batches, IdxT n_samples,
                  std::shared_ptr<MLCommon::deviceAllocator> allocator,
-                 cudaStream_t stream, DataT pval_threshold = 0.05) {
-  // Run the test for d=0
-  bool is_statio[n_batches];
-  _is_stationary(y_d, is_statio, n_batches, n_samples, allocator, stream,
-                 pval_threshold);
-
-  // Check the results
-  std::vector<int> gather_map_h;
-  for (IdxT i = 0; i < n_batches; i++) {
-    if (is_statio[i]) {
-      d[i] = 0;
-    } else {
-      gather_map_h.push_back(i);
-    }
-  }
-
-  IdxT n_diff_batches = gather_map_h.size();
-  if (n_diff_batches == 0) return 0;  // All series are stationary with d=0
-
-  /* Construct a matrix of the first difference of the series that failed
-       the test for d=0 */
-  IdxT n_diff_samples = n_samples - 1;
-  IdxT* gather_map_d =
-    (IdxT*)allocator->allocate(n_diff_batches * sizeof(int), stream);
-  MLCommon::updateDevice(gather_map_d, gather_map_h.data(), n_diff_batches,
-                         stream);
-  DataT* y_diff_d = (DataT*)allocator->allocate(
-    n_diff_batches * n_diff_samples * sizeof(DataT), stream);
-
+                 cudaStream_t stream, DataT pval_threshold = 0.05,
+                 StationarityTestType test = KPSS, int max_d = 1) {
+  ASSERT(max_d >= 0, "stationarity: max_d must be non-negative");
+  ASSERT(n_samples - max_d >= 8,
+         "stationarity: the series are too short for max_d");
   constexpr int TPB = 256;
-  dim3 block = choose_block_dims<TPB>(n_diff_batches);
-  dim3 grid(ceildiv<IdxT>(n_diff_samples, block.x),
-            ceildiv<IdxT>(n_diff_batches, block.y));
 
-  gather_diff_kernel<<<grid, block, 0, stream>>>(
-    y_diff_d, y_d, gather_map_d, n_diff_batches, n_diff_samples);
+  // The static shared memory is small next to the limit
+  cudaFuncAttributes attr;
+  CUDA_CHECK(
+    cudaFuncGetAttributes(&attr, stationarity_fused_kernel<DataT, TPB>));
+  size_t smem = n_samples * sizeof(DataT);
+  bool use_smem =
+    smem + attr.sharedSizeBytes <= static_cast<size_t>(getSharedMemPerBlock());
+
+  device_buffer<int> d_d(allocator, stream, n_batches);
+  stationarity_fused_kernel<DataT, TPB>
+    <<<n_batches, TPB, use_smem ? smem : 0, stream>>>(
+      d_d.data(), y_d, n_samples, max_d, test, pval_threshold, use_smem);
   CUDA_CHECK(cudaPeekAtLastError());
 
-  // Test these series with d=1
-  _is_stationary(y_diff_d, is_statio, n_diff_batches, n_diff_samples, allocator,
-                 stream, pval_threshold);
+  MLCommon::updateHost(d, d_d.data(), n_batches, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
 
-  // Check the results
-  int ret_value = 1;
-  for (int i = 0; i < n_diff_batches; i++) {
-    if (is_statio[i]) {
-      d[gather_map_h[i]] = 1;
-    } else {
-      d[gather_map_h[i]] = -1;  // Invalid value to indicate failure
-      ret_value = -1;
-    }
+  int ret_value = 0;
+  for (IdxT i = 0; i < n_batches; i++) {
+    if (d[i] < 0) return -1;
+    ret_value = std::max(ret_value, d[i]);
   }
-
-  allocator->deallocate(gather_map_d, n_diff_batches * sizeof(IdxT), stream);
-  allocator->deallocate(
-    y_diff_d, n_diff_batches * n_diff_samples * sizeof(DataT), stream);
-
   return ret_value;
 }
 
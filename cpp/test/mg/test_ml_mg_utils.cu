@@ -90,4 +90,20 @@ TEST_F(ChunkToDeviceTest, Fit) {
   ASSERT_TRUE(devArrMatch(expected_params[1], params[1], 4, Compare<float>()));
 }
 
+TEST(BalancedRowsTest, Parts) {
+  // 10 rows over 4 parts: 3, 3, 2, 2
+  int expected_begins[] = {0, 3, 6, 8}, expected_counts[] = {3, 3, 2, 2};
+  for (int part = 0; part < 4; part++) {
+    int begin, count;
+    balanced_rows(10, 4, part, &begin, &count);
+    ASSERT_EQ(expected_begins[part], begin);
+    ASSERT_EQ(expected_counts[part], count);
+  }
+  // fewer rows than parts
+  int begin, count;
+  balanced_rows(2, 4, 3, &begin, &count);
+  ASSERT_EQ(2, begin);
+  ASSERT_EQ(0, count);
+}
+
 }  // end namespace ML
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "stats/batched_histogram.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Stats {
+
+struct BatchedHistInputs {
+  int nrows, ncols, nnodes, maxBins;
+  HistType type;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const BatchedHistInputs& dims) {
+  return os;
+}
+
+/**
+ * The per node counts and weight sums of columns of varying numbers of bins,
+ * against the host. The weights are multiples of 1/8, so that the sums are
+ * exact whatever the order of the atomics.
+ */
+class BatchedHistTest : public ::testing::TestWithParam<BatchedHistInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<BatchedHistInputs>::GetParam();
+    int nrows = params.nrows, ncols = params.ncols, nnodes = params.nnodes;
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+    // the first column has maxBins bins, the others fewer
+    std::vector<int> offsets_h(ncols + 1, 0);
+    for (int c = 0; c < ncols; c++) {
+      int nbins = c == 0 ? params.maxBins : 1 + (c * 7) % params.maxBins;
+      offsets_h[c + 1] = offsets_h[c] + nbins;
+    }
+    int totalBins = offsets_h[ncols];
+
+    std::default_random_engine gen(params.seed);
+    std::uniform_int_distribution<int> node(-1, nnodes - 1);
+    std::uniform_int_distribution<int> weight(-16, 16);
+    std::vector<int> data_h(nrows * ncols), nodes_h(nrows);
+    std::vector<float> weights_h(nrows);
+    for (int r = 0; r < nrows; r++) {
+      nodes_h[r] = node(gen);
+      weights_h[r] = float(weight(gen)) / 8.f;
+    }
+    for (int c = 0; c < ncols; c++) {
+      int nbins = offsets_h[c + 1] - offsets_h[c];
+      std::uniform_int_distribution<int> bin(0, nbins - 1);
+      for (int r = 0; r < nrows; r++) data_h[c * nrows + r] = bin(gen);
+    }
+
+    counts_exp.assign(nnodes * totalBins, 0);
+    sums_exp.assign(nnodes * totalBins, 0.f);
+    for (int c = 0; c < ncols; c++) {
+      for (int r = 0; r < nrows; r++) {
+        if (nodes_h[r] < 0) continue;
+        int idx = nodes_h[r] * totalBins + offsets_h[c] + data_h[c * nrows + r];
+        counts_exp[idx]++;
+        sums_exp[idx] += weights_h[r];
+      }
+    }
+
+    device_buffer<int> data(alloc, stream, nrows * ncols);
+    device_buffer<int> nodes(alloc, stream, nrows);
+    device_buffer<int> offsets(alloc, stream, ncols + 1);
+    device_buffer<float> weights(alloc, stream, nrows);
+    device_buffer<int> counts(alloc, stream, nnodes * totalBins);
+    device_buffer<float> sums(alloc, stream, nnodes * totalBins);
+    updateDevice(data.data(), data_h.data(), nrows * ncols, stream);
+    updateDevice(nodes.data(), nodes_h.data(), nrows, stream);
+    updateDevice(offsets.data(), offsets_h.data(), ncols + 1, stream);
+    updateDevice(weights.data(), weights_h.data(), nrows, stream);
+
+    batchedHistogram<int>(params.type, counts.data(), offsets.data(),
+                          params.maxBins, data.data(), nrows, ncols,
+                          nodes.data(), nnodes, alloc, stream);
+    batchedWeightedHistogram<int>(sums.data(), weights.data(), offsets.data(),
+                                  params.maxBins, data.data(), nrows, ncols,
+                                  nodes.data(), nnodes, stream);
+    counts_res.resize(nnodes * totalBins);
+    sums_res.resize(nnodes * totalBins);
+    updateHost(counts_res.data(), counts.data(), nnodes * totalBins, stream);
+    updateHost(sums_res.data(), sums.data(), nnodes * totalBins, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  BatchedHistInputs params;
+  std::vector<int> counts_exp, counts_res;
+  std::vector<float> sums_exp, sums_res;
+};
+
+template <typename T>
+::testing::AssertionResult match(const std::vector<T>& expected,
+                                 const std::vector<T>& actual) {
+  for (size_t i = 0; i < expected.size(); i++) {
+    if (expected[i] != actual[i]) {
+      return ::testing::AssertionFailure()
+             << "actual=" << actual[i] << " != expected=" << expected[i]
+             << " @" << i;
+    }
+  }
+  return ::testing::AssertionSuccess();
+}
+
+static const int oneK = 1024;
+const std::vector<BatchedHistInputs> inputs = {
+  {1, 1, 1, 1, HistTypeAuto, 1234ULL},
+  {oneK + 1, 5, 4, 32, HistTypeAuto, 1234ULL},
+  {oneK + 1, 5, 4, 32, HistTypeGmem, 1234ULL},
+  {oneK + 1, 5, 4, 32, HistTypeSmem, 1234ULL},
+  {oneK + 1, 5, 4, 32, HistTypeSmemBits16, 1234ULL},
+  {oneK + 1, 5, 4, 32, HistTypeSmemBits4, 1234ULL},
+  {oneK + 1, 5, 4, 32, HistTypeSmemBits1, 1234ULL},
+  {oneK + 1, 5, 4, 32, HistTypeSmemHash, 1234ULL},
+  {100 * oneK + 3, 21, 64, 256, HistTypeAuto, 42ULL},
+  {100 * oneK + 3, 21, 64, 256, HistTypeSmemBits2, 42ULL},
+  // the counters bit-packed and the sums in global memory
+  {100 * oneK, 3, 512, 256, HistTypeAuto, 42ULL}};
+typedef BatchedHistTest BatchedHistTestF;
+TEST_P(BatchedHistTestF, Result) {
+  ASSERT_TRUE(match(counts_exp, counts_res));
+  ASSERT_TRUE(match(sums_exp, sums_res));
+}
+INSTANTIATE_TEST_CASE_P(BatchedHistTests, BatchedHistTestF,
+                        ::testing::ValuesIn(inputs));
+
+};  // end namespace Stats
+};  // end namespace MLCommon
@@ -290,6 +290,11 @@ class BatchedMatrixTest
 // Test parameters (op, n_batches, m, n, p, q, tolerance)
 const std::vector<BatchedMatrixInputs<double>> inputsd = {
   {AB_op, 7, 15, 37, 37, 11, 0, 0, 1e-6},
+  {AB_op, 100, 3, 4, 4, 2, 0, 0, 1e-6},
+  {AB_op, 33, 7, 8, 8, 5, 0, 0, 1e-6},
+  {AB_op, 21, 16, 13, 13, 16, 0, 0, 1e-6},
+  {AZT_op, 70, 6, 5, 1, 1, 0, 0, 1e-6},
+  {ZA_op, 45, 12, 9, 1, 1, 0, 0, 1e-6},
   {AZT_op, 5, 33, 65, 1, 1, 0, 0, 1e-6},
   {ZA_op, 8, 12, 41, 1, 1, 0, 0, 1e-6},
   {ApB_op, 4, 16, 48, 16, 48, 0, 0, 1e-6},
@@ -298,6 +303,7 @@ const std::vector<BatchedMatrixInputs<double>> inputsd = {
   {AkB_op, 3, 7, 12, 31, 15, 0, 0, 1e-6},
   {AkB_op, 2, 11, 2, 8, 46, 0, 0, 1e-6},
   {AsolveZ_op, 6, 17, 17, 1, 1, 0, 0, 1e-6},
+  {AsolveZ_op, 50, 4, 4, 1, 1, 0, 0, 1e-6},
   {LaggedZ_op, 5, 31, 9, 1, 1, 0, 0, 1e-6},
   {LaggedZ_op, 7, 129, 3, 1, 1, 0, 0, 1e-6},
   {CopyA_op, 7, 35, 43, 1, 1, 0, 0, 1e-6},
@@ -309,6 +315,11 @@ const std::vector<BatchedMatrixInputs<double>> inputsd = {
 // Test parameters (op, n_batches, m, n, p, q, tolerance)
 const std::vector<BatchedMatrixInputs<float>> inputsf = {
   {AB_op, 7, 15, 37, 37, 11, 0, 0, 1e-2},
+  {AB_op, 100, 3, 4, 4, 2, 0, 0, 1e-2},
+  {AB_op, 33, 7, 8, 8, 5, 0, 0, 1e-2},
+  {AB_op, 21, 16, 13, 13, 16, 0, 0, 1e-2},
+  {AZT_op, 70, 6, 5, 1, 1, 0, 0, 1e-2},
+  {ZA_op, 45, 12, 9, 1, 1, 0, 0, 1e-2},
   {AZT_op, 5, 33, 65, 1, 1, 0, 0, 1e-2},
   {ZA_op, 8, 12, 41, 1, 1, 0, 0, 1e-2},
   {ApB_op, 4, 16, 48, 16, 48, 0, 0, 1e-2},
@@ -317,6 +328,7 @@ const std::vector<BatchedMatrixInputs<float>> inputsf = {
   {AkB_op, 3, 7, 12, 31, 15, 0, 0, 1e-2},
   {AkB_op, 2, 11, 2, 8, 46, 0, 0, 1e-2},
   {AsolveZ_op, 6, 17, 17, 1, 1, 0, 0, 1e-2},
+  {AsolveZ_op, 50, 4, 4, 1, 1, 0, 0, 1e-2},
   {LaggedZ_op, 5, 31, 9, 1, 1, 0, 0, 1e-5},
   {LaggedZ_op, 7, 129, 3, 1, 1, 0, 0, 1e-5},
   {CopyA_op, 7, 35, 43, 1, 1, 0, 0, 1e-5},
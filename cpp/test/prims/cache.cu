@@ -292,5 +292,172 @@ TEST_F(CacheTest, TestStoreCollect) {
     }
   }
 }
+
+TEST_F(CacheTest, TestStats) {
+  float cache_size = 5 * sizeof(float) * n_cols / (1024 * 1024.0);
+  Cache<float, 2> cache(allocator, stream, n_cols, cache_size);
+
+  int n_cached;
+  cache.GetCacheIdxPartitioned(keys_dev, n, cache_idx_dev, &n_cached, stream);
+  cache.AssignCacheIdx(keys_dev, n, cache_idx_dev, stream);
+  updateDevice(keys_dev, keys_host, n, stream);
+  cache.GetCacheIdxPartitioned(keys_dev, n, cache_idx_dev, &n_cached, stream);
+  ASSERT_EQ(n_cached, 4);
+
+  CacheStats stats = cache.GetStats(stream);
+  EXPECT_EQ(stats.n_lookups, uint64_t(20));
+  EXPECT_EQ(stats.n_hits, uint64_t(4));
+  EXPECT_DOUBLE_EQ(stats.HitRate(), 0.2);
+
+  cache.ResetStats(stream);
+  stats = cache.GetStats(stream);
+  EXPECT_EQ(stats.n_lookups, uint64_t(0));
+  EXPECT_EQ(stats.n_hits, uint64_t(0));
+  EXPECT_DOUBLE_EQ(stats.HitRate(), 0.0);
+}
+
+TEST_F(CacheTest, TestEvictClock) {
+  float cache_size = 8 * sizeof(float) * n_cols / (1024 * 1024.0);
+  Cache<float, 4> cache(allocator, stream, n_cols, cache_size, false, CLOCK);
+
+  ASSERT_EQ(cache.GetSize(), 8);
+  ASSERT_EQ(cache.GetPolicy(), CLOCK);
+
+  int n_cached;
+  cache.GetCacheIdxPartitioned(keys_dev, 5, cache_idx_dev, &n_cached, stream);
+  ASSERT_EQ(n_cached, 0);
+  cache.AssignCacheIdx(keys_dev, 5, cache_idx_dev, stream);
+
+  // the hands fill the sets in order
+  int cache_idx_exp[5] = {0, 1, 2, 4, 5};
+  int keys_exp[5] = {0, 2, 4, 1, 3};
+  EXPECT_TRUE(devArrMatchHost(cache_idx_exp, cache_idx_dev, 5, Compare<int>()));
+  EXPECT_TRUE(devArrMatchHost(keys_exp, keys_dev, 5, Compare<int>()));
+
+  int idx_host[10] = {2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  updateDevice(keys_dev, idx_host, 10, stream);
+  cache.GetCacheIdxPartitioned(keys_dev, 10, cache_idx_dev, &n_cached, stream);
+  EXPECT_EQ(n_cached, 3);
+  int cache_idx_exp2[3] = {1, 5, 2};
+  EXPECT_TRUE(
+    devArrMatchHost(cache_idx_exp2, cache_idx_dev, 3, Compare<int>()));
+
+  cache.AssignCacheIdx(keys_dev + n_cached, 10 - n_cached,
+                       cache_idx_dev + n_cached, stream);
+
+  // keys 0 and 1 lose their second chance, and the entries accessed in this
+  // round are kept
+  int keys_exp3[10] = {2, 3, 4, 10, 8, 6, 11, 9, 7, 5};
+  int cache_idx_exp3[10] = {1, 5, 2, 3, 0, -1, 6, 7, 4, -1};
+  EXPECT_TRUE(devArrMatchHost(keys_exp3, keys_dev, 10, Compare<int>()));
+  EXPECT_TRUE(
+    devArrMatchHost(cache_idx_exp3, cache_idx_dev, 10, Compare<int>()));
+}
+
+TEST_F(CacheTest, TestStoreCollectKey64Half) {
+  float cache_size = 8 * sizeof(__half) * n_cols / (1024 * 1024.0);
+  Cache<float, 4, int64_t, __half> cache(allocator, stream, n_cols,
+                                         cache_size);
+
+  ASSERT_EQ(cache.GetSize(), 8);
+
+  // keys beyond the range of int
+  const int64_t offset = int64_t(1) << 40;
+  int64_t keys64_host[5];
+  for (int i = 0; i < 5; i++) keys64_host[i] = offset + i;
+  int64_t *keys64_dev;
+  int *tile_idx_dev;
+  allocate(keys64_dev, 5);
+  allocate(tile_idx_dev, 5);
+  updateDevice(keys64_dev, keys64_host, 5, stream);
+
+  int n_cached;
+  cache.GetCacheIdxPartitioned(keys64_dev, 5, cache_idx_dev, &n_cached,
+                               stream);
+  ASSERT_EQ(n_cached, 0);
+  cache.AssignCacheIdx(keys64_dev, 5, cache_idx_dev, stream);
+
+  int tile_idx_host[5];
+  updateHost(keys64_host, keys64_dev, 5, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  for (int i = 0; i < 5; i++) tile_idx_host[i] = keys64_host[i] - offset;
+  updateDevice(tile_idx_dev, tile_idx_host, 5, stream);
+  cache.StoreVecs(x_dev, 10, 5, cache_idx_dev, stream, tile_idx_dev);
+
+  // collect them on another stream, the small integers of x are exact in
+  // half precision
+  cudaStream_t stream2;
+  CUDA_CHECK(cudaStreamCreate(&stream2));
+  cache.GetCacheIdxPartitioned(keys64_dev, 5, cache_idx_dev, &n_cached,
+                               stream2);
+  ASSERT_EQ(n_cached, 5);
+  cache.GetVecs(cache_idx_dev, n_cached, tile_dev, stream2);
+  updateHost(keys64_host, keys64_dev, 5, stream2);
+  CUDA_CHECK(cudaStreamSynchronize(stream2));
+  for (int i = 0; i < n_cached; i++) {
+    EXPECT_TRUE(devArrMatch(x_dev + (keys64_host[i] - offset) * n_cols,
+                            tile_dev + i * n_cols, n_cols, Compare<float>()))
+      << "vector " << i;
+  }
+
+  CUDA_CHECK(cudaStreamDestroy(stream2));
+  CUDA_CHECK(cudaFree(keys64_dev));
+  CUDA_CHECK(cudaFree(tile_idx_dev));
+}
+TEST_F(CacheTest, TestHostSpill) {
+  float cache_size = 5 * sizeof(float) * n_cols / (1024 * 1024.0);
+  float host_cache_size = 9 * sizeof(float) * n_cols / (1024 * 1024.0);
+  Cache<float, 2> cache(allocator, stream, n_cols, cache_size, false, LRU,
+                        host_cache_size);
+
+  ASSERT_EQ(cache.GetSize(), 4);
+  ASSERT_EQ(cache.GetHostSize(), 8);
+
+  // fill the device with keys 0..3, then evict them to the host with 4..7
+  int n_cached;
+  for (int k = 0; k < 2; k++) {
+    updateDevice(keys_dev, keys_host + 4 * k, 4, stream);
+    cache.GetCacheIdxPartitioned(keys_dev, 4, cache_idx_dev, &n_cached,
+                                 stream);
+    ASSERT_EQ(n_cached, 0);
+    cache.AssignCacheIdx(keys_dev, 4, cache_idx_dev, stream);
+    cache.StoreVecs(x_dev, 10, 4, cache_idx_dev, stream, keys_dev);
+  }
+
+  // the lookup promotes keys 0..3 back from the host, spilling 4..7
+  updateDevice(keys_dev, keys_host, 4, stream);
+  cache.GetCacheIdxPartitioned(keys_dev, 4, cache_idx_dev, &n_cached, stream);
+  ASSERT_EQ(n_cached, 4);
+  cache.GetVecs(cache_idx_dev, 4, tile_dev, stream);
+  int keys_check[4];
+  updateHost(keys_check, keys_dev, 4, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(devArrMatch(x_dev + keys_check[i] * n_cols,
+                            tile_dev + i * n_cols, n_cols, Compare<float>()))
+      << "vector " << i;
+  }
+
+  // prefetch 4..7 back before looking them up
+  updateDevice(keys_dev, keys_host + 4, 4, stream);
+  cache.Prefetch(keys_dev, 4, stream);
+  cache.GetCacheIdxPartitioned(keys_dev, 4, cache_idx_dev, &n_cached, stream);
+  ASSERT_EQ(n_cached, 4);
+  cache.GetVecs(cache_idx_dev, 4, tile_dev, stream);
+  updateHost(keys_check, keys_dev, 4, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(devArrMatch(x_dev + keys_check[i] * n_cols,
+                            tile_dev + i * n_cols, n_cols, Compare<float>()))
+      << "vector " << i;
+  }
+
+  // the promotions of the lookups are host hits, not the ones of Prefetch
+  CacheStats stats = cache.GetStats(stream);
+  EXPECT_EQ(stats.n_lookups, uint64_t(16));
+  EXPECT_EQ(stats.n_hits, uint64_t(8));
+  EXPECT_EQ(stats.n_host_hits, uint64_t(4));
+}
+
 };  // end namespace Cache
 };  // end namespace MLCommon
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include "metrics/adjustedRandIndex.h"
+#include "metrics/clusteringScores.h"
+#include "metrics/vMeasure.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Metrics {
+
+struct ClusteringScoresParam {
+  int nElements;
+  int lowerLabelRange;
+  int upperLabelRange;
+  bool sameArrays;
+  double tolerance;
+};
+
+// the scores at once, against the metrics computed one by one
+template <typename T>
+class ClusteringScoresTest
+  : public ::testing::TestWithParam<ClusteringScoresParam> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<ClusteringScoresParam>::GetParam();
+    int n = params.nElements;
+    T lower = params.lowerLabelRange, upper = params.upperLabelRange;
+
+    std::vector<T> truth(n), pred(n);
+    std::default_random_engine dre(n);
+    std::uniform_int_distribution<T> intGenerator(lower, upper);
+    std::generate(truth.begin(), truth.end(),
+                  [&]() { return intGenerator(dre); });
+    if (params.sameArrays) {
+      pred = truth;
+    } else {
+      std::generate(pred.begin(), pred.end(),
+                    [&]() { return intGenerator(dre); });
+    }
+
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> allocator(new defaultDeviceAllocator);
+    device_buffer<T> d_truth(allocator, stream, n);
+    device_buffer<T> d_pred(allocator, stream, n);
+    updateDevice(d_truth.data(), truth.data(), n, stream);
+    updateDevice(d_pred.data(), pred.data(), n, stream);
+
+    computed = clusteringScores(d_truth.data(), d_pred.data(), n, lower, upper,
+                                allocator, stream);
+    expected.adjustedRandIndex = computeAdjustedRandIndex(
+      d_truth.data(), d_pred.data(), n, lower, upper, allocator, stream);
+    expected.mutualInfo = mutualInfoScore(d_truth.data(), d_pred.data(), n,
+                                          lower, upper, allocator, stream);
+    expected.homogeneity = homogeneityScore(d_truth.data(), d_pred.data(), n,
+                                            lower, upper, allocator, stream);
+    expected.completeness = homogeneityScore(d_pred.data(), d_truth.data(), n,
+                                             lower, upper, allocator, stream);
+    expected.vMeasure = vMeasure(d_truth.data(), d_pred.data(), n, lower,
+                                 upper, allocator, stream);
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  ClusteringScoresParam params;
+  ClusteringScores computed, expected;
+};
+
+const std::vector<ClusteringScoresParam> inputs = {
+  {199, 1, 10, false, 0.000001},     {200, 15, 100, false, 0.000001},
+  {300, 3, 99, true, 0.000001},      {10, 1, 10, true, 0.000001},
+  {20000, 1, 6000, false, 0.000001}, {20000, 1, 6000, true, 0.000001}};
+
+typedef ClusteringScoresTest<int> ClusteringScoresTestI;
+TEST_P(ClusteringScoresTestI, Result) {
+  double tol = params.tolerance;
+  ASSERT_NEAR(expected.adjustedRandIndex, computed.adjustedRandIndex, tol);
+  ASSERT_NEAR(expected.mutualInfo, computed.mutualInfo, tol);
+  ASSERT_NEAR(expected.homogeneity, computed.homogeneity, tol);
+  ASSERT_NEAR(expected.completeness, computed.completeness, tol);
+  ASSERT_NEAR(expected.vMeasure, computed.vMeasure, tol);
+}
+INSTANTIATE_TEST_CASE_P(ClusteringScores, ClusteringScoresTestI,
+                        ::testing::ValuesIn(inputs));
+
+}  // end namespace Metrics
+}  // end namespace MLCommon
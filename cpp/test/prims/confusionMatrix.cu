@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <cuml/common/cuml_allocator.hpp>
+#include <random>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "metrics/confusionMatrix.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Metrics {
+
+struct ConfusionMatrixParam {
+  int nSamples;
+  int lowerLabelRange;
+  int upperLabelRange;
+  unsigned long long int seed;
+};
+
+std::ostream &operator<<(std::ostream &os, const ConfusionMatrixParam &p) {
+  return os << "{" << p.nSamples << ", " << p.lowerLabelRange << ", "
+            << p.upperLabelRange << "}";
+}
+
+/**
+ * Random labels, a third of them predicted right, against the counts of the
+ * pairs of labels on the host
+ */
+class ConfusionMatrixTest
+  : public ::testing::TestWithParam<ConfusionMatrixParam> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<ConfusionMatrixParam>::GetParam();
+    int n = params.nSamples, lower = params.lowerLabelRange;
+    nClasses = params.upperLabelRange - lower + 1;
+
+    std::default_random_engine gen(params.seed);
+    std::uniform_int_distribution<int> labels(lower, params.upperLabelRange);
+    std::vector<int> truth(n), pred(n);
+    expected.assign(nClasses * nClasses, 0);
+    for (int i = 0; i < n; i++) {
+      truth[i] = labels(gen);
+      pred[i] = i % 3 == 0 ? truth[i] : labels(gen);
+      expected[(truth[i] - lower) * nClasses + pred[i] - lower]++;
+    }
+
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+    device_buffer<int> d_truth(alloc, stream, n), d_pred(alloc, stream, n);
+    device_buffer<int> d_mat(alloc, stream, nClasses * nClasses);
+    updateDevice(d_truth.data(), truth.data(), n, stream);
+    updateDevice(d_pred.data(), pred.data(), n, stream);
+    confusionMatrix(d_truth.data(), d_pred.data(), n, d_mat.data(), lower,
+                    params.upperLabelRange, stream);
+    result.resize(nClasses * nClasses);
+    updateHost(result.data(), d_mat.data(), nClasses * nClasses, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  ConfusionMatrixParam params;
+  int nClasses;
+  std::vector<int> expected, result;
+};
+
+const std::vector<ConfusionMatrixParam> inputs = {{1, 0, 0, 1234ULL},
+                                                  {1000, 0, 1, 1234ULL},
+                                                  {10000, -3, 6, 42ULL},
+                                                  {100000, 1, 200, 42ULL}};
+
+TEST_P(ConfusionMatrixTest, Result) {
+  ASSERT_EQ(expected, result);
+}
+INSTANTIATE_TEST_CASE_P(ConfusionMatrix, ConfusionMatrixTest,
+                        ::testing::ValuesIn(inputs));
+
+}  //end namespace Metrics
+}  //end namespace MLCommon
@@ -112,10 +112,34 @@ class ContingencyMatrixTestImpl
       MLCommon::Metrics::contingencyMatrix(
         dY, dYHat, numElements, dComputedOutput, stream, (void *)pWorkspace,
         workspaceSz, lowerLabelRange, upperLabelRange);
+
+    // the sparse form, sorted by row then column, scattered back on the host
+    std::shared_ptr<deviceAllocator> allocator(new defaultDeviceAllocator);
+    device_buffer<int> rows(allocator, stream, numElements);
+    device_buffer<int> cols(allocator, stream, numElements);
+    device_buffer<int> counts(allocator, stream, numElements);
+    int nnz = MLCommon::Metrics::sparseContingencyMatrix(
+      dY, dYHat, numElements, rows.data(), cols.data(), counts.data(),
+      (T)lowerLabelRange, (T)upperLabelRange, allocator, stream);
+    std::vector<int> hRows(nnz), hCols(nnz), hCounts(nnz);
+    MLCommon::updateHost(hRows.data(), rows.data(), nnz, stream);
+    MLCommon::updateHost(hCols.data(), cols.data(), nnz, stream);
+    MLCommon::updateHost(hCounts.data(), counts.data(), nnz, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    sparseMatches = true;
+    for (int e = 0; e < nnz; e++) {
+      int idx = hRows[e] * numUniqueClasses + hCols[e];
+      if (e > 0 && idx <= hRows[e - 1] * numUniqueClasses + hCols[e - 1])
+        sparseMatches = false;
+      if (hCounts[e] != hGoldenOutput[idx]) sparseMatches = false;
+      hGoldenOutput[idx] = 0;
+    }
+    for (int i = 0; i < numUniqueClasses * numUniqueClasses; i++)
+      if (hGoldenOutput[i] != 0) sparseMatches = false;
+    free(hGoldenOutput);
   }
 
   void TearDown() override {
-    free(hGoldenOutput);
     CUDA_CHECK(cudaStreamDestroy(stream));
     CUDA_CHECK(cudaFree(dY));
     CUDA_CHECK(cudaFree(dYHat));
@@ -130,8 +154,8 @@ class ContingencyMatrixTestImpl
   T *dYHat = nullptr;
   int *dComputedOutput = nullptr;
   int *dGoldenOutput = nullptr;
-  int *hGoldenOutput = nullptr;
   char *pWorkspace = nullptr;
+  bool sparseMatches = false;
   cudaStream_t stream;
 };
 
@@ -147,6 +171,7 @@ TEST_P(ContingencyMatrixTestImplS, Result) {
   ASSERT_TRUE(devArrMatch(dComputedOutput, dGoldenOutput,
                           numUniqueClasses * numUniqueClasses,
                           CompareApprox<float>(params.tolerance)));
+  ASSERT_TRUE(sparseMatches);
 }
 
 INSTANTIATE_TEST_CASE_P(ContingencyMatrix, ContingencyMatrixTestImplS,
@@ -20,7 +20,10 @@
 #include "sparse/coo.h"
 #include "test_utils.h"
 
+#include <algorithm>
 #include <iostream>
+#include <tuple>
+#include <vector>
 
 namespace MLCommon {
 namespace Sparse {
@@ -128,6 +131,88 @@ TEST_P(COOSymmetrize, Result) {
   delete[] exp_vals_h;
 }
 
+// The input of COOSymmetrize, unsorted and with (0, 1) duplicated
+template <typename Index_>
+void check_symmetrize_csr() {
+  cudaStream_t stream;
+  cudaStreamCreate(&stream);
+  std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+  const Index_ n = 4, nnz = 9;
+  std::vector<Index_> in_rows_h = {3, 0, 1, 1, 2, 2, 0, 3, 0};
+  std::vector<Index_> in_cols_h = {2, 1, 2, 3, 0, 1, 3, 0, 1};
+  std::vector<float> in_vals_h = {0.5, 0.5, 0.5, 0.5, 0.5, 0.0, 1.0, 0.5, 0.25};
+
+  std::vector<Index_> exp_rows_h = {0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3};
+  std::vector<Index_> exp_cols_h = {1, 2, 3, 0, 2, 3, 0, 1, 3, 0, 1, 2};
+  std::vector<float> exp_vals_h = {0.75, 0.5, 1.5, 0.75, 0.5, 0.5,
+                                   0.5,  0.5, 0.5, 1.5,  0.5, 0.5};
+  std::vector<Index_> exp_row_ind = {0, 3, 6, 9, 12};
+
+  COO<float, Index_> in(alloc, stream, nnz, n, n);
+  updateDevice(in.rows(), in_rows_h.data(), nnz, stream);
+  updateDevice(in.cols(), in_cols_h.data(), nnz, stream);
+  updateDevice(in.vals(), in_vals_h.data(), nnz, stream);
+
+  COO<float, Index_> out(alloc, stream);
+  device_buffer<Index_> row_ind(alloc, stream, n + 1);
+  coo_symmetrize_csr<32, float>(
+    &in, &out,
+    [] __device__(Index_ row, Index_ col, float val, float trans) {
+      return val + trans;
+    },
+    alloc, stream, row_ind.data());
+
+  ASSERT_EQ(out.nnz, Index_(exp_rows_h.size()));
+  ASSERT_TRUE(devArrMatchHost(exp_rows_h.data(), out.rows(), out.nnz,
+                              Compare<Index_>(), stream));
+  ASSERT_TRUE(devArrMatchHost(exp_cols_h.data(), out.cols(), out.nnz,
+                              Compare<Index_>(), stream));
+  ASSERT_TRUE(devArrMatchHost(exp_vals_h.data(), out.vals(), out.nnz,
+                              CompareApprox<float>(1e-6), stream));
+  ASSERT_TRUE(devArrMatchHost(exp_row_ind.data(), row_ind.data(), n + 1,
+                              Compare<Index_>(), stream));
+
+  CUDA_CHECK(cudaStreamDestroy(stream));
+}
+
+typedef COOTest<float> COOSymmetrizeCSR;
+TEST_P(COOSymmetrizeCSR, Result) {
+  check_symmetrize_csr<int>();
+  check_symmetrize_csr<int64_t>();
+}
+
+typedef COOTest<float> COOSort64;
+TEST_P(COOSort64, Result) {
+  cudaStream_t stream;
+  CUDA_CHECK(cudaStreamCreate(&stream));
+  std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+  // An index past 2^31 sorts after the small ones
+  const int64_t nnz = 4, big = int64_t(1) << 33;
+  std::vector<int64_t> rows_h = {big, 1, 0, 1};
+  std::vector<int64_t> cols_h = {0, 3, big, 2};
+  std::vector<float> vals_h = {1, 2, 3, 4};
+  std::vector<int64_t> exp_rows_h = {0, 1, 1, big};
+  std::vector<int64_t> exp_cols_h = {big, 2, 3, 0};
+  std::vector<float> exp_vals_h = {3, 4, 2, 1};
+
+  COO<float, int64_t> in(alloc, stream, nnz, big + 1, big + 1);
+  updateDevice(in.rows(), rows_h.data(), nnz, stream);
+  updateDevice(in.cols(), cols_h.data(), nnz, stream);
+  updateDevice(in.vals(), vals_h.data(), nnz, stream);
+  coo_sort<float>(&in, alloc, stream);
+
+  ASSERT_TRUE(devArrMatchHost(exp_rows_h.data(), in.rows(), nnz,
+                              Compare<int64_t>(), stream));
+  ASSERT_TRUE(devArrMatchHost(exp_cols_h.data(), in.cols(), nnz,
+                              Compare<int64_t>(), stream));
+  ASSERT_TRUE(devArrMatchHost(exp_vals_h.data(), in.vals(), nnz,
+                              Compare<float>(), stream));
+
+  CUDA_CHECK(cudaStreamDestroy(stream));
+}
+
 typedef COOTest<float> COOSort;
 TEST_P(COOSort, Result) {
   int *in_rows, *in_cols, *verify;
@@ -296,10 +381,64 @@ TEST_P(COORowCountNonzero, Result) {
   CUDA_CHECK(cudaStreamDestroy(stream));
 }
 
+typedef COOTest<float> COOKnnSymmetrizeMerged;
+TEST_P(COOKnnSymmetrizeMerged, Result) {
+  cudaStream_t stream;
+  cudaStreamCreate(&stream);
+  std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+  // 0 and 1 are each other's neighbors; 2 -> 0 and 3 -> 0 are not mutual
+  const int n = 4, k = 2;
+  std::vector<long> indices_h = {0, 1, 1, 0, 2, 0, 3, 0};
+  std::vector<float> dists_h = {1, 2, 3, 4, 5, 6, 7, 8};
+
+  // (row, col, val) of every entry, sorted
+  std::vector<std::tuple<int, int, float>> exp = {
+    std::make_tuple(0, 0, 2.0f), std::make_tuple(0, 1, 6.0f),
+    std::make_tuple(0, 2, 6.0f), std::make_tuple(0, 3, 8.0f),
+    std::make_tuple(1, 0, 6.0f), std::make_tuple(1, 1, 6.0f),
+    std::make_tuple(2, 0, 6.0f), std::make_tuple(2, 2, 10.0f),
+    std::make_tuple(3, 0, 8.0f), std::make_tuple(3, 3, 14.0f)};
+  std::vector<int> exp_row_ind = {0, 4, 6, 8, 10};
+
+  device_buffer<long> indices(alloc, stream, n * k);
+  device_buffer<float> dists(alloc, stream, n * k);
+  device_buffer<int> row_ind(alloc, stream, n + 1);
+  updateDevice(indices.data(), indices_h.data(), n * k, stream);
+  updateDevice(dists.data(), dists_h.data(), n * k, stream);
+
+  COO<float> out(alloc, stream);
+  from_knn_symmetrize_merged(indices.data(), dists.data(), n, k, &out, stream,
+                             alloc, row_ind.data());
+
+  ASSERT_EQ(out.nnz, int(exp.size()));
+  std::vector<int> rows_h(out.nnz), cols_h(out.nnz), row_ind_h(n + 1);
+  std::vector<float> vals_h(out.nnz);
+  updateHost(rows_h.data(), out.rows(), out.nnz, stream);
+  updateHost(cols_h.data(), out.cols(), out.nnz, stream);
+  updateHost(vals_h.data(), out.vals(), out.nnz, stream);
+  updateHost(row_ind_h.data(), row_ind.data(), n + 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  // The entries are grouped by row, in any order within a row
+  std::vector<std::tuple<int, int, float>> res;
+  for (int i = 0; i < out.nnz; i++) {
+    res.push_back(std::make_tuple(rows_h[i], cols_h[i], vals_h[i]));
+    if (i > 0) ASSERT_LE(rows_h[i - 1], rows_h[i]);
+  }
+  std::sort(res.begin(), res.end());
+  ASSERT_TRUE(res == exp);
+  ASSERT_TRUE(row_ind_h == exp_row_ind);
+
+  CUDA_CHECK(cudaStreamDestroy(stream));
+}
+
 INSTANTIATE_TEST_CASE_P(COOTests, SortedCOOToCSR, ::testing::ValuesIn(inputsf));
 
 INSTANTIATE_TEST_CASE_P(COOTests, COOSort, ::testing::ValuesIn(inputsf));
 
+INSTANTIATE_TEST_CASE_P(COOTests, COOSort64, ::testing::ValuesIn(inputsf));
+
 INSTANTIATE_TEST_CASE_P(COOTests, COORemoveZeros, ::testing::ValuesIn(inputsf));
 
 INSTANTIATE_TEST_CASE_P(COOTests, COORowCount, ::testing::ValuesIn(inputsf));
@@ -309,5 +448,11 @@ INSTANTIATE_TEST_CASE_P(COOTests, COORowCountNonzero,
 
 INSTANTIATE_TEST_CASE_P(COOTests, COOSymmetrize, ::testing::ValuesIn(inputsf));
 
+INSTANTIATE_TEST_CASE_P(COOTests, COOSymmetrizeCSR,
+                        ::testing::ValuesIn(inputsf));
+
+INSTANTIATE_TEST_CASE_P(COOTests, COOKnnSymmetrizeMerged,
+                        ::testing::ValuesIn(inputsf));
+
 }  // namespace Sparse
 }  // namespace MLCommon
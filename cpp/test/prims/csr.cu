@@ -21,8 +21,11 @@
 #include "random/rng.h"
 #include "test_utils.h"
 
+#include <algorithm>
 #include <iostream>
 #include <limits>
+#include <random>
+#include <vector>
 
 namespace MLCommon {
 namespace Sparse {
@@ -72,6 +75,52 @@ TEST_P(CSRToCOO, Result) {
   cudaStreamDestroy(stream);
 }
 
+typedef CSRTest<float> CSRToDenseRows;
+TEST_P(CSRToDenseRows, Result) {
+  cudaStream_t stream;
+  cudaStreamCreate(&stream);
+
+  // [[1, 0, 2],
+  //  [0, 0, 0],
+  //  [0, 3, 4],
+  //  [5, 0, 0]]
+  int row_ptr_h[5] = {0, 2, 2, 4, 5};
+  int col_ind_h[5] = {0, 2, 1, 2, 0};
+  float vals_h[5] = {1, 2, 3, 4, 5};
+  // rows 2, 0 and 1, in column major format
+  int rows_h[3] = {2, 0, 1};
+  float verify_h[9] = {0, 1, 0, 3, 0, 0, 4, 2, 0};
+
+  int *row_ptr, *col_ind, *rows;
+  float *vals, *result, *verify;
+  allocate(row_ptr, 5);
+  allocate(col_ind, 5);
+  allocate(vals, 5);
+  allocate(rows, 3);
+  allocate(verify, 9);
+  allocate(result, 9);
+
+  updateDevice(row_ptr, row_ptr_h, 5, stream);
+  updateDevice(col_ind, col_ind_h, 5, stream);
+  updateDevice(vals, vals_h, 5, stream);
+  updateDevice(rows, rows_h, 3, stream);
+  updateDevice(verify, verify_h, 9, stream);
+
+  csr_to_dense_rows(row_ptr, col_ind, vals, rows, 3, 3, result, stream);
+
+  ASSERT_TRUE(
+    devArrMatch<float>(verify, result, 9, Compare<float>(), stream));
+
+  CUDA_CHECK(cudaFree(row_ptr));
+  CUDA_CHECK(cudaFree(col_ind));
+  CUDA_CHECK(cudaFree(vals));
+  CUDA_CHECK(cudaFree(rows));
+  CUDA_CHECK(cudaFree(verify));
+  CUDA_CHECK(cudaFree(result));
+
+  cudaStreamDestroy(stream);
+}
+
 typedef CSRTest<float> CSRRowNormalizeMax;
 TEST_P(CSRRowNormalizeMax, Result) {
   cudaStream_t stream;
@@ -337,14 +386,167 @@ TEST_P(WeakCCTest, Result) {
   CUDA_CHECK(cudaFree(result));
 }
 
+typedef CSRTest<float> WeakCCUnionFindTest;
+TEST_P(WeakCCUnionFindTest, Result) {
+  cudaStream_t stream;
+  cudaStreamCreate(&stream);
+  std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+  // a long chain, random edges among the next 400 vertices, and isolated
+  // vertices
+  const int N = 1000, MAX_LABEL = std::numeric_limits<int>::max();
+  std::vector<std::vector<int>> adj(N);
+  auto add_edge = [&adj](int a, int b) {
+    adj[a].push_back(b);
+    adj[b].push_back(a);
+  };
+  for (int i = 0; i < 499; i++) add_edge(i, i + 1);
+  std::mt19937 gen(params.seed);
+  std::uniform_int_distribution<int> dist(500, 899);
+  for (int e = 0; e < 300; e++) add_edge(dist(gen), dist(gen));
+
+  std::vector<bool> h_seeded(N);
+  for (int i = 0; i < N; i++) h_seeded[i] = i % 7 == 3 && i < 900;
+
+  // reference: 1 + the smallest seeded vertex of each component
+  std::vector<int> comp(N, -1), verify_h(N, MAX_LABEL);
+  for (int i = 0; i < N; i++) {
+    if (comp[i] >= 0) continue;
+    std::vector<int> stack(1, i), members;
+    comp[i] = i;
+    int label = MAX_LABEL;
+    while (!stack.empty()) {
+      int v = stack.back();
+      stack.pop_back();
+      members.push_back(v);
+      if (h_seeded[v]) label = std::min(label, v + 1);
+      for (int u : adj[v])
+        if (comp[u] < 0) {
+          comp[u] = i;
+          stack.push_back(u);
+        }
+    }
+    for (int v : members) verify_h[v] = label;
+  }
+
+  device_buffer<int> parent(alloc, stream, N);
+  device_buffer<bool> seeded(alloc, stream, N);
+  device_buffer<bool> d_seeds(alloc, stream, N);
+  device_buffer<int> result(alloc, stream, N);
+  device_buffer<int> verify(alloc, stream, N);
+  std::vector<char> seeds_h(h_seeded.begin(), h_seeded.end());
+  updateDevice(d_seeds.data(), (bool *)seeds_h.data(), N, stream);
+  updateDevice(verify.data(), verify_h.data(), N, stream);
+  UnionFindState<int> state(parent.data(), seeded.data());
+
+  const int batch_starts[3] = {0, 250, N};
+  for (int b = 0; b < 2; b++) {
+    int start = batch_starts[b], batch_size = batch_starts[b + 1] - start;
+    std::vector<int> row_ind_h, row_ind_ptr_h;
+    for (int v = start; v < start + batch_size; v++) {
+      row_ind_h.push_back(row_ind_ptr_h.size());
+      row_ind_ptr_h.insert(row_ind_ptr_h.end(), adj[v].begin(), adj[v].end());
+    }
+    int nnz = row_ind_ptr_h.size();
+    device_buffer<int> row_ind(alloc, stream, batch_size);
+    device_buffer<int> row_ind_ptr(alloc, stream, nnz);
+    updateDevice(row_ind.data(), row_ind_h.data(), batch_size, stream);
+    updateDevice(row_ind_ptr.data(), row_ind_ptr_h.data(), nnz, stream);
+
+    bool *seeds = d_seeds.data();
+    weak_cc_union_find_batched<int, 32>(
+      result.data(), row_ind.data(), row_ind_ptr.data(), nnz, N, start,
+      batch_size, &state, stream,
+      [seeds, start] __device__(int tid) { return seeds[start + tid]; });
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  ASSERT_TRUE(
+    devArrMatch<int>(verify.data(), result.data(), N, Compare<int>(), stream));
+
+  cudaStreamDestroy(stream);
+}
+
+typedef CSRTest<float> WeakCCComponentsTest;
+TEST_P(WeakCCComponentsTest, Result) {
+  cudaStream_t stream;
+  cudaStreamCreate(&stream);
+  std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+  // random directed edges within blocks of 50 vertices, the last ones left
+  // isolated, so that the edges are not symmetric
+  const int N = 1000;
+  std::mt19937 gen(params.seed);
+  std::uniform_int_distribution<int> dist(0, 49);
+  std::vector<std::vector<int>> adj(N), undirected(N);
+  for (int block = 0; block < 900; block += 50) {
+    for (int e = 0; e < 40; e++) {
+      int a = block + dist(gen), b = block + dist(gen);
+      adj[a].push_back(b);
+      undirected[a].push_back(b);
+      undirected[b].push_back(a);
+    }
+  }
+
+  // reference: the components numbered from 1 by their smallest vertex
+  std::vector<int> verify_h(N, 0);
+  int n_components = 0;
+  for (int i = 0; i < N; i++) {
+    if (verify_h[i] > 0) continue;
+    std::vector<int> stack(1, i);
+    verify_h[i] = ++n_components;
+    while (!stack.empty()) {
+      int v = stack.back();
+      stack.pop_back();
+      for (int u : undirected[v])
+        if (verify_h[u] == 0) {
+          verify_h[u] = n_components;
+          stack.push_back(u);
+        }
+    }
+  }
+
+  std::vector<int> row_ind_h, row_ind_ptr_h;
+  for (int v = 0; v < N; v++) {
+    row_ind_h.push_back(row_ind_ptr_h.size());
+    row_ind_ptr_h.insert(row_ind_ptr_h.end(), adj[v].begin(), adj[v].end());
+  }
+  int nnz = row_ind_ptr_h.size();
+  device_buffer<int> row_ind(alloc, stream, N);
+  device_buffer<int> row_ind_ptr(alloc, stream, nnz);
+  device_buffer<int> result(alloc, stream, N);
+  device_buffer<int> verify(alloc, stream, N);
+  updateDevice(row_ind.data(), row_ind_h.data(), N, stream);
+  updateDevice(row_ind_ptr.data(), row_ind_ptr_h.data(), nnz, stream);
+  updateDevice(verify.data(), verify_h.data(), N, stream);
+
+  int n_result = weak_cc_union_find<int, 32>(
+    result.data(), row_ind.data(), row_ind_ptr.data(), nnz, N, alloc, stream);
+
+  ASSERT_EQ(n_components, n_result);
+  ASSERT_TRUE(
+    devArrMatch<int>(verify.data(), result.data(), N, Compare<int>(), stream));
+
+  cudaStreamDestroy(stream);
+}
+
 INSTANTIATE_TEST_CASE_P(CSRTests, WeakCCTest, ::testing::ValuesIn(inputsf));
 
+INSTANTIATE_TEST_CASE_P(CSRTests, WeakCCUnionFindTest,
+                        ::testing::ValuesIn(inputsf));
+
+INSTANTIATE_TEST_CASE_P(CSRTests, WeakCCComponentsTest,
+                        ::testing::ValuesIn(inputsf));
+
 INSTANTIATE_TEST_CASE_P(CSRTests, AdjGraphTest, ::testing::ValuesIn(inputsf));
 
 INSTANTIATE_TEST_CASE_P(CSRTests, CSRRowOpTest, ::testing::ValuesIn(inputsf));
 
 INSTANTIATE_TEST_CASE_P(CSRTests, CSRToCOO, ::testing::ValuesIn(inputsf));
 
+INSTANTIATE_TEST_CASE_P(CSRTests, CSRToDenseRows,
+                        ::testing::ValuesIn(inputsf));
+
 INSTANTIATE_TEST_CASE_P(CSRTests, CSRRowNormalizeMax,
                         ::testing::ValuesIn(inputsf));
 
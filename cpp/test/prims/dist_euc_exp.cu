@@ -62,5 +62,88 @@ TEST_P(DistanceEucExpTestD, Result) {
 INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceEucExpTestD,
                         ::testing::ValuesIn(inputsd));
 
+/**
+ * distanceAutoTile on all the output tiles, with the workspace for the norms
+ * and without it, for the L2 to be evaluated in its unexpanded form
+ */
+template <typename DataType>
+void autoTileLauncher(DataType *x, DataType *y, DataType *dist, int m, int n,
+                      int k, char *workspace, size_t worksize,
+                      cudaStream_t stream, bool isRowMajor) {
+  auto fin_op = [] __device__(DataType d_val, int g_d_idx) { return d_val; };
+  distanceAutoTile<EucExpandedL2, DataType, DataType, DataType,
+                   decltype(fin_op)>(x, y, dist, m, n, k, workspace, worksize,
+                                     fin_op, stream, isRowMajor);
+}
+
+template <typename DataType>
+class DistanceEucExpAutoTileTest
+  : public ::testing::TestWithParam<DistanceInputs<DataType>> {
+ public:
+  void SetUp() override {
+    params = ::testing::TestWithParam<DistanceInputs<DataType>>::GetParam();
+    Random::Rng r(params.seed);
+    int m = params.m;
+    int n = params.n;
+    int k = params.k;
+    bool isRowMajor = params.isRowMajor;
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    allocate(x, m * k);
+    allocate(y, n * k);
+    allocate(dist_ref, m * n);
+    allocate(dist, m * n);
+    allocate(dist_nows, m * n);
+    r.uniform(x, m * k, DataType(-1.0), DataType(1.0), stream);
+    r.uniform(y, n * k, DataType(-1.0), DataType(1.0), stream);
+    naiveDistance(dist_ref, x, y, m, n, k, EucExpandedL2, isRowMajor);
+    char *workspace = nullptr;
+    size_t worksize =
+      getWorkspaceSize<EucExpandedL2, DataType, DataType, DataType>(x, y, m, n,
+                                                                   k);
+    allocate(workspace, worksize);
+
+    autoTileLauncher(x, y, dist, m, n, k, workspace, worksize, stream,
+                     isRowMajor);
+    autoTileLauncher(x, y, dist_nows, m, n, k, (char *)nullptr, 0, stream,
+                     isRowMajor);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+    CUDA_CHECK(cudaFree(workspace));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(x));
+    CUDA_CHECK(cudaFree(y));
+    CUDA_CHECK(cudaFree(dist_ref));
+    CUDA_CHECK(cudaFree(dist));
+    CUDA_CHECK(cudaFree(dist_nows));
+  }
+
+ protected:
+  DistanceInputs<DataType> params;
+  DataType *x, *y, *dist_ref, *dist, *dist_nows;
+};
+
+const std::vector<DistanceInputs<float>> inputsAutoTilef = {
+  {0.001f, 1024, 1024, 32, true, 1234ULL},
+  {0.001f, 300, 200, 64, true, 1234ULL},
+  {0.003f, 16, 100, 1024, true, 1234ULL},
+  {0.001f, 1024, 1024, 32, false, 1234ULL},
+  {0.001f, 300, 200, 64, false, 1234ULL},
+  {0.003f, 16, 100, 1024, false, 1234ULL},
+};
+typedef DistanceEucExpAutoTileTest<float> DistanceEucExpAutoTileTestF;
+TEST_P(DistanceEucExpAutoTileTestF, Result) {
+  int m = params.isRowMajor ? params.m : params.n;
+  int n = params.isRowMajor ? params.n : params.m;
+  ASSERT_TRUE(
+    devArrMatch(dist_ref, dist, m, n, CompareApprox<float>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(dist_ref, dist_nows, m, n,
+                          CompareApprox<float>(params.tolerance)));
+}
+INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceEucExpAutoTileTestF,
+                        ::testing::ValuesIn(inputsAutoTilef));
+
 }  // end namespace Distance
 }  // end namespace MLCommon
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "distance_base.h"
+
+namespace MLCommon {
+namespace Distance {
+
+template <typename DataType>
+class DistanceHaversine
+  : public DistanceTest<EucUnexpandedHaversine, DataType> {};
+
+const std::vector<DistanceInputs<float>> inputsf = {
+  {0.001f, 1024, 1024, 2, true, 1234ULL},
+  {0.001f, 1024, 32, 2, true, 1234ULL},
+  {0.001f, 32, 1024, 2, true, 1234ULL},
+  {0.001f, 777, 333, 2, true, 1234ULL},
+  {0.001f, 1024, 1024, 2, false, 1234ULL},
+  {0.001f, 1024, 32, 2, false, 1234ULL},
+  {0.001f, 32, 1024, 2, false, 1234ULL},
+  {0.001f, 777, 333, 2, false, 1234ULL},
+};
+typedef DistanceHaversine<float> DistanceHaversineF;
+TEST_P(DistanceHaversineF, Result) {
+  int m = params.isRowMajor ? params.m : params.n;
+  int n = params.isRowMajor ? params.n : params.m;
+  ASSERT_TRUE(
+    devArrMatch(dist_ref, dist, m, n, CompareApprox<float>(params.tolerance)));
+}
+INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceHaversineF,
+                        ::testing::ValuesIn(inputsf));
+
+const std::vector<DistanceInputs<double>> inputsd = {
+  {0.001, 1024, 1024, 2, true, 1234ULL},
+  {0.001, 1024, 32, 2, true, 1234ULL},
+  {0.001, 32, 1024, 2, true, 1234ULL},
+  {0.001, 777, 333, 2, true, 1234ULL},
+  {0.001, 1024, 1024, 2, false, 1234ULL},
+  {0.001, 1024, 32, 2, false, 1234ULL},
+  {0.001, 32, 1024, 2, false, 1234ULL},
+  {0.001, 777, 333, 2, false, 1234ULL},
+};
+typedef DistanceHaversine<double> DistanceHaversineD;
+TEST_P(DistanceHaversineD, Result) {
+  int m = params.isRowMajor ? params.m : params.n;
+  int n = params.isRowMajor ? params.n : params.m;
+  ASSERT_TRUE(
+    devArrMatch(dist_ref, dist, m, n, CompareApprox<double>(params.tolerance)));
+}
+INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceHaversineD,
+                        ::testing::ValuesIn(inputsd));
+
+}  // end namespace Distance
+}  // end namespace MLCommon
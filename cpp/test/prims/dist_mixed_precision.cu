@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "distance/distance_mixed_precision.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Distance {
+
+struct MixedPrecisionDistanceInputs {
+  int m, n, k;
+  GemmPrecision precision;
+  float tolerance;
+  unsigned long long int seed;
+};
+
+::std::ostream &operator<<(::std::ostream &os,
+                           const MixedPrecisionDistanceInputs &dims) {
+  return os;
+}
+
+/**
+ * The squared L2 distances and cosine similarities with the gemm in each
+ * precision, against the host. The coordinates are multiples of 1/8 in
+ * [-2, 2], which all the precisions hold exactly, so that the products are
+ * exact and only the square roots of the cosine are rounded.
+ */
+class MixedPrecisionDistanceTest
+  : public ::testing::TestWithParam<MixedPrecisionDistanceInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<MixedPrecisionDistanceInputs>::GetParam();
+    int m = params.m, n = params.n, k = params.k;
+
+    int dev, major;
+    CUDA_CHECK(cudaGetDevice(&dev));
+    CUDA_CHECK(
+      cudaDeviceGetAttribute(&major, cudaDevAttrComputeCapabilityMajor, dev));
+    supported = params.precision == GemmFp32 ||
+                (params.precision == GemmFp16 && major >= 7);
+#if CUDART_VERSION >= 11000
+    supported = supported || major >= 8;
+#endif
+    if (!supported) return;
+
+    cudaStream_t stream;
+    cublasHandle_t cublasHandle;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    CUBLAS_CHECK(cublasCreate(&cublasHandle));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+    std::default_random_engine gen(params.seed);
+    std::uniform_int_distribution<int> coord(-16, 16);
+    std::vector<float> x_h(m * k), y_h(n * k);
+    for (auto &v : x_h) v = float(coord(gen)) / 8.f;
+    // no row of y is zero, for the cosine to be defined
+    for (int j = 0; j < n; j++) {
+      for (int c = 0; c < k; c++) y_h[j * k + c] = float(coord(gen)) / 8.f;
+      y_h[j * k] = 0.125f * (1 + (j % 16));
+    }
+    for (int i = 0; i < m; i++) x_h[i * k] = 0.125f * (1 + (i % 16));
+
+    l2_exp.resize(m * n);
+    cos_exp.resize(m * n);
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < n; j++) {
+        double d = 0, dot = 0, xn = 0, yn = 0;
+        for (int c = 0; c < k; c++) {
+          double a = x_h[i * k + c], b = y_h[j * k + c];
+          d += (a - b) * (a - b);
+          dot += a * b;
+          xn += a * a;
+          yn += b * b;
+        }
+        l2_exp[i * n + j] = float(d);
+        cos_exp[i * n + j] = float(dot / (std::sqrt(xn) * std::sqrt(yn)));
+      }
+    }
+
+    device_buffer<float> x(alloc, stream, m * k), y(alloc, stream, n * k);
+    device_buffer<float> dist(alloc, stream, m * n);
+    updateDevice(x.data(), x_h.data(), m * k, stream);
+    updateDevice(y.data(), y_h.data(), n * k, stream);
+    l2_res.resize(m * n);
+    cos_res.resize(m * n);
+    mixedPrecisionDistance<EucExpandedL2>(x.data(), y.data(), dist.data(), m,
+                                          n, k, params.precision, cublasHandle,
+                                          alloc, stream);
+    updateHost(l2_res.data(), dist.data(), m * n, stream);
+    mixedPrecisionDistance<EucExpandedCosine>(x.data(), y.data(), dist.data(),
+                                              m, n, k, params.precision,
+                                              cublasHandle, alloc, stream);
+    updateHost(cos_res.data(), dist.data(), m * n, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUBLAS_CHECK(cublasDestroy(cublasHandle));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  MixedPrecisionDistanceInputs params;
+  bool supported;
+  std::vector<float> l2_exp, cos_exp, l2_res, cos_res;
+};
+
+::testing::AssertionResult match(const std::vector<float> &expected,
+                                 const std::vector<float> &actual,
+                                 float tolerance) {
+  CompareApprox<float> eq(tolerance);
+  for (size_t i = 0; i < expected.size(); i++) {
+    if (!eq(expected[i], actual[i])) {
+      return ::testing::AssertionFailure()
+             << "actual=" << actual[i] << " != expected=" << expected[i]
+             << " @" << i;
+    }
+  }
+  return ::testing::AssertionSuccess();
+}
+
+const std::vector<MixedPrecisionDistanceInputs> inputs = {
+  {1, 1, 8, GemmFp32, 1e-5f, 1234ULL},
+  {100, 300, 16, GemmFp32, 1e-5f, 1234ULL},
+  {1, 1, 8, GemmFp16, 1e-5f, 1234ULL},
+  {100, 300, 16, GemmFp16, 1e-5f, 1234ULL},
+  {257, 129, 64, GemmFp16, 1e-5f, 42ULL},
+  {257, 129, 17, GemmFp16, 1e-5f, 42ULL},
+  {100, 300, 16, GemmBf16, 1e-5f, 1234ULL},
+  {257, 129, 64, GemmBf16, 1e-5f, 42ULL},
+  {100, 300, 16, GemmTf32, 1e-5f, 1234ULL},
+  {257, 129, 64, GemmTf32, 1e-5f, 42ULL}};
+typedef MixedPrecisionDistanceTest MixedPrecisionDistanceTestF;
+TEST_P(MixedPrecisionDistanceTestF, Result) {
+  // the precisions the device or the toolkit lack are not run
+  if (!supported) return;
+  ASSERT_TRUE(match(l2_exp, l2_res, params.tolerance));
+  ASSERT_TRUE(match(cos_exp, cos_res, params.tolerance));
+}
+INSTANTIATE_TEST_CASE_P(MixedPrecisionDistanceTests,
+                        MixedPrecisionDistanceTestF,
+                        ::testing::ValuesIn(inputs));
+
+};  // namespace Distance
+};  // namespace MLCommon
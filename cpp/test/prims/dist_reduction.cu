@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "distance/distance_reduction.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Distance {
+
+template <typename T>
+struct DistanceReductionInputs {
+  int m, n, k, nLabels;
+  T eps;
+  T tolerance;
+  unsigned long long int seed;
+};
+
+template <typename T>
+::std::ostream &operator<<(::std::ostream &os,
+                           const DistanceReductionInputs<T> &dims) {
+  return os;
+}
+
+/**
+ * The fused min/argmin, count within eps and sum by label of the squared L2
+ * distances, in their expanded and unexpanded forms, against the reductions
+ * of the distance matrix on the host
+ */
+template <typename T>
+class DistanceReductionTest
+  : public ::testing::TestWithParam<DistanceReductionInputs<T>> {
+ protected:
+  template <DistanceType distanceType>
+  void run(const T *x, const T *y, const int *labels,
+           std::shared_ptr<deviceAllocator> alloc, cudaStream_t stream,
+           int pass) {
+    int m = params.m, n = params.n, k = params.k, nLabels = params.nLabels;
+    device_buffer<cub::KeyValuePair<int, T>> minArgmin(alloc, stream, m);
+    device_buffer<int> counts(alloc, stream, m);
+    device_buffer<T> sums(alloc, stream, m * nLabels);
+    CUDA_CHECK(cudaMemsetAsync(counts.data(), 0, m * sizeof(int), stream));
+    CUDA_CHECK(
+      cudaMemsetAsync(sums.data(), 0, m * nLabels * sizeof(T), stream));
+    minAndArgMinDistance<distanceType, T>(x, y, m, n, k, minArgmin.data(),
+                                          alloc, stream);
+    countWithinDistance<distanceType, T>(x, y, m, n, k, params.eps,
+                                         counts.data(), alloc, stream);
+    sumDistanceByLabel<distanceType, T, int>(x, y, m, n, k, labels, nLabels,
+                                             sums.data(), alloc, stream);
+
+    std::vector<cub::KeyValuePair<int, T>> minArgmin_h(m);
+    updateHost(minArgmin_h.data(), minArgmin.data(), m, stream);
+    updateHost(count_res[pass].data(), counts.data(), m, stream);
+    updateHost(sum_res[pass].data(), sums.data(), m * nLabels, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    for (int i = 0; i < m; i++) {
+      argmin_res[pass][i] = minArgmin_h[i].key;
+      min_res[pass][i] = minArgmin_h[i].value;
+    }
+  }
+
+  void SetUp() override {
+    params = ::testing::TestWithParam<DistanceReductionInputs<T>>::GetParam();
+    int m = params.m, n = params.n, k = params.k, nLabels = params.nLabels;
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+    // the coordinates are multiples of 1/8, so that all the forms of the
+    // distances are exact and their ties go to the lowest index everywhere
+    std::default_random_engine gen(params.seed);
+    std::uniform_int_distribution<int> coord(-16, 16);
+    std::uniform_int_distribution<int> label(0, nLabels - 1);
+    std::vector<T> x_h(m * k), y_h(n * k);
+    std::vector<int> labels_h(n);
+    for (auto &v : x_h) v = T(coord(gen)) / T(8);
+    for (auto &v : y_h) v = T(coord(gen)) / T(8);
+    for (auto &l : labels_h) l = label(gen);
+
+    min_exp.assign(m, T(0));
+    argmin_exp.assign(m, 0);
+    count_exp.assign(m, 0);
+    sum_exp.assign(m * nLabels, T(0));
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < n; j++) {
+        T d = 0;
+        for (int c = 0; c < k; c++) {
+          T diff = x_h[i * k + c] - y_h[j * k + c];
+          d += diff * diff;
+        }
+        if (j == 0 || d < min_exp[i]) {
+          min_exp[i] = d;
+          argmin_exp[i] = j;
+        }
+        if (d <= params.eps) count_exp[i]++;
+        sum_exp[i * nLabels + labels_h[j]] += d;
+      }
+    }
+
+    device_buffer<T> x(alloc, stream, m * k), y(alloc, stream, n * k);
+    device_buffer<int> labels(alloc, stream, n);
+    updateDevice(x.data(), x_h.data(), m * k, stream);
+    updateDevice(y.data(), y_h.data(), n * k, stream);
+    updateDevice(labels.data(), labels_h.data(), n, stream);
+    for (int pass = 0; pass < 2; pass++) {
+      min_res[pass].resize(m);
+      argmin_res[pass].resize(m);
+      count_res[pass].resize(m);
+      sum_res[pass].resize(m * nLabels);
+    }
+    run<EucExpandedL2>(x.data(), y.data(), labels.data(), alloc, stream, 0);
+    run<EucUnexpandedL2>(x.data(), y.data(), labels.data(), alloc, stream, 1);
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  DistanceReductionInputs<T> params;
+  std::vector<T> min_exp, sum_exp, min_res[2], sum_res[2];
+  std::vector<int> argmin_exp, count_exp, argmin_res[2], count_res[2];
+};
+
+template <typename T>
+::testing::AssertionResult match(const std::vector<T> &expected,
+                                 const std::vector<T> &actual, T tolerance) {
+  CompareApprox<T> eq(tolerance);
+  for (size_t i = 0; i < expected.size(); i++) {
+    if (!eq(expected[i], actual[i])) {
+      return ::testing::AssertionFailure()
+             << "actual=" << actual[i] << " != expected=" << expected[i]
+             << " @" << i;
+    }
+  }
+  return ::testing::AssertionSuccess();
+}
+
+const std::vector<DistanceReductionInputs<float>> inputsf = {
+  {1, 1, 1, 1, 1.f, 1e-5f, 1234ULL},
+  {100, 300, 3, 4, 2.f, 1e-5f, 1234ULL},
+  {257, 129, 17, 7, 10.f, 1e-5f, 42ULL}};
+typedef DistanceReductionTest<float> DistanceReductionTestF;
+TEST_P(DistanceReductionTestF, Result) {
+  for (int pass = 0; pass < 2; pass++) {
+    ASSERT_TRUE(match(min_exp, min_res[pass], params.tolerance));
+    ASSERT_EQ(argmin_exp, argmin_res[pass]);
+    ASSERT_EQ(count_exp, count_res[pass]);
+    ASSERT_TRUE(match(sum_exp, sum_res[pass], params.tolerance));
+  }
+}
+INSTANTIATE_TEST_CASE_P(DistanceReductionTests, DistanceReductionTestF,
+                        ::testing::ValuesIn(inputsf));
+
+const std::vector<DistanceReductionInputs<double>> inputsd = {
+  {1, 1, 1, 1, 1.0, 1e-10, 1234ULL},
+  {100, 300, 3, 4, 2.0, 1e-10, 1234ULL},
+  {257, 129, 17, 7, 10.0, 1e-10, 42ULL}};
+typedef DistanceReductionTest<double> DistanceReductionTestD;
+TEST_P(DistanceReductionTestD, Result) {
+  for (int pass = 0; pass < 2; pass++) {
+    ASSERT_TRUE(match(min_exp, min_res[pass], params.tolerance));
+    ASSERT_EQ(argmin_exp, argmin_res[pass]);
+    ASSERT_EQ(count_exp, count_res[pass]);
+    ASSERT_TRUE(match(sum_exp, sum_res[pass], params.tolerance));
+  }
+}
+INSTANTIATE_TEST_CASE_P(DistanceReductionTests, DistanceReductionTestD,
+                        ::testing::ValuesIn(inputsd));
+
+};  // namespace Distance
+};  // namespace MLCommon
@@ -95,9 +95,98 @@ __global__ void naiveCosineDistanceKernel(DataType *dist, const DataType *x,
   dist[outidx] = acc_ab / (mySqrt(acc_a) * mySqrt(acc_b));
 }
 
+template <typename DataType>
+__global__ void naiveOtherDistanceKernel(DataType *dist, const DataType *x,
+                                         const DataType *y, int m, int n,
+                                         int k, DistanceType type,
+                                         bool isRowMajor, DataType p) {
+  int midx = threadIdx.x + blockIdx.x * blockDim.x;
+  int nidx = threadIdx.y + blockIdx.y * blockDim.y;
+  if (midx >= m || nidx >= n) {
+    return;
+  }
+
+  DataType mean_a = DataType(0);
+  DataType mean_b = DataType(0);
+  for (int i = 0; i < k; ++i) {
+    mean_a += x[isRowMajor ? i + midx * k : i * m + midx];
+    mean_b += y[isRowMajor ? i + nidx * k : i * n + nidx];
+  }
+  mean_a /= k;
+  mean_b /= k;
+
+  DataType acc = DataType(0);
+  DataType acc_a = DataType(0);
+  DataType acc_b = DataType(0);
+  DataType acc_ab = DataType(0);
+  for (int i = 0; i < k; ++i) {
+    int xidx = isRowMajor ? i + midx * k : i * m + midx;
+    int yidx = isRowMajor ? i + nidx * k : i * n + nidx;
+    auto a = x[xidx];
+    auto b = y[yidx];
+    auto diff = (a > b) ? (a - b) : (b - a);
+    switch (type) {
+      case EucUnexpandedLinf:
+        acc = diff > acc ? diff : acc;
+        break;
+      case EucUnexpandedMinkowski:
+        acc += myPow(diff, p);
+        break;
+      case EucUnexpandedHamming:
+        acc += a != b ? DataType(1) : DataType(0);
+        break;
+      case EucExpandedJaccard:
+        // intersection and union of binary inputs
+        acc_ab += a * b;
+        acc += a + b - a * b;
+        break;
+      default:
+        acc_a += (a - mean_a) * (a - mean_a);
+        acc_b += (b - mean_b) * (b - mean_b);
+        acc_ab += (a - mean_a) * (b - mean_b);
+    }
+  }
+
+  switch (type) {
+    case EucUnexpandedMinkowski:
+      acc = myPow(acc, DataType(1) / p);
+      break;
+    case EucUnexpandedHamming:
+      acc /= k;
+      break;
+    case EucExpandedJaccard:
+      acc = acc > DataType(0) ? DataType(1) - acc_ab / acc : DataType(0);
+      break;
+    case EucExpandedCorrelation:
+      acc = DataType(1) - acc_ab / (mySqrt(acc_a) * mySqrt(acc_b));
+      break;
+    case EucUnexpandedHaversine: {
+      DataType lat1 = x[isRowMajor ? midx * k : midx];
+      DataType lon1 = x[isRowMajor ? 1 + midx * k : m + midx];
+      DataType lat2 = y[isRowMajor ? nidx * k : nidx];
+      DataType lon2 = y[isRowMajor ? 1 + nidx * k : n + nidx];
+      DataType s1 = sin((lat2 - lat1) / 2), s2 = sin((lon2 - lon1) / 2);
+      acc = 2 * asin(mySqrt(s1 * s1 + cos(lat1) * cos(lat2) * s2 * s2));
+      break;
+    }
+    default:
+      break;
+  }
+
+  int outidx = isRowMajor ? midx * n + nidx : midx + m * nidx;
+  dist[outidx] = acc;
+}
+
+template <typename DataType>
+__global__ void binarizeKernel(DataType *x, int len) {
+  int idx = threadIdx.x + blockIdx.x * blockDim.x;
+  if (idx < len) x[idx] = x[idx] > DataType(0) ? DataType(1) : DataType(0);
+}
+
 template <typename DataType>
 void naiveDistance(DataType *dist, const DataType *x, const DataType *y, int m,
-                   int n, int k, DistanceType type, bool isRowMajor) {
+                   int n, int k, DistanceType type, bool isRowMajor,
+                   DataType metric_arg = 2) {
   static const dim3 TPB(16, 32, 1);
   dim3 nblks(ceildiv(m, (int)TPB.x), ceildiv(n, (int)TPB.y), 1);
 
@@ -117,6 +206,15 @@ void naiveDistance(DataType *dist, const DataType *x, const DataType *y, int m,
       naiveCosineDistanceKernel<DataType>
         <<<nblks, TPB>>>(dist, x, y, m, n, k, isRowMajor);
       break;
+    case EucUnexpandedLinf:
+    case EucUnexpandedMinkowski:
+    case EucUnexpandedHamming:
+    case EucExpandedJaccard:
+    case EucExpandedCorrelation:
+    case EucUnexpandedHaversine:
+      naiveOtherDistanceKernel<DataType><<<nblks, TPB>>>(
+        dist, x, y, m, n, k, type, isRowMajor, metric_arg);
+      break;
     default:
       FAIL() << "should be here\n";
   }
@@ -129,6 +227,8 @@ struct DistanceInputs {
   int m, n, k;
   bool isRowMajor;
   unsigned long long int seed;
+  /** the order p of the Minkowski distance, unused by the others */
+  DataType metric_arg;
 };
 
 template <typename DataType>
@@ -147,7 +247,8 @@ void distanceLauncher(DataType *x, DataType *y, DataType *dist, DataType *dist2,
     return d_val;
   };
   distance<distanceType, DataType, DataType, DataType, OutputTile_t>(
-    x, y, dist, m, n, k, workspace, worksize, fin_op, stream, isRowMajor);
+    x, y, dist, m, n, k, workspace, worksize, fin_op, stream, isRowMajor,
+    params.metric_arg);
 }
 
 template <DistanceType distanceType, typename DataType>
@@ -169,7 +270,15 @@ class DistanceTest : public ::testing::TestWithParam<DistanceInputs<DataType>> {
     allocate(dist2, m * n);
     r.uniform(x, m * k, DataType(-1.0), DataType(1.0), stream);
     r.uniform(y, n * k, DataType(-1.0), DataType(1.0), stream);
-    naiveDistance(dist_ref, x, y, m, n, k, distanceType, isRowMajor);
+    if (distanceType == EucUnexpandedHamming ||
+        distanceType == EucExpandedJaccard) {
+      binarizeKernel<<<ceildiv(m * k, 256), 256, 0, stream>>>(x, m * k);
+      binarizeKernel<<<ceildiv(n * k, 256), 256, 0, stream>>>(y, n * k);
+      CUDA_CHECK(cudaPeekAtLastError());
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+    }
+    naiveDistance(dist_ref, x, y, m, n, k, distanceType, isRowMajor,
+                  params.metric_arg);
     char *workspace = nullptr;
     size_t worksize =
       getWorkspaceSize<distanceType, DataType, DataType, DataType>(x, y, m, n,
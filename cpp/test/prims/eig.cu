@@ -80,6 +80,22 @@ class EigTest : public ::testing::TestWithParam<EigInputs<T>> {
     eigJacobi(cov_matrix, params.n_row, params.n_col, eig_vectors_jacobi,
               eig_vals_jacobi, cusolverH, stream, allocator, tol, sweeps);
 
+    // the same matrix, repeated n_batch times, decomposed in one batch
+    allocate(cov_matrix_batched, len * n_batch);
+    allocate(eig_vectors_batched, len * n_batch);
+    allocate(eig_vals_batched, params.n_col * n_batch);
+    allocate(eig_vectors_batched_ref, len * n_batch);
+    allocate(eig_vals_batched_ref, params.n_col * n_batch);
+    for (int b = 0; b < n_batch; b++) {
+      updateDevice(cov_matrix_batched + b * len, cov_matrix_h, len, stream);
+      copy(eig_vectors_batched_ref + b * len, eig_vectors_jacobi, len, stream);
+      updateDevice(eig_vals_batched_ref + b * params.n_col, eig_vals_ref_h,
+                   params.n_col, stream);
+    }
+    eigJacobiBatched(cov_matrix_batched, params.n_col, n_batch,
+                     eig_vectors_batched, eig_vals_batched, cusolverH, stream,
+                     allocator, tol, sweeps);
+
     // test code for comparing two methods
     len = params.n * params.n;
     allocate(cov_matrix_large, len);
@@ -104,6 +120,11 @@ class EigTest : public ::testing::TestWithParam<EigInputs<T>> {
     CUDA_CHECK(cudaFree(eig_vals_jacobi));
     CUDA_CHECK(cudaFree(eig_vectors_ref));
     CUDA_CHECK(cudaFree(eig_vals_ref));
+    CUDA_CHECK(cudaFree(cov_matrix_batched));
+    CUDA_CHECK(cudaFree(eig_vectors_batched));
+    CUDA_CHECK(cudaFree(eig_vals_batched));
+    CUDA_CHECK(cudaFree(eig_vectors_batched_ref));
+    CUDA_CHECK(cudaFree(eig_vals_batched_ref));
     CUSOLVER_CHECK(cusolverDnDestroy(cusolverH));
     CUDA_CHECK(cudaStreamDestroy(stream));
   }
@@ -116,6 +137,10 @@ class EigTest : public ::testing::TestWithParam<EigInputs<T>> {
   T *cov_matrix_large, *eig_vectors_large, *eig_vectors_jacobi_large,
     *eig_vals_large, *eig_vals_jacobi_large;
 
+  static const int n_batch = 5;
+  T *cov_matrix_batched, *eig_vectors_batched, *eig_vals_batched,
+    *eig_vectors_batched_ref, *eig_vals_batched_ref;
+
   cusolverDnHandle_t cusolverH = NULL;
   cudaStream_t stream;
 };
@@ -188,6 +213,26 @@ TEST_P(EigTestVecCompareD, Result) {
                           CompareApproxAbs<double>(params.tolerance)));
 }
 
+typedef EigTest<float> EigTestBatchedF;
+TEST_P(EigTestBatchedF, Result) {
+  ASSERT_TRUE(devArrMatch(eig_vals_batched_ref, eig_vals_batched,
+                          params.n_col * n_batch,
+                          CompareApproxAbs<float>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(eig_vectors_batched_ref, eig_vectors_batched,
+                          params.len * n_batch,
+                          CompareApproxAbs<float>(params.tolerance)));
+}
+
+typedef EigTest<double> EigTestBatchedD;
+TEST_P(EigTestBatchedD, Result) {
+  ASSERT_TRUE(devArrMatch(eig_vals_batched_ref, eig_vals_batched,
+                          params.n_col * n_batch,
+                          CompareApproxAbs<double>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(eig_vectors_batched_ref, eig_vectors_batched,
+                          params.len * n_batch,
+                          CompareApproxAbs<double>(params.tolerance)));
+}
+
 INSTANTIATE_TEST_CASE_P(EigTests, EigTestValF, ::testing::ValuesIn(inputsf2));
 
 INSTANTIATE_TEST_CASE_P(EigTests, EigTestValD, ::testing::ValuesIn(inputsd2));
@@ -208,5 +253,11 @@ INSTANTIATE_TEST_CASE_P(EigTests, EigTestVecJacobiF,
 INSTANTIATE_TEST_CASE_P(EigTests, EigTestVecJacobiD,
                         ::testing::ValuesIn(inputsd2));
 
+INSTANTIATE_TEST_CASE_P(EigTests, EigTestBatchedF,
+                        ::testing::ValuesIn(inputsf2));
+
+INSTANTIATE_TEST_CASE_P(EigTests, EigTestBatchedD,
+                        ::testing::ValuesIn(inputsd2));
+
 }  // end namespace LinAlg
 }  // end namespace MLCommon
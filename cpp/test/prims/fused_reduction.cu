@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "linalg/fused_reduction.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace LinAlg {
+
+template <typename T>
+struct FusedReductionInputs {
+  T tolerance;
+  int rows, cols;
+  bool rowMajor, alongRows;
+  unsigned long long int seed;
+};
+
+template <typename T>
+::std::ostream &operator<<(::std::ostream &os,
+                           const FusedReductionInputs<T> &dims) {
+  return os;
+}
+
+// Or else, we get the following compilation error
+// for an extended __device__ lambda cannot have private or protected access
+// within its class
+template <typename T>
+void fusedReductionLaunch(T *norms, T *maxs, const T *data, const T *colMeans,
+                          const T *rowScales, int cols, int rows,
+                          bool rowMajor, bool alongRows,
+                          std::shared_ptr<deviceAllocator> alloc,
+                          cudaStream_t stream) {
+  // the L2 norms of the centered and scaled matrix
+  auto center = [colMeans] __device__(T v, int row, int col) {
+    return v - colMeans[col];
+  };
+  auto scale = [rowScales] __device__(T v, int row, int col) {
+    return v * rowScales[row];
+  };
+  auto square = [] __device__(T v, int row, int col) { return v * v; };
+  fusedReduction(
+    norms, data, cols, rows, T(0), rowMajor, alongRows, alloc, stream,
+    composeMaps(center, scale, square), false, Sum<T>(),
+    [] __device__(T v) { return mySqrt(v); });
+  // the max of the values and of the previous maxs
+  fusedReduction(
+    maxs, data, cols, rows, T(-1e30), rowMajor, alongRows, alloc, stream,
+    IdentityMap<T>(), true,
+    [] __device__(T a, T b) { return myMax(a, b); });
+}
+
+/**
+ * The fused chains of the maps of every layout and direction against the
+ * same chains on the host, with sizes that do or do not vectorize and
+ * strided reductions that do or do not need the partials of several blocks.
+ */
+template <typename T>
+class FusedReductionTest
+  : public ::testing::TestWithParam<FusedReductionInputs<T>> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<FusedReductionInputs<T>>::GetParam();
+    int rows = params.rows, cols = params.cols;
+    bool rowMajor = params.rowMajor, alongRows = params.alongRows;
+    outlen = alongRows ? rows : cols;
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+    std::default_random_engine gen(params.seed);
+    std::uniform_real_distribution<T> uniform(T(-1), T(1));
+    std::vector<T> data_h(size_t(rows) * cols), means_h(cols), scales_h(rows);
+    for (auto &v : data_h) v = uniform(gen);
+    for (auto &v : means_h) v = uniform(gen);
+    for (auto &v : scales_h) v = uniform(gen);
+    std::vector<T> prevMaxs_h(outlen);
+    for (auto &v : prevMaxs_h) v = T(0.5) * uniform(gen) + T(0.5);
+
+    std::vector<T> norms_h(outlen, T(0)), maxs_h(prevMaxs_h);
+    for (int r = 0; r < rows; r++) {
+      for (int c = 0; c < cols; c++) {
+        T v = rowMajor ? data_h[size_t(r) * cols + c]
+                       : data_h[size_t(c) * rows + r];
+        T m = (v - means_h[c]) * scales_h[r];
+        int o = alongRows ? r : c;
+        norms_h[o] += m * m;
+        maxs_h[o] = std::max(maxs_h[o], v);
+      }
+    }
+    for (auto &v : norms_h) v = std::sqrt(v);
+
+    device_buffer<T> data(alloc, stream, data_h.size());
+    device_buffer<T> means(alloc, stream, cols), scales(alloc, stream, rows);
+    updateDevice(data.data(), data_h.data(), data_h.size(), stream);
+    updateDevice(means.data(), means_h.data(), cols, stream);
+    updateDevice(scales.data(), scales_h.data(), rows, stream);
+    allocate(norms_exp, outlen);
+    allocate(norms_act, outlen);
+    allocate(maxs_exp, outlen);
+    allocate(maxs_act, outlen);
+    updateDevice(norms_exp, norms_h.data(), outlen, stream);
+    updateDevice(maxs_exp, maxs_h.data(), outlen, stream);
+    updateDevice(maxs_act, prevMaxs_h.data(), outlen, stream);
+    fusedReductionLaunch(norms_act, maxs_act, data.data(), means.data(),
+                         scales.data(), cols, rows, rowMajor, alongRows, alloc,
+                         stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(norms_exp));
+    CUDA_CHECK(cudaFree(norms_act));
+    CUDA_CHECK(cudaFree(maxs_exp));
+    CUDA_CHECK(cudaFree(maxs_act));
+  }
+
+ protected:
+  FusedReductionInputs<T> params;
+  T *norms_exp, *norms_act, *maxs_exp, *maxs_act;
+  int outlen;
+};
+
+const std::vector<FusedReductionInputs<float>> inputsf = {
+  {0.0001f, 1024, 32, true, true, 1234ULL},
+  {0.0001f, 1024, 257, true, true, 1234ULL},
+  {0.0001f, 1024, 32, true, false, 1234ULL},
+  {0.0001f, 100000, 33, true, false, 1234ULL},
+  {0.0001f, 1024, 32, false, true, 1234ULL},
+  {0.0001f, 1023, 1000, false, true, 1234ULL},
+  {0.0001f, 1024, 32, false, false, 1234ULL},
+  {0.0001f, 99999, 20, false, false, 1234ULL}};
+
+const std::vector<FusedReductionInputs<double>> inputsd = {
+  {0.000000001, 1024, 32, true, true, 1234ULL},
+  {0.000000001, 1024, 257, true, true, 1234ULL},
+  {0.000000001, 100000, 32, true, false, 1234ULL},
+  {0.000000001, 1024, 33, true, false, 1234ULL},
+  {0.000000001, 1024, 32, false, true, 1234ULL},
+  {0.000000001, 1023, 1000, false, true, 1234ULL},
+  {0.000000001, 1024, 32, false, false, 1234ULL},
+  {0.000000001, 99999, 20, false, false, 1234ULL}};
+
+typedef FusedReductionTest<float> FusedReductionTestF;
+TEST_P(FusedReductionTestF, Result) {
+  ASSERT_TRUE(devArrMatch(norms_exp, norms_act, outlen,
+                          CompareApprox<float>(params.tolerance)));
+  ASSERT_TRUE(
+    devArrMatch(maxs_exp, maxs_act, outlen, CompareApprox<float>(0.f)));
+}
+
+typedef FusedReductionTest<double> FusedReductionTestD;
+TEST_P(FusedReductionTestD, Result) {
+  ASSERT_TRUE(devArrMatch(norms_exp, norms_act, outlen,
+                          CompareApprox<double>(params.tolerance)));
+  ASSERT_TRUE(
+    devArrMatch(maxs_exp, maxs_act, outlen, CompareApprox<double>(0.0)));
+}
+
+INSTANTIATE_TEST_CASE_P(FusedReductionTests, FusedReductionTestF,
+                        ::testing::ValuesIn(inputsf));
+
+INSTANTIATE_TEST_CASE_P(FusedReductionTests, FusedReductionTestD,
+                        ::testing::ValuesIn(inputsd));
+
+}  // end namespace LinAlg
+}  // end namespace MLCommon
@@ -171,5 +171,48 @@ TEST_F(GramMatrixTest, RBF_Rectangular) {
   ASSERT_TRUE(
     devArrMatchHost(K, gram_dev, n1 * n2, CompareApprox<float>(1e-6f)));
 }
+TEST_F(GramMatrixTest, CsrInput) {
+  // x = [[1, 0, 2],
+  //      [0, 3, 0],
+  //      [4, 0, 5],
+  //      [0, 0, 6]]
+  const int n = 4, n_cols = 3, nnz = 6;
+  int row_ptr_h[] = {0, 2, 3, 5, 6};
+  int col_ind_h[] = {0, 2, 1, 0, 2, 2};
+  float vals_h[] = {1, 2, 3, 4, 5, 6};
+  // the same matrix in column major format
+  float x_h[] = {1, 0, 4, 0, 0, 3, 0, 0, 2, 0, 5, 6};
+
+  cusparseHandle_t cusparse_handle;
+  CUSPARSE_CHECK(cusparseCreate(&cusparse_handle));
+  device_buffer<int> row_ptr(allocator, stream, n + 1);
+  device_buffer<int> col_ind(allocator, stream, nnz);
+  device_buffer<float> vals(allocator, stream, nnz);
+  device_buffer<float> x(allocator, stream, n * n_cols);
+  device_buffer<float> gram_dense(allocator, stream, n * n);
+  device_buffer<float> gram_csr(allocator, stream, n * n);
+  updateDevice(row_ptr.data(), row_ptr_h, n + 1, stream);
+  updateDevice(col_ind.data(), col_ind_h, nnz, stream);
+  updateDevice(vals.data(), vals_h, nnz, stream);
+  updateDevice(x.data(), x_h, n * n_cols, stream);
+  CsrMatrix<float> x_csr{row_ptr.data(), col_ind.data(), vals.data(),
+                         nnz,            n,              n_cols};
+
+  for (auto params :
+       {KernelParams{LINEAR, 3, 1, 0}, KernelParams{POLYNOMIAL, 2, 0.5, 2.4},
+        KernelParams{TANH, 0, 0.1, 0.5}, KernelParams{RBF, 0, 0.1, 0}}) {
+    SCOPED_TRACE(params.kernel);
+    GramMatrixBase<float> *kernel =
+      KernelFactory<float>::create(params, cublas_handle);
+    (*kernel)(x.data(), n, n_cols, x.data(), n, gram_dense.data(), stream);
+    kernel->evaluateCsr(x_csr, x.data(), n, gram_csr.data(), cusparse_handle,
+                        allocator, stream, n, n);
+    ASSERT_TRUE(devArrMatch(gram_dense.data(), gram_csr.data(), n * n,
+                            CompareApprox<float>(1e-5f)));
+    delete kernel;
+  }
+  CUSPARSE_CHECK(cusparseDestroy(cusparse_handle));
+}
+
 };  // end namespace Matrix
 };  // end namespace MLCommon
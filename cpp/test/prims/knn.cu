@@ -17,8 +17,12 @@
 #include <cuda_utils.h>
 #include <gtest/gtest.h>
 #include <test_utils.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <numeric>
 #include <vector>
+#include "random/rng.h"
 #include "selection/knn.h"
 
 namespace MLCommon {
@@ -104,5 +108,330 @@ TEST_F(KNNTestF, Fit) {
   ASSERT_TRUE(devArrMatch(d_ref_I, d_pred_I, n * n, Compare<long>()));
 }
 
+struct KNNTilingInputs {
+  bool rowMajorQuery;
+  int n_int_streams;
+  int max_tile_rows;
+};
+
+::std::ostream &operator<<(::std::ostream &os, const KNNTilingInputs &dims) {
+  return os;
+}
+
+/**
+ * Queries some random rows against two partitions in tiles of max_tile_rows
+ * and checks the neighbors match those of a single tile.
+ */
+class KNNTilingTest : public ::testing::TestWithParam<KNNTilingInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<KNNTilingInputs>::GetParam();
+    auto alloc = std::make_shared<defaultDeviceAllocator>();
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    streams.resize(params.n_int_streams);
+    for (auto &s : streams) CUDA_CHECK(cudaStreamCreate(&s));
+
+    allocate(d_index, n_index * d);
+    allocate(d_query, n_query * d);
+    allocate<long>(d_ref_I, n_query * k);
+    allocate(d_ref_D, n_query * k);
+    allocate<long>(d_pred_I, n_query * k);
+    allocate(d_pred_D, n_query * k);
+    Random::Rng r(1234ULL);
+    r.uniform(d_index, n_index * d, -1.0f, 1.0f, stream);
+    r.uniform(d_query, n_query * d, -1.0f, 1.0f, stream);
+
+    std::vector<float *> input = {d_index, d_index + (n_index / 2) * d};
+    std::vector<int> sizes = {n_index / 2, n_index / 2};
+    brute_force_knn(input, sizes, d, d_query, n_query, d_ref_I, d_ref_D, k,
+                    alloc, stream, nullptr, 0, true, params.rowMajorQuery);
+    brute_force_knn(input, sizes, d, d_query, n_query, d_pred_I, d_pred_D, k,
+                    alloc, stream, streams.data(), params.n_int_streams, true,
+                    params.rowMajorQuery, nullptr, METRIC_L2, 2.0f,
+                    params.max_tile_rows);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(d_index));
+    CUDA_CHECK(cudaFree(d_query));
+    CUDA_CHECK(cudaFree(d_ref_I));
+    CUDA_CHECK(cudaFree(d_ref_D));
+    CUDA_CHECK(cudaFree(d_pred_I));
+    CUDA_CHECK(cudaFree(d_pred_D));
+    for (auto &s : streams) CUDA_CHECK(cudaStreamDestroy(s));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  KNNTilingInputs params;
+  cudaStream_t stream;
+  std::vector<cudaStream_t> streams;
+
+  int n_index = 200;
+  int n_query = 100;
+  int d = 4;
+  int k = 5;
+
+  float *d_index, *d_query;
+  long *d_ref_I, *d_pred_I;
+  float *d_ref_D, *d_pred_D;
+};
+
+const std::vector<KNNTilingInputs> tilingInputs = {
+  {true, 0, 7}, {true, 2, 7}, {false, 0, 7}, {false, 3, 16}, {true, 2, 100}};
+
+TEST_P(KNNTilingTest, Tiles) {
+  ASSERT_TRUE(devArrMatch(d_ref_D, d_pred_D, n_query * k,
+                          CompareApprox<float>(1e-4)));
+  ASSERT_TRUE(devArrMatch(d_ref_I, d_pred_I, n_query * k, Compare<long>()));
+}
+
+INSTANTIATE_TEST_CASE_P(KNNTilingTests, KNNTilingTest,
+                        ::testing::ValuesIn(tilingInputs));
+
+struct FusedKnnInputs {
+  int n_index;
+  int n_query;
+  int d;
+  int k;
+  bool rowMajorIndex;
+  bool rowMajorQuery;
+  MetricType metric;
+  float p;
+};
+
+::std::ostream &operator<<(::std::ostream &os, const FusedKnnInputs &dims) {
+  return os;
+}
+
+/**
+ * Checks fused_knn against the neighbors of a host brute force, on sizes
+ * which are not multiples of the tiles.
+ */
+class FusedKnnTest : public ::testing::TestWithParam<FusedKnnInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<FusedKnnInputs>::GetParam();
+    int n_index = params.n_index, n_query = params.n_query, d = params.d;
+    int k = params.k;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    allocate(d_index, n_index * d);
+    allocate(d_query, n_query * d);
+    allocate(d_ref_D, n_query * k);
+    allocate<long>(d_ref_I, n_query * k);
+    allocate(d_pred_D, n_query * k);
+    allocate<long>(d_pred_I, n_query * k);
+    Random::Rng r(4321ULL);
+    r.uniform(d_index, n_index * d, -1.0f, 1.0f, stream);
+    r.uniform(d_query, n_query * d, -1.0f, 1.0f, stream);
+
+    std::vector<float> h_index(n_index * d), h_query(n_query * d);
+    updateHost(h_index.data(), d_index, n_index * d, stream);
+    updateHost(h_query.data(), d_query, n_query * d, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+
+    std::vector<float> h_ref_D(n_query * k), dists(n_index);
+    std::vector<long> h_ref_I(n_query * k);
+    std::vector<int> order(n_index);
+    for (int q = 0; q < n_query; q++) {
+      for (int i = 0; i < n_index; i++) {
+        dists[i] = host_distance(h_index, i, h_query, q);
+      }
+      std::iota(order.begin(), order.end(), 0);
+      std::partial_sort(order.begin(), order.begin() + k, order.end(),
+                        [&](int a, int b) { return dists[a] < dists[b]; });
+      for (int j = 0; j < k; j++) {
+        h_ref_D[q * k + j] = dists[order[j]];
+        h_ref_I[q * k + j] = order[j];
+      }
+    }
+    updateDevice(d_ref_D, h_ref_D.data(), n_query * k, stream);
+    updateDevice(d_ref_I, h_ref_I.data(), n_query * k, stream);
+
+    fused_knn(d_index, n_index, params.rowMajorIndex, d_query, n_query,
+              params.rowMajorQuery, d, k, params.metric, params.p, d_pred_D,
+              d_pred_I, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  // Distance in the format of fused_knn of index row i and query row q
+  float host_distance(const std::vector<float> &h_index, int i,
+                      const std::vector<float> &h_query, int q) {
+    int n_index = params.n_index, n_query = params.n_query, d = params.d;
+    double acc = 0, index_norm = 0, query_norm = 0;
+    for (int c = 0; c < d; c++) {
+      double x = params.rowMajorIndex ? h_index[i * d + c]
+                                      : h_index[i + c * n_index];
+      double y = params.rowMajorQuery ? h_query[q * d + c]
+                                      : h_query[q + c * n_query];
+      switch (params.metric) {
+        case METRIC_L2:
+          acc += (x - y) * (x - y);
+          break;
+        case METRIC_INNER_PRODUCT:
+        case METRIC_COSINE:
+          acc += x * y;
+          index_norm += x * x;
+          query_norm += y * y;
+          break;
+        case METRIC_L1:
+          acc += std::abs(x - y);
+          break;
+        case METRIC_MINKOWSKI:
+          acc += std::pow(std::abs(x - y), params.p);
+          break;
+      }
+    }
+    if (params.metric == METRIC_INNER_PRODUCT) return -acc;
+    if (params.metric == METRIC_COSINE)
+      return 1 - acc / std::sqrt(index_norm * query_norm);
+    return acc;
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(d_index));
+    CUDA_CHECK(cudaFree(d_query));
+    CUDA_CHECK(cudaFree(d_ref_D));
+    CUDA_CHECK(cudaFree(d_ref_I));
+    CUDA_CHECK(cudaFree(d_pred_D));
+    CUDA_CHECK(cudaFree(d_pred_I));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  FusedKnnInputs params;
+  cudaStream_t stream;
+  float *d_index, *d_query, *d_ref_D, *d_pred_D;
+  long *d_ref_I, *d_pred_I;
+};
+
+const std::vector<FusedKnnInputs> fusedInputs = {
+  {300, 50, 37, 1, true, true, METRIC_L2, 2.0f},
+  {300, 50, 37, 5, false, true, METRIC_L2, 2.0f},
+  {300, 50, 37, 32, true, false, METRIC_L2, 2.0f},
+  {100, 13, 3, 10, false, false, METRIC_L2, 2.0f},
+  {1000, 70, 64, 16, true, true, METRIC_L2, 2.0f},
+  {1000, 70, 20, 100, true, true, METRIC_L2, 2.0f},
+  {300, 50, 37, 10, true, true, METRIC_INNER_PRODUCT, 2.0f},
+  {300, 50, 37, 10, false, true, METRIC_COSINE, 2.0f},
+  {300, 50, 37, 64, true, false, METRIC_COSINE, 2.0f},
+  {300, 50, 37, 10, true, true, METRIC_L1, 2.0f},
+  {300, 50, 37, 10, false, false, METRIC_MINKOWSKI, 3.0f}};
+
+TEST_P(FusedKnnTest, Neighbors) {
+  int len = params.n_query * params.k;
+  ASSERT_TRUE(devArrMatch(d_ref_D, d_pred_D, len, CompareApprox<float>(1e-4)));
+  ASSERT_TRUE(devArrMatch(d_ref_I, d_pred_I, len, Compare<long>()));
+}
+
+INSTANTIATE_TEST_CASE_P(FusedKnnTests, FusedKnnTest,
+                        ::testing::ValuesIn(fusedInputs));
+
+struct KnnQuantizedInputs {
+  int n_index;
+  int n_query;
+  int d;
+  int k;
+  bool rowMajorIndex;
+  KnnStorage storage;
+  // 0 searches without re-ranking
+  int n_cand;
+  float min_recall;
+};
+
+::std::ostream &operator<<(::std::ostream &os,
+                           const KnnQuantizedInputs &dims) {
+  return os;
+}
+
+/**
+ * Checks the recall of knn_quantized_search against the fp32 fused_knn,
+ * and that the re-ranked distances are the exact ones.
+ */
+class KnnQuantizedTest : public ::testing::TestWithParam<KnnQuantizedInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<KnnQuantizedInputs>::GetParam();
+    int n_index = params.n_index, n_query = params.n_query, d = params.d;
+    int k = params.k;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    auto alloc = std::make_shared<defaultDeviceAllocator>();
+    allocate(d_index, n_index * d);
+    allocate(d_query, n_query * d);
+    allocate(d_ref_D, n_query * k);
+    allocate<long>(d_ref_I, n_query * k);
+    allocate(d_pred_D, n_query * k);
+    allocate<long>(d_pred_I, n_query * k);
+    Random::Rng r(1234ULL);
+    r.uniform(d_index, n_index * d, -1.0f, 1.0f, stream);
+    r.uniform(d_query, n_query * d, -1.0f, 1.0f, stream);
+
+    fused_knn(d_index, n_index, params.rowMajorIndex, d_query, n_query, true,
+              d, k, METRIC_L2, 2.0f, d_ref_D, d_ref_I, stream);
+    KnnQuantizedIndex qindex(alloc, stream);
+    knn_quantized_build(&qindex, d_index, n_index, params.rowMajorIndex, d,
+                        params.storage, stream);
+    knn_quantized_search(qindex, d_query, n_query, true, k, METRIC_L2, 2.0f,
+                         d_pred_D, d_pred_I, alloc, stream,
+                         params.n_cand > 0 ? d_index : nullptr,
+                         params.n_cand);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  // Fraction of the true neighbors found
+  float recall() {
+    int len = params.n_query * params.k;
+    std::vector<long> ref_I(len), pred_I(len);
+    updateHost(ref_I.data(), d_ref_I, len, stream);
+    updateHost(pred_I.data(), d_pred_I, len, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    int found = 0;
+    for (int q = 0; q < params.n_query; q++) {
+      auto first = ref_I.begin() + q * params.k;
+      std::sort(first, first + params.k);
+      for (int j = 0; j < params.k; j++) {
+        found += std::binary_search(first, first + params.k,
+                                    pred_I[q * params.k + j]);
+      }
+    }
+    return (float)found / len;
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(d_index));
+    CUDA_CHECK(cudaFree(d_query));
+    CUDA_CHECK(cudaFree(d_ref_D));
+    CUDA_CHECK(cudaFree(d_ref_I));
+    CUDA_CHECK(cudaFree(d_pred_D));
+    CUDA_CHECK(cudaFree(d_pred_I));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  KnnQuantizedInputs params;
+  cudaStream_t stream;
+  float *d_index, *d_query, *d_ref_D, *d_pred_D;
+  long *d_ref_I, *d_pred_I;
+};
+
+const std::vector<KnnQuantizedInputs> quantizedInputs = {
+  {2000, 100, 32, 10, true, KNN_STORAGE_FP16, 0, 0.95f},
+  {2000, 100, 32, 10, false, KNN_STORAGE_FP16, 40, 1.0f},
+  {2000, 100, 32, 10, true, KNN_STORAGE_INT8, 0, 0.8f},
+  {2000, 100, 32, 10, false, KNN_STORAGE_INT8, 80, 1.0f}};
+
+TEST_P(KnnQuantizedTest, Recall) {
+  ASSERT_GE(recall(), params.min_recall);
+  if (params.n_cand > 0) {
+    int len = params.n_query * params.k;
+    ASSERT_TRUE(
+      devArrMatch(d_ref_D, d_pred_D, len, CompareApprox<float>(1e-4)));
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(KnnQuantizedTests, KnnQuantizedTest,
+                        ::testing::ValuesIn(quantizedInputs));
+
 };  // end namespace Selection
 };  // namespace MLCommon
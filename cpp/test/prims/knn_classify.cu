@@ -48,6 +48,7 @@ class KNNClassifyTest : public ::testing::TestWithParam<KNNClassifyInputs> {
     allocate(train_labels, params.rows);
 
     allocate(pred_labels, params.rows);
+    allocate(fused_labels, params.rows);
     allocate(unique_labels, params.n_labels, true);
 
     allocate(knn_indices, params.rows * params.k);
@@ -81,6 +82,17 @@ class KNNClassifyTest : public ::testing::TestWithParam<KNNClassifyInputs> {
     knn_classify(pred_labels, knn_indices, y, params.rows, params.k,
                  uniq_labels, n_unique, alloc, stream);
 
+    allocate(pred_proba, params.rows * n_classes);
+    allocate(fused_proba, params.rows * n_classes);
+    std::vector<float *> probs(1, pred_proba), fused_probs(1, fused_proba);
+    class_probs(probs, knn_indices, y, params.rows, params.k, uniq_labels,
+                n_unique, alloc, stream);
+    brute_force_knn_classify(ptrs, sizes, params.cols, train_samples,
+                             params.rows, params.k, fused_labels,
+                             &fused_probs, y, uniq_labels, n_unique, alloc,
+                             stream);
+    n_proba = params.rows * n_classes;
+
     CUDA_CHECK(cudaStreamSynchronize(stream));
     CUDA_CHECK(cudaStreamDestroy(stream));
   }
@@ -92,6 +104,9 @@ class KNNClassifyTest : public ::testing::TestWithParam<KNNClassifyInputs> {
     CUDA_CHECK(cudaFree(train_labels));
 
     CUDA_CHECK(cudaFree(pred_labels));
+    CUDA_CHECK(cudaFree(fused_labels));
+    CUDA_CHECK(cudaFree(pred_proba));
+    CUDA_CHECK(cudaFree(fused_proba));
 
     CUDA_CHECK(cudaFree(knn_indices));
     CUDA_CHECK(cudaFree(knn_dists));
@@ -106,6 +121,11 @@ class KNNClassifyTest : public ::testing::TestWithParam<KNNClassifyInputs> {
   int *train_labels;
 
   int *pred_labels;
+  // Outputs of brute_force_knn_classify, which must match those of
+  // knn_classify and class_probs
+  int *fused_labels;
+  float *pred_proba, *fused_proba;
+  int n_proba;
 
   int64_t *knn_indices;
   float *knn_dists;
@@ -117,6 +137,10 @@ typedef KNNClassifyTest KNNClassifyTestF;
 TEST_P(KNNClassifyTestF, Fit) {
   ASSERT_TRUE(
     devArrMatch(train_labels, pred_labels, params.rows, Compare<int>()));
+  ASSERT_TRUE(
+    devArrMatch(pred_labels, fused_labels, params.rows, Compare<int>()));
+  ASSERT_TRUE(devArrMatch(pred_proba, fused_proba, n_proba,
+                          CompareApprox<float>(1e-5)));
 }
 
 const std::vector<KNNClassifyInputs> inputsf = {
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuda_utils.h>
+#include <gtest/gtest.h>
+#include <test_utils.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+#include "selection/knn_graph.h"
+
+namespace MLCommon {
+namespace Selection {
+
+struct KnnGraphInputs {
+  int n;
+  int d;
+  int k;
+  bool include_self;
+  int tile_rows;
+};
+
+::std::ostream &operator<<(::std::ostream &os, const KnnGraphInputs &dims) {
+  return os;
+}
+
+/**
+ * Checks knn_graph_self_join against a host brute force. The neighbors are
+ * checked through their distances, which are robust to near ties.
+ */
+class KnnGraphTest : public ::testing::TestWithParam<KnnGraphInputs> {
+ protected:
+  float host_dist(int i, int j) {
+    float acc = 0;
+    for (int c = 0; c < params.d; c++) {
+      float diff = h_X[i * params.d + c] - h_X[j * params.d + c];
+      acc += diff * diff;
+    }
+    return std::sqrt(acc);
+  }
+
+  void SetUp() override {
+    params = ::testing::TestWithParam<KnnGraphInputs>::GetParam();
+    int n = params.n, d = params.d, k = params.k;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    h_X.resize(n * d);
+    for (float &x : h_X) x = dist(gen);
+
+    h_ref_D.resize(n * k);
+    for (int i = 0; i < n; i++) {
+      std::vector<float> row;
+      for (int j = 0; j < n; j++)
+        if (params.include_self || j != i) row.push_back(host_dist(i, j));
+      std::sort(row.begin(), row.end());
+      std::copy(row.begin(), row.begin() + k, h_ref_D.begin() + i * k);
+    }
+
+    auto alloc = std::make_shared<defaultDeviceAllocator>();
+    allocate(d_X, n * d);
+    allocate(d_D, n * k);
+    allocate(d_I, n * k);
+    updateDevice(d_X, h_X.data(), n * d, stream);
+    knn_graph_self_join(d_X, n, d, k, params.include_self, d_I, d_D, alloc,
+                        stream, params.tile_rows);
+    coo.reset(new Sparse::COO<float>(alloc, stream));
+    knn_graph_self_join(d_X, n, d, k, params.include_self, coo.get(), alloc,
+                        stream);
+
+    h_I.resize(n * k);
+    h_rows.resize(n * k);
+    h_cols.resize(n * k);
+    updateHost(h_I.data(), d_I, n * k, stream);
+    updateHost(h_rows.data(), coo->rows(), n * k, stream);
+    updateHost(h_cols.data(), coo->cols(), n * k, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    coo.reset();
+    CUDA_CHECK(cudaFree(d_X));
+    CUDA_CHECK(cudaFree(d_D));
+    CUDA_CHECK(cudaFree(d_I));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  KnnGraphInputs params;
+  cudaStream_t stream;
+  float *d_X, *d_D;
+  int64_t *d_I;
+  std::unique_ptr<Sparse::COO<float>> coo;
+  std::vector<float> h_X, h_ref_D;
+  std::vector<int64_t> h_I;
+  std::vector<int> h_rows, h_cols;
+};
+
+const std::vector<KnnGraphInputs> inputs = {
+  {300, 5, 10, true, 64},   {300, 5, 10, false, 64},
+  {1000, 37, 40, false, 0}, {1000, 37, 40, true, 256},
+  {130, 3, 129, false, 50}, {64, 8, 1, false, 64}};
+
+TEST_P(KnnGraphTest, Neighbors) {
+  int n = params.n, k = params.k;
+  ASSERT_TRUE(devArrMatchHost(h_ref_D.data(), d_D, n * k,
+                              CompareApprox<float>(1e-3), stream));
+  for (int i = 0; i < n; i++) {
+    std::vector<int64_t> ids(h_I.begin() + i * k, h_I.begin() + (i + 1) * k);
+    std::sort(ids.begin(), ids.end());
+    ASSERT_TRUE(std::unique(ids.begin(), ids.end()) == ids.end());
+    for (int j = 0; j < k; j++) {
+      int64_t id = h_I[i * k + j];
+      ASSERT_TRUE(id >= 0 && id < n);
+      ASSERT_TRUE(params.include_self || id != i);
+      ASSERT_NEAR(host_dist(i, id), h_ref_D[i * k + j], 1e-3);
+    }
+  }
+}
+
+TEST_P(KnnGraphTest, Coo) {
+  int n = params.n, k = params.k;
+  ASSERT_EQ(coo->nnz, n * k);
+  ASSERT_EQ(coo->n_rows, n);
+  for (int i = 0; i < n * k; i++) {
+    ASSERT_EQ(h_rows[i], i / k);
+    ASSERT_NEAR(host_dist(h_rows[i], h_cols[i]), h_ref_D[i], 1e-3);
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(KnnGraphTests, KnnGraphTest,
+                        ::testing::ValuesIn(inputs));
+
+};  // end namespace Selection
+};  // end namespace MLCommon
@@ -89,6 +89,7 @@ class KNNRegressionTest : public ::testing::TestWithParam<KNNRegressionInputs> {
     allocate(train_labels, params.rows);
 
     allocate(pred_labels, params.rows);
+    allocate(fused_labels, params.rows);
 
     allocate(knn_indices, params.rows * params.k);
     allocate(knn_dists, params.rows * params.k);
@@ -108,6 +109,9 @@ class KNNRegressionTest : public ::testing::TestWithParam<KNNRegressionInputs> {
     y.push_back(train_labels);
 
     knn_regress(pred_labels, knn_indices, y, params.rows, params.k, stream);
+    brute_force_knn_regress(ptrs, sizes, params.cols, train_samples,
+                            params.rows, params.k, fused_labels, y, alloc,
+                            stream);
 
     CUDA_CHECK(cudaStreamSynchronize(stream));
     CUDA_CHECK(cudaStreamDestroy(stream));
@@ -120,6 +124,7 @@ class KNNRegressionTest : public ::testing::TestWithParam<KNNRegressionInputs> {
     CUDA_CHECK(cudaFree(train_labels));
 
     CUDA_CHECK(cudaFree(pred_labels));
+    CUDA_CHECK(cudaFree(fused_labels));
 
     CUDA_CHECK(cudaFree(knn_indices));
     CUDA_CHECK(cudaFree(knn_dists));
@@ -132,6 +137,8 @@ class KNNRegressionTest : public ::testing::TestWithParam<KNNRegressionInputs> {
   float *train_labels;
 
   float *pred_labels;
+  // Output of brute_force_knn_regress, which must match that of knn_regress
+  float *fused_labels;
 
   int64_t *knn_indices;
   float *knn_dists;
@@ -141,6 +148,8 @@ typedef KNNRegressionTest KNNRegressionTestF;
 TEST_P(KNNRegressionTestF, Fit) {
   ASSERT_TRUE(devArrMatch(train_labels, pred_labels, params.rows,
                           CompareApprox<float>(0.3)));
+  ASSERT_TRUE(devArrMatch(pred_labels, fused_labels, params.rows,
+                          CompareApprox<float>(1e-5)));
 }
 
 const std::vector<KNNRegressionInputs> inputsf = {
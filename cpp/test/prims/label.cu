@@ -106,5 +106,94 @@ TEST(LabelTest, ClassLabels) {
   CUDA_CHECK(cudaFree(y_unique_d));
   CUDA_CHECK(cudaFree(y_relabeled_d));
 }
+void makeMonotonicHashed(int64_t *out, const int64_t *in, int m,
+                         bool filter_negative, int *n_unique,
+                         size_t max_unique, cudaStream_t stream,
+                         std::shared_ptr<deviceAllocator> allocator) {
+  make_monotonic_hashed(
+    out, in, m, stream, allocator,
+    [filter_negative] __device__(int64_t val) {
+      return filter_negative && val < 0;
+    },
+    n_unique, max_unique);
+}
+
+TEST(LabelTest, MakeMonotonicHashed) {
+  cudaStream_t stream;
+  CUDA_CHECK(cudaStreamCreate(&stream));
+  std::shared_ptr<deviceAllocator> allocator(new defaultDeviceAllocator);
+
+  int m = 9;
+  int64_t data_h[] = {8, -1, 3, 8, 100, -1, 3, 0, 8};
+  int64_t *data, *actual;
+  int *n_unique;
+  allocate(data, m);
+  allocate(actual, m);
+  allocate(n_unique, 1);
+  updateDevice(data, data_h, m, stream);
+
+  // numbered in the order of first occurrence, -1 being the empty key pattern
+  makeMonotonicHashed(actual, data, m, false, n_unique, 0, stream, allocator);
+  int64_t expected_h[] = {1, 2, 3, 1, 4, 2, 3, 5, 1};
+  EXPECT_TRUE(devArrMatchHost(expected_h, actual, m, Compare<int64_t>(),
+                              stream));
+  int n_unique_exp = 5;
+  EXPECT_TRUE(
+    devArrMatchHost(&n_unique_exp, n_unique, 1, Compare<int>(), stream));
+
+  // the filtered elements are not written
+  updateDevice(actual, data_h, m, stream);
+  makeMonotonicHashed(actual, data, m, true, n_unique, 0, stream, allocator);
+  int64_t expected_filtered_h[] = {1, -1, 2, 1, 3, -1, 2, 4, 1};
+  EXPECT_TRUE(devArrMatchHost(expected_filtered_h, actual, m,
+                              Compare<int64_t>(), stream));
+  n_unique_exp = 4;
+  EXPECT_TRUE(
+    devArrMatchHost(&n_unique_exp, n_unique, 1, Compare<int>(), stream));
+
+  // too few slots for the labels
+  makeMonotonicHashed(actual, data, m, false, n_unique, 1, stream, allocator);
+  n_unique_exp = -1;
+  EXPECT_TRUE(
+    devArrMatchHost(&n_unique_exp, n_unique, 1, Compare<int>(), stream));
+
+  CUDA_CHECK(cudaStreamDestroy(stream));
+  CUDA_CHECK(cudaFree(data));
+  CUDA_CHECK(cudaFree(actual));
+  CUDA_CHECK(cudaFree(n_unique));
+}
+
+TEST(LabelTest, ClassLabelsHashed) {
+  cudaStream_t stream;
+  CUDA_CHECK(cudaStreamCreate(&stream));
+  std::shared_ptr<deviceAllocator> allocator(new defaultDeviceAllocator);
+
+  int n_rows = 7;
+  float *y_d, *y_unique_d;
+  int *n_classes_d;
+  allocate(y_d, n_rows);
+  allocate(y_unique_d, n_rows);
+  allocate(n_classes_d, 1);
+
+  float y_h[] = {2, -1, 1, 2, 1, -0.0f, 0};
+  updateDevice(y_d, y_h, n_rows, stream);
+
+  getUniqueLabelsHashed(y_d, n_rows, y_unique_d, n_classes_d, stream,
+                        allocator);
+
+  int n_classes;
+  updateHost(&n_classes, n_classes_d, 1, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  ASSERT_EQ(n_classes, 4);
+
+  float y_unique_exp[] = {2, -1, 1, 0};
+  EXPECT_TRUE(devArrMatchHost(y_unique_exp, y_unique_d, n_classes,
+                              Compare<float>(), stream));
+
+  CUDA_CHECK(cudaStreamDestroy(stream));
+  CUDA_CHECK(cudaFree(y_d));
+  CUDA_CHECK(cudaFree(y_unique_d));
+  CUDA_CHECK(cudaFree(n_classes_d));
+}
 };  // namespace Label
 };  // namespace MLCommon
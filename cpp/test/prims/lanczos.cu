@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "cuda_utils.h"
+#include "random/rng.h"
+#include "sparse/cusparse_wrappers.h"
+#include "sparse/lanczos.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Sparse {
+
+template <typename T>
+struct LanczosInputs {
+  int n;
+  int n_eig;
+  int ncv;
+  int max_restarts;
+  T tol;
+  T eig_tolerance;
+  unsigned long long int seed;
+};
+
+template <typename T>
+::std::ostream &operator<<(::std::ostream &os, const LanczosInputs<T> &dims) {
+  return os;
+}
+
+/**
+ * The operator is the 1D Laplacian tridiag(-1, 2, -1) of size n, as a CSR
+ * matrix, whose eigenvalues are 2 - 2 cos(i pi / (n + 1)), i = 1..n
+ */
+template <typename T>
+class LanczosTest : public ::testing::TestWithParam<LanczosInputs<T>> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<LanczosInputs<T>>::GetParam();
+    int n = params.n, n_eig = params.n_eig;
+
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    CUBLAS_CHECK(cublasCreate(&cublas_h));
+    CUSOLVER_CHECK(cusolverDnCreate(&cusolver_h));
+    CUSPARSE_CHECK(cusparseCreate(&cusparse_h));
+    CUSPARSE_CHECK(cusparseCreateMatDescr(&descr));
+    std::shared_ptr<deviceAllocator> allocator(new defaultDeviceAllocator);
+
+    std::vector<int> row_ptr_h(n + 1), cols_h;
+    std::vector<T> vals_h;
+    for (int i = 0; i < n; i++) {
+      row_ptr_h[i] = cols_h.size();
+      for (int j = std::max(i - 1, 0); j <= std::min(i + 1, n - 1); j++) {
+        cols_h.push_back(j);
+        vals_h.push_back(i == j ? T(2) : T(-1));
+      }
+    }
+    int nnz = cols_h.size();
+    row_ptr_h[n] = nnz;
+
+    allocate(row_ptr, n + 1);
+    allocate(cols, nnz);
+    allocate(vals, nnz);
+    allocate(v0, n);
+    allocate(eig_vals, n_eig);
+    allocate(eig_vectors, n * n_eig);
+    updateDevice(row_ptr, row_ptr_h.data(), n + 1, stream);
+    updateDevice(cols, cols_h.data(), nnz, stream);
+    updateDevice(vals, vals_h.data(), nnz, stream);
+
+    Random::Rng r(params.seed);
+    r.normal(v0, n, T(0), T(1), stream);
+
+    const T one = 1, zero = 0;
+    auto op = [&](const T *x, T *y) {
+      CUSPARSE_CHECK(cusparse_csrmv(
+        cusparse_h, CUSPARSE_OPERATION_NON_TRANSPOSE, n, n, nnz, &one, descr,
+        vals, row_ptr, cols, x, &zero, y, stream));
+    };
+    converged =
+      lanczos_largest<T>(op, n, n_eig, v0, eig_vals, eig_vectors, cublas_h,
+                         cusolver_h, allocator, stream, params.ncv,
+                         params.max_restarts, params.tol);
+
+    eig_vals_h.resize(n_eig);
+    eig_vectors_h.resize(n * n_eig);
+    updateHost(eig_vals_h.data(), eig_vals, n_eig, stream);
+    updateHost(eig_vectors_h.data(), eig_vectors, n * n_eig, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(row_ptr));
+    CUDA_CHECK(cudaFree(cols));
+    CUDA_CHECK(cudaFree(vals));
+    CUDA_CHECK(cudaFree(v0));
+    CUDA_CHECK(cudaFree(eig_vals));
+    CUDA_CHECK(cudaFree(eig_vectors));
+    CUSPARSE_CHECK(cusparseDestroyMatDescr(descr));
+    CUSPARSE_CHECK(cusparseDestroy(cusparse_h));
+    CUSOLVER_CHECK(cusolverDnDestroy(cusolver_h));
+    CUBLAS_CHECK(cublasDestroy(cublas_h));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  /** max over the eigenpairs of |A v - lambda v| */
+  T max_residual() {
+    int n = params.n;
+    T res = 0;
+    for (int e = 0; e < params.n_eig; e++) {
+      const T *v = eig_vectors_h.data() + e * n;
+      for (int i = 0; i < n; i++) {
+        T av = 2 * v[i];
+        if (i > 0) av -= v[i - 1];
+        if (i < n - 1) av -= v[i + 1];
+        res = std::max(res, std::abs(av - eig_vals_h[e] * v[i]));
+      }
+    }
+    return res;
+  }
+
+ protected:
+  LanczosInputs<T> params;
+  cudaStream_t stream;
+  cublasHandle_t cublas_h;
+  cusolverDnHandle_t cusolver_h;
+  cusparseHandle_t cusparse_h;
+  cusparseMatDescr_t descr;
+  int *row_ptr, *cols;
+  T *vals, *v0, *eig_vals, *eig_vectors;
+  std::vector<T> eig_vals_h, eig_vectors_h;
+  bool converged;
+};
+
+// ncv = n runs a single, exact, Krylov space
+const std::vector<LanczosInputs<float>> inputsf = {
+  {64, 3, 0, 200, 1e-4f, 1e-3f, 1234ULL},
+  {100, 4, 30, 200, 1e-4f, 1e-3f, 1234ULL},
+  {16, 4, 16, 200, 1e-4f, 1e-4f, 1234ULL}};
+
+const std::vector<LanczosInputs<double>> inputsd = {
+  {64, 3, 0, 200, 1e-8, 1e-6, 1234ULL},
+  {100, 4, 30, 200, 1e-8, 1e-6, 1234ULL},
+  {16, 4, 16, 200, 1e-8, 1e-8, 1234ULL}};
+
+typedef LanczosTest<float> LanczosTestF;
+TEST_P(LanczosTestF, Result) {
+  ASSERT_TRUE(converged);
+  int n = params.n;
+  for (int e = 0; e < params.n_eig; e++) {
+    float ref = 2 - 2 * std::cos((n - e) * M_PI / (n + 1));
+    ASSERT_NEAR(eig_vals_h[e], ref, params.eig_tolerance);
+  }
+  // the residuals are relative to the largest eigenvalue, below 4
+  ASSERT_LT(max_residual(), 8 * params.tol);
+}
+
+typedef LanczosTest<double> LanczosTestD;
+TEST_P(LanczosTestD, Result) {
+  ASSERT_TRUE(converged);
+  int n = params.n;
+  for (int e = 0; e < params.n_eig; e++) {
+    double ref = 2 - 2 * std::cos((n - e) * M_PI / (n + 1));
+    ASSERT_NEAR(eig_vals_h[e], ref, params.eig_tolerance);
+  }
+  // the residuals are relative to the largest eigenvalue, below 4
+  ASSERT_LT(max_residual(), 8 * params.tol);
+}
+
+INSTANTIATE_TEST_CASE_P(LanczosTests, LanczosTestF,
+                        ::testing::ValuesIn(inputsf));
+
+INSTANTIATE_TEST_CASE_P(LanczosTests, LanczosTestD,
+                        ::testing::ValuesIn(inputsd));
+
+}  // namespace Sparse
+}  // namespace MLCommon
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cuml/common/cuml_allocator.hpp>
+#include <random>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "metrics/logLoss.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Metrics {
+
+struct LogLossParam {
+  int nSamples;
+  int nClasses;
+  double tolerance;
+  unsigned long long int seed;
+};
+
+std::ostream &operator<<(std::ostream &os, const LogLossParam &p) {
+  return os << "{" << p.nSamples << ", " << p.nClasses << "}";
+}
+
+/**
+ * Random normalized probabilities, some of them zero to exercise the
+ * clipping, against the mean negative log-likelihood on the host
+ */
+template <typename DataT>
+class LogLossTest : public ::testing::TestWithParam<LogLossParam> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<LogLossParam>::GetParam();
+    int n = params.nSamples, k = params.nClasses;
+    const double eps = 1e-7;
+
+    std::default_random_engine gen(params.seed);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+    std::uniform_int_distribution<int> labels(0, k - 1);
+    std::vector<int> truth(n);
+    std::vector<DataT> probs(n * k);
+    expected = 0.0;
+    for (int i = 0; i < n; i++) {
+      truth[i] = labels(gen);
+      double sum = 0.0;
+      for (int c = 0; c < k; c++) {
+        double p = unif(gen);
+        probs[i * k + c] = p < 0.1 ? DataT(0) : DataT(p);
+        sum += probs[i * k + c];
+      }
+      for (int c = 0; c < k; c++) {
+        if (sum > 0) probs[i * k + c] = DataT(probs[i * k + c] / sum);
+      }
+      double p = probs[i * k + truth[i]];
+      expected -= std::log(std::min(std::max(p, eps), 1.0 - eps));
+    }
+    expected /= n;
+
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+    device_buffer<int> d_truth(alloc, stream, n);
+    device_buffer<DataT> d_probs(alloc, stream, n * k);
+    updateDevice(d_truth.data(), truth.data(), n, stream);
+    updateDevice(d_probs.data(), probs.data(), n * k, stream);
+    result = logLoss(d_truth.data(), d_probs.data(), n, k, alloc, stream, eps);
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  LogLossParam params;
+  double expected, result;
+};
+
+const std::vector<LogLossParam> inputs = {{1, 2, 1e-6, 1234ULL},
+                                          {1000, 2, 1e-6, 1234ULL},
+                                          {5000, 10, 1e-6, 42ULL},
+                                          {100000, 3, 1e-6, 42ULL}};
+
+typedef LogLossTest<float> LogLossTestF;
+TEST_P(LogLossTestF, Result) {
+  ASSERT_NEAR(expected, result, params.tolerance);
+}
+INSTANTIATE_TEST_CASE_P(LogLoss, LogLossTestF, ::testing::ValuesIn(inputs));
+
+typedef LogLossTest<double> LogLossTestD;
+TEST_P(LogLossTestD, Result) {
+  ASSERT_NEAR(expected, result, params.tolerance);
+}
+INSTANTIATE_TEST_CASE_P(LogLoss, LogLossTestD, ::testing::ValuesIn(inputs));
+
+}  //end namespace Metrics
+}  //end namespace MLCommon
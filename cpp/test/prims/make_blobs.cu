@@ -16,6 +16,8 @@
 
 #include <gtest/gtest.h>
 #include <cub/cub.cuh>
+#include <vector>
+#include "common/device_buffer.hpp"
 #include "cuda_utils.h"
 #include "random/make_blobs.h"
 #include "test_utils.h"
@@ -154,5 +156,63 @@ TEST_P(MakeBlobsTestD, Result) {
 INSTANTIATE_TEST_CASE_P(MakeBlobsTests, MakeBlobsTestD,
                         ::testing::ValuesIn(inputsd_t));
 
+/**
+ * The sharded make_blobs generates the same dataset whichever way it is cut
+ * in shards or chunks, and starting at any row
+ */
+TEST(MakeBlobsShardTest, SameAcrossShards) {
+  const int64_t n_rows = 5000, n_cols = 37, n_clusters = 7, split = 1234;
+  const int64_t offset = int64_t(1) << 33;
+  const uint64_t seed = 1234ULL;
+  std::shared_ptr<deviceAllocator> allocator(new defaultDeviceAllocator);
+  cudaStream_t stream;
+  CUDA_CHECK(cudaStreamCreate(&stream));
+  device_buffer<float> whole(allocator, stream, n_rows * n_cols);
+  device_buffer<float> shards(allocator, stream, n_rows * n_cols);
+  device_buffer<float> chunks(allocator, stream, n_rows * n_cols);
+  device_buffer<int64_t> whole_l(allocator, stream, n_rows);
+  device_buffer<int64_t> shards_l(allocator, stream, n_rows);
+  device_buffer<int64_t> chunks_l(allocator, stream, n_rows);
+  make_blobs_shard(whole.data(), whole_l.data(), offset, n_rows, n_cols,
+                   n_clusters, allocator, stream, (const float*)nullptr,
+                   (const float*)nullptr, 2.f, -10.f, 10.f, seed);
+  make_blobs_shard(shards.data(), shards_l.data(), offset, split, n_cols,
+                   n_clusters, allocator, stream, (const float*)nullptr,
+                   (const float*)nullptr, 2.f, -10.f, 10.f, seed);
+  make_blobs_shard(shards.data() + split * n_cols, shards_l.data() + split,
+                   offset + split, n_rows - split, n_cols, n_clusters,
+                   allocator, stream, (const float*)nullptr,
+                   (const float*)nullptr, 2.f, -10.f, 10.f, seed);
+  float* chunks_p = chunks.data();
+  int64_t* chunks_lp = chunks_l.data();
+  make_blobs_chunked<float, int64_t>(
+    offset, n_rows, n_cols, n_clusters, 999,
+    [&](const float* out, const int64_t* labels, int64_t first,
+        int64_t rows) {
+      copy(chunks_p + (first - offset) * n_cols, out, rows * n_cols, stream);
+      copy(chunks_lp + (first - offset), labels, rows, stream);
+    },
+    allocator, stream, nullptr, nullptr, 2.f, -10.f, 10.f, seed);
+  ASSERT_TRUE(devArrMatch(whole.data(), shards.data(), n_rows * n_cols,
+                          Compare<float>(), stream));
+  ASSERT_TRUE(devArrMatch(whole.data(), chunks.data(), n_rows * n_cols,
+                          Compare<float>(), stream));
+  ASSERT_TRUE(devArrMatch(whole_l.data(), shards_l.data(), n_rows,
+                          Compare<int64_t>(), stream));
+  ASSERT_TRUE(devArrMatch(whole_l.data(), chunks_l.data(), n_rows,
+                          Compare<int64_t>(), stream));
+  // all the clusters are drawn, and only them
+  std::vector<int64_t> h_labels(n_rows);
+  updateHost(h_labels.data(), whole_l.data(), n_rows, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  std::vector<int64_t> counts(n_clusters, 0);
+  for (auto l : h_labels) {
+    ASSERT_TRUE(l >= 0 && l < n_clusters);
+    ++counts[l];
+  }
+  for (auto c : counts) ASSERT_GT(c, n_rows / n_clusters / 2);
+  CUDA_CHECK(cudaStreamDestroy(stream));
+}
+
 }  // end namespace Random
 }  // end namespace MLCommon
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "random/make_classification.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Random {
+
+struct MakeClassificationInputs {
+  int n_rows, n_cols, n_classes, n_clusters_per_class;
+  int n_informative, n_redundant, n_repeated;
+  uint64_t seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os,
+                           const MakeClassificationInputs& dims) {
+  return os;
+}
+
+/**
+ * Without flipped labels nor shuffle, the classes are balanced, the repeated
+ * features are copies of the informative or redundant ones, and the class
+ * means of the informative features are far apart with a large class_sep
+ */
+class MakeClassificationTest
+  : public ::testing::TestWithParam<MakeClassificationInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<MakeClassificationInputs>::GetParam();
+    std::shared_ptr<deviceAllocator> allocator(new defaultDeviceAllocator);
+    cudaStream_t stream;
+    cublasHandle_t cublas_handle;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    CUBLAS_CHECK(cublasCreate(&cublas_handle));
+    CUBLAS_CHECK(cublasSetStream(cublas_handle, stream));
+    int len = params.n_rows * params.n_cols;
+    device_buffer<float> out(allocator, stream, len);
+    device_buffer<int> labels(allocator, stream, params.n_rows);
+    make_classification(out.data(), labels.data(), params.n_rows,
+                        params.n_cols, cublas_handle, allocator, stream,
+                        params.n_classes, params.n_clusters_per_class,
+                        params.n_informative, params.n_redundant,
+                        params.n_repeated, 0.f, 20.f, true, 0.f, 1.f, false,
+                        params.seed);
+    h_out.resize(len);
+    h_labels.resize(params.n_rows);
+    updateHost(h_out.data(), out.data(), len, stream);
+    updateHost(h_labels.data(), labels.data(), params.n_rows, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUBLAS_CHECK(cublasDestroy(cublas_handle));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  float at(int row, int col) const { return h_out[row * params.n_cols + col]; }
+
+ protected:
+  MakeClassificationInputs params;
+  std::vector<float> h_out;
+  std::vector<int> h_labels;
+};
+
+TEST_P(MakeClassificationTest, Result) {
+  std::vector<int> counts(params.n_classes, 0);
+  for (auto l : h_labels) {
+    ASSERT_TRUE(l >= 0 && l < params.n_classes);
+    ++counts[l];
+  }
+  int n_clusters = params.n_classes * params.n_clusters_per_class;
+  int per_class = params.n_rows / n_clusters * params.n_clusters_per_class;
+  for (auto c : counts) {
+    ASSERT_GE(c, per_class);
+    ASSERT_LE(c, per_class + params.n_clusters_per_class);
+  }
+
+  int n_useful = params.n_informative + params.n_redundant;
+  for (int j = n_useful; j < n_useful + params.n_repeated; ++j) {
+    bool found = false;
+    for (int src = 0; src < n_useful && !found; ++src) {
+      bool same = true;
+      for (int i = 0; i < params.n_rows && same; ++i) {
+        same = at(i, j) == at(i, src);
+      }
+      found = same;
+    }
+    ASSERT_TRUE(found) << "the repeated feature " << j << " is no copy";
+  }
+
+  if (params.n_clusters_per_class == 1) {
+    // the vertices of the classes are at least 2 * class_sep apart along
+    // one of the informative features, much more than the within-cluster
+    // deviations
+    std::vector<double> means(params.n_classes * params.n_informative, 0.0);
+    for (int i = 0; i < params.n_rows; ++i) {
+      for (int j = 0; j < params.n_informative; ++j) {
+        means[h_labels[i] * params.n_informative + j] += at(i, j);
+      }
+    }
+    for (int c = 0; c < params.n_classes; ++c) {
+      for (int j = 0; j < params.n_informative; ++j) {
+        means[c * params.n_informative + j] /= counts[c];
+      }
+    }
+    for (int a = 0; a < params.n_classes; ++a) {
+      for (int b = a + 1; b < params.n_classes; ++b) {
+        double dmax = 0.0;
+        for (int j = 0; j < params.n_informative; ++j) {
+          dmax = std::max(dmax, std::abs(means[a * params.n_informative + j] -
+                                         means[b * params.n_informative + j]));
+        }
+        ASSERT_GT(dmax, 20.0);
+      }
+    }
+  }
+}
+
+const std::vector<MakeClassificationInputs> inputs = {
+  {1000, 20, 2, 2, 5, 3, 2, 1234ULL},
+  {1001, 10, 4, 1, 3, 2, 1, 1234ULL},
+  {5000, 50, 5, 1, 10, 10, 10, 4321ULL}};
+
+INSTANTIATE_TEST_CASE_P(MakeClassificationTests, MakeClassificationTest,
+                        ::testing::ValuesIn(inputs));
+
+}  // end namespace Random
+}  // end namespace MLCommon
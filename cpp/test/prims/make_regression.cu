@@ -17,7 +17,10 @@
 #include <gtest/gtest.h>
 #include <thrust/count.h>
 #include <thrust/device_vector.h>
+#include <cmath>
+#include <vector>
 
+#include "common/device_buffer.hpp"
 #include "cuda_utils.h"
 #include "linalg/cublas_wrappers.h"
 #include "linalg/subtract.h"
@@ -141,5 +144,83 @@ TEST_P(MakeRegressionTestD, Result) {
 INSTANTIATE_TEST_CASE_P(MakeRegressionTests, MakeRegressionTestD,
                         ::testing::ValuesIn(inputsd_t));
 
+/**
+ * The sharded make_regression generates the same problem whichever way it is
+ * cut in shards or chunks, and starting at any row, with the values of its
+ * coefficients
+ */
+TEST(MakeRegressionShardTest, SameAcrossShards) {
+  const int64_t n_rows = 3000, n_cols = 40, n_informative = 25;
+  const int64_t n_targets = 3, split = 1111, offset = int64_t(1) << 33;
+  const uint64_t seed = 1234ULL;
+  const double bias = 4.2;
+  std::shared_ptr<deviceAllocator> allocator(new defaultDeviceAllocator);
+  cudaStream_t stream;
+  cublasHandle_t cublas_handle;
+  CUDA_CHECK(cudaStreamCreate(&stream));
+  CUBLAS_CHECK(cublasCreate(&cublas_handle));
+  CUBLAS_CHECK(cublasSetStream(cublas_handle, stream));
+  device_buffer<double> whole(allocator, stream, n_rows * n_cols);
+  device_buffer<double> shards(allocator, stream, n_rows * n_cols);
+  device_buffer<double> chunks(allocator, stream, n_rows * n_cols);
+  device_buffer<double> whole_v(allocator, stream, n_rows * n_targets);
+  device_buffer<double> shards_v(allocator, stream, n_rows * n_targets);
+  device_buffer<double> chunks_v(allocator, stream, n_rows * n_targets);
+  device_buffer<double> coef(allocator, stream, n_cols * n_targets);
+  make_regression_shard(whole.data(), whole_v.data(), offset, n_rows, n_cols,
+                        n_informative, cublas_handle, allocator, stream,
+                        coef.data(), n_targets, bias, 0.0, seed);
+  make_regression_shard(shards.data(), shards_v.data(), offset, split, n_cols,
+                        n_informative, cublas_handle, allocator, stream,
+                        (double*)nullptr, n_targets, bias, 0.0, seed);
+  make_regression_shard(shards.data() + split * n_cols,
+                        shards_v.data() + split * n_targets, offset + split,
+                        n_rows - split, n_cols, n_informative, cublas_handle,
+                        allocator, stream, (double*)nullptr, n_targets, bias,
+                        0.0, seed);
+  double* chunks_p = chunks.data();
+  double* chunks_vp = chunks_v.data();
+  make_regression_chunked<double, int64_t>(
+    offset, n_rows, n_cols, n_informative, 700,
+    [&](const double* out, const double* values, int64_t first,
+        int64_t rows) {
+      copy(chunks_p + (first - offset) * n_cols, out, rows * n_cols, stream);
+      copy(chunks_vp + (first - offset) * n_targets, values, rows * n_targets,
+           stream);
+    },
+    cublas_handle, allocator, stream, nullptr, n_targets, bias, 0.0, seed);
+  ASSERT_TRUE(devArrMatch(whole.data(), shards.data(), n_rows * n_cols,
+                          Compare<double>(), stream));
+  ASSERT_TRUE(devArrMatch(whole.data(), chunks.data(), n_rows * n_cols,
+                          Compare<double>(), stream));
+  ASSERT_TRUE(devArrMatch(whole_v.data(), shards_v.data(), n_rows * n_targets,
+                          CompareApprox<double>(1e-8), stream));
+  ASSERT_TRUE(devArrMatch(whole_v.data(), chunks_v.data(), n_rows * n_targets,
+                          CompareApprox<double>(1e-8), stream));
+
+  // the values are those of the coefficients, only the informative ones
+  // being non-zero
+  std::vector<double> h_x(n_rows * n_cols), h_v(n_rows * n_targets);
+  std::vector<double> h_coef(n_cols * n_targets);
+  updateHost(h_x.data(), whole.data(), h_x.size(), stream);
+  updateHost(h_v.data(), whole_v.data(), h_v.size(), stream);
+  updateHost(h_coef.data(), coef.data(), h_coef.size(), stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  for (int64_t j = 0; j < n_cols * n_targets; ++j) {
+    ASSERT_EQ(j < n_informative * n_targets, h_coef[j] != 0.0);
+  }
+  for (int64_t i = 0; i < n_rows; ++i) {
+    for (int64_t t = 0; t < n_targets; ++t) {
+      double v = bias;
+      for (int64_t j = 0; j < n_cols; ++j) {
+        v += h_x[i * n_cols + j] * h_coef[j * n_targets + t];
+      }
+      ASSERT_NEAR(v, h_v[i * n_targets + t], 1e-8 * std::abs(v) + 1e-8);
+    }
+  }
+  CUBLAS_CHECK(cublasDestroy(cublas_handle));
+  CUDA_CHECK(cudaStreamDestroy(stream));
+}
+
 }  // end namespace Random
 }  // end namespace MLCommon
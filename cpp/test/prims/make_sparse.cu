@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "random/make_sparse.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Random {
+
+struct MakeSparseInputs {
+  int n_rows, n_cols;
+  double density;
+  uint64_t seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const MakeSparseInputs& dims) {
+  return os;
+}
+
+/**
+ * The matrix is a valid CSR one, its column indices sorted in each row, of
+ * the expected nnz and with values in range
+ */
+class MakeSparseTest : public ::testing::TestWithParam<MakeSparseInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<MakeSparseInputs>::GetParam();
+    std::shared_ptr<deviceAllocator> allocator(new defaultDeviceAllocator);
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    device_buffer<int> indptr(allocator, stream, params.n_rows + 1);
+    make_sparse_rows(indptr.data(), params.n_rows, params.n_cols,
+                     params.density, params.seed, stream);
+    h_indptr.resize(params.n_rows + 1);
+    updateHost(h_indptr.data(), indptr.data(), params.n_rows + 1, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    int nnz = h_indptr[params.n_rows];
+    device_buffer<int> indices(allocator, stream, nnz);
+    device_buffer<float> values(allocator, stream, nnz);
+    make_sparse(indices.data(), values.data(), indptr.data(), params.n_rows,
+                params.n_cols, params.density, -2.f, 3.f, params.seed,
+                stream);
+    h_indices.resize(nnz);
+    h_values.resize(nnz);
+    updateHost(h_indices.data(), indices.data(), nnz, stream);
+    updateHost(h_values.data(), values.data(), nnz, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  MakeSparseInputs params;
+  std::vector<int> h_indptr, h_indices;
+  std::vector<float> h_values;
+};
+
+TEST_P(MakeSparseTest, Result) {
+  ASSERT_EQ(0, h_indptr[0]);
+  for (int r = 0; r < params.n_rows; ++r) {
+    ASSERT_LE(h_indptr[r], h_indptr[r + 1]);
+    for (int k = h_indptr[r]; k < h_indptr[r + 1]; ++k) {
+      ASSERT_TRUE(h_indices[k] >= 0 && h_indices[k] < params.n_cols);
+      if (k > h_indptr[r]) ASSERT_LT(h_indices[k - 1], h_indices[k]);
+      ASSERT_TRUE(h_values[k] >= -2.f && h_values[k] < 3.f);
+    }
+  }
+  double n = double(params.n_rows) * params.n_cols;
+  double expected = n * params.density;
+  double sigma = std::sqrt(n * params.density * (1.0 - params.density));
+  ASSERT_NEAR(expected, h_indptr[params.n_rows], 6.0 * sigma + 0.5);
+}
+
+const std::vector<MakeSparseInputs> inputs = {
+  {2000, 500, 0.05, 1234ULL}, {1000, 3000, 0.001, 1234ULL},
+  {100, 100, 0.7, 4321ULL},   {300, 64, 1.0, 1234ULL},
+  {300, 64, 0.0, 1234ULL},    {1, 100000, 0.01, 1234ULL}};
+
+INSTANTIATE_TEST_CASE_P(MakeSparseTests, MakeSparseTest,
+                        ::testing::ValuesIn(inputs));
+
+}  // end namespace Random
+}  // end namespace MLCommon
@@ -148,7 +148,8 @@ const std::vector<mutualInfoParam> inputs = {
   {198, 1, 100, false, 0.000001}, {300, 3, 99, false, 0.000001},
   {199, 1, 10, true, 0.000001},   {200, 15, 100, true, 0.000001},
   {100, 1, 20, true, 0.000001},   {10, 1, 10, true, 0.000001},
-  {198, 1, 100, true, 0.000001},  {300, 3, 99, true, 0.000001}};
+  {198, 1, 100, true, 0.000001},  {300, 3, 99, true, 0.000001},
+  {20000, 1, 6000, false, 0.000001}, {20000, 1, 6000, true, 0.000001}};
 
 //writing the test suite
 typedef mutualInfoTest<int> mutualInfoTestClass;
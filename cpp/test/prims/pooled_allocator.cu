@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cuml/common/pooledAllocator.hpp>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "common/host_buffer.hpp"
+#include "cuda_utils.h"
+
+namespace MLCommon {
+
+TEST(PooledAllocatorTest, reuse) {
+  pooledDeviceAllocator allocator;
+  cudaStream_t stream;
+  CUDA_CHECK(cudaStreamCreate(&stream));
+
+  void* p = allocator.allocate(1000, stream);
+  allocator.deallocate(p, 1000, stream);
+  // same size class
+  void* q = allocator.allocate(1024, stream);
+  ASSERT_EQ(p, q);
+  auto stats = allocator.getStats();
+  ASSERT_EQ(2, stats.nAllocations);
+  ASSERT_EQ(1, stats.nCacheHits);
+  ASSERT_EQ(1, stats.nCudaMallocs);
+  ASSERT_EQ(1024, stats.bytesInUse);
+  ASSERT_EQ(0, stats.bytesCached);
+  // another size class
+  void* r = allocator.allocate(4000, stream);
+  ASSERT_NE(q, r);
+  allocator.deallocate(q, 1024, stream);
+  allocator.deallocate(r, 4000, stream);
+  stats = allocator.getStats();
+  ASSERT_EQ(2, stats.nCudaMallocs);
+  ASSERT_EQ(0, stats.bytesInUse);
+  ASSERT_EQ(1024 + 4096, stats.bytesCached);
+
+  CUDA_CHECK(cudaStreamDestroy(stream));
+}
+
+TEST(PooledAllocatorTest, crossStream) {
+  pooledDeviceAllocator allocator;
+  cudaStream_t s1, s2;
+  CUDA_CHECK(cudaStreamCreate(&s1));
+  CUDA_CHECK(cudaStreamCreate(&s2));
+
+  const int len = 1 << 20;
+  std::vector<int> h(len, 0);
+  int* p = (int*)allocator.allocate(len * sizeof(int), s1);
+  CUDA_CHECK(cudaMemsetAsync(p, 0xff, len * sizeof(int), s1));
+  allocator.deallocate(p, len * sizeof(int), s1);
+  // the block is reused on s2 only once the memset of s1 is done
+  int* q = (int*)allocator.allocate(len * sizeof(int), s2);
+  ASSERT_EQ(p, q);
+  CUDA_CHECK(cudaMemsetAsync(q, 0, len * sizeof(int), s2));
+  updateHost(h.data(), q, len, s2);
+  CUDA_CHECK(cudaStreamSynchronize(s2));
+  for (int i = 0; i < len; i++) ASSERT_EQ(0, h[i]) << " @" << i;
+  allocator.deallocate(q, len * sizeof(int), s2);
+
+  CUDA_CHECK(cudaStreamDestroy(s1));
+  CUDA_CHECK(cudaStreamDestroy(s2));
+}
+
+TEST(PooledAllocatorTest, peaks) {
+  pooledDeviceAllocator allocator;
+  cudaStream_t stream;
+  CUDA_CHECK(cudaStreamCreate(&stream));
+
+  void* p = allocator.allocate(2048, stream);
+  void* q = allocator.allocate(2048, stream);
+  allocator.deallocate(p, 2048, stream);
+  auto stats = allocator.getStats();
+  ASSERT_EQ(2048, stats.bytesInUse);
+  ASSERT_EQ(4096, stats.peakBytesInUse);
+  ASSERT_EQ(4096, stats.peakBytesReserved);
+  allocator.resetPeaks();
+  stats = allocator.getStats();
+  ASSERT_EQ(2048, stats.peakBytesInUse);
+  ASSERT_EQ(4096, stats.peakBytesReserved);
+  allocator.releaseCached();
+  allocator.resetPeaks();
+  stats = allocator.getStats();
+  ASSERT_EQ(0, stats.bytesCached);
+  ASSERT_EQ(2048, stats.peakBytesReserved);
+  allocator.deallocate(q, 2048, stream);
+
+  CUDA_CHECK(cudaStreamDestroy(stream));
+}
+
+TEST(PooledAllocatorTest, limits) {
+  // 4KB of cache, classes from 512B to 8KB
+  pooledDeviceAllocator allocator(4096, 512, 8192);
+  cudaStream_t stream;
+  CUDA_CHECK(cudaStreamCreate(&stream));
+
+  // not pooled
+  void* p = allocator.allocate(10000, stream);
+  allocator.deallocate(p, 10000, stream);
+  auto stats = allocator.getStats();
+  ASSERT_EQ(0, stats.bytesCached);
+  ASSERT_EQ(1, stats.nCudaMallocs);
+  // above the cache limit once freed
+  p = allocator.allocate(8192, stream);
+  allocator.deallocate(p, 8192, stream);
+  stats = allocator.getStats();
+  ASSERT_EQ(0, stats.bytesCached);
+  p = allocator.allocate(8192, stream);
+  stats = allocator.getStats();
+  ASSERT_EQ(0, stats.nCacheHits);
+  ASSERT_EQ(3, stats.nCudaMallocs);
+  allocator.deallocate(p, 8192, stream);
+
+  CUDA_CHECK(cudaStreamDestroy(stream));
+}
+
+TEST(PooledAllocatorTest, deviceBuffer) {
+  std::shared_ptr<pooledDeviceAllocator> allocator(new pooledDeviceAllocator);
+  cudaStream_t stream;
+  CUDA_CHECK(cudaStreamCreate(&stream));
+
+  for (int i = 0; i < 10; i++) {
+    device_buffer<float> buffer(allocator, stream, 1000);
+    ASSERT_NE(nullptr, buffer.data());
+  }
+  auto stats = allocator->getStats();
+  ASSERT_EQ(10, stats.nAllocations);
+  ASSERT_EQ(1, stats.nCudaMallocs);
+  ASSERT_EQ(0, stats.bytesInUse);
+
+  CUDA_CHECK(cudaStreamDestroy(stream));
+}
+
+TEST(PooledHostAllocatorTest, reuse) {
+  pooledHostAllocator allocator;
+  cudaStream_t stream;
+  CUDA_CHECK(cudaStreamCreate(&stream));
+
+  const int len = 1 << 20;
+  device_buffer<int> d(std::make_shared<defaultDeviceAllocator>(), stream,
+                       len);
+  CUDA_CHECK(cudaMemsetAsync(d.data(), 0, len * sizeof(int), stream));
+  int* p = (int*)allocator.allocate(len * sizeof(int), stream);
+  for (int i = 0; i < len; i++) p[i] = 1;
+  updateDevice(d.data(), p, len, stream);
+  allocator.deallocate(p, len * sizeof(int), stream);
+  // handed out only once the copy out of it is done
+  int* q = (int*)allocator.allocate(len * sizeof(int), stream);
+  ASSERT_EQ(p, q);
+  for (int i = 0; i < len; i++) q[i] = 2;
+  updateHost(q, d.data(), len, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  for (int i = 0; i < len; i++) ASSERT_EQ(1, q[i]) << " @" << i;
+  allocator.deallocate(q, len * sizeof(int), stream);
+  auto stats = allocator.getStats();
+  ASSERT_EQ(1, stats.nCacheHits);
+  ASSERT_EQ(1, stats.nCudaMallocs);
+
+  CUDA_CHECK(cudaStreamDestroy(stream));
+}
+
+TEST(PooledHostAllocatorTest, hostBuffer) {
+  std::shared_ptr<pooledHostAllocator> allocator(new pooledHostAllocator);
+  cudaStream_t stream;
+  CUDA_CHECK(cudaStreamCreate(&stream));
+
+  for (int i = 0; i < 10; i++) {
+    host_buffer<float> buffer(allocator, stream, 1000);
+    ASSERT_NE(nullptr, buffer.data());
+    cudaPointerAttributes attr;
+    CUDA_CHECK(cudaPointerGetAttributes(&attr, buffer.data()));
+    ASSERT_EQ(cudaMemoryTypeHost, attr.type);
+  }
+  auto stats = allocator->getStats();
+  ASSERT_EQ(10, stats.nAllocations);
+  ASSERT_EQ(1, stats.nCudaMallocs);
+
+  CUDA_CHECK(cudaStreamDestroy(stream));
+}
+
+}  // end namespace MLCommon
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuda_utils.h>
+#include <gtest/gtest.h>
+#include <test_utils.h>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+#include "selection/radius_neighbors.h"
+
+namespace MLCommon {
+namespace Selection {
+
+struct RadiusNeighborsInputs {
+  int n_index;
+  int n_query;
+  int d;
+  float eps;
+  bool rowMajorIndex;
+  bool rowMajorQuery;
+};
+
+::std::ostream &operator<<(::std::ostream &os,
+                           const RadiusNeighborsInputs &dims) {
+  return os;
+}
+
+/**
+ * Checks radius_neighbors against a host brute force. The features are small
+ * integers, so the squared distances are exact and never equal to eps^2.
+ */
+class RadiusNeighborsTest
+  : public ::testing::TestWithParam<RadiusNeighborsInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<RadiusNeighborsInputs>::GetParam();
+    int n_index = params.n_index, n_query = params.n_query, d = params.d;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(-3, 3);
+    std::vector<float> h_index(n_index * d), h_query(n_query * d);
+    for (float &x : h_index) x = dist(gen);
+    for (float &x : h_query) x = dist(gen);
+
+    h_row_ind.push_back(0);
+    for (int q = 0; q < n_query; q++) {
+      for (int i = 0; i < n_index; i++) {
+        float acc = 0;
+        for (int c = 0; c < d; c++) {
+          float x = params.rowMajorIndex ? h_index[i * d + c]
+                                         : h_index[i + c * n_index];
+          float y = params.rowMajorQuery ? h_query[q * d + c]
+                                         : h_query[q + c * n_query];
+          acc += (x - y) * (x - y);
+        }
+        if (acc <= params.eps * params.eps) {
+          h_col_ind.push_back(i);
+          h_vals.push_back(std::sqrt(acc));
+        }
+      }
+      h_row_ind.push_back(h_col_ind.size());
+    }
+
+    allocate(d_index, n_index * d);
+    allocate(d_query, n_query * d);
+    updateDevice(d_index, h_index.data(), n_index * d, stream);
+    updateDevice(d_query, h_query.data(), n_query * d, stream);
+    auto alloc = std::make_shared<defaultDeviceAllocator>();
+    graph.reset(new Sparse::CSR<float>(alloc, stream));
+    radius_neighbors(d_index, n_index, params.rowMajorIndex, d_query, n_query,
+                     params.rowMajorQuery, d, params.eps, graph.get(),
+                     stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    graph.reset();
+    CUDA_CHECK(cudaFree(d_index));
+    CUDA_CHECK(cudaFree(d_query));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  RadiusNeighborsInputs params;
+  cudaStream_t stream;
+  float *d_index, *d_query;
+  std::unique_ptr<Sparse::CSR<float>> graph;
+  std::vector<int> h_row_ind, h_col_ind;
+  std::vector<float> h_vals;
+};
+
+const std::vector<RadiusNeighborsInputs> inputs = {
+  {300, 50, 5, 3.5f, true, true},
+  {300, 50, 5, 3.5f, false, true},
+  {1000, 70, 37, 9.5f, true, false},
+  {100, 13, 3, 2.5f, false, false},
+  {100, 13, 3, 0.5f, true, true}};
+
+TEST_P(RadiusNeighborsTest, Graph) {
+  int nnz = h_col_ind.size();
+  ASSERT_EQ(graph->nnz, nnz);
+  ASSERT_TRUE(devArrMatchHost(h_row_ind.data(), graph->row_ind(),
+                              params.n_query + 1, Compare<int>()));
+  ASSERT_TRUE(devArrMatchHost(h_col_ind.data(), graph->row_ind_ptr(), nnz,
+                              Compare<int>()));
+  ASSERT_TRUE(devArrMatchHost(h_vals.data(), graph->vals(), nnz,
+                              CompareApprox<float>(1e-5)));
+}
+
+INSTANTIATE_TEST_CASE_P(RadiusNeighborsTests, RadiusNeighborsTest,
+                        ::testing::ValuesIn(inputs));
+
+};  // end namespace Selection
+};  // end namespace MLCommon
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "selection/radix_topk.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Selection {
+
+struct RadixTopKInputs {
+  int rows, cols, k;
+  bool smallest;
+  // draw the values from a few integers, for many ties
+  bool ties;
+  unsigned long long int seed;
+};
+
+::std::ostream &operator<<(::std::ostream &os, const RadixTopKInputs &dims) {
+  return os;
+}
+
+template <bool Greater>
+void runTopK(float *outV, int *outK, const float *arr, int k, int rows,
+             int cols, std::shared_ptr<deviceAllocator> alloc,
+             cudaStream_t stream) {
+  topK<float, int, Greater>(outV, outK, arr, k, rows, cols, alloc, stream);
+}
+
+/**
+ * The sorted top-k of each row against a host partial sort, dispatched to
+ * the warp-select or the radix-select by k. The keys are checked to point at
+ * their values and to be distinct, as the ties may come in any order.
+ */
+class RadixTopKTest : public ::testing::TestWithParam<RadixTopKInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<RadixTopKInputs>::GetParam();
+    int rows = params.rows, cols = params.cols, k = params.k;
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+    std::default_random_engine gen(params.seed);
+    std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+    std::uniform_int_distribution<int> few(-8, 8);
+    arr_h.resize(rows * cols);
+    for (auto &v : arr_h) v = params.ties ? float(few(gen)) : uniform(gen);
+
+    device_buffer<float> arr(alloc, stream, rows * cols);
+    device_buffer<float> outV(alloc, stream, rows * k);
+    device_buffer<int> outK(alloc, stream, rows * k);
+    updateDevice(arr.data(), arr_h.data(), rows * cols, stream);
+    if (params.smallest) {
+      runTopK<true>(outV.data(), outK.data(), arr.data(), k, rows, cols, alloc,
+                    stream);
+    } else {
+      runTopK<false>(outV.data(), outK.data(), arr.data(), k, rows, cols,
+                     alloc, stream);
+    }
+    outV_h.resize(rows * k);
+    outK_h.resize(rows * k);
+    updateHost(outV_h.data(), outV.data(), rows * k, stream);
+    updateHost(outK_h.data(), outK.data(), rows * k, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  ::testing::AssertionResult check() {
+    int cols = params.cols, k = params.k;
+    for (int r = 0; r < params.rows; r++) {
+      std::vector<float> row(arr_h.begin() + r * cols,
+                             arr_h.begin() + (r + 1) * cols);
+      if (params.smallest) {
+        std::partial_sort(row.begin(), row.begin() + k, row.end());
+      } else {
+        std::partial_sort(row.begin(), row.begin() + k, row.end(),
+                          std::greater<float>());
+      }
+      std::vector<bool> seen(cols, false);
+      for (int j = 0; j < k; j++) {
+        float val = outV_h[r * k + j];
+        int key = outK_h[r * k + j];
+        if (val != row[j]) {
+          return ::testing::AssertionFailure()
+                 << "actual=" << val << " != expected=" << row[j] << " @("
+                 << r << ", " << j << ")";
+        }
+        if (key < 0 || key >= cols || seen[key] ||
+            arr_h[r * cols + key] != val) {
+          return ::testing::AssertionFailure()
+                 << "bad key " << key << " @(" << r << ", " << j << ")";
+        }
+        seen[key] = true;
+      }
+    }
+    return ::testing::AssertionSuccess();
+  }
+
+  RadixTopKInputs params;
+  std::vector<float> arr_h, outV_h;
+  std::vector<int> outK_h;
+};
+
+const std::vector<RadixTopKInputs> inputs = {
+  {4, 2048, 256, true, false, 1234ULL},
+  {4, 2048, 257, true, false, 1234ULL},
+  {4, 2048, 257, false, false, 1234ULL},
+  {3, 5000, 1023, true, false, 1234ULL},
+  {3, 5000, 1023, true, true, 1234ULL},
+  {3, 5000, 1023, false, true, 1234ULL},
+  {2, 100000, 4096, true, false, 42ULL},
+  {2, 100000, 4096, false, true, 42ULL},
+  {5, 1000, 1000, true, false, 42ULL}};
+typedef RadixTopKTest RadixTopKTestF;
+TEST_P(RadixTopKTestF, Result) { ASSERT_TRUE(check()); }
+INSTANTIATE_TEST_CASE_P(RadixTopKTests, RadixTopKTestF,
+                        ::testing::ValuesIn(inputs));
+
+};  // end namespace Selection
+};  // end namespace MLCommon
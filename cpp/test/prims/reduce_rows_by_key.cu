@@ -25,6 +25,7 @@ namespace LinAlg {
 
 template <typename Type>
 __global__ void naiveReduceRowsByKeyKernel(Type *d_A, int lda, uint32_t *d_keys,
+                                           const Type *d_weights,
                                            char *d_char_keys, int nrows,
                                            int ncols, int nkeys, Type *d_sums) {
   int c = threadIdx.x + blockIdx.x * blockDim.x;
@@ -34,19 +35,21 @@ __global__ void naiveReduceRowsByKeyKernel(Type *d_A, int lda, uint32_t *d_keys,
   Type sum = 0.0;
   for (int r = 0; r < nrows; r++) {
     if (this_key != d_keys[r]) continue;
-    sum += d_A[lda * r + c];
+    sum += d_A[lda * r + c] * (d_weights ? d_weights[r] : Type(1));
   }
   d_sums[this_key * ncols + c] = sum;
 }
 template <typename Type>
 void naiveReduceRowsByKey(Type *d_A, int lda, uint32_t *d_keys,
-                          char *d_char_keys, int nrows, int ncols, int nkeys,
-                          Type *d_sums, cudaStream_t stream) {
+                          const Type *d_weights, char *d_char_keys, int nrows,
+                          int ncols, int nkeys, Type *d_sums,
+                          cudaStream_t stream) {
   cudaMemset(d_sums, 0, sizeof(Type) * nkeys * ncols);
 
   naiveReduceRowsByKeyKernel<<<dim3((ncols + 31) / 32, nkeys), dim3(32, 1), 0,
-                               stream>>>(d_A, lda, d_keys, d_char_keys, nrows,
-                                         ncols, nkeys, d_sums);
+                               stream>>>(d_A, lda, d_keys, d_weights,
+                                         d_char_keys, nrows, ncols, nkeys,
+                                         d_sums);
 }
 
 template <typename T>
@@ -56,6 +59,7 @@ struct ReduceRowsInputs {
   uint32_t cols;
   uint32_t nkeys;
   unsigned long long int seed;
+  bool weighted;
 };
 
 template <typename T>
@@ -78,20 +82,29 @@ class ReduceRowTest : public ::testing::TestWithParam<ReduceRowsInputs<T>> {
     uint32_t nkeys = params.nkeys;
     allocate(in1, nobs * cols);
     allocate(in2, nobs);
+    allocate(weights, nobs);
     allocate(chars2, nobs);
     allocate(out_ref, nkeys * cols);
     allocate(out, nkeys * cols);
     r.uniform(in1, nobs * cols, T(0.0), T(2.0 / nobs), stream);
     r_int.uniformInt(in2, nobs, (uint32_t)0, nkeys, stream);
-    naiveReduceRowsByKey(in1, cols, in2, chars2, nobs, cols, nkeys, out_ref,
+    r.uniform(weights, nobs, T(0.0), T(2.0), stream);
+    T *w = params.weighted ? weights : nullptr;
+    naiveReduceRowsByKey(in1, cols, in2, w, chars2, nobs, cols, nkeys, out_ref,
+                         stream);
+    if (params.weighted)
+      reduce_rows_by_key(in1, cols, in2, w, chars2, nobs, cols, nkeys, out,
+                         stream);
+    else
+      reduce_rows_by_key(in1, cols, in2, chars2, nobs, cols, nkeys, out,
                          stream);
-    reduce_rows_by_key(in1, cols, in2, chars2, nobs, cols, nkeys, out, stream);
     CUDA_CHECK(cudaStreamSynchronize(stream));
   }
 
   void TearDown() override {
     CUDA_CHECK(cudaFree(in1));
     CUDA_CHECK(cudaFree(in2));
+    CUDA_CHECK(cudaFree(weights));
     CUDA_CHECK(cudaFree(chars2));
     CUDA_CHECK(cudaFree(out_ref));
     CUDA_CHECK(cudaFree(out));
@@ -101,7 +114,7 @@ class ReduceRowTest : public ::testing::TestWithParam<ReduceRowsInputs<T>> {
  protected:
   cudaStream_t stream;
   ReduceRowsInputs<T> params;
-  T *in1, *out_ref, *out, *out_2;
+  T *in1, *out_ref, *out, *out_2, *weights;
   uint32_t *in2;
   char *chars2;
   int device_count = 0;
@@ -183,5 +196,19 @@ TEST_P(ReduceRowTestManyClusters, Result) {
 INSTANTIATE_TEST_CASE_P(ReduceRowTests, ReduceRowTestManyClusters,
                         ::testing::ValuesIn(inputsf_many_cluster));
 
+// ReduceRowTestWeighted
+// weighted rows, with small and large # of clusters
+const std::vector<ReduceRowsInputs<float>> inputsf_weighted = {
+  {0.00001f, 128, 32, 3, 1234ULL, true},
+  {0.00001f, 100000, 37, 32, 1234ULL, true},
+  {0.00001f, 100000, 37, 2048, 1234ULL, true}};
+typedef ReduceRowTest<float> ReduceRowTestWeighted;
+TEST_P(ReduceRowTestWeighted, Result) {
+  ASSERT_TRUE(devArrMatch(out_ref, out, params.cols * params.nkeys,
+                          CompareApprox<float>(params.tolerance)));
+}
+INSTANTIATE_TEST_CASE_P(ReduceRowTests, ReduceRowTestWeighted,
+                        ::testing::ValuesIn(inputsf_weighted));
+
 }  // end namespace LinAlg
 }  // end namespace MLCommon
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "random/stateless_rng.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Random {
+
+struct StatelessRngInputs {
+  int len;
+  // where the stream is cut in two launches
+  int split;
+  uint64_t seed, streamId;
+};
+
+::std::ostream &operator<<(::std::ostream &os,
+                           const StatelessRngInputs &dims) {
+  return os;
+}
+
+/**
+ * The slices of a stream generated in two launches, as two ranks would, are
+ * the stream generated at once and the values of the host, and the moments
+ * of the distributions are right.
+ */
+class StatelessRngTest : public ::testing::TestWithParam<StatelessRngInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<StatelessRngInputs>::GetParam();
+    int len = params.len, split = params.split;
+    uint64_t seed = params.seed, sid = params.streamId;
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+    device_buffer<float> whole(alloc, stream, len), parts(alloc, stream, len);
+    device_buffer<float> other(alloc, stream, len);
+    device_buffer<int64_t> ints(alloc, stream, len);
+    device_buffer<double> normals(alloc, stream, len);
+    device_buffer<bool> coins(alloc, stream, len);
+    statelessUniform(whole.data(), len, 0.f, 1.f, seed, sid, 0, stream);
+    statelessUniform(parts.data(), split, 0.f, 1.f, seed, sid, 0, stream);
+    statelessUniform(parts.data() + split, len - split, 0.f, 1.f, seed, sid,
+                     uint64_t(split), stream);
+    statelessUniform(other.data(), len, 0.f, 1.f, seed, sid + 1, 0, stream);
+    statelessUniformInt(ints.data(), len, int64_t(-5), int64_t(1) << 40, seed,
+                        sid, 0, stream);
+    statelessNormal(normals.data(), len, 1.0, 2.0, seed, sid, 0, stream);
+    statelessBernoulli(coins.data(), len, 0.25f, seed, sid, 0, stream);
+
+    whole_h.resize(len);
+    parts_h.resize(len);
+    other_h.resize(len);
+    ints_h.resize(len);
+    normals_h.resize(len);
+    std::unique_ptr<bool[]> coins_h(new bool[len]);
+    updateHost(whole_h.data(), whole.data(), len, stream);
+    updateHost(parts_h.data(), parts.data(), len, stream);
+    updateHost(other_h.data(), other.data(), len, stream);
+    updateHost(ints_h.data(), ints.data(), len, stream);
+    updateHost(normals_h.data(), normals.data(), len, stream);
+    updateHost(coins_h.get(), coins.data(), len, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+    heads = 0;
+    for (int i = 0; i < len; i++) heads += coins_h[i];
+  }
+
+  StatelessRngInputs params;
+  std::vector<float> whole_h, parts_h, other_h;
+  std::vector<int64_t> ints_h;
+  std::vector<double> normals_h;
+  int heads;
+};
+
+const std::vector<StatelessRngInputs> inputs = {
+  {1024 * 1024, 1000, 1234ULL, 0ULL},
+  {1024 * 1024 + 3, 517 * 1024 + 1, 1234ULL, 7ULL},
+  {1024 * 1024, 1, 0xdeadbeefcafeULL, 1ULL << 40}};
+typedef StatelessRngTest StatelessRngTestF;
+TEST_P(StatelessRngTestF, Result) {
+  int len = params.len, sameAsOther = 0;
+  double sum = 0, sumSq = 0;
+  for (int i = 0; i < len; i++) {
+    float host = statelessUniformAt(params.seed, params.streamId, uint64_t(i),
+                                    0.f, 1.f);
+    ASSERT_EQ(host, whole_h[i]) << " @" << i;
+    ASSERT_EQ(whole_h[i], parts_h[i]) << " @" << i;
+    ASSERT_EQ(statelessUniformIntAt(params.seed, params.streamId, uint64_t(i),
+                                    int64_t(-5), int64_t(1) << 40),
+              ints_h[i])
+      << " @" << i;
+    sameAsOther += whole_h[i] == other_h[i];
+    sum += normals_h[i];
+    sumSq += normals_h[i] * normals_h[i];
+  }
+  // the streams of a seed are independent
+  ASSERT_LT(sameAsOther, len / 1000);
+  double mean = sum / len, var = sumSq / len - mean * mean;
+  ASSERT_NEAR(mean, 1.0, 0.01);
+  ASSERT_NEAR(std::sqrt(var), 2.0, 0.01);
+  ASSERT_NEAR(double(heads) / len, 0.25, 0.005);
+}
+INSTANTIATE_TEST_CASE_P(StatelessRngTests, StatelessRngTestF,
+                        ::testing::ValuesIn(inputs));
+
+};  // end namespace Random
+};  // end namespace MLCommon
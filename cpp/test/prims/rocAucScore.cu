@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <cuml/common/cuml_allocator.hpp>
+#include <random>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "metrics/rocAucScore.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Metrics {
+
+struct RocAucScoreParam {
+  int nSamples;
+  // the scores are rounded to multiples of 1 / nLevels, making ties
+  int nLevels;
+  unsigned long long int seed;
+};
+
+std::ostream &operator<<(std::ostream &os, const RocAucScoreParam &p) {
+  return os << "{" << p.nSamples << ", " << p.nLevels << "}";
+}
+
+/**
+ * Scores of the positives shifted up, against the fraction of the
+ * positive-negative pairs ordered right, ties counting half, on the host
+ */
+template <typename DataT>
+class RocAucScoreTest : public ::testing::TestWithParam<RocAucScoreParam> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<RocAucScoreParam>::GetParam();
+    int n = params.nSamples;
+
+    std::default_random_engine gen(params.seed);
+    std::bernoulli_distribution label(0.3);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::vector<int> truth(n);
+    std::vector<DataT> scores(n);
+    for (int i = 0; i < n; i++) {
+      truth[i] = i < 2 ? i : label(gen);
+      double s = normal(gen) + truth[i];
+      scores[i] = DataT(std::round(s * params.nLevels) / params.nLevels);
+    }
+
+    double pairs = 0.0, nPositives = 0.0;
+    for (int i = 0; i < n; i++) {
+      if (!truth[i]) continue;
+      nPositives++;
+      for (int j = 0; j < n; j++) {
+        if (truth[j]) continue;
+        if (scores[i] > scores[j])
+          pairs += 1.0;
+        else if (scores[i] == scores[j])
+          pairs += 0.5;
+      }
+    }
+    expected = pairs / (nPositives * (n - nPositives));
+
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+    device_buffer<int> d_truth(alloc, stream, n);
+    device_buffer<DataT> d_scores(alloc, stream, n);
+    updateDevice(d_truth.data(), truth.data(), n, stream);
+    updateDevice(d_scores.data(), scores.data(), n, stream);
+    result = rocAucScore(d_truth.data(), d_scores.data(), n, alloc, stream);
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  RocAucScoreParam params;
+  double expected, result;
+};
+
+const std::vector<RocAucScoreParam> inputs = {
+  {2, 1, 1234ULL}, {1000, 1000000, 1234ULL}, {5000, 4, 42ULL}, {3000, 1, 7ULL}};
+
+typedef RocAucScoreTest<float> RocAucScoreTestF;
+TEST_P(RocAucScoreTestF, Result) { ASSERT_NEAR(expected, result, 1e-6); }
+INSTANTIATE_TEST_CASE_P(RocAucScore, RocAucScoreTestF,
+                        ::testing::ValuesIn(inputs));
+
+typedef RocAucScoreTest<double> RocAucScoreTestD;
+TEST_P(RocAucScoreTestD, Result) { ASSERT_NEAR(expected, result, 1e-10); }
+INSTANTIATE_TEST_CASE_P(RocAucScore, RocAucScoreTestD,
+                        ::testing::ValuesIn(inputs));
+
+}  //end namespace Metrics
+}  //end namespace MLCommon
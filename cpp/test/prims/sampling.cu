@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "random/sampling.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Random {
+
+struct SamplingInputs {
+  int n, k;
+  uint64_t seed;
+};
+
+::std::ostream &operator<<(::std::ostream &os, const SamplingInputs &dims) {
+  return os;
+}
+
+/**
+ * The samples without replacement are distinct and in range, the uniform one
+ * increasing when drawn in the bitmap, and the weighted ones never pick the
+ * null weights: every other weight is null, and their proportion among the
+ * draws with replacement follows the weights 1 and 3 of the others.
+ */
+class SamplingTest : public ::testing::TestWithParam<SamplingInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<SamplingInputs>::GetParam();
+    int n = params.n, k = params.k;
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+    wts_h.resize(n);
+    for (int i = 0; i < n; i++) wts_h[i] = i % 2 ? 0.f : (i % 4 ? 3.f : 1.f);
+    device_buffer<float> wts(alloc, stream, n);
+    updateDevice(wts.data(), wts_h.data(), n, stream);
+    device_buffer<int> uniform(alloc, stream, k), again(alloc, stream, k);
+    device_buffer<int> weighted(alloc, stream, k / 2);
+    device_buffer<int> replaced(alloc, stream, 64 * k);
+    uniformSampleWithoutReplacement(uniform.data(), k, n, params.seed, alloc,
+                                    stream);
+    uniformSampleWithoutReplacement(again.data(), k, n, params.seed, alloc,
+                                    stream);
+    weightedSampleWithoutReplacement(weighted.data(), wts.data(), k / 2, n,
+                                     params.seed, alloc, stream);
+    weightedSampleWithReplacement(replaced.data(), wts.data(), 64 * k, n,
+                                  params.seed, alloc, stream);
+
+    uniform_h.resize(k);
+    again_h.resize(k);
+    weighted_h.resize(k / 2);
+    replaced_h.resize(64 * k);
+    updateHost(uniform_h.data(), uniform.data(), k, stream);
+    updateHost(again_h.data(), again.data(), k, stream);
+    updateHost(weighted_h.data(), weighted.data(), k / 2, stream);
+    updateHost(replaced_h.data(), replaced.data(), 64 * k, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  ::testing::AssertionResult distinct(std::vector<int> idx) {
+    std::sort(idx.begin(), idx.end());
+    for (size_t i = 0; i < idx.size(); i++) {
+      if (idx[i] < 0 || idx[i] >= params.n) {
+        return ::testing::AssertionFailure() << "out of range " << idx[i];
+      }
+      if (i > 0 && idx[i] == idx[i - 1]) {
+        return ::testing::AssertionFailure() << "sampled twice " << idx[i];
+      }
+    }
+    return ::testing::AssertionSuccess();
+  }
+
+  SamplingInputs params;
+  std::vector<float> wts_h;
+  std::vector<int> uniform_h, again_h, weighted_h, replaced_h;
+};
+
+const std::vector<SamplingInputs> inputs = {{1000, 10, 1234ULL},
+                                            {100000, 50000, 1234ULL},
+                                            {100000, 90000, 42ULL},
+                                            {1000003, 1000, 42ULL}};
+typedef SamplingTest SamplingTestF;
+TEST_P(SamplingTestF, Result) {
+  ASSERT_TRUE(distinct(uniform_h));
+  ASSERT_TRUE(distinct(weighted_h));
+  ASSERT_EQ(uniform_h, again_h);
+  if (2 * params.k <= params.n) {
+    ASSERT_TRUE(std::is_sorted(uniform_h.begin(), uniform_h.end()));
+  }
+  for (auto i : weighted_h) ASSERT_GT(wts_h[i], 0.f) << " @" << i;
+  int heavy = 0;
+  for (auto i : replaced_h) {
+    ASSERT_GE(i, 0);
+    ASSERT_LT(i, params.n);
+    ASSERT_GT(wts_h[i], 0.f) << " @" << i;
+    heavy += wts_h[i] > 1.f;
+  }
+  ASSERT_NEAR(double(heavy) / replaced_h.size(), 0.75, 0.05);
+}
+INSTANTIATE_TEST_CASE_P(SamplingTests, SamplingTestF,
+                        ::testing::ValuesIn(inputs));
+
+};  // end namespace Random
+};  // end namespace MLCommon
@@ -15,7 +15,11 @@
  */
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <numeric>
+#include <random>
 #include <vector>
 #include "random/rng.h"
 #include "score/scores.h"
@@ -75,6 +79,90 @@ TEST(ScoreTestLowScore, Result) {
   CUDA_CHECK(cudaStreamDestroy(stream));
 }
 
+// Tests for trustworthiness_score
+
+struct TrustworthinessInputs {
+  int n, m, d, n_neighbors, batchSize;
+  unsigned long long int seed;
+};
+
+std::ostream &operator<<(std::ostream &os, const TrustworthinessInputs &dims) {
+  return os;
+}
+
+/**
+ * The embedding is the first d features of X with noise, against the score
+ * from the sorted rows of distances of both spaces on the host
+ */
+class TrustworthinessTest
+  : public ::testing::TestWithParam<TrustworthinessInputs> {
+ protected:
+  std::vector<int> sorted_by_distance(const std::vector<float> &X, int dim,
+                                      int i) {
+    int n = params.n;
+    std::vector<double> dist(n, 0.0);
+    for (int j = 0; j < n; j++) {
+      for (int c = 0; c < dim; c++) {
+        double diff = X[i * dim + c] - X[j * dim + c];
+        dist[j] += diff * diff;
+      }
+    }
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&dist](int a, int b) { return dist[a] < dist[b]; });
+    return order;
+  }
+
+  void SetUp() override {
+    params = ::testing::TestWithParam<TrustworthinessInputs>::GetParam();
+    int n = params.n, m = params.m, d = params.d, k = params.n_neighbors;
+    std::default_random_engine gen(params.seed);
+    std::uniform_real_distribution<float> unif(-1.0f, 1.0f);
+    std::vector<float> X(n * m), X_embedded(n * d);
+    for (auto &x : X) x = unif(gen);
+    for (int i = 0; i < n; i++) {
+      for (int c = 0; c < d; c++)
+        X_embedded[i * d + c] = X[i * m + c] + 0.3f * unif(gen);
+    }
+
+    double t = 0.0;
+    for (int i = 0; i < n; i++) {
+      std::vector<int> rank(n), order = sorted_by_distance(X, m, i);
+      for (int r = 0; r < n; r++) rank[order[r]] = r;
+      std::vector<int> nn = sorted_by_distance(X_embedded, d, i);
+      for (int j = 1; j <= k; j++) t += std::max(0, rank[nn[j]] - k);
+    }
+    expected = 1.0 - 2.0 / (n * k * (2.0 * n - 3.0 * k - 1.0)) * t;
+
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+    device_buffer<float> d_X(alloc, stream, n * m);
+    device_buffer<float> d_X_embedded(alloc, stream, n * d);
+    updateDevice(d_X.data(), X.data(), n * m, stream);
+    updateDevice(d_X_embedded.data(), X_embedded.data(), n * d, stream);
+    result = trustworthiness_score<float, Distance::EucUnexpandedL2Sqrt>(
+      d_X.data(), d_X_embedded.data(), n, m, d, k, alloc, stream,
+      params.batchSize);
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  TrustworthinessInputs params;
+  double expected, result;
+};
+
+const std::vector<TrustworthinessInputs> trustworthiness_inputs = {
+  {300, 10, 2, 10, 64, 1234ULL},
+  {500, 16, 3, 40, 0, 42ULL},
+  {257, 5, 2, 5, 1, 7ULL}};
+
+TEST_P(TrustworthinessTest, Result) {
+  ASSERT_NEAR(expected, result, 1e-4);
+}
+INSTANTIATE_TEST_CASE_P(TrustworthinessTests, TrustworthinessTest,
+                        ::testing::ValuesIn(trustworthiness_inputs));
+
 // Tests for accuracy_score
 
 struct AccuracyInputs {
@@ -183,6 +271,106 @@ INSTANTIATE_TEST_CASE_P(AccuracyTests, AccuracyTestF,
 INSTANTIATE_TEST_CASE_P(AccuracyTests, AccuracyTestD,
                         ::testing::ValuesIn(inputs));
 
+// Tests for batched_r2_score and batched_accuracy_score
+struct BatchedScoreInputs {
+  int n_models, n;
+  unsigned long long int seed;
+};
+
+std::ostream &operator<<(std::ostream &os, const BatchedScoreInputs &inputs) {
+  return os << "{" << inputs.n_models << ", " << inputs.n << "}";
+}
+
+/**
+ * The batched scores of n_models noisy predictions against the scores of
+ * each model computed on its own
+ */
+template <typename T>
+class BatchedScoreTest : public ::testing::TestWithParam<BatchedScoreInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<BatchedScoreInputs>::GetParam();
+    int n_models = params.n_models, n = params.n;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> d_alloc(new defaultDeviceAllocator);
+
+    std::default_random_engine gen(params.seed);
+    std::normal_distribution<T> normal(T(0), T(1));
+    std::uniform_int_distribution<int> labels(0, 3);
+    std::vector<T> y_h(n), y_hat_h((size_t)n_models * n);
+    std::vector<int> ref_h(n), pred_h((size_t)n_models * n);
+    for (int j = 0; j < n; j++) {
+      y_h[j] = normal(gen);
+      ref_h[j] = labels(gen);
+    }
+    for (int i = 0; i < n_models; i++) {
+      for (int j = 0; j < n; j++) {
+        y_hat_h[i * n + j] = y_h[j] + T(0.1) * (i + 1) * normal(gen);
+        pred_h[i * n + j] = labels(gen) < i % 4 ? labels(gen) : ref_h[j];
+      }
+    }
+
+    device_buffer<T> y(d_alloc, stream, n);
+    device_buffer<T> y_hat(d_alloc, stream, (size_t)n_models * n);
+    device_buffer<int> ref(d_alloc, stream, n);
+    device_buffer<int> pred(d_alloc, stream, (size_t)n_models * n);
+    updateDevice(y.data(), y_h.data(), n, stream);
+    updateDevice(y_hat.data(), y_hat_h.data(), n_models * n, stream);
+    updateDevice(ref.data(), ref_h.data(), n, stream);
+    updateDevice(pred.data(), pred_h.data(), n_models * n, stream);
+
+    device_buffer<T> r2(d_alloc, stream, n_models);
+    device_buffer<float> acc(d_alloc, stream, n_models);
+    batched_r2_score(r2.data(), y.data(), y_hat.data(), n_models, n, d_alloc,
+                     stream);
+    batched_accuracy_score(acc.data(), pred.data(), ref.data(), n_models, n,
+                           stream);
+    r2_res.resize(n_models);
+    acc_res.resize(n_models);
+    updateHost(r2_res.data(), r2.data(), n_models, stream);
+    updateHost(acc_res.data(), acc.data(), n_models, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+
+    for (int i = 0; i < n_models; i++) {
+      r2_exp.push_back(
+        r2_score(y.data(), y_hat.data() + (size_t)i * n, n, stream));
+      acc_exp.push_back(accuracy_score(pred.data() + (size_t)i * n,
+                                       ref.data(), n, d_alloc, stream));
+    }
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  BatchedScoreInputs params;
+  std::vector<T> r2_res, r2_exp;
+  std::vector<float> acc_res, acc_exp;
+  cudaStream_t stream;
+};
+
+const std::vector<BatchedScoreInputs> batched_inputs = {
+  {1, 10, 1234ULL}, {7, 1000, 1234ULL}, {100, 33, 42ULL}, {16, 5000, 42ULL}};
+
+typedef BatchedScoreTest<float> BatchedScoreTestF;
+TEST_P(BatchedScoreTestF, Result) {
+  for (int i = 0; i < params.n_models; i++) {
+    ASSERT_TRUE(match(r2_exp[i], r2_res[i], CompareApprox<float>(1e-4f)));
+    ASSERT_TRUE(match(acc_exp[i], acc_res[i], CompareApprox<float>(1e-6f)));
+  }
+}
+
+typedef BatchedScoreTest<double> BatchedScoreTestD;
+TEST_P(BatchedScoreTestD, Result) {
+  for (int i = 0; i < params.n_models; i++) {
+    ASSERT_TRUE(match(r2_exp[i], r2_res[i], CompareApprox<double>(1e-10)));
+    ASSERT_TRUE(match(acc_exp[i], acc_res[i], CompareApprox<float>(1e-6f)));
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(BatchedScoreTests, BatchedScoreTestF,
+                        ::testing::ValuesIn(batched_inputs));
+INSTANTIATE_TEST_CASE_P(BatchedScoreTests, BatchedScoreTestD,
+                        ::testing::ValuesIn(batched_inputs));
+
 // Tests for regression_metrics
 
 template <typename T>
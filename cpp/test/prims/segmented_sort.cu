@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "selection/segmented_sort.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Selection {
+
+struct SegmentedSortInputs {
+  int nItems, nSegments;
+  // whether the segments are the rows of a matrix, else of random lengths
+  bool rows;
+  bool descending;
+  // whether the outputs overwrite the inputs
+  bool inPlace;
+  unsigned long long int seed;
+};
+
+::std::ostream &operator<<(::std::ostream &os,
+                           const SegmentedSortInputs &dims) {
+  return os;
+}
+
+template <typename T>
+::testing::AssertionResult match(const std::vector<T> &expected,
+                                 const std::vector<T> &actual) {
+  for (size_t i = 0; i < expected.size(); i++) {
+    if (expected[i] != actual[i]) {
+      return ::testing::AssertionFailure()
+             << "actual=" << actual[i] << " != expected=" << expected[i]
+             << " @" << i;
+    }
+  }
+  return ::testing::AssertionSuccess();
+}
+
+/**
+ * The keys-only sort of float keys and the key-value sort of 64-bit keys
+ * against a host stable sort of each segment. The 64-bit keys take few
+ * distinct values, so that the stability of the values is checked too.
+ */
+class SegmentedSortTest
+  : public ::testing::TestWithParam<SegmentedSortInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<SegmentedSortInputs>::GetParam();
+    int nItems = params.nItems, nSegments = params.nSegments;
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+    std::default_random_engine gen(params.seed);
+    std::vector<int> offsets_h(nSegments + 1, 0);
+    if (params.rows) {
+      for (int s = 0; s <= nSegments; s++)
+        offsets_h[s] = s * (nItems / nSegments);
+    } else {
+      std::uniform_int_distribution<int> cut(0, nItems);
+      for (int s = 1; s < nSegments; s++) offsets_h[s] = cut(gen);
+      std::sort(offsets_h.begin(), offsets_h.end());
+      offsets_h[nSegments] = nItems;
+    }
+    std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+    std::uniform_int_distribution<int> few(0, 15);
+    std::vector<float> keys_h(nItems);
+    std::vector<uint64_t> keys64_h(nItems);
+    std::vector<int> vals_h(nItems);
+    for (int i = 0; i < nItems; i++) {
+      keys_h[i] = uniform(gen);
+      keys64_h[i] = (uint64_t(few(gen)) << 40) | 7;
+      vals_h[i] = i;
+    }
+
+    keys_exp = keys_h;
+    keys64_exp = keys64_h;
+    vals_exp = vals_h;
+    bool desc = params.descending;
+    for (int s = 0; s < nSegments; s++) {
+      auto b = offsets_h[s], e = offsets_h[s + 1];
+      std::stable_sort(
+        keys_exp.begin() + b, keys_exp.begin() + e,
+        [desc](float a, float c) { return desc ? a > c : a < c; });
+      std::stable_sort(vals_exp.begin() + b, vals_exp.begin() + e,
+                       [&](int a, int c) {
+                         return desc ? keys64_h[a] > keys64_h[c]
+                                     : keys64_h[a] < keys64_h[c];
+                       });
+      for (int i = b; i < e; i++) keys64_exp[i] = keys64_h[vals_exp[i]];
+    }
+
+    device_buffer<float> keys(alloc, stream, nItems);
+    device_buffer<float> keysOut(alloc, stream, nItems);
+    device_buffer<uint64_t> keys64(alloc, stream, nItems);
+    device_buffer<uint64_t> keys64Out(alloc, stream, nItems);
+    device_buffer<int> vals(alloc, stream, nItems);
+    device_buffer<int> valsOut(alloc, stream, nItems);
+    device_buffer<int> offsets(alloc, stream, nSegments + 1);
+    updateDevice(keys.data(), keys_h.data(), nItems, stream);
+    updateDevice(keys64.data(), keys64_h.data(), nItems, stream);
+    updateDevice(vals.data(), vals_h.data(), nItems, stream);
+    updateDevice(offsets.data(), offsets_h.data(), nSegments + 1, stream);
+    float *pKeysOut = params.inPlace ? keys.data() : keysOut.data();
+    uint64_t *pKeys64Out = params.inPlace ? keys64.data() : keys64Out.data();
+    int *pValsOut = params.inPlace ? vals.data() : valsOut.data();
+    if (params.rows) {
+      int cols = nItems / nSegments;
+      sortRowsKeys(keys.data(), pKeysOut, nSegments, cols, alloc, stream,
+                   desc);
+      sortRowsPairs(keys64.data(), pKeys64Out, vals.data(), pValsOut,
+                    nSegments, cols, alloc, stream, desc);
+    } else {
+      segmentedSortKeys(keys.data(), pKeysOut, nItems, nSegments,
+                        offsets.data(), alloc, stream, desc);
+      segmentedSortPairs(keys64.data(), pKeys64Out, vals.data(), pValsOut,
+                         nItems, nSegments, offsets.data(), alloc, stream,
+                         desc);
+    }
+    keys_res.resize(nItems);
+    keys64_res.resize(nItems);
+    vals_res.resize(nItems);
+    updateHost(keys_res.data(), pKeysOut, nItems, stream);
+    updateHost(keys64_res.data(), pKeys64Out, nItems, stream);
+    updateHost(vals_res.data(), pValsOut, nItems, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  SegmentedSortInputs params;
+  std::vector<float> keys_exp, keys_res;
+  std::vector<uint64_t> keys64_exp, keys64_res;
+  std::vector<int> vals_exp, vals_res;
+};
+
+const std::vector<SegmentedSortInputs> inputs = {
+  {1000, 1, false, false, false, 1234ULL},
+  {1000, 1, false, true, true, 1234ULL},
+  {100000, 37, false, false, false, 1234ULL},
+  {100000, 37, false, true, true, 1234ULL},
+  {100000, 1000, true, false, true, 42ULL},
+  {100000, 1000, true, true, false, 42ULL},
+  {300000, 3, true, false, false, 42ULL}};
+typedef SegmentedSortTest SegmentedSortTestF;
+TEST_P(SegmentedSortTestF, Result) {
+  ASSERT_TRUE(match(keys_exp, keys_res));
+  ASSERT_TRUE(match(keys64_exp, keys64_res));
+  ASSERT_TRUE(match(vals_exp, vals_res));
+}
+INSTANTIATE_TEST_CASE_P(SegmentedSortTests, SegmentedSortTestF,
+                        ::testing::ValuesIn(inputs));
+
+};  // end namespace Selection
+};  // end namespace MLCommon
@@ -164,6 +164,11 @@ class silhouetteScoreTest
     computedSilhouetteScore = MLCommon::Metrics::silhouetteScore(
       d_X, nRows, nCols, d_labels, nLabels, sampleSilScore, allocator, stream,
       params.metric);
+
+    //and with tiles of 3 rows, the last one partial for most inputs
+    computedTiledSilhouetteScore = MLCommon::Metrics::silhouetteScore(
+      d_X, nRows, nCols, d_labels, nLabels, sampleSilScore, allocator, stream,
+      params.metric, 3);
   }
 
   //the destructor
@@ -183,6 +188,7 @@ class silhouetteScoreTest
   int nCols;
   double truthSilhouetteScore = 0;
   double computedSilhouetteScore = 0;
+  double computedTiledSilhouetteScore = 0;
   cudaStream_t stream;
 };
 
@@ -196,6 +202,8 @@ const std::vector<silhouetteScoreParam> inputs = {
 typedef silhouetteScoreTest<int, double> silhouetteScoreTestClass;
 TEST_P(silhouetteScoreTestClass, Result) {
   ASSERT_NEAR(computedSilhouetteScore, truthSilhouetteScore, params.tolerance);
+  ASSERT_NEAR(computedTiledSilhouetteScore, truthSilhouetteScore,
+              params.tolerance);
 }
 INSTANTIATE_TEST_CASE_P(silhouetteScore, silhouetteScoreTestClass,
                         ::testing::ValuesIn(inputs));
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuda_utils.h>
+#include <gtest/gtest.h>
+#include <test_utils.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+#include "selection/sparse_knn.h"
+
+namespace MLCommon {
+namespace Selection {
+
+struct SparseKnnInputs {
+  int n_index;
+  int n_query;
+  int d;
+  float density;
+  int k;
+  int tile_rows;
+};
+
+::std::ostream &operator<<(::std::ostream &os, const SparseKnnInputs &dims) {
+  return os;
+}
+
+/**
+ * Checks sparse_brute_force_knn against a host brute force over the dense
+ * matrices. The neighbors are checked through their distances, which are
+ * robust to near ties.
+ */
+class SparseKnnTest : public ::testing::TestWithParam<SparseKnnInputs> {
+ protected:
+  // A random CSR matrix, together with its dense copy
+  void make_csr(int n_rows, std::mt19937 &gen, std::vector<float> &dense,
+                std::vector<float> &vals, std::vector<int> &row_ind,
+                std::vector<int> &cols) {
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    std::bernoulli_distribution nonzero(params.density);
+    dense.assign(n_rows * params.d, 0.f);
+    row_ind.assign(1, 0);
+    for (int i = 0; i < n_rows; i++) {
+      for (int c = 0; c < params.d; c++) {
+        if (!nonzero(gen)) continue;
+        dense[i * params.d + c] = dist(gen);
+        vals.push_back(dense[i * params.d + c]);
+        cols.push_back(c);
+      }
+      row_ind.push_back(vals.size());
+    }
+  }
+
+  float host_dist(int q, int i) {
+    float acc = 0;
+    for (int c = 0; c < params.d; c++) {
+      float diff = h_query[q * params.d + c] - h_index[i * params.d + c];
+      acc += diff * diff;
+    }
+    return std::sqrt(acc);
+  }
+
+  void SetUp() override {
+    params = ::testing::TestWithParam<SparseKnnInputs>::GetParam();
+    int n_q = params.n_query, k = params.k;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::mt19937 gen(42);
+    std::vector<float> idx_vals, q_vals;
+    std::vector<int> idx_row_ind, idx_cols, q_row_ind, q_cols;
+    make_csr(params.n_index, gen, h_index, idx_vals, idx_row_ind, idx_cols);
+    make_csr(n_q, gen, h_query, q_vals, q_row_ind, q_cols);
+
+    h_ref_D.resize(n_q * k);
+    for (int q = 0; q < n_q; q++) {
+      std::vector<float> row;
+      for (int i = 0; i < params.n_index; i++) row.push_back(host_dist(q, i));
+      std::sort(row.begin(), row.end());
+      std::copy(row.begin(), row.begin() + k, h_ref_D.begin() + q * k);
+    }
+
+    int idx_nnz = idx_vals.size(), q_nnz = q_vals.size();
+    allocate(d_idx_vals, std::max(idx_nnz, 1));
+    allocate(d_idx_cols, std::max(idx_nnz, 1));
+    allocate(d_idx_row_ind, params.n_index + 1);
+    allocate(d_q_vals, std::max(q_nnz, 1));
+    allocate(d_q_cols, std::max(q_nnz, 1));
+    allocate(d_q_row_ind, n_q + 1);
+    allocate(d_D, n_q * k);
+    allocate(d_I, n_q * k);
+    updateDevice(d_idx_vals, idx_vals.data(), idx_nnz, stream);
+    updateDevice(d_idx_cols, idx_cols.data(), idx_nnz, stream);
+    updateDevice(d_idx_row_ind, idx_row_ind.data(), params.n_index + 1,
+                 stream);
+    updateDevice(d_q_vals, q_vals.data(), q_nnz, stream);
+    updateDevice(d_q_cols, q_cols.data(), q_nnz, stream);
+    updateDevice(d_q_row_ind, q_row_ind.data(), n_q + 1, stream);
+
+    auto alloc = std::make_shared<defaultDeviceAllocator>();
+    sparse_brute_force_knn(d_idx_vals, d_idx_row_ind, d_idx_cols, idx_nnz,
+                           params.n_index, d_q_vals, d_q_row_ind, d_q_cols,
+                           n_q, params.d, k, d_I, d_D, alloc, stream,
+                           params.tile_rows);
+
+    h_I.resize(n_q * k);
+    updateHost(h_I.data(), d_I, n_q * k, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(d_idx_vals));
+    CUDA_CHECK(cudaFree(d_idx_cols));
+    CUDA_CHECK(cudaFree(d_idx_row_ind));
+    CUDA_CHECK(cudaFree(d_q_vals));
+    CUDA_CHECK(cudaFree(d_q_cols));
+    CUDA_CHECK(cudaFree(d_q_row_ind));
+    CUDA_CHECK(cudaFree(d_D));
+    CUDA_CHECK(cudaFree(d_I));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  SparseKnnInputs params;
+  cudaStream_t stream;
+  float *d_idx_vals, *d_q_vals, *d_D;
+  int *d_idx_cols, *d_idx_row_ind, *d_q_cols, *d_q_row_ind;
+  int64_t *d_I;
+  std::vector<float> h_index, h_query, h_ref_D;
+  std::vector<int64_t> h_I;
+};
+
+const std::vector<SparseKnnInputs> inputs = {
+  {300, 200, 50, 0.1f, 10, 64},    {300, 200, 50, 0.1f, 10, 0},
+  {1000, 500, 2000, 0.01f, 32, 0}, {500, 77, 100, 0.3f, 100, 30},
+  {64, 64, 20, 0.05f, 1, 16}};
+
+TEST_P(SparseKnnTest, Neighbors) {
+  int n_q = params.n_query, k = params.k;
+  ASSERT_TRUE(devArrMatchHost(h_ref_D.data(), d_D, n_q * k,
+                              CompareApprox<float>(1e-3), stream));
+  for (int q = 0; q < n_q; q++) {
+    std::vector<int64_t> ids(h_I.begin() + q * k, h_I.begin() + (q + 1) * k);
+    std::sort(ids.begin(), ids.end());
+    ASSERT_TRUE(std::unique(ids.begin(), ids.end()) == ids.end());
+    for (int j = 0; j < k; j++) {
+      int64_t id = h_I[q * k + j];
+      ASSERT_TRUE(id >= 0 && id < params.n_index);
+      ASSERT_NEAR(host_dist(q, id), h_ref_D[q * k + j], 1e-3);
+    }
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(SparseKnnTests, SparseKnnTest,
+                        ::testing::ValuesIn(inputs));
+
+};  // end namespace Selection
+};  // end namespace MLCommon
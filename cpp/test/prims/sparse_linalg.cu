@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "sparse/linalg.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Sparse {
+
+template <typename T>
+struct SparseLinalgInputs {
+  int n_rows, n_cols, n;
+  T density;
+  T tolerance;
+  unsigned long long int seed;
+};
+
+template <typename T>
+::std::ostream &operator<<(::std::ostream &os,
+                           const SparseLinalgInputs<T> &dims) {
+  return os;
+}
+
+template <typename T>
+struct SqrtOp {
+  HDI T operator()(T in) { return mySqrt(in); }
+};
+
+/**
+ * A random CSR matrix A of n_rows x n_cols, against the products of its dense
+ * copy on the host: y = 2 A' x + y / 2, C = A B, C2 = A' B2 + C2,
+ * S = (X Y') o spy(A) with S sharing the pattern of A, and the row norms
+ */
+template <typename T>
+class SparseLinalgTest
+  : public ::testing::TestWithParam<SparseLinalgInputs<T>> {
+ protected:
+  std::vector<T> random_dense(int size, std::default_random_engine &gen) {
+    std::uniform_real_distribution<T> dist(T(-1), T(1));
+    std::vector<T> out(size);
+    for (auto &v : out) v = dist(gen);
+    return out;
+  }
+
+  void SetUp() override {
+    params = ::testing::TestWithParam<SparseLinalgInputs<T>>::GetParam();
+    int m = params.n_rows, k = params.n_cols, n = params.n;
+    cudaStream_t stream;
+    cusparseHandle_t handle;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    CUSPARSE_CHECK(cusparseCreate(&handle));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+    // A, in CSR and dense column major
+    std::default_random_engine gen(params.seed);
+    std::uniform_real_distribution<T> unif(T(0), T(1));
+    std::vector<T> A(m * k, T(0)), vals_h;
+    std::vector<int> row_ind_h = {0}, cols_h;
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < k; j++) {
+        if (unif(gen) < params.density) {
+          A[i + j * m] = T(2) * unif(gen) - T(1);
+          cols_h.push_back(j);
+          vals_h.push_back(A[i + j * m]);
+        }
+      }
+      row_ind_h.push_back(cols_h.size());
+    }
+    int nnz = vals_h.size();
+    device_buffer<int> row_ind(alloc, stream, m + 1);
+    device_buffer<int> cols(alloc, stream, nnz);
+    device_buffer<T> vals(alloc, stream, nnz);
+    updateDevice(row_ind.data(), row_ind_h.data(), m + 1, stream);
+    updateDevice(cols.data(), cols_h.data(), nnz, stream);
+    updateDevice(vals.data(), vals_h.data(), nnz, stream);
+
+    // y = 2 A' x + y / 2
+    std::vector<T> x_h = random_dense(m, gen), y_h = random_dense(k, gen);
+    device_buffer<T> x(alloc, stream, m), y(alloc, stream, k);
+    updateDevice(x.data(), x_h.data(), m, stream);
+    updateDevice(y.data(), y_h.data(), k, stream);
+    csr_spmv(handle, true, row_ind.data(), cols.data(), vals.data(), nnz, m,
+             k, T(2), x.data(), T(0.5), y.data(), alloc, stream);
+    spmv_exp.resize(k);
+    for (int j = 0; j < k; j++) {
+      T dot = 0;
+      for (int i = 0; i < m; i++) dot += A[i + j * m] * x_h[i];
+      spmv_exp[j] = T(2) * dot + T(0.5) * y_h[j];
+    }
+    spmv_res.resize(k);
+    updateHost(spmv_res.data(), y.data(), k, stream);
+
+    // C = A B, C2 = A' B2 + C2
+    std::vector<T> B_h = random_dense(k * n, gen);
+    std::vector<T> B2_h = random_dense(m * n, gen);
+    std::vector<T> C2_h = random_dense(k * n, gen);
+    device_buffer<T> B(alloc, stream, k * n), C(alloc, stream, m * n);
+    device_buffer<T> B2(alloc, stream, m * n), C2(alloc, stream, k * n);
+    updateDevice(B.data(), B_h.data(), k * n, stream);
+    updateDevice(B2.data(), B2_h.data(), m * n, stream);
+    updateDevice(C2.data(), C2_h.data(), k * n, stream);
+    csr_spmm(handle, false, false, row_ind.data(), cols.data(), vals.data(),
+             nnz, m, k, n, T(1), B.data(), k, T(0), C.data(), m, alloc,
+             stream);
+    csr_spmm(handle, true, false, row_ind.data(), cols.data(), vals.data(),
+             nnz, m, k, n, T(1), B2.data(), m, T(1), C2.data(), k, alloc,
+             stream);
+    spmm_exp.assign(m * n + k * n, T(0));
+    for (int c = 0; c < n; c++) {
+      for (int i = 0; i < m; i++) {
+        for (int j = 0; j < k; j++) {
+          spmm_exp[i + c * m] += A[i + j * m] * B_h[j + c * k];
+        }
+      }
+      for (int j = 0; j < k; j++) {
+        T dot = C2_h[j + c * k];
+        for (int i = 0; i < m; i++) dot += A[i + j * m] * B2_h[i + c * m];
+        spmm_exp[m * n + j + c * k] = dot;
+      }
+    }
+    spmm_res.resize(m * n + k * n);
+    updateHost(spmm_res.data(), C.data(), m * n, stream);
+    updateHost(spmm_res.data() + m * n, C2.data(), k * n, stream);
+
+    // S = (X Y') o spy(A), X of m x n and Y of k x n
+    device_buffer<T> S(alloc, stream, nnz);
+    csr_sddmm(row_ind.data(), cols.data(), S.data(), nnz, m, n, T(1),
+              B2.data(), m, C2.data(), k, T(0), alloc, stream);
+    sddmm_exp.resize(nnz);
+    for (int i = 0; i < m; i++) {
+      for (int e = row_ind_h[i]; e < row_ind_h[i + 1]; e++) {
+        T dot = 0;
+        for (int c = 0; c < n; c++) {
+          dot += B2_h[i + c * m] * spmm_exp[m * n + cols_h[e] + c * k];
+        }
+        sddmm_exp[e] = dot;
+      }
+    }
+    sddmm_res.resize(nnz);
+    updateHost(sddmm_res.data(), S.data(), nnz, stream);
+
+    // L1 and L2 norms of the rows
+    device_buffer<T> norms(alloc, stream, 2 * m);
+    csr_row_norm(norms.data(), row_ind.data(), vals.data(), m,
+                 LinAlg::L1Norm, stream);
+    csr_row_norm(norms.data() + m, row_ind.data(), vals.data(), m,
+                 LinAlg::L2Norm, stream, SqrtOp<T>());
+    norm_exp.assign(2 * m, T(0));
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < k; j++) {
+        norm_exp[i] += std::abs(A[i + j * m]);
+        norm_exp[m + i] += A[i + j * m] * A[i + j * m];
+      }
+      norm_exp[m + i] = std::sqrt(norm_exp[m + i]);
+    }
+    norm_res.resize(2 * m);
+    updateHost(norm_res.data(), norms.data(), 2 * m, stream);
+
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUSPARSE_CHECK(cusparseDestroy(handle));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  SparseLinalgInputs<T> params;
+  std::vector<T> spmv_exp, spmv_res, spmm_exp, spmm_res;
+  std::vector<T> sddmm_exp, sddmm_res, norm_exp, norm_res;
+};
+
+template <typename T>
+::testing::AssertionResult match(const std::vector<T> &expected,
+                                 const std::vector<T> &actual, T tolerance) {
+  CompareApprox<T> eq(tolerance);
+  for (size_t i = 0; i < expected.size(); i++) {
+    if (!eq(expected[i], actual[i])) {
+      return ::testing::AssertionFailure()
+             << "actual=" << actual[i] << " != expected=" << expected[i]
+             << " @" << i;
+    }
+  }
+  return ::testing::AssertionSuccess();
+}
+
+const std::vector<SparseLinalgInputs<float>> inputsf = {
+  {50, 30, 7, 0.2f, 1e-4f, 1234ULL}, {100, 120, 16, 0.05f, 1e-4f, 42ULL}};
+typedef SparseLinalgTest<float> SparseLinalgTestF;
+TEST_P(SparseLinalgTestF, Result) {
+  ASSERT_TRUE(match(spmv_exp, spmv_res, params.tolerance));
+  ASSERT_TRUE(match(spmm_exp, spmm_res, params.tolerance));
+  ASSERT_TRUE(match(sddmm_exp, sddmm_res, params.tolerance));
+  ASSERT_TRUE(match(norm_exp, norm_res, params.tolerance));
+}
+INSTANTIATE_TEST_CASE_P(SparseLinalgTests, SparseLinalgTestF,
+                        ::testing::ValuesIn(inputsf));
+
+const std::vector<SparseLinalgInputs<double>> inputsd = {
+  {50, 30, 7, 0.2, 1e-10, 1234ULL}, {100, 120, 16, 0.05, 1e-10, 42ULL}};
+typedef SparseLinalgTest<double> SparseLinalgTestD;
+TEST_P(SparseLinalgTestD, Result) {
+  ASSERT_TRUE(match(spmv_exp, spmv_res, params.tolerance));
+  ASSERT_TRUE(match(spmm_exp, spmm_res, params.tolerance));
+  ASSERT_TRUE(match(sddmm_exp, sddmm_res, params.tolerance));
+  ASSERT_TRUE(match(norm_exp, norm_res, params.tolerance));
+}
+INSTANTIATE_TEST_CASE_P(SparseLinalgTests, SparseLinalgTestD,
+                        ::testing::ValuesIn(inputsd));
+
+};  // namespace Sparse
+};  // namespace MLCommon
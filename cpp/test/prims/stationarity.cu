@@ -33,6 +33,9 @@ struct StationarityParams {
   DataT scale;
   std::vector<DataT> inc_rates;
   std::vector<int> d_ref;
+  // The KPSS cases leave the test and max_d out, for KPSS with max_d=1
+  StationarityTestType test;
+  int max_d;
 };
 
 template <typename DataT>
@@ -84,9 +87,10 @@ class StationarityTest
 
     d_out = std::vector<int>(params.n_batches);
 
-    MLCommon::TimeSeries::stationarity(y_d, d_out.data(), params.n_batches,
-                                       params.n_samples, allocator, stream,
-                                       static_cast<DataT>(0.05));
+    int max_d = params.max_d > 0 ? params.max_d : 1;
+    MLCommon::TimeSeries::stationarity(
+      y_d, d_out.data(), params.n_batches, params.n_samples, allocator, stream,
+      static_cast<DataT>(0.05), params.test, max_d);
   }
 
   void TearDown() override {
@@ -109,6 +113,8 @@ class StationarityTest
  *  - odd series size
  *  - larger values
  *  - multiple large series
+ *  - ADF test, with trends 0 and 1 and up to d=2
+ *  - ADF test, larger values
  */
 const std::vector<struct StationarityParams<float>> params_float = {
   {2, 200, 1, {0.5f, 0.0f}, {1, 0}},
@@ -118,13 +124,16 @@ const std::vector<struct StationarityParams<float>> params_float = {
     7, 1000, 442, {0.3f, -1.7f, 0.0f, 0.4f, -0.4f, -4.2f, 1.3f}, {
       1, 1, 0, 1, 1, 1, 1
     }
-  }
+  },
+  {3, 200, 1, {5.0f, 0.0f, -8.0f}, {1, 0, 1}, ADF, 2},
+  {2, 300, 1234, {0.0f, 6.0f}, {0, 1}, ADF, 2}
 };
 
 /* The tests respectively check the following aspects:
  *  - multiple large series
  *  - almost stationary series
  *  - many small series
+ *  - ADF test, multiple large series
  */
 const std::vector<struct StationarityParams<double>> params_double = {
   {5, 1338, 277, {1.0, 0.5, -0.3, 0.0, 2.2}, {1, 1, 1, 0, 1}},
@@ -134,7 +143,8 @@ const std::vector<struct StationarityParams<double>> params_double = {
     {
       1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 1, 1, 1, 1, 1, 1, 0
     }
-  }
+  },
+  {4, 500, 10, {0.0, 10.0, -12.0, 0.0}, {0, 1, 1, 0}, ADF, 2}
 };
 
 typedef StationarityTest<float> StationarityTestF;
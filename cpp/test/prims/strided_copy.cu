@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "matrix/strided_copy.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace Matrix {
+
+struct StridedCopyInputs {
+  int rows, cols;
+  // strides of the input and of the output, in elements
+  int64_t inRowStride, inColStride, outRowStride, outColStride;
+  unsigned long long int seed;
+};
+
+::std::ostream &operator<<(::std::ostream &os, const StridedCopyInputs &dims) {
+  return os;
+}
+
+/**
+ * Copies between padded, transposed and sliced layouts, which go through
+ * the 2D memcpy or the tiled kernel, against the same copies on the host.
+ */
+class StridedCopyTest : public ::testing::TestWithParam<StridedCopyInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<StridedCopyInputs>::GetParam();
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+    size_t inLen = extent(params.inRowStride, params.inColStride);
+    size_t outLen = extent(params.outRowStride, params.outColStride);
+    std::default_random_engine gen(params.seed);
+    std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+    std::vector<float> in_h(inLen);
+    for (auto &v : in_h) v = uniform(gen);
+    // the elements outside of the matrix must be left as they are
+    out_exp.assign(outLen, -5.f);
+    for (int i = 0; i < params.rows; i++) {
+      for (int j = 0; j < params.cols; j++) {
+        out_exp[i * params.outRowStride + j * params.outColStride] =
+          in_h[i * params.inRowStride + j * params.inColStride];
+      }
+    }
+
+    device_buffer<float> in(alloc, stream, inLen), out(alloc, stream, outLen);
+    updateDevice(in.data(), in_h.data(), inLen, stream);
+    std::vector<float> init(outLen, -5.f);
+    updateDevice(out.data(), init.data(), outLen, stream);
+    stridedCopy(out.data(), params.outRowStride, params.outColStride,
+                in.data(), params.inRowStride, params.inColStride,
+                params.rows, params.cols, stream);
+    out_res.resize(outLen);
+    updateHost(out_res.data(), out.data(), outLen, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  // number of elements spanned by a matrix of the shape of the test
+  size_t extent(int64_t rowStride, int64_t colStride) const {
+    return size_t((params.rows - 1) * rowStride +
+                  (params.cols - 1) * colStride + 1);
+  }
+
+  StridedCopyInputs params;
+  std::vector<float> out_exp, out_res;
+};
+
+const std::vector<StridedCopyInputs> inputs = {
+  // padded row-major to row-major, and column-major to column-major
+  {1000, 33, 40, 1, 33, 1, 1234ULL},
+  {1000, 33, 1, 1024, 1, 1000, 1234ULL},
+  // transpositions
+  {1000, 33, 33, 1, 1, 1000, 1234ULL},
+  {1000, 33, 1, 1000, 33, 1, 1234ULL},
+  {31, 1025, 1, 40, 1025, 1, 1234ULL},
+  // every other row of a row-major matrix, and a column slice of it
+  {500, 33, 66, 1, 1, 500, 1234ULL},
+  {500, 16, 66, 2, 16, 1, 1234ULL}};
+
+TEST_P(StridedCopyTest, Result) {
+  for (size_t i = 0; i < out_exp.size(); i++) {
+    ASSERT_EQ(out_exp[i], out_res[i]) << " @" << i;
+  }
+}
+INSTANTIATE_TEST_CASE_P(StridedCopyTests, StridedCopyTest,
+                        ::testing::ValuesIn(inputs));
+
+}  // end namespace Matrix
+}  // end namespace MLCommon
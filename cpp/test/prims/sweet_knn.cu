@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cuda_utils.h>
+#include <gtest/gtest.h>
+#include <test_utils.h>
+#include <vector>
+#include "random/rng.h"
+#include "selection/knn.h"
+#include "selection/sweet_knn.h"
+
+namespace MLCommon {
+namespace Selection {
+
+struct SweetKnnInputs {
+  int n_index;
+  int n_query;
+  int d;
+  int k;
+  int n_reps;
+  bool rowMajorIndex;
+  bool rowMajorQuery;
+};
+
+::std::ostream &operator<<(::std::ostream &os, const SweetKnnInputs &dims) {
+  return os;
+}
+
+/**
+ * Checks the neighbors of sweet_knn_search against those of fused_knn,
+ * which compares each query to every index row.
+ */
+class SweetKnnTest : public ::testing::TestWithParam<SweetKnnInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<SweetKnnInputs>::GetParam();
+    int len = params.n_query * params.k;
+    auto alloc = std::make_shared<defaultDeviceAllocator>();
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    allocate(d_index, params.n_index * params.d);
+    allocate(d_query, params.n_query * params.d);
+    allocate(d_ref_D, len);
+    allocate<long>(d_ref_I, len);
+    allocate(d_pred_D, len);
+    allocate<long>(d_pred_I, len);
+    Random::Rng r(1234ULL);
+    r.uniform(d_index, params.n_index * params.d, -1.0f, 1.0f, stream);
+    r.uniform(d_query, params.n_query * params.d, -1.0f, 1.0f, stream);
+
+    fused_knn(d_index, params.n_index, params.rowMajorIndex, d_query,
+              params.n_query, params.rowMajorQuery, params.d, params.k,
+              METRIC_L2, 2.0f, d_ref_D, d_ref_I, stream);
+
+    SweetKnnIndex sweet(alloc, stream);
+    sweet_knn_build(&sweet, d_index, params.n_index, params.rowMajorIndex,
+                    params.d, params.n_reps, alloc, stream);
+    sweet_knn_search(sweet, d_query, params.n_query, params.rowMajorQuery,
+                     params.k, d_pred_D, d_pred_I, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(d_index));
+    CUDA_CHECK(cudaFree(d_query));
+    CUDA_CHECK(cudaFree(d_ref_D));
+    CUDA_CHECK(cudaFree(d_ref_I));
+    CUDA_CHECK(cudaFree(d_pred_D));
+    CUDA_CHECK(cudaFree(d_pred_I));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  SweetKnnInputs params;
+  cudaStream_t stream;
+  float *d_index, *d_query, *d_ref_D, *d_pred_D;
+  long *d_ref_I, *d_pred_I;
+};
+
+const std::vector<SweetKnnInputs> inputs = {
+  {3000, 500, 2, 1, 0, true, true},     {3000, 500, 3, 10, 0, false, true},
+  {3000, 500, 3, 10, 7, true, false},   {3000, 500, 8, 40, 0, false, false},
+  {5000, 300, 16, 100, 100, true, true}, {100, 50, 4, 100, 0, true, true}};
+
+TEST_P(SweetKnnTest, Neighbors) {
+  int len = params.n_query * params.k;
+  ASSERT_TRUE(devArrMatch(d_ref_D, d_pred_D, len, CompareApprox<float>(1e-4)));
+  ASSERT_TRUE(devArrMatch(d_ref_I, d_pred_I, len, Compare<long>()));
+}
+
+INSTANTIATE_TEST_CASE_P(SweetKnnTests, SweetKnnTest,
+                        ::testing::ValuesIn(inputs));
+
+};  // end namespace Selection
+};  // end namespace MLCommon
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include "cuda_utils.h"
+#include "linalg/qr.h"
+#include "linalg/tsqr.h"
+#include "random/rng.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace LinAlg {
+
+template <typename T>
+struct TsqrInputs {
+  T tolerance;
+  int n_row;
+  int n_col;
+  int block_rows;
+  unsigned long long int seed;
+};
+
+template <typename T>
+::std::ostream &operator<<(::std::ostream &os, const TsqrInputs<T> &dims) {
+  return os;
+}
+
+template <typename T>
+class TsqrTest : public ::testing::TestWithParam<TsqrInputs<T>> {
+ protected:
+  void SetUp() override {
+    CUSOLVER_CHECK(cusolverDnCreate(&cusolverH));
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> allocator(new defaultDeviceAllocator);
+
+    params = ::testing::TestWithParam<TsqrInputs<T>>::GetParam();
+    Random::Rng r(params.seed);
+    int m = params.n_row, n = params.n_col;
+
+    allocate(data, m * n);
+    allocate(Q_ref, m * n);
+    allocate(R_ref, n * n, true);
+    allocate(R, n * n);
+    r.uniform(data, m * n, T(-1.0), T(1.0), stream);
+
+    qrGetQR(data, Q_ref, R_ref, m, n, cusolverH, stream, allocator);
+    tsqrGetR(data, R, m, n, params.block_rows, cusolverH, stream, allocator);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(data));
+    CUDA_CHECK(cudaFree(Q_ref));
+    CUDA_CHECK(cudaFree(R_ref));
+    CUDA_CHECK(cudaFree(R));
+    CUSOLVER_CHECK(cusolverDnDestroy(cusolverH));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  TsqrInputs<T> params;
+  T *data, *Q_ref, *R_ref, *R;
+  cusolverDnHandle_t cusolverH = NULL;
+  cudaStream_t stream;
+};
+
+// a single block, a single reduction and a reduction tree of two levels
+const std::vector<TsqrInputs<float>> inputsf = {{0.001f, 30, 5, 32, 1234ULL},
+                                                {0.001f, 500, 5, 64, 1234ULL},
+                                                {0.001f, 4000, 8, 16, 1234ULL}};
+
+const std::vector<TsqrInputs<double>> inputsd = {
+  {0.00001, 30, 5, 32, 1234ULL},
+  {0.00001, 500, 5, 64, 1234ULL},
+  {0.00001, 4000, 8, 16, 1234ULL}};
+
+// the rows of R are only defined up to their signs
+typedef TsqrTest<float> TsqrTestF;
+TEST_P(TsqrTestF, Result) {
+  ASSERT_TRUE(devArrMatch(R_ref, R, params.n_col * params.n_col,
+                          CompareApproxAbs<float>(params.tolerance)));
+}
+
+typedef TsqrTest<double> TsqrTestD;
+TEST_P(TsqrTestD, Result) {
+  ASSERT_TRUE(devArrMatch(R_ref, R, params.n_col * params.n_col,
+                          CompareApproxAbs<double>(params.tolerance)));
+}
+
+INSTANTIATE_TEST_CASE_P(TsqrTests, TsqrTestF, ::testing::ValuesIn(inputsf));
+
+INSTANTIATE_TEST_CASE_P(TsqrTests, TsqrTestD, ::testing::ValuesIn(inputsd));
+
+}  // end namespace LinAlg
+}  // end namespace MLCommon
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "common/device_buffer.hpp"
+#include "cuda_utils.h"
+#include "linalg/binary_op.h"
+#include "linalg/vectorized_map.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace LinAlg {
+
+struct VectorizedMapInputs {
+  int len;
+  // offsets in elements of the views of the output and of the inputs
+  int outOffset, inOffset1, inOffset2;
+  unsigned long long int seed;
+};
+
+::std::ostream &operator<<(::std::ostream &os,
+                           const VectorizedMapInputs &dims) {
+  return os;
+}
+
+// Or else, we get the following compilation error
+// for an extended __device__ lambda cannot have private or protected access
+// within its class
+void vectorizedMapLaunch(double *out3, float *out2, const float *in1,
+                         const float *in2, const int8_t *in3, int len,
+                         cudaStream_t stream) {
+  vectorizedMap(
+    out3, len,
+    [] __device__(float a, float b, int8_t c) {
+      return double(a) * double(b) + double(c);
+    },
+    stream, in1, in2, in3);
+  binaryOp(
+    out2, in1, in2, len, [] __device__(float a, float b) { return a - b; },
+    stream);
+}
+
+/**
+ * Views at any offsets and of any length, so that the head and tail peeling
+ * and the narrowing of the vectors for mutually misaligned views all run,
+ * against the same operations on the host.
+ */
+class VectorizedMapTest
+  : public ::testing::TestWithParam<VectorizedMapInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<VectorizedMapInputs>::GetParam();
+    int len = params.len;
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    std::shared_ptr<deviceAllocator> alloc(new defaultDeviceAllocator);
+
+    std::default_random_engine gen(params.seed);
+    std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+    std::uniform_int_distribution<int> small(-100, 100);
+    std::vector<float> in1_h(len), in2_h(len);
+    std::vector<int8_t> in3_h(len);
+    for (int i = 0; i < len; i++) {
+      in1_h[i] = uniform(gen);
+      in2_h[i] = uniform(gen);
+      in3_h[i] = int8_t(small(gen));
+    }
+    out3_exp.resize(len);
+    out2_exp.resize(len);
+    for (int i = 0; i < len; i++) {
+      out3_exp[i] = double(in1_h[i]) * double(in2_h[i]) + double(in3_h[i]);
+      out2_exp[i] = in1_h[i] - in2_h[i];
+    }
+
+    int pad = 16;
+    device_buffer<float> in1(alloc, stream, len + pad);
+    device_buffer<float> in2(alloc, stream, len + pad);
+    device_buffer<int8_t> in3(alloc, stream, len + pad);
+    device_buffer<double> out3(alloc, stream, len + pad);
+    device_buffer<float> out2(alloc, stream, len + pad);
+    float *pIn1 = in1.data() + params.inOffset1;
+    float *pIn2 = in2.data() + params.inOffset2;
+    int8_t *pIn3 = in3.data() + params.inOffset1;
+    double *pOut3 = out3.data() + params.outOffset;
+    float *pOut2 = out2.data() + params.outOffset;
+    updateDevice(pIn1, in1_h.data(), len, stream);
+    updateDevice(pIn2, in2_h.data(), len, stream);
+    updateDevice(pIn3, in3_h.data(), len, stream);
+    vectorizedMapLaunch(pOut3, pOut2, pIn1, pIn2, pIn3, len, stream);
+    out3_res.resize(len);
+    out2_res.resize(len);
+    updateHost(out3_res.data(), pOut3, len, stream);
+    updateHost(out2_res.data(), pOut2, len, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  VectorizedMapInputs params;
+  std::vector<double> out3_exp, out3_res;
+  std::vector<float> out2_exp, out2_res;
+};
+
+const std::vector<VectorizedMapInputs> inputs = {
+  {1024 * 1024, 0, 0, 0, 1234ULL}, {1024 * 1024 + 7, 3, 3, 3, 1234ULL},
+  {1000001, 1, 1, 3, 1234ULL},     {1000001, 0, 2, 2, 1234ULL},
+  {5, 1, 1, 1, 1234ULL},           {33, 15, 7, 15, 1234ULL}};
+typedef VectorizedMapTest VectorizedMapTestF;
+TEST_P(VectorizedMapTestF, Result) {
+  for (int i = 0; i < params.len; i++) {
+    ASSERT_EQ(out3_exp[i], out3_res[i]) << " @" << i;
+    ASSERT_EQ(out2_exp[i], out2_res[i]) << " @" << i;
+  }
+}
+INSTANTIATE_TEST_CASE_P(VectorizedMapTests, VectorizedMapTestF,
+                        ::testing::ValuesIn(inputs));
+
+}  // end namespace LinAlg
+}  // end namespace MLCommon
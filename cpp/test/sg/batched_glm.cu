@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuda_utils.h>
+#include <gtest/gtest.h>
+#include <test_utils.h>
+#include <vector>
+#include "glm/batched.h"
+#include "glm/ridge.h"
+#include "ml_utils.h"
+
+namespace ML {
+namespace GLM {
+
+using namespace MLCommon;
+
+template <typename T>
+struct BatchedGlmInputs {
+  T tol;
+  int n_row;
+  int n_batches;
+  int algo;
+};
+
+template <typename T>
+class BatchedGlmTest : public ::testing::TestWithParam<BatchedGlmInputs<T>> {
+ protected:
+  void basicTest() {
+    params = ::testing::TestWithParam<BatchedGlmInputs<T>>::GetParam();
+    int n_row = params.n_row, n_batches = params.n_batches;
+    int len = n_row * n_col * n_batches;
+
+    allocate(data, len);
+    allocate(labels, n_row * n_batches);
+    allocate(coef, n_col * n_batches);
+    allocate(coef_ref, n_col * n_batches);
+    allocate(intercept, n_batches);
+    allocate(intercept_ref, n_batches);
+    allocate(pred, n_row * n_batches);
+    allocate(coef2, n_col * n_batches);
+    allocate(coef2_ref, n_col * n_batches);
+    allocate(intercept2, n_batches);
+    allocate(intercept2_ref, n_batches);
+
+    // noise free models of a few distinct coefficients and intercepts
+    std::vector<T> data_h(len), labels_h(n_row * n_batches);
+    std::vector<T> coef_ref_h(n_col * n_batches), intercept_ref_h(n_batches);
+    for (int b = 0; b < n_batches; b++) {
+      coef_ref_h[b * n_col] = T(b % 5 + 1);
+      coef_ref_h[b * n_col + 1] = T(2) - T(b % 3) / 2;
+      intercept_ref_h[b] = T(b % 4);
+      for (int i = 0; i < n_row; i++) {
+        T x1 = T(i) / n_row;
+        T x2 = T((i * i + b) % 7) / 7;
+        data_h[b * n_row * n_col + i] = x1;
+        data_h[b * n_row * n_col + n_row + i] = x2;
+        labels_h[b * n_row + i] = coef_ref_h[b * n_col] * x1 +
+                                  coef_ref_h[b * n_col + 1] * x2 +
+                                  intercept_ref_h[b];
+      }
+    }
+    updateDevice(data, data_h.data(), len, stream);
+    updateDevice(labels, labels_h.data(), n_row * n_batches, stream);
+    updateDevice(coef_ref, coef_ref_h.data(), n_col * n_batches, stream);
+    updateDevice(intercept_ref, intercept_ref_h.data(), n_batches, stream);
+
+    olsFitBatched(handle.getImpl(), data, n_row, n_col, n_batches, labels, coef,
+                  intercept, true, stream, params.algo);
+    linearPredictBatched(handle.getImpl(), data, n_row, n_col, n_batches, coef,
+                         intercept, pred, stream);
+
+    // the reference ridge models are fitted one at a time
+    T alpha = T(0.5);
+    std::vector<T> intercept2_ref_h(n_batches);
+    for (int b = 0; b < n_batches; b++) {
+      ridgeFit(handle.getImpl(), data + b * n_row * n_col, n_row, n_col,
+               labels + b * n_row, &alpha, 1, coef2_ref + b * n_col,
+               &intercept2_ref_h[b], true, false, stream);
+    }
+    updateDevice(intercept2_ref, intercept2_ref_h.data(), n_batches, stream);
+
+    ridgeFitBatched(handle.getImpl(), data, n_row, n_col, n_batches, labels,
+                    alpha, coef2, intercept2, true, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void SetUp() override {
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    handle.setStream(stream);
+    basicTest();
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(data));
+    CUDA_CHECK(cudaFree(labels));
+    CUDA_CHECK(cudaFree(coef));
+    CUDA_CHECK(cudaFree(coef_ref));
+    CUDA_CHECK(cudaFree(intercept));
+    CUDA_CHECK(cudaFree(intercept_ref));
+    CUDA_CHECK(cudaFree(pred));
+    CUDA_CHECK(cudaFree(coef2));
+    CUDA_CHECK(cudaFree(coef2_ref));
+    CUDA_CHECK(cudaFree(intercept2));
+    CUDA_CHECK(cudaFree(intercept2_ref));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  static const int n_col = 2;
+  BatchedGlmInputs<T> params;
+  T *data, *labels, *coef, *coef_ref, *intercept, *intercept_ref, *pred;
+  T *coef2, *coef2_ref, *intercept2, *intercept2_ref;
+  cumlHandle handle;
+  cudaStream_t stream;
+};
+
+const std::vector<BatchedGlmInputs<float>> inputsf2 = {
+  {0.001f, 20, 5, 0}, {0.001f, 20, 5, 1}, {0.001f, 100, 300, 0}};
+
+const std::vector<BatchedGlmInputs<double>> inputsd2 = {
+  {0.00001, 20, 5, 0}, {0.00001, 20, 5, 1}, {0.00001, 100, 300, 1}};
+
+typedef BatchedGlmTest<float> BatchedGlmTestF;
+TEST_P(BatchedGlmTestF, Fit) {
+  int n_batches = params.n_batches;
+  ASSERT_TRUE(devArrMatch(coef_ref, coef, n_col * n_batches,
+                          CompareApproxAbs<float>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(intercept_ref, intercept, n_batches,
+                          CompareApproxAbs<float>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(labels, pred, params.n_row * n_batches,
+                          CompareApproxAbs<float>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(coef2_ref, coef2, n_col * n_batches,
+                          CompareApproxAbs<float>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(intercept2_ref, intercept2, n_batches,
+                          CompareApproxAbs<float>(params.tol)));
+}
+
+typedef BatchedGlmTest<double> BatchedGlmTestD;
+TEST_P(BatchedGlmTestD, Fit) {
+  int n_batches = params.n_batches;
+  ASSERT_TRUE(devArrMatch(coef_ref, coef, n_col * n_batches,
+                          CompareApproxAbs<double>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(intercept_ref, intercept, n_batches,
+                          CompareApproxAbs<double>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(labels, pred, params.n_row * n_batches,
+                          CompareApproxAbs<double>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(coef2_ref, coef2, n_col * n_batches,
+                          CompareApproxAbs<double>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(intercept2_ref, intercept2, n_batches,
+                          CompareApproxAbs<double>(params.tol)));
+}
+
+INSTANTIATE_TEST_CASE_P(BatchedGlmTests, BatchedGlmTestF,
+                        ::testing::ValuesIn(inputsf2));
+
+INSTANTIATE_TEST_CASE_P(BatchedGlmTests, BatchedGlmTestD,
+                        ::testing::ValuesIn(inputsd2));
+
+}  // namespace GLM
+}  // end namespace ML
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <test_utils.h>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "common/cumlHandle.hpp"
+#include "kalman_filter/KalmanFilter.cuh"
+#include "kalman_filter/batched_lkf.h"
+
+namespace kf {
+namespace linear {
+
+using namespace MLCommon;
+
+template <typename T>
+struct BatchedLKFInputs {
+  T tolerance;
+  int batch_size, iterations;
+  unsigned long long int seed;
+};
+
+template <typename T>
+::std::ostream &operator<<(::std::ostream &os,
+                           const BatchedLKFInputs<T> &dims) {
+  return os;
+}
+
+// The constant velocity model of the LKF test, a filter per series of noisy
+// positions. Each filter is also run alone with the short explicit form
+template <typename T>
+class BatchedLKFTest : public ::testing::TestWithParam<BatchedLKFInputs<T>> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<BatchedLKFInputs<T>>::GetParam();
+    int B = params.batch_size;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    handle.setStream(stream);
+    auto allocator = handle.getDeviceAllocator();
+    auto cublas_handle = handle.getImpl().getCublasHandle();
+    auto cusolver_handle = handle.getImpl().getcusolverDnHandle();
+
+    T var = 0.001;
+    std::vector<T> x0 = {0.0, 1.0}, Phi = {1.0, 0.0, 1.0, 1.0};
+    std::vector<T> P0 = {100.0, 0.0, 0.0, 100.0}, R = {100.0};
+    std::vector<T> Q = {T(0.25) * var, T(0.5) * var, T(0.5) * var,
+                        T(1.1) * var};
+    std::vector<T> H = {1.0, 0.0};
+    auto replicate = [B](const std::vector<T> &v) {
+      std::vector<T> out;
+      for (int b = 0; b < B; b++) out.insert(out.end(), v.begin(), v.end());
+      return out;
+    };
+
+    BatchedMatrix<T> bPhi(2, 2, B, cublas_handle, allocator, stream);
+    BatchedMatrix<T> bQ(2, 2, B, cublas_handle, allocator, stream);
+    BatchedMatrix<T> bH(1, 2, B, cublas_handle, allocator, stream);
+    BatchedMatrix<T> bR(1, 1, B, cublas_handle, allocator, stream);
+    BatchedMatrix<T> bx(2, 1, B, cublas_handle, allocator, stream);
+    BatchedMatrix<T> bP(2, 2, B, cublas_handle, allocator, stream);
+    BatchedMatrix<T> bz(1, 1, B, cublas_handle, allocator, stream);
+    updateDevice(bPhi.raw_data(), replicate(Phi).data(), 4 * B, stream);
+    updateDevice(bQ.raw_data(), replicate(Q).data(), 4 * B, stream);
+    updateDevice(bH.raw_data(), replicate(H).data(), 2 * B, stream);
+    updateDevice(bR.raw_data(), replicate(R).data(), B, stream);
+    updateDevice(bx.raw_data(), replicate(x0).data(), 2 * B, stream);
+    updateDevice(bP.raw_data(), replicate(P0).data(), 4 * B, stream);
+
+    std::default_random_engine generator(params.seed);
+    std::normal_distribution<T> distribution(0.0, 1.0);
+    std::vector<T> z(params.iterations * B);
+    for (auto &zi : z) zi = distribution(generator);
+    rmse_x = 0.0;
+    std::vector<T> x_h(2 * B);
+    for (int q = 0; q < params.iterations; q++) {
+      for (int b = 0; b < B; b++) z[q * B + b] += q;
+      batched_predict(bPhi, bQ, bx, bP);
+      updateDevice(bz.raw_data(), z.data() + q * B, B, stream);
+      batched_update(bH, bR, bz, bx, bP);
+      updateHost(x_h.data(), bx.raw_data(), 2 * B, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+      for (int b = 0; b < B; b++) rmse_x += pow(x_h[2 * b] - q, 2);
+    }
+    rmse_x = pow(rmse_x / (params.iterations * B), 0.5);
+    allocate(x_batched, 2 * B);
+    allocate(P_batched, 4 * B);
+    copy(x_batched, bx.raw_data(), 2 * B, stream);
+    copy(P_batched, bP.raw_data(), 4 * B, stream);
+
+    // the filters one by one
+    allocate(x_ref, 2 * B);
+    allocate(P_ref, 4 * B);
+    T *x_est_d, *x_up_d, *Phi_d, *P_est_d, *P_up_d, *Q_d, *R_d, *H_d, *z_d;
+    allocate(x_est_d, 2);
+    allocate(x_up_d, 2);
+    allocate(Phi_d, 4);
+    allocate(P_est_d, 4);
+    allocate(P_up_d, 4);
+    allocate(Q_d, 4);
+    allocate(R_d, 1);
+    allocate(H_d, 2);
+    allocate(z_d, 1);
+    updateDevice(Phi_d, Phi.data(), 4, stream);
+    updateDevice(R_d, R.data(), 1, stream);
+    updateDevice(H_d, H.data(), 2, stream);
+    for (int b = 0; b < B; b++) {
+      updateDevice(x_up_d, x0.data(), 2, stream);
+      updateDevice(P_up_d, P0.data(), 4, stream);
+      Variables<T> vars;
+      size_t workspaceSize;
+      void *workspace;
+      init(vars, 2, 1, ShortFormExplicit, x_est_d, x_up_d, Phi_d, P_est_d,
+           P_up_d, Q_d, R_d, H_d, nullptr, workspaceSize, cusolver_handle);
+      CUDA_CHECK(cudaMalloc(&workspace, workspaceSize));
+      init(vars, 2, 1, ShortFormExplicit, x_est_d, x_up_d, Phi_d, P_est_d,
+           P_up_d, Q_d, R_d, H_d, workspace, workspaceSize, cusolver_handle);
+      for (int q = 0; q < params.iterations; q++) {
+        // predict uses Q as a scratch buffer
+        updateDevice(Q_d, Q.data(), 4, stream);
+        predict(vars, cublas_handle, stream);
+        updateDevice(z_d, z.data() + q * B + b, 1, stream);
+        update(vars, z_d, cublas_handle, cusolver_handle, stream);
+      }
+      copy(x_ref + 2 * b, x_up_d, 2, stream);
+      copy(P_ref + 4 * b, P_up_d, 4, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+      CUDA_CHECK(cudaFree(workspace));
+    }
+    CUDA_CHECK(cudaFree(x_est_d));
+    CUDA_CHECK(cudaFree(x_up_d));
+    CUDA_CHECK(cudaFree(Phi_d));
+    CUDA_CHECK(cudaFree(P_est_d));
+    CUDA_CHECK(cudaFree(P_up_d));
+    CUDA_CHECK(cudaFree(Q_d));
+    CUDA_CHECK(cudaFree(R_d));
+    CUDA_CHECK(cudaFree(H_d));
+    CUDA_CHECK(cudaFree(z_d));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(x_batched));
+    CUDA_CHECK(cudaFree(P_batched));
+    CUDA_CHECK(cudaFree(x_ref));
+    CUDA_CHECK(cudaFree(P_ref));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  BatchedLKFInputs<T> params;
+  ML::cumlHandle handle;
+  cudaStream_t stream;
+  T *x_batched, *P_batched, *x_ref, *P_ref;
+  T rmse_x;
+};
+
+const std::vector<BatchedLKFInputs<float>> inputsf = {{1.5f, 10, 100, 6ULL}};
+typedef BatchedLKFTest<float> BatchedLKFTestF;
+TEST_P(BatchedLKFTestF, Result) {
+  EXPECT_LT(rmse_x, params.tolerance) << " position out of tol.";
+  ASSERT_TRUE(devArrMatch(x_ref, x_batched, 2 * params.batch_size,
+                          CompareApprox<float>(1e-3)));
+  ASSERT_TRUE(devArrMatch(P_ref, P_batched, 4 * params.batch_size,
+                          CompareApprox<float>(1e-3)));
+}
+INSTANTIATE_TEST_CASE_P(BatchedLKFTests, BatchedLKFTestF,
+                        ::testing::ValuesIn(inputsf));
+
+const std::vector<BatchedLKFInputs<double>> inputsd = {{1.5, 10, 100, 6ULL}};
+typedef BatchedLKFTest<double> BatchedLKFTestD;
+TEST_P(BatchedLKFTestD, Result) {
+  EXPECT_LT(rmse_x, params.tolerance) << " position out of tol.";
+  ASSERT_TRUE(devArrMatch(x_ref, x_batched, 2 * params.batch_size,
+                          CompareApprox<double>(1e-8)));
+  ASSERT_TRUE(devArrMatch(P_ref, P_batched, 4 * params.batch_size,
+                          CompareApprox<double>(1e-8)));
+}
+INSTANTIATE_TEST_CASE_P(BatchedLKFTests, BatchedLKFTestD,
+                        ::testing::ValuesIn(inputsd));
+
+};  // end namespace linear
+};  // end namespace kf
@@ -48,6 +48,9 @@ class CdTest : public ::testing::TestWithParam<CdInputs<T>> {
     allocate(coef2, params.n_col, true);
     allocate(coef3, params.n_col, true);
     allocate(coef4, params.n_col, true);
+    allocate(coef5, params.n_col, true);
+    allocate(coef6, params.n_col, true);
+    allocate(coef_path, 2 * params.n_col, true);
     allocate(coef_ref, params.n_col, true);
     allocate(coef2_ref, params.n_col, true);
     allocate(coef3_ref, params.n_col, true);
@@ -105,6 +108,29 @@ class CdTest : public ::testing::TestWithParam<CdInputs<T>> {
     cdFit(handle.getImpl(), data, params.n_row, params.n_col, labels, coef4,
           &intercept2, fit_intercept, normalize, epochs, loss, alpha, l1_ratio,
           shuffle, tol, stream);
+
+    // the fits of coef and coef4, with the precomputed Gram matrix
+    bool precompute_gram = true;
+    T intercept3 = T(0);
+    cdFit(handle.getImpl(), data, params.n_row, params.n_col, labels, coef6,
+          &intercept3, fit_intercept, normalize, epochs, loss, alpha, l1_ratio,
+          shuffle, tol, stream, precompute_gram);
+
+    alpha = T(0.2);
+    l1_ratio = T(1.0);
+    fit_intercept = false;
+    normalize = false;
+    cdFit(handle.getImpl(), data, params.n_row, params.n_col, labels, coef5,
+          &intercept3, fit_intercept, normalize, epochs, loss, alpha, l1_ratio,
+          shuffle, tol, stream, precompute_gram);
+
+    // a lasso path ending with the fit of coef2
+    fit_intercept = true;
+    T alphas[2] = {T(1.0), alpha};
+    T intercepts[2];
+    cdFitPath(handle.getImpl(), data, params.n_row, params.n_col, labels,
+              alphas, 2, coef_path, intercepts, fit_intercept, normalize,
+              epochs, loss, l1_ratio, shuffle, tol, stream);
   }
 
   void SetUp() override {
@@ -124,6 +150,9 @@ class CdTest : public ::testing::TestWithParam<CdInputs<T>> {
     CUDA_CHECK(cudaFree(coef3_ref));
     CUDA_CHECK(cudaFree(coef4));
     CUDA_CHECK(cudaFree(coef4_ref));
+    CUDA_CHECK(cudaFree(coef5));
+    CUDA_CHECK(cudaFree(coef6));
+    CUDA_CHECK(cudaFree(coef_path));
     CUDA_CHECK(cudaStreamDestroy(stream));
   }
 
@@ -133,6 +162,7 @@ class CdTest : public ::testing::TestWithParam<CdInputs<T>> {
   T *coef2, *coef2_ref;
   T *coef3, *coef3_ref;
   T *coef4, *coef4_ref;
+  T *coef5, *coef6, *coef_path;
   T intercept, intercept2;
   cudaStream_t stream;
   cumlHandle handle;
@@ -155,6 +185,15 @@ TEST_P(CdTestF, Fit) {
 
   ASSERT_TRUE(devArrMatch(coef4_ref, coef4, params.n_col,
                           CompareApproxAbs<float>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(coef_ref, coef5, params.n_col,
+                          CompareApproxAbs<float>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(coef4_ref, coef6, params.n_col,
+                          CompareApproxAbs<float>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(coef2_ref, coef_path + params.n_col, params.n_col,
+                          CompareApproxAbs<float>(params.tol)));
 }
 
 typedef CdTest<double> CdTestD;
@@ -170,6 +209,15 @@ TEST_P(CdTestD, Fit) {
 
   ASSERT_TRUE(devArrMatch(coef4_ref, coef4, params.n_col,
                           CompareApproxAbs<double>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(coef_ref, coef5, params.n_col,
+                          CompareApproxAbs<double>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(coef4_ref, coef6, params.n_col,
+                          CompareApproxAbs<double>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(coef2_ref, coef_path + params.n_col, params.n_col,
+                          CompareApproxAbs<double>(params.tol)));
 }
 
 INSTANTIATE_TEST_CASE_P(CdTests, CdTestF, ::testing::ValuesIn(inputsf2));
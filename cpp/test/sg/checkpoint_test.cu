@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <cuml/cluster/kmeans.hpp>
+#include <string>
+#include "common/checkpoint.hpp"
+#include "common/cumlHandle.hpp"
+#include "common/device_buffer.hpp"
+#include "random/make_blobs.h"
+#include "random/rng.h"
+#include "single_rank_comms.h"
+#include "test_utils.h"
+
+namespace ML {
+
+using namespace MLCommon;
+
+class CheckpointTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    stream = handle.getStream();
+    path = "/tmp/cuml_checkpoint_test_" + std::to_string(getpid());
+    remove(path.c_str());
+  }
+
+  void TearDown() override { remove(path.c_str()); }
+
+  cumlHandle handle;
+  cudaStream_t stream;
+  std::string path;
+  const int n = 1000;
+};
+
+TEST_F(CheckpointTest, SaveLoad) {
+  auto allocator = handle.getImpl().getDeviceAllocator();
+  device_buffer<float> x(allocator, stream, n), y(allocator, stream, n);
+  Random::Rng r(1234ULL);
+  r.uniform(x.data(), n, -1.f, 1.f, stream);
+  int iteration = 0;
+  ASSERT_FALSE(
+    loadCheckpoint(path, 1, y.data(), n * sizeof(float), &iteration, stream));
+  {
+    checkpointWriter writer(path, 1);
+    ASSERT_TRUE(writer.save(x.data(), n * sizeof(float), 7, stream));
+    writer.wait();
+  }
+  ASSERT_TRUE(
+    loadCheckpoint(path, 1, y.data(), n * sizeof(float), &iteration, stream));
+  ASSERT_EQ(7, iteration);
+  ASSERT_TRUE(devArrMatch(x.data(), y.data(), n, Compare<float>()));
+  // the snapshot of another fit
+  ASSERT_THROW(
+    loadCheckpoint(path, 2, y.data(), n * sizeof(float), &iteration, stream),
+    MLCommon::Exception);
+  ASSERT_THROW(loadCheckpoint(path, 1, y.data(), (n - 1) * sizeof(float),
+                              &iteration, stream),
+               MLCommon::Exception);
+}
+
+TEST_F(CheckpointTest, LastSnapshot) {
+  auto allocator = handle.getImpl().getDeviceAllocator();
+  device_buffer<int> x(allocator, stream, n), y(allocator, stream, n);
+  checkpointWriter writer(path, 3);
+  for (int it = 1; it <= 4; ++it) {
+    CUDA_CHECK(cudaMemsetAsync(x.data(), it, n * sizeof(int), stream));
+    // a snapshot may be skipped while the previous one is being written
+    if (!writer.save(x.data(), n * sizeof(int), it, stream)) {
+      writer.wait();
+      ASSERT_TRUE(writer.save(x.data(), n * sizeof(int), it, stream));
+    }
+  }
+  writer.wait();
+  int iteration = 0;
+  ASSERT_TRUE(
+    loadCheckpoint(path, 3, y.data(), n * sizeof(int), &iteration, stream));
+  ASSERT_EQ(4, iteration);
+  ASSERT_TRUE(devArrMatch(x.data(), y.data(), n, Compare<int>()));
+}
+
+// A distributed k-means stopped after its checkpoint, then resumed from it,
+// ends with the centroids of a fit which was not interrupted
+TEST_F(CheckpointTest, KMeansResume) {
+  const int n_samples = 5000, n_features = 8, n_clusters = 10;
+  const int max_iter = 10, stop_iter = 4;
+  initSingleRankComms(handle);
+  auto allocator = handle.getImpl().getDeviceAllocator();
+  device_buffer<float> X(allocator, stream, n_samples * n_features);
+  device_buffer<int> blobLabels(allocator, stream, n_samples);
+  Random::make_blobs<float, int>(X.data(), blobLabels.data(), n_samples,
+                                 n_features, n_clusters, allocator, stream);
+  device_buffer<float> full(allocator, stream, n_clusters * n_features);
+  device_buffer<float> resumed(allocator, stream, n_clusters * n_features);
+  copy(full.data(), X.data(), n_clusters * n_features, stream);
+  copy(resumed.data(), X.data(), n_clusters * n_features, stream);
+
+  // no early stop, so that both fits run all the iterations
+  kmeans::KMeansParams params;
+  params.n_clusters = n_clusters;
+  params.init = kmeans::KMeansParams::Array;
+  params.tol = 0;
+  params.max_iter = max_iter;
+  float full_inertia, resumed_inertia;
+  int full_n_iter, resumed_n_iter;
+  kmeans::fit_mg(handle, params, X.data(), n_samples, n_features, full.data(),
+                 full_inertia, full_n_iter);
+
+  // preempted after stop_iter iterations, with a single checkpoint written
+  // at the end, which may thus not be skipped
+  params.checkpoint_path = path;
+  params.checkpoint_interval = stop_iter;
+  params.max_iter = stop_iter;
+  kmeans::fit_mg(handle, params, X.data(), n_samples, n_features,
+                 resumed.data(), resumed_inertia, resumed_n_iter);
+  ASSERT_EQ(stop_iter, resumed_n_iter);
+  ASSERT_EQ(0, access(path.c_str(), F_OK));
+
+  // the initial centroids are ignored when resuming
+  CUDA_CHECK(cudaMemsetAsync(resumed.data(), 0,
+                             resumed.size() * sizeof(float), stream));
+  params.checkpoint_interval = 0;
+  params.max_iter = max_iter;
+  params.resume = true;
+  kmeans::fit_mg(handle, params, X.data(), n_samples, n_features,
+                 resumed.data(), resumed_inertia, resumed_n_iter);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  ASSERT_EQ(full_n_iter, resumed_n_iter);
+  ASSERT_TRUE(devArrMatch(full.data(), resumed.data(), full.size(),
+                          CompareApprox<float>(1e-4)));
+  ASSERT_NEAR(full_inertia, resumed_inertia, 1e-4 * full_inertia);
+}
+
+}  // end namespace ML
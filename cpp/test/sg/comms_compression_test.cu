@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "common/compressed_allreduce.h"
+#include "common/cumlHandle.hpp"
+#include "common/device_buffer.hpp"
+#include "random/rng.h"
+#include "single_rank_comms.h"
+
+namespace MLCommon {
+
+class CompressedAllreduceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    comm = makeSingleRankCommunicator();
+    stream = handle.getStream();
+    x_h.resize(n);
+    device_buffer<float> x(handle.getImpl().getDeviceAllocator(), stream, n);
+    // beyond the range of half, so that the values must be scaled
+    Random::Rng r(1234ULL);
+    r.uniform(x.data(), n, -1.e5f, 1.e5f, stream);
+    updateHost(x_h.data(), x.data(), n, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    for (float v : x_h) maxAbs = std::max(maxAbs, std::abs(v));
+  }
+
+  // the sums over n_calls of the outputs minus n_calls times the input
+  std::vector<double> totalErrors(bool error_feedback, int n_calls) {
+    auto allocator = handle.getImpl().getDeviceAllocator();
+    device_buffer<float> x(allocator, stream, n), y(allocator, stream, n);
+    updateDevice(x.data(), x_h.data(), n, stream);
+    compressedAllreduce<float> compressed(*comm, allocator, n, stream,
+                                          error_feedback);
+    std::vector<double> errors(n, 0.0);
+    std::vector<float> y_h(n);
+    for (int c = 0; c < n_calls; ++c) {
+      compressed.allreduce(x.data(), y.data(), stream);
+      updateHost(y_h.data(), y.data(), n, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+      for (int i = 0; i < n; ++i) errors[i] += double(y_h[i]) - x_h[i];
+    }
+    return errors;
+  }
+
+  static double maxOf(const std::vector<double>& v) {
+    double m = 0.0;
+    for (double e : v) m = std::max(m, std::abs(e));
+    return m;
+  }
+
+  ML::cumlHandle handle;
+  std::shared_ptr<cumlCommunicator> comm;
+  cudaStream_t stream;
+  const int n = 4096;
+  std::vector<float> x_h;
+  float maxAbs = 0.f;
+};
+
+TEST_F(CompressedAllreduceTest, RoundsToHalf) {
+  // half has 11 significant bits, relative to the largest magnitude
+  double err = maxOf(totalErrors(false, 1));
+  ASSERT_LE(err, maxAbs * std::ldexp(1.0, -10));
+  ASSERT_GT(err, 0.0);
+}
+
+TEST_F(CompressedAllreduceTest, ErrorFeedback) {
+  const int n_calls = 32;
+  double withoutFeedback = maxOf(totalErrors(false, n_calls));
+  double withFeedback = maxOf(totalErrors(true, n_calls));
+  // the rounding errors add up without feedback, while with feedback the
+  // total error stays that of a single call
+  ASSERT_LE(withFeedback, maxAbs * std::ldexp(1.0, -9));
+  ASSERT_LT(withFeedback * 4, withoutFeedback);
+}
+
+}  // end namespace MLCommon
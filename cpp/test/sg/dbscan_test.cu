@@ -16,6 +16,8 @@
 
 #include <cuda_utils.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include <cuml/cluster/dbscan.hpp>
@@ -28,6 +30,7 @@
 #include "linalg/transpose.h"
 
 #include "ml_utils.h"
+#include "single_rank_comms.h"
 #include "test_utils.h"
 
 #include "common/device_buffer.hpp"
@@ -118,6 +121,10 @@ class DbscanTest : public ::testing::TestWithParam<DbscanInputs<T, IdxT>> {
 const std::vector<DbscanInputs<float, int>> inputsf2 = {
   {50000, 16, 5, 0.01, 2, 2, (size_t)13e3, 1234ULL},
   {500, 16, 5, 0.01, 2, 2, (size_t)100, 1234ULL},
+  {5000, 16, 5, 0.01, 2, 2, (size_t)1, 1234ULL},
+  {5000, 2, 5, 0.01, 0.05, 2, (size_t)1, 1234ULL},
+  {50000, 3, 10, 0.01, 0.05, 2, (size_t)13e3, 1234ULL},
+  {20000, 16, 5, 0.01, 2, 2, (size_t)0, 1234ULL},
   {1000, 1000, 10, 0.01, 2, 2, (size_t)13e3, 1234ULL},
   {50000, 16, 5l, 0.01, 2, 2, (size_t)13e3, 1234ULL},
   {20000, 10000, 10, 0.01, 2, 2, (size_t)13e3, 1234ULL},
@@ -126,6 +133,9 @@ const std::vector<DbscanInputs<float, int>> inputsf2 = {
 const std::vector<DbscanInputs<float, int64_t>> inputsf3 = {
   {50000, 16, 5, 0.01, 2, 2, (size_t)9e3, 1234ULL},
   {500, 16, 5, 0.01, 2, 2, (size_t)100, 1234ULL},
+  {5000, 16, 5, 0.01, 2, 2, (size_t)1, 1234ULL},
+  {5000, 2, 5, 0.01, 0.05, 2, (size_t)1, 1234ULL},
+  {50000, 3, 10, 0.01, 0.05, 2, (size_t)13e3, 1234ULL},
   {1000, 1000, 10, 0.01, 2, 2, (size_t)9e3, 1234ULL},
   {50000, 16, 5l, 0.01, 2, 2, (size_t)9e3, 1234ULL},
   {20000, 10000, 10, 0.01, 2, 2, (size_t)9e3, 1234ULL},
@@ -134,6 +144,9 @@ const std::vector<DbscanInputs<float, int64_t>> inputsf3 = {
 const std::vector<DbscanInputs<double, int>> inputsd2 = {
   {50000, 16, 5, 0.01, 2, 2, (size_t)13e3, 1234ULL},
   {500, 16, 5, 0.01, 2, 2, (size_t)100, 1234ULL},
+  {5000, 16, 5, 0.01, 2, 2, (size_t)1, 1234ULL},
+  {5000, 2, 5, 0.01, 0.05, 2, (size_t)1, 1234ULL},
+  {50000, 3, 10, 0.01, 0.05, 2, (size_t)13e3, 1234ULL},
   {1000, 1000, 10, 0.01, 2, 2, (size_t)13e3, 1234ULL},
   {100, 10000, 10, 0.01, 2, 2, (size_t)13e3, 1234ULL},
   {20000, 10000, 10, 0.01, 2, 2, (size_t)13e3, 1234ULL},
@@ -142,6 +155,9 @@ const std::vector<DbscanInputs<double, int>> inputsd2 = {
 const std::vector<DbscanInputs<double, int64_t>> inputsd3 = {
   {50000, 16, 5, 0.01, 2, 2, (size_t)9e3, 1234ULL},
   {500, 16, 5, 0.01, 2, 2, (size_t)100, 1234ULL},
+  {5000, 16, 5, 0.01, 2, 2, (size_t)1, 1234ULL},
+  {5000, 2, 5, 0.01, 0.05, 2, (size_t)1, 1234ULL},
+  {50000, 3, 10, 0.01, 0.05, 2, (size_t)13e3, 1234ULL},
   {1000, 1000, 10, 0.01, 2, 2, (size_t)9e3, 1234ULL},
   {100, 10000, 10, 0.01, 2, 2, (size_t)9e3, 1234ULL},
   {20000, 10000, 10, 0.01, 2, 2, (size_t)9e3, 1234ULL},
@@ -159,6 +175,197 @@ TEST_P(DbscanTestD_Int, Result) { ASSERT_TRUE(score == 1.0); }
 typedef DbscanTest<double, int64_t> DbscanTestD_Int64;
 TEST_P(DbscanTestD_Int64, Result) { ASSERT_TRUE(score == 1.0); }
 
+// Blobs well apart from each other, and their labels, on the host
+static void hostBlobs(const cumlHandle &handle, int n_rows, int n_cols,
+                      int n_centers, std::vector<float> &h_X,
+                      std::vector<int> &h_labels) {
+  device_buffer<float> X(handle.getDeviceAllocator(), handle.getStream(),
+                         n_rows * n_cols);
+  device_buffer<int> y(handle.getDeviceAllocator(), handle.getStream(),
+                       n_rows);
+  make_blobs(handle, X.data(), y.data(), n_rows, n_cols, n_centers, nullptr,
+             nullptr, 0.01f, true, -10.0f, 10.0f, 1234ULL);
+  h_X.resize(n_rows * n_cols);
+  h_labels.resize(n_rows);
+  updateHost(h_X.data(), X.data(), n_rows * n_cols, handle.getStream());
+  updateHost(h_labels.data(), y.data(), n_rows, handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+}
+
+// The cosine distance does not depend on the norms of the rows
+TEST(DbscanCosineTest, ScaleInvariant) {
+  cumlHandle handle;
+  cudaStream_t stream = handle.getStream();
+  const int n_rows = 5000, n_cols = 16, n_centers = 5;
+  std::vector<float> h_X;
+  std::vector<int> h_ref;
+  hostBlobs(handle, n_rows, n_cols, n_centers, h_X, h_ref);
+  for (int i = 0; i < n_rows; i++)
+    for (int j = 0; j < n_cols; j++) h_X[i * n_cols + j] *= 0.5f + i % 4;
+
+  device_buffer<float> X(handle.getDeviceAllocator(), stream, n_rows * n_cols);
+  device_buffer<int> ref(handle.getDeviceAllocator(), stream, n_rows);
+  device_buffer<int> labels(handle.getDeviceAllocator(), stream, n_rows);
+  updateDevice(X.data(), h_X.data(), n_rows * n_cols, stream);
+  updateDevice(ref.data(), h_ref.data(), n_rows, stream);
+  dbscanFit(handle, X.data(), n_rows, n_cols, 1e-3f, 2, METRIC_COSINE,
+            labels.data());
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  double score = adjustedRandIndex(handle, ref.data(), labels.data(), n_rows,
+                                   0, n_centers - 1);
+  ASSERT_TRUE(score == 1.0);
+}
+
+// The epsilon neighborhoods, given as a graph with farther neighbors and
+// their distances, or already filtered, give the clusters of the points
+TEST(DbscanPrecomputedTest, MatchesPoints) {
+  cumlHandle handle;
+  cudaStream_t stream = handle.getStream();
+  const int n_rows = 2000, n_cols = 2, n_centers = 5;
+  const float eps = 0.05f;
+  std::vector<float> h_X;
+  std::vector<int> h_ref;
+  hostBlobs(handle, n_rows, n_cols, n_centers, h_X, h_ref);
+
+  std::vector<int> h_indptr(1, 0), h_indices, h_eps_indptr(1, 0), h_eps_indices;
+  std::vector<float> h_dists;
+  for (int i = 0; i < n_rows; i++) {
+    for (int j = 0; j < n_rows; j++) {
+      float d2 = 0;
+      for (int c = 0; c < n_cols; c++) {
+        float diff = h_X[i * n_cols + c] - h_X[j * n_cols + c];
+        d2 += diff * diff;
+      }
+      float dist = std::sqrt(d2);
+      if (dist <= 4 * eps) {
+        h_indices.push_back(j);
+        h_dists.push_back(dist);
+      }
+      if (dist <= eps) h_eps_indices.push_back(j);
+    }
+    h_indptr.push_back(h_indices.size());
+    h_eps_indptr.push_back(h_eps_indices.size());
+  }
+
+  auto alloc = handle.getDeviceAllocator();
+  device_buffer<int> indptr(alloc, stream, n_rows + 1);
+  device_buffer<int> indices(alloc, stream, h_indices.size());
+  device_buffer<float> dists(alloc, stream, h_dists.size());
+  device_buffer<int> eps_indptr(alloc, stream, n_rows + 1);
+  device_buffer<int> eps_indices(alloc, stream, h_eps_indices.size());
+  device_buffer<int> ref(alloc, stream, n_rows);
+  device_buffer<int> labels(alloc, stream, n_rows);
+  updateDevice(indptr.data(), h_indptr.data(), n_rows + 1, stream);
+  updateDevice(indices.data(), h_indices.data(), h_indices.size(), stream);
+  updateDevice(dists.data(), h_dists.data(), h_dists.size(), stream);
+  updateDevice(eps_indptr.data(), h_eps_indptr.data(), n_rows + 1, stream);
+  updateDevice(eps_indices.data(), h_eps_indices.data(), h_eps_indices.size(),
+               stream);
+  updateDevice(ref.data(), h_ref.data(), n_rows, stream);
+
+  dbscanFit(handle, indptr.data(), indices.data(), dists.data(), n_rows, eps,
+            2, labels.data());
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  ASSERT_TRUE(adjustedRandIndex(handle, ref.data(), labels.data(), n_rows, 0,
+                                n_centers - 1) == 1.0);
+
+  dbscanFit(handle, eps_indptr.data(), eps_indices.data(), (float *)nullptr,
+            n_rows, eps, 2, labels.data());
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  ASSERT_TRUE(adjustedRandIndex(handle, ref.data(), labels.data(), n_rows, 0,
+                                n_centers - 1) == 1.0);
+}
+
+// One hierarchy gives the clusters at several eps, and its most stable
+// clusters are the blobs
+TEST(DbscanHierarchyTest, Blobs) {
+  cumlHandle handle;
+  cudaStream_t stream = handle.getStream();
+  const int n_rows = 2000, n_cols = 2, n_centers = 5;
+  std::vector<float> h_X;
+  std::vector<int> h_ref;
+  hostBlobs(handle, n_rows, n_cols, n_centers, h_X, h_ref);
+
+  auto alloc = handle.getDeviceAllocator();
+  device_buffer<float> X(alloc, stream, n_rows * n_cols);
+  device_buffer<int> ref(alloc, stream, n_rows);
+  device_buffer<int> labels(alloc, stream, n_rows);
+  device_buffer<float> core_dists(alloc, stream, n_rows);
+  device_buffer<int> mst_src(alloc, stream, n_rows - 1);
+  device_buffer<int> mst_dst(alloc, stream, n_rows - 1);
+  device_buffer<float> mst_weights(alloc, stream, n_rows - 1);
+  updateDevice(X.data(), h_X.data(), n_rows * n_cols, stream);
+  updateDevice(ref.data(), h_ref.data(), n_rows, stream);
+
+  int n_edges = dbscanHierarchy(handle, X.data(), n_rows, n_cols, 2, 0.1f,
+                                core_dists.data(), mst_src.data(),
+                                mst_dst.data(), mst_weights.data());
+  // one tree per blob
+  ASSERT_EQ(n_edges, n_rows - n_centers);
+  std::vector<float> h_weights(n_edges);
+  updateHost(h_weights.data(), mst_weights.data(), n_edges, stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  ASSERT_TRUE(std::is_sorted(h_weights.begin(), h_weights.end()));
+
+  for (float eps : {0.05f, 0.1f}) {
+    dbscanCutHierarchy(handle, core_dists.data(), mst_src.data(),
+                       mst_dst.data(), mst_weights.data(), n_edges, n_rows,
+                       eps, labels.data());
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    ASSERT_TRUE(adjustedRandIndex(handle, ref.data(), labels.data(), n_rows,
+                                  0, n_centers - 1) == 1.0);
+  }
+
+  hdbscanFit(handle, X.data(), n_rows, n_cols, 2, 10, 1.0f, labels.data());
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  ASSERT_TRUE(adjustedRandIndex(handle, ref.data(), labels.data(), n_rows, 0,
+                                n_centers - 1) == 1.0);
+}
+
+// The only rank of a communicator labels its samples as dbscanFit does
+TEST(DbscanMGTest, MatchesFit) {
+  cumlHandle handle;
+  initSingleRankComms(handle);
+  cudaStream_t stream = handle.getStream();
+  const int n_rows = 5000, n_cols = 16, n_centers = 5;
+  std::vector<float> h_X;
+  std::vector<int> h_ref;
+  hostBlobs(handle, n_rows, n_cols, n_centers, h_X, h_ref);
+
+  auto alloc = handle.getDeviceAllocator();
+  device_buffer<float> X(alloc, stream, n_rows * n_cols);
+  device_buffer<int> labels(alloc, stream, n_rows);
+  device_buffer<int> mg_labels(alloc, stream, n_rows);
+  device_buffer<int> ref(alloc, stream, n_rows);
+  updateDevice(X.data(), h_X.data(), n_rows * n_cols, stream);
+  updateDevice(ref.data(), h_ref.data(), n_rows, stream);
+  // 1 MB, about 20 batches of the epsilon graph, and the default budget
+  for (size_t max_mbytes_per_batch : {(size_t)0, (size_t)1}) {
+    dbscanFit(handle, X.data(), n_rows, n_cols, 2.f, 2, labels.data(),
+              max_mbytes_per_batch);
+    dbscanFitMG(handle, X.data(), n_rows, n_cols, 2.f, 2, mg_labels.data(),
+                max_mbytes_per_batch);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    ASSERT_TRUE(devArrMatch(labels.data(), mg_labels.data(), n_rows,
+                            Compare<int>()));
+    double score = adjustedRandIndex(handle, ref.data(), mg_labels.data(),
+                                     n_rows, 0, n_centers - 1);
+    ASSERT_TRUE(score == 1.0);
+  }
+}
+
+TEST(DbscanBatchSize, FitsFreeMemory) {
+  cumlHandle handle;
+  size_t free_mem, total_mem;
+  CUDA_CHECK(cudaMemGetInfo(&free_mem, &total_mem));
+  size_t mbytes = dbscanMaxMbytesPerBatch(handle, 100000, 16);
+  ASSERT_GE(mbytes, 1);
+  ASSERT_LE(mbytes * 1e6, free_mem);
+  ASSERT_LE(dbscanMaxMbytesPerBatch(handle, int64_t(1e8), int64_t(2)),
+            mbytes);
+}
+
 INSTANTIATE_TEST_CASE_P(DbscanTests, DbscanTestF_Int,
                         ::testing::ValuesIn(inputsf2));
 
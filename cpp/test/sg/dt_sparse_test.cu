@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuda_utils.h>
+#include <gtest/gtest.h>
+#include <test_utils.h>
+#include <numeric>
+#include "cuml/tree/decisiontree.hpp"
+#include "ml_utils.h"
+
+namespace ML {
+
+using namespace MLCommon;
+
+template <typename T>
+struct DtSparseInputs {
+  int max_depth;
+  int n_bins;
+  float max_features;
+};
+
+template <typename T>
+::std::ostream& operator<<(::std::ostream& os, const DtSparseInputs<T>& dims) {
+  return os;
+}
+
+// Fits the same trees on dense, CSC and CSR data, which must agree.
+template <typename T>
+class DtSparseClassifierTest
+  : public ::testing::TestWithParam<DtSparseInputs<T>> {
+ protected:
+  void fit_predict(int format, std::vector<int>& predictions) {
+    DecisionTree::DecisionTreeParams tree_params;
+    set_tree_params(tree_params, params.max_depth, -1, params.max_features,
+                    params.n_bins, SPLIT_ALGO::GLOBAL_QUANTILE);
+    std::vector<unsigned int> rowids_h(n_rows);
+    std::iota(rowids_h.begin(), rowids_h.end(), 0);
+    updateDevice(rowids, rowids_h.data(), n_rows, stream);
+
+    DecisionTree::TreeMetaDataNode<T, int>* tree =
+      new DecisionTree::TreeMetaDataNode<T, int>;
+    tree->treeid = 0;
+    if (format == 0) {
+      DecisionTree::decisionTreeClassifierFit(
+        handle, tree, data, n_cols, n_rows, labels, rowids, n_rows, 4,
+        tree_params);
+    } else if (format == 1) {
+      DecisionTree::decisionTreeClassifierFitCSC(
+        handle, tree, csc_ind, csc_rows, csc_vals, nnz, n_cols, n_rows, labels,
+        rowids, n_rows, 4, tree_params);
+    } else {
+      DecisionTree::decisionTreeClassifierFitCSR(
+        handle, tree, csr_ind, csr_cols, csr_vals, nnz, n_cols, n_rows, labels,
+        rowids, n_rows, 4, tree_params);
+    }
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    predictions.resize(n_rows);
+    DecisionTree::decisionTreeClassifierPredict(handle, tree, rows_h.data(),
+                                                n_rows, n_cols,
+                                                predictions.data());
+    delete tree;
+  }
+
+  void SetUp() override {
+    params = ::testing::TestWithParam<DtSparseInputs<T>>::GetParam();
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    handle.setStream(stream);
+
+    // Column major, mostly zeros
+    std::vector<T> data_h = {0, 1, 0, 0, 2, 0, 3, 0, 0, 0, -1, 0,
+                             0, 4, 0, 0, 5, 0, 0, 0, 0, 0, 0,  6};
+    std::vector<int> labels_h = {0, 1, 0, 2, 1, 2, 3, 0};
+    std::vector<int> csc_ind_h, csc_rows_h, csr_ind_h, csr_cols_h;
+    std::vector<T> csc_vals_h, csr_vals_h;
+    rows_h.resize(n_rows * n_cols);
+    for (int c = 0; c < n_cols; c++) {
+      csc_ind_h.push_back(csc_vals_h.size());
+      for (int r = 0; r < n_rows; r++) {
+        T value = data_h[c * n_rows + r];
+        rows_h[r * n_cols + c] = value;
+        if (value == 0) continue;
+        csc_rows_h.push_back(r);
+        csc_vals_h.push_back(value);
+      }
+    }
+    for (int r = 0; r < n_rows; r++) {
+      csr_ind_h.push_back(csr_vals_h.size());
+      for (int c = 0; c < n_cols; c++) {
+        T value = data_h[c * n_rows + r];
+        if (value == 0) continue;
+        csr_cols_h.push_back(c);
+        csr_vals_h.push_back(value);
+      }
+    }
+    nnz = csc_vals_h.size();
+
+    allocate(data, n_rows * n_cols);
+    allocate(labels, n_rows);
+    allocate(rowids, n_rows);
+    allocate(csc_ind, n_cols);
+    allocate(csc_rows, nnz);
+    allocate(csc_vals, nnz);
+    allocate(csr_ind, n_rows);
+    allocate(csr_cols, nnz);
+    allocate(csr_vals, nnz);
+    updateDevice(data, data_h.data(), n_rows * n_cols, stream);
+    updateDevice(labels, labels_h.data(), n_rows, stream);
+    updateDevice(csc_ind, csc_ind_h.data(), n_cols, stream);
+    updateDevice(csc_rows, csc_rows_h.data(), nnz, stream);
+    updateDevice(csc_vals, csc_vals_h.data(), nnz, stream);
+    updateDevice(csr_ind, csr_ind_h.data(), n_rows, stream);
+    updateDevice(csr_cols, csr_cols_h.data(), nnz, stream);
+    updateDevice(csr_vals, csr_vals_h.data(), nnz, stream);
+
+    fit_predict(0, dense_predictions);
+    fit_predict(1, csc_predictions);
+    fit_predict(2, csr_predictions);
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(data));
+    CUDA_CHECK(cudaFree(labels));
+    CUDA_CHECK(cudaFree(rowids));
+    CUDA_CHECK(cudaFree(csc_ind));
+    CUDA_CHECK(cudaFree(csc_rows));
+    CUDA_CHECK(cudaFree(csc_vals));
+    CUDA_CHECK(cudaFree(csr_ind));
+    CUDA_CHECK(cudaFree(csr_cols));
+    CUDA_CHECK(cudaFree(csr_vals));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  DtSparseInputs<T> params;
+  const int n_rows = 8;
+  const int n_cols = 3;
+  int nnz;
+  cumlHandle handle;
+  cudaStream_t stream;
+  T *data, *csc_vals, *csr_vals;
+  int *labels, *csc_ind, *csc_rows, *csr_ind, *csr_cols;
+  unsigned int* rowids;
+  std::vector<T> rows_h;
+  std::vector<int> dense_predictions, csc_predictions, csr_predictions;
+};
+
+const std::vector<DtSparseInputs<float>> inputsf2 = {
+  {8, 8, 1.0f}, {8, 4, 1.0f}, {2, 8, 1.0f}, {8, 8, 0.67f}};
+
+const std::vector<DtSparseInputs<double>> inputsd2 = {  // Same as inputsf2
+  {8, 8, 1.0f},
+  {8, 4, 1.0f},
+  {2, 8, 1.0f},
+  {8, 8, 0.67f}};
+
+typedef DtSparseClassifierTest<float> DtSparseClassifierTestF;
+TEST_P(DtSparseClassifierTestF, Fit) {
+  ASSERT_TRUE(csc_predictions == dense_predictions);
+  ASSERT_TRUE(csr_predictions == dense_predictions);
+}
+
+typedef DtSparseClassifierTest<double> DtSparseClassifierTestD;
+TEST_P(DtSparseClassifierTestD, Fit) {
+  ASSERT_TRUE(csc_predictions == dense_predictions);
+  ASSERT_TRUE(csr_predictions == dense_predictions);
+}
+
+INSTANTIATE_TEST_CASE_P(DtSparseClassifierTests, DtSparseClassifierTestF,
+                        ::testing::ValuesIn(inputsf2));
+
+INSTANTIATE_TEST_CASE_P(DtSparseClassifierTests, DtSparseClassifierTestD,
+                        ::testing::ValuesIn(inputsd2));
+
+}  // end namespace ML
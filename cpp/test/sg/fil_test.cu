@@ -20,6 +20,7 @@
 #include <treelite/c_api.h>
 #include <treelite/frontend.h>
 #include <treelite/tree.h>
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <limits>
@@ -28,6 +29,7 @@
 #include "cuml/fil/fil.h"
 #include "ml_utils.h"
 #include "random/rng.h"
+#include "single_rank_comms.h"
 #include "test_utils.h"
 
 #define TL_CPP_CHECK(call) ASSERT(int(call) >= 0, "treelite call error")
@@ -57,6 +59,8 @@ struct FilTestParams {
   float tolerance;
   // treelite parameters, only used for treelite tests
   tl::Operator op;
+  // number of classes; 0 (the default) is the same as 1
+  int num_classes;
 };
 
 std::ostream& operator<<(std::ostream& os, const FilTestParams& ps) {
@@ -65,7 +69,8 @@ std::ostream& operator<<(std::ostream& os, const FilTestParams& ps) {
      << ", num_trees = " << ps.num_trees << ", leaf_prob = " << ps.leaf_prob
      << ", output = " << ps.output << ", threshold = " << ps.threshold
      << ", algo = " << ps.algo << ", seed = " << ps.seed
-     << ", tolerance = " << ps.tolerance << ", op = " << tl::OpName(ps.op);
+     << ", tolerance = " << ps.tolerance << ", op = " << tl::OpName(ps.op)
+     << ", num_classes = " << ps.num_classes;
   return os;
 }
 
@@ -87,6 +92,7 @@ class BaseFilTest : public testing::TestWithParam<FilTestParams> {
 
     generate_forest();
     generate_data();
+    adjust_inputs();
     predict_on_cpu();
     predict_on_gpu();
   }
@@ -191,37 +197,63 @@ class BaseFilTest : public testing::TestWithParam<FilTestParams> {
 
   void predict_on_cpu() {
     // predict on host
-    std::vector<float> want_preds_h(ps.num_rows);
+    int nc = num_classes();
+    std::vector<float> want_preds_h(num_preds());
     int num_nodes = tree_num_nodes();
     for (int i = 0; i < ps.num_rows; ++i) {
-      float pred = 0.0f;
+      float* row_preds = &want_preds_h[i * nc];
+      for (int c = 0; c < nc; ++c) row_preds[c] = 0.0f;
       for (int j = 0; j < ps.num_trees; ++j) {
-        pred += infer_one_tree(&nodes[j * num_nodes], &data_h[i * ps.num_cols]);
+        row_preds[j % nc] +=
+          infer_one_tree(&nodes[j * num_nodes], &data_h[i * ps.num_cols]);
       }
-      if ((ps.output & fil::output_t::AVG) != 0) pred = pred / ps.num_trees;
-      pred += ps.global_bias;
-      if ((ps.output & fil::output_t::SIGMOID) != 0) pred = sigmoid(pred);
-      if ((ps.output & fil::output_t::THRESHOLD) != 0) {
-        pred = pred > ps.threshold ? 1.0f : 0.0f;
+      for (int c = 0; c < nc; ++c) {
+        float pred = row_preds[c];
+        if ((ps.output & fil::output_t::AVG) != 0) {
+          pred = pred / (ps.num_trees / nc);
+        }
+        pred += ps.global_bias;
+        if ((ps.output & fil::output_t::SIGMOID) != 0) pred = sigmoid(pred);
+        if ((ps.output & fil::output_t::THRESHOLD) != 0) {
+          pred = pred > ps.threshold ? 1.0f : 0.0f;
+        }
+        row_preds[c] = pred;
+      }
+      if ((ps.output & fil::output_t::SOFTMAX) != 0) {
+        float max_pred = *std::max_element(row_preds, row_preds + nc);
+        float sum = 0.0f;
+        for (int c = 0; c < nc; ++c) {
+          row_preds[c] = expf(row_preds[c] - max_pred);
+          sum += row_preds[c];
+        }
+        for (int c = 0; c < nc; ++c) row_preds[c] /= sum;
       }
-      want_preds_h[i] = pred;
     }
 
     // copy to GPU
-    allocate(want_preds_d, ps.num_rows);
-    updateDevice(want_preds_d, want_preds_h.data(), ps.num_rows, stream);
+    allocate(want_preds_d, num_preds());
+    updateDevice(want_preds_d, want_preds_h.data(), num_preds(), stream);
     CUDA_CHECK(cudaStreamSynchronize(stream));
   }
 
+  /** adjust_inputs changes the generated forest or data, if necessary for
+      the test, before the predictions are computed */
+  virtual void adjust_inputs() {}
+
   virtual void init_forest(fil::forest_t* pforest) = 0;
 
+  /** predict writes the predictions of forest on data_d into preds_d */
+  virtual void predict(fil::forest_t forest) {
+    fil::predict(handle, forest, preds_d, data_d, ps.num_rows);
+  }
+
   void predict_on_gpu() {
     fil::forest_t forest = nullptr;
     init_forest(&forest);
 
     // predict
-    allocate(preds_d, ps.num_rows);
-    fil::predict(handle, forest, preds_d, data_d, ps.num_rows);
+    allocate(preds_d, num_preds());
+    predict(forest);
     CUDA_CHECK(cudaStreamSynchronize(stream));
 
     // cleanup
@@ -229,7 +261,7 @@ class BaseFilTest : public testing::TestWithParam<FilTestParams> {
   }
 
   void compare() {
-    ASSERT_TRUE(devArrMatch(want_preds_d, preds_d, ps.num_rows,
+    ASSERT_TRUE(devArrMatch(want_preds_d, preds_d, num_preds(),
                             CompareApprox<float>(ps.tolerance), stream));
   }
 
@@ -253,6 +285,10 @@ class BaseFilTest : public testing::TestWithParam<FilTestParams> {
 
   int forest_num_nodes() { return tree_num_nodes() * ps.num_trees; }
 
+  int num_classes() { return std::max(ps.num_classes, 1); }
+
+  size_t num_preds() { return size_t(ps.num_rows) * num_classes(); }
+
   // predictions
   float* preds_d = nullptr;
   float* want_preds_d = nullptr;
@@ -282,11 +318,197 @@ class PredictDenseFilTest : public BaseFilTest {
     fil_ps.output = ps.output;
     fil_ps.threshold = ps.threshold;
     fil_ps.global_bias = ps.global_bias;
+    fil_ps.num_classes = num_classes();
     fil::init_dense(handle, pforest, nodes.data(), &fil_ps);
   }
 };
 
-class PredictSparseFilTest : public BaseFilTest {
+// node_init and node_decode initialize and decode sparse nodes of either size
+void node_init(fil::sparse_node_t* node, float output, float thresh, int fid,
+               bool def_left, bool is_leaf, int left_index) {
+  fil::sparse_node_init(node, output, thresh, fid, def_left, is_leaf,
+                        left_index);
+}
+
+void node_init(fil::sparse_node8_t* node, float output, float thresh, int fid,
+               bool def_left, bool is_leaf, int left_index) {
+  fil::sparse_node8_init(node, output, thresh, fid, def_left, is_leaf,
+                         left_index);
+}
+
+class PredictHostDenseFilTest : public PredictDenseFilTest {
+ protected:
+  void predict(fil::forest_t forest) override {
+    // predict from pinned host memory, using several internal streams
+    const int NUM_STREAMS = 3;
+    const size_t CHUNK_ROWS = 1500;
+    cumlHandle streams_handle(NUM_STREAMS);
+    streams_handle.setStream(stream);
+    float* data_h_pinned = nullptr;
+    float* preds_h_pinned = nullptr;
+    CUDA_CHECK(cudaMallocHost(&data_h_pinned, sizeof(float) * data_h.size()));
+    CUDA_CHECK(cudaMallocHost(&preds_h_pinned, sizeof(float) * num_preds()));
+    std::copy(data_h.begin(), data_h.end(), data_h_pinned);
+    fil::predict_host(streams_handle, forest, preds_h_pinned, data_h_pinned,
+                      ps.num_rows, CHUNK_ROWS);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    updateDevice(preds_d, preds_h_pinned, num_preds(), stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaFreeHost(preds_h_pinned));
+    CUDA_CHECK(cudaFreeHost(data_h_pinned));
+  }
+};
+
+class ContribDenseFilTest : public PredictDenseFilTest {
+ protected:
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(contribs_d));
+    CUDA_CHECK(cudaFree(want_contribs_d));
+    PredictDenseFilTest::TearDown();
+  }
+
+  void predict(fil::forest_t forest) override {
+    PredictDenseFilTest::predict(forest);
+    contribs_on_cpu();
+    allocate(contribs_d, num_contribs());
+    fil::predict_contributions(handle, forest, contribs_d, data_d,
+                               ps.num_rows);
+  }
+
+  /** expected_value returns the expected value of node curr of the tree
+      at root, with equal weights for both children of each inner node */
+  float expected_value(const fil::dense_node_t* root, int curr) {
+    float output = 0.0f, threshold = 0.0f;
+    int fid = 0;
+    bool def_left = false, is_leaf = false;
+    fil::dense_node_decode(&root[curr], &output, &threshold, &fid, &def_left,
+                           &is_leaf);
+    if (is_leaf) return output;
+    return 0.5f * (expected_value(root, 2 * curr + 1) +
+                   expected_value(root, 2 * curr + 2));
+  }
+
+  void contribs_on_cpu() {
+    int nc = num_classes();
+    int stride = ps.num_cols + 1;
+    float scale = 1.0f;
+    if ((ps.output & fil::output_t::AVG) != 0) scale /= ps.num_trees / nc;
+    std::vector<float> want_contribs_h(num_contribs(), 0.0f);
+    for (int i = 0; i < ps.num_rows; ++i) {
+      const float* row = &data_h[i * ps.num_cols];
+      for (int c = 0; c < nc; ++c) {
+        want_contribs_h[(i * nc + c) * stride + ps.num_cols] = ps.global_bias;
+      }
+      for (int j = 0; j < ps.num_trees; ++j) {
+        const fil::dense_node_t* root = &nodes[j * tree_num_nodes()];
+        float* contribs = &want_contribs_h[(i * nc + j % nc) * stride];
+        int curr = 0;
+        float curr_val = expected_value(root, curr);
+        contribs[ps.num_cols] += curr_val * scale;
+        for (;;) {
+          float output = 0.0f, threshold = 0.0f;
+          int fid = 0;
+          bool def_left = false, is_leaf = false;
+          fil::dense_node_decode(&root[curr], &output, &threshold, &fid,
+                                 &def_left, &is_leaf);
+          if (is_leaf) break;
+          float val = row[fid];
+          bool cond = isnan(val) ? !def_left : val >= threshold;
+          curr = (curr << 1) + 1 + (cond ? 1 : 0);
+          float next_val = expected_value(root, curr);
+          contribs[fid] += (next_val - curr_val) * scale;
+          curr_val = next_val;
+        }
+      }
+    }
+    allocate(want_contribs_d, num_contribs());
+    updateDevice(want_contribs_d, want_contribs_h.data(), num_contribs(),
+                 stream);
+  }
+
+  void compare_contribs() {
+    ASSERT_TRUE(devArrMatch(want_contribs_d, contribs_d, num_contribs(),
+                            CompareApprox<float>(ps.tolerance), stream));
+  }
+
+  size_t num_contribs() { return num_preds() * (ps.num_cols + 1); }
+
+  float* contribs_d = nullptr;
+  float* want_contribs_d = nullptr;
+};
+
+class PerTreeDenseFilTest : public PredictDenseFilTest {
+ protected:
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(outputs_d));
+    CUDA_CHECK(cudaFree(want_outputs_d));
+    CUDA_CHECK(cudaFree(leaves_d));
+    CUDA_CHECK(cudaFree(want_leaves_d));
+    PredictDenseFilTest::TearDown();
+  }
+
+  void predict(fil::forest_t forest) override {
+    PredictDenseFilTest::predict(forest);
+    per_tree_on_cpu();
+    allocate(outputs_d, num_outputs());
+    allocate(leaves_d, num_outputs());
+    fil::predict_per_tree(handle, forest, outputs_d, data_d, ps.num_rows,
+                          false);
+    fil::predict_per_tree(handle, forest, leaves_d, data_d, ps.num_rows, true);
+  }
+
+  /** leaf_index returns the index of the leaf reached by data in the tree
+      at root */
+  int leaf_index(const fil::dense_node_t* root, const float* data) {
+    int curr = 0;
+    float output = 0.0f, threshold = 0.0f;
+    int fid = 0;
+    bool def_left = false, is_leaf = false;
+    for (;;) {
+      fil::dense_node_decode(&root[curr], &output, &threshold, &fid, &def_left,
+                             &is_leaf);
+      if (is_leaf) break;
+      float val = data[fid];
+      bool cond = isnan(val) ? !def_left : val >= threshold;
+      curr = (curr << 1) + 1 + (cond ? 1 : 0);
+    }
+    return curr;
+  }
+
+  void per_tree_on_cpu() {
+    std::vector<float> want_outputs_h(num_outputs()),
+      want_leaves_h(num_outputs());
+    for (int i = 0; i < ps.num_rows; ++i) {
+      for (int j = 0; j < ps.num_trees; ++j) {
+        fil::dense_node_t* root = &nodes[j * tree_num_nodes()];
+        float* row = &data_h[i * ps.num_cols];
+        want_leaves_h[i * ps.num_trees + j] = leaf_index(root, row);
+        want_outputs_h[i * ps.num_trees + j] = infer_one_tree(root, row);
+      }
+    }
+    allocate(want_outputs_d, num_outputs());
+    allocate(want_leaves_d, num_outputs());
+    updateDevice(want_outputs_d, want_outputs_h.data(), num_outputs(), stream);
+    updateDevice(want_leaves_d, want_leaves_h.data(), num_outputs(), stream);
+  }
+
+  void compare_per_tree() {
+    ASSERT_TRUE(devArrMatch(want_outputs_d, outputs_d, num_outputs(),
+                            CompareApprox<float>(ps.tolerance), stream));
+    ASSERT_TRUE(devArrMatch(want_leaves_d, leaves_d, num_outputs(),
+                            Compare<float>(), stream));
+  }
+
+  size_t num_outputs() { return size_t(ps.num_rows) * ps.num_trees; }
+
+  float* outputs_d = nullptr;
+  float* want_outputs_d = nullptr;
+  float* leaves_d = nullptr;
+  float* want_leaves_d = nullptr;
+};
+
+template <typename node_t>
+class BasePredictSparseFilTest : public BaseFilTest {
  protected:
   void dense2sparse_node(const fil::dense_node_t* dense_root, int i_dense,
                          int i_sparse_root, int i_sparse) {
@@ -297,17 +519,17 @@ class PredictSparseFilTest : public BaseFilTest {
                       &def_left, &is_leaf);
     if (is_leaf) {
       // leaf sparse node
-      sparse_node_init(&sparse_nodes[i_sparse], output, threshold, feature,
-                       def_left, is_leaf, 0);
+      node_init(&sparse_nodes[i_sparse], output, threshold, feature, def_left,
+                is_leaf, 0);
       return;
     }
     // inner sparse node
     // reserve space for children
     int left_index = sparse_nodes.size();
-    sparse_nodes.push_back(fil::sparse_node_t());
-    sparse_nodes.push_back(fil::sparse_node_t());
-    sparse_node_init(&sparse_nodes[i_sparse], output, threshold, feature,
-                     def_left, is_leaf, left_index - i_sparse_root);
+    sparse_nodes.push_back(node_t());
+    sparse_nodes.push_back(node_t());
+    node_init(&sparse_nodes[i_sparse], output, threshold, feature, def_left,
+              is_leaf, left_index - i_sparse_root);
     dense2sparse_node(dense_root, 2 * i_dense + 1, i_sparse_root, left_index);
     dense2sparse_node(dense_root, 2 * i_dense + 2, i_sparse_root,
                       left_index + 1);
@@ -315,7 +537,7 @@ class PredictSparseFilTest : public BaseFilTest {
 
   void dense2sparse_tree(const fil::dense_node_t* dense_root) {
     int i_sparse_root = sparse_nodes.size();
-    sparse_nodes.push_back(fil::sparse_node_t());
+    sparse_nodes.push_back(node_t());
     dense2sparse_node(dense_root, 0, i_sparse_root, i_sparse_root);
     trees.push_back(i_sparse_root);
   }
@@ -335,15 +557,71 @@ class PredictSparseFilTest : public BaseFilTest {
     fil_params.output = ps.output;
     fil_params.threshold = ps.threshold;
     fil_params.global_bias = ps.global_bias;
+    fil_params.num_classes = num_classes();
     dense2sparse();
     fil_params.num_nodes = sparse_nodes.size();
     fil::init_sparse(handle, pforest, trees.data(), sparse_nodes.data(),
                      &fil_params);
   }
-  std::vector<fil::sparse_node_t> sparse_nodes;
+  std::vector<node_t> sparse_nodes;
   std::vector<int> trees;
 };
 
+typedef BasePredictSparseFilTest<fil::sparse_node_t> PredictSparseFilTest;
+typedef BasePredictSparseFilTest<fil::sparse_node8_t> PredictSparse8FilTest;
+
+/** SaveLoadFilTest predicts with a copy of the forest made by saving
+    and loading it */
+template <typename base_test>
+class SaveLoadFilTest : public base_test {
+ protected:
+  void predict(fil::forest_t forest) override {
+    std::vector<char> bytes;
+    fil::save(this->handle, forest, &bytes);
+    fil::forest_t loaded = nullptr;
+    fil::load(this->handle, &loaded, bytes.data(), bytes.size());
+    base_test::predict(loaded);
+    CUDA_CHECK(cudaStreamSynchronize(this->stream));
+    fil::free(this->handle, loaded);
+  }
+};
+
+typedef SaveLoadFilTest<PredictDenseFilTest> SaveLoadDenseFilTest;
+typedef SaveLoadFilTest<PredictSparseFilTest> SaveLoadSparseFilTest;
+typedef SaveLoadFilTest<PredictSparse8FilTest> SaveLoadSparse8FilTest;
+
+/** GraphedFilTest predicts with graph capture enabled: the first run is
+    eager, the second captured and the third replayed from the graph, and
+    all of them must match the uncaptured predictions exactly, as the
+    inference reduces the tree outputs in a fixed order */
+template <typename base_test>
+class GraphedFilTest : public base_test {
+ protected:
+  void predict(fil::forest_t forest) override {
+    size_t n = this->num_preds();
+    std::vector<float> eager_h(n), preds_h(n);
+    this->handle.setGraphCapture(false);
+    base_test::predict(forest);
+    updateHost(eager_h.data(), this->preds_d, n, this->stream);
+    this->handle.setGraphCapture(true);
+    for (int run = 0; run < 3; ++run) {
+      CUDA_CHECK(
+        cudaMemsetAsync(this->preds_d, 0, n * sizeof(float), this->stream));
+      base_test::predict(forest);
+      updateHost(preds_h.data(), this->preds_d, n, this->stream);
+      CUDA_CHECK(cudaStreamSynchronize(this->stream));
+      for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(eager_h[i], preds_h[i]) << " @" << i << " run " << run;
+      }
+    }
+    this->handle.clearGraphs();
+    this->handle.setGraphCapture(false);
+  }
+};
+
+typedef GraphedFilTest<PredictDenseFilTest> GraphedDenseFilTest;
+typedef GraphedFilTest<PredictSparseFilTest> GraphedSparseFilTest;
+
 class TreeliteFilTest : public BaseFilTest {
  protected:
   /** adds nodes[node] of tree starting at index root to builder
@@ -360,6 +638,17 @@ class TreeliteFilTest : public BaseFilTest {
                            &default_left, &is_leaf);
     if (is_leaf) {
       TL_CPP_CHECK(builder->SetLeafNode(key, output));
+    } else if (categorical) {
+      // integer x goes left iff x < threshold, i.e. iff x is in
+      // {0, ..., ceil(threshold) - 1}
+      std::vector<uint32_t> left_categories;
+      for (uint32_t c = 0; c < threshold; ++c) left_categories.push_back(c);
+      int left_key =
+        node_to_treelite(builder, pkey, root, root + 2 * (node - root) + 1);
+      int right_key =
+        node_to_treelite(builder, pkey, root, root + 2 * (node - root) + 2);
+      TL_CPP_CHECK(builder->SetCategoricalTestNode(
+        key, feature, left_categories, default_left, left_key, right_key));
     } else {
       int left = root + 2 * (node - root) + 1;
       int right = root + 2 * (node - root) + 2;
@@ -391,14 +680,17 @@ class TreeliteFilTest : public BaseFilTest {
     return key;
   }
 
-  void init_forest_impl(fil::forest_t* pforest, bool dense) {
+  void init_forest_impl(fil::forest_t* pforest,
+                        fil::storage_type_t storage_type) {
     bool random_forest_flag = (ps.output & fil::output_t::AVG) != 0;
     std::unique_ptr<tlf::ModelBuilder> model_builder(
-      new tlf::ModelBuilder(ps.num_cols, 1, random_forest_flag));
+      new tlf::ModelBuilder(ps.num_cols, num_classes(), random_forest_flag));
 
     // prediction transform
     if ((ps.output & fil::output_t::SIGMOID) != 0) {
       model_builder->SetModelParam("pred_transform", "sigmoid");
+    } else if ((ps.output & fil::output_t::SOFTMAX) != 0) {
+      model_builder->SetModelParam("pred_transform", "softmax");
     }
 
     // global bias
@@ -428,24 +720,101 @@ class TreeliteFilTest : public BaseFilTest {
     params.algo = ps.algo;
     params.threshold = ps.threshold;
     params.output_class = (ps.output & fil::output_t::THRESHOLD) != 0;
-    params.storage_type =
-      dense ? fil::storage_type_t::DENSE : fil::storage_type_t::SPARSE;
-    fil::from_treelite(handle, pforest, (ModelHandle)model.get(), &params);
+    params.storage_type = storage_type;
+    if (model_parallel) {
+      initSingleRankComms(handle);
+      fil::from_treelite_mg(handle, pforest, (ModelHandle)model.get(),
+                            &params, fil::mg_mode_t::MODEL_PARALLEL);
+    } else {
+      fil::from_treelite(handle, pforest, (ModelHandle)model.get(), &params);
+    }
     CUDA_CHECK(cudaStreamSynchronize(stream));
   }
+
+  // if true, the inner nodes are imported as categorical splits
+  bool categorical = false;
+  // if true, the forest is imported as the only shard of a model-parallel
+  // forest, whose partial sums go through the allreduce of the communicator
+  bool model_parallel = false;
 };
 
 class TreeliteDenseFilTest : public TreeliteFilTest {
  protected:
   void init_forest(fil::forest_t* pforest) override {
-    init_forest_impl(pforest, true);
+    init_forest_impl(pforest, fil::storage_type_t::DENSE);
   }
 };
 
 class TreeliteSparseFilTest : public TreeliteFilTest {
  protected:
   void init_forest(fil::forest_t* pforest) override {
-    init_forest_impl(pforest, false);
+    init_forest_impl(pforest, fil::storage_type_t::SPARSE);
+  }
+};
+
+/** TreeliteCategoricalFilTest makes the data integer-valued in [0, NUM_CATS),
+    and adjusts the thresholds, so that the forest can be imported with
+    equivalent categorical splits */
+class TreeliteCategoricalFilTest : public TreeliteFilTest {
+ protected:
+  static const int NUM_CATS = 20;
+
+  void adjust_inputs() override {
+    for (float& val : data_h) {
+      if (isnan(val)) continue;
+      val = std::min(floorf((val + 1.0f) * NUM_CATS / 2), NUM_CATS - 1.0f);
+    }
+    updateDevice(data_d, data_h.data(), data_h.size(), stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    for (fil::dense_node_t& node : nodes) {
+      float output, threshold;
+      int fid;
+      bool def_left, is_leaf;
+      fil::dense_node_decode(&node, &output, &threshold, &fid, &def_left,
+                             &is_leaf);
+      if (is_leaf) continue;
+      threshold = (threshold + 1.0f) * NUM_CATS / 2;
+      fil::dense_node_init(&node, output, threshold, fid, def_left, is_leaf);
+    }
+  }
+};
+
+class TreeliteCategoricalDenseFilTest : public TreeliteCategoricalFilTest {
+ protected:
+  void init_forest(fil::forest_t* pforest) override {
+    categorical = true;
+    init_forest_impl(pforest, fil::storage_type_t::DENSE);
+  }
+};
+
+class TreeliteCategoricalSparseFilTest : public TreeliteCategoricalFilTest {
+ protected:
+  void init_forest(fil::forest_t* pforest) override {
+    categorical = true;
+    init_forest_impl(pforest, fil::storage_type_t::SPARSE);
+  }
+};
+
+class TreeliteModelParallelDenseFilTest : public TreeliteFilTest {
+ protected:
+  void init_forest(fil::forest_t* pforest) override {
+    model_parallel = true;
+    init_forest_impl(pforest, fil::storage_type_t::DENSE);
+  }
+};
+
+class TreeliteModelParallelSparseFilTest : public TreeliteFilTest {
+ protected:
+  void init_forest(fil::forest_t* pforest) override {
+    model_parallel = true;
+    init_forest_impl(pforest, fil::storage_type_t::SPARSE);
+  }
+};
+
+class TreeliteSparse8FilTest : public TreeliteFilTest {
+ protected:
+  void init_forest(fil::forest_t* pforest) override {
+    init_forest_impl(pforest, fil::storage_type_t::SPARSE8);
   }
 };
 
@@ -497,6 +866,23 @@ std::vector<FilTestParams> predict_dense_inputs = {
   {20000, 50, 0.05, 8, 50, 0.05,
    fil::output_t(fil::output_t::AVG | fil::output_t::THRESHOLD), 1.0, 0.5,
    fil::algo_t::TREE_REORG, 42, 2e-3f},
+  {20000, 50, 0.05, 8, 51, 0.05, fil::output_t::RAW, 0, 0, fil::algo_t::NAIVE,
+   42, 2e-3f, tl::Operator::kNone, 3},
+  {20000, 50, 0.05, 8, 51, 0.05, fil::output_t::AVG, 0, 0.5,
+   fil::algo_t::TREE_REORG, 42, 2e-3f, tl::Operator::kNone, 3},
+  {20000, 50, 0.05, 8, 300, 0.05, fil::output_t::SOFTMAX, 0, 0,
+   fil::algo_t::BATCH_TREE_REORG, 42, 2e-3f, tl::Operator::kNone, 5},
+  {20000, 50, 0.05, 8, 50, 0.05, fil::output_t::SIGMOID, 0, 0,
+   fil::algo_t::BATCH_TREE_REORG, 42, 2e-3f, tl::Operator::kNone, 2},
+  {20000, 50, 0.05, 8, 50, 0.05, fil::output_t::AVG, 0, 0.5,
+   fil::algo_t::ALGO_AUTO, 42, 2e-3f},
+  {20000, 50, 0.05, 8, 51, 0.05, fil::output_t::SOFTMAX, 0, 0,
+   fil::algo_t::ALGO_AUTO, 42, 2e-3f, tl::Operator::kNone, 3},
+  // rows too wide to be cached in shared memory
+  {1000, 20000, 0.05, 8, 50, 0.05, fil::output_t::RAW, 0, 0,
+   fil::algo_t::BATCH_TREE_REORG, 42, 2e-3f},
+  {1000, 20000, 0.05, 8, 51, 0.05, fil::output_t::AVG, 0, 0,
+   fil::algo_t::NAIVE, 42, 2e-3f, tl::Operator::kNone, 3},
 };
 
 TEST_P(PredictDenseFilTest, Predict) { compare(); }
@@ -504,6 +890,50 @@ TEST_P(PredictDenseFilTest, Predict) { compare(); }
 INSTANTIATE_TEST_CASE_P(FilTests, PredictDenseFilTest,
                         testing::ValuesIn(predict_dense_inputs));
 
+std::vector<FilTestParams> predict_host_dense_inputs = {
+  {20000, 50, 0.05, 8, 50, 0.05, fil::output_t::SIGMOID, 0, 0,
+   fil::algo_t::BATCH_TREE_REORG, 42, 2e-3f},
+  {20000, 50, 0.05, 8, 51, 0.05, fil::output_t::AVG, 0, 0.5,
+   fil::algo_t::NAIVE, 42, 2e-3f, tl::Operator::kNone, 3},
+};
+
+TEST_P(PredictHostDenseFilTest, Predict) { compare(); }
+
+INSTANTIATE_TEST_CASE_P(FilTests, PredictHostDenseFilTest,
+                        testing::ValuesIn(predict_host_dense_inputs));
+
+std::vector<FilTestParams> contrib_dense_inputs = {
+  {2000, 50, 0.05, 8, 50, 0.05, fil::output_t::RAW, 0, 0, fil::algo_t::NAIVE,
+   42, 2e-3f},
+  {2000, 50, 0.05, 8, 50, 0.05, fil::output_t::SIGMOID, 0, 0.5,
+   fil::algo_t::BATCH_TREE_REORG, 42, 2e-3f},
+  {2000, 50, 0.05, 8, 51, 0.05, fil::output_t::AVG, 0, 0.5,
+   fil::algo_t::TREE_REORG, 42, 2e-3f, tl::Operator::kNone, 3},
+};
+
+TEST_P(ContribDenseFilTest, Predict) {
+  compare();
+  compare_contribs();
+}
+
+INSTANTIATE_TEST_CASE_P(FilTests, ContribDenseFilTest,
+                        testing::ValuesIn(contrib_dense_inputs));
+
+std::vector<FilTestParams> per_tree_dense_inputs = {
+  {2000, 50, 0.05, 8, 50, 0.05, fil::output_t::RAW, 0, 0, fil::algo_t::NAIVE,
+   42, 2e-3f},
+  {2000, 50, 0.05, 8, 51, 0.05, fil::output_t::SOFTMAX, 0, 0.5,
+   fil::algo_t::BATCH_TREE_REORG, 42, 2e-3f, tl::Operator::kNone, 3},
+};
+
+TEST_P(PerTreeDenseFilTest, Predict) {
+  compare();
+  compare_per_tree();
+}
+
+INSTANTIATE_TEST_CASE_P(FilTests, PerTreeDenseFilTest,
+                        testing::ValuesIn(per_tree_dense_inputs));
+
 // rows, cols, nan_prob, depth, num_trees, leaf_prob, output, threshold,
 // global_bias, algo, seed, tolerance
 std::vector<FilTestParams> predict_sparse_inputs = {
@@ -528,6 +958,19 @@ std::vector<FilTestParams> predict_sparse_inputs = {
   {20000, 50, 0.05, 8, 50, 0.05,
    fil::output_t(fil::output_t::AVG | fil::output_t::THRESHOLD), 1.0, 0.5,
    fil::algo_t::NAIVE, 42, 2e-3f},
+  {20000, 50, 0.05, 8, 51, 0.05, fil::output_t::RAW, 0, 0, fil::algo_t::NAIVE,
+   42, 2e-3f, tl::Operator::kNone, 3},
+  {20000, 50, 0.05, 8, 300, 0.05, fil::output_t::SOFTMAX, 0, 0.5,
+   fil::algo_t::NAIVE, 42, 2e-3f, tl::Operator::kNone, 5},
+  {20000, 50, 0.05, 8, 50, 0.05, fil::output_t::SIGMOID, 0, 0.5,
+   fil::algo_t::ALGO_AUTO, 42, 2e-3f},
+};
+
+// rows too wide to be cached in shared memory; only for 12-byte sparse nodes,
+// as 8-byte nodes are limited to 2**14 features
+std::vector<FilTestParams> predict_sparse_wide_inputs = {
+  {1000, 20000, 0.05, 8, 50, 0.05, fil::output_t::SIGMOID, 0, 0,
+   fil::algo_t::NAIVE, 42, 2e-3f},
 };
 
 TEST_P(PredictSparseFilTest, Predict) { compare(); }
@@ -535,6 +978,53 @@ TEST_P(PredictSparseFilTest, Predict) { compare(); }
 INSTANTIATE_TEST_CASE_P(FilTests, PredictSparseFilTest,
                         testing::ValuesIn(predict_sparse_inputs));
 
+INSTANTIATE_TEST_CASE_P(FilWideTests, PredictSparseFilTest,
+                        testing::ValuesIn(predict_sparse_wide_inputs));
+
+TEST_P(PredictSparse8FilTest, Predict) { compare(); }
+
+INSTANTIATE_TEST_CASE_P(FilTests, PredictSparse8FilTest,
+                        testing::ValuesIn(predict_sparse_inputs));
+
+std::vector<FilTestParams> save_load_inputs = {
+  {20000, 50, 0.05, 8, 50, 0.05, fil::output_t::SIGMOID, 0, 0.5,
+   fil::algo_t::NAIVE, 42, 2e-3f},
+  {20000, 50, 0.05, 8, 51, 0.05, fil::output_t::AVG, 0, 0,
+   fil::algo_t::ALGO_AUTO, 42, 2e-3f, tl::Operator::kNone, 3},
+};
+
+TEST_P(SaveLoadDenseFilTest, Predict) { compare(); }
+
+INSTANTIATE_TEST_CASE_P(FilTests, SaveLoadDenseFilTest,
+                        testing::ValuesIn(save_load_inputs));
+
+TEST_P(SaveLoadSparseFilTest, Predict) { compare(); }
+
+INSTANTIATE_TEST_CASE_P(FilTests, SaveLoadSparseFilTest,
+                        testing::ValuesIn(save_load_inputs));
+
+TEST_P(SaveLoadSparse8FilTest, Predict) { compare(); }
+
+INSTANTIATE_TEST_CASE_P(FilTests, SaveLoadSparse8FilTest,
+                        testing::ValuesIn(save_load_inputs));
+
+std::vector<FilTestParams> graphed_inputs = {
+  {20000, 50, 0.05, 8, 50, 0.05, fil::output_t::SIGMOID, 0, 0.5,
+   fil::algo_t::NAIVE, 42, 2e-3f},
+  {20000, 50, 0.05, 8, 51, 0.05, fil::output_t::SOFTMAX, 0, 0,
+   fil::algo_t::ALGO_AUTO, 42, 2e-3f, tl::Operator::kNone, 3},
+};
+
+TEST_P(GraphedDenseFilTest, Predict) { compare(); }
+
+INSTANTIATE_TEST_CASE_P(FilTests, GraphedDenseFilTest,
+                        testing::ValuesIn(graphed_inputs));
+
+TEST_P(GraphedSparseFilTest, Predict) { compare(); }
+
+INSTANTIATE_TEST_CASE_P(FilTests, GraphedSparseFilTest,
+                        testing::ValuesIn(graphed_inputs));
+
 std::vector<FilTestParams> import_dense_inputs = {
   {20000, 50, 0.05, 8, 50, 0.05, fil::output_t::RAW, 0, 0, fil::algo_t::NAIVE,
    42, 2e-3f, tl::Operator::kLT},
@@ -601,6 +1091,12 @@ std::vector<FilTestParams> import_dense_inputs = {
   {20000, 50, 0.05, 8, 50, 0.05,
    fil::output_t(fil::output_t::AVG | fil::output_t::THRESHOLD), 1.0, 0.5,
    fil::algo_t::TREE_REORG, 42, 2e-3f, tl::Operator::kGE},
+  {20000, 50, 0.05, 8, 51, 0.05, fil::output_t::RAW, 0, 0,
+   fil::algo_t::BATCH_TREE_REORG, 42, 2e-3f, tl::Operator::kLT, 3},
+  {20000, 50, 0.05, 8, 51, 0.05, fil::output_t::SOFTMAX, 0, 0,
+   fil::algo_t::TREE_REORG, 42, 2e-3f, tl::Operator::kLE, 3},
+  {20000, 50, 0.05, 8, 50, 0.05, fil::output_t::SIGMOID, 0, 0,
+   fil::algo_t::ALGO_AUTO, 42, 2e-3f, tl::Operator::kGT},
 };
 
 TEST_P(TreeliteDenseFilTest, Import) { compare(); }
@@ -630,6 +1126,10 @@ std::vector<FilTestParams> import_sparse_inputs = {
   {20000, 50, 0.05, 8, 50, 0.05,
    fil::output_t(fil::output_t::AVG | fil::output_t::THRESHOLD), 1.0, 0.5,
    fil::algo_t::NAIVE, 42, 2e-3f, tl::Operator::kGE},
+  {20000, 50, 0.05, 8, 51, 0.05, fil::output_t::SOFTMAX, 0, 0,
+   fil::algo_t::NAIVE, 42, 2e-3f, tl::Operator::kGT, 3},
+  {20000, 50, 0.05, 8, 50, 0.05, fil::output_t::AVG, 0, 0,
+   fil::algo_t::ALGO_AUTO, 42, 2e-3f, tl::Operator::kLE},
 };
 
 TEST_P(TreeliteSparseFilTest, Import) { compare(); }
@@ -637,4 +1137,49 @@ TEST_P(TreeliteSparseFilTest, Import) { compare(); }
 INSTANTIATE_TEST_CASE_P(FilTests, TreeliteSparseFilTest,
                         testing::ValuesIn(import_sparse_inputs));
 
+TEST_P(TreeliteSparse8FilTest, Import) { compare(); }
+
+INSTANTIATE_TEST_CASE_P(FilTests, TreeliteSparse8FilTest,
+                        testing::ValuesIn(import_sparse_inputs));
+
+// a single-rank model-parallel forest predicts the same as the whole forest
+std::vector<FilTestParams> import_model_parallel_inputs = {
+  {20000, 50, 0.05, 8, 50, 0.05, fil::output_t::SIGMOID, 0, 0.5,
+   fil::algo_t::NAIVE, 42, 2e-3f, tl::Operator::kLT},
+  {20000, 50, 0.05, 8, 50, 0.05, fil::output_t::AVG, 0, 0,
+   fil::algo_t::ALGO_AUTO, 42, 2e-3f, tl::Operator::kGE},
+  {20000, 50, 0.05, 8, 51, 0.05, fil::output_t::SOFTMAX, 0, 0,
+   fil::algo_t::ALGO_AUTO, 42, 2e-3f, tl::Operator::kLE, 3},
+};
+
+TEST_P(TreeliteModelParallelDenseFilTest, Import) { compare(); }
+
+INSTANTIATE_TEST_CASE_P(FilTests, TreeliteModelParallelDenseFilTest,
+                        testing::ValuesIn(import_model_parallel_inputs));
+
+TEST_P(TreeliteModelParallelSparseFilTest, Import) { compare(); }
+
+INSTANTIATE_TEST_CASE_P(FilTests, TreeliteModelParallelSparseFilTest,
+                        testing::ValuesIn(import_model_parallel_inputs));
+
+// ALGO_AUTO uses tree reorg for dense forests
+std::vector<FilTestParams> import_categorical_inputs = {
+  {20000, 50, 0.05, 8, 50, 0.05, fil::output_t::RAW, 0, 0, fil::algo_t::NAIVE,
+   42, 2e-3f},
+  {20000, 50, 0.05, 8, 50, 0.05, fil::output_t::SIGMOID, 0, 0.5,
+   fil::algo_t::ALGO_AUTO, 42, 2e-3f},
+  {20000, 50, 0.05, 8, 51, 0.05, fil::output_t::SOFTMAX, 0, 0,
+   fil::algo_t::NAIVE, 42, 2e-3f, tl::Operator::kNone, 3},
+};
+
+TEST_P(TreeliteCategoricalDenseFilTest, Import) { compare(); }
+
+INSTANTIATE_TEST_CASE_P(FilTests, TreeliteCategoricalDenseFilTest,
+                        testing::ValuesIn(import_categorical_inputs));
+
+TEST_P(TreeliteCategoricalSparseFilTest, Import) { compare(); }
+
+INSTANTIATE_TEST_CASE_P(FilTests, TreeliteCategoricalSparseFilTest,
+                        testing::ValuesIn(import_categorical_inputs));
+
 }  // namespace ML
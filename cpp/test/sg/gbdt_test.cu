@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuda_utils.h>
+#include <gtest/gtest.h>
+#include <test_utils.h>
+#include <random>
+#include <vector>
+#include "cuml/ensemble/gbdt.hpp"
+#include "ml_utils.h"
+
+namespace ML {
+
+using namespace MLCommon;
+
+template <typename T>
+struct GbdtInputs {
+  int n_rows;
+  int n_cols;
+  int n_estimators;
+  float learning_rate;
+  GBDT_loss loss;
+  int max_depth;
+  int n_bins;
+  int split_algo;
+  bool quantize;
+  float max_features;
+};
+
+template <typename T>
+::std::ostream& operator<<(::std::ostream& os, const GbdtInputs<T>& dims) {
+  return os;
+}
+
+// Fits on uniform data in [0, 1), with the labels x0 + 2 x1 (regression) or
+// x0 + x1 > 1 (logistic), and predicts on the training rows.
+template <typename T>
+class GbdtTest : public ::testing::TestWithParam<GbdtInputs<T>> {
+ protected:
+  void basicTest() {
+    params = ::testing::TestWithParam<GbdtInputs<T>>::GetParam();
+
+    GBDT_params gbdt_params;
+    set_gbdt_params(gbdt_params, params.n_estimators, params.learning_rate,
+                    params.loss);
+    DecisionTree::set_tree_params(gbdt_params.tree_params, params.max_depth,
+                                  -1, params.max_features, params.n_bins,
+                                  params.split_algo);
+    gbdt_params.tree_params.quantize = params.quantize;
+
+    int data_len = params.n_rows * params.n_cols;
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<T> dist(0, 1);
+    std::vector<T> data_h(data_len);  // Col major
+    std::vector<T> inference_data_h(data_len);  // Row major
+    for (int c = 0; c < params.n_cols; c++) {
+      for (int r = 0; r < params.n_rows; r++) {
+        T val = dist(gen);
+        data_h[r + c * params.n_rows] = val;
+        inference_data_h[c + r * params.n_cols] = val;
+      }
+    }
+    labels_h.resize(params.n_rows);
+    for (int r = 0; r < params.n_rows; r++) {
+      T x0 = data_h[r];
+      T x1 = data_h[r + params.n_rows];
+      if (params.loss == GBDT_loss::LOGISTIC) {
+        labels_h[r] = (x0 + x1 > 1) ? 1 : 0;
+      } else {
+        labels_h[r] = x0 + 2 * x1;
+      }
+    }
+
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    allocate(data, data_len);
+    allocate(inference_data, data_len);
+    allocate(labels, params.n_rows);
+    allocate(predictions, params.n_rows);
+    updateDevice(data, data_h.data(), data_len, stream);
+    updateDevice(inference_data, inference_data_h.data(), data_len, stream);
+    updateDevice(labels, labels_h.data(), params.n_rows, stream);
+
+    cumlHandle handle;
+    handle.setStream(stream);
+    fit(handle, model, data, params.n_rows, params.n_cols, labels,
+        gbdt_params);
+    predict(handle, model, inference_data, params.n_rows, params.n_cols,
+            predictions);
+    predictions_h.resize(params.n_rows);
+    updateHost(predictions_h.data(), predictions, params.n_rows, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  void SetUp() override { basicTest(); }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(data));
+    CUDA_CHECK(cudaFree(inference_data));
+    CUDA_CHECK(cudaFree(labels));
+    CUDA_CHECK(cudaFree(predictions));
+  }
+
+  // Ratio of the MSE of the predictions to the variance of the labels
+  double relative_mse() {
+    double mean = 0, var = 0, mse = 0;
+    for (T label : labels_h) mean += label;
+    mean /= params.n_rows;
+    for (int r = 0; r < params.n_rows; r++) {
+      double dev = labels_h[r] - mean;
+      double err = labels_h[r] - predictions_h[r];
+      var += dev * dev;
+      mse += err * err;
+    }
+    return mse / var;
+  }
+
+  double accuracy() {
+    int correct = 0;
+    for (int r = 0; r < params.n_rows; r++) {
+      correct += ((predictions_h[r] > 0.5) == (labels_h[r] > 0.5));
+    }
+    return (double)correct / params.n_rows;
+  }
+
+ protected:
+  GbdtInputs<T> params;
+  GBDTModel<T> model;
+  T *data, *inference_data, *labels, *predictions;
+  std::vector<T> labels_h, predictions_h;
+};
+
+const std::vector<GbdtInputs<float>> inputsf = {
+  {1000, 4, 50, 0.3f, GBDT_loss::SQUARED_ERROR, 4, 16, SPLIT_ALGO::HIST, false,
+   1.0f},
+  {1000, 4, 50, 0.3f, GBDT_loss::SQUARED_ERROR, 4, 16,
+   SPLIT_ALGO::GLOBAL_QUANTILE, false, 1.0f},
+  {1000, 4, 50, 0.3f, GBDT_loss::SQUARED_ERROR, 4, 16,
+   SPLIT_ALGO::GLOBAL_QUANTILE, true, 0.5f},
+  {1000, 4, 50, 0.3f, GBDT_loss::LOGISTIC, 4, 16, SPLIT_ALGO::HIST, false,
+   1.0f},
+  {1000, 4, 50, 0.3f, GBDT_loss::LOGISTIC, 4, 16, SPLIT_ALGO::GLOBAL_QUANTILE,
+   true, 1.0f}};
+
+const std::vector<GbdtInputs<double>> inputsd = {  // Same as inputsf
+  {1000, 4, 50, 0.3f, GBDT_loss::SQUARED_ERROR, 4, 16, SPLIT_ALGO::HIST, false,
+   1.0f},
+  {1000, 4, 50, 0.3f, GBDT_loss::SQUARED_ERROR, 4, 16,
+   SPLIT_ALGO::GLOBAL_QUANTILE, false, 1.0f},
+  {1000, 4, 50, 0.3f, GBDT_loss::SQUARED_ERROR, 4, 16,
+   SPLIT_ALGO::GLOBAL_QUANTILE, true, 0.5f},
+  {1000, 4, 50, 0.3f, GBDT_loss::LOGISTIC, 4, 16, SPLIT_ALGO::HIST, false,
+   1.0f},
+  {1000, 4, 50, 0.3f, GBDT_loss::LOGISTIC, 4, 16, SPLIT_ALGO::GLOBAL_QUANTILE,
+   true, 1.0f}};
+
+typedef GbdtTest<float> GbdtTestF;
+TEST_P(GbdtTestF, Fit) {
+  ASSERT_EQ((int)model.trees.size(), params.n_estimators);
+  if (params.loss == GBDT_loss::LOGISTIC) {
+    ASSERT_TRUE(accuracy() >= 0.9);
+  } else {
+    ASSERT_TRUE(relative_mse() <= 0.1);
+  }
+}
+
+typedef GbdtTest<double> GbdtTestD;
+TEST_P(GbdtTestD, Fit) {
+  ASSERT_EQ((int)model.trees.size(), params.n_estimators);
+  if (params.loss == GBDT_loss::LOGISTIC) {
+    ASSERT_TRUE(accuracy() >= 0.9);
+  } else {
+    ASSERT_TRUE(relative_mse() <= 0.1);
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(GbdtTests, GbdtTestF, ::testing::ValuesIn(inputsf));
+INSTANTIATE_TEST_CASE_P(GbdtTests, GbdtTestD, ::testing::ValuesIn(inputsd));
+
+}  // end namespace ML
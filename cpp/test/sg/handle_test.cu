@@ -15,8 +15,14 @@
  */
 
 #include <gtest/gtest.h>
+#include <cuml/common/handlePool.hpp>
+#include <thread>
+#include <vector>
 
+#include "common/cumlHandle.hpp"
+#include "common/device_buffer.hpp"
 #include "cuml/cuml_api.h"
+#include "linalg/unary_op.h"
 
 TEST(HandleTest, CreateHandleAndDestroy) {
   cumlHandle_t handle;
@@ -55,3 +61,208 @@ TEST(HandleTest, SetStreamInvalidHandle) {
   cumlHandle_t handle = 12346;
   EXPECT_EQ(CUML_INVALID_HANDLE, cumlSetStream(handle, 0));
 }
+
+TEST(HandleTest, DestroyedHandleStaysInvalid) {
+  cumlHandle_t handle;
+  EXPECT_EQ(CUML_SUCCESS, cumlCreate(&handle));
+  EXPECT_EQ(CUML_SUCCESS, cumlDestroy(handle));
+  // the new handle may reuse the slot of the destroyed one, but not its ID
+  cumlHandle_t other;
+  EXPECT_EQ(CUML_SUCCESS, cumlCreate(&other));
+  EXPECT_NE(handle, other);
+  cudaStream_t stream;
+  EXPECT_EQ(CUML_INVALID_HANDLE, cumlGetStream(handle, &stream));
+  EXPECT_EQ(CUML_SUCCESS, cumlGetStream(other, &stream));
+  EXPECT_EQ(CUML_SUCCESS, cumlDestroy(other));
+}
+
+TEST(HandleTest, ConcurrentLookups) {
+  const int n_threads = 8;
+  const int n_lookups = 10000;
+  cumlHandle_t handle;
+  EXPECT_EQ(CUML_SUCCESS, cumlCreate(&handle));
+  std::vector<int> n_failed(n_threads, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      // creations and destructions of other handles alongside the lookups
+      cumlHandle_t own;
+      for (int i = 0; i < n_lookups; ++i) {
+        cudaStream_t stream;
+        if (cumlGetStream(handle, &stream) != CUML_SUCCESS) n_failed[t]++;
+        if (i % 1000 == 0) {
+          if (cumlCreate(&own) != CUML_SUCCESS) n_failed[t]++;
+          if (cumlDestroy(own) != CUML_SUCCESS) n_failed[t]++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int t = 0; t < n_threads; ++t) EXPECT_EQ(0, n_failed[t]);
+  EXPECT_EQ(CUML_SUCCESS, cumlDestroy(handle));
+}
+
+TEST(HandleTest, DeviceMemoryUsage) {
+  ML::cumlHandle handle;
+  const ML::cumlHandle_impl& impl = handle.getImpl();
+  cudaStream_t stream = handle.getStream();
+  auto allocator = handle.getDeviceAllocator();
+
+  void* outside = allocator->allocate(1000, stream);
+  void* inner;
+  {
+    ML::detail::memoryTagScope outer(impl, "outer");
+    void* p = allocator->allocate(2000, stream);
+    {
+      ML::detail::memoryTagScope scope(impl, "inner");
+      inner = allocator->allocate(3000, stream);
+    }
+    allocator->deallocate(p, 2000, stream);
+  }
+
+  ML::memoryUsage total = handle.getDeviceMemoryUsage();
+  EXPECT_EQ(4000, total.bytesInUse);
+  EXPECT_EQ(6000, total.peakBytesInUse);
+  EXPECT_EQ(3, total.nAllocations);
+  ML::memoryUsage outer = handle.getDeviceMemoryUsage("outer");
+  EXPECT_EQ(3000, outer.bytesInUse);
+  EXPECT_EQ(5000, outer.peakBytesInUse);
+  EXPECT_EQ(2, outer.nAllocations);
+  ML::memoryUsage in = handle.getDeviceMemoryUsage("inner");
+  EXPECT_EQ(3000, in.bytesInUse);
+  EXPECT_EQ(3000, in.peakBytesInUse);
+  EXPECT_EQ(1, in.nAllocations);
+  EXPECT_EQ(0, handle.getDeviceMemoryUsage("unknown").peakBytesInUse);
+  std::vector<std::string> tags = handle.getDeviceMemoryTags();
+  ASSERT_EQ(2, tags.size());
+  EXPECT_EQ("outer", tags[0]);
+  EXPECT_EQ("inner", tags[1]);
+
+  // a new allocator is tracked too, and the blocks of the old one are still
+  // released from the counters
+  handle.setDeviceAllocator(std::make_shared<ML::defaultDeviceAllocator>());
+  allocator->deallocate(inner, 3000, stream);
+  handle.resetDeviceMemoryUsage();
+  total = handle.getDeviceMemoryUsage();
+  EXPECT_EQ(1000, total.bytesInUse);
+  EXPECT_EQ(1000, total.peakBytesInUse);
+  EXPECT_EQ(0, total.nAllocations);
+  void* p = handle.getDeviceAllocator()->allocate(500, stream);
+  EXPECT_EQ(1500, handle.getDeviceMemoryUsage().bytesInUse);
+  handle.getDeviceAllocator()->deallocate(p, 500, stream);
+  allocator->deallocate(outside, 1000, stream);
+  EXPECT_EQ(0, handle.getDeviceMemoryUsage().bytesInUse);
+}
+
+// out = 2 * in + 1 through a workspace of the handle, optionally syncing the
+// host in between, which no capture allows
+void graphedCall(const ML::cumlHandle_impl& impl, const float* in, float* out,
+                 int len, bool sync) {
+  cudaStream_t stream = impl.getStream();
+  impl.runGraphed(ML::graphKey("graphedCall", in, out, len, sync), [&]() {
+    MLCommon::device_buffer<float> tmp(impl.getDeviceAllocator(), stream, len);
+    MLCommon::LinAlg::unaryOp(
+      tmp.data(), in, len, [] __device__(float v) { return 2.f * v; },
+      stream);
+    if (sync) CUDA_CHECK(cudaStreamSynchronize(stream));
+    MLCommon::LinAlg::unaryOp(
+      out, tmp.data(), len, [] __device__(float v) { return v + 1.f; },
+      stream);
+  });
+}
+
+TEST(HandleTest, GraphCapture) {
+  ML::cumlHandle handle;
+  cudaStream_t stream;
+  CUDA_CHECK(cudaStreamCreate(&stream));
+  handle.setStream(stream);
+  handle.setGraphCapture(true);
+  EXPECT_TRUE(handle.getGraphCapture());
+  const int len = 1000;
+  std::vector<float> in_h(len), out_h(len);
+  auto allocator = handle.getDeviceAllocator();
+  MLCommon::device_buffer<float> in(allocator, stream, len);
+  MLCommon::device_buffer<float> out(allocator, stream, len);
+
+  for (bool sync : {false, true}) {
+    // eager and captured, then replayed, runs reading the current input
+    for (int run = 0; run < 3; run++) {
+      for (int i = 0; i < len; i++) in_h[i] = float(i + run);
+      MLCommon::updateDevice(in.data(), in_h.data(), len, stream);
+      CUDA_CHECK(cudaMemsetAsync(out.data(), 0, len * sizeof(float), stream));
+      graphedCall(handle.getImpl(), in.data(), out.data(), len, sync);
+      MLCommon::updateHost(out_h.data(), out.data(), len, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+      for (int i = 0; i < len; i++) {
+        ASSERT_EQ(2.f * in_h[i] + 1.f, out_h[i]) << " @" << i << " run " << run;
+      }
+    }
+  }
+
+  handle.clearGraphs();
+  handle.setGraphCapture(false);
+  in.release(stream);
+  out.release(stream);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  CUDA_CHECK(cudaStreamDestroy(stream));
+}
+
+TEST(HandleTest, HandlePool) {
+  const int n_handles = 4, n_requests = 32, len = 100000;
+  ML::cumlHandlePool pool(n_handles);
+  EXPECT_EQ(n_handles, pool.size());
+  EXPECT_EQ(n_handles, pool.available());
+  std::vector<int> ok(n_requests, 0);
+
+  auto request = [&](int r) {
+    ML::cumlHandlePool::lease h = pool.acquire();
+    EXPECT_EQ(pool.getDeviceAllocator(), h->getDeviceAllocator());
+    cudaStream_t stream = h.getStream();
+    std::vector<float> in_h(len, float(r)), out_h(len);
+    MLCommon::device_buffer<float> in(h->getDeviceAllocator(), stream, len);
+    MLCommon::device_buffer<float> out(h->getDeviceAllocator(), stream, len);
+    MLCommon::updateDevice(in.data(), in_h.data(), len, stream);
+    graphedCall(h->getImpl(), in.data(), out.data(), len, false);
+    MLCommon::updateHost(out_h.data(), out.data(), len, stream);
+    h.synchronize();
+    bool match = true;
+    for (int i = 0; i < len; i++) match = match && out_h[i] == 2.f * r + 1.f;
+    ok[r] = match;
+  };
+  std::vector<std::thread> threads;
+  for (int r = 0; r < n_requests; r++) threads.emplace_back(request, r);
+  for (auto& t : threads) t.join();
+
+  EXPECT_EQ(n_handles, pool.available());
+  for (int r = 0; r < n_requests; r++) EXPECT_TRUE(ok[r]) << " request " << r;
+}
+
+TEST(HandleTest, Profiling) {
+  ML::cumlHandle handle;
+  const ML::cumlHandle_impl& impl = handle.getImpl();
+  EXPECT_FALSE(handle.getProfiling());
+  {
+    ML::detail::phaseScope scope(impl, "ML::Test::Disabled");
+  }
+  EXPECT_EQ("{\"phases\":[]}", handle.getProfileReport());
+
+  handle.setProfiling(true);
+  EXPECT_TRUE(handle.getProfiling());
+  for (int i = 0; i < 3; i++) {
+    ML::detail::phaseScope outer(impl, "ML::Test::Call", "i=%d", i);
+    ML::detail::phaseScope inner(impl, "Trace::Test::\"Phase\"", i);
+  }
+  std::string report = handle.getProfileReport();
+  EXPECT_EQ(std::size_t(0),
+            report.find("{\"phases\":[{\"name\":\"ML::Test::Call\","
+                        "\"calls\":3,"));
+  EXPECT_NE(std::string::npos,
+            report.find("{\"name\":\"Trace::Test::\\\"Phase\\\"\","
+                        "\"calls\":3,"));
+  EXPECT_EQ(std::string::npos, report.find("Disabled"));
+  // the phases tag the device memory, profiled or not
+  EXPECT_EQ(3, handle.getDeviceMemoryTags().size());
+
+  handle.resetProfile();
+  EXPECT_EQ("{\"phases\":[]}", handle.getProfileReport());
+}
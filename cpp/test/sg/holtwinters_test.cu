@@ -71,6 +71,13 @@ class HoltWintersTest : public ::testing::TestWithParam<HoltWintersInputs<T>> {
     allocate(season_ptr, components_len, stream);
     allocate(SSE_error_ptr, batch_size, stream);
     allocate(forecast_ptr, batch_size * h, stream);
+    allocate(alpha_ptr, batch_size, stream);
+    allocate(beta_ptr, batch_size, stream);
+    allocate(gamma_ptr, batch_size, stream);
+    allocate(lower_ptr, batch_size * h, stream);
+    allocate(upper_ptr, batch_size * h, stream);
+    allocate(forecast2_ptr, batch_size * h, stream);
+    allocate(update_ptr, batch_size * h, stream);
 
     allocate(data, batch_size * n);
     updateDevice(data, dataset_h, batch_size * n, stream);
@@ -80,11 +87,36 @@ class HoltWintersTest : public ::testing::TestWithParam<HoltWintersInputs<T>> {
 
     ML::HoltWinters::fit(handle, n, batch_size, frequency, start_periods,
                          seasonal, epsilon, data, level_ptr, trend_ptr,
-                         season_ptr, SSE_error_ptr);
+                         season_ptr, SSE_error_ptr, alpha_ptr, beta_ptr,
+                         gamma_ptr);
 
     ML::HoltWinters::forecast(handle, n, batch_size, frequency, h, seasonal,
                               level_ptr, trend_ptr, season_ptr, forecast_ptr);
 
+    ML::HoltWinters::forecast(handle, n, batch_size, frequency, h, seasonal,
+                              level_ptr, trend_ptr, season_ptr, alpha_ptr,
+                              beta_ptr, gamma_ptr, SSE_error_ptr, T(0.95),
+                              forecast2_ptr, lower_ptr, upper_ptr);
+
+    // appending the point forecasts as observations leaves the forecasts
+    // of the following points unchanged
+    n_update = h / 2;
+    std::vector<T> forecast_h(batch_size * h), update_h(batch_size * n_update);
+    updateHost(forecast_h.data(), forecast_ptr, batch_size * h, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    for (int b = 0; b < batch_size; b++) {
+      for (int i = 0; i < n_update; i++) {
+        update_h[b * n_update + i] = forecast_h[i * batch_size + b];
+      }
+    }
+    updateDevice(update_ptr, update_h.data(), batch_size * n_update, stream);
+    ML::HoltWinters::update(handle, n, batch_size, frequency, n_update,
+                            seasonal, update_ptr, alpha_ptr, beta_ptr,
+                            gamma_ptr, level_ptr, trend_ptr, season_ptr);
+    ML::HoltWinters::forecast(handle, n, batch_size, frequency, h - n_update,
+                              seasonal, level_ptr, trend_ptr, season_ptr,
+                              forecast2_ptr);
+
     CUDA_CHECK(cudaStreamSynchronize(stream));
   }
 
@@ -97,6 +129,13 @@ class HoltWintersTest : public ::testing::TestWithParam<HoltWintersInputs<T>> {
     CUDA_CHECK(cudaFree(season_ptr));
     CUDA_CHECK(cudaFree(SSE_error_ptr));
     CUDA_CHECK(cudaFree(forecast_ptr));
+    CUDA_CHECK(cudaFree(alpha_ptr));
+    CUDA_CHECK(cudaFree(beta_ptr));
+    CUDA_CHECK(cudaFree(gamma_ptr));
+    CUDA_CHECK(cudaFree(lower_ptr));
+    CUDA_CHECK(cudaFree(upper_ptr));
+    CUDA_CHECK(cudaFree(forecast2_ptr));
+    CUDA_CHECK(cudaFree(update_ptr));
     CUDA_CHECK(cudaStreamDestroy(stream));
   }
 
@@ -105,12 +144,14 @@ class HoltWintersTest : public ::testing::TestWithParam<HoltWintersInputs<T>> {
   HoltWintersInputs<T> params;
   T *dataset_h, *test;
   T *data;
-  int n, h;
+  int n, h, n_update;
   int leveltrend_seed_len, season_seed_len, components_len;
   int leveltrend_coef_offset, season_coef_offset;
   int error_len;
   int batch_size, frequency, start_periods;
   T *SSE_error_ptr, *level_ptr, *trend_ptr, *season_ptr, *forecast_ptr;
+  T *alpha_ptr, *beta_ptr, *gamma_ptr, *lower_ptr, *upper_ptr;
+  T *forecast2_ptr, *update_ptr;
   T epsilon, mae_tolerance;
 };
 
@@ -183,6 +224,41 @@ TEST_P(HoltWintersTestD, Fit) {
   ASSERT_TRUE(mae < mae_tolerance);
 }
 
+template <typename T>
+void check_intervals(HoltWintersTest<T> &t) {
+  int len = t.batch_size * t.h;
+  std::vector<T> forecast_h(len), lower_h(len), upper_h(len);
+  updateHost(forecast_h.data(), t.forecast_ptr, len, t.stream);
+  updateHost(lower_h.data(), t.lower_ptr, len, t.stream);
+  updateHost(upper_h.data(), t.upper_ptr, len, t.stream);
+  CUDA_CHECK(cudaStreamSynchronize(t.stream));
+  for (int i = 0; i < len; i++) {
+    ASSERT_LE(lower_h[i], forecast_h[i]);
+    ASSERT_GE(upper_h[i], forecast_h[i]);
+    // the intervals widen with the horizon
+    if (i >= t.batch_size) {
+      ASSERT_GE(upper_h[i] - lower_h[i],
+                upper_h[i - t.batch_size] - lower_h[i - t.batch_size]);
+    }
+  }
+}
+
+TEST_P(HoltWintersTestF, Interval) { check_intervals(*this); }
+
+TEST_P(HoltWintersTestD, Interval) { check_intervals(*this); }
+
+TEST_P(HoltWintersTestF, Update) {
+  ASSERT_TRUE(devArrMatch(forecast_ptr + n_update * batch_size, forecast2_ptr,
+                          (h - n_update) * batch_size,
+                          CompareApprox<float>(1e-4)));
+}
+
+TEST_P(HoltWintersTestD, Update) {
+  ASSERT_TRUE(devArrMatch(forecast_ptr + n_update * batch_size, forecast2_ptr,
+                          (h - n_update) * batch_size,
+                          CompareApprox<double>(1e-10)));
+}
+
 INSTANTIATE_TEST_CASE_P(HoltWintersTests, HoltWintersTestF,
                         ::testing::ValuesIn(inputsf));
 INSTANTIATE_TEST_CASE_P(HoltWintersTests, HoltWintersTestD,
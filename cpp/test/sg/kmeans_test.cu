@@ -17,8 +17,12 @@
 #include <cuda_utils.h>
 #include <gtest/gtest.h>
 #include <test_utils.h>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include "kmeans/kmeans.cu"
+#include "random/make_blobs.h"
+#include "single_rank_comms.h"
 
 namespace ML {
 
@@ -49,6 +53,7 @@ class KmeansTest : public ::testing::TestWithParam<KmeansInputs<T>> {
     allocate(d_transform, n_samples * n_features);
     allocate(d_transform_ref, n_samples * n_features);
     allocate(d_labels, n_samples);
+    allocate(d_labels_async, n_samples);
     allocate(d_labels_ref, n_samples);
     allocate(d_centroids, params.n_clusters * n_features);
     allocate(d_centroids_ref, params.n_clusters * n_features);
@@ -76,7 +81,7 @@ class KmeansTest : public ::testing::TestWithParam<KmeansInputs<T>> {
     cumlHandle handle;
     handle.setStream(stream);
 
-    T inertia = 0;
+    inertia = 0;
     int n_iter = 0;
     kmeans::fit_predict(handle, params, d_srcdata, n_samples, n_features,
                         d_centroids, d_labels, inertia, n_iter);
@@ -84,6 +89,19 @@ class KmeansTest : public ::testing::TestWithParam<KmeansInputs<T>> {
     kmeans::transform(handle, params, d_centroids, d_srcdata, n_samples,
                       n_features, params.metric, d_transform);
 
+    // the same prediction, the host only waiting on the event
+    T *d_inertia;
+    allocate(d_inertia, 1);
+    cudaEvent_t done;
+    CUDA_CHECK(cudaEventCreate(&done));
+    kmeans::predict_async(handle, params, d_centroids, d_srcdata, n_samples,
+                          n_features, d_labels_async, d_inertia, done);
+    CUDA_CHECK(cudaEventSynchronize(done));
+    CUDA_CHECK(
+      cudaMemcpy(&inertia_async, d_inertia, sizeof(T), cudaMemcpyDefault));
+    CUDA_CHECK(cudaEventDestroy(done));
+    CUDA_CHECK(cudaFree(d_inertia));
+
     CUDA_CHECK(cudaStreamSynchronize(stream));
   }
 
@@ -95,6 +113,7 @@ class KmeansTest : public ::testing::TestWithParam<KmeansInputs<T>> {
   void TearDown() override {
     CUDA_CHECK(cudaFree(d_srcdata));
     CUDA_CHECK(cudaFree(d_labels));
+    CUDA_CHECK(cudaFree(d_labels_async));
     CUDA_CHECK(cudaFree(d_centroids));
     CUDA_CHECK(cudaFree(d_transform));
     CUDA_CHECK(cudaFree(d_labels_ref));
@@ -107,8 +126,9 @@ class KmeansTest : public ::testing::TestWithParam<KmeansInputs<T>> {
   KmeansInputs<T> testparams;
   T *d_srcdata;
   T *d_transform, *d_transform_ref;
-  int *d_labels, *d_labels_ref;
+  int *d_labels, *d_labels_async, *d_labels_ref;
   T *d_centroids, *d_centroids_ref;
+  T inertia, inertia_async;
   ML::kmeans::KMeansParams params;
   cudaStream_t stream;
 };
@@ -129,6 +149,9 @@ TEST_P(KmeansTestF, Result) {
   ASSERT_TRUE(devArrMatch(d_transform_ref, d_transform,
                           testparams.n_row * testparams.n_col,
                           CompareApproxAbs<float>(testparams.tol)));
+  ASSERT_TRUE(devArrMatch(d_labels, d_labels_async, testparams.n_row,
+                          Compare<int>()));
+  ASSERT_NEAR(inertia, inertia_async, testparams.tol);
 }
 
 typedef KmeansTest<double> KmeansTestD;
@@ -141,6 +164,9 @@ TEST_P(KmeansTestD, Result) {
   ASSERT_TRUE(devArrMatch(d_transform_ref, d_transform,
                           testparams.n_row * testparams.n_col,
                           CompareApproxAbs<double>(testparams.tol)));
+  ASSERT_TRUE(devArrMatch(d_labels, d_labels_async, testparams.n_row,
+                          Compare<int>()));
+  ASSERT_NEAR(inertia, inertia_async, testparams.tol);
 }
 
 INSTANTIATE_TEST_CASE_P(KmeansTests, KmeansTestF,
@@ -149,4 +175,784 @@ INSTANTIATE_TEST_CASE_P(KmeansTests, KmeansTestF,
 INSTANTIATE_TEST_CASE_P(KmeansTests, KmeansTestD,
                         ::testing::ValuesIn(inputsd2));
 
+template <typename T>
+struct KmeansMiniBatchInputs {
+  int n_clusters;
+  int n_row;
+  int n_col;
+  int batch_size;
+  // largest ratio of the mini-batch inertia over the Lloyd one
+  T max_ratio;
+};
+
+/**
+ * Fits well separated blobs with Lloyd and mini-batch k-means from the same
+ * seed; mini-batch k-means must find (nearly) the same clustering.
+ */
+template <typename T>
+class KmeansMiniBatchTest
+  : public ::testing::TestWithParam<KmeansMiniBatchInputs<T>> {
+ protected:
+  void SetUp() override {
+    testparams = ::testing::TestWithParam<KmeansMiniBatchInputs<T>>::GetParam();
+    int n_samples = testparams.n_row;
+    int n_features = testparams.n_col;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    cumlHandle handle;
+    handle.setStream(stream);
+
+    allocate(d_srcdata, n_samples * n_features);
+    allocate(d_labels, n_samples);
+    allocate(d_centroids, testparams.n_clusters * n_features);
+    Random::make_blobs<T, int>(d_srcdata, d_labels, n_samples, n_features,
+                               testparams.n_clusters,
+                               handle.getDeviceAllocator(), stream, nullptr,
+                               nullptr, (T)0.1);
+
+    ML::kmeans::KMeansParams params;
+    params.n_clusters = testparams.n_clusters;
+    params.seed = 7;
+    params.batch_size = testparams.batch_size;
+    kmeans::fit(handle, params, d_srcdata, n_samples, n_features, d_centroids,
+                lloyd_inertia, n_iter);
+
+    params.algorithm = ML::kmeans::KMeansParams::MiniBatch;
+    kmeans::fit(handle, params, d_srcdata, n_samples, n_features, d_centroids,
+                mini_batch_inertia, n_iter);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(d_srcdata));
+    CUDA_CHECK(cudaFree(d_labels));
+    CUDA_CHECK(cudaFree(d_centroids));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  KmeansMiniBatchInputs<T> testparams;
+  T *d_srcdata, *d_centroids;
+  int *d_labels;
+  T lloyd_inertia, mini_batch_inertia;
+  int n_iter;
+  cudaStream_t stream;
+};
+
+const std::vector<KmeansMiniBatchInputs<float>> inputsf_mb = {
+  {5, 10000, 8, 512, 1.1f}, {20, 50000, 16, 2048, 1.1f}};
+
+const std::vector<KmeansMiniBatchInputs<double>> inputsd_mb = {
+  {5, 10000, 8, 512, 1.1}, {20, 50000, 16, 2048, 1.1}};
+
+typedef KmeansMiniBatchTest<float> KmeansMiniBatchTestF;
+TEST_P(KmeansMiniBatchTestF, Result) {
+  ASSERT_GT(mini_batch_inertia, 0.f);
+  ASSERT_LE(mini_batch_inertia, testparams.max_ratio * lloyd_inertia);
+}
+
+typedef KmeansMiniBatchTest<double> KmeansMiniBatchTestD;
+TEST_P(KmeansMiniBatchTestD, Result) {
+  ASSERT_GT(mini_batch_inertia, 0.);
+  ASSERT_LE(mini_batch_inertia, testparams.max_ratio * lloyd_inertia);
+}
+
+INSTANTIATE_TEST_CASE_P(KmeansMiniBatchTests, KmeansMiniBatchTestF,
+                        ::testing::ValuesIn(inputsf_mb));
+
+INSTANTIATE_TEST_CASE_P(KmeansMiniBatchTests, KmeansMiniBatchTestD,
+                        ::testing::ValuesIn(inputsd_mb));
+
+template <typename T>
+struct KmeansHamerlyInputs {
+  int n_clusters;
+  int n_row;
+  int n_col;
+  T tol;
+};
+
+/**
+ * Fits blobs with Lloyd's and Hamerly's k-means from the same initial
+ * centroids; the bounds only skip distance computations, so both must reach
+ * the same centroids.
+ */
+template <typename T>
+class KmeansHamerlyTest
+  : public ::testing::TestWithParam<KmeansHamerlyInputs<T>> {
+ protected:
+  void SetUp() override {
+    testparams = ::testing::TestWithParam<KmeansHamerlyInputs<T>>::GetParam();
+    int n_samples = testparams.n_row;
+    int n_features = testparams.n_col;
+    int n_clusters = testparams.n_clusters;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    cumlHandle handle;
+    handle.setStream(stream);
+
+    allocate(d_srcdata, n_samples * n_features);
+    allocate(d_labels, n_samples);
+    allocate(d_centroids_lloyd, n_clusters * n_features);
+    allocate(d_centroids_hamerly, n_clusters * n_features);
+    // fewer blobs than clusters, so that samples move between the clusters of
+    // a blob for a few iterations
+    Random::make_blobs<T, int>(d_srcdata, d_labels, n_samples, n_features,
+                               std::max(1, n_clusters / 4),
+                               handle.getDeviceAllocator(), stream);
+
+    ML::kmeans::KMeansParams params;
+    params.n_clusters = n_clusters;
+    params.init = ML::kmeans::KMeansParams::Random;
+    params.tol = 0;
+    params.max_iter = 50;
+    params.seed = 3;
+    params.batch_size = 1000;
+    kmeans::fit(handle, params, d_srcdata, n_samples, n_features,
+                d_centroids_lloyd, lloyd_inertia, lloyd_n_iter);
+
+    params.algorithm = ML::kmeans::KMeansParams::Hamerly;
+    kmeans::fit(handle, params, d_srcdata, n_samples, n_features,
+                d_centroids_hamerly, hamerly_inertia, hamerly_n_iter);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(d_srcdata));
+    CUDA_CHECK(cudaFree(d_labels));
+    CUDA_CHECK(cudaFree(d_centroids_lloyd));
+    CUDA_CHECK(cudaFree(d_centroids_hamerly));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  KmeansHamerlyInputs<T> testparams;
+  T *d_srcdata, *d_centroids_lloyd, *d_centroids_hamerly;
+  int *d_labels;
+  T lloyd_inertia, hamerly_inertia;
+  int lloyd_n_iter, hamerly_n_iter;
+  cudaStream_t stream;
+};
+
+const std::vector<KmeansHamerlyInputs<float>> inputsf_hamerly = {
+  {1, 1000, 4, 1e-3f}, {8, 5000, 10, 1e-3f}, {64, 20000, 33, 1e-3f}};
+
+const std::vector<KmeansHamerlyInputs<double>> inputsd_hamerly = {
+  {1, 1000, 4, 1e-6}, {8, 5000, 10, 1e-6}, {64, 20000, 33, 1e-6}};
+
+typedef KmeansHamerlyTest<float> KmeansHamerlyTestF;
+TEST_P(KmeansHamerlyTestF, Result) {
+  ASSERT_TRUE(devArrMatch(d_centroids_lloyd, d_centroids_hamerly,
+                          testparams.n_clusters * testparams.n_col,
+                          CompareApprox<float>(testparams.tol)));
+  ASSERT_NEAR(lloyd_inertia, hamerly_inertia, testparams.tol * lloyd_inertia);
+}
+
+typedef KmeansHamerlyTest<double> KmeansHamerlyTestD;
+TEST_P(KmeansHamerlyTestD, Result) {
+  ASSERT_TRUE(devArrMatch(d_centroids_lloyd, d_centroids_hamerly,
+                          testparams.n_clusters * testparams.n_col,
+                          CompareApprox<double>(testparams.tol)));
+  ASSERT_NEAR(lloyd_inertia, hamerly_inertia, testparams.tol * lloyd_inertia);
+}
+
+INSTANTIATE_TEST_CASE_P(KmeansHamerlyTests, KmeansHamerlyTestF,
+                        ::testing::ValuesIn(inputsf_hamerly));
+
+INSTANTIATE_TEST_CASE_P(KmeansHamerlyTests, KmeansHamerlyTestD,
+                        ::testing::ValuesIn(inputsd_hamerly));
+
+struct KmeansFusedInputs {
+  int n_clusters;
+  int n_row;
+  int n_col;
+};
+
+/**
+ * Compares one fused assignment and centroid update with the unfused
+ * distance matrix, argmin and reduce_rows_by_key path, from the same
+ * centroids.
+ */
+class KmeansFusedTest : public ::testing::TestWithParam<KmeansFusedInputs> {
+ protected:
+  void SetUp() override {
+    testparams = ::testing::TestWithParam<KmeansFusedInputs>::GetParam();
+    int n_samples = testparams.n_row;
+    int n_features = testparams.n_col;
+    int n_clusters = testparams.n_clusters;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    cumlHandle handle;
+    handle.setStream(stream);
+    const cumlHandle_impl &h = handle.getImpl();
+    auto alloc = h.getDeviceAllocator();
+
+    Tensor<float, 2> X({n_samples, n_features}, alloc, stream);
+    Tensor<int, 1> blobLabels({n_samples}, alloc, stream);
+    Random::make_blobs<float, int>(X.data(), blobLabels.data(), n_samples,
+                                   n_features, 10, alloc, stream);
+    // the first samples are the centroids
+    auto centroids = X.template view<2>({n_clusters, n_features}, {0, 0});
+
+    ML::kmeans::KMeansParams params;
+    params.n_clusters = n_clusters;
+    MLCommon::device_buffer<char> workspace(alloc, stream);
+    Tensor<cub::KeyValuePair<int, float>, 1> minClusterAndDistance(
+      {n_samples}, alloc, stream);
+    Tensor<float, 2> pairwiseDistance({n_samples, n_clusters}, alloc, stream);
+    Tensor<float, 2> newCentroids({n_clusters, n_features}, alloc, stream);
+    Tensor<int, 1> counts({n_clusters}, alloc, stream);
+    Tensor<cub::KeyValuePair<int, float>, 1> fusedMinClusterAndDistance(
+      {n_samples}, alloc, stream);
+    Tensor<float, 2> fusedNewCentroids({n_clusters, n_features}, alloc,
+                                       stream);
+    Tensor<int, 1> fusedCounts({n_clusters}, alloc, stream);
+
+    ASSERT_TRUE(kmeans::detail::canFuseAssignUpdate<float>(
+      Distance::EucUnexpandedL2, n_features));
+    kmeans::detail::minClusterAndDistance(
+      h, params, X, centroids, pairwiseDistance, minClusterAndDistance,
+      workspace, Distance::EucUnexpandedL2, stream);
+    kmeans::detail::KeyValueIndexOp<int, float> conversion_op;
+    cub::TransformInputIterator<int,
+                                kmeans::detail::KeyValueIndexOp<int, float>,
+                                cub::KeyValuePair<int, float> *>
+      itr(minClusterAndDistance.data(), conversion_op);
+    kmeans::detail::updateCentroids(h, X, centroids, itr, newCentroids, counts,
+                                    workspace, stream);
+
+    kmeans::detail::fusedAssignUpdate(
+      h, X, centroids, fusedMinClusterAndDistance, fusedNewCentroids,
+      fusedCounts, workspace, Distance::EucUnexpandedL2, stream);
+
+    h_pairs.resize(n_samples);
+    h_fused_pairs.resize(n_samples);
+    h_centroids.resize(n_clusters * n_features);
+    h_fused_centroids.resize(n_clusters * n_features);
+    h_counts.resize(n_clusters);
+    h_fused_counts.resize(n_clusters);
+    updateHost(h_pairs.data(), minClusterAndDistance.data(), n_samples,
+               stream);
+    updateHost(h_fused_pairs.data(), fusedMinClusterAndDistance.data(),
+               n_samples, stream);
+    updateHost(h_centroids.data(), newCentroids.data(),
+               n_clusters * n_features, stream);
+    updateHost(h_fused_centroids.data(), fusedNewCentroids.data(),
+               n_clusters * n_features, stream);
+    updateHost(h_counts.data(), counts.data(), n_clusters, stream);
+    updateHost(h_fused_counts.data(), fusedCounts.data(), n_clusters, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override { CUDA_CHECK(cudaStreamDestroy(stream)); }
+
+ protected:
+  KmeansFusedInputs testparams;
+  std::vector<cub::KeyValuePair<int, float>> h_pairs, h_fused_pairs;
+  std::vector<float> h_centroids, h_fused_centroids;
+  std::vector<int> h_counts, h_fused_counts;
+  cudaStream_t stream;
+};
+
+const std::vector<KmeansFusedInputs> inputs_fused = {
+  {5, 5000, 3}, {100, 5000, 3}, {5, 5000, 40}, {100, 5000, 200}, {1, 77, 33}};
+
+TEST_P(KmeansFusedTest, Result) {
+  for (int i = 0; i < testparams.n_row; i++) {
+    ASSERT_EQ(h_pairs[i].key, h_fused_pairs[i].key);
+    ASSERT_NEAR(h_pairs[i].value, h_fused_pairs[i].value,
+                1e-4 * (1 + h_pairs[i].value));
+  }
+  for (int c = 0; c < testparams.n_clusters; c++)
+    ASSERT_EQ(h_counts[c], h_fused_counts[c]);
+  for (size_t i = 0; i < h_centroids.size(); i++)
+    ASSERT_NEAR(h_centroids[i], h_fused_centroids[i],
+                1e-4 * (1 + std::abs(h_centroids[i])));
+}
+
+INSTANTIATE_TEST_CASE_P(KmeansFusedTests, KmeansFusedTest,
+                        ::testing::ValuesIn(inputs_fused));
+
+struct KmeansWeightedInputs {
+  int n_clusters;
+  int n_row;
+  int n_col;
+};
+
+/**
+ * Integer sample weights must give the clustering of the dataset where each
+ * sample is repeated as many times as its weight, from the same centroids.
+ */
+class KmeansWeightedTest
+  : public ::testing::TestWithParam<KmeansWeightedInputs> {
+ protected:
+  void SetUp() override {
+    testparams = ::testing::TestWithParam<KmeansWeightedInputs>::GetParam();
+    int n_samples = testparams.n_row;
+    int n_features = testparams.n_col;
+    int n_clusters = testparams.n_clusters;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    cumlHandle handle;
+    handle.setStream(stream);
+    auto alloc = handle.getDeviceAllocator();
+
+    MLCommon::device_buffer<float> X(alloc, stream, n_samples * n_features);
+    MLCommon::device_buffer<int> blobLabels(alloc, stream, n_samples);
+    Random::make_blobs<float, int>(X.data(), blobLabels.data(), n_samples,
+                                   n_features, n_clusters, alloc, stream);
+    std::vector<float> h_X(n_samples * n_features), h_weights(n_samples);
+    updateHost(h_X.data(), X.data(), n_samples * n_features, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+
+    std::vector<float> h_repeated;
+    for (int i = 0; i < n_samples; i++) {
+      h_weights[i] = 1 + i % 3;
+      for (int w = 0; w < h_weights[i]; w++)
+        h_repeated.insert(h_repeated.end(), h_X.begin() + i * n_features,
+                          h_X.begin() + (i + 1) * n_features);
+    }
+    int n_repeated = h_repeated.size() / n_features;
+    MLCommon::device_buffer<float> weights(alloc, stream, n_samples);
+    MLCommon::device_buffer<float> repeated(alloc, stream, h_repeated.size());
+    updateDevice(weights.data(), h_weights.data(), n_samples, stream);
+    updateDevice(repeated.data(), h_repeated.data(), h_repeated.size(),
+                 stream);
+
+    // both fits start from the first samples
+    ML::kmeans::KMeansParams params;
+    params.n_clusters = n_clusters;
+    params.init = ML::kmeans::KMeansParams::Array;
+    allocate(d_centroids_weighted, n_clusters * n_features);
+    allocate(d_centroids_repeated, n_clusters * n_features);
+    copy(d_centroids_weighted, X.data(), n_clusters * n_features, stream);
+    copy(d_centroids_repeated, X.data(), n_clusters * n_features, stream);
+
+    int n_iter;
+    kmeans::fit(handle, params, X.data(), n_samples, n_features,
+                weights.data(), d_centroids_weighted, weighted_inertia, n_iter);
+    kmeans::fit(handle, params, repeated.data(), n_repeated, n_features,
+                d_centroids_repeated, repeated_inertia, n_iter);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(d_centroids_weighted));
+    CUDA_CHECK(cudaFree(d_centroids_repeated));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  KmeansWeightedInputs testparams;
+  float *d_centroids_weighted, *d_centroids_repeated;
+  float weighted_inertia, repeated_inertia;
+  cudaStream_t stream;
+};
+
+const std::vector<KmeansWeightedInputs> inputs_weighted = {
+  {5, 3000, 4}, {20, 10000, 16}};
+
+TEST_P(KmeansWeightedTest, Result) {
+  ASSERT_TRUE(devArrMatch(d_centroids_repeated, d_centroids_weighted,
+                          testparams.n_clusters * testparams.n_col,
+                          CompareApprox<float>(1e-3)));
+  ASSERT_NEAR(weighted_inertia, repeated_inertia, 1e-3 * repeated_inertia);
+}
+
+INSTANTIATE_TEST_CASE_P(KmeansWeightedTests, KmeansWeightedTest,
+                        ::testing::ValuesIn(inputs_weighted));
+
+struct KmeansSparseInputs {
+  int n_clusters;
+  int n_row;
+  int n_col;
+  // features of absolute value below are zeroed
+  float threshold;
+};
+
+/**
+ * Fits the CSR form of a sparsified dataset and its dense form from the same
+ * centroids; the centroids, the inertia and the labels must match.
+ */
+class KmeansSparseTest : public ::testing::TestWithParam<KmeansSparseInputs> {
+ protected:
+  void SetUp() override {
+    testparams = ::testing::TestWithParam<KmeansSparseInputs>::GetParam();
+    int n_samples = testparams.n_row;
+    int n_features = testparams.n_col;
+    int n_clusters = testparams.n_clusters;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    cumlHandle handle;
+    handle.setStream(stream);
+    auto alloc = handle.getDeviceAllocator();
+
+    MLCommon::device_buffer<float> X(alloc, stream, n_samples * n_features);
+    MLCommon::device_buffer<int> blobLabels(alloc, stream, n_samples);
+    Random::make_blobs<float, int>(X.data(), blobLabels.data(), n_samples,
+                                   n_features, n_clusters, alloc, stream);
+    std::vector<float> h_X(n_samples * n_features);
+    updateHost(h_X.data(), X.data(), n_samples * n_features, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+
+    std::vector<float> h_vals;
+    std::vector<int> h_row_ind(1, 0), h_cols;
+    for (int i = 0; i < n_samples; i++) {
+      for (int j = 0; j < n_features; j++) {
+        float &x = h_X[i * n_features + j];
+        if (std::abs(x) < testparams.threshold) {
+          x = 0;
+        } else {
+          h_vals.push_back(x);
+          h_cols.push_back(j);
+        }
+      }
+      h_row_ind.push_back(h_vals.size());
+    }
+    int nnz = h_vals.size();
+    MLCommon::device_buffer<float> vals(alloc, stream, nnz);
+    MLCommon::device_buffer<int> row_ind(alloc, stream, n_samples + 1);
+    MLCommon::device_buffer<int> cols(alloc, stream, nnz);
+    updateDevice(X.data(), h_X.data(), n_samples * n_features, stream);
+    updateDevice(vals.data(), h_vals.data(), nnz, stream);
+    updateDevice(row_ind.data(), h_row_ind.data(), n_samples + 1, stream);
+    updateDevice(cols.data(), h_cols.data(), nnz, stream);
+
+    ML::kmeans::KMeansParams params;
+    params.n_clusters = n_clusters;
+    params.init = ML::kmeans::KMeansParams::Array;
+    allocate(d_centroids_dense, n_clusters * n_features);
+    allocate(d_centroids_sparse, n_clusters * n_features);
+    allocate(d_labels_dense, n_samples);
+    allocate(d_labels_sparse, n_samples);
+    copy(d_centroids_dense, X.data(), n_clusters * n_features, stream);
+    copy(d_centroids_sparse, X.data(), n_clusters * n_features, stream);
+
+    int n_iter;
+    kmeans::fit(handle, params, X.data(), n_samples, n_features,
+                d_centroids_dense, dense_inertia, n_iter);
+    kmeans::fit_sparse(handle, params, vals.data(), row_ind.data(),
+                       cols.data(), nnz, n_samples, n_features, nullptr,
+                       d_centroids_sparse, sparse_inertia, n_iter);
+    float inertia;
+    kmeans::predict(handle, params, d_centroids_dense, X.data(), n_samples,
+                    n_features, d_labels_dense, inertia);
+    kmeans::predict_sparse(handle, params, d_centroids_sparse, vals.data(),
+                           row_ind.data(), cols.data(), nnz, n_samples,
+                           n_features, d_labels_sparse, inertia);
+
+    // k-means++ on the CSR matrix must find a clustering as good
+    params.init = ML::kmeans::KMeansParams::KMeansPlusPlus;
+    kmeans::fit_sparse(handle, params, vals.data(), row_ind.data(),
+                       cols.data(), nnz, n_samples, n_features, nullptr,
+                       d_centroids_sparse, plus_plus_inertia, n_iter);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(d_centroids_dense));
+    CUDA_CHECK(cudaFree(d_centroids_sparse));
+    CUDA_CHECK(cudaFree(d_labels_dense));
+    CUDA_CHECK(cudaFree(d_labels_sparse));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  KmeansSparseInputs testparams;
+  float *d_centroids_dense, *d_centroids_sparse;
+  int *d_labels_dense, *d_labels_sparse;
+  float dense_inertia, sparse_inertia, plus_plus_inertia;
+  cudaStream_t stream;
+};
+
+const std::vector<KmeansSparseInputs> inputs_sparse = {
+  {5, 3000, 8, 1.f}, {10, 5000, 64, 4.f}, {3, 1000, 300, 6.f}};
+
+TEST_P(KmeansSparseTest, Result) {
+  ASSERT_TRUE(devArrMatch(d_centroids_dense, d_centroids_sparse,
+                          testparams.n_clusters * testparams.n_col,
+                          CompareApprox<float>(1e-3)));
+  ASSERT_NEAR(dense_inertia, sparse_inertia, 1e-3 * dense_inertia);
+  ASSERT_TRUE(devArrMatch(d_labels_dense, d_labels_sparse, testparams.n_row,
+                          Compare<int>()));
+  ASSERT_LE(plus_plus_inertia, 1.1f * dense_inertia);
+}
+
+INSTANTIATE_TEST_CASE_P(KmeansSparseTests, KmeansSparseTest,
+                        ::testing::ValuesIn(inputs_sparse));
+
+struct KmeansMixedPrecisionInputs {
+  int n_clusters;
+  int n_row;
+  int n_col;
+  int metric;
+};
+
+/**
+ * Fits and predicts in full and in mixed precision from the same centroids;
+ * the refinement must keep the labels of the mixed precision predict exact.
+ */
+class KmeansMixedPrecisionTest
+  : public ::testing::TestWithParam<KmeansMixedPrecisionInputs> {
+ protected:
+  void SetUp() override {
+    testparams =
+      ::testing::TestWithParam<KmeansMixedPrecisionInputs>::GetParam();
+    int n_samples = testparams.n_row;
+    int n_features = testparams.n_col;
+    int n_clusters = testparams.n_clusters;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    cumlHandle handle;
+    handle.setStream(stream);
+    auto alloc = handle.getDeviceAllocator();
+
+    // offset blobs, whose large norms stress the expanded distances
+    MLCommon::device_buffer<float> X(alloc, stream, n_samples * n_features);
+    MLCommon::device_buffer<int> blobLabels(alloc, stream, n_samples);
+    Random::make_blobs<float, int>(
+      X.data(), blobLabels.data(), n_samples, n_features, n_clusters, alloc,
+      stream, nullptr, nullptr, 1.f, true, 20.f, 40.f);
+
+    ML::kmeans::KMeansParams params;
+    params.n_clusters = n_clusters;
+    params.metric = testparams.metric;
+    params.init = ML::kmeans::KMeansParams::Array;
+    allocate(d_centroids_full, n_clusters * n_features);
+    allocate(d_centroids_mixed, n_clusters * n_features);
+    allocate(d_labels_full, n_samples);
+    allocate(d_labels_mixed, n_samples);
+    copy(d_centroids_full, X.data(), n_clusters * n_features, stream);
+    copy(d_centroids_mixed, X.data(), n_clusters * n_features, stream);
+
+    int n_iter;
+    kmeans::fit(handle, params, X.data(), n_samples, n_features,
+                d_centroids_full, full_inertia, n_iter);
+    kmeans::predict(handle, params, d_centroids_full, X.data(), n_samples,
+                    n_features, d_labels_full, predict_full_inertia);
+
+    params.precision = ML::kmeans::KMeansParams::Mixed;
+    kmeans::fit(handle, params, X.data(), n_samples, n_features,
+                d_centroids_mixed, mixed_inertia, n_iter);
+    kmeans::predict(handle, params, d_centroids_full, X.data(), n_samples,
+                    n_features, d_labels_mixed, predict_mixed_inertia);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(d_centroids_full));
+    CUDA_CHECK(cudaFree(d_centroids_mixed));
+    CUDA_CHECK(cudaFree(d_labels_full));
+    CUDA_CHECK(cudaFree(d_labels_mixed));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  KmeansMixedPrecisionInputs testparams;
+  float *d_centroids_full, *d_centroids_mixed;
+  int *d_labels_full, *d_labels_mixed;
+  float full_inertia, mixed_inertia;
+  float predict_full_inertia, predict_mixed_inertia;
+  cudaStream_t stream;
+};
+
+const std::vector<KmeansMixedPrecisionInputs> inputs_mixed = {
+  {5, 3000, 16, MLCommon::Distance::EucExpandedL2},
+  {50, 20000, 128, MLCommon::Distance::EucExpandedL2},
+  {20, 10000, 37, MLCommon::Distance::EucExpandedL2Sqrt}};
+
+TEST_P(KmeansMixedPrecisionTest, Result) {
+  ASSERT_TRUE(devArrMatch(d_labels_full, d_labels_mixed, testparams.n_row,
+                          Compare<int>()));
+  ASSERT_NEAR(predict_full_inertia, predict_mixed_inertia,
+              1e-4 * predict_full_inertia);
+  ASSERT_TRUE(devArrMatch(d_centroids_full, d_centroids_mixed,
+                          testparams.n_clusters * testparams.n_col,
+                          CompareApprox<float>(1e-3)));
+  ASSERT_NEAR(full_inertia, mixed_inertia, 1e-3 * full_inertia);
+}
+
+INSTANTIATE_TEST_CASE_P(KmeansMixedPrecisionTests, KmeansMixedPrecisionTest,
+                        ::testing::ValuesIn(inputs_mixed));
+
+struct KmeansPartialFitInputs {
+  int n_clusters;
+  int n_row;
+  int n_col;
+  int n_chunks;
+};
+
+/**
+ * Feeds the samples to partial_fit in chunks, from the first samples and zero
+ * counts, and checks the centroids and the counts against a host reference.
+ */
+class KmeansPartialFitTest
+  : public ::testing::TestWithParam<KmeansPartialFitInputs> {
+ protected:
+  void SetUp() override {
+    testparams = ::testing::TestWithParam<KmeansPartialFitInputs>::GetParam();
+    int n_samples = testparams.n_row;
+    int n_features = testparams.n_col;
+    int n_clusters = testparams.n_clusters;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    cumlHandle handle;
+    handle.setStream(stream);
+    auto alloc = handle.getDeviceAllocator();
+
+    MLCommon::device_buffer<float> X(alloc, stream, n_samples * n_features);
+    MLCommon::device_buffer<int> blobLabels(alloc, stream, n_samples);
+    Random::make_blobs<float, int>(X.data(), blobLabels.data(), n_samples,
+                                   n_features, n_clusters, alloc, stream);
+    std::vector<float> h_X(n_samples * n_features);
+    updateHost(h_X.data(), X.data(), n_samples * n_features, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+
+    h_centroids.assign(h_X.begin(), h_X.begin() + n_clusters * n_features);
+    h_counts.assign(n_clusters, 0.f);
+    allocate(d_centroids, n_clusters * n_features);
+    allocate(d_counts, n_clusters, true);
+    updateDevice(d_centroids, h_centroids.data(), n_clusters * n_features,
+                 stream);
+
+    ML::kmeans::KMeansParams params;
+    params.n_clusters = n_clusters;
+    int chunk = MLCommon::ceildiv(n_samples, testparams.n_chunks);
+    for (int begin = 0; begin < n_samples; begin += chunk) {
+      int end = std::min(begin + chunk, n_samples);
+      float inertia;
+      kmeans::partial_fit(handle, params, X.data() + begin * n_features,
+                          end - begin, n_features, d_centroids, d_counts,
+                          inertia);
+      hostPartialFit(h_X, begin, end);
+    }
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  // assigns the samples [begin, end) to the nearest centroids, then moves the
+  // centroids to the means of all their samples
+  void hostPartialFit(const std::vector<float> &h_X, int begin, int end) {
+    int d = testparams.n_col, k = testparams.n_clusters;
+    std::vector<float> sums(k * d, 0.f), counts(k, 0.f);
+    for (int i = begin; i < end; i++) {
+      int best = 0;
+      float bestDist = 0;
+      for (int c = 0; c < k; c++) {
+        float dist = 0;
+        for (int f = 0; f < d; f++) {
+          float diff = h_X[i * d + f] - h_centroids[c * d + f];
+          dist += diff * diff;
+        }
+        if (c == 0 || dist < bestDist) {
+          best = c;
+          bestDist = dist;
+        }
+      }
+      for (int f = 0; f < d; f++) sums[best * d + f] += h_X[i * d + f];
+      counts[best] += 1;
+    }
+    for (int c = 0; c < k; c++) {
+      if (counts[c] == 0) continue;
+      for (int f = 0; f < d; f++) {
+        float &centroid = h_centroids[c * d + f];
+        centroid = (centroid * h_counts[c] + sums[c * d + f]) /
+                   (h_counts[c] + counts[c]);
+      }
+      h_counts[c] += counts[c];
+    }
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(d_centroids));
+    CUDA_CHECK(cudaFree(d_counts));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  KmeansPartialFitInputs testparams;
+  float *d_centroids, *d_counts;
+  std::vector<float> h_centroids, h_counts;
+  cudaStream_t stream;
+};
+
+const std::vector<KmeansPartialFitInputs> inputs_partial_fit = {
+  {5, 3000, 4, 1}, {5, 3000, 4, 3}, {20, 10000, 16, 10}};
+
+TEST_P(KmeansPartialFitTest, Result) {
+  ASSERT_TRUE(devArrMatchHost(h_counts.data(), d_counts,
+                              testparams.n_clusters, Compare<float>(), stream));
+  ASSERT_TRUE(devArrMatchHost(h_centroids.data(), d_centroids,
+                              testparams.n_clusters * testparams.n_col,
+                              CompareApprox<float>(1e-3), stream));
+}
+
+INSTANTIATE_TEST_CASE_P(KmeansPartialFitTests, KmeansPartialFitTest,
+                        ::testing::ValuesIn(inputs_partial_fit));
+
+struct KmeansMGInputs {
+  int n_clusters;
+  int n_row;
+  int n_col;
+};
+
+/**
+ * Fits with fit_mg() over a single-rank communicator and with fit() from the
+ * same centroids; the allreduced sums and counts of a single rank must give
+ * the centroids and inertia of the single-GPU fit.
+ */
+class KmeansMGTest : public ::testing::TestWithParam<KmeansMGInputs> {
+ protected:
+  void SetUp() override {
+    testparams = ::testing::TestWithParam<KmeansMGInputs>::GetParam();
+    int n_samples = testparams.n_row;
+    int n_features = testparams.n_col;
+    int n_clusters = testparams.n_clusters;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    cumlHandle handle;
+    handle.setStream(stream);
+    initSingleRankComms(handle);
+    auto alloc = handle.getDeviceAllocator();
+
+    MLCommon::device_buffer<float> X(alloc, stream, n_samples * n_features);
+    MLCommon::device_buffer<int> blobLabels(alloc, stream, n_samples);
+    Random::make_blobs<float, int>(X.data(), blobLabels.data(), n_samples,
+                                   n_features, n_clusters, alloc, stream);
+
+    ML::kmeans::KMeansParams params;
+    params.n_clusters = n_clusters;
+    params.init = ML::kmeans::KMeansParams::Array;
+    params.inertia_check = true;
+    allocate(d_centroids_sg, n_clusters * n_features);
+    allocate(d_centroids_mg, n_clusters * n_features);
+    copy(d_centroids_sg, X.data(), n_clusters * n_features, stream);
+    copy(d_centroids_mg, X.data(), n_clusters * n_features, stream);
+
+    kmeans::fit(handle, params, X.data(), n_samples, n_features,
+                d_centroids_sg, sg_inertia, sg_n_iter);
+    kmeans::fit_mg(handle, params, X.data(), n_samples, n_features,
+                   d_centroids_mg, mg_inertia, mg_n_iter);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(d_centroids_sg));
+    CUDA_CHECK(cudaFree(d_centroids_mg));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  KmeansMGInputs testparams;
+  float *d_centroids_sg, *d_centroids_mg;
+  float sg_inertia, mg_inertia;
+  int sg_n_iter, mg_n_iter;
+  cudaStream_t stream;
+};
+
+// the widest samples are too wide for the fused assignment and accumulation
+const std::vector<KmeansMGInputs> inputs_mg = {
+  {5, 3000, 4}, {20, 10000, 16}, {5, 2000, 2000}};
+
+TEST_P(KmeansMGTest, Result) {
+  ASSERT_TRUE(devArrMatch(d_centroids_sg, d_centroids_mg,
+                          testparams.n_clusters * testparams.n_col,
+                          CompareApprox<float>(1e-3)));
+  ASSERT_NEAR(sg_inertia, mg_inertia, 1e-3 * sg_inertia);
+  ASSERT_EQ(sg_n_iter, mg_n_iter);
+}
+
+INSTANTIATE_TEST_CASE_P(KmeansMGTests, KmeansMGTest,
+                        ::testing::ValuesIn(inputs_mg));
+
 }  // end namespace ML
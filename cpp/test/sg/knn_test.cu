@@ -18,8 +18,10 @@
 #include <gtest/gtest.h>
 #include <test_utils.h>
 #include <iostream>
+#include <random>
 #include <vector>
 #include "cuml/neighbors/knn.hpp"
+#include "single_rank_comms.h"
 
 namespace ML {
 
@@ -101,4 +103,146 @@ TEST_F(KNNTestF, Fit) {
   ASSERT_TRUE(devArrMatch(d_ref_I, d_pred_I, n * n, Compare<long>()));
 }
 
+// knnIndex on uniform random vectors, queried with its first n_query rows
+class KNNIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(0, 1);
+    h_inputs.resize(n * d);
+    for (float &val : h_inputs) val = dist(gen);
+    allocate(d_inputs, n * d);
+    allocate<long>(d_I, n_query * k);
+    allocate(d_D, n_query * k);
+    updateDevice(d_inputs, h_inputs.data(), n * d, handle.getStream());
+
+    // Reference distances: brute force, in row major order
+    std::vector<float *> ptrs(1, d_inputs);
+    std::vector<int> sizes(1, n);
+    brute_force_knn(handle, ptrs, sizes, d, d_inputs, n_query, d_I, d_D, k,
+                    true, true);
+    h_ref_D.resize(n_query * k);
+    updateHost(h_ref_D.data(), d_D, n_query * k, handle.getStream());
+    CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(d_inputs));
+    CUDA_CHECK(cudaFree(d_I));
+    CUDA_CHECK(cudaFree(d_D));
+  }
+
+  void search(const knnIndex &index) {
+    index.search(d_inputs, n_query, d_I, d_D, k);
+    h_I.resize(n_query * k);
+    h_D.resize(n_query * k);
+    updateHost(h_I.data(), d_I, n_query * k, handle.getStream());
+    updateHost(h_D.data(), d_D, n_query * k, handle.getStream());
+    CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+  }
+
+ protected:
+  int n = 2000;
+  int d = 16;
+  int n_query = 100;
+  int k = 10;
+  cumlHandle handle;
+  std::vector<float> h_inputs;
+  float *d_inputs, *d_D;
+  long *d_I;
+  std::vector<long> h_I;
+  std::vector<float> h_ref_D, h_D;
+};
+
+TEST_F(KNNIndexTest, IvfFlat) {
+  knnIndexParams params;
+  params.type = IVF_FLAT;
+  params.n_lists = 16;
+  params.n_probes = 16;  // all the lists: exact search
+  knnIndex index(handle, d, params);
+  index.build(d_inputs, n / 2);
+  index.add(d_inputs + n / 2 * d, n - n / 2);
+  ASSERT_EQ(index.size(), n);
+  search(index);
+  for (int i = 0; i < n_query * k; i++) {
+    ASSERT_NEAR(h_D[i], h_ref_D[i], 1e-4);
+  }
+
+  // The saved index returns the same results
+  std::vector<char> bytes;
+  index.save(&bytes);
+  knnIndex loaded(handle, d, knnIndexParams());
+  loaded.load(bytes.data(), bytes.size());
+  ASSERT_EQ(loaded.size(), n);
+  std::vector<long> saved_I = h_I;
+  search(loaded);
+  ASSERT_TRUE(h_I == saved_I);
+}
+
+TEST_F(KNNIndexTest, IvfPq) {
+  knnIndexParams params;
+  params.type = IVF_PQ;
+  params.n_lists = 16;
+  params.n_probes = 16;
+  params.pq_m = 8;
+  knnIndex index(handle, d, params);
+  index.build(d_inputs, n);
+  search(index);
+  // Each query is a row of the index, which it should find among its
+  // approximate nearest neighbors
+  int found = 0;
+  for (int q = 0; q < n_query; q++) {
+    for (int j = 0; j < k; j++) found += h_I[q * k + j] == q;
+  }
+  ASSERT_TRUE(found >= 0.9 * n_query);
+}
+
+// On the only rank of a communicator, the distributed classify and regress
+// vote as knn_classify and knn_regress on the neighbors of brute_force_knn
+TEST_F(KNNIndexTest, ClassifyRegressMG) {
+  initSingleRankComms(handle);
+  cudaStream_t stream = handle.getStream();
+  std::vector<int> h_classes(n);
+  std::vector<float> h_values(n);
+  for (int i = 0; i < n; i++) {
+    h_classes[i] = i % 4;
+    h_values[i] = h_inputs[i * d] + h_inputs[i * d + 1];
+  }
+  int *d_classes, *d_out, *d_out_mg;
+  float *d_values, *d_reg, *d_reg_mg;
+  allocate(d_classes, n);
+  allocate(d_values, n);
+  allocate(d_out, n_query);
+  allocate(d_out_mg, n_query);
+  allocate(d_reg, n_query);
+  allocate(d_reg_mg, n_query);
+  updateDevice(d_classes, h_classes.data(), n, stream);
+  updateDevice(d_values, h_values.data(), n, stream);
+
+  // two partitions, numbered one after the other
+  std::vector<float *> ptrs = {d_inputs, d_inputs + n / 2 * d};
+  std::vector<int> sizes = {n / 2, n - n / 2};
+  std::vector<int *> classes(1, d_classes);
+  std::vector<float *> values(1, d_values);
+  brute_force_knn(handle, ptrs, sizes, d, d_inputs, n_query, d_I, d_D, k,
+                  true, true);
+  knn_classify(handle, d_out, d_I, classes, n_query, k);
+  knn_regress(handle, d_reg, d_I, values, n_query, k);
+  brute_force_knn_classify_mg(handle, d_out_mg, ptrs, sizes, d, d_inputs,
+                              n_query, k, classes, true, true);
+  brute_force_knn_regress_mg(handle, d_reg_mg, ptrs, sizes, d, d_inputs,
+                             n_query, k, values, true, true);
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  ASSERT_TRUE(devArrMatch(d_out, d_out_mg, n_query, Compare<int>()));
+  ASSERT_TRUE(
+    devArrMatch(d_reg, d_reg_mg, n_query, CompareApprox<float>(1e-5f)));
+  CUDA_CHECK(cudaFree(d_classes));
+  CUDA_CHECK(cudaFree(d_values));
+  CUDA_CHECK(cudaFree(d_out));
+  CUDA_CHECK(cudaFree(d_out_mg));
+  CUDA_CHECK(cudaFree(d_reg));
+  CUDA_CHECK(cudaFree(d_reg_mg));
+}
+
 }  // end namespace ML
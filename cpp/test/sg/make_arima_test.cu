@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuda_utils.h>
+#include <cuml/datasets/make_arima.hpp>
+#include <gtest/gtest.h>
+#include <test_utils.h>
+#include <cmath>
+#include <vector>
+
+namespace ML {
+
+using namespace MLCommon;
+
+struct MakeArimaInputs {
+  int batch_size, n_obs;
+  ARIMAOrder order;
+  uint64_t seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const MakeArimaInputs& dims) {
+  return os;
+}
+
+/**
+ * The series of the AR(1) models, basic or seasonal, once differenced as the
+ * order says, have the mean mu and the autocorrelation at the lag of the AR
+ * polynomial of its coefficient
+ */
+class MakeArimaTest : public ::testing::TestWithParam<MakeArimaInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<MakeArimaInputs>::GetParam();
+    cumlHandle handle;
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    handle.setStream(stream);
+    int N = params.order.complexity();
+    double *d_out, *d_params;
+    allocate(d_out, params.n_obs * params.batch_size);
+    allocate(d_params, N * params.batch_size);
+    Datasets::make_arima(handle, d_out, params.batch_size, params.n_obs,
+                         params.order, 1.0, 2.0, params.seed, d_params);
+    h_out.resize(params.n_obs * params.batch_size);
+    h_params.resize(N * params.batch_size);
+    updateHost(h_out.data(), d_out, h_out.size(), stream);
+    updateHost(h_params.data(), d_params, h_params.size(), stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaFree(d_out));
+    CUDA_CHECK(cudaFree(d_params));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+ protected:
+  MakeArimaInputs params;
+  std::vector<double> h_out, h_params;
+};
+
+TEST_P(MakeArimaTest, Result) {
+  const ARIMAOrder& o = params.order;
+  const int N = o.complexity();
+  const int lag = o.p > 0 ? 1 : o.s;
+  for (int b = 0; b < params.batch_size; ++b) {
+    std::vector<double> y(h_out.begin() + b * params.n_obs,
+                          h_out.begin() + (b + 1) * params.n_obs);
+    for (int i = 0; i < o.D; i++) {
+      for (size_t t = 0; t + o.s < y.size(); t++) y[t] = y[t + o.s] - y[t];
+      y.resize(y.size() - o.s);
+    }
+    for (int i = 0; i < o.d; i++) {
+      for (size_t t = 0; t + 1 < y.size(); t++) y[t] = y[t + 1] - y[t];
+      y.resize(y.size() - 1);
+    }
+    const double* param = h_params.data() + b * N;
+    double mean = 0.0;
+    for (double v : y) mean += v;
+    mean /= y.size();
+    if (o.k()) ASSERT_NEAR(param[0], mean, 0.3) << "series " << b;
+    double c0 = 0.0, cl = 0.0;
+    for (size_t t = 0; t < y.size(); t++) {
+      c0 += (y[t] - mean) * (y[t] - mean);
+      if (t >= size_t(lag)) cl += (y[t] - mean) * (y[t - lag] - mean);
+    }
+    // the coefficient of the only AR polynomial
+    double phi = param[o.k()];
+    ASSERT_NEAR(phi, cl / c0, 0.1) << "series " << b;
+  }
+}
+
+const std::vector<MakeArimaInputs> inputs = {
+  {20, 5000, {1, 0, 0, 0, 0, 0, 0, 0}, 1234ULL},
+  {20, 5000, {1, 1, 0, 0, 0, 0, 0, 0}, 1234ULL},
+  {20, 5000, {0, 0, 0, 1, 0, 0, 4, 0}, 4321ULL},
+  {20, 5000, {0, 1, 0, 1, 1, 0, 12, 0}, 4321ULL}};
+
+INSTANTIATE_TEST_CASE_P(MakeArimaTests, MakeArimaTest,
+                        ::testing::ValuesIn(inputs));
+
+}  // namespace ML
@@ -19,7 +19,9 @@
 #include <test_utils.h>
 #include <vector>
 #include "glm/ols.h"
+#include "glm/ols_mg.h"
 #include "ml_utils.h"
+#include "single_rank_comms.h"
 
 namespace ML {
 namespace GLM {
@@ -58,6 +60,10 @@ class OlsTest : public ::testing::TestWithParam<OlsInputs<T>> {
     allocate(pred2_ref, params.n_row_2);
     allocate(pred3, params.n_row_2);
     allocate(pred3_ref, params.n_row_2);
+    allocate(coef4, params.n_col);
+    allocate(coef5, params.n_col);
+    allocate(coef6, params.n_col);
+    allocate(coef7, params.n_col);
 
     std::vector<T> data_h = {1.0, 1.0, 2.0, 2.0, 1.0, 2.0, 2.0, 3.0};
     data_h.resize(len);
@@ -122,6 +128,23 @@ class OlsTest : public ::testing::TestWithParam<OlsInputs<T>> {
 
     olsPredict(handle.getImpl(), pred_data, params.n_row_2, params.n_col, coef3,
                intercept3, pred3, stream);
+
+    // the fits of coef and coef2, streaming blocks of 3 rows from the host
+    intercept4 = T(0);
+    olsFitHost(handle.getImpl(), data_h.data(), params.n_row, params.n_col,
+               labels_h.data(), coef4, &intercept4, false, 3, stream);
+
+    olsFitHost(handle.getImpl(), data_h.data(), params.n_row, params.n_col,
+               labels_h.data(), coef5, &intercept5, true, 3, stream);
+
+    // the fits of coef and coef2 on the only rank of a communicator
+    initSingleRankComms(handle);
+    updateDevice(data, data_h.data(), len, stream);
+    updateDevice(labels, labels_h.data(), params.n_row, stream);
+    olsFitMG(handle.getImpl(), data, params.n_row, params.n_col, labels, coef6,
+             &intercept6, false, stream);
+    olsFitMG(handle.getImpl(), data, params.n_row, params.n_col, labels, coef7,
+             &intercept7, true, stream);
   }
 
   void basicTest2() {
@@ -174,6 +197,10 @@ class OlsTest : public ::testing::TestWithParam<OlsInputs<T>> {
     CUDA_CHECK(cudaFree(pred2_ref));
     CUDA_CHECK(cudaFree(pred3));
     CUDA_CHECK(cudaFree(pred3_ref));
+    CUDA_CHECK(cudaFree(coef4));
+    CUDA_CHECK(cudaFree(coef5));
+    CUDA_CHECK(cudaFree(coef6));
+    CUDA_CHECK(cudaFree(coef7));
 
     CUDA_CHECK(cudaFree(data_sc));
     CUDA_CHECK(cudaFree(labels_sc));
@@ -188,7 +215,9 @@ class OlsTest : public ::testing::TestWithParam<OlsInputs<T>> {
   T *coef2, *coef2_ref, *pred2, *pred2_ref;
   T *coef3, *coef3_ref, *pred3, *pred3_ref;
   T *data_sc, *labels_sc, *coef_sc, *coef_sc_ref;
-  T intercept, intercept2, intercept3;
+  T *coef4, *coef5, *coef6, *coef7;
+  T intercept, intercept2, intercept3, intercept4, intercept5, intercept6,
+    intercept7;
   cumlHandle handle;
   cudaStream_t stream;
 };
@@ -221,6 +250,22 @@ TEST_P(OlsTestF, Fit) {
 
   ASSERT_TRUE(
     devArrMatch(coef_sc_ref, coef_sc, 1, CompareApproxAbs<float>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(coef_ref, coef4, params.n_col,
+                          CompareApproxAbs<float>(params.tol)));
+  ASSERT_EQ(intercept4, float(0));
+
+  ASSERT_TRUE(devArrMatch(coef2_ref, coef5, params.n_col,
+                          CompareApproxAbs<float>(params.tol)));
+  ASSERT_NEAR(intercept2, intercept5, params.tol);
+
+  ASSERT_TRUE(devArrMatch(coef_ref, coef6, params.n_col,
+                          CompareApproxAbs<float>(params.tol)));
+  ASSERT_EQ(intercept6, float(0));
+
+  ASSERT_TRUE(devArrMatch(coef2_ref, coef7, params.n_col,
+                          CompareApproxAbs<float>(params.tol)));
+  ASSERT_NEAR(intercept2, intercept7, params.tol);
 }
 
 typedef OlsTest<double> OlsTestD;
@@ -245,6 +290,22 @@ TEST_P(OlsTestD, Fit) {
 
   ASSERT_TRUE(
     devArrMatch(coef_sc_ref, coef_sc, 1, CompareApproxAbs<double>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(coef_ref, coef4, params.n_col,
+                          CompareApproxAbs<double>(params.tol)));
+  ASSERT_EQ(intercept4, double(0));
+
+  ASSERT_TRUE(devArrMatch(coef2_ref, coef5, params.n_col,
+                          CompareApproxAbs<double>(params.tol)));
+  ASSERT_NEAR(intercept2, intercept5, params.tol);
+
+  ASSERT_TRUE(devArrMatch(coef_ref, coef6, params.n_col,
+                          CompareApproxAbs<double>(params.tol)));
+  ASSERT_EQ(intercept6, double(0));
+
+  ASSERT_TRUE(devArrMatch(coef2_ref, coef7, params.n_col,
+                          CompareApproxAbs<double>(params.tol)));
+  ASSERT_NEAR(intercept2, intercept7, params.tol);
 }
 
 INSTANTIATE_TEST_CASE_P(OlsTests, OlsTestF, ::testing::ValuesIn(inputsf2));
@@ -20,7 +20,9 @@
 #include <vector>
 #include "ml_utils.h"
 #include "pca/pca.h"
+#include "pca/pca_mg.h"
 #include "random/rng.h"
+#include "single_rank_comms.h"
 #include "test_utils.h"
 
 namespace ML {
@@ -103,6 +105,69 @@ class PcaTest : public ::testing::TestWithParam<PcaInputs<T>> {
                  mean, prms, stream);
     pcaInverseTransform(handle.getImpl(), trans_data, components, singular_vals,
                         mean, data_back, prms, stream);
+
+    // whitening scales the projections by 1 / sqrt(explained_vars)
+    allocate(trans_data_whiten, len);
+    allocate(trans_data_whiten_ref, len);
+    std::vector<T> trans_data_whiten_ref_h(len);
+    for (int i = 0; i < len; i++) {
+      trans_data_whiten_ref_h[i] =
+        trans_data_ref_h[i] / sqrt(explained_vars_ref_h[i / params.n_row]);
+    }
+    updateDevice(trans_data_whiten_ref, trans_data_whiten_ref_h.data(), len,
+                 stream);
+    paramsPCA prms_whiten = prms;
+    prms_whiten.whiten = true;
+    pcaTransform(handle.getImpl(), data, components, trans_data_whiten,
+                 singular_vals, mean, prms_whiten, stream);
+
+    // the same rows, fitted in batches of two rows and one row
+    allocate(batch, len);
+    allocate(scatter, len_comp);
+    allocate(components3, len_comp);
+    allocate(explained_vars3, params.n_col);
+    allocate(explained_var_ratio3, params.n_col);
+    allocate(singular_vals3, params.n_col);
+    allocate(mean3, params.n_col);
+    size_t n_seen = 0;
+    paramsPCA prms_batch = prms;
+    std::vector<T> batch1_h = {1.0, 2.0, 4.0, 2.0};
+    updateDevice(batch, batch1_h.data(), 4, stream);
+    prms_batch.n_rows = 2;
+    pcaPartialFit(handle.getImpl(), batch, mean3, scatter, &n_seen, prms_batch,
+                  stream);
+    std::vector<T> batch2_h = {5.0, 1.0};
+    updateDevice(batch, batch2_h.data(), 2, stream);
+    prms_batch.n_rows = 1;
+    pcaPartialFit(handle.getImpl(), batch, mean3, scatter, &n_seen, prms_batch,
+                  stream);
+    pcaFitScatter(handle.getImpl(), scatter, n_seen, components3,
+                  explained_vars3, explained_var_ratio3, singular_vals3, prms,
+                  stream);
+
+    // the randomized solver is exact when all the components are kept
+    allocate(components4, len_comp);
+    allocate(explained_vars4, params.n_col);
+    allocate(explained_var_ratio4, params.n_col);
+    allocate(singular_vals4, params.n_col);
+    allocate(mean4, params.n_col);
+    paramsPCA prms_rsvd = prms;
+    prms_rsvd.algorithm = solver::RANDOMIZED;
+    pcaFit(handle.getImpl(), data, components4, explained_vars4,
+           explained_var_ratio4, singular_vals4, mean4, noise_vars, prms_rsvd,
+           stream);
+
+    // the same rows on the only rank of a communicator
+    allocate(components5, len_comp);
+    allocate(explained_vars5, params.n_col);
+    allocate(explained_var_ratio5, params.n_col);
+    allocate(singular_vals5, params.n_col);
+    allocate(mean5, params.n_col);
+    allocate(noise_vars5, 1);
+    initSingleRankComms(handle);
+    pcaFitMG(handle.getImpl(), data, components5, explained_vars5,
+             explained_var_ratio5, singular_vals5, mean5, noise_vars5, prms,
+             stream);
   }
 
   void advancedTest() {
@@ -170,6 +235,26 @@ class PcaTest : public ::testing::TestWithParam<PcaInputs<T>> {
     CUDA_CHECK(cudaFree(singular_vals2));
     CUDA_CHECK(cudaFree(mean2));
     CUDA_CHECK(cudaFree(noise_vars2));
+    CUDA_CHECK(cudaFree(trans_data_whiten));
+    CUDA_CHECK(cudaFree(trans_data_whiten_ref));
+    CUDA_CHECK(cudaFree(batch));
+    CUDA_CHECK(cudaFree(scatter));
+    CUDA_CHECK(cudaFree(components3));
+    CUDA_CHECK(cudaFree(explained_vars3));
+    CUDA_CHECK(cudaFree(explained_var_ratio3));
+    CUDA_CHECK(cudaFree(singular_vals3));
+    CUDA_CHECK(cudaFree(mean3));
+    CUDA_CHECK(cudaFree(components4));
+    CUDA_CHECK(cudaFree(explained_vars4));
+    CUDA_CHECK(cudaFree(explained_var_ratio4));
+    CUDA_CHECK(cudaFree(singular_vals4));
+    CUDA_CHECK(cudaFree(mean4));
+    CUDA_CHECK(cudaFree(components5));
+    CUDA_CHECK(cudaFree(explained_vars5));
+    CUDA_CHECK(cudaFree(explained_var_ratio5));
+    CUDA_CHECK(cudaFree(singular_vals5));
+    CUDA_CHECK(cudaFree(mean5));
+    CUDA_CHECK(cudaFree(noise_vars5));
     CUDA_CHECK(cudaStreamDestroy(stream));
   }
 
@@ -181,6 +266,14 @@ class PcaTest : public ::testing::TestWithParam<PcaInputs<T>> {
 
   T *data2, *data2_trans, *data2_back, *components2, *explained_vars2,
     *explained_var_ratio2, *singular_vals2, *mean2, *noise_vars2;
+
+  T *trans_data_whiten, *trans_data_whiten_ref;
+  T *batch, *scatter, *components3, *explained_vars3, *explained_var_ratio3,
+    *singular_vals3, *mean3;
+  T *components4, *explained_vars4, *explained_var_ratio4, *singular_vals4,
+    *mean4;
+  T *components5, *explained_vars5, *explained_var_ratio5, *singular_vals5,
+    *mean5, *noise_vars5;
   cumlHandle handle;
   cudaStream_t stream;
 };
@@ -219,6 +312,68 @@ TEST_P(PcaTestLeftVecD, Result) {
                           CompareApproxAbs<double>(params.tolerance)));
 }
 
+typedef PcaTest<float> PcaTestPartialFitF;
+TEST_P(PcaTestPartialFitF, Result) {
+  ASSERT_TRUE(devArrMatch(explained_vars3, explained_vars_ref, params.n_col,
+                          CompareApproxAbs<float>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(components3, components_ref,
+                          (params.n_col * params.n_col),
+                          CompareApproxAbs<float>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(mean3, mean, params.n_col,
+                          CompareApproxAbs<float>(params.tolerance)));
+}
+
+typedef PcaTest<double> PcaTestPartialFitD;
+TEST_P(PcaTestPartialFitD, Result) {
+  ASSERT_TRUE(devArrMatch(explained_vars3, explained_vars_ref, params.n_col,
+                          CompareApproxAbs<double>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(components3, components_ref,
+                          (params.n_col * params.n_col),
+                          CompareApproxAbs<double>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(mean3, mean, params.n_col,
+                          CompareApproxAbs<double>(params.tolerance)));
+}
+
+typedef PcaTest<float> PcaTestRandomizedF;
+TEST_P(PcaTestRandomizedF, Result) {
+  ASSERT_TRUE(devArrMatch(explained_vars4, explained_vars_ref, params.n_col,
+                          CompareApproxAbs<float>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(explained_var_ratio4, explained_var_ratio,
+                          params.n_col,
+                          CompareApproxAbs<float>(params.tolerance)));
+}
+
+typedef PcaTest<double> PcaTestRandomizedD;
+TEST_P(PcaTestRandomizedD, Result) {
+  ASSERT_TRUE(devArrMatch(explained_vars4, explained_vars_ref, params.n_col,
+                          CompareApproxAbs<double>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(explained_var_ratio4, explained_var_ratio,
+                          params.n_col,
+                          CompareApproxAbs<double>(params.tolerance)));
+}
+
+typedef PcaTest<float> PcaTestMGF;
+TEST_P(PcaTestMGF, Result) {
+  ASSERT_TRUE(devArrMatch(explained_vars5, explained_vars, params.n_col,
+                          CompareApproxAbs<float>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(components5, components,
+                          (params.n_col * params.n_col),
+                          CompareApproxAbs<float>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(mean5, mean, params.n_col,
+                          CompareApproxAbs<float>(params.tolerance)));
+}
+
+typedef PcaTest<double> PcaTestMGD;
+TEST_P(PcaTestMGD, Result) {
+  ASSERT_TRUE(devArrMatch(explained_vars5, explained_vars, params.n_col,
+                          CompareApproxAbs<double>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(components5, components,
+                          (params.n_col * params.n_col),
+                          CompareApproxAbs<double>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(mean5, mean, params.n_col,
+                          CompareApproxAbs<double>(params.tolerance)));
+}
+
 typedef PcaTest<float> PcaTestTransDataF;
 TEST_P(PcaTestTransDataF, Result) {
   ASSERT_TRUE(devArrMatch(trans_data, trans_data_ref,
@@ -233,6 +388,20 @@ TEST_P(PcaTestTransDataD, Result) {
                           CompareApproxAbs<double>(params.tolerance)));
 }
 
+typedef PcaTest<float> PcaTestWhitenF;
+TEST_P(PcaTestWhitenF, Result) {
+  ASSERT_TRUE(devArrMatch(trans_data_whiten, trans_data_whiten_ref,
+                          (params.n_row * params.n_col),
+                          CompareApproxAbs<float>(params.tolerance)));
+}
+
+typedef PcaTest<double> PcaTestWhitenD;
+TEST_P(PcaTestWhitenD, Result) {
+  ASSERT_TRUE(devArrMatch(trans_data_whiten, trans_data_whiten_ref,
+                          (params.n_row * params.n_col),
+                          CompareApproxAbs<double>(params.tolerance)));
+}
+
 typedef PcaTest<float> PcaTestDataVecSmallF;
 TEST_P(PcaTestDataVecSmallF, Result) {
   ASSERT_TRUE(devArrMatch(data, data_back, (params.n_col * params.n_col),
@@ -269,12 +438,36 @@ INSTANTIATE_TEST_CASE_P(PcaTests, PcaTestLeftVecF,
 INSTANTIATE_TEST_CASE_P(PcaTests, PcaTestLeftVecD,
                         ::testing::ValuesIn(inputsd2));
 
+INSTANTIATE_TEST_CASE_P(PcaTests, PcaTestPartialFitF,
+                        ::testing::ValuesIn(inputsf2));
+
+INSTANTIATE_TEST_CASE_P(PcaTests, PcaTestPartialFitD,
+                        ::testing::ValuesIn(inputsd2));
+
+INSTANTIATE_TEST_CASE_P(PcaTests, PcaTestRandomizedF,
+                        ::testing::ValuesIn(inputsf2));
+
+INSTANTIATE_TEST_CASE_P(PcaTests, PcaTestRandomizedD,
+                        ::testing::ValuesIn(inputsd2));
+
+INSTANTIATE_TEST_CASE_P(PcaTests, PcaTestWhitenF,
+                        ::testing::ValuesIn(inputsf2));
+
+INSTANTIATE_TEST_CASE_P(PcaTests, PcaTestWhitenD,
+                        ::testing::ValuesIn(inputsd2));
+
 INSTANTIATE_TEST_CASE_P(PcaTests, PcaTestDataVecSmallF,
                         ::testing::ValuesIn(inputsf2));
 
 INSTANTIATE_TEST_CASE_P(PcaTests, PcaTestDataVecSmallD,
                         ::testing::ValuesIn(inputsd2));
 
+INSTANTIATE_TEST_CASE_P(PcaTests, PcaTestMGF,
+                        ::testing::ValuesIn(inputsf2));
+
+INSTANTIATE_TEST_CASE_P(PcaTests, PcaTestMGD,
+                        ::testing::ValuesIn(inputsd2));
+
 INSTANTIATE_TEST_CASE_P(PcaTests, PcaTestTransDataF,
                         ::testing::ValuesIn(inputsf2));
 
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuda_utils.h>
+#include <cuml/preprocessing/preprocessing.hpp>
+#include <gtest/gtest.h>
+#include <test_utils.h>
+#include <cmath>
+#include <vector>
+
+namespace ML {
+
+using namespace MLCommon;
+using namespace Preprocessing;
+
+class PreprocessingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    handle.setStream(stream);
+  }
+
+  void TearDown() override {
+    for (float* ptr : ptrs) CUDA_CHECK(cudaFree(ptr));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  /** a device copy of h, freed at the end of the test */
+  float* toDevice(const std::vector<float>& h) {
+    float* d;
+    allocate(d, h.size());
+    updateDevice(d, h.data(), h.size(), stream);
+    ptrs.push_back(d);
+    return d;
+  }
+
+  /** a device array of n elements, freed at the end of the test */
+  float* deviceArray(size_t n) { return toDevice(std::vector<float>(n)); }
+
+  std::vector<float> toHost(const float* d, size_t n) {
+    std::vector<float> h(n);
+    updateHost(h.data(), d, n, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    return h;
+  }
+
+  void expectNear(const std::vector<float>& expected, const float* d) {
+    std::vector<float> h = toHost(d, expected.size());
+    for (size_t k = 0; k < expected.size(); ++k) {
+      EXPECT_NEAR(expected[k], h[k], 1e-5) << "at " << k;
+    }
+  }
+
+  cumlHandle handle;
+  cudaStream_t stream;
+  std::vector<float*> ptrs;
+};
+
+// the second feature is constant
+const std::vector<float> X_scale = {1.f, 2.f, 3.f, 4.f, 10.f, 10.f, 10.f, 10.f};
+
+TEST_F(PreprocessingTest, StandardScaler) {
+  float* X = toDevice(X_scale);
+  float* mean = deviceArray(2);
+  float* scale = deviceArray(2);
+  float* out = deviceArray(8);
+  standardScalerFitTransform(handle, X, 4, 2, mean, scale, true, true, out,
+                             true);
+  float s = std::sqrt(1.25f);
+  expectNear({2.5f, 10.f}, mean);
+  expectNear({s, 1.f}, scale);
+  expectNear({-1.5f / s, 0.f, -0.5f / s, 0.f, 0.5f / s, 0.f, 1.5f / s, 0.f},
+             out);
+
+  // in place, only centered
+  standardScalerTransform(handle, X, 4, 2, mean, scale, true, false, X);
+  expectNear({-1.5f, -0.5f, 0.5f, 1.5f, 0.f, 0.f, 0.f, 0.f}, X);
+}
+
+TEST_F(PreprocessingTest, MinMaxScaler) {
+  float* X = toDevice(X_scale);
+  float* data_min = deviceArray(2);
+  float* data_max = deviceArray(2);
+  float* out = deviceArray(8);
+  minMaxScalerFitTransform(handle, X, 4, 2, data_min, data_max, -1.f, 1.f,
+                           out);
+  expectNear({1.f, 10.f}, data_min);
+  expectNear({4.f, 10.f}, data_max);
+  expectNear({-1.f, -1.f / 3, 1.f / 3, 1.f, -1.f, -1.f, -1.f, -1.f}, out);
+}
+
+TEST_F(PreprocessingTest, Encoders) {
+  float* X = toDevice({3.f, 1.f, 3.f, 2.f, 5.f, 5.f, -7.f, 5.f});
+  std::vector<std::vector<float>> categories;
+  encoderFit(handle, X, 4, 2, categories);
+  ASSERT_EQ(size_t(2), categories.size());
+  EXPECT_EQ(std::vector<float>({1.f, 2.f, 3.f}), categories[0]);
+  EXPECT_EQ(std::vector<float>({-7.f, 5.f}), categories[1]);
+
+  // 4 and 6 are unknown
+  float* Y = toDevice({3.f, 4.f, 1.f, 5.f, 6.f, -7.f});
+  float* ordinal = deviceArray(6);
+  ordinalEncoderTransform(handle, Y, 3, 2, categories, ordinal);
+  expectNear({2.f, -1.f, 0.f, 1.f, -1.f, 0.f}, ordinal);
+
+  float* one_hot = deviceArray(15);
+  oneHotEncoderTransform(handle, Y, 3, 2, categories, one_hot, true);
+  expectNear({0.f, 0.f, 1.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 0.f,
+              1.f, 0.f, 0.f, 1.f, 0.f},
+             one_hot);
+}
+
+TEST_F(PreprocessingTest, KBinsDiscretizer) {
+  float* X = toDevice({0.f, 1.f, 2.f, 3.f, 1.f, 2.f, 3.f, 10.f});
+  float* edges = deviceArray(6);
+  float* out = deviceArray(8);
+  kBinsDiscretizerFitTransform(handle, X, 4, 2, 2, KBINS_UNIFORM, edges,
+                               false, out);
+  expectNear({0.f, 1.5f, 3.f, 1.f, 5.5f, 10.f}, edges);
+  expectNear({0.f, 0.f, 1.f, 1.f, 0.f, 0.f, 0.f, 1.f}, out);
+
+  float* one_hot = deviceArray(16);
+  kBinsDiscretizerFitTransform(handle, X, 4, 2, 2, KBINS_QUANTILE, edges,
+                               true, one_hot, true);
+  expectNear({0.f, 1.5f, 3.f, 1.f, 2.5f, 10.f}, edges);
+  expectNear({1.f, 0.f, 1.f, 0.f, 1.f, 0.f, 1.f, 0.f,
+              0.f, 1.f, 0.f, 1.f, 0.f, 1.f, 0.f, 1.f},
+             one_hot);
+}
+
+}  // namespace ML
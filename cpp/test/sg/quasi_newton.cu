@@ -5,7 +5,9 @@
 #include <gtest/gtest.h>
 #include <linalg/transpose.h>
 #include <cuml/linear_model/glm.hpp>
+#include <cmath>
 #include <vector>
+#include "single_rank_comms.h"
 #include "test_utils.h"
 #include "utils.h"
 
@@ -402,5 +404,131 @@ TEST_F(QuasiNewtonTest, predict_softmax) {
   }
 }
 
+TEST_F(QuasiNewtonTest, sparse_vs_dense) {
+  CompareApprox<double> compApprox(tol);
+  // Sparsify X, with its small entries dropped, into a dense and a CSR copy
+  std::vector<double> X_dense(N * D, 0), values;
+  std::vector<int> cols, row_ids(N + 1);
+  for (int i = 0; i < N; i++) {
+    row_ids[i] = values.size();
+    for (int j = 0; j < D; j++) {
+      if (std::abs(X[i][j]) < 0.3) continue;
+      X_dense[i * D + j] = X[i][j];
+      values.push_back(X[i][j]);
+      cols.push_back(j);
+    }
+  }
+  const int nnz = values.size();
+  row_ids[N] = nnz;
+  updateDevice(Xdev->data, X_dense.data(), Xdev->len, stream);
+  SimpleVecOwning<double> X_values(allocator, nnz, stream);
+  MLCommon::device_buffer<int> X_cols(allocator, stream, nnz);
+  MLCommon::device_buffer<int> X_row_ids(allocator, stream, N + 1);
+  updateDevice(X_values.data, values.data(), nnz, stream);
+  updateDevice(X_cols.data(), cols.data(), nnz, stream);
+  updateDevice(X_row_ids.data(), row_ids.data(), N + 1, stream);
+
+  double y_binary[N] = {1, 1, 1, 0, 1, 0, 1, 0, 1, 0};
+  double y_multi[N] = {2, 2, 0, 3, 3, 0, 0, 0, 1, 0};
+  const int max_iter = 100;
+  const double grad_tol = 1e-8;
+  for (int loss_type : {0, 2}) {
+    const int C = loss_type == 0 ? 1 : 4;
+    updateDevice(ydev->data, loss_type == 0 ? y_binary : y_multi, N, stream);
+    for (bool fit_intercept : {true, false}) {
+      for (double l2 : {0.0, 0.1}) {
+        const int n_param = C * (D + fit_intercept);
+        SimpleVecOwning<double> w_dense(allocator, n_param, stream);
+        SimpleVecOwning<double> w_sparse(allocator, n_param, stream);
+        w_dense.fill(0, stream);
+        w_sparse.fill(0, stream);
+        double fx_dense, fx_sparse;
+        int iters_dense, iters_sparse;
+        qnFit(cuml_handle, Xdev->data, ydev->data, N, D, C, fit_intercept, 0.0,
+              l2, max_iter, grad_tol, 50, 5, 0, w_dense.data, &fx_dense,
+              &iters_dense, false, loss_type);
+        qnFitSparse(cuml_handle, X_values.data, X_cols.data(),
+                    X_row_ids.data(), nnz, ydev->data, N, D, C, fit_intercept,
+                    0.0, l2, max_iter, grad_tol, 50, 5, 0, w_sparse.data,
+                    &fx_sparse, &iters_sparse, loss_type);
+        ASSERT_TRUE(compApprox(fx_dense, fx_sparse));
+        ASSERT_TRUE(devArrMatch(w_dense.data, w_sparse.data, n_param,
+                                CompareApprox<double>(1e-4)));
+
+        SimpleVecOwning<double> preds_dense(allocator, N, stream);
+        SimpleVecOwning<double> preds_sparse(allocator, N, stream);
+        qnPredict(cuml_handle, Xdev->data, N, D, C, fit_intercept,
+                  w_dense.data, false, loss_type, preds_dense.data);
+        qnPredictSparse(cuml_handle, X_values.data, X_cols.data(),
+                        X_row_ids.data(), nnz, N, D, C, fit_intercept,
+                        w_dense.data, loss_type, preds_sparse.data);
+        ASSERT_TRUE(devArrMatch(preds_dense.data, preds_sparse.data, N,
+                                Compare<double>()));
+      }
+    }
+  }
+}
+
+// On the only rank of a communicator, the MG fits find the qnFit parameters
+TEST_F(QuasiNewtonTest, mg_vs_sg) {
+  initSingleRankComms(cuml_handle);
+  CompareApprox<double> compApprox(tol);
+  std::vector<double> values;
+  std::vector<int> cols, row_ids(N + 1);
+  for (int i = 0; i < N; i++) {
+    row_ids[i] = values.size();
+    for (int j = 0; j < D; j++) {
+      values.push_back(X[i][j]);
+      cols.push_back(j);
+    }
+  }
+  row_ids[N] = N * D;
+  SimpleVecOwning<double> X_values(allocator, N * D, stream);
+  MLCommon::device_buffer<int> X_cols(allocator, stream, N * D);
+  MLCommon::device_buffer<int> X_row_ids(allocator, stream, N + 1);
+  updateDevice(X_values.data, values.data(), N * D, stream);
+  updateDevice(X_cols.data(), cols.data(), N * D, stream);
+  updateDevice(X_row_ids.data(), row_ids.data(), N + 1, stream);
+
+  double y_binary[N] = {1, 1, 1, 0, 1, 0, 1, 0, 1, 0};
+  double y_linear[N] = {0.2, -1.1, 3.4, 0.5, 2.0, -0.3, 0.7, 2.2, -2.5, 1.3};
+  double y_multi[N] = {2, 2, 0, 3, 3, 0, 0, 0, 1, 0};
+  double *ys[] = {y_binary, y_linear, y_multi};
+  const int max_iter = 100;
+  const double grad_tol = 1e-8;
+  for (int loss_type : {0, 1, 2}) {
+    const int C = loss_type == 2 ? 4 : 1;
+    updateDevice(ydev->data, ys[loss_type], N, stream);
+    for (bool fit_intercept : {true, false}) {
+      const int n_param = C * (D + fit_intercept);
+      SimpleVecOwning<double> w_sg(allocator, n_param, stream);
+      SimpleVecOwning<double> w_mg(allocator, n_param, stream);
+      SimpleVecOwning<double> w_mg_sparse(allocator, n_param, stream);
+      w_sg.fill(0, stream);
+      w_mg.fill(0, stream);
+      w_mg_sparse.fill(0, stream);
+      double fx_sg, fx_mg, fx_mg_sparse;
+      int iters_sg, iters_mg, iters_mg_sparse;
+      qnFit(cuml_handle, Xdev->data, ydev->data, N, D, C, fit_intercept, 0.0,
+            0.1, max_iter, grad_tol, 50, 5, 0, w_sg.data, &fx_sg, &iters_sg,
+            false, loss_type);
+      qnFitMG(cuml_handle, Xdev->data, ydev->data, N, D, C, fit_intercept, 0.0,
+              0.1, max_iter, grad_tol, 50, 5, 0, w_mg.data, &fx_mg, &iters_mg,
+              false, loss_type);
+      qnFitSparseMG(cuml_handle, X_values.data, X_cols.data(),
+                    X_row_ids.data(), N * D, ydev->data, N, D, C,
+                    fit_intercept, 0.0, 0.1, max_iter, grad_tol, 50, 5, 0,
+                    w_mg_sparse.data, &fx_mg_sparse, &iters_mg_sparse,
+                    loss_type);
+      ASSERT_TRUE(compApprox(fx_sg, fx_mg));
+      ASSERT_TRUE(compApprox(fx_sg, fx_mg_sparse));
+      ASSERT_TRUE(devArrMatch(w_sg.data, w_mg.data, n_param,
+                              CompareApprox<double>(1e-4)));
+      ASSERT_TRUE(devArrMatch(w_sg.data, w_mg_sparse.data, n_param,
+                              CompareApprox<double>(1e-4)));
+    }
+  }
+}
+
 }  // namespace GLM
 }  // end namespace ML
@@ -17,8 +17,13 @@
 #include <cuda_utils.h>
 #include <gtest/gtest.h>
 #include <test_utils.h>
+#include <cmath>
+#include <memory>
+#include <random>
 #include "cuml/ensemble/randomforest.hpp"
+#include "cuml/fil/fil.h"
 #include "ml_utils.h"
+#include "single_rank_comms.h"
 
 namespace ML {
 
@@ -63,6 +68,9 @@ class RfClassifierTest : public ::testing::TestWithParam<RfInputs<T>> {
     RF_params rf_params;
     set_all_rf_params(rf_params, params.n_trees, params.bootstrap,
                       params.rows_sample, -1, params.n_streams, tree_params);
+    rf_params.tree_batch_size = tree_batch_size;
+    rf_params.tree_params.quantize = quantize;
+    rf_params.tree_params.stream_cols = stream_cols;
     //print(rf_params);
 
     //--------------------------------------------------------
@@ -94,8 +102,16 @@ class RfClassifierTest : public ::testing::TestWithParam<RfInputs<T>> {
     cumlHandle handle(rf_params.n_streams);
     handle.setStream(stream);
 
-    fit(handle, forest, data, params.n_rows, params.n_cols, labels,
-        labels_map.size(), rf_params);
+    // The streamed training data stays on the host
+    T* train_data = stream_cols > 0 ? data_h.data() : data;
+    if (distributed) {
+      initSingleRankComms(handle);
+      fit_mg(handle, forest, train_data, params.n_rows, params.n_cols, labels,
+             labels_map.size(), rf_params);
+    } else {
+      fit(handle, forest, train_data, params.n_rows, params.n_cols, labels,
+          labels_map.size(), rf_params);
+    }
 
     CUDA_CHECK(cudaStreamSynchronize(stream));
     //print_rf_detailed(forest);
@@ -112,6 +128,46 @@ class RfClassifierTest : public ::testing::TestWithParam<RfInputs<T>> {
     RF_metrics tmp = score(handle, forest, labels, params.n_inference_rows,
                            predicted_labels, false);
 
+    // The same predictions from a column-major view of the training data,
+    // which is transposed on the fly
+    if (stream_cols == 0 && params.n_rows == params.n_inference_rows) {
+      std::vector<int> h_rowMajor(params.n_rows), h_view(params.n_rows);
+      int* view_labels;
+      allocate(view_labels, params.n_rows);
+      predict(handle, forest,
+              matrixView<const T>::colMajor(data, params.n_rows,
+                                            params.n_cols),
+              view_labels, false);
+      updateHost(h_rowMajor.data(), predicted_labels, params.n_rows, stream);
+      updateHost(h_view.data(), view_labels, params.n_rows, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+      CUDA_CHECK(cudaFree(view_labels));
+      view_predictions_match = h_rowMajor == h_view;
+    }
+
+    // A distributed fit builds the same trees as fit() on a single GPU
+    if (distributed) {
+      RandomForestMetaData<T, int>* ref =
+        new typename ML::RandomForestMetaData<T, int>;
+      null_trees_ptr(ref);
+      fit(handle, ref, train_data, params.n_rows, params.n_cols, labels,
+          labels_map.size(), rf_params);
+      int* ref_labels;
+      allocate(ref_labels, params.n_inference_rows);
+      predict(handle, ref, inference_data_d, params.n_inference_rows,
+              params.n_cols, ref_labels, false);
+      std::vector<int> h_mg(params.n_inference_rows),
+        h_ref(params.n_inference_rows);
+      updateHost(h_mg.data(), predicted_labels, params.n_inference_rows,
+                 stream);
+      updateHost(h_ref.data(), ref_labels, params.n_inference_rows, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+      CUDA_CHECK(cudaFree(ref_labels));
+      delete[] ref->trees;
+      delete ref;
+      mg_predictions_match = h_mg == h_ref;
+    }
+
     CUDA_CHECK(cudaStreamSynchronize(stream));
     CUDA_CHECK(cudaStreamDestroy(stream));
     accuracy = tmp.accuracy;
@@ -119,6 +175,19 @@ class RfClassifierTest : public ::testing::TestWithParam<RfInputs<T>> {
 
   void SetUp() override { basicTest(); }
 
+  /** checkAccuracy checks the accuracy of the fit forest on its training
+      data, perfect unless the rows or features are sampled */
+  void checkAccuracy() {
+    ASSERT_TRUE(view_predictions_match);
+    ASSERT_TRUE(mg_predictions_match);
+    //print_rf_detailed(forest);  // Prints all trees in the forest. Leaf nodes use the remapped values from labels_map.
+    if (!params.bootstrap && (params.max_features == 1.0f)) {
+      ASSERT_TRUE(accuracy == 1.0f);
+    } else {
+      ASSERT_TRUE(accuracy >= 0.75f);  // Empirically derived accuracy range
+    }
+  }
+
   void TearDown() override {
     accuracy = -1.0f;  // reset accuracy
     postprocess_labels(params.n_rows, labels_h, labels_map);
@@ -145,10 +214,58 @@ class RfClassifierTest : public ::testing::TestWithParam<RfInputs<T>> {
 
   RandomForestMetaData<T, int>* forest;
   float accuracy = -1.0f;  // overriden in each test SetUp and TearDown
+  int tree_batch_size = 1;
+  bool quantize = false;
+  int stream_cols = 0;
+  bool view_predictions_match = true;
+  bool distributed = false;
+  bool mg_predictions_match = true;
 
   int* predicted_labels;
 };
 
+// Same as RfClassifierTest, with the trees grown in lock-step, 4 at a time.
+template <typename T>
+class RfBatchedClassifierTest : public RfClassifierTest<T> {
+ protected:
+  void SetUp() override {
+    this->tree_batch_size = 4;
+    this->basicTest();
+  }
+};
+
+// Same as RfClassifierTest, with the data pre-binned for GLOBAL_QUANTILE.
+template <typename T>
+class RfQuantizedClassifierTest : public RfClassifierTest<T> {
+ protected:
+  void SetUp() override {
+    this->quantize = true;
+    this->basicTest();
+  }
+};
+
+// Same as RfClassifierTest, with the data streamed from the host one column
+// at a time.
+template <typename T>
+class RfStreamedClassifierTest : public RfClassifierTest<T> {
+ protected:
+  void SetUp() override {
+    this->stream_cols = 1;
+    this->basicTest();
+  }
+};
+
+// Same as RfClassifierTest, with the trees trained by fit_mg() over a
+// single-rank communicator.
+template <typename T>
+class RfDistributedClassifierTest : public RfClassifierTest<T> {
+ protected:
+  void SetUp() override {
+    this->distributed = true;
+    this->basicTest();
+  }
+};
+
 //-------------------------------------------------------------------------------------------------------------------------------------
 
 template <typename T>
@@ -165,6 +282,7 @@ class RfRegressorTest : public ::testing::TestWithParam<RfInputs<T>> {
     RF_params rf_params;
     set_all_rf_params(rf_params, params.n_trees, params.bootstrap,
                       params.rows_sample, -1, params.n_streams, tree_params);
+    rf_params.tree_params.quantize = quantize;
     //print(rf_params);
 
     //--------------------------------------------------------
@@ -194,7 +312,14 @@ class RfRegressorTest : public ::testing::TestWithParam<RfInputs<T>> {
     cumlHandle handle(rf_params.n_streams);
     handle.setStream(stream);
 
-    fit(handle, forest, data, params.n_rows, params.n_cols, labels, rf_params);
+    if (distributed) {
+      initSingleRankComms(handle);
+      fit_mg(handle, forest, data, params.n_rows, params.n_cols, labels,
+             rf_params);
+    } else {
+      fit(handle, forest, data, params.n_rows, params.n_cols, labels,
+          rf_params);
+    }
 
     CUDA_CHECK(cudaStreamSynchronize(stream));
 
@@ -211,6 +336,28 @@ class RfRegressorTest : public ::testing::TestWithParam<RfInputs<T>> {
     RF_metrics tmp = score(handle, forest, labels, params.n_inference_rows,
                            predicted_labels, false);
 
+    // A distributed fit builds the same trees as fit() on a single GPU
+    if (distributed) {
+      RandomForestMetaData<T, T>* ref =
+        new typename ML::RandomForestMetaData<T, T>;
+      null_trees_ptr(ref);
+      fit(handle, ref, data, params.n_rows, params.n_cols, labels, rf_params);
+      T* ref_labels;
+      allocate(ref_labels, params.n_inference_rows);
+      predict(handle, ref, inference_data_d, params.n_inference_rows,
+              params.n_cols, ref_labels, false);
+      std::vector<T> h_mg(params.n_inference_rows),
+        h_ref(params.n_inference_rows);
+      updateHost(h_mg.data(), predicted_labels, params.n_inference_rows,
+                 stream);
+      updateHost(h_ref.data(), ref_labels, params.n_inference_rows, stream);
+      CUDA_CHECK(cudaStreamSynchronize(stream));
+      CUDA_CHECK(cudaFree(ref_labels));
+      delete[] ref->trees;
+      delete ref;
+      mg_predictions_match = h_mg == h_ref;
+    }
+
     CUDA_CHECK(cudaStreamSynchronize(stream));
     CUDA_CHECK(cudaStreamDestroy(stream));
 
@@ -219,6 +366,18 @@ class RfRegressorTest : public ::testing::TestWithParam<RfInputs<T>> {
 
   void SetUp() override { basicTest(); }
 
+  /** checkMse checks the mean squared error of the fit forest on its
+      training data, zero unless the rows or features are sampled */
+  void checkMse() {
+    ASSERT_TRUE(mg_predictions_match);
+    //print_rf_detailed(forest);  // Prints all trees in the forest.
+    if (!params.bootstrap && (params.max_features == 1.0f)) {
+      ASSERT_TRUE(mse == 0.0f);
+    } else {
+      ASSERT_TRUE(mse <= 0.2f);
+    }
+  }
+
   void TearDown() override {
     mse = -1.0f;  // reset mse
     inference_data_h.clear();
@@ -241,9 +400,33 @@ class RfRegressorTest : public ::testing::TestWithParam<RfInputs<T>> {
 
   RandomForestMetaData<T, T>* forest;
   float mse = -1.0f;  // overriden in each test SetUp and TearDown
+  bool quantize = false;
+  bool distributed = false;
+  bool mg_predictions_match = true;
 
   T* predicted_labels;
 };
+
+// Same as RfRegressorTest, with the data pre-binned for GLOBAL_QUANTILE.
+template <typename T>
+class RfQuantizedRegressorTest : public RfRegressorTest<T> {
+ protected:
+  void SetUp() override {
+    this->quantize = true;
+    this->basicTest();
+  }
+};
+
+// Same as RfRegressorTest, with the trees trained by fit_mg() over a
+// single-rank communicator.
+template <typename T>
+class RfDistributedRegressorTest : public RfRegressorTest<T> {
+ protected:
+  void SetUp() override {
+    this->distributed = true;
+    this->basicTest();
+  }
+};
 //-------------------------------------------------------------------------------------------------------------------------------------
 
 const std::vector<RfInputs<float>> inputsf2_clf = {
@@ -270,7 +453,11 @@ const std::vector<RfInputs<float>> inputsf2_clf = {
   {4, 2, 10, 0.8f, 0.8f, 4, 8, -1, true, false, 3, SPLIT_ALGO::HIST, 2, 0.0, 2,
    CRITERION::ENTROPY},
   {4, 2, 10, 0.8f, 0.8f, 4, 8, -1, true, false, 3, SPLIT_ALGO::GLOBAL_QUANTILE,
-   2, 0.0, 2, CRITERION::ENTROPY}};
+   2, 0.0, 2, CRITERION::ENTROPY},
+  {4, 2, 10, 1.0f, 0.8f, 4, 8, -1, true, false, 3, SPLIT_ALGO::GLOBAL_QUANTILE,
+   2, 0.0, 2,
+   CRITERION::
+     GINI}};  //all columns for all nodes, siblings' histograms are subtracted
 
 const std::vector<RfInputs<double>> inputsd2_clf = {  // Same as inputsf2_clf
   {4, 2, 1, 1.0f, 1.0f, 4, 8, -1, false, false, 4, SPLIT_ALGO::HIST, 2, 0.0, 2,
@@ -292,26 +479,28 @@ const std::vector<RfInputs<double>> inputsd2_clf = {  // Same as inputsf2_clf
   {4, 2, 10, 0.8f, 0.8f, 4, 8, -1, true, false, 3, SPLIT_ALGO::HIST, 2, 0.0, 2,
    CRITERION::ENTROPY},
   {4, 2, 10, 0.8f, 0.8f, 4, 8, -1, true, false, 3, SPLIT_ALGO::GLOBAL_QUANTILE,
+   2, 0.0, 2, CRITERION::ENTROPY},
+  {4, 2, 10, 1.0f, 0.8f, 4, 8, -1, true, false, 3, SPLIT_ALGO::GLOBAL_QUANTILE,
+   2, 0.0, 2, CRITERION::GINI}};
+
+// Streaming needs all the features, in order, with GLOBAL_QUANTILE
+const std::vector<RfInputs<float>> inputsf2_stream_clf = {
+  {4, 2, 1, 1.0f, 1.0f, 4, 8, -1, false, false, 4, SPLIT_ALGO::GLOBAL_QUANTILE,
+   2, 0.0, 2, CRITERION::GINI},
+  {4, 2, 10, 1.0f, 0.8f, 4, 8, -1, true, false, 3, SPLIT_ALGO::GLOBAL_QUANTILE,
+   2, 0.0, 2, CRITERION::ENTROPY}};
+
+const std::vector<RfInputs<double>> inputsd2_stream_clf = {
+  {4, 2, 1, 1.0f, 1.0f, 4, 8, -1, false, false, 4, SPLIT_ALGO::GLOBAL_QUANTILE,
+   2, 0.0, 2, CRITERION::GINI},
+  {4, 2, 10, 1.0f, 0.8f, 4, 8, -1, true, false, 3, SPLIT_ALGO::GLOBAL_QUANTILE,
    2, 0.0, 2, CRITERION::ENTROPY}};
 
 typedef RfClassifierTest<float> RfClassifierTestF;
-TEST_P(RfClassifierTestF, Fit) {
-  //print_rf_detailed(forest);  // Prints all trees in the forest. Leaf nodes use the remapped values from labels_map.
-  if (!params.bootstrap && (params.max_features == 1.0f)) {
-    ASSERT_TRUE(accuracy == 1.0f);
-  } else {
-    ASSERT_TRUE(accuracy >= 0.75f);  // Empirically derived accuracy range
-  }
-}
+TEST_P(RfClassifierTestF, Fit) { checkAccuracy(); }
 
 typedef RfClassifierTest<double> RfClassifierTestD;
-TEST_P(RfClassifierTestD, Fit) {
-  if (!params.bootstrap && (params.max_features == 1.0f)) {
-    ASSERT_TRUE(accuracy == 1.0f);
-  } else {
-    ASSERT_TRUE(accuracy >= 0.75f);
-  }
-}
+TEST_P(RfClassifierTestD, Fit) { checkAccuracy(); }
 
 INSTANTIATE_TEST_CASE_P(RfClassifierTests, RfClassifierTestF,
                         ::testing::ValuesIn(inputsf2_clf));
@@ -319,24 +508,61 @@ INSTANTIATE_TEST_CASE_P(RfClassifierTests, RfClassifierTestF,
 INSTANTIATE_TEST_CASE_P(RfClassifierTests, RfClassifierTestD,
                         ::testing::ValuesIn(inputsd2_clf));
 
+typedef RfBatchedClassifierTest<float> RfBatchedClassifierTestF;
+TEST_P(RfBatchedClassifierTestF, Fit) { checkAccuracy(); }
+
+typedef RfBatchedClassifierTest<double> RfBatchedClassifierTestD;
+TEST_P(RfBatchedClassifierTestD, Fit) { checkAccuracy(); }
+
+INSTANTIATE_TEST_CASE_P(RfBatchedClassifierTests, RfBatchedClassifierTestF,
+                        ::testing::ValuesIn(inputsf2_clf));
+
+INSTANTIATE_TEST_CASE_P(RfBatchedClassifierTests, RfBatchedClassifierTestD,
+                        ::testing::ValuesIn(inputsd2_clf));
+
+typedef RfQuantizedClassifierTest<float> RfQuantizedClassifierTestF;
+TEST_P(RfQuantizedClassifierTestF, Fit) { checkAccuracy(); }
+
+typedef RfQuantizedClassifierTest<double> RfQuantizedClassifierTestD;
+TEST_P(RfQuantizedClassifierTestD, Fit) { checkAccuracy(); }
+
+INSTANTIATE_TEST_CASE_P(RfQuantizedClassifierTests, RfQuantizedClassifierTestF,
+                        ::testing::ValuesIn(inputsf2_clf));
+
+INSTANTIATE_TEST_CASE_P(RfQuantizedClassifierTests, RfQuantizedClassifierTestD,
+                        ::testing::ValuesIn(inputsd2_clf));
+
+typedef RfStreamedClassifierTest<float> RfStreamedClassifierTestF;
+TEST_P(RfStreamedClassifierTestF, Fit) { checkAccuracy(); }
+
+typedef RfStreamedClassifierTest<double> RfStreamedClassifierTestD;
+TEST_P(RfStreamedClassifierTestD, Fit) { checkAccuracy(); }
+
+INSTANTIATE_TEST_CASE_P(RfStreamedClassifierTests, RfStreamedClassifierTestF,
+                        ::testing::ValuesIn(inputsf2_stream_clf));
+
+INSTANTIATE_TEST_CASE_P(RfStreamedClassifierTests, RfStreamedClassifierTestD,
+                        ::testing::ValuesIn(inputsd2_stream_clf));
+
+typedef RfDistributedClassifierTest<float> RfDistributedClassifierTestF;
+TEST_P(RfDistributedClassifierTestF, Fit) { checkAccuracy(); }
+
+typedef RfDistributedClassifierTest<double> RfDistributedClassifierTestD;
+TEST_P(RfDistributedClassifierTestD, Fit) { checkAccuracy(); }
+
+INSTANTIATE_TEST_CASE_P(RfDistributedClassifierTests,
+                        RfDistributedClassifierTestF,
+                        ::testing::ValuesIn(inputsf2_clf));
+
+INSTANTIATE_TEST_CASE_P(RfDistributedClassifierTests,
+                        RfDistributedClassifierTestD,
+                        ::testing::ValuesIn(inputsd2_clf));
+
 typedef RfRegressorTest<float> RfRegressorTestF;
-TEST_P(RfRegressorTestF, Fit) {
-  //print_rf_detailed(forest);  // Prints all trees in the forest.
-  if (!params.bootstrap && (params.max_features == 1.0f)) {
-    ASSERT_TRUE(mse == 0.0f);
-  } else {
-    ASSERT_TRUE(mse <= 0.2f);
-  }
-}
+TEST_P(RfRegressorTestF, Fit) { checkMse(); }
 
 typedef RfRegressorTest<double> RfRegressorTestD;
-TEST_P(RfRegressorTestD, Fit) {
-  if (!params.bootstrap && (params.max_features == 1.0f)) {
-    ASSERT_TRUE(mse == 0.0f);
-  } else {
-    ASSERT_TRUE(mse <= 0.2f);
-  }
-}
+TEST_P(RfRegressorTestD, Fit) { checkMse(); }
 
 const std::vector<RfInputs<float>> inputsf2_reg = {
   {4, 2, 1, 1.0f, 1.0f, 4, 8, -1, false, false, 4, SPLIT_ALGO::HIST, 2, 0.0, 2,
@@ -372,4 +598,345 @@ INSTANTIATE_TEST_CASE_P(RfRegressorTests, RfRegressorTestF,
 INSTANTIATE_TEST_CASE_P(RfRegressorTests, RfRegressorTestD,
                         ::testing::ValuesIn(inputsd2_reg));
 
+typedef RfQuantizedRegressorTest<float> RfQuantizedRegressorTestF;
+TEST_P(RfQuantizedRegressorTestF, Fit) { checkMse(); }
+
+typedef RfQuantizedRegressorTest<double> RfQuantizedRegressorTestD;
+TEST_P(RfQuantizedRegressorTestD, Fit) { checkMse(); }
+
+INSTANTIATE_TEST_CASE_P(RfQuantizedRegressorTests, RfQuantizedRegressorTestF,
+                        ::testing::ValuesIn(inputsf2_reg));
+INSTANTIATE_TEST_CASE_P(RfQuantizedRegressorTests, RfQuantizedRegressorTestD,
+                        ::testing::ValuesIn(inputsd2_reg));
+
+typedef RfDistributedRegressorTest<float> RfDistributedRegressorTestF;
+TEST_P(RfDistributedRegressorTestF, Fit) { checkMse(); }
+
+typedef RfDistributedRegressorTest<double> RfDistributedRegressorTestD;
+TEST_P(RfDistributedRegressorTestD, Fit) { checkMse(); }
+
+INSTANTIATE_TEST_CASE_P(RfDistributedRegressorTests,
+                        RfDistributedRegressorTestF,
+                        ::testing::ValuesIn(inputsf2_reg));
+INSTANTIATE_TEST_CASE_P(RfDistributedRegressorTests,
+                        RfDistributedRegressorTestD,
+                        ::testing::ValuesIn(inputsd2_reg));
+
+//-------------------------------------------------------------------------------------------------------------------------------------
+
+struct RfOobInputs {
+  int n_rows;
+  int n_cols;
+  int n_trees;
+  int tree_batch_size;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const RfOobInputs& dims) {
+  return os;
+}
+
+// Out-of-bag metrics and feature importances of a classifier (label
+// x0 > 0.5) and a regressor (label x0) on uniform data in [0, 1), where
+// only the first feature is informative.
+template <typename T>
+class RfOobTest : public ::testing::TestWithParam<RfOobInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<RfOobInputs>::GetParam();
+    DecisionTree::DecisionTreeParams tree_params;
+    set_tree_params(tree_params, 8, -1, 1.0f, 16, SPLIT_ALGO::HIST, 2, 0.0f,
+                    false, CRITERION_END, false);
+    RF_params rf_params;
+    set_all_rf_params(rf_params, params.n_trees, true, 1.0f, 0, 4,
+                      tree_params);
+    rf_params.tree_batch_size = params.tree_batch_size;
+    rf_params.oob_score = true;
+
+    int data_len = params.n_rows * params.n_cols;
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<T> dist(0, 1);
+    std::vector<T> data_h(data_len);  // Col major
+    for (T& val : data_h) val = dist(gen);
+    std::vector<int> class_labels_h(params.n_rows);
+    for (int r = 0; r < params.n_rows; r++)
+      class_labels_h[r] = data_h[r] > 0.5 ? 1 : 0;
+
+    cudaStream_t stream;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    allocate(data, data_len);
+    allocate(class_labels, params.n_rows);
+    updateDevice(data, data_h.data(), data_len, stream);
+    updateDevice(class_labels, class_labels_h.data(), params.n_rows, stream);
+
+    cumlHandle handle(rf_params.n_streams);
+    handle.setStream(stream);
+    classifier = new RandomForestMetaData<T, int>;
+    null_trees_ptr(classifier);
+    fit(handle, classifier, data, params.n_rows, params.n_cols, class_labels,
+        2, rf_params);
+    regressor = new RandomForestMetaData<T, T>;
+    null_trees_ptr(regressor);
+    // The labels of the regressor are the first column of the data
+    fit(handle, regressor, data, params.n_rows, params.n_cols, data,
+        rf_params);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    CUDA_CHECK(cudaStreamDestroy(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(data));
+    CUDA_CHECK(cudaFree(class_labels));
+    delete[] classifier->trees;
+    delete classifier;
+    delete[] regressor->trees;
+    delete regressor;
+  }
+
+  void check_importances(const std::vector<T>& importances) {
+    ASSERT_EQ((int)importances.size(), params.n_cols);
+    T sum = 0;
+    for (T imp : importances) sum += imp;
+    ASSERT_NEAR(sum, 1, 1e-4);
+    ASSERT_TRUE(importances[0] >= 0.8);
+  }
+
+ protected:
+  RfOobInputs params;
+  T* data;
+  int* class_labels;
+  RandomForestMetaData<T, int>* classifier;
+  RandomForestMetaData<T, T>* regressor;
+};
+
+const std::vector<RfOobInputs> inputs_oob = {{1000, 4, 10, 1},
+                                             {1000, 4, 10, 4}};
+
+typedef RfOobTest<float> RfOobTestF;
+TEST_P(RfOobTestF, Fit) {
+  ASSERT_TRUE(classifier->oob_metrics.accuracy >= 0.9f);
+  check_importances(classifier->feature_importances);
+  ASSERT_TRUE(regressor->oob_metrics.mean_squared_error <= 0.01);
+  check_importances(regressor->feature_importances);
+}
+
+typedef RfOobTest<double> RfOobTestD;
+TEST_P(RfOobTestD, Fit) {
+  ASSERT_TRUE(classifier->oob_metrics.accuracy >= 0.9f);
+  check_importances(classifier->feature_importances);
+  ASSERT_TRUE(regressor->oob_metrics.mean_squared_error <= 0.01);
+  check_importances(regressor->feature_importances);
+}
+
+INSTANTIATE_TEST_CASE_P(RfOobTests, RfOobTestF,
+                        ::testing::ValuesIn(inputs_oob));
+INSTANTIATE_TEST_CASE_P(RfOobTests, RfOobTestD,
+                        ::testing::ValuesIn(inputs_oob));
+
+//-------------------------------------------------------------------------------------------------------------------------------------
+
+struct RfExportInputs {
+  int n_rows;
+  int n_cols;
+  int n_trees;
+  int max_depth;
+  fil::storage_type_t storage_type;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const RfExportInputs& dims) {
+  return os;
+}
+
+// save_forest / load_forest round trip and direct conversion to FIL of a
+// binary classifier (label x0 > 0.5) and a regressor (label x0 + x1) on
+// uniform data in [0, 1), compared to the forests themselves.
+template <typename T>
+class RfExportTest : public ::testing::TestWithParam<RfExportInputs> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<RfExportInputs>::GetParam();
+    DecisionTree::DecisionTreeParams tree_params;
+    set_tree_params(tree_params, params.max_depth, -1, 1.0f, 16,
+                    SPLIT_ALGO::HIST, 2, 0.0f, false, CRITERION_END, false);
+    RF_params rf_params;
+    set_all_rf_params(rf_params, params.n_trees, true, 1.0f, 0, 4,
+                      tree_params);
+
+    int data_len = params.n_rows * params.n_cols;
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<T> dist(0, 1);
+    std::vector<T> data_h(data_len);  // Col major
+    std::vector<T> inference_data_h(data_len);  // Row major
+    std::vector<float> fil_data_h(data_len);  // Row major
+    for (int c = 0; c < params.n_cols; c++) {
+      for (int r = 0; r < params.n_rows; r++) {
+        T val = dist(gen);
+        data_h[r + c * params.n_rows] = val;
+        inference_data_h[c + r * params.n_cols] = val;
+        fil_data_h[c + r * params.n_cols] = val;
+      }
+    }
+    std::vector<int> class_labels_h(params.n_rows);
+    std::vector<T> labels_h(params.n_rows);
+    for (int r = 0; r < params.n_rows; r++) {
+      class_labels_h[r] = data_h[r] > 0.5 ? 1 : 0;
+      labels_h[r] = data_h[r] + data_h[r + params.n_rows];
+    }
+
+    stream = 0;
+    CUDA_CHECK(cudaStreamCreate(&stream));
+    allocate(data, data_len);
+    allocate(inference_data, data_len);
+    allocate(fil_data, data_len);
+    allocate(class_labels, params.n_rows);
+    allocate(labels, params.n_rows);
+    allocate(class_predictions, params.n_rows);
+    allocate(predictions, params.n_rows);
+    allocate(fil_predictions, params.n_rows);
+    updateDevice(data, data_h.data(), data_len, stream);
+    updateDevice(inference_data, inference_data_h.data(), data_len, stream);
+    updateDevice(fil_data, fil_data_h.data(), data_len, stream);
+    updateDevice(class_labels, class_labels_h.data(), params.n_rows, stream);
+    updateDevice(labels, labels_h.data(), params.n_rows, stream);
+
+    handle.reset(new cumlHandle(rf_params.n_streams));
+    handle->setStream(stream);
+    classifier = new RandomForestMetaData<T, int>;
+    null_trees_ptr(classifier);
+    fit(*handle, classifier, data, params.n_rows, params.n_cols, class_labels,
+        2, rf_params);
+    regressor = new RandomForestMetaData<T, T>;
+    null_trees_ptr(regressor);
+    fit(*handle, regressor, data, params.n_rows, params.n_cols, labels,
+        rf_params);
+    predict(*handle, classifier, inference_data, params.n_rows, params.n_cols,
+            class_predictions);
+    predict(*handle, regressor, inference_data, params.n_rows, params.n_cols,
+            predictions);
+    class_predictions_h.resize(params.n_rows);
+    predictions_h.resize(params.n_rows);
+    updateHost(class_predictions_h.data(), class_predictions, params.n_rows,
+               stream);
+    updateHost(predictions_h.data(), predictions, params.n_rows, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    handle.reset();
+    CUDA_CHECK(cudaStreamDestroy(stream));
+    CUDA_CHECK(cudaFree(data));
+    CUDA_CHECK(cudaFree(inference_data));
+    CUDA_CHECK(cudaFree(fil_data));
+    CUDA_CHECK(cudaFree(class_labels));
+    CUDA_CHECK(cudaFree(labels));
+    CUDA_CHECK(cudaFree(class_predictions));
+    CUDA_CHECK(cudaFree(predictions));
+    CUDA_CHECK(cudaFree(fil_predictions));
+    delete[] classifier->trees;
+    delete classifier;
+    delete[] regressor->trees;
+    delete regressor;
+  }
+
+  template <class L>
+  void check_round_trip(const RandomForestMetaData<T, L>* forest) {
+    std::vector<char> bytes;
+    save_forest(forest, &bytes);
+    RandomForestMetaData<T, L> loaded;
+    loaded.trees = nullptr;
+    load_forest(&loaded, bytes.data(), bytes.size());
+    ASSERT_EQ(loaded.rf_params.n_trees, forest->rf_params.n_trees);
+    for (int i = 0; i < forest->rf_params.n_trees; i++) {
+      const std::vector<SparseTreeNode<T, L>>& tree =
+        forest->trees[i].sparsetree;
+      const std::vector<SparseTreeNode<T, L>>& loaded_tree =
+        loaded.trees[i].sparsetree;
+      ASSERT_EQ(loaded.trees[i].depth_counter, forest->trees[i].depth_counter);
+      ASSERT_EQ(loaded_tree.size(), tree.size());
+      for (size_t j = 0; j < tree.size(); j++) {
+        ASSERT_EQ(loaded_tree[j].prediction, tree[j].prediction);
+        ASSERT_EQ(loaded_tree[j].colid, tree[j].colid);
+        ASSERT_EQ(loaded_tree[j].quesval, tree[j].quesval);
+        ASSERT_EQ(loaded_tree[j].left_child_id, tree[j].left_child_id);
+      }
+    }
+    delete[] loaded.trees;
+  }
+
+  // Predictions of the forest converted to FIL, on the host
+  template <class L>
+  std::vector<float> fil_predict(const RandomForestMetaData<T, L>* forest,
+                                 bool output_class) {
+    fil::treelite_params_t tl_params;
+    tl_params.algo = fil::algo_t::ALGO_AUTO;
+    tl_params.output_class = output_class;
+    tl_params.threshold = 0.5f;
+    tl_params.storage_type = params.storage_type;
+    fil::forest_t fil_forest;
+    build_fil_forest(*handle, &fil_forest, forest, params.n_cols, &tl_params);
+    fil::predict(*handle, fil_forest, fil_predictions, fil_data,
+                 params.n_rows);
+    std::vector<float> fil_predictions_h(params.n_rows);
+    updateHost(fil_predictions_h.data(), fil_predictions, params.n_rows,
+               stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    fil::free(*handle, fil_forest);
+    return fil_predictions_h;
+  }
+
+  void check_fil() {
+    // The thresholds are rounded to float, which can send a few rows of a
+    // double forest down another branch
+    int max_mismatches = params.n_rows / 100;
+    std::vector<float> fil_classes = fil_predict(classifier, true);
+    int mismatches = 0;
+    for (int r = 0; r < params.n_rows; r++) {
+      mismatches += fil_classes[r] != class_predictions_h[r];
+    }
+    ASSERT_TRUE(mismatches <= max_mismatches);
+    std::vector<float> fil_values = fil_predict(regressor, false);
+    mismatches = 0;
+    for (int r = 0; r < params.n_rows; r++) {
+      mismatches += std::abs(fil_values[r] - predictions_h[r]) > 1e-4;
+    }
+    ASSERT_TRUE(mismatches <= max_mismatches);
+  }
+
+ protected:
+  RfExportInputs params;
+  cudaStream_t stream;
+  std::unique_ptr<cumlHandle> handle;
+  T *data, *inference_data, *labels, *predictions;
+  float *fil_data, *fil_predictions;
+  int *class_labels, *class_predictions;
+  RandomForestMetaData<T, int>* classifier;
+  RandomForestMetaData<T, T>* regressor;
+  std::vector<int> class_predictions_h;
+  std::vector<T> predictions_h;
+};
+
+// Odd numbers of trees, so that the votes of the classifiers are never tied
+const std::vector<RfExportInputs> inputs_export = {
+  {1000, 4, 11, 8, fil::storage_type_t::DENSE},
+  {1000, 4, 11, 8, fil::storage_type_t::SPARSE},
+  {1000, 4, 11, 8, fil::storage_type_t::SPARSE8}};
+
+typedef RfExportTest<float> RfExportTestF;
+TEST_P(RfExportTestF, SaveLoad) {
+  check_round_trip(classifier);
+  check_round_trip(regressor);
+}
+TEST_P(RfExportTestF, Fil) { check_fil(); }
+
+typedef RfExportTest<double> RfExportTestD;
+TEST_P(RfExportTestD, SaveLoad) {
+  check_round_trip(classifier);
+  check_round_trip(regressor);
+}
+TEST_P(RfExportTestD, Fil) { check_fil(); }
+
+INSTANTIATE_TEST_CASE_P(RfExportTests, RfExportTestF,
+                        ::testing::ValuesIn(inputs_export));
+INSTANTIATE_TEST_CASE_P(RfExportTests, RfExportTestD,
+                        ::testing::ValuesIn(inputs_export));
+
 }  // end namespace ML
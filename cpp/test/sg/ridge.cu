@@ -17,8 +17,10 @@
 #include <cuda_utils.h>
 #include <gtest/gtest.h>
 #include <test_utils.h>
+#include "glm/ols_mg.h"
 #include "glm/ridge.h"
 #include "ml_utils.h"
+#include "single_rank_comms.h"
 
 namespace ML {
 namespace GLM {
@@ -58,6 +60,9 @@ class RidgeTest : public ::testing::TestWithParam<RidgeInputs<T>> {
     allocate(pred2_ref, params.n_row_2);
     allocate(pred3, params.n_row_2);
     allocate(pred3_ref, params.n_row_2);
+    allocate(coef_path, 2 * params.n_col);
+    allocate(coef4, params.n_col);
+    allocate(coef5, params.n_col);
     T alpha = params.alpha;
 
     T data_h[len] = {0.0, 0.0, 1.0, 0.0, 0.0, 1.0};
@@ -114,6 +119,24 @@ class RidgeTest : public ::testing::TestWithParam<RidgeInputs<T>> {
 
     ridgePredict(handle.getImpl(), pred_data, params.n_row_2, params.n_col,
                  coef3, intercept3, pred3, stream);
+
+    updateDevice(data, data_h, len, stream);
+    updateDevice(labels, labels_h, params.n_row, stream);
+
+    // the path ends with the fit of coef3
+    T alphas[2] = {T(2) * alpha, alpha};
+    ridgeFitPath(handle.getImpl(), data, params.n_row, params.n_col, labels,
+                 alphas, 2, coef_path, intercept_path, true, true, stream,
+                 params.algo);
+
+    // the fits of coef and coef2 on the only rank of a communicator
+    initSingleRankComms(handle);
+    updateDevice(data, data_h, len, stream);
+    updateDevice(labels, labels_h, params.n_row, stream);
+    ridgeFitMG(handle.getImpl(), data, params.n_row, params.n_col, labels,
+               alpha, coef4, &intercept4, false, stream);
+    ridgeFitMG(handle.getImpl(), data, params.n_row, params.n_col, labels,
+               alpha, coef5, &intercept5, true, stream);
   }
 
   void basicTest2() {
@@ -167,6 +190,9 @@ class RidgeTest : public ::testing::TestWithParam<RidgeInputs<T>> {
     CUDA_CHECK(cudaFree(pred2_ref));
     CUDA_CHECK(cudaFree(pred3));
     CUDA_CHECK(cudaFree(pred3_ref));
+    CUDA_CHECK(cudaFree(coef_path));
+    CUDA_CHECK(cudaFree(coef4));
+    CUDA_CHECK(cudaFree(coef5));
 
     CUDA_CHECK(cudaFree(data_sc));
     CUDA_CHECK(cudaFree(labels_sc));
@@ -180,8 +206,10 @@ class RidgeTest : public ::testing::TestWithParam<RidgeInputs<T>> {
   T *data, *labels, *coef, *coef_ref, *pred_data, *pred, *pred_ref;
   T *coef2, *coef2_ref, *pred2, *pred2_ref;
   T *coef3, *coef3_ref, *pred3, *pred3_ref;
+  T *coef_path, intercept_path[2];
   T *data_sc, *labels_sc, *coef_sc, *coef_sc_ref;
-  T intercept, intercept2, intercept3;
+  T *coef4, *coef5;
+  T intercept, intercept2, intercept3, intercept4, intercept5;
   cumlHandle handle;
   cudaStream_t stream;
 };
@@ -214,6 +242,18 @@ TEST_P(RidgeTestF, Fit) {
 
   ASSERT_TRUE(
     devArrMatch(coef_sc_ref, coef_sc, 1, CompareApproxAbs<float>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(coef3_ref, coef_path + params.n_col, params.n_col,
+                          CompareApproxAbs<float>(params.tol)));
+  ASSERT_NEAR(intercept3, intercept_path[1], params.tol);
+
+  ASSERT_TRUE(devArrMatch(coef_ref, coef4, params.n_col,
+                          CompareApproxAbs<float>(params.tol)));
+  ASSERT_EQ(intercept4, float(0));
+
+  ASSERT_TRUE(devArrMatch(coef2_ref, coef5, params.n_col,
+                          CompareApproxAbs<float>(params.tol)));
+  ASSERT_NEAR(intercept2, intercept5, params.tol);
 }
 
 typedef RidgeTest<double> RidgeTestD;
@@ -238,6 +278,18 @@ TEST_P(RidgeTestD, Fit) {
 
   ASSERT_TRUE(
     devArrMatch(coef_sc_ref, coef_sc, 1, CompareApproxAbs<double>(params.tol)));
+
+  ASSERT_TRUE(devArrMatch(coef3_ref, coef_path + params.n_col, params.n_col,
+                          CompareApproxAbs<double>(params.tol)));
+  ASSERT_NEAR(intercept3, intercept_path[1], params.tol);
+
+  ASSERT_TRUE(devArrMatch(coef_ref, coef4, params.n_col,
+                          CompareApproxAbs<double>(params.tol)));
+  ASSERT_EQ(intercept4, double(0));
+
+  ASSERT_TRUE(devArrMatch(coef2_ref, coef5, params.n_col,
+                          CompareApproxAbs<double>(params.tol)));
+  ASSERT_NEAR(intercept2, intercept5, params.tol);
 }
 
 INSTANTIATE_TEST_CASE_P(RidgeTests, RidgeTestF, ::testing::ValuesIn(inputsf2));
@@ -103,17 +103,56 @@ class RPROJTest : public ::testing::Test {
       d_output2, N, params2->n_components);  // From column major to row major
   }
 
+  void sparseInputTest() {
+    // the dense input as CSR, projected by both random matrices
+    std::vector<T> values(N * M);
+    std::vector<int> cols(N * M), row_ids(N + 1);
+    for (int i = 0; i < N; i++) {
+      row_ids[i] = i * M;
+      for (int j = 0; j < M; j++) {
+        values[i * M + j] = h_input[j * N + i];
+        cols[i * M + j] = j;
+      }
+    }
+    row_ids[N] = N * M;
+    T* d_values;
+    int *d_cols, *d_row_ids;
+    allocate(d_values, N * M);
+    allocate(d_cols, N * M);
+    allocate(d_row_ids, N + 1);
+    updateDevice(d_values, values.data(), N * M, h.getStream());
+    updateDevice(d_cols, cols.data(), N * M, h.getStream());
+    updateDevice(d_row_ids, row_ids.data(), N + 1, h.getStream());
+
+    allocate(d_output3, N * params1->n_components);
+    RPROJtransformSparse(h, d_values, d_cols, d_row_ids, N * M, random_matrix1,
+                         d_output3, params1);
+    d_output3 = transpose(d_output3, N, params1->n_components);
+    allocate(d_output4, N * params2->n_components);
+    RPROJtransformSparse(h, d_values, d_cols, d_row_ids, N * M, random_matrix2,
+                         d_output4, params2);
+    d_output4 = transpose(d_output4, N, params2->n_components);
+
+    CUDA_CHECK(cudaStreamSynchronize(h.getStream()));
+    CUDA_CHECK(cudaFree(d_values));
+    CUDA_CHECK(cudaFree(d_cols));
+    CUDA_CHECK(cudaFree(d_row_ids));
+  }
+
   void SetUp() override {
     epsilon = 0.2;
     generate_data();
     gaussianTest();
     sparseTest();
+    sparseInputTest();
   }
 
   void TearDown() override {
     CUDA_CHECK(cudaFree(d_input));
     CUDA_CHECK(cudaFree(d_output1));
     CUDA_CHECK(cudaFree(d_output2));
+    CUDA_CHECK(cudaFree(d_output3));
+    CUDA_CHECK(cudaFree(d_output4));
     delete params1;
     delete random_matrix1;
     delete params2;
@@ -134,6 +173,13 @@ class RPROJTest : public ::testing::Test {
     ASSERT_TRUE(random_matrix2->sparse_data_size = N * D);
   }
 
+  void sparse_input_check() {
+    ASSERT_TRUE(devArrMatch(d_output1, d_output3, N * params1->n_components,
+                            CompareApprox<T>(1e-3)));
+    ASSERT_TRUE(devArrMatch(d_output2, d_output4, N * params2->n_components,
+                            CompareApprox<T>(1e-3)));
+  }
+
   void epsilon_check() {
     int D = johnson_lindenstrauss_min_dim(N, epsilon);
 
@@ -209,22 +255,29 @@ class RPROJTest : public ::testing::Test {
   paramsRPROJ* params2;
   rand_mat<T>* random_matrix2;
   T* d_output2;
+
+  T* d_output3;
+  T* d_output4;
 };
 
 typedef RPROJTest<float, 500, 2000> RPROJTestF1;
 TEST_F(RPROJTestF1, RandomMatrixCheck) { random_matrix_check(); }
 TEST_F(RPROJTestF1, EpsilonCheck) { epsilon_check(); }
+TEST_F(RPROJTestF1, SparseInputCheck) { sparse_input_check(); }
 
 typedef RPROJTest<double, 500, 2000> RPROJTestD1;
 TEST_F(RPROJTestD1, RandomMatrixCheck) { random_matrix_check(); }
 TEST_F(RPROJTestD1, EpsilonCheck) { epsilon_check(); }
+TEST_F(RPROJTestD1, SparseInputCheck) { sparse_input_check(); }
 
 typedef RPROJTest<float, 5000, 3500> RPROJTestF2;
 TEST_F(RPROJTestF2, RandomMatrixCheck) { random_matrix_check(); }
 TEST_F(RPROJTestF2, EpsilonCheck) { epsilon_check(); }
+TEST_F(RPROJTestF2, SparseInputCheck) { sparse_input_check(); }
 
 typedef RPROJTest<double, 5000, 3500> RPROJTestD2;
 TEST_F(RPROJTestD2, RandomMatrixCheck) { random_matrix_check(); }
 TEST_F(RPROJTestD2, EpsilonCheck) { epsilon_check(); }
+TEST_F(RPROJTestD2, SparseInputCheck) { sparse_input_check(); }
 
 }  // end namespace ML
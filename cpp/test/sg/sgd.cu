@@ -33,6 +33,7 @@ class SgdTest : public ::testing::TestWithParam<SgdInputs<T>> {
     allocate(labels, params.n_row);
     allocate(coef, params.n_col, true);
     allocate(coef2, params.n_col, true);
+    allocate(coef3, params.n_col, true);
     allocate(coef_ref, params.n_col);
     allocate(coef2_ref, params.n_col);
 
@@ -73,6 +74,13 @@ class SgdTest : public ::testing::TestWithParam<SgdInputs<T>> {
            &intercept2, fit_intercept, params.batch_size, epochs,
            ML::lr_type::CONSTANT, lr, power_t, loss, pen, alpha, l1_ratio,
            shuffle, tol, n_iter_no_change, stream);
+
+    // the same fit, streamed from the host by mini-batches
+    intercept3 = T(0);
+    sgdFitHost(handle.getImpl(), data_h, params.n_row, params.n_col, labels_h,
+               coef3, &intercept3, fit_intercept, params.batch_size, epochs,
+               ML::lr_type::CONSTANT, lr, power_t, loss, pen, alpha, l1_ratio,
+               shuffle, tol, n_iter_no_change, stream);
   }
 
   void logisticRegressionTest() {
@@ -193,6 +201,7 @@ class SgdTest : public ::testing::TestWithParam<SgdInputs<T>> {
     CUDA_CHECK(cudaFree(coef));
     CUDA_CHECK(cudaFree(coef_ref));
     CUDA_CHECK(cudaFree(coef2));
+    CUDA_CHECK(cudaFree(coef3));
     CUDA_CHECK(cudaFree(coef2_ref));
     CUDA_CHECK(cudaFree(data_logreg));
     CUDA_CHECK(cudaFree(data_logreg_test));
@@ -210,11 +219,11 @@ class SgdTest : public ::testing::TestWithParam<SgdInputs<T>> {
  protected:
   SgdInputs<T> params;
   T *data, *labels, *coef, *coef_ref;
-  T *coef2, *coef2_ref;
+  T *coef2, *coef2_ref, *coef3;
   T *data_logreg, *data_logreg_test, *labels_logreg;
   T *data_svmreg, *data_svmreg_test, *labels_svmreg;
   T *pred_svm, *pred_svm_ref, *pred_log, *pred_log_ref;
-  T intercept, intercept2;
+  T intercept, intercept2, intercept3;
   cudaStream_t stream;
   cumlHandle handle;
 };
@@ -231,6 +240,10 @@ TEST_P(SgdTestF, Fit) {
   ASSERT_TRUE(devArrMatch(coef2_ref, coef2, params.n_col,
                           CompareApproxAbs<float>(params.tol)));
 
+  ASSERT_TRUE(devArrMatch(coef2_ref, coef3, params.n_col,
+                          CompareApproxAbs<float>(params.tol)));
+  ASSERT_NEAR(intercept2, intercept3, params.tol);
+
   ASSERT_TRUE(devArrMatch(pred_log_ref, pred_log, params.n_row,
                           CompareApproxAbs<float>(params.tol)));
 
@@ -246,6 +259,10 @@ TEST_P(SgdTestD, Fit) {
   ASSERT_TRUE(devArrMatch(coef2_ref, coef2, params.n_col,
                           CompareApproxAbs<double>(params.tol)));
 
+  ASSERT_TRUE(devArrMatch(coef2_ref, coef3, params.n_col,
+                          CompareApproxAbs<double>(params.tol)));
+  ASSERT_NEAR(intercept2, intercept3, params.tol);
+
   ASSERT_TRUE(devArrMatch(pred_log_ref, pred_log, params.n_row,
                           CompareApproxAbs<double>(params.tol)));
 
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuml/cuml.hpp>
+#include <memory>
+
+#include "common/cumlHandle.hpp"
+#include "common/cuml_comms_iface.hpp"
+
+namespace MLCommon {
+
+/**
+ * A communicator of a single rank, whose collectives are copies, to run the
+ * multi-GPU code paths without a cluster; a single rank never sends to
+ * another one, so the point-to-point calls only accept empty exchanges
+ */
+class singleRankCommunicator : public cumlCommunicator_iface {
+ public:
+  int getSize() const { return 1; }
+  int getRank() const { return 0; }
+
+  std::unique_ptr<cumlCommunicator_iface> commSplit(int, int) const {
+    return std::unique_ptr<cumlCommunicator_iface>(
+      new singleRankCommunicator());
+  }
+
+  void barrier() const {}
+
+  status_t syncStream(cudaStream_t stream) const {
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    return cumlCommunicator::commStatusSuccess;
+  }
+
+  void isend(const void*, int, int, int, request_t*) const {
+    ASSERT(false, "singleRankCommunicator: no other rank to send to");
+  }
+  void irecv(void*, int, int, int, request_t*) const {
+    ASSERT(false, "singleRankCommunicator: no other rank to receive from");
+  }
+  void waitall(int count, request_t[]) const {
+    ASSERT(count == 0, "singleRankCommunicator: %d pending requests", count);
+  }
+  void device_send(const void*, int, int, cudaStream_t) const {
+    ASSERT(false, "singleRankCommunicator: no other rank to send to");
+  }
+  void device_recv(void*, int, int, cudaStream_t) const {
+    ASSERT(false, "singleRankCommunicator: no other rank to receive from");
+  }
+
+  void allreduce(const void* sendbuff, void* recvbuff, int count,
+                 datatype_t datatype, op_t, cudaStream_t stream) const {
+    copy(sendbuff, recvbuff, count, datatype, stream);
+  }
+  void bcast(void*, int, datatype_t, int, cudaStream_t) const {}
+  void reduce(const void* sendbuff, void* recvbuff, int count,
+              datatype_t datatype, op_t, int, cudaStream_t stream) const {
+    copy(sendbuff, recvbuff, count, datatype, stream);
+  }
+  void allgather(const void* sendbuff, void* recvbuff, int sendcount,
+                 datatype_t datatype, cudaStream_t stream) const {
+    copy(sendbuff, recvbuff, sendcount, datatype, stream);
+  }
+  void allgatherv(const void* sendbuf, void* recvbuf, const int recvcounts[],
+                  const int displs[], datatype_t datatype,
+                  cudaStream_t stream) const {
+    copy(sendbuf, (char*)recvbuf + displs[0] * size(datatype), recvcounts[0],
+         datatype, stream);
+  }
+  void reducescatter(const void* sendbuff, void* recvbuff, int recvcount,
+                     datatype_t datatype, op_t, cudaStream_t stream) const {
+    copy(sendbuff, recvbuff, recvcount, datatype, stream);
+  }
+  void alltoall(const void* sendbuff, void* recvbuff, int count,
+                datatype_t datatype, cudaStream_t stream) const {
+    copy(sendbuff, recvbuff, count, datatype, stream);
+  }
+  void alltoallv(const void* sendbuf, const int sendcounts[],
+                 const int sdispls[], void* recvbuf, const int[],
+                 const int rdispls[], datatype_t datatype,
+                 cudaStream_t stream) const {
+    copy((const char*)sendbuf + sdispls[0] * size(datatype),
+         (char*)recvbuf + rdispls[0] * size(datatype), sendcounts[0],
+         datatype, stream);
+  }
+  void groupStart() const {}
+  void groupEnd() const {}
+  status_t syncEvent(cudaEvent_t event) const {
+    CUDA_CHECK(cudaEventSynchronize(event));
+    return cumlCommunicator::commStatusSuccess;
+  }
+
+ private:
+  static size_t size(datatype_t datatype) {
+    switch (datatype) {
+      case cumlCommunicator::CHAR:
+      case cumlCommunicator::UINT8:
+        return 1;
+      case cumlCommunicator::HALF:
+        return 2;
+      case cumlCommunicator::INT64:
+      case cumlCommunicator::UINT64:
+      case cumlCommunicator::DOUBLE:
+        return 8;
+      default:
+        return 4;
+    }
+  }
+
+  static void copy(const void* src, void* dst, int count, datatype_t datatype,
+                   cudaStream_t stream) {
+    if (src == dst || count == 0) return;
+    CUDA_CHECK(cudaMemcpyAsync(dst, src, count * size(datatype),
+                               cudaMemcpyDeviceToDevice, stream));
+  }
+};
+
+/** makeSingleRankCommunicator wraps a singleRankCommunicator */
+inline std::shared_ptr<cumlCommunicator> makeSingleRankCommunicator() {
+  return std::make_shared<cumlCommunicator>(
+    std::unique_ptr<cumlCommunicator_iface>(new singleRankCommunicator()));
+}
+
+/** initSingleRankComms makes handle the only rank of a communicator */
+inline void initSingleRankComms(ML::cumlHandle& handle) {
+  handle.getImpl().setCommunicator(makeSingleRankCommunicator());
+}
+
+}  // namespace MLCommon
@@ -56,6 +56,19 @@ TEST_F(TestSpectralClustering, Fit) {
   MLCommon::allocate(out, n, true);
 
   ML::Spectral::fit_clusters(handle, X, n, d, k, 10, 1e-3f, out);
+
+  std::vector<int> labels(n);
+  updateHost(labels.data(), out, n, handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+  std::vector<int> sizes(k, 0);
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(labels[i] >= 0 && labels[i] < k);
+    sizes[labels[i]]++;
+  }
+  for (int c = 0; c < k; c++) ASSERT_GT(sizes[c], 0);
+
+  CUDA_CHECK(cudaFree(X));
+  CUDA_CHECK(cudaFree(out));
 }
 
 typedef SpectralTest<float> TestSpectralEmbedding;
@@ -75,6 +88,23 @@ TEST_F(TestSpectralEmbedding, Fit) {
   MLCommon::allocate(out, n * 2, true);
 
   ML::Spectral::fit_embedding(handle, X, n, d, k, 2, out);
+
+  // the components are eigenvectors of the normalized Laplacian, orthonormal
+  std::vector<float> embedding(n * 2);
+  updateHost(embedding.data(), out, n * 2, handle.getStream());
+  CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+  double dots[3] = {0.0, 0.0, 0.0};
+  for (int i = 0; i < n; i++) {
+    dots[0] += embedding[i] * embedding[i];
+    dots[1] += embedding[n + i] * embedding[n + i];
+    dots[2] += embedding[i] * embedding[n + i];
+  }
+  EXPECT_NEAR(dots[0], 1.0, 1e-3);
+  EXPECT_NEAR(dots[1], 1.0, 1e-3);
+  EXPECT_NEAR(dots[2], 0.0, 1e-3);
+
+  CUDA_CHECK(cudaFree(X));
+  CUDA_CHECK(cudaFree(out));
 }
 
 }  // end namespace ML
@@ -17,10 +17,12 @@
 #include <gtest/gtest.h>
 #include <test_utils.h>
 #include <thrust/device_ptr.h>
+#include <thrust/count.h>
 #include <thrust/fill.h>
 #include <thrust/iterator/zip_iterator.h>
 #include <thrust/transform.h>
 #include <cub/cub.cuh>
+#include <cmath>
 #include <iostream>
 #include <string>
 #include <type_traits>
@@ -38,6 +40,7 @@
 #include "svm/svc.hpp"
 #include "svm/svm_model.h"
 #include "svm/svm_parameter.h"
+#include "svm/svr.hpp"
 #include "svm/workingset.h"
 #include "test_utils.h"
 
@@ -94,6 +97,11 @@ TYPED_TEST(WorkingSetTest, Init) {
     new WorkingSet<TypeParam>(this->handle.getImpl(), this->stream, 100000);
   EXPECT_EQ(this->ws->GetSize(), 1024);
   delete this->ws;
+
+  this->ws = new WorkingSet<TypeParam>(this->handle.getImpl(), this->stream,
+                                       100000, 4096);
+  EXPECT_EQ(this->ws->GetSize(), 4096);
+  delete this->ws;
 }
 
 TYPED_TEST(WorkingSetTest, Select) {
@@ -212,7 +220,41 @@ TYPED_TEST_P(KernelCacheTest, EvalTest) {
   }
 }
 
-REGISTER_TYPED_TEST_CASE_P(KernelCacheTest, EvalTest);
+TYPED_TEST_P(KernelCacheTest, HitMissTest) {
+  Matrix::KernelParams params{Matrix::LINEAR, 3, 1, 0};
+  Matrix::GramMatrixBase<TypeParam> *kernel =
+    Matrix::KernelFactory<TypeParam>::create(
+      params, this->handle.getImpl().getCublasHandle());
+  // A negative cache size is resolved from the free device memory
+  EXPECT_GT(KernelCache<TypeParam>::AdaptiveCacheSize(-1, this->n_rows), 0);
+  KernelCache<TypeParam> cache(this->handle.getImpl(), this->x_dev,
+                               this->n_rows, this->n_cols, this->n_ws, kernel,
+                               -1);
+  cache.GetTile(this->ws_idx_dev);
+  EXPECT_EQ(cache.GetHits(), 0);
+  EXPECT_EQ(cache.GetMisses(), this->n_ws);
+  // The same working set again is served from the cache
+  TypeParam *tile_dev = cache.GetTile(this->ws_idx_dev);
+  EXPECT_EQ(cache.GetHits(), this->n_ws);
+  EXPECT_EQ(cache.GetMisses(), this->n_ws);
+  std::vector<int> ws_idx(this->n_ws);
+  updateHost(ws_idx.data(), this->ws_idx_dev, this->n_ws, this->stream);
+  std::vector<TypeParam> tile(this->n_rows * this->n_ws);
+  updateHost(tile.data(), tile_dev, this->n_rows * this->n_ws, this->stream);
+  CUDA_CHECK(cudaStreamSynchronize(this->stream));
+  // The columns follow the order of the (permuted) working set
+  for (int i = 0; i < this->n_ws; i++) {
+    int k = 0;
+    while (this->ws_idx_host[k] != ws_idx[i]) k++;
+    for (int j = 0; j < this->n_rows; j++) {
+      EXPECT_NEAR(tile[i * this->n_rows + j],
+                  this->tile_host_expected[k * this->n_rows + j], 1e-6);
+    }
+  }
+  delete kernel;
+}
+
+REGISTER_TYPED_TEST_CASE_P(KernelCacheTest, EvalTest, HitMissTest);
 INSTANTIATE_TYPED_TEST_CASE_P(My, KernelCacheTest, FloatTypes);
 
 template <typename math_t>
@@ -919,6 +961,375 @@ TYPED_TEST(SmoSolverTest, BlobPredict) {
   }
 }
 
+struct is_negative_functor {
+  template <typename math_t>
+  __host__ __device__ bool operator()(math_t f) {
+    return f < 0;
+  }
+};
+
+TYPED_TEST(SmoSolverTest, SvrTest) {
+  // A noiseless linear target, y = 2 * x0 - x1 + 1, which a linear SVR fits
+  // within the insensitive tube
+  const int n_rows = 20;
+  const int n_cols = 2;
+  std::vector<TypeParam> x_host(n_rows * n_cols);
+  std::vector<TypeParam> y_host(n_rows);
+  for (int i = 0; i < n_rows; i++) {
+    x_host[i] = i * 0.1;
+    x_host[n_rows + i] = (i % 5) * 0.2;
+    y_host[i] = 2 * x_host[i] - x_host[n_rows + i] + 1;
+  }
+  auto allocator = this->handle.getDeviceAllocator();
+  device_buffer<TypeParam> x(allocator, this->stream, n_rows * n_cols);
+  device_buffer<TypeParam> y(allocator, this->stream, n_rows);
+  device_buffer<TypeParam> y_pred(allocator, this->stream, n_rows);
+  updateDevice(x.data(), x_host.data(), n_rows * n_cols, this->stream);
+  updateDevice(y.data(), y_host.data(), n_rows, this->stream);
+
+  svmParameter param{10, 200, -1, 1000, 1e-3, false, 0.1, 0.5};
+  KernelParams kernel_params{LINEAR, 3, 1, 0};
+  svmModel<TypeParam> model{0,       n_cols,  0, nullptr,
+                            nullptr, nullptr, 0, nullptr};
+  svrFit(this->handle, x.data(), n_rows, n_cols, y.data(), param,
+         kernel_params, model);
+  EXPECT_EQ(model.n_classes, 0);
+  EXPECT_GT(model.n_support, 0);
+  EXPECT_LE(model.n_support, n_rows);
+
+  svcPredict(this->handle, x.data(), n_rows, n_cols, kernel_params, model,
+             y_pred.data(), TypeParam(200), false);
+  // Every residual is within epsilon, up to the tolerance of the solver
+  EXPECT_TRUE(devArrMatch(y.data(), y_pred.data(), n_rows,
+                          CompareApprox<TypeParam>(param.epsilon + 0.05)));
+  svmFreeBuffers(this->handle, model);
+}
+
+TYPED_TEST(SmoSolverTest, OneClassTest) {
+  const int n_rows = 200;
+  const int n_cols = 2;
+  auto allocator = this->handle.getDeviceAllocator();
+  device_buffer<TypeParam> x(allocator, this->stream, n_rows * n_cols);
+  device_buffer<TypeParam> y(allocator, this->stream, n_rows);
+  device_buffer<TypeParam> y_pred(allocator, this->stream, n_rows);
+  make_blobs(x.data(), y.data(), n_rows, n_cols, 1, allocator,
+             this->handle.getImpl().getCublasHandle(), this->stream);
+
+  for (double nu : {0.1, 0.5}) {
+    SCOPED_TRACE(nu);
+    svmParameter param{1, 200, -1, 1000, 1e-3, false, 0.1, nu};
+    KernelParams kernel_params{RBF, 0, 0.5, 0};
+    svmModel<TypeParam> model{0,       n_cols,  0, nullptr,
+                              nullptr, nullptr, 0, nullptr};
+    oneClassFit(this->handle, x.data(), n_rows, n_cols, param, kernel_params,
+                model);
+    // nu is a lower bound on the fraction of support vectors
+    EXPECT_GE(model.n_support, int(nu * n_rows));
+
+    svcPredict(this->handle, x.data(), n_rows, n_cols, kernel_params, model,
+               y_pred.data(), TypeParam(200), false);
+    thrust::device_ptr<TypeParam> ptr(y_pred.data());
+    int n_outlier = thrust::count_if(thrust::cuda::par.on(this->stream), ptr,
+                                     ptr + n_rows, is_negative_functor());
+    // and an upper bound on the fraction of outliers, up to a margin for the
+    // tolerance of the solver
+    EXPECT_LE(n_outlier, int((nu + 0.05) * n_rows));
+    svmFreeBuffers(this->handle, model);
+  }
+}
+
+TYPED_TEST(SmoSolverTest, MultiClassTest) {
+  const int n_rows = 300;
+  const int n_cols = 2;
+  const int n_classes = 3;
+  auto allocator = this->handle.getDeviceAllocator();
+  std::vector<float> centers_host = {-5, -5, 5, 5, -5, 5};
+  device_buffer<float> centers(allocator, this->stream, n_classes * n_cols);
+  updateDevice(centers.data(), centers_host.data(), n_classes * n_cols,
+               this->stream);
+  device_buffer<TypeParam> x(allocator, this->stream, n_rows * n_cols);
+  device_buffer<TypeParam> y(allocator, this->stream, n_rows);
+  device_buffer<TypeParam> y_pred(allocator, this->stream, n_rows);
+  make_blobs(x.data(), y.data(), n_rows, n_cols, n_classes, allocator,
+             this->handle.getImpl().getCublasHandle(), this->stream,
+             centers.data());
+
+  for (auto kernel_params :
+       {KernelParams{LINEAR, 3, 1, 0}, KernelParams{RBF, 0, 0.5, 0}}) {
+    SCOPED_TRACE(kernelName(kernel_params));
+    svmParameter param{1, 200, -1, 1000, 1e-3, false, 0.1, 0.5};
+    svmMultiClassModel<TypeParam> model{0, nullptr, nullptr};
+    svcFitMultiClass(this->handle, x.data(), n_rows, n_cols, y.data(), param,
+                     kernel_params, model);
+    ASSERT_EQ(model.n_classes, n_classes);
+
+    // The support vector indices refer to the full training set
+    for (int m = 0; m < n_classes * (n_classes - 1) / 2; m++) {
+      svmModel<TypeParam> &sub = model.models[m];
+      ASSERT_GT(sub.n_support, 0);
+      device_buffer<TypeParam> x_sv(allocator, this->stream,
+                                    sub.n_support * n_cols);
+      Matrix::copyRows(x.data(), n_rows, n_cols, x_sv.data(), sub.support_idx,
+                       sub.n_support, this->stream, false);
+      EXPECT_TRUE(devArrMatch(sub.x_support, x_sv.data(),
+                              sub.n_support * n_cols,
+                              CompareApprox<TypeParam>(1e-6)));
+    }
+
+    svcPredictMultiClass(this->handle, x.data(), n_rows, n_cols, kernel_params,
+                         model, y_pred.data());
+    thrust::device_ptr<TypeParam> ptr1(y.data());
+    thrust::device_ptr<TypeParam> ptr2(y_pred.data());
+    device_buffer<int> is_correct(allocator, this->stream, n_rows);
+    thrust::device_ptr<int> ptr3(is_correct.data());
+    auto first = thrust::make_zip_iterator(thrust::make_tuple(ptr1, ptr2));
+    auto last = thrust::make_zip_iterator(
+      thrust::make_tuple(ptr1 + n_rows, ptr2 + n_rows));
+    thrust::transform(thrust::cuda::par.on(this->stream), first, last, ptr3,
+                      is_same_functor());
+    int n_correct =
+      thrust::reduce(thrust::cuda::par.on(this->stream), ptr3, ptr3 + n_rows);
+    EXPECT_GE(100 * n_correct / n_rows, 98);
+    svmFreeBuffers(this->handle, model);
+  }
+}
+
+TYPED_TEST(SmoSolverTest, PredictTiled) {
+  // A small prediction buffer makes svcPredict tile over the support vectors
+  const int n_rows = 1000;
+  const int n_cols = 5;
+  auto allocator = this->handle.getDeviceAllocator();
+  device_buffer<TypeParam> x(allocator, this->stream, n_rows * n_cols);
+  device_buffer<TypeParam> y(allocator, this->stream, n_rows);
+  device_buffer<TypeParam> y_ref(allocator, this->stream, n_rows);
+  device_buffer<TypeParam> y_tiled(allocator, this->stream, n_rows);
+  make_blobs(x.data(), y.data(), n_rows, n_cols, 2, allocator,
+             this->handle.getImpl().getCublasHandle(), this->stream);
+
+  for (auto kernel_params :
+       {KernelParams{LINEAR, 3, 1, 0}, KernelParams{RBF, 0, 0.5, 0}}) {
+    SCOPED_TRACE(kernelName(kernel_params));
+    svmParameter param{1, 200, -1, 1000, 1e-3, false, 0.1, 0.5};
+    svmModel<TypeParam> model{0,       n_cols,  0, nullptr,
+                              nullptr, nullptr, 0, nullptr};
+    svcFit(this->handle, x.data(), n_rows, n_cols, y.data(), param,
+           kernel_params, model);
+    svcPredict(this->handle, x.data(), n_rows, n_cols, kernel_params, model,
+               y_ref.data(), TypeParam(200), false);
+    // 0.01 MiB holds 256 rows of only a few support vectors
+    svcPredict(this->handle, x.data(), n_rows, n_cols, kernel_params, model,
+               y_tiled.data(), TypeParam(0.01), false);
+    EXPECT_TRUE(devArrMatch(y_ref.data(), y_tiled.data(), n_rows,
+                            CompareApprox<TypeParam>(1e-3)));
+    svmFreeBuffers(this->handle, model);
+  }
+}
+
+TYPED_TEST(SmoSolverTest, LargeWorkingSet) {
+  // The working sets above 1024 elements are solved by several blocks
+  const int n_rows = 5000;
+  const int n_cols = 2;
+  auto allocator = this->handle.getDeviceAllocator();
+  device_buffer<float> centers(allocator, this->stream, 2 * n_cols);
+  thrust::device_ptr<float> thrust_ptr(centers.data());
+  thrust::fill(thrust::cuda::par.on(this->stream), thrust_ptr,
+               thrust_ptr + n_cols, -5.0f);
+  thrust::fill(thrust::cuda::par.on(this->stream), thrust_ptr + n_cols,
+               thrust_ptr + 2 * n_cols, +5.0f);
+  device_buffer<TypeParam> x(allocator, this->stream, n_rows * n_cols);
+  device_buffer<TypeParam> y(allocator, this->stream, n_rows);
+  device_buffer<TypeParam> y_pred(allocator, this->stream, n_rows);
+  make_blobs(x.data(), y.data(), n_rows, n_cols, 2, allocator,
+             this->handle.getImpl().getCublasHandle(), this->stream,
+             centers.data());
+
+  KernelParams kernel_params{RBF, 0, 0.5, 0};
+  for (int ws_size : {1500, 3000}) {
+    SCOPED_TRACE(ws_size);
+    svmParameter param{1, 200, -1, 1000, 1e-3, false, 0.1, 0.5, ws_size};
+    svmModel<TypeParam> model{0,       n_cols,  0, nullptr,
+                              nullptr, nullptr, 0, nullptr};
+    svcFit(this->handle, x.data(), n_rows, n_cols, y.data(), param,
+           kernel_params, model);
+    EXPECT_GT(model.n_support, 0);
+    svcPredict(this->handle, x.data(), n_rows, n_cols, kernel_params, model,
+               y_pred.data(), TypeParam(200));
+    // The blobs are separable
+    EXPECT_TRUE(devArrMatch(y.data(), y_pred.data(), n_rows,
+                            Compare<TypeParam>()));
+    svmFreeBuffers(this->handle, model);
+  }
+}
+
+TYPED_TEST(SmoSolverTest, ShrinkingTest) {
+  // Overlapping blobs, which need many outer iterations with the default
+  // working set size
+  const int n_rows = 4000;
+  const int n_cols = 2;
+  auto allocator = this->handle.getDeviceAllocator();
+  device_buffer<TypeParam> x(allocator, this->stream, n_rows * n_cols);
+  device_buffer<TypeParam> y(allocator, this->stream, n_rows);
+  device_buffer<TypeParam> y_ref(allocator, this->stream, n_rows);
+  device_buffer<TypeParam> y_shrink(allocator, this->stream, n_rows);
+  make_blobs(x.data(), y.data(), n_rows, n_cols, 2, allocator,
+             this->handle.getImpl().getCublasHandle(), this->stream);
+
+  KernelParams kernel_params{RBF, 0, 1, 0};
+  svmModel<TypeParam> models[2];
+  for (int shrinking = 0; shrinking < 2; shrinking++) {
+    svmParameter param{1,   200, -1, 1000, 1e-3, false, 0.1,
+                       0.5, 0,   shrinking};
+    models[shrinking] = svmModel<TypeParam>{0,       n_cols,  0, nullptr,
+                                            nullptr, nullptr, 0, nullptr};
+    svcFit(this->handle, x.data(), n_rows, n_cols, y.data(), param,
+           kernel_params, models[shrinking]);
+  }
+  // Shrinking does not change the solution, up to the tolerance
+  EXPECT_NEAR(models[0].b, models[1].b, 1e-2);
+  svcPredict(this->handle, x.data(), n_rows, n_cols, kernel_params, models[0],
+             y_ref.data(), TypeParam(200), false);
+  svcPredict(this->handle, x.data(), n_rows, n_cols, kernel_params, models[1],
+             y_shrink.data(), TypeParam(200), false);
+  EXPECT_TRUE(devArrMatch(y_ref.data(), y_shrink.data(), n_rows,
+                          CompareApprox<TypeParam>(1e-2)));
+  svmFreeBuffers(this->handle, models[0]);
+  svmFreeBuffers(this->handle, models[1]);
+}
+
+TYPED_TEST(SmoSolverTest, SaveLoadWarmStart) {
+  const int n_rows = 500;
+  const int n_cols = 3;
+  auto allocator = this->handle.getDeviceAllocator();
+  device_buffer<TypeParam> x(allocator, this->stream, n_rows * n_cols);
+  device_buffer<TypeParam> y(allocator, this->stream, n_rows);
+  device_buffer<TypeParam> y_ref(allocator, this->stream, n_rows);
+  device_buffer<TypeParam> y_pred(allocator, this->stream, n_rows);
+  make_blobs(x.data(), y.data(), n_rows, n_cols, 2, allocator,
+             this->handle.getImpl().getCublasHandle(), this->stream);
+
+  KernelParams kernel_params{RBF, 0, 0.5, 0};
+  svmParameter param{1, 200, -1, 1000, 1e-3, false, 0.1, 0.5};
+  svmModel<TypeParam> model{0,       n_cols,  0, nullptr,
+                            nullptr, nullptr, 0, nullptr};
+  svcFit(this->handle, x.data(), n_rows, n_cols, y.data(), param,
+         kernel_params, model);
+  svcPredict(this->handle, x.data(), n_rows, n_cols, kernel_params, model,
+             y_ref.data(), TypeParam(200), false);
+
+  std::vector<char> bytes;
+  svmSave(this->handle, model, &bytes);
+  svmModel<TypeParam> loaded{0,       0,       0, nullptr,
+                             nullptr, nullptr, 0, nullptr};
+  svmLoad(this->handle, loaded, bytes.data(), bytes.size());
+  EXPECT_EQ(loaded.n_support, model.n_support);
+  EXPECT_EQ(loaded.n_cols, model.n_cols);
+  EXPECT_EQ(loaded.n_classes, model.n_classes);
+  EXPECT_EQ(loaded.b, model.b);
+  EXPECT_TRUE(devArrMatch(model.dual_coefs, loaded.dual_coefs,
+                          model.n_support, Compare<TypeParam>()));
+  EXPECT_TRUE(devArrMatch(model.support_idx, loaded.support_idx,
+                          model.n_support, Compare<int>()));
+  svcPredict(this->handle, x.data(), n_rows, n_cols, kernel_params, loaded,
+             y_pred.data(), TypeParam(200), false);
+  EXPECT_TRUE(devArrMatch(y_ref.data(), y_pred.data(), n_rows,
+                          Compare<TypeParam>()));
+
+  // A truncated blob is rejected
+  svmModel<TypeParam> broken{0,       n_cols,  0, nullptr,
+                             nullptr, nullptr, 0, nullptr};
+  EXPECT_THROW(svmLoad(this->handle, broken, bytes.data(), 8),
+               MLCommon::Exception);
+
+  // Retraining from the loaded model, with a different C, gives the same
+  // solution as training from scratch
+  param.C = 2;
+  svmModel<TypeParam> cold{0,       n_cols,  0, nullptr,
+                           nullptr, nullptr, 0, nullptr};
+  svmModel<TypeParam> warm = cold;
+  svcFit(this->handle, x.data(), n_rows, n_cols, y.data(), param,
+         kernel_params, cold);
+  svcFitWarmStart(this->handle, x.data(), n_rows, n_cols, y.data(), param,
+                  kernel_params, loaded, warm);
+  EXPECT_NEAR(cold.b, warm.b, 1e-2);
+  svcPredict(this->handle, x.data(), n_rows, n_cols, kernel_params, cold,
+             y_ref.data(), TypeParam(200), false);
+  svcPredict(this->handle, x.data(), n_rows, n_cols, kernel_params, warm,
+             y_pred.data(), TypeParam(200), false);
+  EXPECT_TRUE(devArrMatch(y_ref.data(), y_pred.data(), n_rows,
+                          CompareApprox<TypeParam>(1e-2)));
+  svmFreeBuffers(this->handle, model);
+  svmFreeBuffers(this->handle, loaded);
+  svmFreeBuffers(this->handle, cold);
+  svmFreeBuffers(this->handle, warm);
+}
+
+TYPED_TEST(SmoSolverTest, SparseSvcTest) {
+  const int n_rows = 100;
+  const int n_cols = 20;
+  auto allocator = this->handle.getDeviceAllocator();
+  device_buffer<TypeParam> x(allocator, this->stream, n_rows * n_cols);
+  device_buffer<TypeParam> y(allocator, this->stream, n_rows);
+  make_blobs(x.data(), y.data(), n_rows, n_cols, 2, allocator,
+             this->handle.getImpl().getCublasHandle(), this->stream);
+
+  // Zero out the small values, and store the same matrix in CSR format
+  std::vector<TypeParam> x_host(n_rows * n_cols);
+  updateHost(x_host.data(), x.data(), n_rows * n_cols, this->stream);
+  CUDA_CHECK(cudaStreamSynchronize(this->stream));
+  std::vector<int> indptr_host(n_rows + 1, 0), indices_host;
+  std::vector<TypeParam> data_host;
+  for (int r = 0; r < n_rows; r++) {
+    for (int c = 0; c < n_cols; c++) {
+      TypeParam &val = x_host[r + c * n_rows];
+      if (std::abs(val) < 2) {
+        val = 0;
+      } else {
+        indices_host.push_back(c);
+        data_host.push_back(val);
+      }
+    }
+    indptr_host[r + 1] = indices_host.size();
+  }
+  int nnz = indices_host.size();
+  device_buffer<int> indptr(allocator, this->stream, n_rows + 1);
+  device_buffer<int> indices(allocator, this->stream, nnz);
+  device_buffer<TypeParam> data(allocator, this->stream, nnz);
+  updateDevice(x.data(), x_host.data(), n_rows * n_cols, this->stream);
+  updateDevice(indptr.data(), indptr_host.data(), n_rows + 1, this->stream);
+  updateDevice(indices.data(), indices_host.data(), nnz, this->stream);
+  updateDevice(data.data(), data_host.data(), nnz, this->stream);
+
+  device_buffer<TypeParam> y_dense(allocator, this->stream, n_rows);
+  device_buffer<TypeParam> y_sparse(allocator, this->stream, n_rows);
+  for (auto kernel_params :
+       {KernelParams{LINEAR, 3, 1, 0}, KernelParams{POLYNOMIAL, 2, 0.1, 1},
+        KernelParams{RBF, 0, 0.05, 0}}) {
+    SCOPED_TRACE(kernelName(kernel_params));
+    svmParameter param{1, 200, -1, 1000, 1e-3, false, 0.1, 0.5};
+    svmModel<TypeParam> dense{0,       n_cols,  0, nullptr,
+                              nullptr, nullptr, 0, nullptr};
+    svmModel<TypeParam> sparse = dense;
+    svcFit(this->handle, x.data(), n_rows, n_cols, y.data(), param,
+           kernel_params, dense);
+    svcFitSparse(this->handle, indptr.data(), indices.data(), data.data(), nnz,
+                 n_rows, n_cols, y.data(), param, kernel_params, sparse);
+    EXPECT_EQ(dense.n_support, sparse.n_support);
+    EXPECT_NEAR(dense.b, sparse.b, 1e-3);
+
+    // The dense and the sparse models give the same decision function, on
+    // dense and on sparse input
+    svcPredict(this->handle, x.data(), n_rows, n_cols, kernel_params, dense,
+               y_dense.data(), TypeParam(200), false);
+    svcPredictSparse(this->handle, indptr.data(), indices.data(), data.data(),
+                     nnz, n_rows, n_cols, kernel_params, sparse,
+                     y_sparse.data(), TypeParam(200), false);
+    EXPECT_TRUE(devArrMatch(y_dense.data(), y_sparse.data(), n_rows,
+                            CompareApprox<TypeParam>(1e-3)));
+    svmFreeBuffers(this->handle, dense);
+    svmFreeBuffers(this->handle, sparse);
+  }
+}
+
 TYPED_TEST(SmoSolverTest, MemoryLeak) {
   // We measure that we have the same amount of free memory available on the GPU
   // before and after we call SVM. This can help catch memory leaks, but it is
@@ -27,6 +27,7 @@
 
 #include <cuml/common/cuml_allocator.hpp>
 #include "common/device_buffer.hpp"
+#include "single_rank_comms.h"
 
 using namespace MLCommon;
 using namespace MLCommon::Score;
@@ -106,10 +107,83 @@ class TSNETest : public ::testing::Test {
       X_d.data(), Y_d.data(), n, p, 2, 5, handle.getDeviceAllocator(),
       handle.getStream());
 
+    // Test FFT interpolated TSNE
+    TSNE_fit(handle, X_d.data(), Y_d.data(), n, p, 2, 90, 0.5, 0.0025, 50, 100,
+             1e-5, 12, 250, 0.01, 200, 500, 1000, 1e-7, 0.5, 0.8, -1, true,
+             true, true, nullptr, true);
+    score_fft = embedding_score(handle, X_d.data(), Y_d.data());
+
+    // Test Barnes Hut from a precomputed kNN graph
+    device_buffer<long> knn_indices(handle.getDeviceAllocator(),
+                                    handle.getStream(), n * 90);
+    device_buffer<float> knn_dists(handle.getDeviceAllocator(),
+                                   handle.getStream(), n * 90);
+    TSNE::get_distances(X_d.data(), n, p, knn_indices.data(), knn_dists.data(),
+                        90, nullptr, handle.getDeviceAllocator(),
+                        handle.getStream());
+    TSNE_fit_knn(handle, knn_indices.data(), knn_dists.data(), Y_d.data(), n,
+                 2, 90);
+    score_knn = embedding_score(handle, X_d.data(), Y_d.data());
+
+    // Test Barnes Hut on the digits as a CSR matrix
+    std::vector<float> csr_vals_h;
+    std::vector<int> csr_row_ind_h(1, 0), csr_cols_h;
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < p; j++) {
+        if (digits[i * p + j] == 0) continue;
+        csr_vals_h.push_back(digits[i * p + j]);
+        csr_cols_h.push_back(j);
+      }
+      csr_row_ind_h.push_back(csr_vals_h.size());
+    }
+    const int nnz = csr_vals_h.size();
+    device_buffer<float> csr_vals(handle.getDeviceAllocator(),
+                                  handle.getStream(), nnz);
+    device_buffer<int> csr_row_ind(handle.getDeviceAllocator(),
+                                   handle.getStream(), n + 1);
+    device_buffer<int> csr_cols(handle.getDeviceAllocator(),
+                                handle.getStream(), nnz);
+    MLCommon::updateDevice(csr_vals.data(), csr_vals_h.data(), nnz,
+                           handle.getStream());
+    MLCommon::updateDevice(csr_row_ind.data(), csr_row_ind_h.data(), n + 1,
+                           handle.getStream());
+    MLCommon::updateDevice(csr_cols.data(), csr_cols_h.data(), nnz,
+                           handle.getStream());
+    TSNE_fit_sparse(handle, csr_vals.data(), csr_row_ind.data(),
+                    csr_cols.data(), nnz, Y_d.data(), n, p, 2, 90);
+    score_sparse = embedding_score(handle, X_d.data(), Y_d.data());
+
+    // Test Barnes Hut on an octree
+    device_buffer<float> Y3_d(handle.getDeviceAllocator(), handle.getStream(),
+                              n * 3);
+    TSNE_fit(handle, X_d.data(), Y3_d.data(), n, p, 3, 90);
+    score_bh_3d = embedding_score(handle, X_d.data(), Y3_d.data(), 3);
+
+    // Test Barnes Hut over the only rank of a communicator
+    initSingleRankComms(handle);
+    TSNE_fit_mg(handle, X_d.data(), Y_d.data(), n, p, 90);
+    score_mg = embedding_score(handle, X_d.data(), Y_d.data());
+
     // Free space
     free(embeddings_h);
   }
 
+  /** trustworthiness of the column-major embedding Y_d, transposed in place */
+  double embedding_score(const cumlHandle &handle, const float *X_d, float *Y_d,
+                         const int dim = 2) {
+    std::vector<float> embeddings_h(n * dim), C_contiguous_embedding(n * dim);
+    MLCommon::updateHost(embeddings_h.data(), Y_d, n * dim, handle.getStream());
+    CUDA_CHECK(cudaStreamSynchronize(handle.getStream()));
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < dim; j++)
+        C_contiguous_embedding[i * dim + j] = embeddings_h[j * n + i];
+    }
+    MLCommon::updateDevice(Y_d, C_contiguous_embedding.data(), n * dim,
+                           handle.getStream());
+    return trustworthiness_score<float, EucUnexpandedL2Sqrt>(
+      X_d, Y_d, n, p, dim, 5, handle.getDeviceAllocator(), handle.getStream());
+  }
+
   void SetUp() override { basicTest(); }
 
   void TearDown() override {}
@@ -119,12 +193,24 @@ class TSNETest : public ::testing::Test {
   int p = 64;
   double score_bh;
   double score_exact;
+  double score_fft;
+  double score_knn;
+  double score_bh_3d;
+  double score_sparse;
+  double score_mg;
 };
 
 typedef TSNETest TSNETestF;
 TEST_F(TSNETestF, Result) {
   if (score_bh < 0.98) printf("BH score = %f\n", score_bh);
   if (score_exact < 0.98) printf("Exact score = %f\n", score_exact);
-
-  ASSERT_TRUE(0.98 < score_bh && 0.98 < score_exact);
+  if (score_fft < 0.98) printf("FFT score = %f\n", score_fft);
+  if (score_knn < 0.98) printf("Precomputed kNN score = %f\n", score_knn);
+  if (score_bh_3d < 0.98) printf("3D BH score = %f\n", score_bh_3d);
+  if (score_sparse < 0.98) printf("Sparse score = %f\n", score_sparse);
+  if (score_mg < 0.98) printf("Single rank MG score = %f\n", score_mg);
+
+  ASSERT_TRUE(0.98 < score_bh && 0.98 < score_exact && 0.98 < score_fft &&
+              0.98 < score_knn && 0.98 < score_bh_3d && 0.98 < score_sparse &&
+              0.98 < score_mg);
 }
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+#include "common/cumlHandle.hpp"
+#include "linalg/qr.h"
+#include "linalg/tsqr.h"
+#include "random/rng.h"
+#include "single_rank_comms.h"
+#include "test_utils.h"
+
+namespace MLCommon {
+namespace LinAlg {
+
+template <typename T>
+struct TsqrMGInputs {
+  T tolerance;
+  int n_row;
+  int n_col;
+  int block_rows;
+  unsigned long long int seed;
+};
+
+template <typename T>
+::std::ostream &operator<<(::std::ostream &os, const TsqrMGInputs<T> &dims) {
+  return os;
+}
+
+// On the only rank of a communicator, tsqrGetRMG factors the local rows
+template <typename T>
+class TsqrMGTest : public ::testing::TestWithParam<TsqrMGInputs<T>> {
+ protected:
+  void SetUp() override {
+    params = ::testing::TestWithParam<TsqrMGInputs<T>>::GetParam();
+    std::shared_ptr<cumlCommunicator> comm = makeSingleRankCommunicator();
+    cudaStream_t stream = handle.getStream();
+    cusolverDnHandle_t cusolverH = handle.getImpl().getcusolverDnHandle();
+    auto allocator = handle.getImpl().getDeviceAllocator();
+    Random::Rng r(params.seed);
+    int m = params.n_row, n = params.n_col;
+
+    allocate(data, m * n);
+    allocate(Q_ref, m * n);
+    allocate(R_ref, n * n, true);
+    allocate(R, n * n);
+    r.uniform(data, m * n, T(-1.0), T(1.0), stream);
+
+    qrGetQR(data, Q_ref, R_ref, m, n, cusolverH, stream, allocator);
+    tsqrGetRMG(*comm, data, R, m, n, params.block_rows, cusolverH, stream,
+               allocator);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void TearDown() override {
+    CUDA_CHECK(cudaFree(data));
+    CUDA_CHECK(cudaFree(Q_ref));
+    CUDA_CHECK(cudaFree(R_ref));
+    CUDA_CHECK(cudaFree(R));
+  }
+
+ protected:
+  TsqrMGInputs<T> params;
+  ML::cumlHandle handle;
+  T *data, *Q_ref, *R_ref, *R;
+};
+
+// a single block and a reduction tree of two levels
+const std::vector<TsqrMGInputs<float>> inputsf = {
+  {0.001f, 30, 5, 32, 1234ULL}, {0.001f, 4000, 8, 16, 1234ULL}};
+
+const std::vector<TsqrMGInputs<double>> inputsd = {
+  {0.00001, 30, 5, 32, 1234ULL}, {0.00001, 4000, 8, 16, 1234ULL}};
+
+typedef TsqrMGTest<float> TsqrMGTestF;
+TEST_P(TsqrMGTestF, Result) {
+  ASSERT_TRUE(devArrMatch(R_ref, R, params.n_col * params.n_col,
+                          CompareApproxAbs<float>(params.tolerance)));
+}
+
+typedef TsqrMGTest<double> TsqrMGTestD;
+TEST_P(TsqrMGTestD, Result) {
+  ASSERT_TRUE(devArrMatch(R_ref, R, params.n_col * params.n_col,
+                          CompareApproxAbs<double>(params.tolerance)));
+}
+
+INSTANTIATE_TEST_CASE_P(TsqrMGTests, TsqrMGTestF,
+                        ::testing::ValuesIn(inputsf));
+
+INSTANTIATE_TEST_CASE_P(TsqrMGTests, TsqrMGTestD,
+                        ::testing::ValuesIn(inputsd));
+
+}  // end namespace LinAlg
+}  // end namespace MLCommon
@@ -19,8 +19,10 @@
 #include <vector>
 #include "ml_utils.h"
 #include "random/rng.h"
+#include "single_rank_comms.h"
 #include "test_utils.h"
 #include "tsvd/tsvd.h"
+#include "tsvd/tsvd_mg.h"
 
 namespace ML {
 
@@ -81,6 +83,13 @@ class TsvdTest : public ::testing::TestWithParam<TsvdInputs<T>> {
       prms.algorithm = solver::COV_EIG_JACOBI;
 
     tsvdFit(handle.getImpl(), data, components, singular_vals, prms, stream);
+
+    // the same rows on the only rank of a communicator
+    allocate(components5, len_comp);
+    allocate(singular_vals5, params.n_col);
+    initSingleRankComms(handle);
+    tsvdFitMG(handle.getImpl(), data, components5, singular_vals5, prms,
+              stream);
   }
 
   void advancedTest() {
@@ -120,11 +129,95 @@ class TsvdTest : public ::testing::TestWithParam<TsvdInputs<T>> {
                          prms, stream);
   }
 
+  void randomizedTest() {
+    params = ::testing::TestWithParam<TsvdInputs<T>>::GetParam();
+    Random::Rng r(params.seed, MLCommon::Random::GenTaps);
+
+    // the randomized solver is exact on data of rank n_components
+    paramsTSVD prms;
+    prms.n_cols = params.n_col2;
+    prms.n_rows = params.n_row2;
+    prms.n_components = 5;
+    device_buffer<T> a(handle.getDeviceAllocator(), stream,
+                       prms.n_rows * prms.n_components);
+    device_buffer<T> b(handle.getDeviceAllocator(), stream,
+                       prms.n_components * prms.n_cols);
+    r.uniform(a.data(), prms.n_rows * prms.n_components, T(-1.0), T(1.0),
+              stream);
+    r.uniform(b.data(), prms.n_components * prms.n_cols, T(-1.0), T(1.0),
+              stream);
+    allocate(data3, params.len2);
+    LinAlg::gemm(a.data(), prms.n_rows, prms.n_components, b.data(), data3,
+                 prms.n_rows, prms.n_cols, CUBLAS_OP_N, CUBLAS_OP_N,
+                 handle.getImpl().getCublasHandle(), stream);
+
+    allocate(components3, prms.n_components * prms.n_cols);
+    allocate(components3_ref, prms.n_components * prms.n_cols);
+    allocate(singular_vals3, prms.n_components);
+    allocate(singular_vals3_ref, prms.n_components);
+    prms.algorithm = solver::COV_EIG_DQ;
+    tsvdFit(handle.getImpl(), data3, components3_ref, singular_vals3_ref, prms,
+            stream);
+    prms.algorithm = solver::RANDOMIZED;
+    tsvdFit(handle.getImpl(), data3, components3, singular_vals3, prms,
+            stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  void sparseTest() {
+    params = ::testing::TestWithParam<TsvdInputs<T>>::GetParam();
+
+    // a 4 x 3 matrix with zeros, as CSR and as column major dense data
+    std::vector<T> values_h = {1.0, 5.0, 2.0, 4.0, 1.0, 4.0, 6.0, 2.0, 4.0};
+    std::vector<int> cols_h = {0, 2, 0, 1, 2, 1, 2, 0, 2};
+    std::vector<int> row_ids_h = {0, 2, 5, 7, 9};
+    std::vector<T> dense_h(4 * 3, T(0));
+    for (int i = 0; i < 4; i++) {
+      for (int j = row_ids_h[i]; j < row_ids_h[i + 1]; j++) {
+        dense_h[cols_h[j] * 4 + i] = values_h[j];
+      }
+    }
+    int nnz = values_h.size();
+    allocate(values4, nnz);
+    allocate(cols4, nnz);
+    allocate(row_ids4, 5);
+    allocate(data4, 4 * 3);
+    updateDevice(values4, values_h.data(), nnz, stream);
+    updateDevice(cols4, cols_h.data(), nnz, stream);
+    updateDevice(row_ids4, row_ids_h.data(), 5, stream);
+    updateDevice(data4, dense_h.data(), 4 * 3, stream);
+
+    paramsTSVD prms;
+    prms.n_cols = 3;
+    prms.n_rows = 4;
+    prms.n_components = 2;
+    allocate(components4, 2 * 3);
+    allocate(singular_vals4, 2);
+    allocate(singular_vals4_ref, 2);
+    allocate(trans4, 4 * 2);
+    allocate(trans4_ref, 4 * 2);
+    tsvdFitSparse(handle.getImpl(), values4, cols4, row_ids4, nnz, components4,
+                  singular_vals4, prms, stream);
+    tsvdTransformSparse(handle.getImpl(), values4, cols4, row_ids4, nnz,
+                        components4, trans4, prms, stream);
+
+    // the dense reference, on the sparse components to match their signs
+    device_buffer<T> components_ref4(handle.getDeviceAllocator(), stream,
+                                     2 * 3);
+    tsvdFit(handle.getImpl(), data4, components_ref4.data(),
+            singular_vals4_ref, prms, stream);
+    tsvdTransform(handle.getImpl(), data4, components4, trans4_ref, prms,
+                  stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
   void SetUp() override {
     CUDA_CHECK(cudaStreamCreate(&stream));
     handle.setStream(stream);
     basicTest();
     advancedTest();
+    randomizedTest();
+    sparseTest();
   }
 
   void TearDown() override {
@@ -139,6 +232,22 @@ class TsvdTest : public ::testing::TestWithParam<TsvdInputs<T>> {
     CUDA_CHECK(cudaFree(explained_vars2));
     CUDA_CHECK(cudaFree(explained_var_ratio2));
     CUDA_CHECK(cudaFree(singular_vals2));
+    CUDA_CHECK(cudaFree(data3));
+    CUDA_CHECK(cudaFree(components3));
+    CUDA_CHECK(cudaFree(components3_ref));
+    CUDA_CHECK(cudaFree(singular_vals3));
+    CUDA_CHECK(cudaFree(singular_vals3_ref));
+    CUDA_CHECK(cudaFree(values4));
+    CUDA_CHECK(cudaFree(cols4));
+    CUDA_CHECK(cudaFree(row_ids4));
+    CUDA_CHECK(cudaFree(data4));
+    CUDA_CHECK(cudaFree(components4));
+    CUDA_CHECK(cudaFree(singular_vals4));
+    CUDA_CHECK(cudaFree(singular_vals4_ref));
+    CUDA_CHECK(cudaFree(trans4));
+    CUDA_CHECK(cudaFree(trans4_ref));
+    CUDA_CHECK(cudaFree(components5));
+    CUDA_CHECK(cudaFree(singular_vals5));
     CUDA_CHECK(cudaStreamDestroy(stream));
   }
 
@@ -147,6 +256,12 @@ class TsvdTest : public ::testing::TestWithParam<TsvdInputs<T>> {
   T *data, *components, *singular_vals, *components_ref, *explained_vars_ref;
   T *data2, *data2_trans, *data2_back, *components2, *explained_vars2,
     *explained_var_ratio2, *singular_vals2;
+  T *data3, *components3, *components3_ref, *singular_vals3,
+    *singular_vals3_ref;
+  T *values4, *data4, *components4, *singular_vals4, *singular_vals4_ref,
+    *trans4, *trans4_ref;
+  int *cols4, *row_ids4;
+  T *components5, *singular_vals5;
   cumlHandle handle;
   cudaStream_t stream;
 };
@@ -189,6 +304,52 @@ TEST_P(TsvdTestDataVecD, Result) {
                           CompareApproxAbs<double>(params.tolerance)));
 }
 
+typedef TsvdTest<float> TsvdTestRandomizedF;
+TEST_P(TsvdTestRandomizedF, Result) {
+  ASSERT_TRUE(devArrMatch(singular_vals3_ref, singular_vals3, 5,
+                          CompareApprox<float>(params.tolerance)));
+}
+
+typedef TsvdTest<double> TsvdTestRandomizedD;
+TEST_P(TsvdTestRandomizedD, Result) {
+  ASSERT_TRUE(devArrMatch(singular_vals3_ref, singular_vals3, 5,
+                          CompareApprox<double>(params.tolerance)));
+}
+
+typedef TsvdTest<float> TsvdTestSparseF;
+TEST_P(TsvdTestSparseF, Result) {
+  ASSERT_TRUE(devArrMatch(singular_vals4_ref, singular_vals4, 2,
+                          CompareApprox<float>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(trans4_ref, trans4, 4 * 2,
+                          CompareApproxAbs<float>(params.tolerance)));
+}
+
+typedef TsvdTest<double> TsvdTestSparseD;
+TEST_P(TsvdTestSparseD, Result) {
+  ASSERT_TRUE(devArrMatch(singular_vals4_ref, singular_vals4, 2,
+                          CompareApprox<double>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(trans4_ref, trans4, 4 * 2,
+                          CompareApproxAbs<double>(params.tolerance)));
+}
+
+typedef TsvdTest<float> TsvdTestMGF;
+TEST_P(TsvdTestMGF, Result) {
+  ASSERT_TRUE(devArrMatch(components, components5,
+                          (params.n_col * params.n_col),
+                          CompareApproxAbs<float>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(singular_vals, singular_vals5, params.n_col,
+                          CompareApprox<float>(params.tolerance)));
+}
+
+typedef TsvdTest<double> TsvdTestMGD;
+TEST_P(TsvdTestMGD, Result) {
+  ASSERT_TRUE(devArrMatch(components, components5,
+                          (params.n_col * params.n_col),
+                          CompareApproxAbs<double>(params.tolerance)));
+  ASSERT_TRUE(devArrMatch(singular_vals, singular_vals5, params.n_col,
+                          CompareApprox<double>(params.tolerance)));
+}
+
 INSTANTIATE_TEST_CASE_P(TsvdTests, TsvdTestLeftVecF,
                         ::testing::ValuesIn(inputsf2));
 
@@ -201,4 +362,22 @@ INSTANTIATE_TEST_CASE_P(TsvdTests, TsvdTestDataVecF,
 INSTANTIATE_TEST_CASE_P(TsvdTests, TsvdTestDataVecD,
                         ::testing::ValuesIn(inputsd2));
 
+INSTANTIATE_TEST_CASE_P(TsvdTests, TsvdTestRandomizedF,
+                        ::testing::ValuesIn(inputsf2));
+
+INSTANTIATE_TEST_CASE_P(TsvdTests, TsvdTestRandomizedD,
+                        ::testing::ValuesIn(inputsd2));
+
+INSTANTIATE_TEST_CASE_P(TsvdTests, TsvdTestSparseF,
+                        ::testing::ValuesIn(inputsf2));
+
+INSTANTIATE_TEST_CASE_P(TsvdTests, TsvdTestSparseD,
+                        ::testing::ValuesIn(inputsd2));
+
+INSTANTIATE_TEST_CASE_P(TsvdTests, TsvdTestMGF,
+                        ::testing::ValuesIn(inputsf2));
+
+INSTANTIATE_TEST_CASE_P(TsvdTests, TsvdTestMGD,
+                        ::testing::ValuesIn(inputsd2));
+
 }  // end namespace ML
@@ -20,6 +20,7 @@
 
 #include "datasets/digits.h"
 
+#include <cuml/manifold/umap.hpp>
 #include <cuml/manifold/umapparams.h>
 #include <metrics/trustworthiness.h>
 #include <cuml/common/cuml_allocator.hpp>
@@ -27,6 +28,7 @@
 #include <cuml/neighbors/knn.hpp>
 
 #include "common/device_buffer.hpp"
+#include "single_rank_comms.h"
 #include "umap/runner.h"
 
 #include <cuda_utils.h>
@@ -124,3 +126,253 @@ TEST_F(UMAPTestF, Result) {
   ASSERT_TRUE(fit_score > 0.97);
   ASSERT_TRUE(xformed_score > 0.70);
 }
+
+TEST(UMAPPrecomputedKNNTest, Result) {
+  cumlHandle handle;
+  cudaStream_t stream = handle.getStream();
+  auto d_alloc = handle.getDeviceAllocator();
+
+  UMAPParams umap_params;
+  umap_params.n_neighbors = 15;
+  umap_params.n_epochs = 500;
+  umap_params.min_dist = 0.01;
+  umap_params.verbose = false;
+  int k = umap_params.n_neighbors;
+
+  device_buffer<float> X_d(d_alloc, stream, n_samples * n_features);
+  MLCommon::updateDevice(X_d.data(), digits.data(), n_samples * n_features,
+                         stream);
+
+  device_buffer<int64_t> knn_indices(d_alloc, stream, n_samples * k);
+  device_buffer<float> knn_dists(d_alloc, stream, n_samples * k);
+  UMAPAlgo::kNNGraph::run(X_d.data(), n_samples, X_d.data(), n_samples,
+                          n_features, knn_indices.data(), knn_dists.data(), k,
+                          &umap_params, d_alloc, stream);
+
+  device_buffer<float> embeddings(d_alloc, stream,
+                                  n_samples * umap_params.n_components);
+  UMAPAlgo::_fit<float, 32>(handle, X_d.data(), n_samples, n_features,
+                            &umap_params, embeddings.data(),
+                            knn_indices.data(), knn_dists.data());
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  double score = trustworthiness_score<float, EucUnexpandedL2Sqrt>(
+    handle, X_d.data(), embeddings.data(), n_samples, n_features,
+    umap_params.n_components, umap_params.n_neighbors);
+  ASSERT_TRUE(score > 0.97);
+}
+
+TEST(UMAPSparseTest, Result) {
+  cumlHandle handle;
+  cudaStream_t stream = handle.getStream();
+  auto d_alloc = handle.getDeviceAllocator();
+
+  UMAPParams umap_params;
+  umap_params.n_neighbors = 15;
+  umap_params.n_epochs = 500;
+  umap_params.min_dist = 0.01;
+  umap_params.verbose = false;
+
+  // Digits in CSR: most of its pixels are zero
+  std::vector<float> h_vals;
+  std::vector<int> h_row_ind(1, 0), h_cols;
+  for (int i = 0; i < n_samples; i++) {
+    for (int c = 0; c < n_features; c++) {
+      float x = digits[i * n_features + c];
+      if (x == 0.f) continue;
+      h_vals.push_back(x);
+      h_cols.push_back(c);
+    }
+    h_row_ind.push_back(h_vals.size());
+  }
+  int nnz = h_vals.size();
+
+  device_buffer<float> X_d(d_alloc, stream, n_samples * n_features);
+  device_buffer<float> vals(d_alloc, stream, nnz);
+  device_buffer<int> row_ind(d_alloc, stream, n_samples + 1);
+  device_buffer<int> cols(d_alloc, stream, nnz);
+  MLCommon::updateDevice(X_d.data(), digits.data(), n_samples * n_features,
+                         stream);
+  MLCommon::updateDevice(vals.data(), h_vals.data(), nnz, stream);
+  MLCommon::updateDevice(row_ind.data(), h_row_ind.data(), n_samples + 1,
+                         stream);
+  MLCommon::updateDevice(cols.data(), h_cols.data(), nnz, stream);
+
+  int n_components = umap_params.n_components;
+  device_buffer<float> embeddings(d_alloc, stream, n_samples * n_components);
+  UMAPAlgo::_fit_sparse<float, 32>(handle, vals.data(), row_ind.data(),
+                                   cols.data(), nnz, nullptr, n_samples,
+                                   n_features, &umap_params,
+                                   embeddings.data());
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  double fit_score = trustworthiness_score<float, EucUnexpandedL2Sqrt>(
+    handle, X_d.data(), embeddings.data(), n_samples, n_features,
+    n_components, umap_params.n_neighbors);
+  ASSERT_TRUE(fit_score > 0.97);
+
+  device_buffer<float> xformed(d_alloc, stream, n_samples * n_components);
+  UMAPAlgo::_transform_sparse<float, 32>(
+    handle, vals.data(), row_ind.data(), cols.data(), n_samples, n_features,
+    vals.data(), row_ind.data(), cols.data(), nnz, n_samples,
+    embeddings.data(), n_samples, &umap_params, xformed.data());
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  double xformed_score = trustworthiness_score<float, EucUnexpandedL2Sqrt>(
+    handle, X_d.data(), xformed.data(), n_samples, n_features, n_components,
+    umap_params.n_neighbors);
+  ASSERT_TRUE(xformed_score > 0.70);
+}
+
+TEST(UMAPDeterministicTest, Reproducible) {
+  cumlHandle handle;
+  cudaStream_t stream = handle.getStream();
+  auto d_alloc = handle.getDeviceAllocator();
+
+  UMAPParams umap_params;
+  umap_params.n_neighbors = 15;
+  umap_params.n_epochs = 500;
+  umap_params.min_dist = 0.01;
+  umap_params.verbose = false;
+  umap_params.init = 0;
+  umap_params.deterministic = true;
+  umap_params.random_state = 42;
+  int n_components = umap_params.n_components;
+
+  device_buffer<float> X_d(d_alloc, stream, n_samples * n_features);
+  MLCommon::updateDevice(X_d.data(), digits.data(), n_samples * n_features,
+                         stream);
+
+  std::vector<std::vector<float>> h_embeddings(2);
+  device_buffer<float> embeddings(d_alloc, stream, n_samples * n_components);
+  for (auto &h_embedding : h_embeddings) {
+    UMAPAlgo::_fit<float, 32>(handle, X_d.data(), n_samples, n_features,
+                              &umap_params, embeddings.data());
+    h_embedding.resize(n_samples * n_components);
+    MLCommon::updateHost(h_embedding.data(), embeddings.data(),
+                         n_samples * n_components, stream);
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+  ASSERT_TRUE(h_embeddings[0] == h_embeddings[1]);
+
+  double score = trustworthiness_score<float, EucUnexpandedL2Sqrt>(
+    handle, X_d.data(), embeddings.data(), n_samples, n_features,
+    n_components, umap_params.n_neighbors);
+  ASSERT_TRUE(score > 0.95);
+}
+
+TEST(UMAPBatchedTransformTest, Result) {
+  cumlHandle handle(2);
+  cudaStream_t stream = handle.getStream();
+  auto d_alloc = handle.getDeviceAllocator();
+
+  UMAPParams umap_params;
+  umap_params.n_neighbors = 15;
+  umap_params.n_epochs = 500;
+  umap_params.min_dist = 0.01;
+  umap_params.verbose = false;
+  int n_components = umap_params.n_components;
+
+  device_buffer<float> X_d(d_alloc, stream, n_samples * n_features);
+  MLCommon::updateDevice(X_d.data(), digits.data(), n_samples * n_features,
+                         stream);
+
+  device_buffer<float> embeddings(d_alloc, stream, n_samples * n_components);
+  UMAPAlgo::_fit<float, 32>(handle, X_d.data(), n_samples, n_features,
+                            &umap_params, embeddings.data());
+
+  // Batches of uneven sizes, spread over the 2 internal streams
+  umap_params.transform_batch_size = 500;
+  device_buffer<float> xformed(d_alloc, stream, n_samples * n_components);
+  UMAPAlgo::_transform<float, 32>(handle, X_d.data(), n_samples, n_features,
+                                  X_d.data(), n_samples, embeddings.data(),
+                                  n_samples, &umap_params, xformed.data());
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  double xformed_score = trustworthiness_score<float, EucUnexpandedL2Sqrt>(
+    handle, X_d.data(), xformed.data(), n_samples, n_features, n_components,
+    umap_params.n_neighbors);
+  ASSERT_TRUE(xformed_score > 0.70);
+}
+
+TEST(UMAPGraphReuseTest, Result) {
+  cumlHandle handle;
+  cudaStream_t stream = handle.getStream();
+  auto d_alloc = handle.getDeviceAllocator();
+
+  UMAPParams umap_params;
+  umap_params.n_neighbors = 15;
+  umap_params.verbose = false;
+
+  device_buffer<float> X_d(d_alloc, stream, n_samples * n_features);
+  MLCommon::updateDevice(X_d.data(), digits.data(), n_samples * n_features,
+                         stream);
+
+  MLCommon::Sparse::COO<float> graph(d_alloc, stream);
+  UMAPAlgo::_fuzzy_graph<float, 32>(handle, X_d.data(), n_samples, n_features,
+                                    &umap_params, &graph);
+  int nnz = graph.nnz;
+
+  // Each embedding of the kept graph has its own embedding settings
+  float min_dists[] = {0.01, 0.5};
+  int n_components[] = {2, 3};
+  for (int i = 0; i < 2; i++) {
+    UMAPParams embed_params = umap_params;
+    embed_params.n_epochs = 500;
+    embed_params.min_dist = min_dists[i];
+    embed_params.n_components = n_components[i];
+
+    device_buffer<float> embeddings(d_alloc, stream,
+                                    n_samples * n_components[i]);
+    UMAPAlgo::_embed_copy<float, 32>(handle, n_samples, &graph,
+                                     &embed_params, embeddings.data());
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    ASSERT_EQ(graph.nnz, nnz);
+
+    double score = trustworthiness_score<float, EucUnexpandedL2Sqrt>(
+      handle, X_d.data(), embeddings.data(), n_samples, n_features,
+      n_components[i], umap_params.n_neighbors);
+    ASSERT_TRUE(score > 0.9);
+  }
+}
+
+// On the only rank of a communicator, fit_mg embeds the rows as well as _fit
+TEST(UMAPMGTest, MatchesFit) {
+  cumlHandle handle;
+  initSingleRankComms(handle);
+  cudaStream_t stream = handle.getStream();
+  auto d_alloc = handle.getDeviceAllocator();
+
+  UMAPParams umap_params;
+  umap_params.n_neighbors = 15;
+  umap_params.n_epochs = 500;
+  umap_params.min_dist = 0.01;
+  umap_params.verbose = false;
+  umap_params.init = 0;
+  int n_components = umap_params.n_components;
+
+  device_buffer<float> X_d(d_alloc, stream, n_samples * n_features);
+  MLCommon::updateDevice(X_d.data(), digits.data(), n_samples * n_features,
+                         stream);
+
+  device_buffer<float> embeddings(d_alloc, stream, n_samples * n_components);
+  UMAPAlgo::_fit<float, 32>(handle, X_d.data(), n_samples, n_features,
+                            &umap_params, embeddings.data());
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  double score = trustworthiness_score<float, EucUnexpandedL2Sqrt>(
+    handle, X_d.data(), embeddings.data(), n_samples, n_features,
+    n_components, umap_params.n_neighbors);
+
+  device_buffer<float> mg_embeddings(d_alloc, stream,
+                                     n_samples * n_components);
+  fit_mg(handle, X_d.data(), n_samples, n_features, &umap_params,
+         mg_embeddings.data());
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  double mg_score = trustworthiness_score<float, EucUnexpandedL2Sqrt>(
+    handle, X_d.data(), mg_embeddings.data(), n_samples, n_features,
+    n_components, umap_params.n_neighbors);
+
+  // the epochs of fit_mg are their own scheme, so only the quality matches
+  ASSERT_TRUE(mg_score > 0.95);
+  ASSERT_NEAR(mg_score, score, 0.02);
+}
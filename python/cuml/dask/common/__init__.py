@@ -18,8 +18,8 @@ from cuml.dask.common.comms import CommsContext, worker_state, default_comms
 
 from cuml.dask.common.comms_utils import inject_comms_on_handle, \
     perform_test_comms_allreduce, perform_test_comms_send_recv, \
-    perform_test_comms_recv_any_rank, \
-    inject_comms_on_handle_coll_only, is_ucx_enabled
+    perform_test_comms_recv_any_rank, perform_test_comms_device_send_recv, \
+    perform_benchmark_comms, inject_comms_on_handle_coll_only, is_ucx_enabled
 
 from cuml.dask.common.dask_df_utils import *
 from cuml.dask.common.part_utils import *
@@ -23,6 +23,8 @@ from cython.operator cimport dereference as deref
 from cpython.long cimport PyLong_AsVoidPtr
 
 from libcpp cimport bool
+from libcpp.string cimport string
+from libcpp.vector cimport vector
 
 
 from libc.stdint cimport uintptr_t
@@ -63,6 +65,23 @@ cdef extern from "comms/cuML_comms_test.hpp" namespace "ML::Comms":
                                             int numTrials) except +
     bool test_pointToPoint_recv_any_rank(const cumlHandle& h,
                                          int numTrials) except +
+    bool test_pointToPoint_device_send_recv(const cumlHandle& h,
+                                            int numTrials) except +
+
+    cdef struct commsBenchmarkResult:
+        string collective
+        size_t bytes
+        double time_us
+        double alg_bw
+        double bus_bw
+        bool correct
+
+    bool benchmark_collectives(const cumlHandle& h,
+                               size_t min_bytes,
+                               size_t max_bytes,
+                               int n_iters,
+                               int n_warmup,
+                               vector[commsBenchmarkResult]* results) except +
 
 
 def is_ucx_enabled():
@@ -96,6 +115,39 @@ def perform_test_comms_recv_any_rank(handle, n_trials):
     return test_pointToPoint_recv_any_rank(deref(h), < int > n_trials)
 
 
+def perform_test_comms_device_send_recv(handle, n_trials):
+    """
+    Performs a stream-ordered p2p send/recv over NCCL on the current worker
+    :param handle: Handle handle containing cumlCommunicator to use
+    """
+    cdef const cumlHandle *h = <cumlHandle*><size_t>handle.getHandle()
+    return test_pointToPoint_device_send_recv(deref(h), <int>n_trials)
+
+
+def perform_benchmark_comms(handle, min_bytes, max_bytes, n_iters,
+                            n_warmup=5):
+    """
+    Times and checks every collective of the cumlCommunicator on the current
+    worker, on messages of min_bytes to max_bytes, doubling the size. The
+    table of the results is printed by rank 0.
+    :param handle: Handle handle containing cumlCommunicator to use
+    :return: list of dicts with the collective, the message size in bytes,
+             the mean time of a call in microseconds, the algorithm and bus
+             bandwidths in GB/s and whether the result was correct, the same
+             on all the workers
+    """
+    cdef const cumlHandle *h = <cumlHandle*><size_t>handle.getHandle()
+    cdef vector[commsBenchmarkResult] results
+    benchmark_collectives(deref(h), <size_t>min_bytes, <size_t>max_bytes,
+                          <int>n_iters, <int>n_warmup, &results)
+    return [{"collective": r.collective.decode("utf-8"),
+             "bytes": r.bytes,
+             "time_us": r.time_us,
+             "alg_bw": r.alg_bw,
+             "bus_bw": r.bus_bw,
+             "correct": r.correct} for r in results]
+
+
 def inject_comms_on_handle_coll_only(handle, nccl_inst, size, rank):
     """
     Given a handle and initialized nccl comm, creates a cumlCommunicator
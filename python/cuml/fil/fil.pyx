@@ -142,12 +142,14 @@ cdef extern from "cuml/fil/fil.h" namespace "ML::fil":
     cdef enum algo_t:
         NAIVE,
         TREE_REORG,
-        BATCH_TREE_REORG
+        BATCH_TREE_REORG,
+        ALGO_AUTO
 
     cdef enum storage_type_t:
         AUTO,
         DENSE,
-        SPARSE
+        SPARSE,
+        SPARSE8
 
     cdef struct forest:
         pass
@@ -184,7 +186,9 @@ cdef class ForestInference_impl():
         self.handle = handle
 
     def get_algo(self, algo_str):
-        algo_dict={'NAIVE': algo_t.NAIVE,
+        algo_dict={'AUTO': algo_t.ALGO_AUTO,
+                   'auto': algo_t.ALGO_AUTO,
+                   'NAIVE': algo_t.NAIVE,
                    'naive': algo_t.NAIVE,
                    'BATCH_TREE_REORG': algo_t.BATCH_TREE_REORG,
                    'batch_tree_reorg': algo_t.BATCH_TREE_REORG,
@@ -201,7 +205,9 @@ cdef class ForestInference_impl():
                            'DENSE': storage_type_t.DENSE,
                            'dense': storage_type_t.DENSE,
                            'SPARSE': storage_type_t.SPARSE,
-                           'sparse': storage_type_t.SPARSE}
+                           'sparse': storage_type_t.SPARSE,
+                           'SPARSE8': storage_type_t.SPARSE8,
+                           'sparse8': storage_type_t.SPARSE8}
         if storage_type_str not in storage_type_dict.keys():
             raise ValueError(' Wrong sparsity selected please refer'
                              ' to the documentation')
@@ -415,6 +421,12 @@ class ForestInference(Base):
            If true, return a 1 or 0 depending on whether the raw prediction
            exceeds the threshold. If False, just return the raw prediction.
         algo : string name of the algo from (from algo_t enum)
+             'AUTO' or 'auto' - choose the algorithm automatically
+                                from the shape of the forest: 'NAIVE'
+                                for sparse forests; 'BATCH_TREE_REORG'
+                                for dense forests of shallow trees
+                                whose rows fit into shared memory,
+                                and 'TREE_REORG' otherwise
              'NAIVE' or 'naive' - simple inference using shared memory
              'TREE_REORG' or 'tree_reorg' - similar to naive but trees
                               rearranged to be more coalescing-friendly
@@ -430,6 +442,10 @@ class ForestInference(Base):
              'DENSE' or 'dense' - create a dense forest
              'SPARSE' or 'sparse' - create a sparse forest;
                                     requires algo='NAIVE'
+             'SPARSE8' or 'sparse8' - create a sparse forest with
+                                      8-byte nodes; requires algo='NAIVE',
+                                      at most 2**14 features and
+                                      at most 2**16 nodes per tree
         """
         if isinstance(model, TreeliteModel):
             # TreeliteModel defined in this file
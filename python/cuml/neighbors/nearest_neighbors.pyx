@@ -82,16 +82,17 @@ cdef extern from "cuml/neighbors/knn.hpp" namespace "ML":
 cdef extern from "cuml/neighbors/knnjoin.hpp":
 
     void sweet_knn(
-        int arg1,
-        int arg2,
-        int arg3,
-        int arg4,
-        int arg5,
-        int arg6,
-        float *arg7,
-        float *arg8,
+        cumlHandle &handle,
+        float *index,
+        int64_t n_index,
+        float *search_items,
+        int64_t n,
+        int D,
         int64_t *res_I,
-        float *res_D,  
+        float *res_D,
+        int k,
+        bool rowMajorIndex,
+        bool rowMajorQuery
     ) except +
 
 
@@ -353,16 +354,17 @@ class NearestNeighbors(Base):
 
         elif self.algorithm == 'sweet':
             sweet_knn(
-                <int>X.shape[0],
-                <int>self.X.shape[0],
-                <int>self.n_dims,
-                2,
-                2,
-                <int>n_neighbors,
+                handle_[0],
                 <float*>x_ctype_st_source,
+                <int64_t>self.X.shape[0],
                 <float*>x_ctype_st_query,
+                <int64_t>N,
+                <int>self.n_dims,
                 <int64_t*>I_ptr,
-                <float*>D_ptr,                
+                <float*>D_ptr,
+                <int>n_neighbors,
+                False,
+                False
             )
 
         I_ndarr = I_ndarr.reshape((N, n_neighbors))
@@ -54,6 +54,8 @@ cdef extern from "svm/svm_parameter.h" namespace "ML::SVM":
         int nochange_steps
         double tol
         int verbose
+        int ws_size
+        int shrinking
 
 cdef extern from "svm/svm_model.h" namespace "ML::SVM":
     cdef cppclass svmModel[math_t]:
@@ -309,6 +311,9 @@ class SVC(Base):
         param.nochange_steps = self.nochange_steps
         param.tol = self.tol
         param.verbose = self.verbose
+        # let the SMO solver select the default working set size
+        param.ws_size = 0
+        param.shrinking = False
         return param
 
     def _get_svm_model(self):
@@ -25,6 +25,8 @@ from cuml.dask.common.comms import CommsContext, worker_state, default_comms
 from cuml.dask.common import perform_test_comms_send_recv
 from cuml.dask.common import perform_test_comms_allreduce
 from cuml.dask.common import perform_test_comms_recv_any_rank
+from cuml.dask.common import perform_test_comms_device_send_recv
+from cuml.dask.common import perform_benchmark_comms
 
 pytestmark = pytest.mark.mg
 
@@ -77,6 +79,16 @@ def func_test_recv_any_rank(sessionId, n_trials, r):
     return perform_test_comms_recv_any_rank(handle, n_trials)
 
 
+def func_test_device_send_recv(sessionId, n_trials, r):
+    handle = worker_state(sessionId)["handle"]
+    return perform_test_comms_device_send_recv(handle, n_trials)
+
+
+def func_benchmark_comms(sessionId, max_bytes, r):
+    handle = worker_state(sessionId)["handle"]
+    return perform_benchmark_comms(handle, 4, max_bytes, 3, n_warmup=1)
+
+
 @pytest.mark.skip(reason="default_comms() not yet being used")
 def test_default_comms_no_exist(cluster):
 
@@ -199,3 +211,67 @@ def test_recv_any_rank(n_trials, cluster):
     finally:
         cb.destroy()
         client.close()
+
+
+@pytest.mark.nccl
+@pytest.mark.parametrize("n_trials", [5])
+def test_device_send_recv(n_trials, cluster):
+
+    client = Client(cluster)
+
+    try:
+
+        cb = CommsContext()
+        cb.init()
+
+        dfs = [client.submit(func_test_device_send_recv,
+                             cb.sessionId,
+                             n_trials,
+                             random.random(),
+                             workers=[w])
+               for wid, w in zip(range(len(cb.worker_addresses)),
+                                 cb.worker_addresses)]
+
+        wait(dfs)
+
+        result = list(map(lambda x: x.result(), dfs))
+
+        assert all(result)
+
+    finally:
+        cb.destroy()
+        client.close()
+
+
+@pytest.mark.nccl
+@pytest.mark.parametrize("max_bytes", [1 << 20])
+def test_benchmark_comms(max_bytes, cluster):
+
+    client = Client(cluster)
+
+    try:
+
+        cb = CommsContext()
+        cb.init()
+
+        dfs = [client.submit(func_benchmark_comms,
+                             cb.sessionId,
+                             max_bytes,
+                             random.random(),
+                             workers=[w])
+               for wid, w in zip(range(len(cb.worker_addresses)),
+                                 cb.worker_addresses)]
+
+        wait(dfs)
+
+        results = list(map(lambda x: x.result(), dfs))
+
+        for result in results:
+            assert len(result) > 0
+            assert all(r["correct"] for r in result)
+        # the results are allreduced, and so the same on all the workers
+        assert all(result == results[0] for result in results)
+
+    finally:
+        cb.destroy()
+        client.close()